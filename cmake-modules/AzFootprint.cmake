@@ -0,0 +1,48 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+# Adds the `footprint` target, which builds the SDK libraries for each combination of the
+# PRECONDITIONS and LOGGING options, and with the optional IoT Hub features off, and reports their
+# code size and stack usage.
+# See eng/scripts/footprint.py for the report and the format of FOOTPRINT_BUDGET.
+
+if(NOT CMAKE_C_COMPILER_ID MATCHES "GNU|Clang")
+  message(FATAL_ERROR "Option `FOOTPRINT` needs -fstack-usage, which is only supported by GNU gcc and Clang.")
+endif()
+
+find_package(PythonInterp 3 REQUIRED)
+
+# Use the size tool of the toolchain, as in arm-none-eabi-gcc -> arm-none-eabi-size
+get_filename_component(_az_compiler_dir "${CMAKE_C_COMPILER}" DIRECTORY)
+get_filename_component(_az_compiler_name "${CMAKE_C_COMPILER}" NAME)
+string(REGEX REPLACE "(gcc|clang|cc)(-[0-9.]+)?(\\.exe)?$" "" _az_toolchain_prefix "${_az_compiler_name}")
+find_program(AZ_SIZE_TOOL
+  NAMES ${_az_toolchain_prefix}size size llvm-size
+  HINTS ${_az_compiler_dir})
+if(NOT AZ_SIZE_TOOL)
+  message(FATAL_ERROR "Option `FOOTPRINT` needs the `size` tool of the toolchain, which wasn't found.")
+endif()
+
+# Without the call graph, only the frame of each function is known, not its peak stack
+include(CheckCCompilerFlag)
+check_c_compiler_flag(-fcallgraph-info=su AZ_HAS_CALLGRAPH_INFO)
+if(AZ_HAS_CALLGRAPH_INFO)
+  set(_az_footprint_callgraph --callgraph)
+else()
+  message(WARNING "${CMAKE_C_COMPILER} doesn't support -fcallgraph-info, the footprint report only has the frame of each function.")
+endif()
+
+add_custom_target(footprint
+  COMMAND ${PYTHON_EXECUTABLE} ${CMAKE_SOURCE_DIR}/eng/scripts/footprint.py
+    --source-dir ${CMAKE_SOURCE_DIR}
+    --build-dir ${CMAKE_BINARY_DIR}/footprint
+    --cmake ${CMAKE_COMMAND}
+    --size ${AZ_SIZE_TOOL}
+    --c-compiler ${CMAKE_C_COMPILER}
+    "--c-flags=${CMAKE_C_FLAGS}"
+    "--toolchain-file=${CMAKE_TOOLCHAIN_FILE}"
+    "--budget=${FOOTPRINT_BUDGET}"
+    ${_az_footprint_callgraph}
+  COMMENT "Measuring the code size and stack usage of the SDK libraries"
+  USES_TERMINAL
+  VERBATIM)
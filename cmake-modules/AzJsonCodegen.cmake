@@ -0,0 +1,47 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+# Adds the az_json_codegen() function, which generates the C functions that parse and serialize the
+# JSON described by a DTDL interface or a JSON Schema, and builds them as a static library.
+# See eng/scripts/json_codegen.py for the schemas supported.
+#
+#   az_json_codegen(<target> SCHEMA <file> [PREFIX <prefix>]
+#                   [MAX_STRING_LENGTH <length>] [MAX_ARRAY_ITEMS <count>])
+#
+# The header is <prefix>.h, and it is found within the include directories of <target>.
+
+find_package(PythonInterp 3 REQUIRED)
+
+set(_az_json_codegen_script ${CMAKE_CURRENT_LIST_DIR}/../eng/scripts/json_codegen.py)
+
+function(az_json_codegen target)
+  cmake_parse_arguments(_az "" "SCHEMA;PREFIX;MAX_STRING_LENGTH;MAX_ARRAY_ITEMS" "" ${ARGN})
+  if(NOT _az_SCHEMA)
+    message(FATAL_ERROR "az_json_codegen(${target}) needs a SCHEMA.")
+  endif()
+  if(NOT _az_PREFIX)
+    message(FATAL_ERROR "az_json_codegen(${target}) needs a PREFIX, the name of the generated files.")
+  endif()
+
+  get_filename_component(_az_schema ${_az_SCHEMA} ABSOLUTE)
+  set(_az_output_dir ${CMAKE_CURRENT_BINARY_DIR}/${target})
+  set(_az_options --prefix ${_az_PREFIX})
+  if(_az_MAX_STRING_LENGTH)
+    list(APPEND _az_options --max-string-length ${_az_MAX_STRING_LENGTH})
+  endif()
+  if(_az_MAX_ARRAY_ITEMS)
+    list(APPEND _az_options --max-array-items ${_az_MAX_ARRAY_ITEMS})
+  endif()
+
+  add_custom_command(
+    OUTPUT ${_az_output_dir}/${_az_PREFIX}.h ${_az_output_dir}/${_az_PREFIX}.c
+    COMMAND ${PYTHON_EXECUTABLE} ${_az_json_codegen_script} ${_az_schema}
+      --output-dir ${_az_output_dir} ${_az_options}
+    DEPENDS ${_az_schema} ${_az_json_codegen_script}
+    COMMENT "Generating the JSON functions of ${_az_SCHEMA}"
+    VERBATIM)
+
+  add_library(${target} STATIC ${_az_output_dir}/${_az_PREFIX}.h ${_az_output_dir}/${_az_PREFIX}.c)
+  target_include_directories(${target} PUBLIC ${_az_output_dir})
+  target_link_libraries(${target} PUBLIC az_core)
+endfunction()
@@ -0,0 +1,319 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+"""Reports the code size and stack usage of the SDK libraries.
+
+Builds the libraries once for each combination of the PRECONDITIONS and LOGGING options, and
+once more with the optional IoT Hub features compiled out too, then reports the text, data and bss of each translation unit, from `size`, and the peak stack of each
+public function, from the frame sizes of `-fstack-usage` and, when the compiler can write it, the
+call graph of `-fcallgraph-info`. The report is printed and written as JSON.
+
+When a budget file is given, the script fails if any library or function goes over its budget.
+The budget file maps a configuration name, or "*" for all of them, to the limits in bytes:
+
+    {
+      "*": {
+        "libraries": { "az_core": { "text": 40000, "data": 64, "bss": 256 } },
+        "stack": { "az_iot_hub_client_sas_get_password": 256 }
+      },
+      "preconditions_off_logging_off": {
+        "libraries": { "az_iot_hub": { "text": 9000 } }
+      }
+    }
+
+It is run by the `footprint` target, which the FOOTPRINT CMake option adds.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+LIBRARIES = ['az_core', 'az_iot_common', 'az_iot_hub', 'az_iot_provisioning', 'az_storage_blobs']
+
+# The options of the smallest IoT Hub client, for devices which only send telemetry and receive
+# cloud-to-device messages.
+MINIMAL_IOT_HUB_OPTIONS = [
+    '-DIOT_HUB_TWIN=OFF',
+    '-DIOT_HUB_METHODS=OFF',
+    '-DIOT_HUB_MODULE_ID=OFF',
+    '-DIOT_HUB_MODEL_ID=OFF',
+]
+
+CONFIGURATIONS = [
+    ('preconditions_on_logging_on', 'ON', 'ON', []),
+    ('preconditions_on_logging_off', 'ON', 'OFF', []),
+    ('preconditions_off_logging_on', 'OFF', 'ON', []),
+    ('preconditions_off_logging_off', 'OFF', 'OFF', []),
+    ('minimal', 'OFF', 'OFF', MINIMAL_IOT_HUB_OPTIONS),
+]
+
+# The number of functions with the deepest stack printed for each configuration.
+STACK_REPORT_COUNT = 20
+
+parser = argparse.ArgumentParser('Report the code size and stack usage of the SDK libraries')
+parser.add_argument('--source-dir', required=True)
+parser.add_argument('--build-dir', required=True)
+parser.add_argument('--cmake', default='cmake')
+parser.add_argument('--size', default='size')
+parser.add_argument('--c-compiler', default='')
+parser.add_argument('--c-flags', default='')
+parser.add_argument('--toolchain-file', default='')
+parser.add_argument('--callgraph', action='store_true',
+                    help='the compiler supports -fcallgraph-info, so peak stack can be computed')
+parser.add_argument('--budget', default='')
+
+args = parser.parse_args()
+
+
+def build(name, preconditions, logging, options):
+    build_dir = os.path.join(args.build_dir, name)
+    flags = [args.c_flags, '-fstack-usage']
+    if args.callgraph:
+        flags.append('-fcallgraph-info=su')
+
+    # The flags are given through the environment, so the toolchain file's are kept.
+    environment = dict(os.environ, CFLAGS=' '.join(f for f in flags if f), AZ_SDK_C_NO_SAMPLES='1')
+    configure = [
+        args.cmake, '-S', args.source_dir, '-B', build_dir,
+        '-DCMAKE_BUILD_TYPE=MinSizeRel',
+        '-DPRECONDITIONS=' + preconditions,
+        '-DLOGGING=' + logging,
+        '-DUNIT_TESTING=OFF',
+        '-DBENCHMARKS=OFF',
+        '-DFOOTPRINT=OFF',
+    ] + options
+    if args.c_compiler:
+        configure.append('-DCMAKE_C_COMPILER=' + args.c_compiler)
+    if args.toolchain_file:
+        configure.append('-DCMAKE_TOOLCHAIN_FILE=' + args.toolchain_file)
+
+    subprocess.check_call(configure, env=environment, stdout=subprocess.DEVNULL)
+    for library in LIBRARIES:
+        subprocess.check_call(
+            [args.cmake, '--build', build_dir, '--target', library],
+            env=environment, stdout=subprocess.DEVNULL)
+
+    return build_dir
+
+
+def find_objects(build_dir):
+    """Returns the object files of each library, which CMake puts in CMakeFiles/<library>.dir."""
+    objects = {library: [] for library in LIBRARIES}
+    for root, _, files in os.walk(build_dir):
+        library = os.path.basename(root)[:-len('.dir')] if root.endswith('.dir') else None
+        if library not in objects:
+            continue
+        for file in sorted(files):
+            if file.endswith('.o') or file.endswith('.obj'):
+                objects[library].append(os.path.join(root, file))
+    return objects
+
+
+def measure_sizes(objects):
+    """Returns the text, data and bss of each object file, from the Berkeley format of `size`."""
+    output = subprocess.check_output([args.size, '-B'] + objects, universal_newlines=True)
+    sizes = {}
+    for line in output.splitlines()[1:]:
+        fields = line.split()
+        if len(fields) >= 6:
+            sizes[fields[5]] = {
+                'text': int(fields[0]),
+                'data': int(fields[1]),
+                'bss': int(fields[2]),
+            }
+    return sizes
+
+
+def auxiliary_file(object_file, extension):
+    # GCC names its auxiliary outputs after the object, as in az_span.c.o -> az_span.c.su.
+    return os.path.splitext(object_file)[0] + extension
+
+
+def read_frames(object_file):
+    """Returns the frame size and kind, from its .su file, of each function of the object."""
+    frames = {}
+    su_file = auxiliary_file(object_file, '.su')
+    if not os.path.exists(su_file):
+        return frames
+    with open(su_file) as su:
+        for line in su:
+            fields = line.rstrip('\n').split('\t')
+            if len(fields) == 3:
+                function = fields[0].rsplit(':', 1)[-1]
+                frames[function] = {'frame': int(fields[1]), 'kind': fields[2]}
+    return frames
+
+
+EDGE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+
+
+def read_calls(object_file):
+    """Returns the functions called by each function of the object, from its .ci file."""
+    calls = {}
+    ci_file = auxiliary_file(object_file, '.ci')
+    if not os.path.exists(ci_file):
+        return calls
+    with open(ci_file) as ci:
+        for line in ci:
+            edge = EDGE.search(line)
+            if edge:
+                calls.setdefault(edge.group(1), []).append(edge.group(2))
+    return calls
+
+
+def compute_peak_stacks(units):
+    """Returns the peak stack of each function, as its frame plus the deepest of its callees.
+
+    A call to a function which isn't in the libraries, such as one from the C library, counts as
+    no stack. A function whose peak depends on an indirect call, recursion or a dynamically sized
+    frame is reported as unbounded, with the peak of what is known.
+    """
+    # Calls are resolved in the translation unit first, for static functions of the same name.
+    global_functions = {}
+    for unit in units:
+        for function in unit['frames']:
+            global_functions.setdefault(function, unit)
+
+    memo = {}
+
+    def peak(unit, function, visiting):
+        key = (unit['name'], function)
+        if key in memo:
+            return memo[key]
+        if key in visiting:
+            return (0, False)
+        visiting.add(key)
+
+        frame = unit['frames'][function]
+        deepest = 0
+        bounded = frame['kind'] == 'static'
+        for callee in unit['calls'].get(function, []):
+            if callee == '__indirect_call':
+                bounded = False
+                continue
+            callee_unit = unit if callee in unit['frames'] else global_functions.get(callee)
+            if callee_unit is None:
+                continue
+            callee_peak, callee_bounded = peak(callee_unit, callee, visiting)
+            deepest = max(deepest, callee_peak)
+            bounded = bounded and callee_bounded and (callee_unit['name'], callee) not in visiting
+
+        visiting.discard(key)
+        memo[key] = (frame['frame'] + deepest, bounded)
+        return memo[key]
+
+    stacks = {}
+    for unit in units:
+        for function in unit['frames']:
+            # Public functions are named az_*, and internal ones _az_*.
+            if function.startswith('az_') and function not in stacks:
+                stack_peak, bounded = peak(unit, function, set())
+                stacks[function] = {
+                    'frame': unit['frames'][function]['frame'],
+                    'peak': stack_peak,
+                    'bounded': bounded and args.callgraph,
+                    'unit': unit['name'],
+                }
+    return stacks
+
+
+def measure(build_dir):
+    objects = find_objects(build_dir)
+    all_objects = [o for library in LIBRARIES for o in objects[library]]
+    sizes = measure_sizes(all_objects)
+
+    libraries = {}
+    units = []
+    for library in LIBRARIES:
+        totals = {'text': 0, 'data': 0, 'bss': 0}
+        library_units = {}
+        for object_file in objects[library]:
+            unit_name = os.path.splitext(os.path.basename(object_file))[0]
+            size = sizes.get(object_file, {'text': 0, 'data': 0, 'bss': 0})
+            library_units[unit_name] = size
+            for section in totals:
+                totals[section] += size[section]
+            units.append({
+                'name': library + '/' + unit_name,
+                'frames': read_frames(object_file),
+                'calls': read_calls(object_file),
+            })
+        libraries[library] = dict(totals, units=library_units)
+
+    return {'libraries': libraries, 'stack': compute_peak_stacks(units)}
+
+
+def check_budget(report, budget):
+    failures = []
+    for name, configuration in report.items():
+        for scope in ('*', name):
+            limits = budget.get(scope, {})
+            for library, sections in limits.get('libraries', {}).items():
+                for section, limit in sections.items():
+                    value = configuration['libraries'].get(library, {}).get(section, 0)
+                    if value > limit:
+                        failures.append('{}: {} {} is {} bytes, over the budget of {}'.format(
+                            name, library, section, value, limit))
+            for function, limit in limits.get('stack', {}).items():
+                stack = configuration['stack'].get(function)
+                if stack is not None and stack['peak'] > limit:
+                    failures.append('{}: {} peak stack is {} bytes, over the budget of {}'.format(
+                        name, function, stack['peak'], limit))
+    return failures
+
+
+def print_report(report):
+    names = [configuration[0] for configuration in CONFIGURATIONS]
+    print('Code size (text/data/bss), in bytes:')
+    print('  {:<28}'.format('library') + ''.join('{:>32}'.format(n) for n in names))
+    for library in LIBRARIES:
+        row = '  {:<28}'.format(library)
+        for name in names:
+            size = report[name]['libraries'][library]
+            row += '{:>32}'.format('{}/{}/{}'.format(size['text'], size['data'], size['bss']))
+        print(row)
+        for unit in sorted(report[names[0]]['libraries'][library]['units']):
+            row = '    {:<26}'.format(unit)
+            for name in names:
+                size = report[name]['libraries'][library]['units'].get(unit)
+                row += '{:>32}'.format(
+                    '{}/{}/{}'.format(size['text'], size['data'], size['bss']) if size else '-')
+            print(row)
+
+    for name in names:
+        stacks = report[name]['stack']
+        print('Deepest peak stack of the public functions, in bytes ({}):'.format(name))
+        deepest = sorted(stacks.items(), key=lambda item: item[1]['peak'], reverse=True)
+        for function, stack in deepest[:STACK_REPORT_COUNT]:
+            print('  {:<64}{:>8}{}'.format(
+                function, stack['peak'], '' if stack['bounded'] else '  (unbounded)'))
+
+
+def main():
+    report = {}
+    for name, preconditions, logging, options in CONFIGURATIONS:
+        report[name] = measure(build(name, preconditions, logging, options))
+
+    report_file = os.path.join(args.build_dir, 'footprint.json')
+    with open(report_file, 'w') as output:
+        json.dump(report, output, indent=2, sort_keys=True)
+
+    print_report(report)
+    print('The full report is in ' + report_file)
+
+    if args.budget:
+        with open(args.budget) as budget_file:
+            failures = check_budget(report, json.load(budget_file))
+        for failure in failures:
+            print('error: ' + failure, file=sys.stderr)
+        if failures:
+            return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
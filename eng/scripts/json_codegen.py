@@ -0,0 +1,688 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+"""Generates C functions which parse JSON into a struct, and serialize the struct back into JSON.
+
+The schema is either a DTDL v2 interface, whose properties and telemetry become the fields of the
+struct, or a JSON Schema of an object. Both describe the same kinds of fields:
+
+    JSON Schema                    DTDL                      C field
+    "integer"                      "integer"                 int32_t
+    "integer", "format": "int64"   "long"                    int64_t
+    "number"                       "double", "float"         double
+    "boolean"                      "boolean"                 bool
+    "string"                       "string", dates, times    char[maxLength + 1]
+    "object" with "properties"     "Object" with "fields"    a nested struct
+    "array" with "items"           "Array"                   an array and its count
+
+Enums are read as their value schema. Strings hold at most "maxLength" bytes once unescaped, or
+--max-string-length, and arrays at most "maxItems" items, or --max-array-items. Arrays of arrays,
+maps and references are not supported.
+
+Every field is paired with a `has_<field>` flag, set when the property was read and checked before
+it is written. Properties which aren't part of the schema are skipped. The properties listed as
+"required" by a JSON Schema fail parsing with AZ_ERROR_ITEM_NOT_FOUND when they are missing.
+
+Property names are matched by switching on their length, then on their first byte, before a single
+comparison. Names with escaped characters, or read from non-contiguous buffers, are compared with
+az_json_token_is_text_equal() instead.
+
+The generated files only use the public API of az_core. The az_json_codegen() CMake function of
+cmake-modules/AzJsonCodegen.cmake runs this script and builds the generated files as a library.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+C_KEYWORDS = {
+    'auto', 'bool', 'break', 'case', 'char', 'const', 'continue', 'default', 'do', 'double', 'else',
+    'enum', 'extern', 'float', 'for', 'goto', 'if', 'inline', 'int', 'long', 'register', 'restrict',
+    'return', 'short', 'signed', 'sizeof', 'static', 'struct', 'switch', 'typedef', 'union',
+    'unsigned', 'void', 'volatile', 'while',
+}
+
+DTDL_PRIMITIVES = {
+    'boolean': 'bool',
+    'double': 'double',
+    'float': 'double',
+    'integer': 'int32',
+    'long': 'int64',
+    'string': 'string',
+    'date': 'string',
+    'dateTime': 'string',
+    'duration': 'string',
+    'time': 'string',
+}
+
+
+class SchemaError(Exception):
+    pass
+
+
+class Field:
+    def __init__(self, json_name, c_name, value_type, required=False):
+        self.json_name = json_name
+        self.c_name = c_name
+        self.value_type = value_type
+        self.required = required
+
+
+class ValueType:
+    """A kind of value: int32, int64, double, bool, string, object or array."""
+
+    def __init__(self, kind, max_length=0, fields=None, type_name=None, item=None, max_items=0):
+        self.kind = kind
+        self.max_length = max_length  # string
+        self.fields = fields  # object
+        self.type_name = type_name  # object
+        self.item = item  # array
+        self.max_items = max_items  # array
+
+
+def to_c_identifier(name):
+    identifier = re.sub(r'(?<=[a-z0-9])([A-Z])', r'_\1', name)
+    identifier = re.sub(r'[^A-Za-z0-9_]', '_', identifier).lower()
+    if not identifier or identifier[0].isdigit():
+        identifier = '_' + identifier
+    if identifier in C_KEYWORDS:
+        identifier += '_'
+    return identifier
+
+
+def c_string_literal(value):
+    literal = ''
+    for byte in value.encode('utf-8'):
+        char = chr(byte)
+        if char in '"\\':
+            literal += '\\' + char
+        elif 0x20 <= byte < 0x7F and char != '?':
+            literal += char
+        else:
+            # Octal escapes can't swallow the following characters, unlike hex escapes.
+            literal += '\\%03o' % byte
+    return '"' + literal + '"'
+
+
+def unique_fields(fields, where):
+    c_names = set()
+    json_names = set()
+    for field in fields:
+        if field.json_name in json_names:
+            raise SchemaError('%s has two properties named "%s"' % (where, field.json_name))
+        json_names.add(field.json_name)
+        while field.c_name in c_names or field.c_name.startswith('has_'):
+            field.c_name += '_'
+        c_names.add(field.c_name)
+        if field.value_type.kind == 'array':
+            c_names.add(field.c_name + '_count')
+    return fields
+
+
+class Parser:
+    def __init__(self, prefix, max_string_length, max_array_items):
+        self.prefix = prefix
+        self.max_string_length = max_string_length
+        self.max_array_items = max_array_items
+
+    def json_schema_type(self, schema, type_name, where):
+        if '$ref' in schema:
+            raise SchemaError('%s: references are not supported' % where)
+        kind = schema.get('type')
+        if kind == 'integer':
+            return ValueType('int64' if schema.get('format') == 'int64' else 'int32')
+        if kind == 'number':
+            return ValueType('double')
+        if kind == 'boolean':
+            return ValueType('bool')
+        if kind == 'string':
+            return ValueType('string', max_length=schema.get('maxLength', self.max_string_length))
+        if kind == 'object':
+            required = set(schema.get('required', []))
+            fields = [
+                Field(name, to_c_identifier(name),
+                      self.json_schema_type(
+                          value, type_name + '_' + to_c_identifier(name), where + '.' + name),
+                      name in required)
+                for name, value in schema.get('properties', {}).items()
+            ]
+            return ValueType('object', fields=unique_fields(fields, where), type_name=type_name)
+        if kind == 'array':
+            item = self.json_schema_type(schema.get('items', {}), type_name + '_item', where + '[]')
+            if item.kind == 'array':
+                raise SchemaError('%s: arrays of arrays are not supported' % where)
+            return ValueType(
+                'array', item=item, max_items=schema.get('maxItems', self.max_array_items))
+        raise SchemaError('%s: the type "%s" is not supported' % (where, kind))
+
+    def dtdl_type(self, schema, type_name, where):
+        if isinstance(schema, str):
+            if schema not in DTDL_PRIMITIVES:
+                raise SchemaError('%s: the schema "%s" is not supported' % (where, schema))
+            kind = DTDL_PRIMITIVES[schema]
+            if kind == 'string':
+                return ValueType('string', max_length=self.max_string_length)
+            return ValueType(kind)
+
+        kind = schema.get('@type')
+        if kind == 'Enum':
+            return self.dtdl_type(schema['valueSchema'], type_name, where)
+        if kind == 'Object':
+            fields = [
+                Field(field['name'], to_c_identifier(field['name']),
+                      self.dtdl_type(
+                          field['schema'], type_name + '_' + to_c_identifier(field['name']),
+                          where + '.' + field['name']))
+                for field in schema.get('fields', [])
+            ]
+            return ValueType('object', fields=unique_fields(fields, where), type_name=type_name)
+        if kind == 'Array':
+            item = self.dtdl_type(schema['elementSchema'], type_name + '_item', where + '[]')
+            if item.kind == 'array':
+                raise SchemaError('%s: arrays of arrays are not supported' % where)
+            return ValueType('array', item=item, max_items=self.max_array_items)
+        raise SchemaError('%s: the schema "%s" is not supported' % (where, kind))
+
+    def parse(self, document):
+        if document.get('@type') == 'Interface':
+            fields = []
+            for content in document.get('contents', []):
+                types = content.get('@type')
+                types = types if isinstance(types, list) else [types]
+                if 'Property' in types or 'Telemetry' in types:
+                    name = content['name']
+                    fields.append(Field(
+                        name, to_c_identifier(name),
+                        self.dtdl_type(
+                            content['schema'], self.prefix + '_' + to_c_identifier(name), name)))
+            return ValueType('object', fields=unique_fields(fields, 'The interface'),
+                             type_name=self.prefix)
+        if document.get('type') == 'object':
+            return self.json_schema_type(document, self.prefix, '$')
+        raise SchemaError('The schema is neither a DTDL interface nor a JSON Schema of an object')
+
+
+def default_prefix(document):
+    if document.get('@type') == 'Interface' and '@id' in document:
+        # dtmi:com:example:Thermostat;1 -> thermostat
+        return to_c_identifier(document['@id'].split(';')[0].split(':')[-1])
+    if 'title' in document:
+        return to_c_identifier(document['title'])
+    raise SchemaError('The schema has no @id or title, pass --prefix')
+
+
+def object_types(value_type):
+    """Lists the object types, nested ones first, as they have to be declared in that order."""
+    types = []
+    if value_type.kind == 'array':
+        return object_types(value_type.item)
+    if value_type.kind == 'object':
+        for field in value_type.fields:
+            types += object_types(field.value_type)
+        types.append(value_type)
+    return types
+
+
+class Writer:
+    def __init__(self):
+        self.lines = []
+
+    def line(self, text='', indent=0):
+        self.lines.append(('  ' * indent + text) if text else '')
+
+    def text(self):
+        return '\n'.join(self.lines) + '\n'
+
+
+RETURN_IF_FAILED = '_az_JSON_CODEGEN_RETURN_IF_FAILED'
+
+
+def field_declaration(field, value_type, name):
+    if value_type.kind == 'int32':
+        return 'int32_t %s;' % name
+    if value_type.kind == 'int64':
+        return 'int64_t %s;' % name
+    if value_type.kind == 'double':
+        return 'double %s;' % name
+    if value_type.kind == 'bool':
+        return 'bool %s;' % name
+    if value_type.kind == 'string':
+        return 'char %s[%d];' % (name, value_type.max_length + 1)
+    if value_type.kind == 'object':
+        return '%s %s;' % (value_type.type_name, name)
+    raise AssertionError(value_type.kind)
+
+
+def emit_header(w, root, source_name, guard):
+    w.line('// Generated by eng/scripts/json_codegen.py from %s. Do not edit.' % source_name)
+    w.line()
+    w.line('#ifndef %s' % guard)
+    w.line('#define %s' % guard)
+    w.line()
+    w.line('#include <azure/core/az_json.h>')
+    w.line('#include <azure/core/az_result.h>')
+    w.line('#include <azure/core/az_span.h>')
+    w.line()
+    w.line('#include <stdbool.h>')
+    w.line('#include <stdint.h>')
+    w.line()
+    w.line('#ifdef __cplusplus')
+    w.line('extern "C" {')
+    w.line('#endif')
+
+    for value_type in object_types(root):
+        w.line()
+        w.line('typedef struct')
+        w.line('{')
+        for field in value_type.fields:
+            w.line('/// The `%s` property.' % field.json_name.replace('\\', '\\\\'), 1)
+            if field.value_type.kind == 'array':
+                w.line(field_declaration(
+                    field, field.value_type.item,
+                    '%s[%d]' % (field.c_name, field.value_type.max_items)), 1)
+                w.line('int32_t %s_count;' % field.c_name, 1)
+            else:
+                w.line(field_declaration(field, field.value_type, field.c_name), 1)
+            w.line('bool has_%s;' % field.c_name, 1)
+        if not value_type.fields:
+            w.line('/// The object has no properties.', 1)
+            w.line('bool unused;', 1)
+        w.line('} %s;' % value_type.type_name)
+
+    name = root.type_name
+    w.line()
+    w.line('/**')
+    w.line(' * @brief Parses the JSON object in \\p json_buffer into a #%s.' % name)
+    w.line(' *')
+    w.line(' * @param[in] json_buffer An #az_span over the byte buffer containing the JSON text.')
+    w.line(' * @param[out] out_value A pointer to the #%s to fill in.' % name)
+    w.line(' *')
+    w.line(' * @return An #az_result value indicating the result of the operation.')
+    w.line(' * @retval #AZ_OK The JSON object is parsed.')
+    w.line(' * @retval #AZ_ERROR_ITEM_NOT_FOUND A required property is missing.')
+    w.line(' * @retval #AZ_ERROR_NOT_ENOUGH_SPACE A string or an array is longer than its field.')
+    w.line(' * @retval other The JSON text is invalid, or a property has a value of another type.')
+    w.line(' */')
+    w.line('AZ_NODISCARD az_result %s_parse(az_span json_buffer, %s* out_value);' % (name, name))
+    w.line()
+    w.line('/**')
+    w.line(' * @brief Reads the JSON object an #az_json_reader is on into a #%s.' % name)
+    w.line(' *')
+    w.line(' * @param[in,out] ref_json_reader A pointer to an #az_json_reader on the start of the')
+    w.line(' * object, or on the name of the property it\'s the value of, or which was just')
+    w.line(' * initialized. It is left on the end of the object.')
+    w.line(' * @param[out] out_value A pointer to the #%s to fill in.' % name)
+    w.line(' *')
+    w.line(' * @return An #az_result value indicating the result of the operation, as for')
+    w.line(' * #%s_parse().' % name)
+    w.line(' */')
+    w.line('AZ_NODISCARD az_result %s_read(az_json_reader* ref_json_reader, %s* out_value);'
+           % (name, name))
+    w.line()
+    w.line('/**')
+    w.line(' * @brief Writes the fields of a #%s which are set as a JSON object.' % name)
+    w.line(' *')
+    w.line(' * @param[in,out] ref_json_writer A pointer to the #az_json_writer to write to.')
+    w.line(' * @param[in] value A pointer to the #%s to write.' % name)
+    w.line(' *')
+    w.line(' * @return An #az_result value indicating the result of the operation.')
+    w.line(' */')
+    w.line('AZ_NODISCARD az_result %s_write(az_json_writer* ref_json_writer, %s const* value);'
+           % (name, name))
+    w.line()
+    w.line('/**')
+    w.line(' * @brief Serializes the fields of a #%s which are set as a JSON object.' % name)
+    w.line(' *')
+    w.line(' * @param[in] value A pointer to the #%s to serialize.' % name)
+    w.line(' * @param[in] destination_buffer An #az_span over the buffer to write the JSON to.')
+    w.line(' * @param[out] out_json A pointer to an #az_span which receives the JSON text written.')
+    w.line(' *')
+    w.line(' * @return An #az_result value indicating the result of the operation.')
+    w.line(' * @retval #AZ_OK The JSON object is written.')
+    w.line(' * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \\p destination_buffer is too small.')
+    w.line(' */')
+    w.line('AZ_NODISCARD az_result %s_serialize(' % name)
+    w.line('%s const* value,' % name, 2)
+    w.line('az_span destination_buffer,', 2)
+    w.line('az_span* out_json);', 2)
+    w.line()
+    w.line('#ifdef __cplusplus')
+    w.line('}')
+    w.line('#endif')
+    w.line()
+    w.line('#endif // %s' % guard)
+
+
+def emit_find_field(w, value_type):
+    w.line()
+    w.line('// Returns the index of the field for the property name, or -1 if there is none.')
+    w.line('static int32_t _%s_find_field(az_json_token const* name)' % value_type.type_name)
+    w.line('{')
+    fields = list(enumerate(value_type.fields))
+    if not fields:
+        w.line('(void)name;', 1)
+        w.line('return -1;', 1)
+        w.line('}')
+        return
+
+    w.line('az_span const slice = name->slice;', 1)
+    w.line('uint8_t const* const ptr = az_span_ptr(slice);', 1)
+    w.line('switch (az_span_size(slice))', 1)
+    w.line('{', 1)
+    by_size = {}
+    for index, field in fields:
+        by_size.setdefault(len(field.json_name.encode('utf-8')), []).append((index, field))
+    for size in sorted(by_size):
+        w.line('case %d:' % size, 2)
+        if size == 0:
+            w.line('return %d;' % by_size[size][0][0], 3)
+            continue
+        w.line('switch (ptr[0])', 3)
+        w.line('{', 3)
+        by_first_byte = {}
+        for index, field in by_size[size]:
+            by_first_byte.setdefault(field.json_name.encode('utf-8')[0], []).append((index, field))
+        for first_byte in sorted(by_first_byte):
+            w.line('case %s:' % (("'%s'" % chr(first_byte)) if 0x20 <= first_byte < 0x7F
+                                 and chr(first_byte) not in "'\\" else '0x%02X' % first_byte), 4)
+            for index, field in by_first_byte[first_byte]:
+                w.line('if (az_span_is_content_equal(slice, AZ_SPAN_FROM_STR(%s)))'
+                       % c_string_literal(field.json_name), 5)
+                w.line('{', 5)
+                w.line('return %d;' % index, 6)
+                w.line('}', 5)
+            w.line('break;', 5)
+        w.line('default:', 4)
+        w.line('break;', 5)
+        w.line('}', 3)
+        w.line('break;', 3)
+    w.line('default:', 2)
+    w.line('break;', 3)
+    w.line('}', 1)
+    w.line()
+    w.line('// The slice of a name with escaped characters is longer than its value, and the', 1)
+    w.line('// slice of one which straddles several buffers is only the last part of it.', 1)
+    w.line('if (name->size != az_span_size(slice)', 1)
+    w.line('|| az_span_find(slice, AZ_SPAN_FROM_STR("\\\\")) != -1)', 3)
+    w.line('{', 1)
+    for index, field in fields:
+        w.line('if (az_json_token_is_text_equal(name, AZ_SPAN_FROM_STR(%s)))'
+               % c_string_literal(field.json_name), 2)
+        w.line('{', 2)
+        w.line('return %d;' % index, 3)
+        w.line('}', 2)
+    w.line('}', 1)
+    w.line()
+    w.line('return -1;', 1)
+    w.line('}')
+
+
+def emit_read_value(w, value_type, target, indent):
+    token = '&ref_json_reader->token'
+    if value_type.kind == 'int32':
+        w.line('%s(az_json_token_get_int32(%s, &%s));' % (RETURN_IF_FAILED, token, target), indent)
+    elif value_type.kind == 'int64':
+        w.line('%s(az_json_token_get_int64(%s, &%s));' % (RETURN_IF_FAILED, token, target), indent)
+    elif value_type.kind == 'double':
+        w.line('%s(az_json_token_get_double(%s, &%s));' % (RETURN_IF_FAILED, token, target), indent)
+    elif value_type.kind == 'bool':
+        w.line('%s(az_json_token_get_boolean(%s, &%s));' % (RETURN_IF_FAILED, token, target),
+               indent)
+    elif value_type.kind == 'string':
+        w.line('%s(az_json_token_get_string(' % RETURN_IF_FAILED, indent)
+        w.line('%s, %s, (int32_t)sizeof(%s), NULL));' % (token, target, target), indent + 2)
+    elif value_type.kind == 'object':
+        w.line('%s(_%s_read_object(ref_json_reader, &%s));'
+               % (RETURN_IF_FAILED, value_type.type_name, target), indent)
+    else:
+        raise AssertionError(value_type.kind)
+
+
+def emit_read_object(w, value_type):
+    name = value_type.type_name
+    w.line()
+    w.line('static az_result _%s_read_object(az_json_reader* ref_json_reader, %s* out_value)'
+           % (name, name))
+    w.line('{')
+    w.line('if (ref_json_reader->token.kind != AZ_JSON_TOKEN_BEGIN_OBJECT)', 1)
+    w.line('{', 1)
+    w.line('return AZ_ERROR_JSON_INVALID_STATE;', 2)
+    w.line('}', 1)
+    w.line()
+    w.line('memset(out_value, 0, sizeof(*out_value));', 1)
+    w.line('while (true)', 1)
+    w.line('{', 1)
+    w.line('%s(az_json_reader_next_token(ref_json_reader));' % RETURN_IF_FAILED, 2)
+    w.line('if (ref_json_reader->token.kind == AZ_JSON_TOKEN_END_OBJECT)', 2)
+    w.line('{', 2)
+    w.line('break;', 3)
+    w.line('}', 2)
+    w.line()
+    w.line('int32_t const field = _%s_find_field(&ref_json_reader->token);' % name, 2)
+    w.line('%s(az_json_reader_next_token(ref_json_reader));' % RETURN_IF_FAILED, 2)
+    w.line('switch (field)', 2)
+    w.line('{', 2)
+    for index, field in enumerate(value_type.fields):
+        target = 'out_value->' + field.c_name
+        w.line('case %d:' % index, 3)
+        if field.value_type.kind == 'array':
+            w.line('{', 3)
+            w.line('if (ref_json_reader->token.kind != AZ_JSON_TOKEN_BEGIN_ARRAY)', 4)
+            w.line('{', 4)
+            w.line('return AZ_ERROR_JSON_INVALID_STATE;', 5)
+            w.line('}', 4)
+            w.line('%s_count = 0;' % target, 4)
+            w.line('while (true)', 4)
+            w.line('{', 4)
+            w.line('%s(az_json_reader_next_token(ref_json_reader));' % RETURN_IF_FAILED, 5)
+            w.line('if (ref_json_reader->token.kind == AZ_JSON_TOKEN_END_ARRAY)', 5)
+            w.line('{', 5)
+            w.line('break;', 6)
+            w.line('}', 5)
+            w.line('if (%s_count == %d)' % (target, field.value_type.max_items), 5)
+            w.line('{', 5)
+            w.line('return AZ_ERROR_NOT_ENOUGH_SPACE;', 6)
+            w.line('}', 5)
+            emit_read_value(w, field.value_type.item, '%s[%s_count]' % (target, target), 5)
+            w.line('%s_count++;' % target, 5)
+            w.line('}', 4)
+            w.line('out_value->has_%s = true;' % field.c_name, 4)
+            w.line('break;', 4)
+            w.line('}', 3)
+        else:
+            emit_read_value(w, field.value_type, target, 4)
+            w.line('out_value->has_%s = true;' % field.c_name, 4)
+            w.line('break;', 4)
+    w.line('default:', 3)
+    w.line('%s(az_json_reader_skip_children(ref_json_reader));' % RETURN_IF_FAILED, 4)
+    w.line('break;', 4)
+    w.line('}', 2)
+    w.line('}', 1)
+    required = [field for field in value_type.fields if field.required]
+    if required:
+        w.line()
+        w.line('if (%s)' % ' || '.join('!out_value->has_' + field.c_name for field in required),
+               1)
+        w.line('{', 1)
+        w.line('return AZ_ERROR_ITEM_NOT_FOUND;', 2)
+        w.line('}', 1)
+    w.line()
+    w.line('return AZ_OK;', 1)
+    w.line('}')
+
+
+def emit_write_value(w, value_type, source, indent):
+    writer = 'ref_json_writer'
+    if value_type.kind == 'int32':
+        w.line('%s(az_json_writer_append_int32(%s, %s));' % (RETURN_IF_FAILED, writer, source),
+               indent)
+    elif value_type.kind == 'int64':
+        w.line('{', indent)
+        w.line('// The longest 64-bit integer is -9223372036854775808.', indent + 1)
+        w.line('uint8_t digits[20];', indent + 1)
+        w.line('az_span remainder = AZ_SPAN_EMPTY;', indent + 1)
+        w.line('%s(az_span_i64toa(AZ_SPAN_FROM_BUFFER(digits), %s, &remainder));'
+               % (RETURN_IF_FAILED, source), indent + 1)
+        w.line('%s(az_json_writer_append_json_text(' % RETURN_IF_FAILED, indent + 1)
+        w.line('%s, az_span_create(digits, (int32_t)sizeof(digits) - az_span_size(remainder))));'
+               % writer, indent + 3)
+        w.line('}', indent)
+    elif value_type.kind == 'double':
+        w.line('%s(az_json_writer_append_double_shortest(%s, %s));'
+               % (RETURN_IF_FAILED, writer, source), indent)
+    elif value_type.kind == 'bool':
+        w.line('%s(az_json_writer_append_bool(%s, %s));' % (RETURN_IF_FAILED, writer, source),
+               indent)
+    elif value_type.kind == 'string':
+        # The writer doesn't modify the string, the cast only drops const from the field.
+        w.line('%s(az_json_writer_append_string(' % RETURN_IF_FAILED, indent)
+        w.line('%s, az_span_create((uint8_t*)(uintptr_t)%s, (int32_t)strlen(%s))));'
+               % (writer, source, source), indent + 2)
+    elif value_type.kind == 'object':
+        w.line('%s(_%s_write_object(%s, &%s));'
+               % (RETURN_IF_FAILED, value_type.type_name, writer, source), indent)
+    else:
+        raise AssertionError(value_type.kind)
+
+
+def emit_write_object(w, value_type):
+    name = value_type.type_name
+    w.line()
+    w.line('static az_result _%s_write_object(az_json_writer* ref_json_writer, %s const* value)'
+           % (name, name))
+    w.line('{')
+    w.line('%s(az_json_writer_append_begin_object(ref_json_writer));' % RETURN_IF_FAILED, 1)
+    for field in value_type.fields:
+        source = 'value->' + field.c_name
+        w.line()
+        w.line('if (value->has_%s)' % field.c_name, 1)
+        w.line('{', 1)
+        w.line('%s(az_json_writer_append_property_name(' % RETURN_IF_FAILED, 2)
+        w.line('ref_json_writer, AZ_SPAN_FROM_STR(%s)));' % c_string_literal(field.json_name), 4)
+        if field.value_type.kind == 'array':
+            w.line('%s(az_json_writer_append_begin_array(ref_json_writer));' % RETURN_IF_FAILED,
+                   2)
+            w.line('for (int32_t i = 0; i < %s_count; i++)' % source, 2)
+            w.line('{', 2)
+            emit_write_value(w, field.value_type.item, '%s[i]' % source, 3)
+            w.line('}', 2)
+            w.line('%s(az_json_writer_append_end_array(ref_json_writer));' % RETURN_IF_FAILED, 2)
+        else:
+            emit_write_value(w, field.value_type, source, 2)
+        w.line('}', 1)
+    w.line()
+    w.line('return az_json_writer_append_end_object(ref_json_writer);', 1)
+    w.line('}')
+
+
+def emit_source(w, root, source_name, header_name):
+    name = root.type_name
+    w.line('// Generated by eng/scripts/json_codegen.py from %s. Do not edit.' % source_name)
+    w.line()
+    w.line('#include "%s"' % header_name)
+    w.line()
+    w.line('#include <string.h>')
+    w.line()
+    w.line('#define %s(exp) \\' % RETURN_IF_FAILED)
+    w.line('do \\', 1)
+    w.line('{ \\', 1)
+    w.line('az_result const _az_codegen_result = (exp); \\', 2)
+    w.line('if (az_result_failed(_az_codegen_result)) \\', 2)
+    w.line('{ \\', 2)
+    w.line('return _az_codegen_result; \\', 3)
+    w.line('} \\', 2)
+    w.line('} while (0)', 1)
+
+    types = object_types(root)
+    for value_type in types:
+        emit_find_field(w, value_type)
+        emit_read_object(w, value_type)
+        emit_write_object(w, value_type)
+
+    w.line()
+    w.line('AZ_NODISCARD az_result %s_read(az_json_reader* ref_json_reader, %s* out_value)'
+           % (name, name))
+    w.line('{')
+    w.line('if (ref_json_reader->token.kind == AZ_JSON_TOKEN_NONE', 1)
+    w.line('|| ref_json_reader->token.kind == AZ_JSON_TOKEN_PROPERTY_NAME)', 3)
+    w.line('{', 1)
+    w.line('%s(az_json_reader_next_token(ref_json_reader));' % RETURN_IF_FAILED, 2)
+    w.line('}', 1)
+    w.line()
+    w.line('return _%s_read_object(ref_json_reader, out_value);' % name, 1)
+    w.line('}')
+    w.line()
+    w.line('AZ_NODISCARD az_result %s_parse(az_span json_buffer, %s* out_value)' % (name, name))
+    w.line('{')
+    w.line('az_json_reader reader;', 1)
+    w.line('%s(az_json_reader_init(&reader, json_buffer, NULL));' % RETURN_IF_FAILED, 1)
+    w.line('%s(%s_read(&reader, out_value));' % (RETURN_IF_FAILED, name), 1)
+    w.line()
+    w.line('// Nothing but whitespace may follow the object.', 1)
+    w.line('az_result const result = az_json_reader_next_token(&reader);', 1)
+    w.line('if (result == AZ_ERROR_JSON_READER_DONE)', 1)
+    w.line('{', 1)
+    w.line('return AZ_OK;', 2)
+    w.line('}', 1)
+    w.line('return az_result_failed(result) ? result : AZ_ERROR_UNEXPECTED_CHAR;', 1)
+    w.line('}')
+    w.line()
+    w.line('AZ_NODISCARD az_result %s_write(az_json_writer* ref_json_writer, %s const* value)'
+           % (name, name))
+    w.line('{')
+    w.line('return _%s_write_object(ref_json_writer, value);' % name, 1)
+    w.line('}')
+    w.line()
+    w.line('AZ_NODISCARD az_result %s_serialize(' % name)
+    w.line('%s const* value,' % name, 2)
+    w.line('az_span destination_buffer,', 2)
+    w.line('az_span* out_json)', 2)
+    w.line('{')
+    w.line('az_json_writer writer;', 1)
+    w.line('%s(az_json_writer_init(&writer, destination_buffer, NULL));' % RETURN_IF_FAILED, 1)
+    w.line('%s(%s_write(&writer, value));' % (RETURN_IF_FAILED, name), 1)
+    w.line('*out_json = az_json_writer_get_bytes_used_in_destination(&writer);', 1)
+    w.line('return AZ_OK;', 1)
+    w.line('}')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        'Generate C functions which parse JSON into a struct and serialize it back')
+    parser.add_argument('schema', help='a DTDL v2 interface or a JSON Schema of an object')
+    parser.add_argument('--output-dir', required=True)
+    parser.add_argument('--prefix', default='',
+                        help='the name of the struct and the prefix of the functions, by default '
+                        'the last segment of the DTDL @id or the JSON Schema title')
+    parser.add_argument('--max-string-length', type=int, default=63)
+    parser.add_argument('--max-array-items', type=int, default=8)
+    args = parser.parse_args()
+
+    try:
+        with open(args.schema, encoding='utf-8') as schema_file:
+            document = json.load(schema_file)
+        prefix = to_c_identifier(args.prefix) if args.prefix else default_prefix(document)
+        root = Parser(prefix, args.max_string_length, args.max_array_items).parse(document)
+    except (OSError, ValueError, KeyError, SchemaError) as error:
+        print('json_codegen: %s: %s' % (args.schema, error), file=sys.stderr)
+        return 1
+
+    source_name = os.path.basename(args.schema)
+    header_name = prefix + '.h'
+
+    header = Writer()
+    emit_header(header, root, source_name, prefix.upper() + '_H')
+    source = Writer()
+    emit_source(source, root, source_name, header_name)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    for file_name, writer in ((header_name, header), (prefix + '.c', source)):
+        with open(os.path.join(args.output_dir, file_name), 'w', encoding='utf-8') as output:
+            output.write(writer.text())
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_loopback_transport.h"
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_result.h>
+
+static az_span loopback_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 200 OK\r\n\r\n");
+
+void az_http_loopback_transport_set_response(az_span response) { loopback_response = response; }
+
+AZ_NODISCARD az_result
+az_http_client_send_request(az_http_request const* request, az_http_response* ref_response)
+{
+  (void)request;
+  return az_http_response_append(ref_response, loopback_response);
+}
+
+AZ_NODISCARD az_result az_http_client_connection_reuse_init() { return AZ_OK; }
+
+void az_http_client_connection_reuse_cleanup() {}
+
+// There is no TLS over the loopback.
+AZ_NODISCARD az_result
+az_http_client_tls_sessions_export(az_span destination, az_span* out_sessions)
+{
+  (void)destination;
+  (void)out_sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_tls_sessions_import(az_span sessions)
+{
+  (void)sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+// Requests are answered as they are sent, so there is nothing to multiplex them over.
+AZ_NODISCARD az_result az_http_client_async_init(
+    az_http_client_async* out_client,
+    az_http_client_async_options const* options)
+{
+  (void)out_client;
+  (void)options;
+  return AZ_ERROR_NOT_IMPLEMENTED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_submit(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* out_operation,
+    az_http_request const* request,
+    az_http_response* ref_response)
+{
+  (void)ref_client;
+  (void)out_operation;
+  (void)request;
+  (void)ref_response;
+  return AZ_ERROR_NOT_IMPLEMENTED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_poll(
+    az_http_client_async* ref_client,
+    int32_t timeout_msec,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)timeout_msec;
+  (void)out_pending_count;
+  return AZ_ERROR_NOT_IMPLEMENTED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_socket_action(
+    az_http_client_async* ref_client,
+    intptr_t socket,
+    az_http_client_async_socket_events events,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)socket;
+  (void)events;
+  (void)out_pending_count;
+  return AZ_ERROR_NOT_IMPLEMENTED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_timer_expired(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)out_pending_count;
+  return AZ_ERROR_NOT_IMPLEMENTED;
+}
+
+void az_http_client_async_cancel(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* ref_operation)
+{
+  (void)ref_client;
+  (void)ref_operation;
+}
+
+void az_http_client_async_cleanup(az_http_client_async* ref_client) { (void)ref_client; }
@@ -0,0 +1,22 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_http_loopback_transport.h
+ *
+ * @brief An HTTP transport adapter which answers every request with the same canned response,
+ * without any I/O, so that the time spent in the HTTP pipeline can be measured on its own.
+ */
+
+#ifndef _az_HTTP_LOOPBACK_TRANSPORT_H
+#define _az_HTTP_LOOPBACK_TRANSPORT_H
+
+#include <azure/core/az_span.h>
+
+/**
+ * @brief Sets the raw HTTP response, status line, headers and body, which
+ * #az_http_client_send_request() writes to the response of every request.
+ */
+void az_http_loopback_transport_set_response(az_span response);
+
+#endif // _az_HTTP_LOOPBACK_TRANSPORT_H
@@ -0,0 +1,378 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_http_pipeline_benchmark.c
+ *
+ * @brief Measures the overhead of the HTTP pipeline policies, by sending requests through
+ * #az_http_pipeline_process() to a loopback transport which answers them from memory, and prints
+ * the results to stdout as JSON.
+ *
+ * @details Usage: `az_http_pipeline_benchmark [min_seconds]`. Each pipeline runs for at least
+ * `min_seconds` (0.2 by default) of processor time. For every pipeline, the results are:
+ *   - "cpu_nsec_per_request": the processor time to build a request, send it through the pipeline
+ *     and read the status line of its response.
+ *   - "stack_bytes": the stack high-water mark of a request, measured by painting the stack below
+ *     the benchmark with a pattern and looking for the deepest byte overwritten. It assumes the
+ *     stack grows down, and is an estimate within a few bytes of the frame of the measuring code.
+ *   - "heap_allocations_per_request" and "heap_bytes_per_request": the calls to the C allocator
+ *     made by the request the stack is measured for, and the bytes they asked for. They are only
+ *     counted when the linker can wrap `malloc()`, and are `null` otherwise.
+ */
+
+#include "az_http_loopback_transport.h"
+
+#include <azure/core/az_context.h>
+#include <azure/core/az_credentials.h>
+#include <azure/core/az_http.h>
+#include <azure/core/az_log.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/az_version.h>
+#include <azure/core/internal/az_http_internal.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_MSC_VER)
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+enum
+{
+  BENCHMARK_STACK_PAINT_SIZE = 64 * 1024,
+  BENCHMARK_STACK_PATTERN = 0xA5,
+  BENCHMARK_URL_SIZE = 256,
+  BENCHMARK_HEADERS_SIZE = 1024,
+  BENCHMARK_RESPONSE_SIZE = 1024,
+};
+
+static char const benchmark_url[] = "https://contoso.blob.core.windows.net/container/blob";
+
+static uint8_t benchmark_body[] = "{\"temperature\":21.43,\"humidity\":48}";
+
+static uint8_t benchmark_response[]
+    = "HTTP/1.1 201 Created\r\n"
+      "Content-Length: 0\r\n"
+      "Content-MD5: 1B2M2Y8AsgTpgAmY7PhCfg==\r\n"
+      "Last-Modified: Thu, 23 Jul 2020 19:51:02 GMT\r\n"
+      "ETag: \"0x8D82F433CE87551\"\r\n"
+      "Server: Windows-Azure-Blob/1.0 Microsoft-HTTPAPI/2.0\r\n"
+      "x-ms-request-id: 5b9c9eb5-f01e-0093-0f2c-61c6b6000000\r\n"
+      "x-ms-version: 2019-02-02\r\n"
+      "x-ms-request-server-encrypted: true\r\n"
+      "Date: Thu, 23 Jul 2020 19:51:02 GMT\r\n"
+      "\r\n";
+
+#ifdef _az_BENCHMARK_COUNT_ALLOCATIONS
+// The benchmark is linked with `--wrap` for the allocator, so that the calls made by the SDK go
+// through these.
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+
+static int64_t heap_allocation_count = 0;
+static int64_t heap_allocation_bytes = 0;
+
+void* __wrap_malloc(size_t size)
+{
+  heap_allocation_count++;
+  heap_allocation_bytes += (int64_t)size;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+  heap_allocation_count++;
+  heap_allocation_bytes += (int64_t)(count * size);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+  heap_allocation_count++;
+  heap_allocation_bytes += (int64_t)size;
+  return __real_realloc(ptr, size);
+}
+#endif // _az_BENCHMARK_COUNT_ALLOCATIONS
+
+// A credential which sets the header a bearer token credential would, without requesting a token.
+typedef struct
+{
+  _az_credential credential;
+  az_span authorization;
+} benchmark_credential;
+
+static AZ_NODISCARD az_result benchmark_credential_apply(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  benchmark_credential const* const credential = (benchmark_credential const*)ref_options;
+
+  az_result const result = az_http_request_append_header(
+      ref_request, AZ_SPAN_FROM_STR("authorization"), credential->authorization);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+}
+
+#ifndef AZ_NO_LOGGING
+static void benchmark_log_discard(az_log_classification classification, az_span message)
+{
+  (void)classification;
+  (void)message;
+}
+#endif // AZ_NO_LOGGING
+
+typedef struct
+{
+  char const* name;
+  _az_http_pipeline pipeline;
+  int32_t policy_count;
+  bool logs;
+} benchmark_pipeline;
+
+// The results are folded into this, so that the compiler can't drop the work being timed.
+static volatile int64_t benchmark_sink;
+
+static bool first_result = true;
+
+static void check(az_result result, char const* what)
+{
+  if (az_result_failed(result))
+  {
+    fprintf(stderr, "%s failed with 0x%08x\n", what, (unsigned)result);
+    exit(1);
+  }
+}
+
+// Builds a request the way the service clients do, sends it and reads the response status.
+static BENCHMARK_NOINLINE void send_request(_az_http_pipeline* ref_pipeline)
+{
+  uint8_t url_buffer[BENCHMARK_URL_SIZE];
+  uint8_t headers_buffer[BENCHMARK_HEADERS_SIZE];
+  uint8_t response_buffer[BENCHMARK_RESPONSE_SIZE];
+
+  az_span const url = AZ_SPAN_FROM_BUFFER(url_buffer);
+  int32_t const url_length = (int32_t)sizeof(benchmark_url) - 1;
+  memcpy(url_buffer, benchmark_url, (size_t)url_length);
+
+  az_http_request request;
+  check(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_put(),
+          url,
+          url_length,
+          AZ_SPAN_FROM_BUFFER(headers_buffer),
+          az_span_create(benchmark_body, (int32_t)sizeof(benchmark_body) - 1)),
+      "az_http_request_init");
+  check(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("x-ms-blob-type"), AZ_SPAN_FROM_STR("BlockBlob")),
+      "az_http_request_append_header");
+  check(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("Content-Type"), AZ_SPAN_FROM_STR("application/json")),
+      "az_http_request_append_header");
+
+  az_http_response response;
+  check(
+      az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)),
+      "az_http_response_init");
+
+  check(az_http_pipeline_process(ref_pipeline, &request, &response), "az_http_pipeline_process");
+
+  az_http_response_status_line status_line = { 0 };
+  check(
+      az_http_response_get_status_line(&response, &status_line),
+      "az_http_response_get_status_line");
+  benchmark_sink += (int64_t)status_line.status_code;
+}
+
+// Returns the lowest address painted, which the frames of a function called next overwrite.
+static BENCHMARK_NOINLINE uintptr_t paint_stack(void)
+{
+  volatile uint8_t region[BENCHMARK_STACK_PAINT_SIZE];
+  for (int32_t i = 0; i < BENCHMARK_STACK_PAINT_SIZE; i++)
+  {
+    region[i] = BENCHMARK_STACK_PATTERN;
+  }
+
+  return (uintptr_t)region;
+}
+
+static int32_t measure_stack(uintptr_t painted)
+{
+  volatile uint8_t const* const region = (volatile uint8_t const*)painted;
+  int32_t untouched = 0;
+  while (untouched < BENCHMARK_STACK_PAINT_SIZE && region[untouched] == BENCHMARK_STACK_PATTERN)
+  {
+    untouched++;
+  }
+
+  return BENCHMARK_STACK_PAINT_SIZE - untouched;
+}
+
+static BENCHMARK_NOINLINE int32_t measure_request_stack(_az_http_pipeline* ref_pipeline)
+{
+  uintptr_t const painted = paint_stack();
+  send_request(ref_pipeline);
+  return measure_stack(painted);
+}
+
+static double elapsed_seconds(clock_t start) { return (double)(clock() - start) / CLOCKS_PER_SEC; }
+
+// Sends requests in batches twice as large as the one before, until a batch takes at least
+// min_seconds, and reports that batch.
+static void run_benchmark(benchmark_pipeline* ref_pipeline, double min_seconds)
+{
+#ifndef AZ_NO_LOGGING
+  az_log_set_classifications(NULL);
+  az_log_set_callback(ref_pipeline->logs ? benchmark_log_discard : NULL);
+#endif // AZ_NO_LOGGING
+
+  // One request outside of the timing, for the caches.
+  send_request(&ref_pipeline->pipeline);
+
+#ifdef _az_BENCHMARK_COUNT_ALLOCATIONS
+  int64_t const allocation_count = heap_allocation_count;
+  int64_t const allocation_bytes = heap_allocation_bytes;
+#endif // _az_BENCHMARK_COUNT_ALLOCATIONS
+
+  int32_t const stack_bytes = measure_request_stack(&ref_pipeline->pipeline);
+
+  int64_t iterations = 1;
+  double seconds = 0;
+  while (true)
+  {
+    clock_t const start = clock();
+    for (int64_t i = 0; i < iterations; i++)
+    {
+      send_request(&ref_pipeline->pipeline);
+    }
+
+    seconds = elapsed_seconds(start);
+    if (seconds >= min_seconds || iterations >= INT64_MAX / 2)
+    {
+      break;
+    }
+
+    iterations *= 2;
+  }
+
+  if (seconds <= 0)
+  {
+    seconds = 1.0 / CLOCKS_PER_SEC;
+  }
+
+  printf(
+      "%s\n    {\"pipeline\":\"%s\",\"policies\":%d,\"iterations\":%lld,\"seconds\":%.6f,"
+      "\"cpu_nsec_per_request\":%.1f,\"requests_per_sec\":%.1f,\"stack_bytes\":%d,",
+      first_result ? "" : ",",
+      ref_pipeline->name,
+      (int)ref_pipeline->policy_count,
+      (long long)iterations,
+      seconds,
+      seconds * 1e9 / (double)iterations,
+      (double)iterations / seconds,
+      (int)stack_bytes);
+
+#ifdef _az_BENCHMARK_COUNT_ALLOCATIONS
+  printf(
+      "\"heap_allocations_per_request\":%lld,\"heap_bytes_per_request\":%lld}",
+      (long long)(heap_allocation_count - allocation_count),
+      (long long)(heap_allocation_bytes - allocation_bytes));
+#else
+  printf("\"heap_allocations_per_request\":null,\"heap_bytes_per_request\":null}");
+#endif // _az_BENCHMARK_COUNT_ALLOCATIONS
+
+  first_result = false;
+}
+
+int main(int argc, char** argv)
+{
+  double min_seconds = 0.2;
+  if (argc > 1)
+  {
+    min_seconds = atof(argv[1]);
+  }
+
+  az_http_loopback_transport_set_response(
+      az_span_create(benchmark_response, (int32_t)sizeof(benchmark_response) - 1));
+
+  _az_http_policy_apiversion_options api_version = _az_http_policy_apiversion_options_default();
+  api_version._internal.name = AZ_SPAN_FROM_STR("x-ms-version");
+  api_version._internal.version = AZ_SPAN_FROM_STR("2019-02-02");
+
+  _az_http_policy_telemetry_options telemetry = _az_http_policy_telemetry_options_default();
+  az_http_policy_retry_options retry = _az_http_policy_retry_options_default();
+
+  benchmark_credential credential = {
+    .credential = { ._internal = { .apply_credential_policy = benchmark_credential_apply } },
+    .authorization = AZ_SPAN_FROM_STR("Bearer eyJ0eXAiOiJKV1QiLCJhbGciOiJSUzI1NiJ9.e30.c2ln"),
+  };
+
+  _az_http_policy const transport = {
+    ._internal = { .process = az_http_pipeline_policy_transport, .options = NULL },
+  };
+
+  // The policies of a service client, as in az_storage_blobs_blob_client_init().
+  _az_http_policy const full[] = {
+    { ._internal = { .process = az_http_pipeline_policy_apiversion, .options = &api_version } },
+    { ._internal = { .process = az_http_pipeline_policy_telemetry, .options = &telemetry } },
+    { ._internal = { .process = az_http_pipeline_policy_retry, .options = &retry } },
+    { ._internal = { .process = az_http_pipeline_policy_credential, .options = &credential } },
+#ifndef AZ_NO_LOGGING
+    { ._internal = { .process = az_http_pipeline_policy_logging, .options = NULL } },
+#endif // AZ_NO_LOGGING
+    transport,
+  };
+  int32_t const full_count = (int32_t)(sizeof(full) / sizeof(full[0]));
+
+  benchmark_pipeline pipelines[] = {
+    { .name = "transport", .policy_count = 1, .logs = false },
+    { .name = "client", .policy_count = full_count, .logs = false },
+#ifndef AZ_NO_LOGGING
+    { .name = "client_logging", .policy_count = full_count, .logs = true },
+#endif // AZ_NO_LOGGING
+  };
+  int32_t const pipeline_count = (int32_t)(sizeof(pipelines) / sizeof(pipelines[0]));
+
+  pipelines[0].pipeline._internal.policies[0] = transport;
+  for (int32_t i = 1; i < pipeline_count; i++)
+  {
+    for (int32_t j = 0; j < full_count; j++)
+    {
+      pipelines[i].pipeline._internal.policies[j] = full[j];
+    }
+  }
+
+  printf("{\n  \"sdk_version\":\"%s\",\n  \"results\":[", AZ_SDK_VERSION_STRING);
+
+  for (int32_t i = 0; i < pipeline_count; i++)
+  {
+    run_benchmark(&pipelines[i], min_seconds);
+  }
+
+  printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,622 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_json_benchmark.c
+ *
+ * @brief Measures the throughput of #az_json_reader, the #az_json_token conversions and
+ * #az_json_writer over documents like the ones the SDK handles, and prints the results to stdout as
+ * JSON so that they can be compared between releases.
+ *
+ * @details Usage: `az_json_benchmark [min_seconds]`. Each benchmark runs over each document of the
+ * corpus for at least `min_seconds` (0.2 by default) of processor time. For every result, "tokens"
+ * counts the JSON tokens read, converted or written in one iteration, and "bytes" the size of the
+ * JSON text they span.
+ */
+
+#include <azure/core/az_json.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/az_version.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum
+{
+  BENCHMARK_DOCUMENT_MAX_SIZE = 16 * 1024,
+  BENCHMARK_MAX_TOKENS = 4096,
+  BENCHMARK_STRING_POOL_SIZE = 16 * 1024,
+  BENCHMARK_DEEP_DEPTH = 60,
+  BENCHMARK_ESCAPED_STRING_COUNT = 64,
+};
+
+static uint8_t twin_document[]
+    = "{\"desired\":{\"telemetrySendFrequency\":\"5m\",\"targetTemperature\":22.5,"
+      "\"fanSpeed\":3,\"firmware\":{\"version\":\"1.4.2\",\"uri\":"
+      "\"https://contoso.blob.core.windows.net/firmware/1.4.2.bin\",\"checksum\":"
+      "\"9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08\"},"
+      "\"$metadata\":{\"$lastUpdated\":\"2020-07-28T19:26:38.6107227Z\","
+      "\"$lastUpdatedVersion\":12,\"telemetrySendFrequency\":{\"$lastUpdated\":"
+      "\"2020-07-28T19:26:38.6107227Z\",\"$lastUpdatedVersion\":12},\"targetTemperature\":{"
+      "\"$lastUpdated\":\"2020-07-28T19:26:38.6107227Z\",\"$lastUpdatedVersion\":11}},"
+      "\"$version\":12},\"reported\":{\"telemetrySendFrequency\":\"5m\",\"currentTemperature\":"
+      "21.43,\"maxTempSinceLastReboot\":27.01,\"fanSpeed\":3,\"isOnline\":true,\"lastError\":null,"
+      "\"firmware\":{\"version\":\"1.4.1\",\"status\":\"downloading\",\"progress\":42},"
+      "\"$metadata\":{\"$lastUpdated\":\"2020-07-28T19:27:02.1056524Z\",\"currentTemperature\":{"
+      "\"$lastUpdated\":\"2020-07-28T19:27:02.1056524Z\"},\"fanSpeed\":{\"$lastUpdated\":"
+      "\"2020-07-28T19:26:59.9376108Z\"}},\"$version\":87}}";
+
+static uint8_t dps_document[]
+    = "{\"operationId\":\"4.d0a671905ea5b2c8.e7173b7b-0e54-4aa0-9d20-aeb1b89e6c7d\","
+      "\"status\":\"assigned\",\"registrationState\":{\"x509\":{},\"registrationId\":"
+      "\"mydevice\",\"createdDateTimeUtc\":\"2020-04-10T03:11:13.0276997Z\",\"assignedHub\":"
+      "\"contoso.azure-devices.net\",\"deviceId\":\"mydevice\",\"status\":\"assigned\","
+      "\"substatus\":\"initialAssignment\",\"lastUpdatedDateTimeUtc\":"
+      "\"2020-04-10T03:11:13.2096201Z\",\"etag\":"
+      "\"IjYxMDA4ZDQ2LTAwMDAtMDEwMC0wMDAwLTVlOGZlM2QxMDAwMCI=\","
+      "\"payload\":{\"modelId\":\"dtmi:com:example:TemperatureController;1\"}}}";
+
+static uint8_t pnp_telemetry_document[]
+    = "{\"thermostat1\":{\"temperature\":21.43,\"targetTemperature\":22.5,\"humidity\":48},"
+      "\"thermostat2\":{\"temperature\":19.875,\"targetTemperature\":20,\"humidity\":51},"
+      "\"deviceInformation\":{\"manufacturer\":\"Contoso\",\"model\":\"TC-100\","
+      "\"swVersion\":\"1.0.3\",\"osName\":\"FreeRTOS\",\"processorArchitecture\":\"ARM\","
+      "\"totalStorage\":1048576,\"totalMemory\":262144},\"workingSet\":118843,"
+      "\"serialNumber\":\"SN-0042-7731\",\"uptimeSeconds\":8640023,\"rssi\":-67,"
+      "\"accelerometer\":[0.012,-0.981,0.104],\"alarms\":[false,false,true]}";
+
+typedef struct
+{
+  char const* name;
+  az_span json;
+  int32_t token_count;
+} benchmark_document;
+
+typedef enum
+{
+  BENCHMARK_WRITE_BEGIN_OBJECT,
+  BENCHMARK_WRITE_END_OBJECT,
+  BENCHMARK_WRITE_BEGIN_ARRAY,
+  BENCHMARK_WRITE_END_ARRAY,
+  BENCHMARK_WRITE_PROPERTY_NAME,
+  BENCHMARK_WRITE_STRING,
+  BENCHMARK_WRITE_INT32,
+  BENCHMARK_WRITE_DOUBLE,
+  BENCHMARK_WRITE_BOOL,
+  BENCHMARK_WRITE_NULL,
+} benchmark_write_kind;
+
+// One call to an az_json_writer_append_* function, decoded from a document before it's timed.
+typedef struct
+{
+  benchmark_write_kind kind;
+  az_span text;
+  int32_t int32_value;
+  double double_value;
+  bool bool_value;
+} benchmark_write_op;
+
+// What the benchmark being timed works on.
+typedef struct
+{
+  benchmark_document const* document;
+  az_json_token const* tokens;
+  int32_t token_count;
+  benchmark_write_op const* ops;
+  int32_t op_count;
+} benchmark_input;
+
+// What one iteration of a benchmark processed.
+typedef struct
+{
+  int64_t tokens;
+  int64_t bytes;
+} benchmark_work;
+
+typedef benchmark_work (*benchmark_fn)(benchmark_input const* input);
+
+static uint8_t deep_buffer[BENCHMARK_DOCUMENT_MAX_SIZE];
+static uint8_t escaped_buffer[BENCHMARK_DOCUMENT_MAX_SIZE];
+static uint8_t writer_buffer[BENCHMARK_DOCUMENT_MAX_SIZE * 2];
+static char string_buffer[BENCHMARK_DOCUMENT_MAX_SIZE];
+static char string_pool[BENCHMARK_STRING_POOL_SIZE];
+static az_json_token tokens[BENCHMARK_MAX_TOKENS];
+static benchmark_write_op ops[BENCHMARK_MAX_TOKENS];
+
+// The results are folded into this, so that the compiler can't drop the work being timed.
+static volatile int64_t benchmark_sink;
+
+static bool first_result = true;
+
+static void check(az_result result, char const* what)
+{
+  if (az_result_failed(result))
+  {
+    fprintf(stderr, "%s failed with 0x%08x\n", what, (unsigned)result);
+    exit(1);
+  }
+}
+
+static az_span append_text(az_span remainder, char const* text)
+{
+  az_span const source = az_span_create_from_str((char*)(uintptr_t)text);
+  if (az_span_size(remainder) < az_span_size(source))
+  {
+    fprintf(stderr, "The benchmark corpus doesn't fit in its buffer.\n");
+    exit(1);
+  }
+
+  return az_span_copy(remainder, source);
+}
+
+// {"level":{"level":...{"leaf":[1,2.5,"x",true,null]}...}}
+static az_span build_deep_document(void)
+{
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(deep_buffer);
+  az_span remainder = buffer;
+  for (int32_t i = 0; i < BENCHMARK_DEEP_DEPTH - 2; i++)
+  {
+    remainder = append_text(remainder, "{\"level\":");
+  }
+
+  remainder = append_text(remainder, "{\"leaf\":[1,2.5,\"x\",true,null]}");
+  for (int32_t i = 0; i < BENCHMARK_DEEP_DEPTH - 2; i++)
+  {
+    remainder = append_text(remainder, "}");
+  }
+
+  return az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder));
+}
+
+// {"messages":["...","...",...]}, with every kind of escape sequence in each string but \uXXXX,
+// which az_json_token_get_string() doesn't unescape.
+static az_span build_escaped_document(void)
+{
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(escaped_buffer);
+  az_span remainder = append_text(buffer, "{\"messages\":[");
+  for (int32_t i = 0; i < BENCHMARK_ESCAPED_STRING_COUNT; i++)
+  {
+    if (i > 0)
+    {
+      remainder = append_text(remainder, ",");
+    }
+
+    remainder = append_text(
+        remainder,
+        "\"C:\\\\logs\\\\device.log: \\\"sensor\\\" read\\tfailed\\r\\n"
+        "retry \\/var\\/log\\b\\f \\\"again\\\"\"");
+  }
+
+  remainder = append_text(remainder, "]}");
+  return az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder));
+}
+
+static int32_t count_tokens(az_span json)
+{
+  az_json_reader reader;
+  check(az_json_reader_init(&reader, json, NULL), "az_json_reader_init");
+
+  int32_t count = 0;
+  az_result result;
+  while ((result = az_json_reader_next_token(&reader)) == AZ_OK)
+  {
+    count++;
+  }
+
+  if (result != AZ_ERROR_JSON_READER_DONE)
+  {
+    check(result, "az_json_reader_next_token");
+  }
+
+  return count;
+}
+
+typedef bool (*token_filter_fn)(az_json_token const* token);
+
+static bool is_number(az_json_token const* token) { return token->kind == AZ_JSON_TOKEN_NUMBER; }
+
+static bool is_int32(az_json_token const* token)
+{
+  int32_t value = 0;
+  return token->kind == AZ_JSON_TOKEN_NUMBER
+      && az_json_token_get_int32(token, &value) == AZ_OK;
+}
+
+static bool is_int64(az_json_token const* token)
+{
+  int64_t value = 0;
+  return token->kind == AZ_JSON_TOKEN_NUMBER
+      && az_json_token_get_int64(token, &value) == AZ_OK;
+}
+
+static bool is_string(az_json_token const* token) { return token->kind == AZ_JSON_TOKEN_STRING; }
+
+static bool is_property_name(az_json_token const* token)
+{
+  return token->kind == AZ_JSON_TOKEN_PROPERTY_NAME;
+}
+
+// Copies the tokens of the document which the filter accepts, so that only their conversion is
+// timed.
+static int32_t collect_tokens(az_span json, token_filter_fn filter)
+{
+  az_json_reader reader;
+  check(az_json_reader_init(&reader, json, NULL), "az_json_reader_init");
+
+  int32_t count = 0;
+  while (count < BENCHMARK_MAX_TOKENS && az_json_reader_next_token(&reader) == AZ_OK)
+  {
+    if (filter(&reader.token))
+    {
+      tokens[count++] = reader.token;
+    }
+  }
+
+  return count;
+}
+
+// Decodes the document into the sequence of writer calls which writes it again.
+static int32_t collect_write_ops(az_span json)
+{
+  az_json_reader reader;
+  check(az_json_reader_init(&reader, json, NULL), "az_json_reader_init");
+
+  int32_t count = 0;
+  int32_t pool_used = 0;
+  while (count < BENCHMARK_MAX_TOKENS && az_json_reader_next_token(&reader) == AZ_OK)
+  {
+    az_json_token const* token = &reader.token;
+    benchmark_write_op op = { .kind = BENCHMARK_WRITE_NULL, .text = AZ_SPAN_EMPTY };
+    switch (token->kind)
+    {
+      case AZ_JSON_TOKEN_BEGIN_OBJECT:
+        op.kind = BENCHMARK_WRITE_BEGIN_OBJECT;
+        break;
+      case AZ_JSON_TOKEN_END_OBJECT:
+        op.kind = BENCHMARK_WRITE_END_OBJECT;
+        break;
+      case AZ_JSON_TOKEN_BEGIN_ARRAY:
+        op.kind = BENCHMARK_WRITE_BEGIN_ARRAY;
+        break;
+      case AZ_JSON_TOKEN_END_ARRAY:
+        op.kind = BENCHMARK_WRITE_END_ARRAY;
+        break;
+      case AZ_JSON_TOKEN_PROPERTY_NAME:
+      case AZ_JSON_TOKEN_STRING:
+      {
+        op.kind = token->kind == AZ_JSON_TOKEN_STRING ? BENCHMARK_WRITE_STRING
+                                                      : BENCHMARK_WRITE_PROPERTY_NAME;
+        int32_t length = 0;
+        check(
+            az_json_token_get_string(
+                token,
+                &string_pool[pool_used],
+                BENCHMARK_STRING_POOL_SIZE - pool_used,
+                &length),
+            "az_json_token_get_string");
+        op.text = az_span_create((uint8_t*)&string_pool[pool_used], length);
+        pool_used += length + 1;
+        break;
+      }
+      case AZ_JSON_TOKEN_NUMBER:
+        if (az_json_token_get_int32(token, &op.int32_value) == AZ_OK)
+        {
+          op.kind = BENCHMARK_WRITE_INT32;
+        }
+        else
+        {
+          op.kind = BENCHMARK_WRITE_DOUBLE;
+          check(az_json_token_get_double(token, &op.double_value), "az_json_token_get_double");
+        }
+        break;
+      case AZ_JSON_TOKEN_TRUE:
+      case AZ_JSON_TOKEN_FALSE:
+        op.kind = BENCHMARK_WRITE_BOOL;
+        op.bool_value = token->kind == AZ_JSON_TOKEN_TRUE;
+        break;
+      default:
+        op.kind = BENCHMARK_WRITE_NULL;
+        break;
+    }
+
+    ops[count++] = op;
+  }
+
+  return count;
+}
+
+static benchmark_work benchmark_reader_next_token(benchmark_input const* input)
+{
+  az_json_reader reader;
+  check(az_json_reader_init(&reader, input->document->json, NULL), "az_json_reader_init");
+
+  int64_t count = 0;
+  while (az_json_reader_next_token(&reader) == AZ_OK)
+  {
+    count++;
+  }
+
+  benchmark_sink += count;
+  return (benchmark_work){ .tokens = count, .bytes = az_span_size(input->document->json) };
+}
+
+static benchmark_work benchmark_reader_skip_children(benchmark_input const* input)
+{
+  az_json_reader reader;
+  check(az_json_reader_init(&reader, input->document->json, NULL), "az_json_reader_init");
+  check(az_json_reader_next_token(&reader), "az_json_reader_next_token");
+  check(az_json_reader_skip_children(&reader), "az_json_reader_skip_children");
+
+  benchmark_sink += reader.token.kind;
+  return (benchmark_work){ .tokens = input->document->token_count,
+                           .bytes = az_span_size(input->document->json) };
+}
+
+static int64_t token_bytes(benchmark_input const* input)
+{
+  int64_t bytes = 0;
+  for (int32_t i = 0; i < input->token_count; i++)
+  {
+    bytes += input->tokens[i].size;
+  }
+
+  return bytes;
+}
+
+static benchmark_work benchmark_token_get_int32(benchmark_input const* input)
+{
+  int64_t total = 0;
+  for (int32_t i = 0; i < input->token_count; i++)
+  {
+    int32_t value = 0;
+    check(az_json_token_get_int32(&input->tokens[i], &value), "az_json_token_get_int32");
+    total += value;
+  }
+
+  benchmark_sink += total;
+  return (benchmark_work){ .tokens = input->token_count, .bytes = token_bytes(input) };
+}
+
+static benchmark_work benchmark_token_get_int64(benchmark_input const* input)
+{
+  int64_t total = 0;
+  for (int32_t i = 0; i < input->token_count; i++)
+  {
+    int64_t value = 0;
+    check(az_json_token_get_int64(&input->tokens[i], &value), "az_json_token_get_int64");
+    total += value;
+  }
+
+  benchmark_sink += total;
+  return (benchmark_work){ .tokens = input->token_count, .bytes = token_bytes(input) };
+}
+
+static benchmark_work benchmark_token_get_double(benchmark_input const* input)
+{
+  double total = 0;
+  for (int32_t i = 0; i < input->token_count; i++)
+  {
+    double value = 0;
+    check(az_json_token_get_double(&input->tokens[i], &value), "az_json_token_get_double");
+    total += value;
+  }
+
+  benchmark_sink += (int64_t)total;
+  return (benchmark_work){ .tokens = input->token_count, .bytes = token_bytes(input) };
+}
+
+static benchmark_work benchmark_token_get_string(benchmark_input const* input)
+{
+  int64_t total = 0;
+  for (int32_t i = 0; i < input->token_count; i++)
+  {
+    int32_t length = 0;
+    check(
+        az_json_token_get_string(
+            &input->tokens[i], string_buffer, (int32_t)sizeof(string_buffer), &length),
+        "az_json_token_get_string");
+    total += length;
+  }
+
+  benchmark_sink += total;
+  return (benchmark_work){ .tokens = input->token_count, .bytes = token_bytes(input) };
+}
+
+static benchmark_work benchmark_token_is_text_equal(benchmark_input const* input)
+{
+  int64_t matches = 0;
+  for (int32_t i = 0; i < input->token_count; i++)
+  {
+    // Compare against the next property name, as a lookup of the properties of a known schema
+    // would, so that both matches and mismatches are measured.
+    az_json_token const* expected = &input->tokens[(i + 1) % input->token_count];
+    if (az_json_token_is_text_equal(&input->tokens[i], expected->slice))
+    {
+      matches++;
+    }
+  }
+
+  benchmark_sink += matches;
+  return (benchmark_work){ .tokens = input->token_count, .bytes = token_bytes(input) };
+}
+
+static benchmark_work benchmark_writer_append(benchmark_input const* input)
+{
+  az_json_writer writer;
+  check(
+      az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(writer_buffer), NULL),
+      "az_json_writer_init");
+
+  for (int32_t i = 0; i < input->op_count; i++)
+  {
+    benchmark_write_op const* op = &input->ops[i];
+    az_result result = AZ_OK;
+    switch (op->kind)
+    {
+      case BENCHMARK_WRITE_BEGIN_OBJECT:
+        result = az_json_writer_append_begin_object(&writer);
+        break;
+      case BENCHMARK_WRITE_END_OBJECT:
+        result = az_json_writer_append_end_object(&writer);
+        break;
+      case BENCHMARK_WRITE_BEGIN_ARRAY:
+        result = az_json_writer_append_begin_array(&writer);
+        break;
+      case BENCHMARK_WRITE_END_ARRAY:
+        result = az_json_writer_append_end_array(&writer);
+        break;
+      case BENCHMARK_WRITE_PROPERTY_NAME:
+        result = az_json_writer_append_property_name(&writer, op->text);
+        break;
+      case BENCHMARK_WRITE_STRING:
+        result = az_json_writer_append_string(&writer, op->text);
+        break;
+      case BENCHMARK_WRITE_INT32:
+        result = az_json_writer_append_int32(&writer, op->int32_value);
+        break;
+      case BENCHMARK_WRITE_DOUBLE:
+        result = az_json_writer_append_double_shortest(&writer, op->double_value);
+        break;
+      case BENCHMARK_WRITE_BOOL:
+        result = az_json_writer_append_bool(&writer, op->bool_value);
+        break;
+      case BENCHMARK_WRITE_NULL:
+        result = az_json_writer_append_null(&writer);
+        break;
+    }
+
+    check(result, "az_json_writer_append");
+  }
+
+  int32_t const written = az_span_size(az_json_writer_get_bytes_used_in_destination(&writer));
+  benchmark_sink += written;
+  return (benchmark_work){ .tokens = input->op_count, .bytes = written };
+}
+
+static double elapsed_seconds(clock_t start) { return (double)(clock() - start) / CLOCKS_PER_SEC; }
+
+// Runs the benchmark in batches twice as large as the one before, until a batch takes at least
+// min_seconds, and reports that batch.
+static void run_benchmark(
+    char const* name,
+    benchmark_fn benchmark,
+    benchmark_input const* input,
+    double min_seconds)
+{
+  // One iteration outside of the timing, for the caches and to know how much work it does.
+  benchmark_work const work = benchmark(input);
+
+  int64_t iterations = 1;
+  double seconds = 0;
+  while (true)
+  {
+    clock_t const start = clock();
+    for (int64_t i = 0; i < iterations; i++)
+    {
+      (void)benchmark(input);
+    }
+
+    seconds = elapsed_seconds(start);
+    if (seconds >= min_seconds || iterations >= INT64_MAX / 2)
+    {
+      break;
+    }
+
+    iterations *= 2;
+  }
+
+  if (seconds <= 0)
+  {
+    seconds = 1.0 / CLOCKS_PER_SEC;
+  }
+
+  double const tokens_per_sec = (double)(work.tokens * iterations) / seconds;
+  double const mb_per_sec = (double)(work.bytes * iterations) / seconds / (1024.0 * 1024.0);
+
+  printf(
+      "%s\n    {\"benchmark\":\"%s\",\"document\":\"%s\",\"iterations\":%lld,\"tokens\":%lld,"
+      "\"bytes\":%lld,\"seconds\":%.6f,\"tokens_per_sec\":%.1f,\"mb_per_sec\":%.3f}",
+      first_result ? "" : ",",
+      name,
+      input->document->name,
+      (long long)iterations,
+      (long long)work.tokens,
+      (long long)work.bytes,
+      seconds,
+      tokens_per_sec,
+      mb_per_sec);
+  first_result = false;
+}
+
+static void run_token_benchmark(
+    char const* name,
+    benchmark_fn benchmark,
+    token_filter_fn filter,
+    benchmark_document const* document,
+    double min_seconds)
+{
+  int32_t const count = collect_tokens(document->json, filter);
+  if (count > 0)
+  {
+    benchmark_input const input = { .document = document, .tokens = tokens, .token_count = count };
+    run_benchmark(name, benchmark, &input, min_seconds);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  double min_seconds = 0.2;
+  if (argc > 1)
+  {
+    min_seconds = atof(argv[1]);
+  }
+
+  benchmark_document documents[] = {
+    { .name = "twin", .json = az_span_create(twin_document, sizeof(twin_document) - 1) },
+    { .name = "dps_response", .json = az_span_create(dps_document, sizeof(dps_document) - 1) },
+    { .name = "pnp_telemetry",
+      .json = az_span_create(pnp_telemetry_document, sizeof(pnp_telemetry_document) - 1) },
+    { .name = "deep", .json = build_deep_document() },
+    { .name = "escaped_strings", .json = build_escaped_document() },
+  };
+  int32_t const document_count = (int32_t)(sizeof(documents) / sizeof(documents[0]));
+
+  printf("{\n  \"sdk_version\":\"%s\",\n  \"results\":[", AZ_SDK_VERSION_STRING);
+
+  for (int32_t i = 0; i < document_count; i++)
+  {
+    benchmark_document* const document = &documents[i];
+    document->token_count = count_tokens(document->json);
+
+    benchmark_input const input = { .document = document };
+    run_benchmark("az_json_reader_next_token", benchmark_reader_next_token, &input, min_seconds);
+    run_benchmark(
+        "az_json_reader_skip_children", benchmark_reader_skip_children, &input, min_seconds);
+
+    run_token_benchmark(
+        "az_json_token_get_int32", benchmark_token_get_int32, is_int32, document, min_seconds);
+    run_token_benchmark(
+        "az_json_token_get_int64", benchmark_token_get_int64, is_int64, document, min_seconds);
+    run_token_benchmark(
+        "az_json_token_get_double", benchmark_token_get_double, is_number, document, min_seconds);
+    run_token_benchmark(
+        "az_json_token_get_string", benchmark_token_get_string, is_string, document, min_seconds);
+    run_token_benchmark(
+        "az_json_token_is_text_equal",
+        benchmark_token_is_text_equal,
+        is_property_name,
+        document,
+        min_seconds);
+
+    benchmark_input const write_input
+        = { .document = document, .ops = ops, .op_count = collect_write_ops(document->json) };
+    run_benchmark("az_json_writer_append", benchmark_writer_append, &write_input, min_seconds);
+  }
+
+  printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,573 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_benchmark.c
+ *
+ * @brief See az_iot_benchmark.h. Usage on a host: `az_iot_benchmark [min_msec]`, where each
+ * benchmark runs for at least `min_msec` (200 by default) milliseconds.
+ */
+
+#include "az_iot_benchmark.h"
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/az_version.h>
+#include <azure/iot/az_iot_common.h>
+#include <azure/iot/az_iot_hub_client.h>
+#include <azure/iot/az_iot_provisioning_client.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef AZ_BENCHMARK_CLOCK_NSEC
+#define AZ_BENCHMARK_CLOCK_NSEC() ((int64_t)((double)clock() * (1e9 / (double)CLOCKS_PER_SEC)))
+#endif
+
+#ifndef AZ_BENCHMARK_CYCLE_COUNT
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define AZ_BENCHMARK_CYCLE_COUNT() ((uint64_t)__rdtsc())
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define AZ_BENCHMARK_CYCLE_COUNT() ((uint64_t)__rdtsc())
+#endif
+#endif // AZ_BENCHMARK_CYCLE_COUNT
+
+#ifndef AZ_BENCHMARK_PRINTF
+#define AZ_BENCHMARK_PRINTF printf
+#endif
+
+#define TEST_HUB_HOSTNAME "contoso-hub.azure-devices.net"
+#define TEST_DEVICE_ID "thermostat-0042"
+#define TEST_DPS_HOSTNAME "global.azure-devices-provisioning.net"
+#define TEST_ID_SCOPE "0ne00003E26"
+#define TEST_OPERATION_ID "4.d0a671905ea5b2c8.e7173b7b-0e54-4aa0-9d20-aeb1b89e6c7d"
+
+enum
+{
+  BENCHMARK_TOPIC_SIZE = 256,
+  BENCHMARK_SIGNATURE_SIZE = 256,
+  BENCHMARK_PASSWORD_SIZE = 512,
+  BENCHMARK_PROPERTY_COUNT = 4,
+  BENCHMARK_SAS_EXPIRY = 1600000000,
+};
+
+static uint8_t properties_buffer[]
+    = "$.ct=application%2Fjson&$.ce=utf-8&sensor=thermostat1&alert=overheat";
+static uint8_t c2d_topic[] = "devices/" TEST_DEVICE_ID
+                             "/messages/devicebound/%24.mid=4fd3a1c2&%24.to=%2Fdevices%2F"
+                             TEST_DEVICE_ID "%2Fmessages%2FdeviceBound&command=reboot";
+static uint8_t methods_topic[] = "$iothub/methods/POST/setTargetTemperature/?$rid=1a2b";
+static uint8_t twin_response_topic[] = "$iothub/twin/res/200/?$rid=7&$version=87";
+static uint8_t twin_patch_topic[] = "$iothub/twin/PATCH/properties/desired/?$version=13";
+static uint8_t dps_topic[] = "$dps/registrations/res/200/?$rid=1";
+static uint8_t dps_payload[]
+    = "{\"operationId\":\"" TEST_OPERATION_ID "\",\"status\":\"assigned\","
+      "\"registrationState\":{\"x509\":{},\"registrationId\":\"" TEST_DEVICE_ID "\","
+      "\"createdDateTimeUtc\":\"2020-04-10T03:11:13.0276997Z\",\"assignedHub\":\"" TEST_HUB_HOSTNAME
+      "\",\"deviceId\":\"" TEST_DEVICE_ID "\",\"status\":\"assigned\","
+      "\"substatus\":\"initialAssignment\",\"lastUpdatedDateTimeUtc\":"
+      "\"2020-04-10T03:11:13.2096201Z\",\"etag\":"
+      "\"IjYxMDA4ZDQ2LTAwMDAtMDEwMC0wMDAwLTVlOGZlM2QxMDAwMCI=\"}}";
+
+#define BENCHMARK_SPAN(buffer) az_span_create((buffer), (int32_t)sizeof(buffer) - 1)
+
+// The state the benchmarks work on, set up once before they are timed.
+typedef struct
+{
+  az_iot_hub_client hub_client;
+  az_iot_hub_client hub_client_prefixed;
+  uint8_t topic_prefix_buffer[AZ_IOT_HUB_CLIENT_TOPIC_PREFIX_BUFFER_SIZE(
+      sizeof(TEST_DEVICE_ID) - 1,
+      0)];
+  az_iot_provisioning_client provisioning_client;
+  az_iot_message_properties properties;
+  az_iot_message_properties indexed_properties;
+  az_iot_message_property property_index[BENCHMARK_PROPERTY_COUNT];
+  uint8_t signature[BENCHMARK_SIGNATURE_SIZE];
+} benchmark_context;
+
+// Returns AZ_OK, or the first failure, for one call of the function being measured.
+typedef az_result (*benchmark_fn)(benchmark_context* context);
+
+static char topic_buffer[BENCHMARK_TOPIC_SIZE];
+static char password_buffer[BENCHMARK_PASSWORD_SIZE];
+
+// The results are folded into this, so that the compiler can't drop the work being timed.
+static volatile int64_t benchmark_sink;
+
+static bool first_result = true;
+
+static az_result benchmark_telemetry_topic(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_hub_client_telemetry_get_publish_topic(
+      &context->hub_client, NULL, topic_buffer, sizeof(topic_buffer), &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result benchmark_telemetry_topic_prefixed(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_hub_client_telemetry_get_publish_topic(
+      &context->hub_client_prefixed, NULL, topic_buffer, sizeof(topic_buffer), &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result benchmark_telemetry_topic_properties(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_hub_client_telemetry_get_publish_topic(
+      &context->hub_client, &context->properties, topic_buffer, sizeof(topic_buffer), &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result benchmark_c2d_parse(benchmark_context* context)
+{
+  az_iot_hub_client_c2d_request request;
+  az_result const result = az_iot_hub_client_c2d_parse_received_topic(
+      &context->hub_client, BENCHMARK_SPAN(c2d_topic), &request);
+  benchmark_sink += az_span_size(request.properties._internal.properties_buffer);
+  return result;
+}
+
+static az_result benchmark_methods_parse(benchmark_context* context)
+{
+  az_iot_hub_client_method_request request;
+  az_result const result = az_iot_hub_client_methods_parse_received_topic(
+      &context->hub_client, BENCHMARK_SPAN(methods_topic), &request);
+  benchmark_sink += az_span_size(request.name);
+  return result;
+}
+
+static az_result benchmark_twin_parse_response(benchmark_context* context)
+{
+  az_iot_hub_client_twin_response response;
+  az_result const result = az_iot_hub_client_twin_parse_received_topic(
+      &context->hub_client, BENCHMARK_SPAN(twin_response_topic), &response);
+  benchmark_sink += az_span_size(response.version);
+  return result;
+}
+
+static az_result benchmark_twin_parse_patch(benchmark_context* context)
+{
+  az_iot_hub_client_twin_response response;
+  az_result const result = az_iot_hub_client_twin_parse_received_topic(
+      &context->hub_client, BENCHMARK_SPAN(twin_patch_topic), &response);
+  benchmark_sink += az_span_size(response.version);
+  return result;
+}
+
+static az_result benchmark_parse_any(benchmark_context* context)
+{
+  az_iot_hub_client_received_topic topic;
+  az_result const result = az_iot_hub_client_parse_received_topic(
+      &context->hub_client, BENCHMARK_SPAN(methods_topic), &topic);
+  benchmark_sink += (int64_t)topic.type;
+  return result;
+}
+
+static az_result benchmark_properties_find(benchmark_context* context)
+{
+  // The last property, so that the whole buffer is scanned.
+  az_span value = AZ_SPAN_EMPTY;
+  az_result const result = az_iot_message_properties_find(
+      &context->properties, AZ_SPAN_FROM_STR("alert"), &value);
+  benchmark_sink += az_span_size(value);
+  return result;
+}
+
+static az_result benchmark_properties_find_indexed(benchmark_context* context)
+{
+  az_span value = AZ_SPAN_EMPTY;
+  az_result const result = az_iot_message_properties_find(
+      &context->indexed_properties, AZ_SPAN_FROM_STR("alert"), &value);
+  benchmark_sink += az_span_size(value);
+  return result;
+}
+
+// Iterates over all of the properties, from a copy so that each call starts over.
+static az_result walk_properties(az_iot_message_properties const* properties)
+{
+  az_iot_message_properties iterator = *properties;
+  az_span name = AZ_SPAN_EMPTY;
+  az_span value = AZ_SPAN_EMPTY;
+  az_result result;
+  while ((result = az_iot_message_properties_next(&iterator, &name, &value)) == AZ_OK)
+  {
+    benchmark_sink += az_span_size(value);
+  }
+
+  return result == AZ_ERROR_IOT_END_OF_PROPERTIES ? AZ_OK : result;
+}
+
+static az_result benchmark_properties_next(benchmark_context* context)
+{
+  return walk_properties(&context->properties);
+}
+
+static az_result benchmark_properties_next_indexed(benchmark_context* context)
+{
+  return walk_properties(&context->indexed_properties);
+}
+
+static az_result benchmark_hub_sas_signature(benchmark_context* context)
+{
+  az_span signature = AZ_SPAN_EMPTY;
+  az_result const result = az_iot_hub_client_sas_get_signature(
+      &context->hub_client,
+      BENCHMARK_SAS_EXPIRY,
+      AZ_SPAN_FROM_BUFFER(context->signature),
+      &signature);
+  benchmark_sink += az_span_size(signature);
+  return result;
+}
+
+static az_result benchmark_hub_sas_password(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_hub_client_sas_get_password(
+      &context->hub_client,
+      BENCHMARK_SAS_EXPIRY,
+      AZ_SPAN_FROM_STR("dGhpcyBpcyBhIGZha2Ugc2lnbmF0dXJlIG9mIDMyIGJ5dGU="),
+      AZ_SPAN_EMPTY,
+      password_buffer,
+      sizeof(password_buffer),
+      &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result benchmark_provisioning_register_topic(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_provisioning_client_register_get_publish_topic(
+      &context->provisioning_client, topic_buffer, sizeof(topic_buffer), &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result benchmark_provisioning_query_topic(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_provisioning_client_query_status_get_publish_topic(
+      &context->provisioning_client,
+      AZ_SPAN_FROM_STR(TEST_OPERATION_ID),
+      topic_buffer,
+      sizeof(topic_buffer),
+      &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result benchmark_provisioning_parse(benchmark_context* context)
+{
+  az_iot_provisioning_client_register_response response;
+  az_result const result = az_iot_provisioning_client_parse_received_topic_and_payload(
+      &context->provisioning_client,
+      BENCHMARK_SPAN(dps_topic),
+      BENCHMARK_SPAN(dps_payload),
+      &response);
+  benchmark_sink += az_span_size(response.registration_state.assigned_hub_hostname);
+  return result;
+}
+
+static az_result benchmark_provisioning_sas_signature(benchmark_context* context)
+{
+  az_span signature = AZ_SPAN_EMPTY;
+  az_result const result = az_iot_provisioning_client_sas_get_signature(
+      &context->provisioning_client,
+      BENCHMARK_SAS_EXPIRY,
+      AZ_SPAN_FROM_BUFFER(context->signature),
+      &signature);
+  benchmark_sink += az_span_size(signature);
+  return result;
+}
+
+static az_result benchmark_provisioning_sas_password(benchmark_context* context)
+{
+  size_t length = 0;
+  az_result const result = az_iot_provisioning_client_sas_get_password(
+      &context->provisioning_client,
+      AZ_SPAN_FROM_STR("dGhpcyBpcyBhIGZha2Ugc2lnbmF0dXJlIG9mIDMyIGJ5dGU="),
+      BENCHMARK_SAS_EXPIRY,
+      AZ_SPAN_FROM_STR("registration"),
+      password_buffer,
+      sizeof(password_buffer),
+      &length);
+  benchmark_sink += (int64_t)length;
+  return result;
+}
+
+static az_result setup_context(benchmark_context* context)
+{
+  az_result result = az_iot_hub_client_init(
+      &context->hub_client,
+      AZ_SPAN_FROM_STR(TEST_HUB_HOSTNAME),
+      AZ_SPAN_FROM_STR(TEST_DEVICE_ID),
+      NULL);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.topic_prefix_buffer = AZ_SPAN_FROM_BUFFER(context->topic_prefix_buffer);
+  result = az_iot_hub_client_init(
+      &context->hub_client_prefixed,
+      AZ_SPAN_FROM_STR(TEST_HUB_HOSTNAME),
+      AZ_SPAN_FROM_STR(TEST_DEVICE_ID),
+      &options);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  result = az_iot_provisioning_client_init(
+      &context->provisioning_client,
+      AZ_SPAN_FROM_STR(TEST_DPS_HOSTNAME),
+      AZ_SPAN_FROM_STR(TEST_ID_SCOPE),
+      AZ_SPAN_FROM_STR(TEST_DEVICE_ID),
+      NULL);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  az_span const properties = BENCHMARK_SPAN(properties_buffer);
+  result = az_iot_message_properties_init(
+      &context->properties, properties, az_span_size(properties));
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  context->indexed_properties = context->properties;
+  return az_iot_message_properties_build_index(
+      &context->indexed_properties, context->property_index, BENCHMARK_PROPERTY_COUNT);
+}
+
+// Runs the benchmark in batches twice as large as the one before, until a batch takes at least
+// min_msec, and reports that batch.
+static bool run_benchmark(
+    char const* name,
+    char const* case_name,
+    benchmark_fn benchmark,
+    benchmark_context* context,
+    int32_t min_msec)
+{
+  // One call outside of the timing, for the caches and to check that it succeeds.
+  az_result const result = benchmark(context);
+  if (az_result_failed(result))
+  {
+    fprintf(stderr, "%s (%s) failed with 0x%08x\n", name, case_name, (unsigned)result);
+    return false;
+  }
+
+  int64_t const min_nsec = (int64_t)min_msec * 1000000;
+  int64_t iterations = 1;
+  int64_t nsec = 0;
+  uint64_t cycles = 0;
+  while (true)
+  {
+#ifdef AZ_BENCHMARK_CYCLE_COUNT
+    uint64_t const start_cycles = AZ_BENCHMARK_CYCLE_COUNT();
+#endif
+    int64_t const start = AZ_BENCHMARK_CLOCK_NSEC();
+    for (int64_t i = 0; i < iterations; i++)
+    {
+      benchmark_sink += (int64_t)benchmark(context);
+    }
+
+    nsec = AZ_BENCHMARK_CLOCK_NSEC() - start;
+#ifdef AZ_BENCHMARK_CYCLE_COUNT
+    cycles = AZ_BENCHMARK_CYCLE_COUNT() - start_cycles;
+#endif
+    if (nsec >= min_nsec || iterations >= INT64_MAX / 2)
+    {
+      break;
+    }
+
+    iterations *= 2;
+  }
+
+  // Hundredths of a nanosecond and of a cycle, printed as fixed point numbers.
+  int64_t const centi_nsec = nsec * 100 / iterations;
+
+  AZ_BENCHMARK_PRINTF(
+      "%s\n    {\"benchmark\":\"%s\",\"case\":\"%s\",\"iterations\":%lld,"
+      "\"ns_per_op\":%lld.%02lld,\"cycles_per_op\":",
+      first_result ? "" : ",",
+      name,
+      case_name,
+      (long long)iterations,
+      (long long)(centi_nsec / 100),
+      (long long)(centi_nsec % 100));
+
+#ifdef AZ_BENCHMARK_CYCLE_COUNT
+  uint64_t const centi_cycles = cycles * 100 / (uint64_t)iterations;
+  AZ_BENCHMARK_PRINTF(
+      "%llu.%02llu}",
+      (unsigned long long)(centi_cycles / 100),
+      (unsigned long long)(centi_cycles % 100));
+#else
+  (void)cycles;
+  AZ_BENCHMARK_PRINTF("null}");
+#endif
+
+  first_result = false;
+  return true;
+}
+
+int az_iot_benchmark_run(int32_t min_msec)
+{
+  static benchmark_context context;
+  az_result const result = setup_context(&context);
+  if (az_result_failed(result))
+  {
+    fprintf(stderr, "Setting up the clients failed with 0x%08x\n", (unsigned)result);
+    return 1;
+  }
+
+  AZ_BENCHMARK_PRINTF("{\n  \"sdk_version\":\"%s\",\n  \"results\":[", AZ_SDK_VERSION_STRING);
+
+  bool succeeded = true;
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_telemetry_get_publish_topic",
+      "no_properties",
+      benchmark_telemetry_topic,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_telemetry_get_publish_topic",
+      "no_properties_prefix_buffer",
+      benchmark_telemetry_topic_prefixed,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_telemetry_get_publish_topic",
+      "4_properties",
+      benchmark_telemetry_topic_properties,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_c2d_parse_received_topic",
+      "3_properties",
+      benchmark_c2d_parse,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_methods_parse_received_topic",
+      "request",
+      benchmark_methods_parse,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_twin_parse_received_topic",
+      "response",
+      benchmark_twin_parse_response,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_twin_parse_received_topic",
+      "desired_patch",
+      benchmark_twin_parse_patch,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_parse_received_topic",
+      "method_request",
+      benchmark_parse_any,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_message_properties_find",
+      "last_of_4",
+      benchmark_properties_find,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_message_properties_find",
+      "last_of_4_indexed",
+      benchmark_properties_find_indexed,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_message_properties_next",
+      "all_4",
+      benchmark_properties_next,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_message_properties_next",
+      "all_4_indexed",
+      benchmark_properties_next_indexed,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_sas_get_signature",
+      "device",
+      benchmark_hub_sas_signature,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_hub_client_sas_get_password",
+      "device",
+      benchmark_hub_sas_password,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_provisioning_client_register_get_publish_topic",
+      "register",
+      benchmark_provisioning_register_topic,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_provisioning_client_query_status_get_publish_topic",
+      "query",
+      benchmark_provisioning_query_topic,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_provisioning_client_parse_received_topic_and_payload",
+      "assigned",
+      benchmark_provisioning_parse,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_provisioning_client_sas_get_signature",
+      "registration",
+      benchmark_provisioning_sas_signature,
+      &context,
+      min_msec);
+  succeeded &= run_benchmark(
+      "az_iot_provisioning_client_sas_get_password",
+      "registration",
+      benchmark_provisioning_sas_password,
+      &context,
+      min_msec);
+
+  AZ_BENCHMARK_PRINTF("\n  ]\n}\n");
+  return succeeded ? 0 : 1;
+}
+
+#ifndef AZ_BENCHMARK_NO_MAIN
+int main(int argc, char** argv)
+{
+  int32_t min_msec = 200;
+  if (argc > 1)
+  {
+    min_msec = (int32_t)atoi(argv[1]);
+  }
+
+  return az_iot_benchmark_run(min_msec);
+}
+#endif // AZ_BENCHMARK_NO_MAIN
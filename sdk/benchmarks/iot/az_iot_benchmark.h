@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_benchmark.h
+ *
+ * @brief Measures the per-message IoT Hub and Provisioning client calls: building publish topics,
+ * parsing received topics, reading message properties and building SAS tokens.
+ *
+ * @details The results are printed as JSON, with the nanoseconds and cycles per call. On a host,
+ * the benchmark is its own program. To run it on a target MCU, compile az_iot_benchmark.c into the
+ * firmware with `AZ_BENCHMARK_NO_MAIN` defined, call #az_iot_benchmark_run(), and define as
+ * needed:
+ *   - `AZ_BENCHMARK_CLOCK_NSEC()`: an expression giving a monotonic time, in nanoseconds, as an
+ *     `int64_t`. It defaults to the processor time from `clock()`.
+ *   - `AZ_BENCHMARK_CYCLE_COUNT()`: an expression giving a cycle counter as a `uint64_t`, such as
+ *     `DWT->CYCCNT` on Cortex-M. It defaults to the time stamp counter on x86, and the cycles are
+ *     reported as `null` elsewhere.
+ *   - `AZ_BENCHMARK_PRINTF`: the `printf()`-like function the results are written with.
+ *
+ * Only integers are printed, so the output doesn't need floating point support in `printf()`.
+ */
+
+#ifndef _az_IOT_BENCHMARK_H
+#define _az_IOT_BENCHMARK_H
+
+#include <stdint.h>
+
+/**
+ * @brief Runs each benchmark for at least \p min_msec milliseconds and prints the results.
+ *
+ * @param[in] min_msec The time, in milliseconds, each benchmark runs for.
+ *
+ * @return `0` if all of the calls succeeded, `1` otherwise.
+ */
+int az_iot_benchmark_run(int32_t min_msec);
+
+#endif // _az_IOT_BENCHMARK_H
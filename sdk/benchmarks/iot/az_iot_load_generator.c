@@ -0,0 +1,611 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_load_generator.c
+ *
+ * @brief See az_iot_load_generator.h. Usage: `az_iot_load_generator [device_count]
+ * [messages_per_device]`, 100 devices sending 100 messages each by default, through the in-memory
+ * broker. Define `AZ_BENCHMARK_NO_MAIN` to call #az_iot_load_generator_run() with another backend,
+ * `AZ_BENCHMARK_CLOCK_NSEC()` for an expression giving a monotonic time, in nanoseconds, as an
+ * `int64_t`, and `AZ_BENCHMARK_PRINTF` for the `printf()`-like function the results are written
+ * with.
+ */
+
+#include "az_iot_load_generator.h"
+#include "az_iot_load_mqtt.h"
+
+#include <azure/core/az_json.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/az_version.h>
+#include <azure/iot/az_iot_common.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef AZ_BENCHMARK_CLOCK_NSEC
+#if defined(_WIN32) || defined(CLOCK_MONOTONIC)
+#define AZ_BENCHMARK_CLOCK_NSEC() load_clock_nsec()
+#else
+#define AZ_BENCHMARK_CLOCK_NSEC() ((int64_t)((double)clock() * (1e9 / (double)CLOCKS_PER_SEC)))
+#endif
+#endif // AZ_BENCHMARK_CLOCK_NSEC
+
+#ifndef AZ_BENCHMARK_PRINTF
+#define AZ_BENCHMARK_PRINTF printf
+#endif
+
+#define LOAD_HUB_HOSTNAME "contoso-hub.azure-devices.net"
+#define LOAD_DEVICE_ID_PREFIX "load-device-"
+#define LOAD_SHARED_ACCESS_KEY "dGhpcyBpcyBhIGZha2Ugc2hhcmVkIGFjY2VzcyBrZXkgb2YgMzIgYg=="
+
+enum
+{
+  LOAD_DEVICE_ID_SIZE = sizeof(LOAD_DEVICE_ID_PREFIX) + 10,
+  LOAD_PASSWORD_SIZE = 256,
+  LOAD_MQTT_FIELD_SIZE = 256,
+  LOAD_TOPIC_SIZE = 256,
+  LOAD_PAYLOAD_SIZE = 128,
+  LOAD_REQUEST_ID_SIZE = 12,
+  LOAD_METHOD_INTERVAL = 10,
+  LOAD_TWIN_PATCH_INTERVAL = 25,
+  LOAD_EPOCH = 1600000000,
+};
+
+// The operations whose latency is reported.
+typedef enum
+{
+  LOAD_OPERATION_CONNECT,
+  LOAD_OPERATION_TELEMETRY,
+  LOAD_OPERATION_METHOD,
+  LOAD_OPERATION_TWIN_PATCH,
+  LOAD_OPERATION_TWIN_RESPONSE,
+  LOAD_OPERATION_COUNT,
+} load_operation;
+
+static char const* const load_operation_names[LOAD_OPERATION_COUNT] = {
+  "connect", "telemetry", "method_response", "twin_reported_patch", "twin_response",
+};
+
+// The state of a simulated device, which is all the memory a device needs besides the buffers the
+// devices share.
+typedef struct
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_sas_token_cache sas_token_cache;
+  uint8_t password_buffer[2 * LOAD_PASSWORD_SIZE];
+  uint8_t device_id[LOAD_DEVICE_ID_SIZE];
+  int32_t index;
+  int32_t next_request_id;
+  int32_t sequence;
+} load_device;
+
+// The latencies of one operation, in nanoseconds.
+typedef struct
+{
+  int64_t* values;
+  int64_t count;
+  int64_t capacity;
+} load_samples;
+
+#ifdef _az_BENCHMARK_COUNT_ALLOCATIONS
+// The generator is linked with `--wrap` for the allocator, so that the calls made by the SDK go
+// through these.
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+
+static int64_t heap_allocation_bytes = 0;
+
+void* __wrap_malloc(size_t size)
+{
+  heap_allocation_bytes += (int64_t)size;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+  heap_allocation_bytes += (int64_t)(count * size);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+  heap_allocation_bytes += (int64_t)size;
+  return __real_realloc(ptr, size);
+}
+#endif // _az_BENCHMARK_COUNT_ALLOCATIONS
+
+#if defined(_WIN32) || defined(CLOCK_MONOTONIC)
+// The latencies are far shorter than the resolution of `clock()`, so they are measured with the
+// monotonic clock of the operating system.
+static int64_t load_clock_nsec(void)
+{
+  struct timespec now = { 0 };
+#if defined(_WIN32)
+  (void)timespec_get(&now, TIME_UTC);
+#else
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+  return (int64_t)now.tv_sec * 1000000000 + (int64_t)now.tv_nsec;
+}
+#endif
+
+static az_iot_hub_client_shared load_shared;
+static az_iot_load_mqtt_backend const* load_backend;
+static load_samples load_latencies[LOAD_OPERATION_COUNT];
+
+// The first failure, of the devices or of the backend.
+static az_result load_result = AZ_OK;
+static int64_t load_message_count = 0;
+
+// The devices take turns, so they share the buffers their messages are built in.
+static char topic_buffer[LOAD_TOPIC_SIZE];
+static uint8_t payload_buffer[LOAD_PAYLOAD_SIZE];
+static uint8_t properties_buffer[] = "$.ct=application%2Fjson&$.ce=utf-8";
+
+static bool load_check(az_result result, char const* operation)
+{
+  if (az_result_failed(result))
+  {
+    if (az_result_succeeded(load_result))
+    {
+      fprintf(stderr, "%s failed with 0x%08x\n", operation, (unsigned)result);
+      load_result = result;
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+static void load_record(load_operation operation, int64_t start_nsec)
+{
+  int64_t const nsec = AZ_BENCHMARK_CLOCK_NSEC() - start_nsec;
+  load_samples* const samples = &load_latencies[operation];
+  if (samples->count < samples->capacity)
+  {
+    samples->values[samples->count++] = nsec;
+  }
+}
+
+static az_result load_publish(load_device const* device, size_t topic_length, az_span payload)
+{
+  load_message_count++;
+  return load_backend->publish(
+      load_backend->context,
+      device->index,
+      az_span_create((uint8_t*)topic_buffer, (int32_t)topic_length),
+      payload);
+}
+
+// Writes `{"<name>":<value>}` to the payload buffer.
+static az_result load_build_payload(az_span name, double value, az_span* out_payload)
+{
+  az_json_writer writer;
+  az_result result = az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(payload_buffer), NULL);
+  if (az_result_succeeded(result))
+  {
+    result = az_json_writer_append_begin_object(&writer);
+  }
+
+  if (az_result_succeeded(result))
+  {
+    result = az_json_writer_append_property_name(&writer, name);
+  }
+
+  if (az_result_succeeded(result))
+  {
+    result = az_json_writer_append_double(&writer, value, 2);
+  }
+
+  if (az_result_succeeded(result))
+  {
+    result = az_json_writer_append_end_object(&writer);
+  }
+
+  *out_payload = az_json_writer_get_bytes_used_in_destination(&writer);
+  return result;
+}
+
+static void load_answer_method(load_device* device, az_iot_hub_client_method_request const* request)
+{
+  int64_t const start = AZ_BENCHMARK_CLOCK_NSEC();
+  az_span payload = AZ_SPAN_EMPTY;
+  size_t topic_length = 0;
+  if (load_check(
+          az_iot_hub_client_methods_response_get_publish_topic(
+              &device->client,
+              request->request_id,
+              AZ_IOT_STATUS_OK,
+              topic_buffer,
+              sizeof(topic_buffer),
+              &topic_length),
+          "az_iot_hub_client_methods_response_get_publish_topic")
+      && load_check(
+          load_build_payload(AZ_SPAN_FROM_STR("delaySeconds"), 5, &payload), "az_json_writer")
+      && load_check(load_publish(device, topic_length, payload), "publish"))
+  {
+    load_record(LOAD_OPERATION_METHOD, start);
+  }
+}
+
+static void load_answer_desired_patch(load_device* device)
+{
+  int64_t const start = AZ_BENCHMARK_CLOCK_NSEC();
+  uint8_t request_id_buffer[LOAD_REQUEST_ID_SIZE];
+  az_span request_id = AZ_SPAN_FROM_BUFFER(request_id_buffer);
+  az_span remainder = request_id;
+  az_span payload = AZ_SPAN_EMPTY;
+  size_t topic_length = 0;
+  if (load_check(
+          az_span_i32toa(request_id, device->next_request_id++, &remainder), "az_span_i32toa")
+      && load_check(
+          az_iot_hub_client_twin_patch_get_publish_topic(
+              &device->client,
+              az_span_slice(request_id, 0, az_span_size(request_id) - az_span_size(remainder)),
+              topic_buffer,
+              sizeof(topic_buffer),
+              &topic_length),
+          "az_iot_hub_client_twin_patch_get_publish_topic")
+      && load_check(
+          load_build_payload(AZ_SPAN_FROM_STR("targetTemperature"), 23.5, &payload),
+          "az_json_writer")
+      && load_check(load_publish(device, topic_length, payload), "publish"))
+  {
+    load_record(LOAD_OPERATION_TWIN_PATCH, start);
+  }
+}
+
+static void load_on_receive(void* device_context, az_span topic, az_span payload)
+{
+  (void)payload;
+  load_device* const device = (load_device*)device_context;
+  load_message_count++;
+
+  int64_t const start = AZ_BENCHMARK_CLOCK_NSEC();
+  az_iot_hub_client_received_topic received;
+  if (!load_check(
+          az_iot_hub_client_parse_received_topic(&device->client, topic, &received),
+          "az_iot_hub_client_parse_received_topic"))
+  {
+    return;
+  }
+
+  switch (received.type)
+  {
+    case AZ_IOT_HUB_CLIENT_TOPIC_TYPE_METHOD_REQUEST:
+      load_answer_method(device, &received.data.method_request);
+      break;
+    case AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_DESIRED_PATCH:
+      load_answer_desired_patch(device);
+      break;
+    case AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_RESPONSE:
+      load_record(LOAD_OPERATION_TWIN_RESPONSE, start);
+      break;
+    default:
+      break;
+  }
+}
+
+static bool load_poll(void)
+{
+  return load_check(load_backend->poll(load_backend->context), "poll")
+      && az_result_succeeded(load_result);
+}
+
+static bool load_connect(load_device* device, int32_t index)
+{
+  int64_t const start = AZ_BENCHMARK_CLOCK_NSEC();
+  device->index = index;
+  device->next_request_id = 1;
+  device->sequence = 0;
+
+  int const id_length = snprintf(
+      (char*)device->device_id, sizeof(device->device_id), LOAD_DEVICE_ID_PREFIX "%06d", index);
+  az_iot_hub_client_init_shared(
+      &device->client, &load_shared, az_span_create(device->device_id, (int32_t)id_length));
+
+  char client_id[LOAD_MQTT_FIELD_SIZE];
+  char user_name[LOAD_MQTT_FIELD_SIZE];
+  size_t client_id_length = 0;
+  size_t user_name_length = 0;
+  az_span password = AZ_SPAN_EMPTY;
+  if (!load_check(
+          az_iot_hub_client_sas_token_cache_init(
+              &device->sas_token_cache,
+              &device->client,
+              AZ_SPAN_FROM_STR(LOAD_SHARED_ACCESS_KEY),
+              AZ_SPAN_EMPTY,
+              AZ_SPAN_FROM_BUFFER(device->password_buffer),
+              NULL),
+          "az_iot_hub_client_sas_token_cache_init")
+      || !load_check(
+          az_iot_hub_client_sas_token_cache_get_password(
+              &device->sas_token_cache, LOAD_EPOCH, &password),
+          "az_iot_hub_client_sas_token_cache_get_password")
+      || !load_check(
+          az_iot_hub_client_get_client_id(
+              &device->client, client_id, sizeof(client_id), &client_id_length),
+          "az_iot_hub_client_get_client_id")
+      || !load_check(
+          az_iot_hub_client_get_user_name(
+              &device->client, user_name, sizeof(user_name), &user_name_length),
+          "az_iot_hub_client_get_user_name"))
+  {
+    return false;
+  }
+
+  if (!load_check(
+          load_backend->connect(
+              load_backend->context,
+              index,
+              az_span_create((uint8_t*)client_id, (int32_t)client_id_length),
+              az_span_create((uint8_t*)user_name, (int32_t)user_name_length),
+              password,
+              load_on_receive,
+              device),
+          "connect")
+      || !load_check(
+          load_backend->subscribe(
+              load_backend->context,
+              index,
+              AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_METHODS_SUBSCRIBE_TOPIC)),
+          "subscribe")
+      || !load_check(
+          load_backend->subscribe(
+              load_backend->context,
+              index,
+              AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_TWIN_RESPONSE_SUBSCRIBE_TOPIC)),
+          "subscribe")
+      || !load_check(
+          load_backend->subscribe(
+              load_backend->context,
+              index,
+              AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_TWIN_PATCH_SUBSCRIBE_TOPIC)),
+          "subscribe"))
+  {
+    return false;
+  }
+
+  load_record(LOAD_OPERATION_CONNECT, start);
+
+  // The twin is requested once connected, as the devices do when they start.
+  size_t topic_length = 0;
+  return load_check(
+             az_iot_hub_client_twin_document_get_publish_topic(
+                 &device->client,
+                 AZ_SPAN_FROM_STR("0"),
+                 topic_buffer,
+                 sizeof(topic_buffer),
+                 &topic_length),
+             "az_iot_hub_client_twin_document_get_publish_topic")
+      && load_check(load_publish(device, topic_length, AZ_SPAN_EMPTY), "publish") && load_poll();
+}
+
+static bool load_send_telemetry(load_device* device, az_iot_message_properties const* properties)
+{
+  int64_t const start = AZ_BENCHMARK_CLOCK_NSEC();
+  size_t topic_length = 0;
+  az_span payload = AZ_SPAN_EMPTY;
+  double const temperature = 21.0 + (double)(device->sequence++ % 50) / 10.0;
+  if (!load_check(
+          az_iot_hub_client_telemetry_get_publish_topic(
+              &device->client, properties, topic_buffer, sizeof(topic_buffer), &topic_length),
+          "az_iot_hub_client_telemetry_get_publish_topic")
+      || !load_check(
+          load_build_payload(AZ_SPAN_FROM_STR("temperature"), temperature, &payload),
+          "az_json_writer")
+      || !load_check(load_publish(device, topic_length, payload), "publish"))
+  {
+    return false;
+  }
+
+  load_record(LOAD_OPERATION_TELEMETRY, start);
+  return load_poll();
+}
+
+static int load_compare_samples(void const* left, void const* right)
+{
+  int64_t const left_value = *(int64_t const*)left;
+  int64_t const right_value = *(int64_t const*)right;
+  return (left_value > right_value) - (left_value < right_value);
+}
+
+// The sample below which `per_mille` thousandths of the samples are, which must be sorted.
+static int64_t load_percentile(load_samples const* samples, int64_t per_mille)
+{
+  return samples->count == 0 ? 0 : samples->values[(samples->count - 1) * per_mille / 1000];
+}
+
+static void load_print_latencies(void)
+{
+  AZ_BENCHMARK_PRINTF("  \"latency_nsec\":[");
+  for (int32_t i = 0; i < LOAD_OPERATION_COUNT; i++)
+  {
+    load_samples* const samples = &load_latencies[i];
+    qsort(samples->values, (size_t)samples->count, sizeof(int64_t), load_compare_samples);
+    AZ_BENCHMARK_PRINTF(
+        "%s\n    {\"operation\":\"%s\",\"count\":%lld,\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,"
+        "\"p999\":%lld,\"max\":%lld}",
+        i == 0 ? "" : ",",
+        load_operation_names[i],
+        (long long)samples->count,
+        (long long)load_percentile(samples, 500),
+        (long long)load_percentile(samples, 900),
+        (long long)load_percentile(samples, 990),
+        (long long)load_percentile(samples, 999),
+        (long long)load_percentile(samples, 1000));
+  }
+
+  AZ_BENCHMARK_PRINTF("\n  ]\n");
+}
+
+static bool load_allocate_samples(int32_t device_count, int32_t messages_per_device)
+{
+  // Each device connects and gets its twin once, and sends or answers at most one message for
+  // each telemetry message.
+  int64_t const capacity = (int64_t)device_count * ((int64_t)messages_per_device + 1);
+  for (int32_t i = 0; i < LOAD_OPERATION_COUNT; i++)
+  {
+    load_latencies[i].values = (int64_t*)malloc((size_t)capacity * sizeof(int64_t));
+    load_latencies[i].count = 0;
+    load_latencies[i].capacity = capacity;
+    if (load_latencies[i].values == NULL)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void load_free_samples(void)
+{
+  for (int32_t i = 0; i < LOAD_OPERATION_COUNT; i++)
+  {
+    free(load_latencies[i].values);
+    load_latencies[i].values = NULL;
+  }
+}
+
+int az_iot_load_generator_run(
+    az_iot_load_mqtt_backend const* backend,
+    int32_t device_count,
+    int32_t messages_per_device)
+{
+  load_backend = backend;
+  load_result = AZ_OK;
+  load_message_count = 0;
+
+  load_device* const devices = (load_device*)calloc((size_t)device_count, sizeof(load_device));
+  az_iot_message_properties properties;
+  if (devices == NULL || !load_allocate_samples(device_count, messages_per_device))
+  {
+    fprintf(stderr, "Allocating the state of %d devices failed\n", device_count);
+    free(devices);
+    load_free_samples();
+    return 1;
+  }
+
+  az_iot_hub_client_shared_init(&load_shared, AZ_SPAN_FROM_STR(LOAD_HUB_HOSTNAME), NULL);
+  az_span const properties_span
+      = az_span_create(properties_buffer, (int32_t)sizeof(properties_buffer) - 1);
+  bool succeeded = load_check(
+      az_iot_message_properties_init(
+          &properties, properties_span, az_span_size(properties_span)),
+      "az_iot_message_properties_init");
+
+#ifdef _az_BENCHMARK_COUNT_ALLOCATIONS
+  int64_t const allocation_bytes = heap_allocation_bytes;
+#endif
+
+  for (int32_t i = 0; succeeded && i < device_count; i++)
+  {
+    succeeded = load_connect(&devices[i], i);
+  }
+
+  clock_t const cpu_start = clock();
+  int64_t const connect_message_count = load_message_count;
+  for (int32_t m = 0; succeeded && m < messages_per_device; m++)
+  {
+    for (int32_t i = 0; succeeded && i < device_count; i++)
+    {
+      succeeded = load_send_telemetry(&devices[i], &properties);
+    }
+  }
+
+  double const cpu_nsec = (double)(clock() - cpu_start) * (1e9 / (double)CLOCKS_PER_SEC);
+  int64_t const message_count = load_message_count - connect_message_count;
+
+  for (int32_t i = 0; i < device_count; i++)
+  {
+    backend->disconnect(backend->context, i);
+  }
+
+  if (succeeded)
+  {
+    // Hundredths of a nanosecond, printed as a fixed point number.
+    int64_t const centi_nsec
+        = message_count == 0 ? 0 : (int64_t)(cpu_nsec * 100.0 / (double)message_count);
+
+    AZ_BENCHMARK_PRINTF(
+        "{\n  \"sdk_version\":\"%s\",\n  \"devices\":%d,\n  \"messages_per_device\":%d,\n"
+        "  \"messages\":%lld,\n  \"cpu_nsec_per_message\":%lld.%02lld,\n"
+        "  \"client_bytes\":%u,\n  \"device_state_bytes\":%u,\n  \"heap_bytes_per_device\":",
+        AZ_SDK_VERSION_STRING,
+        device_count,
+        messages_per_device,
+        (long long)message_count,
+        (long long)(centi_nsec / 100),
+        (long long)(centi_nsec % 100),
+        (unsigned)sizeof(az_iot_hub_client),
+        (unsigned)sizeof(load_device));
+
+#ifdef _az_BENCHMARK_COUNT_ALLOCATIONS
+    int64_t const heap_bytes = heap_allocation_bytes - allocation_bytes;
+    AZ_BENCHMARK_PRINTF(
+        "%lld,\n", (long long)(device_count == 0 ? 0 : heap_bytes / device_count));
+#else
+    AZ_BENCHMARK_PRINTF("null,\n");
+#endif
+
+    load_print_latencies();
+    AZ_BENCHMARK_PRINTF("}\n");
+  }
+
+  free(devices);
+  load_free_samples();
+  return succeeded ? 0 : 1;
+}
+
+#ifndef AZ_BENCHMARK_NO_MAIN
+int main(int argc, char** argv)
+{
+  int32_t device_count = 100;
+  int32_t messages_per_device = 100;
+  if (argc > 1)
+  {
+    device_count = (int32_t)atoi(argv[1]);
+  }
+
+  if (argc > 2)
+  {
+    messages_per_device = (int32_t)atoi(argv[2]);
+  }
+
+  if (device_count < 0 || messages_per_device < 0)
+  {
+    fprintf(stderr, "Usage: %s [device_count] [messages_per_device]\n", argv[0]);
+    return 1;
+  }
+
+  az_iot_load_memory_broker_device* const broker_devices
+      = (az_iot_load_memory_broker_device*)calloc(
+          (size_t)device_count + 1, sizeof(az_iot_load_memory_broker_device));
+  if (broker_devices == NULL)
+  {
+    fprintf(stderr, "Allocating the broker failed\n");
+    return 1;
+  }
+
+  static az_iot_load_memory_broker broker;
+  az_iot_load_memory_broker_init(
+      &broker, broker_devices, device_count, LOAD_METHOD_INTERVAL, LOAD_TWIN_PATCH_INTERVAL);
+  az_iot_load_mqtt_backend const backend = az_iot_load_memory_broker_get_backend(&broker);
+
+  int const result = az_iot_load_generator_run(&backend, device_count, messages_per_device);
+  free(broker_devices);
+  return result;
+}
+#endif // AZ_BENCHMARK_NO_MAIN
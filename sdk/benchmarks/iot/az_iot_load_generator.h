@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_load_generator.h
+ *
+ * @brief Simulates a fleet of devices, each with its own #az_iot_hub_client, to size gateways and
+ * to catch the scaling regressions of the IoT Hub client.
+ *
+ * @details Each device connects with a SAS token signed by an
+ * #az_iot_hub_client_sas_token_cache, subscribes to methods and twin updates, and requests its
+ * twin. The devices then send their telemetry in turns, and answer the method requests and the
+ * desired properties patches they receive, through an #az_iot_load_mqtt_backend. The in-memory
+ * broker of az_iot_load_mqtt.h answers them as IoT Hub would, so that only the SDK side is
+ * measured.
+ *
+ * The results are printed as JSON:
+ *   - "cpu_nsec_per_message": the processor time spent for each message a device sent or
+ *     received, once connected, including the in-memory broker, which only copies the messages.
+ *   - "client_bytes" and "device_state_bytes": the size of an #az_iot_hub_client, and of all of
+ *     the state the generator keeps for a device, its client, its SAS token cache and the buffer
+ *     of its passwords.
+ *   - "heap_bytes_per_device": the bytes asked of the C allocator while the devices connect and
+ *     run, divided by the number of devices. They are only counted when the linker can wrap
+ *     `malloc()`, and are `null` otherwise.
+ *   - "latency_nsec": the percentiles of the time the SDK side of each operation takes, from
+ *     building the topic and the payload of a message to handing it to the backend, or from
+ *     receiving a message to handing its response to the backend.
+ */
+
+#ifndef _az_IOT_LOAD_GENERATOR_H
+#define _az_IOT_LOAD_GENERATOR_H
+
+#include "az_iot_load_mqtt.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Connects \p device_count devices through \p backend, has each of them send
+ * \p messages_per_device telemetry messages, and prints the results.
+ *
+ * @param[in] backend The #az_iot_load_mqtt_backend the devices connect through.
+ * @param[in] device_count The number of devices to simulate.
+ * @param[in] messages_per_device The number of telemetry messages each device sends.
+ *
+ * @return `0` if all of the calls succeeded, `1` otherwise.
+ */
+int az_iot_load_generator_run(
+    az_iot_load_mqtt_backend const* backend,
+    int32_t device_count,
+    int32_t messages_per_device);
+
+#endif // _az_IOT_LOAD_GENERATOR_H
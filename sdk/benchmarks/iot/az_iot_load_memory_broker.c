@@ -0,0 +1,368 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_load_memory_broker.c
+ *
+ * @brief See az_iot_load_mqtt.h. The broker stands in for IoT Hub, so it reads the topics the
+ * devices publish to with plain span searches rather than with the SDK, whose cost is what the
+ * load generator measures.
+ */
+
+#include "az_iot_load_mqtt.h"
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum
+{
+  BROKER_SUBSCRIPTION_C2D = 1 << 0,
+  BROKER_SUBSCRIPTION_METHODS = 1 << 1,
+  BROKER_SUBSCRIPTION_TWIN_RESPONSE = 1 << 2,
+  BROKER_SUBSCRIPTION_TWIN_PATCH = 1 << 3,
+};
+
+static uint8_t twin_document[]
+    = "{\"desired\":{\"targetTemperature\":21.5,\"$version\":1},"
+      "\"reported\":{\"maxTempSinceLastReboot\":22.3,\"$version\":1}}";
+
+static uint8_t method_payload[] = "{\"delay\":5}";
+
+static uint8_t desired_patch_payload[] = "{\"targetTemperature\":23.5,\"$version\":";
+
+#define BROKER_SPAN(buffer) az_span_create((buffer), (int32_t)sizeof(buffer) - 1)
+
+// Appends to a message, and remembers if it ran out of space.
+typedef struct
+{
+  az_span remainder;
+  bool overflowed;
+} broker_writer;
+
+static void broker_write(broker_writer* writer, az_span source)
+{
+  if (az_span_size(source) > az_span_size(writer->remainder))
+  {
+    writer->overflowed = true;
+    return;
+  }
+
+  writer->remainder = az_span_copy(writer->remainder, source);
+}
+
+static void broker_write_u64(broker_writer* writer, uint64_t value)
+{
+  az_span remainder = writer->remainder;
+  if (az_result_failed(az_span_u64toa(remainder, value, &remainder)))
+  {
+    writer->overflowed = true;
+    return;
+  }
+
+  writer->remainder = remainder;
+}
+
+// Queues a message for the device, from its topic and payload written one after the other.
+static az_result broker_enqueue(
+    az_iot_load_memory_broker* broker,
+    int32_t device_index,
+    az_iot_load_memory_broker_message* message,
+    int32_t topic_size,
+    broker_writer const* writer)
+{
+  if (writer->overflowed)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  message->device_index = device_index;
+  message->topic_size = topic_size;
+  message->payload_size = (int32_t)sizeof(message->buffer) - az_span_size(writer->remainder)
+      - topic_size;
+  broker->queue_count++;
+  return AZ_OK;
+}
+
+// The next free message of the queue, or NULL if it is full.
+static az_iot_load_memory_broker_message* broker_reserve(az_iot_load_memory_broker* broker)
+{
+  if (broker->queue_count == AZ_IOT_LOAD_MEMORY_BROKER_QUEUE_SIZE)
+  {
+    return NULL;
+  }
+
+  return &broker->queue[(broker->queue_head + broker->queue_count)
+                        % AZ_IOT_LOAD_MEMORY_BROKER_QUEUE_SIZE];
+}
+
+static az_result broker_send_method_request(az_iot_load_memory_broker* broker, int32_t device_index)
+{
+  az_iot_load_memory_broker_message* const message = broker_reserve(broker);
+  if (message == NULL)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  az_iot_load_memory_broker_device* const device = &broker->devices[device_index];
+  broker_writer writer = { .remainder = AZ_SPAN_FROM_BUFFER(message->buffer), .overflowed = false };
+  broker_write(&writer, AZ_SPAN_FROM_STR("$iothub/methods/POST/reboot/?$rid="));
+  broker_write_u64(&writer, (uint64_t)device->next_request_id++);
+  int32_t const topic_size = (int32_t)sizeof(message->buffer) - az_span_size(writer.remainder);
+  broker_write(&writer, BROKER_SPAN(method_payload));
+  return broker_enqueue(broker, device_index, message, topic_size, &writer);
+}
+
+static az_result broker_send_desired_patch(az_iot_load_memory_broker* broker, int32_t device_index)
+{
+  az_iot_load_memory_broker_message* const message = broker_reserve(broker);
+  if (message == NULL)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  az_iot_load_memory_broker_device* const device = &broker->devices[device_index];
+  uint64_t const version = (uint64_t)(device->telemetry_count / broker->twin_patch_interval) + 1;
+  broker_writer writer = { .remainder = AZ_SPAN_FROM_BUFFER(message->buffer), .overflowed = false };
+  broker_write(&writer, AZ_SPAN_FROM_STR("$iothub/twin/PATCH/properties/desired/?$version="));
+  broker_write_u64(&writer, version);
+  int32_t const topic_size = (int32_t)sizeof(message->buffer) - az_span_size(writer.remainder);
+  broker_write(&writer, BROKER_SPAN(desired_patch_payload));
+  broker_write_u64(&writer, version);
+  broker_write(&writer, AZ_SPAN_FROM_STR("}"));
+  return broker_enqueue(broker, device_index, message, topic_size, &writer);
+}
+
+// Answers a twin request with the request ID of its topic, which follows `$rid=`.
+static az_result broker_send_twin_response(
+    az_iot_load_memory_broker* broker,
+    int32_t device_index,
+    az_span request_topic,
+    az_span status,
+    bool with_document)
+{
+  az_span const rid_name = AZ_SPAN_FROM_STR("$rid=");
+  int32_t const rid_index = az_span_find(request_topic, rid_name);
+  if (rid_index < 0)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  az_span request_id = az_span_slice_to_end(request_topic, rid_index + az_span_size(rid_name));
+  int32_t const rid_end = az_span_find(request_id, AZ_SPAN_FROM_STR("&"));
+  if (rid_end >= 0)
+  {
+    request_id = az_span_slice(request_id, 0, rid_end);
+  }
+
+  az_iot_load_memory_broker_message* const message = broker_reserve(broker);
+  if (message == NULL)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  broker->twin_request_count++;
+  broker_writer writer = { .remainder = AZ_SPAN_FROM_BUFFER(message->buffer), .overflowed = false };
+  broker_write(&writer, AZ_SPAN_FROM_STR("$iothub/twin/res/"));
+  broker_write(&writer, status);
+  broker_write(&writer, AZ_SPAN_FROM_STR("/?$rid="));
+  broker_write(&writer, request_id);
+  if (!with_document)
+  {
+    broker_write(&writer, AZ_SPAN_FROM_STR("&$version="));
+    broker_write_u64(&writer, (uint64_t)broker->twin_request_count);
+  }
+
+  int32_t const topic_size = (int32_t)sizeof(message->buffer) - az_span_size(writer.remainder);
+  if (with_document)
+  {
+    broker_write(&writer, BROKER_SPAN(twin_document));
+  }
+
+  return broker_enqueue(broker, device_index, message, topic_size, &writer);
+}
+
+static az_result broker_receive_telemetry(az_iot_load_memory_broker* broker, int32_t device_index)
+{
+  az_iot_load_memory_broker_device* const device = &broker->devices[device_index];
+  device->telemetry_count++;
+  broker->telemetry_count++;
+
+  if (broker->method_interval > 0 && device->telemetry_count % broker->method_interval == 0
+      && (device->subscriptions & BROKER_SUBSCRIPTION_METHODS) != 0)
+  {
+    az_result const result = broker_send_method_request(broker, device_index);
+    if (az_result_failed(result))
+    {
+      return result;
+    }
+  }
+
+  if (broker->twin_patch_interval > 0 && device->telemetry_count % broker->twin_patch_interval == 0
+      && (device->subscriptions & BROKER_SUBSCRIPTION_TWIN_PATCH) != 0)
+  {
+    return broker_send_desired_patch(broker, device_index);
+  }
+
+  return AZ_OK;
+}
+
+static az_result broker_connect(
+    void* context,
+    int32_t device_index,
+    az_span client_id,
+    az_span user_name,
+    az_span password,
+    az_iot_load_mqtt_receive_fn on_receive,
+    void* device_context)
+{
+  az_iot_load_memory_broker* const broker = (az_iot_load_memory_broker*)context;
+  if (device_index < 0 || device_index >= broker->device_count || az_span_size(client_id) == 0
+      || az_span_size(user_name) == 0 || az_span_size(password) == 0)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  broker->devices[device_index] = (az_iot_load_memory_broker_device){
+    .on_receive = on_receive,
+    .device_context = device_context,
+    .subscriptions = 0,
+    .telemetry_count = 0,
+    .next_request_id = 1,
+  };
+  return AZ_OK;
+}
+
+static az_result broker_subscribe(void* context, int32_t device_index, az_span topic_filter)
+{
+  az_iot_load_memory_broker* const broker = (az_iot_load_memory_broker*)context;
+  uint32_t subscription = 0;
+  if (az_span_is_content_equal(
+          topic_filter, AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_C2D_SUBSCRIBE_TOPIC)))
+  {
+    subscription = BROKER_SUBSCRIPTION_C2D;
+  }
+  else if (az_span_is_content_equal(
+               topic_filter, AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_METHODS_SUBSCRIBE_TOPIC)))
+  {
+    subscription = BROKER_SUBSCRIPTION_METHODS;
+  }
+  else if (az_span_is_content_equal(
+               topic_filter, AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_TWIN_RESPONSE_SUBSCRIBE_TOPIC)))
+  {
+    subscription = BROKER_SUBSCRIPTION_TWIN_RESPONSE;
+  }
+  else if (az_span_is_content_equal(
+               topic_filter, AZ_SPAN_FROM_STR(AZ_IOT_HUB_CLIENT_TWIN_PATCH_SUBSCRIBE_TOPIC)))
+  {
+    subscription = BROKER_SUBSCRIPTION_TWIN_PATCH;
+  }
+  else
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  broker->devices[device_index].subscriptions |= subscription;
+  return AZ_OK;
+}
+
+static az_result broker_publish(void* context, int32_t device_index, az_span topic, az_span payload)
+{
+  (void)payload;
+  az_iot_load_memory_broker* const broker = (az_iot_load_memory_broker*)context;
+  bool const twin_subscribed
+      = (broker->devices[device_index].subscriptions & BROKER_SUBSCRIPTION_TWIN_RESPONSE) != 0;
+
+  if (az_span_find(topic, AZ_SPAN_FROM_STR("/messages/events/")) >= 0)
+  {
+    return broker_receive_telemetry(broker, device_index);
+  }
+
+  if (az_span_find(topic, AZ_SPAN_FROM_STR("$iothub/methods/res/")) == 0)
+  {
+    broker->method_response_count++;
+    return AZ_OK;
+  }
+
+  if (az_span_find(topic, AZ_SPAN_FROM_STR("$iothub/twin/GET/")) == 0)
+  {
+    return twin_subscribed
+        ? broker_send_twin_response(broker, device_index, topic, AZ_SPAN_FROM_STR("200"), true)
+        : AZ_OK;
+  }
+
+  if (az_span_find(topic, AZ_SPAN_FROM_STR("$iothub/twin/PATCH/properties/reported/")) == 0)
+  {
+    return twin_subscribed
+        ? broker_send_twin_response(broker, device_index, topic, AZ_SPAN_FROM_STR("204"), false)
+        : AZ_OK;
+  }
+
+  return AZ_ERROR_ARG;
+}
+
+static az_result broker_poll(void* context)
+{
+  az_iot_load_memory_broker* const broker = (az_iot_load_memory_broker*)context;
+
+  // The devices answer some of the messages while they are delivered, which queues more of them.
+  while (broker->queue_count > 0)
+  {
+    az_iot_load_memory_broker_message message = broker->queue[broker->queue_head];
+    broker->queue_head = (broker->queue_head + 1) % AZ_IOT_LOAD_MEMORY_BROKER_QUEUE_SIZE;
+    broker->queue_count--;
+
+    az_iot_load_memory_broker_device const* const device = &broker->devices[message.device_index];
+    az_span const buffer
+        = az_span_create(message.buffer, message.topic_size + message.payload_size);
+    device->on_receive(
+        device->device_context,
+        az_span_slice(buffer, 0, message.topic_size),
+        az_span_slice_to_end(buffer, message.topic_size));
+  }
+
+  return AZ_OK;
+}
+
+static void broker_disconnect(void* context, int32_t device_index)
+{
+  az_iot_load_memory_broker* const broker = (az_iot_load_memory_broker*)context;
+  broker->devices[device_index].on_receive = NULL;
+  broker->devices[device_index].subscriptions = 0;
+}
+
+void az_iot_load_memory_broker_init(
+    az_iot_load_memory_broker* broker,
+    az_iot_load_memory_broker_device devices[],
+    int32_t device_count,
+    int32_t method_interval,
+    int32_t twin_patch_interval)
+{
+  *broker = (az_iot_load_memory_broker){
+    .devices = devices,
+    .device_count = device_count,
+    .method_interval = method_interval,
+    .twin_patch_interval = twin_patch_interval,
+    .queue_head = 0,
+    .queue_count = 0,
+    .telemetry_count = 0,
+    .method_response_count = 0,
+    .twin_request_count = 0,
+  };
+}
+
+az_iot_load_mqtt_backend az_iot_load_memory_broker_get_backend(az_iot_load_memory_broker* broker)
+{
+  return (az_iot_load_mqtt_backend){
+    .context = broker,
+    .connect = broker_connect,
+    .subscribe = broker_subscribe,
+    .publish = broker_publish,
+    .poll = broker_poll,
+    .disconnect = broker_disconnect,
+  };
+}
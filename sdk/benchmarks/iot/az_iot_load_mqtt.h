@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_load_mqtt.h
+ *
+ * @brief The MQTT backend the load generator sends the messages of its simulated devices through,
+ * and the in-memory broker which implements it without any I/O.
+ *
+ * @details A backend keeps one connection per simulated device, identified by its index. It
+ * delivers the messages a device receives from #az_iot_load_mqtt_backend.poll, by calling the
+ * receive callback the device connected with. A backend over a real MQTT client, such as Paho or an
+ * MQTT broker of a test environment, fills an #az_iot_load_mqtt_backend with its own functions.
+ */
+
+#ifndef _az_IOT_LOAD_MQTT_H
+#define _az_IOT_LOAD_MQTT_H
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+
+#include <stdint.h>
+
+/**
+ * @brief Called by the backend for each message a device receives.
+ *
+ * @param[in] device_context The context the device connected with.
+ * @param[in] topic The topic of the message.
+ * @param[in] payload The payload of the message. It can be empty.
+ */
+typedef void (*az_iot_load_mqtt_receive_fn)(void* device_context, az_span topic, az_span payload);
+
+/**
+ * @brief The functions of an MQTT backend, each called with #az_iot_load_mqtt_backend.context.
+ */
+typedef struct
+{
+  /// The state of the backend.
+  void* context;
+
+  /// Connects the device \p device_index with its MQTT client ID, user name and password.
+  /// \p on_receive is called with \p device_context for the messages it receives.
+  az_result (*connect)(
+      void* context,
+      int32_t device_index,
+      az_span client_id,
+      az_span user_name,
+      az_span password,
+      az_iot_load_mqtt_receive_fn on_receive,
+      void* device_context);
+
+  /// Subscribes the device \p device_index to \p topic_filter.
+  az_result (*subscribe)(void* context, int32_t device_index, az_span topic_filter);
+
+  /// Publishes a message of the device \p device_index.
+  az_result (*publish)(void* context, int32_t device_index, az_span topic, az_span payload);
+
+  /// Delivers the messages the devices received since the last call.
+  az_result (*poll)(void* context);
+
+  /// Disconnects the device \p device_index.
+  void (*disconnect)(void* context, int32_t device_index);
+} az_iot_load_mqtt_backend;
+
+/**
+ * @brief The number of messages the in-memory broker holds until #az_iot_load_mqtt_backend.poll
+ * delivers them.
+ */
+#define AZ_IOT_LOAD_MEMORY_BROKER_QUEUE_SIZE 64
+
+/**
+ * @brief The size, in bytes, of the topic and payload of a message held by the in-memory broker.
+ */
+#define AZ_IOT_LOAD_MEMORY_BROKER_MESSAGE_SIZE 256
+
+/**
+ * @brief A device connected to the in-memory broker.
+ */
+typedef struct
+{
+  az_iot_load_mqtt_receive_fn on_receive;
+  void* device_context;
+  uint32_t subscriptions; // A bit for each of the topic filters of IoT Hub it subscribed to.
+  int64_t telemetry_count;
+  int64_t next_request_id;
+} az_iot_load_memory_broker_device;
+
+/**
+ * @brief A message queued by the in-memory broker for a device.
+ */
+typedef struct
+{
+  int32_t device_index;
+  int32_t topic_size;
+  int32_t payload_size;
+  uint8_t buffer[AZ_IOT_LOAD_MEMORY_BROKER_MESSAGE_SIZE];
+} az_iot_load_memory_broker_message;
+
+/**
+ * @brief An MQTT broker in memory, which answers the devices as IoT Hub does.
+ *
+ * @details It accepts every connection and counts the telemetry messages. Every
+ * `method_interval` telemetry messages of a device, it sends the device a method request, and every
+ * `twin_patch_interval` a desired properties patch. It answers the twin GET and the reported
+ * properties PATCH requests, and counts the method responses.
+ */
+typedef struct
+{
+  az_iot_load_memory_broker_device* devices;
+  int32_t device_count;
+  int32_t method_interval;
+  int32_t twin_patch_interval;
+  az_iot_load_memory_broker_message queue[AZ_IOT_LOAD_MEMORY_BROKER_QUEUE_SIZE];
+  int32_t queue_head;
+  int32_t queue_count;
+  int64_t telemetry_count;
+  int64_t method_response_count;
+  int64_t twin_request_count;
+} az_iot_load_memory_broker;
+
+/**
+ * @brief Initializes an #az_iot_load_memory_broker.
+ *
+ * @param[out] broker The #az_iot_load_memory_broker to initialize.
+ * @param[in] devices An array of \p device_count #az_iot_load_memory_broker_device, one for each
+ * simulated device.
+ * @param[in] device_count The number of devices in \p devices.
+ * @param[in] method_interval The number of telemetry messages of a device between two of its
+ * method requests, or 0 for none.
+ * @param[in] twin_patch_interval The number of telemetry messages of a device between two of its
+ * desired properties patches, or 0 for none.
+ */
+void az_iot_load_memory_broker_init(
+    az_iot_load_memory_broker* broker,
+    az_iot_load_memory_broker_device devices[],
+    int32_t device_count,
+    int32_t method_interval,
+    int32_t twin_patch_interval);
+
+/**
+ * @brief Gets the #az_iot_load_mqtt_backend of an #az_iot_load_memory_broker.
+ *
+ * @param[in] broker The #az_iot_load_memory_broker the backend sends the messages to.
+ *
+ * @return An #az_iot_load_mqtt_backend.
+ */
+az_iot_load_mqtt_backend az_iot_load_memory_broker_get_backend(az_iot_load_memory_broker* broker);
+
+#endif // _az_IOT_LOAD_MQTT_H
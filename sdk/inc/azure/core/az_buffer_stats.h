@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief This header defines the high-watermarks of the buffers your application gives the SDK to
+ * write into, which let you size them from real traffic instead of worst-case constants.
+ *
+ * @details If you define the `AZ_BUFFER_STATS` symbol when compiling the SDK code (or adding option
+ * `-DBUFFER_STATS=ON` with cmake), the functions which build HTTP requests and responses, JSON
+ * payloads and IoT MQTT fields record the most bytes they used of each kind of buffer. The peaks
+ * are shared by all the clients of the process, and updated with atomic operations, so that they
+ * can be read while requests are sent. Without `AZ_BUFFER_STATS`, nothing is recorded, and
+ * #az_buffer_stats_get() returns zeros.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_BUFFER_STATS_H
+#define _az_BUFFER_STATS_H
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief The most bytes used of each kind of buffer since the SDK was loaded, or since
+ * #az_buffer_stats_reset() was last called.
+ */
+typedef struct
+{
+  /// The longest URL of an `az_http_request`, which its URL buffer must hold.
+  int32_t http_request_url;
+
+  /// The most bytes of the headers buffer of an `az_http_request` its headers used.
+  int32_t http_request_headers;
+
+  /// The longest response written into the buffer of an `az_http_response`. The body bytes passed
+  /// to a body sink are not counted.
+  int32_t http_response;
+
+  /// The most bytes an `az_json_writer` wrote, into its buffer or the chunks it asked for.
+  int32_t json_writer;
+
+  /// The longest MQTT topic an IoT client built, including its null terminator.
+  int32_t iot_mqtt_topic;
+
+  /// The longest MQTT client ID an IoT client built, including its null terminator.
+  int32_t iot_mqtt_client_id;
+
+  /// The longest MQTT user name an IoT client built, including its null terminator.
+  int32_t iot_mqtt_user_name;
+
+  /// The longest MQTT password an IoT client built, including its null terminator.
+  int32_t iot_mqtt_password;
+} az_buffer_stats;
+
+/**
+ * @brief Gets the buffer high-watermarks recorded so far.
+ *
+ * @param[out] out_stats The #az_buffer_stats to fill.
+ */
+void az_buffer_stats_get(az_buffer_stats* out_stats);
+
+/**
+ * @brief Sets all the buffer high-watermarks back to zero, such as between two phases of the
+ * traffic of an application.
+ */
+void az_buffer_stats_reset(void);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_BUFFER_STATS_H
@@ -0,0 +1,599 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief This header defines the types and functions your application uses to read or write CBOR
+ * (RFC 8949), a binary encoding of the JSON data model which is typically 2 to 4 times smaller
+ * than JSON text for telemetry.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_CBOR_H
+#define _az_CBOR_H
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief Defines symbols for the various kinds of CBOR tokens that make up any CBOR data item.
+ */
+typedef enum
+{
+  AZ_CBOR_TOKEN_NONE, ///< There is no value (as distinct from #AZ_CBOR_TOKEN_NULL).
+  AZ_CBOR_TOKEN_BEGIN_MAP, ///< The token kind is the start of a map, the CBOR object.
+  AZ_CBOR_TOKEN_END_MAP, ///< The token kind is the end of a map.
+  AZ_CBOR_TOKEN_BEGIN_ARRAY, ///< The token kind is the start of an array.
+  AZ_CBOR_TOKEN_END_ARRAY, ///< The token kind is the end of an array.
+  AZ_CBOR_TOKEN_PROPERTY_NAME, ///< The token kind is a text string key of a map.
+  AZ_CBOR_TOKEN_STRING, ///< The token kind is a text string value.
+  AZ_CBOR_TOKEN_BYTES, ///< The token kind is a byte string value.
+  AZ_CBOR_TOKEN_INTEGER, ///< The token kind is an unsigned or negative integer.
+  AZ_CBOR_TOKEN_FLOAT, ///< The token kind is a half, single or double precision float.
+  AZ_CBOR_TOKEN_TRUE, ///< The token kind is the simple value true.
+  AZ_CBOR_TOKEN_FALSE, ///< The token kind is the simple value false.
+  AZ_CBOR_TOKEN_NULL, ///< The token kind is the simple value null, or undefined.
+} az_cbor_token_kind;
+
+/**
+ * @brief Represents a CBOR token. The kind field indicates the type of the CBOR token and the
+ * slice field points to the content of a string token.
+ */
+typedef struct
+{
+  /// This read-only field gives access to the slice of the CBOR buffer that holds the content of
+  /// a string, byte string or property name token, or the encoded item for other kinds of
+  /// tokens.
+  az_span slice;
+
+  /// This read-only field gives access to the type of the token returned by the #az_cbor_reader,
+  /// and it shouldn't be modified by the caller.
+  az_cbor_token_kind kind;
+
+  /// A limited set of fields which are considered private.
+  struct
+  {
+    uint64_t value;
+    bool is_negative;
+    double float_value;
+  } _internal;
+} az_cbor_token;
+
+/**
+ * @brief Gets the boolean representation of the CBOR token.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] out_value A pointer to a variable to receive the value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The boolean value is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_TRUE or
+ * #AZ_CBOR_TOKEN_FALSE.
+ */
+AZ_NODISCARD az_result az_cbor_token_get_boolean(az_cbor_token const* cbor_token, bool* out_value);
+
+/**
+ * @brief Gets the CBOR token's integer as a 64-bit unsigned integer.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] out_value A pointer to a variable to receive the value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_INTEGER.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The integer is negative.
+ */
+AZ_NODISCARD az_result
+az_cbor_token_get_uint64(az_cbor_token const* cbor_token, uint64_t* out_value);
+
+/**
+ * @brief Gets the CBOR token's integer as a 32-bit unsigned integer.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] out_value A pointer to a variable to receive the value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_INTEGER.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The integer is negative or too large for a `uint32_t`.
+ */
+AZ_NODISCARD az_result
+az_cbor_token_get_uint32(az_cbor_token const* cbor_token, uint32_t* out_value);
+
+/**
+ * @brief Gets the CBOR token's integer as a 64-bit signed integer.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] out_value A pointer to a variable to receive the value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_INTEGER.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The integer is too large for an `int64_t`.
+ */
+AZ_NODISCARD az_result az_cbor_token_get_int64(az_cbor_token const* cbor_token, int64_t* out_value);
+
+/**
+ * @brief Gets the CBOR token's integer as a 32-bit signed integer.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] out_value A pointer to a variable to receive the value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_INTEGER.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The integer is too large for an `int32_t`.
+ */
+AZ_NODISCARD az_result az_cbor_token_get_int32(az_cbor_token const* cbor_token, int32_t* out_value);
+
+/**
+ * @brief Gets the CBOR token's number as a `double`.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] out_value A pointer to a variable to receive the value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_FLOAT or
+ * #AZ_CBOR_TOKEN_INTEGER.
+ *
+ * @remarks Integers beyond 2^53 lose precision, as they would in JSON.
+ */
+AZ_NODISCARD az_result az_cbor_token_get_double(az_cbor_token const* cbor_token, double* out_value);
+
+/**
+ * @brief Copies the text string of the CBOR token into a null-terminated buffer.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance.
+ * @param[out] destination A pointer to a buffer where the string should be copied into.
+ * @param[in] destination_max_size The maximum available space within the buffer referred to by
+ * \p destination.
+ * @param[out] out_string_length __[nullable]__ Contains the number of bytes written to the \p
+ * destination, without the null terminator. If `NULL` is passed, the parameter is ignored.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The string is returned.
+ * @retval #AZ_ERROR_CBOR_INVALID_STATE The kind is not #AZ_CBOR_TOKEN_STRING or
+ * #AZ_CBOR_TOKEN_PROPERTY_NAME.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p destination does not have enough size.
+ */
+AZ_NODISCARD az_result az_cbor_token_get_string(
+    az_cbor_token const* cbor_token,
+    char* destination,
+    int32_t destination_max_size,
+    int32_t* out_string_length);
+
+/**
+ * @brief Determines whether the text string of the CBOR token is equal to the expected text, with
+ * a case-sensitive comparison.
+ *
+ * @param[in] cbor_token A pointer to an #az_cbor_token instance containing the CBOR string token.
+ * @param[in] expected_text The lookup text to compare the token against.
+ *
+ * @return `true` if the text of the token is \p expected_text; otherwise, `false`. It is always
+ * `false` for kinds other than the string and property name.
+ */
+AZ_NODISCARD bool az_cbor_token_is_text_equal(
+    az_cbor_token const* cbor_token,
+    az_span expected_text);
+
+/**
+ * @brief Allows the user to define custom behavior when writing CBOR using the #az_cbor_writer.
+ */
+typedef struct
+{
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_cbor_writer_options;
+
+/**
+ * @brief Gets the default CBOR writer options.
+ *
+ * @details Call this to obtain an initialized #az_cbor_writer_options structure that can be
+ * modified and passed to #az_cbor_writer_init().
+ *
+ * @return The default #az_cbor_writer_options.
+ */
+AZ_NODISCARD AZ_INLINE az_cbor_writer_options az_cbor_writer_options_default()
+{
+  az_cbor_writer_options options = (az_cbor_writer_options) {
+    ._internal = {
+      .unused = false,
+    },
+  };
+
+  return options;
+}
+
+/**
+ * @brief Provides forward-only, non-cached writing of CBOR into the provided buffer.
+ *
+ * @remarks Maps and arrays are written with an indefinite length, closed by a break byte, so that
+ * the number of their items doesn't need to be known when they are started. Every number is
+ * written in the smallest encoding which holds it exactly, as the preferred serialization of
+ * RFC 8949 describes.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span destination_buffer;
+    int32_t bytes_written;
+    // For single contiguous buffer, bytes_written == total_bytes_written
+    int32_t total_bytes_written; // Currently, this is primarily used for testing.
+    az_span_allocator_fn allocator_callback;
+    void* user_context;
+    int32_t nesting_depth;
+    az_cbor_writer_options options;
+  } _internal;
+} az_cbor_writer;
+
+/**
+ * @brief Initializes an #az_cbor_writer which writes CBOR into a buffer.
+ *
+ * @param[out] out_cbor_writer A pointer to an #az_cbor_writer instance to initialize.
+ * @param destination_buffer An #az_span over the byte buffer where the CBOR is to be written.
+ * @param[in] options __[nullable]__ A reference to an #az_cbor_writer_options
+ * structure which defines custom behavior of the #az_cbor_writer. If `NULL` is passed, the writer
+ * will use the default options (i.e. #az_cbor_writer_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK #az_cbor_writer is initialized successfully.
+ * @retval other Initialization failed.
+ */
+AZ_NODISCARD az_result az_cbor_writer_init(
+    az_cbor_writer* out_cbor_writer,
+    az_span destination_buffer,
+    az_cbor_writer_options const* options);
+
+/**
+ * @brief Initializes an #az_cbor_writer which writes CBOR into a destination that can contain
+ * non-contiguous buffers.
+ *
+ * @param[out] out_cbor_writer A pointer to an #az_cbor_writer the instance to initialize.
+ * @param[in] first_destination_buffer An #az_span over the byte buffer where the CBOR is to be
+ * written at the start.
+ * @param[in] allocator_callback An #az_span_allocator_fn callback function that provides the
+ * destination span to write the CBOR to once the previous buffer is full or too small to contain
+ * the next item.
+ * @param user_context A context specific user-defined struct or set of fields that is passed
+ * through to calls to the #az_span_allocator_fn.
+ * @param[in] options __[nullable]__ A reference to an #az_cbor_writer_options
+ * structure which defines custom behavior of the #az_cbor_writer. If `NULL` is passed, the writer
+ * will use the default options (i.e. #az_cbor_writer_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_cbor_writer is initialized successfully.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_cbor_writer_chunked_init(
+    az_cbor_writer* out_cbor_writer,
+    az_span first_destination_buffer,
+    az_span_allocator_fn allocator_callback,
+    void* user_context,
+    az_cbor_writer_options const* options);
+
+/**
+ * @brief Returns the #az_span containing the CBOR written to the underlying buffer so far, in the
+ * last provided destination buffer.
+ *
+ * @param[in] cbor_writer A pointer to an #az_cbor_writer instance wrapping the destination buffer.
+ *
+ * @return An #az_span containing the CBOR built so far.
+ *
+ * @remarks As with #az_json_writer_get_bytes_used_in_destination(), this is only the whole CBOR
+ * when it fits in the first provided buffer.
+ */
+AZ_NODISCARD AZ_INLINE az_span
+az_cbor_writer_get_bytes_used_in_destination(az_cbor_writer const* cbor_writer)
+{
+  return az_span_slice(
+      cbor_writer->_internal.destination_buffer, 0, cbor_writer->_internal.bytes_written);
+}
+
+/**
+ * @brief Appends a UTF-8 text string value.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the string value to.
+ * @param[in] value The UTF-8 encoded value to be written as a CBOR text string.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The string value was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_string(az_cbor_writer* ref_cbor_writer, az_span value);
+
+/**
+ * @brief Appends a byte string value, which JSON would need to encode as base64 text.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the bytes to.
+ * @param[in] value The bytes to be written as a CBOR byte string.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The bytes were appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_bytes(az_cbor_writer* ref_cbor_writer, az_span value);
+
+/**
+ * @brief Appends the key of the next property of a map.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the property name to.
+ * @param[in] name The UTF-8 encoded property name.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The property name was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result
+az_cbor_writer_append_property_name(az_cbor_writer* ref_cbor_writer, az_span name);
+
+/**
+ * @brief Appends a boolean value.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the value to.
+ * @param[in] value The value to be written as a CBOR simple value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The bool was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_bool(az_cbor_writer* ref_cbor_writer, bool value);
+
+/**
+ * @brief Appends an `int32_t` number value.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the value to.
+ * @param[in] value The value to be written as a CBOR integer.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_int32(az_cbor_writer* ref_cbor_writer, int32_t value);
+
+/**
+ * @brief Appends an `int64_t` number value.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the value to.
+ * @param[in] value The value to be written as a CBOR integer.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_int64(az_cbor_writer* ref_cbor_writer, int64_t value);
+
+/**
+ * @brief Appends a `uint64_t` number value.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the value to.
+ * @param[in] value The value to be written as a CBOR integer.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result
+az_cbor_writer_append_uint64(az_cbor_writer* ref_cbor_writer, uint64_t value);
+
+/**
+ * @brief Appends a `double` number value.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the value to.
+ * @param[in] value The value to be written as a CBOR float.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ *
+ * @remarks The value is written as a half or single precision float when that holds it exactly,
+ * so a reading such as 21.5 takes 3 bytes. Unlike JSON, NaN and the infinities can be written.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_double(az_cbor_writer* ref_cbor_writer, double value);
+
+/**
+ * @brief Appends the simple value null.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the null to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Null was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_null(az_cbor_writer* ref_cbor_writer);
+
+/**
+ * @brief Appends the beginning of a map, the CBOR object.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the start of the map to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Map start was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_begin_map(az_cbor_writer* ref_cbor_writer);
+
+/**
+ * @brief Appends the beginning of an array.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the start of the array to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Array start was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_begin_array(az_cbor_writer* ref_cbor_writer);
+
+/**
+ * @brief Appends the end of the current map.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the end of the map to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Map end was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_end_map(az_cbor_writer* ref_cbor_writer);
+
+/**
+ * @brief Appends the end of the current array.
+ *
+ * @param[in,out] ref_cbor_writer A pointer to an #az_cbor_writer instance containing the buffer to
+ * append the end of the array to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Array end was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ */
+AZ_NODISCARD az_result az_cbor_writer_append_end_array(az_cbor_writer* ref_cbor_writer);
+
+/**
+ * @brief Allows the user to define custom behavior when reading CBOR using the #az_cbor_reader.
+ */
+typedef struct
+{
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_cbor_reader_options;
+
+/**
+ * @brief Gets the default CBOR reader options.
+ *
+ * @details Call this to obtain an initialized #az_cbor_reader_options structure that can be
+ * modified and passed to #az_cbor_reader_init().
+ *
+ * @return The default #az_cbor_reader_options.
+ */
+AZ_NODISCARD AZ_INLINE az_cbor_reader_options az_cbor_reader_options_default()
+{
+  az_cbor_reader_options options = (az_cbor_reader_options) {
+    ._internal = {
+      .unused = false,
+    },
+  };
+
+  return options;
+}
+
+enum
+{
+  _az_CBOR_MAX_NESTING_DEPTH = 32,
+};
+
+/**
+ * @brief Returns the CBOR tokens contained within a CBOR buffer, one at a time.
+ *
+ * @remarks Maps and arrays of both definite and indefinite length can be read, nested up to 32
+ * deep. Tags are skipped, so the token is the item they tag. Text and byte strings of indefinite
+ * length are not supported, nor are map keys other than text strings, as neither has a JSON
+ * counterpart.
+ */
+typedef struct
+{
+  /// This read-only field gives access to the current token that the #az_cbor_reader has
+  /// processed, and it shouldn't be modified by the caller.
+  az_cbor_token token;
+
+  /// A limited set of fields which are considered private.
+  struct
+  {
+    az_span cbor_buffer;
+    int32_t bytes_consumed;
+    int32_t nesting_depth;
+    struct
+    {
+      uint32_t remaining_items;
+      bool is_map;
+      bool is_indefinite;
+      bool is_key_next;
+    } containers[_az_CBOR_MAX_NESTING_DEPTH];
+    az_cbor_reader_options options;
+  } _internal;
+} az_cbor_reader;
+
+/**
+ * @brief Initializes an #az_cbor_reader to read the CBOR payload contained within the provided
+ * buffer.
+ *
+ * @param[out] out_cbor_reader A pointer to an #az_cbor_reader instance to initialize.
+ * @param[in] cbor_buffer An #az_span over the byte buffer containing the CBOR to read.
+ * @param[in] options __[nullable]__ A reference to an #az_cbor_reader_options structure which
+ * defines custom behavior of the #az_cbor_reader. If `NULL` is passed, the reader will use the
+ * default options (i.e. #az_cbor_reader_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_cbor_reader is initialized successfully.
+ * @retval other Initialization failed.
+ *
+ * @remarks The buffer may hold a sequence of several CBOR data items (RFC 8742), which are read
+ * one after the other.
+ */
+AZ_NODISCARD az_result az_cbor_reader_init(
+    az_cbor_reader* out_cbor_reader,
+    az_span cbor_buffer,
+    az_cbor_reader_options const* options);
+
+/**
+ * @brief Reads the next token in the CBOR buffer and updates the reader state.
+ *
+ * @param[in,out] ref_cbor_reader A pointer to an #az_cbor_reader instance containing the CBOR to
+ * read.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The token was read successfully.
+ * @retval #AZ_ERROR_UNEXPECTED_END The end of the CBOR buffer was reached within a data item.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The CBOR is not well-formed.
+ * @retval #AZ_ERROR_NOT_SUPPORTED The CBOR uses an encoding this reader doesn't support.
+ * @retval #AZ_ERROR_CBOR_NESTING_OVERFLOW The maps and arrays are nested too deep.
+ * @retval #AZ_ERROR_CBOR_READER_DONE No more CBOR data items to read.
+ */
+AZ_NODISCARD az_result az_cbor_reader_next_token(az_cbor_reader* ref_cbor_reader);
+
+/**
+ * @brief Reads and skips over any nested CBOR elements.
+ *
+ * @param[in,out] ref_cbor_reader A pointer to an #az_cbor_reader instance containing the CBOR to
+ * read.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The children of the current CBOR token are skipped successfully.
+ * @retval other As for #az_cbor_reader_next_token().
+ *
+ * @remarks If the current token kind is a property name, the reader first moves to the property
+ * value. Then, if the token kind is start of a map or array, the reader moves to the matching
+ * end. For all other token kinds, the reader doesn't move.
+ */
+AZ_NODISCARD az_result az_cbor_reader_skip_children(az_cbor_reader* ref_cbor_reader);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_CBOR_H
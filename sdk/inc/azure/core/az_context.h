@@ -41,6 +41,8 @@ struct az_context
     int64_t expiration; // Time when context expires
     void const* key; // Pointers to the key & value (usually NULL)
     void const* value;
+    int64_t soonest_expiration; // Soonest expiration of this node and its parents at creation
+    uint32_t cancel_count; // Number of canceled nodes when soonest_expiration was computed
   } _internal;
 };
 
@@ -86,6 +88,9 @@ void az_context_cancel(az_context* ref_context);
 /**
  * @brief Returns the soonest expiration time of this #az_context node or any of its parent nodes.
  *
+ * @details The soonest expiration is computed once, when the node is created, so this doesn't walk
+ * the parent nodes unless a node has been canceled since then.
+ *
  * @param[in] context A pointer to an #az_context node.
  * @return The soonest expiration time from this context and its parents.
  */
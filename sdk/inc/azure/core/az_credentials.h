@@ -15,11 +15,14 @@
 #ifndef _az_CREDENTIALS_H
 #define _az_CREDENTIALS_H
 
+#include <azure/core/az_context.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include <azure/core/_az_cfg_prefix.h>
 
@@ -50,6 +53,142 @@ typedef struct
   } _internal;
 } _az_credential;
 
+/**
+ * @brief The number of (credential, scopes) pairs an #az_credential_token_cache holds tokens for.
+ */
+#define AZ_CREDENTIAL_TOKEN_CACHE_MAX_ENTRIES 4
+
+/**
+ * @brief The maximum size, in bytes, of a token held by an #az_credential_token_cache.
+ */
+#define AZ_CREDENTIAL_TOKEN_MAX_SIZE 4096
+
+/**
+ * @brief Acquires a new token from the identity service, for an #az_credential_token_cache.
+ *
+ * @param[in] user_context The user context given to #az_credential_token_cache_get().
+ * @param[in] context The #az_context given to #az_credential_token_cache_get().
+ * @param[in] scopes The scopes the token is for.
+ * @param[in] token_buffer The buffer to write the token to.
+ * @param[out] out_token The part of \p token_buffer the token was written to.
+ * @param[out] out_expires_at_msec When the token expires, in #az_platform_clock_msec() time.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ */
+typedef AZ_NODISCARD az_result (*az_credential_token_acquire_fn)(
+    void* user_context,
+    az_context* context,
+    az_span scopes,
+    az_span token_buffer,
+    az_span* out_token,
+    int64_t* out_expires_at_msec);
+
+/**
+ * @brief Allows customization of an #az_credential_token_cache.
+ */
+typedef struct
+{
+  /**
+   * How long, in milliseconds, before its expiration a token is refreshed. Until it expires, the
+   * other callers keep getting the current token while the refresh is in flight.
+   */
+  int32_t refresh_before_expiry_msec;
+} az_credential_token_cache_options;
+
+/**
+ * @brief The tokens cached for one credential and its scopes.
+ */
+typedef struct
+{
+  struct
+  {
+    void const* credential;
+    az_span scopes;
+    uint8_t token[AZ_CREDENTIAL_TOKEN_MAX_SIZE];
+    int32_t token_size;
+    int64_t expires_at_msec;
+    bool is_refreshing;
+    uint64_t refresh_count;
+    az_result refresh_result;
+  } _internal;
+} _az_credential_token_cache_entry;
+
+/**
+ * @brief A cache of tokens which the credentials of several clients, on several threads, share.
+ *
+ * @details Each (credential, scopes) pair has one token, which only one caller at a time
+ * refreshes. The others wait for the result of that refresh, rather than each acquiring their own
+ * token, when many clients start at once or when the token expires.
+ */
+typedef struct
+{
+  struct
+  {
+    az_credential_token_cache_options options;
+    uint64_t volatile lock;
+    int32_t entry_count;
+    _az_credential_token_cache_entry entries[AZ_CREDENTIAL_TOKEN_CACHE_MAX_ENTRIES];
+  } _internal;
+} az_credential_token_cache;
+
+/**
+ * @brief Gets the default #az_credential_token_cache_options, which refresh a token 5 minutes
+ * before it expires.
+ *
+ * @return An #az_credential_token_cache_options.
+ */
+AZ_NODISCARD AZ_INLINE az_credential_token_cache_options az_credential_token_cache_options_default()
+{
+  return (az_credential_token_cache_options){ .refresh_before_expiry_msec = 5 * 60 * 1000 };
+}
+
+/**
+ * @brief Initializes an empty #az_credential_token_cache.
+ *
+ * @param[out] out_cache The #az_credential_token_cache to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_credential_token_cache_options
+ * structure. If `NULL` is passed, the cache will use the default options (i.e.
+ * #az_credential_token_cache_options_default()).
+ */
+void az_credential_token_cache_init(
+    az_credential_token_cache* out_cache,
+    az_credential_token_cache_options const* options);
+
+/**
+ * @brief Gets the token cached for \p credential and \p scopes, and acquires it first if needed.
+ *
+ * @details The first caller which finds no valid token, or a token close to its expiration,
+ * acquires a new one with \p acquire. While it does, the other callers get the current token if it
+ * hasn't expired, and otherwise wait for the new one. If a refresh fails while the current token
+ * is still valid, the current token is returned.
+ *
+ * @param[in,out] ref_cache The #az_credential_token_cache shared by the credentials.
+ * @param[in] credential The credential the token is for, which identifies it with \p scopes.
+ * @param[in] scopes The scopes the token is for. It must stay valid as long as \p ref_cache.
+ * @param[in] context The #az_context of the request which needs the token.
+ * @param[in] acquire Acquires a new token.
+ * @param[in] acquire_user_context The user context passed to \p acquire.
+ * @param[in] token_buffer The buffer to copy the token to.
+ * @param[out] out_token The part of \p token_buffer the token was copied to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The token is in \p out_token.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The token doesn't fit \p token_buffer or
+ * #AZ_CREDENTIAL_TOKEN_MAX_SIZE, or the cache holds tokens for
+ * #AZ_CREDENTIAL_TOKEN_CACHE_MAX_ENTRIES other pairs already.
+ * @retval #AZ_ERROR_CANCELED \p context was canceled while waiting for another caller's refresh.
+ * @retval other The failure of \p acquire, for its caller and for the callers which waited for it.
+ */
+AZ_NODISCARD az_result az_credential_token_cache_get(
+    az_credential_token_cache* ref_cache,
+    void const* credential,
+    az_span scopes,
+    az_context* context,
+    az_credential_token_acquire_fn acquire,
+    void* acquire_user_context,
+    az_span token_buffer,
+    az_span* out_token);
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_CREDENTIALS_H
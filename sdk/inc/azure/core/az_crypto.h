@@ -0,0 +1,268 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief This header defines the SHA-256, HMAC-SHA256, Base64 and hex routines used to sign Shared
+ * Access Signature (SAS) tokens and carry binary values as text, and the CRC-64 used to check the
+ * integrity of storage content.
+ *
+ * @details The SDK provides a portable default implementation which uses the SHA extensions of x86
+ * and ARMv8 processors, vector instructions for Base64 and hex encoding and decoding, and
+ * carry-less multiplication for the CRC-64, when the compiler targets them (unless `AZ_NO_SIMD` is
+ * defined). Applications
+ * which prefer another implementation, such as one backed by a hardware security module, can
+ * replace the HMAC-SHA256 routine with #az_crypto_set_hmac_sha256_callback().
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_CRYPTO_H
+#define _az_CRYPTO_H
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief The size, in bytes, of a SHA-256 digest, and so of an HMAC-SHA256.
+ */
+#define AZ_CRYPTO_SHA256_SIZE 32
+
+/**
+ * @brief Defines the signature of an HMAC-SHA256 implementation which replaces the SDK default.
+ *
+ * @param[in] key The key to sign with.
+ * @param[in] message The bytes to sign.
+ * @param[out] destination The #az_span which receives the #AZ_CRYPTO_SHA256_SIZE bytes of the
+ * HMAC. It is at least that large.
+ * @return An #az_result value indicating the result of the operation.
+ */
+typedef az_result (*az_crypto_hmac_sha256_fn)(az_span key, az_span message, az_span destination);
+
+/**
+ * @brief Sets the function that #az_crypto_hmac_sha256() forwards to.
+ *
+ * @param[in] hmac_sha256_callback __[nullable]__ A pointer to the function to use instead of the
+ * SDK implementation. If `NULL`, the SDK implementation is restored.
+ */
+void az_crypto_set_hmac_sha256_callback(az_crypto_hmac_sha256_fn hmac_sha256_callback);
+
+/**
+ * @brief Computes the SHA-256 digest of \p source.
+ *
+ * @param[in] source The bytes to hash.
+ * @param[out] destination The #az_span whose first #AZ_CRYPTO_SHA256_SIZE bytes receive the digest.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The digest was computed successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than #AZ_CRYPTO_SHA256_SIZE.
+ */
+AZ_NODISCARD az_result az_crypto_sha256(az_span source, az_span destination);
+
+/**
+ * @brief Computes the HMAC-SHA256 of \p message with \p key, as defined by RFC 2104.
+ *
+ * @details Uses the function set with #az_crypto_set_hmac_sha256_callback(), if any.
+ *
+ * @param[in] key The key to sign with. It can be of any size.
+ * @param[in] message The bytes to sign.
+ * @param[out] destination The #az_span whose first #AZ_CRYPTO_SHA256_SIZE bytes receive the HMAC.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The HMAC was computed successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than #AZ_CRYPTO_SHA256_SIZE.
+ */
+AZ_NODISCARD az_result az_crypto_hmac_sha256(az_span key, az_span message, az_span destination);
+
+/**
+ * @brief Updates the CRC-64 which Azure Storage uses for the `x-ms-content-crc64` header with the
+ * bytes of \p source.
+ *
+ * @details The CRC uses the polynomial 0x9A6C9329AC4BC9B5, bit-reflected, and starts from and is
+ * finished with all ones, as the CRC-64/NVME. Content can be checked as it is read, one piece at a
+ * time, by passing the CRC of the previous pieces.
+ *
+ * @param[in] source The bytes to add to the CRC.
+ * @param[in] crc The CRC of the content before \p source, or `0` to start.
+ * @return The CRC of the content up to and including \p source.
+ */
+AZ_NODISCARD uint64_t az_crypto_crc64(az_span source, uint64_t crc);
+
+/**
+ * @brief Calculates the size of the Base64 encoding of \p source_size bytes, including padding.
+ *
+ * @param[in] source_size The number of bytes to encode. Must not be negative.
+ * @return The number of characters az_base64_encode() writes.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_base64_get_encoded_size(int32_t source_size)
+{
+  return ((source_size + 2) / 3) * 4;
+}
+
+/**
+ * @brief Calculates the largest number of bytes that Base64 text of \p source_size characters
+ * decodes to.
+ *
+ * @param[in] source_size The number of characters to decode. Must not be negative.
+ * @return The largest number of bytes az_base64_decode() writes.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_base64_get_max_decoded_size(int32_t source_size)
+{
+  return (source_size / 4) * 3;
+}
+
+/**
+ * @brief Encodes \p source as padded Base64 text, using the alphabet of RFC 4648 section 4.
+ *
+ * @param[out] destination The #az_span which receives the Base64 text.
+ * @param[in] source The bytes to encode.
+ * @param[out] out_written The number of characters written to \p destination.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The bytes were encoded successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than
+ * az_base64_get_encoded_size() of the \p source size.
+ */
+AZ_NODISCARD az_result
+az_base64_encode(az_span destination, az_span source, int32_t* out_written);
+
+/**
+ * @brief Decodes padded Base64 text, using the alphabet of RFC 4648 section 4.
+ *
+ * @param[out] destination The #az_span which receives the decoded bytes.
+ * @param[in] source The Base64 text to decode. Its size must be a multiple of 4.
+ * @param[out] out_written The number of bytes written to \p destination.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The text was decoded successfully.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The \p source contains a character outside of the Base64
+ * alphabet, or misplaced padding.
+ * @retval #AZ_ERROR_UNEXPECTED_END The size of \p source is not a multiple of 4.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is too small for the decoded bytes.
+ */
+AZ_NODISCARD az_result
+az_base64_decode(az_span destination, az_span source, int32_t* out_written);
+
+/**
+ * @brief Calculates the number of bytes that the padded Base64 text \p source decodes to.
+ *
+ * @param[in] source The Base64 text. Its size must be a multiple of 4.
+ * @return The number of bytes az_base64_decode() writes, once the padding at the end of \p source
+ * is taken into account.
+ */
+AZ_NODISCARD int32_t az_base64_get_decoded_size(az_span source);
+
+/**
+ * @brief Calculates the size of the unpadded Base64url encoding of \p source_size bytes.
+ *
+ * @param[in] source_size The number of bytes to encode. Must not be negative.
+ * @return The number of characters az_base64_url_encode() writes.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_base64_url_get_encoded_size(int32_t source_size)
+{
+  return ((source_size / 3) * 4) + (source_size % 3 == 0 ? 0 : (source_size % 3) + 1);
+}
+
+/**
+ * @brief Calculates the number of bytes that unpadded Base64url text of \p source_size characters
+ * decodes to.
+ *
+ * @param[in] source_size The number of characters to decode. Must not be negative.
+ * @return The number of bytes az_base64_url_decode() writes.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_base64_url_get_decoded_size(int32_t source_size)
+{
+  return ((source_size / 4) * 3) + (source_size % 4 == 0 ? 0 : (source_size % 4) - 1);
+}
+
+/**
+ * @brief Encodes \p source as unpadded Base64url text, using the URL and filename safe alphabet of
+ * RFC 4648 section 5, as in JSON Web Tokens.
+ *
+ * @param[out] destination The #az_span which receives the Base64url text.
+ * @param[in] source The bytes to encode.
+ * @param[out] out_written The number of characters written to \p destination.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The bytes were encoded successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than
+ * az_base64_url_get_encoded_size() of the \p source size.
+ */
+AZ_NODISCARD az_result
+az_base64_url_encode(az_span destination, az_span source, int32_t* out_written);
+
+/**
+ * @brief Decodes unpadded Base64url text, using the URL and filename safe alphabet of RFC 4648
+ * section 5.
+ *
+ * @param[out] destination The #az_span which receives the decoded bytes.
+ * @param[in] source The Base64url text to decode, without padding.
+ * @param[out] out_written The number of bytes written to \p destination.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The text was decoded successfully.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The \p source contains a character outside of the Base64url
+ * alphabet, such as padding.
+ * @retval #AZ_ERROR_UNEXPECTED_END The \p source ends with a single character of a group, which
+ * no number of bytes encodes to.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than
+ * az_base64_url_get_decoded_size() of the \p source size.
+ */
+AZ_NODISCARD az_result
+az_base64_url_decode(az_span destination, az_span source, int32_t* out_written);
+
+/**
+ * @brief Calculates the size of the hex encoding of \p source_size bytes.
+ *
+ * @param[in] source_size The number of bytes to encode. Must not be negative.
+ * @return The number of characters az_hex_encode() writes.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_hex_get_encoded_size(int32_t source_size)
+{
+  return source_size * 2;
+}
+
+/**
+ * @brief Calculates the number of bytes that hex text of \p source_size characters decodes to.
+ *
+ * @param[in] source_size The number of characters to decode. Must not be negative.
+ * @return The number of bytes az_hex_decode() writes.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_hex_get_decoded_size(int32_t source_size)
+{
+  return source_size / 2;
+}
+
+/**
+ * @brief Encodes \p source as lowercase hex text, two characters per byte.
+ *
+ * @param[out] destination The #az_span which receives the hex text.
+ * @param[in] source The bytes to encode.
+ * @param[out] out_written The number of characters written to \p destination.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The bytes were encoded successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than az_hex_get_encoded_size()
+ * of the \p source size.
+ */
+AZ_NODISCARD az_result az_hex_encode(az_span destination, az_span source, int32_t* out_written);
+
+/**
+ * @brief Decodes hex text, whose digits may be lowercase or uppercase.
+ *
+ * @param[out] destination The #az_span which receives the decoded bytes.
+ * @param[in] source The hex text to decode. Its size must be even.
+ * @param[out] out_written The number of bytes written to \p destination.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The text was decoded successfully.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The \p source contains a character which isn't a hex digit.
+ * @retval #AZ_ERROR_UNEXPECTED_END The size of \p source is odd.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than az_hex_get_decoded_size()
+ * of the \p source size.
+ */
+AZ_NODISCARD az_result az_hex_decode(az_span destination, az_span source, int32_t* out_written);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_CRYPTO_H
@@ -18,6 +18,7 @@
 
 #include <azure/core/az_config.h>
 #include <azure/core/az_context.h>
+#include <azure/core/az_log.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
 
@@ -114,6 +115,33 @@ typedef enum
   AZ_HTTP_STATUS_CODE_END_OF_LIST = -1,
 } az_http_status_code;
 
+/**
+ * @brief How the retry policy randomizes the delay before each retry.
+ */
+typedef enum
+{
+  /// The delay doubles with each retry, up to the maximum delay.
+  AZ_HTTP_POLICY_RETRY_JITTER_NONE = 0,
+
+  /// The delay is picked at random between the minimum delay and three times the previous delay,
+  /// up to the maximum delay. This spreads out the retries of clients which failed together.
+  AZ_HTTP_POLICY_RETRY_JITTER_DECORRELATED = 1,
+} az_http_policy_retry_jitter;
+
+/**
+ * @brief Defines the callback the retry policy calls to wait before a retry, instead of
+ * az_platform_sleep_msec().
+ *
+ * @param[in] user_context The user-provided context which is passed to the callback.
+ * @param[in] delay_msec The time, in milliseconds, to wait before the retry.
+ *
+ * @return An #az_result value indicating the result of the operation. On failure, the request is
+ * not retried and the policy returns this result.
+ *
+ * @remarks This lets an application with a cooperative scheduler run other work during the delay.
+ */
+typedef az_result (*az_http_policy_retry_wait_fn)(void* user_context, int32_t delay_msec);
+
 /**
  * @brief Allows you to customize the retry policy used by SDK clients whenever they perform an I/O
  * operation.
@@ -135,8 +163,111 @@ typedef struct
 
   /// Maximum number of retries.
   int32_t max_retries;
+
+  /// How the delay before each retry is randomized, when the response has no retry-after header.
+  az_http_policy_retry_jitter jitter;
+
+  /// An optional callback to wait before each retry. If `NULL`, the policy calls
+  /// az_platform_sleep_msec().
+  az_http_policy_retry_wait_fn wait_callback;
+
+  /// The user-provided context which is passed to #wait_callback.
+  void* wait_user_context;
 } az_http_policy_retry_options;
 
+/**
+ * @brief The maximum number of pipeline policies the metrics policy times separately.
+ */
+#define AZ_HTTP_POLICY_METRICS_MAX_POLICIES 10
+
+/**
+ * @brief What the metrics policy measured while one request went through the HTTP pipeline.
+ */
+typedef struct
+{
+  /// The time, in milliseconds, spent in each policy following the metrics policy, not counting the
+  /// time spent in the policies after it. The last policy is the transport.
+  int64_t policy_time_msec[AZ_HTTP_POLICY_METRICS_MAX_POLICIES];
+
+  /// The number of entries of #policy_time_msec which were measured.
+  int32_t policy_count;
+
+  /// The number of request body bytes sent, over all the attempts.
+  int64_t bytes_sent;
+
+  /// The number of response bytes received into the #az_http_response, over all the attempts.
+  /// Bytes passed to a body sink are not counted.
+  int64_t bytes_received;
+
+  /// The number of times the request was sent again after the first attempt.
+  int32_t retry_count;
+
+  /// The status code of the final response, or `0` if there was no response.
+  az_http_status_code status_code;
+
+  /// The result the pipeline returned.
+  az_result result;
+} az_http_request_metrics;
+
+/**
+ * @brief Counters the metrics policy adds the #az_http_request_metrics of every request to.
+ *
+ * @remarks The counters only ever increase, and each one is updated with a single atomic addition,
+ * so that the requests of several threads can be recorded in the same counters, and a scraper on
+ * another thread can read them without taking a lock. A reading may include part of the request
+ * being recorded at the time.
+ */
+typedef struct
+{
+  /// The number of requests which went through the pipeline.
+  int64_t request_count;
+
+  /// The number of requests for which the pipeline returned a failed #az_result.
+  int64_t failed_request_count;
+
+  /// The number of times requests were sent again after their first attempt.
+  int64_t retry_count;
+
+  /// The number of request body bytes sent.
+  int64_t bytes_sent;
+
+  /// The number of response bytes received.
+  int64_t bytes_received;
+
+  /// The number of final responses by status class, where `[2]` counts the 2xx responses, and so
+  /// on. `[0]` counts the requests without a response.
+  int64_t status_class_count[6];
+
+  /// The time, in milliseconds, spent in each policy following the metrics policy.
+  int64_t policy_time_msec[AZ_HTTP_POLICY_METRICS_MAX_POLICIES];
+} az_http_pipeline_metrics;
+
+/**
+ * @brief Defines the callback the metrics policy calls with the #az_http_request_metrics of each
+ * request.
+ *
+ * @param[in] user_context The user-provided context which is passed to the callback.
+ * @param[in] metrics What was measured. It is only valid for the duration of the call.
+ */
+typedef void (
+    *az_http_policy_metrics_fn)(void* user_context, az_http_request_metrics const* metrics);
+
+/**
+ * @brief Allows you to collect metrics about the requests SDK clients send, without formatting
+ * any text.
+ */
+typedef struct
+{
+  /// The counters which are updated after each request. May be `NULL`.
+  az_http_pipeline_metrics* counters;
+
+  /// The callback which is called after each request. May be `NULL`.
+  az_http_policy_metrics_fn callback;
+
+  /// The user-provided context which is passed to #callback.
+  void* callback_user_context;
+} az_http_policy_metrics_options;
+
 typedef enum
 {
   _az_HTTP_RESPONSE_KIND_STATUS_LINE = 0,
@@ -145,6 +276,33 @@ typedef enum
   _az_HTTP_RESPONSE_KIND_EOF = 3,
 } _az_http_response_kind;
 
+typedef enum
+{
+  _az_HTTP_RESPONSE_BODY_SINK_STATE_HEADERS = 0,
+  _az_HTTP_RESPONSE_BODY_SINK_STATE_SINK = 1,
+  _az_HTTP_RESPONSE_BODY_SINK_STATE_BUFFER = 2,
+} _az_http_response_body_sink_state;
+
+/**
+ * @brief Defines the callback which receives the body of an HTTP response as it arrives from the
+ * network.
+ *
+ * @param[in] user_context The user context passed to #az_http_response_set_body_sink().
+ * @param[in] body_chunk The next chunk of the response body. It is only valid for the duration of
+ * the call.
+ *
+ * @return An #az_result value indicating the result of the operation. Returning a failed result
+ * aborts the transfer.
+ */
+typedef AZ_NODISCARD az_result (
+    *az_http_response_body_sink_fn)(void* user_context, az_span body_chunk);
+
+/**
+ * @brief Used to declare #az_http_response_pool.
+ */
+// Definition is below.
+typedef struct az_http_response_pool az_http_response_pool;
+
 /**
  * @brief Allows you to parse an HTTP response's status line, headers, and body.
  *
@@ -165,6 +323,19 @@ typedef struct
       _az_http_response_kind next_kind;
       // After parsing an element, next_kind refers to the next expected element
     } parser;
+    struct
+    {
+      az_http_response_body_sink_fn callback;
+      void* user_context;
+      int32_t header_end_matched; // number of bytes of the "\r\n\r\n" terminator seen so far.
+      _az_http_response_body_sink_state state;
+    } body_sink;
+    struct
+    {
+      az_span_allocator_fn callback;
+      void* user_context;
+    } allocator;
+    az_http_response_pool* pool; // The pool the buffer was checked out from, or NULL.
   } _internal;
 } az_http_response;
 
@@ -174,7 +345,9 @@ typedef struct
  *
  * @param[out] out_response The pointer to an #az_http_response instance which is to be initialized.
  * @param[in] buffer A span over the byte buffer that is to be filled with the HTTP response data.
- * This buffer must be large enough to hold the entire response.
+ * This buffer must be large enough to hold the entire response, or only its status line and headers
+ * when the body is streamed with #az_http_response_set_body_sink(), unless it is grown by an
+ * allocator set with #az_http_response_set_allocator().
  *
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK Success.
@@ -191,12 +364,616 @@ az_http_response_init(az_http_response* out_response, az_span buffer)
         .remaining = AZ_SPAN_EMPTY,
         .next_kind = _az_HTTP_RESPONSE_KIND_STATUS_LINE,
       },
+      .body_sink = {
+        .callback = NULL,
+        .user_context = NULL,
+        .header_end_matched = 0,
+        .state = _az_HTTP_RESPONSE_BODY_SINK_STATE_HEADERS,
+      },
+      .allocator = {
+        .callback = NULL,
+        .user_context = NULL,
+      },
+      .pool = NULL,
     },
   };
 
   return AZ_OK;
 }
 
+/**
+ * @brief Streams the body of a successful HTTP response to a callback instead of buffering it.
+ *
+ * @details The status line and headers are still written to the buffer passed to
+ * #az_http_response_init(), so it only needs to be large enough to hold them. Once the headers are
+ * complete, the body of a response with a 2xx status code is passed to \p sink as it arrives and
+ * #az_http_response_get_body() returns an empty body. Bodies of other responses, such as service
+ * errors, are buffered as usual, so a retried request never writes the body of a failed attempt
+ * to \p sink.
+ *
+ * @param[in,out] ref_response The #az_http_response to stream the body of. It must have been
+ * initialized with #az_http_response_init().
+ * @param[in] sink The callback which receives the body bytes.
+ * @param[in] user_context A pointer which is passed to \p sink. May be `NULL`.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_http_response_set_body_sink(
+    az_http_response* ref_response,
+    az_http_response_body_sink_fn sink,
+    void* user_context);
+
+/**
+ * @brief Lets the buffer of an HTTP response start small, and grow only for the responses which
+ * don't fit it.
+ *
+ * @details When the data received from the network doesn't fit the buffer, \p allocator is called
+ * with the number of bytes the response holds so far as the `bytes_used` of the
+ * #az_span_allocator_context, and the size the buffer must at least have as its
+ * `minimum_required_size`. The buffer it returns must start with the `bytes_used` bytes of the
+ * previous buffer, as `realloc()` does, and the response no longer uses the previous buffer once
+ * it returns. Growing the buffer more than strictly required, such as by doubling its size, lets
+ * the allocator be called fewer times.
+ *
+ * The response stays contiguous, so the status line, headers and body are parsed as usual, from
+ * the last buffer the allocator returned. The allocator is kept when the response is reset to
+ * retry the request, along with the larger buffer.
+ *
+ * @param[in,out] ref_response The #az_http_response to grow the buffer of. It must have been
+ * initialized with #az_http_response_init(), whose buffer may be empty.
+ * @param[in] allocator The callback which provides the larger buffers.
+ * @param[in] user_context A pointer which is passed to \p allocator. May be `NULL`.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ *
+ * @remark Once \p allocator fails, or returns a buffer which is too small,
+ * #az_http_response_append() fails with #AZ_ERROR_NOT_ENOUGH_SPACE, as it does without an
+ * allocator.
+ */
+AZ_NODISCARD az_result az_http_response_set_allocator(
+    az_http_response* ref_response,
+    az_span_allocator_fn allocator,
+    void* user_context);
+
+/// The most size classes an #az_http_response_pool can have.
+#define AZ_HTTP_RESPONSE_POOL_MAX_SIZE_CLASSES 4
+
+/// The most buffers each size class of an #az_http_response_pool can have.
+#define AZ_HTTP_RESPONSE_POOL_MAX_BUFFERS_PER_SIZE_CLASS 64
+
+/**
+ * @brief The number and size of the buffers of one size class of an #az_http_response_pool.
+ */
+typedef struct
+{
+  /// The size of each buffer, in bytes.
+  int32_t buffer_size;
+
+  /// The number of buffers, at most #AZ_HTTP_RESPONSE_POOL_MAX_BUFFERS_PER_SIZE_CLASS.
+  int32_t buffer_count;
+} az_http_response_pool_size_class;
+
+/**
+ * @brief A fixed set of response buffers, carved from caller-provided memory, which concurrent
+ * requests check out and return, so that the memory used for responses is bounded by the number of
+ * requests in flight rather than by the number of requests sent.
+ *
+ * @details Buffers are checked out and returned without a lock, so requests may be sent and
+ * completed from different threads. The buffers of a size class are next to each other, and are
+ * reused first to last, which keeps the ones in use close together.
+ */
+struct az_http_response_pool
+{
+  struct
+  {
+    struct
+    {
+      uint8_t* buffers;
+      int32_t buffer_size;
+      int32_t buffer_count;
+      uint64_t volatile in_use; // One bit per buffer, set while it is checked out.
+    } size_classes[AZ_HTTP_RESPONSE_POOL_MAX_SIZE_CLASSES];
+    int32_t size_class_count;
+  } _internal;
+};
+
+/**
+ * @brief Initializes an #az_http_response_pool over caller-provided memory.
+ *
+ * @param[out] out_pool The #az_http_response_pool to initialize.
+ * @param[in] memory The memory the buffers are carved from, which must outlive the pool. It must
+ * be at least the sum of the sizes of all the buffers.
+ * @param[in] size_classes The size classes, from the smallest buffers to the largest.
+ * @param[in] size_class_count The number of elements of \p size_classes, at most
+ * #AZ_HTTP_RESPONSE_POOL_MAX_SIZE_CLASSES.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p memory is too small for the buffers.
+ */
+AZ_NODISCARD az_result az_http_response_pool_init(
+    az_http_response_pool* out_pool,
+    az_span memory,
+    az_http_response_pool_size_class const* size_classes,
+    int32_t size_class_count);
+
+/**
+ * @brief Initializes an #az_http_response over a buffer checked out from an
+ * #az_http_response_pool.
+ *
+ * @details The buffer comes from the smallest size class which has a buffer of at least
+ * \p expected_size bytes available. If the response turns out to be larger, it is moved to a
+ * buffer of a larger size class as it arrives, and the smaller buffer is returned to the pool,
+ * through an allocator set with #az_http_response_set_allocator().
+ *
+ * @param[in,out] ref_pool The #az_http_response_pool to check the buffer out from.
+ * @param[in] expected_size The number of bytes the response is expected to need, or `0` for the
+ * smallest buffer available.
+ * @param[out] out_response The #az_http_response to initialize. It must not be moved or copied
+ * until it is returned to the pool with #az_http_response_pool_return().
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE Every buffer of at least \p expected_size bytes is checked
+ * out.
+ */
+AZ_NODISCARD az_result az_http_response_pool_checkout(
+    az_http_response_pool* ref_pool,
+    int32_t expected_size,
+    az_http_response* out_response);
+
+/**
+ * @brief Returns the buffer of an #az_http_response to the #az_http_response_pool it was checked
+ * out from.
+ *
+ * @param[in,out] ref_pool The #az_http_response_pool the buffer was checked out from.
+ * @param[in,out] ref_response The #az_http_response initialized by
+ * #az_http_response_pool_checkout(). It is left with an empty buffer, so the spans parsed from it
+ * must no longer be used.
+ */
+void az_http_response_pool_return(az_http_response_pool* ref_pool, az_http_response* ref_response);
+
+/// The most distinct requests an #az_http_request_coalescer can share the response of at once.
+#define AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT 8
+
+/// The largest method, URL and headers of a request an #az_http_request_coalescer compares.
+#define AZ_HTTP_REQUEST_COALESCER_MAX_KEY_SIZE 1024
+
+typedef struct
+{
+  struct
+  {
+    uint8_t key[AZ_HTTP_REQUEST_COALESCER_MAX_KEY_SIZE];
+    int32_t key_size;
+    void const* credential; // The credential the request is authorized with.
+    bool is_in_use;
+    bool is_done;
+    int32_t waiter_count; // The requests waiting to copy the response.
+    az_result result;
+    az_http_response const* response; // The response of the request which is sent.
+  } _internal;
+} _az_http_request_coalescer_flight;
+
+/**
+ * @brief Lets identical `GET` and `HEAD` requests, sent from several threads through the
+ * pipelines of SDK clients, share the response of the one which is already in flight.
+ *
+ * @details A request is identical to another one when its method, URL and headers are the same,
+ * and it is sent by a client with the same credential, so that a response is never shared with a
+ * client which isn't authorized to get it.
+ * When a request arrives while an identical one is in flight, it waits for that one to complete,
+ * and its #az_http_response gets a copy of the same response, or the same failed #az_result. The
+ * requests which don't fit #AZ_HTTP_REQUEST_COALESCER_MAX_KEY_SIZE, the ones whose response body
+ * goes to a sink, and the ones arriving while #AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT distinct
+ * requests are in flight are sent as usual.
+ */
+typedef struct
+{
+  struct
+  {
+    uint64_t volatile lock;
+    _az_http_request_coalescer_flight flights[AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT];
+  } _internal;
+} az_http_request_coalescer;
+
+/**
+ * @brief Initializes an #az_http_request_coalescer, which the clients sharing it must not outlive.
+ *
+ * @param[out] out_coalescer The #az_http_request_coalescer to initialize.
+ */
+void az_http_request_coalescer_init(az_http_request_coalescer* out_coalescer);
+
+/// The most responses an #az_http_response_cache can hold.
+#define AZ_HTTP_RESPONSE_CACHE_MAX_ENTRIES 16
+
+/// The largest URL and headers of a request an #az_http_response_cache looks responses up by.
+#define AZ_HTTP_RESPONSE_CACHE_MAX_KEY_SIZE 1024
+
+/// The largest `ETag` of a response an #az_http_response_cache holds.
+#define AZ_HTTP_RESPONSE_CACHE_MAX_ETAG_SIZE 128
+
+typedef struct
+{
+  struct
+  {
+    uint8_t* buffer; // The key of the request, followed by the response.
+    int32_t key_size;
+    int32_t response_size;
+    uint8_t etag[AZ_HTTP_RESPONSE_CACHE_MAX_ETAG_SIZE];
+    int32_t etag_size;
+    uint64_t last_used; // The use count of the cache when the entry was last stored or served.
+  } _internal;
+} _az_http_response_cache_entry;
+
+/**
+ * @brief Keeps the responses to `GET` requests which have an `ETag`, so that sending the same
+ * request again only transfers the response when it changed.
+ *
+ * @details The pipeline policy sends a request for a cached response with an `If-None-Match`
+ * header, and when the service answers `304 Not Modified`, the caller gets a copy of the cached
+ * response instead. A response is cached with its status line and headers, for the request with
+ * the same URL and headers, in one of the slots the caller-provided memory is split into. When
+ * every slot is in use, the least recently used response is replaced. Responses which don't fit a
+ * slot, or don't have an `ETag`, aren't cached.
+ *
+ * The cache can be shared by the clients which send requests from several threads.
+ */
+typedef struct
+{
+  struct
+  {
+    uint64_t volatile lock;
+    int32_t slot_size;
+    int32_t entry_count;
+    uint64_t use_count;
+    _az_http_response_cache_entry entries[AZ_HTTP_RESPONSE_CACHE_MAX_ENTRIES];
+  } _internal;
+} az_http_response_cache;
+
+/**
+ * @brief Initializes an #az_http_response_cache over caller-provided memory.
+ *
+ * @param[out] out_cache The #az_http_response_cache to initialize.
+ * @param[in] memory The memory the slots are carved from, which must outlive the cache. Each slot
+ * holds the key of a request, as long as its URL and headers, followed by its response.
+ * @param[in] slot_count The number of slots \p memory is split into, at most
+ * #AZ_HTTP_RESPONSE_CACHE_MAX_ENTRIES.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p memory has less than one byte for each slot.
+ */
+AZ_NODISCARD az_result
+az_http_response_cache_init(az_http_response_cache* out_cache, az_span memory, int32_t slot_count);
+
+/**
+ * @brief Allows you to customize an #az_http_rate_limiter.
+ */
+typedef struct
+{
+  /// The number of requests per second which can be sent on average. It must be greater than `0`.
+  int32_t requests_per_second;
+
+  /// The number of requests which can be sent at once after no request was sent for a while. It
+  /// must be at least `1`.
+  int32_t burst;
+
+  /// Whether the rate is halved each time the service answers `429 Too Many Requests` or
+  /// `503 Service Unavailable`, and raised back towards #requests_per_second by a sixteenth after
+  /// each other response. When such a response has a `Retry-After` header, no request is sent
+  /// until it has passed.
+  bool is_adaptive;
+} az_http_rate_limiter_options;
+
+/**
+ * @brief Gets the default #az_http_rate_limiter_options, which allow 100 requests per second in
+ * bursts of 10, and adapt the rate to the throttling responses.
+ *
+ * @return An #az_http_rate_limiter_options.
+ */
+AZ_NODISCARD AZ_INLINE az_http_rate_limiter_options az_http_rate_limiter_options_default()
+{
+  return (az_http_rate_limiter_options){
+    .requests_per_second = 100,
+    .burst = 10,
+    .is_adaptive = true,
+  };
+}
+
+/**
+ * @brief A token bucket which paces the requests SDK clients send, so that they stay under the
+ * rate a service accepts instead of being throttled and retried.
+ *
+ * @details Each attempt to send a request takes a token, and waits for one when there are none
+ * left. The bucket is refilled at the current rate, up to its burst, from the time
+ * #az_platform_clock_msec() returns. The state is updated with compare-and-swap operations, so the
+ * limiter can be shared by the clients which send requests from several threads.
+ */
+typedef struct
+{
+  struct
+  {
+    az_http_rate_limiter_options options;
+    // When the bucket will be full again, in microseconds of az_platform_clock_msec() time, as the
+    // generic cell rate algorithm keeps a token bucket in a single value.
+    uint64_t volatile full_at_usec;
+    uint64_t volatile requests_per_second; // The current rate, lowered by throttling responses.
+  } _internal;
+} az_http_rate_limiter;
+
+/**
+ * @brief Initializes an #az_http_rate_limiter with a full bucket.
+ *
+ * @param[out] out_limiter The #az_http_rate_limiter to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_http_rate_limiter_options structure. If
+ * `NULL` is passed, the limiter will use the default options (i.e.
+ * #az_http_rate_limiter_options_default()).
+ */
+void az_http_rate_limiter_init(
+    az_http_rate_limiter* out_limiter,
+    az_http_rate_limiter_options const* options);
+
+/// The number of hosts an #az_http_circuit_breaker tracks.
+#define AZ_HTTP_CIRCUIT_BREAKER_MAX_HOSTS 16
+
+/// The size of the longest host name an #az_http_circuit_breaker tracks.
+#define AZ_HTTP_CIRCUIT_BREAKER_MAX_HOST_SIZE 256
+
+/**
+ * @brief Allows you to customize an #az_http_circuit_breaker.
+ */
+typedef struct
+{
+  /// The percentage of the requests sent to a host which must fail for its circuit to open.
+  int32_t failure_percent_threshold;
+
+  /// The number of requests which must have been sent to a host during the last #window_msec
+  /// before its circuit can open.
+  int32_t minimum_request_count;
+
+  /// How far back, in milliseconds, the failure rate of a host is measured.
+  int32_t window_msec;
+
+  /// How long, in milliseconds, the circuit of a host stays open before a trial request is sent.
+  int32_t break_msec;
+} az_http_circuit_breaker_options;
+
+/**
+ * @brief Gets the default #az_http_circuit_breaker_options, which open the circuit of a host when
+ * at least half of the last 10 seconds of requests to it failed, with at least 10 of them, and send
+ * a trial request after 30 seconds.
+ *
+ * @return An #az_http_circuit_breaker_options.
+ */
+AZ_NODISCARD AZ_INLINE az_http_circuit_breaker_options az_http_circuit_breaker_options_default()
+{
+  return (az_http_circuit_breaker_options){
+    .failure_percent_threshold = 50,
+    .minimum_request_count = 10,
+    .window_msec = 10000,
+    .break_msec = 30000,
+  };
+}
+
+/**
+ * @brief The state of one host of an #az_http_circuit_breaker.
+ */
+typedef struct
+{
+  struct
+  {
+    uint8_t host[AZ_HTTP_CIRCUIT_BREAKER_MAX_HOST_SIZE];
+    int32_t host_size;
+    // The requests of the current window, and those of the previous one, which are counted in
+    // proportion to how much of it is still within #window_msec.
+    int64_t window_start_msec;
+    int32_t request_count;
+    int32_t failure_count;
+    int32_t previous_request_count;
+    int32_t previous_failure_count;
+    int64_t opened_at_msec;
+    bool is_open;
+    bool is_probing; // Whether the trial request of an open circuit is in flight.
+  } _internal;
+} _az_http_circuit_breaker_host;
+
+/**
+ * @brief Tracks the failure rate of the requests SDK clients send to each host, and fails the
+ * requests to a host which is failing instead of sending them.
+ *
+ * @details A request fails when it can't be sent or when the service answers
+ * `408 Request Timeout`, `500 Internal Server Error`, `502 Bad Gateway`,
+ * `503 Service Unavailable` or `504 Gateway Timeout`. Once enough of the requests to a host
+ * failed, its circuit opens, and the requests to it fail with #AZ_ERROR_HTTP_CIRCUIT_OPEN. After
+ * az_http_circuit_breaker_options.break_msec, one trial request is sent: the circuit closes if it
+ * succeeds, and stays open for another break otherwise. The breaker may be shared by the clients
+ * which send requests from several threads. The requests to hosts beyond the first
+ * #AZ_HTTP_CIRCUIT_BREAKER_MAX_HOSTS are sent without being tracked.
+ */
+typedef struct
+{
+  struct
+  {
+    az_http_circuit_breaker_options options;
+    uint64_t volatile lock;
+    int32_t host_count;
+    _az_http_circuit_breaker_host hosts[AZ_HTTP_CIRCUIT_BREAKER_MAX_HOSTS];
+  } _internal;
+} az_http_circuit_breaker;
+
+/**
+ * @brief Initializes an #az_http_circuit_breaker, with the circuits of all hosts closed.
+ *
+ * @param[out] out_breaker The #az_http_circuit_breaker to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_http_circuit_breaker_options structure.
+ * If `NULL` is passed, the breaker will use the default options (i.e.
+ * #az_http_circuit_breaker_options_default()).
+ */
+void az_http_circuit_breaker_init(
+    az_http_circuit_breaker* out_breaker,
+    az_http_circuit_breaker_options const* options);
+
+/// The size of a W3C trace ID, in bytes.
+#define AZ_HTTP_TRACE_ID_SIZE 16
+
+/// The size of a W3C span ID, in bytes.
+#define AZ_HTTP_TRACE_SPAN_ID_SIZE 8
+
+/// The size of a W3C `traceparent` header value, such as
+/// `00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01`.
+#define AZ_HTTP_TRACEPARENT_SIZE 55
+
+/**
+ * @brief Identifies an operation within a distributed trace, as the W3C `traceparent` header
+ * does.
+ *
+ * @details The IDs are kept as bytes, and only formatted when
+ * #az_http_trace_context_get_traceparent() is called.
+ */
+typedef struct
+{
+  uint8_t trace_id[AZ_HTTP_TRACE_ID_SIZE]; ///< The ID of the trace the operation belongs to.
+  uint8_t span_id[AZ_HTTP_TRACE_SPAN_ID_SIZE]; ///< The ID of the operation.
+  bool is_sampled; ///< Whether the operation, and the requests sent for it, are recorded.
+} az_http_trace_context;
+
+/**
+ * @brief Creates a new #az_context node, child of \p parent, which carries \p trace_context, so
+ * that the requests sent with it are traced as operations of \p trace_context.
+ *
+ * @param[in] parent The #az_context node that is the parent to the new node.
+ * @param[in] trace_context The #az_http_trace_context of the operation the requests are sent for.
+ * It must stay valid as long as the new node is used.
+ *
+ * @return The new child #az_context node.
+ */
+AZ_NODISCARD az_context
+az_http_trace_context_create(az_context const* parent, az_http_trace_context const* trace_context);
+
+/**
+ * @brief Formats an #az_http_trace_context as the value of a W3C `traceparent` header.
+ *
+ * @param[in] trace_context The #az_http_trace_context to format.
+ * @param[in] buffer An #az_span to write the value to.
+ * @param[out] out_traceparent A pointer to an #az_span which receives the value, the first
+ * #AZ_HTTP_TRACEPARENT_SIZE bytes of \p buffer.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p buffer is smaller than #AZ_HTTP_TRACEPARENT_SIZE.
+ */
+AZ_NODISCARD az_result az_http_trace_context_get_traceparent(
+    az_http_trace_context const* trace_context,
+    az_span buffer,
+    az_span* out_traceparent);
+
+/**
+ * @brief What the tracing policy recorded about one request.
+ */
+typedef struct
+{
+  /// The trace the request belongs to, and the span ID it was sent with.
+  az_http_trace_context context;
+
+  /// The span ID of the operation the request was sent for, or zeros when it started a trace.
+  uint8_t parent_span_id[AZ_HTTP_TRACE_SPAN_ID_SIZE];
+
+  int64_t start_msec; ///< When the request went into the pipeline, from #az_platform_clock_msec().
+  int64_t end_msec; ///< When its response, or failure, came back out of it.
+  az_http_status_code status_code; ///< The status code of the last response, if there was one.
+  az_result result; ///< The result the pipeline returned.
+} az_http_trace_span;
+
+/**
+ * @brief Allows you to customize an #az_http_tracer.
+ */
+typedef struct
+{
+  /// Which of the traces the requests start are sampled: one in #sample_one_in of them. `1`
+  /// samples every trace, and `0` none. A request sent for an operation with an
+  /// #az_http_trace_context is sampled if that operation is.
+  int32_t sample_one_in;
+
+  /// The seed of the IDs the tracer generates. If `0`, it is seeded from the clock.
+  uint64_t seed;
+} az_http_tracer_options;
+
+/**
+ * @brief Gets the default #az_http_tracer_options, which sample every trace.
+ *
+ * @return An #az_http_tracer_options.
+ */
+AZ_NODISCARD AZ_INLINE az_http_tracer_options az_http_tracer_options_default()
+{
+  return (az_http_tracer_options){
+    .sample_one_in = 1,
+    .seed = 0,
+  };
+}
+
+/**
+ * @brief Sends a W3C `traceparent` header with each sampled request SDK clients send, and records
+ * an #az_http_trace_span of it in a buffer the caller provides.
+ *
+ * @details The span of a request is recorded once its response came back, so the spans are only
+ * complete once the requests sent through the tracer have. When the buffer is full, the next spans
+ * are dropped. A request which isn't sampled is sent without a `traceparent` header, and costs
+ * the tracer a lookup in the #az_context of the request and, for the requests which start a trace,
+ * a random number. The tracer may be shared by the clients which send requests from several
+ * threads.
+ */
+typedef struct
+{
+  struct
+  {
+    az_http_tracer_options options;
+    az_http_trace_span* spans;
+    int32_t span_capacity;
+    uint64_t volatile random_state; // xorshift64* state, advanced with compare-and-swap.
+    uint64_t volatile span_count; // The number of spans recorded or dropped.
+  } _internal;
+} az_http_tracer;
+
+/**
+ * @brief Initializes an #az_http_tracer.
+ *
+ * @param[out] out_tracer The #az_http_tracer to initialize.
+ * @param[in] spans __[nullable]__ The buffer to record the #az_http_trace_span of each sampled
+ * request in. If `NULL`, the requests are sent with `traceparent` headers, and nothing is recorded.
+ * @param[in] span_capacity The number of #az_http_trace_span that fit in \p spans.
+ * @param[in] options __[nullable]__ A reference to an #az_http_tracer_options structure. If `NULL`
+ * is passed, the tracer will use the default options (i.e. #az_http_tracer_options_default()).
+ */
+void az_http_tracer_init(
+    az_http_tracer* out_tracer,
+    az_http_trace_span* spans,
+    int32_t span_capacity,
+    az_http_tracer_options const* options);
+
+/**
+ * @brief Starts a new trace, for an operation of the application which sends requests.
+ *
+ * @details Pass the #az_http_trace_context to #az_http_trace_context_create() to send the requests
+ * of the operation as part of the trace.
+ *
+ * @param[in,out] ref_tracer The #az_http_tracer which generates the IDs and samples the trace.
+ * @param[out] out_trace_context The #az_http_trace_context of the operation.
+ */
+void az_http_tracer_start_trace(
+    az_http_tracer* ref_tracer,
+    az_http_trace_context* out_trace_context);
+
+/**
+ * @brief Gets the number of #az_http_trace_span the tracer recorded in its buffer.
+ *
+ * @param[in] tracer The #az_http_tracer.
+ *
+ * @return The number of spans at the start of the buffer, at most its capacity.
+ */
+AZ_NODISCARD int32_t az_http_tracer_get_span_count(az_http_tracer const* tracer);
+
 /**
  * @brief Represents the result of making an HTTP request.
  * An application obtains this initialized structure by calling #az_http_response_get_status_line().
@@ -267,6 +1044,212 @@ AZ_NODISCARD az_result az_http_response_get_next_header(
  */
 AZ_NODISCARD az_result az_http_response_get_body(az_http_response* ref_response, az_span* out_body);
 
+/**
+ * @brief A name/value pair of an HTTP response header, within the buffer of the response.
+ */
+typedef struct
+{
+  az_span name; ///< Name.
+  az_span value; ///< Value.
+} az_http_response_header;
+
+/**
+ * @brief The headers of an HTTP response, parsed once by #az_http_response_parse_headers() so
+ * that they can be looked up any number of times.
+ */
+typedef struct
+{
+  struct
+  {
+    az_http_response_header const* headers;
+    int32_t count;
+  } _internal;
+} az_http_response_headers;
+
+/**
+ * @brief Parses all the headers of an HTTP response into a caller-provided array.
+ *
+ * @details The parsing state of \p response isn't changed, so this can be called at any time after
+ * the response is received. The spans of the headers point into the buffer of the \p response, so
+ * they are valid as long as it is.
+ *
+ * @param[in] response A pointer to an #az_http_response instance.
+ * @param[out] headers The array which receives the headers.
+ * @param[in] headers_capacity The number of elements of \p headers.
+ * @param[out] out_headers A pointer to an #az_http_response_headers to initialize over
+ * \p headers.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK All the headers were parsed.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The response has more than \p headers_capacity headers.
+ * @retval other The HTTP response status line or headers are invalid.
+ */
+AZ_NODISCARD az_result az_http_response_parse_headers(
+    az_http_response const* response,
+    az_http_response_header* headers,
+    int32_t headers_capacity,
+    az_http_response_headers* out_headers);
+
+/**
+ * @brief Returns the number of headers parsed by #az_http_response_parse_headers().
+ *
+ * @param[in] headers A pointer to an #az_http_response_headers instance.
+ *
+ * @return The number of headers.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_http_response_headers_count(az_http_response_headers const* headers)
+{
+  return headers->_internal.count;
+}
+
+/**
+ * @brief Gets the value of the first header with the specified name.
+ *
+ * @param[in] headers A pointer to an #az_http_response_headers instance.
+ * @param[in] name The name of the header, which is compared ignoring case.
+ * @param[out] out_value A pointer to an #az_span to receive the header's value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The header was found.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND There is no header with this \p name.
+ */
+AZ_NODISCARD az_result az_http_response_headers_find(
+    az_http_response_headers const* headers,
+    az_span name,
+    az_span* out_value);
+
+/**
+ * @brief A view of an HTTP request the SDK is about to send, or of a response it received, which is
+ * passed to an #az_http_log_message_fn instead of a formatted log message.
+ *
+ * @details The callback only reads, and formats, the parts of the request or response it needs.
+ */
+typedef struct
+{
+  struct
+  {
+    void const* request;
+    az_http_response const* response;
+    az_http_response response_reader;
+    bool status_line_read;
+    int64_t duration_msec;
+  } _internal;
+} az_http_log_message;
+
+/**
+ * @brief Defines the callback which receives the HTTP requests and responses the SDK logs, without
+ * formatting them into text.
+ *
+ * @param[in] classification #AZ_LOG_HTTP_REQUEST or #AZ_LOG_HTTP_RESPONSE.
+ * @param[in,out] message The request or response. It is only valid for the duration of the call.
+ */
+typedef void (*az_http_log_message_fn)(
+    az_log_classification classification,
+    az_http_log_message* message);
+
+/**
+ * @brief Sets the function that will be invoked with the HTTP requests and responses the SDK logs.
+ *
+ * @param[in] http_log_message_callback __[nullable]__ A pointer to the function that will be
+ * invoked for the #AZ_LOG_HTTP_REQUEST and #AZ_LOG_HTTP_RESPONSE classifications passed to
+ * #az_log_set_classifications(). These messages are then no longer formatted for the callback set
+ * with #az_log_set_callback(). If `NULL`, they are formatted again.
+ */
+#ifndef AZ_NO_LOGGING
+void az_http_log_set_message_callback(az_http_log_message_fn http_log_message_callback);
+#else
+AZ_INLINE void az_http_log_set_message_callback(az_http_log_message_fn http_log_message_callback)
+{
+  (void)http_log_message_callback;
+}
+#endif // AZ_NO_LOGGING
+
+/**
+ * @brief Gets the method and URL of the request of an #az_http_log_message.
+ *
+ * @param[in] message The #az_http_log_message passed to the #az_http_log_message_fn.
+ * @param[out] out_method A pointer to an #az_span to receive the HTTP method.
+ * @param[out] out_url A pointer to an #az_span to receive the URL.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_http_log_message_get_request(
+    az_http_log_message const* message,
+    az_span* out_method,
+    az_span* out_url);
+
+/**
+ * @brief Gets a header of the request of an #az_http_log_message by index.
+ *
+ * @param[in] message The #az_http_log_message passed to the #az_http_log_message_fn.
+ * @param[in] index Index of the HTTP header to get.
+ * @param[out] out_name A pointer to an #az_span to receive the header's name.
+ * @param[out] out_value A pointer to an #az_span to receive the header's value. The value of the
+ * `authorization` header is always empty.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ARG \p index is out of range.
+ */
+AZ_NODISCARD az_result az_http_log_message_get_request_header(
+    az_http_log_message const* message,
+    int32_t index,
+    az_span* out_name,
+    az_span* out_value);
+
+/**
+ * @brief Gets the time, in milliseconds, the SDK waited for the response of an
+ * #az_http_log_message.
+ *
+ * @param[in] message The #az_http_log_message passed to the #az_http_log_message_fn.
+ *
+ * @return The duration, or `0` for an #AZ_LOG_HTTP_REQUEST message.
+ */
+AZ_NODISCARD AZ_INLINE int64_t
+az_http_log_message_get_duration_msec(az_http_log_message const* message)
+{
+  return message->_internal.duration_msec;
+}
+
+/**
+ * @brief Gets the status line of the response of an #az_http_log_message.
+ *
+ * @param[in,out] message The #az_http_log_message passed to the #az_http_log_message_fn.
+ * @param[out] out_status_line The pointer to an #az_http_response_status_line structure to be
+ * filled in by this function.
+ *
+ * @details The next call to #az_http_log_message_get_next_response_header() returns the first
+ * header of the response again.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The message is for an #AZ_LOG_HTTP_REQUEST.
+ * @retval other HTTP response was not parsed.
+ */
+AZ_NODISCARD az_result az_http_log_message_get_status_line(
+    az_http_log_message* message,
+    az_http_response_status_line* out_status_line);
+
+/**
+ * @brief Returns the next header of the response of an #az_http_log_message.
+ *
+ * @param[in,out] message The #az_http_log_message passed to the #az_http_log_message_fn.
+ * @param[out] out_name A pointer to an #az_span to receive the header's name.
+ * @param[out] out_value A pointer to an #az_span to receive the header's value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK A header was returned.
+ * @retval #AZ_ERROR_HTTP_END_OF_HEADERS There are no more headers within the HTTP response.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The message is for an #AZ_LOG_HTTP_REQUEST.
+ * @retval other HTTP response was not parsed.
+ */
+AZ_NODISCARD az_result az_http_log_message_get_next_response_header(
+    az_http_log_message* message,
+    az_span* out_name,
+    az_span* out_value);
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_HTTP_H
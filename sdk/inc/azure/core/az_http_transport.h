@@ -62,14 +62,62 @@ typedef struct
 {
   az_span name; ///< Name.
   az_span value; ///< Value.
+  int32_t name_hash; ///< Case-insensitive hash of the name, see #az_http_header_id.
 } _az_http_request_header;
 
+/**
+ * @brief Identifies the HTTP request headers which policies and transport adapters often look up.
+ *
+ * @details Each value is the hash of the header name which is stored with every header of an
+ * #az_http_request, so #az_http_request_get_header_by_id() only compares the name of a header
+ * whose hash matches.
+ */
+typedef enum
+{
+  AZ_HTTP_HEADER_ID_AUTHORIZATION = 0x113657BE, ///< `Authorization`.
+  AZ_HTTP_HEADER_ID_CONTENT_LENGTH = 0x4DF9451D, ///< `Content-Length`.
+  AZ_HTTP_HEADER_ID_CONTENT_TYPE = 0x7CF70995, ///< `Content-Type`.
+  AZ_HTTP_HEADER_ID_X_MS_CLIENT_REQUEST_ID = 0x16BB3CA0, ///< `x-ms-client-request-id`.
+  AZ_HTTP_HEADER_ID_X_MS_DATE = 0x23110495, ///< `x-ms-date`.
+  AZ_HTTP_HEADER_ID_X_MS_VERSION = 0x291FC2A3, ///< `x-ms-version`.
+} az_http_header_id;
+
 /**
  * @brief A type representing a buffer of #_az_http_request_header instances for HTTP request
  * headers.
  */
 typedef az_span _az_http_request_headers;
 
+/**
+ * @brief Defines the callback signature used to provide the body of an #az_http_request in chunks,
+ * as it is being sent, instead of from a single contiguous buffer.
+ *
+ * @param[in] user_context The user context given to #az_http_request_set_body_provider().
+ * @param[in] offset The position, within the body, of the first byte to provide. It goes back to
+ * `0` when the request is sent again (i.e. when it is retried).
+ * @param[out] destination The buffer to fill with the body bytes starting at \p offset.
+ * @param[out] out_size The number of bytes written to \p destination. It must be greater than `0`,
+ * since the body is never read past its size. When the size of the body is
+ * #AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN, it is `0` once the whole body was provided.
+ *
+ * @return An #az_result value indicating the result of the operation. Any failure aborts sending
+ * the request.
+ */
+/**
+ * @brief The size of the body of an #az_http_request whose body provider can't tell how large the
+ * body is before providing it, such as one generating it as it is sent.
+ *
+ * @details Transport adapters send such a body with chunked transfer coding, instead of with a
+ * `Content-Length` header, until the body provider provides no more bytes.
+ */
+#define AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN (-1)
+
+typedef AZ_NODISCARD az_result (*az_http_request_body_provider_fn)(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size);
+
 /**
  * @brief Structure used to represent an HTTP request.
  * It contains an HTTP method, URL, headers and body. It also contains
@@ -89,9 +137,26 @@ typedef struct
     int32_t max_headers;
     int32_t retry_headers_start_byte_offset;
     az_span body;
+    az_http_request_body_provider_fn body_provider;
+    void* body_provider_user_context;
+    int64_t body_provider_size;
+    az_span const* body_segments;
+    int32_t body_segment_count;
   } _internal;
 } az_http_request;
 
+/**
+ * @brief Tracks how much of the body of an #az_http_request a transport adapter has sent.
+ */
+typedef struct
+{
+  struct
+  {
+    az_http_request const* request;
+    int64_t offset;
+  } _internal;
+} _az_http_request_body_reader;
+
 /**
  * @brief Used to declare policy process callback #_az_http_policy_process_fn definition.
  */
@@ -142,6 +207,38 @@ AZ_NODISCARD az_result az_http_request_get_header(
     az_span* out_name,
     az_span* out_value);
 
+/**
+ * @brief Gets the value of the first HTTP header with the specified name.
+ *
+ * @param[in] request HTTP request to get HTTP header from.
+ * @param[in] name The name of the HTTP header, which is compared ignoring case.
+ * @param[out] out_value A pointer to an #az_span to write the header's value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The \p request has no header with this \p name.
+ */
+AZ_NODISCARD az_result az_http_request_get_header_by_name(
+    az_http_request const* request,
+    az_span name,
+    az_span* out_value);
+
+/**
+ * @brief Gets the value of the first HTTP header of a well-known name.
+ *
+ * @param[in] request HTTP request to get HTTP header from.
+ * @param[in] id The #az_http_header_id of the HTTP header.
+ * @param[out] out_value A pointer to an #az_span to write the header's value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The \p request has no header with this \p id.
+ */
+AZ_NODISCARD az_result az_http_request_get_header_by_id(
+    az_http_request const* request,
+    az_http_header_id id,
+    az_span* out_value);
+
 /**
  * @brief Get method of an HTTP request.
  *
@@ -185,6 +282,43 @@ AZ_NODISCARD az_result az_http_request_get_url(az_http_request const* request, a
  */
 AZ_NODISCARD az_result az_http_request_get_body(az_http_request const* request, az_span* out_body);
 
+/**
+ * @brief Get the size of the body of an HTTP request, whether it comes from a buffer or from a body
+ * provider (see #az_http_request_body_provider_fn).
+ *
+ * @remarks This function is expected to be used by transport layer only.
+ *
+ * @param[in] request The HTTP request from which to get the body size.
+ *
+ * @return The size of the request body, in bytes, or #AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN when the
+ * body provider can't tell it before providing the body.
+ */
+AZ_NODISCARD int64_t az_http_request_get_body_size(az_http_request const* request);
+
+/**
+ * @brief Reads the next chunk of the body of an HTTP request, whether it comes from a buffer or
+ * from a body provider (see #az_http_request_body_provider_fn).
+ *
+ * @remarks This function is expected to be used by transport layer only.
+ *
+ * @param[in] request The HTTP request from which to read the body.
+ * @param[in] offset The position, within the body, of the first byte to read.
+ * @param[out] destination The buffer where the body bytes will be written.
+ * @param[out] out_size The number of bytes written to \p destination, which is `0` once the whole
+ * body has been read.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_UNEXPECTED_END The body provider stopped providing bytes before the end of the
+ * body.
+ * @retval other The body provider failed.
+ */
+AZ_NODISCARD az_result az_http_request_read_body(
+    az_http_request const* request,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size);
+
 /**
  * @brief This function is expected to be used by transport adapters like curl. Use it to write
  * content from \p source to \p ref_response.
@@ -230,6 +364,365 @@ AZ_NODISCARD int32_t az_http_request_headers_count(az_http_request const* reques
 AZ_NODISCARD az_result
 az_http_client_send_request(az_http_request const* request, az_http_response* ref_response);
 
+/**
+ * @brief Enables connection reuse for #az_http_client_send_request(), so that requests sent through
+ * an HTTP pipeline can pick up keep-alive connections, cached DNS lookups and TLS sessions from
+ * previous requests, instead of paying for a new connection and handshake every time.
+ *
+ * @remarks Call #az_http_client_connection_reuse_cleanup() to release the cached connections.
+ *
+ * @remarks When connection reuse is enabled, #az_http_client_send_request() can be called from
+ * several threads at once. The libcurl adapter keeps up to 8 connections alive for the requests
+ * sent at the same time, and sends any further one on a connection of its own. This function and
+ * #az_http_client_connection_reuse_cleanup() must not be called while requests are being sent.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success, or connection reuse was already enabled.
+ * @retval #AZ_ERROR_OUT_OF_MEMORY The connection cache could not be allocated.
+ * @retval #AZ_ERROR_DEPENDENCY_NOT_PROVIDED The HTTP transport adapter does not support connection
+ * reuse.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any other issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result az_http_client_connection_reuse_init();
+
+/**
+ * @brief Closes any connection kept alive by #az_http_client_connection_reuse_init() and goes back
+ * to using a new connection for every request.
+ *
+ * @remarks It is safe to call this function when connection reuse is not enabled.
+ */
+void az_http_client_connection_reuse_cleanup();
+
+/**
+ * @brief Writes the TLS sessions cached by connection reuse to \p destination, so that a later
+ * process can resume them with #az_http_client_tls_sessions_import() and skip the full TLS
+ * handshake.
+ *
+ * @details The sessions are written in a format private to the HTTP transport adapter, which the
+ * caller stores as it is, such as in a file. They are as sensitive as the connections they resume.
+ *
+ * @param[out] destination The buffer to write the sessions to.
+ * @param[out] out_sessions The part of \p destination which was written to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success. No sessions are written if connection reuse is not enabled.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The sessions don't fit \p destination.
+ * @retval #AZ_ERROR_DEPENDENCY_NOT_PROVIDED The HTTP transport adapter can't export TLS sessions.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any other issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result
+az_http_client_tls_sessions_export(az_span destination, az_span* out_sessions);
+
+/**
+ * @brief Enables connection reuse and adds the TLS sessions written by
+ * #az_http_client_tls_sessions_export() to its cache, so that the first connection to each host
+ * resumes its session.
+ *
+ * @param[in] sessions The sessions, as written by #az_http_client_tls_sessions_export().
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success. Sessions which the TLS library rejects, such as expired ones, are
+ * skipped.
+ * @retval #AZ_ERROR_UNEXPECTED_END \p sessions is truncated or corrupted.
+ * @retval #AZ_ERROR_DEPENDENCY_NOT_PROVIDED The HTTP transport adapter can't import TLS sessions.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any other issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result az_http_client_tls_sessions_import(az_span sessions);
+
+/**
+ * @brief Used to declare #az_http_client_async_operation.
+ */
+// Definition is below.
+typedef struct az_http_client_async_operation az_http_client_async_operation;
+
+/**
+ * @brief An HTTP request in flight on an #az_http_client_async, started with
+ * #az_http_client_async_submit().
+ *
+ * @remarks The operation, and the #az_http_request and #az_http_response it was submitted with,
+ * must stay alive until the operation completes.
+ */
+struct az_http_client_async_operation
+{
+  struct
+  {
+    void* easy_handle;
+    void* headers;
+    az_span post_body;
+    _az_http_request_body_reader upload_body;
+    az_result result;
+    bool completed;
+    az_http_client_async_operation* next;
+  } _internal;
+};
+
+/**
+ * @brief The activity an #az_http_client_async waits for on a socket.
+ */
+typedef enum
+{
+  AZ_HTTP_CLIENT_ASYNC_SOCKET_NONE = 0, ///< The socket is no longer used, stop watching it.
+  AZ_HTTP_CLIENT_ASYNC_SOCKET_IN = 1, ///< Wait for the socket to be readable.
+  AZ_HTTP_CLIENT_ASYNC_SOCKET_OUT = 2, ///< Wait for the socket to be writable.
+  AZ_HTTP_CLIENT_ASYNC_SOCKET_INOUT = 3, ///< Wait for the socket to be readable or writable.
+} az_http_client_async_socket_events;
+
+/**
+ * @brief Defines the callback an #az_http_client_async calls when the activity it waits for on a
+ * socket changes.
+ *
+ * @param[in] user_context The `callback_context` of the #az_http_client_async_options.
+ * @param[in] socket The socket: a file descriptor on POSIX, or a `SOCKET` on Windows.
+ * @param[in] events The activity to watch \p socket for, which replaces what was asked before, or
+ * #AZ_HTTP_CLIENT_ASYNC_SOCKET_NONE to stop watching it.
+ *
+ * @remarks The event loop calls #az_http_client_async_socket_action() when the activity happens.
+ */
+typedef void (*az_http_client_async_socket_fn)(
+    void* user_context,
+    intptr_t socket,
+    az_http_client_async_socket_events events);
+
+/**
+ * @brief Defines the callback an #az_http_client_async calls when the time it next needs to move
+ * its requests forward changes.
+ *
+ * @param[in] user_context The `callback_context` of the #az_http_client_async_options.
+ * @param[in] timeout_msec The milliseconds from now after which the event loop calls
+ * #az_http_client_async_timer_expired(), which replaces the time asked before, `0` to call it as
+ * soon as possible, or `-1` to cancel the timer.
+ *
+ * @remarks #az_http_client_async_timer_expired() must not be called from the callback itself.
+ */
+typedef void (*az_http_client_async_timer_fn)(void* user_context, int32_t timeout_msec);
+
+/**
+ * @brief Sends many HTTP requests concurrently from a single thread.
+ *
+ * @details Requests are started with #az_http_client_async_submit() and moved forward by calling
+ * #az_http_client_async_poll() until their #az_http_client_async_operation completes.
+ */
+typedef struct
+{
+  struct
+  {
+    void* multi_handle;
+    az_http_client_async_operation* operations;
+    int32_t pending_count;
+    bool use_http2;
+    az_http_client_async_socket_fn socket_callback;
+    az_http_client_async_timer_fn timer_callback;
+    void* callback_context;
+  } _internal;
+} az_http_client_async;
+
+/**
+ * @brief Allows the user to customize how an #az_http_client_async sends requests.
+ */
+typedef struct
+{
+  /// Whether to ask for HTTP/2 over TLS, so that concurrent requests to the same host are
+  /// multiplexed over one connection instead of each opening its own. Requests use HTTP/1.1 when
+  /// the server or the HTTP transport adapter doesn't support HTTP/2.
+  bool use_http2;
+
+  /// The most connections open to the same host at the same time, or 0 for no limit. Requests
+  /// over the limit wait for a connection, or for a stream on a multiplexed one.
+  int32_t max_host_connections;
+
+  /// When set with `timer_callback`, the client is driven by an event loop, such as one built on
+  /// epoll or libuv, instead of #az_http_client_async_poll(). The client tells the event loop the
+  /// sockets to watch through this callback.
+  az_http_client_async_socket_fn socket_callback;
+
+  /// When set with `socket_callback`, the client tells the event loop when to call
+  /// #az_http_client_async_timer_expired() through this callback.
+  az_http_client_async_timer_fn timer_callback;
+
+  /// The user context the callbacks are called with.
+  void* callback_context;
+} az_http_client_async_options;
+
+/**
+ * @brief Gets the default #az_http_client_async_options.
+ *
+ * @details Call this to obtain an initialized #az_http_client_async_options structure that can be
+ * afterwards modified and passed to #az_http_client_async_init().
+ *
+ * @return #az_http_client_async_options.
+ */
+AZ_NODISCARD AZ_INLINE az_http_client_async_options az_http_client_async_options_default()
+{
+  return (az_http_client_async_options){
+    .use_http2 = false,
+    .max_host_connections = 0,
+    .socket_callback = NULL,
+    .timer_callback = NULL,
+    .callback_context = NULL,
+  };
+}
+
+/**
+ * @brief Initializes an #az_http_client_async.
+ *
+ * @param[out] out_client The #az_http_client_async to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_http_client_async_options structure
+ * which defines custom behavior of the client. If `NULL` is passed, the client will use the
+ * default options (i.e. #az_http_client_async_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_OUT_OF_MEMORY The transport adapter could not allocate its resources.
+ * @retval #AZ_ERROR_DEPENDENCY_NOT_PROVIDED The HTTP transport adapter does not support sending
+ * requests asynchronously, or driving them from an event loop.
+ *
+ * @remarks When the options have a `socket_callback` and a `timer_callback`, the callbacks are
+ * given \p out_client, so it must not be moved or copied once initialized.
+ */
+AZ_NODISCARD az_result az_http_client_async_init(
+    az_http_client_async* out_client,
+    az_http_client_async_options const* options);
+
+/**
+ * @brief Starts sending \p request, without waiting for the response.
+ *
+ * @param[in,out] ref_client The #az_http_client_async to send the request with.
+ * @param[out] out_operation The #az_http_client_async_operation tracking the request.
+ * @param[in] request The #az_http_request to send.
+ * @param[in,out] ref_response The #az_http_response where the response will be written as it
+ * arrives.
+ *
+ * @remarks Policies such as API version, telemetry and credentials can be applied to \p request
+ * before submitting it. The result of the operation is the same #az_result value that
+ * #az_http_client_send_request() would have returned for the request.
+ *
+ * @remarks With the WinHTTP transport adapter, the request moves forward on the threads of the
+ * WinHTTP thread pool, which call the body provider of \p request and the body sink of
+ * \p ref_response.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The request was submitted.
+ * @retval #AZ_ERROR_OUT_OF_MEMORY The transport adapter could not allocate its resources.
+ * @retval #AZ_ERROR_HTTP_INVALID_METHOD_VERB The method of \p request is not supported.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any other issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result az_http_client_async_submit(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* out_operation,
+    az_http_request const* request,
+    az_http_response* ref_response);
+
+/**
+ * @brief Moves all the submitted requests forward, waiting up to \p timeout_msec for network
+ * activity, and completes the ones that are done.
+ *
+ * @param[in,out] ref_client The #az_http_client_async to poll.
+ * @param[in] timeout_msec Maximum time to wait for network activity, in milliseconds. Use `0` to
+ * never block.
+ * @param[out] out_pending_count __[nullable]__ The number of requests that are still in flight.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result az_http_client_async_poll(
+    az_http_client_async* ref_client,
+    int32_t timeout_msec,
+    int32_t* out_pending_count);
+
+/**
+ * @brief Moves forward the requests of an #az_http_client_async driven by an event loop, after
+ * the activity it waits for happened on \p socket, and completes the ones that are done.
+ *
+ * @param[in,out] ref_client The #az_http_client_async, initialized with a `socket_callback` and a
+ * `timer_callback`.
+ * @param[in] socket The socket given to the `socket_callback`.
+ * @param[in] events The activity which happened on \p socket, or
+ * #AZ_HTTP_CLIENT_ASYNC_SOCKET_NONE to let the client find out.
+ * @param[out] out_pending_count __[nullable]__ The number of requests that are still in flight.
+ *
+ * @remarks The callbacks may be called before this function returns. A client driven by an event
+ * loop must not also be moved forward with #az_http_client_async_poll().
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result az_http_client_async_socket_action(
+    az_http_client_async* ref_client,
+    intptr_t socket,
+    az_http_client_async_socket_events events,
+    int32_t* out_pending_count);
+
+/**
+ * @brief Moves forward the requests of an #az_http_client_async driven by an event loop, once the
+ * time given to the `timer_callback` has passed, and completes the ones that are done.
+ *
+ * @param[in,out] ref_client The #az_http_client_async, initialized with a `socket_callback` and a
+ * `timer_callback`.
+ * @param[out] out_pending_count __[nullable]__ The number of requests that are still in flight.
+ *
+ * @remarks This is how the requests submitted to the client are started, as the client asks for
+ * the timer as soon as they are.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_HTTP_ADAPTER Any issue from the transport adapter layer.
+ */
+AZ_NODISCARD az_result az_http_client_async_timer_expired(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count);
+
+/**
+ * @brief Abandons an #az_http_client_async_operation which is still in flight.
+ *
+ * @param[in,out] ref_client The #az_http_client_async the operation was submitted to.
+ * @param[in,out] ref_operation The #az_http_client_async_operation to abandon. It completes with
+ * #AZ_ERROR_CANCELED, unless it had already completed.
+ *
+ * @remarks Whatever the operation already wrote to its #az_http_response is left in place.
+ */
+void az_http_client_async_cancel(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* ref_operation);
+
+/**
+ * @brief Releases an #az_http_client_async.
+ *
+ * @remarks Any operation still in flight completes with #AZ_ERROR_CANCELED.
+ *
+ * @param[in,out] ref_client The #az_http_client_async to release.
+ */
+void az_http_client_async_cleanup(az_http_client_async* ref_client);
+
+/**
+ * @brief Checks whether an #az_http_client_async_operation has completed.
+ *
+ * @param[in] operation The #az_http_client_async_operation to check.
+ *
+ * @return `true` if the operation completed, `false` if it is still in flight.
+ */
+AZ_NODISCARD AZ_INLINE bool
+az_http_client_async_operation_is_completed(az_http_client_async_operation const* operation)
+{
+  return operation->_internal.completed;
+}
+
+/**
+ * @brief Gets the result of a completed #az_http_client_async_operation.
+ *
+ * @param[in] operation The completed #az_http_client_async_operation.
+ *
+ * @return The same #az_result value that #az_http_client_send_request() would have returned for the
+ * request, or #AZ_ERROR_CANCELED if the operation was abandoned by
+ * #az_http_client_async_cleanup().
+ */
+AZ_NODISCARD AZ_INLINE az_result
+az_http_client_async_operation_get_result(az_http_client_async_operation const* operation)
+{
+  return operation->_internal.result;
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_HTTP_TRANSPORT_H
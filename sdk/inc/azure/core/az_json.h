@@ -55,9 +55,23 @@ typedef struct
     // Each subsequent bit is the parent / containing type (object or array).
     uint64_t az_json_stack;
     int32_t current_depth;
+    // The states of the outermost containers, once more than 64 are nested, are spilled into this
+    // caller-provided buffer, one bit per depth. It is NULL when the depth is limited to 64.
+    uint8_t* overflow;
+    int32_t overflow_depth; // The number of additional depths the overflow buffer can hold.
   } _internal;
 } _az_json_bit_stack;
 
+/**
+ * @brief Computes the size, in bytes, of the nesting stack buffer to set in the
+ * #az_json_reader_options or #az_json_writer_options to read or write JSON that is nested up to
+ * \p max_depth objects and arrays deep.
+ *
+ * @remarks No buffer is needed for a maximum depth of 64 or less.
+ */
+#define AZ_JSON_NESTING_STACK_BUFFER_SIZE(max_depth) \
+  ((max_depth) > 64 ? (((max_depth)-64) + 7) / 8 : 0)
+
 /**
  * @brief Represents a JSON token. The kind field indicates the type of the JSON token and the slice
  * represents the portion of the JSON payload that points to the token value.
@@ -112,6 +126,17 @@ typedef struct
 
     /// The offset within the particular segment within which this token ends.
     int32_t end_buffer_offset;
+
+    /// A flag to indicate whether the number token is an integer whose magnitude fits in 64 bits,
+    /// read by an #az_json_reader with the `parse_integers` option. Only then integer_magnitude
+    /// and is_negative are set. It is meaningless for any other token kind.
+    bool has_integer_value;
+
+    /// A flag to indicate whether the integer number starts with a minus sign.
+    bool is_negative;
+
+    /// The absolute value of the integer number, accumulated while its digits were read.
+    uint64_t integer_magnitude;
   } _internal;
 } az_json_token;
 
@@ -221,6 +246,9 @@ AZ_NODISCARD az_result az_json_token_get_double(az_json_token const* json_token,
 /**
  * @brief Gets the JSON token's string after unescaping it, if required.
  *
+ * @details Escape sequences in the form of `\uXXXX` are unescaped into the UTF-8 encoding of the
+ * code point, and a surrogate pair of them is unescaped into the single code point it denotes.
+ *
  * @param[in] json_token A pointer to an #az_json_token instance.
  * @param destination A pointer to a buffer where the string should be copied into.
  * @param[in] destination_max_size The maximum available space within the buffer referred to by
@@ -233,6 +261,8 @@ AZ_NODISCARD az_result az_json_token_get_double(az_json_token const* json_token,
  * @retval #AZ_OK The string is returned.
  * @retval #AZ_ERROR_JSON_INVALID_STATE The kind is not #AZ_JSON_TOKEN_STRING.
  * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p destination does not have enough size.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The string contains a `\uXXXX` escape sequence of an unpaired
+ * surrogate, which cannot be encoded in UTF-8.
  */
 AZ_NODISCARD az_result az_json_token_get_string(
     az_json_token const* json_token,
@@ -257,18 +287,80 @@ AZ_NODISCARD bool az_json_token_is_text_equal(
     az_json_token const* json_token,
     az_span expected_text);
 
-/************************************ JSON WRITER ******************/
-
 /**
- * @brief Allows the user to define custom behavior when writing JSON using the #az_json_writer.
+ * @brief Matches JSON tokens, typically property names, against a fixed table of names.
+ *
+ * @details Initialize it once with #az_json_property_matcher_init() and call
+ * #az_json_property_matcher_find() for every token to dispatch, instead of calling
+ * #az_json_token_is_text_equal() for each candidate name.
  */
 typedef struct
 {
   struct
   {
-    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
-    bool unused;
+    /// The table of names to match against.
+    az_span const* names;
+
+    /// The number of names in the table.
+    int32_t names_count;
+
+    /// Bit `n` is set if a name is `n` bytes long, or at least 63 bytes long when `n` is 63.
+    uint64_t sizes;
+
+    /// Bit `b % 64` of element `b / 64` is set if a name starts with the byte `b`.
+    uint64_t first_bytes[4];
   } _internal;
+} az_json_property_matcher;
+
+/**
+ * @brief Initializes an #az_json_property_matcher over a table of names.
+ *
+ * @param[out] out_matcher A pointer to an #az_json_property_matcher instance to initialize.
+ * @param[in] names The table of names to match against, such as the property names a handler
+ * dispatches on. It must outlive the matcher.
+ * @param[in] names_count The number of names in \p names.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_json_property_matcher is initialized successfully.
+ */
+AZ_NODISCARD az_result az_json_property_matcher_init(
+    az_json_property_matcher* out_matcher,
+    az_span const names[],
+    int32_t names_count);
+
+/**
+ * @brief Finds which of the names of an #az_json_property_matcher the unescaped value of a JSON
+ * token is equal to.
+ *
+ * @param[in] matcher A pointer to an initialized #az_json_property_matcher.
+ * @param[in] json_token A pointer to an #az_json_token instance containing a JSON string or
+ * property name token.
+ *
+ * @return The index of the first name in the table which is equal to the token, with the exact
+ * casing, or -1 if there is none or the token isn't a string or property name.
+ *
+ * @remarks The length and first byte of the token rule out most names without comparing them.
+ * Only tokens which contain escaped characters or straddle several buffers are compared with
+ * #az_json_token_is_text_equal().
+ */
+AZ_NODISCARD int32_t az_json_property_matcher_find(
+    az_json_property_matcher const* matcher,
+    az_json_token const* json_token);
+
+/************************************ JSON WRITER ******************/
+
+/**
+ * @brief Allows the user to define custom behavior when writing JSON using the #az_json_writer.
+ */
+typedef struct
+{
+  /**
+   * An optional buffer used to track the state of nested objects and arrays beyond a depth of 64,
+   * which is the maximum depth without it. Use #AZ_JSON_NESTING_STACK_BUFFER_SIZE to compute its
+   * size for a given maximum depth. The buffer must not be shared with another #az_json_writer
+   * which is in use.
+   */
+  az_span nesting_stack_buffer;
 } az_json_writer_options;
 
 /**
@@ -283,14 +375,25 @@ typedef struct
 AZ_NODISCARD AZ_INLINE az_json_writer_options az_json_writer_options_default()
 {
   az_json_writer_options options = (az_json_writer_options) {
-    ._internal = {
-      .unused = false,
-    },
+    .nesting_stack_buffer = AZ_SPAN_EMPTY,
   };
 
   return options;
 }
 
+/**
+ * @brief Defines the signature of the callback function that an #az_json_writer initialized with
+ * #az_json_writer_sink_init() calls with each chunk of JSON text it has written, before it reuses
+ * its buffer.
+ *
+ * @param[in] user_context The user context passed to #az_json_writer_sink_init().
+ * @param[in] chunk The next bytes of JSON text, which are only valid until the callback returns.
+ *
+ * @return An #az_result value indicating the result of the operation. A failure stops the
+ * #az_json_writer from writing more JSON text.
+ */
+typedef az_result (*az_json_writer_flush_fn)(void* user_context, az_span chunk);
+
 /**
  * @brief Provides forward-only, non-cached writing of UTF-8 encoded JSON text into the provided
  * buffer.
@@ -305,9 +408,11 @@ typedef struct
     az_span destination_buffer;
     int32_t bytes_written;
     // For single contiguous buffer, bytes_written == total_bytes_written
-    int32_t total_bytes_written; // Currently, this is primarily used for testing.
+    int32_t total_bytes_written;
     az_span_allocator_fn allocator_callback;
+    az_json_writer_flush_fn flush_callback;
     void* user_context;
+    bool is_measuring; // Only total_bytes_written is kept, nothing is written to a destination.
     bool need_comma;
     az_json_token_kind token_kind; // needed for validation, potentially #if/def with preconditions.
     _az_json_bit_stack bit_stack; // needed for validation, potentially #if/def with preconditions.
@@ -360,6 +465,92 @@ AZ_NODISCARD az_result az_json_writer_chunked_init(
     void* user_context,
     az_json_writer_options const* options);
 
+/**
+ * @brief Initializes an #az_json_writer which writes JSON text into a single buffer, and passes it
+ * to a callback, such as a write to a socket, each time the buffer is too full for the next token.
+ *
+ * @details The buffer is then written again from its start, so JSON text of any size is written
+ * with the memory of the buffer. Call #az_json_writer_flush() once the JSON text is complete, to
+ * pass the rest of it to the callback.
+ *
+ * @param[out] out_json_writer A pointer to an #az_json_writer instance to initialize.
+ * @param[in] scratch_buffer An #az_span over the byte buffer where the JSON text is written before
+ * it is passed to \p flush_callback. Must be at least 64 bytes, the size of the largest token that
+ * is not split across chunks.
+ * @param[in] flush_callback An #az_json_writer_flush_fn callback function which is passed each
+ * chunk of JSON text.
+ * @param user_context A context specific user-defined struct or set of fields that is passed
+ * through to calls to the #az_json_writer_flush_fn.
+ * @param[in] options __[nullable]__ A reference to an #az_json_writer_options
+ * structure which defines custom behavior of the #az_json_writer. If `NULL` is passed, the writer
+ * will use the default options (i.e. #az_json_writer_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_json_writer is initialized successfully.
+ * @retval other Failure.
+ *
+ * @remarks An append for which \p flush_callback fails returns #AZ_ERROR_NOT_ENOUGH_SPACE, as with
+ * a failing #az_span_allocator_fn. Part of its token may already have been passed to the callback.
+ */
+AZ_NODISCARD az_result az_json_writer_sink_init(
+    az_json_writer* out_json_writer,
+    az_span scratch_buffer,
+    az_json_writer_flush_fn flush_callback,
+    void* user_context,
+    az_json_writer_options const* options);
+
+/**
+ * @brief Passes the JSON text written since the last chunk of an #az_json_writer initialized with
+ * #az_json_writer_sink_init() to its callback.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance initialized with
+ * #az_json_writer_sink_init().
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The JSON text was passed to the callback, or there was none left to pass.
+ * @retval other The failure returned by the callback.
+ */
+AZ_NODISCARD az_result az_json_writer_flush(az_json_writer* ref_json_writer);
+
+/**
+ * @brief Initializes an #az_json_writer which writes nothing, and only counts the size of the JSON
+ * text it is asked to write.
+ *
+ * @details Every append validates its input and computes the exact size of its JSON text, escaping
+ * included, as when writing to a buffer, so the size from #az_json_writer_get_total_bytes_written()
+ * after building the JSON a first time is the size of the buffer to write it into afterwards.
+ *
+ * @param[out] out_json_writer A pointer to an #az_json_writer instance to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_json_writer_options
+ * structure which defines custom behavior of the #az_json_writer. If `NULL` is passed, the writer
+ * will use the default options (i.e. #az_json_writer_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_json_writer is initialized successfully.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result
+az_json_writer_measure_init(az_json_writer* out_json_writer, az_json_writer_options const* options);
+
+/**
+ * @brief Resets an initialized #az_json_writer to write a new JSON text into another buffer.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance to reset.
+ * @param destination_buffer An #az_span over the byte buffer where the JSON text is to be written.
+ * It is the first chunk of a writer initialized with #az_json_writer_chunked_init(), and the
+ * scratch buffer of one initialized with #az_json_writer_sink_init(). It is ignored by a writer
+ * initialized with #az_json_writer_measure_init().
+ *
+ * @details The writer keeps the options, callbacks and user context it was initialized with, and
+ * only the state which writing changes is set again. Resetting one writer for each message, rather
+ * than initializing it again, avoids copying the options and setting up the nesting stack every
+ * time.
+ *
+ * @remarks Any JSON text a writer initialized with #az_json_writer_sink_init() hasn't flushed yet
+ * is discarded.
+ */
+void az_json_writer_reset(az_json_writer* ref_json_writer, az_span destination_buffer);
+
 /**
  * @brief Returns the #az_span containing the JSON text written to the underlying buffer so far, in
  * the last provided destination buffer.
@@ -384,6 +575,21 @@ az_json_writer_get_bytes_used_in_destination(az_json_writer const* json_writer)
       json_writer->_internal.destination_buffer, 0, json_writer->_internal.bytes_written);
 }
 
+/**
+ * @brief Returns the size of the JSON text written so far, across all the destination buffers of
+ * the #az_json_writer.
+ *
+ * @param[in] json_writer A pointer to an #az_json_writer instance.
+ *
+ * @return The number of bytes of JSON text written so far. For a writer initialized with
+ * #az_json_writer_measure_init(), this is the number of bytes the JSON text would take.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_json_writer_get_total_bytes_written(az_json_writer const* json_writer)
+{
+  return json_writer->_internal.total_bytes_written;
+}
+
 /**
  * @brief Appends the UTF-8 text value (as a JSON string) into the buffer.
  *
@@ -430,6 +636,57 @@ AZ_NODISCARD az_result az_json_writer_append_string(az_json_writer* ref_json_wri
 AZ_NODISCARD az_result
 az_json_writer_append_json_text(az_json_writer* ref_json_writer, az_span json_text);
 
+/**
+ * @brief A JSON text validated once by az_json_validated_text_init(), which
+ * az_json_writer_append_validated_json_text() appends without reading it again.
+ *
+ * @remarks The bytes of the JSON text are not copied, and must not change while the
+ * #az_json_validated_text is used.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span json_text;
+    az_json_token_kind last_token_kind;
+  } _internal;
+} az_json_validated_text;
+
+/**
+ * @brief Validates a UTF-8 encoded JSON text, as az_json_writer_append_json_text() does, so that it
+ * can be appended to any number of JSON writers without being validated again.
+ *
+ * @param[out] out_validated_text A pointer to an #az_json_validated_text instance to initialize.
+ * @param[in] json_text A single, possibly nested, valid, UTF-8 encoded, JSON value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The \p json_text is valid, and \p out_validated_text refers to it.
+ * @retval #AZ_ERROR_UNEXPECTED_END The provided \p json_text is invalid because it is incomplete
+ * and ends too early.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The provided \p json_text is invalid because of an unexpected
+ * character.
+ */
+AZ_NODISCARD az_result
+az_json_validated_text_init(az_json_validated_text* out_validated_text, az_span json_text);
+
+/**
+ * @brief Appends a JSON text validated by az_json_validated_text_init() into the buffer, as
+ * az_json_writer_append_json_text() does, only copying its bytes.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance containing the buffer to
+ * append the JSON text to.
+ * @param[in] validated_text The #az_json_validated_text to append.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The JSON text was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The destination is too small for the JSON text.
+ * @retval #AZ_ERROR_JSON_INVALID_STATE The \p ref_json_writer is in a state where the JSON text
+ * cannot be appended because it would result in invalid JSON.
+ */
+AZ_NODISCARD az_result az_json_writer_append_validated_json_text(
+    az_json_writer* ref_json_writer,
+    az_json_validated_text const* validated_text);
+
 /**
  * @brief Appends the UTF-8 property name (as a JSON string) which is the first part of a name/value
  * pair of a JSON object.
@@ -501,6 +758,75 @@ AZ_NODISCARD az_result az_json_writer_append_double(
     double value,
     int32_t fractional_digits);
 
+/**
+ * @brief Appends a `double` number value, using the fewest digits which read back as the same
+ * `double`.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance containing the buffer to
+ * append the number to.
+ * @param[in] value The value to be written as a JSON number.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ *
+ * @remark Only finite double values are supported. Values such as `NAN` and `INFINITY` are not
+ * allowed and would lead to invalid JSON being written.
+ *
+ * @remark Unlike #az_json_writer_append_double(), no digits are truncated and any magnitude is
+ * supported. The number is formatted as with #az_span_dtoa_shortest().
+ */
+AZ_NODISCARD az_result
+az_json_writer_append_double_shortest(az_json_writer* ref_json_writer, double value);
+
+/**
+ * @brief Appends a scaled integer, such as a temperature in hundredths of a degree, as a JSON
+ * number with a decimal point, using integer arithmetic only.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance containing the buffer to
+ * append the number to.
+ * @param[in] value The scaled value, which is \p decimal_places powers of ten larger than the
+ * number to write. For example, 2150 with 2 decimal places is written as `21.5`.
+ * @param[in] decimal_places The number of digits of the \p value which are after the decimal
+ * point.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The number was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ *
+ * @remark Non-significant trailing zeros (after the decimal point) are not written, so the JSON is
+ * the same as #az_json_writer_append_double() writes for the value divided down, without needing
+ * floating point support.
+ *
+ * @remark The \p decimal_places must be between 0 and 18 (inclusive).
+ */
+AZ_NODISCARD az_result az_json_writer_append_scaled_int64(
+    az_json_writer* ref_json_writer,
+    int64_t value,
+    int32_t decimal_places);
+
+/**
+ * @brief Appends a time as a JSON string holding its ISO 8601 UTC timestamp, such as
+ * `"2020-10-14T12:34:56.789Z"`.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance containing the buffer to
+ * append the timestamp to.
+ * @param[in] epoch_msec The time, in milliseconds from 1/1/1970, until the end of the year 9999.
+ * @param[in,out] ref_cache __[nullable]__ The #az_span_timestamp_cache kept between the calls, or
+ * `NULL` to format the whole timestamp.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The timestamp was appended successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
+ *
+ * @remark The timestamp is written by #az_span_timestamp_to_iso8601(), so a cache kept across the
+ * messages sent within the same hour only formats the minutes, seconds and milliseconds of each.
+ */
+AZ_NODISCARD az_result az_json_writer_append_timestamp(
+    az_json_writer* ref_json_writer,
+    int64_t epoch_msec,
+    az_span_timestamp_cache* ref_cache);
+
 /**
  * @brief Appends the JSON literal `null`.
  *
@@ -523,7 +849,7 @@ AZ_NODISCARD az_result az_json_writer_append_null(az_json_writer* ref_json_write
  * @retval #AZ_OK Object start was appended successfully.
  * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
  * @retval #AZ_ERROR_JSON_NESTING_OVERFLOW The depth of the JSON exceeds the maximum allowed
- * depth of 64.
+ * depth, which is 64 unless a larger nesting stack buffer is set in the #az_json_writer_options.
  */
 AZ_NODISCARD az_result az_json_writer_append_begin_object(az_json_writer* ref_json_writer);
 
@@ -536,8 +862,8 @@ AZ_NODISCARD az_result az_json_writer_append_begin_object(az_json_writer* ref_js
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK Array start was appended successfully.
  * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer is too small.
- * @retval #AZ_ERROR_JSON_NESTING_OVERFLOW The depth of the JSON exceeds the maximum allowed depth
- * of 64.
+ * @retval #AZ_ERROR_JSON_NESTING_OVERFLOW The depth of the JSON exceeds the maximum allowed
+ * depth, which is 64 unless a larger nesting stack buffer is set in the #az_json_writer_options.
  */
 AZ_NODISCARD az_result az_json_writer_append_begin_array(az_json_writer* ref_json_writer);
 
@@ -565,18 +891,145 @@ AZ_NODISCARD az_result az_json_writer_append_end_object(az_json_writer* ref_json
  */
 AZ_NODISCARD az_result az_json_writer_append_end_array(az_json_writer* ref_json_writer);
 
-/************************************ JSON READER ******************/
+/************************************ JSON TEMPLATE ******************/
 
 /**
- * @brief Allows the user to define custom behavior when reading JSON using the #az_json_reader.
+ * @brief The kind of value written for a field of an #az_json_template.
+ */
+typedef enum
+{
+  AZ_JSON_TEMPLATE_FIELD_INT32 = 0, ///< A JSON number written from an `int32_t`.
+  AZ_JSON_TEMPLATE_FIELD_INT64 = 1, ///< A JSON number written from an `int64_t`.
+  AZ_JSON_TEMPLATE_FIELD_DOUBLE = 2, ///< A JSON number written from a `double`.
+  AZ_JSON_TEMPLATE_FIELD_BOOLEAN = 3, ///< The JSON literal `true` or `false`.
+} az_json_template_field_kind;
+
+/**
+ * @brief A property of the JSON object described by an #az_json_template.
  */
 typedef struct
 {
+  /// The unescaped name of the property.
+  az_span name;
+
+  /// The kind of value of the property.
+  az_json_template_field_kind kind;
+
   struct
   {
-    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
-    bool unused;
+    /// The offset within the fragments of the template where the text preceding this value ends.
+    int32_t fragment_end;
   } _internal;
+} az_json_template_field;
+
+/**
+ * @brief The value of a field of an #az_json_template. The member which is read is selected by the
+ * kind of the field.
+ */
+typedef union
+{
+  int32_t int32_value; ///< The value of an #AZ_JSON_TEMPLATE_FIELD_INT32 field.
+  int64_t int64_value; ///< The value of an #AZ_JSON_TEMPLATE_FIELD_INT64 field.
+  double double_value; ///< The value of an #AZ_JSON_TEMPLATE_FIELD_DOUBLE field.
+  bool boolean_value; ///< The value of an #AZ_JSON_TEMPLATE_FIELD_BOOLEAN field.
+} az_json_template_value;
+
+/**
+ * @brief Writes JSON objects which always have the same properties, in the same order, such as
+ * telemetry messages.
+ *
+ * @details The opening brace, escaped property names, separators and closing brace are written
+ * once by #az_json_template_compile(). Each call to #az_json_template_write() then only copies
+ * them and formats the values, without the state validation of #az_json_writer.
+ */
+typedef struct
+{
+  struct
+  {
+    /// The literal text of the object, without its values.
+    az_span fragments;
+
+    /// The fields of the object, in order.
+    az_json_template_field const* fields;
+
+    /// The number of fields.
+    int32_t fields_count;
+  } _internal;
+} az_json_template;
+
+/**
+ * @brief Compiles the fields of a JSON object into an #az_json_template.
+ *
+ * @param[out] out_template A pointer to an #az_json_template instance to initialize.
+ * @param[in,out] fields The properties of the object, in the order they are written. The array and
+ * the names must outlive the template.
+ * @param[in] fields_count The number of fields in \p fields.
+ * @param[in] fragment_buffer The buffer the literal text of the object is written to. It must
+ * outlive the template.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The template is compiled successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p fragment_buffer is too small.
+ */
+AZ_NODISCARD az_result az_json_template_compile(
+    az_json_template* out_template,
+    az_json_template_field fields[],
+    int32_t fields_count,
+    az_span fragment_buffer);
+
+/**
+ * @brief Writes a JSON object from an #az_json_template and the values of its fields.
+ *
+ * @param[in] json_template A pointer to a compiled #az_json_template.
+ * @param[in] values The values of the fields of the template, in the same order.
+ * @param[in] destination The buffer the JSON object is written to.
+ * @param[out] out_json A pointer to an #az_span which receives the written JSON object.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The JSON object is written successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is too small.
+ * @retval #AZ_ERROR_NOT_SUPPORTED A `double` value is not a finite number.
+ *
+ * @remarks `double` values are written with the fewest digits which read back as the same value,
+ * as by #az_span_dtoa_shortest().
+ */
+AZ_NODISCARD az_result az_json_template_write(
+    az_json_template const* json_template,
+    az_json_template_value const values[],
+    az_span destination,
+    az_span* out_json);
+
+/************************************ JSON READER ******************/
+
+/**
+ * @brief Allows the user to define custom behavior when reading JSON using the #az_json_reader.
+ */
+typedef struct
+{
+  /**
+   * An optional buffer used to track the state of nested objects and arrays beyond a depth of 64,
+   * which is the maximum depth without it. Use #AZ_JSON_NESTING_STACK_BUFFER_SIZE to compute its
+   * size for a given maximum depth. The buffer must not be shared with another #az_json_reader
+   * which is in use.
+   */
+  az_span nesting_stack_buffer;
+
+  /**
+   * Whether the reader validates that strings and property names are well-formed UTF-8, and fails
+   * with #AZ_ERROR_UNEXPECTED_CHAR otherwise. This rejects overlong encodings, encoded surrogates
+   * and code points beyond U+10FFFF. The validation is done while the strings are scanned, rather
+   * than in a separate pass over the payload. Default is `false`.
+   */
+  bool validate_utf8;
+
+  /**
+   * Whether the reader computes the value of integer numbers, without a fraction or an exponent,
+   * while their digits are scanned. #az_json_token_get_int64(), #az_json_token_get_uint64() and the
+   * other integer getters, as well as #az_json_token_get_double() for integers below 2^53, then
+   * return that value without reading the token again, nor copying it when it straddles
+   * non-contiguous buffers. Default is `false`.
+   */
+  bool parse_integers;
 } az_json_reader_options;
 
 /**
@@ -591,9 +1044,9 @@ typedef struct
 AZ_NODISCARD AZ_INLINE az_json_reader_options az_json_reader_options_default()
 {
   az_json_reader_options options = (az_json_reader_options) {
-    ._internal = {
-      .unused = false,
-    },
+    .nesting_stack_buffer = AZ_SPAN_EMPTY,
+    .validate_utf8 = false,
+    .parse_integers = false,
   };
 
   return options;
@@ -644,9 +1097,34 @@ typedef struct
 
     /// A copy of the options provided by the user.
     az_json_reader_options options;
+
+    /// The positions of the structural characters and the start of every value within the JSON
+    /// payload, which will be null unless the reader was initialized with
+    /// #az_json_reader_indexed_init().
+    uint32_t* structural_index;
+
+    /// The number of positions in the structural index.
+    int32_t structural_index_count;
+
+    /// The first position in the structural index which hasn't been consumed yet.
+    int32_t structural_index_cursor;
+
+    /// The number of buffer segments the array can hold, when the reader was initialized with
+    /// #az_json_reader_incremental_init(). It is set to zero otherwise.
+    int32_t max_number_of_buffers;
+
+    /// Flag which indicates that #az_json_reader_incremental_end() was called: no more buffer
+    /// segments are going to be fed to the reader.
+    bool is_end_of_data;
   } _internal;
 } az_json_reader;
 
+/**
+ * @brief The size, in bytes, of a structural index buffer which is always large enough for
+ * #az_json_reader_indexed_init() to index a JSON payload of \p json_size bytes.
+ */
+#define AZ_JSON_READER_STRUCTURAL_INDEX_SIZE(json_size) ((json_size) * (int32_t)sizeof(uint32_t))
+
 /**
  * @brief Initializes an #az_json_reader to read the JSON payload contained within the provided
  * buffer.
@@ -701,6 +1179,115 @@ AZ_NODISCARD az_result az_json_reader_chunked_init(
     int32_t number_of_buffers,
     az_json_reader_options const* options);
 
+/**
+ * @brief Initializes an #az_json_reader to read the JSON payload contained within the provided
+ * buffer, indexing the payload up front so that tokens are read faster.
+ *
+ * @param[out] out_json_reader A pointer to an #az_json_reader instance to initialize.
+ * @param[in] json_buffer An #az_span over the byte buffer containing the JSON text to read.
+ * @param[in] structural_index_buffer An #az_span over a byte buffer, aligned for `uint32_t`, which
+ * receives the structural index of \p json_buffer.
+ * #AZ_JSON_READER_STRUCTURAL_INDEX_SIZE() gives a size which is always large enough, while most
+ * payloads need a fraction of it.
+ * @param[in] options __[nullable]__ A reference to an #az_json_reader_options structure which
+ * defines custom behavior of the #az_json_reader. If `NULL` is passed, the reader will use the
+ * default options (i.e. #az_json_reader_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_json_reader is initialized successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p structural_index_buffer is too small.
+ *
+ * @details The payload is first scanned, using SIMD instructions when the target architecture
+ * supports them, for structural characters, string boundaries and the start of every value. Then,
+ * #az_json_reader_next_token() moves from one indexed position to the next instead of scanning
+ * the whitespace and strings byte by byte. The tokens returned, and the errors for invalid JSON,
+ * are the same as for a reader initialized with #az_json_reader_init().
+ *
+ * @remarks The provided json buffer must not be empty, as that is invalid JSON.
+ *
+ * @remarks An instance of #az_json_reader must not outlive the lifetime of the JSON payload within
+ * the \p json_buffer or of the \p structural_index_buffer.
+ */
+AZ_NODISCARD az_result az_json_reader_indexed_init(
+    az_json_reader* out_json_reader,
+    az_span json_buffer,
+    az_span structural_index_buffer,
+    az_json_reader_options const* options);
+
+/**
+ * @brief Initializes an #az_json_reader which is fed the JSON payload one buffer at a time, as it
+ * arrives.
+ *
+ * @param[out] out_json_reader A pointer to an #az_json_reader instance to initialize.
+ * @param[in] json_buffers An array of spans which holds the buffers fed with
+ * #az_json_reader_incremental_feed(). Its initial contents are ignored.
+ * @param[in] max_number_of_buffers The number of spans \p json_buffers can hold, which is the
+ * maximum number of buffers that can be fed to the reader.
+ * @param[in] options __[nullable]__ A reference to an #az_json_reader_options structure which
+ * defines custom behavior of the #az_json_reader. If `NULL` is passed, the reader will use the
+ * default options (i.e. #az_json_reader_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The #az_json_reader is initialized successfully.
+ *
+ * @details Until #az_json_reader_incremental_end() is called, the functions which read the next
+ * token return #AZ_ERROR_JSON_READER_NEED_MORE_DATA rather than #AZ_ERROR_UNEXPECTED_END or
+ * #AZ_ERROR_JSON_READER_DONE when the buffers fed so far end before it, or partway through it, and
+ * leave the reader as it was before the call. Once more data is fed, calling them again reads the
+ * same token, across the buffer boundary.
+ *
+ * @remarks An instance of #az_json_reader must not outlive the lifetime of \p json_buffers. Each
+ * buffer fed to it must remain valid until the reader, and the tokens read from it, have moved
+ * past that buffer.
+ */
+AZ_NODISCARD az_result az_json_reader_incremental_init(
+    az_json_reader* out_json_reader,
+    az_span json_buffers[],
+    int32_t max_number_of_buffers,
+    az_json_reader_options const* options);
+
+/**
+ * @brief Feeds the next buffer of the JSON payload to an incremental #az_json_reader.
+ *
+ * @param[in,out] ref_json_reader A pointer to an #az_json_reader instance initialized with
+ * #az_json_reader_incremental_init().
+ * @param[in] json_buffer The next, non-empty, buffer of the JSON payload.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The buffer is added to the data to read.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The reader already holds the maximum number of buffers.
+ */
+AZ_NODISCARD az_result
+az_json_reader_incremental_feed(az_json_reader* ref_json_reader, az_span json_buffer);
+
+/**
+ * @brief Tells an incremental #az_json_reader that all of the JSON payload was fed to it.
+ *
+ * @param[in,out] ref_json_reader A pointer to an #az_json_reader instance initialized with
+ * #az_json_reader_incremental_init().
+ *
+ * @details Reading then completes and reports errors as for a reader initialized with
+ * #az_json_reader_chunked_init() over the same buffers.
+ */
+void az_json_reader_incremental_end(az_json_reader* ref_json_reader);
+
+/**
+ * @brief Resets an initialized #az_json_reader to read the JSON payload contained within another
+ * buffer.
+ *
+ * @param[in,out] ref_json_reader A pointer to an #az_json_reader instance to reset.
+ * @param[in] json_buffer An #az_span over the byte buffer containing the JSON text to read.
+ *
+ * @details The reader keeps the options it was initialized with, including the nesting stack
+ * buffer, and only the state which reading changes is set again. Afterwards, it reads \p
+ * json_buffer as if it had been initialized with #az_json_reader_init(), whichever of the
+ * initialization functions was used originally. Resetting one reader for each message, rather than
+ * initializing it again, avoids copying the options and setting up the nesting stack every time.
+ *
+ * @remarks The provided json buffer must not be empty, as that is invalid JSON.
+ */
+void az_json_reader_reset(az_json_reader* ref_json_reader, az_span json_buffer);
+
 /**
  * @brief Reads the next token in the JSON text and updates the reader state.
  *
@@ -712,6 +1299,10 @@ AZ_NODISCARD az_result az_json_reader_chunked_init(
  * @retval #AZ_ERROR_UNEXPECTED_END The end of the JSON document is reached.
  * @retval #AZ_ERROR_UNEXPECTED_CHAR An invalid character is detected.
  * @retval #AZ_ERROR_JSON_READER_DONE No more JSON text left to process.
+ * @retval #AZ_ERROR_JSON_NESTING_OVERFLOW The depth of the JSON exceeds the maximum allowed
+ * depth, which is 64 unless a larger nesting stack buffer is set in the #az_json_reader_options.
+ * @retval #AZ_ERROR_JSON_READER_NEED_MORE_DATA The buffers fed to an incremental reader end before
+ * the next token is complete.
  */
 AZ_NODISCARD az_result az_json_reader_next_token(az_json_reader* ref_json_reader);
 
@@ -725,6 +1316,8 @@ AZ_NODISCARD az_result az_json_reader_next_token(az_json_reader* ref_json_reader
  * @retval #AZ_OK The children of the current JSON token are skipped successfully.
  * @retval #AZ_ERROR_UNEXPECTED_END The end of the JSON document is reached.
  * @retval #AZ_ERROR_UNEXPECTED_CHAR An invalid character is detected.
+ * @retval #AZ_ERROR_JSON_READER_NEED_MORE_DATA The buffers fed to an incremental reader end before
+ * the children are skipped, and the reader is left as it was before the call.
  *
  * @remarks If the current token kind is a property name, the reader first moves to the property
  * value. Then, if the token kind is start of an object or array, the reader moves to the matching
@@ -732,6 +1325,230 @@ AZ_NODISCARD az_result az_json_reader_next_token(az_json_reader* ref_json_reader
  */
 AZ_NODISCARD az_result az_json_reader_skip_children(az_json_reader* ref_json_reader);
 
+/**
+ * @brief Skips over any nested JSON elements without validating them.
+ *
+ * @param[in,out] ref_json_reader A pointer to an #az_json_reader instance containing the JSON to
+ * read.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The children of the current JSON token are skipped successfully.
+ * @retval #AZ_ERROR_UNEXPECTED_END The end of the JSON document is reached.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The end of the skipped object or array doesn't match its start.
+ * @retval #AZ_ERROR_JSON_READER_NEED_MORE_DATA The buffers fed to an incremental reader end before
+ * the children are skipped, and the reader is left as it was before the call.
+ *
+ * @details The reader moves to the same token as #az_json_reader_skip_children() would, but scans
+ * the skipped JSON text for string boundaries and object and array delimiters only, a block of
+ * bytes at a time and using SIMD instructions when the target architecture supports them, instead
+ * of reading every token.
+ *
+ * @remarks The skipped JSON text is not validated: invalid tokens, mismatched delimiters within it,
+ * and nesting beyond the maximum depth of the reader are not reported. Use it to skip content which
+ * is ignored, such as large sections of a document a handler doesn't know about.
+ */
+AZ_NODISCARD az_result az_json_reader_fast_skip_children(az_json_reader* ref_json_reader);
+
+/**
+ * @brief Moves the reader to the JSON value at a path, skipping over every subtree which isn't on
+ * that path.
+ *
+ * @param[in,out] ref_json_reader A pointer to an #az_json_reader instance containing the JSON to
+ * read.
+ * @param[in] path The path of the value, relative to the current value of the reader, as property
+ * names separated by `.`. Segments which are made of digits select an array element by its
+ * zero-based index when the value they apply to is an array. For example,
+ * `properties.desired.thermostat1.targetTemperature` or `readings.0`. An empty path selects the
+ * current value.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The reader is positioned on the value at \p path.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND There is no value at \p path.
+ * @retval #AZ_ERROR_UNEXPECTED_END The end of the JSON document is reached.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR An invalid character is detected.
+ * @retval #AZ_ERROR_JSON_READER_NEED_MORE_DATA The buffers fed to an incremental reader end before
+ * the value is found, and the reader is left as it was before the call.
+ *
+ * @remarks The current value of the reader is its current token, or the value which follows when
+ * the reader was just initialized or is on a property name. On success, the reader can keep
+ * reading from the value: for example, the children of an object or array.
+ *
+ * @remarks Property names which contain a `.` can't be looked up.
+ */
+AZ_NODISCARD az_result az_json_reader_find_path(az_json_reader* ref_json_reader, az_span path);
+
+/**
+ * @brief A path to look up with #az_json_reader_find_paths(), along with its value once found.
+ */
+typedef struct
+{
+  /// The path of the value, in the format described for #az_json_reader_find_path().
+  az_span path;
+
+  /// The token of the value at #path. Its kind is #AZ_JSON_TOKEN_NONE when there is no value at
+  /// that path. For an object or an array, this is the token of its start.
+  az_json_token value;
+
+  struct
+  {
+    /// The number of segments of the path which match the location of the reader.
+    int32_t matched_segments;
+  } _internal;
+} az_json_path_lookup;
+
+/**
+ * @brief Looks up the values at several paths in a single pass over the JSON.
+ *
+ * @param[in,out] ref_json_reader A pointer to an #az_json_reader instance containing the JSON to
+ * read.
+ * @param[in,out] lookups The paths to look up. On return, the value of each of them is set.
+ * @param[in] lookups_count The number of paths in \p lookups.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The JSON was read. Paths without a value have a value token of kind
+ * #AZ_JSON_TOKEN_NONE.
+ * @retval #AZ_ERROR_UNEXPECTED_END The end of the JSON document is reached.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR An invalid character is detected.
+ * @retval #AZ_ERROR_JSON_READER_NEED_MORE_DATA The buffers fed to an incremental reader end before
+ * the lookup completes, and the reader is left as it was before the call.
+ *
+ * @remarks Each subtree is only read if it contains one of the paths, and reading stops as soon as
+ * all the paths are found. Afterwards, the position of the reader is unspecified.
+ */
+AZ_NODISCARD az_result az_json_reader_find_paths(
+    az_json_reader* ref_json_reader,
+    az_json_path_lookup lookups[],
+    int32_t lookups_count);
+
+/**
+ * @brief An entry of an #az_json_tape, for one token of the JSON payload.
+ *
+ * @details The entries of an object or an array follow its own entry, and each property name is
+ * followed by the entries of its value. #next_index skips over all of them, so the first child of a
+ * container at `i` is at `i + 1`, and its next sibling at `entries[i].next_index`.
+ */
+typedef struct
+{
+  /// The kind of the token, which is never #AZ_JSON_TOKEN_END_OBJECT or #AZ_JSON_TOKEN_END_ARRAY.
+  az_json_token_kind kind;
+
+  /// The offset of the token within the JSON payload. For a string or a property name, this is
+  /// the offset of its contents, without the quotes.
+  int32_t offset;
+
+  /// The size of the token. For an object or an array, this is the size of its whole JSON text.
+  int32_t size;
+
+  /// The index of the entry which follows this one and all the entries within it. For a property
+  /// name, this is the entry after its value.
+  int32_t next_index;
+} az_json_tape_entry;
+
+/**
+ * @brief An index of every token of a JSON payload, built in a single pass, for random access into
+ * the payload without reading it again.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span json_buffer;
+    az_json_tape_entry* entries;
+    int32_t count;
+  } _internal;
+} az_json_tape;
+
+/**
+ * @brief Reads the JSON payload contained within the provided buffer, and writes an entry of the
+ * tape for each of its tokens.
+ *
+ * @param[out] out_tape A pointer to an #az_json_tape instance to initialize.
+ * @param[in] json_buffer An #az_span over the byte buffer containing the JSON text to index.
+ * @param[out] entries An array of \p max_entries #az_json_tape_entry, which receives the tape.
+ * @param[in] max_entries The number of entries \p entries can hold. Every value and property name
+ * takes one.
+ * @param[in] options __[nullable]__ A reference to an #az_json_reader_options structure which
+ * defines custom behavior of the #az_json_reader used to read the payload. If `NULL` is passed,
+ * the default options are used (i.e. #az_json_reader_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The tape was built.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The payload has more tokens than \p max_entries.
+ * @retval other The JSON payload is invalid, as returned by #az_json_reader_next_token().
+ *
+ * @remarks The tape does not need more memory than \p entries, even for nested containers. An
+ * instance of #az_json_tape must not outlive \p json_buffer or \p entries.
+ */
+AZ_NODISCARD az_result az_json_tape_init(
+    az_json_tape* out_tape,
+    az_span json_buffer,
+    az_json_tape_entry entries[],
+    int32_t max_entries,
+    az_json_reader_options const* options);
+
+/**
+ * @brief Returns the number of entries of an #az_json_tape.
+ *
+ * @param[in] tape A pointer to an #az_json_tape instance.
+ *
+ * @return The number of entries, which are at the indexes from 0, the root value, to this
+ * number minus one.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_json_tape_get_count(az_json_tape const* tape)
+{
+  return tape->_internal.count;
+}
+
+/**
+ * @brief Gets the #az_json_token of an entry of an #az_json_tape, to read its value with the
+ * `az_json_token_get_*()` functions.
+ *
+ * @param[in] tape A pointer to an #az_json_tape instance.
+ * @param[in] index The index of the entry.
+ * @param[out] out_token A pointer to an #az_json_token instance to receive the token. For an
+ * object or an array, its slice is the whole JSON text of the container.
+ */
+void az_json_tape_get_token(az_json_tape const* tape, int32_t index, az_json_token* out_token);
+
+/**
+ * @brief Finds the value of a property of an object in an #az_json_tape, skipping over the values
+ * of the other properties.
+ *
+ * @param[in] tape A pointer to an #az_json_tape instance.
+ * @param[in] object_index The index of the entry of the object, of kind
+ * #AZ_JSON_TOKEN_BEGIN_OBJECT.
+ * @param[in] name The name of the property, unescaped.
+ * @param[out] out_value_index The index of the entry of the value of the first property with
+ * that name.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The property was found.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The object has no property with that name.
+ */
+AZ_NODISCARD az_result az_json_tape_find_property(
+    az_json_tape const* tape,
+    int32_t object_index,
+    az_span name,
+    int32_t* out_value_index);
+
+/**
+ * @brief Finds an item of an array in an #az_json_tape, skipping over the items before it.
+ *
+ * @param[in] tape A pointer to an #az_json_tape instance.
+ * @param[in] array_index The index of the entry of the array, of kind #AZ_JSON_TOKEN_BEGIN_ARRAY.
+ * @param[in] position The position of the item within the array, from 0.
+ * @param[out] out_item_index The index of the entry of the item.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The item was found.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The array has no more than \p position items.
+ */
+AZ_NODISCARD az_result az_json_tape_get_array_item(
+    az_json_tape const* tape,
+    int32_t array_index,
+    int32_t position,
+    int32_t* out_item_index);
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_JSON_H
@@ -11,6 +11,10 @@
  * `-DLOGGING=OFF` with cmake), all of the Azure SDK logging functionality will be excluded, making
  * the resulting compiled code smaller and faster.
  *
+ * To keep only some of the log messages, define `AZ_LOG_COMPILED_CLASSIFICATIONS` as the bitwise
+ * or of the #AZ_LOG_CLASSIFICATION_BIT() of their #az_log_classification values. The messages of
+ * the other classifications are then excluded from the compiled code.
+ *
  * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
  * prefixed with an underscore ('_') directly in your application code. These symbols
  * are part of Azure SDK's internal implementation; we do not document these symbols
@@ -65,6 +69,15 @@ typedef enum
   = _az_LOG_MAKE_CLASSIFICATION(_az_FACILITY_IOT, 3), ///< Azure IoT classification for Azure RTOS.
 } az_log_classification;
 
+/**
+ * @brief Returns the bit of an #az_log_classification in a mask of classifications, such as
+ * `AZ_LOG_COMPILED_CLASSIFICATIONS`.
+ */
+#define AZ_LOG_CLASSIFICATION_BIT(classification)     \
+  ((uint64_t)1                                        \
+   << ((((uint32_t)(classification) >> 16) & 7u) * 8u \
+       + ((uint32_t)(classification) & 7u)))
+
 /**
  * @brief Defines the signature of the callback function that application developers must write in
  * order to receive Azure SDK log messages.
@@ -81,6 +94,9 @@ typedef void (*az_log_message_fn)(az_log_classification classification, az_span
  * @details If no classifications are set (`NULL`), the application will receive log messages for
  * all #az_log_classification values.
  *
+ * The array is read once by this function, so later changes to it have no effect until it is set
+ * again.
+ *
  * @param[in] classifications __[nullable]__ An array of az_log_classification values, terminated by
  * #AZ_LOG_END_OF_LIST.
  */
@@ -109,6 +125,152 @@ AZ_INLINE void az_log_set_callback(az_log_message_fn az_log_message_callback)
 }
 #endif // AZ_NO_LOGGING
 
+/**
+ * @brief Limits the log messages of a classification which reach the #az_log_message_fn, so that
+ * a burst of them, such as the retries and responses of an outage, takes a bounded share of the
+ * CPU and of the log pipeline.
+ */
+typedef struct
+{
+  /// Only one message out of this many is logged, starting with the first one. `0` and `1` log
+  /// every message.
+  int32_t sample_rate;
+
+  /// The most messages logged within each second. The messages beyond it are suppressed, and their
+  /// number is logged as a summary before the first message of the next second which is logged.
+  /// `0` doesn't cap the rate.
+  int32_t max_messages_per_second;
+} az_log_limit_options;
+
+/**
+ * @brief Gets the default #az_log_limit_options, which log every message.
+ *
+ * @details Call this to obtain an initialized #az_log_limit_options structure that can be
+ * afterwards modified and passed to #az_log_set_limit().
+ *
+ * @return #az_log_limit_options.
+ */
+AZ_NODISCARD AZ_INLINE az_log_limit_options az_log_limit_options_default()
+{
+  return (az_log_limit_options){ .sample_rate = 1, .max_messages_per_second = 0 };
+}
+
+/**
+ * @brief Samples, or caps the rate of, the log messages of a classification.
+ *
+ * @param[in] classification The #az_log_classification to limit.
+ * @param[in] options __[nullable]__ A reference to an #az_log_limit_options structure. If `NULL`
+ * is passed, the limit of \p classification is removed.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE Every classification already has a limit.
+ *
+ * @remarks A message which is sampled out or suppressed is dropped before the SDK formats it. The
+ * rate cap counts seconds with #az_platform_clock_msec(), so it needs a platform which has a clock.
+ * Messages logged from several threads at once are each counted once.
+ */
+#ifndef AZ_NO_LOGGING
+AZ_NODISCARD az_result
+az_log_set_limit(az_log_classification classification, az_log_limit_options const* options);
+#else
+AZ_NODISCARD AZ_INLINE az_result
+az_log_set_limit(az_log_classification classification, az_log_limit_options const* options)
+{
+  (void)classification;
+  (void)options;
+  return AZ_OK;
+}
+#endif // AZ_NO_LOGGING
+
+/**
+ * @brief A ring buffer which log messages are copied to, so that the #az_log_message_fn is called
+ * later by #az_log_ring_drain() instead of on the thread which logs them.
+ *
+ * @details Use it when the callback is slow, such as when it writes to a file, syslog or a UART,
+ * so that logging never holds up network I/O. When the ring is full, messages are dropped and
+ * counted instead of waiting for room.
+ *
+ * @remarks Messages can be logged from several threads at once, such as by the requests of a
+ * shared client, and must be drained from one thread at a time. The two can be different threads
+ * when the SDK is built with GCC or Clang, or with MSVC for x86 or x64. Messages are delivered in
+ * the order they were logged in, so a message being copied by a thread holds up the drain of the
+ * messages logged after it.
+ */
+typedef struct
+{
+  struct
+  {
+    uint8_t* buffer;
+    uint32_t capacity;
+    uint64_t volatile head;
+    uint64_t volatile tail;
+    uint64_t volatile dropped_count;
+  } _internal;
+} az_log_ring;
+
+/**
+ * @brief Initializes an #az_log_ring over a buffer.
+ *
+ * @param[out] out_ring The #az_log_ring to initialize.
+ * @param[in] buffer The buffer the messages are copied to. Its size must be a power of two and at
+ * least 16. It is cleared, and must stay alive while the ring is in use.
+ *
+ * @remarks Each message takes 8 bytes, plus its size rounded up to a multiple of 8. Messages of
+ * 16 MiB or more are dropped.
+ */
+#ifndef AZ_NO_LOGGING
+void az_log_ring_init(az_log_ring* out_ring, az_span buffer);
+#else
+AZ_INLINE void az_log_ring_init(az_log_ring* out_ring, az_span buffer)
+{
+  (void)out_ring;
+  (void)buffer;
+}
+#endif // AZ_NO_LOGGING
+
+/**
+ * @brief Makes the SDK copy log messages to \p ring instead of calling the #az_log_message_fn.
+ *
+ * @param[in] ring __[nullable]__ The #az_log_ring to copy log messages to. If `NULL`, the
+ * #az_log_message_fn is called right away again. Drain the previous ring before replacing it.
+ */
+#ifndef AZ_NO_LOGGING
+void az_log_set_ring(az_log_ring* ring);
+#else
+AZ_INLINE void az_log_set_ring(az_log_ring* ring) { (void)ring; }
+#endif // AZ_NO_LOGGING
+
+/**
+ * @brief Calls the #az_log_message_fn set with #az_log_set_callback() with the oldest messages of
+ * an #az_log_ring, and removes them from the ring.
+ *
+ * @param[in,out] ref_ring The #az_log_ring to drain.
+ * @param[in] max_messages The maximum number of messages to deliver.
+ *
+ * @return The number of messages removed from the ring.
+ */
+#ifndef AZ_NO_LOGGING
+int32_t az_log_ring_drain(az_log_ring* ref_ring, int32_t max_messages);
+#else
+AZ_INLINE int32_t az_log_ring_drain(az_log_ring* ref_ring, int32_t max_messages)
+{
+  (void)ref_ring;
+  (void)max_messages;
+  return 0;
+}
+#endif // AZ_NO_LOGGING
+
+/**
+ * @brief Returns the number of messages which were dropped because an #az_log_ring was full.
+ *
+ * @param[in] ring The #az_log_ring.
+ */
+AZ_NODISCARD AZ_INLINE uint32_t az_log_ring_get_dropped_count(az_log_ring const* ring)
+{
+  return (uint32_t)ring->_internal.dropped_count;
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_LOG_H
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief This header defines the types and functions your application uses to read or write
+ * newline-delimited JSON (NDJSON), where each line holds one JSON value, as in log files and bulk
+ * exports.
+ *
+ * @details A batch is split into its records with #az_ndjson_split(), and its records are parsed
+ * by #az_ndjson_parse_records(), which spreads them over the threads of the platform executor. A
+ * batch is written with an #az_json_writer, which #az_ndjson_writer_end_record() lets write one
+ * value after another, each on its own line.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_NDJSON_H
+#define _az_NDJSON_H
+
+#include <azure/core/az_json.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief Splits NDJSON text into its records, one for each line.
+ *
+ * @param[in] source The NDJSON text. The last line doesn't need to end with a newline.
+ * @param[out] out_records An array of \p max_records #az_span, which receives the records. They
+ * don't include the newline, nor the carriage return before it.
+ * @param[in] max_records The number of records \p out_records can hold.
+ * @param[out] out_record_count The number of records written to \p out_records.
+ * @param[out] out_remaining The part of \p source which follows the last record written. It is
+ * empty unless \p out_records was filled, in which case it is split by the next call.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The records were split.
+ *
+ * @remarks Empty lines are skipped. The newlines are looked for with vector instructions, a block
+ * of bytes at a time, so a batch is split in a single pass whatever the length of its records.
+ */
+AZ_NODISCARD az_result az_ndjson_split(
+    az_span source,
+    az_span out_records[],
+    int32_t max_records,
+    int32_t* out_record_count,
+    az_span* out_remaining);
+
+/**
+ * @brief Defines the function #az_ndjson_parse_records() calls for each record.
+ *
+ * @param[in,out] ref_json_reader An #az_json_reader over the record, before its first token.
+ * @param[in] record_index The index of the record in the records passed to
+ * #az_ndjson_parse_records().
+ * @param[in] user_context The user context passed to #az_ndjson_parse_records().
+ *
+ * @return The result of the record, which #az_ndjson_parse_records() writes to its results.
+ *
+ * @remarks It is called from several threads at the same time, for different records.
+ */
+typedef AZ_NODISCARD az_result (*az_ndjson_record_fn)(
+    az_json_reader* ref_json_reader,
+    int32_t record_index,
+    void* user_context);
+
+/**
+ * @brief The state of a thread which #az_ndjson_parse_records() parses records on.
+ */
+typedef struct
+{
+  struct
+  {
+    az_platform_work work;
+  } _internal;
+} az_ndjson_worker;
+
+/**
+ * @brief Parses records on the threads of the platform executor, each with its own
+ * #az_json_reader.
+ *
+ * @param[in] records The records, as split by #az_ndjson_split().
+ * @param[in] record_count The number of records in \p records.
+ * @param[in] record_fn The function which reads each record.
+ * @param[in] user_context The argument \p record_fn is called with.
+ * @param[in] options __[nullable]__ A reference to an #az_json_reader_options structure which
+ * defines custom behavior of the readers. If `NULL` is passed, the default options are used (i.e.
+ * #az_json_reader_options_default()).
+ * @param[in] workers An array of \p worker_count #az_ndjson_worker, one for each executor thread
+ * to parse records on, in addition to the calling thread.
+ * @param[in] worker_count The number of workers in \p workers, which can be 0 to parse the records
+ * on the calling thread only.
+ * @param[out] out_results An array of \p record_count #az_result, which receives the result of
+ * \p record_fn for each record.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Every record was parsed successfully.
+ * @retval other The result of the first record, in the order of \p records, which failed. The
+ * records after it are still parsed.
+ *
+ * @remarks The threads take the records a few at a time, as they finish the previous ones, so a
+ * batch of records of different lengths keeps all of them busy. The function returns once every
+ * record was parsed, so \p workers can be reused afterwards.
+ */
+AZ_NODISCARD az_result az_ndjson_parse_records(
+    az_span const records[],
+    int32_t record_count,
+    az_ndjson_record_fn record_fn,
+    void* user_context,
+    az_json_reader_options const* options,
+    az_ndjson_worker workers[],
+    int32_t worker_count,
+    az_result out_results[]);
+
+/**
+ * @brief Ends the record an #az_json_writer has written, so that it can write the next one.
+ *
+ * @param[in,out] ref_json_writer A pointer to an #az_json_writer instance which has written one
+ * complete JSON value since it was initialized or since the previous record ended.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The newline was appended.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The destination buffer is too small, and no other buffer
+ * could be allocated.
+ *
+ * @remarks The writer appends a newline, and then writes values as if nothing had been written
+ * yet. With a writer initialized by #az_json_writer_chunked_init(), the records of a batch are
+ * written across as many buffers as it needs.
+ */
+AZ_NODISCARD az_result az_ndjson_writer_end_record(az_json_writer* ref_json_writer);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_NDJSON_H
@@ -15,9 +15,12 @@
 #ifndef _az_PLATFORM_H
 #define _az_PLATFORM_H
 
+#include <azure/core/az_context.h>
 #include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <azure/core/_az_cfg_prefix.h>
@@ -43,6 +46,244 @@ AZ_NODISCARD int64_t az_platform_clock_msec();
  */
 void az_platform_sleep_msec(int32_t milliseconds);
 
+/**
+ * @brief Gets a monotonic platform clock in nanoseconds.
+ *
+ * @remark The moment of time where clock starts is undefined, and it may not be the same as for
+ * #az_platform_clock_msec(). The clock never goes backwards, so the difference between two values
+ * is the time elapsed between the calls, at the resolution the platform provides.
+ *
+ * @return Platform clock in nanoseconds.
+ */
+AZ_NODISCARD int64_t az_platform_clock_nsec();
+
+/**
+ * @brief Waits for a given number of milliseconds, unless \p context is canceled or expires first.
+ *
+ * @param[in] context The #az_context the wait is for. It may be `NULL`, in which case this is the
+ * same as #az_platform_sleep_msec().
+ * @param[in] milliseconds Number of milliseconds to wait.
+ *
+ * @remarks Unlike #az_platform_sleep_msec(), the wait ends as soon as #az_context_cancel() is
+ * called on \p context or one of its parents, from another thread, or when the expiration of
+ * \p context, in #az_platform_clock_msec() time, is reached.
+ *
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if the whole time was waited
+ *         - #AZ_ERROR_CANCELED if \p context was canceled or has expired
+ */
+AZ_NODISCARD az_result az_platform_wait_msec(az_context const* context, int32_t milliseconds);
+
+/**
+ * @brief Wakes the threads in #az_platform_wait_msec(), so that they check their context again.
+ *
+ * @remarks It is called by #az_context_cancel(), so it must be safe to call from any thread.
+ */
+void az_platform_wake_waiters();
+
+/**
+ * @brief Defines the function the platform executor runs for an #az_platform_work.
+ *
+ * @param[in] user_context The user context given to #az_platform_work_init().
+ */
+typedef void (*az_platform_work_fn)(void* user_context);
+
+/**
+ * @brief A unit of work for the platform executor.
+ *
+ * @details The executor doesn't allocate memory: the caller owns each #az_platform_work, which
+ * must stay valid from #az_platform_executor_submit() until #az_platform_executor_wait() returns.
+ */
+typedef struct az_platform_work az_platform_work;
+
+struct az_platform_work
+{
+  struct
+  {
+    az_platform_work_fn work_fn;
+    void* user_context;
+    az_platform_work* next;
+    int32_t volatile state;
+  } _internal;
+};
+
+/**
+ * @brief Initializes an #az_platform_work, which can then be submitted to the executor.
+ *
+ * @param[out] out_work The #az_platform_work to initialize.
+ * @param[in] work_fn The function to run.
+ * @param[in] user_context The argument \p work_fn is called with.
+ */
+AZ_INLINE void az_platform_work_init(
+    az_platform_work* out_work,
+    az_platform_work_fn work_fn,
+    void* user_context)
+{
+  out_work->_internal.work_fn = work_fn;
+  out_work->_internal.user_context = user_context;
+  out_work->_internal.next = NULL;
+  out_work->_internal.state = 0;
+}
+
+/**
+ * @brief Submits \p ref_work to the platform executor, which runs it on one of its threads.
+ *
+ * @param[in,out] ref_work The #az_platform_work to run. It must not be submitted again until
+ * #az_platform_executor_wait() has returned for it.
+ *
+ * @remarks On POSIX and Windows, the work is run by a pool of threads, one per processor, which is
+ * started by the first submission. Each thread takes the work submitted from it first, and takes
+ * work from the other threads when it has none. On platforms without threads, the work is run
+ * before this function returns.
+ *
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if the work was submitted, or run
+ */
+AZ_NODISCARD az_result az_platform_executor_submit(az_platform_work* ref_work);
+
+/**
+ * @brief Waits until \p ref_work has run.
+ *
+ * @param[in,out] ref_work A submitted #az_platform_work.
+ *
+ * @remarks If no thread has started \p ref_work yet, it is run by the calling thread instead, so
+ * work running on the executor can wait for work it submitted.
+ */
+void az_platform_executor_wait(az_platform_work* ref_work);
+
+/**
+ * @brief Runs the work that was submitted and then stops the threads of the executor.
+ *
+ * @remarks A later #az_platform_executor_submit() starts the threads again.
+ */
+void az_platform_executor_shutdown();
+
+/**
+ * @brief A read-only mapping of a file into memory.
+ *
+ * @details The contents of the file are read by the operating system as they are accessed, through
+ * its page cache, so they can be sent without being copied into a buffer first.
+ */
+typedef struct
+{
+  struct
+  {
+    uint8_t* content;
+    int64_t size;
+  } _internal;
+} az_platform_file_mapping;
+
+/**
+ * @brief Maps the file at \p path into memory, for reading.
+ *
+ * @param[out] out_mapping The #az_platform_file_mapping to initialize. It must be released with
+ * #az_platform_file_unmap().
+ * @param[in] path The null-terminated path of the file.
+ *
+ * @remarks The file is expected to be read once, from start to end, so the operating system is
+ * asked to read ahead. Changing the file while it is mapped changes the mapped contents.
+ *
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if the file was mapped
+ *         - #AZ_ERROR_ITEM_NOT_FOUND if there is no file at \p path
+ *         - #AZ_ERROR_PLATFORM_FILE_IO if the file couldn't be opened or mapped
+ *         - #AZ_ERROR_DEPENDENCY_NOT_PROVIDED if the platform has no files
+ */
+AZ_NODISCARD az_result
+az_platform_file_map(az_platform_file_mapping* out_mapping, char const* path);
+
+/**
+ * @brief Maps a file which is already open into memory, for reading.
+ *
+ * @param[out] out_mapping The #az_platform_file_mapping to initialize. It must be released with
+ * #az_platform_file_unmap().
+ * @param[in] file The file, opened for reading: a file descriptor on POSIX, or a `HANDLE` on
+ * Windows. It can be closed once this function returns.
+ *
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if the file was mapped
+ *         - #AZ_ERROR_PLATFORM_FILE_IO if the file couldn't be mapped
+ *         - #AZ_ERROR_DEPENDENCY_NOT_PROVIDED if the platform has no files
+ */
+AZ_NODISCARD az_result
+az_platform_file_map_handle(az_platform_file_mapping* out_mapping, intptr_t file);
+
+/**
+ * @brief Releases a mapping made by #az_platform_file_map() or #az_platform_file_map_handle().
+ *
+ * @param[in,out] ref_mapping The #az_platform_file_mapping to release. The spans taken from it
+ * can no longer be used.
+ */
+void az_platform_file_unmap(az_platform_file_mapping* ref_mapping);
+
+/**
+ * @brief Gets the size of a mapped file.
+ *
+ * @param[in] mapping The #az_platform_file_mapping.
+ *
+ * @return The size of the file, in bytes.
+ */
+AZ_NODISCARD AZ_INLINE int64_t
+az_platform_file_mapping_get_size(az_platform_file_mapping const* mapping)
+{
+  return mapping->_internal.size;
+}
+
+/**
+ * @brief Gets the mapped contents of the file from \p offset, such as one block of a block blob.
+ *
+ * @param[in] mapping The #az_platform_file_mapping.
+ * @param[in] offset The position, in bytes, of the first byte of the span in the file.
+ * @param[in] size The size, in bytes, of the span. It is cut to the end of the file.
+ *
+ * @return An #az_span over the mapped contents, valid until the file is unmapped.
+ */
+AZ_NODISCARD AZ_INLINE az_span az_platform_file_mapping_get_span(
+    az_platform_file_mapping const* mapping,
+    int64_t offset,
+    int32_t size)
+{
+  int64_t const remaining = mapping->_internal.size - offset;
+  return az_span_create(
+      mapping->_internal.content + offset, remaining < size ? (int32_t)remaining : size);
+}
+
+/**
+ * @brief Writes \p content to \p file at \p offset, without moving the position of the file, so
+ * that the ranges of a download can be written as they complete, in any order and from several
+ * threads at once.
+ *
+ * @param[in] file The file, opened for writing: a file descriptor on POSIX, or a `HANDLE` on
+ * Windows, opened without `FILE_FLAG_OVERLAPPED`.
+ * @param[in] offset The position, in bytes, in the file of the first byte of \p content. The file
+ * grows if it ends before \p offset.
+ * @param[in] content The bytes to write.
+ *
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if all of \p content was written
+ *         - #AZ_ERROR_PLATFORM_FILE_IO if the file couldn't be written
+ *         - #AZ_ERROR_DEPENDENCY_NOT_PROVIDED if the platform has no files
+ */
+AZ_NODISCARD az_result az_platform_file_write_at(intptr_t file, int64_t offset, az_span content);
+
+/**
+ * @brief Reserves the disk space of the first \p size bytes of \p file, so that writing them
+ * later doesn't fail for lack of space or fragment the file.
+ *
+ * @param[in] file The file, opened for writing: a file descriptor on POSIX, or a `HANDLE` on
+ * Windows.
+ * @param[in] size The size, in bytes, to reserve.
+ *
+ * @remarks On POSIX, the file grows to \p size if it is smaller. On Windows, the clusters are
+ * reserved but the size of the file only grows as it is written.
+ *
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if the space was reserved
+ *         - #AZ_ERROR_PLATFORM_FILE_IO if the space couldn't be reserved
+ *         - #AZ_ERROR_DEPENDENCY_NOT_PROVIDED if the platform has no files
+ */
+AZ_NODISCARD az_result az_platform_file_allocate(intptr_t file, int64_t size);
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_PLATFORM_H
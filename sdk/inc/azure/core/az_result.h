@@ -28,6 +28,8 @@ enum
   _az_FACILITY_HTTP = 0x4,
   _az_FACILITY_MQTT = 0x5,
   _az_FACILITY_IOT = 0x6,
+  _az_FACILITY_STORAGE = 0x7,
+  _az_FACILITY_CBOR = 0x8,
 };
 
 enum
@@ -88,6 +90,9 @@ typedef enum
   /// Dynamic memory allocation request was not successful.
   AZ_ERROR_OUT_OF_MEMORY = _az_RESULT_MAKE_ERROR(_az_FACILITY_PLATFORM, 1),
 
+  /// A file could not be opened or mapped into memory.
+  AZ_ERROR_PLATFORM_FILE_IO = _az_RESULT_MAKE_ERROR(_az_FACILITY_PLATFORM, 2),
+
   // === JSON error codes ===
   /// The kind of the token being read is not compatible with the expected type of the value.
   AZ_ERROR_JSON_INVALID_STATE = _az_RESULT_MAKE_ERROR(_az_FACILITY_JSON, 1),
@@ -98,6 +103,19 @@ typedef enum
   /// No more JSON text left to process.
   AZ_ERROR_JSON_READER_DONE = _az_RESULT_MAKE_ERROR(_az_FACILITY_JSON, 3),
 
+  /// The JSON text fed to an incremental reader so far ends before the next token is complete.
+  AZ_ERROR_JSON_READER_NEED_MORE_DATA = _az_RESULT_MAKE_ERROR(_az_FACILITY_JSON, 4),
+
+  // === CBOR error codes ===
+  /// The kind of the CBOR token being read is not compatible with the expected type of the value.
+  AZ_ERROR_CBOR_INVALID_STATE = _az_RESULT_MAKE_ERROR(_az_FACILITY_CBOR, 1),
+
+  /// The CBOR maps and arrays are nested too deep.
+  AZ_ERROR_CBOR_NESTING_OVERFLOW = _az_RESULT_MAKE_ERROR(_az_FACILITY_CBOR, 2),
+
+  /// No more CBOR data items left to process.
+  AZ_ERROR_CBOR_READER_DONE = _az_RESULT_MAKE_ERROR(_az_FACILITY_CBOR, 3),
+
   // === HTTP error codes ===
   /// The #az_http_response instance is in an invalid state.
   AZ_ERROR_HTTP_INVALID_STATE = _az_RESULT_MAKE_ERROR(_az_FACILITY_HTTP, 1),
@@ -123,6 +141,9 @@ typedef enum
   /// There are no more headers within the HTTP response payload.
   AZ_ERROR_HTTP_END_OF_HEADERS = _az_RESULT_MAKE_ERROR(_az_FACILITY_HTTP, 8),
 
+  /// The request wasn't sent, because too many of the requests to its host failed recently.
+  AZ_ERROR_HTTP_CIRCUIT_OPEN = _az_RESULT_MAKE_ERROR(_az_FACILITY_HTTP, 10),
+
   // === HTTP Adapter error codes ===
   /// Generic error in the HTTP transport adapter implementation.
   AZ_ERROR_HTTP_ADAPTER = _az_RESULT_MAKE_ERROR(_az_FACILITY_HTTP, 9),
@@ -133,6 +154,24 @@ typedef enum
 
   /// While iterating, there are no more properties to return.
   AZ_ERROR_IOT_END_OF_PROPERTIES = _az_RESULT_MAKE_ERROR(_az_FACILITY_IOT, 2),
+
+  /// No telemetry can be sent from the queue yet, because the publish rate or the number of
+  /// messages in flight reached the limit of its options.
+  AZ_ERROR_IOT_QUEUE_THROTTLED = _az_RESULT_MAKE_ERROR(_az_FACILITY_IOT, 3),
+
+  // === Storage error codes ===
+  /// The CRC-64 the service computed for the content it received doesn't match the one computed as
+  /// the content was sent.
+  AZ_ERROR_STORAGE_CONTENT_CRC64_MISMATCH = _az_RESULT_MAKE_ERROR(_az_FACILITY_STORAGE, 1),
+
+  /// The service didn't append a block to an append blob.
+  AZ_ERROR_STORAGE_APPEND_FAILED = _az_RESULT_MAKE_ERROR(_az_FACILITY_STORAGE, 2),
+
+  /// While reading the results of a blob batch, there are no more results to return.
+  AZ_ERROR_STORAGE_END_OF_BATCH = _az_RESULT_MAKE_ERROR(_az_FACILITY_STORAGE, 3),
+
+  /// The service didn't return a range of a blob being downloaded.
+  AZ_ERROR_STORAGE_DOWNLOAD_FAILED = _az_RESULT_MAKE_ERROR(_az_FACILITY_STORAGE, 4),
 } az_result;
 
 /**
@@ -475,6 +475,88 @@ AZ_NODISCARD az_result az_span_u64toa(az_span destination, uint64_t source, az_s
 AZ_NODISCARD az_result
 az_span_dtoa(az_span destination, double source, int32_t fractional_digits, az_span* out_span);
 
+/**
+ * @brief Converts a `double` into the shortest digit characters (base 10 decimal notation) which
+ * convert back to the same `double`, and copies them to the \p destination #az_span starting at
+ * its 0-th index.
+ *
+ * @param destination The #az_span where the bytes should be copied to.
+ * @param[in] source The `double` whose number is copied to the \p destination #az_span as ASCII
+ * digits and characters.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the `double` has been copied.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is not big enough to contain the copied
+ * bytes. At most 25 bytes are needed.
+ * @retval #AZ_ERROR_NOT_SUPPORTED The \p source is not a finite decimal number.
+ *
+ * @remark Only finite `double` values are supported. Values such as `NaN` and `INFINITY` are not
+ * allowed.
+ *
+ * @remark Unlike #az_span_dtoa(), no digits are truncated and any magnitude is supported. Values
+ * from `1e-7` up to `1e21` are written in decimal notation, for example `0.1`, `1234.5` or `100`.
+ * Other values are written in scientific notation, for example `1e+21` or `1.5e-7`.
+ */
+AZ_NODISCARD az_result az_span_dtoa_shortest(az_span destination, double source, az_span* out_span);
+
+/// The size, in bytes, of the ISO 8601 timestamps written by #az_span_timestamp_to_iso8601(),
+/// such as `2020-10-14T12:34:56.789Z`.
+#define AZ_SPAN_ISO8601_TIMESTAMP_SIZE 24
+
+/**
+ * @brief The date and hour of the last timestamp written by #az_span_timestamp_to_iso8601(), so
+ * that the timestamps written within the same hour only format their minutes, seconds and
+ * milliseconds.
+ *
+ * @remarks A cache must not be used by several threads at the same time.
+ */
+typedef struct
+{
+  struct
+  {
+    int64_t hour_end_msec;
+    uint8_t hour_prefix[14];
+  } _internal;
+} az_span_timestamp_cache;
+
+/**
+ * @brief Initializes an #az_span_timestamp_cache, which holds no hour yet, as does one which is
+ * zero-initialized.
+ *
+ * @param[out] out_cache The #az_span_timestamp_cache to initialize.
+ */
+AZ_INLINE void az_span_timestamp_cache_init(az_span_timestamp_cache* out_cache)
+{
+  out_cache->_internal.hour_end_msec = 0;
+}
+
+/**
+ * @brief Writes a time as an ISO 8601 UTC timestamp, with milliseconds, such as
+ * `2020-10-14T12:34:56.789Z`, to the \p destination #az_span starting at its 0-th index.
+ *
+ * @param destination The #az_span where the bytes should be copied to.
+ * @param[in] epoch_msec The time, in milliseconds from 1/1/1970, until the end of the year 9999.
+ * @param[in,out] ref_cache __[nullable]__ The #az_span_timestamp_cache kept between the calls, or
+ * `NULL` to format the whole timestamp.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the timestamp has been copied.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is smaller than
+ * #AZ_SPAN_ISO8601_TIMESTAMP_SIZE.
+ *
+ * @remarks Unlike `gmtime()` and `strftime()`, it uses no global state and no locale. With a
+ * cache, the date is only computed once an hour.
+ */
+AZ_NODISCARD az_result az_span_timestamp_to_iso8601(
+    az_span destination,
+    int64_t epoch_msec,
+    az_span_timestamp_cache* ref_cache,
+    az_span* out_span);
+
 /******************************  NON-CONTIGUOUS SPAN  */
 
 /**
@@ -524,6 +606,73 @@ typedef az_result (*az_span_allocator_fn)(
     az_span_allocator_context* allocator_context,
     az_span* out_next_destination);
 
+/**
+ * @brief A caller-provided region of memory which buffers are carved from, one after the other, and
+ * which is then reset all at once.
+ *
+ * @details This bounds the memory used by an operation to the size of the region, without any
+ * dynamic memory allocation. Each buffer starts at a multiple of #AZ_SPAN_ARENA_ALIGNMENT bytes, so
+ * it can hold structures as well as bytes.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span buffer;
+    int32_t used;
+  } _internal;
+} az_span_arena;
+
+/// The alignment, in bytes, of the buffers allocated by #az_span_arena_allocate().
+#define AZ_SPAN_ARENA_ALIGNMENT 8
+
+/**
+ * @brief Initializes an #az_span_arena over a caller-provided buffer.
+ *
+ * @param[out] out_arena The #az_span_arena to initialize.
+ * @param[in] buffer The memory the buffers are allocated from. It must stay valid as long as the
+ * \p out_arena or any of its buffers are used.
+ */
+AZ_INLINE void az_span_arena_init(az_span_arena* out_arena, az_span buffer)
+{
+  *out_arena = (az_span_arena){ ._internal = { .buffer = buffer, .used = 0 } };
+}
+
+/**
+ * @brief Allocates a buffer from an #az_span_arena.
+ *
+ * @param[in,out] ref_arena The #az_span_arena to allocate from.
+ * @param[in] size The size, in bytes, of the buffer.
+ * @param[out] out_buffer A pointer to an #az_span which receives the buffer.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The rest of the arena is smaller than \p size.
+ */
+AZ_NODISCARD az_result
+az_span_arena_allocate(az_span_arena* ref_arena, int32_t size, az_span* out_buffer);
+
+/**
+ * @brief Releases all the buffers allocated from an #az_span_arena, so that its memory can be used
+ * again.
+ *
+ * @param[in,out] ref_arena The #az_span_arena to reset.
+ */
+AZ_INLINE void az_span_arena_reset(az_span_arena* ref_arena) { ref_arena->_internal.used = 0; }
+
+/**
+ * @brief Returns the number of bytes of an #az_span_arena which are allocated, including the
+ * padding between buffers.
+ *
+ * @param[in] arena The #az_span_arena.
+ *
+ * @return The number of bytes allocated since the arena was initialized or reset.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_span_arena_get_used_size(az_span_arena const* arena)
+{
+  return arena->_internal.used;
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_SPAN_H
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief This header defines the functions your application uses to let tracing tools receive the
+ * events of the Azure SDK static tracepoints.
+ *
+ * @details If you define the `AZ_TRACEPOINTS` symbol when compiling the SDK code (or adding option
+ * `-DTRACEPOINTS=ON` with cmake), the SDK has static tracepoints at the entry and exit of the HTTP
+ * pipeline, around the transport sending each request, at each retry attempt, where the JSON
+ * reader fails, and where the IoT clients parse topics and sign SAS tokens. They let you profile
+ * an application in production without rebuilding it with logging:
+ *
+ * - On Linux, each tracepoint is a USDT probe of the `azure_sdk` provider, which tools such as
+ * bpftrace and perf attach to (e.g. `bpftrace -e 'usdt:./app:azure_sdk:http_retry_attempt {
+ * printf("%d %d\n", arg1, arg2); }'`). A probe costs a single `nop` instruction while no tool is
+ * attached. Building with it needs the `sys/sdt.h` header, from the systemtap SDT development
+ * package.
+ * - On Windows, each tracepoint is a TraceLogging event of the `Azure.SDK.C` ETW provider, whose
+ * cost is a check of whether a session enabled the provider.
+ * - On other platforms, and without `AZ_TRACEPOINTS`, the tracepoints compile to nothing.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_TRACEPOINT_H
+#define _az_TRACEPOINT_H
+
+#include <azure/core/az_result.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief Registers the ETW provider of the SDK tracepoints, so that their events reach the tracing
+ * sessions which enable it.
+ *
+ * @details On Windows, call it once before the SDK is used, and call #az_tracepoint_unregister()
+ * before the SDK library is unloaded. Elsewhere, and without `AZ_TRACEPOINTS`, it does nothing, as
+ * USDT probes need no registration.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_OUT_OF_MEMORY ETW had no room left to register the provider.
+ */
+AZ_NODISCARD az_result az_tracepoint_register(void);
+
+/**
+ * @brief Unregisters the ETW provider #az_tracepoint_register() registered.
+ *
+ * @details Elsewhere than on Windows, and without `AZ_TRACEPOINTS`, it does nothing.
+ */
+void az_tracepoint_unregister(void);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_TRACEPOINT_H
@@ -0,0 +1,116 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief The atomic operations of the structures which can be shared by threads, such as the
+ * #az_http_response_pool, the #az_credential_token_cache, the #az_http_request_coalescer and the
+ * connection caches of the HTTP transport adapters.
+ *
+ * @details They use the GCC and Clang `__atomic` builtins, or the MSVC interlocked intrinsics.
+ * Other compilers get plain loads and stores, so their structures must only be used from a single
+ * thread.
+ */
+
+#ifndef _az_ATOMIC_INTERNAL_H
+#define _az_ATOMIC_INTERNAL_H
+
+#include <azure/core/az_result.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include <azure/core/_az_cfg_prefix.h>
+
+AZ_NODISCARD AZ_INLINE uint64_t _az_atomic_load(uint64_t volatile const* value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+  return *value;
+#endif
+}
+
+AZ_INLINE void _az_atomic_store(uint64_t volatile* value, uint64_t desired)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+  (void)_InterlockedExchange64((__int64 volatile*)value, (__int64)desired);
+#else
+  *value = desired;
+#endif
+}
+
+/*
+ * Adds \p addend to \p value, for the counters which several threads update, and returns the
+ * previous value.
+ */
+AZ_INLINE uint64_t _az_atomic_add(uint64_t volatile* value, uint64_t addend)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_fetch_add(value, addend, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER)
+  return (uint64_t)_InterlockedExchangeAdd64((__int64 volatile*)value, (__int64)addend);
+#else
+  uint64_t const previous = *value;
+  *value = previous + addend;
+  return previous;
+#endif
+}
+
+/*
+ * Sets \p value to \p desired if it is \p ref_expected, and otherwise updates \p ref_expected to
+ * the current value.
+ */
+AZ_NODISCARD AZ_INLINE bool _az_atomic_compare_exchange(
+    uint64_t volatile* value,
+    uint64_t* ref_expected,
+    uint64_t desired)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_compare_exchange_n(
+      value, ref_expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+  uint64_t const previous = (uint64_t)_InterlockedCompareExchange64(
+      (__int64 volatile*)value, (__int64)desired, (__int64)*ref_expected);
+  bool const is_exchanged = previous == *ref_expected;
+  *ref_expected = previous;
+  return is_exchanged;
+#else
+  bool const is_exchanged = *value == *ref_expected;
+  if (is_exchanged)
+  {
+    *value = desired;
+  }
+  else
+  {
+    *ref_expected = *value;
+  }
+  return is_exchanged;
+#endif
+}
+
+/*
+ * Takes the spin lock \p lock, which is `0` while it is free. It is meant for the short critical
+ * sections which only look up or copy a few fields, never for one which waits.
+ */
+AZ_INLINE void _az_atomic_spin_lock(uint64_t volatile* lock)
+{
+  uint64_t expected = 0;
+  while (!_az_atomic_compare_exchange(lock, &expected, 1))
+  {
+    expected = 0;
+  }
+}
+
+AZ_INLINE void _az_atomic_spin_unlock(uint64_t volatile* lock) { _az_atomic_store(lock, 0); }
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_ATOMIC_INTERNAL_H
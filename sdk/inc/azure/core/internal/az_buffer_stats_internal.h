@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#ifndef _az_BUFFER_STATS_INTERNAL_H
+#define _az_BUFFER_STATS_INTERNAL_H
+
+#include <azure/core/az_buffer_stats.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+// The buffers of az_buffer_stats, in the order of its fields.
+typedef enum
+{
+  _az_BUFFER_STATS_HTTP_REQUEST_URL,
+  _az_BUFFER_STATS_HTTP_REQUEST_HEADERS,
+  _az_BUFFER_STATS_HTTP_RESPONSE,
+  _az_BUFFER_STATS_JSON_WRITER,
+  _az_BUFFER_STATS_IOT_MQTT_TOPIC,
+  _az_BUFFER_STATS_IOT_MQTT_CLIENT_ID,
+  _az_BUFFER_STATS_IOT_MQTT_USER_NAME,
+  _az_BUFFER_STATS_IOT_MQTT_PASSWORD,
+  _az_BUFFER_STATS_COUNT,
+} _az_buffer_stats_kind;
+
+#ifdef AZ_BUFFER_STATS
+
+void _az_buffer_stats_record(_az_buffer_stats_kind kind, int32_t size);
+
+#define _az_BUFFER_STATS_RECORD(kind, size) _az_buffer_stats_record(kind, size)
+
+#else
+
+// The size isn't evaluated, so it must not have side effects.
+#define _az_BUFFER_STATS_RECORD(kind, size) ((void)0)
+
+#endif // AZ_BUFFER_STATS
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_BUFFER_STATS_INTERNAL_H
@@ -19,7 +19,7 @@ typedef struct
 {
   struct
   {
-    _az_http_policy policies[10];
+    _az_http_policy policies[13];
   } _internal;
 } _az_http_pipeline;
 
@@ -78,6 +78,100 @@ _az_http_policy_apiversion_options_default()
  */
 AZ_NODISCARD az_http_policy_retry_options _az_http_policy_retry_options_default();
 
+enum
+{
+  // The number of recent latencies the hedge policy picks its delay from.
+  _az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT = 16,
+};
+
+/**
+ * @brief Options for the coalescing policy.
+ *
+ * @remarks The policy comes before the credential policy, so requests only share a response with
+ * the requests authorized by the same #credential.
+ */
+typedef struct
+{
+  /// The coalescer the requests share responses through. If `NULL`, every request is sent.
+  az_http_request_coalescer* coalescer;
+
+  /// The credential the requests are authorized with, which may be `NULL`.
+  void const* credential;
+} _az_http_policy_coalescing_options;
+
+/**
+ * @brief Options for the hedge policy, which sends a second copy of a GET or HEAD request when the
+ * first one is slower than most recent requests, and uses whichever response arrives first.
+ *
+ * @remarks The policy sends requests with #az_http_client_async_submit(), so it must come directly
+ * before the transport policy. Requests with other methods, and responses with a body sink, go
+ * through the rest of the pipeline unchanged. The recent latencies are recorded and read under a
+ * spin lock, so the requests of a shared pipeline can go through the policy at the same time.
+ */
+typedef struct
+{
+  /// The client the requests are sent with. If `NULL`, the policy does nothing.
+  az_http_client_async* async_client;
+
+  /// The buffer the response to the second request is written to. The winning response is copied
+  /// to the response of the pipeline, so it should be as large as that one.
+  az_span hedge_response_buffer;
+
+  /// The percentile, between 1 and 100, of the recent latencies after which the second request is
+  /// sent.
+  int32_t percentile;
+
+  /// The delay, in milliseconds, before the second request is sent, until enough latencies were
+  /// measured.
+  int32_t initial_delay_msec;
+
+  struct
+  {
+    int32_t latencies_msec[_az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT];
+    int32_t latency_count;
+    int32_t next_latency;
+    // The spin lock of the latencies, which the requests of a shared pipeline record concurrently.
+    uint64_t volatile lock;
+  } _internal;
+} _az_http_policy_hedge_options;
+
+/**
+ * @brief Initialize _az_http_policy_hedge_options with default values
+ *
+ */
+AZ_NODISCARD _az_http_policy_hedge_options _az_http_policy_hedge_options_default();
+
+/**
+ * @brief Options for the compression policy, which sends request bodies compressed with gzip and
+ * decompresses gzip response bodies which are streamed to a body sink.
+ *
+ * @remarks The compressed body and the decompression state are allocated from #arena while the
+ * rest of the pipeline runs, and released when the policy returns. The policy must come after the
+ * retry policy, so that the body of each attempt is decompressed from its start.
+ *
+ * Request bodies are sent as they are when they come from a body provider, already have a
+ * `Content-Encoding` header, or don't get smaller. Responses are only asked for gzip when they
+ * have a body sink, and the bodies of failed responses, which are buffered, are left as the service
+ * sent them.
+ */
+typedef struct
+{
+  /// The arena the buffers are allocated from. If `NULL`, the policy does nothing.
+  az_span_arena* arena;
+
+  /// Request bodies smaller than this, in bytes, are sent as they are.
+  int32_t min_body_size;
+
+  /// Whether to ask for gzip response bodies and decompress them before they reach the body sink.
+  bool decompress_responses;
+} _az_http_policy_compression_options;
+
+/**
+ * @brief Initialize _az_http_policy_compression_options with default values
+ *
+ */
+AZ_NODISCARD _az_http_policy_compression_options _az_http_policy_compression_options_default();
+
 // PipelinePolicies
 //   Policies are non-allocating caveat the TransportPolicy
 //   Transport policies can only allocate if the transport layer they call allocates
@@ -112,12 +206,60 @@ AZ_NODISCARD az_result az_http_pipeline_policy_telemetry(
     az_http_request* ref_request,
     az_http_response* ref_response);
 
+AZ_NODISCARD az_result az_http_pipeline_policy_coalescing(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
+AZ_NODISCARD az_result az_http_pipeline_policy_response_cache(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
+AZ_NODISCARD az_result az_http_pipeline_policy_tracing(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
 AZ_NODISCARD az_result az_http_pipeline_policy_retry(
     _az_http_policy* ref_policies,
     void* ref_options,
     az_http_request* ref_request,
     az_http_response* ref_response);
 
+AZ_NODISCARD az_result az_http_pipeline_policy_circuit_breaker(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
+AZ_NODISCARD az_result az_http_pipeline_policy_rate_limit(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
+AZ_NODISCARD az_result az_http_pipeline_policy_hedge(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
+AZ_NODISCARD az_result az_http_pipeline_policy_metrics(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
+AZ_NODISCARD az_result az_http_pipeline_policy_compression(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response);
+
 AZ_NODISCARD az_result az_http_pipeline_policy_credential(
     _az_http_policy* ref_policies,
     void* ref_options,
@@ -154,6 +296,49 @@ AZ_NODISCARD AZ_INLINE az_result _az_http_pipeline_nextpolicy(
       &(ref_policies[1]), ref_policies[0]._internal.options, ref_request, ref_response);
 }
 
+/*
+ * The pipeline the SDK clients compose, as the policy which follows each policy of it. The
+ * policies call the one listed after them with _az_http_pipeline_nextpolicy_expecting(), so a
+ * pipeline composed in this order runs as a fixed sequence of direct calls.
+ */
+#define _az_HTTP_PIPELINE_FIRST_POLICY az_http_pipeline_policy_metrics
+#define _az_HTTP_PIPELINE_POLICY_AFTER_METRICS az_http_pipeline_policy_apiversion
+#define _az_HTTP_PIPELINE_POLICY_AFTER_APIVERSION az_http_pipeline_policy_telemetry
+#define _az_HTTP_PIPELINE_POLICY_AFTER_TELEMETRY az_http_pipeline_policy_coalescing
+#define _az_HTTP_PIPELINE_POLICY_AFTER_COALESCING az_http_pipeline_policy_response_cache
+#define _az_HTTP_PIPELINE_POLICY_AFTER_RESPONSE_CACHE az_http_pipeline_policy_tracing
+#define _az_HTTP_PIPELINE_POLICY_AFTER_TRACING az_http_pipeline_policy_retry
+#define _az_HTTP_PIPELINE_POLICY_AFTER_RETRY az_http_pipeline_policy_circuit_breaker
+#define _az_HTTP_PIPELINE_POLICY_AFTER_CIRCUIT_BREAKER az_http_pipeline_policy_rate_limit
+#define _az_HTTP_PIPELINE_POLICY_AFTER_RATE_LIMIT az_http_pipeline_policy_credential
+#ifndef AZ_NO_LOGGING
+#define _az_HTTP_PIPELINE_POLICY_AFTER_CREDENTIAL az_http_pipeline_policy_logging
+#define _az_HTTP_PIPELINE_POLICY_AFTER_LOGGING az_http_pipeline_policy_transport
+#else
+#define _az_HTTP_PIPELINE_POLICY_AFTER_CREDENTIAL az_http_pipeline_policy_transport
+#endif // AZ_NO_LOGGING
+
+/*
+ * Calls the next policy as _az_http_pipeline_nextpolicy() does, but calls \p expected_process
+ * directly when it is the next policy. The comparison is predicted much better than an indirect
+ * call, and the compiler can inline the policy. Pipelines composed in another order can still be
+ * processed, through the function pointers of their policies.
+ */
+AZ_NODISCARD AZ_INLINE az_result _az_http_pipeline_nextpolicy_expecting(
+    _az_http_policy* ref_policies,
+    _az_http_policy_process_fn expected_process,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  if (ref_policies[0]._internal.process == expected_process)
+  {
+    return expected_process(
+        &(ref_policies[1]), ref_policies[0]._internal.options, ref_request, ref_response);
+  }
+
+  return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+}
+
 /**
  * @brief Format buffer as a http request containing URL and header spans.
  *
@@ -186,6 +371,46 @@ AZ_NODISCARD az_result az_http_request_init(
     az_span headers_buffer,
     az_span body);
 
+/**
+ * @brief Gets where the query of \p url starts, as #az_http_request keeps it, so that a URL which
+ * many requests start with, such as the endpoint of a client, only needs to be scanned once.
+ *
+ * @param[in] url The URL.
+ *
+ * @return The index after the `?` of \p url, or `0` if \p url has no query.
+ */
+AZ_NODISCARD int32_t _az_http_url_get_query_start(az_span url);
+
+/**
+ * @brief Initializes an #az_http_request whose URL starts with \p url_prefix, which is copied to
+ * \p url_buffer without looking for its query again.
+ *
+ * @param[out] out_request Pointer to an #az_http_request to be initialized.
+ * @param[in] context A pointer to an #az_context node.
+ * @param[in] method HTTP verb: `"GET"`, `"POST"`, etc.
+ * @param[in] url_buffer The buffer the URL of the request is built in. Query parameters are
+ * appended to it after \p url_prefix.
+ * @param[in] url_prefix The URL the request starts with, such as the endpoint of a client.
+ * @param[in] url_prefix_query_start The value #_az_http_url_get_query_start() returned for
+ * \p url_prefix.
+ * @param[in] headers_buffer The #az_span to be used for storing headers for the request.
+ * @param[in] body The #az_span buffer that contains a payload for the request. Use #AZ_SPAN_EMPTY
+ * for requests that don't have a body.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p url_buffer is smaller than \p url_prefix.
+ */
+AZ_NODISCARD az_result _az_http_request_init_from_url_prefix(
+    az_http_request* out_request,
+    az_context* context,
+    az_http_method method,
+    az_span url_buffer,
+    az_span url_prefix,
+    int32_t url_prefix_query_start,
+    az_span headers_buffer,
+    az_span body);
+
 /**
  * @brief Set a query parameter at the end of url.
  *
@@ -218,6 +443,50 @@ AZ_NODISCARD az_result az_http_request_set_query_parameter(
     az_span value,
     bool is_value_url_encoded);
 
+/**
+ * @brief Sets a callback to provide the body of the request in chunks as it is sent, instead of
+ * from a contiguous buffer.
+ *
+ * @param ref_request HTTP request to set the body provider to.
+ * @param body_size The size of the body, in bytes, or #AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN when it
+ * isn't known before the body is provided. Such a body is sent with chunked transfer coding.
+ * @param body_provider The #az_http_request_body_provider_fn that fills the body chunks.
+ * @param user_context A context specific user-defined struct or set of fields that is passed
+ * through to calls to \p body_provider.
+ *
+ * @remarks The body provided replaces the body buffer given to #az_http_request_init().
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_http_request_set_body_provider(
+    az_http_request* ref_request,
+    int64_t body_size,
+    az_http_request_body_provider_fn body_provider,
+    void* user_context);
+
+/**
+ * @brief Sets the body of the request as an array of segments, which are sent one after the
+ * other, instead of from a contiguous buffer.
+ *
+ * @param ref_request HTTP request to set the body segments to.
+ * @param body_segments An array of \p number_of_segments #az_span, whose contents make up the body
+ * in order. The array and the segments must stay alive until the request is sent.
+ * @param number_of_segments The number of segments in \p body_segments.
+ *
+ * @remarks The body replaces the body buffer given to #az_http_request_init(). Its size, which
+ * transport adapters send as `Content-Length`, is the sum of the sizes of the segments. Transport
+ * adapters read it as they read the body of a body provider, straight from the segments, so they
+ * are never copied together.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_http_request_set_body_segments(
+    az_http_request* ref_request,
+    az_span const body_segments[],
+    int32_t number_of_segments);
+
 /**
  * @brief Add a new HTTP header for the request.
  *
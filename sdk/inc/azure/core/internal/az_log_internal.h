@@ -8,6 +8,7 @@
 #include <azure/core/az_span.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <azure/core/_az_cfg_prefix.h>
 
@@ -18,9 +19,32 @@
 bool _az_log_should_write(az_log_classification classification);
 void _az_log_write(az_log_classification classification, az_span message);
 
+#ifdef AZ_LOG_COMPILED_CLASSIFICATIONS
+
+// With a constant classification, the check is resolved at compile time and the code which only
+// runs when the message is logged is removed.
+#define _az_LOG_IS_COMPILED(classification) \
+  ((AZ_LOG_CLASSIFICATION_BIT(classification) & (uint64_t)(AZ_LOG_COMPILED_CLASSIFICATIONS)) != 0)
+
+#define _az_LOG_SHOULD_WRITE(classification) \
+  (_az_LOG_IS_COMPILED(classification) && _az_log_should_write(classification))
+
+#define _az_LOG_WRITE(classification, message)    \
+  do                                              \
+  {                                               \
+    if (_az_LOG_IS_COMPILED(classification))      \
+    {                                             \
+      _az_log_write(classification, message);     \
+    }                                             \
+  } while (0)
+
+#else
+
 #define _az_LOG_SHOULD_WRITE(classification) _az_log_should_write(classification)
 #define _az_LOG_WRITE(classification, message) _az_log_write(classification, message)
 
+#endif // AZ_LOG_COMPILED_CLASSIFICATIONS
+
 #else
 
 #define _az_LOG_SHOULD_WRITE(classification) false
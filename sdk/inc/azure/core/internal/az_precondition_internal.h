@@ -43,6 +43,17 @@
 
 az_precondition_failed_fn az_precondition_failed_get_callback();
 
+// Invokes the precondition failed callback. It is out of line, so that every precondition check
+// only costs a compare and a branch which is predicted as not taken, rather than also fetching and
+// calling the callback inline.
+void _az_precondition_failed(void);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define _az_PRECONDITION_UNLIKELY(condition) __builtin_expect(!!(condition), 0)
+#else
+#define _az_PRECONDITION_UNLIKELY(condition) (condition)
+#endif
+
 // __analysis_assume() tells MSVC's code analysis tool about the assumptions we have, so it doesn't
 // emit warnings for the statements that we put into _az_PRECONDITION().
 // Code analysis starts to fail with this condition some time around version 19.27; but
@@ -61,14 +72,14 @@ az_precondition_failed_fn az_precondition_failed_get_callback();
 #ifdef AZ_NO_PRECONDITION_CHECKING
 #define _az_PRECONDITION(condition)
 #else
-#define _az_PRECONDITION(condition)            \
-  do                                           \
-  {                                            \
-    if (!(condition))                          \
-    {                                          \
-      az_precondition_failed_get_callback()(); \
-    }                                          \
-    _az_ANALYSIS_ASSUME(condition);            \
+#define _az_PRECONDITION(condition)              \
+  do                                             \
+  {                                              \
+    if (_az_PRECONDITION_UNLIKELY(!(condition))) \
+    {                                            \
+      _az_precondition_failed();                 \
+    }                                            \
+    _az_ANALYSIS_ASSUME(condition);              \
   } while (0)
 #endif // AZ_NO_PRECONDITION_CHECKING
 
@@ -20,6 +20,41 @@ AZ_NODISCARD AZ_INLINE int32_t _az_retry_calc_delay(
                                                         : exponential_retry_after;
 }
 
+// xorshift32, which is enough to spread out retries and needs no platform entropy source. Zero is
+// the only state it cannot leave, so the state must be seeded with another value.
+AZ_NODISCARD AZ_INLINE uint32_t _az_retry_next_random(uint32_t* ref_state)
+{
+  uint32_t x = *ref_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *ref_state = x;
+  return x;
+}
+
+// Decorrelated jitter: a delay in [base, previous * 3] picked with the random value, capped at the
+// maximum delay.
+AZ_NODISCARD AZ_INLINE int32_t _az_retry_calc_decorrelated_delay(
+    uint32_t random,
+    int32_t previous_delay_msec,
+    int32_t retry_delay_msec,
+    int32_t max_retry_delay_msec)
+{
+  int64_t upper = (int64_t)previous_delay_msec * 3;
+  if (upper > max_retry_delay_msec)
+  {
+    upper = max_retry_delay_msec;
+  }
+
+  if (upper <= retry_delay_msec)
+  {
+    return (int32_t)upper;
+  }
+
+  uint32_t const range = (uint32_t)(upper - retry_delay_msec) + 1;
+  return retry_delay_msec + (int32_t)(random % range);
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_RETRY_INTERNAL_H
@@ -8,7 +8,9 @@
 #include <azure/core/az_span.h>
 #include <azure/core/internal/az_precondition_internal.h>
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <azure/core/_az_cfg_prefix.h>
 
@@ -25,6 +27,92 @@ AZ_INLINE AZ_NODISCARD int32_t _az_span_diff(az_span sliced_span, az_span origin
   return answer;
 }
 
+// The _unchecked functions below are the precondition-free equivalents of #az_span_slice(),
+// #az_span_slice_to_end(), #az_span_copy() and #az_span_copy_u8(), for the inner loops of functions
+// which validate their spans, and the size they need, once at the API boundary rather than once per
+// byte or token. The caller guarantees the indexes are in range and the \p destination is large
+// enough; nothing is capped, so getting it wrong corrupts memory.
+
+AZ_NODISCARD AZ_INLINE az_span
+_az_span_slice_unchecked(az_span span, int32_t start_index, int32_t end_index)
+{
+  return (az_span){ ._internal = { .ptr = az_span_ptr(span) + start_index,
+                                   .size = end_index - start_index } };
+}
+
+AZ_NODISCARD AZ_INLINE az_span _az_span_slice_to_end_unchecked(az_span span, int32_t start_index)
+{
+  return _az_span_slice_unchecked(span, start_index, az_span_size(span));
+}
+
+AZ_INLINE az_span _az_span_copy_unchecked(az_span destination, az_span source)
+{
+  int32_t const src_size = az_span_size(source);
+
+  // memmove() with a null pointer is undefined, even to move no bytes.
+  if (src_size > 0)
+  {
+    memmove((void*)az_span_ptr(destination), (void const*)az_span_ptr(source), (size_t)src_size);
+  }
+
+  return _az_span_slice_to_end_unchecked(destination, src_size);
+}
+
+AZ_INLINE az_span _az_span_copy_u8_unchecked(az_span destination, uint8_t byte)
+{
+  az_span_ptr(destination)[0] = byte;
+  return _az_span_slice_to_end_unchecked(destination, 1);
+}
+
+// Returns the bits which differ between the eight bytes at \p a and those at \p b.
+AZ_NODISCARD AZ_INLINE uint64_t _az_span_word_difference(uint8_t const* a, uint8_t const* b)
+{
+  uint64_t a_word = 0;
+  uint64_t b_word = 0;
+  memcpy(&a_word, a, sizeof(a_word));
+  memcpy(&b_word, b, sizeof(b_word));
+  return a_word ^ b_word;
+}
+
+/**
+ * @brief Determines whether \p span starts with the bytes of \p prefix.
+ *
+ * @details The bytes are compared eight at a time, the last word overlapping the one before it, so
+ * that a well-known prefix such as an MQTT topic prefix takes one or two word comparisons. When
+ * \p prefix is a literal, such as an #AZ_SPAN_LITERAL_FROM_STR() constant, and the call is
+ * inlined, the compiler folds the words of the prefix into constants.
+ *
+ * @param[in] span The #az_span to check the start of.
+ * @param[in] prefix The #az_span to compare with the start of \p span.
+ * @return `true` if the first `az_span_size(prefix)` bytes of \p span are those of \p prefix.
+ */
+AZ_NODISCARD AZ_INLINE bool _az_span_starts_with(az_span span, az_span prefix)
+{
+  int32_t const prefix_size = az_span_size(prefix);
+  if (az_span_size(span) < prefix_size)
+  {
+    return false;
+  }
+
+  uint8_t const* const span_ptr = az_span_ptr(span);
+  uint8_t const* const prefix_ptr = az_span_ptr(prefix);
+  if (prefix_size < 8)
+  {
+    return prefix_size == 0 || memcmp(span_ptr, prefix_ptr, (size_t)prefix_size) == 0;
+  }
+
+  // The last word overlaps the one before it, unless the size is a multiple of eight.
+  int32_t const last_offset = prefix_size - 8;
+  uint64_t difference = 0;
+  for (int32_t offset = 0; offset < last_offset; offset += 8)
+  {
+    difference |= _az_span_word_difference(span_ptr + offset, prefix_ptr + offset);
+  }
+
+  difference |= _az_span_word_difference(span_ptr + last_offset, prefix_ptr + last_offset);
+  return difference == 0;
+}
+
 /**
  * @brief Copies character from the \p source #az_span to the \p destination #az_span by
  * URL-encoding the \p source span characters.
@@ -51,6 +139,8 @@ _az_span_url_encode(az_span destination, az_span source, int32_t* out_length);
  * @param[in] source The #az_span containing the non-URL-encoded bytes.
  * @return The length of source if it would be url-encoded.
  *
+ * @remark Nothing is written, so the result can be used to size the destination of
+ * #_az_span_url_encode() exactly, rather than for the worst case of three bytes per byte.
  */
 AZ_NODISCARD int32_t _az_span_url_encode_calc_length(az_span source);
 
@@ -77,6 +167,149 @@ az_span _az_span_token(
     az_span* out_remainder,
     int32_t* out_index);
 
+/**
+ * @brief Calculates the number of decimal digits needed to write \p value as text.
+ *
+ * @param[in] value The number whose digits are counted.
+ * @return The number of digits `az_span_u32toa()` writes for \p value, between 1 and 10.
+ */
+AZ_NODISCARD int32_t _az_span_u32_digit_count(uint32_t value);
+
+/**
+ * @brief Calculates the number of decimal digits needed to write \p value as text.
+ *
+ * @param[in] value The number whose digits are counted.
+ * @return The number of digits `az_span_u64toa()` writes for \p value, between 1 and 20.
+ */
+AZ_NODISCARD int32_t _az_span_u64_digit_count(uint64_t value);
+
+/**
+ * @brief Builds text, such as an MQTT topic or a URL, out of pieces with a single capacity check.
+ *
+ * @details Pieces are appended without checking the result of each one. Once a piece doesn't fit,
+ * the later ones are no longer written but their size is still added, so that
+ * #_az_span_builder_length() is the size the whole text needs and #_az_span_builder_result() is
+ * checked once at the end.
+ *
+ * A builder made with #_az_span_builder_init() copies all of the pieces into its buffer. One made
+ * with #_az_span_builder_init_segmented() instead collects a list of segments, as for a vectored
+ * write: appended spans are referenced where they are, without being copied, and only the text
+ * produced by the builder, such as digits and URL-encoded bytes, is written to its buffer.
+ */
+typedef struct
+{
+  az_span buffer;
+  az_span* segments;
+  int32_t segments_capacity;
+  int32_t segment_count;
+  int32_t buffer_length;
+  int32_t length;
+  bool overflowed;
+} _az_span_builder;
+
+/**
+ * @brief Initializes a builder which writes the text into \p buffer.
+ *
+ * @param[out] builder The #_az_span_builder to initialize.
+ * @param[in] buffer The #az_span the text is written to.
+ */
+void _az_span_builder_init(_az_span_builder* builder, az_span buffer);
+
+/**
+ * @brief Initializes a builder which collects the text as a list of segments.
+ *
+ * @param[out] builder The #_az_span_builder to initialize.
+ * @param[in] buffer The #az_span the text produced by the builder is written to. It may be empty if
+ * only spans are appended.
+ * @param[out] segments The array the segments are written to. Consecutive pieces which are also
+ * consecutive in memory share a segment.
+ * @param[in] segments_capacity The number of elements of \p segments.
+ */
+void _az_span_builder_init_segmented(
+    _az_span_builder* builder,
+    az_span buffer,
+    az_span* segments,
+    int32_t segments_capacity);
+
+/**
+ * @brief Appends the contents of \p source.
+ *
+ * @param[in,out] builder The #_az_span_builder to append to.
+ * @param[in] source The #az_span to append. With a segmented builder, it must stay valid for as
+ * long as the segments are used.
+ */
+void _az_span_builder_append(_az_span_builder* builder, az_span source);
+
+/**
+ * @brief Appends one byte.
+ *
+ * @param[in,out] builder The #_az_span_builder to append to.
+ * @param[in] byte The byte to append.
+ */
+void _az_span_builder_append_u8(_az_span_builder* builder, uint8_t byte);
+
+/**
+ * @brief Appends the decimal digits of \p value, as `az_span_u32toa()` writes them.
+ *
+ * @param[in,out] builder The #_az_span_builder to append to.
+ * @param[in] value The number to append.
+ */
+void _az_span_builder_append_u32(_az_span_builder* builder, uint32_t value);
+
+/**
+ * @brief Appends the decimal digits of \p value, as `az_span_u64toa()` writes them.
+ *
+ * @param[in,out] builder The #_az_span_builder to append to.
+ * @param[in] value The number to append.
+ */
+void _az_span_builder_append_u64(_az_span_builder* builder, uint64_t value);
+
+/**
+ * @brief Appends \p source URL-encoded, as #_az_span_url_encode() writes it.
+ *
+ * @param[in,out] builder The #_az_span_builder to append to.
+ * @param[in] source The #az_span containing the non-URL-encoded bytes. It must not overlap the
+ * buffer of the builder.
+ */
+void _az_span_builder_append_url_encoded(_az_span_builder* builder, az_span source);
+
+/**
+ * @brief Returns whether all of the appended pieces fit.
+ *
+ * @param[in] builder The #_az_span_builder.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if all of the pieces were written
+ *         - #AZ_ERROR_NOT_ENOUGH_SPACE if the builder ran out of buffer or segments
+ */
+AZ_NODISCARD AZ_INLINE az_result _az_span_builder_result(_az_span_builder const* builder)
+{
+  return builder->overflowed ? AZ_ERROR_NOT_ENOUGH_SPACE : AZ_OK;
+}
+
+/**
+ * @brief Returns the length of the appended text, including the pieces which didn't fit.
+ *
+ * @param[in] builder The #_az_span_builder.
+ * @return The size of the text, which is the size the buffer needs when the builder isn't
+ * segmented.
+ */
+AZ_NODISCARD AZ_INLINE int32_t _az_span_builder_length(_az_span_builder const* builder)
+{
+  return builder->length;
+}
+
+/**
+ * @brief Returns the part of the buffer written to, which is the whole text when the builder isn't
+ * segmented.
+ *
+ * @param[in] builder The #_az_span_builder.
+ * @return An #az_span over the bytes written to the buffer of the builder.
+ */
+AZ_NODISCARD AZ_INLINE az_span _az_span_builder_get_span(_az_span_builder const* builder)
+{
+  return az_span_slice(builder->buffer, 0, builder->buffer_length);
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_SPAN_INTERNAL_H
@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief The static tracepoints of the SDK, described in az_tracepoint.h.
+ *
+ * @details `_az_TRACEPOINTn(name, ...)` fires the tracepoint `name` with `n` integer or pointer
+ * arguments, `arg0` to `arg2` for the tracing tools. Without `AZ_TRACEPOINTS`, or on a platform
+ * with no static tracing, the arguments aren't evaluated, so they must not have side effects.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_TRACEPOINT_INTERNAL_H
+#define _az_TRACEPOINT_INTERNAL_H
+
+#include <azure/core/az_tracepoint.h>
+
+#include <stdint.h>
+
+#if defined(AZ_TRACEPOINTS) && defined(__linux__)
+
+#include <sys/sdt.h>
+
+#define _az_TRACEPOINT1(name, a) DTRACE_PROBE1(azure_sdk, name, a)
+#define _az_TRACEPOINT2(name, a, b) DTRACE_PROBE2(azure_sdk, name, a, b)
+#define _az_TRACEPOINT3(name, a, b, c) DTRACE_PROBE3(azure_sdk, name, a, b, c)
+
+#elif defined(AZ_TRACEPOINTS) && defined(_WIN32)
+
+#include <windows.h>
+
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(_az_tracepoint_provider);
+
+#define _az_TRACEPOINT_ARG(value, field) TraceLoggingInt64((int64_t)(intptr_t)(value), field)
+
+#define _az_TRACEPOINT1(name, a) \
+  TraceLoggingWrite(_az_tracepoint_provider, #name, _az_TRACEPOINT_ARG(a, "arg0"))
+#define _az_TRACEPOINT2(name, a, b) \
+  TraceLoggingWrite( \
+      _az_tracepoint_provider, \
+      #name, \
+      _az_TRACEPOINT_ARG(a, "arg0"), \
+      _az_TRACEPOINT_ARG(b, "arg1"))
+#define _az_TRACEPOINT3(name, a, b, c) \
+  TraceLoggingWrite( \
+      _az_tracepoint_provider, \
+      #name, \
+      _az_TRACEPOINT_ARG(a, "arg0"), \
+      _az_TRACEPOINT_ARG(b, "arg1"), \
+      _az_TRACEPOINT_ARG(c, "arg2"))
+
+#else
+
+#define _az_TRACEPOINT1(name, a) ((void)0)
+#define _az_TRACEPOINT2(name, a, b) ((void)0)
+#define _az_TRACEPOINT3(name, a, b, c) ((void)0)
+
+#endif // AZ_TRACEPOINTS
+
+#endif // _az_TRACEPOINT_INTERNAL_H
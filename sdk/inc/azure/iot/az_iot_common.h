@@ -89,6 +89,21 @@ https://docs.microsoft.com/en-us/azure/iot-hub/iot-hub-distributed-tracing. */
 #define AZ_IOT_MESSAGE_PROPERTIES_USER_ID "%24.uid" /**< User ID field. */
 #define AZ_IOT_MESSAGE_PROPERTIES_CREATION_TIME "%24.ctime" /**< Creation time of the message. */
 
+/**
+ * @brief The URL encoded content type of a payload written with #az_cbor_writer.
+ */
+#define AZ_IOT_MESSAGE_CONTENT_TYPE_CBOR "application%2Fcbor"
+
+/**
+ * @brief A name-value pair of an #az_iot_message_properties index.
+ *
+ */
+typedef struct
+{
+  az_span name; /**< The name of the property. */
+  az_span value; /**< The value of the property. */
+} az_iot_message_property;
+
 /**
  * @brief Telemetry or C2D properties.
  *
@@ -100,6 +115,9 @@ typedef struct
     az_span properties_buffer;
     int32_t properties_written;
     uint32_t current_property_index;
+    az_iot_message_property* index;
+    int32_t index_capacity;
+    int32_t index_count;
   } _internal;
 } az_iot_message_properties;
 
@@ -152,6 +170,21 @@ AZ_NODISCARD az_result az_iot_message_properties_append(
     az_span name,
     az_span value);
 
+/**
+ * @brief Appends the content type and content encoding properties of a CBOR payload, as written
+ * with #az_cbor_writer, so that IoT Hub message routing can read it.
+ *
+ * @remark Text strings in CBOR are always UTF-8, which is appended as the content encoding.
+ *
+ * @param[in] properties The #az_iot_message_properties to use for this call.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The operation was performed successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE There was not enough space to append the properties. The
+ * properties are left unchanged.
+ */
+AZ_NODISCARD az_result
+az_iot_message_properties_append_cbor_content_type(az_iot_message_properties* properties);
+
 /**
  * @brief Finds the value of a property.
  * @remark This will return the first value of the property with the given name if multiple
@@ -169,6 +202,27 @@ AZ_NODISCARD az_result az_iot_message_properties_find(
     az_span name,
     az_span* out_value);
 
+/**
+ * @brief Builds an index of the name-value pairs of the properties, so that later calls to
+ * az_iot_message_properties_find() and az_iot_message_properties_next() don't re-scan the buffer.
+ *
+ * @remark Properties appended afterwards with az_iot_message_properties_append() are added to the
+ * index while it has room. Once it is full, the index is dropped and the buffer is scanned again.
+ *
+ * @param[in] properties The #az_iot_message_properties to use for this call.
+ * @param[in] index An array of \p index_capacity #az_iot_message_property, which must remain valid
+ * for as long as \p properties is used.
+ * @param[in] index_capacity The number of elements in \p index. Must be positive.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The index was built successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE There are more properties than \p index_capacity. The
+ * properties are left without an index.
+ */
+AZ_NODISCARD az_result az_iot_message_properties_build_index(
+    az_iot_message_properties* properties,
+    az_iot_message_property* index,
+    int32_t index_capacity);
+
 /**
  * @brief Iterates over the list of properties.
  *
@@ -225,6 +279,257 @@ AZ_NODISCARD int32_t az_iot_calculate_retry_delay(
     int32_t max_retry_delay_msec,
     int32_t random_jitter_msec);
 
+/**
+ * @brief How an #az_iot_retry spreads the delays of devices which failed at the same time.
+ */
+typedef enum
+{
+  /// The delay is picked at random between the minimum delay and the delay doubled with each
+  /// failed attempt, up to the maximum delay.
+  AZ_IOT_RETRY_JITTER_FULL = 0,
+
+  /// The delay is picked at random between the minimum delay and three times the previous delay,
+  /// up to the maximum delay.
+  AZ_IOT_RETRY_JITTER_DECORRELATED = 1,
+} az_iot_retry_jitter;
+
+/**
+ * @brief Defines the callback an #az_iot_retry calls for a random number, instead of its built-in
+ * generator.
+ *
+ * @param[in] user_context The user-provided context which is passed to the callback.
+ * @return A random number, uniformly distributed over the `uint32_t` values.
+ */
+typedef uint32_t (*az_iot_retry_random_callback)(void* user_context);
+
+/**
+ * @brief Options of an #az_iot_retry.
+ *
+ */
+typedef struct
+{
+  /// How the delays are spread. The default is #AZ_IOT_RETRY_JITTER_FULL.
+  az_iot_retry_jitter jitter;
+
+  /// The minimum delay, in milliseconds, before a retry. The default is 1 second.
+  int32_t min_retry_delay_msec;
+
+  /// The maximum delay, in milliseconds, before a retry. The default is 100 seconds.
+  int32_t max_retry_delay_msec;
+
+  /// The minimum delay, in milliseconds, once IoT Hub throttles the device with
+  /// #AZ_IOT_STATUS_THROTTLED, which replaces `min_retry_delay_msec` from then on. The default is
+  /// 10 seconds.
+  int32_t throttled_min_retry_delay_msec;
+
+  /// The seed of the built-in random number generator. Devices of a fleet must use different
+  /// seeds, such as a hash of their device ID or a value of their hardware random number
+  /// generator, or they pick the same delays. The default is 0, which stands for a fixed seed.
+  uint32_t random_seed;
+
+  /// __[nullable]__ A random number generator which replaces the built-in one. The default is
+  /// `NULL`.
+  az_iot_retry_random_callback random_callback;
+
+  /// The context passed to `random_callback`.
+  void* random_user_context;
+} az_iot_retry_options;
+
+/**
+ * @brief The state of the retries of an operation, such as connecting to IoT Hub.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_retry_options options;
+    uint32_t random_state;
+    int32_t previous_delay_msec;
+    int16_t attempt;
+    bool is_throttled;
+  } _internal;
+} az_iot_retry;
+
+/**
+ * @brief Gets the default #az_iot_retry_options.
+ *
+ * @return An #az_iot_retry_options.
+ */
+AZ_NODISCARD az_iot_retry_options az_iot_retry_options_default();
+
+/**
+ * @brief Initializes an #az_iot_retry with no failed attempts.
+ *
+ * @param[out] retry The #az_iot_retry to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_retry_options structure. If `NULL` is
+ *                    passed, the default options are used.
+ */
+void az_iot_retry_init(az_iot_retry* retry, az_iot_retry_options const* options);
+
+/**
+ * @brief Records a failed attempt and calculates the delay before the next one.
+ *
+ * @details The delay grows exponentially with the number of failed attempts, and is randomized as
+ * set by the `jitter` option, so that the devices which are disconnected together don't reconnect
+ * together.
+ *
+ * @param[in,out] retry The #az_iot_retry to use for this call.
+ * @param[in] status The status of the failure, or #AZ_IOT_STATUS_UNKNOWN if there is none, as when
+ *                   the connection failed.
+ * @param[in] operation_msec The time it took, in milliseconds, to perform the operation that
+ *                           failed. It is subtracted from the delay.
+ * @param[out] out_delay_msec The delay, in milliseconds, before the next attempt.
+ * @return `true` if the operation should be retried after \p out_delay_msec. `false` if \p status
+ * is not retriable, as defined by az_iot_status_retriable().
+ */
+AZ_NODISCARD bool az_iot_retry_next_delay(
+    az_iot_retry* retry,
+    az_iot_status status,
+    int32_t operation_msec,
+    int32_t* out_delay_msec);
+
+/**
+ * @brief Resets an #az_iot_retry after the operation succeeded, keeping its random state.
+ *
+ * @param[in,out] retry The #az_iot_retry to reset.
+ */
+void az_iot_retry_reset(az_iot_retry* retry);
+
+/*
+ *
+ * Pending Request APIs
+ *
+ *   Twin and provisioning requests carry a request ID (`$rid`) which their responses echo. Use
+ *   these APIs to generate the request IDs and to match each response to the request it answers.
+ */
+
+/**
+ * @brief The largest size, in bytes, of a request ID generated by
+ * az_iot_pending_request_table_add(): the digits of `UINT32_MAX`.
+ */
+#define AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE 10
+
+/**
+ * @brief A slot of an #az_iot_pending_request_table.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    uint32_t request_id;
+    int64_t expiration_msec;
+    void* user_context;
+  } _internal;
+} az_iot_pending_request;
+
+/**
+ * @brief A fixed set of requests waiting for their response, keyed by their request ID.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_pending_request* slots;
+    int32_t slot_count;
+    int32_t request_count;
+    uint32_t last_request_id;
+  } _internal;
+} az_iot_pending_request_table;
+
+/**
+ * @brief Initializes an #az_iot_pending_request_table with no pending requests.
+ *
+ * @param[out] table The #az_iot_pending_request_table to initialize.
+ * @param[in] slots The array of the hash table which holds the pending requests. It must outlive
+ *                  \p table.
+ * @param[in] slot_count The number of elements in \p slots. It must be a power of two, at least 2.
+ *                       One slot is always left empty, and a table at most half full keeps lookups
+ *                       short.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_pending_request_table_init(
+    az_iot_pending_request_table* table,
+    az_iot_pending_request* slots,
+    int32_t slot_count);
+
+/**
+ * @brief Adds a pending request to an #az_iot_pending_request_table, and generates its request ID.
+ *
+ * @details Request IDs are consecutive decimal numbers, so that they are generated and looked up
+ * without hashing or comparing strings.
+ *
+ * @param[in,out] table The #az_iot_pending_request_table to use for this call.
+ * @param[in] expiration_msec The time, as given by az_platform_clock_msec(), after which
+ *                            az_iot_pending_request_table_expire() removes the request.
+ * @param[in] user_context __[nullable]__ A pointer identifying the request to the application,
+ *                         returned when the request is removed.
+ * @param[in] request_id_buffer An #az_span which receives the request ID. At most
+ *                              #AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE bytes are written.
+ * @param[out] out_request_id The request ID, within \p request_id_buffer, to send with the
+ *                            request.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The request was added.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The table is full, or \p request_id_buffer is too small.
+ */
+AZ_NODISCARD az_result az_iot_pending_request_table_add(
+    az_iot_pending_request_table* table,
+    int64_t expiration_msec,
+    void* user_context,
+    az_span request_id_buffer,
+    az_span* out_request_id);
+
+/**
+ * @brief Removes the pending request a response answers.
+ *
+ * @param[in,out] table The #az_iot_pending_request_table to use for this call.
+ * @param[in] request_id The request ID of the response, such as the `request_id` of an
+ *                       #az_iot_hub_client_twin_response.
+ * @param[out] out_user_context __[nullable]__ The user context the request was added with. Can be
+ *                              `NULL`.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The request was pending and is removed.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND No pending request has this request ID, because it expired,
+ *                                  was already answered, or was not sent by this table.
+ */
+AZ_NODISCARD az_result az_iot_pending_request_table_complete(
+    az_iot_pending_request_table* table,
+    az_span request_id,
+    void** out_user_context);
+
+/**
+ * @brief Removes a pending request whose expiration time has passed.
+ *
+ * @details Call this in a loop, for instance once per iteration of the MQTT receive loop, until
+ * it returns #AZ_ERROR_ITEM_NOT_FOUND. Each call goes through the slots of the table.
+ *
+ * @param[in,out] table The #az_iot_pending_request_table to use for this call.
+ * @param[in] now_msec The current time, as given by az_platform_clock_msec().
+ * @param[out] out_user_context __[nullable]__ The user context the expired request was added
+ *                              with. Can be `NULL`.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK An expired request is removed.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND No pending request has expired.
+ */
+AZ_NODISCARD az_result az_iot_pending_request_table_expire(
+    az_iot_pending_request_table* table,
+    int64_t now_msec,
+    void** out_user_context);
+
+/**
+ * @brief Gets the number of requests of an #az_iot_pending_request_table that are pending.
+ *
+ * @param[in] table The #az_iot_pending_request_table to use for this call.
+ * @return The number of pending requests.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_iot_pending_request_table_get_count(az_iot_pending_request_table const* table)
+{
+  return table->_internal.request_count;
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif //!_az_IOT_CORE_H
@@ -17,6 +17,7 @@
 #ifndef _az_IOT_HUB_CLIENT_H
 #define _az_IOT_HUB_CLIENT_H
 
+#include <azure/core/az_json.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
 #include <azure/iot/az_iot_common.h>
@@ -35,29 +36,71 @@ enum
   AZ_HUB_CLIENT_DEFAULT_MQTT_TELEMETRY_QOS = 0
 };
 
+/**
+ * @brief The size, in bytes, of an #az_iot_hub_client_options.topic_prefix_buffer large enough
+ * for a device id of \p device_id_size and a module id of \p module_id_size bytes.
+ */
+#define AZ_IOT_HUB_CLIENT_TOPIC_PREFIX_BUFFER_SIZE(device_id_size, module_id_size) \
+  (35 + (device_id_size) + (module_id_size))
+
 /**
  * @brief Azure IoT Hub Client options.
  *
  */
 typedef struct
 {
+#ifndef AZ_NO_IOT_HUB_MODULE_ID
   az_span module_id; /**< The module name (if a module identity is used). */
+#endif // AZ_NO_IOT_HUB_MODULE_ID
   az_span user_agent; /**< The user-agent is a formatted string that will be used for Azure IoT
                          usage statistics. */
+#ifndef AZ_NO_IOT_HUB_MODEL_ID
   az_span model_id; /**< The model id used to identify the capabilities of a device based on the
                        Digital Twin document. */
+#endif // AZ_NO_IOT_HUB_MODEL_ID
+  az_span topic_prefix_buffer; /**< Optional buffer in which the client builds its telemetry topic
+                                  prefix once, during init. Size it with
+                                  #AZ_IOT_HUB_CLIENT_TOPIC_PREFIX_BUFFER_SIZE and keep it valid
+                                  for the lifetime of the client. */
 } az_iot_hub_client_options;
 
+/**
+ * @brief The hostname and options which any number of #az_iot_hub_client can share.
+ *
+ * @details The clients initialized from one #az_iot_hub_client_shared with
+ * az_iot_hub_client_init_shared(), such as the devices of a fleet simulator, use the same hostname,
+ * module ID, model ID and user agent. When the SDK is built with `AZ_IOT_HUB_LEAN_CLIENT` defined,
+ * each of them only holds a reference to the #az_iot_hub_client_shared and its device ID.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span iot_hub_hostname;
+    az_iot_hub_client_options options;
+  } _internal;
+} az_iot_hub_client_shared;
+
 /**
  * @brief Azure IoT Hub Client.
+ *
+ * @remark When `AZ_IOT_HUB_LEAN_CLIENT` is defined, the client refers to an
+ * #az_iot_hub_client_shared instead of holding the hostname and options, and doesn't cache its
+ * telemetry topic prefix, so it must be initialized with az_iot_hub_client_init_shared().
  */
 typedef struct
 {
   struct
   {
+#ifdef AZ_IOT_HUB_LEAN_CLIENT
+    az_iot_hub_client_shared const* shared;
+    az_span device_id;
+#else
     az_span iot_hub_hostname;
     az_span device_id;
     az_iot_hub_client_options options;
+    az_span telemetry_topic_prefix;
+#endif // AZ_IOT_HUB_LEAN_CLIENT
   } _internal;
 } az_iot_hub_client;
 
@@ -70,6 +113,7 @@ typedef struct
  */
 AZ_NODISCARD az_iot_hub_client_options az_iot_hub_client_options_default();
 
+#ifndef AZ_IOT_HUB_LEAN_CLIENT
 /**
  * @brief Initializes an Azure IoT Hub Client.
  *
@@ -86,12 +130,46 @@ AZ_NODISCARD az_iot_hub_client_options az_iot_hub_client_options_default();
  * calling az_iot_hub_client_options_default() and then populating relevant options with your own
  * values.
  * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The #az_iot_hub_client_options.topic_prefix_buffer is not
+ * empty but too small to hold the telemetry topic prefix.
+ *
+ * @remark When #az_iot_hub_client_options.topic_prefix_buffer is not empty, the
+ * `devices/{device_id}[/modules/{module_id}]/messages/events/` prefix is written to it here, and
+ * az_iot_hub_client_telemetry_get_publish_topic() copies it instead of assembling it every call.
  */
 AZ_NODISCARD az_result az_iot_hub_client_init(
     az_iot_hub_client* client,
     az_span iot_hub_hostname,
     az_span device_id,
     az_iot_hub_client_options const* options);
+#endif // AZ_IOT_HUB_LEAN_CLIENT
+
+/**
+ * @brief Initializes an #az_iot_hub_client_shared.
+ *
+ * @param[out] shared The #az_iot_hub_client_shared to initialize.
+ * @param[in] iot_hub_hostname The IoT Hub Hostname.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_hub_client_options structure shared
+ *                    by every client. Its `topic_prefix_buffer` must be empty, since the prefix is
+ *                    specific to one device. If `NULL` is passed, the default options are used.
+ */
+void az_iot_hub_client_shared_init(
+    az_iot_hub_client_shared* shared,
+    az_span iot_hub_hostname,
+    az_iot_hub_client_options const* options);
+
+/**
+ * @brief Initializes an Azure IoT Hub Client with the hostname and options of an
+ * #az_iot_hub_client_shared.
+ *
+ * @param[out] client The #az_iot_hub_client to use for this call.
+ * @param[in] shared The #az_iot_hub_client_shared of the client. It must outlive \p client.
+ * @param[in] device_id The Device ID, percent-encoded as for az_iot_hub_client_init().
+ */
+void az_iot_hub_client_init_shared(
+    az_iot_hub_client* client,
+    az_iot_hub_client_shared const* shared,
+    az_span device_id);
 
 /**
  * @brief The HTTP URI Path necessary when connecting to IoT Hub using WebSockets.
@@ -122,6 +200,9 @@ AZ_NODISCARD az_result az_iot_hub_client_init(
  * @param[in] mqtt_user_name_size The size, in bytes of \p mqtt_user_name.
  * @param[out] out_mqtt_user_name_length __[nullable]__ Contains the string length, in bytes, of
  *                                                      \p mqtt_user_name. Can be `NULL`.
+ * @remark If \p mqtt_user_name is `NULL` and \p mqtt_user_name_size is 0, nothing is written and
+ * \p out_mqtt_user_name_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  */
 AZ_NODISCARD az_result az_iot_hub_client_get_user_name(
@@ -144,6 +225,9 @@ AZ_NODISCARD az_result az_iot_hub_client_get_user_name(
  * @param[in] mqtt_client_id_size The size, in bytes of \p mqtt_client_id.
  * @param[out] out_mqtt_client_id_length __[nullable]__ Contains the string length, in bytes, of
  *                                                      of \p mqtt_client_id. Can be `NULL`.
+ * @remark If \p mqtt_client_id is `NULL` and \p mqtt_client_id_size is 0, nothing is written and
+ * \p out_mqtt_client_id_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  */
 AZ_NODISCARD az_result az_iot_hub_client_get_client_id(
@@ -200,6 +284,9 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_signature(
  * @param[in] mqtt_password_size The size, in bytes of \p mqtt_password.
  * @param[out] out_mqtt_password_length __[nullable]__ Contains the string length, in bytes, of
  *                                                     \p mqtt_password. Can be `NULL`.
+ * @remark If \p mqtt_password is `NULL` and \p mqtt_password_size is 0, nothing is written and
+ * \p out_mqtt_password_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK The operation was successful. In this case, \p mqtt_password will contain a
  * null-terminated string with the password that needs to be passed to the MQTT client.
@@ -214,6 +301,156 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_password(
     size_t mqtt_password_size,
     size_t* out_mqtt_password_length);
 
+/**
+ * @brief Gets the MQTT password, signing the SAS signature with the Shared Access Key.
+ * @remark This combines az_iot_hub_client_sas_get_signature(), HMAC-SHA256 signing with
+ *         az_crypto_hmac_sha256() and az_iot_hub_client_sas_get_password(), without any
+ *         additional buffer. Applications which keep the key in a Hardware Security Module use
+ *         those APIs instead.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @param[in] token_expiration_epoch_time The time, in seconds, from 1/1/1970.
+ * @param[in] base64_shared_access_key The Base64 encoded Shared Access Key.
+ * @param[in] key_name The Shared Access Key Name (Policy Name). This is optional. For security
+ *                     reasons we recommend using one key per device instead of using a global
+ *                     policy key.
+ * @param[out] mqtt_password A char buffer with sufficient capacity to hold the MQTT password.
+ * @param[in] mqtt_password_size The size, in bytes of \p mqtt_password.
+ * @param[out] out_mqtt_password_length __[nullable]__ Contains the string length, in bytes, of
+ *                                                     \p mqtt_password. Can be `NULL`.
+ * @remark If \p mqtt_password is `NULL` and \p mqtt_password_size is 0, nothing is written and
+ * \p out_mqtt_password_length receives the length of the longest password the key can sign,
+ * without signing it: the URL-encoding of the signature makes it up to 86 bytes longer
+ * than the password.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The operation was successful. In this case, \p mqtt_password will contain a
+ * null-terminated string with the password that needs to be passed to the MQTT client.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p mqtt_password does not have enough size.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The \p base64_shared_access_key is not valid Base64.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_get_password_from_key(
+    az_iot_hub_client const* client,
+    uint64_t token_expiration_epoch_time,
+    az_span base64_shared_access_key,
+    az_span key_name,
+    char* mqtt_password,
+    size_t mqtt_password_size,
+    size_t* out_mqtt_password_length);
+
+/**
+ * @brief The default lifetime, in seconds, of the tokens built by an
+ * #az_iot_hub_client_sas_token_cache.
+ */
+#define AZ_IOT_HUB_CLIENT_SAS_TOKEN_CACHE_DEFAULT_LIFETIME_SECONDS 3600
+
+/**
+ * @brief The default number of seconds before its expiration that an
+ * #az_iot_hub_client_sas_token_cache stops handing out a token.
+ */
+#define AZ_IOT_HUB_CLIENT_SAS_TOKEN_CACHE_DEFAULT_REFRESH_MARGIN_SECONDS 300
+
+/**
+ * @brief Azure IoT Hub SAS token cache options.
+ */
+typedef struct
+{
+  uint32_t token_lifetime_seconds; /**< The number of seconds each token is valid for. */
+  uint32_t refresh_margin_seconds; /**< The number of seconds before its expiration that a token
+                                      is replaced. It must be less than the lifetime. */
+} az_iot_hub_client_sas_token_cache_options;
+
+/**
+ * @brief Caches the MQTT password of an #az_iot_hub_client, so that reconnecting does not sign a
+ * new SAS token until the cached one is about to expire.
+ *
+ * @details The cache holds the current password and, once
+ * az_iot_hub_client_sas_token_cache_renew() has been called, the one that replaces it, each in
+ * one half of a caller-provided buffer.
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client const* client;
+    az_span base64_shared_access_key;
+    az_span key_name;
+    az_iot_hub_client_sas_token_cache_options options;
+    az_span passwords[2];
+    int32_t password_lengths[2];
+    uint64_t expirations[2];
+    int32_t current; // The index of the current password, or -1 when there is none.
+    bool next_ready;
+  } _internal;
+} az_iot_hub_client_sas_token_cache;
+
+/**
+ * @brief Gets the default #az_iot_hub_client_sas_token_cache_options.
+ *
+ * @return #az_iot_hub_client_sas_token_cache_options.
+ */
+AZ_NODISCARD az_iot_hub_client_sas_token_cache_options
+az_iot_hub_client_sas_token_cache_options_default();
+
+/**
+ * @brief Initializes an #az_iot_hub_client_sas_token_cache. No token is built until one is
+ * requested.
+ *
+ * @param[out] cache The #az_iot_hub_client_sas_token_cache to initialize.
+ * @param[in] client The #az_iot_hub_client the tokens are for. It must outlive \p cache.
+ * @param[in] base64_shared_access_key The Base64 encoded Shared Access Key. It must outlive
+ *                                     \p cache.
+ * @param[in] key_name The Shared Access Key Name (Policy Name). This is optional.
+ * @param[in] buffer The buffer that holds the passwords. Each half of it must be large enough for
+ *                   a null-terminated MQTT password. It must outlive \p cache.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_hub_client_sas_token_cache_options
+ *                    structure. If `NULL` is passed, the default options are used.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_token_cache_init(
+    az_iot_hub_client_sas_token_cache* cache,
+    az_iot_hub_client const* client,
+    az_span base64_shared_access_key,
+    az_span key_name,
+    az_span buffer,
+    az_iot_hub_client_sas_token_cache_options const* options);
+
+/**
+ * @brief Gets the MQTT password to connect with at \p current_epoch_time.
+ *
+ * @details The cached password is returned until it is within the refresh margin of its
+ * expiration. It is then replaced by the one az_iot_hub_client_sas_token_cache_renew() prepared,
+ * or, if there is none, by a new token signed in this call.
+ *
+ * @param[in] cache The #az_iot_hub_client_sas_token_cache to use for this call.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970.
+ * @param[out] out_mqtt_password The null-terminated MQTT password. Its size does not include the
+ *                               null terminator. It is valid until the next call which replaces
+ *                               the current password.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The password was returned successfully.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE Half of the cache buffer is too small for a password.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_token_cache_get_password(
+    az_iot_hub_client_sas_token_cache* cache,
+    uint64_t current_epoch_time,
+    az_span* out_mqtt_password);
+
+/**
+ * @brief Signs the token which replaces the current password, if it has not been signed yet.
+ *
+ * @details Call this off the connection path, for instance from an idle loop or a timer, so that
+ * az_iot_hub_client_sas_token_cache_get_password() does not need to sign a token when the current
+ * one is due for replacement. The new token expires one lifetime after the current one is
+ * replaced. Does nothing if there is no current password yet.
+ *
+ * @param[in] cache The #az_iot_hub_client_sas_token_cache to use for this call.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The next password is ready, or there is no current password yet.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE Half of the cache buffer is too small for a password.
+ */
+AZ_NODISCARD az_result
+az_iot_hub_client_sas_token_cache_renew(az_iot_hub_client_sas_token_cache* cache);
+
 /*
  *
  * Telemetry APIs
@@ -233,6 +470,9 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_password(
  * @param[in] mqtt_topic_size The size, in bytes of \p mqtt_topic.
  * @param[out] out_mqtt_topic_length __[nullable]__ Contains the string length, in bytes, of
  *                                                  \p mqtt_topic. Can be `NULL`.
+ * @remark If \p mqtt_topic is `NULL` and \p mqtt_topic_size is 0, nothing is written and
+ * \p out_mqtt_topic_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK The topic was retrieved successfully.
  */
@@ -243,6 +483,355 @@ AZ_NODISCARD az_result az_iot_hub_client_telemetry_get_publish_topic(
     size_t mqtt_topic_size,
     size_t* out_mqtt_topic_length);
 
+/**
+ * @brief Telemetry batch options.
+ *
+ */
+typedef struct
+{
+  int32_t max_payload_size; /**< The payload size, in bytes, from which the batch should be
+                               flushed. If 0, the batch is flushed when the buffer is full. */
+  uint32_t max_age_seconds; /**< The number of seconds after its first reading that the batch
+                               should be flushed. If 0, the age of the batch is not considered. */
+} az_iot_hub_client_telemetry_batch_options;
+
+/**
+ * @brief Collects telemetry readings into a single JSON array payload, so that they are sent in
+ * one telemetry message.
+ *
+ * @details Every reading of a batch shares the topic and the message properties it is published
+ * with, so the topic only needs to be built once with
+ * az_iot_hub_client_telemetry_get_publish_topic().
+ */
+typedef struct
+{
+  struct
+  {
+    az_span payload_buffer;
+    az_json_writer writer;
+    az_iot_hub_client_telemetry_batch_options options;
+    int32_t reading_count;
+    uint64_t first_reading_time;
+  } _internal;
+} az_iot_hub_client_telemetry_batch;
+
+/**
+ * @brief Gets the default #az_iot_hub_client_telemetry_batch_options.
+ *
+ * @return #az_iot_hub_client_telemetry_batch_options.
+ */
+AZ_NODISCARD az_iot_hub_client_telemetry_batch_options
+az_iot_hub_client_telemetry_batch_options_default();
+
+/**
+ * @brief Initializes an empty #az_iot_hub_client_telemetry_batch.
+ *
+ * @param[out] batch The #az_iot_hub_client_telemetry_batch to initialize.
+ * @param[in] payload_buffer The buffer the payload is built in. It must outlive \p batch.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_hub_client_telemetry_batch_options
+ *                    structure. If `NULL` is passed, the default options are used.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_batch_init(
+    az_iot_hub_client_telemetry_batch* batch,
+    az_span payload_buffer,
+    az_iot_hub_client_telemetry_batch_options const* options);
+
+/**
+ * @brief Appends a reading to an #az_iot_hub_client_telemetry_batch.
+ *
+ * @param[in,out] batch The #az_iot_hub_client_telemetry_batch to use for this call.
+ * @param[in] json_reading A single JSON value, typically an object, for the reading.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970. The time of the
+ *                               first reading determines the age of the batch.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The reading was appended.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The reading does not fit in the payload buffer. The batch is
+ * unchanged, so it can be flushed and the reading appended again.
+ * @retval other \p json_reading is not valid JSON.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_batch_append_reading(
+    az_iot_hub_client_telemetry_batch* batch,
+    az_span json_reading,
+    uint64_t current_epoch_time);
+
+/**
+ * @brief Checks whether an #az_iot_hub_client_telemetry_batch is due to be flushed, because it
+ * reached the maximum payload size or age of its options.
+ *
+ * @param[in] batch The #az_iot_hub_client_telemetry_batch to use for this call.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970.
+ * @return `true` if the batch holds readings and is due to be flushed, `false` otherwise.
+ */
+AZ_NODISCARD bool az_iot_hub_client_telemetry_batch_should_flush(
+    az_iot_hub_client_telemetry_batch const* batch,
+    uint64_t current_epoch_time);
+
+/**
+ * @brief Completes the JSON array payload of an #az_iot_hub_client_telemetry_batch, to be
+ * published as one telemetry message.
+ *
+ * @details The batch must be reset with az_iot_hub_client_telemetry_batch_reset() once the
+ * payload has been published, and before more readings are appended.
+ *
+ * @param[in,out] batch The #az_iot_hub_client_telemetry_batch to use for this call.
+ * @param[out] out_payload The JSON array of the readings.
+ * @param[out] out_reading_count __[nullable]__ The number of readings in the payload. Can be
+ *                               `NULL`.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_batch_get_payload(
+    az_iot_hub_client_telemetry_batch* batch,
+    az_span* out_payload,
+    int32_t* out_reading_count);
+
+/**
+ * @brief Empties an #az_iot_hub_client_telemetry_batch, reusing its payload buffer.
+ *
+ * @param[in,out] batch The #az_iot_hub_client_telemetry_batch to use for this call.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result
+az_iot_hub_client_telemetry_batch_reset(az_iot_hub_client_telemetry_batch* batch);
+
+/**
+ * @brief Writes a changed part of the memory of an #az_iot_hub_client_telemetry_queue to its
+ * persistent copy, such as a flash region or a file.
+ *
+ * @param[in] user_context The context given in the #az_iot_hub_client_telemetry_queue_options.
+ * @param[in] offset The offset, in bytes, of \p data from the start of the queue buffer.
+ * @param[in] data The bytes to write at \p offset.
+ * @return An #az_result value indicating the result of the operation.
+ */
+typedef az_result (*az_iot_hub_client_telemetry_queue_persist_fn)(
+    void* user_context,
+    int32_t offset,
+    az_span data);
+
+/**
+ * @brief Telemetry queue options.
+ *
+ */
+typedef struct
+{
+  int32_t max_in_flight; /**< The number of messages which can be published and waiting for their
+                            PUBACK at once. If 0, it is not limited. */
+  uint32_t max_messages_per_second; /**< The number of messages which can be published in each
+                                       second, so that a backlog drains without being throttled
+                                       by the hub after a reconnect. If 0, it is not limited. */
+  bool discard_oldest; /**< Whether the oldest messages which are not in flight are discarded to
+                          make room for new ones. If `false`, the new message is rejected. */
+  az_iot_hub_client_telemetry_queue_persist_fn persist; /**< __[nullable]__ Called with every
+                                                           change to the queue buffer, to keep a
+                                                           persistent copy of it. */
+  void* persist_context; /**< The user context passed to `persist`. */
+} az_iot_hub_client_telemetry_queue_options;
+
+/**
+ * @brief Holds telemetry messages, each with its MQTT topic, until the hub acknowledges them, so
+ * that telemetry is not lost while the device is offline.
+ *
+ * @details Messages are kept in a ring within a caller-provided buffer, whose size bounds the
+ * memory used. The buffer holds all of the state of the queue, so a copy of it can be kept in a
+ * flash region or a file through the `persist` callback of the options, and the queue reloaded
+ * from that copy with az_iot_hub_client_telemetry_queue_restore() after a restart.
+ *
+ * Messages are published in order with QoS 1: az_iot_hub_client_telemetry_queue_get_next() returns
+ * the next one to publish and az_iot_hub_client_telemetry_queue_mark_published() records the
+ * packet id of its MQTT Publish. The message is removed once
+ * az_iot_hub_client_telemetry_queue_acknowledge() is called for its PUBACK.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span buffer;
+    az_iot_hub_client_telemetry_queue_options options;
+    int32_t begin;
+    int32_t end;
+    int32_t wrap;
+    int32_t count;
+    int32_t acknowledged_count;
+    int32_t in_flight_count;
+    uint64_t window_start_time;
+    uint32_t window_count;
+  } _internal;
+} az_iot_hub_client_telemetry_queue;
+
+/**
+ * @brief A message of an #az_iot_hub_client_telemetry_queue to publish.
+ *
+ */
+typedef struct
+{
+  az_span topic; /**< The MQTT topic, followed by a null terminator which is not part of its
+                    size. */
+  az_span payload; /**< The payload of the message. */
+  struct
+  {
+    int32_t offset;
+  } _internal;
+} az_iot_hub_client_telemetry_queue_message;
+
+/**
+ * @brief Gets the default #az_iot_hub_client_telemetry_queue_options.
+ *
+ * @return #az_iot_hub_client_telemetry_queue_options.
+ */
+AZ_NODISCARD az_iot_hub_client_telemetry_queue_options
+az_iot_hub_client_telemetry_queue_options_default();
+
+/**
+ * @brief Initializes an empty #az_iot_hub_client_telemetry_queue.
+ *
+ * @param[out] queue The #az_iot_hub_client_telemetry_queue to initialize.
+ * @param[in] buffer The buffer the messages are kept in. It must outlive \p queue.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_hub_client_telemetry_queue_options
+ *                    structure. If `NULL` is passed, the default options are used.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The queue was initialized.
+ * @retval other The `persist` callback of the options failed.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_init(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_span buffer,
+    az_iot_hub_client_telemetry_queue_options const* options);
+
+/**
+ * @brief Initializes an #az_iot_hub_client_telemetry_queue with the messages a buffer already
+ * holds, such as one reloaded from the persistent copy of a queue.
+ *
+ * @details Messages which were in flight are published again, since their PUBACK may never have
+ * arrived.
+ *
+ * @param[out] queue The #az_iot_hub_client_telemetry_queue to initialize.
+ * @param[in] buffer The buffer of the queue. It must outlive \p queue.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_hub_client_telemetry_queue_options
+ *                    structure. If `NULL` is passed, the default options are used.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The queue was restored.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND \p buffer does not hold a valid queue. Use
+ * az_iot_hub_client_telemetry_queue_init() to start an empty one.
+ * @retval other The `persist` callback of the options failed.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_restore(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_span buffer,
+    az_iot_hub_client_telemetry_queue_options const* options);
+
+/**
+ * @brief Adds a telemetry message to an #az_iot_hub_client_telemetry_queue.
+ *
+ * @details The topic of the message is built with az_iot_hub_client_telemetry_get_publish_topic().
+ *
+ * @param[in,out] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ * @param[in] client The #az_iot_hub_client to build the topic for.
+ * @param[in] properties An optional #az_iot_message_properties object (can be NULL).
+ * @param[in] payload The payload of the message.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The message was queued.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The message does not fit in the queue. Older messages may
+ * have been discarded, if the options allow it.
+ * @retval other The `persist` callback of the options failed. The message is queued, but may not
+ * be restored after a restart.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_enqueue(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_iot_hub_client const* client,
+    az_iot_message_properties const* properties,
+    az_span payload);
+
+/**
+ * @brief Adds the payload of an #az_iot_hub_client_telemetry_batch to an
+ * #az_iot_hub_client_telemetry_queue, as one telemetry message, and resets the batch.
+ *
+ * @param[in,out] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ * @param[in] client The #az_iot_hub_client to build the topic for.
+ * @param[in] properties An optional #az_iot_message_properties object (can be NULL).
+ * @param[in,out] batch The #az_iot_hub_client_telemetry_batch to queue. It is only reset if it was
+ *                      queued.
+ * @return An #az_result value indicating the result of the operation, as for
+ * az_iot_hub_client_telemetry_queue_enqueue().
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_enqueue_batch(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_iot_hub_client const* client,
+    az_iot_message_properties const* properties,
+    az_iot_hub_client_telemetry_batch* batch);
+
+/**
+ * @brief Gets the oldest message of an #az_iot_hub_client_telemetry_queue which has not been
+ * published yet.
+ *
+ * @details Publish the message with QoS 1, then call
+ * az_iot_hub_client_telemetry_queue_mark_published() with the packet id of the MQTT Publish.
+ *
+ * @param[in,out] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970, which the publish
+ *                               rate is counted with.
+ * @param[out] out_message The message to publish. Its spans point into the queue buffer, and are
+ *                         valid until the message is acknowledged or discarded.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK There is a message to publish.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND Every message of the queue has been published.
+ * @retval #AZ_ERROR_IOT_QUEUE_THROTTLED There is a message to publish, but not until a PUBACK
+ * arrives or the next second, because of the limits of the options.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_get_next(
+    az_iot_hub_client_telemetry_queue* queue,
+    uint64_t current_epoch_time,
+    az_iot_hub_client_telemetry_queue_message* out_message);
+
+/**
+ * @brief Records that a message of an #az_iot_hub_client_telemetry_queue was published.
+ *
+ * @param[in,out] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ * @param[in] message The message returned by az_iot_hub_client_telemetry_queue_get_next().
+ * @param[in] packet_id The packet id of the MQTT Publish of \p message. It must not be 0.
+ */
+void az_iot_hub_client_telemetry_queue_mark_published(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_iot_hub_client_telemetry_queue_message const* message,
+    uint16_t packet_id);
+
+/**
+ * @brief Removes the message acknowledged by a PUBACK from an #az_iot_hub_client_telemetry_queue.
+ *
+ * @param[in,out] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ * @param[in] packet_id The packet id of the PUBACK.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The message was acknowledged.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND No message in flight was published with \p packet_id.
+ * @retval other The `persist` callback of the options failed.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_acknowledge(
+    az_iot_hub_client_telemetry_queue* queue,
+    uint16_t packet_id);
+
+/**
+ * @brief Returns the messages in flight of an #az_iot_hub_client_telemetry_queue to the ones to be
+ * published, so that they are published again.
+ *
+ * @details Call this when the MQTT connection is lost, since the PUBACK of messages in flight may
+ * never arrive.
+ *
+ * @param[in,out] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ */
+void az_iot_hub_client_telemetry_queue_requeue_in_flight(az_iot_hub_client_telemetry_queue* queue);
+
+/**
+ * @brief Gets the number of messages of an #az_iot_hub_client_telemetry_queue which have not been
+ * acknowledged yet.
+ *
+ * @param[in] queue The #az_iot_hub_client_telemetry_queue to use for this call.
+ * @return The number of messages queued or in flight.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_iot_hub_client_telemetry_queue_get_message_count(az_iot_hub_client_telemetry_queue const* queue)
+{
+  return queue->_internal.count - queue->_internal.acknowledged_count;
+}
+
 /*
  *
  * Cloud-to-device (C2D) APIs
@@ -267,6 +856,8 @@ typedef struct
 /**
  * @brief Attempts to parse a received message's topic for C2D features.
  *
+ * @remark The properties of \p out_request are a view into \p received_topic; nothing is copied.
+ *
  * @param[in] client The #az_iot_hub_client to use for this call.
  * @param[in] received_topic An #az_span containing the received topic.
  * @param[out] out_request If the message is a C2D request, this will contain the
@@ -283,6 +874,8 @@ AZ_NODISCARD az_result az_iot_hub_client_c2d_parse_received_topic(
     az_span received_topic,
     az_iot_hub_client_c2d_request* out_request);
 
+#ifndef AZ_NO_IOT_HUB_METHODS
+
 /*
  *
  * Methods APIs
@@ -309,6 +902,9 @@ typedef struct
 /**
  * @brief Attempts to parse a received message's topic for method features.
  *
+ * @remark The name and request id of \p out_request are views into \p received_topic; nothing is
+ * copied.
+ *
  * @param[in] client The #az_iot_hub_client to use for this call.
  * @param[in] received_topic An #az_span containing the received topic.
  * @param[out] out_request If the message is a method request, this will contain the
@@ -338,6 +934,9 @@ AZ_NODISCARD az_result az_iot_hub_client_methods_parse_received_topic(
  * @param[in] mqtt_topic_size The size, in bytes of \p mqtt_topic.
  * @param[out] out_mqtt_topic_length __[nullable]__ Contains the string length, in bytes, of
  *                                                  \p mqtt_topic. Can be `NULL`.
+ * @remark If \p mqtt_topic is `NULL` and \p mqtt_topic_size is 0, nothing is written and
+ * \p out_mqtt_topic_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK The topic was retrieved successfully.
  */
@@ -349,6 +948,113 @@ AZ_NODISCARD az_result az_iot_hub_client_methods_response_get_publish_topic(
     size_t mqtt_topic_size,
     size_t* out_mqtt_topic_length);
 
+/**
+ * @brief The separator between the component name and the command name of an IoT Plug and Play
+ * command, as in `thermostat1*getMaxMinReport`.
+ */
+#define AZ_IOT_HUB_CLIENT_COMMAND_COMPONENT_SEPARATOR '*'
+
+/**
+ * @brief A command registered with an #az_iot_hub_client_command_table.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_span component_name;
+    az_span command_name;
+    uint32_t hash;
+  } _internal;
+} az_iot_hub_client_command;
+
+/**
+ * @brief A set of commands, each one of a component or of the root interface, which routes the
+ * name of a method request to the command it invokes.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client_command* commands;
+    int32_t command_capacity;
+    int32_t command_count;
+    int32_t* buckets;
+    int32_t bucket_count;
+    uint8_t component_separator;
+  } _internal;
+} az_iot_hub_client_command_table;
+
+/**
+ * @brief Initializes an #az_iot_hub_client_command_table with no commands.
+ *
+ * @param[out] table The #az_iot_hub_client_command_table to initialize.
+ * @param[in] component_separator The byte between the component name and the command name of
+ *                                a method name, usually
+ *                                #AZ_IOT_HUB_CLIENT_COMMAND_COMPONENT_SEPARATOR.
+ * @param[in] commands The array that holds the commands. It must outlive \p table.
+ * @param[in] command_capacity The number of elements in \p commands.
+ * @param[in] buckets The array of the hash table which maps names to commands. It must outlive
+ *                    \p table.
+ * @param[in] bucket_count The number of elements in \p buckets. It must be a power of two larger
+ *                         than \p command_capacity; twice as large keeps lookups short.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_command_table_init(
+    az_iot_hub_client_command_table* table,
+    uint8_t component_separator,
+    az_iot_hub_client_command* commands,
+    int32_t command_capacity,
+    int32_t* buckets,
+    int32_t bucket_count);
+
+/**
+ * @brief Adds a command to an #az_iot_hub_client_command_table.
+ *
+ * @param[in,out] table The #az_iot_hub_client_command_table to use for this call.
+ * @param[in] component_name The component name, or an empty #az_span for a command of the root
+ *                           interface. It must outlive \p table.
+ * @param[in] command_name The command name. It must outlive \p table.
+ * @param[out] out_command_index __[nullable]__ The index of the new command. Can be `NULL`.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The command was added.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The table already holds `command_capacity` commands.
+ * @retval #AZ_ERROR_ARG The table already holds this command.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_command_table_add(
+    az_iot_hub_client_command_table* table,
+    az_span component_name,
+    az_span command_name,
+    int32_t* out_command_index);
+
+/**
+ * @brief Finds the command a method request invokes.
+ *
+ * @details The name is split at the first component separator, if any, and looked up in the hash
+ * table, so the time taken does not depend on the number of components and commands.
+ *
+ * @param[in] table The #az_iot_hub_client_command_table to use for this call.
+ * @param[in] method_name The name of an #az_iot_hub_client_method_request.
+ * @param[out] out_command_index The index of the command.
+ * @param[out] out_component_name __[nullable]__ The component name of the command, empty for a
+ *                                command of the root interface. Can be `NULL`.
+ * @param[out] out_command_name __[nullable]__ The command name. Can be `NULL`.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The command was found.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The table does not hold the command.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_command_table_find(
+    az_iot_hub_client_command_table const* table,
+    az_span method_name,
+    int32_t* out_command_index,
+    az_span* out_component_name,
+    az_span* out_command_name);
+
+#endif // AZ_NO_IOT_HUB_METHODS
+
+#ifndef AZ_NO_IOT_HUB_TWIN
+
 /*
  *
  * Twin APIs
@@ -426,6 +1132,9 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_parse_received_topic(
  * @param[in] mqtt_topic_size The size, in bytes of \p mqtt_topic.
  * @param[out] out_mqtt_topic_length __[nullable]__ Contains the string length, in bytes, of
  *                                                  \p mqtt_topic. Can be `NULL`.
+ * @remark If \p mqtt_topic is `NULL` and \p mqtt_topic_size is 0, nothing is written and
+ * \p out_mqtt_topic_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK The topic was retrieved successfully.
  */
@@ -449,6 +1158,9 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_document_get_publish_topic(
  * @param[in] mqtt_topic_size The size, in bytes of \p mqtt_topic.
  * @param[out] out_mqtt_topic_length __[nullable]__ Contains the string length, in bytes, of
  *                                                  \p mqtt_topic. Can be `NULL`.
+ * @remark If \p mqtt_topic is `NULL` and \p mqtt_topic_size is 0, nothing is written and
+ * \p out_mqtt_topic_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  * @retval #AZ_OK The topic was retrieved successfully.
  */
@@ -459,6 +1171,666 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_patch_get_publish_topic(
     size_t mqtt_topic_size,
     size_t* out_mqtt_topic_length);
 
+/**
+ * @brief The maximum depth of desired properties within the desired section of a twin, which IoT
+ * Hub limits.
+ */
+#define AZ_IOT_HUB_CLIENT_TWIN_DESIRED_MAX_DEPTH 10
+
+/**
+ * @brief A record of the value of a desired property, which is kept by an
+ * #az_iot_hub_client_twin_desired_tracker.
+ */
+typedef struct
+{
+  struct
+  {
+    uint64_t path_hash;
+    uint64_t value_hash;
+  } _internal;
+} az_iot_hub_client_twin_desired_record;
+
+/**
+ * @brief Tracks the desired properties an application applied, so that only those which change
+ * are reported when a twin document or desired properties patch is received.
+ *
+ * @details Only a hash of the path and of the value of each property is kept. Objects are walked
+ * into, and any other value, including an array, is a single property.
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client_twin_desired_record* records;
+    int32_t record_capacity;
+    int32_t record_count;
+    int64_t version;
+  } _internal;
+} az_iot_hub_client_twin_desired_tracker;
+
+/**
+ * @brief Initializes an #az_iot_hub_client_twin_desired_tracker, which has no record of any
+ * property.
+ *
+ * @param[out] tracker The #az_iot_hub_client_twin_desired_tracker to initialize.
+ * @param[in] records The storage of the records of the properties. It must outlive the tracker.
+ * @param[in] record_capacity The number of records in \p records, which must be a power of two.
+ * At most three quarters of them are used.
+ */
+void az_iot_hub_client_twin_desired_tracker_init(
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_desired_record* records,
+    int32_t record_capacity);
+
+/**
+ * @brief Iterates over the desired properties of a twin document or desired properties patch which
+ * differ from the ones an #az_iot_hub_client_twin_desired_tracker last recorded.
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client_twin_desired_tracker* tracker;
+    az_span json;
+    az_json_reader reader;
+    az_span path_buffer;
+    int32_t path_lengths[AZ_IOT_HUB_CLIENT_TWIN_DESIRED_MAX_DEPTH];
+    int32_t depth;
+    int64_t version;
+    bool done;
+  } _internal;
+} az_iot_hub_client_twin_desired_changes;
+
+/**
+ * @brief Starts iterating over the desired properties of a received twin document or patch which
+ * changed.
+ *
+ * @param[out] changes The #az_iot_hub_client_twin_desired_changes to initialize.
+ * @param[in,out] tracker The #az_iot_hub_client_twin_desired_tracker which holds the properties
+ * applied so far.
+ * @param[in] response_type The type of the twin response the payload was received with: either
+ * #AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET for a full twin document, or
+ * #AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES for a desired properties patch.
+ * @param[in] json The payload of the twin message.
+ * @param[in] path_buffer The buffer which receives the path of each changed property. It must be
+ * large enough to hold the longest path.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The iteration is started.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND A twin document has no desired section.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The payload is not a JSON object.
+ * @retval #AZ_ERROR_UNEXPECTED_END The payload is incomplete.
+ *
+ * @remarks When the `$version` of the payload is not greater than the one an iteration last
+ * completed with, no property is reported.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_twin_desired_changes_init(
+    az_iot_hub_client_twin_desired_changes* changes,
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_response_type response_type,
+    az_span json,
+    az_span path_buffer);
+
+/**
+ * @brief Gets the next desired property which changed, and records its new value.
+ *
+ * @param[in,out] changes The #az_iot_hub_client_twin_desired_changes to use for this call.
+ * @param[out] out_path The path of the property, as its unescaped property names separated by `.`,
+ * for example `thermostat1.targetTemperature`. It lies in the path buffer.
+ * @param[out] out_value The token of the value of the property. For an array, the slice of the
+ * token spans the whole array so that it can be read with a new #az_json_reader.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK A changed property is returned.
+ * @retval #AZ_ERROR_IOT_END_OF_PROPERTIES There are no more changed properties. The tracker then
+ * records the `$version` of the payload.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The path buffer is too small for the path of a property.
+ * @retval #AZ_ERROR_NOT_SUPPORTED Properties are nested deeper than
+ * #AZ_IOT_HUB_CLIENT_TWIN_DESIRED_MAX_DEPTH.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR An invalid character is detected.
+ * @retval #AZ_ERROR_UNEXPECTED_END The payload is incomplete.
+ *
+ * @remarks A property is also returned when the tracker has no room left to record it, or when
+ * an object which held it was replaced by another value, so that no change is left out. Metadata
+ * properties within the desired section, whose names start with `$`, are not returned. A property
+ * removed by a patch is returned with a `null` value, while a property missing from a twin
+ * document is not returned.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_twin_desired_changes_next(
+    az_iot_hub_client_twin_desired_changes* changes,
+    az_span* out_path,
+    az_json_token* out_value);
+
+/**
+ * @brief Twin reported properties batch options.
+ *
+ */
+typedef struct
+{
+  int32_t max_patch_size; /**< The size, in bytes, of the pending property names and values from
+                             which the batch should be flushed. If 0, the size is not considered. */
+  uint32_t max_delay_seconds; /**< The number of seconds after the first pending update that the
+                                 batch should be flushed. If 0, the delay is not considered. */
+} az_iot_hub_client_twin_reported_batch_options;
+
+/**
+ * @brief A reported property tracked by an #az_iot_hub_client_twin_reported_batch.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span name;
+    az_span pending_value;
+    uint64_t pending_hash;
+    uint64_t sent_hash;
+    uint64_t acknowledged_hash;
+    bool is_pending;
+    bool is_sent;
+    bool is_acknowledged;
+  } _internal;
+} az_iot_hub_client_twin_reported_property;
+
+/**
+ * @brief Merges updates of reported properties into a single twin PATCH document, leaving out
+ * the ones which set a property to the value IoT Hub already acknowledged.
+ *
+ * @details One patch is in flight at a time: once the payload from
+ * az_iot_hub_client_twin_reported_batch_get_patch() has been published, the batch must be told of
+ * the twin response with az_iot_hub_client_twin_reported_batch_acknowledge() before it builds the
+ * next one. Updates can keep being set in the meantime.
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client_twin_reported_property* properties;
+    int32_t property_capacity;
+    int32_t property_count;
+    az_span value_buffer;
+    int32_t value_buffer_used;
+    az_iot_hub_client_twin_reported_batch_options options;
+    int32_t pending_count;
+    int32_t pending_size;
+    uint64_t first_pending_time;
+    bool is_patch_in_flight;
+  } _internal;
+} az_iot_hub_client_twin_reported_batch;
+
+/**
+ * @brief Gets the default #az_iot_hub_client_twin_reported_batch_options.
+ *
+ * @return #az_iot_hub_client_twin_reported_batch_options.
+ */
+AZ_NODISCARD az_iot_hub_client_twin_reported_batch_options
+az_iot_hub_client_twin_reported_batch_options_default();
+
+/**
+ * @brief Initializes an empty #az_iot_hub_client_twin_reported_batch.
+ *
+ * @param[out] batch The #az_iot_hub_client_twin_reported_batch to initialize.
+ * @param[in] properties The storage of the reported properties. It must outlive \p batch.
+ * @param[in] property_capacity The number of properties in \p properties.
+ * @param[in] value_buffer The buffer the pending values are copied to. It must outlive \p batch.
+ * @param[in] options __[nullable]__ A reference to an
+ *                    #az_iot_hub_client_twin_reported_batch_options structure. If `NULL` is
+ *                    passed, the default options are used.
+ */
+void az_iot_hub_client_twin_reported_batch_init(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_iot_hub_client_twin_reported_property* properties,
+    int32_t property_capacity,
+    az_span value_buffer,
+    az_iot_hub_client_twin_reported_batch_options const* options);
+
+/**
+ * @brief Sets the value of a reported property, to be sent with the next patch unless it is the
+ * value IoT Hub acknowledged.
+ *
+ * @param[in,out] batch The #az_iot_hub_client_twin_reported_batch to use for this call.
+ * @param[in] name The unescaped name of the property. It must outlive \p batch.
+ * @param[in] json_value A single JSON value for the property, such as a number or a JSON object
+ *                       for a component.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970. The time of the
+ *                               first pending update determines the delay of the batch.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The update is pending, or dropped because the property already has this value.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE There is no room left for another property or the value. The
+ * batch is unchanged, so it can be flushed and the property set again.
+ * @retval other \p json_value is not a single valid JSON value.
+ *
+ * @remarks Values are compared as JSON text, so a value written differently, such as with other
+ * white space, is sent again.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_twin_reported_batch_set(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_span name,
+    az_span json_value,
+    uint64_t current_epoch_time);
+
+/**
+ * @brief Checks whether an #az_iot_hub_client_twin_reported_batch is due to be flushed, because
+ * its pending updates reached the maximum patch size or delay of its options.
+ *
+ * @param[in] batch The #az_iot_hub_client_twin_reported_batch to use for this call.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970.
+ * @return `true` if the batch holds pending updates, has no patch in flight and is due to be
+ * flushed, `false` otherwise.
+ */
+AZ_NODISCARD bool az_iot_hub_client_twin_reported_batch_should_flush(
+    az_iot_hub_client_twin_reported_batch const* batch,
+    uint64_t current_epoch_time);
+
+/**
+ * @brief Writes the pending updates of an #az_iot_hub_client_twin_reported_batch into a twin PATCH
+ * document, to be published on the topic from az_iot_hub_client_twin_patch_get_publish_topic().
+ *
+ * @param[in,out] batch The #az_iot_hub_client_twin_reported_batch to use for this call. It must
+ *                      have no patch in flight.
+ * @param[in] destination The buffer the JSON object of the patch is written to.
+ * @param[out] out_patch The JSON object of the patch. It is `{}` when no update is pending.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The patch was written, and its updates are in flight.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination is too small. The batch is unchanged.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_twin_reported_batch_get_patch(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_span destination,
+    az_span* out_patch);
+
+/**
+ * @brief Completes the patch in flight of an #az_iot_hub_client_twin_reported_batch, with the
+ * status of its twin response.
+ *
+ * @param[in,out] batch The #az_iot_hub_client_twin_reported_batch to use for this call.
+ * @param[in] status The status of the twin response to the patch. When the twin response is lost,
+ *                   any failure status, such as #AZ_IOT_STATUS_TIMEOUT, can be passed.
+ *
+ * @remarks When the patch is rejected, the values it held are forgotten and the properties keep
+ * the values acknowledged before. Setting them again makes them pending.
+ */
+void az_iot_hub_client_twin_reported_batch_acknowledge(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_iot_status status);
+
+/**
+ * @brief Writes the image of an #az_iot_hub_client_twin_cache to its persistent store, such as a
+ * flash region or a file.
+ *
+ * @param[in] user_context The context given to az_iot_hub_client_twin_cache_init().
+ * @param[in] image The whole image, which replaces the one stored before.
+ * @return An #az_result value indicating the result of the operation.
+ */
+typedef az_result (*az_iot_hub_client_twin_cache_store_fn)(void* user_context, az_span image);
+
+/**
+ * @brief Keeps a persistent copy of the state of an #az_iot_hub_client_twin_desired_tracker, and
+ * of the reported properties an #az_iot_hub_client_twin_reported_batch had acknowledged, so that
+ * it outlives a restart of the device.
+ *
+ * @details After a restart, the state is restored with az_iot_hub_client_twin_cache_restore().
+ * The twin document received on reconnecting then has no desired property reported unless its
+ * `$version` is newer than the cached one, in which case only the properties which changed are,
+ * and reported properties which are set to the values IoT Hub holds are not sent again. The twin
+ * document is still requested, since IoT Hub doesn't send the patches a disconnected device
+ * missed.
+ *
+ * Call az_iot_hub_client_twin_cache_save() once the changes of a twin document or desired
+ * properties patch have been applied, and once a reported properties patch was acknowledged. It
+ * only writes to the store when the state changed.
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client_twin_desired_tracker* tracker;
+    az_iot_hub_client_twin_reported_batch* batch;
+    az_span buffer;
+    az_iot_hub_client_twin_cache_store_fn store;
+    void* store_context;
+    uint64_t stored_check;
+    bool is_stored;
+  } _internal;
+} az_iot_hub_client_twin_cache;
+
+/**
+ * @brief Initializes an #az_iot_hub_client_twin_cache.
+ *
+ * @param[out] cache The #az_iot_hub_client_twin_cache to initialize.
+ * @param[in] tracker The #az_iot_hub_client_twin_desired_tracker whose state is cached. It must
+ * outlive \p cache.
+ * @param[in] batch __[nullable]__ The #az_iot_hub_client_twin_reported_batch whose acknowledged
+ * properties are cached. It must outlive \p cache. If `NULL`, only the desired properties are.
+ * @param[in] buffer The buffer the image is built in before it is stored. It must outlive \p cache.
+ * @param[in] store The function which writes the image to the store.
+ * @param[in] store_context The user context passed to \p store.
+ */
+void az_iot_hub_client_twin_cache_init(
+    az_iot_hub_client_twin_cache* cache,
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_span buffer,
+    az_iot_hub_client_twin_cache_store_fn store,
+    void* store_context);
+
+/**
+ * @brief Sets the tracker, and the batch, of an #az_iot_hub_client_twin_cache to the state of an
+ * image read back from the store.
+ *
+ * @param[in,out] cache The #az_iot_hub_client_twin_cache to use for this call. Its tracker and
+ * batch must have just been initialized.
+ * @param[in] image The image, as it was stored. The names of the reported properties restored
+ * from it lie in it, so it must outlive the batch, and must not be the buffer of \p cache.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The state was restored.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND \p image does not hold a complete image, such as when it was
+ * never stored or its write was interrupted. The tracker and the batch are left empty.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The tracker or the batch has less room than the image needs.
+ * The tracker and the batch are left empty.
+ */
+AZ_NODISCARD az_result
+az_iot_hub_client_twin_cache_restore(az_iot_hub_client_twin_cache* cache, az_span image);
+
+/**
+ * @brief Writes the image of the current state of an #az_iot_hub_client_twin_cache to its store,
+ * unless it is the one stored last.
+ *
+ * @param[in,out] cache The #az_iot_hub_client_twin_cache to use for this call.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The image was stored, or the state did not change since it last was.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The buffer of \p cache is too small for the image.
+ * @retval other The store function failed. The image is written again by the next call.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_twin_cache_save(az_iot_hub_client_twin_cache* cache);
+
+/**
+ * @brief Gets the `$version` of the desired properties the cached state was last updated with.
+ *
+ * @param[in] cache The #az_iot_hub_client_twin_cache to use for this call.
+ * @return The version, or -1 when no twin document or patch was applied yet.
+ */
+AZ_NODISCARD AZ_INLINE int64_t
+az_iot_hub_client_twin_cache_get_desired_version(az_iot_hub_client_twin_cache const* cache)
+{
+  return cache->_internal.tracker->_internal.version;
+}
+
+#endif // AZ_NO_IOT_HUB_TWIN
+
+/*
+ *
+ * Received topic APIs
+ *
+ */
+
+/**
+ * @brief The feature an MQTT topic received from IoT Hub belongs to.
+ *
+ */
+typedef enum
+{
+  AZ_IOT_HUB_CLIENT_TOPIC_TYPE_C2D_REQUEST = 1, /**< A Cloud-To-Device request. */
+  AZ_IOT_HUB_CLIENT_TOPIC_TYPE_METHOD_REQUEST = 2, /**< A method request. */
+  AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_RESPONSE = 3, /**< A response to a twin GET or PATCH. */
+  AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_DESIRED_PATCH = 4, /**< A desired properties update. */
+} az_iot_hub_client_topic_type;
+
+/**
+ * @brief A received MQTT topic, classified by the feature it belongs to.
+ *
+ */
+typedef struct
+{
+  az_iot_hub_client_topic_type type; /**< Selects which member of \p data is populated. */
+  union
+  {
+    az_iot_hub_client_c2d_request c2d_request; /**< Set for a C2D request. */
+#ifndef AZ_NO_IOT_HUB_METHODS
+    az_iot_hub_client_method_request method_request; /**< Set for a method request. */
+#endif // AZ_NO_IOT_HUB_METHODS
+#ifndef AZ_NO_IOT_HUB_TWIN
+    az_iot_hub_client_twin_response twin_response; /**< Set for a twin response or desired
+                                                      properties update. */
+#endif // AZ_NO_IOT_HUB_TWIN
+  } data; /**< The parsed fields of the topic. */
+} az_iot_hub_client_received_topic;
+
+/**
+ * @brief Parses a received message's topic for any of the C2D, methods and twin features at once.
+ * @details The topic's leading bytes select the one feature it can belong to, so only that
+ * feature's parser runs. This replaces calling az_iot_hub_client_c2d_parse_received_topic(),
+ * az_iot_hub_client_methods_parse_received_topic() and
+ * az_iot_hub_client_twin_parse_received_topic() in turn.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @param[in] received_topic An #az_span containing the received topic.
+ * @param[out] out_topic If the topic belongs to one of the features, this will contain its type
+ *                       and parsed fields.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The topic was classified and \p out_topic was populated.
+ * @retval #AZ_ERROR_IOT_TOPIC_NO_MATCH The topic does not belong to any of the features, or is
+ * malformed.
+ * @retval other The error returned by the parser of the feature the topic belongs to.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_parse_received_topic(
+    az_iot_hub_client const* client,
+    az_span received_topic,
+    az_iot_hub_client_received_topic* out_topic);
+
+/**
+ * @brief Called when the application releases an #az_iot_hub_client_received_message, so that the
+ * MQTT client can reuse the buffer the message was received in.
+ *
+ * @param[in] received_topic The topic passed to az_iot_hub_client_parse_received_message().
+ * @param[in] received_payload The payload passed to az_iot_hub_client_parse_received_message().
+ * @param[in] user_context The user context passed to az_iot_hub_client_parse_received_message().
+ */
+typedef void (*az_iot_hub_client_receive_buffer_release_fn)(
+    az_span received_topic,
+    az_span received_payload,
+    void* user_context);
+
+/**
+ * @brief A message received from IoT Hub, which refers to the MQTT client's receive buffer rather
+ * than copying from it.
+ *
+ * @details The parsed fields of #az_iot_hub_client_received_message.topic, such as the properties
+ * of a C2D request or the name and request ID of a method request, and
+ * #az_iot_hub_client_received_message.payload are views into the received topic and payload. They
+ * are valid until az_iot_hub_client_received_message_release() is called.
+ */
+typedef struct
+{
+  az_iot_hub_client_received_topic topic; /**< The type and parsed fields of the received topic. */
+  az_span payload; /**< The received payload. */
+  struct
+  {
+    az_span received_topic;
+    az_iot_hub_client_receive_buffer_release_fn release_callback;
+    void* release_user_context;
+  } _internal;
+} az_iot_hub_client_received_message;
+
+/**
+ * @brief Parses a received message, as az_iot_hub_client_parse_received_topic() does its topic,
+ * without copying any of its bytes.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @param[in] received_topic An #az_span containing the received topic, in the receive buffer of
+ *                           the MQTT client.
+ * @param[in] received_payload An #az_span containing the received payload, in the receive buffer
+ *                             of the MQTT client. It can be empty.
+ * @param[in] release_callback __[nullable]__ The function which recycles the receive buffer, called
+ *                             by az_iot_hub_client_received_message_release(). Can be `NULL`.
+ * @param[in] release_user_context __[nullable]__ The context passed to \p release_callback.
+ * @param[out] out_message The #az_iot_hub_client_received_message, referring to
+ *                         \p received_topic and \p received_payload.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The message was parsed. It must be released with
+ * az_iot_hub_client_received_message_release().
+ * @retval other The error returned by az_iot_hub_client_parse_received_topic(). \p out_message
+ * doesn't refer to the buffer, and \p release_callback isn't called.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_parse_received_message(
+    az_iot_hub_client const* client,
+    az_span received_topic,
+    az_span received_payload,
+    az_iot_hub_client_receive_buffer_release_fn release_callback,
+    void* release_user_context,
+    az_iot_hub_client_received_message* out_message);
+
+/**
+ * @brief Releases an #az_iot_hub_client_received_message once the application is done with it,
+ * which calls its release callback.
+ *
+ * @details The payload and release callback of \p message are cleared, so that releasing it again
+ * does nothing.
+ *
+ * @param[in,out] message The #az_iot_hub_client_received_message to release.
+ */
+void az_iot_hub_client_received_message_release(az_iot_hub_client_received_message* message);
+
+/*
+ *
+ * Gateway APIs
+ *
+ *   Use the following APIs when one application acts for many device or module identities, such as
+ *   a gateway for downstream devices. The identities share the hostname and options, and each one
+ *   only records its IDs.
+ */
+
+/**
+ * @brief A device or module identity of an #az_iot_hub_gateway.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_span device_id;
+    az_span module_id;
+    uint32_t hash;
+  } _internal;
+} az_iot_hub_gateway_identity;
+
+/**
+ * @brief A set of identities which connect to the same IoT Hub with the same options.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_hub_client_shared shared;
+    az_iot_hub_gateway_identity* identities;
+    int32_t identity_capacity;
+    int32_t identity_count;
+    int32_t* buckets;
+    int32_t bucket_count;
+  } _internal;
+} az_iot_hub_gateway;
+
+/**
+ * @brief Initializes an #az_iot_hub_gateway with no identities.
+ *
+ * @param[out] gateway The #az_iot_hub_gateway to initialize.
+ * @param[in] iot_hub_hostname The IoT Hub Hostname.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_hub_client_options structure shared
+ *                    by every identity. Its `module_id` and `topic_prefix_buffer` must be empty,
+ *                    since they are specific to one identity. If `NULL` is passed, the default
+ *                    options are used.
+ * @param[in] identities The array that holds the identities. It must outlive \p gateway.
+ * @param[in] identity_capacity The number of elements in \p identities.
+ * @param[in] buckets The array of the hash table which maps IDs to identities. It must outlive
+ *                    \p gateway.
+ * @param[in] bucket_count The number of elements in \p buckets. It must be a power of two larger
+ *                         than \p identity_capacity; twice as large keeps lookups short.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_hub_gateway_init(
+    az_iot_hub_gateway* gateway,
+    az_span iot_hub_hostname,
+    az_iot_hub_client_options const* options,
+    az_iot_hub_gateway_identity* identities,
+    int32_t identity_capacity,
+    int32_t* buckets,
+    int32_t bucket_count);
+
+/**
+ * @brief Adds an identity to an #az_iot_hub_gateway.
+ *
+ * @param[in,out] gateway The #az_iot_hub_gateway to use for this call.
+ * @param[in] device_id The Device ID, percent-encoded as for az_iot_hub_client_init(). It must
+ *                      outlive \p gateway.
+ * @param[in] module_id The Module ID, or an empty #az_span for a device identity. It must outlive
+ *                      \p gateway. It must be empty when `AZ_IOT_HUB_LEAN_CLIENT` is defined, since
+ *                      the clients of the identities share the options of the gateway.
+ * @param[out] out_identity_index __[nullable]__ The index of the new identity. Can be `NULL`.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The identity was added.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The gateway already holds `identity_capacity` identities.
+ * @retval #AZ_ERROR_ARG The gateway already holds this identity.
+ */
+AZ_NODISCARD az_result az_iot_hub_gateway_add_identity(
+    az_iot_hub_gateway* gateway,
+    az_span device_id,
+    az_span module_id,
+    int32_t* out_identity_index);
+
+/**
+ * @brief Finds the index of an identity of an #az_iot_hub_gateway.
+ *
+ * @param[in] gateway The #az_iot_hub_gateway to use for this call.
+ * @param[in] device_id The Device ID.
+ * @param[in] module_id The Module ID, or an empty #az_span for a device identity.
+ * @param[out] out_identity_index The index of the identity.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The identity was found.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The gateway does not hold this identity.
+ */
+AZ_NODISCARD az_result az_iot_hub_gateway_find_identity(
+    az_iot_hub_gateway const* gateway,
+    az_span device_id,
+    az_span module_id,
+    int32_t* out_identity_index);
+
+/**
+ * @brief Gets an #az_iot_hub_client for an identity of an #az_iot_hub_gateway, to pass to the
+ * other hub client APIs.
+ *
+ * @details This only copies the shared hostname and options, or a reference to them when
+ * `AZ_IOT_HUB_LEAN_CLIENT` is defined, and the identity's IDs, so it is meant to be called as
+ * needed rather than kept for every identity.
+ *
+ * @param[in] gateway The #az_iot_hub_gateway to use for this call.
+ * @param[in] identity_index The index of the identity.
+ * @param[out] out_client The #az_iot_hub_client of the identity.
+ */
+void az_iot_hub_gateway_get_client(
+    az_iot_hub_gateway const* gateway,
+    int32_t identity_index,
+    az_iot_hub_client* out_client);
+
+/**
+ * @brief Finds the identity a received topic, such as a C2D topic, is addressed to.
+ *
+ * @details The `devices/{device_id}[/modules/{module_id}]/` prefix of the topic is looked up in
+ * the hash table, so the time taken does not depend on the number of identities.
+ *
+ * @param[in] gateway The #az_iot_hub_gateway to use for this call.
+ * @param[in] received_topic An #az_span containing the received topic.
+ * @param[out] out_identity_index The index of the identity the topic is addressed to.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The identity was found.
+ * @retval #AZ_ERROR_IOT_TOPIC_NO_MATCH The topic does not name a device, as is the case of twin
+ * and methods topics.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The gateway does not hold the identity the topic names.
+ */
+AZ_NODISCARD az_result az_iot_hub_gateway_route_received_topic(
+    az_iot_hub_gateway const* gateway,
+    az_span received_topic,
+    int32_t* out_identity_index);
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif //!_az_IOT_HUB_CLIENT_H
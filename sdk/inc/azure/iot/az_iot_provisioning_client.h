@@ -95,6 +95,9 @@ AZ_NODISCARD az_result az_iot_provisioning_client_init(
  * @param[in] mqtt_user_name_size The size, in bytes of \p mqtt_user_name.
  * @param[out] out_mqtt_user_name_length __[nullable]__ Contains the string length, in bytes, of
  *                                                      \p mqtt_user_name. Can be `NULL`.
+ * @remark If \p mqtt_user_name is `NULL` and \p mqtt_user_name_size is 0, nothing is written and
+ * \p out_mqtt_user_name_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  */
 AZ_NODISCARD az_result az_iot_provisioning_client_get_user_name(
@@ -113,6 +116,9 @@ AZ_NODISCARD az_result az_iot_provisioning_client_get_user_name(
  * @param[in] mqtt_client_id_size The size, in bytes of \p mqtt_client_id.
  * @param[out] out_mqtt_client_id_length __[nullable]__ Contains the string length, in bytes, of
  *                                                      of \p mqtt_client_id. Can be `NULL`.
+ * @remark If \p mqtt_client_id is `NULL` and \p mqtt_client_id_size is 0, nothing is written and
+ * \p out_mqtt_client_id_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  */
 AZ_NODISCARD az_result az_iot_provisioning_client_get_client_id(
@@ -173,6 +179,9 @@ AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_signature(
  * @param[in] mqtt_password_size The size, in bytes of \p mqtt_password.
  * @param[out] out_mqtt_password_length __[nullable]__ Contains the string length, in bytes, of
  *                                                     \p mqtt_password. Can be `NULL`.
+ * @remark If \p mqtt_password is `NULL` and \p mqtt_password_size is 0, nothing is written and
+ * \p out_mqtt_password_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation..
  */
 AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_password(
@@ -184,6 +193,41 @@ AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_password(
     size_t mqtt_password_size,
     size_t* out_mqtt_password_length);
 
+/**
+ * @brief Gets the MQTT password, signing the SAS signature with the Shared Access Key.
+ * @remark This combines #az_iot_provisioning_client_sas_get_signature, HMAC-SHA256 signing with
+ *         #az_crypto_hmac_sha256 and #az_iot_provisioning_client_sas_get_password, without any
+ *         additional buffer. Applications which keep the key in a Hardware Security Module use
+ *         those APIs instead.
+ *
+ * @param[in] client The #az_iot_provisioning_client to use for this call.
+ * @param[in] base64_shared_access_key The Base64 encoded Shared Access Key. For group enrollments,
+ *                                     this is the key derived for the registration ID.
+ * @param[in] token_expiration_epoch_time The time, in seconds, from 1/1/1970.
+ * @param[in] key_name The Shared Access Key Name (Policy Name). This is optional. For security
+ *                     reasons we recommend using one key per device instead of using a global
+ *                     policy key.
+ * @param[out] mqtt_password A buffer with sufficient capacity to hold the MQTT password.
+ *                           If successful, contains a null-terminated string with the password that
+ *                           needs to be passed to the MQTT client.
+ * @param[in] mqtt_password_size The size, in bytes of \p mqtt_password.
+ * @param[out] out_mqtt_password_length __[nullable]__ Contains the string length, in bytes, of
+ *                                                     \p mqtt_password. Can be `NULL`.
+ * @remark If \p mqtt_password is `NULL` and \p mqtt_password_size is 0, nothing is written and
+ * \p out_mqtt_password_length receives the length of the longest password the key can sign,
+ * without signing it: the URL-encoding of the signature makes it up to 86 bytes longer
+ * than the password.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_password_from_key(
+    az_iot_provisioning_client const* client,
+    az_span base64_shared_access_key,
+    uint64_t token_expiration_epoch_time,
+    az_span key_name,
+    char* mqtt_password,
+    size_t mqtt_password_size,
+    size_t* out_mqtt_password_length);
+
 /*
  *
  * Register APIs
@@ -258,6 +302,43 @@ AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_paylo
     az_span received_payload,
     az_iot_provisioning_client_register_response* out_response);
 
+/**
+ * @brief Attempts to parse a received message's topic, reading the payload only as far as needed
+ * for the operation ID and status.
+ *
+ * @details Unlike az_iot_provisioning_client_parse_received_topic_and_payload(), the registration
+ * state of \p out_response is left empty, and can be parsed from the payload with
+ * az_iot_provisioning_client_parse_registration_state() once the operation completed. This saves
+ * reading the whole payload of the responses to the many queries of an operation in progress.
+ *
+ * @param[in] client The #az_iot_provisioning_client to use for this call.
+ * @param[in] received_topic An #az_span containing the received MQTT topic.
+ * @param[in] received_payload An #az_span containing the received MQTT payload.
+ * @param[out] out_response If the message is register-operation related, this will contain the
+ *                          #az_iot_provisioning_client_register_response, without its
+ *                          registration state.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_ERROR_IOT_TOPIC_NO_MATCH If the topic is not matching the expected format.
+ */
+AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_payload_lazy(
+    az_iot_provisioning_client const* client,
+    az_span received_topic,
+    az_span received_payload,
+    az_iot_provisioning_client_register_response* out_response);
+
+/**
+ * @brief Parses the registration state, including the assigned hub and device ID or the error
+ * details, from the payload of a register response.
+ *
+ * @param[in] received_payload An #az_span containing the received MQTT payload, as parsed by
+ * az_iot_provisioning_client_parse_received_topic_and_payload_lazy().
+ * @param[out] out_state The #az_iot_provisioning_client_registration_state of the operation.
+ * @return An #az_result value indicating the result of the operation.
+ */
+AZ_NODISCARD az_result az_iot_provisioning_client_parse_registration_state(
+    az_span received_payload,
+    az_iot_provisioning_client_registration_state* out_state);
+
 /**
  * @brief Azure IoT Provisioning Service operation status.
  *
@@ -318,6 +399,9 @@ AZ_INLINE bool az_iot_provisioning_client_operation_complete(
  * @param[in] mqtt_topic_size The size, in bytes of \p mqtt_topic.
  * @param[out] out_mqtt_topic_length __[nullable]__ Contains the string length, in bytes, of
  *                                                  \p mqtt_topic. Can be `NULL`.
+ * @remark If \p mqtt_topic is `NULL` and \p mqtt_topic_size is 0, nothing is written and
+ * \p out_mqtt_topic_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  */
 AZ_NODISCARD az_result az_iot_provisioning_client_register_get_publish_topic(
@@ -339,6 +423,9 @@ AZ_NODISCARD az_result az_iot_provisioning_client_register_get_publish_topic(
  * @param[in] mqtt_topic_size The size, in bytes of \p mqtt_topic.
  * @param[out] out_mqtt_topic_length __[nullable]__ Contains the string length, in bytes, of
  *                                                  \p mqtt_topic. Can be `NULL`.
+ * @remark If \p mqtt_topic is `NULL` and \p mqtt_topic_size is 0, nothing is written and
+ * \p out_mqtt_topic_length receives the exact length, without the null terminator, so that
+ * a buffer of one more byte can be allocated for it.
  * @return An #az_result value indicating the result of the operation.
  */
 AZ_NODISCARD az_result az_iot_provisioning_client_query_status_get_publish_topic(
@@ -348,6 +435,264 @@ AZ_NODISCARD az_result az_iot_provisioning_client_query_status_get_publish_topic
     size_t mqtt_topic_size,
     size_t* out_mqtt_topic_length);
 
+/*
+ *
+ * Register flow APIs
+ *
+ *   The flow drives the register and query requests of a registration, so that a fleet of devices
+ *   provisioning at the same time spreads its requests instead of polling in lockstep.
+ *
+ */
+
+/**
+ * @brief What the application should do next for the registration driven by an
+ * #az_iot_provisioning_client_flow.
+ *
+ */
+typedef enum
+{
+  /// Nothing is due until the time returned with this action.
+  AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT,
+
+  /// Publish a register request, to the topic from
+  /// az_iot_provisioning_client_register_get_publish_topic().
+  AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER,
+
+  /// Publish a query request, to the topic from
+  /// az_iot_provisioning_client_query_status_get_publish_topic() for the operation ID from
+  /// az_iot_provisioning_client_flow_get_operation_id().
+  AZ_IOT_PROVISIONING_FLOW_ACTION_QUERY,
+
+  /// The device was assigned to a hub, as described by the registration state of the last
+  /// response.
+  AZ_IOT_PROVISIONING_FLOW_ACTION_ASSIGNED,
+
+  /// The registration failed, or was disabled, as described by the last response.
+  AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED,
+} az_iot_provisioning_client_flow_action;
+
+/**
+ * @brief Options of an #az_iot_provisioning_client_flow.
+ *
+ */
+typedef struct
+{
+  /// The retries of requests which failed, or got no response, and the source of the random
+  /// numbers of the jitter.
+  az_iot_retry_options retry_options;
+
+  /// The maximum random delay, in milliseconds, added to the first register request and to the
+  /// interval between queries. The default is 1 second.
+  int32_t jitter_msec;
+
+  /// The interval, in milliseconds, between queries when the service doesn't recommend one with
+  /// `retry-after`. The default is 3 seconds.
+  int32_t default_poll_interval_msec;
+
+  /// The time, in milliseconds, to wait for the response to a request before it is retried. The
+  /// default is 30 seconds.
+  int32_t response_timeout_msec;
+} az_iot_provisioning_client_flow_options;
+
+/**
+ * @brief The state of a registration, from the first register request until the device is
+ * assigned or the registration failed.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    az_iot_provisioning_client_flow_options options;
+    az_iot_retry retry;
+    az_span operation_id_buffer;
+    az_span operation_id;
+    az_iot_provisioning_client_flow_action next_action;
+    int64_t next_publish_msec;
+    int64_t response_deadline_msec;
+    bool is_request_pending;
+  } _internal;
+} az_iot_provisioning_client_flow;
+
+/**
+ * @brief Gets the default #az_iot_provisioning_client_flow_options.
+ *
+ * @return An #az_iot_provisioning_client_flow_options.
+ */
+AZ_NODISCARD az_iot_provisioning_client_flow_options
+az_iot_provisioning_client_flow_options_default();
+
+/**
+ * @brief Initializes an #az_iot_provisioning_client_flow, which schedules the first register
+ * request a random delay of up to `jitter_msec` after \p now_msec.
+ *
+ * @param[out] flow The #az_iot_provisioning_client_flow to initialize.
+ * @param[in] now_msec The current time, in milliseconds, such as from az_platform_clock_msec().
+ * @param[in] operation_id_buffer An #az_span the operation ID is copied to, since it must outlive
+ * the MQTT message it is received in. It must remain valid for as long as \p flow is used.
+ * @param[in] options __[nullable]__ A reference to an #az_iot_provisioning_client_flow_options
+ * structure. If `NULL` is passed, the flow will use the default options.
+ */
+void az_iot_provisioning_client_flow_init(
+    az_iot_provisioning_client_flow* flow,
+    int64_t now_msec,
+    az_span operation_id_buffer,
+    az_iot_provisioning_client_flow_options const* options);
+
+/**
+ * @brief Gets what the application should do next for the registration.
+ *
+ * @details When #AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER or #AZ_IOT_PROVISIONING_FLOW_ACTION_QUERY
+ * is returned, the request is considered published: it is returned again only if its response
+ * doesn't arrive within `response_timeout_msec`, after a retry delay.
+ *
+ * @param[in,out] flow The #az_iot_provisioning_client_flow to use for this call.
+ * @param[in] now_msec The current time, in milliseconds.
+ * @param[out] out_next_msec The time, in milliseconds, this function should be called again if
+ * nothing else happens, as when waiting for a response or the next poll. It is \p now_msec when
+ * the returned action is due now.
+ * @return The #az_iot_provisioning_client_flow_action to perform.
+ */
+AZ_NODISCARD az_iot_provisioning_client_flow_action az_iot_provisioning_client_flow_get_next_action(
+    az_iot_provisioning_client_flow* flow,
+    int64_t now_msec,
+    int64_t* out_next_msec);
+
+/**
+ * @brief Updates the registration with a register or query response.
+ *
+ * @details A registration in progress schedules its next query after the `retry-after` the service
+ * recommended, plus a random jitter. A retriable error, such as #AZ_IOT_STATUS_THROTTLED, retries
+ * the request after the longer of `retry-after` and the delay of the retry options. Other errors,
+ * and a failed or disabled registration, end the flow with
+ * #AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED.
+ *
+ * @param[in,out] flow The #az_iot_provisioning_client_flow to use for this call.
+ * @param[in] response The #az_iot_provisioning_client_register_response, as parsed by
+ * az_iot_provisioning_client_parse_received_topic_and_payload() or its `_lazy` variant.
+ * @param[in] now_msec The current time, in milliseconds.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The response was handled.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The operation status of the response is unknown. The flow is
+ * left as it was.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The operation ID doesn't fit in the buffer given to
+ * az_iot_provisioning_client_flow_init(). The flow is left as it was.
+ */
+AZ_NODISCARD az_result az_iot_provisioning_client_flow_on_response(
+    az_iot_provisioning_client_flow* flow,
+    az_iot_provisioning_client_register_response const* response,
+    int64_t now_msec);
+
+/**
+ * @brief Gets the operation ID of the registration, to build the topic of query requests.
+ *
+ * @param[in] flow The #az_iot_provisioning_client_flow to use for this call.
+ * @return An #az_span containing the operation ID, which is empty until the service accepted the
+ * register request.
+ */
+AZ_NODISCARD AZ_INLINE az_span
+az_iot_provisioning_client_flow_get_operation_id(az_iot_provisioning_client_flow const* flow)
+{
+  return flow->_internal.operation_id;
+}
+
+/*
+ *
+ * Registration cache APIs
+ *
+ *   The cache keeps the hub a device was assigned to across reboots, so that it connects to the
+ *   hub straight away instead of registering with the provisioning service each time it starts.
+ *
+ */
+
+/**
+ * @brief A registration read back from the image written by
+ * az_iot_provisioning_client_cache_write().
+ *
+ */
+typedef struct
+{
+  /// The hostname of the hub the device was assigned to. It refers to the image.
+  az_span assigned_hub_hostname;
+
+  /// The device ID the device was assigned. It refers to the image.
+  az_span device_id;
+
+  /// The time, in seconds from 1/1/1970, the image was written at.
+  uint64_t assigned_epoch_time;
+} az_iot_provisioning_client_cache_entry;
+
+/**
+ * @brief Writes the image of an assigned registration, for the application to persist (e.g. to
+ * flash) and read with az_iot_provisioning_client_cache_read() after the device restarts.
+ *
+ * @param[in] client The #az_iot_provisioning_client which registered the device.
+ * @param[in] registration_state The #az_iot_provisioning_client_registration_state of the response
+ * which ended the registration as `assigned`.
+ * @param[in] current_epoch_time The time, in seconds from 1/1/1970.
+ * @param[out] destination The buffer the image is written to.
+ * @param[out] out_image The part of \p destination the image was written to.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The image was written.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p destination is too small for the image.
+ *
+ * @remarks The image holds the assigned hub and device ID, the time it was written at, and a hash
+ * of the global endpoint, ID scope and registration ID of \p client, so that it is only read back
+ * for the same registration. Its integrity is checked when it is read, so an image whose write was
+ * interrupted is not used.
+ */
+AZ_NODISCARD az_result az_iot_provisioning_client_cache_write(
+    az_iot_provisioning_client const* client,
+    az_iot_provisioning_client_registration_state const* registration_state,
+    uint64_t current_epoch_time,
+    az_span destination,
+    az_span* out_image);
+
+/**
+ * @brief Reads the registration of an image written by az_iot_provisioning_client_cache_write().
+ *
+ * @param[in] client The #az_iot_provisioning_client the device would register with.
+ * @param[in] image The image, as persisted by the application.
+ * @param[in] current_epoch_time The time, in seconds from 1/1/1970.
+ * @param[in] max_age_seconds How long, in seconds, an image can be used after it was written, or 0
+ * for it to be used until the hub rejects the device.
+ * @param[out] out_entry The #az_iot_provisioning_client_cache_entry read from \p image.
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The device can connect to the hub of \p out_entry.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The image is incomplete or corrupted, was written for another
+ * registration, or is older than \p max_age_seconds. The device should register with the
+ * provisioning service.
+ *
+ * @remarks An image written later than \p current_epoch_time, as when the clock of the device
+ * isn't set yet after it restarted, is used: the hub rejecting the device still sends it back to
+ * the provisioning service.
+ */
+AZ_NODISCARD az_result az_iot_provisioning_client_cache_read(
+    az_iot_provisioning_client const* client,
+    az_span image,
+    uint64_t current_epoch_time,
+    uint32_t max_age_seconds,
+    az_iot_provisioning_client_cache_entry* out_entry);
+
+/**
+ * @brief Tells whether the hub of a cached registration rejected the device, so that it should
+ * register with the provisioning service again and write a new image.
+ *
+ * @details The device may have been reassigned to another hub, or its registration deleted from
+ * the hub it was assigned to. An MQTT connection refused as not authorized (CONNACK return code 5)
+ * or with bad credentials (return code 4) is #AZ_IOT_STATUS_UNAUTHORIZED.
+ *
+ * @param[in] status The status of the connection or request to the hub.
+ * @return `true` if the device should register with the provisioning service, `false` if the
+ * failure, such as throttling or a server error, is retried with the same hub.
+ */
+AZ_NODISCARD AZ_INLINE bool
+az_iot_provisioning_client_cache_should_reprovision(az_iot_status status)
+{
+  return status == AZ_IOT_STATUS_UNAUTHORIZED || status == AZ_IOT_STATUS_FORBIDDEN
+      || status == AZ_IOT_STATUS_NOT_FOUND;
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif //!_az_IOT_PROVISIONING_CLIENT_H
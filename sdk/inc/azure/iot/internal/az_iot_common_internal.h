@@ -17,6 +17,7 @@
 
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -51,6 +52,45 @@ AZ_NODISCARD int32_t _az_iot_u64toa_size(uint64_t number);
  */
 AZ_NODISCARD az_result _az_span_copy_url_encode(az_span destination, az_span source, az_span* out_remainder);
 
+/**
+ * @brief Checks the buffer a null-terminated string is written to, which is `NULL` with a size of 0
+ * when only the length of the string is asked for, through `out_length`.
+ */
+#define _az_PRECONDITION_IOT_STRING_BUFFER(buffer, size, out_length) \
+  _az_PRECONDITION(                                                   \
+      ((buffer) != NULL && (size) > 0) || ((buffer) == NULL && (size) == 0 && (out_length) != NULL))
+
+/**
+ * @brief The size, in bytes, of the Base64 encoded HMAC-SHA256 of a SAS signature.
+ */
+#define _az_IOT_SAS_BASE64_HMAC_SHA256_SIZE 44
+
+/**
+ * @brief A Base64 encoded HMAC-SHA256 whose characters are all URL-encoded in a password, which
+ * measures the longest password a signature can give without signing it.
+ */
+#define _az_IOT_SAS_LONGEST_BASE64_HMAC_SHA256 "++++++++++++++++++++++++++++++++++++++++++++"
+
+/**
+ * @brief Signs a SAS signature with a Base64 encoded Shared Access Key.
+ *
+ * @param[in] base64_shared_access_key The Base64 encoded Shared Access Key.
+ * @param[in] signature The SAS signature to sign.
+ * @param[in] key_buffer A span, which must not overlap `signature`, that receives the decoded key.
+ * It is cleared before returning.
+ * @param[out] base64_hmac_sha256_signature The span, of at least
+ * #_az_IOT_SAS_BASE64_HMAC_SHA256_SIZE bytes, that receives the Base64 encoded HMAC-SHA256.
+ * @param[out] out_base64_hmac_sha256_signature The slice of `base64_hmac_sha256_signature` that
+ * was written.
+ * @return An `az_result` value.
+ */
+AZ_NODISCARD az_result _az_iot_sas_sign(
+    az_span base64_shared_access_key,
+    az_span signature,
+    az_span key_buffer,
+    az_span base64_hmac_sha256_signature,
+    az_span* out_base64_hmac_sha256_signature);
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif //!_az_IOT_CORE_INTERNAL_H
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_iot_hub_client_internal.h
+ *
+ * @brief Azure IoT Hub client internal definitions.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_IOT_HUB_CLIENT_INTERNAL_H
+#define _az_IOT_HUB_CLIENT_INTERNAL_H
+
+#include <azure/core/az_span.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief Gets the IoT Hub hostname of the client, wherever `AZ_IOT_HUB_LEAN_CLIENT` keeps it.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @return An #az_span containing the hostname.
+ */
+AZ_NODISCARD AZ_INLINE az_span _az_iot_hub_client_get_hostname(az_iot_hub_client const* client)
+{
+#ifdef AZ_IOT_HUB_LEAN_CLIENT
+  return client->_internal.shared->_internal.iot_hub_hostname;
+#else
+  return client->_internal.iot_hub_hostname;
+#endif // AZ_IOT_HUB_LEAN_CLIENT
+}
+
+/**
+ * @brief Gets the options of the client, wherever `AZ_IOT_HUB_LEAN_CLIENT` keeps them.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @return A reference to the #az_iot_hub_client_options of the client.
+ */
+AZ_NODISCARD AZ_INLINE az_iot_hub_client_options const*
+_az_iot_hub_client_get_options(az_iot_hub_client const* client)
+{
+#ifdef AZ_IOT_HUB_LEAN_CLIENT
+  return &client->_internal.shared->_internal.options;
+#else
+  return &client->_internal.options;
+#endif // AZ_IOT_HUB_LEAN_CLIENT
+}
+
+/**
+ * @brief Gets the telemetry topic prefix the client built during init, which is always empty when
+ * `AZ_IOT_HUB_LEAN_CLIENT` is defined.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @return An #az_span containing the prefix, or an empty #az_span if the client has none.
+ */
+AZ_NODISCARD AZ_INLINE az_span
+_az_iot_hub_client_get_telemetry_topic_prefix(az_iot_hub_client const* client)
+{
+#ifdef AZ_IOT_HUB_LEAN_CLIENT
+  (void)client;
+  return AZ_SPAN_EMPTY;
+#else
+  return client->_internal.telemetry_topic_prefix;
+#endif // AZ_IOT_HUB_LEAN_CLIENT
+}
+
+/**
+ * @brief Gets the module ID of the client, which is always empty when `AZ_NO_IOT_HUB_MODULE_ID` is
+ * defined, so that the compiler drops the code handling module identities.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @return An #az_span containing the module ID, or an empty #az_span for a device identity.
+ */
+AZ_NODISCARD AZ_INLINE az_span _az_iot_hub_client_get_module_id(az_iot_hub_client const* client)
+{
+#ifdef AZ_NO_IOT_HUB_MODULE_ID
+  (void)client;
+  return AZ_SPAN_EMPTY;
+#else
+  return _az_iot_hub_client_get_options(client)->module_id;
+#endif // AZ_NO_IOT_HUB_MODULE_ID
+}
+
+/**
+ * @brief Gets the model ID of the client, which is always empty when `AZ_NO_IOT_HUB_MODEL_ID` is
+ * defined.
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @return An #az_span containing the model ID, or an empty #az_span if the device has none.
+ */
+AZ_NODISCARD AZ_INLINE az_span _az_iot_hub_client_get_model_id(az_iot_hub_client const* client)
+{
+#ifdef AZ_NO_IOT_HUB_MODEL_ID
+  (void)client;
+  return AZ_SPAN_EMPTY;
+#else
+  return _az_iot_hub_client_get_options(client)->model_id;
+#endif // AZ_NO_IOT_HUB_MODEL_ID
+}
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_IOT_HUB_CLIENT_INTERNAL_H
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief This header defines the functions your application uses to set up the HTTP transport
+ * adapter for the lwIP raw API and mbedTLS, which targets microcontrollers without an operating
+ * system.
+ *
+ * @details If you add option `-DTRANSPORT_LWIP_MBEDTLS=ON` with cmake, the `az_lwip_mbedtls`
+ * library implements #az_http_client_send_request() with lwIP TCP connections, secured by mbedTLS
+ * for `https` URLs. lwIP is built by your application, with its own `lwipopts.h`, so its include
+ * directories are given with `-DLWIP_INCLUDE_DIRS=...`, and it needs `LWIP_TCP` and `LWIP_DNS`.
+ *
+ * The adapter keeps RAM and copies to a minimum:
+ *
+ * - The status line, the headers and the body of a plain HTTP response are passed to the
+ * #az_http_response (or to its body sink) straight from the payloads of the pbufs lwIP received,
+ * and each pbuf is released as soon as it is consumed, so the TCP window only opens as fast as the
+ * response is consumed. A response with chunked transfer coding is decoded as it arrives.
+ * - A single mbedTLS context is set up once, and is reset for each new connection rather than
+ * allocated again.
+ * - Once connection reuse is enabled with #az_http_client_connection_reuse_init(), the connection
+ * of a request is kept alive and used again by a request to the same host, without a new TCP or
+ * TLS handshake.
+ *
+ * @note You MUST NOT use any symbols (macros, functions, structures, enums, etc.)
+ * prefixed with an underscore ('_') directly in your application code. These symbols
+ * are part of Azure SDK's internal implementation; we do not document these symbols
+ * and they are subject to change in future versions of the SDK which would break your code.
+ */
+
+#ifndef _az_LWIP_MBEDTLS_H
+#define _az_LWIP_MBEDTLS_H
+
+#include <azure/core/az_result.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief The mbedTLS SSL configuration, which is declared by `mbedtls/ssl.h`.
+ */
+struct mbedtls_ssl_config;
+
+/**
+ * @brief Defines the callback the adapter calls while it waits for the network.
+ *
+ * @param[in] user_context The `poll_context` of the #az_http_client_lwip_options.
+ *
+ * @remarks It runs lwIP: without an operating system (`NO_SYS=1`), it passes the frames the
+ * network interface received to lwIP and calls `sys_check_timeouts()`. With one, it unlocks the
+ * lwIP core, sleeps, and locks it again.
+ */
+typedef void (*az_http_client_lwip_poll_fn)(void* user_context);
+
+/**
+ * @brief Allows the user to customize how the lwIP and mbedTLS HTTP transport adapter sends
+ * requests.
+ */
+typedef struct
+{
+  /// The mbedTLS configuration of the connections to `https` URLs, with its random number
+  /// generator and the trusted CA certificates set up. `https` URLs fail when it is `NULL`. It
+  /// must stay alive until #az_http_client_lwip_cleanup() is called.
+  struct mbedtls_ssl_config const* tls_config;
+
+  /// The callback which runs lwIP while the adapter waits for the network.
+  az_http_client_lwip_poll_fn poll;
+
+  /// The user context \p poll is called with.
+  void* poll_context;
+
+  /// The longest time, in milliseconds, the adapter waits for the network before the request
+  /// fails, whether it is for the host name to be resolved, for the connection to be established
+  /// or for more of the response.
+  int32_t timeout_msec;
+} az_http_client_lwip_options;
+
+/**
+ * @brief Gets the default #az_http_client_lwip_options.
+ *
+ * @details Call this to obtain an initialized #az_http_client_lwip_options structure that can be
+ * afterwards modified and passed to #az_http_client_lwip_init().
+ *
+ * @return #az_http_client_lwip_options.
+ */
+AZ_NODISCARD AZ_INLINE az_http_client_lwip_options az_http_client_lwip_options_default()
+{
+  return (az_http_client_lwip_options){
+    .tls_config = NULL,
+    .poll = NULL,
+    .poll_context = NULL,
+    .timeout_msec = 30000,
+  };
+}
+
+/**
+ * @brief Sets up the lwIP and mbedTLS HTTP transport adapter, before the first request is sent.
+ *
+ * @param[in] options A reference to an #az_http_client_lwip_options structure, whose `poll`
+ * callback must be set.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_OUT_OF_MEMORY mbedTLS could not allocate the buffers of its context.
+ * @retval #AZ_ERROR_HTTP_ADAPTER mbedTLS rejected \p options.
+ *
+ * @remarks The adapter calls the lwIP raw API from the thread which sends the requests, so it must
+ * be the thread which runs lwIP, or hold the lwIP core lock.
+ */
+AZ_NODISCARD az_result az_http_client_lwip_init(az_http_client_lwip_options const* options);
+
+/**
+ * @brief Closes the connection kept alive by the adapter, and releases its mbedTLS context.
+ *
+ * @remarks It is safe to call this function when the adapter is not set up.
+ */
+void az_http_client_lwip_cleanup();
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_LWIP_MBEDTLS_H
@@ -20,10 +20,13 @@
 #include <azure/core/az_credentials.h>
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_config_internal.h>
 #include <azure/core/internal/az_http_internal.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <azure/core/_az_cfg_prefix.h>
@@ -33,6 +36,23 @@
  */
 static az_span const AZ_STORAGE_API_VERSION = AZ_SPAN_LITERAL_FROM_STR("2019-02-02");
 
+enum
+{
+  _az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE = 14 * sizeof(_az_http_request_header),
+  _az_STORAGE_BLOBS_CRC64_BASE64_SIZE = 12, // the Base64 of the 8 bytes of a CRC-64
+};
+
+/**
+ * @brief The size, in bytes, of a block ID generated by #az_storage_blobs_blob_get_block_id().
+ */
+#define AZ_STORAGE_BLOBS_BLOCK_ID_SIZE 8
+
+/**
+ * @brief The maximum number of blocks a block blob can be staged with, using block IDs from
+ * #az_storage_blobs_blob_get_block_id().
+ */
+#define AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT 50000
+
 /**
  * @brief Allows customization of the blob client.
  */
@@ -41,6 +61,31 @@ typedef struct
   /// Optional values used to override the default retry policy options.
   az_http_policy_retry_options retry_options;
 
+  /// Optional counters and callback which receive metrics about each request the client sends.
+  az_http_policy_metrics_options metrics_options;
+
+  /// Optional coalescer, which may be shared by several clients, letting identical `GET` and
+  /// `HEAD` requests sent at the same time share one response. Only the clients with the same
+  /// credential share responses. If `NULL`, every request is sent.
+  az_http_request_coalescer* coalescer;
+
+  /// Optional cache, which may be shared by several clients, of the responses to `GET` requests
+  /// which have an `ETag`. They are revalidated with `If-None-Match`, and served from the cache
+  /// when the service answers `304 Not Modified`. If `NULL`, no response is cached.
+  az_http_response_cache* response_cache;
+
+  /// Optional tracer, which may be shared by several clients, sending a W3C `traceparent` header
+  /// with the sampled requests and recording their spans. If `NULL`, requests aren't traced.
+  az_http_tracer* tracer;
+
+  /// Optional rate limiter, which may be shared by several clients, pacing each attempt to send a
+  /// request. If `NULL`, requests are sent as fast as they are made.
+  az_http_rate_limiter* rate_limiter;
+
+  /// Optional circuit breaker, which may be shared by several clients, failing the requests to a
+  /// host which is failing instead of sending and retrying them. If `NULL`, every request is sent.
+  az_http_circuit_breaker* circuit_breaker;
+
   struct
   {
     /// Services pass API versions in the header or in query parameters used by the API Version
@@ -49,11 +94,20 @@ typedef struct
 
     /// Options for the telemetry policy.
     _az_http_policy_telemetry_options telemetry_options;
+
+    /// Options for the coalescing policy, set from #coalescer and the client's credential.
+    _az_http_policy_coalescing_options coalescing_options;
   } _internal;
 } az_storage_blobs_blob_client_options;
 
 /**
  * @brief Azure Storage Blobs Blob Client.
+ *
+ * @remarks Once initialized, a client can be used from several threads at once. Each request is
+ * built in the buffers its caller provides, and the state the policies of the pipeline share
+ * between requests, such as the cached tokens and the metrics, is only updated atomically. Only
+ * the SAS tokens of an #az_storage_blobs_shared_key_credential, which are created in its signing
+ * buffer, must be created from one thread at a time.
  */
 typedef struct
 {
@@ -63,9 +117,14 @@ typedef struct
     uint8_t endpoint_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
     // this url will point to endpoint_buffer
     az_span endpoint;
+    // where the query of the endpoint starts, as in az_http_request, found once during init
+    int32_t endpoint_query_start;
     _az_http_pipeline pipeline;
     az_storage_blobs_blob_client_options options;
     _az_credential* credential;
+    // the prewarm running on the platform executor, which the first request waits for
+    az_platform_work prewarm_work;
+    bool is_prewarming;
   } _internal;
 } az_storage_blobs_blob_client;
 
@@ -74,8 +133,9 @@ typedef struct
  *
  * @param[out] out_client The blob client instance to initialize.
  * @param[in] endpoint A URL to a blob storage account.
- * @param credential The object used for authentication. #AZ_CREDENTIAL_ANONYMOUS should be
- * used for SAS.
+ * @param credential The object used for authentication: an
+ * #az_storage_blobs_shared_key_credential, an #az_storage_blobs_sas_credential, or
+ * #AZ_CREDENTIAL_ANONYMOUS when the \p endpoint already contains a SAS token or the blob is public.
  * @param[in] options A reference to an #az_storage_blobs_blob_client_options structure which
  * defines custom behavior of the client.
  *
@@ -89,12 +149,296 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
     void* credential,
     az_storage_blobs_blob_client_options const* options);
 
+/**
+ * @brief Opens a connection to the endpoint of \p ref_client, so that its first request finds
+ * the DNS lookup, the TCP connection and the TLS handshake done already.
+ *
+ * @details It enables connection reuse with #az_http_client_connection_reuse_init() and sends a
+ * `HEAD` request for the endpoint, without credentials, straight to the HTTP transport. The
+ * connection stays open whatever the status code of the response is.
+ *
+ * @param[in] ref_client The blob client to open a connection for.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK A connection to the endpoint is open.
+ * @retval #AZ_ERROR_DEPENDENCY_NOT_PROVIDED The HTTP transport adapter does not support connection
+ * reuse.
+ * @retval other The failure of the HTTP transport adapter to connect.
+ */
+AZ_NODISCARD az_result
+az_storage_blobs_blob_client_prewarm(az_storage_blobs_blob_client* ref_client);
+
+/**
+ * @brief Runs #az_storage_blobs_blob_client_prewarm() on the platform executor, while the
+ * application prepares its first request.
+ *
+ * @details The next request of \p ref_client waits until the prewarm is done, and a failed prewarm
+ * only means that request opens its own connection.
+ *
+ * @param[in] ref_client The blob client to open a connection for.
+ *
+ * @remarks As for any request with connection reuse, no other client may send a request until the
+ * prewarm is done.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The prewarm was submitted, or has run.
+ */
+AZ_NODISCARD az_result
+az_storage_blobs_blob_client_prewarm_submit(az_storage_blobs_blob_client* ref_client);
+
+/**
+ * @brief The largest size, in bytes, of a decoded storage account key.
+ */
+#define AZ_STORAGE_BLOBS_ACCOUNT_KEY_MAX_SIZE 64
+
+enum
+{
+  _az_STORAGE_BLOBS_ACCOUNT_NAME_MAX_SIZE = 24,
+  _az_STORAGE_BLOBS_SIGNATURE_BASE64_SIZE = 44, // the Base64 of the 32 bytes of an HMAC-SHA256
+  _az_STORAGE_BLOBS_SHARED_KEY_AUTHORIZATION_SIZE = sizeof("SharedKey :") - 1
+      + _az_STORAGE_BLOBS_ACCOUNT_NAME_MAX_SIZE + _az_STORAGE_BLOBS_SIGNATURE_BASE64_SIZE,
+  _az_STORAGE_BLOBS_RFC1123_DATE_SIZE = sizeof("Wed, 21 Oct 2015 07:28:00 GMT") - 1,
+  _az_STORAGE_BLOBS_STRING_TO_SIGN_MAX_SIZE = 1024, // enough for the requests of the blob client
+};
+
+/**
+ * @brief Defines the callback signature the shared key credential gets the current time with.
+ *
+ * @return The current time, in seconds since 1970-01-01 00:00:00 UTC, such as from `time()` of the
+ * C library or from a clock synchronized with SNTP.
+ */
+typedef AZ_NODISCARD int64_t (*az_storage_blobs_get_time_fn)(void);
+
+/**
+ * @brief A credential which signs each request with the key of the storage account, as the
+ * `SharedKey` authorization scheme.
+ *
+ * @details Requests are signed locally with HMAC-SHA256, so no token is ever requested. The
+ * `x-ms-date` header, the text which is signed and the `Authorization` header of each request are
+ * built on the stack of the request, up to 1 KiB of signed text, so the credential can be used by
+ * several requests at once. The signing buffer given to
+ * #az_storage_blobs_shared_key_credential_init() is only used to create SAS tokens, so those must
+ * not be created from several threads at once.
+ */
+typedef struct
+{
+  _az_credential credential; // must be the first field in every credential structure
+  struct
+  {
+    uint8_t key[AZ_STORAGE_BLOBS_ACCOUNT_KEY_MAX_SIZE];
+    int32_t key_size;
+    // "SharedKey <account name>:", which each request copies and appends its signature to.
+    uint8_t authorization_buffer[_az_STORAGE_BLOBS_SHARED_KEY_AUTHORIZATION_SIZE];
+    int32_t authorization_prefix_size;
+    az_span account_name;
+    az_span signing_buffer;
+    az_storage_blobs_get_time_fn get_time;
+  } _internal;
+} az_storage_blobs_shared_key_credential;
+
+/**
+ * @brief Initializes a shared key credential.
+ *
+ * @param[out] out_credential The credential to initialize.
+ * @param[in] account_name The name of the storage account, of at most 24 characters.
+ * @param[in] account_key The key of the storage account, as it is shown in the Azure portal, in
+ * Base64. It is decoded, so it doesn't need to stay valid.
+ * @param[in] signing_buffer The buffer the text signed to create a SAS token is written to, by
+ * #az_storage_blobs_get_account_sas() and #az_storage_blobs_get_blob_sas(). It holds the options
+ * of the token and the names of its container and blob, and it must stay valid for as long as the
+ * credential is used. Requests are signed on the stack instead.
+ * @param[in] get_time The function the `x-ms-date` header of each request is set from.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ARG The \p account_name is too long.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p account_key decodes to more than
+ * #AZ_STORAGE_BLOBS_ACCOUNT_KEY_MAX_SIZE bytes.
+ * @retval other The \p account_key isn't valid Base64.
+ */
+AZ_NODISCARD az_result az_storage_blobs_shared_key_credential_init(
+    az_storage_blobs_shared_key_credential* out_credential,
+    az_span account_name,
+    az_span account_key,
+    az_span signing_buffer,
+    az_storage_blobs_get_time_fn get_time);
+
+/**
+ * @brief The permissions, validity and restrictions of a shared access signature (SAS).
+ */
+typedef struct
+{
+  /// The permissions granted, as the letters of the service, in this order: `r` (read), `a`
+  /// (add), `c` (create), `w` (write), `d` (delete), `l` (list), such as `rw`.
+  az_span permissions;
+
+  /// The time the SAS becomes valid, in the ISO 8601 format with seconds, such as
+  /// `2024-01-01T00:00:00Z`. If empty, it is valid as soon as it is created.
+  az_span start;
+
+  /// The time the SAS expires, in the same format as #start.
+  az_span expiry;
+
+  /// Optional IP address, or range of addresses such as `168.1.5.60-168.1.5.70`, which the SAS
+  /// is restricted to.
+  az_span ip_range;
+
+  /// Optional protocols allowed: `https`, or `https,http`.
+  az_span protocol;
+} az_storage_blobs_sas_options;
+
+/**
+ * @brief Gets the default SAS options: read permission only, with no expiry, which must be set.
+ *
+ * @return An #az_storage_blobs_sas_options.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_sas_options az_storage_blobs_sas_options_default()
+{
+  return (az_storage_blobs_sas_options){
+    .permissions = AZ_SPAN_FROM_STR("r"),
+    .start = AZ_SPAN_EMPTY,
+    .expiry = AZ_SPAN_EMPTY,
+    .ip_range = AZ_SPAN_EMPTY,
+    .protocol = AZ_SPAN_EMPTY,
+  };
+}
+
+/**
+ * @brief Creates an account SAS token for the blob service of the account of a shared key
+ * credential.
+ *
+ * @details The token is signed locally, with the signing buffer of the \p credential, and can be
+ * given to an #az_storage_blobs_sas_credential or to a device which must not have the account key.
+ *
+ * @param[in] credential The shared key credential of the account.
+ * @param[in] options The permissions and validity of the SAS. The permissions of an account SAS
+ * may also include `u` (update) and `p` (process), after `l`.
+ * @param[in] resource_types The resource types the SAS grants access to: `s` (service), `c`
+ * (container) and `o` (object), such as `co`.
+ * @param[out] destination The buffer the token is written to, without a leading `?`.
+ * @param[out] out_token The #az_span of \p destination the token was written to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination, or the signing buffer of the
+ * \p credential, is too small.
+ */
+AZ_NODISCARD az_result az_storage_blobs_get_account_sas(
+    az_storage_blobs_shared_key_credential* credential,
+    az_storage_blobs_sas_options const* options,
+    az_span resource_types,
+    az_span destination,
+    az_span* out_token);
+
+/**
+ * @brief Creates a service SAS token for a container or a blob of the account of a shared key
+ * credential.
+ *
+ * @details The token is signed locally, with the signing buffer of the \p credential.
+ *
+ * @param[in] credential The shared key credential of the account.
+ * @param[in] options The permissions and validity of the SAS.
+ * @param[in] container_name The name of the container.
+ * @param[in] blob_name The name of the blob, or #AZ_SPAN_EMPTY for a SAS to the whole container.
+ * @param[out] destination The buffer the token is written to, without a leading `?`.
+ * @param[out] out_token The #az_span of \p destination the token was written to.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The \p destination, or the signing buffer of the
+ * \p credential, is too small.
+ */
+AZ_NODISCARD az_result az_storage_blobs_get_blob_sas(
+    az_storage_blobs_shared_key_credential* credential,
+    az_storage_blobs_sas_options const* options,
+    az_span container_name,
+    az_span blob_name,
+    az_span destination,
+    az_span* out_token);
+
+/**
+ * @brief A credential which adds a SAS token to the query of each request.
+ *
+ * @details Unlike putting the token in the endpoint of the client, the token can be replaced with
+ * #az_storage_blobs_sas_credential_init() before it expires, without initializing the client
+ * again.
+ */
+typedef struct
+{
+  _az_credential credential; // must be the first field in every credential structure
+  struct
+  {
+    az_span token;
+  } _internal;
+} az_storage_blobs_sas_credential;
+
+/**
+ * @brief Initializes a SAS credential.
+ *
+ * @param[out] out_credential The credential to initialize.
+ * @param[in] token The SAS token, with or without a leading `?`, such as one from
+ * #az_storage_blobs_get_blob_sas(). It must stay valid for as long as the credential is used.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_storage_blobs_sas_credential_init(
+    az_storage_blobs_sas_credential* out_credential,
+    az_span token);
+
+/**
+ * @brief Conditions on the current state of a blob, which the service checks before carrying out
+ * a request, so that data which didn't change isn't transferred again.
+ *
+ * @details Each condition left empty isn't checked. A request whose conditions aren't met fails
+ * with `304 Not Modified` for a read whose `if_none_match` or `if_modified_since` isn't met, and
+ * with `412 Precondition Failed` otherwise.
+ */
+typedef struct
+{
+  /// Only carry out the request if the ETag of the blob is this one, or if the blob exists for
+  /// `*`.
+  az_span if_match;
+
+  /// Only carry out the request if the ETag of the blob isn't this one, or if the blob doesn't
+  /// exist for `*`.
+  az_span if_none_match;
+
+  /// Only carry out the request if the blob changed since this date, in the RFC 1123 format of
+  /// the `Last-Modified` header, such as `Wed, 21 Oct 2015 07:28:00 GMT`.
+  az_span if_modified_since;
+
+  /// Only carry out the request if the blob didn't change since this date, in the same format as
+  /// #if_modified_since.
+  az_span if_unmodified_since;
+} az_storage_blobs_blob_request_conditions;
+
 /**
  * @brief Allows customization of the upload operation.
  */
 typedef struct
 {
   az_context* context; ///< Operation context.
+
+  /// An optional #az_span_arena which the URL and headers of the request are allocated from,
+  /// instead of worst-case sized buffers on the stack. The caller resets it once the operation
+  /// returns. #az_storage_blobs_blob_stage_block_submit() doesn't use it, since its buffers are in
+  /// the #az_storage_blobs_blob_stage_block_operation.
+  az_span_arena* arena;
+
+  /// Whether to check the integrity of the content with its CRC-64, from az_crypto_crc64(). When
+  /// the content is in a buffer, the CRC-64 is sent in the `x-ms-content-crc64` header, and the
+  /// service fails the request if the content it received doesn't match it. When the content comes
+  /// from a provider, the CRC-64 is computed as the content is sent and compared with the one the
+  /// service returns, and the operation fails with #AZ_ERROR_STORAGE_CONTENT_CRC64_MISMATCH if they
+  /// differ. Either way, the content is not read again to compute it.
+  bool validate_content_crc64;
+
+  /// Conditions on the blob being replaced, such as an `if_none_match` of `*` to only create
+  /// blobs which don't exist. They apply to the requests which write the blob: uploads in one
+  /// request and block list commits.
+  az_storage_blobs_blob_request_conditions conditions;
+
   struct
   {
     /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
@@ -125,6 +469,14 @@ AZ_NODISCARD AZ_INLINE az_storage_blobs_blob_upload_options
 az_storage_blobs_blob_upload_options_default()
 {
   return (az_storage_blobs_blob_upload_options){ .context = &az_context_application,
+                                                 .arena = NULL,
+                                                 .validate_content_crc64 = false,
+                                                 .conditions = {
+                                                     .if_match = AZ_SPAN_EMPTY,
+                                                     .if_none_match = AZ_SPAN_EMPTY,
+                                                     .if_modified_since = AZ_SPAN_EMPTY,
+                                                     .if_unmodified_since = AZ_SPAN_EMPTY,
+                                                 },
                                                  ._internal = { .unused = false } };
 }
 
@@ -148,6 +500,1840 @@ AZ_NODISCARD az_result az_storage_blobs_blob_upload(
     az_storage_blobs_blob_upload_options const* options,
     az_http_response* ref_response);
 
+/**
+ * @brief Uploads the contents to blob storage, reading them from a callback as they are sent
+ * instead of from a contiguous buffer.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] content_size The size, in bytes, of the blob content to upload.
+ * @param[in] content_provider The #az_http_request_body_provider_fn that fills the blob content,
+ * one chunk at a time. It is called again from offset `0` if the upload is retried.
+ * @param user_context A context specific user-defined struct or set of fields that is passed
+ * through to calls to \p content_provider.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for uploading the blob. If `NULL` is passed, the client
+ * will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_from_provider(
+    az_storage_blobs_blob_client* ref_client,
+    int64_t content_size,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Uploads the contents of a file mapped into memory to blob storage.
+ *
+ * @details The transport reads the content straight from the mapping, so the file is never copied
+ * into a buffer of the application, and the operating system reads it ahead as it is sent.
+ * Content larger than an #az_span can hold is sent through a content provider, which the
+ * transport calls for one chunk of the mapping at a time.
+ *
+ * To upload a large file in blocks, take each block from the mapping with
+ * #az_platform_file_mapping_get_span() and pass it to #az_storage_blobs_blob_stage_block() or
+ * #az_storage_blobs_blob_stage_block_submit(), which then don't copy it either.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] mapping The #az_platform_file_mapping of the file, from #az_platform_file_map().
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for uploading the blob. If `NULL` is passed, the client
+ * will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_from_file(
+    az_storage_blobs_blob_client* ref_client,
+    az_platform_file_mapping const* mapping,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Gets the ID of the block at \p block_index, to be used with
+ * #az_storage_blobs_blob_stage_block() and #az_storage_blobs_blob_commit_block_list().
+ *
+ * @details All the IDs generated with this function have the same length
+ * (#AZ_STORAGE_BLOBS_BLOCK_ID_SIZE), as required by the service for the blocks of a blob, and
+ * sort in the same order as their \p block_index.
+ *
+ * @param[in] block_index The zero-based position of the block within the blob. Must be between 0
+ * and `AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT - 1`.
+ * @param[in] destination The #az_span where the block ID will be written.
+ * @param[out] out_block_id The slice of \p destination containing the block ID.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p destination is smaller than
+ * #AZ_STORAGE_BLOBS_BLOCK_ID_SIZE.
+ */
+AZ_NODISCARD az_result
+az_storage_blobs_blob_get_block_id(int32_t block_index, az_span destination, az_span* out_block_id);
+
+/**
+ * @brief Uploads one block of a block blob, without committing it (Put Block).
+ *
+ * @details Large payloads can be uploaded by splitting them into blocks, staging each block with
+ * this function, and then committing all of them with #az_storage_blobs_blob_commit_block_list().
+ * Blocks can be staged in any order, and from multiple threads at once using the same client. When
+ * a block fails to be staged, only that block needs to be sent again.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] block_id The ID of the block, from #az_storage_blobs_blob_get_block_id().
+ * @param[in] content The block content to upload.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for uploading the block. If `NULL` is passed, the client
+ * will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block(
+    az_storage_blobs_blob_client* ref_client,
+    az_span block_id,
+    az_span content,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief A block being staged asynchronously with #az_storage_blobs_blob_stage_block_submit().
+ */
+typedef struct
+{
+  /// The HTTP operation sending the block. Use #az_http_client_async_operation_is_completed() and
+  /// #az_http_client_async_operation_get_result() to find out when and how it completes.
+  az_http_client_async_operation operation;
+
+  struct
+  {
+    uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+    uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+    uint8_t content_length_buffer[_az_INT64_AS_STR_BUFFER_SIZE];
+    uint8_t content_crc64_buffer[_az_STORAGE_BLOBS_CRC64_BASE64_SIZE];
+    // "bytes=" followed by the first and last byte positions, for blocks staged from a URL.
+    uint8_t source_range_buffer[6 + _az_INT64_AS_STR_BUFFER_SIZE * 2];
+    az_http_request request;
+  } _internal;
+} az_storage_blobs_blob_stage_block_operation;
+
+/**
+ * @brief Starts uploading one block of a block blob on an #az_http_client_async, without waiting
+ * for it to complete.
+ *
+ * @details This lets many blocks of the same blob be in flight at once from a single thread. The
+ * API version, telemetry and credential policies of the client are applied to the request before
+ * it is submitted. Retries are up to the caller: a block whose operation fails can be submitted
+ * again on its own.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in,out] ref_async_client The #az_http_client_async used to send the block.
+ * @param[out] out_operation The #az_storage_blobs_blob_stage_block_operation tracking the block. It
+ * must stay alive until its operation completes.
+ * @param[in] block_id The ID of the block, from #az_storage_blobs_blob_get_block_id().
+ * @param[in] content The block content to upload. It must stay alive until the operation
+ * completes.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for uploading the block. If `NULL` is passed, the client
+ * will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * It must stay alive until the operation completes.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The block was submitted.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_storage_blobs_blob_stage_block_operation* out_operation,
+    az_span block_id,
+    az_span content,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Commits the blocks staged with #az_storage_blobs_blob_stage_block() as the new content of
+ * the blob (Put Block List).
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] block_ids The IDs of the blocks, in the order in which they make up the blob.
+ * @param[in] block_ids_count The number of blocks in \p block_ids.
+ * @param[in] body_buffer The #az_span used to build the block list sent to the service. It needs
+ * 61 bytes, plus 17 bytes and the size of the block ID for each block.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for committing the blocks. If `NULL` is passed, the
+ * client will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p body_buffer is too small for the block list.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_commit_block_list(
+    az_storage_blobs_blob_client* ref_client,
+    az_span const* block_ids,
+    int32_t block_ids_count,
+    az_span body_buffer,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief The largest blob, in bytes, #az_storage_blobs_blob_copy_from_url() copies in one request.
+ */
+#define AZ_STORAGE_BLOBS_COPY_FROM_URL_MAX_SIZE (256 * 1024 * 1024)
+
+/**
+ * @brief The largest block, in bytes, #az_storage_blobs_blob_stage_block_from_url() copies.
+ */
+#define AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE (100 * 1024 * 1024)
+
+/**
+ * @brief The largest number of blocks #az_storage_blobs_blob_copy_from_url_in_blocks() keeps in
+ * flight.
+ */
+#define AZ_STORAGE_BLOBS_COPY_MAX_CONCURRENCY 8
+
+/**
+ * @brief Copies a blob from \p source_url to the blob of the client, on the service, without its
+ * content going through the client (Copy Blob From URL).
+ *
+ * @details The service reads the source and writes the blob before it answers, with `202 Accepted`
+ * and an `x-ms-copy-status` of `success`. The source can be in another storage account, as long as
+ * its URL can be read as it is: a public blob, or one whose URL has a SAS token. Blobs larger than
+ * #AZ_STORAGE_BLOBS_COPY_FROM_URL_MAX_SIZE are copied with
+ * #az_storage_blobs_blob_copy_from_url_in_blocks() instead.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure, of the destination blob.
+ * @param[in] source_url The URL of the source blob, url-encoded. It is sent in a header, so it
+ * isn't copied.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure, whose context, arena and conditions on the destination blob are used. If `NULL` is
+ * passed, the client will use the default options (i.e.
+ * #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_copy_from_url(
+    az_storage_blobs_blob_client* ref_client,
+    az_span source_url,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Stages one block of a block blob with a range of the blob at \p source_url, which the
+ * service copies without it going through the client (Put Block From URL).
+ *
+ * @details The block is committed with #az_storage_blobs_blob_commit_block_list(), as the blocks
+ * staged with #az_storage_blobs_blob_stage_block() are, and both kinds can be mixed in the same
+ * blob.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure, of the destination blob.
+ * @param[in] block_id The ID of the block, from #az_storage_blobs_blob_get_block_id().
+ * @param[in] source_url The URL of the source blob, url-encoded, as for
+ * #az_storage_blobs_blob_copy_from_url().
+ * @param[in] source_offset The position, within the source blob, of the first byte of the block.
+ * @param[in] size The size of the block, in bytes, from 1 to
+ * #AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure, whose context and arena are used. If `NULL` is passed, the client will use the
+ * default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block_from_url(
+    az_storage_blobs_blob_client* ref_client,
+    az_span block_id,
+    az_span source_url,
+    int64_t source_offset,
+    int64_t size,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Starts staging one block of a block blob from a range of the blob at \p source_url, as
+ * #az_storage_blobs_blob_stage_block_from_url() does, on an #az_http_client_async, without waiting
+ * for it to complete.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure, of the destination blob.
+ * @param[in,out] ref_async_client The #az_http_client_async used to send the request.
+ * @param[out] out_operation The #az_storage_blobs_blob_stage_block_operation tracking the block. It
+ * must stay alive until its operation completes.
+ * @param[in] block_id The ID of the block, from #az_storage_blobs_blob_get_block_id().
+ * @param[in] source_url The URL of the source blob, url-encoded. It must stay alive until the
+ * operation completes.
+ * @param[in] source_offset The position, within the source blob, of the first byte of the block.
+ * @param[in] size The size of the block, in bytes, from 1 to
+ * #AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure, whose context is used. If `NULL` is passed, the client will use the default options
+ * (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * It must stay alive until the operation completes.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The request was submitted.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block_from_url_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_storage_blobs_blob_stage_block_operation* out_operation,
+    az_span block_id,
+    az_span source_url,
+    int64_t source_offset,
+    int64_t size,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Allows customization of #az_storage_blobs_blob_copy_from_url_in_blocks().
+ */
+typedef struct
+{
+  /// The #az_context each request is sent with.
+  az_context* context;
+
+  /// The size, in bytes, of each block but the last one, at most
+  /// #AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE.
+  int32_t block_size;
+
+  /// The number of blocks staged at once, at most #AZ_STORAGE_BLOBS_COPY_MAX_CONCURRENCY.
+  int32_t concurrency;
+
+  /// Conditions on the destination blob, which apply to the block list commit.
+  az_storage_blobs_blob_request_conditions conditions;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_blob_copy_options;
+
+/**
+ * @brief Gets the default copy options, which copy blocks of 8 MiB, 4 at once.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_blob_copy_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_blob_copy_options
+az_storage_blobs_blob_copy_options_default()
+{
+  return (az_storage_blobs_blob_copy_options){ .context = &az_context_application,
+                                               .block_size = 8 * 1024 * 1024,
+                                               .concurrency = 4,
+                                               .conditions = {
+                                                   .if_match = AZ_SPAN_EMPTY,
+                                                   .if_none_match = AZ_SPAN_EMPTY,
+                                                   .if_modified_since = AZ_SPAN_EMPTY,
+                                                   .if_unmodified_since = AZ_SPAN_EMPTY,
+                                               },
+                                               ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Copies a blob of any size from \p source_url to the blob of the client, on the service,
+ * by staging its blocks from the source in parallel, then committing them.
+ *
+ * @details The blocks are staged with #az_storage_blobs_blob_stage_block_from_url_submit(), up to
+ * the concurrency of the options at once, so the content never goes through the client. A block
+ * whose request fails is staged again with #az_storage_blobs_blob_stage_block_from_url(), through
+ * the pipeline of the client and its retries.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure, of the destination blob.
+ * @param[in,out] ref_async_client The #az_http_client_async the blocks are staged with.
+ * @param[in] source_url The URL of the source blob, url-encoded, as for
+ * #az_storage_blobs_blob_copy_from_url().
+ * @param[in] source_size The size of the source blob, in bytes, such as from
+ * #az_storage_blobs_blob_parse_properties().
+ * @param[in] block_list_buffer The #az_span used to build the block list sent to the service. It
+ * needs 61 bytes, plus 25 bytes for each block.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_copy_options
+ * structure. If `NULL` is passed, the default options are used.
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * It holds the response of the block list commit, or of the block which failed.
+ *
+ * @return An #az_result value indicating the result of the operation. As with the other
+ * operations, a response with an error status still returns #AZ_OK.
+ * @retval #AZ_OK The service answered the last request sent, which is in \p ref_response.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p block_list_buffer is too small for the blocks of the
+ * blob, or the blob needs more than #AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT blocks.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_copy_from_url_in_blocks(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_span source_url,
+    int64_t source_size,
+    az_span block_list_buffer,
+    az_storage_blobs_blob_copy_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief The size, in bytes, of the buffer of an #az_storage_blobs_blob_upload_journal which tracks
+ * \p block_count blocks.
+ */
+#define AZ_STORAGE_BLOBS_UPLOAD_JOURNAL_SIZE(block_count) (12 + (((block_count) + 7) / 8))
+
+/**
+ * @brief Tracks which blocks of a resumable upload, sent with
+ * #az_storage_blobs_blob_upload_resumable(), are already staged.
+ *
+ * @details The progress is kept in a buffer provided by the caller, which can save it, to a file
+ * for instance, and give it back to #az_storage_blobs_blob_upload_journal_init() to resume the
+ * upload later, even from another process.
+ */
+typedef struct
+{
+  struct
+  {
+    uint8_t* staged_blocks;
+    int64_t content_size;
+    int32_t block_size;
+    int32_t block_count;
+  } _internal;
+} az_storage_blobs_blob_upload_journal;
+
+/**
+ * @brief Initializes an #az_storage_blobs_blob_upload_journal over \p buffer.
+ *
+ * @details If \p buffer already holds the journal of an upload of the same size, in blocks of the
+ * same size, its progress is kept. Otherwise, the journal starts with no block staged.
+ *
+ * @param[out] out_journal The #az_storage_blobs_blob_upload_journal to initialize.
+ * @param[in,out] buffer The #az_span the progress is kept in. It must be at least
+ * `AZ_STORAGE_BLOBS_UPLOAD_JOURNAL_SIZE(block_count)` bytes, for the number of blocks the content
+ * is split into, and stay alive while the journal is used.
+ * @param[in] content_size The size, in bytes, of the blob content. Must be greater than `0`.
+ * @param[in] block_size The size, in bytes, of each block but the last one, which may be smaller.
+ * Must be greater than `0`, and split the content into at most #AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT
+ * blocks.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p buffer is too small.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_journal_init(
+    az_storage_blobs_blob_upload_journal* out_journal,
+    az_span buffer,
+    int64_t content_size,
+    int32_t block_size);
+
+/**
+ * @brief Gets the number of blocks the content of an #az_storage_blobs_blob_upload_journal is
+ * split into.
+ *
+ * @param[in] journal The #az_storage_blobs_blob_upload_journal.
+ *
+ * @return The number of blocks.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_storage_blobs_blob_upload_journal_get_block_count(
+    az_storage_blobs_blob_upload_journal const* journal)
+{
+  return journal->_internal.block_count;
+}
+
+/**
+ * @brief Checks whether the block at \p block_index is staged.
+ *
+ * @param[in] journal The #az_storage_blobs_blob_upload_journal.
+ * @param[in] block_index The zero-based position of the block within the blob.
+ *
+ * @return `true` if the block is staged, `false` if it still needs to be sent.
+ */
+AZ_NODISCARD bool az_storage_blobs_blob_upload_journal_is_block_staged(
+    az_storage_blobs_blob_upload_journal const* journal,
+    int32_t block_index);
+
+/**
+ * @brief Records that the block at \p block_index is staged.
+ *
+ * @details #az_storage_blobs_blob_upload_resumable() records the blocks it stages. Call this when
+ * staging blocks some other way, such as with #az_storage_blobs_blob_stage_block_submit(), using
+ * the block IDs from #az_storage_blobs_blob_get_block_id().
+ *
+ * @param[in,out] ref_journal The #az_storage_blobs_blob_upload_journal.
+ * @param[in] block_index The zero-based position of the block within the blob.
+ */
+void az_storage_blobs_blob_upload_journal_set_block_staged(
+    az_storage_blobs_blob_upload_journal* ref_journal,
+    int32_t block_index);
+
+/**
+ * @brief Gets the number of blocks recorded as staged.
+ *
+ * @param[in] journal The #az_storage_blobs_blob_upload_journal.
+ *
+ * @return The number of blocks staged.
+ */
+AZ_NODISCARD int32_t az_storage_blobs_blob_upload_journal_get_staged_count(
+    az_storage_blobs_blob_upload_journal const* journal);
+
+/**
+ * @brief Gets the list of blocks of a blob, both committed and uncommitted (Get Block List).
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for the request. If `NULL` is passed, the client will
+ * use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * Its buffer needs room for the headers and about 60 bytes for each block of the blob.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_get_block_list(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Makes an #az_storage_blobs_blob_upload_journal match the blocks the service has, from the
+ * response of #az_storage_blobs_blob_get_block_list().
+ *
+ * @details Only the blocks whose ID is the one #az_storage_blobs_blob_get_block_id() gives for
+ * their position, and whose size is the one expected at that position, are recorded as staged.
+ * Blocks the journal recorded but the service no longer has, such as uncommitted blocks it
+ * discarded after a week, are sent again. A blob which doesn't exist has no block.
+ *
+ * @param[in,out] ref_journal The #az_storage_blobs_blob_upload_journal to update.
+ * @param[in,out] ref_response The response of #az_storage_blobs_blob_get_block_list().
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The journal was updated.
+ * @retval #AZ_ERROR_ARG The response is neither a block list nor a "not found" error.
+ * @retval #AZ_ERROR_UNEXPECTED_END The block list is incomplete, such as when it didn't fit in the
+ * buffer of the response. The journal is left as it was.
+ * @retval other The response or the block list is invalid.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_journal_update(
+    az_storage_blobs_blob_upload_journal* ref_journal,
+    az_http_response* ref_response);
+
+/**
+ * @brief Uploads the blocks of a block blob which \p ref_journal doesn't record as staged, then
+ * commits all of them.
+ *
+ * @details Each block is read from \p content_provider into \p block_buffer, staged with
+ * #az_storage_blobs_blob_stage_block() and recorded in \p ref_journal. When a block fails, the
+ * upload stops and the journal holds the progress, so that calling this function again, after
+ * #az_storage_blobs_blob_upload_journal_init() over the saved journal in another process, only
+ * sends the missing blocks. Use #az_storage_blobs_blob_get_block_list() and
+ * #az_storage_blobs_blob_upload_journal_update() first when the journal may not have been saved
+ * after the last blocks were staged.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] content_provider The #az_http_request_body_provider_fn that fills the blob content,
+ * one chunk at a time. It is called from the offset of each block that is sent.
+ * @param user_context A context specific user-defined struct or set of fields that is passed
+ * through to calls to \p content_provider.
+ * @param[in] block_buffer The #az_span each block is read into before it is sent. It must be at
+ * least as large as the block size of the journal.
+ * @param[in,out] ref_journal The #az_storage_blobs_blob_upload_journal of the upload.
+ * @param[in] block_list_buffer The #az_span used to build the block list sent to the service. It
+ * needs 61 bytes, plus 25 bytes for each block.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for uploading the blocks. If `NULL` is passed, the
+ * client will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()). An
+ * arena is reset before each request, so it only needs room for one.
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * It holds the response of the block list commit, or of the block which failed.
+ *
+ * @return An #az_result value indicating the result of the operation. As with the other
+ * operations, a response with an error status still returns #AZ_OK.
+ * @retval #AZ_OK The service answered the last request sent, which is in \p ref_response.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p block_buffer or \p block_list_buffer is too small.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_resumable(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_span block_buffer,
+    az_storage_blobs_blob_upload_journal* ref_journal,
+    az_span block_list_buffer,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Uploads content whose size isn't known until it ends, such as content which is generated
+ * as it is uploaded, in blocks which are staged as soon as they are filled, then commits them.
+ *
+ * @details The service needs the size of each request before it is sent, so the content is read
+ * from \p content_provider into \p block_buffer until it is full, or until the content ends, and
+ * the block is staged with #az_storage_blobs_blob_stage_block(). Only one block of the content is
+ * held in memory at a time, and a block which is retried is sent again from \p block_buffer, so
+ * \p content_provider is called once for each piece of the content, in order.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] content_provider The #az_http_request_body_provider_fn that fills the blob content,
+ * one chunk at a time, and sets its `out_size` to `0` once the content ends.
+ * @param user_context A context specific user-defined struct or set of fields that is passed
+ * through to calls to \p content_provider.
+ * @param[in] block_buffer The #az_span each block is read into before it is sent. Its size is the
+ * size of the blocks, so the content can be up to #AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT times as large.
+ * @param[in] block_list_buffer The #az_span used to build the block list sent to the service. It
+ * needs 61 bytes, plus 25 bytes for each block.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for uploading the blocks. If `NULL` is passed, the
+ * client will use the default options (i.e. #az_storage_blobs_blob_upload_options_default()). An
+ * arena is reset before each request, so it only needs room for one.
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * It holds the response of the block list commit, or of the block which failed.
+ *
+ * @return An #az_result value indicating the result of the operation. As with the other
+ * operations, a response with an error status still returns #AZ_OK.
+ * @retval #AZ_OK The service answered the last request sent, which is in \p ref_response.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p block_list_buffer is too small for the blocks of the
+ * content, or the content needs more than #AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT blocks.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_from_stream(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_span block_buffer,
+    az_span block_list_buffer,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Allows customization of the download operation.
+ */
+typedef struct
+{
+  az_context* context; ///< Operation context.
+
+  /// Position, within the blob, of the first byte to download.
+  int64_t range_offset;
+
+  /// Number of bytes to download starting at #range_offset, or `0` to download up to the end of
+  /// the blob.
+  int64_t range_size;
+
+  /// An optional #az_span_arena which the URL and headers of the request are allocated from by
+  /// #az_storage_blobs_blob_download(), instead of worst-case sized buffers on the stack. The
+  /// caller resets it once the operation returns.
+  az_span_arena* arena;
+
+  /// Conditions on the blob, such as an `if_none_match` with the ETag of the copy already
+  /// downloaded, which makes the service answer `304 Not Modified`, without the content, if the
+  /// blob didn't change.
+  az_storage_blobs_blob_request_conditions conditions;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_blob_download_options;
+
+/**
+ * @brief Gets the default blob download options, which download the whole blob.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_blob_download_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_blob_download_options
+az_storage_blobs_blob_download_options_default()
+{
+  return (az_storage_blobs_blob_download_options){ .context = &az_context_application,
+                                                   .range_offset = 0,
+                                                   .range_size = 0,
+                                                   .arena = NULL,
+                                                   .conditions = {
+                                                       .if_match = AZ_SPAN_EMPTY,
+                                                       .if_none_match = AZ_SPAN_EMPTY,
+                                                       .if_modified_since = AZ_SPAN_EMPTY,
+                                                       .if_unmodified_since = AZ_SPAN_EMPTY,
+                                                   },
+                                                   ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Downloads the contents of a blob, or of a range of it, from blob storage.
+ *
+ * @details Large blobs can be downloaded as several ranges, each with its own request (and its own
+ * retries) and its own response buffer, which only needs to be large enough for that range.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_download_options
+ * structure which defines the range to download. If `NULL` is passed, the client will use the
+ * default options (i.e. #az_storage_blobs_blob_download_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_download(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief A blob range being downloaded asynchronously with
+ * #az_storage_blobs_blob_download_submit().
+ */
+typedef struct
+{
+  /// The HTTP operation downloading the range. Use #az_http_client_async_operation_is_completed()
+  /// and #az_http_client_async_operation_get_result() to find out when and how it completes.
+  az_http_client_async_operation operation;
+
+  struct
+  {
+    uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+    uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+    // "bytes=" followed by the first and last byte positions.
+    uint8_t range_buffer[6 + _az_INT64_AS_STR_BUFFER_SIZE * 2];
+    az_http_request request;
+  } _internal;
+} az_storage_blobs_blob_download_operation;
+
+/**
+ * @brief Starts downloading the contents of a blob, or of a range of it, on an
+ * #az_http_client_async, without waiting for it to complete.
+ *
+ * @details This lets many ranges of the same blob be downloaded at once from a single thread. The
+ * API version, telemetry and credential policies of the client are applied to the request before
+ * it is submitted. Retries are up to the caller: a range whose operation fails can be submitted
+ * again on its own.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in,out] ref_async_client The #az_http_client_async used to download the range.
+ * @param[out] out_operation The #az_storage_blobs_blob_download_operation tracking the range. It
+ * must stay alive until its operation completes.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_download_options
+ * structure which defines the range to download. If `NULL` is passed, the client will use the
+ * default options (i.e. #az_storage_blobs_blob_download_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ * It must stay alive until the operation completes.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The download was submitted.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_download_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_storage_blobs_blob_download_operation* out_operation,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Gets the size of the whole blob from the response to a ranged download, so that the
+ * remaining ranges can be downloaded.
+ *
+ * @param[in,out] ref_response The #az_http_response of a successful
+ * #az_storage_blobs_blob_download() or #az_storage_blobs_blob_download_submit().
+ * @param[out] out_blob_size The size of the whole blob, in bytes.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The response has no `Content-Range` header, which is the case
+ * when the whole blob was downloaded.
+ * @retval #AZ_ERROR_UNEXPECTED_CHAR The `Content-Range` header is malformed.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_download_get_blob_size(
+    az_http_response* ref_response,
+    int64_t* out_blob_size);
+
+/**
+ * @brief Allows customization of an #az_storage_blobs_transfer_tuner, with the bounds it tunes
+ * the transfer within.
+ */
+typedef struct
+{
+  /// The smallest block or range size, in bytes, which is also the size transfers start with.
+  int32_t min_block_size;
+
+  /// The largest block or range size, in bytes.
+  int32_t max_block_size;
+
+  /// The smallest number of blocks or ranges in flight, which is also the number transfers start
+  /// with.
+  int32_t min_concurrency;
+
+  /// The largest number of blocks or ranges in flight.
+  int32_t max_concurrency;
+
+  /// How long each block should take, in milliseconds. Blocks which take much less spend a larger
+  /// part of their time on the round trip of their request, so the block size grows, and blocks
+  /// which take much longer make each retry costly, so it shrinks.
+  int32_t target_block_msec;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_transfer_tuner_options;
+
+/**
+ * @brief Gets the default transfer tuner options, with blocks of 64 KiB to 8 MiB, 1 to 8 of them
+ * in flight, and a target of 2 seconds per block.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_transfer_tuner_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_transfer_tuner_options
+az_storage_blobs_transfer_tuner_options_default()
+{
+  return (az_storage_blobs_transfer_tuner_options){ .min_block_size = 64 * 1024,
+                                                    .max_block_size = 8 * 1024 * 1024,
+                                                    .min_concurrency = 1,
+                                                    .max_concurrency = 8,
+                                                    .target_block_msec = 2000,
+                                                    ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Tunes the block size and the number of blocks in flight of a staged upload or of a
+ * ranged download, from the blocks as they complete.
+ *
+ * @details The block size follows the time each block takes, compared to the target of the
+ * options. The concurrency is tuned a round at a time, a round being as many blocks as are in
+ * flight: it grows by one while the throughput of a round is at least a tenth above the previous
+ * one, and shrinks by one when it is a tenth below. A `503 Server Busy` or `500 Operation Timed
+ * Out`, which is how the service throttles, halves it.
+ *
+ * An #az_storage_blobs_download_reader uses a tuner given in its options. For an upload, read
+ * #az_storage_blobs_transfer_tuner_get_block_size() for each block to stage, keep up to
+ * #az_storage_blobs_transfer_tuner_get_concurrency() of them in flight, and record each one with
+ * #az_storage_blobs_transfer_tuner_record() as it completes.
+ */
+typedef struct
+{
+  struct
+  {
+    az_storage_blobs_transfer_tuner_options options;
+    int32_t block_size;
+    int32_t concurrency;
+    int32_t round_count;
+    int64_t round_size;
+    int64_t round_start_msec;
+    int64_t round_end_msec;
+    int64_t previous_round_rate;
+  } _internal;
+} az_storage_blobs_transfer_tuner;
+
+/**
+ * @brief Initializes an #az_storage_blobs_transfer_tuner, at the smallest block size and
+ * concurrency.
+ *
+ * @param[out] out_tuner The #az_storage_blobs_transfer_tuner to initialize.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_transfer_tuner_options
+ * structure. If `NULL` is passed, the default options are used.
+ */
+void az_storage_blobs_transfer_tuner_init(
+    az_storage_blobs_transfer_tuner* out_tuner,
+    az_storage_blobs_transfer_tuner_options const* options);
+
+/**
+ * @brief Records a block of the transfer which completed.
+ *
+ * @param[in,out] ref_tuner The #az_storage_blobs_transfer_tuner.
+ * @param[in] block_size The size of the block, in bytes.
+ * @param[in] start_msec The #az_platform_clock_msec() time the block was submitted.
+ * @param[in] end_msec The #az_platform_clock_msec() time the block completed.
+ * @param[in] status_code The status code of the response to the block, or `0` if the transport
+ * failed. Only successful blocks are measured.
+ */
+void az_storage_blobs_transfer_tuner_record(
+    az_storage_blobs_transfer_tuner* ref_tuner,
+    int64_t block_size,
+    int64_t start_msec,
+    int64_t end_msec,
+    az_http_status_code status_code);
+
+/**
+ * @brief Gets the size of the next block or range to transfer, in bytes.
+ *
+ * @param[in] tuner The #az_storage_blobs_transfer_tuner.
+ *
+ * @return The block size, within the bounds of the options.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_storage_blobs_transfer_tuner_get_block_size(az_storage_blobs_transfer_tuner const* tuner)
+{
+  return tuner->_internal.block_size;
+}
+
+/**
+ * @brief Gets the number of blocks or ranges to keep in flight.
+ *
+ * @param[in] tuner The #az_storage_blobs_transfer_tuner.
+ *
+ * @return The concurrency, within the bounds of the options.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_storage_blobs_transfer_tuner_get_concurrency(az_storage_blobs_transfer_tuner const* tuner)
+{
+  return tuner->_internal.concurrency;
+}
+
+/**
+ * @brief The largest number of ranges an #az_storage_blobs_download_reader keeps in flight.
+ */
+#define AZ_STORAGE_BLOBS_DOWNLOAD_READER_MAX_WINDOWS 8
+
+/**
+ * @brief The part of each window of an #az_storage_blobs_download_reader which is left for the
+ * status line and headers of its response, in bytes.
+ */
+#define AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE 2048
+
+enum
+{
+  _az_STORAGE_BLOBS_ETAG_MAX_SIZE = 64,
+};
+
+/**
+ * @brief Allows customization of an #az_storage_blobs_download_reader.
+ */
+typedef struct
+{
+  /// The #az_context each range is downloaded with.
+  az_context* context;
+
+  /// Position, within the blob, of the first byte to read.
+  int64_t range_offset;
+
+  /// The number of ranges downloaded ahead of the one being read, at most
+  /// #AZ_STORAGE_BLOBS_DOWNLOAD_READER_MAX_WINDOWS.
+  int32_t window_count;
+
+  /// Conditions on the blob. Unless it has an `if_match`, the ranges after the first one are
+  /// downloaded only if the blob still has the ETag of the first one, so that a blob written while
+  /// it is read fails with `412 Precondition Failed` rather than mixing both versions.
+  az_storage_blobs_blob_request_conditions conditions;
+
+  /// An optional #az_storage_blobs_transfer_tuner which sets the size of each range and how many
+  /// are in flight, within the windows of the reader, and records each range as it completes.
+  az_storage_blobs_transfer_tuner* tuner;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_download_reader_options;
+
+/**
+ * @brief Gets the default download reader options, which read the whole blob with 4 ranges in
+ * flight.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_download_reader_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_download_reader_options
+az_storage_blobs_download_reader_options_default()
+{
+  return (az_storage_blobs_download_reader_options){ .context = &az_context_application,
+                                                     .range_offset = 0,
+                                                     .window_count = 4,
+                                                     .conditions = {
+                                                         .if_match = AZ_SPAN_EMPTY,
+                                                         .if_none_match = AZ_SPAN_EMPTY,
+                                                         .if_modified_since = AZ_SPAN_EMPTY,
+                                                         .if_unmodified_since = AZ_SPAN_EMPTY,
+                                                     },
+                                                     .tuner = NULL,
+                                                     ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Reads a blob from start to end, while the next ranges are already being downloaded.
+ *
+ * @details The buffer of the reader is split into windows, each receiving the response to one
+ * ranged Get Blob request submitted with #az_storage_blobs_blob_download_submit(). The windows are
+ * read in order, and each one is submitted again for the next range as soon as it was read, so
+ * that the content is downloaded while the previous ranges are being processed.
+ *
+ * The ranges only move forward while the #az_http_client_async is polled, which reading does. A
+ * consumer which takes long to process a range can call #az_http_client_async_poll() with a `0`
+ * timeout meanwhile, or drive the client from an event loop.
+ */
+typedef struct
+{
+  struct
+  {
+    az_storage_blobs_blob_client* client;
+    az_http_client_async* async_client;
+    struct
+    {
+      az_storage_blobs_blob_download_operation download;
+      az_http_response response;
+      int64_t offset;
+      int64_t submit_msec;
+      int32_t size;
+      bool assigned;
+      bool in_flight;
+      bool measured;
+    } windows[AZ_STORAGE_BLOBS_DOWNLOAD_READER_MAX_WINDOWS];
+    az_span buffer;
+    int32_t window_count;
+    int32_t range_size;
+    int32_t head;
+    bool head_read;
+    bool done;
+    int64_t next_offset;
+    int64_t blob_size;
+    uint8_t etag[_az_STORAGE_BLOBS_ETAG_MAX_SIZE];
+    int32_t etag_size;
+    az_storage_blobs_download_reader_options options;
+  } _internal;
+} az_storage_blobs_download_reader;
+
+/**
+ * @brief Initializes an #az_storage_blobs_download_reader. Nothing is downloaded until the first
+ * read.
+ *
+ * @param[out] out_reader The #az_storage_blobs_download_reader to initialize.
+ * @param[in] client The #az_storage_blobs_blob_client of the blob. It must stay alive while the
+ * reader is used.
+ * @param[in] async_client The #az_http_client_async the ranges are downloaded with. It must stay
+ * alive while the reader is used.
+ * @param[in] buffer The #az_span the windows are taken from. Each window gets an equal part of it,
+ * and receives a range of that size less #AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE. It must
+ * stay alive while the reader is used.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_download_reader_options
+ * structure. If `NULL` is passed, the default options are used.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p buffer doesn't leave room for any content in each window.
+ */
+AZ_NODISCARD az_result az_storage_blobs_download_reader_init(
+    az_storage_blobs_download_reader* out_reader,
+    az_storage_blobs_blob_client* client,
+    az_http_client_async* async_client,
+    az_span buffer,
+    az_storage_blobs_download_reader_options const* options);
+
+/**
+ * @brief Reads the next range of the blob, waiting for it to be downloaded if it isn't yet.
+ *
+ * @param[in,out] ref_reader The #az_storage_blobs_download_reader.
+ * @param[out] out_content The content of the range, in the window it was downloaded to. It is
+ * valid until the next call to #az_storage_blobs_download_reader_read(), which reuses the window
+ * for a later range. It is empty if the blob was empty.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success. The blob was read to the end once
+ * #az_storage_blobs_download_reader_is_done() is true.
+ * @retval #AZ_ERROR_STORAGE_DOWNLOAD_FAILED The service didn't return the range, and
+ * #az_storage_blobs_download_reader_get_response() has its response.
+ * @retval other The transport failed to download the range.
+ *
+ * @remarks After a failure, the next call downloads the same range again.
+ */
+AZ_NODISCARD az_result az_storage_blobs_download_reader_read(
+    az_storage_blobs_download_reader* ref_reader,
+    az_span* out_content);
+
+/**
+ * @brief Gets the response to the range being read, such as to find out why it failed.
+ *
+ * @param[in] reader The #az_storage_blobs_download_reader.
+ *
+ * @return The #az_http_response of the current window.
+ */
+AZ_NODISCARD AZ_INLINE az_http_response*
+az_storage_blobs_download_reader_get_response(az_storage_blobs_download_reader* reader)
+{
+  return &reader->_internal.windows[reader->_internal.head].response;
+}
+
+/**
+ * @brief Checks whether a blob was read to the end.
+ *
+ * @param[in] reader The #az_storage_blobs_download_reader.
+ *
+ * @return `true` once the last range was read.
+ */
+AZ_NODISCARD AZ_INLINE bool
+az_storage_blobs_download_reader_is_done(az_storage_blobs_download_reader const* reader)
+{
+  return reader->_internal.done;
+}
+
+/**
+ * @brief Abandons the ranges still being downloaded, such as to stop reading before the end.
+ *
+ * @details The reader, its buffer and the #az_http_client_async can be released afterwards.
+ *
+ * @param[in,out] ref_reader The #az_storage_blobs_download_reader.
+ */
+void az_storage_blobs_download_reader_cancel(az_storage_blobs_download_reader* ref_reader);
+
+/**
+ * @brief Allows customization of #az_storage_blobs_blob_download_to_file().
+ */
+typedef struct
+{
+  /// The #az_context each range is downloaded with.
+  az_context* context;
+
+  /// The number of ranges downloaded at once, at most
+  /// #AZ_STORAGE_BLOBS_DOWNLOAD_READER_MAX_WINDOWS.
+  int32_t window_count;
+
+  /// Conditions on the blob. Unless it has an `if_match`, the ranges after the first one are
+  /// downloaded only if the blob still has the ETag of the first one.
+  az_storage_blobs_blob_request_conditions conditions;
+
+  /// Whether the disk space of the whole blob is reserved with #az_platform_file_allocate() once
+  /// the first range tells its size, so that the download fails right away if it doesn't fit.
+  bool preallocate;
+
+  /// An optional #az_storage_blobs_transfer_tuner which sets the size of each range and how many
+  /// are in flight, within the windows, and records each range as it completes.
+  az_storage_blobs_transfer_tuner* tuner;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_blob_download_to_file_options;
+
+/**
+ * @brief Gets the default download to file options, which download 4 ranges at once and don't
+ * reserve the disk space.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_blob_download_to_file_options
+ * structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_blob_download_to_file_options
+az_storage_blobs_blob_download_to_file_options_default()
+{
+  return (az_storage_blobs_blob_download_to_file_options){ .context = &az_context_application,
+                                                           .window_count = 4,
+                                                           .conditions = {
+                                                               .if_match = AZ_SPAN_EMPTY,
+                                                               .if_none_match = AZ_SPAN_EMPTY,
+                                                               .if_modified_since = AZ_SPAN_EMPTY,
+                                                               .if_unmodified_since = AZ_SPAN_EMPTY,
+                                                           },
+                                                           .preallocate = false,
+                                                           .tuner = NULL,
+                                                           ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Downloads a blob into a file, with several ranges downloaded at once, each written to its
+ * position in the file as soon as it completes.
+ *
+ * @details The buffer is split into windows, as by #az_storage_blobs_download_reader_init(). The
+ * ranges are written with #az_platform_file_write_at() in the order they complete rather than in
+ * the order of the blob, so a slow range doesn't hold back the others, and the memory used doesn't
+ * depend on the size of the blob. Only the blob's content is written: a file longer than the blob
+ * keeps its bytes past the end of the blob.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in,out] ref_async_client The #az_http_client_async the ranges are downloaded with.
+ * @param[in] file The file to write the blob to, opened for writing, as for
+ * #az_platform_file_write_at().
+ * @param[in] buffer The #az_span the windows are taken from. Each window gets an equal part of it,
+ * and receives a range of that size less #AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE.
+ * @param[in] options __[nullable]__ A reference to an
+ * #az_storage_blobs_blob_download_to_file_options structure. If `NULL` is passed, the default
+ * options are used.
+ * @param[out] out_blob_size __[nullable]__ The size of the blob, in bytes, once it was written.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The whole blob was written to the file.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE \p buffer doesn't leave room for any content in each window.
+ * @retval #AZ_ERROR_STORAGE_DOWNLOAD_FAILED The service didn't return one of the ranges.
+ * @retval #AZ_ERROR_PLATFORM_FILE_IO The file couldn't be written, or its space reserved.
+ * @retval other The transport failed to download one of the ranges.
+ *
+ * @remarks On failure, the ranges still being downloaded are cancelled, and the file holds
+ * whichever ranges were written. Calling this function again downloads the whole blob again.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_download_to_file(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    intptr_t file,
+    az_span buffer,
+    az_storage_blobs_blob_download_to_file_options const* options,
+    int64_t* out_blob_size);
+
+/**
+ * @brief Gets the properties of a blob, without its content (Get Blob Properties).
+ *
+ * @details This is a `HEAD` request, so it is a cheap way to find out whether a blob changed, from
+ * its ETag, last modified date, size or content MD5, which
+ * #az_storage_blobs_blob_parse_properties() reads from the response.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_download_options
+ * structure, whose context, arena and conditions are used. The range is ignored. If `NULL` is
+ * passed, the client will use the default options (i.e.
+ * #az_storage_blobs_blob_download_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_get_properties(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief The properties of a blob, as returned in the headers of a response.
+ */
+typedef struct
+{
+  /// The `ETag` of the blob, which changes each time the blob is written.
+  az_span etag;
+
+  /// The `Last-Modified` date of the blob, in RFC 1123 format.
+  az_span last_modified;
+
+  /// The `Content-MD5` of the blob, in Base64, or empty if the blob doesn't have one.
+  az_span content_md5;
+
+  /// The `x-ms-blob-type` of the blob: `BlockBlob`, `AppendBlob` or `PageBlob`.
+  az_span blob_type;
+
+  /// The size of the blob, in bytes, from the `Content-Length` of a Get Blob Properties response.
+  int64_t content_length;
+} az_storage_blobs_blob_properties;
+
+/**
+ * @brief Reads the properties of a blob from the headers of a response, such as the one of
+ * #az_storage_blobs_blob_get_properties().
+ *
+ * @details Properties which the response doesn't have are left empty, and the content length `-1`.
+ *
+ * @param[in,out] ref_response The #az_http_response to read the properties from.
+ * @param[out] out_properties The #az_storage_blobs_blob_properties, whose spans point into the
+ * buffer of \p ref_response.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other The response is invalid.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_parse_properties(
+    az_http_response* ref_response,
+    az_storage_blobs_blob_properties* out_properties);
+
+/**
+ * @brief The maximum size, in bytes, of a block appended to an append blob.
+ */
+#define AZ_STORAGE_BLOBS_APPEND_BLOCK_MAX_SIZE (4 * 1024 * 1024)
+
+/**
+ * @brief Creates an empty append blob, replacing the blob if it exists, so that blocks can then be
+ * appended to it with an #az_storage_blobs_append_writer.
+ *
+ * @param[in,out] ref_client An #az_storage_blobs_blob_client structure.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_blob_upload_options
+ * structure which defines custom behavior for the request. If `NULL` is passed, the client will
+ * use the default options (i.e. #az_storage_blobs_blob_upload_options_default()).
+ * @param[in,out] ref_response An initialized #az_http_response where to write HTTP response into.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_create_append_blob(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief Allows customization of an #az_storage_blobs_append_writer.
+ */
+typedef struct
+{
+  az_context* context; ///< Context of the requests sent by the writer.
+
+  /// The number of buffered bytes which makes the writer append them. `0` means when the buffer
+  /// is full.
+  int32_t flush_size;
+
+  /// The longest time, in milliseconds, a record stays buffered before the writer appends it, as
+  /// checked by #az_storage_blobs_append_writer_write() and #az_storage_blobs_append_writer_poll().
+  /// `0` means that records are only appended by size.
+  int32_t flush_interval_msec;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_append_writer_options;
+
+/**
+ * @brief Gets the default append writer options.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_append_writer_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_append_writer_options
+az_storage_blobs_append_writer_options_default()
+{
+  return (az_storage_blobs_append_writer_options){ .context = &az_context_application,
+                                                   .flush_size = 0,
+                                                   .flush_interval_msec = 0,
+                                                   ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Buffers records, such as log lines, and appends them to an append blob in batches.
+ *
+ * @details Each batch is sent with an Append Block request, which only carries the new records,
+ * conditioned on the position the writer expects the blob to end at. If another writer appended
+ * to the blob in the meantime, the service rejects the block instead of interleaving records.
+ */
+typedef struct
+{
+  struct
+  {
+    az_storage_blobs_blob_client* client;
+    az_span buffer;
+    int32_t buffered_size;
+    int64_t append_position;
+    int64_t first_buffered_msec;
+    az_storage_blobs_append_writer_options options;
+  } _internal;
+} az_storage_blobs_append_writer;
+
+/**
+ * @brief Initializes an #az_storage_blobs_append_writer.
+ *
+ * @param[out] out_writer The #az_storage_blobs_append_writer to initialize.
+ * @param[in] client The #az_storage_blobs_blob_client of the append blob, which must exist, such
+ * as after #az_storage_blobs_blob_create_append_blob(). It must stay alive while the writer is
+ * used.
+ * @param[in] buffer The #az_span records are buffered in, which is sent as the body of the Append
+ * Block requests. It must stay alive while the writer is used, and be at most
+ * #AZ_STORAGE_BLOBS_APPEND_BLOCK_MAX_SIZE bytes.
+ * @param[in] append_position The size of the blob, where the first block is appended: `0` for a
+ * blob just created.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_append_writer_options
+ * structure. If `NULL` is passed, the writer will use the default options (i.e.
+ * #az_storage_blobs_append_writer_options_default()).
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_storage_blobs_append_writer_init(
+    az_storage_blobs_append_writer* out_writer,
+    az_storage_blobs_blob_client* client,
+    az_span buffer,
+    int64_t append_position,
+    az_storage_blobs_append_writer_options const* options);
+
+/**
+ * @brief Writes a record, appending the buffered records first if it doesn't fit in the buffer,
+ * and afterwards if they reach the flush size or interval.
+ *
+ * @details A record is never split between two blocks. One larger than the buffer is appended on
+ * its own, without being buffered.
+ *
+ * @param[in,out] ref_writer The #az_storage_blobs_append_writer.
+ * @param[in] record The bytes to append.
+ * @param[in,out] ref_response An initialized #az_http_response where to write the response of the
+ * Append Block requests into, if any is sent.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The record was buffered or appended.
+ * @retval #AZ_ERROR_STORAGE_APPEND_FAILED The service didn't append a block, whose response is in
+ * \p ref_response. The records buffered before \p record are kept, and sent again by the next
+ * flush, but \p record isn't written and needs to be written again.
+ * @retval other Failure, with the same outcome.
+ */
+AZ_NODISCARD az_result az_storage_blobs_append_writer_write(
+    az_storage_blobs_append_writer* ref_writer,
+    az_span record,
+    az_http_response* ref_response);
+
+/**
+ * @brief Appends the buffered records if the oldest of them was written at least
+ * `flush_interval_msec` ago, so that records are appended on time when no more are written.
+ *
+ * @param[in,out] ref_writer The #az_storage_blobs_append_writer.
+ * @param[in,out] ref_response An initialized #az_http_response where to write the response of the
+ * Append Block request into, if it is sent.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK No records were due, or they were appended.
+ * @retval #AZ_ERROR_STORAGE_APPEND_FAILED The service didn't append the block, whose response is
+ * in \p ref_response. The records are still buffered.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_append_writer_poll(
+    az_storage_blobs_append_writer* ref_writer,
+    az_http_response* ref_response);
+
+/**
+ * @brief Appends the buffered records, if any.
+ *
+ * @param[in,out] ref_writer The #az_storage_blobs_append_writer.
+ * @param[in,out] ref_response An initialized #az_http_response where to write the response of the
+ * Append Block request into, if it is sent.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The records were appended, or there were none.
+ * @retval #AZ_ERROR_STORAGE_APPEND_FAILED The service didn't append the block, whose response is
+ * in \p ref_response. The records are still buffered. A status of `412` means the blob doesn't end
+ * where the writer expected: another writer appended to it, or a retried request was in fact
+ * appended before it timed out.
+ * @retval other Failure.
+ */
+AZ_NODISCARD az_result az_storage_blobs_append_writer_flush(
+    az_storage_blobs_append_writer* ref_writer,
+    az_http_response* ref_response);
+
+/**
+ * @brief Gets the position the next block is appended at, which is the size of the blob once the
+ * buffered records are appended.
+ *
+ * @param[in] writer The #az_storage_blobs_append_writer.
+ *
+ * @return The size, in bytes, of the blob as of the last block appended by the writer.
+ */
+AZ_NODISCARD AZ_INLINE int64_t
+az_storage_blobs_append_writer_get_append_position(az_storage_blobs_append_writer const* writer)
+{
+  return writer->_internal.append_position;
+}
+
+/**
+ * @brief Gets the number of bytes buffered and not appended yet.
+ *
+ * @param[in] writer The #az_storage_blobs_append_writer.
+ *
+ * @return The number of bytes buffered.
+ */
+AZ_NODISCARD AZ_INLINE int32_t
+az_storage_blobs_append_writer_get_buffered_size(az_storage_blobs_append_writer const* writer)
+{
+  return writer->_internal.buffered_size;
+}
+
+/**
+ * @brief The largest number of operations a blob batch can hold.
+ */
+#define AZ_STORAGE_BLOBS_BATCH_MAX_COUNT 256
+
+/**
+ * @brief The boundary between the operations of a blob batch request.
+ */
+#define AZ_STORAGE_BLOBS_BATCH_BOUNDARY "batch_a81786c8-e301-4e42-a729-a32ca24ae252"
+
+/**
+ * @brief Allows customization of a blob batch request.
+ */
+typedef struct
+{
+  /// The #az_context the batch request is sent with.
+  az_context* context;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_batch_options;
+
+/**
+ * @brief Gets the default blob batch options.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_batch_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_batch_options az_storage_blobs_batch_options_default()
+{
+  return (az_storage_blobs_batch_options){ .context = &az_context_application,
+                                           ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Operations on the blobs of a container, such as deleting them or changing their tier,
+ * sent in a single multipart Blob Batch request.
+ *
+ * @details Each operation is written as a sub-request to the buffer given to
+ * #az_storage_blobs_batch_init() as it is added, and authorized with the credential of the client
+ * right away. The buffer is the body of the batch request, so nothing is copied when it is sent.
+ */
+typedef struct
+{
+  struct
+  {
+    az_storage_blobs_blob_client* client;
+    az_span buffer;
+    int32_t length;
+    int32_t count;
+  } _internal;
+} az_storage_blobs_batch;
+
+/**
+ * @brief Initializes an empty blob batch.
+ *
+ * @param[out] out_batch The #az_storage_blobs_batch to initialize.
+ * @param[in] client The #az_storage_blobs_blob_client whose endpoint is the URL of the container,
+ * such as `https://<account>.blob.core.windows.net/<container>`. Its credential authorizes each
+ * operation. It must stay alive while the batch is used.
+ * @param[in] buffer The #az_span the operations are written to. Each one takes about 100 bytes,
+ * plus its path, or about 500 with an #az_storage_blobs_shared_key_credential. It must stay alive
+ * while the batch is used.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_storage_blobs_batch_init(
+    az_storage_blobs_batch* out_batch,
+    az_storage_blobs_blob_client* client,
+    az_span buffer);
+
+/**
+ * @brief Adds the deletion of a blob, with its snapshots, to a batch.
+ *
+ * @param[in,out] ref_batch The #az_storage_blobs_batch to add to.
+ * @param[in] blob_name The name of the blob in the container, URL-encoded as needed.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success. The result of the operation has the index of the operations added before
+ * it as its Content-ID.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The batch already has #AZ_STORAGE_BLOBS_BATCH_MAX_COUNT
+ * operations, or its buffer is full. The batch is left as it was.
+ */
+AZ_NODISCARD az_result
+az_storage_blobs_batch_add_delete(az_storage_blobs_batch* ref_batch, az_span blob_name);
+
+/**
+ * @brief Adds the change of the access tier of a blob to a batch.
+ *
+ * @param[in,out] ref_batch The #az_storage_blobs_batch to add to.
+ * @param[in] blob_name The name of the blob in the container, URL-encoded as needed.
+ * @param[in] tier The new tier of the blob: `Hot`, `Cool` or `Archive`.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE The batch already has #AZ_STORAGE_BLOBS_BATCH_MAX_COUNT
+ * operations, or its buffer is full. The batch is left as it was.
+ */
+AZ_NODISCARD az_result az_storage_blobs_batch_add_set_tier(
+    az_storage_blobs_batch* ref_batch,
+    az_span blob_name,
+    az_span tier);
+
+/**
+ * @brief Gets the number of operations in a batch.
+ *
+ * @param[in] batch The #az_storage_blobs_batch.
+ *
+ * @return The number of operations added since the batch was initialized or cleared.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_storage_blobs_batch_get_count(az_storage_blobs_batch const* batch)
+{
+  return batch->_internal.count;
+}
+
+/**
+ * @brief Removes all of the operations of a batch, so that its buffer can be used for the next
+ * ones.
+ *
+ * @param[in,out] ref_batch The #az_storage_blobs_batch to clear.
+ */
+AZ_INLINE void az_storage_blobs_batch_clear(az_storage_blobs_batch* ref_batch)
+{
+  ref_batch->_internal.length = 0;
+  ref_batch->_internal.count = 0;
+}
+
+/**
+ * @brief Sends the operations of a batch in one `POST ?restype=container&comp=batch` request.
+ *
+ * @param[in,out] ref_batch The #az_storage_blobs_batch to send. The closing boundary is written to
+ * its buffer, so it needs some room after the operations.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_batch_options structure.
+ * If `NULL` is passed, the default options are used.
+ * @param[in,out] ref_response An initialized #az_http_response where to write the HTTP response.
+ * It holds the results of all of the operations, which #az_storage_blobs_batch_reader_init()
+ * reads, so it must be large enough for about 300 bytes by operation.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The batch was sent. A `202 Accepted` status means the service carried out the
+ * operations, each of which has its own result.
+ * @retval #AZ_ERROR_ARG The batch is empty.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE There is no room for the closing boundary.
+ */
+AZ_NODISCARD az_result az_storage_blobs_batch_submit(
+    az_storage_blobs_batch* ref_batch,
+    az_storage_blobs_batch_options const* options,
+    az_http_response* ref_response);
+
+/**
+ * @brief The result of one operation of a batch.
+ */
+typedef struct
+{
+  /// The index of the operation in the batch, from 0, or -1 if the service didn't give it.
+  int32_t content_id;
+
+  /// The status code of the operation, such as `202 Accepted` for a deletion.
+  az_http_status_code status_code;
+
+  /// The HTTP response of the operation, which is a slice of the batch response, for its headers
+  /// and error body to be read with #az_http_response_get_next_header() and
+  /// #az_http_response_get_body().
+  az_http_response response;
+} az_storage_blobs_batch_result;
+
+/**
+ * @brief Reads the results of the operations of a batch from the multipart batch response, in
+ * place.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span boundary;
+    az_span remaining;
+  } _internal;
+} az_storage_blobs_batch_reader;
+
+/**
+ * @brief Initializes a reader of the results of a batch.
+ *
+ * @param[out] out_reader The #az_storage_blobs_batch_reader to initialize.
+ * @param[in] response The #az_http_response of #az_storage_blobs_batch_submit(). It must stay
+ * alive, and not be reused, while the results are read.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_ITEM_NOT_FOUND The response isn't multipart, as when the service rejected the
+ * batch as a whole.
+ */
+AZ_NODISCARD az_result az_storage_blobs_batch_reader_init(
+    az_storage_blobs_batch_reader* out_reader,
+    az_http_response* response);
+
+/**
+ * @brief Reads the result of the next operation.
+ *
+ * @param[in,out] ref_reader The #az_storage_blobs_batch_reader.
+ * @param[out] out_result The #az_storage_blobs_batch_result of the next operation.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ * @retval #AZ_ERROR_STORAGE_END_OF_BATCH There are no more results.
+ * @retval #AZ_ERROR_UNEXPECTED_END The response ends before its closing boundary.
+ */
+AZ_NODISCARD az_result az_storage_blobs_batch_reader_next(
+    az_storage_blobs_batch_reader* ref_reader,
+    az_storage_blobs_batch_result* out_result);
+
+/**
+ * @brief The largest size, in bytes, of the continuation marker of a blob listing.
+ */
+#define AZ_STORAGE_BLOBS_LIST_MARKER_MAX_SIZE 256
+
+/**
+ * @brief A blob of a listing, as its fields appear in the List Blobs response.
+ *
+ * @details The spans point into the receive buffer of the #az_storage_blobs_blob_enumerator, so
+ * they are only valid during the call to the #az_storage_blobs_blob_item_fn. Names are XML-escaped,
+ * as in the response, so `&` is `&amp;`.
+ */
+typedef struct
+{
+  /// The name of the blob.
+  az_span name;
+
+  /// The ETag of the blob.
+  az_span etag;
+
+  /// The date the blob was last modified, in the RFC 1123 format.
+  az_span last_modified;
+
+  /// The type of the blob: `BlockBlob`, `AppendBlob` or `PageBlob`.
+  az_span blob_type;
+
+  /// The access tier of the blob, such as `Hot`, or empty if the listing doesn't have it.
+  az_span access_tier;
+
+  /// The size of the blob, in bytes, or -1 if the listing doesn't have it.
+  int64_t content_length;
+} az_storage_blobs_blob_item;
+
+/**
+ * @brief Defines the callback signature which receives the blobs of a listing, one at a time, as
+ * the pages of the listing are received.
+ *
+ * @param[in] user_context The user context given to #az_storage_blobs_blob_enumerator_next_page().
+ * @param[in] item The #az_storage_blobs_blob_item of the next blob.
+ *
+ * @return An #az_result value indicating the result of the operation. Any failure aborts receiving
+ * the page, and is returned by #az_storage_blobs_blob_enumerator_next_page().
+ */
+typedef AZ_NODISCARD az_result (
+    *az_storage_blobs_blob_item_fn)(void* user_context, az_storage_blobs_blob_item const* item);
+
+/**
+ * @brief Allows customization of a blob listing.
+ */
+typedef struct
+{
+  /// The #az_context each page is requested with.
+  az_context* context;
+
+  /// Only list the blobs whose name starts with this prefix, unless it is empty.
+  az_span prefix;
+
+  /// The largest number of blobs in each page, or 0 for the service default of 5000.
+  int32_t max_results;
+
+  struct
+  {
+    /// Currently, this is unused, but needed as a placeholder since we can't have an empty struct.
+    bool unused;
+  } _internal;
+} az_storage_blobs_list_blobs_options;
+
+/**
+ * @brief Gets the default blob listing options.
+ *
+ * @details Call this to obtain an initialized #az_storage_blobs_list_blobs_options structure.
+ *
+ * @remark Use this, for instance, when only caring about setting one option by calling this
+ * function and then overriding that specific option.
+ */
+AZ_NODISCARD AZ_INLINE az_storage_blobs_list_blobs_options
+az_storage_blobs_list_blobs_options_default()
+{
+  return (az_storage_blobs_list_blobs_options){ .context = &az_context_application,
+                                                .prefix = AZ_SPAN_EMPTY,
+                                                .max_results = 0,
+                                                ._internal = { .unused = false } };
+}
+
+/**
+ * @brief Lists the blobs of a container, page by page, following the continuation marker of each
+ * page to the next one.
+ *
+ * @details The body of each page is streamed with #az_http_response_set_body_sink() and parsed as
+ * it arrives: once the receive buffer has a whole `<Blob>` element, the blob is given to the
+ * #az_storage_blobs_blob_item_fn and its bytes are discarded. Only the element being received is
+ * kept, so the receive buffer doesn't depend on the size of the pages or of the container.
+ */
+typedef struct
+{
+  struct
+  {
+    az_storage_blobs_blob_client* client;
+    az_span buffer;
+    int32_t buffered_size;
+    uint8_t marker[AZ_STORAGE_BLOBS_LIST_MARKER_MAX_SIZE];
+    int32_t marker_size;
+    bool page_complete;
+    bool done;
+    az_storage_blobs_blob_item_fn callback;
+    void* user_context;
+    az_storage_blobs_list_blobs_options options;
+  } _internal;
+} az_storage_blobs_blob_enumerator;
+
+/**
+ * @brief Initializes an enumerator of the blobs of a container, starting at the first page.
+ *
+ * @param[out] out_enumerator The #az_storage_blobs_blob_enumerator to initialize.
+ * @param[in] client The #az_storage_blobs_blob_client whose endpoint is the URL of the container.
+ * It must stay alive while the enumerator is used.
+ * @param[in] buffer The #az_span the body of each page is received into. It must be large enough
+ * for the largest `<Blob>` element, which is about 1 KiB without metadata, and stay alive while the
+ * enumerator is used.
+ * @param[in] options __[nullable]__ A reference to an #az_storage_blobs_list_blobs_options
+ * structure. If `NULL` is passed, the default options are used.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK Success.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_enumerator_init(
+    az_storage_blobs_blob_enumerator* out_enumerator,
+    az_storage_blobs_blob_client* client,
+    az_span buffer,
+    az_storage_blobs_list_blobs_options const* options);
+
+/**
+ * @brief Requests the next page of the listing, and gives each of its blobs to \p callback as it
+ * is received.
+ *
+ * @param[in,out] ref_enumerator The #az_storage_blobs_blob_enumerator.
+ * @param[in] callback The #az_storage_blobs_blob_item_fn which receives the blobs.
+ * @param[in] user_context A context passed to \p callback.
+ * @param[in,out] ref_response An initialized #az_http_response where to write the HTTP response.
+ * It only holds the status line and headers of a successful page, and the error of a failed one.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The page was requested. Unless the response status is `200 OK`, the service
+ * returned an error and the page can be requested again. Otherwise, the listing is complete once
+ * #az_storage_blobs_blob_enumerator_is_done() is true.
+ * @retval #AZ_ERROR_NOT_ENOUGH_SPACE An element of the page doesn't fit in the receive buffer, or
+ * the continuation marker is longer than #AZ_STORAGE_BLOBS_LIST_MARKER_MAX_SIZE.
+ * @retval #AZ_ERROR_UNEXPECTED_END The page ended without a continuation marker.
+ * @retval other The failure returned by \p callback, or by the transport.
+ */
+AZ_NODISCARD az_result az_storage_blobs_blob_enumerator_next_page(
+    az_storage_blobs_blob_enumerator* ref_enumerator,
+    az_storage_blobs_blob_item_fn callback,
+    void* user_context,
+    az_http_response* ref_response);
+
+/**
+ * @brief Checks whether all of the pages of a listing were received.
+ *
+ * @param[in] enumerator The #az_storage_blobs_blob_enumerator.
+ *
+ * @return `true` once the last page was received.
+ */
+AZ_NODISCARD AZ_INLINE bool
+az_storage_blobs_blob_enumerator_is_done(az_storage_blobs_blob_enumerator const* enumerator)
+{
+  return enumerator->_internal.done;
+}
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_STORAGE_BLOBS_H
@@ -25,11 +25,10 @@
 #include <string.h>
 #include <time.h>
 
+#include <azure/core/az_crypto.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
 
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
 
@@ -114,6 +113,7 @@ az_result iot_sample_read_environment_variables(
 
     switch (name)
     {
+      case PAHO_IOT_HUB_ASYNC_TELEMETRY_SAMPLE:
       case PAHO_IOT_HUB_C2D_SAMPLE:
       case PAHO_IOT_HUB_METHODS_SAMPLE:
       case PAHO_IOT_HUB_PNP_COMPONENT_SAMPLE:
@@ -323,57 +323,12 @@ static az_result decode_base64_bytes(
     az_span decoded_bytes,
     az_span* out_decoded_bytes)
 {
-  BIO* base64_decoder;
-  BIO* source_mem_bio;
-
-  memset(az_span_ptr(decoded_bytes), 0, (size_t)az_span_size(decoded_bytes));
-
-  // Create a BIO filter to process the bytes.
-  base64_decoder = BIO_new(BIO_f_base64());
-  if (base64_decoder == NULL)
-  {
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Get the source BIO to push through the filter.
-  source_mem_bio
-      = BIO_new_mem_buf(az_span_ptr(base64_encoded_bytes), (int)az_span_size(base64_encoded_bytes));
-  if (source_mem_bio == NULL)
-  {
-    BIO_free(base64_decoder);
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Push the memory through the filter.
-  source_mem_bio = BIO_push(base64_decoder, source_mem_bio);
-  if (source_mem_bio == NULL)
-  {
-    BIO_free(base64_decoder);
-    BIO_free(source_mem_bio);
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Set flags to not have a newline and close the BIO.
-  BIO_set_flags(source_mem_bio, BIO_FLAGS_BASE64_NO_NL);
-  BIO_set_close(source_mem_bio, BIO_CLOSE);
-
-  // Read the memory which was pushed through the filter.
-  int read_data = BIO_read(source_mem_bio, az_span_ptr(decoded_bytes), az_span_size(decoded_bytes));
-
-  // Set the output span.
-  az_result rc;
-  if (read_data > 0)
+  int32_t decoded_size = 0;
+  az_result const rc = az_base64_decode(decoded_bytes, base64_encoded_bytes, &decoded_size);
+  if (az_result_succeeded(rc))
   {
-    *out_decoded_bytes = az_span_create(az_span_ptr(decoded_bytes), (int32_t)read_data);
-    rc = AZ_OK;
+    *out_decoded_bytes = az_span_slice(decoded_bytes, 0, decoded_size);
   }
-  else
-  {
-    rc = AZ_ERROR_NOT_ENOUGH_SPACE;
-  }
-
-  // Free the BIO chain.
-  BIO_free_all(source_mem_bio);
 
   return rc;
 }
@@ -413,70 +368,12 @@ static az_result base64_encode_bytes(
     az_span base64_encoded_bytes,
     az_span* out_base64_encoded_bytes)
 {
-  BIO* base64_encoder;
-  BIO* sink_mem_bio;
-  BUF_MEM* encoded_mem_ptr;
-
-  // Create a BIO filter to process the bytes.
-  base64_encoder = BIO_new(BIO_f_base64());
-  if (base64_encoder == NULL)
-  {
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Create a memory sink BIO to process bytes to.
-  sink_mem_bio = BIO_new(BIO_s_mem());
-  if (sink_mem_bio == NULL)
-  {
-    BIO_free(base64_encoder);
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Push the sink to the encoder.
-  base64_encoder = BIO_push(base64_encoder, sink_mem_bio);
-  if (base64_encoder == NULL)
-  {
-    BIO_free(sink_mem_bio);
-    BIO_free(base64_encoder);
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Set no newline flag for the encoder.
-  BIO_set_flags(base64_encoder, BIO_FLAGS_BASE64_NO_NL);
-
-  // Write the bytes to be encoded.
-  int const bytes_written
-      = BIO_write(base64_encoder, az_span_ptr(decoded_bytes), (int)az_span_size(decoded_bytes));
-  if (bytes_written < 1)
-  {
-    BIO_free(sink_mem_bio);
-    BIO_free(base64_encoder);
-    return AZ_ERROR_OUT_OF_MEMORY;
-  }
-
-  // Flush the BIO
-  BIO_flush(base64_encoder);
-
-  // Get the pointer to the encoded bytes.
-  BIO_get_mem_ptr(base64_encoder, &encoded_mem_ptr);
-
-  az_result rc;
-  if ((size_t)az_span_size(base64_encoded_bytes) >= encoded_mem_ptr->length)
+  int32_t encoded_size = 0;
+  az_result const rc = az_base64_encode(base64_encoded_bytes, decoded_bytes, &encoded_size);
+  if (az_result_succeeded(rc))
   {
-    // Copy the bytes to the output and initialize output span.
-    memcpy(az_span_ptr(base64_encoded_bytes), encoded_mem_ptr->data, encoded_mem_ptr->length);
-    *out_base64_encoded_bytes
-        = az_span_create(az_span_ptr(base64_encoded_bytes), (int32_t)encoded_mem_ptr->length);
-
-    rc = AZ_OK;
+    *out_base64_encoded_bytes = az_span_slice(base64_encoded_bytes, 0, encoded_size);
   }
-  else
-  {
-    rc = AZ_ERROR_NOT_ENOUGH_SPACE;
-  }
-
-  // Free the BIO chain.
-  BIO_free_all(base64_encoder);
 
   return rc;
 }
@@ -144,7 +144,8 @@ typedef enum
   PAHO_IOT_HUB_TELEMETRY_SAMPLE,
   PAHO_IOT_HUB_TWIN_SAMPLE,
   PAHO_IOT_PROVISIONING_SAMPLE,
-  PAHO_IOT_PROVISIONING_SAS_SAMPLE
+  PAHO_IOT_PROVISIONING_SAS_SAMPLE,
+  PAHO_IOT_HUB_ASYNC_TELEMETRY_SAMPLE
 } iot_sample_name;
 
 extern bool is_device_operational;
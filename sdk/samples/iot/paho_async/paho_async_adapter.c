@@ -0,0 +1,319 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "paho_async_adapter.h"
+
+#include <iot_sample_common.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+static void* encode_thread_main(void* context);
+static void publish_next_message(paho_async_adapter* adapter);
+static void complete_publish(paho_async_adapter_in_flight_publish* publish, int mqtt_return_code);
+static void on_publish_success(void* context, MQTTAsync_successData* response);
+static void on_publish_failure(void* context, MQTTAsync_failureData* response);
+static int on_message_arrived(
+    void* context,
+    char* topic_name,
+    int topic_length,
+    MQTTAsync_message* message);
+static void on_connection_lost(void* context, char* cause);
+static void release_mqtt_message(az_span topic, az_span payload, void* user_context);
+
+az_result paho_async_adapter_init(
+    paho_async_adapter* out_adapter,
+    az_iot_hub_client const* hub_client,
+    MQTTAsync mqtt_client,
+    paho_async_adapter_message_received_fn message_received_callback,
+    void* message_received_user_context)
+{
+  if (out_adapter == NULL || hub_client == NULL || mqtt_client == NULL
+      || message_received_callback == NULL)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  memset(out_adapter, 0, sizeof(*out_adapter));
+  out_adapter->hub_client = hub_client;
+  out_adapter->mqtt_client = mqtt_client;
+  out_adapter->message_received_callback = message_received_callback;
+  out_adapter->message_received_user_context = message_received_user_context;
+
+  for (int32_t i = 0; i < PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT; i++)
+  {
+    out_adapter->in_flight[i].adapter = out_adapter;
+  }
+
+  int rc = MQTTAsync_setCallbacks(
+      mqtt_client, out_adapter, on_connection_lost, on_message_arrived, NULL);
+  if (rc != MQTTASYNC_SUCCESS)
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to set MQTT callbacks: MQTTAsync return code %d.", rc);
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  if (pthread_mutex_init(&out_adapter->mutex, NULL) != 0)
+  {
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  if (pthread_cond_init(&out_adapter->state_changed, NULL) != 0)
+  {
+    pthread_mutex_destroy(&out_adapter->mutex);
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  if (pthread_create(&out_adapter->encode_thread, NULL, encode_thread_main, out_adapter) != 0)
+  {
+    pthread_cond_destroy(&out_adapter->state_changed);
+    pthread_mutex_destroy(&out_adapter->mutex);
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  return AZ_OK;
+}
+
+az_result paho_async_adapter_publish_telemetry(
+    paho_async_adapter* adapter,
+    az_span payload,
+    az_iot_message_properties const* properties,
+    paho_async_adapter_publish_completed_fn completed_callback,
+    void* completed_user_context)
+{
+  if (adapter == NULL)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  pthread_mutex_lock(&adapter->mutex);
+
+  // A full queue slows the application down to the rate at which IoT Hub acknowledges messages.
+  while (adapter->queue_count == PAHO_ASYNC_ADAPTER_QUEUE_SIZE && !adapter->is_stopping)
+  {
+    pthread_cond_wait(&adapter->state_changed, &adapter->mutex);
+  }
+
+  if (adapter->is_stopping)
+  {
+    pthread_mutex_unlock(&adapter->mutex);
+    return AZ_ERROR_ARG;
+  }
+
+  int32_t const tail
+      = (adapter->queue_head + adapter->queue_count) % PAHO_ASYNC_ADAPTER_QUEUE_SIZE;
+  adapter->queue[tail] = (paho_async_adapter_publish_request){
+    .payload = payload,
+    .properties = properties,
+    .completed_callback = completed_callback,
+    .completed_user_context = completed_user_context,
+  };
+  adapter->queue_count++;
+
+  pthread_cond_broadcast(&adapter->state_changed);
+  pthread_mutex_unlock(&adapter->mutex);
+
+  return AZ_OK;
+}
+
+void paho_async_adapter_stop(paho_async_adapter* adapter)
+{
+  if (adapter == NULL)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&adapter->mutex);
+  adapter->is_stopping = true;
+  pthread_cond_broadcast(&adapter->state_changed);
+  pthread_mutex_unlock(&adapter->mutex);
+
+  // The encode thread returns once it sent every queued message.
+  pthread_join(adapter->encode_thread, NULL);
+
+  // Paho completes every publish, with a failure if the connection is lost.
+  pthread_mutex_lock(&adapter->mutex);
+  while (adapter->in_flight_count > 0)
+  {
+    pthread_cond_wait(&adapter->state_changed, &adapter->mutex);
+  }
+  pthread_mutex_unlock(&adapter->mutex);
+
+  pthread_cond_destroy(&adapter->state_changed);
+  pthread_mutex_destroy(&adapter->mutex);
+}
+
+static void* encode_thread_main(void* context)
+{
+  paho_async_adapter* adapter = (paho_async_adapter*)context;
+
+  pthread_mutex_lock(&adapter->mutex);
+
+  while (true)
+  {
+    // Wait for a message, and for the window of in-flight publishes to have room for it.
+    while (!(adapter->queue_count > 0
+             && adapter->in_flight_count < PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT)
+           && !(adapter->is_stopping && adapter->queue_count == 0))
+    {
+      pthread_cond_wait(&adapter->state_changed, &adapter->mutex);
+    }
+
+    if (adapter->queue_count == 0)
+    {
+      break; // Stopping, and every message was sent.
+    }
+
+    publish_next_message(adapter);
+  }
+
+  pthread_mutex_unlock(&adapter->mutex);
+
+  return NULL;
+}
+
+// Called with the mutex locked, which is released while the message is encoded and sent.
+static void publish_next_message(paho_async_adapter* adapter)
+{
+  paho_async_adapter_in_flight_publish* publish = NULL;
+  for (int32_t i = 0; i < PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT; i++)
+  {
+    if (!adapter->in_flight[i].is_in_use)
+    {
+      publish = &adapter->in_flight[i];
+      break;
+    }
+  }
+
+  publish->request = adapter->queue[adapter->queue_head];
+  publish->is_in_use = true;
+  adapter->in_flight_count++;
+  adapter->queue_head = (adapter->queue_head + 1) % PAHO_ASYNC_ADAPTER_QUEUE_SIZE;
+  adapter->queue_count--;
+
+  // Wake the application if it waits for room in the queue.
+  pthread_cond_broadcast(&adapter->state_changed);
+  pthread_mutex_unlock(&adapter->mutex);
+
+  int rc = az_iot_hub_client_telemetry_get_publish_topic(
+      adapter->hub_client,
+      publish->request.properties,
+      publish->topic,
+      sizeof(publish->topic),
+      NULL);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to get the Telemetry topic: az_result return code 0x%08x.", rc);
+    complete_publish(publish, MQTTASYNC_FAILURE);
+  }
+  else
+  {
+    MQTTAsync_message message = MQTTAsync_message_initializer;
+    message.payload = az_span_ptr(publish->request.payload);
+    message.payloadlen = az_span_size(publish->request.payload);
+    message.qos = 1; // The PUBACK completes the message, and frees its slot in the window.
+
+    MQTTAsync_responseOptions response_options = MQTTAsync_responseOptions_initializer;
+    response_options.onSuccess = on_publish_success;
+    response_options.onFailure = on_publish_failure;
+    response_options.context = publish;
+
+    rc = MQTTAsync_sendMessage(adapter->mqtt_client, publish->topic, &message, &response_options);
+    if (rc != MQTTASYNC_SUCCESS)
+    {
+      IOT_SAMPLE_LOG_ERROR("Failed to publish Telemetry message: MQTTAsync return code %d.", rc);
+      complete_publish(publish, rc);
+    }
+  }
+
+  pthread_mutex_lock(&adapter->mutex);
+}
+
+static void complete_publish(paho_async_adapter_in_flight_publish* publish, int mqtt_return_code)
+{
+  paho_async_adapter* adapter = publish->adapter;
+
+  // The slot is freed once the callback returns, so that paho_async_adapter_stop() doesn't return
+  // while a callback runs.
+  if (publish->request.completed_callback != NULL)
+  {
+    publish->request.completed_callback(
+        mqtt_return_code, publish->request.completed_user_context);
+  }
+
+  pthread_mutex_lock(&adapter->mutex);
+  publish->is_in_use = false;
+  adapter->in_flight_count--;
+  pthread_cond_broadcast(&adapter->state_changed);
+  pthread_mutex_unlock(&adapter->mutex);
+}
+
+static void on_publish_success(void* context, MQTTAsync_successData* response)
+{
+  (void)response;
+
+  complete_publish((paho_async_adapter_in_flight_publish*)context, MQTTASYNC_SUCCESS);
+}
+
+static void on_publish_failure(void* context, MQTTAsync_failureData* response)
+{
+  int const rc = (response != NULL && response->code != MQTTASYNC_SUCCESS) ? response->code
+                                                                           : MQTTASYNC_FAILURE;
+  complete_publish((paho_async_adapter_in_flight_publish*)context, rc);
+}
+
+static int on_message_arrived(
+    void* context,
+    char* topic_name,
+    int topic_length,
+    MQTTAsync_message* message)
+{
+  paho_async_adapter* adapter = (paho_async_adapter*)context;
+
+  // Paho passes a topic length of 0 for a null-terminated topic.
+  az_span const topic = az_span_create(
+      (uint8_t*)topic_name, topic_length > 0 ? topic_length : (int32_t)strlen(topic_name));
+  az_span const payload = az_span_create((uint8_t*)message->payload, message->payloadlen);
+
+  // The message refers to Paho's buffers, which release_mqtt_message() frees once the application
+  // releases it.
+  az_iot_hub_client_received_message received_message;
+  az_result rc = az_iot_hub_client_parse_received_message(
+      adapter->hub_client, topic, payload, release_mqtt_message, message, &received_message);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Message from unknown topic: az_result return code 0x%08x.", rc);
+    IOT_SAMPLE_LOG_AZ_SPAN("Topic:", topic);
+    release_mqtt_message(topic, payload, message);
+  }
+  else
+  {
+    adapter->message_received_callback(
+        &received_message, adapter->message_received_user_context);
+  }
+
+  return 1; // The message is taken, and freed by release_mqtt_message().
+}
+
+static void on_connection_lost(void* context, char* cause)
+{
+  (void)context;
+
+  IOT_SAMPLE_LOG_ERROR("MQTT connection lost: %s", cause != NULL ? cause : "unknown cause");
+}
+
+static void release_mqtt_message(az_span topic, az_span payload, void* user_context)
+{
+  (void)payload;
+
+  MQTTAsync_message* message = (MQTTAsync_message*)user_context;
+  MQTTAsync_freeMessage(&message);
+  MQTTAsync_free((char*)az_span_ptr(topic));
+}
@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#ifndef PAHO_ASYNC_ADAPTER_H
+#define PAHO_ASYNC_ADAPTER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+// warning C4201: nonstandard extension used: nameless struct/union
+#pragma warning(disable : 4201)
+#endif
+#include <paho-mqtt/MQTTAsync.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+// The number of telemetry messages which can wait for the encode thread.
+#ifndef PAHO_ASYNC_ADAPTER_QUEUE_SIZE
+#define PAHO_ASYNC_ADAPTER_QUEUE_SIZE 64
+#endif
+
+// The number of QoS 1 publishes which can wait for their PUBACK at once.
+#ifndef PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT
+#define PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT 16
+#endif
+
+#define PAHO_ASYNC_ADAPTER_TOPIC_BUFFER_SIZE 256
+
+/**
+ * @brief Called once a telemetry message was acknowledged by IoT Hub, or failed to be published.
+ *
+ * @param[in] mqtt_return_code #MQTTASYNC_SUCCESS once IoT Hub acknowledged the message, the Paho
+ * return code of the failure otherwise.
+ * @param[in] user_context The user context passed to paho_async_adapter_publish_telemetry().
+ */
+typedef void (*paho_async_adapter_publish_completed_fn)(int mqtt_return_code, void* user_context);
+
+/**
+ * @brief Called on a Paho thread for each message received from IoT Hub. The message refers to
+ * Paho's receive buffers, which are freed once the application calls
+ * az_iot_hub_client_received_message_release(). To release it after the callback returns, copy
+ * the #az_iot_hub_client_received_message.
+ *
+ * @param[in] message The classified #az_iot_hub_client_received_message.
+ * @param[in] user_context The user context passed to paho_async_adapter_init().
+ */
+typedef void (*paho_async_adapter_message_received_fn)(
+    az_iot_hub_client_received_message* message,
+    void* user_context);
+
+typedef struct
+{
+  az_span payload;
+  az_iot_message_properties const* properties;
+  paho_async_adapter_publish_completed_fn completed_callback;
+  void* completed_user_context;
+} paho_async_adapter_publish_request;
+
+typedef struct paho_async_adapter paho_async_adapter;
+
+typedef struct
+{
+  paho_async_adapter* adapter;
+  paho_async_adapter_publish_request request;
+  char topic[PAHO_ASYNC_ADAPTER_TOPIC_BUFFER_SIZE];
+  bool is_in_use;
+} paho_async_adapter_in_flight_publish;
+
+/*
+ * Pairs an #az_iot_hub_client with a Paho MQTTAsync client. Telemetry goes through a queue to an
+ * encode thread, which builds each topic and sends it as soon as fewer than
+ * PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT publishes wait for their PUBACK. Received messages are
+ * classified with az_iot_hub_client_parse_received_message() and handed to the application without
+ * copying them.
+ */
+struct paho_async_adapter
+{
+  az_iot_hub_client const* hub_client;
+  MQTTAsync mqtt_client;
+  paho_async_adapter_message_received_fn message_received_callback;
+  void* message_received_user_context;
+
+  pthread_t encode_thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t state_changed; // Broadcast whenever the queue, the window or is_stopping change.
+
+  paho_async_adapter_publish_request queue[PAHO_ASYNC_ADAPTER_QUEUE_SIZE];
+  int32_t queue_head;
+  int32_t queue_count;
+
+  paho_async_adapter_in_flight_publish in_flight[PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT];
+  int32_t in_flight_count;
+
+  bool is_stopping;
+};
+
+/**
+ * @brief Initializes a #paho_async_adapter, sets the Paho callbacks of \p mqtt_client and starts
+ * the encode thread. Call before connecting \p mqtt_client.
+ *
+ * @param[out] out_adapter The #paho_async_adapter to initialize.
+ * @param[in] hub_client The #az_iot_hub_client building the topics, which must outlive the adapter.
+ * @param[in] mqtt_client The created, not yet connected, Paho MQTTAsync client.
+ * @param[in] message_received_callback Called for each message received from IoT Hub.
+ * @param[in] message_received_user_context Passed to \p message_received_callback.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The adapter is started.
+ * @retval #AZ_ERROR_ARG A parameter is NULL.
+ * @retval #AZ_ERROR_NOT_SUPPORTED Paho's callbacks couldn't be set or the thread couldn't start.
+ */
+az_result paho_async_adapter_init(
+    paho_async_adapter* out_adapter,
+    az_iot_hub_client const* hub_client,
+    MQTTAsync mqtt_client,
+    paho_async_adapter_message_received_fn message_received_callback,
+    void* message_received_user_context);
+
+/**
+ * @brief Queues a telemetry message for the encode thread, waiting while the queue is full.
+ *
+ * @param[in] adapter The started #paho_async_adapter.
+ * @param[in] payload The telemetry payload, which must stay valid until \p completed_callback.
+ * @param[in] properties __[nullable]__ The message properties, which must stay valid until
+ * \p completed_callback.
+ * @param[in] completed_callback __[nullable]__ Called on a Paho or the encode thread once the
+ * message was acknowledged or failed. It must not wait, so it must not queue messages either.
+ * @param[in] completed_user_context Passed to \p completed_callback.
+ *
+ * @return An #az_result value indicating the result of the operation.
+ * @retval #AZ_OK The message is queued.
+ * @retval #AZ_ERROR_ARG The adapter is NULL, or is stopping.
+ */
+az_result paho_async_adapter_publish_telemetry(
+    paho_async_adapter* adapter,
+    az_span payload,
+    az_iot_message_properties const* properties,
+    paho_async_adapter_publish_completed_fn completed_callback,
+    void* completed_user_context);
+
+/**
+ * @brief Publishes the queued telemetry messages, waits for all of them to complete and stops the
+ * encode thread. Call before disconnecting the MQTTAsync client.
+ *
+ * @param[in] adapter The started #paho_async_adapter.
+ */
+void paho_async_adapter_stop(paho_async_adapter* adapter);
+
+#endif // PAHO_ASYNC_ADAPTER_H
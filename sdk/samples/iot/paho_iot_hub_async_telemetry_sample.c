@@ -0,0 +1,351 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "paho_async/paho_async_adapter.h"
+
+#include "iot_sample_common.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+#define SAMPLE_TYPE PAHO_IOT_HUB
+#define SAMPLE_NAME PAHO_IOT_HUB_ASYNC_TELEMETRY_SAMPLE
+
+#define MAX_TELEMETRY_MESSAGE_COUNT 1000
+#define TELEMETRY_PAYLOAD_BUFFER_SIZE 32
+#define MQTT_TIMEOUT_DISCONNECT_MS (10 * 1000)
+#define MQTT_OPERATION_PENDING 1
+
+static iot_sample_environment_variables env_vars;
+static az_iot_hub_client hub_client;
+static MQTTAsync mqtt_client;
+static paho_async_adapter adapter;
+static char mqtt_client_username_buffer[128];
+static char telemetry_payload_buffers[MAX_TELEMETRY_MESSAGE_COUNT][TELEMETRY_PAYLOAD_BUFFER_SIZE];
+
+// The Paho callbacks of the connect, subscribe and disconnect operations signal the main thread.
+static pthread_mutex_t operation_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t operation_completed = PTHREAD_COND_INITIALIZER;
+static int operation_result = MQTT_OPERATION_PENDING;
+
+static pthread_mutex_t telemetry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int32_t telemetry_acknowledged_count;
+static int32_t telemetry_failed_count;
+
+// Functions
+static void create_and_configure_mqtt_client(void);
+static void connect_mqtt_client_to_iot_hub(void);
+static void subscribe_mqtt_client_to_iot_hub_topics(void);
+static void send_telemetry_messages_to_iot_hub(void);
+static void disconnect_mqtt_client_from_iot_hub(void);
+
+static int wait_for_operation(void);
+static void on_operation_success(void* context, MQTTAsync_successData* response);
+static void on_operation_failure(void* context, MQTTAsync_failureData* response);
+static void on_telemetry_completed(int mqtt_return_code, void* user_context);
+static void on_message_received(az_iot_hub_client_received_message* message, void* user_context);
+
+/*
+ * This sample sends MAX_TELEMETRY_MESSAGE_COUNT telemetry messages to the Azure IoT Hub through
+ * the Paho MQTTAsync client, keeping up to PAHO_ASYNC_ADAPTER_MAX_IN_FLIGHT QoS 1 publishes in
+ * flight at once, and logs the C2D messages received meanwhile. X509 self-certification is used.
+ */
+int main(void)
+{
+  create_and_configure_mqtt_client();
+  IOT_SAMPLE_LOG_SUCCESS("Client created and configured.");
+
+  connect_mqtt_client_to_iot_hub();
+  IOT_SAMPLE_LOG_SUCCESS("Client connected to IoT Hub.");
+
+  subscribe_mqtt_client_to_iot_hub_topics();
+  IOT_SAMPLE_LOG_SUCCESS("Client subscribed to IoT Hub topics.\n");
+
+  send_telemetry_messages_to_iot_hub();
+  IOT_SAMPLE_LOG_SUCCESS("Client sent telemetry messages to IoT Hub.");
+
+  disconnect_mqtt_client_from_iot_hub();
+  IOT_SAMPLE_LOG_SUCCESS("Client disconnected from IoT Hub.");
+
+  return 0;
+}
+
+static void create_and_configure_mqtt_client(void)
+{
+  int rc;
+
+  // Reads in environment variables set by user for purposes of running sample.
+  rc = iot_sample_read_environment_variables(SAMPLE_TYPE, SAMPLE_NAME, &env_vars);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR(
+        "Failed to read configuration from environment variables: az_result return code 0x%08x.",
+        rc);
+    exit(rc);
+  }
+
+  // Build an MQTT endpoint c-string.
+  char mqtt_endpoint_buffer[128];
+  rc = iot_sample_create_mqtt_endpoint(
+      SAMPLE_TYPE, &env_vars, mqtt_endpoint_buffer, sizeof(mqtt_endpoint_buffer));
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to create MQTT endpoint: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+
+  // Initialize the hub client with the default connection options.
+  rc = az_iot_hub_client_init(&hub_client, env_vars.hub_hostname, env_vars.hub_device_id, NULL);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to initialize hub client: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+
+  // Get the MQTT client id used for the MQTT connection.
+  char mqtt_client_id_buffer[128];
+  rc = az_iot_hub_client_get_client_id(
+      &hub_client, mqtt_client_id_buffer, sizeof(mqtt_client_id_buffer), NULL);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to get MQTT client id: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+
+  // Create the Paho MQTTAsync client.
+  rc = MQTTAsync_create(
+      &mqtt_client, mqtt_endpoint_buffer, mqtt_client_id_buffer, MQTTCLIENT_PERSISTENCE_NONE, NULL);
+  if (rc != MQTTASYNC_SUCCESS)
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to create MQTT client: MQTTAsync return code %d.", rc);
+    exit(rc);
+  }
+
+  // Start the encode thread and dispatch the received messages, before any can arrive.
+  rc = paho_async_adapter_init(&adapter, &hub_client, mqtt_client, on_message_received, NULL);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to initialize async adapter: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+}
+
+static void connect_mqtt_client_to_iot_hub(void)
+{
+  int rc;
+
+  // Get the MQTT client username.
+  rc = az_iot_hub_client_get_user_name(
+      &hub_client, mqtt_client_username_buffer, sizeof(mqtt_client_username_buffer), NULL);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to get MQTT client username: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+
+  // Set MQTT connection options.
+  MQTTAsync_connectOptions mqtt_connect_options = MQTTAsync_connectOptions_initializer;
+  mqtt_connect_options.username = mqtt_client_username_buffer;
+  mqtt_connect_options.password = NULL; // This sample uses x509 authentication.
+  mqtt_connect_options.cleansession = false; // Set to false so can receive any pending messages.
+  mqtt_connect_options.keepAliveInterval = AZ_IOT_DEFAULT_MQTT_CONNECT_KEEPALIVE_SECONDS;
+  mqtt_connect_options.onSuccess = on_operation_success;
+  mqtt_connect_options.onFailure = on_operation_failure;
+
+  MQTTAsync_SSLOptions mqtt_ssl_options = MQTTAsync_SSLOptions_initializer;
+  mqtt_ssl_options.keyStore = (char*)az_span_ptr(env_vars.x509_cert_pem_file_path);
+  if (az_span_size(env_vars.x509_trust_pem_file_path) != 0) // Is only set if required by OS.
+  {
+    mqtt_ssl_options.trustStore = (char*)az_span_ptr(env_vars.x509_trust_pem_file_path);
+  }
+  mqtt_connect_options.ssl = &mqtt_ssl_options;
+
+  // Connect MQTT client to the Azure IoT Hub.
+  rc = MQTTAsync_connect(mqtt_client, &mqtt_connect_options);
+  if (rc == MQTTASYNC_SUCCESS)
+  {
+    rc = wait_for_operation();
+  }
+
+  if (rc != MQTTASYNC_SUCCESS)
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to connect: MQTTAsync return code %d.", rc);
+    exit(rc);
+  }
+}
+
+static void subscribe_mqtt_client_to_iot_hub_topics(void)
+{
+  MQTTAsync_responseOptions response_options = MQTTAsync_responseOptions_initializer;
+  response_options.onSuccess = on_operation_success;
+  response_options.onFailure = on_operation_failure;
+
+  // Messages received on the C2D topic are dispatched by the adapter to on_message_received().
+  int rc = MQTTAsync_subscribe(
+      mqtt_client, AZ_IOT_HUB_CLIENT_C2D_SUBSCRIBE_TOPIC, 1, &response_options);
+  if (rc == MQTTASYNC_SUCCESS)
+  {
+    rc = wait_for_operation();
+  }
+
+  if (rc != MQTTASYNC_SUCCESS)
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to subscribe to the C2D topic: MQTTAsync return code %d.", rc);
+    exit(rc);
+  }
+}
+
+static void send_telemetry_messages_to_iot_hub(void)
+{
+  struct timespec start_time;
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  // The adapter builds the topics and publishes on its encode thread, so the loop only queues the
+  // payloads, waiting whenever the queue is full.
+  for (int32_t message_count = 0; message_count < MAX_TELEMETRY_MESSAGE_COUNT; message_count++)
+  {
+    char* payload_buffer = telemetry_payload_buffers[message_count];
+    int const payload_length = snprintf(
+        payload_buffer,
+        TELEMETRY_PAYLOAD_BUFFER_SIZE,
+        "{\"message_number\":%d}",
+        message_count + 1);
+
+    az_result rc = paho_async_adapter_publish_telemetry(
+        &adapter,
+        az_span_create((uint8_t*)payload_buffer, payload_length),
+        NULL,
+        on_telemetry_completed,
+        NULL);
+    if (az_result_failed(rc))
+    {
+      IOT_SAMPLE_LOG_ERROR(
+          "Failed to queue Telemetry message #%d: az_result return code 0x%08x.",
+          message_count + 1,
+          rc);
+      exit(rc);
+    }
+  }
+
+  // Waits for IoT Hub to acknowledge every message.
+  paho_async_adapter_stop(&adapter);
+
+  struct timespec end_time;
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  double const elapsed_seconds = (double)(end_time.tv_sec - start_time.tv_sec)
+      + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+  IOT_SAMPLE_LOG(
+      "Acknowledged: %d, failed: %d, in %.3f seconds.",
+      telemetry_acknowledged_count,
+      telemetry_failed_count,
+      elapsed_seconds);
+  if (elapsed_seconds > 0)
+  {
+    IOT_SAMPLE_LOG(
+        "Throughput: %.1f messages per second.", MAX_TELEMETRY_MESSAGE_COUNT / elapsed_seconds);
+  }
+}
+
+static void disconnect_mqtt_client_from_iot_hub(void)
+{
+  MQTTAsync_disconnectOptions mqtt_disconnect_options = MQTTAsync_disconnectOptions_initializer;
+  mqtt_disconnect_options.timeout = MQTT_TIMEOUT_DISCONNECT_MS;
+  mqtt_disconnect_options.onSuccess = on_operation_success;
+  mqtt_disconnect_options.onFailure = on_operation_failure;
+
+  int rc = MQTTAsync_disconnect(mqtt_client, &mqtt_disconnect_options);
+  if (rc == MQTTASYNC_SUCCESS)
+  {
+    rc = wait_for_operation();
+  }
+
+  if (rc != MQTTASYNC_SUCCESS)
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to disconnect MQTT client: MQTTAsync return code %d.", rc);
+    exit(rc);
+  }
+
+  MQTTAsync_destroy(&mqtt_client);
+}
+
+static int wait_for_operation(void)
+{
+  pthread_mutex_lock(&operation_mutex);
+  while (operation_result == MQTT_OPERATION_PENDING)
+  {
+    pthread_cond_wait(&operation_completed, &operation_mutex);
+  }
+
+  int const rc = operation_result;
+  operation_result = MQTT_OPERATION_PENDING;
+  pthread_mutex_unlock(&operation_mutex);
+
+  return rc;
+}
+
+static void on_operation_success(void* context, MQTTAsync_successData* response)
+{
+  (void)context;
+  (void)response;
+
+  pthread_mutex_lock(&operation_mutex);
+  operation_result = MQTTASYNC_SUCCESS;
+  pthread_cond_signal(&operation_completed);
+  pthread_mutex_unlock(&operation_mutex);
+}
+
+static void on_operation_failure(void* context, MQTTAsync_failureData* response)
+{
+  (void)context;
+
+  pthread_mutex_lock(&operation_mutex);
+  operation_result = (response != NULL && response->code != MQTTASYNC_SUCCESS) ? response->code
+                                                                               : MQTTASYNC_FAILURE;
+  pthread_cond_signal(&operation_completed);
+  pthread_mutex_unlock(&operation_mutex);
+}
+
+static void on_telemetry_completed(int mqtt_return_code, void* user_context)
+{
+  (void)user_context;
+
+  pthread_mutex_lock(&telemetry_mutex);
+  if (mqtt_return_code == MQTTASYNC_SUCCESS)
+  {
+    telemetry_acknowledged_count++;
+  }
+  else
+  {
+    telemetry_failed_count++;
+  }
+  pthread_mutex_unlock(&telemetry_mutex);
+}
+
+static void on_message_received(az_iot_hub_client_received_message* message, void* user_context)
+{
+  (void)user_context;
+
+  if (message->topic.type == AZ_IOT_HUB_CLIENT_TOPIC_TYPE_C2D_REQUEST)
+  {
+    IOT_SAMPLE_LOG_SUCCESS("Client received a C2D message.");
+    IOT_SAMPLE_LOG_AZ_SPAN("Payload:", message->payload);
+  }
+  else
+  {
+    IOT_SAMPLE_LOG_ERROR("Client received a message on an unexpected topic.");
+  }
+
+  // Releasing the message frees Paho's receive buffers.
+  az_iot_hub_client_received_message_release(message);
+}
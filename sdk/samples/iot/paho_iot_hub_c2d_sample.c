@@ -45,8 +45,9 @@ static void disconnect_mqtt_client_from_iot_hub(void);
 static void parse_c2d_message(
     char* topic,
     int topic_len,
-    MQTTClient_message const* message,
-    az_iot_hub_client_c2d_request* out_c2d_request);
+    MQTTClient_message* message,
+    az_iot_hub_client_received_message* out_c2d_message);
+static void release_mqtt_message(az_span topic, az_span payload, void* user_context);
 
 /*
  * This sample receives incoming cloud-to-device (C2D) messages sent from the Azure IoT Hub to the
@@ -217,13 +218,13 @@ static void receive_c2d_messages(void)
     IOT_SAMPLE_LOG_SUCCESS(
         "Message #%d: Client received a C2D message from the service.", message_count + 1);
 
-    // Parse c2d message.
-    az_iot_hub_client_c2d_request c2d_request;
-    parse_c2d_message(topic, topic_len, message, &c2d_request);
+    // Parse c2d message. It refers to the topic and payload Paho received, without copying them.
+    az_iot_hub_client_received_message c2d_message;
+    parse_c2d_message(topic, topic_len, message, &c2d_message);
     IOT_SAMPLE_LOG_SUCCESS("Client parsed C2D message.");
 
-    MQTTClient_freeMessage(&message);
-    MQTTClient_free(topic);
+    // Releasing the message frees the topic and payload, in release_mqtt_message().
+    az_iot_hub_client_received_message_release(&c2d_message);
   }
 
   IOT_SAMPLE_LOG(" "); // Formatting
@@ -245,15 +246,15 @@ static void disconnect_mqtt_client_from_iot_hub(void)
 static void parse_c2d_message(
     char* topic,
     int topic_len,
-    MQTTClient_message const* message,
-    az_iot_hub_client_c2d_request* out_c2d_request)
+    MQTTClient_message* message,
+    az_iot_hub_client_received_message* out_c2d_message)
 {
   az_span const topic_span = az_span_create((uint8_t*)topic, topic_len);
   az_span const message_span = az_span_create((uint8_t*)message->payload, message->payloadlen);
 
-  // Parse message and retrieve c2d_request info.
-  az_result rc
-      = az_iot_hub_client_c2d_parse_received_topic(&hub_client, topic_span, out_c2d_request);
+  // Parse message and retrieve c2d_request info. Only C2D topics are subscribed to.
+  az_result rc = az_iot_hub_client_parse_received_message(
+      &hub_client, topic_span, message_span, release_mqtt_message, message, out_c2d_message);
   if (az_result_failed(rc))
   {
     IOT_SAMPLE_LOG_ERROR("Message from unknown topic: az_result return code 0x%08x.", rc);
@@ -262,5 +263,14 @@ static void parse_c2d_message(
   }
   IOT_SAMPLE_LOG_SUCCESS("Client received a valid topic response.");
   IOT_SAMPLE_LOG_AZ_SPAN("Topic:", topic_span);
-  IOT_SAMPLE_LOG_AZ_SPAN("Payload:", message_span);
+  IOT_SAMPLE_LOG_AZ_SPAN("Payload:", out_c2d_message->payload);
+}
+
+static void release_mqtt_message(az_span topic, az_span payload, void* user_context)
+{
+  (void)payload;
+
+  MQTTClient_message* message = (MQTTClient_message*)user_context;
+  MQTTClient_freeMessage(&message);
+  MQTTClient_free((char*)az_span_ptr(topic));
 }
@@ -65,9 +65,18 @@ static az_span const twin_response_failed = AZ_SPAN_LITERAL_FROM_STR("failed");
 
 // IoT Hub Method (Command) Values
 static az_span const command_reboot_name = AZ_SPAN_LITERAL_FROM_STR("reboot");
+static az_span const command_get_max_min_report_name = AZ_SPAN_LITERAL_FROM_STR("getMaxMinReport");
 static az_span const command_empty_response_payload = AZ_SPAN_LITERAL_FROM_STR("{}");
 static char command_property_scratch_buffer[64];
 
+// The commands are routed with one lookup in a table. The thermostat of each command is at the
+// same index in command_thermostats, NULL for the commands of the Temperature Controller.
+#define COMMAND_CAPACITY 3
+static az_iot_hub_client_command_table command_table;
+static az_iot_hub_client_command commands[COMMAND_CAPACITY];
+static int32_t command_buckets[COMMAND_CAPACITY * 2 + 2];
+static pnp_thermostat_component* command_thermostats[COMMAND_CAPACITY];
+
 // IoT Hub Telemetry Values
 static az_span const telemetry_working_set_name = AZ_SPAN_LITERAL_FROM_STR("workingSet");
 
@@ -84,6 +93,10 @@ static void create_and_configure_mqtt_client(void);
 static void connect_mqtt_client_to_iot_hub(void);
 static void subscribe_mqtt_client_to_iot_hub_topics(void);
 static void initialize_components(void);
+static void register_command(
+    az_span component_name,
+    az_span command_name,
+    pnp_thermostat_component* thermostat);
 static void send_device_info(void);
 static void send_serial_number(void);
 static void request_device_twin_document(void);
@@ -467,6 +480,43 @@ static void initialize_components(void)
         "Failed to initialize Temperature Sensor 2: az_result return code 0x%08x.", rc);
     exit(rc);
   }
+
+  // Register the commands of the Temperature Controller and of the thermostats. The names of
+  // component commands use the separator of pnp_parse_command_name().
+  rc = az_iot_hub_client_command_table_init(
+      &command_table,
+      '/',
+      commands,
+      COMMAND_CAPACITY,
+      command_buckets,
+      (int32_t)(sizeof(command_buckets) / sizeof(command_buckets[0])));
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR(
+        "Failed to initialize the command table: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+
+  register_command(AZ_SPAN_EMPTY, command_reboot_name, NULL);
+  register_command(thermostat_1_name, command_get_max_min_report_name, &thermostat_1);
+  register_command(thermostat_2_name, command_get_max_min_report_name, &thermostat_2);
+}
+
+static void register_command(
+    az_span component_name,
+    az_span command_name,
+    pnp_thermostat_component* thermostat)
+{
+  int32_t index;
+  az_result rc
+      = az_iot_hub_client_command_table_add(&command_table, component_name, command_name, &index);
+  if (az_result_failed(rc))
+  {
+    IOT_SAMPLE_LOG_ERROR("Failed to register a command: az_result return code 0x%08x.", rc);
+    exit(rc);
+  }
+
+  command_thermostats[index] = thermostat;
 }
 
 static void send_device_info(void)
@@ -817,42 +867,36 @@ static void handle_command_request(
     MQTTClient_message const* receive_message,
     az_iot_hub_client_method_request const* command_request)
 {
-  az_span component_name;
+  int32_t command_index;
   az_span command_name;
-  pnp_parse_command_name(command_request->name, &component_name, &command_name);
 
   az_span const message_span
       = az_span_create((uint8_t*)receive_message->payload, receive_message->payloadlen);
   az_iot_status status = AZ_IOT_STATUS_UNKNOWN;
 
   // Invoke command and retrieve status and response payload to send to server.
-  if (az_span_is_content_equal(thermostat_1.component_name, component_name))
+  if (az_result_failed(az_iot_hub_client_command_table_find(
+          &command_table, command_request->name, &command_index, NULL, &command_name)))
   {
-    if (az_result_succeeded(pnp_thermostat_process_command_request(
-            &thermostat_1,
-            command_name,
-            message_span,
-            publish_message.payload,
-            &publish_message.out_payload,
-            &status)))
-    {
-      IOT_SAMPLE_LOG_AZ_SPAN("Client invoked command on Temperature Sensor 1:", command_name);
-    }
+    IOT_SAMPLE_LOG_AZ_SPAN("Command not supported:", command_request->name);
+    publish_message.out_payload = command_empty_response_payload;
+    status = AZ_IOT_STATUS_NOT_FOUND;
   }
-  else if (az_span_is_content_equal(thermostat_2.component_name, component_name))
+  else if (command_thermostats[command_index] != NULL)
   {
     if (az_result_succeeded(pnp_thermostat_process_command_request(
-            &thermostat_2,
+            command_thermostats[command_index],
             command_name,
             message_span,
             publish_message.payload,
             &publish_message.out_payload,
             &status)))
     {
-      IOT_SAMPLE_LOG_AZ_SPAN("Client invoked command on Temperature Sensor 2:", command_name);
+      IOT_SAMPLE_LOG_AZ_SPAN(
+          "Client invoked command on Temperature Sensor:", command_request->name);
     }
   }
-  else if (az_span_size(component_name) == 0)
+  else
   {
     if (az_result_succeeded(temp_controller_process_command_request(
             command_name,
@@ -864,12 +908,6 @@ static void handle_command_request(
       IOT_SAMPLE_LOG_AZ_SPAN("Client invoked command on Temperature Controller:", command_name);
     }
   }
-  else
-  {
-    IOT_SAMPLE_LOG_AZ_SPAN("Command not supported:", command_request->name);
-    publish_message.out_payload = command_empty_response_payload;
-    status = AZ_IOT_STATUS_NOT_FOUND;
-  }
 
   // Get the Methods response topic to publish the command response.
   az_result rc = az_iot_hub_client_methods_response_get_publish_topic(
@@ -4,9 +4,6 @@
 #ifdef _MSC_VER
 // warning C4204: nonstandard extension used: non-constant aggregate initializer
 #pragma warning(disable : 4204)
-// warning C4996: 'localtime': This function or variable may be unsafe.  Consider using localtime_s
-// instead.
-#pragma warning(disable : 4996)
 #pragma warning(push)
 // warning C4201: nonstandard extension used: nameless struct/union
 #pragma warning(disable : 4201)
@@ -42,7 +39,6 @@
 #define DOUBLE_DECIMAL_PLACE_DIGITS 2
 
 bool is_device_operational = true;
-static char const iso_spec_time_format[] = "%Y-%m-%dT%H:%M:%S%z"; // ISO8601 Time Format
 
 // * PnP Values *
 // The model id is the JSON document (also called the Digital Twins Model Identifier or DTMI) which
@@ -79,6 +75,7 @@ static az_span const command_end_time_name = AZ_SPAN_LITERAL_FROM_STR("endTime")
 static az_span const command_empty_response_payload = AZ_SPAN_LITERAL_FROM_STR("{}");
 static char command_start_time_value_buffer[32];
 static char command_end_time_value_buffer[32];
+static az_span_timestamp_cache command_end_time_cache;
 static char command_response_payload_buffer[256];
 
 // IoT Hub Telemetry Values
@@ -876,17 +873,12 @@ static az_result invoke_getMaxMinReport(az_span payload, az_span response, az_sp
 
   IOT_SAMPLE_LOG_AZ_SPAN("Start time:", start_time_span);
 
-  // Get the current time as a string.
-  time_t rawtime;
-  struct tm* timeinfo;
-  time(&rawtime);
-  timeinfo = localtime(&rawtime);
-  size_t length = strftime(
-      command_end_time_value_buffer,
-      sizeof(command_end_time_value_buffer),
-      iso_spec_time_format,
-      timeinfo);
-  az_span end_time_span = az_span_create((uint8_t*)command_end_time_value_buffer, (int32_t)length);
+  // Get the current time as an ISO 8601 UTC timestamp.
+  az_span end_time_span = az_span_create(
+      (uint8_t*)command_end_time_value_buffer, AZ_SPAN_ISO8601_TIMESTAMP_SIZE);
+  az_span remainder;
+  IOT_SAMPLE_RETURN_IF_FAILED(az_span_timestamp_to_iso8601(
+      end_time_span, (int64_t)time(NULL) * 1000, &command_end_time_cache, &remainder));
 
   IOT_SAMPLE_LOG_AZ_SPAN("End Time:", end_time_span);
 
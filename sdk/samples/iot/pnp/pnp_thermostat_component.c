@@ -1,12 +1,6 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
-#ifdef _MSC_VER
-// warning C4996: 'localtime': This function or variable may be unsafe. Consider using localtime_s
-// instead.
-#pragma warning(disable : 4996)
-#endif
-
 #include <iot_sample_common.h>
 
 #include "pnp_mqtt_message.h"
@@ -26,8 +20,6 @@
 #define DOUBLE_DECIMAL_PLACE_DIGITS 2
 #define DEFAULT_START_TEMP_COUNT 1
 
-static char const iso_spec_time_format[] = "%Y-%m-%dT%H:%M:%S%z"; // ISO8601 Time Format
-
 // IoT Hub Device Twin Values
 static az_span const twin_desired_temperature_property_name
     = AZ_SPAN_LITERAL_FROM_STR("targetTemperature");
@@ -46,6 +38,7 @@ static az_span const command_end_time_name = AZ_SPAN_LITERAL_FROM_STR("endTime")
 static az_span const command_empty_response_payload = AZ_SPAN_LITERAL_FROM_STR("{}");
 static char command_start_time_value_buffer[32];
 static char command_end_time_value_buffer[32];
+static az_span_timestamp_cache command_end_time_cache;
 
 // IoT Hub Telemetry Values
 static az_span const telemetry_temperature_name = AZ_SPAN_LITERAL_FROM_STR("temperature");
@@ -111,17 +104,12 @@ static az_result invoke_getMaxMinReport(
 
   IOT_SAMPLE_LOG_AZ_SPAN("Start time:", start_time_span);
 
-  // Get the current time as a string.
-  time_t rawtime;
-  struct tm* timeinfo;
-  time(&rawtime);
-  timeinfo = localtime(&rawtime);
-  size_t length = strftime(
-      command_end_time_value_buffer,
-      sizeof(command_end_time_value_buffer),
-      iso_spec_time_format,
-      timeinfo);
-  az_span end_time_span = az_span_create((uint8_t*)command_end_time_value_buffer, (int32_t)length);
+  // Get the current time as an ISO 8601 UTC timestamp.
+  az_span end_time_span = az_span_create(
+      (uint8_t*)command_end_time_value_buffer, AZ_SPAN_ISO8601_TIMESTAMP_SIZE);
+  az_span remainder;
+  IOT_SAMPLE_RETURN_IF_FAILED(az_span_timestamp_to_iso8601(
+      end_time_span, (int64_t)time(NULL) * 1000, &command_end_time_cache, &remainder));
 
   IOT_SAMPLE_LOG_AZ_SPAN("End Time:", end_time_span);
 
@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_buffer_stats.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+#ifdef AZ_BUFFER_STATS
+
+static uint64_t volatile _az_buffer_stats_peaks[_az_BUFFER_STATS_COUNT];
+
+void _az_buffer_stats_record(_az_buffer_stats_kind kind, int32_t size)
+{
+  uint64_t volatile* const peak = &_az_buffer_stats_peaks[kind];
+  uint64_t const new_size = size > 0 ? (uint64_t)size : 0;
+
+  uint64_t current = _az_atomic_load(peak);
+  while (current < new_size && !_az_atomic_compare_exchange(peak, &current, new_size))
+  {
+    // Another thread recorded a size, compare with the new peak.
+  }
+}
+
+static int32_t _az_buffer_stats_get_peak(_az_buffer_stats_kind kind)
+{
+  return (int32_t)_az_atomic_load(&_az_buffer_stats_peaks[kind]);
+}
+
+void az_buffer_stats_get(az_buffer_stats* out_stats)
+{
+  _az_PRECONDITION_NOT_NULL(out_stats);
+
+  *out_stats = (az_buffer_stats){
+    .http_request_url = _az_buffer_stats_get_peak(_az_BUFFER_STATS_HTTP_REQUEST_URL),
+    .http_request_headers = _az_buffer_stats_get_peak(_az_BUFFER_STATS_HTTP_REQUEST_HEADERS),
+    .http_response = _az_buffer_stats_get_peak(_az_BUFFER_STATS_HTTP_RESPONSE),
+    .json_writer = _az_buffer_stats_get_peak(_az_BUFFER_STATS_JSON_WRITER),
+    .iot_mqtt_topic = _az_buffer_stats_get_peak(_az_BUFFER_STATS_IOT_MQTT_TOPIC),
+    .iot_mqtt_client_id = _az_buffer_stats_get_peak(_az_BUFFER_STATS_IOT_MQTT_CLIENT_ID),
+    .iot_mqtt_user_name = _az_buffer_stats_get_peak(_az_BUFFER_STATS_IOT_MQTT_USER_NAME),
+    .iot_mqtt_password = _az_buffer_stats_get_peak(_az_BUFFER_STATS_IOT_MQTT_PASSWORD),
+  };
+}
+
+void az_buffer_stats_reset(void)
+{
+  for (int32_t i = 0; i < _az_BUFFER_STATS_COUNT; i++)
+  {
+    _az_atomic_store(&_az_buffer_stats_peaks[i], 0);
+  }
+}
+
+#else
+
+void az_buffer_stats_get(az_buffer_stats* out_stats)
+{
+  _az_PRECONDITION_NOT_NULL(out_stats);
+
+  *out_stats = (az_buffer_stats){ 0 };
+}
+
+void az_buffer_stats_reset(void) {}
+
+#endif // AZ_BUFFER_STATS
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#ifndef _az_CBOR_PRIVATE_H
+#define _az_CBOR_PRIVATE_H
+
+#include <azure/core/az_cbor.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+// The initial byte of a CBOR data item is its major type in the high 3 bits, and in the low 5
+// bits, either its argument, up to 23, or the size of the argument which follows it (RFC 8949).
+enum
+{
+  _az_CBOR_MAJOR_UNSIGNED_INTEGER = 0x00,
+  _az_CBOR_MAJOR_NEGATIVE_INTEGER = 0x20,
+  _az_CBOR_MAJOR_BYTE_STRING = 0x40,
+  _az_CBOR_MAJOR_TEXT_STRING = 0x60,
+  _az_CBOR_MAJOR_ARRAY = 0x80,
+  _az_CBOR_MAJOR_MAP = 0xA0,
+  _az_CBOR_MAJOR_TAG = 0xC0,
+  _az_CBOR_MAJOR_SIMPLE = 0xE0,
+  _az_CBOR_MAJOR_TYPE_MASK = 0xE0,
+  _az_CBOR_ADDITIONAL_MASK = 0x1F,
+};
+
+enum
+{
+  _az_CBOR_ADDITIONAL_UINT8 = 24,
+  _az_CBOR_ADDITIONAL_UINT16 = 25,
+  _az_CBOR_ADDITIONAL_UINT32 = 26,
+  _az_CBOR_ADDITIONAL_UINT64 = 27,
+  _az_CBOR_ADDITIONAL_INDEFINITE = 31,
+  _az_CBOR_BREAK = 0xFF,
+};
+
+// The simple values, whose floats use the additional information of the argument sizes.
+enum
+{
+  _az_CBOR_SIMPLE_FALSE = 20,
+  _az_CBOR_SIMPLE_TRUE = 21,
+  _az_CBOR_SIMPLE_NULL = 22,
+  _az_CBOR_SIMPLE_UNDEFINED = 23,
+};
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_CBOR_PRIVATE_H
@@ -0,0 +1,499 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_cbor_private.h"
+#include <azure/core/az_cbor.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+AZ_NODISCARD az_result az_cbor_reader_init(
+    az_cbor_reader* out_cbor_reader,
+    az_span cbor_buffer,
+    az_cbor_reader_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_cbor_reader);
+
+  *out_cbor_reader = (az_cbor_reader){
+    .token = (az_cbor_token){
+      .slice = AZ_SPAN_EMPTY,
+      .kind = AZ_CBOR_TOKEN_NONE,
+      ._internal = { 0 },
+    },
+    ._internal = {
+      .cbor_buffer = cbor_buffer,
+      .bytes_consumed = 0,
+      .nesting_depth = 0,
+      .options = options == NULL ? az_cbor_reader_options_default() : *options,
+    },
+  };
+  return AZ_OK;
+}
+
+// Reads the argument which follows the initial byte of an item, and returns the size of its head.
+static AZ_NODISCARD az_result
+_az_cbor_read_argument(az_span head, uint64_t* out_argument, int32_t* out_head_size)
+{
+  uint8_t const additional = az_span_ptr(head)[0] & _az_CBOR_ADDITIONAL_MASK;
+  if (additional < _az_CBOR_ADDITIONAL_UINT8)
+  {
+    *out_argument = additional;
+    *out_head_size = 1;
+    return AZ_OK;
+  }
+
+  if (additional > _az_CBOR_ADDITIONAL_UINT64)
+  {
+    // 28 to 30 are reserved, and an indefinite length is handled by the caller.
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  int32_t const argument_size = 1 << (additional - _az_CBOR_ADDITIONAL_UINT8);
+  if (az_span_size(head) < 1 + argument_size)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  uint64_t argument = 0;
+  for (int32_t i = 1; i <= argument_size; i++)
+  {
+    argument = argument << 8 | az_span_ptr(head)[i];
+  }
+
+  *out_argument = argument;
+  *out_head_size = 1 + argument_size;
+  return AZ_OK;
+}
+
+static AZ_NODISCARD double _az_cbor_half_to_double(uint16_t half_bits)
+{
+  uint32_t const sign = (uint32_t)(half_bits & 0x8000) << 16;
+  uint32_t const exponent = (half_bits >> 10) & 0x1F;
+  uint32_t const mantissa = half_bits & 0x3FF;
+
+  if (exponent == 0)
+  {
+    // Zero and the subnormal values, which are multiples of 2^-24, exactly as a double.
+    double const value = (double)mantissa / 16777216.0;
+    return sign != 0 ? -value : value;
+  }
+
+  // Normal values, the infinities and NaN have the same layout as in a single precision float,
+  // with a wider exponent.
+  uint32_t const single_bits = sign
+      | (exponent == 0x1F ? 0x7F800000 : (exponent - 15 + 127) << 23) | mantissa << 13;
+  float single = 0;
+  memcpy(&single, &single_bits, sizeof(single));
+  return single;
+}
+
+static AZ_NODISCARD az_result _az_cbor_read_simple(
+    az_span remaining,
+    int32_t offset,
+    az_cbor_token* out_token,
+    int32_t* out_head_size)
+{
+  az_span const head = az_span_slice_to_end(remaining, offset);
+  uint8_t const additional = az_span_ptr(head)[0] & _az_CBOR_ADDITIONAL_MASK;
+  switch (additional)
+  {
+    case _az_CBOR_SIMPLE_FALSE:
+      out_token->kind = AZ_CBOR_TOKEN_FALSE;
+      *out_head_size = 1;
+      return AZ_OK;
+    case _az_CBOR_SIMPLE_TRUE:
+      out_token->kind = AZ_CBOR_TOKEN_TRUE;
+      *out_head_size = 1;
+      return AZ_OK;
+    case _az_CBOR_SIMPLE_NULL:
+    case _az_CBOR_SIMPLE_UNDEFINED:
+      out_token->kind = AZ_CBOR_TOKEN_NULL;
+      *out_head_size = 1;
+      return AZ_OK;
+    case _az_CBOR_ADDITIONAL_UINT16:
+    case _az_CBOR_ADDITIONAL_UINT32:
+    case _az_CBOR_ADDITIONAL_UINT64:
+      break;
+    case _az_CBOR_ADDITIONAL_UINT8:
+      return AZ_ERROR_NOT_SUPPORTED;
+    default:
+      return additional < _az_CBOR_SIMPLE_FALSE ? AZ_ERROR_NOT_SUPPORTED : AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  uint64_t bits = 0;
+  _az_RETURN_IF_FAILED(_az_cbor_read_argument(head, &bits, out_head_size));
+
+  out_token->kind = AZ_CBOR_TOKEN_FLOAT;
+  if (additional == _az_CBOR_ADDITIONAL_UINT16)
+  {
+    out_token->_internal.float_value = _az_cbor_half_to_double((uint16_t)bits);
+  }
+  else if (additional == _az_CBOR_ADDITIONAL_UINT32)
+  {
+    uint32_t const single_bits = (uint32_t)bits;
+    float single = 0;
+    memcpy(&single, &single_bits, sizeof(single));
+    out_token->_internal.float_value = single;
+  }
+  else
+  {
+    memcpy(&out_token->_internal.float_value, &bits, sizeof(bits));
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_reader_next_token(az_cbor_reader* ref_cbor_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_reader);
+
+  az_span const remaining = az_span_slice_to_end(
+      ref_cbor_reader->_internal.cbor_buffer, ref_cbor_reader->_internal.bytes_consumed);
+  int32_t const depth = ref_cbor_reader->_internal.nesting_depth;
+  bool is_key = false;
+
+  if (depth > 0)
+  {
+    bool const is_map = ref_cbor_reader->_internal.containers[depth - 1].is_map;
+    bool const is_indefinite = ref_cbor_reader->_internal.containers[depth - 1].is_indefinite;
+    is_key = is_map && ref_cbor_reader->_internal.containers[depth - 1].is_key_next;
+
+    // A container of definite length ends after its last item, and one of indefinite length at
+    // the break byte, which can only come instead of a key in a map.
+    bool const is_end = is_indefinite
+        ? az_span_size(remaining) > 0 && az_span_ptr(remaining)[0] == _az_CBOR_BREAK
+        : ref_cbor_reader->_internal.containers[depth - 1].remaining_items == 0;
+    if (is_end)
+    {
+      if (is_indefinite && is_map && !is_key)
+      {
+        return AZ_ERROR_UNEXPECTED_CHAR;
+      }
+
+      int32_t const end_size = is_indefinite ? 1 : 0;
+      ref_cbor_reader->token = (az_cbor_token){
+        .slice = az_span_slice(remaining, 0, end_size),
+        .kind = is_map ? AZ_CBOR_TOKEN_END_MAP : AZ_CBOR_TOKEN_END_ARRAY,
+        ._internal = { 0 },
+      };
+      ref_cbor_reader->_internal.bytes_consumed += end_size;
+      ref_cbor_reader->_internal.nesting_depth--;
+      return AZ_OK;
+    }
+  }
+
+  if (az_span_size(remaining) == 0)
+  {
+    return depth == 0 ? AZ_ERROR_CBOR_READER_DONE : AZ_ERROR_UNEXPECTED_END;
+  }
+
+  // Tags only qualify the item which follows them, so they are skipped.
+  az_cbor_token token = { .slice = AZ_SPAN_EMPTY, .kind = AZ_CBOR_TOKEN_NONE, ._internal = { 0 } };
+  int32_t offset = 0;
+  uint8_t major_type = 0;
+  uint64_t argument = 0;
+  int32_t head_size = 0;
+  bool is_indefinite = false;
+  while (true)
+  {
+    if (offset >= az_span_size(remaining))
+    {
+      return AZ_ERROR_UNEXPECTED_END;
+    }
+
+    uint8_t const initial = az_span_ptr(remaining)[offset];
+    major_type = initial & _az_CBOR_MAJOR_TYPE_MASK;
+    if (major_type == _az_CBOR_MAJOR_SIMPLE)
+    {
+      _az_RETURN_IF_FAILED(_az_cbor_read_simple(remaining, offset, &token, &head_size));
+      break;
+    }
+
+    if ((initial & _az_CBOR_ADDITIONAL_MASK) == _az_CBOR_ADDITIONAL_INDEFINITE)
+    {
+      if (major_type == _az_CBOR_MAJOR_ARRAY || major_type == _az_CBOR_MAJOR_MAP)
+      {
+        is_indefinite = true;
+        head_size = 1;
+        break;
+      }
+
+      return major_type == _az_CBOR_MAJOR_BYTE_STRING || major_type == _az_CBOR_MAJOR_TEXT_STRING
+          ? AZ_ERROR_NOT_SUPPORTED
+          : AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
+    _az_RETURN_IF_FAILED(
+        _az_cbor_read_argument(az_span_slice_to_end(remaining, offset), &argument, &head_size));
+    if (major_type != _az_CBOR_MAJOR_TAG)
+    {
+      break;
+    }
+
+    offset += head_size;
+  }
+
+  int32_t item_size = offset + head_size;
+  switch (major_type)
+  {
+    case _az_CBOR_MAJOR_UNSIGNED_INTEGER:
+    case _az_CBOR_MAJOR_NEGATIVE_INTEGER:
+      token.kind = AZ_CBOR_TOKEN_INTEGER;
+      token._internal.value = argument;
+      token._internal.is_negative = major_type == _az_CBOR_MAJOR_NEGATIVE_INTEGER;
+      break;
+    case _az_CBOR_MAJOR_BYTE_STRING:
+    case _az_CBOR_MAJOR_TEXT_STRING:
+      if (argument > (uint64_t)(az_span_size(remaining) - item_size))
+      {
+        return AZ_ERROR_UNEXPECTED_END;
+      }
+      token.kind = major_type == _az_CBOR_MAJOR_BYTE_STRING
+          ? AZ_CBOR_TOKEN_BYTES
+          : (is_key ? AZ_CBOR_TOKEN_PROPERTY_NAME : AZ_CBOR_TOKEN_STRING);
+      break;
+    case _az_CBOR_MAJOR_ARRAY:
+    case _az_CBOR_MAJOR_MAP:
+      // Every item takes at least a byte, which also bounds the count of a map to half of 2^32.
+      if (!is_indefinite && argument > (uint64_t)(az_span_size(remaining) - item_size))
+      {
+        return AZ_ERROR_UNEXPECTED_END;
+      }
+      if (depth == _az_CBOR_MAX_NESTING_DEPTH)
+      {
+        return AZ_ERROR_CBOR_NESTING_OVERFLOW;
+      }
+      token.kind
+          = major_type == _az_CBOR_MAJOR_MAP ? AZ_CBOR_TOKEN_BEGIN_MAP : AZ_CBOR_TOKEN_BEGIN_ARRAY;
+      break;
+    default:
+      break;
+  }
+
+  if (is_key && token.kind != AZ_CBOR_TOKEN_PROPERTY_NAME)
+  {
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  if (token.kind == AZ_CBOR_TOKEN_BYTES || token.kind == AZ_CBOR_TOKEN_STRING
+      || token.kind == AZ_CBOR_TOKEN_PROPERTY_NAME)
+  {
+    token.slice = az_span_slice(remaining, item_size, item_size + (int32_t)argument);
+    item_size += (int32_t)argument;
+  }
+  else
+  {
+    token.slice = az_span_slice(remaining, 0, item_size);
+  }
+
+  if (depth > 0)
+  {
+    if (!ref_cbor_reader->_internal.containers[depth - 1].is_indefinite)
+    {
+      ref_cbor_reader->_internal.containers[depth - 1].remaining_items--;
+    }
+
+    if (ref_cbor_reader->_internal.containers[depth - 1].is_map)
+    {
+      ref_cbor_reader->_internal.containers[depth - 1].is_key_next = !is_key;
+    }
+  }
+
+  if (token.kind == AZ_CBOR_TOKEN_BEGIN_MAP || token.kind == AZ_CBOR_TOKEN_BEGIN_ARRAY)
+  {
+    bool const is_map = token.kind == AZ_CBOR_TOKEN_BEGIN_MAP;
+    ref_cbor_reader->_internal.containers[depth].is_map = is_map;
+    ref_cbor_reader->_internal.containers[depth].is_indefinite = is_indefinite;
+    ref_cbor_reader->_internal.containers[depth].is_key_next = is_map;
+    ref_cbor_reader->_internal.containers[depth].remaining_items
+        = is_indefinite ? 0 : (uint32_t)(is_map ? argument * 2 : argument);
+    ref_cbor_reader->_internal.nesting_depth++;
+  }
+
+  ref_cbor_reader->token = token;
+  ref_cbor_reader->_internal.bytes_consumed += item_size;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_reader_skip_children(az_cbor_reader* ref_cbor_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_reader);
+
+  if (ref_cbor_reader->token.kind == AZ_CBOR_TOKEN_PROPERTY_NAME)
+  {
+    _az_RETURN_IF_FAILED(az_cbor_reader_next_token(ref_cbor_reader));
+  }
+
+  az_cbor_token_kind const kind = ref_cbor_reader->token.kind;
+  if (kind == AZ_CBOR_TOKEN_BEGIN_MAP || kind == AZ_CBOR_TOKEN_BEGIN_ARRAY)
+  {
+    // The matching end token is the one which brings the depth back to its value before the start.
+    int32_t const depth = ref_cbor_reader->_internal.nesting_depth - 1;
+    while (true)
+    {
+      _az_RETURN_IF_FAILED(az_cbor_reader_next_token(ref_cbor_reader));
+      if (ref_cbor_reader->_internal.nesting_depth == depth
+          && (ref_cbor_reader->token.kind == AZ_CBOR_TOKEN_END_MAP
+              || ref_cbor_reader->token.kind == AZ_CBOR_TOKEN_END_ARRAY))
+      {
+        break;
+      }
+    }
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_token_get_boolean(az_cbor_token const* cbor_token, bool* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(cbor_token);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  if (cbor_token->kind != AZ_CBOR_TOKEN_TRUE && cbor_token->kind != AZ_CBOR_TOKEN_FALSE)
+  {
+    return AZ_ERROR_CBOR_INVALID_STATE;
+  }
+
+  *out_value = cbor_token->kind == AZ_CBOR_TOKEN_TRUE;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_cbor_token_get_uint64(az_cbor_token const* cbor_token, uint64_t* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(cbor_token);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  if (cbor_token->kind != AZ_CBOR_TOKEN_INTEGER)
+  {
+    return AZ_ERROR_CBOR_INVALID_STATE;
+  }
+
+  if (cbor_token->_internal.is_negative)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  *out_value = cbor_token->_internal.value;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_cbor_token_get_uint32(az_cbor_token const* cbor_token, uint32_t* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  uint64_t value = 0;
+  _az_RETURN_IF_FAILED(az_cbor_token_get_uint64(cbor_token, &value));
+  if (value > UINT32_MAX)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  *out_value = (uint32_t)value;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_token_get_int64(az_cbor_token const* cbor_token, int64_t* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(cbor_token);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  if (cbor_token->kind != AZ_CBOR_TOKEN_INTEGER)
+  {
+    return AZ_ERROR_CBOR_INVALID_STATE;
+  }
+
+  uint64_t const value = cbor_token->_internal.value;
+  if (value > INT64_MAX)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  // A negative integer holds -1 - value, so INT64_MIN is the largest it can be.
+  *out_value = cbor_token->_internal.is_negative ? -1 - (int64_t)value : (int64_t)value;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_token_get_int32(az_cbor_token const* cbor_token, int32_t* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  int64_t value = 0;
+  _az_RETURN_IF_FAILED(az_cbor_token_get_int64(cbor_token, &value));
+  if (value > INT32_MAX || value < INT32_MIN)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  *out_value = (int32_t)value;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_token_get_double(az_cbor_token const* cbor_token, double* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(cbor_token);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  if (cbor_token->kind == AZ_CBOR_TOKEN_FLOAT)
+  {
+    *out_value = cbor_token->_internal.float_value;
+    return AZ_OK;
+  }
+
+  if (cbor_token->kind != AZ_CBOR_TOKEN_INTEGER)
+  {
+    return AZ_ERROR_CBOR_INVALID_STATE;
+  }
+
+  double const value = (double)cbor_token->_internal.value;
+  *out_value = cbor_token->_internal.is_negative ? -1.0 - value : value;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_token_get_string(
+    az_cbor_token const* cbor_token,
+    char* destination,
+    int32_t destination_max_size,
+    int32_t* out_string_length)
+{
+  _az_PRECONDITION_NOT_NULL(cbor_token);
+  _az_PRECONDITION_NOT_NULL(destination);
+  _az_PRECONDITION(destination_max_size > 0);
+
+  if (cbor_token->kind != AZ_CBOR_TOKEN_STRING && cbor_token->kind != AZ_CBOR_TOKEN_PROPERTY_NAME)
+  {
+    return AZ_ERROR_CBOR_INVALID_STATE;
+  }
+
+  int32_t const size = az_span_size(cbor_token->slice);
+  if (size >= destination_max_size)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  az_span_to_str(destination, destination_max_size, cbor_token->slice);
+
+  if (out_string_length != NULL)
+  {
+    *out_string_length = size;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD bool az_cbor_token_is_text_equal(
+    az_cbor_token const* cbor_token,
+    az_span expected_text)
+{
+  _az_PRECONDITION_NOT_NULL(cbor_token);
+
+  return (cbor_token->kind == AZ_CBOR_TOKEN_STRING
+          || cbor_token->kind == AZ_CBOR_TOKEN_PROPERTY_NAME)
+      && az_span_is_content_equal(cbor_token->slice, expected_text);
+}
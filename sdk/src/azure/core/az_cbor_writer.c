@@ -0,0 +1,388 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_cbor_private.h"
+#include "az_span_private.h"
+#include <azure/core/az_cbor.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+AZ_NODISCARD az_result az_cbor_writer_init(
+    az_cbor_writer* out_cbor_writer,
+    az_span destination_buffer,
+    az_cbor_writer_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_cbor_writer);
+
+  *out_cbor_writer = (az_cbor_writer){
+    ._internal = {
+      .destination_buffer = destination_buffer,
+      .bytes_written = 0,
+      .total_bytes_written = 0,
+      .allocator_callback = NULL,
+      .user_context = NULL,
+      .nesting_depth = 0,
+      .options = options == NULL ? az_cbor_writer_options_default() : *options,
+    },
+  };
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_writer_chunked_init(
+    az_cbor_writer* out_cbor_writer,
+    az_span first_destination_buffer,
+    az_span_allocator_fn allocator_callback,
+    void* user_context,
+    az_cbor_writer_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_cbor_writer);
+  _az_PRECONDITION_NOT_NULL(allocator_callback);
+
+  *out_cbor_writer = (az_cbor_writer){
+    ._internal = {
+      .destination_buffer = first_destination_buffer,
+      .bytes_written = 0,
+      .total_bytes_written = 0,
+      .allocator_callback = allocator_callback,
+      .user_context = user_context,
+      .nesting_depth = 0,
+      .options = options == NULL ? az_cbor_writer_options_default() : *options,
+    },
+  };
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_span
+_az_cbor_writer_get_remaining_span(az_cbor_writer* ref_cbor_writer, int32_t required_size)
+{
+  az_span remaining = az_span_slice_to_end(
+      ref_cbor_writer->_internal.destination_buffer, ref_cbor_writer->_internal.bytes_written);
+
+  if (az_span_size(remaining) < required_size
+      && ref_cbor_writer->_internal.allocator_callback != NULL)
+  {
+    az_span_allocator_context context = {
+      .user_context = ref_cbor_writer->_internal.user_context,
+      .bytes_used = ref_cbor_writer->_internal.bytes_written,
+      .minimum_required_size = required_size,
+    };
+
+    // No more space left in the destination, let the caller fail with AZ_ERROR_NOT_ENOUGH_SPACE.
+    if (az_result_failed(ref_cbor_writer->_internal.allocator_callback(&context, &remaining)))
+    {
+      return AZ_SPAN_EMPTY;
+    }
+    ref_cbor_writer->_internal.destination_buffer = remaining;
+    ref_cbor_writer->_internal.bytes_written = 0;
+  }
+
+  return remaining;
+}
+
+static void _az_cbor_writer_advance(az_cbor_writer* ref_cbor_writer, int32_t size)
+{
+  ref_cbor_writer->_internal.bytes_written += size;
+  ref_cbor_writer->_internal.total_bytes_written += size;
+}
+
+// The head of an item is never split across destination buffers, so that a buffer always starts
+// with a whole head.
+static AZ_NODISCARD az_result
+_az_cbor_writer_append_head(az_cbor_writer* ref_cbor_writer, uint8_t major_type, uint64_t argument)
+{
+  uint8_t head[9];
+  int32_t size = 1;
+  if (argument < _az_CBOR_ADDITIONAL_UINT8)
+  {
+    head[0] = (uint8_t)(major_type | argument);
+  }
+  else
+  {
+    int32_t argument_size = 8;
+    uint8_t additional = _az_CBOR_ADDITIONAL_UINT64;
+    if (argument <= UINT8_MAX)
+    {
+      argument_size = 1;
+      additional = _az_CBOR_ADDITIONAL_UINT8;
+    }
+    else if (argument <= UINT16_MAX)
+    {
+      argument_size = 2;
+      additional = _az_CBOR_ADDITIONAL_UINT16;
+    }
+    else if (argument <= UINT32_MAX)
+    {
+      argument_size = 4;
+      additional = _az_CBOR_ADDITIONAL_UINT32;
+    }
+
+    head[0] = (uint8_t)(major_type | additional);
+    for (int32_t i = argument_size; i > 0; i--)
+    {
+      head[i] = (uint8_t)argument;
+      argument >>= 8;
+    }
+    size += argument_size;
+  }
+
+  az_span remaining = _az_cbor_writer_get_remaining_span(ref_cbor_writer, size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining, size);
+  memcpy(az_span_ptr(remaining), head, (size_t)size);
+  _az_cbor_writer_advance(ref_cbor_writer, size);
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_cbor_writer_append_content(az_cbor_writer* ref_cbor_writer, az_span content)
+{
+  while (az_span_size(content) > 0)
+  {
+    az_span remaining = _az_cbor_writer_get_remaining_span(ref_cbor_writer, 1);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining, 1);
+
+    int32_t const size = az_span_size(remaining) < az_span_size(content) ? az_span_size(remaining)
+                                                                         : az_span_size(content);
+    az_span_copy(remaining, az_span_slice(content, 0, size));
+    _az_cbor_writer_advance(ref_cbor_writer, size);
+    content = az_span_slice_to_end(content, size);
+  }
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_cbor_writer_append_string(az_cbor_writer* ref_cbor_writer, uint8_t major_type, az_span value)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+  _az_PRECONDITION_VALID_SPAN(value, 0, true);
+
+  // Without an allocator the whole string must fit, so that a failed append writes nothing.
+  if (ref_cbor_writer->_internal.allocator_callback == NULL)
+  {
+    int32_t const size = az_span_size(value);
+    int32_t const head_size = size < _az_CBOR_ADDITIONAL_UINT8 ? 1
+        : size <= UINT8_MAX                                    ? 2
+        : size <= UINT16_MAX                                   ? 3
+                                                               : 5;
+    az_span const remaining = az_span_slice_to_end(
+        ref_cbor_writer->_internal.destination_buffer, ref_cbor_writer->_internal.bytes_written);
+    if (az_span_size(remaining) - head_size < size)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+  }
+
+  _az_RETURN_IF_FAILED(
+      _az_cbor_writer_append_head(ref_cbor_writer, major_type, (uint64_t)az_span_size(value)));
+  return _az_cbor_writer_append_content(ref_cbor_writer, value);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_string(az_cbor_writer* ref_cbor_writer, az_span value)
+{
+  return _az_cbor_writer_append_string(ref_cbor_writer, _az_CBOR_MAJOR_TEXT_STRING, value);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_bytes(az_cbor_writer* ref_cbor_writer, az_span value)
+{
+  return _az_cbor_writer_append_string(ref_cbor_writer, _az_CBOR_MAJOR_BYTE_STRING, value);
+}
+
+AZ_NODISCARD az_result
+az_cbor_writer_append_property_name(az_cbor_writer* ref_cbor_writer, az_span name)
+{
+  _az_PRECONDITION(ref_cbor_writer->_internal.nesting_depth > 0);
+
+  return _az_cbor_writer_append_string(ref_cbor_writer, _az_CBOR_MAJOR_TEXT_STRING, name);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_bool(az_cbor_writer* ref_cbor_writer, bool value)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+
+  return _az_cbor_writer_append_head(
+      ref_cbor_writer, _az_CBOR_MAJOR_SIMPLE, value ? _az_CBOR_SIMPLE_TRUE : _az_CBOR_SIMPLE_FALSE);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_null(az_cbor_writer* ref_cbor_writer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+
+  return _az_cbor_writer_append_head(ref_cbor_writer, _az_CBOR_MAJOR_SIMPLE, _az_CBOR_SIMPLE_NULL);
+}
+
+AZ_NODISCARD az_result
+az_cbor_writer_append_uint64(az_cbor_writer* ref_cbor_writer, uint64_t value)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+
+  return _az_cbor_writer_append_head(ref_cbor_writer, _az_CBOR_MAJOR_UNSIGNED_INTEGER, value);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_int64(az_cbor_writer* ref_cbor_writer, int64_t value)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+
+  if (value >= 0)
+  {
+    return _az_cbor_writer_append_head(
+        ref_cbor_writer, _az_CBOR_MAJOR_UNSIGNED_INTEGER, (uint64_t)value);
+  }
+
+  // A negative integer is encoded as -1 - value, which is computed without overflowing INT64_MIN.
+  return _az_cbor_writer_append_head(
+      ref_cbor_writer, _az_CBOR_MAJOR_NEGATIVE_INTEGER, (uint64_t)(-(value + 1)));
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_int32(az_cbor_writer* ref_cbor_writer, int32_t value)
+{
+  return az_cbor_writer_append_int64(ref_cbor_writer, value);
+}
+
+// Returns whether the single precision float is exactly a half precision one, and its bits.
+static AZ_NODISCARD bool _az_cbor_float_to_half(uint32_t float_bits, uint16_t* out_half_bits)
+{
+  uint16_t const sign = (uint16_t)((float_bits >> 16) & 0x8000);
+  int32_t const exponent = (int32_t)((float_bits >> 23) & 0xFF) - 127;
+  uint32_t const mantissa = float_bits & 0x7FFFFF;
+
+  if (exponent == 128)
+  {
+    // The infinities, and NaN, which is always written as the canonical quiet NaN.
+    *out_half_bits = (uint16_t)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    return true;
+  }
+
+  if (exponent == -127 && mantissa == 0)
+  {
+    *out_half_bits = sign;
+    return true;
+  }
+
+  if (exponent >= -14 && exponent <= 15)
+  {
+    *out_half_bits = (uint16_t)(sign | (uint32_t)(exponent + 15) << 10 | mantissa >> 13);
+    return (mantissa & 0x1FFF) == 0;
+  }
+
+  // The smallest values are subnormal half precision floats, which are multiples of 2^-24.
+  if (exponent >= -24 && exponent < -14)
+  {
+    uint32_t const significand = mantissa | 0x800000;
+    int32_t const shift = -(exponent + 1);
+    *out_half_bits = (uint16_t)(sign | significand >> shift);
+    return (significand & ((1U << shift) - 1)) == 0;
+  }
+
+  return false;
+}
+
+// Floats are written with the size of their encoding rather than the smallest head which holds
+// their bits, which would be read as a float of another precision.
+static AZ_NODISCARD az_result
+_az_cbor_writer_append_float(az_cbor_writer* ref_cbor_writer, uint8_t additional, uint64_t bits)
+{
+  int32_t const argument_size = additional == _az_CBOR_ADDITIONAL_UINT16
+      ? 2
+      : (additional == _az_CBOR_ADDITIONAL_UINT32 ? 4 : 8);
+  az_span remaining = _az_cbor_writer_get_remaining_span(ref_cbor_writer, 1 + argument_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining, 1 + argument_size);
+
+  uint8_t* const bytes = az_span_ptr(remaining);
+  bytes[0] = (uint8_t)(_az_CBOR_MAJOR_SIMPLE | additional);
+  for (int32_t i = argument_size; i > 0; i--)
+  {
+    bytes[i] = (uint8_t)bits;
+    bits >>= 8;
+  }
+  _az_cbor_writer_advance(ref_cbor_writer, 1 + argument_size);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_double(az_cbor_writer* ref_cbor_writer, double value)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+
+  uint64_t double_bits = 0;
+  memcpy(&double_bits, &value, sizeof(double_bits));
+  bool const is_nan = !_az_isfinite(value) && (double_bits & 0xFFFFFFFFFFFFF) != 0;
+
+  // The value is written as a single precision float if converting it back gives the same bits.
+  float const single = is_nan ? 0.0f : (float)value;
+  double const widened = single;
+  uint64_t widened_bits = 0;
+  memcpy(&widened_bits, &widened, sizeof(widened_bits));
+  if (!is_nan && widened_bits != double_bits)
+  {
+    return _az_cbor_writer_append_float(ref_cbor_writer, _az_CBOR_ADDITIONAL_UINT64, double_bits);
+  }
+
+  uint32_t single_bits = 0x7FC00000;
+  if (!is_nan)
+  {
+    memcpy(&single_bits, &single, sizeof(single_bits));
+  }
+
+  uint16_t half_bits = 0;
+  if (_az_cbor_float_to_half(single_bits, &half_bits))
+  {
+    return _az_cbor_writer_append_float(ref_cbor_writer, _az_CBOR_ADDITIONAL_UINT16, half_bits);
+  }
+
+  return _az_cbor_writer_append_float(ref_cbor_writer, _az_CBOR_ADDITIONAL_UINT32, single_bits);
+}
+
+static AZ_NODISCARD az_result
+_az_cbor_writer_append_container_start(az_cbor_writer* ref_cbor_writer, uint8_t major_type)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+
+  az_span remaining = _az_cbor_writer_get_remaining_span(ref_cbor_writer, 1);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining, 1);
+  az_span_ptr(remaining)[0] = (uint8_t)(major_type | _az_CBOR_ADDITIONAL_INDEFINITE);
+  _az_cbor_writer_advance(ref_cbor_writer, 1);
+  ref_cbor_writer->_internal.nesting_depth++;
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_cbor_writer_append_container_end(az_cbor_writer* ref_cbor_writer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cbor_writer);
+  _az_PRECONDITION(ref_cbor_writer->_internal.nesting_depth > 0);
+
+  az_span remaining = _az_cbor_writer_get_remaining_span(ref_cbor_writer, 1);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining, 1);
+  az_span_ptr(remaining)[0] = _az_CBOR_BREAK;
+  _az_cbor_writer_advance(ref_cbor_writer, 1);
+  ref_cbor_writer->_internal.nesting_depth--;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_begin_map(az_cbor_writer* ref_cbor_writer)
+{
+  return _az_cbor_writer_append_container_start(ref_cbor_writer, _az_CBOR_MAJOR_MAP);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_begin_array(az_cbor_writer* ref_cbor_writer)
+{
+  return _az_cbor_writer_append_container_start(ref_cbor_writer, _az_CBOR_MAJOR_ARRAY);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_end_map(az_cbor_writer* ref_cbor_writer)
+{
+  return _az_cbor_writer_append_container_end(ref_cbor_writer);
+}
+
+AZ_NODISCARD az_result az_cbor_writer_append_end_array(az_cbor_writer* ref_cbor_writer)
+{
+  return _az_cbor_writer_append_container_end(ref_cbor_writer);
+}
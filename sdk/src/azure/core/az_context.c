@@ -2,9 +2,11 @@
 // SPDX-License-Identifier: MIT
 
 #include <azure/core/az_context.h>
+#include <azure/core/az_platform.h>
 #include <azure/core/internal/az_precondition_internal.h>
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -12,15 +14,24 @@
 // never expires. Call az_context_cancel passing a pointer to this node to cancel the entire
 // application (which cancels all the child nodes).
 az_context az_context_application = {
-  ._internal
-  = { .parent = NULL, .expiration = _az_CONTEXT_MAX_EXPIRATION, .key = NULL, .value = NULL }
+  ._internal = {
+    .parent = NULL,
+    .expiration = _az_CONTEXT_MAX_EXPIRATION,
+    .key = NULL,
+    .value = NULL,
+    .soonest_expiration = _az_CONTEXT_MAX_EXPIRATION,
+    .cancel_count = 0,
+  },
 };
 
-// Returns the soonest expiration time of this az_context node or any of its parent nodes.
-AZ_NODISCARD int64_t az_context_get_expiration(az_context const* context)
-{
-  _az_PRECONDITION_NOT_NULL(context);
+// Counts the calls to az_context_cancel. Canceling a node changes the soonest expiration of its
+// child nodes, which don't know about it, so their cached value is only used while this count
+// hasn't changed since they were created.
+static uint32_t volatile _az_context_cancel_count = 0;
 
+// Walks up the parent nodes to find the soonest expiration time.
+static AZ_NODISCARD int64_t _az_context_get_soonest_expiration(az_context const* context)
+{
   int64_t expiration = _az_CONTEXT_MAX_EXPIRATION;
   for (; context != NULL; context = context->_internal.parent)
   {
@@ -30,6 +41,42 @@ AZ_NODISCARD int64_t az_context_get_expiration(az_context const* context)
   return expiration;
 }
 
+// Returns the soonest expiration time of this az_context node or any of its parent nodes.
+AZ_NODISCARD int64_t az_context_get_expiration(az_context const* context)
+{
+  _az_PRECONDITION_NOT_NULL(context);
+
+  if (context->_internal.cancel_count == _az_context_cancel_count)
+  {
+    return context->_internal.soonest_expiration;
+  }
+
+  return _az_context_get_soonest_expiration(context);
+}
+
+// Creates a child node, caching its soonest expiration.
+static AZ_NODISCARD az_context _az_context_create(
+    az_context const* parent,
+    int64_t expiration,
+    void const* key,
+    void const* value)
+{
+  // Read the count first, so that a node canceled while the expiration is computed isn't missed.
+  uint32_t const cancel_count = _az_context_cancel_count;
+  int64_t const parent_expiration = az_context_get_expiration(parent);
+
+  return (az_context){
+    ._internal = {
+      .parent = parent,
+      .expiration = expiration,
+      .key = key,
+      .value = value,
+      .soonest_expiration = expiration < parent_expiration ? expiration : parent_expiration,
+      .cancel_count = cancel_count,
+    },
+  };
+}
+
 // Walks up this az_context node's parent until it find a node whose key matches the specified key
 // and return the corresponding value. Returns AZ_ERROR_ITEM_NOT_FOUND is there are no nodes
 // matching the specified key.
@@ -58,7 +105,7 @@ az_context_create_with_expiration(az_context const* parent, int64_t expiration)
   _az_PRECONDITION_NOT_NULL(parent);
   _az_PRECONDITION(expiration >= 0);
 
-  return (az_context){ ._internal = { .parent = parent, .expiration = expiration } };
+  return _az_context_create(parent, expiration, NULL, NULL);
 }
 
 AZ_NODISCARD az_context
@@ -67,10 +114,7 @@ az_context_create_with_value(az_context const* parent, void const* key, void con
   _az_PRECONDITION_NOT_NULL(parent);
   _az_PRECONDITION_NOT_NULL(key);
 
-  return (az_context){
-    ._internal
-    = { .parent = parent, .expiration = _az_CONTEXT_MAX_EXPIRATION, .key = key, .value = value }
-  };
+  return _az_context_create(parent, _az_CONTEXT_MAX_EXPIRATION, key, value);
 }
 
 void az_context_cancel(az_context* ref_context)
@@ -78,6 +122,13 @@ void az_context_cancel(az_context* ref_context)
   _az_PRECONDITION_NOT_NULL(ref_context);
 
   ref_context->_internal.expiration = 0; // The beginning of time
+  ref_context->_internal.soonest_expiration = 0;
+
+  // The child nodes of this node now have to walk up their parents to find it.
+  _az_context_cancel_count++;
+
+  // Threads waiting in az_platform_wait_msec() on this node or its children stop waiting.
+  az_platform_wake_waiters();
 }
 
 AZ_NODISCARD bool az_context_has_expired(az_context const* context, int64_t current_time)
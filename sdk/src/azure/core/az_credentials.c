@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_credentials.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+// How long a caller waits before it checks a refresh in flight again. The refreshing caller wakes
+// it as soon as the refresh is done, so this only bounds the wait when that wake is missed.
+#define _az_CREDENTIAL_TOKEN_CACHE_WAIT_MSEC 50
+
+// The lock is only held to look up an entry and to copy its token, never while a token is
+// acquired.
+static void _az_credential_token_cache_lock(az_credential_token_cache* ref_cache)
+{
+  _az_atomic_spin_lock(&ref_cache->_internal.lock);
+}
+
+static void _az_credential_token_cache_unlock(az_credential_token_cache* ref_cache)
+{
+  _az_atomic_spin_unlock(&ref_cache->_internal.lock);
+}
+
+// Called with the lock held.
+static AZ_NODISCARD az_result _az_credential_token_cache_find(
+    az_credential_token_cache* ref_cache,
+    void const* credential,
+    az_span scopes,
+    _az_credential_token_cache_entry** out_entry)
+{
+  for (int32_t i = 0; i < ref_cache->_internal.entry_count; i++)
+  {
+    _az_credential_token_cache_entry* const entry = &ref_cache->_internal.entries[i];
+    if (entry->_internal.credential == credential
+        && az_span_is_content_equal(entry->_internal.scopes, scopes))
+    {
+      *out_entry = entry;
+      return AZ_OK;
+    }
+  }
+
+  if (ref_cache->_internal.entry_count == AZ_CREDENTIAL_TOKEN_CACHE_MAX_ENTRIES)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  _az_credential_token_cache_entry* const entry
+      = &ref_cache->_internal.entries[ref_cache->_internal.entry_count];
+  entry->_internal.credential = credential;
+  entry->_internal.scopes = scopes;
+  entry->_internal.token_size = 0;
+  entry->_internal.expires_at_msec = 0;
+  entry->_internal.is_refreshing = false;
+  entry->_internal.refresh_count = 0;
+  entry->_internal.refresh_result = AZ_OK;
+  ref_cache->_internal.entry_count++;
+
+  *out_entry = entry;
+  return AZ_OK;
+}
+
+// Called with the lock held.
+static AZ_NODISCARD az_result _az_credential_token_cache_copy(
+    _az_credential_token_cache_entry* entry,
+    az_span token_buffer,
+    az_span* out_token)
+{
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(token_buffer, entry->_internal.token_size);
+
+  az_span_copy(
+      token_buffer, az_span_create(entry->_internal.token, entry->_internal.token_size));
+  *out_token = az_span_slice(token_buffer, 0, entry->_internal.token_size);
+  return AZ_OK;
+}
+
+void az_credential_token_cache_init(
+    az_credential_token_cache* out_cache,
+    az_credential_token_cache_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_cache);
+
+  out_cache->_internal.options
+      = options == NULL ? az_credential_token_cache_options_default() : *options;
+  out_cache->_internal.lock = 0;
+  out_cache->_internal.entry_count = 0;
+}
+
+AZ_NODISCARD az_result az_credential_token_cache_get(
+    az_credential_token_cache* ref_cache,
+    void const* credential,
+    az_span scopes,
+    az_context* context,
+    az_credential_token_acquire_fn acquire,
+    void* acquire_user_context,
+    az_span token_buffer,
+    az_span* out_token)
+{
+  _az_PRECONDITION_NOT_NULL(ref_cache);
+  _az_PRECONDITION_NOT_NULL(acquire);
+  _az_PRECONDITION_VALID_SPAN(token_buffer, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_token);
+
+  int64_t const refresh_before_expiry_msec
+      = ref_cache->_internal.options.refresh_before_expiry_msec;
+  int64_t now = az_platform_clock_msec();
+
+  _az_credential_token_cache_lock(ref_cache);
+
+  _az_credential_token_cache_entry* entry = NULL;
+  az_result result = _az_credential_token_cache_find(ref_cache, credential, scopes, &entry);
+  if (az_result_failed(result))
+  {
+    _az_credential_token_cache_unlock(ref_cache);
+    return result;
+  }
+
+  while (true)
+  {
+    bool const is_valid
+        = entry->_internal.token_size > 0 && now < entry->_internal.expires_at_msec;
+    bool const is_fresh
+        = is_valid && now < entry->_internal.expires_at_msec - refresh_before_expiry_msec;
+
+    if (is_fresh || (is_valid && entry->_internal.is_refreshing))
+    {
+      result = _az_credential_token_cache_copy(entry, token_buffer, out_token);
+      _az_credential_token_cache_unlock(ref_cache);
+      return result;
+    }
+
+    if (!entry->_internal.is_refreshing)
+    {
+      break;
+    }
+
+    // Wait for the refresh in flight, and return its failure rather than start another one.
+    uint64_t const refresh_count = entry->_internal.refresh_count;
+    _az_credential_token_cache_unlock(ref_cache);
+
+    _az_RETURN_IF_FAILED(az_platform_wait_msec(context, _az_CREDENTIAL_TOKEN_CACHE_WAIT_MSEC));
+
+    now = az_platform_clock_msec();
+    _az_credential_token_cache_lock(ref_cache);
+
+    if (entry->_internal.refresh_count != refresh_count
+        && az_result_failed(entry->_internal.refresh_result))
+    {
+      result = entry->_internal.refresh_result;
+      _az_credential_token_cache_unlock(ref_cache);
+      return result;
+    }
+  }
+
+  // This caller refreshes the token, the others wait for it or keep using the current one.
+  entry->_internal.is_refreshing = true;
+  _az_credential_token_cache_unlock(ref_cache);
+
+  az_span token = AZ_SPAN_EMPTY;
+  int64_t expires_at_msec = 0;
+  result = acquire(acquire_user_context, context, scopes, token_buffer, &token, &expires_at_msec);
+  if (az_result_succeeded(result) && az_span_size(token) > AZ_CREDENTIAL_TOKEN_MAX_SIZE)
+  {
+    result = AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  _az_credential_token_cache_lock(ref_cache);
+
+  if (az_result_succeeded(result))
+  {
+    az_span_copy(AZ_SPAN_FROM_BUFFER(entry->_internal.token), token);
+    entry->_internal.token_size = az_span_size(token);
+    entry->_internal.expires_at_msec = expires_at_msec;
+    *out_token = token;
+  }
+  else if (entry->_internal.token_size > 0 && now < entry->_internal.expires_at_msec)
+  {
+    // The current token is still valid, the next caller will try to refresh it again.
+    result = _az_credential_token_cache_copy(entry, token_buffer, out_token);
+  }
+
+  entry->_internal.refresh_result = result;
+  entry->_internal.refresh_count++;
+  entry->_internal.is_refreshing = false;
+  _az_credential_token_cache_unlock(ref_cache);
+
+  az_platform_wake_waiters();
+  return result;
+}
@@ -0,0 +1,1438 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_hex_private.h"
+#include "az_simd_private.h"
+#include <azure/core/az_crypto.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+enum
+{
+  _az_SHA256_BLOCK_SIZE = 64,
+};
+
+static az_crypto_hmac_sha256_fn volatile _az_crypto_hmac_sha256_callback = NULL;
+
+// The first 32 bits of the fractional parts of the cube roots of the first 64 primes.
+static uint32_t const _az_sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+typedef struct
+{
+  uint32_t state[8];
+  uint8_t block[_az_SHA256_BLOCK_SIZE];
+  int32_t block_size;
+  uint64_t total_size;
+} _az_sha256_context;
+
+#ifdef _az_SIMD_KERNEL_SHA_X86
+
+// Uses the SHA extensions, which keep the state as the ABEF and CDGH halves and perform two rounds
+// per instruction.
+_az_SIMD_TARGET("sha,sse4.1") void _az_sha256_compress_sha_x86(
+    uint32_t state[8],
+    uint8_t const* data,
+    int32_t block_count)
+{
+  __m128i const byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const*)&state[0]), 0xB1); // CDAB
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const*)&state[4]), 0x1B); // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+  for (int32_t block = 0; block < block_count; block++, data += _az_SHA256_BLOCK_SIZE)
+  {
+    __m128i const abef_save = state0;
+    __m128i const cdgh_save = state1;
+    __m128i w[4];
+
+    for (int32_t group = 0; group < 16; group++)
+    {
+      if (group < 4)
+      {
+        w[group] = _mm_shuffle_epi8(
+            _mm_loadu_si128((__m128i const*)(data + (group * 16))), byte_swap);
+      }
+
+      __m128i message
+          = _mm_add_epi32(w[group & 3], _mm_loadu_si128((__m128i const*)&_az_sha256_k[group * 4]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+
+      if (group >= 3 && group <= 14)
+      {
+        __m128i const next = _mm_add_epi32(
+            w[(group + 1) & 3], _mm_alignr_epi8(w[group & 3], w[(group - 1) & 3], 4));
+        w[(group + 1) & 3] = _mm_sha256msg2_epu32(next, w[group & 3]);
+      }
+
+      message = _mm_shuffle_epi32(message, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+
+      if (group >= 1 && group <= 12)
+      {
+        w[(group - 1) & 3] = _mm_sha256msg1_epu32(w[(group - 1) & 3], w[group & 3]);
+      }
+    }
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+  _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(tmp, state1, 0xF0)); // DCBA
+  _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(state1, tmp, 8)); // HGFE
+}
+
+#endif // _az_SIMD_KERNEL_SHA_X86
+
+#ifdef _az_SIMD_KERNEL_SHA_ARMV8
+
+// Uses the ARMv8 cryptography extension, which performs four rounds per instruction pair.
+_az_SIMD_TARGET_ARMV8("sha2") void _az_sha256_compress_sha_armv8(
+    uint32_t state[8],
+    uint8_t const* data,
+    int32_t block_count)
+{
+  uint32x4_t state0 = vld1q_u32(&state[0]);
+  uint32x4_t state1 = vld1q_u32(&state[4]);
+
+  for (int32_t block = 0; block < block_count; block++, data += _az_SHA256_BLOCK_SIZE)
+  {
+    uint32x4_t const abcd_save = state0;
+    uint32x4_t const efgh_save = state1;
+    uint32x4_t w[4];
+
+    for (int32_t i = 0; i < 4; i++)
+    {
+      w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + (i * 16))));
+    }
+
+    for (int32_t group = 0; group < 16; group++)
+    {
+      uint32x4_t const message = vaddq_u32(w[group & 3], vld1q_u32(&_az_sha256_k[group * 4]));
+      uint32x4_t const previous_state0 = state0;
+
+      if (group < 12)
+      {
+        w[group & 3] = vsha256su0q_u32(w[group & 3], w[(group + 1) & 3]);
+      }
+
+      state0 = vsha256hq_u32(state0, state1, message);
+      state1 = vsha256h2q_u32(state1, previous_state0, message);
+
+      if (group < 12)
+      {
+        w[group & 3] = vsha256su1q_u32(w[group & 3], w[(group + 2) & 3], w[(group + 3) & 3]);
+      }
+    }
+
+    state0 = vaddq_u32(state0, abcd_save);
+    state1 = vaddq_u32(state1, efgh_save);
+  }
+
+  vst1q_u32(&state[0], state0);
+  vst1q_u32(&state[4], state1);
+}
+
+#endif // _az_SIMD_KERNEL_SHA_ARMV8
+
+AZ_INLINE uint32_t _az_sha256_rotate_right(uint32_t value, int32_t count)
+{
+  return (value >> count) | (value << (32 - count));
+}
+
+static void
+_az_sha256_compress_scalar(uint32_t state[8], uint8_t const* data, int32_t block_count)
+{
+  for (int32_t block = 0; block < block_count; block++, data += _az_SHA256_BLOCK_SIZE)
+  {
+    // Only the last 16 words of the message schedule are needed at any time.
+    uint32_t w[16];
+    for (int32_t i = 0; i < 16; i++)
+    {
+      uint8_t const* word = data + (i * 4);
+      w[i] = ((uint32_t)word[0] << 24) | ((uint32_t)word[1] << 16) | ((uint32_t)word[2] << 8)
+          | (uint32_t)word[3];
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+
+    for (int32_t round = 0; round < 64; round++)
+    {
+      if (round >= 16)
+      {
+        uint32_t const w15 = w[(round - 15) & 15];
+        uint32_t const w2 = w[(round - 2) & 15];
+        uint32_t const s0
+            = _az_sha256_rotate_right(w15, 7) ^ _az_sha256_rotate_right(w15, 18) ^ (w15 >> 3);
+        uint32_t const s1
+            = _az_sha256_rotate_right(w2, 17) ^ _az_sha256_rotate_right(w2, 19) ^ (w2 >> 10);
+        w[round & 15] += s0 + w[(round - 7) & 15] + s1;
+      }
+
+      uint32_t const sum1 = _az_sha256_rotate_right(e, 6) ^ _az_sha256_rotate_right(e, 11)
+          ^ _az_sha256_rotate_right(e, 25);
+      uint32_t const choice = (e & f) ^ (~e & g);
+      uint32_t const temp1 = h + sum1 + choice + _az_sha256_k[round] + w[round & 15];
+      uint32_t const sum0 = _az_sha256_rotate_right(a, 2) ^ _az_sha256_rotate_right(a, 13)
+          ^ _az_sha256_rotate_right(a, 22);
+      uint32_t const majority = (a & b) ^ (a & c) ^ (b & c);
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + temp1;
+      d = c;
+      c = b;
+      b = a;
+      a = temp1 + sum0 + majority;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+// Uses the SHA-256 instructions of the host, when it has them.
+static void _az_sha256_compress(uint32_t state[8], uint8_t const* data, int32_t block_count)
+{
+#ifdef _az_SIMD
+  _az_simd_sha256_fn const compress = _az_simd_get_kernels()->sha256_compress;
+  if (compress != NULL)
+  {
+    compress(state, data, block_count);
+    return;
+  }
+#endif // _az_SIMD
+
+  _az_sha256_compress_scalar(state, data, block_count);
+}
+
+static void _az_sha256_init(_az_sha256_context* context)
+{
+  // The first 32 bits of the fractional parts of the square roots of the first 8 primes.
+  context->state[0] = 0x6a09e667;
+  context->state[1] = 0xbb67ae85;
+  context->state[2] = 0x3c6ef372;
+  context->state[3] = 0xa54ff53a;
+  context->state[4] = 0x510e527f;
+  context->state[5] = 0x9b05688c;
+  context->state[6] = 0x1f83d9ab;
+  context->state[7] = 0x5be0cd19;
+  context->block_size = 0;
+  context->total_size = 0;
+}
+
+static void _az_sha256_update(_az_sha256_context* context, az_span source)
+{
+  int32_t size = az_span_size(source);
+  context->total_size += (uint64_t)size;
+
+  if (context->block_size > 0)
+  {
+    int32_t const needed = _az_SHA256_BLOCK_SIZE - context->block_size;
+    int32_t const copied = size < needed ? size : needed;
+    az_span_copy(
+        az_span_slice_to_end(AZ_SPAN_FROM_BUFFER(context->block), context->block_size),
+        az_span_slice(source, 0, copied));
+    context->block_size += copied;
+    source = az_span_slice_to_end(source, copied);
+    size -= copied;
+
+    if (context->block_size < _az_SHA256_BLOCK_SIZE)
+    {
+      return;
+    }
+
+    _az_sha256_compress(context->state, context->block, 1);
+    context->block_size = 0;
+  }
+
+  // Whole blocks are compressed straight from the source, without being copied.
+  int32_t const block_count = size / _az_SHA256_BLOCK_SIZE;
+  if (block_count > 0)
+  {
+    _az_sha256_compress(context->state, az_span_ptr(source), block_count);
+    size -= block_count * _az_SHA256_BLOCK_SIZE;
+    source = az_span_slice_to_end(source, block_count * _az_SHA256_BLOCK_SIZE);
+  }
+
+  if (size > 0)
+  {
+    az_span_copy(AZ_SPAN_FROM_BUFFER(context->block), source);
+    context->block_size = size;
+  }
+}
+
+static void _az_sha256_final(_az_sha256_context* context, uint8_t digest[AZ_CRYPTO_SHA256_SIZE])
+{
+  uint64_t const total_bits = context->total_size * 8;
+
+  // Pad with a single one bit, then zeros up to the last 8 bytes of a block, which hold the
+  // message size in bits.
+  context->block[context->block_size++] = 0x80;
+  if (context->block_size > _az_SHA256_BLOCK_SIZE - 8)
+  {
+    az_span_fill(
+        az_span_slice_to_end(AZ_SPAN_FROM_BUFFER(context->block), context->block_size), 0);
+    _az_sha256_compress(context->state, context->block, 1);
+    context->block_size = 0;
+  }
+
+  az_span_fill(
+      az_span_slice(
+          AZ_SPAN_FROM_BUFFER(context->block), context->block_size, _az_SHA256_BLOCK_SIZE - 8),
+      0);
+  for (int32_t i = 0; i < 8; i++)
+  {
+    context->block[_az_SHA256_BLOCK_SIZE - 1 - i] = (uint8_t)(total_bits >> (i * 8));
+  }
+  _az_sha256_compress(context->state, context->block, 1);
+
+  for (int32_t i = 0; i < 8; i++)
+  {
+    digest[(i * 4) + 0] = (uint8_t)(context->state[i] >> 24);
+    digest[(i * 4) + 1] = (uint8_t)(context->state[i] >> 16);
+    digest[(i * 4) + 2] = (uint8_t)(context->state[i] >> 8);
+    digest[(i * 4) + 3] = (uint8_t)context->state[i];
+  }
+}
+
+void az_crypto_set_hmac_sha256_callback(az_crypto_hmac_sha256_fn hmac_sha256_callback)
+{
+  _az_crypto_hmac_sha256_callback = hmac_sha256_callback;
+}
+
+AZ_NODISCARD az_result az_crypto_sha256(az_span source, az_span destination)
+{
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, AZ_CRYPTO_SHA256_SIZE);
+
+  _az_sha256_context context;
+  _az_sha256_init(&context);
+  _az_sha256_update(&context, source);
+  _az_sha256_final(&context, az_span_ptr(destination));
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_crypto_hmac_sha256(az_span key, az_span message, az_span destination)
+{
+  _az_PRECONDITION_VALID_SPAN(key, 0, true);
+  _az_PRECONDITION_VALID_SPAN(message, 0, true);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, AZ_CRYPTO_SHA256_SIZE);
+
+  az_crypto_hmac_sha256_fn const callback = _az_crypto_hmac_sha256_callback;
+  if (callback != NULL)
+  {
+    return callback(key, message, destination);
+  }
+
+  // Keys longer than a block are replaced by their digest, and all keys are zero padded to a block.
+  uint8_t padded_key[_az_SHA256_BLOCK_SIZE] = { 0 };
+  if (az_span_size(key) > _az_SHA256_BLOCK_SIZE)
+  {
+    _az_RETURN_IF_FAILED(az_crypto_sha256(key, AZ_SPAN_FROM_BUFFER(padded_key)));
+  }
+  else
+  {
+    az_span_copy(AZ_SPAN_FROM_BUFFER(padded_key), key);
+  }
+
+  uint8_t pad[_az_SHA256_BLOCK_SIZE];
+  uint8_t inner_digest[AZ_CRYPTO_SHA256_SIZE];
+  _az_sha256_context context;
+
+  // inner = SHA-256((key ^ ipad) || message)
+  for (int32_t i = 0; i < _az_SHA256_BLOCK_SIZE; i++)
+  {
+    pad[i] = (uint8_t)(padded_key[i] ^ 0x36);
+  }
+  _az_sha256_init(&context);
+  _az_sha256_update(&context, AZ_SPAN_FROM_BUFFER(pad));
+  _az_sha256_update(&context, message);
+  _az_sha256_final(&context, inner_digest);
+
+  // HMAC = SHA-256((key ^ opad) || inner)
+  for (int32_t i = 0; i < _az_SHA256_BLOCK_SIZE; i++)
+  {
+    pad[i] = (uint8_t)(padded_key[i] ^ 0x5c);
+  }
+  _az_sha256_init(&context);
+  _az_sha256_update(&context, AZ_SPAN_FROM_BUFFER(pad));
+  _az_sha256_update(&context, AZ_SPAN_FROM_BUFFER(inner_digest));
+  _az_sha256_final(&context, az_span_ptr(destination));
+
+  return AZ_OK;
+}
+
+// The CRC-64 of Azure Storage, whose polynomial is 0x9A6C9329AC4BC9B5 in its bit-reflected form,
+// one byte at a time: the remainder of each byte value.
+static uint64_t const _az_crc64_table[256] = {
+  0x0000000000000000, 0x7f6ef0c830358979, 0xfedde190606b12f2, 0x81b31158505e9b8b,
+  0xc962e5739841b68f, 0xb60c15bba8743ff6, 0x37bf04e3f82aa47d, 0x48d1f42bc81f2d04,
+  0xa61cecb46814fe75, 0xd9721c7c5821770c, 0x58c10d24087fec87, 0x27affdec384a65fe,
+  0x6f7e09c7f05548fa, 0x1010f90fc060c183, 0x91a3e857903e5a08, 0xeecd189fa00bd371,
+  0x78e0ff3b88be6f81, 0x078e0ff3b88be6f8, 0x863d1eabe8d57d73, 0xf953ee63d8e0f40a,
+  0xb1821a4810ffd90e, 0xceecea8020ca5077, 0x4f5ffbd87094cbfc, 0x30310b1040a14285,
+  0xdefc138fe0aa91f4, 0xa192e347d09f188d, 0x2021f21f80c18306, 0x5f4f02d7b0f40a7f,
+  0x179ef6fc78eb277b, 0x68f0063448deae02, 0xe943176c18803589, 0x962de7a428b5bcf0,
+  0xf1c1fe77117cdf02, 0x8eaf0ebf2149567b, 0x0f1c1fe77117cdf0, 0x7072ef2f41224489,
+  0x38a31b04893d698d, 0x47cdebccb908e0f4, 0xc67efa94e9567b7f, 0xb9100a5cd963f206,
+  0x57dd12c379682177, 0x28b3e20b495da80e, 0xa900f35319033385, 0xd66e039b2936bafc,
+  0x9ebff7b0e12997f8, 0xe1d10778d11c1e81, 0x606216208142850a, 0x1f0ce6e8b1770c73,
+  0x8921014c99c2b083, 0xf64ff184a9f739fa, 0x77fce0dcf9a9a271, 0x08921014c99c2b08,
+  0x4043e43f0183060c, 0x3f2d14f731b68f75, 0xbe9e05af61e814fe, 0xc1f0f56751dd9d87,
+  0x2f3dedf8f1d64ef6, 0x50531d30c1e3c78f, 0xd1e00c6891bd5c04, 0xae8efca0a188d57d,
+  0xe65f088b6997f879, 0x9931f84359a27100, 0x1882e91b09fcea8b, 0x67ec19d339c963f2,
+  0xd75adabd7a6e2d6f, 0xa8342a754a5ba416, 0x29873b2d1a053f9d, 0x56e9cbe52a30b6e4,
+  0x1e383fcee22f9be0, 0x6156cf06d21a1299, 0xe0e5de5e82448912, 0x9f8b2e96b271006b,
+  0x71463609127ad31a, 0x0e28c6c1224f5a63, 0x8f9bd7997211c1e8, 0xf0f5275142244891,
+  0xb824d37a8a3b6595, 0xc74a23b2ba0eecec, 0x46f932eaea507767, 0x3997c222da65fe1e,
+  0xafba2586f2d042ee, 0xd0d4d54ec2e5cb97, 0x5167c41692bb501c, 0x2e0934dea28ed965,
+  0x66d8c0f56a91f461, 0x19b6303d5aa47d18, 0x980521650afae693, 0xe76bd1ad3acf6fea,
+  0x09a6c9329ac4bc9b, 0x76c839faaaf135e2, 0xf77b28a2faafae69, 0x8815d86aca9a2710,
+  0xc0c42c4102850a14, 0xbfaadc8932b0836d, 0x3e19cdd162ee18e6, 0x41773d1952db919f,
+  0x269b24ca6b12f26d, 0x59f5d4025b277b14, 0xd846c55a0b79e09f, 0xa72835923b4c69e6,
+  0xeff9c1b9f35344e2, 0x90973171c366cd9b, 0x1124202993385610, 0x6e4ad0e1a30ddf69,
+  0x8087c87e03060c18, 0xffe938b633338561, 0x7e5a29ee636d1eea, 0x0134d92653589793,
+  0x49e52d0d9b47ba97, 0x368bddc5ab7233ee, 0xb738cc9dfb2ca865, 0xc8563c55cb19211c,
+  0x5e7bdbf1e3ac9dec, 0x21152b39d3991495, 0xa0a63a6183c78f1e, 0xdfc8caa9b3f20667,
+  0x97193e827bed2b63, 0xe877ce4a4bd8a21a, 0x69c4df121b863991, 0x16aa2fda2bb3b0e8,
+  0xf86737458bb86399, 0x8709c78dbb8deae0, 0x06bad6d5ebd3716b, 0x79d4261ddbe6f812,
+  0x3105d23613f9d516, 0x4e6b22fe23cc5c6f, 0xcfd833a67392c7e4, 0xb0b6c36e43a74e9d,
+  0x9a6c9329ac4bc9b5, 0xe50263e19c7e40cc, 0x64b172b9cc20db47, 0x1bdf8271fc15523e,
+  0x530e765a340a7f3a, 0x2c608692043ff643, 0xadd397ca54616dc8, 0xd2bd67026454e4b1,
+  0x3c707f9dc45f37c0, 0x431e8f55f46abeb9, 0xc2ad9e0da4342532, 0xbdc36ec59401ac4b,
+  0xf5129aee5c1e814f, 0x8a7c6a266c2b0836, 0x0bcf7b7e3c7593bd, 0x74a18bb60c401ac4,
+  0xe28c6c1224f5a634, 0x9de29cda14c02f4d, 0x1c518d82449eb4c6, 0x633f7d4a74ab3dbf,
+  0x2bee8961bcb410bb, 0x548079a98c8199c2, 0xd53368f1dcdf0249, 0xaa5d9839ecea8b30,
+  0x449080a64ce15841, 0x3bfe706e7cd4d138, 0xba4d61362c8a4ab3, 0xc52391fe1cbfc3ca,
+  0x8df265d5d4a0eece, 0xf29c951de49567b7, 0x732f8445b4cbfc3c, 0x0c41748d84fe7545,
+  0x6bad6d5ebd3716b7, 0x14c39d968d029fce, 0x95708ccedd5c0445, 0xea1e7c06ed698d3c,
+  0xa2cf882d2576a038, 0xdda178e515432941, 0x5c1269bd451db2ca, 0x237c997575283bb3,
+  0xcdb181ead523e8c2, 0xb2df7122e51661bb, 0x336c607ab548fa30, 0x4c0290b2857d7349,
+  0x04d364994d625e4d, 0x7bbd94517d57d734, 0xfa0e85092d094cbf, 0x856075c11d3cc5c6,
+  0x134d926535897936, 0x6c2362ad05bcf04f, 0xed9073f555e26bc4, 0x92fe833d65d7e2bd,
+  0xda2f7716adc8cfb9, 0xa54187de9dfd46c0, 0x24f29686cda3dd4b, 0x5b9c664efd965432,
+  0xb5517ed15d9d8743, 0xca3f8e196da80e3a, 0x4b8c9f413df695b1, 0x34e26f890dc31cc8,
+  0x7c339ba2c5dc31cc, 0x035d6b6af5e9b8b5, 0x82ee7a32a5b7233e, 0xfd808afa9582aa47,
+  0x4d364994d625e4da, 0x3258b95ce6106da3, 0xb3eba804b64ef628, 0xcc8558cc867b7f51,
+  0x8454ace74e645255, 0xfb3a5c2f7e51db2c, 0x7a894d772e0f40a7, 0x05e7bdbf1e3ac9de,
+  0xeb2aa520be311aaf, 0x944455e88e0493d6, 0x15f744b0de5a085d, 0x6a99b478ee6f8124,
+  0x224840532670ac20, 0x5d26b09b16452559, 0xdc95a1c3461bbed2, 0xa3fb510b762e37ab,
+  0x35d6b6af5e9b8b5b, 0x4ab846676eae0222, 0xcb0b573f3ef099a9, 0xb465a7f70ec510d0,
+  0xfcb453dcc6da3dd4, 0x83daa314f6efb4ad, 0x0269b24ca6b12f26, 0x7d0742849684a65f,
+  0x93ca5a1b368f752e, 0xeca4aad306bafc57, 0x6d17bb8b56e467dc, 0x12794b4366d1eea5,
+  0x5aa8bf68aecec3a1, 0x25c64fa09efb4ad8, 0xa4755ef8cea5d153, 0xdb1bae30fe90582a,
+  0xbcf7b7e3c7593bd8, 0xc399472bf76cb2a1, 0x422a5673a732292a, 0x3d44a6bb9707a053,
+  0x759552905f188d57, 0x0afba2586f2d042e, 0x8b48b3003f739fa5, 0xf42643c80f4616dc,
+  0x1aeb5b57af4dc5ad, 0x6585ab9f9f784cd4, 0xe436bac7cf26d75f, 0x9b584a0fff135e26,
+  0xd389be24370c7322, 0xace74eec0739fa5b, 0x2d545fb4576761d0, 0x523aaf7c6752e8a9,
+  0xc41748d84fe75459, 0xbb79b8107fd2dd20, 0x3acaa9482f8c46ab, 0x45a459801fb9cfd2,
+  0x0d75adabd7a6e2d6, 0x721b5d63e7936baf, 0xf3a84c3bb7cdf024, 0x8cc6bcf387f8795d,
+  0x620ba46c27f3aa2c, 0x1d6554a417c62355, 0x9cd645fc4798b8de, 0xe3b8b53477ad31a7,
+  0xab69411fbfb21ca3, 0xd407b1d78f8795da, 0x55b4a08fdfd90e51, 0x2ada5047efec8728,
+};
+
+static uint64_t _az_crc64_update_bytes(uint64_t crc, uint8_t const* data, int32_t size)
+{
+  for (int32_t i = 0; i < size; i++)
+  {
+    crc = _az_crc64_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(_az_SIMD_KERNEL_CLMUL_X86) || defined(_az_SIMD_KERNEL_CLMUL_ARMV8)
+
+#if defined(_az_SIMD_KERNEL_CLMUL_X86)
+
+#define _az_CRC64_TARGET _az_SIMD_TARGET("pclmul,sse4.1")
+
+typedef __m128i _az_crc64_block;
+
+#define _az_crc64_make(low, high) _mm_set_epi64x((int64_t)(high), (int64_t)(low))
+#define _az_crc64_load(data) _mm_loadu_si128((__m128i const*)(void const*)(data))
+#define _az_crc64_store(data, block) _mm_storeu_si128((__m128i*)(void*)(data), (block))
+#define _az_crc64_xor(a, b) _mm_xor_si128((a), (b))
+
+// Multiplies the low half of the block by the low constant, and the high half by the high one.
+static _az_CRC64_TARGET _az_crc64_block
+_az_crc64_multiply(_az_crc64_block block, _az_crc64_block constants)
+{
+  return _mm_xor_si128(
+      _mm_clmulepi64_si128(block, constants, 0x00), _mm_clmulepi64_si128(block, constants, 0x11));
+}
+
+#else // _az_SIMD_KERNEL_CLMUL_ARMV8
+
+// PMULL comes with the AES instructions.
+#define _az_CRC64_TARGET _az_SIMD_TARGET_ARMV8("aes")
+
+typedef uint64x2_t _az_crc64_block;
+
+#define _az_crc64_make(low, high) vcombine_u64(vcreate_u64(low), vcreate_u64(high))
+#define _az_crc64_load(data) vreinterpretq_u64_u8(vld1q_u8(data))
+#define _az_crc64_store(data, block) vst1q_u8((data), vreinterpretq_u8_u64(block))
+#define _az_crc64_xor(a, b) veorq_u64((a), (b))
+
+// Multiplies the low half of the block by the low constant, and the high half by the high one.
+static _az_CRC64_TARGET _az_crc64_block
+_az_crc64_multiply(_az_crc64_block block, _az_crc64_block constants)
+{
+  poly128_t const low
+      = vmull_p64((poly64_t)vgetq_lane_u64(block, 0), (poly64_t)vgetq_lane_u64(constants, 0));
+  poly128_t const high
+      = vmull_p64((poly64_t)vgetq_lane_u64(block, 1), (poly64_t)vgetq_lane_u64(constants, 1));
+  return veorq_u64(vreinterpretq_u64_p128(low), vreinterpretq_u64_p128(high));
+}
+
+#endif // _az_SIMD_KERNEL_CLMUL_X86
+
+/**
+ * @brief Updates \p crc with at least 16 bytes, folding them 16 at a time with carry-less
+ * multiplications, and four blocks in parallel while there are enough of them.
+ *
+ * @details Folding a block over the next one multiplies each of its halves by the remainder of
+ * x^(d + 63) and x^(d - 1), bit-reflected, where d is the distance folded, in bits. The last block
+ * then has the same remainder as all of the data, so updating a zero CRC with its bytes gives the
+ * CRC of the data.
+ */
+static _az_CRC64_TARGET uint64_t
+_az_crc64_update_vector(uint64_t crc, uint8_t const* data, int32_t size)
+{
+  _az_crc64_block const fold_128 = _az_crc64_make(0xeadc41fd2ba3d420ULL, 0x21e9761e252621acULL);
+
+  // The CRC so far is added to the first 8 bytes, as the byte at a time update does.
+  _az_crc64_block block = _az_crc64_xor(_az_crc64_load(data), _az_crc64_make(crc, 0));
+  int32_t offset = 16;
+
+  if (size >= 128)
+  {
+    _az_crc64_block const fold_512
+        = _az_crc64_make(0x0c32cdb31e18a84aULL, 0x62242240ace5045aULL);
+
+    _az_crc64_block blocks[4] = {
+      block,
+      _az_crc64_load(data + 16),
+      _az_crc64_load(data + 32),
+      _az_crc64_load(data + 48),
+    };
+    for (offset = 64; size - offset >= 64; offset += 64)
+    {
+      for (int32_t i = 0; i < 4; i++)
+      {
+        blocks[i] = _az_crc64_xor(
+            _az_crc64_multiply(blocks[i], fold_512), _az_crc64_load(data + offset + (i * 16)));
+      }
+    }
+
+    block = blocks[0];
+    for (int32_t i = 1; i < 4; i++)
+    {
+      block = _az_crc64_xor(_az_crc64_multiply(block, fold_128), blocks[i]);
+    }
+  }
+
+  for (; size - offset >= 16; offset += 16)
+  {
+    block = _az_crc64_xor(_az_crc64_multiply(block, fold_128), _az_crc64_load(data + offset));
+  }
+
+  uint8_t last_block[16];
+  _az_crc64_store(last_block, block);
+  crc = _az_crc64_update_bytes(0, last_block, (int32_t)sizeof(last_block));
+
+  return _az_crc64_update_bytes(crc, data + offset, size - offset);
+}
+
+#if defined(_az_SIMD_KERNEL_CLMUL_X86)
+
+_az_CRC64_TARGET AZ_NODISCARD uint64_t
+_az_crc64_update_clmul_x86(uint64_t crc, uint8_t const* data, int32_t size)
+{
+  return _az_crc64_update_vector(crc, data, size);
+}
+
+#else // _az_SIMD_KERNEL_CLMUL_ARMV8
+
+_az_CRC64_TARGET AZ_NODISCARD uint64_t
+_az_crc64_update_clmul_armv8(uint64_t crc, uint8_t const* data, int32_t size)
+{
+  return _az_crc64_update_vector(crc, data, size);
+}
+
+#endif // _az_SIMD_KERNEL_CLMUL_X86
+
+#endif // _az_SIMD_KERNEL_CLMUL_X86 || _az_SIMD_KERNEL_CLMUL_ARMV8
+
+AZ_NODISCARD uint64_t az_crypto_crc64(az_span source, uint64_t crc)
+{
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+
+  uint8_t const* const data = az_span_ptr(source);
+  int32_t const size = az_span_size(source);
+
+  crc = ~crc;
+#ifdef _az_SIMD
+  // The carry-less multiplications of the host fold blocks of 16 bytes, when it has them.
+  _az_simd_crc64_fn const update = _az_simd_get_kernels()->crc64_update;
+  if (update != NULL && size >= 16)
+  {
+    return ~update(crc, data, size);
+  }
+#endif // _az_SIMD
+
+  return ~_az_crc64_update_bytes(crc, data, size);
+}
+
+static uint8_t const _az_base64_alphabet[64]
+    = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+        'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+        'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+        'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/' };
+
+// The URL and filename safe alphabet only differs in its last two characters.
+static uint8_t const _az_base64_url_alphabet[64]
+    = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+        'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+        'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+        'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '_' };
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") AZ_NODISCARD int32_t _az_base64_encode_avx2(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+  int32_t consumed = 0;
+
+  // Each iteration reads 16 bytes but only encodes the first 12 of them, so stop early enough not
+  // to read past the end of the source.
+  __m128i const shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  // The offsets from each range of 6-bit values to their ASCII character, indexed by range.
+  __m128i const offsets = _mm_setr_epi8(
+      'a' - 26,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      (char)(alphabet[62] - 62),
+      (char)(alphabet[63] - 63),
+      'A',
+      0,
+      0);
+
+  while (size - consumed >= 16)
+  {
+    __m128i const input
+        = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)(source + consumed)), shuffle);
+
+    // Spread each group of three bytes into four bytes holding six bits each.
+    __m128i const high = _mm_mulhi_epu16(
+        _mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    __m128i const low = _mm_mullo_epi16(
+        _mm_and_si128(input, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    __m128i const indices = _mm_or_si128(high, low);
+
+    // Map 0..25 to range 13, 26..51 to range 0, and 52..63 to ranges 1..12.
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_or_si128(
+        range,
+        _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+
+    _mm_storeu_si128(
+        (__m128i*)destination,
+        _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range)));
+
+    consumed += 12;
+    destination += 16;
+  }
+
+  return consumed;
+}
+
+#endif // _az_SIMD_KERNEL_AVX2
+
+#if defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+
+AZ_NODISCARD int32_t _az_base64_encode_neon(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+  int32_t consumed = 0;
+
+  uint8x16x4_t alphabet_table;
+  alphabet_table.val[0] = vld1q_u8(alphabet);
+  alphabet_table.val[1] = vld1q_u8(alphabet + 16);
+  alphabet_table.val[2] = vld1q_u8(alphabet + 32);
+  alphabet_table.val[3] = vld1q_u8(alphabet + 48);
+  uint8x16_t const six_bits = vdupq_n_u8(0x3F);
+
+  while (size - consumed >= 48)
+  {
+    // Deinterleave 16 groups of three bytes, and interleave the four characters of each back.
+    uint8x16x3_t const input = vld3q_u8(source + consumed);
+    uint8x16x4_t indices;
+    indices.val[0] = vshrq_n_u8(input.val[0], 2);
+    indices.val[1] = vandq_u8(
+        vorrq_u8(vshlq_n_u8(input.val[0], 4), vshrq_n_u8(input.val[1], 4)), six_bits);
+    indices.val[2] = vandq_u8(
+        vorrq_u8(vshlq_n_u8(input.val[1], 2), vshrq_n_u8(input.val[2], 6)), six_bits);
+    indices.val[3] = vandq_u8(input.val[2], six_bits);
+
+    uint8x16x4_t output;
+    for (int32_t i = 0; i < 4; i++)
+    {
+      output.val[i] = vqtbl4q_u8(alphabet_table, indices.val[i]);
+    }
+    vst4q_u8(destination, output);
+
+    consumed += 48;
+    destination += 64;
+  }
+
+  return consumed;
+}
+
+#endif // defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+
+// Encodes as many whole groups of three bytes as the kernel of the host can, and returns the number
+// of source bytes it consumed.
+static int32_t _az_base64_encode_vector(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+#ifdef _az_SIMD
+  _az_simd_base64_fn const encode = _az_simd_get_kernels()->base64_encode;
+  if (encode != NULL)
+  {
+    return encode(destination, source, size, alphabet);
+  }
+#endif // _az_SIMD
+
+  (void)destination;
+  (void)source;
+  (void)size;
+  (void)alphabet;
+  return 0;
+}
+
+// Encodes the whole groups of three bytes of the source, and returns the number of source bytes it
+// consumed.
+static int32_t _az_base64_encode_groups(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+  int32_t consumed = _az_base64_encode_vector(destination, source, size, alphabet);
+  uint8_t* output = destination + ((consumed / 3) * 4);
+
+  for (; size - consumed >= 3; consumed += 3)
+  {
+    uint32_t const group = ((uint32_t)source[consumed] << 16)
+        | ((uint32_t)source[consumed + 1] << 8) | (uint32_t)source[consumed + 2];
+    *output++ = alphabet[(group >> 18) & 0x3F];
+    *output++ = alphabet[(group >> 12) & 0x3F];
+    *output++ = alphabet[(group >> 6) & 0x3F];
+    *output++ = alphabet[group & 0x3F];
+  }
+
+  return consumed;
+}
+
+// Encodes the last one or two bytes of the source, as the two or three characters which carry
+// their bits, and returns the number of characters written.
+static int32_t _az_base64_encode_tail(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t remaining,
+    uint8_t const* alphabet)
+{
+  uint32_t group = (uint32_t)source[0] << 16;
+  if (remaining == 2)
+  {
+    group |= (uint32_t)source[1] << 8;
+  }
+  destination[0] = alphabet[(group >> 18) & 0x3F];
+  destination[1] = alphabet[(group >> 12) & 0x3F];
+  if (remaining == 2)
+  {
+    destination[2] = alphabet[(group >> 6) & 0x3F];
+  }
+
+  return remaining + 1;
+}
+
+AZ_NODISCARD az_result
+az_base64_encode(az_span destination, az_span source, int32_t* out_written)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_written);
+
+  int32_t const source_size = az_span_size(source);
+  int32_t const encoded_size = az_base64_get_encoded_size(source_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, encoded_size);
+
+  uint8_t const* input = az_span_ptr(source);
+  uint8_t* output = az_span_ptr(destination);
+
+  int32_t const consumed
+      = _az_base64_encode_groups(output, input, source_size, _az_base64_alphabet);
+  output += (consumed / 3) * 4;
+
+  int32_t const remaining = source_size - consumed;
+  if (remaining > 0)
+  {
+    output += _az_base64_encode_tail(output, input + consumed, remaining, _az_base64_alphabet);
+    for (int32_t i = remaining; i < 3; i++)
+    {
+      *output++ = '=';
+    }
+  }
+
+  *out_written = encoded_size;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_base64_url_encode(az_span destination, az_span source, int32_t* out_written)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_written);
+
+  int32_t const source_size = az_span_size(source);
+  int32_t const encoded_size = az_base64_url_get_encoded_size(source_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, encoded_size);
+
+  uint8_t const* input = az_span_ptr(source);
+  uint8_t* output = az_span_ptr(destination);
+
+  int32_t const consumed
+      = _az_base64_encode_groups(output, input, source_size, _az_base64_url_alphabet);
+  if (source_size - consumed > 0)
+  {
+    int32_t const written = _az_base64_encode_tail(
+        output + ((consumed / 3) * 4),
+        input + consumed,
+        source_size - consumed,
+        _az_base64_url_alphabet);
+    (void)written;
+  }
+
+  *out_written = encoded_size;
+  return AZ_OK;
+}
+
+// Returns the 6-bit value of a character of the alphabet, or -1 if it isn't part of it.
+AZ_INLINE int32_t _az_base64_decode_char(uint8_t c, uint8_t const* alphabet)
+{
+  if (c >= 'A' && c <= 'Z')
+  {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z')
+  {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0' + 52;
+  }
+  if (c == alphabet[62])
+  {
+    return 62;
+  }
+  if (c == alphabet[63])
+  {
+    return 63;
+  }
+  return -1;
+}
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") AZ_NODISCARD int32_t _az_base64_decode_avx2(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+  int32_t consumed = 0;
+
+  // Bit masks of the character classes each low and high nibble can be part of: a character is
+  // valid when the masks of its two nibbles have no bit in common.
+  __m128i const valid_low = _mm_setr_epi8(
+      0x15,
+      0x11,
+      0x11,
+      0x11,
+      0x11,
+      0x11,
+      0x11,
+      0x11,
+      0x11,
+      0x11,
+      0x13,
+      0x1A,
+      0x1B,
+      0x1B,
+      0x1B,
+      0x1A);
+  __m128i const valid_high = _mm_setr_epi8(
+      0x10,
+      0x10,
+      0x01,
+      0x02,
+      0x04,
+      0x08,
+      0x04,
+      0x08,
+      0x10,
+      0x10,
+      0x10,
+      0x10,
+      0x10,
+      0x10,
+      0x10,
+      0x10);
+  // The offsets from each character to its 6-bit value, indexed by high nibble, with `/` at 1.
+  __m128i const offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i const pack_shuffle
+      = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  bool const is_url = alphabet[62] == '-';
+
+  // Each iteration writes 16 bytes but only decodes 12 of them, so stop early enough not to write
+  // past the end of the decoded bytes.
+  while (size - consumed >= 24)
+  {
+    __m128i input = _mm_loadu_si128((__m128i const*)(source + consumed));
+    int invalid = 0;
+    if (is_url)
+    {
+      // Swap `-` and `_` for `+` and `/`, which are not part of this alphabet.
+      __m128i const is_minus = _mm_cmpeq_epi8(input, _mm_set1_epi8('-'));
+      __m128i const is_underscore = _mm_cmpeq_epi8(input, _mm_set1_epi8('_'));
+      invalid = _mm_movemask_epi8(_mm_or_si128(
+          _mm_cmpeq_epi8(input, _mm_set1_epi8('+')), _mm_cmpeq_epi8(input, _mm_set1_epi8('/'))));
+      input = _mm_xor_si128(input, _mm_and_si128(is_minus, _mm_set1_epi8('-' ^ '+')));
+      input = _mm_xor_si128(input, _mm_and_si128(is_underscore, _mm_set1_epi8('_' ^ '/')));
+    }
+
+    __m128i const high_nibbles = _mm_and_si128(_mm_srli_epi32(input, 4), _mm_set1_epi8(0x0F));
+    __m128i const low_nibbles = _mm_and_si128(input, _mm_set1_epi8(0x0F));
+    __m128i const classes = _mm_and_si128(
+        _mm_shuffle_epi8(valid_low, low_nibbles), _mm_shuffle_epi8(valid_high, high_nibbles));
+    invalid |= _mm_movemask_epi8(_mm_cmpgt_epi8(classes, _mm_setzero_si128()));
+    if (invalid != 0)
+    {
+      break;
+    }
+
+    __m128i const is_slash = _mm_cmpeq_epi8(input, _mm_set1_epi8('/'));
+    __m128i const values = _mm_add_epi8(
+        input, _mm_shuffle_epi8(offsets, _mm_add_epi8(is_slash, high_nibbles)));
+
+    // Merge each four 6-bit values into three bytes, and pack those together.
+    __m128i const pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i const groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128((__m128i*)destination, _mm_shuffle_epi8(groups, pack_shuffle));
+
+    consumed += 16;
+    destination += 12;
+  }
+
+  return consumed;
+}
+
+#endif // _az_SIMD_KERNEL_AVX2
+
+#if defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+
+AZ_NODISCARD int32_t _az_base64_decode_neon(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+  int32_t consumed = 0;
+
+  if (size < 64)
+  {
+    return 0;
+  }
+
+  // The 6-bit value of each ASCII character, or 0xFF if it isn't part of the alphabet.
+  uint8_t values_table[128];
+  for (int32_t i = 0; i < 128; i++)
+  {
+    values_table[i] = 0xFF;
+  }
+  for (int32_t i = 0; i < 64; i++)
+  {
+    values_table[alphabet[i]] = (uint8_t)i;
+  }
+
+  uint8x16x4_t low_table;
+  uint8x16x4_t high_table;
+  for (int32_t i = 0; i < 4; i++)
+  {
+    low_table.val[i] = vld1q_u8(values_table + (i * 16));
+    high_table.val[i] = vld1q_u8(values_table + 64 + (i * 16));
+  }
+
+  while (size - consumed >= 64)
+  {
+    // Deinterleave 16 groups of four characters, and interleave the three bytes of each back.
+    uint8x16x4_t const input = vld4q_u8(source + consumed);
+    uint8x16x4_t values;
+    uint8x16_t invalid = vdupq_n_u8(0);
+    for (int32_t i = 0; i < 4; i++)
+    {
+      // Characters from 128 up are outside of both tables, so they are marked separately.
+      uint8x16_t const value = vqtbx4q_u8(
+          vqtbl4q_u8(low_table, input.val[i]),
+          high_table,
+          vsubq_u8(input.val[i], vdupq_n_u8(64)));
+      values.val[i] = vorrq_u8(value, vcgeq_u8(input.val[i], vdupq_n_u8(128)));
+      invalid = vorrq_u8(invalid, values.val[i]);
+    }
+    if (vmaxvq_u8(invalid) >= 64)
+    {
+      break;
+    }
+
+    uint8x16x3_t output;
+    output.val[0] = vorrq_u8(vshlq_n_u8(values.val[0], 2), vshrq_n_u8(values.val[1], 4));
+    output.val[1] = vorrq_u8(vshlq_n_u8(values.val[1], 4), vshrq_n_u8(values.val[2], 2));
+    output.val[2] = vorrq_u8(vshlq_n_u8(values.val[2], 6), values.val[3]);
+    vst3q_u8(destination, output);
+
+    consumed += 64;
+    destination += 48;
+  }
+
+  return consumed;
+}
+
+#endif // defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+
+// Decodes as many whole groups of four characters as the kernel of the host can, and returns the
+// number of source characters it consumed. It stops at the first block holding any character
+// outside of the alphabet, padding included, and leaves it to the scalar code to report.
+static int32_t _az_base64_decode_vector(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+#ifdef _az_SIMD
+  _az_simd_base64_fn const decode = _az_simd_get_kernels()->base64_decode;
+  if (decode != NULL)
+  {
+    return decode(destination, source, size, alphabet);
+  }
+#endif // _az_SIMD
+
+  (void)destination;
+  (void)source;
+  (void)size;
+  (void)alphabet;
+  return 0;
+}
+
+// Decodes the whole groups of four characters of the source, which is a multiple of 4 characters
+// without padding.
+static AZ_NODISCARD az_result _az_base64_decode_groups(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet)
+{
+  int32_t const consumed = _az_base64_decode_vector(destination, source, size, alphabet);
+  uint8_t* output = destination + ((consumed / 4) * 3);
+
+  for (int32_t i = consumed; i < size; i += 4)
+  {
+    int32_t const c0 = _az_base64_decode_char(source[i], alphabet);
+    int32_t const c1 = _az_base64_decode_char(source[i + 1], alphabet);
+    int32_t const c2 = _az_base64_decode_char(source[i + 2], alphabet);
+    int32_t const c3 = _az_base64_decode_char(source[i + 3], alphabet);
+    if ((c0 | c1 | c2 | c3) < 0)
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
+    uint32_t const group = ((uint32_t)c0 << 18) | ((uint32_t)c1 << 12) | ((uint32_t)c2 << 6)
+        | (uint32_t)c3;
+    *output++ = (uint8_t)(group >> 16);
+    *output++ = (uint8_t)(group >> 8);
+    *output++ = (uint8_t)group;
+  }
+
+  return AZ_OK;
+}
+
+// Decodes the two or three characters which end the source, into one or two bytes.
+static AZ_NODISCARD az_result _az_base64_decode_tail(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t remaining,
+    uint8_t const* alphabet)
+{
+  int32_t const c0 = _az_base64_decode_char(source[0], alphabet);
+  int32_t const c1 = _az_base64_decode_char(source[1], alphabet);
+  int32_t const c2 = remaining == 3 ? _az_base64_decode_char(source[2], alphabet) : 0;
+  if ((c0 | c1 | c2) < 0)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  uint32_t const group = ((uint32_t)c0 << 18) | ((uint32_t)c1 << 12) | ((uint32_t)c2 << 6);
+  destination[0] = (uint8_t)(group >> 16);
+  if (remaining == 3)
+  {
+    destination[1] = (uint8_t)(group >> 8);
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD int32_t az_base64_get_decoded_size(az_span source)
+{
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+
+  int32_t const source_size = az_span_size(source);
+  uint8_t const* input = az_span_ptr(source);
+
+  int32_t decoded_size = az_base64_get_max_decoded_size(source_size);
+  if (source_size >= 4 && input[source_size - 1] == '=')
+  {
+    decoded_size -= input[source_size - 2] == '=' ? 2 : 1;
+  }
+
+  return decoded_size;
+}
+
+AZ_NODISCARD az_result
+az_base64_decode(az_span destination, az_span source, int32_t* out_written)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_written);
+
+  int32_t const source_size = az_span_size(source);
+  if (source_size % 4 != 0)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  int32_t const decoded_size = az_base64_get_decoded_size(source);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, decoded_size);
+
+  // Padding may only replace the last one or two characters of the last group, which is then
+  // decoded on its own.
+  uint8_t const* input = az_span_ptr(source);
+  uint8_t* output = az_span_ptr(destination);
+  int32_t const padding = az_base64_get_max_decoded_size(source_size) - decoded_size;
+  int32_t const groups_size = padding == 0 ? source_size : source_size - 4;
+  _az_RETURN_IF_FAILED(_az_base64_decode_groups(output, input, groups_size, _az_base64_alphabet));
+  if (padding > 0)
+  {
+    _az_RETURN_IF_FAILED(_az_base64_decode_tail(
+        output + ((groups_size / 4) * 3), input + groups_size, 4 - padding, _az_base64_alphabet));
+  }
+
+  *out_written = decoded_size;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_base64_url_decode(az_span destination, az_span source, int32_t* out_written)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_written);
+
+  int32_t const source_size = az_span_size(source);
+  int32_t const remaining = source_size % 4;
+  if (remaining == 1)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  int32_t const decoded_size = az_base64_url_get_decoded_size(source_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, decoded_size);
+
+  uint8_t const* input = az_span_ptr(source);
+  uint8_t* output = az_span_ptr(destination);
+  int32_t const groups_size = source_size - remaining;
+  _az_RETURN_IF_FAILED(
+      _az_base64_decode_groups(output, input, groups_size, _az_base64_url_alphabet));
+  if (remaining > 0)
+  {
+    _az_RETURN_IF_FAILED(_az_base64_decode_tail(
+        output + ((groups_size / 4) * 3),
+        input + groups_size,
+        remaining,
+        _az_base64_url_alphabet));
+  }
+
+  *out_written = decoded_size;
+  return AZ_OK;
+}
+
+#if defined(_az_SIMD_AVX2) || defined(_az_SIMD_SSE2)
+// Converts 16 hex digits into their values, and sets the bits of those which aren't in `invalid`.
+AZ_INLINE __m128i _az_hex_decode_digits(__m128i digits, int* invalid)
+{
+  __m128i const decimal = _mm_sub_epi8(digits, _mm_set1_epi8('0'));
+  __m128i const letter
+      = _mm_sub_epi8(_mm_or_si128(digits, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i const is_decimal = _mm_cmpeq_epi8(_mm_min_epu8(decimal, _mm_set1_epi8(9)), decimal);
+  __m128i const is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+  *invalid |= _mm_movemask_epi8(_mm_or_si128(is_decimal, is_letter)) ^ 0xFFFF;
+  return _mm_or_si128(
+      _mm_and_si128(is_decimal, decimal),
+      _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+#elif defined(_az_SIMD_NEON)
+// Converts 16 hex digits into their values, and clears the lanes of `valid` of those which aren't.
+AZ_INLINE uint8x16_t _az_hex_decode_digits(uint8x16_t digits, uint8x16_t* valid)
+{
+  uint8x16_t const decimal = vsubq_u8(digits, vdupq_n_u8('0'));
+  uint8x16_t const letter = vsubq_u8(vorrq_u8(digits, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  uint8x16_t const is_decimal = vcleq_u8(decimal, vdupq_n_u8(9));
+
+  *valid = vandq_u8(*valid, vorrq_u8(is_decimal, vcleq_u8(letter, vdupq_n_u8(5))));
+  return vbslq_u8(is_decimal, decimal, vaddq_u8(letter, vdupq_n_u8(10)));
+}
+#endif // _az_SIMD_AVX2
+
+// Encodes as many bytes as the vector code can, 16 at a time, and returns the number it consumed.
+static int32_t _az_hex_encode_vector(uint8_t* destination, uint8_t const* source, int32_t size)
+{
+  int32_t consumed = 0;
+
+#if defined(_az_SIMD_AVX2) || defined(_az_SIMD_SSE2)
+  __m128i const nibble_mask = _mm_set1_epi8(0x0F);
+  for (; size - consumed >= 16; consumed += 16, destination += 32)
+  {
+    __m128i const input = _mm_loadu_si128((__m128i const*)(source + consumed));
+    __m128i const nibbles[2] = {
+      _mm_and_si128(_mm_srli_epi16(input, 4), nibble_mask),
+      _mm_and_si128(input, nibble_mask),
+    };
+
+    // Add '0' to each nibble, and the distance from '9' + 1 to 'a' to those above 9.
+    __m128i digits[2];
+    for (int32_t i = 0; i < 2; i++)
+    {
+      digits[i] = _mm_add_epi8(
+          _mm_add_epi8(nibbles[i], _mm_set1_epi8('0')),
+          _mm_and_si128(
+              _mm_cmpgt_epi8(nibbles[i], _mm_set1_epi8(9)), _mm_set1_epi8('a' - '9' - 1)));
+    }
+
+    _mm_storeu_si128((__m128i*)destination, _mm_unpacklo_epi8(digits[0], digits[1]));
+    _mm_storeu_si128((__m128i*)(destination + 16), _mm_unpackhi_epi8(digits[0], digits[1]));
+  }
+#elif defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+  uint8x16_t const digits_table = vld1q_u8((uint8_t const*)"0123456789abcdef");
+  for (; size - consumed >= 16; consumed += 16, destination += 32)
+  {
+    uint8x16_t const input = vld1q_u8(source + consumed);
+    uint8x16x2_t output;
+    output.val[0] = vqtbl1q_u8(digits_table, vshrq_n_u8(input, 4));
+    output.val[1] = vqtbl1q_u8(digits_table, vandq_u8(input, vdupq_n_u8(0x0F)));
+    vst2q_u8(destination, output);
+  }
+#else
+  (void)destination;
+  (void)source;
+  (void)size;
+#endif // _az_SIMD_AVX2
+
+  return consumed;
+}
+
+// Decodes as many pairs of hex digits as the vector code can, 16 at a time, and returns the number
+// of source characters it consumed. It stops at the first block holding a character which isn't a
+// hex digit, and leaves it to the scalar code to report.
+static int32_t _az_hex_decode_vector(uint8_t* destination, uint8_t const* source, int32_t size)
+{
+  int32_t consumed = 0;
+
+#if defined(_az_SIMD_AVX2) || defined(_az_SIMD_SSE2)
+  for (; size - consumed >= 32; consumed += 32, destination += 16)
+  {
+    int invalid = 0;
+    __m128i const values[2] = {
+      _az_hex_decode_digits(_mm_loadu_si128((__m128i const*)(source + consumed)), &invalid),
+      _az_hex_decode_digits(_mm_loadu_si128((__m128i const*)(source + consumed + 16)), &invalid),
+    };
+    if (invalid != 0)
+    {
+      break;
+    }
+
+    // Each 16-bit lane holds the value of the high digit in its low byte, and the low digit in its
+    // high byte.
+    __m128i bytes[2];
+    for (int32_t i = 0; i < 2; i++)
+    {
+      bytes[i] = _mm_or_si128(
+          _mm_slli_epi16(_mm_and_si128(values[i], _mm_set1_epi16(0x00FF)), 4),
+          _mm_srli_epi16(values[i], 8));
+    }
+    _mm_storeu_si128((__m128i*)destination, _mm_packus_epi16(bytes[0], bytes[1]));
+  }
+#elif defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+  for (; size - consumed >= 32; consumed += 32, destination += 16)
+  {
+    // Deinterleave the high digits from the low ones.
+    uint8x16x2_t const input = vld2q_u8(source + consumed);
+    uint8x16_t valid = vdupq_n_u8(0xFF);
+    uint8x16_t const high = _az_hex_decode_digits(input.val[0], &valid);
+    uint8x16_t const low = _az_hex_decode_digits(input.val[1], &valid);
+    if (vminvq_u8(valid) == 0)
+    {
+      break;
+    }
+
+    vst1q_u8(destination, vorrq_u8(vshlq_n_u8(high, 4), low));
+  }
+#else
+  (void)destination;
+  (void)source;
+  (void)size;
+#endif // _az_SIMD_AVX2
+
+  return consumed;
+}
+
+// Returns the value of a hex digit, or -1 if it isn't one.
+AZ_INLINE int32_t _az_hex_decode_digit(uint8_t c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+
+  uint8_t const lowercase = (uint8_t)(c | 0x20);
+  if (lowercase >= 'a' && lowercase <= 'f')
+  {
+    return lowercase - 'a' + 10;
+  }
+  return -1;
+}
+
+AZ_NODISCARD az_result az_hex_encode(az_span destination, az_span source, int32_t* out_written)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_written);
+
+  int32_t const source_size = az_span_size(source);
+  int32_t const encoded_size = az_hex_get_encoded_size(source_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, encoded_size);
+
+  uint8_t const* input = az_span_ptr(source);
+  uint8_t* output = az_span_ptr(destination);
+
+  int32_t i = _az_hex_encode_vector(output, input, source_size);
+  output += i * 2;
+  for (; i < source_size; i++)
+  {
+    *output++ = _az_number_to_lower_hex((uint8_t)(input[i] >> 4));
+    *output++ = _az_number_to_lower_hex((uint8_t)(input[i] & 0x0F));
+  }
+
+  *out_written = encoded_size;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_hex_decode(az_span destination, az_span source, int32_t* out_written)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_written);
+
+  int32_t const source_size = az_span_size(source);
+  if (source_size % 2 != 0)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  int32_t const decoded_size = az_hex_get_decoded_size(source_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, decoded_size);
+
+  uint8_t const* input = az_span_ptr(source);
+  uint8_t* output = az_span_ptr(destination);
+
+  int32_t i = _az_hex_decode_vector(output, input, source_size);
+  output += i / 2;
+  for (; i < source_size; i += 2)
+  {
+    int32_t const high = _az_hex_decode_digit(input[i]);
+    int32_t const low = _az_hex_decode_digit(input[i + 1]);
+    if ((high | low) < 0)
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+    *output++ = (uint8_t)((high << 4) | low);
+  }
+
+  *out_written = decoded_size;
+  return AZ_OK;
+}
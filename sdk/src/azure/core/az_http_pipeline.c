@@ -4,6 +4,7 @@
 #include <azure/core/az_http.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -16,9 +17,10 @@ AZ_NODISCARD az_result az_http_pipeline_process(
   _az_PRECONDITION_NOT_NULL(ref_response);
   _az_PRECONDITION_NOT_NULL(ref_pipeline);
 
-  return ref_pipeline->_internal.policies[0]._internal.process(
-      &(ref_pipeline->_internal.policies[1]),
-      ref_pipeline->_internal.policies[0]._internal.options,
-      ref_request,
-      ref_response);
+  _az_TRACEPOINT1(http_pipeline_entry, ref_request);
+  az_result const result = _az_http_pipeline_nextpolicy_expecting(
+      ref_pipeline->_internal.policies, _az_HTTP_PIPELINE_FIRST_POLICY, ref_request, ref_response);
+  _az_TRACEPOINT2(http_pipeline_exit, ref_request, result);
+
+  return result;
 }
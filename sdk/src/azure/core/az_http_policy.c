@@ -7,6 +7,7 @@
 #include <azure/core/az_span.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_result_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -39,7 +40,8 @@ AZ_NODISCARD az_result az_http_pipeline_policy_apiversion(
       return AZ_ERROR_ARG;
   }
 
-  return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+  return _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_APIVERSION, ref_request, ref_response);
 }
 
 AZ_NODISCARD az_result az_http_pipeline_policy_telemetry(
@@ -54,7 +56,8 @@ AZ_NODISCARD az_result az_http_pipeline_policy_telemetry(
   _az_RETURN_IF_FAILED(
       az_http_request_append_header(ref_request, AZ_HTTP_HEADER_USER_AGENT, options->os));
 
-  return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+  return _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_TELEMETRY, ref_request, ref_response);
 }
 
 AZ_NODISCARD az_result az_http_pipeline_policy_credential(
@@ -69,7 +72,8 @@ AZ_NODISCARD az_result az_http_pipeline_policy_credential(
 
   if (credential == AZ_CREDENTIAL_ANONYMOUS || policy_credential_apply == NULL)
   {
-    return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CREDENTIAL, ref_request, ref_response);
   }
 
   return policy_credential_apply(ref_policies, credential, ref_request, ref_response);
@@ -87,5 +91,9 @@ AZ_NODISCARD az_result az_http_pipeline_policy_transport(
   // make sure the response is resetted
   _az_http_response_reset(ref_response);
 
-  return az_http_client_send_request(ref_request, ref_response);
+  _az_TRACEPOINT1(http_transport_send, ref_request);
+  az_result const result = az_http_client_send_request(ref_request, ref_response);
+  _az_TRACEPOINT3(http_transport_receive, ref_request, result, ref_response->_internal.written);
+
+  return result;
 }
@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+// The responses which tell that the host is failing, rather than the request. Throttling responses
+// are left to the retry policy and the rate limiter.
+static az_http_status_code const _az_http_circuit_breaker_failure_status_codes[] = {
+  AZ_HTTP_STATUS_CODE_REQUEST_TIMEOUT,
+  AZ_HTTP_STATUS_CODE_INTERNAL_SERVER_ERROR,
+  AZ_HTTP_STATUS_CODE_BAD_GATEWAY,
+  AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE,
+  AZ_HTTP_STATUS_CODE_GATEWAY_TIMEOUT,
+  AZ_HTTP_STATUS_CODE_END_OF_LIST,
+};
+
+void az_http_circuit_breaker_init(
+    az_http_circuit_breaker* out_breaker,
+    az_http_circuit_breaker_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_breaker);
+
+  out_breaker->_internal.options
+      = options == NULL ? az_http_circuit_breaker_options_default() : *options;
+  _az_PRECONDITION_RANGE(1, out_breaker->_internal.options.failure_percent_threshold, 100);
+  _az_PRECONDITION(out_breaker->_internal.options.minimum_request_count > 0);
+  _az_PRECONDITION(out_breaker->_internal.options.window_msec > 0);
+  _az_PRECONDITION(out_breaker->_internal.options.break_msec >= 0);
+
+  out_breaker->_internal.lock = 0;
+  out_breaker->_internal.host_count = 0;
+}
+
+// The host, and port, of the URL.
+static az_span _az_http_circuit_breaker_get_host(az_span url)
+{
+  int32_t const scheme_end = az_span_find(url, AZ_SPAN_FROM_STR("://"));
+  az_span const host = scheme_end < 0 ? url : az_span_slice_to_end(url, scheme_end + 3);
+
+  uint8_t const* const ptr = az_span_ptr(host);
+  for (int32_t i = 0; i < az_span_size(host); i++)
+  {
+    if (ptr[i] == '/' || ptr[i] == '?' || ptr[i] == '#')
+    {
+      return az_span_slice(host, 0, i);
+    }
+  }
+
+  return host;
+}
+
+// Called with the lock held. Returns NULL once the breaker tracks as many hosts as it can.
+static _az_http_circuit_breaker_host* _az_http_circuit_breaker_find(
+    az_http_circuit_breaker* ref_breaker,
+    az_span host,
+    int64_t now_msec)
+{
+  for (int32_t i = 0; i < ref_breaker->_internal.host_count; i++)
+  {
+    _az_http_circuit_breaker_host* const entry = &ref_breaker->_internal.hosts[i];
+    if (az_span_is_content_equal(
+            az_span_create(entry->_internal.host, entry->_internal.host_size), host))
+    {
+      return entry;
+    }
+  }
+
+  if (ref_breaker->_internal.host_count == AZ_HTTP_CIRCUIT_BREAKER_MAX_HOSTS)
+  {
+    return NULL;
+  }
+
+  _az_http_circuit_breaker_host* const entry
+      = &ref_breaker->_internal.hosts[ref_breaker->_internal.host_count];
+  az_span_copy(AZ_SPAN_FROM_BUFFER(entry->_internal.host), host);
+  entry->_internal.host_size = az_span_size(host);
+  entry->_internal.window_start_msec = now_msec;
+  entry->_internal.request_count = 0;
+  entry->_internal.failure_count = 0;
+  entry->_internal.previous_request_count = 0;
+  entry->_internal.previous_failure_count = 0;
+  entry->_internal.opened_at_msec = 0;
+  entry->_internal.is_open = false;
+  entry->_internal.is_probing = false;
+  ref_breaker->_internal.host_count++;
+
+  return entry;
+}
+
+// Called with the lock held. Counts the outcome of a request in the window it completed in, and
+// opens the circuit when the failure rate over the last window_msec reaches the threshold.
+static void _az_http_circuit_breaker_record(
+    az_http_circuit_breaker_options const* options,
+    _az_http_circuit_breaker_host* entry,
+    int64_t now_msec,
+    bool is_failure)
+{
+  int64_t const window_msec = options->window_msec;
+  int64_t const elapsed_msec = now_msec - entry->_internal.window_start_msec;
+  if (elapsed_msec >= window_msec)
+  {
+    bool const is_previous = elapsed_msec < 2 * window_msec;
+    entry->_internal.previous_request_count = is_previous ? entry->_internal.request_count : 0;
+    entry->_internal.previous_failure_count = is_previous ? entry->_internal.failure_count : 0;
+    entry->_internal.request_count = 0;
+    entry->_internal.failure_count = 0;
+    entry->_internal.window_start_msec = now_msec - (elapsed_msec % window_msec);
+  }
+
+  entry->_internal.request_count++;
+  entry->_internal.failure_count += is_failure ? 1 : 0;
+
+  // The counts are scaled by window_msec, so that the part of the previous window which is still
+  // within the last window_msec is counted without a division.
+  int64_t const previous_weight = window_msec - (now_msec - entry->_internal.window_start_msec);
+  int64_t const request_count = (entry->_internal.request_count * window_msec)
+      + (entry->_internal.previous_request_count * previous_weight);
+  int64_t const failure_count = (entry->_internal.failure_count * window_msec)
+      + (entry->_internal.previous_failure_count * previous_weight);
+
+  if (request_count >= options->minimum_request_count * window_msec
+      && failure_count * 100 >= options->failure_percent_threshold * request_count)
+  {
+    entry->_internal.is_open = true;
+    entry->_internal.opened_at_msec = now_msec;
+  }
+}
+
+// Called with the lock held. Closes the circuit, with the failures which opened it forgotten.
+static void _az_http_circuit_breaker_close(_az_http_circuit_breaker_host* entry, int64_t now_msec)
+{
+  entry->_internal.is_open = false;
+  entry->_internal.window_start_msec = now_msec;
+  entry->_internal.request_count = 0;
+  entry->_internal.failure_count = 0;
+  entry->_internal.previous_request_count = 0;
+  entry->_internal.previous_failure_count = 0;
+}
+
+static bool _az_http_circuit_breaker_is_failure(az_result result, az_http_response* ref_response)
+{
+  if (az_result_failed(result))
+  {
+    // A request the caller canceled tells nothing about the host.
+    return result != AZ_ERROR_CANCELED;
+  }
+
+  // Reading the status line moves the parser of the response, so it reads that of a copy.
+  az_http_response response_copy = *ref_response;
+  az_http_response_status_line status_line = { 0 };
+  if (az_result_failed(az_http_response_get_status_line(&response_copy, &status_line)))
+  {
+    return false;
+  }
+
+  for (az_http_status_code const* status_code = _az_http_circuit_breaker_failure_status_codes;
+       *status_code != AZ_HTTP_STATUS_CODE_END_OF_LIST;
+       ++status_code)
+  {
+    if (*status_code == status_line.status_code)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_circuit_breaker(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_http_circuit_breaker* const breaker = (az_http_circuit_breaker*)ref_options;
+  az_span const host = _az_http_circuit_breaker_get_host(
+      az_span_slice(ref_request->_internal.url, 0, ref_request->_internal.url_length));
+  if (breaker == NULL || az_span_size(host) == 0
+      || az_span_size(host) > AZ_HTTP_CIRCUIT_BREAKER_MAX_HOST_SIZE)
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CIRCUIT_BREAKER, ref_request, ref_response);
+  }
+
+  int64_t now_msec = az_platform_clock_msec();
+
+  _az_atomic_spin_lock(&breaker->_internal.lock);
+  _az_http_circuit_breaker_host* const entry
+      = _az_http_circuit_breaker_find(breaker, host, now_msec);
+  if (entry == NULL)
+  {
+    _az_atomic_spin_unlock(&breaker->_internal.lock);
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CIRCUIT_BREAKER, ref_request, ref_response);
+  }
+
+  // Once the break has passed, the first request is sent as a trial, and the others still fail
+  // until it completes.
+  bool const is_probe = entry->_internal.is_open;
+  if (is_probe
+      && (entry->_internal.is_probing
+          || now_msec < entry->_internal.opened_at_msec + breaker->_internal.options.break_msec))
+  {
+    _az_atomic_spin_unlock(&breaker->_internal.lock);
+    return AZ_ERROR_HTTP_CIRCUIT_OPEN;
+  }
+
+  entry->_internal.is_probing = is_probe;
+  _az_atomic_spin_unlock(&breaker->_internal.lock);
+
+  az_result const result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CIRCUIT_BREAKER, ref_request, ref_response);
+  bool const is_failure = _az_http_circuit_breaker_is_failure(result, ref_response);
+  bool const is_canceled = result == AZ_ERROR_CANCELED;
+
+  now_msec = az_platform_clock_msec();
+
+  _az_atomic_spin_lock(&breaker->_internal.lock);
+  if (is_probe)
+  {
+    // A canceled trial lets the next request be one.
+    entry->_internal.is_probing = false;
+    if (is_failure)
+    {
+      entry->_internal.opened_at_msec = now_msec;
+    }
+    else if (!is_canceled)
+    {
+      _az_http_circuit_breaker_close(entry, now_msec);
+    }
+  }
+  else if (!is_canceled && !entry->_internal.is_open)
+  {
+    _az_http_circuit_breaker_record(&breaker->_internal.options, entry, now_msec, is_failure);
+  }
+  _az_atomic_spin_unlock(&breaker->_internal.lock);
+
+  return result;
+}
@@ -0,0 +1,205 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_private.h"
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+// How long the requests waiting for a response, and the request which waits for them to copy it,
+// wait before they check again. A wait only ends early when its context is canceled, so this
+// bounds the latency coalescing adds to the waiting requests.
+#define _az_HTTP_POLICY_COALESCING_WAIT_MSEC 1
+
+void az_http_request_coalescer_init(az_http_request_coalescer* out_coalescer)
+{
+  _az_PRECONDITION_NOT_NULL(out_coalescer);
+
+  out_coalescer->_internal.lock = 0;
+  for (int32_t i = 0; i < AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT; i++)
+  {
+    out_coalescer->_internal.flights[i]._internal.key_size = 0;
+    out_coalescer->_internal.flights[i]._internal.credential = NULL;
+    out_coalescer->_internal.flights[i]._internal.is_in_use = false;
+    out_coalescer->_internal.flights[i]._internal.is_done = false;
+    out_coalescer->_internal.flights[i]._internal.waiter_count = 0;
+    out_coalescer->_internal.flights[i]._internal.result = AZ_OK;
+    out_coalescer->_internal.flights[i]._internal.response = NULL;
+  }
+}
+
+// Called with the lock held.
+static _az_http_request_coalescer_flight* _az_http_policy_coalescing_find(
+    az_http_request_coalescer* ref_coalescer,
+    void const* credential,
+    az_span key)
+{
+  for (int32_t i = 0; i < AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT; i++)
+  {
+    _az_http_request_coalescer_flight* const flight = &ref_coalescer->_internal.flights[i];
+    if (flight->_internal.is_in_use && !flight->_internal.is_done
+        && flight->_internal.credential == credential
+        && az_span_is_content_equal(
+            az_span_create(flight->_internal.key, flight->_internal.key_size), key))
+    {
+      return flight;
+    }
+  }
+
+  return NULL;
+}
+
+// Called with the lock held.
+static _az_http_request_coalescer_flight* _az_http_policy_coalescing_claim(
+    az_http_request_coalescer* ref_coalescer,
+    void const* credential,
+    az_span key)
+{
+  for (int32_t i = 0; i < AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT; i++)
+  {
+    _az_http_request_coalescer_flight* const flight = &ref_coalescer->_internal.flights[i];
+    if (!flight->_internal.is_in_use)
+    {
+      az_span_copy(AZ_SPAN_FROM_BUFFER(flight->_internal.key), key);
+      flight->_internal.key_size = az_span_size(key);
+      flight->_internal.credential = credential;
+      flight->_internal.is_in_use = true;
+      flight->_internal.is_done = false;
+      flight->_internal.waiter_count = 0;
+      return flight;
+    }
+  }
+
+  return NULL;
+}
+
+static AZ_NODISCARD az_result _az_http_policy_coalescing_wait(
+    az_http_request_coalescer* ref_coalescer,
+    _az_http_request_coalescer_flight* flight,
+    az_context* context,
+    az_http_response* ref_response)
+{
+  az_result result = AZ_OK;
+  while (true)
+  {
+    _az_atomic_spin_lock(&ref_coalescer->_internal.lock);
+    bool const is_done = flight->_internal.is_done;
+    _az_atomic_spin_unlock(&ref_coalescer->_internal.lock);
+
+    if (is_done)
+    {
+      break;
+    }
+
+    result = az_platform_wait_msec(context, _az_HTTP_POLICY_COALESCING_WAIT_MSEC);
+    if (az_result_failed(result))
+    {
+      break;
+    }
+  }
+
+  if (az_result_succeeded(result))
+  {
+    // The response which was sent stays as it is until every waiter has copied it.
+    result = flight->_internal.result;
+    if (az_result_succeeded(result))
+    {
+      az_http_response const* const response = flight->_internal.response;
+      _az_http_response_reset(ref_response);
+      result = az_http_response_append(
+          ref_response,
+          az_span_slice(response->_internal.http_response, 0, response->_internal.written));
+    }
+  }
+
+  _az_atomic_spin_lock(&ref_coalescer->_internal.lock);
+  flight->_internal.waiter_count--;
+  _az_atomic_spin_unlock(&ref_coalescer->_internal.lock);
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_coalescing(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  _az_http_policy_coalescing_options const* const options
+      = (_az_http_policy_coalescing_options const*)ref_options;
+  az_http_request_coalescer* const coalescer = options == NULL ? NULL : options->coalescer;
+
+  // Only the requests which don't change anything can share a response, and a response streamed
+  // to a sink can't be copied.
+  if (coalescer == NULL || ref_response->_internal.body_sink.callback != NULL
+      || !(az_span_is_content_equal(ref_request->_internal.method, az_http_method_get())
+           || az_span_is_content_equal(ref_request->_internal.method, az_http_method_head())))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_COALESCING, ref_request, ref_response);
+  }
+
+  uint8_t key_buffer[AZ_HTTP_REQUEST_COALESCER_MAX_KEY_SIZE];
+  az_span key = AZ_SPAN_EMPTY;
+  if (az_result_failed(
+          _az_http_request_write_key(ref_request, AZ_SPAN_FROM_BUFFER(key_buffer), &key)))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_COALESCING, ref_request, ref_response);
+  }
+
+  _az_atomic_spin_lock(&coalescer->_internal.lock);
+
+  _az_http_request_coalescer_flight* flight
+      = _az_http_policy_coalescing_find(coalescer, options->credential, key);
+  if (flight != NULL)
+  {
+    flight->_internal.waiter_count++;
+    _az_atomic_spin_unlock(&coalescer->_internal.lock);
+
+    return _az_http_policy_coalescing_wait(
+        coalescer, flight, ref_request->_internal.context, ref_response);
+  }
+
+  flight = _az_http_policy_coalescing_claim(coalescer, options->credential, key);
+  _az_atomic_spin_unlock(&coalescer->_internal.lock);
+
+  if (flight == NULL)
+  {
+    // As many distinct requests as the coalescer can track are in flight.
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_COALESCING, ref_request, ref_response);
+  }
+
+  az_result const result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_COALESCING, ref_request, ref_response);
+
+  _az_atomic_spin_lock(&coalescer->_internal.lock);
+  flight->_internal.result = result;
+  flight->_internal.response = ref_response;
+  flight->_internal.is_done = true;
+
+  // The requests which joined copy the response before this one returns it to its caller.
+  while (flight->_internal.waiter_count > 0)
+  {
+    _az_atomic_spin_unlock(&coalescer->_internal.lock);
+    az_platform_sleep_msec(_az_HTTP_POLICY_COALESCING_WAIT_MSEC);
+    _az_atomic_spin_lock(&coalescer->_internal.lock);
+  }
+
+  flight->_internal.is_in_use = false;
+  flight->_internal.response = NULL;
+  _az_atomic_spin_unlock(&coalescer->_internal.lock);
+
+  return result;
+}
@@ -0,0 +1,1181 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_config_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+#include <azure/core/internal/az_span_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+enum
+{
+  // The farthest back a match can be found, which is also the size of the decompression window.
+  _az_DEFLATE_WINDOW_SIZE = 32768,
+  _az_DEFLATE_MIN_MATCH = 3,
+  _az_DEFLATE_MAX_MATCH = 258,
+  // The compressor remembers the last position of this many hashes of 3 bytes.
+  _az_DEFLATE_HASH_BITS = 11,
+  _az_DEFLATE_END_OF_BLOCK = 256,
+  _az_GZIP_HEADER_SIZE = 10,
+  _az_GZIP_TRAILER_SIZE = 8,
+};
+
+// The flags of a gzip header which say which optional fields follow it.
+enum
+{
+  _az_GZIP_FLAG_HEADER_CRC = 0x02,
+  _az_GZIP_FLAG_EXTRA = 0x04,
+  _az_GZIP_FLAG_NAME = 0x08,
+  _az_GZIP_FLAG_COMMENT = 0x10,
+  _az_GZIP_FLAG_RESERVED = 0xE0,
+};
+
+static az_span const content_encoding_header = AZ_SPAN_LITERAL_FROM_STR("Content-Encoding");
+static az_span const accept_encoding_header = AZ_SPAN_LITERAL_FROM_STR("Accept-Encoding");
+static az_span const content_length_header = AZ_SPAN_LITERAL_FROM_STR("Content-Length");
+static az_span const gzip_encoding = AZ_SPAN_LITERAL_FROM_STR("gzip");
+
+static uint16_t const _az_deflate_length_base[29] = {
+  3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23,  27,
+  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+
+static uint8_t const _az_deflate_length_extra_bits[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+static uint16_t const _az_deflate_distance_base[30] = {
+  1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+  193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+
+static uint8_t const _az_deflate_distance_extra_bits[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+// The order in which the lengths of the code length code are stored in a dynamic block.
+static uint8_t const _az_deflate_code_length_order[19] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+// The CRC-32 of gzip, four bits at a time.
+static uint32_t const _az_gzip_crc_table[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static AZ_NODISCARD uint32_t _az_gzip_crc32(uint32_t crc, uint8_t const* ptr, int32_t size)
+{
+  crc = ~crc;
+  for (int32_t i = 0; i < size; i++)
+  {
+    crc ^= ptr[i];
+    crc = (crc >> 4) ^ _az_gzip_crc_table[crc & 0x0F];
+    crc = (crc >> 4) ^ _az_gzip_crc_table[crc & 0x0F];
+  }
+
+  return ~crc;
+}
+
+/**
+ * @brief Writes the bits of a deflate stream, least significant bit first.
+ */
+typedef struct
+{
+  az_span buffer;
+  int32_t written;
+  uint32_t bits;
+  int32_t bit_count;
+} _az_deflate_writer;
+
+static AZ_NODISCARD az_result
+_az_deflate_write_bits(_az_deflate_writer* ref_writer, uint32_t value, int32_t count)
+{
+  ref_writer->bits |= value << ref_writer->bit_count;
+  ref_writer->bit_count += count;
+
+  while (ref_writer->bit_count >= 8)
+  {
+    if (ref_writer->written == az_span_size(ref_writer->buffer))
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    az_span_ptr(ref_writer->buffer)[ref_writer->written++] = (uint8_t)ref_writer->bits;
+    ref_writer->bits >>= 8;
+    ref_writer->bit_count -= 8;
+  }
+
+  return AZ_OK;
+}
+
+// Huffman codes are stored starting from their most significant bit.
+static AZ_NODISCARD az_result
+_az_deflate_write_code(_az_deflate_writer* ref_writer, uint32_t code, int32_t length)
+{
+  uint32_t reversed = 0;
+  for (int32_t i = 0; i < length; i++)
+  {
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+
+  return _az_deflate_write_bits(ref_writer, reversed, length);
+}
+
+// Writes a literal or length symbol with the fixed Huffman code of deflate.
+static AZ_NODISCARD az_result
+_az_deflate_write_symbol(_az_deflate_writer* ref_writer, int32_t symbol)
+{
+  if (symbol < 144)
+  {
+    return _az_deflate_write_code(ref_writer, (uint32_t)(0x30 + symbol), 8);
+  }
+
+  if (symbol < 256)
+  {
+    return _az_deflate_write_code(ref_writer, (uint32_t)(0x190 + symbol - 144), 9);
+  }
+
+  if (symbol < 280)
+  {
+    return _az_deflate_write_code(ref_writer, (uint32_t)(symbol - 256), 7);
+  }
+
+  return _az_deflate_write_code(ref_writer, (uint32_t)(0xC0 + symbol - 280), 8);
+}
+
+static AZ_NODISCARD az_result
+_az_deflate_write_match(_az_deflate_writer* ref_writer, int32_t length, int32_t distance)
+{
+  int32_t code = 28;
+  while (_az_deflate_length_base[code] > length)
+  {
+    code--;
+  }
+
+  _az_RETURN_IF_FAILED(_az_deflate_write_symbol(ref_writer, 257 + code));
+  _az_RETURN_IF_FAILED(_az_deflate_write_bits(
+      ref_writer,
+      (uint32_t)(length - _az_deflate_length_base[code]),
+      _az_deflate_length_extra_bits[code]));
+
+  code = 29;
+  while (_az_deflate_distance_base[code] > distance)
+  {
+    code--;
+  }
+
+  // Distances have fixed 5 bit codes.
+  _az_RETURN_IF_FAILED(_az_deflate_write_code(ref_writer, (uint32_t)code, 5));
+  return _az_deflate_write_bits(
+      ref_writer,
+      (uint32_t)(distance - _az_deflate_distance_base[code]),
+      _az_deflate_distance_extra_bits[code]);
+}
+
+static AZ_NODISCARD uint32_t _az_deflate_hash(uint8_t const* ptr)
+{
+  uint32_t const value = (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16);
+  return (value * 2654435761u) >> (32 - _az_DEFLATE_HASH_BITS);
+}
+
+/**
+ * @brief Compresses \p source into a gzip member with a single block of fixed Huffman codes, in
+ * one pass over \p source.
+ *
+ * @details Each position is looked up by the hash of its next 3 bytes in \p hash_table, which
+ * holds the last position with that hash, so the compressor needs no more memory than the table.
+ *
+ * @return #AZ_ERROR_NOT_ENOUGH_SPACE as soon as the compressed data doesn't fit in
+ * \p destination.
+ */
+static AZ_NODISCARD az_result _az_gzip_compress(
+    az_span source,
+    int32_t* hash_table,
+    az_span destination,
+    int32_t* out_size)
+{
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, _az_GZIP_HEADER_SIZE + _az_GZIP_TRAILER_SIZE);
+
+  _az_deflate_writer writer = {
+    .buffer = az_span_slice(destination, 0, az_span_size(destination) - _az_GZIP_TRAILER_SIZE),
+    .written = 0,
+    .bits = 0,
+    .bit_count = 0,
+  };
+
+  // ID1, ID2, the deflate method, no flags, no modification time, no extra flags and an unknown
+  // operating system.
+  static uint8_t const header[_az_GZIP_HEADER_SIZE] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+  for (int32_t i = 0; i < _az_GZIP_HEADER_SIZE; i++)
+  {
+    _az_RETURN_IF_FAILED(_az_deflate_write_bits(&writer, header[i], 8));
+  }
+
+  // The last block, compressed with the fixed Huffman codes.
+  _az_RETURN_IF_FAILED(_az_deflate_write_bits(&writer, 1, 1));
+  _az_RETURN_IF_FAILED(_az_deflate_write_bits(&writer, 1, 2));
+
+  for (int32_t i = 0; i < (1 << _az_DEFLATE_HASH_BITS); i++)
+  {
+    hash_table[i] = -1;
+  }
+
+  uint8_t const* const ptr = az_span_ptr(source);
+  int32_t const size = az_span_size(source);
+  int32_t position = 0;
+  while (position < size)
+  {
+    int32_t length = 0;
+    int32_t distance = 0;
+    if (size - position >= _az_DEFLATE_MIN_MATCH)
+    {
+      uint32_t const hash = _az_deflate_hash(&ptr[position]);
+      int32_t const candidate = hash_table[hash];
+      hash_table[hash] = position;
+
+      if (candidate >= 0 && position - candidate <= _az_DEFLATE_WINDOW_SIZE
+          && ptr[candidate] == ptr[position] && ptr[candidate + 1] == ptr[position + 1]
+          && ptr[candidate + 2] == ptr[position + 2])
+      {
+        int32_t const max_length
+            = size - position < _az_DEFLATE_MAX_MATCH ? size - position : _az_DEFLATE_MAX_MATCH;
+
+        length = _az_DEFLATE_MIN_MATCH;
+        while (length < max_length && ptr[candidate + length] == ptr[position + length])
+        {
+          length++;
+        }
+
+        distance = position - candidate;
+      }
+    }
+
+    if (length == 0)
+    {
+      _az_RETURN_IF_FAILED(_az_deflate_write_symbol(&writer, ptr[position]));
+      position++;
+      continue;
+    }
+
+    _az_RETURN_IF_FAILED(_az_deflate_write_match(&writer, length, distance));
+
+    // The positions inside the match are remembered too, so that their repetitions are found.
+    int32_t const end = position + length;
+    for (position++; position < end && size - position >= _az_DEFLATE_MIN_MATCH; position++)
+    {
+      hash_table[_az_deflate_hash(&ptr[position])] = position;
+    }
+
+    position = end;
+  }
+
+  _az_RETURN_IF_FAILED(_az_deflate_write_symbol(&writer, _az_DEFLATE_END_OF_BLOCK));
+
+  // The last byte is padded with zero bits.
+  if (writer.bit_count > 0)
+  {
+    _az_RETURN_IF_FAILED(_az_deflate_write_bits(&writer, 0, 8 - writer.bit_count));
+  }
+
+  // The CRC-32 and the size of the uncompressed data, in little-endian order.
+  uint32_t const crc = _az_gzip_crc32(0, ptr, size);
+  uint8_t* const trailer = az_span_ptr(destination) + writer.written;
+  for (int32_t i = 0; i < 4; i++)
+  {
+    trailer[i] = (uint8_t)(crc >> (8 * i));
+    trailer[4 + i] = (uint8_t)((uint32_t)size >> (8 * i));
+  }
+
+  *out_size = writer.written + _az_GZIP_TRAILER_SIZE;
+  return AZ_OK;
+}
+
+/**
+ * @brief A canonical Huffman code, as the number of codes of each length and the symbols in the
+ * order of their codes.
+ */
+typedef struct
+{
+  int16_t count[16];
+  int16_t symbol[288];
+} _az_inflate_huffman;
+
+typedef enum
+{
+  _az_INFLATE_STATE_HEADER,
+  _az_INFLATE_STATE_HEADER_SKIP,
+  _az_INFLATE_STATE_HEADER_EXTRA,
+  _az_INFLATE_STATE_HEADER_NAME,
+  _az_INFLATE_STATE_HEADER_COMMENT,
+  _az_INFLATE_STATE_HEADER_CRC,
+  _az_INFLATE_STATE_BLOCK,
+  _az_INFLATE_STATE_STORED_SIZE,
+  _az_INFLATE_STATE_STORED,
+  _az_INFLATE_STATE_TABLE_SIZES,
+  _az_INFLATE_STATE_CODE_LENGTH_CODE,
+  _az_INFLATE_STATE_CODE_LENGTHS,
+  _az_INFLATE_STATE_CODES,
+  _az_INFLATE_STATE_TRAILER_CRC,
+  _az_INFLATE_STATE_TRAILER_SIZE,
+  _az_INFLATE_STATE_DONE,
+} _az_inflate_state;
+
+/**
+ * @brief Decompresses a gzip stream which arrives in chunks of any size, and passes the
+ * decompressed data to a body sink.
+ *
+ * @details The decompressor stops wherever a chunk ends and continues with the next one. The
+ * decompressed data is kept in #window, which matches can refer back to, and it is passed to the
+ * sink when the window is full and at the end of each chunk.
+ */
+typedef struct
+{
+  az_http_response_body_sink_fn sink;
+  void* sink_user_context;
+  az_span input;
+  uint64_t bits;
+  int32_t bit_count;
+  _az_inflate_state state;
+  int32_t header_flags;
+  int32_t remaining; // bytes left to skip in the header, or to copy from a stored block.
+  bool is_last_block;
+  int32_t literal_count;
+  int32_t distance_count;
+  int32_t code_length_count;
+  int32_t length_index;
+  uint8_t lengths[286 + 30];
+  _az_inflate_huffman literal_codes;
+  _az_inflate_huffman distance_codes;
+  uint32_t crc;
+  int64_t output_size;
+  int32_t window_position;
+  int32_t flushed_position;
+  uint8_t window[_az_DEFLATE_WINDOW_SIZE];
+} _az_inflater;
+
+static void _az_inflate_init(
+    _az_inflater* out_inflater,
+    az_http_response_body_sink_fn sink,
+    void* sink_user_context)
+{
+  out_inflater->sink = sink;
+  out_inflater->sink_user_context = sink_user_context;
+  out_inflater->input = AZ_SPAN_EMPTY;
+  out_inflater->bits = 0;
+  out_inflater->bit_count = 0;
+  out_inflater->state = _az_INFLATE_STATE_HEADER;
+  out_inflater->crc = 0;
+  out_inflater->output_size = 0;
+  out_inflater->window_position = 0;
+  out_inflater->flushed_position = 0;
+}
+
+// Reads input until at least count bits are available, which is never more than 48. Returns false
+// when the chunk ends first.
+static AZ_NODISCARD bool _az_inflate_fill(_az_inflater* ref_inflater, int32_t count)
+{
+  while (ref_inflater->bit_count < count)
+  {
+    if (az_span_size(ref_inflater->input) == 0)
+    {
+      return false;
+    }
+
+    ref_inflater->bits |= (uint64_t)az_span_ptr(ref_inflater->input)[0] << ref_inflater->bit_count;
+    ref_inflater->input = az_span_slice_to_end(ref_inflater->input, 1);
+    ref_inflater->bit_count += 8;
+  }
+
+  return true;
+}
+
+static AZ_NODISCARD uint32_t _az_inflate_take(_az_inflater* ref_inflater, int32_t count)
+{
+  uint32_t const value = (uint32_t)(ref_inflater->bits & ((UINT64_C(1) << count) - 1));
+  ref_inflater->bits >>= count;
+  ref_inflater->bit_count -= count;
+  return value;
+}
+
+static void _az_inflate_drop(_az_inflater* ref_inflater, int32_t count)
+{
+  ref_inflater->bits >>= count;
+  ref_inflater->bit_count -= count;
+}
+
+// Returns the symbol of the next code, one bit at a time, or -1 when the bits are not a code.
+static AZ_NODISCARD int32_t
+_az_inflate_decode(_az_inflater* ref_inflater, _az_inflate_huffman const* huffman)
+{
+  int32_t code = 0;
+  int32_t first = 0;
+  int32_t index = 0;
+  for (int32_t length = 1; length < 16 && ref_inflater->bit_count > 0; length++)
+  {
+    code |= (int32_t)_az_inflate_take(ref_inflater, 1);
+    int32_t const count = huffman->count[length];
+    if (code - count < first)
+    {
+      return huffman->symbol[index + (code - first)];
+    }
+
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+
+  return -1;
+}
+
+static AZ_NODISCARD az_result
+_az_inflate_build(_az_inflate_huffman* out_huffman, uint8_t const* lengths, int32_t count)
+{
+  for (int32_t length = 0; length < 16; length++)
+  {
+    out_huffman->count[length] = 0;
+  }
+
+  for (int32_t symbol = 0; symbol < count; symbol++)
+  {
+    out_huffman->count[lengths[symbol]]++;
+  }
+
+  // Fails when there are more codes of some length than the shorter codes leave room for.
+  int32_t left = 1;
+  for (int32_t length = 1; length < 16; length++)
+  {
+    left = (left << 1) - out_huffman->count[length];
+    if (left < 0)
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+  }
+
+  int16_t offsets[16];
+  offsets[1] = 0;
+  for (int32_t length = 1; length < 15; length++)
+  {
+    offsets[length + 1] = (int16_t)(offsets[length] + out_huffman->count[length]);
+  }
+
+  for (int32_t symbol = 0; symbol < count; symbol++)
+  {
+    if (lengths[symbol] != 0)
+    {
+      out_huffman->symbol[offsets[lengths[symbol]]++] = (int16_t)symbol;
+    }
+  }
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_inflate_build_fixed(_az_inflater* ref_inflater)
+{
+  uint8_t* const lengths = ref_inflater->lengths;
+  for (int32_t symbol = 0; symbol < 288; symbol++)
+  {
+    lengths[symbol] = (uint8_t)(symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8);
+  }
+
+  // Symbols 286 and 287 never occur in a valid stream, but their codes come before the 9 bit
+  // codes, so they must be counted for the codes of the literals from 144 to 255 to be right.
+  _az_RETURN_IF_FAILED(_az_inflate_build(&ref_inflater->literal_codes, lengths, 288));
+
+  for (int32_t symbol = 0; symbol < 30; symbol++)
+  {
+    lengths[symbol] = 5;
+  }
+
+  return _az_inflate_build(&ref_inflater->distance_codes, lengths, 30);
+}
+
+// Passes the data written to the window since the last flush to the sink.
+static AZ_NODISCARD az_result _az_inflate_flush(_az_inflater* ref_inflater)
+{
+  int32_t const size = ref_inflater->window_position - ref_inflater->flushed_position;
+  if (size > 0)
+  {
+    uint8_t* const ptr = &ref_inflater->window[ref_inflater->flushed_position];
+    ref_inflater->crc = _az_gzip_crc32(ref_inflater->crc, ptr, size);
+    ref_inflater->flushed_position = ref_inflater->window_position;
+    _az_RETURN_IF_FAILED(
+        ref_inflater->sink(ref_inflater->sink_user_context, az_span_create(ptr, size)));
+  }
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_inflate_put(_az_inflater* ref_inflater, uint8_t value)
+{
+  ref_inflater->window[ref_inflater->window_position++] = value;
+  ref_inflater->output_size++;
+
+  if (ref_inflater->window_position == _az_DEFLATE_WINDOW_SIZE)
+  {
+    _az_RETURN_IF_FAILED(_az_inflate_flush(ref_inflater));
+    ref_inflater->window_position = 0;
+    ref_inflater->flushed_position = 0;
+  }
+
+  return AZ_OK;
+}
+
+// Skips the bits up to the next byte boundary of the stream.
+static void _az_inflate_align(_az_inflater* ref_inflater)
+{
+  _az_inflate_drop(ref_inflater, ref_inflater->bit_count & 7);
+}
+
+static void _az_inflate_end_of_block(_az_inflater* ref_inflater)
+{
+  if (ref_inflater->is_last_block)
+  {
+    _az_inflate_align(ref_inflater);
+    ref_inflater->state = _az_INFLATE_STATE_TRAILER_CRC;
+  }
+  else
+  {
+    ref_inflater->state = _az_INFLATE_STATE_BLOCK;
+  }
+}
+
+// Decodes a literal, a match or the end of the block from its codes.
+static AZ_NODISCARD az_result _az_inflate_codes(_az_inflater* ref_inflater)
+{
+  int32_t symbol = _az_inflate_decode(ref_inflater, &ref_inflater->literal_codes);
+  if (symbol < 0)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  if (symbol < 256)
+  {
+    return _az_inflate_put(ref_inflater, (uint8_t)symbol);
+  }
+
+  if (symbol == _az_DEFLATE_END_OF_BLOCK)
+  {
+    _az_inflate_end_of_block(ref_inflater);
+    return AZ_OK;
+  }
+
+  symbol -= 257;
+  if (symbol >= 29)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  int32_t const length = _az_deflate_length_base[symbol]
+      + (int32_t)_az_inflate_take(ref_inflater, _az_deflate_length_extra_bits[symbol]);
+
+  symbol = _az_inflate_decode(ref_inflater, &ref_inflater->distance_codes);
+  if (symbol < 0 || symbol >= 30)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  int32_t const distance = _az_deflate_distance_base[symbol]
+      + (int32_t)_az_inflate_take(ref_inflater, _az_deflate_distance_extra_bits[symbol]);
+  if (distance > ref_inflater->output_size)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  for (int32_t i = 0; i < length; i++)
+  {
+    int32_t const source
+        = (ref_inflater->window_position - distance) & (_az_DEFLATE_WINDOW_SIZE - 1);
+    _az_RETURN_IF_FAILED(_az_inflate_put(ref_inflater, ref_inflater->window[source]));
+  }
+
+  return AZ_OK;
+}
+
+// Decodes a code length, which is repeated for the next symbols when it is 16, 17 or 18.
+static AZ_NODISCARD az_result _az_inflate_code_length(_az_inflater* ref_inflater)
+{
+  int32_t const symbol = _az_inflate_decode(ref_inflater, &ref_inflater->literal_codes);
+  if (symbol < 0)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  int32_t const total = ref_inflater->literal_count + ref_inflater->distance_count;
+  uint8_t* const lengths = ref_inflater->lengths;
+  if (symbol < 16)
+  {
+    lengths[ref_inflater->length_index++] = (uint8_t)symbol;
+  }
+  else
+  {
+    uint8_t length = 0;
+    int32_t repeat = 0;
+    if (symbol == 16)
+    {
+      if (ref_inflater->length_index == 0)
+      {
+        return AZ_ERROR_UNEXPECTED_CHAR;
+      }
+
+      length = lengths[ref_inflater->length_index - 1];
+      repeat = 3 + (int32_t)_az_inflate_take(ref_inflater, 2);
+    }
+    else if (symbol == 17)
+    {
+      repeat = 3 + (int32_t)_az_inflate_take(ref_inflater, 3);
+    }
+    else
+    {
+      repeat = 11 + (int32_t)_az_inflate_take(ref_inflater, 7);
+    }
+
+    if (ref_inflater->length_index + repeat > total)
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
+    while (repeat-- > 0)
+    {
+      lengths[ref_inflater->length_index++] = length;
+    }
+  }
+
+  if (ref_inflater->length_index < total)
+  {
+    return AZ_OK;
+  }
+
+  // The end of block symbol must have a code.
+  if (lengths[_az_DEFLATE_END_OF_BLOCK] == 0)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  _az_RETURN_IF_FAILED(
+      _az_inflate_build(&ref_inflater->literal_codes, lengths, ref_inflater->literal_count));
+  _az_RETURN_IF_FAILED(_az_inflate_build(
+      &ref_inflater->distance_codes,
+      &lengths[ref_inflater->literal_count],
+      ref_inflater->distance_count));
+
+  ref_inflater->state = _az_INFLATE_STATE_CODES;
+  return AZ_OK;
+}
+
+/**
+ * @brief Decompresses the next chunk of a gzip stream, which may contain several members.
+ *
+ * @return #AZ_ERROR_UNEXPECTED_CHAR when the stream is not valid gzip, or the result of the sink.
+ */
+static AZ_NODISCARD az_result _az_inflate(_az_inflater* ref_inflater, az_span input)
+{
+  ref_inflater->input = input;
+
+  while (true)
+  {
+    switch (ref_inflater->state)
+    {
+      case _az_INFLATE_STATE_HEADER:
+      {
+        // ID1, ID2, the method and the flags, followed by 6 bytes which are not needed.
+        if (!_az_inflate_fill(ref_inflater, 32))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        uint32_t const id = _az_inflate_take(ref_inflater, 16);
+        uint32_t const method = _az_inflate_take(ref_inflater, 8);
+        ref_inflater->header_flags = (int32_t)_az_inflate_take(ref_inflater, 8);
+        if (id != 0x8B1F || method != 8
+            || (ref_inflater->header_flags & _az_GZIP_FLAG_RESERVED) != 0)
+        {
+          return AZ_ERROR_UNEXPECTED_CHAR;
+        }
+
+        ref_inflater->remaining = 6;
+        ref_inflater->state = _az_INFLATE_STATE_HEADER_SKIP;
+        break;
+      }
+
+      case _az_INFLATE_STATE_HEADER_SKIP:
+        while (ref_inflater->remaining > 0)
+        {
+          if (!_az_inflate_fill(ref_inflater, 8))
+          {
+            return _az_inflate_flush(ref_inflater);
+          }
+
+          _az_inflate_drop(ref_inflater, 8);
+          ref_inflater->remaining--;
+        }
+
+        ref_inflater->state = _az_INFLATE_STATE_HEADER_EXTRA;
+        break;
+
+      case _az_INFLATE_STATE_HEADER_EXTRA:
+        if ((ref_inflater->header_flags & _az_GZIP_FLAG_EXTRA) != 0)
+        {
+          if (!_az_inflate_fill(ref_inflater, 16))
+          {
+            return _az_inflate_flush(ref_inflater);
+          }
+
+          // Skips the extra field, and then comes back here for the next fields.
+          ref_inflater->remaining = (int32_t)_az_inflate_take(ref_inflater, 16);
+          ref_inflater->header_flags &= ~_az_GZIP_FLAG_EXTRA;
+          ref_inflater->state = _az_INFLATE_STATE_HEADER_SKIP;
+          break;
+        }
+
+        ref_inflater->state = _az_INFLATE_STATE_HEADER_NAME;
+        break;
+
+      case _az_INFLATE_STATE_HEADER_NAME:
+      case _az_INFLATE_STATE_HEADER_COMMENT:
+      {
+        // The name and the comment end with a zero byte.
+        int32_t const flag = ref_inflater->state == _az_INFLATE_STATE_HEADER_NAME
+            ? _az_GZIP_FLAG_NAME
+            : _az_GZIP_FLAG_COMMENT;
+        while ((ref_inflater->header_flags & flag) != 0)
+        {
+          if (!_az_inflate_fill(ref_inflater, 8))
+          {
+            return _az_inflate_flush(ref_inflater);
+          }
+
+          if (_az_inflate_take(ref_inflater, 8) == 0)
+          {
+            ref_inflater->header_flags &= ~flag;
+          }
+        }
+
+        ref_inflater->state = ref_inflater->state == _az_INFLATE_STATE_HEADER_NAME
+            ? _az_INFLATE_STATE_HEADER_COMMENT
+            : _az_INFLATE_STATE_HEADER_CRC;
+        break;
+      }
+
+      case _az_INFLATE_STATE_HEADER_CRC:
+        if ((ref_inflater->header_flags & _az_GZIP_FLAG_HEADER_CRC) != 0)
+        {
+          if (!_az_inflate_fill(ref_inflater, 16))
+          {
+            return _az_inflate_flush(ref_inflater);
+          }
+
+          _az_inflate_drop(ref_inflater, 16);
+        }
+
+        ref_inflater->state = _az_INFLATE_STATE_BLOCK;
+        break;
+
+      case _az_INFLATE_STATE_BLOCK:
+      {
+        if (!_az_inflate_fill(ref_inflater, 3))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        ref_inflater->is_last_block = _az_inflate_take(ref_inflater, 1) == 1;
+        uint32_t const type = _az_inflate_take(ref_inflater, 2);
+        if (type == 0)
+        {
+          _az_inflate_align(ref_inflater);
+          ref_inflater->state = _az_INFLATE_STATE_STORED_SIZE;
+        }
+        else if (type == 1)
+        {
+          _az_RETURN_IF_FAILED(_az_inflate_build_fixed(ref_inflater));
+          ref_inflater->state = _az_INFLATE_STATE_CODES;
+        }
+        else if (type == 2)
+        {
+          ref_inflater->state = _az_INFLATE_STATE_TABLE_SIZES;
+        }
+        else
+        {
+          return AZ_ERROR_UNEXPECTED_CHAR;
+        }
+
+        break;
+      }
+
+      case _az_INFLATE_STATE_STORED_SIZE:
+      {
+        if (!_az_inflate_fill(ref_inflater, 32))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        uint32_t const size = _az_inflate_take(ref_inflater, 16);
+        if ((size ^ _az_inflate_take(ref_inflater, 16)) != 0xFFFF)
+        {
+          return AZ_ERROR_UNEXPECTED_CHAR;
+        }
+
+        ref_inflater->remaining = (int32_t)size;
+        ref_inflater->state = _az_INFLATE_STATE_STORED;
+        break;
+      }
+
+      case _az_INFLATE_STATE_STORED:
+        while (ref_inflater->remaining > 0)
+        {
+          if (!_az_inflate_fill(ref_inflater, 8))
+          {
+            return _az_inflate_flush(ref_inflater);
+          }
+
+          _az_RETURN_IF_FAILED(
+              _az_inflate_put(ref_inflater, (uint8_t)_az_inflate_take(ref_inflater, 8)));
+          ref_inflater->remaining--;
+        }
+
+        _az_inflate_end_of_block(ref_inflater);
+        break;
+
+      case _az_INFLATE_STATE_TABLE_SIZES:
+        if (!_az_inflate_fill(ref_inflater, 14))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        ref_inflater->literal_count = 257 + (int32_t)_az_inflate_take(ref_inflater, 5);
+        ref_inflater->distance_count = 1 + (int32_t)_az_inflate_take(ref_inflater, 5);
+        ref_inflater->code_length_count = 4 + (int32_t)_az_inflate_take(ref_inflater, 4);
+        if (ref_inflater->literal_count > 286 || ref_inflater->distance_count > 30)
+        {
+          return AZ_ERROR_UNEXPECTED_CHAR;
+        }
+
+        ref_inflater->length_index = 0;
+        ref_inflater->state = _az_INFLATE_STATE_CODE_LENGTH_CODE;
+        break;
+
+      case _az_INFLATE_STATE_CODE_LENGTH_CODE:
+        while (ref_inflater->length_index < ref_inflater->code_length_count)
+        {
+          if (!_az_inflate_fill(ref_inflater, 3))
+          {
+            return _az_inflate_flush(ref_inflater);
+          }
+
+          ref_inflater->lengths[_az_deflate_code_length_order[ref_inflater->length_index++]]
+              = (uint8_t)_az_inflate_take(ref_inflater, 3);
+        }
+
+        while (ref_inflater->length_index < 19)
+        {
+          ref_inflater->lengths[_az_deflate_code_length_order[ref_inflater->length_index++]] = 0;
+        }
+
+        // The code length code is kept with the literal codes until the lengths are read.
+        _az_RETURN_IF_FAILED(
+            _az_inflate_build(&ref_inflater->literal_codes, ref_inflater->lengths, 19));
+        ref_inflater->length_index = 0;
+        ref_inflater->state = _az_INFLATE_STATE_CODE_LENGTHS;
+        break;
+
+      case _az_INFLATE_STATE_CODE_LENGTHS:
+        // A code length code is at most 7 bits, followed by at most 7 extra bits.
+        if (!_az_inflate_fill(ref_inflater, 14))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        _az_RETURN_IF_FAILED(_az_inflate_code_length(ref_inflater));
+        break;
+
+      case _az_INFLATE_STATE_CODES:
+        // The longest match is a 15 bit length code with 5 extra bits, and a 15 bit distance code
+        // with 13 extra bits. The trailer after the last block is longer than that, so a valid
+        // stream never ends while waiting for these.
+        if (!_az_inflate_fill(ref_inflater, 48))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        _az_RETURN_IF_FAILED(_az_inflate_codes(ref_inflater));
+        break;
+
+      case _az_INFLATE_STATE_TRAILER_CRC:
+        if (!_az_inflate_fill(ref_inflater, 32))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        _az_RETURN_IF_FAILED(_az_inflate_flush(ref_inflater));
+        if (_az_inflate_take(ref_inflater, 32) != ref_inflater->crc)
+        {
+          return AZ_ERROR_UNEXPECTED_CHAR;
+        }
+
+        ref_inflater->state = _az_INFLATE_STATE_TRAILER_SIZE;
+        break;
+
+      case _az_INFLATE_STATE_TRAILER_SIZE:
+        if (!_az_inflate_fill(ref_inflater, 32))
+        {
+          return _az_inflate_flush(ref_inflater);
+        }
+
+        if (_az_inflate_take(ref_inflater, 32) != (uint32_t)ref_inflater->output_size)
+        {
+          return AZ_ERROR_UNEXPECTED_CHAR;
+        }
+
+        ref_inflater->state = _az_INFLATE_STATE_DONE;
+        break;
+
+      default:
+        if (az_span_size(ref_inflater->input) == 0 && ref_inflater->bit_count == 0)
+        {
+          return AZ_OK;
+        }
+
+        // Another member follows.
+        ref_inflater->crc = 0;
+        ref_inflater->output_size = 0;
+        ref_inflater->state = _az_INFLATE_STATE_HEADER;
+        break;
+    }
+  }
+}
+
+/**
+ * @brief The user context of the body sink which stands in for the one of the response while the
+ * rest of the pipeline runs.
+ */
+typedef struct
+{
+  az_http_response const* response;
+  _az_inflater* inflater;
+  bool is_checked;
+  bool is_gzip;
+} _az_http_policy_compression_sink_context;
+
+// Whether the response has a gzip Content-Encoding. It is called once the headers are complete.
+static AZ_NODISCARD bool _az_http_policy_compression_is_gzip(az_http_response const* response)
+{
+  // Parsing moves the response forward, so a copy is parsed.
+  az_http_response response_copy = *response;
+  az_http_response_status_line status_line = { 0 };
+  if (az_result_failed(az_http_response_get_status_line(&response_copy, &status_line)))
+  {
+    return false;
+  }
+
+  az_span name = { 0 };
+  az_span value = { 0 };
+  while (az_result_succeeded(az_http_response_get_next_header(&response_copy, &name, &value)))
+  {
+    if (az_span_is_content_equal_ignoring_case(name, content_encoding_header))
+    {
+      return az_span_is_content_equal_ignoring_case(value, gzip_encoding);
+    }
+  }
+
+  return false;
+}
+
+static AZ_NODISCARD az_result _az_http_policy_compression_sink(void* user_context, az_span chunk)
+{
+  _az_http_policy_compression_sink_context* const context
+      = (_az_http_policy_compression_sink_context*)user_context;
+
+  if (!context->is_checked)
+  {
+    context->is_checked = true;
+    context->is_gzip = _az_http_policy_compression_is_gzip(context->response);
+  }
+
+  _az_inflater* const inflater = context->inflater;
+  return context->is_gzip ? _az_inflate(inflater, chunk)
+                          : inflater->sink(inflater->sink_user_context, chunk);
+}
+
+static AZ_NODISCARD _az_http_request_header*
+_az_http_policy_compression_find_header(az_http_request* ref_request, az_span name)
+{
+  _az_http_request_header* const headers
+      = (_az_http_request_header*)az_span_ptr(ref_request->_internal.headers);
+
+  for (int32_t i = 0; i < az_http_request_headers_count(ref_request); i++)
+  {
+    if (az_span_is_content_equal_ignoring_case(headers[i].name, name))
+    {
+      return &headers[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Replaces the body of the request with its gzip compression, when that is smaller than the
+ * body and fits in the arena. The request is not changed when this fails.
+ */
+static AZ_NODISCARD az_result _az_http_policy_compression_compress_request(
+    _az_http_policy_compression_options const* options,
+    az_http_request* ref_request)
+{
+  az_span const body = ref_request->_internal.body;
+  if (ref_request->_internal.body_provider != NULL || az_span_size(body) == 0
+      || az_span_size(body) < options->min_body_size
+      || _az_http_policy_compression_find_header(ref_request, content_encoding_header) != NULL)
+  {
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  az_span_arena* const arena = options->arena;
+
+  az_span hash_table = { 0 };
+  _az_RETURN_IF_FAILED(az_span_arena_allocate(
+      arena, (int32_t)sizeof(int32_t) << _az_DEFLATE_HASH_BITS, &hash_table));
+
+  az_span content_length = { 0 };
+  _az_RETURN_IF_FAILED(
+      az_span_arena_allocate(arena, _az_INT64_AS_STR_BUFFER_SIZE, &content_length));
+
+  // The rest of the arena, minus the padding before it, holds the compressed body.
+  int32_t capacity = az_span_size(arena->_internal.buffer) - az_span_arena_get_used_size(arena)
+      - AZ_SPAN_ARENA_ALIGNMENT;
+  if (capacity > az_span_size(body) - 1)
+  {
+    capacity = az_span_size(body) - 1;
+  }
+
+  if (capacity <= 0)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  az_span compressed = { 0 };
+  _az_RETURN_IF_FAILED(az_span_arena_allocate(arena, capacity, &compressed));
+
+  int32_t compressed_size = 0;
+  _az_RETURN_IF_FAILED(
+      _az_gzip_compress(body, (int32_t*)az_span_ptr(hash_table), compressed, &compressed_size));
+  compressed = az_span_slice(compressed, 0, compressed_size);
+
+  az_span remainder = { 0 };
+  _az_RETURN_IF_FAILED(az_span_i64toa(content_length, compressed_size, &remainder));
+  content_length = az_span_slice(content_length, 0, _az_span_diff(remainder, content_length));
+
+  _az_RETURN_IF_FAILED(
+      az_http_request_append_header(ref_request, content_encoding_header, gzip_encoding));
+
+  _az_http_request_header* const content_length_header_ref
+      = _az_http_policy_compression_find_header(ref_request, content_length_header);
+  if (content_length_header_ref != NULL)
+  {
+    content_length_header_ref->value = content_length;
+  }
+
+  ref_request->_internal.body = compressed;
+  return AZ_OK;
+}
+
+AZ_NODISCARD _az_http_policy_compression_options _az_http_policy_compression_options_default()
+{
+  return (_az_http_policy_compression_options){
+    .arena = NULL,
+    .min_body_size = 256,
+    .decompress_responses = true,
+  };
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_compression(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  _az_http_policy_compression_options const* const options
+      = (_az_http_policy_compression_options const*)ref_options;
+
+  if (options == NULL || options->arena == NULL)
+  {
+    return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+  }
+
+  // Everything the policy changes is put back when it returns, so that it can run again for the
+  // same request.
+  az_span_arena* const arena = options->arena;
+  int32_t const arena_used = az_span_arena_get_used_size(arena);
+  int32_t const headers_length = ref_request->_internal.headers_length;
+  az_span const body = ref_request->_internal.body;
+  _az_http_request_header* const content_length
+      = _az_http_policy_compression_find_header(ref_request, content_length_header);
+  az_span const content_length_value
+      = content_length == NULL ? AZ_SPAN_EMPTY : content_length->value;
+
+  // A body which can't be compressed is sent as it is.
+  if (az_result_failed(_az_http_policy_compression_compress_request(options, ref_request)))
+  {
+    arena->_internal.used = arena_used;
+  }
+
+  az_http_response_body_sink_fn const sink = ref_response->_internal.body_sink.callback;
+  void* const sink_user_context = ref_response->_internal.body_sink.user_context;
+  // The sink context is allocated from the arena too, as the response refers to it while the rest
+  // of the pipeline runs.
+  _az_http_policy_compression_sink_context* sink_context = NULL;
+  az_span sink_buffer = { 0 };
+  az_span inflater = { 0 };
+  if (options->decompress_responses && sink != NULL
+      && _az_http_policy_compression_find_header(ref_request, accept_encoding_header) == NULL
+      && az_result_succeeded(az_span_arena_allocate(
+          arena, (int32_t)sizeof(_az_http_policy_compression_sink_context), &sink_buffer))
+      && az_result_succeeded(
+          az_span_arena_allocate(arena, (int32_t)sizeof(_az_inflater), &inflater))
+      && az_result_succeeded(
+          az_http_request_append_header(ref_request, accept_encoding_header, gzip_encoding)))
+  {
+    sink_context = (_az_http_policy_compression_sink_context*)az_span_ptr(sink_buffer);
+    *sink_context = (_az_http_policy_compression_sink_context){
+      .response = ref_response,
+      .inflater = (_az_inflater*)az_span_ptr(inflater),
+      .is_checked = false,
+      .is_gzip = false,
+    };
+    _az_inflate_init(sink_context->inflater, sink, sink_user_context);
+    ref_response->_internal.body_sink.callback = _az_http_policy_compression_sink;
+    ref_response->_internal.body_sink.user_context = sink_context;
+  }
+
+  az_result result = _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+
+  if (sink_context != NULL)
+  {
+    ref_response->_internal.body_sink.callback = sink;
+    ref_response->_internal.body_sink.user_context = sink_user_context;
+
+    if (az_result_succeeded(result) && sink_context->is_gzip
+        && sink_context->inflater->state != _az_INFLATE_STATE_DONE)
+    {
+      result = AZ_ERROR_UNEXPECTED_END;
+    }
+  }
+
+  ref_request->_internal.body = body;
+  ref_request->_internal.headers_length = headers_length;
+  if (content_length != NULL)
+  {
+    content_length->value = content_length_value;
+  }
+
+  arena->_internal.used = arena_used;
+
+  return result;
+}
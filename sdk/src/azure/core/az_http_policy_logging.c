@@ -7,6 +7,7 @@
 #include <azure/core/az_platform.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_log_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 
@@ -234,7 +235,103 @@ void _az_http_policy_logging_log_http_response(
   _az_LOG_WRITE(AZ_LOG_HTTP_RESPONSE, log_msg);
 }
 
+AZ_NODISCARD az_result az_http_log_message_get_request(
+    az_http_log_message const* message,
+    az_span* out_method,
+    az_span* out_url)
+{
+  _az_PRECONDITION_NOT_NULL(message);
+  _az_PRECONDITION_NOT_NULL(out_method);
+  _az_PRECONDITION_NOT_NULL(out_url);
+
+  az_http_request const* const request = (az_http_request const*)message->_internal.request;
+  _az_RETURN_IF_FAILED(az_http_request_get_method(request, out_method));
+  return az_http_request_get_url(request, out_url);
+}
+
+AZ_NODISCARD az_result az_http_log_message_get_request_header(
+    az_http_log_message const* message,
+    int32_t index,
+    az_span* out_name,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(message);
+  _az_PRECONDITION_NOT_NULL(out_name);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  static az_span const auth_header_name = AZ_SPAN_LITERAL_FROM_STR("authorization");
+
+  _az_RETURN_IF_FAILED(az_http_request_get_header(
+      (az_http_request const*)message->_internal.request, index, out_name, out_value));
+
+  // Same as the formatted log messages, the credential is never logged.
+  if (az_span_is_content_equal(*out_name, auth_header_name))
+  {
+    *out_value = AZ_SPAN_EMPTY;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_log_message_get_status_line(
+    az_http_log_message* message,
+    az_http_response_status_line* out_status_line)
+{
+  _az_PRECONDITION_NOT_NULL(message);
+  _az_PRECONDITION_NOT_NULL(out_status_line);
+
+  if (message->_internal.response == NULL)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  // Parsing moves the response forward, so a copy is parsed and the response is left as it was.
+  message->_internal.response_reader = *message->_internal.response;
+  _az_RETURN_IF_FAILED(
+      az_http_response_get_status_line(&message->_internal.response_reader, out_status_line));
+  message->_internal.status_line_read = true;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_log_message_get_next_response_header(
+    az_http_log_message* message,
+    az_span* out_name,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(message);
+  _az_PRECONDITION_NOT_NULL(out_name);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  if (!message->_internal.status_line_read)
+  {
+    az_http_response_status_line status_line = { 0 };
+    _az_RETURN_IF_FAILED(az_http_log_message_get_status_line(message, &status_line));
+  }
+
+  return az_http_response_get_next_header(&message->_internal.response_reader, out_name, out_value);
+}
+
 #ifndef AZ_NO_LOGGING
+static void _az_http_policy_logging_log_http_message(
+    az_http_log_message_fn callback,
+    az_log_classification classification,
+    az_http_request const* request,
+    az_http_response const* response,
+    int64_t duration_msec)
+{
+  az_http_log_message message = {
+    ._internal = {
+      .request = request,
+      .response = response,
+      .status_line_read = false,
+      .duration_msec = duration_msec,
+    },
+  };
+
+  callback(classification, &message);
+}
+
 AZ_NODISCARD az_result az_http_pipeline_policy_logging(
     _az_http_policy* ref_policies,
     void* ref_options,
@@ -243,22 +340,42 @@ AZ_NODISCARD az_result az_http_pipeline_policy_logging(
 {
   (void)ref_options;
 
-  if (_az_LOG_SHOULD_WRITE(AZ_LOG_HTTP_REQUEST))
+  // A message callback reads only what it needs, so nothing is formatted for it.
+  az_http_log_message_fn const request_callback
+      = _az_http_log_get_message_callback(AZ_LOG_HTTP_REQUEST);
+  if (request_callback != NULL)
+  {
+    _az_http_policy_logging_log_http_message(
+        request_callback, AZ_LOG_HTTP_REQUEST, ref_request, NULL, 0);
+  }
+  else if (_az_LOG_SHOULD_WRITE(AZ_LOG_HTTP_REQUEST))
   {
     _az_http_policy_logging_log_http_request(ref_request);
   }
 
-  if (!_az_LOG_SHOULD_WRITE(AZ_LOG_HTTP_RESPONSE))
+  az_http_log_message_fn const response_callback
+      = _az_http_log_get_message_callback(AZ_LOG_HTTP_RESPONSE);
+  if (response_callback == NULL && !_az_LOG_SHOULD_WRITE(AZ_LOG_HTTP_RESPONSE))
   {
     // If no logging is needed, do not even measure the response time.
-    return _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_LOGGING, ref_request, ref_response);
   }
 
   int64_t const start = az_platform_clock_msec();
-  az_result const result = _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+  az_result const result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_LOGGING, ref_request, ref_response);
   int64_t const end = az_platform_clock_msec();
 
-  _az_http_policy_logging_log_http_response(ref_response, end - start, ref_request);
+  if (response_callback != NULL)
+  {
+    _az_http_policy_logging_log_http_message(
+        response_callback, AZ_LOG_HTTP_RESPONSE, ref_request, ref_response, end - start);
+  }
+  else
+  {
+    _az_http_policy_logging_log_http_response(ref_response, end - start, ref_request);
+  }
 
   return result;
 }
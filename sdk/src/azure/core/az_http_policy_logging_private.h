@@ -6,6 +6,7 @@
 
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
+#include <azure/core/az_log.h>
 
 #include <stdint.h>
 
@@ -18,6 +19,14 @@ void _az_http_policy_logging_log_http_response(
     int64_t duration_msec,
     az_http_request const* request);
 
+#ifndef AZ_NO_LOGGING
+/**
+ * @brief Returns the callback set with #az_http_log_set_message_callback(), if it should receive
+ * messages of \p classification, or `NULL`.
+ */
+az_http_log_message_fn _az_http_log_get_message_callback(az_log_classification classification);
+#endif // AZ_NO_LOGGING
+
 #include <azure/core/_az_cfg_suffix.h>
 
 #endif // _az_HTTP_POLICY_LOGGING_PRIVATE_H
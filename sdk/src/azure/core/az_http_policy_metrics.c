@@ -0,0 +1,201 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+/**
+ * @brief Stands in for a policy of the pipeline, and measures the time spent in it.
+ *
+ * @details The metrics policy sends the request through a copy of the rest of the pipeline, where
+ * each policy is replaced by a probe. Each probe calls its policy with the next probe as the rest
+ * of the pipeline, so that the policies don't need to know about the metrics.
+ */
+typedef struct
+{
+  _az_http_policy policy;
+  az_http_request_metrics* metrics;
+  int32_t index;
+  bool is_last;
+} _az_http_policy_metrics_probe;
+
+static AZ_NODISCARD az_result _az_http_policy_metrics_probe_process(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  _az_http_policy_metrics_probe const* const probe
+      = (_az_http_policy_metrics_probe const*)ref_options;
+  az_http_request_metrics* const metrics = probe->metrics;
+
+  int64_t const start = az_platform_clock_msec();
+  az_result const result = probe->policy._internal.process(
+      ref_policies, probe->policy._internal.options, ref_request, ref_response);
+  int64_t const end = az_platform_clock_msec();
+
+  // Until the other probes are subtracted, this is the time spent in this policy and the ones
+  // after it.
+  metrics->policy_time_msec[probe->index] += end - start;
+
+  if (probe->is_last)
+  {
+    // Every time the last policy runs, the request is sent once. A retry resets the response, so
+    // what was received is counted after each attempt.
+    metrics->retry_count++;
+    int64_t const body_size = az_http_request_get_body_size(ref_request);
+    if (body_size > 0)
+    {
+      // The size of a body sent with chunked transfer coding is only known to its body provider.
+      metrics->bytes_sent += body_size;
+    }
+    metrics->bytes_received += ref_response->_internal.written;
+  }
+
+  return result;
+}
+
+// The counters can be shared by requests sent from several threads, so each one is added to
+// atomically.
+static void _az_http_pipeline_metrics_add(int64_t* ref_counter, int64_t value)
+{
+  _az_atomic_add((uint64_t volatile*)ref_counter, (uint64_t)value);
+}
+
+static void _az_http_policy_metrics_record(
+    az_http_policy_metrics_options const* options,
+    az_http_request_metrics const* metrics)
+{
+  az_http_pipeline_metrics* const counters = options->counters;
+  if (counters != NULL)
+  {
+    _az_http_pipeline_metrics_add(&counters->request_count, 1);
+    if (az_result_failed(metrics->result))
+    {
+      _az_http_pipeline_metrics_add(&counters->failed_request_count, 1);
+    }
+
+    _az_http_pipeline_metrics_add(&counters->retry_count, metrics->retry_count);
+    _az_http_pipeline_metrics_add(&counters->bytes_sent, metrics->bytes_sent);
+    _az_http_pipeline_metrics_add(&counters->bytes_received, metrics->bytes_received);
+
+    int32_t const status_class = (int32_t)metrics->status_code / 100;
+    _az_http_pipeline_metrics_add(
+        &counters->status_class_count[status_class >= 1 && status_class <= 5 ? status_class : 0],
+        1);
+
+    for (int32_t i = 0; i < metrics->policy_count; i++)
+    {
+      _az_http_pipeline_metrics_add(&counters->policy_time_msec[i], metrics->policy_time_msec[i]);
+    }
+  }
+
+  if (options->callback != NULL)
+  {
+    options->callback(options->callback_user_context, metrics);
+  }
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_metrics(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_http_policy_metrics_options const* const options
+      = (az_http_policy_metrics_options const*)ref_options;
+
+  if (options == NULL || (options->counters == NULL && options->callback == NULL))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_METRICS, ref_request, ref_response);
+  }
+
+  az_http_request_metrics metrics = {
+    .policy_count = 0,
+    .bytes_sent = 0,
+    .bytes_received = 0,
+    .retry_count = 0,
+    .status_code = AZ_HTTP_STATUS_CODE_NONE,
+    .result = AZ_OK,
+  };
+
+  // The rest of the pipeline ends with a NULL policy or with the transport policy.
+  _az_http_policy_metrics_probe probes[AZ_HTTP_POLICY_METRICS_MAX_POLICIES];
+  _az_http_policy probe_policies[AZ_HTTP_POLICY_METRICS_MAX_POLICIES + 1];
+  int32_t count = 0;
+  while (count < AZ_HTTP_POLICY_METRICS_MAX_POLICIES
+         && ref_policies[count]._internal.process != NULL)
+  {
+    bool const is_transport = ref_policies[count]._internal.process
+        == az_http_pipeline_policy_transport;
+
+    probes[count] = (_az_http_policy_metrics_probe){
+      .policy = ref_policies[count],
+      .metrics = &metrics,
+      .index = count,
+      .is_last = false,
+    };
+    probe_policies[count] = (_az_http_policy){
+      ._internal = {
+        .process = _az_http_policy_metrics_probe_process,
+        .options = &probes[count],
+      },
+    };
+
+    count++;
+    if (is_transport)
+    {
+      break;
+    }
+  }
+
+  if (count == 0)
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_METRICS, ref_request, ref_response);
+  }
+
+  probes[count - 1].is_last = true;
+  probe_policies[count] = (_az_http_policy){
+    ._internal = {
+      .process = NULL,
+      .options = NULL,
+    },
+  };
+
+  metrics.policy_count = count;
+  metrics.result = _az_http_pipeline_nextpolicy(probe_policies, ref_request, ref_response);
+
+  // Each policy runs inside the one before it, so its time is taken out of that one.
+  for (int32_t i = 0; i < count - 1; i++)
+  {
+    metrics.policy_time_msec[i] -= metrics.policy_time_msec[i + 1];
+  }
+
+  // The last policy counted every attempt, and all but the first are retries.
+  metrics.retry_count = metrics.retry_count > 0 ? metrics.retry_count - 1 : 0;
+
+  if (az_result_succeeded(metrics.result))
+  {
+    // Parsing moves the response forward, so a copy is parsed.
+    az_http_response response_copy = *ref_response;
+    az_http_response_status_line status_line = { 0 };
+    if (az_result_succeeded(az_http_response_get_status_line(&response_copy, &status_line)))
+    {
+      metrics.status_code = status_line.status_code;
+    }
+  }
+
+  _az_http_policy_metrics_record(options, &metrics);
+
+  return metrics.result;
+}
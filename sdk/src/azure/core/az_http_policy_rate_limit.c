@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_private.h"
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_config_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define _az_RATE_LIMITER_USEC_PER_SECOND 1000000
+
+static az_http_status_code const _az_rate_limiter_throttling_status_codes[] = {
+  AZ_HTTP_STATUS_CODE_TOO_MANY_REQUESTS,
+  AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE,
+  AZ_HTTP_STATUS_CODE_END_OF_LIST,
+};
+
+void az_http_rate_limiter_init(
+    az_http_rate_limiter* out_limiter,
+    az_http_rate_limiter_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_limiter);
+
+  out_limiter->_internal.options
+      = options == NULL ? az_http_rate_limiter_options_default() : *options;
+  _az_PRECONDITION(out_limiter->_internal.options.requests_per_second > 0);
+  _az_PRECONDITION(out_limiter->_internal.options.burst > 0);
+
+  out_limiter->_internal.full_at_usec = 0;
+  out_limiter->_internal.requests_per_second
+      = (uint64_t)out_limiter->_internal.options.requests_per_second;
+}
+
+static uint64_t _az_rate_limiter_now_usec(void)
+{
+  int64_t const now_msec = az_platform_clock_msec();
+  return now_msec > 0 ? (uint64_t)now_msec * _az_TIME_MICROSECONDS_PER_MILLISECOND : 0;
+}
+
+// The time it takes to refill one token at the current rate.
+static uint64_t _az_rate_limiter_interval_usec(az_http_rate_limiter* ref_limiter)
+{
+  return _az_RATE_LIMITER_USEC_PER_SECOND
+      / _az_atomic_load(&ref_limiter->_internal.requests_per_second);
+}
+
+// Takes a token, and returns how long to wait for it. The bucket holds `burst` tokens while
+// `full_at_usec` is in the past, and one less for each interval it is in the future.
+static uint64_t _az_rate_limiter_take(az_http_rate_limiter* ref_limiter, uint64_t now_usec)
+{
+  uint64_t const interval_usec = _az_rate_limiter_interval_usec(ref_limiter);
+  uint64_t const burst_usec = interval_usec * (uint64_t)ref_limiter->_internal.options.burst;
+
+  uint64_t full_at_usec = _az_atomic_load(&ref_limiter->_internal.full_at_usec);
+  uint64_t next_full_at_usec = 0;
+  do
+  {
+    next_full_at_usec = (full_at_usec > now_usec ? full_at_usec : now_usec) + interval_usec;
+  } while (!_az_atomic_compare_exchange(
+      &ref_limiter->_internal.full_at_usec, &full_at_usec, next_full_at_usec));
+
+  return next_full_at_usec > now_usec + burst_usec ? next_full_at_usec - now_usec - burst_usec : 0;
+}
+
+// Lowers the rate after a throttling response, and keeps the bucket empty until its Retry-After
+// has passed.
+static void _az_rate_limiter_throttled(
+    az_http_rate_limiter* ref_limiter,
+    uint64_t now_usec,
+    int32_t retry_after_msec)
+{
+  uint64_t rate = _az_atomic_load(&ref_limiter->_internal.requests_per_second);
+  while (rate > 1
+         && !_az_atomic_compare_exchange(
+             &ref_limiter->_internal.requests_per_second, &rate, rate / 2))
+  {
+    // Another request changed the rate, halve its new value.
+  }
+
+  if (retry_after_msec <= 0)
+  {
+    return;
+  }
+
+  uint64_t const interval_usec = _az_rate_limiter_interval_usec(ref_limiter);
+  uint64_t const empty_until_usec = now_usec
+      + (uint64_t)retry_after_msec * _az_TIME_MICROSECONDS_PER_MILLISECOND
+      + interval_usec * (uint64_t)(ref_limiter->_internal.options.burst - 1);
+
+  uint64_t full_at_usec = _az_atomic_load(&ref_limiter->_internal.full_at_usec);
+  while (full_at_usec < empty_until_usec
+         && !_az_atomic_compare_exchange(
+             &ref_limiter->_internal.full_at_usec, &full_at_usec, empty_until_usec))
+  {
+    // Another request took a token, retry with the new time it is full at.
+  }
+}
+
+// Raises the rate back towards the configured one after a successful response.
+static void _az_rate_limiter_succeeded(az_http_rate_limiter* ref_limiter)
+{
+  uint64_t const max_rate = (uint64_t)ref_limiter->_internal.options.requests_per_second;
+  uint64_t rate = _az_atomic_load(&ref_limiter->_internal.requests_per_second);
+  while (rate < max_rate)
+  {
+    uint64_t const step = rate / 16 > 0 ? rate / 16 : 1;
+    uint64_t const next_rate = rate + step < max_rate ? rate + step : max_rate;
+    if (_az_atomic_compare_exchange(&ref_limiter->_internal.requests_per_second, &rate, next_rate))
+    {
+      break;
+    }
+  }
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_rate_limit(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_http_rate_limiter* const limiter = (az_http_rate_limiter*)ref_options;
+  if (limiter == NULL)
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_RATE_LIMIT, ref_request, ref_response);
+  }
+
+  uint64_t const wait_usec = _az_rate_limiter_take(limiter, _az_rate_limiter_now_usec());
+  if (wait_usec > 0)
+  {
+    // Round up, so that the token has been refilled by the end of the wait.
+    uint64_t const wait_msec = (wait_usec + _az_TIME_MICROSECONDS_PER_MILLISECOND - 1)
+        / _az_TIME_MICROSECONDS_PER_MILLISECOND;
+    _az_RETURN_IF_FAILED(az_platform_wait_msec(
+        ref_request->_internal.context, wait_msec < INT32_MAX ? (int32_t)wait_msec : INT32_MAX));
+  }
+
+  az_result const result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_RATE_LIMIT, ref_request, ref_response);
+  if (!limiter->_internal.options.is_adaptive || az_result_failed(result))
+  {
+    return result;
+  }
+
+  // Reading the headers moves the parser of the response, so it reads those of a copy.
+  az_http_response response_copy = *ref_response;
+  bool is_throttled = false;
+  int32_t retry_after_msec = -1;
+  if (az_result_succeeded(_az_http_policy_retry_get_retry_after(
+          &response_copy,
+          _az_rate_limiter_throttling_status_codes,
+          &is_throttled,
+          &retry_after_msec)))
+  {
+    if (is_throttled)
+    {
+      _az_rate_limiter_throttled(limiter, _az_rate_limiter_now_usec(), retry_after_msec);
+    }
+    else
+    {
+      _az_rate_limiter_succeeded(limiter);
+    }
+  }
+
+  return result;
+}
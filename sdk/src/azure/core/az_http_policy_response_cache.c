@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_private.h"
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+static az_span const _az_http_response_cache_etag = AZ_SPAN_LITERAL_FROM_STR("ETag");
+static az_span const _az_http_response_cache_if_none_match
+    = AZ_SPAN_LITERAL_FROM_STR("If-None-Match");
+
+// The headers of a response the policy looks for the `ETag` in.
+#define _az_HTTP_RESPONSE_CACHE_MAX_HEADERS 32
+
+AZ_NODISCARD az_result
+az_http_response_cache_init(az_http_response_cache* out_cache, az_span memory, int32_t slot_count)
+{
+  _az_PRECONDITION_NOT_NULL(out_cache);
+  _az_PRECONDITION_RANGE(1, slot_count, AZ_HTTP_RESPONSE_CACHE_MAX_ENTRIES);
+
+  int32_t const slot_size = az_span_size(memory) / slot_count;
+  if (slot_size == 0)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  out_cache->_internal.lock = 0;
+  out_cache->_internal.slot_size = slot_size;
+  out_cache->_internal.entry_count = slot_count;
+  out_cache->_internal.use_count = 0;
+  for (int32_t i = 0; i < slot_count; i++)
+  {
+    _az_http_response_cache_entry* const entry = &out_cache->_internal.entries[i];
+    entry->_internal.buffer = az_span_ptr(memory) + (i * slot_size);
+    entry->_internal.key_size = 0;
+    entry->_internal.response_size = 0;
+    entry->_internal.etag_size = 0;
+    entry->_internal.last_used = 0;
+  }
+
+  return AZ_OK;
+}
+
+// Called with the lock held.
+static _az_http_response_cache_entry*
+_az_http_response_cache_find(az_http_response_cache* ref_cache, az_span key)
+{
+  for (int32_t i = 0; i < ref_cache->_internal.entry_count; i++)
+  {
+    _az_http_response_cache_entry* const entry = &ref_cache->_internal.entries[i];
+    if (entry->_internal.response_size > 0
+        && az_span_is_content_equal(
+            az_span_create(entry->_internal.buffer, entry->_internal.key_size), key))
+    {
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+// Called with the lock held. Stores the response in the entry of the same request, or else in the
+// least recently used one.
+static void _az_http_response_cache_store(
+    az_http_response_cache* ref_cache,
+    az_span key,
+    az_span response,
+    az_span etag)
+{
+  _az_http_response_cache_entry* entry = _az_http_response_cache_find(ref_cache, key);
+  for (int32_t i = 0; entry == NULL && i < ref_cache->_internal.entry_count; i++)
+  {
+    _az_http_response_cache_entry* const candidate = &ref_cache->_internal.entries[i];
+    if (entry == NULL || candidate->_internal.last_used < entry->_internal.last_used)
+    {
+      entry = candidate;
+    }
+  }
+
+  az_span const slot = az_span_create(entry->_internal.buffer, ref_cache->_internal.slot_size);
+  az_span_copy(az_span_copy(slot, key), response);
+  az_span_copy(AZ_SPAN_FROM_BUFFER(entry->_internal.etag), etag);
+  entry->_internal.key_size = az_span_size(key);
+  entry->_internal.response_size = az_span_size(response);
+  entry->_internal.etag_size = az_span_size(etag);
+  entry->_internal.last_used = ++ref_cache->_internal.use_count;
+}
+
+// Called with the lock held. Copies the cached response in place of the `304 Not Modified` one,
+// unless it was replaced since the request was sent, in which case the caller gets the 304.
+static AZ_NODISCARD az_result _az_http_response_cache_serve(
+    az_http_response_cache* ref_cache,
+    az_span key,
+    az_span etag,
+    az_http_response* ref_response)
+{
+  _az_http_response_cache_entry* const entry = _az_http_response_cache_find(ref_cache, key);
+  if (entry == NULL
+      || !az_span_is_content_equal(
+          az_span_create(entry->_internal.etag, entry->_internal.etag_size), etag))
+  {
+    return AZ_OK;
+  }
+
+  _az_http_response_reset(ref_response);
+  _az_RETURN_IF_FAILED(az_http_response_append(
+      ref_response,
+      az_span_create(
+          entry->_internal.buffer + entry->_internal.key_size, entry->_internal.response_size)));
+
+  entry->_internal.last_used = ++ref_cache->_internal.use_count;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_response_cache(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_http_response_cache* const cache = (az_http_response_cache*)ref_options;
+
+  // A request which is already conditional is the caller's to validate, and a response streamed to
+  // a sink can't be kept.
+  az_span condition = AZ_SPAN_EMPTY;
+  if (cache == NULL || ref_response->_internal.body_sink.callback != NULL
+      || !az_span_is_content_equal(ref_request->_internal.method, az_http_method_get())
+      || az_result_succeeded(az_http_request_get_header_by_name(
+          ref_request, _az_http_response_cache_if_none_match, &condition)))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_RESPONSE_CACHE, ref_request, ref_response);
+  }
+
+  uint8_t key_buffer[AZ_HTTP_RESPONSE_CACHE_MAX_KEY_SIZE];
+  az_span key = AZ_SPAN_EMPTY;
+  if (az_result_failed(
+          _az_http_request_write_key(ref_request, AZ_SPAN_FROM_BUFFER(key_buffer), &key)))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_RESPONSE_CACHE, ref_request, ref_response);
+  }
+
+  uint8_t etag_buffer[AZ_HTTP_RESPONSE_CACHE_MAX_ETAG_SIZE];
+  az_span etag = AZ_SPAN_EMPTY;
+
+  _az_atomic_spin_lock(&cache->_internal.lock);
+  _az_http_response_cache_entry* const cached = _az_http_response_cache_find(cache, key);
+  if (cached != NULL)
+  {
+    etag = az_span_slice(AZ_SPAN_FROM_BUFFER(etag_buffer), 0, cached->_internal.etag_size);
+    az_span_copy(etag, az_span_create(cached->_internal.etag, cached->_internal.etag_size));
+  }
+  _az_atomic_spin_unlock(&cache->_internal.lock);
+
+  // The header refers to etag_buffer, so it is removed before this policy returns.
+  int32_t const headers_length = ref_request->_internal.headers_length;
+  bool const is_conditional = cached != NULL
+      && az_result_succeeded(
+          az_http_request_append_header(ref_request, _az_http_response_cache_if_none_match, etag));
+
+  az_result result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_RESPONSE_CACHE, ref_request, ref_response);
+  ref_request->_internal.headers_length = headers_length;
+  _az_RETURN_IF_FAILED(result);
+
+  az_http_response_status_line status_line = { 0 };
+  if (az_result_failed(az_http_response_get_status_line(ref_response, &status_line)))
+  {
+    return result;
+  }
+
+  if (is_conditional && status_line.status_code == AZ_HTTP_STATUS_CODE_NOT_MODIFIED)
+  {
+    _az_atomic_spin_lock(&cache->_internal.lock);
+    result = _az_http_response_cache_serve(cache, key, etag, ref_response);
+    _az_atomic_spin_unlock(&cache->_internal.lock);
+    return result;
+  }
+
+  if (status_line.status_code != AZ_HTTP_STATUS_CODE_OK)
+  {
+    return result;
+  }
+
+  az_http_response_header headers_buffer[_az_HTTP_RESPONSE_CACHE_MAX_HEADERS];
+  az_http_response_headers headers = { 0 };
+  az_span response_etag = AZ_SPAN_EMPTY;
+  az_span const response
+      = az_span_slice(ref_response->_internal.http_response, 0, ref_response->_internal.written);
+  if (az_result_succeeded(az_http_response_parse_headers(
+          ref_response, headers_buffer, _az_HTTP_RESPONSE_CACHE_MAX_HEADERS, &headers))
+      && az_result_succeeded(
+          az_http_response_headers_find(&headers, _az_http_response_cache_etag, &response_etag))
+      && az_span_size(response_etag) > 0
+      && az_span_size(response_etag) <= AZ_HTTP_RESPONSE_CACHE_MAX_ETAG_SIZE
+      && az_span_size(key) + az_span_size(response) <= cache->_internal.slot_size)
+  {
+    _az_atomic_spin_lock(&cache->_internal.lock);
+    _az_http_response_cache_store(cache, key, response, response_etag);
+    _az_atomic_spin_unlock(&cache->_internal.lock);
+  }
+
+  return result;
+}
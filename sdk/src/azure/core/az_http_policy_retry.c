@@ -4,12 +4,14 @@
 #include "az_http_private.h"
 #include <azure/core/az_config.h>
 #include <azure/core/az_platform.h>
+#include <azure/core/internal/az_atomic_internal.h>
 #include <azure/core/internal/az_config_internal.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_log_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_retry_internal.h>
 #include <azure/core/internal/az_span_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -32,6 +34,9 @@ AZ_NODISCARD az_http_policy_retry_options _az_http_policy_retry_options_default(
     .max_retry_delay_msec
     = 2 * _az_TIME_SECONDS_PER_MINUTE * _az_TIME_MILLISECONDS_PER_SECOND, // 2 minutes
     .status_codes = _default_status_codes,
+    .jitter = AZ_HTTP_POLICY_RETRY_JITTER_NONE,
+    .wait_callback = NULL,
+    .wait_user_context = NULL,
   };
 }
 
@@ -64,6 +69,12 @@ AZ_INLINE az_result _az_http_policy_retry_append_http_retry_msg(
 
 AZ_INLINE void _az_http_policy_retry_log(int32_t attempt, int32_t delay_msec)
 {
+  // Checked for each attempt, so that a message dropped by a log limit is never formatted.
+  if (!_az_LOG_SHOULD_WRITE(AZ_LOG_HTTP_RETRY))
+  {
+    return;
+  }
+
   uint8_t log_msg_buf[AZ_LOG_MESSAGE_BUFFER_SIZE] = { 0 };
   az_span log_msg = AZ_SPAN_FROM_BUFFER(log_msg_buf);
 
@@ -83,7 +94,7 @@ AZ_INLINE AZ_NODISCARD int32_t _az_uint32_span_to_int32(az_span span)
   return value < INT32_MAX ? (int32_t)value : INT32_MAX;
 }
 
-AZ_INLINE AZ_NODISCARD az_result _az_http_policy_retry_get_retry_after(
+AZ_NODISCARD az_result _az_http_policy_retry_get_retry_after(
     az_http_response* ref_response,
     az_http_status_code const* status_codes,
     bool* should_retry,
@@ -166,16 +177,17 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
 
   az_context* const context = ref_request->_internal.context;
 
-  bool const should_log = _az_LOG_SHOULD_WRITE(AZ_LOG_HTTP_RETRY);
   az_result result = AZ_OK;
   int32_t attempt = 1;
+  int32_t previous_delay_msec = retry_delay_msec;
+  uint32_t random_state = 0;
   while (true)
   {
-    _az_RETURN_IF_FAILED(
-        az_http_response_init(ref_response, ref_response->_internal.http_response));
+    _az_http_response_reset(ref_response);
     _az_RETURN_IF_FAILED(_az_http_request_remove_retry_headers(ref_request));
 
-    result = _az_http_pipeline_nextpolicy(ref_policies, ref_request, ref_response);
+    result = _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_RETRY, ref_request, ref_response);
 
     // Even HTTP 429, or 502 are expected to be AZ_OK, so the failed result is not retriable.
     if (attempt > max_retries || az_result_failed(result))
@@ -198,15 +210,54 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
 
     if (retry_after_msec < 0)
     { // there wasn't any kind of "retry-after" response header
-      retry_after_msec = _az_retry_calc_delay(attempt, retry_delay_msec, max_retry_delay_msec);
+      if (retry_options->jitter == AZ_HTTP_POLICY_RETRY_JITTER_DECORRELATED)
+      {
+        if (random_state == 0)
+        {
+          // Seed from the clock and the request address, so that clients which failed together
+          // don't pick the same delays. Zero is the only state xorshift cannot leave.
+          random_state = (uint32_t)az_platform_clock_msec() ^ (uint32_t)(uintptr_t)ref_request;
+          random_state = random_state == 0 ? 1 : random_state;
+        }
+
+        retry_after_msec = _az_retry_calc_decorrelated_delay(
+            _az_retry_next_random(&random_state),
+            previous_delay_msec,
+            retry_delay_msec,
+            max_retry_delay_msec);
+      }
+      else
+      {
+        retry_after_msec = _az_retry_calc_delay(attempt, retry_delay_msec, max_retry_delay_msec);
+      }
+
+      previous_delay_msec = retry_after_msec;
     }
 
-    if (should_log)
+    // Don't wait for a retry which could only start after the context has expired.
+    if (context != NULL)
     {
-      _az_http_policy_retry_log(attempt, retry_after_msec);
+      int64_t const expiration = az_context_get_expiration(context);
+      if (expiration != _az_CONTEXT_MAX_EXPIRATION
+          && az_platform_clock_msec() + retry_after_msec >= expiration)
+      {
+        return AZ_ERROR_CANCELED;
+      }
     }
 
-    az_platform_sleep_msec(retry_after_msec);
+    _az_http_policy_retry_log(attempt, retry_after_msec);
+    _az_TRACEPOINT3(http_retry_attempt, ref_request, attempt, retry_after_msec);
+
+    if (retry_options->wait_callback != NULL)
+    {
+      _az_RETURN_IF_FAILED(
+          retry_options->wait_callback(retry_options->wait_user_context, retry_after_msec));
+    }
+    else
+    {
+      // Stops waiting as soon as the context is canceled, rather than after the whole delay.
+      _az_RETURN_IF_FAILED(az_platform_wait_msec(context, retry_after_msec));
+    }
 
     if (context != NULL && az_context_has_expired(context, az_platform_clock_msec()))
     {
@@ -216,3 +267,193 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
 
   return result;
 }
+
+enum
+{
+  // The longest the hedge policy waits for network activity before checking the context again.
+  _az_HTTP_POLICY_HEDGE_POLL_MSEC = 100,
+};
+
+AZ_NODISCARD _az_http_policy_hedge_options _az_http_policy_hedge_options_default()
+{
+  return (_az_http_policy_hedge_options){
+    .async_client = NULL,
+    .hedge_response_buffer = AZ_SPAN_EMPTY,
+    .percentile = 95,
+    .initial_delay_msec = 500,
+    ._internal = {
+      .latency_count = 0,
+      .next_latency = 0,
+      .lock = 0,
+    },
+  };
+}
+
+// The latency below which the configured percentile of the recent requests completed.
+static AZ_NODISCARD int32_t _az_http_policy_hedge_delay(_az_http_policy_hedge_options* ref_options)
+{
+  // The latencies are copied under the lock, so that the requests of a shared pipeline can record
+  // theirs meanwhile, and sorted once it is released.
+  int32_t latencies[_az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT];
+  _az_atomic_spin_lock(&ref_options->_internal.lock);
+  int32_t const count = ref_options->_internal.latency_count;
+  for (int32_t i = 0; i < count; i++)
+  {
+    latencies[i] = ref_options->_internal.latencies_msec[i];
+  }
+  _az_atomic_spin_unlock(&ref_options->_internal.lock);
+
+  if (count < _az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT)
+  {
+    return ref_options->initial_delay_msec;
+  }
+
+  int32_t sorted[_az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT];
+  for (int32_t i = 0; i < count; i++)
+  {
+    int32_t const latency = latencies[i];
+    int32_t j = i;
+    for (; j > 0 && sorted[j - 1] > latency; j--)
+    {
+      sorted[j] = sorted[j - 1];
+    }
+
+    sorted[j] = latency;
+  }
+
+  // Nearest rank.
+  int32_t const rank = (ref_options->percentile * count + 99) / 100;
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void _az_http_policy_hedge_record_latency(
+    _az_http_policy_hedge_options* ref_options,
+    int64_t latency_msec)
+{
+  _az_atomic_spin_lock(&ref_options->_internal.lock);
+  ref_options->_internal.latencies_msec[ref_options->_internal.next_latency]
+      = latency_msec < INT32_MAX ? (int32_t)latency_msec : INT32_MAX;
+  ref_options->_internal.next_latency
+      = (ref_options->_internal.next_latency + 1) % _az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT;
+
+  if (ref_options->_internal.latency_count < _az_HTTP_POLICY_HEDGE_LATENCY_SAMPLE_COUNT)
+  {
+    ref_options->_internal.latency_count++;
+  }
+  _az_atomic_spin_unlock(&ref_options->_internal.lock);
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_hedge(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  _az_http_policy_hedge_options* const options = (_az_http_policy_hedge_options*)ref_options;
+  az_http_client_async* const client = options->async_client;
+
+  // Only requests which can safely be sent twice are hedged. A body sink would see both bodies.
+  if (client == NULL || ref_response->_internal.body_sink.callback != NULL
+      || !(az_span_is_content_equal(ref_request->_internal.method, az_http_method_get())
+           || az_span_is_content_equal(ref_request->_internal.method, az_http_method_head())))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, az_http_pipeline_policy_transport, ref_request, ref_response);
+  }
+
+  az_context* const context = ref_request->_internal.context;
+  int64_t const start = az_platform_clock_msec();
+  int64_t const hedge_time = start + _az_http_policy_hedge_delay(options);
+
+  az_http_response hedge_response;
+  _az_RETURN_IF_FAILED(az_http_response_init(&hedge_response, options->hedge_response_buffer));
+
+  az_http_client_async_operation primary;
+  az_http_client_async_operation hedge;
+  _az_RETURN_IF_FAILED(az_http_client_async_submit(client, &primary, ref_request, ref_response));
+
+  bool hedged = false;
+  az_http_client_async_operation* winner = NULL;
+  az_result result = AZ_OK;
+  while (true)
+  {
+    bool const primary_done = az_http_client_async_operation_is_completed(&primary);
+    bool const hedge_done = hedged && az_http_client_async_operation_is_completed(&hedge);
+
+    // The first successful response wins. A failure only counts once there is nothing else to
+    // wait for.
+    if (primary_done
+        && (az_result_succeeded(az_http_client_async_operation_get_result(&primary)) || !hedged
+            || hedge_done))
+    {
+      winner = &primary;
+      break;
+    }
+
+    if (hedge_done
+        && (az_result_succeeded(az_http_client_async_operation_get_result(&hedge)) || primary_done))
+    {
+      winner = &hedge;
+      break;
+    }
+
+    int64_t const now = az_platform_clock_msec();
+    if (context != NULL && az_context_has_expired(context, now))
+    {
+      result = AZ_ERROR_CANCELED;
+      break;
+    }
+
+    if (!hedged && now >= hedge_time)
+    {
+      result = az_http_client_async_submit(client, &hedge, ref_request, &hedge_response);
+      if (az_result_failed(result))
+      {
+        break;
+      }
+
+      hedged = true;
+      continue;
+    }
+
+    int64_t wait_msec = hedged ? _az_HTTP_POLICY_HEDGE_POLL_MSEC : hedge_time - now;
+    if (wait_msec > _az_HTTP_POLICY_HEDGE_POLL_MSEC)
+    {
+      wait_msec = _az_HTTP_POLICY_HEDGE_POLL_MSEC;
+    }
+
+    result = az_http_client_async_poll(client, (int32_t)wait_msec, NULL);
+    if (az_result_failed(result))
+    {
+      break;
+    }
+  }
+
+  // The operations live on this stack frame, so none of them can be left in flight.
+  az_http_client_async_cancel(client, &primary);
+  if (hedged)
+  {
+    az_http_client_async_cancel(client, &hedge);
+  }
+
+  if (winner == NULL)
+  {
+    return result;
+  }
+
+  result = az_http_client_async_operation_get_result(winner);
+  if (az_result_succeeded(result))
+  {
+    _az_http_policy_hedge_record_latency(options, az_platform_clock_msec() - start);
+  }
+
+  if (winner == &hedge)
+  {
+    _az_http_response_reset(ref_response);
+    _az_RETURN_IF_FAILED(az_http_response_append(
+        ref_response,
+        az_span_slice(options->hedge_response_buffer, 0, hedge_response._internal.written)));
+  }
+
+  return result;
+}
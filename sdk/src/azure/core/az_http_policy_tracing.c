@@ -0,0 +1,242 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_hex_private.h"
+#include <azure/core/az_context.h>
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+static az_span const _az_http_tracing_traceparent = AZ_SPAN_LITERAL_FROM_STR("traceparent");
+
+// Only its address is used, as the key of the trace context in an az_context.
+static uint8_t const _az_http_trace_context_key = 0;
+
+AZ_NODISCARD az_context
+az_http_trace_context_create(az_context const* parent, az_http_trace_context const* trace_context)
+{
+  _az_PRECONDITION_NOT_NULL(parent);
+  _az_PRECONDITION_NOT_NULL(trace_context);
+
+  return az_context_create_with_value(parent, &_az_http_trace_context_key, trace_context);
+}
+
+static uint8_t*
+_az_http_trace_context_write_hex(uint8_t* destination, uint8_t const* id, int32_t size)
+{
+  for (int32_t i = 0; i < size; i++)
+  {
+    *destination++ = _az_number_to_lower_hex((uint8_t)(id[i] >> 4));
+    *destination++ = _az_number_to_lower_hex((uint8_t)(id[i] & 0x0F));
+  }
+
+  return destination;
+}
+
+AZ_NODISCARD az_result az_http_trace_context_get_traceparent(
+    az_http_trace_context const* trace_context,
+    az_span buffer,
+    az_span* out_traceparent)
+{
+  _az_PRECONDITION_NOT_NULL(trace_context);
+  _az_PRECONDITION_NOT_NULL(out_traceparent);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(buffer, AZ_HTTP_TRACEPARENT_SIZE);
+
+  // version "-" trace-id "-" parent-id "-" trace-flags
+  uint8_t* destination = az_span_ptr(buffer);
+  *destination++ = '0';
+  *destination++ = '0';
+  *destination++ = '-';
+  destination = _az_http_trace_context_write_hex(
+      destination, trace_context->trace_id, AZ_HTTP_TRACE_ID_SIZE);
+  *destination++ = '-';
+  destination = _az_http_trace_context_write_hex(
+      destination, trace_context->span_id, AZ_HTTP_TRACE_SPAN_ID_SIZE);
+  *destination++ = '-';
+  *destination++ = '0';
+  *destination = trace_context->is_sampled ? '1' : '0';
+
+  *out_traceparent = az_span_slice(buffer, 0, AZ_HTTP_TRACEPARENT_SIZE);
+  return AZ_OK;
+}
+
+void az_http_tracer_init(
+    az_http_tracer* out_tracer,
+    az_http_trace_span* spans,
+    int32_t span_capacity,
+    az_http_tracer_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_tracer);
+  _az_PRECONDITION(span_capacity >= 0);
+  _az_PRECONDITION(spans != NULL || span_capacity == 0);
+
+  out_tracer->_internal.options = options == NULL ? az_http_tracer_options_default() : *options;
+  _az_PRECONDITION(out_tracer->_internal.options.sample_one_in >= 0);
+
+  out_tracer->_internal.spans = spans;
+  out_tracer->_internal.span_capacity = span_capacity;
+  out_tracer->_internal.span_count = 0;
+
+  // Tracers seeded at the same time still start apart, and xorshift can't leave a state of zero.
+  uint64_t seed = out_tracer->_internal.options.seed;
+  if (seed == 0)
+  {
+    seed = (uint64_t)az_platform_clock_msec() ^ (uint64_t)(uintptr_t)out_tracer;
+  }
+  out_tracer->_internal.random_state = seed == 0 ? 1 : seed;
+}
+
+// xorshift64*, which never returns zero, so that the IDs it writes are valid ones.
+static uint64_t _az_http_tracer_next_random(az_http_tracer* ref_tracer)
+{
+  uint64_t state = _az_atomic_load(&ref_tracer->_internal.random_state);
+  uint64_t next = 0;
+  do
+  {
+    next = state;
+    next ^= next >> 12;
+    next ^= next << 25;
+    next ^= next >> 27;
+  } while (!_az_atomic_compare_exchange(&ref_tracer->_internal.random_state, &state, next));
+
+  return next * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+static void _az_http_tracer_write_id(az_http_tracer* ref_tracer, uint8_t* id, int32_t size)
+{
+  for (int32_t i = 0; i < size; i += (int32_t)sizeof(uint64_t))
+  {
+    uint64_t const random = _az_http_tracer_next_random(ref_tracer);
+    memcpy(id + i, &random, sizeof(uint64_t));
+  }
+}
+
+// Decides whether a new trace is sampled. A random number is only drawn when some, but not all, of
+// the traces are.
+static bool _az_http_tracer_should_sample(az_http_tracer* ref_tracer)
+{
+  int32_t const sample_one_in = ref_tracer->_internal.options.sample_one_in;
+  return sample_one_in == 1
+      || (sample_one_in > 1
+          && _az_http_tracer_next_random(ref_tracer) % (uint64_t)sample_one_in == 0);
+}
+
+void az_http_tracer_start_trace(
+    az_http_tracer* ref_tracer,
+    az_http_trace_context* out_trace_context)
+{
+  _az_PRECONDITION_NOT_NULL(ref_tracer);
+  _az_PRECONDITION_NOT_NULL(out_trace_context);
+
+  _az_http_tracer_write_id(ref_tracer, out_trace_context->trace_id, AZ_HTTP_TRACE_ID_SIZE);
+  _az_http_tracer_write_id(ref_tracer, out_trace_context->span_id, AZ_HTTP_TRACE_SPAN_ID_SIZE);
+  out_trace_context->is_sampled = _az_http_tracer_should_sample(ref_tracer);
+}
+
+AZ_NODISCARD int32_t az_http_tracer_get_span_count(az_http_tracer const* tracer)
+{
+  _az_PRECONDITION_NOT_NULL(tracer);
+
+  uint64_t const span_count = _az_atomic_load(&tracer->_internal.span_count);
+  return span_count < (uint64_t)tracer->_internal.span_capacity ? (int32_t)span_count
+                                                                 : tracer->_internal.span_capacity;
+}
+
+static void _az_http_tracer_record(az_http_tracer* ref_tracer, az_http_trace_span const* span)
+{
+  uint64_t index = _az_atomic_load(&ref_tracer->_internal.span_count);
+  while (!_az_atomic_compare_exchange(&ref_tracer->_internal.span_count, &index, index + 1))
+  {
+    // Another request recorded its span, retry with the next index.
+  }
+
+  if (index < (uint64_t)ref_tracer->_internal.span_capacity)
+  {
+    ref_tracer->_internal.spans[index] = *span;
+  }
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_tracing(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_http_tracer* const tracer = (az_http_tracer*)ref_options;
+  if (tracer == NULL)
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_TRACING, ref_request, ref_response);
+  }
+
+  az_http_trace_context const* parent = NULL;
+  void const* value = NULL;
+  if (az_result_succeeded(az_context_get_value(
+          ref_request->_internal.context, &_az_http_trace_context_key, &value)))
+  {
+    parent = (az_http_trace_context const*)value;
+  }
+
+  if (parent != NULL ? !parent->is_sampled : !_az_http_tracer_should_sample(tracer))
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_TRACING, ref_request, ref_response);
+  }
+
+  az_http_trace_span span = { 0 };
+  if (parent != NULL)
+  {
+    memcpy(span.context.trace_id, parent->trace_id, AZ_HTTP_TRACE_ID_SIZE);
+    memcpy(span.parent_span_id, parent->span_id, AZ_HTTP_TRACE_SPAN_ID_SIZE);
+  }
+  else
+  {
+    _az_http_tracer_write_id(tracer, span.context.trace_id, AZ_HTTP_TRACE_ID_SIZE);
+  }
+  _az_http_tracer_write_id(tracer, span.context.span_id, AZ_HTTP_TRACE_SPAN_ID_SIZE);
+  span.context.is_sampled = true;
+
+  // The header refers to traceparent_buffer, so it is removed before this policy returns. The
+  // request is still sent when its headers buffer has no room left for it.
+  uint8_t traceparent_buffer[AZ_HTTP_TRACEPARENT_SIZE];
+  az_span traceparent = AZ_SPAN_EMPTY;
+  int32_t const headers_length = ref_request->_internal.headers_length;
+  if (az_result_succeeded(az_http_trace_context_get_traceparent(
+          &span.context, AZ_SPAN_FROM_BUFFER(traceparent_buffer), &traceparent)))
+  {
+    az_result const append_result
+        = az_http_request_append_header(ref_request, _az_http_tracing_traceparent, traceparent);
+    (void)append_result;
+  }
+
+  span.start_msec = az_platform_clock_msec();
+  span.result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_TRACING, ref_request, ref_response);
+  span.end_msec = az_platform_clock_msec();
+  ref_request->_internal.headers_length = headers_length;
+
+  if (az_result_succeeded(span.result))
+  {
+    // Parsing moves the response forward, so a copy is parsed.
+    az_http_response response_copy = *ref_response;
+    az_http_response_status_line status_line = { 0 };
+    if (az_result_succeeded(az_http_response_get_status_line(&response_copy, &status_line)))
+    {
+      span.status_code = status_line.status_code;
+    }
+  }
+
+  _az_http_tracer_record(tracer, &span);
+  return span.result;
+}
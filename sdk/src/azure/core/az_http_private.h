@@ -41,6 +41,41 @@ AZ_NODISCARD AZ_INLINE az_result _az_http_request_remove_retry_headers(az_http_r
   return AZ_OK;
 }
 
+/**
+ * @brief Writes the method, URL and headers which make two requests identical, as
+ * `"METHOD URL\n"` followed by `"name:value\n"` for each header, so that policies can compare or
+ * look up requests.
+ *
+ * @param request The request.
+ * @param key The buffer to write the key to.
+ * @param[out] out_key The part of \p key which was written.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - *`AZ_ERROR_NOT_ENOUGH_SPACE`* the key doesn't fit \p key.
+ */
+AZ_NODISCARD az_result
+_az_http_request_write_key(az_http_request const* request, az_span key, az_span* out_key);
+
+/**
+ * @brief Finds out whether a response has one of the \p status_codes, and how long its
+ * `retry-after-ms`, `x-ms-retry-after-ms` or `Retry-After` header asks to wait.
+ *
+ * @param ref_response The response, whose status line and headers are parsed.
+ * @param status_codes The status codes to look for, ending with #AZ_HTTP_STATUS_CODE_END_OF_LIST.
+ * @param[out] should_retry Whether the response has one of the \p status_codes.
+ * @param[out] retry_after_msec The time to wait, or `-1` if the response doesn't say.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - other the status line of the response is invalid.
+ */
+AZ_NODISCARD az_result _az_http_policy_retry_get_retry_after(
+    az_http_response* ref_response,
+    az_http_status_code const* status_codes,
+    bool* should_retry,
+    int32_t* retry_after_msec);
+
 /**
  * @brief Sets buffer and parser to its initial state.
  *
@@ -8,6 +8,7 @@
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
@@ -31,17 +32,6 @@ AZ_NODISCARD az_result az_http_request_init(
   _az_PRECONDITION_VALID_SPAN(url, 1, false);
   _az_PRECONDITION_VALID_SPAN(headers_buffer, 0, false);
 
-  int32_t query_start = 0;
-  uint8_t const* const ptr = az_span_ptr(url);
-  for (; query_start < url_length; ++query_start)
-  {
-    uint8_t next_byte = ptr[query_start];
-    if (next_byte == '?')
-    {
-      break;
-    }
-  }
-
   *out_request
       = (az_http_request){ ._internal = {
                                .context = context,
@@ -51,14 +41,54 @@ AZ_NODISCARD az_result az_http_request_init(
                                /* query start is set to 0 if there is not a question mark so the
                                   next time query parameter is appended, a question mark will be
                                   added at url length. (+1 jumps the `?`) */
-                               .query_start = query_start == url_length ? 0 : query_start + 1,
+                               .query_start
+                               = _az_http_url_get_query_start(az_span_slice(url, 0, url_length)),
                                .headers = headers_buffer,
                                .headers_length = 0,
                                .max_headers = az_span_size(headers_buffer)
                                    / (int32_t)sizeof(_az_http_request_header),
                                .retry_headers_start_byte_offset = 0,
                                .body = body,
+                               .body_provider = NULL,
+                               .body_provider_user_context = NULL,
+                               .body_provider_size = 0,
+                               .body_segments = NULL,
+                               .body_segment_count = 0,
                            } };
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_HTTP_REQUEST_URL, url_length);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD int32_t _az_http_url_get_query_start(az_span url)
+{
+  int32_t const query_separator = az_span_find(url, AZ_SPAN_FROM_STR("?"));
+  return query_separator == -1 ? 0 : query_separator + 1;
+}
+
+AZ_NODISCARD az_result _az_http_request_init_from_url_prefix(
+    az_http_request* out_request,
+    az_context* context,
+    az_span method,
+    az_span url_buffer,
+    az_span url_prefix,
+    int32_t url_prefix_query_start,
+    az_span headers_buffer,
+    az_span body)
+{
+  _az_PRECONDITION_RANGE(0, url_prefix_query_start, az_span_size(url_prefix));
+
+  int32_t const url_prefix_size = az_span_size(url_prefix);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(url_buffer, url_prefix_size);
+  az_span_copy(url_buffer, url_prefix);
+
+  // The request starts with an empty URL, which isn't scanned, and is then given the prefix and
+  // the query start which was found once for it.
+  _az_RETURN_IF_FAILED(
+      az_http_request_init(out_request, context, method, url_buffer, 0, headers_buffer, body));
+  out_request->_internal.url_length = url_prefix_size;
+  out_request->_internal.query_start = url_prefix_query_start;
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_HTTP_REQUEST_URL, url_prefix_size);
 
   return AZ_OK;
 }
@@ -114,10 +144,26 @@ AZ_NODISCARD az_result az_http_request_set_query_parameter(
   }
 
   ref_request->_internal.url_length += required_length;
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_HTTP_REQUEST_URL, ref_request->_internal.url_length);
 
   return AZ_OK;
 }
 
+// FNV-1a over the lowercase name, without the top bit so that it fits in az_http_header_id.
+static AZ_NODISCARD int32_t _az_http_header_name_hash(az_span name)
+{
+  uint32_t hash = 2166136261u;
+
+  uint8_t const* const ptr = az_span_ptr(name);
+  for (int32_t i = 0; i < az_span_size(name); i++)
+  {
+    uint8_t const c = ptr[i];
+    hash = (hash ^ (uint8_t)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c)) * 16777619u;
+  }
+
+  return (int32_t)(hash & 0x7FFFFFFFu);
+}
+
 AZ_NODISCARD az_result
 az_http_request_append_header(az_http_request* ref_request, az_span name, az_span value)
 {
@@ -133,7 +179,8 @@ az_http_request_append_header(az_http_request* ref_request, az_span name, az_spa
   _az_PRECONDITION(az_http_is_valid_header_name(name));
 
   az_span headers = ref_request->_internal.headers;
-  _az_http_request_header header_to_append = { .name = name, .value = value };
+  _az_http_request_header header_to_append
+      = { .name = name, .value = value, .name_hash = _az_http_header_name_hash(name) };
 
   _az_RETURN_IF_NOT_ENOUGH_SIZE(headers, (int32_t)sizeof header_to_append);
 
@@ -144,6 +191,9 @@ az_http_request_append_header(az_http_request* ref_request, az_span name, az_spa
       az_span_create((uint8_t*)&header_to_append, sizeof header_to_append));
 
   ref_request->_internal.headers_length++;
+  _az_BUFFER_STATS_RECORD(
+      _az_BUFFER_STATS_HTTP_REQUEST_HEADERS,
+      (int32_t)sizeof(_az_http_request_header) * ref_request->_internal.headers_length);
 
   return AZ_OK;
 }
@@ -172,6 +222,77 @@ AZ_NODISCARD az_result az_http_request_get_header(
   return AZ_OK;
 }
 
+// Returns the first header whose name has this hash and is equal to this name.
+static AZ_NODISCARD az_result _az_http_request_find_header(
+    az_http_request const* request,
+    int32_t name_hash,
+    az_span name,
+    az_span* out_value)
+{
+  _az_http_request_header const* const headers
+      = (_az_http_request_header const*)az_span_ptr(request->_internal.headers);
+
+  for (int32_t i = 0; i < az_http_request_headers_count(request); i++)
+  {
+    if (headers[i].name_hash == name_hash
+        && az_span_is_content_equal_ignoring_case(headers[i].name, name))
+    {
+      *out_value = headers[i].value;
+      return AZ_OK;
+    }
+  }
+
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
+
+AZ_NODISCARD az_result az_http_request_get_header_by_name(
+    az_http_request const* request,
+    az_span name,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_VALID_SPAN(name, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  return _az_http_request_find_header(request, _az_http_header_name_hash(name), name, out_value);
+}
+
+AZ_NODISCARD az_result az_http_request_get_header_by_id(
+    az_http_request const* request,
+    az_http_header_id id,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  az_span name = AZ_SPAN_EMPTY;
+  switch (id)
+  {
+    case AZ_HTTP_HEADER_ID_AUTHORIZATION:
+      name = AZ_SPAN_FROM_STR("Authorization");
+      break;
+    case AZ_HTTP_HEADER_ID_CONTENT_LENGTH:
+      name = AZ_SPAN_FROM_STR("Content-Length");
+      break;
+    case AZ_HTTP_HEADER_ID_CONTENT_TYPE:
+      name = AZ_SPAN_FROM_STR("Content-Type");
+      break;
+    case AZ_HTTP_HEADER_ID_X_MS_CLIENT_REQUEST_ID:
+      name = AZ_SPAN_FROM_STR("x-ms-client-request-id");
+      break;
+    case AZ_HTTP_HEADER_ID_X_MS_DATE:
+      name = AZ_SPAN_FROM_STR("x-ms-date");
+      break;
+    case AZ_HTTP_HEADER_ID_X_MS_VERSION:
+      name = AZ_SPAN_FROM_STR("x-ms-version");
+      break;
+    default:
+      return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  return _az_http_request_find_header(request, (int32_t)id, name, out_value);
+}
+
 AZ_NODISCARD az_result
 az_http_request_get_method(az_http_request const* request, az_http_method* out_method)
 {
@@ -202,7 +323,195 @@ AZ_NODISCARD az_result az_http_request_get_body(az_http_request const* request,
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_http_request_set_body_provider(
+    az_http_request* ref_request,
+    int64_t body_size,
+    az_http_request_body_provider_fn body_provider,
+    void* user_context)
+{
+  _az_PRECONDITION_NOT_NULL(ref_request);
+  _az_PRECONDITION_NOT_NULL(body_provider);
+  _az_PRECONDITION(body_size >= 0 || body_size == AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN);
+
+  ref_request->_internal.body = AZ_SPAN_EMPTY;
+  ref_request->_internal.body_provider = body_provider;
+  ref_request->_internal.body_provider_user_context = user_context;
+  ref_request->_internal.body_provider_size = body_size;
+  ref_request->_internal.body_segments = NULL;
+  ref_request->_internal.body_segment_count = 0;
+
+  return AZ_OK;
+}
+
+// Provides the body of a request from its segments, filling the destination across as many of
+// them as it spans.
+static AZ_NODISCARD az_result _az_http_request_body_segments_provider(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  az_http_request const* const request = (az_http_request const*)user_context;
+  az_span const* const segments = request->_internal.body_segments;
+  int32_t const segment_count = request->_internal.body_segment_count;
+
+  // Skip the segments which were already read.
+  int32_t i = 0;
+  while (i < segment_count && offset >= az_span_size(segments[i]))
+  {
+    offset -= az_span_size(segments[i]);
+    i++;
+  }
+
+  az_span remainder = destination;
+  for (; i < segment_count && az_span_size(remainder) > 0; i++)
+  {
+    az_span segment = az_span_slice_to_end(segments[i], (int32_t)offset);
+    offset = 0;
+    if (az_span_size(segment) > az_span_size(remainder))
+    {
+      segment = az_span_slice(segment, 0, az_span_size(remainder));
+    }
+
+    remainder = az_span_copy(remainder, segment);
+  }
+
+  *out_size = az_span_size(destination) - az_span_size(remainder);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_request_set_body_segments(
+    az_http_request* ref_request,
+    az_span const body_segments[],
+    int32_t number_of_segments)
+{
+  _az_PRECONDITION_NOT_NULL(ref_request);
+  _az_PRECONDITION(number_of_segments >= 0);
+  _az_PRECONDITION(body_segments != NULL || number_of_segments == 0);
+
+  int64_t body_size = 0;
+  for (int32_t i = 0; i < number_of_segments; i++)
+  {
+    body_size += az_span_size(body_segments[i]);
+  }
+
+  // The segments are read through the body provider of the request, which transport adapters
+  // already stream.
+  ref_request->_internal.body = AZ_SPAN_EMPTY;
+  ref_request->_internal.body_provider = _az_http_request_body_segments_provider;
+  ref_request->_internal.body_provider_user_context = ref_request;
+  ref_request->_internal.body_provider_size = body_size;
+  ref_request->_internal.body_segments = body_segments;
+  ref_request->_internal.body_segment_count = number_of_segments;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD int64_t az_http_request_get_body_size(az_http_request const* request)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+
+  return request->_internal.body_provider != NULL ? request->_internal.body_provider_size
+                                                  : az_span_size(request->_internal.body);
+}
+
+AZ_NODISCARD az_result az_http_request_read_body(
+    az_http_request const* request,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(out_size);
+  _az_PRECONDITION(offset >= 0);
+
+  int64_t const body_size = az_http_request_get_body_size(request);
+  if (body_size == AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN)
+  {
+    // Only the body provider knows where such a body ends, which it tells by providing nothing.
+    int32_t provided_size = 0;
+    _az_RETURN_IF_FAILED(request->_internal.body_provider(
+        request->_internal.body_provider_user_context, offset, destination, &provided_size));
+    if (provided_size < 0 || provided_size > az_span_size(destination))
+    {
+      return AZ_ERROR_UNEXPECTED_END;
+    }
+
+    *out_size = provided_size;
+    return AZ_OK;
+  }
+
+  _az_PRECONDITION(offset <= body_size);
+
+  int64_t const remaining = body_size - offset;
+  int32_t const max_size = remaining < (int64_t)az_span_size(destination)
+      ? (int32_t)remaining
+      : az_span_size(destination);
+
+  if (max_size == 0)
+  {
+    *out_size = 0;
+    return AZ_OK;
+  }
+
+  if (request->_internal.body_provider == NULL)
+  {
+    az_span_copy(
+        destination,
+        az_span_slice(request->_internal.body, (int32_t)offset, (int32_t)offset + max_size));
+    *out_size = max_size;
+    return AZ_OK;
+  }
+
+  int32_t provided_size = 0;
+  _az_RETURN_IF_FAILED(request->_internal.body_provider(
+      request->_internal.body_provider_user_context,
+      offset,
+      az_span_slice(destination, 0, max_size),
+      &provided_size));
+
+  // The body can't end before the size it was set up with.
+  if (provided_size < 1 || provided_size > max_size)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  *out_size = provided_size;
+  return AZ_OK;
+}
+
 AZ_NODISCARD int32_t az_http_request_headers_count(az_http_request const* request)
 {
   return request->_internal.headers_length;
 }
+
+AZ_NODISCARD az_result
+_az_http_request_write_key(az_http_request const* request, az_span key, az_span* out_key)
+{
+  az_span remainder = key;
+  az_span const url = az_span_slice(request->_internal.url, 0, request->_internal.url_length);
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(
+      remainder, az_span_size(request->_internal.method) + az_span_size(url) + 2);
+  remainder = az_span_copy(remainder, request->_internal.method);
+  remainder = az_span_copy_u8(remainder, ' ');
+  remainder = az_span_copy(remainder, url);
+  remainder = az_span_copy_u8(remainder, '\n');
+
+  int32_t const header_count = az_http_request_headers_count(request);
+  for (int32_t i = 0; i < header_count; i++)
+  {
+    az_span name = AZ_SPAN_EMPTY;
+    az_span value = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(az_http_request_get_header(request, i, &name, &value));
+
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(name) + az_span_size(value) + 2);
+    remainder = az_span_copy(remainder, name);
+    remainder = az_span_copy_u8(remainder, ':');
+    remainder = az_span_copy(remainder, value);
+    remainder = az_span_copy_u8(remainder, '\n');
+  }
+
+  *out_key = az_span_slice(key, 0, _az_span_diff(remainder, key));
+  return AZ_OK;
+}
@@ -5,8 +5,10 @@
 
 #include "az_http_header_validation_private.h"
 #include "az_http_private.h"
+#include "az_simd_private.h"
 #include "az_span_private.h"
 #include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 
@@ -28,6 +30,79 @@ static AZ_NODISCARD bool _az_is_http_whitespace(uint8_t c)
   }
 }
 
+#ifdef _az_SIMD
+
+#if defined(_az_SIMD_AVX2)
+#define _az_HTTP_RESPONSE_SCAN_BLOCK_SIZE 32
+#define _az_HTTP_RESPONSE_SCAN_BITS_PER_POSITION 1
+#elif defined(_az_SIMD_SSE2)
+#define _az_HTTP_RESPONSE_SCAN_BLOCK_SIZE 16
+#define _az_HTTP_RESPONSE_SCAN_BITS_PER_POSITION 1
+#else // _az_SIMD_NEON
+#define _az_HTTP_RESPONSE_SCAN_BLOCK_SIZE 16
+#define _az_HTTP_RESPONSE_SCAN_BITS_PER_POSITION 4
+#endif
+
+/*
+ * Returns a mask with the bits of the positions of `block`, at
+ * _az_HTTP_RESPONSE_SCAN_BITS_PER_POSITION bits per position, which hold a ':' or a control
+ * character. The control characters include the CR and LF ending each line.
+ */
+static AZ_NODISCARD uint64_t _az_http_response_delimiter_mask(uint8_t const* block)
+{
+#if defined(_az_SIMD_AVX2)
+  __m256i const bytes = _mm256_loadu_si256((__m256i const*)block);
+  // Unsigned bytes <= 0x1F is equivalent to max(bytes, 0x1F) == 0x1F.
+  __m256i const delimiters = _mm256_or_si256(
+      _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F)),
+      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')));
+  return (uint32_t)_mm256_movemask_epi8(delimiters);
+#elif defined(_az_SIMD_SSE2)
+  __m128i const bytes = _mm_loadu_si128((__m128i const*)block);
+  __m128i const delimiters = _mm_or_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)),
+      _mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')));
+  return (uint32_t)_mm_movemask_epi8(delimiters);
+#else
+  uint8x16_t const bytes = vld1q_u8(block);
+  uint8x16_t const delimiters
+      = vorrq_u8(vcleq_u8(bytes, vdupq_n_u8(0x1F)), vceqq_u8(bytes, vdupq_n_u8(':')));
+  // NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves one nibble per position.
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(delimiters), 4)), 0);
+#endif
+}
+
+#endif // _az_SIMD
+
+/*
+ * Returns the index of the first ':' or control character of `ptr`, which has `size` bytes, or
+ * `size` if there is none. When a SIMD instruction set is available, the bytes are first checked
+ * one block at a time, so that the status line, and the names and values of the headers, are
+ * scanned without looking at each of their bytes.
+ */
+static AZ_NODISCARD int32_t _az_http_response_find_delimiter(uint8_t const* ptr, int32_t size)
+{
+  int32_t i = 0;
+
+#ifdef _az_SIMD
+  for (; i + _az_HTTP_RESPONSE_SCAN_BLOCK_SIZE <= size; i += _az_HTTP_RESPONSE_SCAN_BLOCK_SIZE)
+  {
+    uint64_t const delimiters = _az_http_response_delimiter_mask(ptr + i);
+    if (delimiters != 0)
+    {
+      return i + _az_simd_lowest_bit_index(delimiters) / _az_HTTP_RESPONSE_SCAN_BITS_PER_POSITION;
+    }
+  }
+#endif // _az_SIMD
+
+  while (i < size && ptr[i] >= ' ' && ptr[i] != ':')
+  {
+    i++;
+  }
+
+  return i;
+}
+
 /* PRIVATE Function. parse next  */
 static AZ_NODISCARD az_result _az_get_digit(az_span* ref_span, uint8_t* save_here)
 {
@@ -88,17 +163,19 @@ _az_get_http_status_line(az_span* ref_span, az_http_response_status_line* out_st
   int32_t offset = 0;
   int32_t input_size = az_span_size(*ref_span);
   uint8_t const* const ptr = az_span_ptr(*ref_span);
-  for (; offset < input_size; ++offset)
+  while (true)
   {
-    uint8_t next_byte = ptr[offset];
-    if (next_byte == '\n')
+    // A ':' or an HTAB may be part of the reason-phrase, so the scan goes on past them.
+    offset += _az_http_response_find_delimiter(ptr + offset, input_size - offset);
+    if (offset == input_size)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+    if (ptr[offset] == '\n')
     {
       break;
     }
-  }
-  if (offset == input_size)
-  {
-    return AZ_ERROR_ITEM_NOT_FOUND;
+    offset++;
   }
 
   // save reason-phrase in status line now that we got the offset. Remove 1 last chars(\r)
@@ -177,25 +254,20 @@ AZ_NODISCARD az_result az_http_response_get_next_header(
     //         "_" / "`" / "|" / "~" / DIGIT / ALPHA;
     // any VCHAR,
     //    except delimiters
-    int32_t field_name_length = 0;
     int32_t input_size = az_span_size(*reader);
     uint8_t const* const ptr = az_span_ptr(*reader);
-    for (; field_name_length < input_size; ++field_name_length)
+    int32_t const field_name_length = _az_http_response_find_delimiter(ptr, input_size);
+    if (field_name_length == input_size || ptr[field_name_length] != ':')
     {
-      uint8_t next_byte = ptr[field_name_length];
-      if (next_byte == ':')
-      {
-        break;
-      }
-      if (!az_http_valid_token[next_byte])
+      return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
+    }
+    for (int32_t i = 0; i < field_name_length; ++i)
+    {
+      if (!az_http_valid_token[ptr[i]])
       {
         return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
       }
     }
-    if (field_name_length == input_size)
-    {
-      return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
-    }
 
     // form a header name. Reader is currently at char ':'
     *out_name = az_span_slice(*reader, 0, field_name_length);
@@ -235,32 +307,34 @@ AZ_NODISCARD az_result az_http_response_get_next_header(
   //
   // Note: obs-fold is not implemented.
   {
+    int32_t const input_size = az_span_size(*reader);
+    uint8_t const* const ptr = az_span_ptr(*reader);
     int32_t offset = 0;
-    int32_t offset_value_end = offset;
     while (true)
     {
-      uint8_t c = az_span_ptr(*reader)[offset];
-      offset += 1;
-      if (c == '\r')
+      offset += _az_http_response_find_delimiter(ptr + offset, input_size - offset);
+      if (offset == input_size)
       {
-        break; // break as soon as end of value char is found
+        return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
       }
-      if (_az_is_http_whitespace(c))
+
+      uint8_t const c = ptr[offset];
+      if (c == '\r')
       {
-        continue; // whitespace or tab is accepted. It can be any number after value (OWS)
+        break; // break as soon as end of value char is found
       }
-      if (c < ' ')
+      if (c != ':' && !_az_is_http_whitespace(c))
       {
         return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
       }
-      offset_value_end = offset; // increasing index only for valid chars,
+      offset++; // a ':' or a tab is accepted, the scan goes on past it.
     }
-    *out_value = az_span_slice(*reader, 0, offset_value_end);
-    // moving reader. It is currently after \r was found
-    *reader = az_span_slice_to_end(*reader, offset);
 
-    // Remove whitespace characters from value https://github.com/Azure/azure-sdk-for-c/issues/604
-    *out_value = _az_span_trim_whitespace_from_end(*out_value);
+    // Remove the whitespace characters after the value (OWS), which may be any number of them
+    // https://github.com/Azure/azure-sdk-for-c/issues/604
+    *out_value = _az_span_trim_whitespace_from_end(az_span_slice(*reader, 0, offset));
+    // moving reader after the \r which was found
+    *reader = az_span_slice_to_end(*reader, offset + 1);
   }
 
   _az_RETURN_IF_FAILED(_az_is_expected_span(reader, AZ_SPAN_FROM_STR("\n")));
@@ -299,20 +373,136 @@ AZ_NODISCARD az_result az_http_response_get_body(az_http_response* ref_response,
     }
   }
 
-  // take all the remaining content from reader as body
-  *out_body = az_span_slice_to_end(ref_response->_internal.parser.remaining, 0);
+  // take all the remaining content from reader as body, unless it was streamed to a body sink
+  *out_body
+      = ref_response->_internal.body_sink.state == _az_HTTP_RESPONSE_BODY_SINK_STATE_SINK
+      ? AZ_SPAN_EMPTY
+      : az_span_slice_to_end(ref_response->_internal.parser.remaining, 0);
 
   ref_response->_internal.parser.next_kind = _az_HTTP_RESPONSE_KIND_EOF;
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_http_response_parse_headers(
+    az_http_response const* response,
+    az_http_response_header* headers,
+    int32_t headers_capacity,
+    az_http_response_headers* out_headers)
+{
+  _az_PRECONDITION_NOT_NULL(response);
+  _az_PRECONDITION_NOT_NULL(headers);
+  _az_PRECONDITION(headers_capacity > 0);
+  _az_PRECONDITION_NOT_NULL(out_headers);
+
+  // Parsing moves the response forward, so a copy is parsed.
+  az_http_response response_copy = *response;
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(&response_copy, &status_line));
+
+  int32_t count = 0;
+  while (true)
+  {
+    az_span name = { 0 };
+    az_span value = { 0 };
+    az_result const result = az_http_response_get_next_header(&response_copy, &name, &value);
+    if (result == AZ_ERROR_HTTP_END_OF_HEADERS)
+    {
+      break;
+    }
+
+    _az_RETURN_IF_FAILED(result);
+
+    if (count == headers_capacity)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    headers[count++] = (az_http_response_header){ .name = name, .value = value };
+  }
+
+  *out_headers = (az_http_response_headers){
+    ._internal = {
+      .headers = headers,
+      .count = count,
+    },
+  };
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_response_headers_find(
+    az_http_response_headers const* headers,
+    az_span name,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(headers);
+  _az_PRECONDITION_VALID_SPAN(name, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  for (int32_t i = 0; i < headers->_internal.count; i++)
+  {
+    if (az_span_is_content_equal_ignoring_case(headers->_internal.headers[i].name, name))
+    {
+      *out_value = headers->_internal.headers[i].value;
+      return AZ_OK;
+    }
+  }
+
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
+
 void _az_http_response_reset(az_http_response* ref_response)
 {
+  az_http_response_body_sink_fn const sink = ref_response->_internal.body_sink.callback;
+  void* const sink_user_context = ref_response->_internal.body_sink.user_context;
+  az_span_allocator_fn const allocator = ref_response->_internal.allocator.callback;
+  void* const allocator_user_context = ref_response->_internal.allocator.user_context;
+  az_http_response_pool* const pool = ref_response->_internal.pool;
+
   // never fails, discard the result
   // init will set written to 0 and will use the same az_span. Internal parser's state is also
   // reset
   az_result result = az_http_response_init(ref_response, ref_response->_internal.http_response);
   (void)result;
+
+  // the body sink survives a reset so that it also receives the body of a retried request
+  ref_response->_internal.body_sink.callback = sink;
+  ref_response->_internal.body_sink.user_context = sink_user_context;
+
+  // and so does the allocator, which grew the buffer the retried request is received in
+  ref_response->_internal.allocator.callback = allocator;
+  ref_response->_internal.allocator.user_context = allocator_user_context;
+  ref_response->_internal.pool = pool;
+}
+
+AZ_NODISCARD az_result az_http_response_set_body_sink(
+    az_http_response* ref_response,
+    az_http_response_body_sink_fn sink,
+    void* user_context)
+{
+  _az_PRECONDITION_NOT_NULL(ref_response);
+  _az_PRECONDITION_NOT_NULL(sink);
+
+  ref_response->_internal.body_sink.callback = sink;
+  ref_response->_internal.body_sink.user_context = user_context;
+  ref_response->_internal.body_sink.header_end_matched = 0;
+  ref_response->_internal.body_sink.state = _az_HTTP_RESPONSE_BODY_SINK_STATE_HEADERS;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_response_set_allocator(
+    az_http_response* ref_response,
+    az_span_allocator_fn allocator,
+    void* user_context)
+{
+  _az_PRECONDITION_NOT_NULL(ref_response);
+  _az_PRECONDITION_NOT_NULL(allocator);
+
+  ref_response->_internal.allocator.callback = allocator;
+  ref_response->_internal.allocator.user_context = user_context;
+
+  return AZ_OK;
 }
 
 // internal function to get az_http_response remainder
@@ -321,16 +511,146 @@ static az_span _az_http_response_get_remaining(az_http_response const* response)
   return az_span_slice_to_end(response->_internal.http_response, response->_internal.written);
 }
 
-AZ_NODISCARD az_result az_http_response_append(az_http_response* ref_response, az_span source)
+// Asks the allocator for a buffer which holds what was written so far and `write_size` more bytes.
+static AZ_NODISCARD az_result
+_az_http_response_grow(az_http_response* ref_response, int32_t write_size)
 {
-  _az_PRECONDITION_NOT_NULL(ref_response);
+  int32_t const written = ref_response->_internal.written;
+  if (write_size > INT32_MAX - written)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
 
+  // The parser may be part way through the response, so it is moved to the same offset of the new
+  // buffer.
+  az_span const parser_remaining = ref_response->_internal.parser.remaining;
+  int32_t const parser_offset = az_span_ptr(parser_remaining) == NULL
+      ? -1
+      : (int32_t)(az_span_ptr(parser_remaining)
+                  - az_span_ptr(ref_response->_internal.http_response));
+
+  az_span_allocator_context context = {
+    .user_context = ref_response->_internal.allocator.user_context,
+    .bytes_used = written,
+    .minimum_required_size = written + write_size,
+  };
+
+  // As without an allocator, let the caller fail with AZ_ERROR_NOT_ENOUGH_SPACE.
+  az_span buffer = AZ_SPAN_EMPTY;
+  if (az_result_failed(ref_response->_internal.allocator.callback(&context, &buffer))
+      || az_span_size(buffer) < context.minimum_required_size)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  ref_response->_internal.http_response = buffer;
+  if (parser_offset >= 0)
+  {
+    ref_response->_internal.parser.remaining
+        = az_span_create(az_span_ptr(buffer) + parser_offset, az_span_size(parser_remaining));
+  }
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_http_response_write(az_http_response* ref_response, az_span source)
+{
   az_span remaining = _az_http_response_get_remaining(ref_response);
   int32_t write_size = az_span_size(source);
+  if (az_span_size(remaining) < write_size && ref_response->_internal.allocator.callback != NULL)
+  {
+    _az_RETURN_IF_FAILED(_az_http_response_grow(ref_response, write_size));
+    remaining = _az_http_response_get_remaining(ref_response);
+  }
   _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining, write_size);
 
   remaining = az_span_copy(remaining, source);
   ref_response->_internal.written += write_size;
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_HTTP_RESPONSE, ref_response->_internal.written);
+
+  return AZ_OK;
+}
+
+// Called once a complete header block has been written. Decides where the body bytes which follow
+// it go.
+static AZ_NODISCARD az_result _az_http_response_end_of_headers(az_http_response* ref_response)
+{
+  az_span status_line_span
+      = az_span_slice(ref_response->_internal.http_response, 0, ref_response->_internal.written);
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(_az_get_http_status_line(&status_line_span, &status_line));
+
+  if (status_line.status_code < 200)
+  {
+    // An informational response (such as 100 Continue) is followed by the final response. Drop it,
+    // so that the buffer starts with the final status line, and look for the next header block.
+    ref_response->_internal.written = 0;
+    return AZ_OK;
+  }
+
+  ref_response->_internal.body_sink.state = status_line.status_code < 300
+      ? _az_HTTP_RESPONSE_BODY_SINK_STATE_SINK
+      : _az_HTTP_RESPONSE_BODY_SINK_STATE_BUFFER;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_response_append(az_http_response* ref_response, az_span source)
+{
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_http_response_body_sink_fn const sink = ref_response->_internal.body_sink.callback;
+  if (sink == NULL)
+  {
+    return _az_http_response_write(ref_response, source);
+  }
+
+  az_span const header_end = AZ_SPAN_FROM_STR("\r\n\r\n");
+  int32_t const header_end_size = az_span_size(header_end);
+
+  while (az_span_size(source) > 0)
+  {
+    switch (ref_response->_internal.body_sink.state)
+    {
+      case _az_HTTP_RESPONSE_BODY_SINK_STATE_SINK:
+        return sink(ref_response->_internal.body_sink.user_context, source);
+
+      case _az_HTTP_RESPONSE_BODY_SINK_STATE_BUFFER:
+        return _az_http_response_write(ref_response, source);
+
+      default:
+        break;
+    }
+
+    // Still receiving headers: only write up to the end of the header block.
+    int32_t* const matched = &ref_response->_internal.body_sink.header_end_matched;
+    uint8_t const* const ptr = az_span_ptr(source);
+    int32_t const source_size = az_span_size(source);
+    int32_t offset = 0;
+    while (offset < source_size && *matched < header_end_size)
+    {
+      uint8_t const c = ptr[offset];
+      ++offset;
+      if (c == az_span_ptr(header_end)[*matched])
+      {
+        ++*matched;
+      }
+      else
+      {
+        *matched = (c == '\r') ? 1 : 0;
+      }
+    }
+
+    _az_RETURN_IF_FAILED(_az_http_response_write(ref_response, az_span_slice(source, 0, offset)));
+    source = az_span_slice_to_end(source, offset);
+
+    if (*matched == header_end_size)
+    {
+      *matched = 0;
+      _az_RETURN_IF_FAILED(_az_http_response_end_of_headers(ref_response));
+    }
+  }
 
   return AZ_OK;
 }
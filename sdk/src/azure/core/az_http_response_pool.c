@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+// The bits of the buffers in use are only ever changed with a compare-and-swap, so a buffer is
+// never given to two requests, whichever threads check them out and return them.
+
+// Takes the first available buffer of the smallest size class which fits `minimum_size` bytes.
+static AZ_NODISCARD az_result
+_az_http_response_pool_take(az_http_response_pool* ref_pool, int32_t minimum_size, az_span* out)
+{
+  for (int32_t i = 0; i < ref_pool->_internal.size_class_count; i++)
+  {
+    uint8_t* const buffers = ref_pool->_internal.size_classes[i].buffers;
+    int32_t const buffer_size = ref_pool->_internal.size_classes[i].buffer_size;
+    int32_t const buffer_count = ref_pool->_internal.size_classes[i].buffer_count;
+    uint64_t volatile* const in_use = &ref_pool->_internal.size_classes[i].in_use;
+    if (buffer_size < minimum_size)
+    {
+      continue;
+    }
+
+    uint64_t const all_in_use = buffer_count == AZ_HTTP_RESPONSE_POOL_MAX_BUFFERS_PER_SIZE_CLASS
+        ? UINT64_MAX
+        : ((uint64_t)1 << buffer_count) - 1;
+
+    uint64_t current = _az_atomic_load(in_use);
+    while (current != all_in_use)
+    {
+      // Adding one to the bits in use carries into the lowest bit which is clear.
+      uint64_t const bit = ~current & (current + 1);
+      if (_az_atomic_compare_exchange(in_use, &current, current | bit))
+      {
+        int32_t index = 0;
+        while ((bit >> index) != 1)
+        {
+          index++;
+        }
+
+        *out = az_span_create(buffers + (index * buffer_size), buffer_size);
+        return AZ_OK;
+      }
+    }
+  }
+
+  return AZ_ERROR_NOT_ENOUGH_SPACE;
+}
+
+static void _az_http_response_pool_give_back(az_http_response_pool* ref_pool, az_span buffer)
+{
+  uint8_t const* const ptr = az_span_ptr(buffer);
+  for (int32_t i = 0; i < ref_pool->_internal.size_class_count; i++)
+  {
+    uint8_t const* const buffers = ref_pool->_internal.size_classes[i].buffers;
+    int32_t const buffer_size = ref_pool->_internal.size_classes[i].buffer_size;
+    int32_t const buffer_count = ref_pool->_internal.size_classes[i].buffer_count;
+    if (ptr < buffers || ptr >= buffers + (buffer_count * buffer_size))
+    {
+      continue;
+    }
+
+    uint64_t const bit = (uint64_t)1 << ((ptr - buffers) / buffer_size);
+    uint64_t volatile* const in_use = &ref_pool->_internal.size_classes[i].in_use;
+    uint64_t current = _az_atomic_load(in_use);
+    while (!_az_atomic_compare_exchange(in_use, &current, current & ~bit))
+    {
+      // The other buffers of the size class changed, retry with their new bits.
+    }
+    return;
+  }
+}
+
+// Moves a checked out response to a larger buffer of the pool, as az_http_response_set_allocator()
+// requires: the new buffer starts with the bytes received so far.
+static AZ_NODISCARD az_result _az_http_response_pool_grow(
+    az_span_allocator_context* allocator_context,
+    az_span* out_next_destination)
+{
+  az_http_response* const response = (az_http_response*)allocator_context->user_context;
+  az_http_response_pool* const pool = response->_internal.pool;
+  az_span const previous = response->_internal.http_response;
+
+  az_span next = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(
+      _az_http_response_pool_take(pool, allocator_context->minimum_required_size, &next));
+
+  memcpy(az_span_ptr(next), az_span_ptr(previous), (size_t)allocator_context->bytes_used);
+  _az_http_response_pool_give_back(pool, previous);
+
+  *out_next_destination = next;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_response_pool_init(
+    az_http_response_pool* out_pool,
+    az_span memory,
+    az_http_response_pool_size_class const* size_classes,
+    int32_t size_class_count)
+{
+  _az_PRECONDITION_NOT_NULL(out_pool);
+  _az_PRECONDITION_NOT_NULL(size_classes);
+  _az_PRECONDITION_RANGE(1, size_class_count, AZ_HTTP_RESPONSE_POOL_MAX_SIZE_CLASSES);
+
+  *out_pool = (az_http_response_pool){ 0 };
+
+  uint8_t* next_buffers = az_span_ptr(memory);
+  int64_t remaining = az_span_size(memory);
+  for (int32_t i = 0; i < size_class_count; i++)
+  {
+    int32_t const buffer_size = size_classes[i].buffer_size;
+    int32_t const buffer_count = size_classes[i].buffer_count;
+    _az_PRECONDITION(buffer_size > 0);
+    _az_PRECONDITION_RANGE(1, buffer_count, AZ_HTTP_RESPONSE_POOL_MAX_BUFFERS_PER_SIZE_CLASS);
+    _az_PRECONDITION(i == 0 || size_classes[i - 1].buffer_size < buffer_size);
+
+    int64_t const class_size = (int64_t)buffer_size * buffer_count;
+    if (class_size > remaining)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    out_pool->_internal.size_classes[i].buffers = next_buffers;
+    out_pool->_internal.size_classes[i].buffer_size = buffer_size;
+    out_pool->_internal.size_classes[i].buffer_count = buffer_count;
+    out_pool->_internal.size_classes[i].in_use = 0;
+
+    next_buffers += class_size;
+    remaining -= class_size;
+  }
+
+  out_pool->_internal.size_class_count = size_class_count;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_response_pool_checkout(
+    az_http_response_pool* ref_pool,
+    int32_t expected_size,
+    az_http_response* out_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_pool);
+  _az_PRECONDITION(expected_size >= 0);
+  _az_PRECONDITION_NOT_NULL(out_response);
+
+  az_span buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_http_response_pool_take(ref_pool, expected_size, &buffer));
+
+  _az_RETURN_IF_FAILED(az_http_response_init(out_response, buffer));
+  out_response->_internal.pool = ref_pool;
+  return az_http_response_set_allocator(out_response, _az_http_response_pool_grow, out_response);
+}
+
+void az_http_response_pool_return(az_http_response_pool* ref_pool, az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_pool);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+  _az_PRECONDITION(ref_response->_internal.pool == ref_pool);
+
+  _az_http_response_pool_give_back(ref_pool, ref_response->_internal.http_response);
+
+  // never fails, discard the result
+  az_result result = az_http_response_init(ref_response, AZ_SPAN_EMPTY);
+  (void)result;
+}
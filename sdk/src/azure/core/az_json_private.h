@@ -17,7 +17,8 @@
 
 enum
 {
-  // We are using a uint64_t to represent our nested state, so we can only go 64 levels deep.
+  // We are using a uint64_t to represent our nested state, so we can only go 64 levels deep,
+  // unless an overflow buffer is provided for the outer levels.
   // This is safe to do because sizeof will not dereference the pointer and is used to find the size
   // of the field used as the stack.
   _az_MAX_JSON_STACK_SIZE = sizeof(((_az_json_bit_stack*)0)->_internal.az_json_stack) * 8 // 64
@@ -41,6 +42,12 @@ enum
   // [-][0-9]{16}.[0-9]{15}, i.e. 1+16+1+15 since _az_MAX_SUPPORTED_FRACTIONAL_DIGITS is 15
   _az_MAX_SIZE_FOR_WRITING_DOUBLE = 33,
 
+  // The scale of a scaled integer can use every digit of an int64_t but one.
+  _az_MAX_SCALED_INT64_DECIMAL_PLACES = 18,
+
+  // [-][0-9]{19}. or [-]0.[0-9]{18}, i.e. 1+19+1 or 1+1+1+18
+  _az_MAX_SIZE_FOR_WRITING_SCALED_INT64 = 21,
+
   // When writing large JSON strings in chunks, ask for at least 64 bytes, to avoid writing one
   // character at a time.
   // This value should be between 12 and 512 (inclusive).
@@ -63,11 +70,42 @@ typedef enum
   _az_JSON_STACK_ARRAY = 0,
 } _az_json_stack_item;
 
+AZ_NODISCARD AZ_INLINE _az_json_bit_stack _az_json_stack_create(az_span overflow_buffer)
+{
+  // Cap the size of the buffer so that the maximum depth always fits in an int32_t.
+  int32_t overflow_size = az_span_size(overflow_buffer);
+  if (overflow_size > (INT32_MAX - _az_MAX_JSON_STACK_SIZE) / 8)
+  {
+    overflow_size = (INT32_MAX - _az_MAX_JSON_STACK_SIZE) / 8;
+  }
+
+  return (_az_json_bit_stack){
+    ._internal = {
+      .az_json_stack = 0,
+      .current_depth = 0,
+      .overflow = az_span_ptr(overflow_buffer),
+      .overflow_depth = overflow_size * 8,
+    },
+  };
+}
+
+// Empties the stack, keeping its overflow buffer.
+AZ_INLINE void _az_json_stack_reset(_az_json_bit_stack* ref_json_stack)
+{
+  ref_json_stack->_internal.az_json_stack = 0;
+  ref_json_stack->_internal.current_depth = 0;
+}
+
+AZ_NODISCARD AZ_INLINE int32_t _az_json_stack_max_depth(_az_json_bit_stack const* json_stack)
+{
+  return _az_MAX_JSON_STACK_SIZE + json_stack->_internal.overflow_depth;
+}
+
 AZ_INLINE _az_json_stack_item _az_json_stack_pop(_az_json_bit_stack* ref_json_stack)
 {
   _az_PRECONDITION(
       ref_json_stack->_internal.current_depth > 0
-      && ref_json_stack->_internal.current_depth <= _az_MAX_JSON_STACK_SIZE);
+      && ref_json_stack->_internal.current_depth <= _az_json_stack_max_depth(ref_json_stack));
 
   // Don't do the right bit shift if we are at the last bit in the stack.
   if (ref_json_stack->_internal.current_depth != 0)
@@ -77,6 +115,16 @@ AZ_INLINE _az_json_stack_item _az_json_stack_pop(_az_json_bit_stack* ref_json_st
     // We don't want current_depth to become negative, in case preconditions are off, and if
     // append_container_end is called before append_X_start.
     ref_json_stack->_internal.current_depth--;
+
+    // Past a depth of 64, refill the outermost bit of the register from the overflow buffer.
+    int32_t const overflow_index
+        = ref_json_stack->_internal.current_depth - _az_MAX_JSON_STACK_SIZE;
+    if (overflow_index >= 0
+        && (ref_json_stack->_internal.overflow[overflow_index / 8] & (1 << (overflow_index % 8)))
+            != 0)
+    {
+      ref_json_stack->_internal.az_json_stack |= (uint64_t)1 << (_az_MAX_JSON_STACK_SIZE - 1);
+    }
   }
 
   // true (i.e. 1) means _az_JSON_STACK_OBJECT, while false (i.e. 0) means _az_JSON_STACK_ARRAY
@@ -88,7 +136,23 @@ AZ_INLINE void _az_json_stack_push(_az_json_bit_stack* ref_json_stack, _az_json_
 {
   _az_PRECONDITION(
       ref_json_stack->_internal.current_depth >= 0
-      && ref_json_stack->_internal.current_depth < _az_MAX_JSON_STACK_SIZE);
+      && ref_json_stack->_internal.current_depth < _az_json_stack_max_depth(ref_json_stack));
+
+  // Past a depth of 64, spill the outermost bit of the register into the overflow buffer before it
+  // gets shifted out. Shallower JSON only ever touches the register.
+  int32_t const overflow_index = ref_json_stack->_internal.current_depth - _az_MAX_JSON_STACK_SIZE;
+  if (overflow_index >= 0)
+  {
+    uint8_t const mask = (uint8_t)(1 << (overflow_index % 8));
+    if ((ref_json_stack->_internal.az_json_stack >> (_az_MAX_JSON_STACK_SIZE - 1)) != 0)
+    {
+      ref_json_stack->_internal.overflow[overflow_index / 8] |= mask;
+    }
+    else
+    {
+      ref_json_stack->_internal.overflow[overflow_index / 8] &= (uint8_t)~mask;
+    }
+  }
 
   ref_json_stack->_internal.current_depth++;
   ref_json_stack->_internal.az_json_stack <<= 1;
@@ -99,7 +163,7 @@ AZ_NODISCARD AZ_INLINE _az_json_stack_item _az_json_stack_peek(_az_json_bit_stac
 {
   _az_PRECONDITION(
       json_stack->_internal.current_depth >= 0
-      && json_stack->_internal.current_depth <= _az_MAX_JSON_STACK_SIZE);
+      && json_stack->_internal.current_depth <= _az_json_stack_max_depth(json_stack));
 
   // true (i.e. 1) means _az_JSON_STACK_OBJECT, while false (i.e. 0) means _az_JSON_STACK_ARRAY
   return (json_stack->_internal.az_json_stack & 1) != 0 ? _az_JSON_STACK_OBJECT
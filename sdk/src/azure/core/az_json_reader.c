@@ -2,12 +2,15 @@
 // SPDX-License-Identifier: MIT
 
 #include "az_json_private.h"
+#include "az_simd_private.h"
 #include "az_span_private.h"
 #include <azure/core/az_precondition.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 
 #include <ctype.h>
+#include <string.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -41,8 +44,14 @@ AZ_NODISCARD az_result az_json_reader_init(
       .bytes_consumed = 0,
       .total_bytes_consumed = 0,
       .is_complex_json = false,
-      .bit_stack = { 0 },
+      .bit_stack = _az_json_stack_create(
+          options == NULL ? AZ_SPAN_EMPTY : options->nesting_stack_buffer),
       .options = options == NULL ? az_json_reader_options_default() : *options,
+      .structural_index = NULL,
+      .structural_index_count = 0,
+      .structural_index_cursor = 0,
+      .max_number_of_buffers = 0,
+      .is_end_of_data = true,
     },
   };
   return AZ_OK;
@@ -80,13 +89,461 @@ AZ_NODISCARD az_result az_json_reader_chunked_init(
       .bytes_consumed = 0,
       .total_bytes_consumed = 0,
       .is_complex_json = false,
-      .bit_stack = { 0 },
+      .bit_stack = _az_json_stack_create(
+          options == NULL ? AZ_SPAN_EMPTY : options->nesting_stack_buffer),
       .options = options == NULL ? az_json_reader_options_default() : *options,
+      .structural_index = NULL,
+      .structural_index_count = 0,
+      .structural_index_cursor = 0,
+      .max_number_of_buffers = 0,
+      .is_end_of_data = true,
     },
   };
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_json_reader_incremental_init(
+    az_json_reader* out_json_reader,
+    az_span json_buffers[],
+    int32_t max_number_of_buffers,
+    az_json_reader_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(json_buffers);
+  _az_PRECONDITION(max_number_of_buffers >= 1);
+
+  *out_json_reader = (az_json_reader){
+    .token = (az_json_token){
+      .kind = AZ_JSON_TOKEN_NONE,
+      .slice = AZ_SPAN_EMPTY,
+      .size = 0,
+      ._internal = {
+        .is_multisegment = false,
+        .string_has_escaped_chars = false,
+        .pointer_to_first_buffer = json_buffers,
+        .start_buffer_index = -1,
+        .start_buffer_offset = -1,
+        .end_buffer_index = -1,
+        .end_buffer_offset = -1,
+      },
+    },
+    ._internal = {
+      .json_buffer = AZ_SPAN_EMPTY,
+      .json_buffers = json_buffers,
+      .number_of_buffers = 0,
+      .buffer_index = 0,
+      .bytes_consumed = 0,
+      .total_bytes_consumed = 0,
+      .is_complex_json = false,
+      .bit_stack = _az_json_stack_create(
+          options == NULL ? AZ_SPAN_EMPTY : options->nesting_stack_buffer),
+      .options = options == NULL ? az_json_reader_options_default() : *options,
+      .structural_index = NULL,
+      .structural_index_count = 0,
+      .structural_index_cursor = 0,
+      .max_number_of_buffers = max_number_of_buffers,
+      .is_end_of_data = false,
+    },
+  };
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_json_reader_incremental_feed(az_json_reader* ref_json_reader, az_span json_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+  _az_PRECONDITION(ref_json_reader->_internal.max_number_of_buffers >= 1);
+  _az_PRECONDITION(!ref_json_reader->_internal.is_end_of_data);
+  _az_PRECONDITION_VALID_SPAN(json_buffer, 1, false);
+
+  int32_t const number_of_buffers = ref_json_reader->_internal.number_of_buffers;
+  if (number_of_buffers >= ref_json_reader->_internal.max_number_of_buffers)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  ref_json_reader->_internal.json_buffers[number_of_buffers] = json_buffer;
+  ref_json_reader->_internal.number_of_buffers++;
+
+  // The reader moves on to the following buffers by itself once the first one is set.
+  if (number_of_buffers == 0)
+  {
+    ref_json_reader->_internal.json_buffer = json_buffer;
+  }
+
+  return AZ_OK;
+}
+
+void az_json_reader_incremental_end(az_json_reader* ref_json_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+  _az_PRECONDITION(ref_json_reader->_internal.max_number_of_buffers >= 1);
+
+  ref_json_reader->_internal.is_end_of_data = true;
+}
+
+void az_json_reader_reset(az_json_reader* ref_json_reader, az_span json_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+  _az_PRECONDITION(az_span_size(json_buffer) >= 1);
+
+  // Only the state which reading changes is set again: the options, and the nesting stack buffer
+  // they point to, are kept as they are.
+  ref_json_reader->token.kind = AZ_JSON_TOKEN_NONE;
+  ref_json_reader->token.slice = AZ_SPAN_EMPTY;
+  ref_json_reader->token.size = 0;
+  ref_json_reader->token._internal.is_multisegment = false;
+  ref_json_reader->token._internal.string_has_escaped_chars = false;
+  ref_json_reader->token._internal.start_buffer_index = -1;
+  ref_json_reader->token._internal.start_buffer_offset = -1;
+  ref_json_reader->token._internal.end_buffer_index = -1;
+  ref_json_reader->token._internal.end_buffer_offset = -1;
+
+  ref_json_reader->_internal.json_buffer = json_buffer;
+  ref_json_reader->_internal.json_buffers = &AZ_SPAN_EMPTY;
+  ref_json_reader->_internal.number_of_buffers = 1;
+  ref_json_reader->_internal.buffer_index = 0;
+  ref_json_reader->_internal.bytes_consumed = 0;
+  ref_json_reader->_internal.total_bytes_consumed = 0;
+  ref_json_reader->_internal.is_complex_json = false;
+  _az_json_stack_reset(&ref_json_reader->_internal.bit_stack);
+  ref_json_reader->_internal.structural_index = NULL;
+  ref_json_reader->_internal.structural_index_count = 0;
+  ref_json_reader->_internal.structural_index_cursor = 0;
+  ref_json_reader->_internal.max_number_of_buffers = 0;
+  ref_json_reader->_internal.is_end_of_data = true;
+}
+
+// The structural index is built 64 bytes at a time, with one bit per byte in each mask.
+#define _az_JSON_INDEX_BLOCK_SIZE 64
+
+// Set on the position of an opening quote when the string contains escaped or control characters,
+// and therefore needs to be validated byte by byte.
+#define _az_JSON_INDEX_SLOW_STRING 0x80000000U
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") void _az_json_index_classify_block_avx2(
+    uint8_t const* block,
+    _az_json_index_block_masks* out)
+{
+  *out = (_az_json_index_block_masks){ 0 };
+  for (int32_t i = 0; i < _az_JSON_INDEX_BLOCK_SIZE; i += 32)
+  {
+    __m256i const v = _mm256_loadu_si256((__m256i const*)(block + i));
+    __m256i const op = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('[')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(']')))),
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':'))));
+    __m256i const ws = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+    // Unsigned v <= 0x1F is equivalent to max(v, 0x1F) == 0x1F.
+    __m256i const control
+        = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F));
+
+    out->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')))
+        << i;
+    out->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')))
+        << i;
+    out->operator_char |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+    out->whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << i;
+    out->control |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << i;
+    // The movemask is the most significant bit of every byte, which is only set outside of ASCII.
+    out->non_ascii |= (uint64_t)(uint32_t)_mm256_movemask_epi8(v) << i;
+  }
+}
+
+#endif // _az_SIMD_KERNEL_AVX2
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+void _az_json_index_classify_block_sse2(uint8_t const* block, _az_json_index_block_masks* out)
+{
+  *out = (_az_json_index_block_masks){ 0 };
+  for (int32_t i = 0; i < _az_JSON_INDEX_BLOCK_SIZE; i += 16)
+  {
+    __m128i const v = _mm_loadu_si128((__m128i const*)(block + i));
+    __m128i const op = _mm_or_si128(
+        _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8(']')))),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8(',')), _mm_cmpeq_epi8(v, _mm_set1_epi8(':'))));
+    __m128i const ws = _mm_or_si128(
+        _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    // Unsigned v <= 0x1F is equivalent to max(v, 0x1F) == 0x1F.
+    __m128i const control
+        = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+
+    out->quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')))
+        << i;
+    out->backslash
+        |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+    out->operator_char |= (uint64_t)(uint32_t)_mm_movemask_epi8(op) << i;
+    out->whitespace |= (uint64_t)(uint32_t)_mm_movemask_epi8(ws) << i;
+    out->control |= (uint64_t)(uint32_t)_mm_movemask_epi8(control) << i;
+    // The movemask is the most significant bit of every byte, which is only set outside of ASCII.
+    out->non_ascii |= (uint64_t)(uint32_t)_mm_movemask_epi8(v) << i;
+  }
+}
+
+#endif // defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+#ifdef _az_SIMD_NEON
+
+// NEON has no movemask: keep one distinct bit per byte and add the bytes of each half together.
+static uint64_t _az_json_index_movemask(uint8x16_t matches)
+{
+  static uint8_t const bit_values[16]
+      = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+  uint8x16_t const bits = vandq_u8(matches, vld1q_u8(bit_values));
+  uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+  sum = vpadd_u8(sum, sum);
+  sum = vpadd_u8(sum, sum);
+  return (uint64_t)vget_lane_u8(sum, 0) | ((uint64_t)vget_lane_u8(sum, 1) << 8);
+}
+
+void _az_json_index_classify_block_neon(uint8_t const* block, _az_json_index_block_masks* out)
+{
+  *out = (_az_json_index_block_masks){ 0 };
+  for (int32_t i = 0; i < _az_JSON_INDEX_BLOCK_SIZE; i += 16)
+  {
+    uint8x16_t const v = vld1q_u8(block + i);
+    uint8x16_t const op = vorrq_u8(
+        vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('{')), vceqq_u8(v, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('[')), vceqq_u8(v, vdupq_n_u8(']')))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(',')), vceqq_u8(v, vdupq_n_u8(':'))));
+    uint8x16_t const ws = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+
+    out->quote |= _az_json_index_movemask(vceqq_u8(v, vdupq_n_u8('"'))) << i;
+    out->backslash |= _az_json_index_movemask(vceqq_u8(v, vdupq_n_u8('\\'))) << i;
+    out->operator_char |= _az_json_index_movemask(op) << i;
+    out->whitespace |= _az_json_index_movemask(ws) << i;
+    out->control |= _az_json_index_movemask(vcleq_u8(v, vdupq_n_u8(0x1F))) << i;
+    out->non_ascii |= _az_json_index_movemask(vcgeq_u8(v, vdupq_n_u8(0x80))) << i;
+  }
+}
+
+#endif // _az_SIMD_NEON
+
+// Without SIMD, each byte is classified on its own. Otherwise, the kernel of the host is used.
+static void _az_json_index_classify_block(uint8_t const* block, _az_json_index_block_masks* out)
+{
+#ifdef _az_SIMD
+  _az_simd_get_kernels()->json_index_classify_block(block, out);
+#else
+  *out = (_az_json_index_block_masks){ 0 };
+  for (int32_t i = 0; i < _az_JSON_INDEX_BLOCK_SIZE; i++)
+  {
+    uint64_t const bit = (uint64_t)1 << i;
+    switch (block[i])
+    {
+      case '"':
+        out->quote |= bit;
+        break;
+      case '\\':
+        out->backslash |= bit;
+        break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ',':
+      case ':':
+        out->operator_char |= bit;
+        break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        out->whitespace |= bit;
+        out->control |= (block[i] < 0x20) ? bit : 0;
+        break;
+      default:
+        out->control |= (block[i] < 0x20) ? bit : 0;
+        out->non_ascii |= (block[i] >= 0x80) ? bit : 0;
+        break;
+    }
+  }
+#endif // _az_SIMD
+}
+
+AZ_NODISCARD static int32_t _az_json_index_lowest_bit(uint64_t mask)
+{
+#ifdef _az_SIMD
+  return _az_simd_lowest_bit_index(mask);
+#else
+  int32_t index = 0;
+  while ((mask & 1) == 0)
+  {
+    mask >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+
+// Each bit of the result is the XOR of that bit and all the lower bits of mask. Applied to the
+// unescaped quotes, it sets the bits from each opening quote up to, but excluding, its closing one.
+AZ_NODISCARD static uint64_t _az_json_index_prefix_xor(uint64_t mask)
+{
+  mask ^= mask << 1;
+  mask ^= mask << 2;
+  mask ^= mask << 4;
+  mask ^= mask << 8;
+  mask ^= mask << 16;
+  mask ^= mask << 32;
+  return mask;
+}
+
+/*
+ * Records, in order, the position of every structural character ({}[],:) and quote outside of
+ * strings, and of the first byte of every other run of non-whitespace characters (numbers and
+ * literals). Everything between two consecutive positions is then either whitespace, the content
+ * of a string, or the rest of a number or literal. When UTF-8 is validated, strings which aren't
+ * all ASCII, and therefore valid already, are left to be validated byte by byte.
+ */
+AZ_NODISCARD static az_result _az_json_reader_build_structural_index(
+    az_span json,
+    bool validate_utf8,
+    uint32_t* structural_index,
+    int32_t capacity,
+    int32_t* out_count)
+{
+  uint8_t const* const json_ptr = az_span_ptr(json);
+  int32_t const json_size = az_span_size(json);
+
+  // State carried from one block to the next.
+  uint64_t escaped_first_byte = 0; // the previous block ended with an unescaped backslash
+  uint64_t within_string = 0; // all ones when the previous block ended inside a string
+  uint64_t within_scalar = 0; // the previous block ended with a number or literal character
+
+  int32_t count = 0;
+  int32_t last_opening_quote = -1;
+
+  for (int32_t block_start = 0; block_start < json_size; block_start += _az_JSON_INDEX_BLOCK_SIZE)
+  {
+    uint8_t padded_block[_az_JSON_INDEX_BLOCK_SIZE];
+    uint8_t const* block = json_ptr + block_start;
+    if (json_size - block_start < _az_JSON_INDEX_BLOCK_SIZE)
+    {
+      // Pad the last block with whitespace, which is never indexed.
+      memset(padded_block, ' ', sizeof(padded_block));
+      memcpy(padded_block, block, (size_t)(json_size - block_start));
+      block = padded_block;
+    }
+
+    _az_json_index_block_masks masks;
+    _az_json_index_classify_block(block, &masks);
+
+    // Backslashes are rare, so find the characters they escape one at a time.
+    uint64_t escaped = escaped_first_byte;
+    uint64_t backslash = masks.backslash & ~escaped_first_byte;
+    escaped_first_byte = 0;
+    while (backslash != 0)
+    {
+      int32_t const bit = _az_json_index_lowest_bit(backslash);
+      backslash &= backslash - 1;
+      if (bit == _az_JSON_INDEX_BLOCK_SIZE - 1)
+      {
+        escaped_first_byte = 1;
+      }
+      else
+      {
+        escaped |= (uint64_t)1 << (bit + 1);
+        backslash &= ~((uint64_t)1 << (bit + 1));
+      }
+    }
+
+    uint64_t const quote = masks.quote & ~escaped;
+    uint64_t const string = _az_json_index_prefix_xor(quote) ^ within_string;
+    within_string = 0 - (string >> 63);
+
+    uint64_t const scalar = ~(masks.operator_char | masks.whitespace | quote) & ~string;
+    uint64_t const scalar_start = scalar & ~((scalar << 1) | within_scalar);
+    within_scalar = scalar >> 63;
+
+    uint64_t const structural = (masks.operator_char & ~string) | quote | scalar_start;
+    uint64_t const slow_string
+        = (masks.backslash | masks.control | (validate_utf8 ? masks.non_ascii : 0)) & string;
+
+    uint64_t bits = structural | slow_string;
+    while (bits != 0)
+    {
+      int32_t const bit = _az_json_index_lowest_bit(bits);
+      uint64_t const bit_mask = (uint64_t)1 << bit;
+      bits &= bits - 1;
+
+      if ((structural & bit_mask) != 0)
+      {
+        if (count >= capacity)
+        {
+          return AZ_ERROR_NOT_ENOUGH_SPACE;
+        }
+        if ((quote & string & bit_mask) != 0)
+        {
+          last_opening_quote = count;
+        }
+        structural_index[count++] = (uint32_t)(block_start + bit);
+      }
+      else if (last_opening_quote != -1)
+      {
+        structural_index[last_opening_quote] |= _az_JSON_INDEX_SLOW_STRING;
+      }
+    }
+  }
+
+  *out_count = count;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_reader_indexed_init(
+    az_json_reader* out_json_reader,
+    az_span json_buffer,
+    az_span structural_index_buffer,
+    az_json_reader_options const* options)
+{
+  _az_PRECONDITION(az_span_size(json_buffer) >= 1);
+  _az_PRECONDITION_VALID_SPAN(structural_index_buffer, 0, true);
+
+  _az_RETURN_IF_FAILED(az_json_reader_init(out_json_reader, json_buffer, options));
+
+  // The buffer is aligned for uint32_t by contract.
+  uint32_t* const structural_index = (uint32_t*)(void*)az_span_ptr(structural_index_buffer);
+  int32_t count = 0;
+  _az_RETURN_IF_FAILED(_az_json_reader_build_structural_index(
+      json_buffer,
+      out_json_reader->_internal.options.validate_utf8,
+      structural_index,
+      az_span_size(structural_index_buffer) / (int32_t)sizeof(uint32_t),
+      &count));
+
+  out_json_reader->_internal.structural_index = structural_index;
+  out_json_reader->_internal.structural_index_count = count;
+  return AZ_OK;
+}
+
 AZ_NODISCARD static az_span _get_remaining_json(az_json_reader* json_reader)
 {
   _az_PRECONDITION_NOT_NULL(json_reader);
@@ -113,6 +570,7 @@ static void _az_json_reader_update_state(
   ref_json_reader->token._internal.end_buffer_offset = ref_json_reader->_internal.bytes_consumed;
 
   ref_json_reader->token._internal.is_multisegment = false;
+  ref_json_reader->token._internal.has_integer_value = false;
 
   // Token straddles more than one segment
   int32_t start_index = ref_json_reader->token._internal.start_buffer_index;
@@ -162,8 +620,61 @@ AZ_NODISCARD static az_result _az_json_reader_get_next_buffer(
   return AZ_OK;
 }
 
+AZ_NODISCARD static int32_t _az_json_reader_structural_position(
+    az_json_reader const* json_reader,
+    int32_t cursor)
+{
+  return (int32_t)(json_reader->_internal.structural_index[cursor] & ~_az_JSON_INDEX_SLOW_STRING);
+}
+
+AZ_NODISCARD static az_span _az_json_reader_skip_indexed_whitespace(az_json_reader* ref_json_reader)
+{
+  int32_t const consumed = ref_json_reader->_internal.bytes_consumed;
+  int32_t const count = ref_json_reader->_internal.structural_index_count;
+
+  // Move past the positions of the tokens which were already consumed.
+  int32_t cursor = ref_json_reader->_internal.structural_index_cursor;
+  while (cursor < count && _az_json_reader_structural_position(ref_json_reader, cursor) < consumed)
+  {
+    cursor++;
+  }
+  ref_json_reader->_internal.structural_index_cursor = cursor;
+
+  // Anything other than whitespace right after the previous token, such as the rest of an invalid
+  // literal, is left for the caller to reject.
+  az_span const remaining = _get_remaining_json(ref_json_reader);
+  if (az_span_size(remaining) < 1)
+  {
+    return remaining;
+  }
+  switch (az_span_ptr(remaining)[0])
+  {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      break;
+    default:
+      return remaining;
+  }
+
+  // Otherwise, every other non-whitespace byte would have started a new indexed run, so only
+  // whitespace is left until the next indexed position.
+  int32_t const next = cursor < count ? _az_json_reader_structural_position(ref_json_reader, cursor)
+                                      : az_span_size(ref_json_reader->_internal.json_buffer);
+  ref_json_reader->_internal.bytes_consumed += next - consumed;
+  ref_json_reader->_internal.total_bytes_consumed += next - consumed;
+
+  return _get_remaining_json(ref_json_reader);
+}
+
 AZ_NODISCARD static az_span _az_json_reader_skip_whitespace(az_json_reader* ref_json_reader)
 {
+  if (ref_json_reader->_internal.structural_index != NULL)
+  {
+    return _az_json_reader_skip_indexed_whitespace(ref_json_reader);
+  }
+
   az_span json = { 0 };
   az_span remaining = _get_remaining_json(ref_json_reader);
 
@@ -211,9 +722,10 @@ AZ_NODISCARD static az_result _az_json_reader_process_container_start(
     az_json_token_kind token_kind,
     _az_json_stack_item container_kind)
 {
-  // The current depth is equal to or larger than the maximum allowed depth of 64. Cannot read the
-  // next JSON object or array.
-  if (ref_json_reader->_internal.bit_stack._internal.current_depth >= _az_MAX_JSON_STACK_SIZE)
+  // The current depth is equal to or larger than the maximum allowed depth. Cannot read the next
+  // JSON object or array.
+  if (ref_json_reader->_internal.bit_stack._internal.current_depth
+      >= _az_json_stack_max_depth(&ref_json_reader->_internal.bit_stack))
   {
     return AZ_ERROR_JSON_NESTING_OVERFLOW;
   }
@@ -243,8 +755,114 @@ AZ_NODISCARD static bool _az_is_valid_escaped_character(uint8_t byte)
   }
 }
 
+// Returns the index of the closing quote when the string starting at the current position was
+// found not to contain escaped or control characters while building the structural index, or -1.
+// The state of the UTF-8 validation of a string, which can stop partway through a multi-byte
+// sequence at the end of a buffer segment.
+typedef struct
+{
+  int32_t continuation_bytes;
+  uint8_t lower; // the range of the next continuation byte
+  uint8_t upper;
+} _az_json_utf8_state;
+
+// Validates the next byte of a string according to the well-formed byte sequences of the Unicode
+// standard, which rule out overlong encodings, surrogates and code points beyond U+10FFFF.
+AZ_NODISCARD static bool _az_json_utf8_validate_byte(_az_json_utf8_state* ref_state, uint8_t byte)
+{
+  if (ref_state->continuation_bytes > 0)
+  {
+    if (byte < ref_state->lower || byte > ref_state->upper)
+    {
+      return false;
+    }
+    ref_state->continuation_bytes--;
+    ref_state->lower = 0x80;
+    ref_state->upper = 0xBF;
+    return true;
+  }
+
+  ref_state->lower = 0x80;
+  ref_state->upper = 0xBF;
+  if (byte < 0x80)
+  {
+    return true;
+  }
+  else if (byte >= 0xC2 && byte <= 0xDF)
+  {
+    ref_state->continuation_bytes = 1;
+  }
+  else if (byte >= 0xE0 && byte <= 0xEF)
+  {
+    ref_state->continuation_bytes = 2;
+    if (byte == 0xE0)
+    {
+      ref_state->lower = 0xA0;
+    }
+    else if (byte == 0xED)
+    {
+      ref_state->upper = 0x9F;
+    }
+  }
+  else if (byte >= 0xF0 && byte <= 0xF4)
+  {
+    ref_state->continuation_bytes = 3;
+    if (byte == 0xF0)
+    {
+      ref_state->lower = 0x90;
+    }
+    else if (byte == 0xF4)
+    {
+      ref_state->upper = 0x8F;
+    }
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+AZ_NODISCARD static int32_t _az_json_reader_find_indexed_string_end(az_json_reader* json_reader)
+{
+  int32_t const cursor = json_reader->_internal.structural_index_cursor;
+  if (json_reader->_internal.structural_index == NULL
+      || cursor + 1 >= json_reader->_internal.structural_index_count
+      || _az_json_reader_structural_position(json_reader, cursor)
+          != json_reader->_internal.bytes_consumed
+      || (json_reader->_internal.structural_index[cursor] & _az_JSON_INDEX_SLOW_STRING) != 0)
+  {
+    return -1;
+  }
+
+  // Nothing within a string is indexed, so the next position is its closing quote.
+  return _az_json_reader_structural_position(json_reader, cursor + 1);
+}
+
 AZ_NODISCARD static az_result _az_json_reader_process_string(az_json_reader* ref_json_reader)
 {
+  int32_t const indexed_string_end = _az_json_reader_find_indexed_string_end(ref_json_reader);
+  if (indexed_string_end != -1)
+  {
+    // Move past the first '"' character
+    ref_json_reader->_internal.bytes_consumed++;
+
+    int32_t const string_length = indexed_string_end - ref_json_reader->_internal.bytes_consumed;
+    ref_json_reader->token._internal.string_has_escaped_chars = false;
+    _az_json_reader_update_state(
+        ref_json_reader,
+        AZ_JSON_TOKEN_STRING,
+        az_span_slice(_get_remaining_json(ref_json_reader), 0, string_length),
+        string_length,
+        string_length);
+
+    // Add 1 to number of bytes consumed to account for the last '"' character.
+    ref_json_reader->_internal.bytes_consumed++;
+    ref_json_reader->_internal.total_bytes_consumed++;
+    ref_json_reader->_internal.structural_index_cursor += 2;
+    return AZ_OK;
+  }
+
   // Move past the first '"' character
   ref_json_reader->_internal.bytes_consumed++;
 
@@ -265,8 +883,19 @@ AZ_NODISCARD static az_result _az_json_reader_process_string(az_json_reader* ref
   // Clear the state of any previous string token.
   ref_json_reader->token._internal.string_has_escaped_chars = false;
 
+  bool const validate_utf8 = ref_json_reader->_internal.options.validate_utf8;
+  _az_json_utf8_state utf8_state = { 0 };
+
   while (true)
   {
+    // Every byte outside of escape sequences is part of the UTF-8 encoded text, including the
+    // closing quote, which can't be within a multi-byte sequence.
+    if (validate_utf8 && (next_byte >= 0x80 || utf8_state.continuation_bytes > 0)
+        && !_az_json_utf8_validate_byte(&utf8_state, next_byte))
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
     if (next_byte == '"')
     {
       break;
@@ -420,11 +1049,15 @@ AZ_NODISCARD static bool _az_finished_consuming_json_number(
   return false;
 }
 
+// When ref_integer_value isn't NULL, the digits are also accumulated into it, and
+// ref_integer_overflow is set once the value no longer fits in 64 bits.
 static void _az_json_reader_consume_digits(
     az_json_reader* ref_json_reader,
     az_span* token,
     int32_t* current_consumed,
-    int32_t* total_consumed)
+    int32_t* total_consumed,
+    uint64_t* ref_integer_value,
+    bool* ref_integer_overflow)
 {
   int32_t counter = 0;
   az_span current = az_span_slice_to_end(*token, *current_consumed);
@@ -437,6 +1070,18 @@ static void _az_json_reader_consume_digits(
     {
       if (isdigit(*next_byte_ptr))
       {
+        if (ref_integer_value != NULL)
+        {
+          uint64_t const digit = (uint64_t)(*next_byte_ptr - '0');
+
+          // This is checking whether value * 10 + digit > UINT64_MAX, before doing the math.
+          if ((UINT64_MAX - digit) / 10 < *ref_integer_value)
+          {
+            *ref_integer_overflow = true;
+          }
+          *ref_integer_value = *ref_integer_value * 10 + digit;
+        }
+
         counter++;
         next_byte_ptr++;
       }
@@ -499,6 +1144,22 @@ AZ_NODISCARD static az_result _az_validate_next_byte_is_digit(
   return AZ_OK;
 }
 
+// Records the value of the integer number token which was just read, if the reader parses
+// integers and the value fits in 64 bits.
+static void _az_json_reader_set_integer_value(
+    az_json_reader* ref_json_reader,
+    bool is_negative,
+    uint64_t integer_value,
+    bool integer_overflow)
+{
+  if (ref_json_reader->_internal.options.parse_integers && !integer_overflow)
+  {
+    ref_json_reader->token._internal.has_integer_value = true;
+    ref_json_reader->token._internal.is_negative = is_negative;
+    ref_json_reader->token._internal.integer_magnitude = integer_value;
+  }
+}
+
 AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref_json_reader)
 {
   az_span token = _get_remaining_json(ref_json_reader);
@@ -506,8 +1167,12 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
   int32_t total_consumed = 0;
   int32_t current_consumed = 0;
 
+  uint64_t integer_value = 0;
+  bool integer_overflow = false;
+
   uint8_t next_byte = az_span_ptr(token)[0];
-  if (next_byte == '-')
+  bool const is_negative = next_byte == '-';
+  if (is_negative)
   {
     total_consumed++;
     current_consumed++;
@@ -531,11 +1196,13 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
         // If there is no more JSON, this is a valid end state only when the JSON payload contains a
         // single value: "[-]0"
         // Otherwise, the payload is incomplete and ending too early.
-        return _az_json_reader_update_number_state_if_single_value(
+        _az_RETURN_IF_FAILED(_az_json_reader_update_number_state_if_single_value(
             ref_json_reader,
             az_span_slice(token, 0, current_consumed),
             current_consumed,
-            total_consumed);
+            total_consumed));
+        _az_json_reader_set_integer_value(ref_json_reader, is_negative, 0, false);
+        return AZ_OK;
       }
       current_consumed = 0;
     }
@@ -552,6 +1219,7 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
             az_span_slice(token, 0, current_consumed),
             current_consumed,
             total_consumed);
+        _az_json_reader_set_integer_value(ref_json_reader, is_negative, 0, false);
       }
       return result;
     }
@@ -560,8 +1228,15 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
   {
     _az_PRECONDITION(isdigit(next_byte));
 
-    // Integer part before decimal
-    _az_json_reader_consume_digits(ref_json_reader, &token, &current_consumed, &total_consumed);
+    // Integer part before decimal, whose value is accumulated while its digits are validated.
+    bool const parse_integers = ref_json_reader->_internal.options.parse_integers;
+    _az_json_reader_consume_digits(
+        ref_json_reader,
+        &token,
+        &current_consumed,
+        &total_consumed,
+        parse_integers ? &integer_value : NULL,
+        &integer_overflow);
 
     if (current_consumed >= az_span_size(token))
     {
@@ -570,11 +1245,14 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
         // If there is no more JSON, this is a valid end state only when the JSON payload contains a
         // single value: "[-][digits]"
         // Otherwise, the payload is incomplete and ending too early.
-        return _az_json_reader_update_number_state_if_single_value(
+        _az_RETURN_IF_FAILED(_az_json_reader_update_number_state_if_single_value(
             ref_json_reader,
             az_span_slice(token, 0, current_consumed),
             current_consumed,
-            total_consumed);
+            total_consumed));
+        _az_json_reader_set_integer_value(
+            ref_json_reader, is_negative, integer_value, integer_overflow);
+        return AZ_OK;
       }
       current_consumed = 0;
     }
@@ -591,6 +1269,8 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
             az_span_slice(token, 0, current_consumed),
             current_consumed,
             total_consumed);
+        _az_json_reader_set_integer_value(
+            ref_json_reader, is_negative, integer_value, integer_overflow);
       }
       return result;
     }
@@ -606,7 +1286,8 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
         _az_validate_next_byte_is_digit(ref_json_reader, &token, &current_consumed));
 
     // Integer part after decimal
-    _az_json_reader_consume_digits(ref_json_reader, &token, &current_consumed, &total_consumed);
+    _az_json_reader_consume_digits(
+        ref_json_reader, &token, &current_consumed, &total_consumed, NULL, NULL);
 
     if (current_consumed >= az_span_size(token))
     {
@@ -664,7 +1345,8 @@ AZ_NODISCARD static az_result _az_json_reader_process_number(az_json_reader* ref
   }
 
   // Integer part after the 'e'/'E'
-  _az_json_reader_consume_digits(ref_json_reader, &token, &current_consumed, &total_consumed);
+  _az_json_reader_consume_digits(
+      ref_json_reader, &token, &current_consumed, &total_consumed, NULL, NULL);
 
   if (current_consumed >= az_span_size(token))
   {
@@ -859,10 +1541,8 @@ AZ_NODISCARD static az_result _az_json_reader_process_next_byte(
   }
 }
 
-AZ_NODISCARD az_result az_json_reader_next_token(az_json_reader* ref_json_reader)
+AZ_NODISCARD static az_result _az_json_reader_read_next_token(az_json_reader* ref_json_reader)
 {
-  _az_PRECONDITION_NOT_NULL(ref_json_reader);
-
   az_span json = _az_json_reader_skip_whitespace(ref_json_reader);
 
   if (az_span_size(json) < 1)
@@ -937,10 +1617,69 @@ AZ_NODISCARD az_result az_json_reader_next_token(az_json_reader* ref_json_reader
   }
 }
 
-AZ_NODISCARD az_result az_json_reader_skip_children(az_json_reader* ref_json_reader)
+// Returns whether all the data fed to the reader has been consumed.
+AZ_NODISCARD static bool _az_json_reader_is_at_end_of_buffers(az_json_reader const* json_reader)
+{
+  return json_reader->_internal.buffer_index >= json_reader->_internal.number_of_buffers - 1
+      && json_reader->_internal.bytes_consumed >= az_span_size(json_reader->_internal.json_buffer);
+}
+
+// Fires the tracepoint of the errors reading a token fails with, other than the end of the JSON.
+AZ_NODISCARD static az_result
+_az_json_reader_trace_result(az_json_reader const* json_reader, az_result result)
+{
+  (void)json_reader;
+  if (az_result_failed(result) && result != AZ_ERROR_JSON_READER_DONE)
+  {
+    _az_TRACEPOINT3(json_reader_error, json_reader, result, json_reader->_internal.bytes_consumed);
+  }
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_json_reader_next_token(az_json_reader* ref_json_reader)
 {
   _az_PRECONDITION_NOT_NULL(ref_json_reader);
 
+  if (ref_json_reader->_internal.is_end_of_data)
+  {
+    return _az_json_reader_trace_result(
+        ref_json_reader, _az_json_reader_read_next_token(ref_json_reader));
+  }
+
+  az_json_reader const saved_json_reader = *ref_json_reader;
+  az_result const result = _az_json_reader_read_next_token(ref_json_reader);
+
+  // Running out of data is only an error, or the end of the JSON, once all of it was fed. Until
+  // then, the token is read again, from the start, after the next feed. A number which ends with
+  // the data fed so far may also continue with the next buffer.
+  if (result == AZ_ERROR_UNEXPECTED_END || result == AZ_ERROR_JSON_READER_DONE
+      || (az_result_succeeded(result) && ref_json_reader->token.kind == AZ_JSON_TOKEN_NUMBER
+          && _az_json_reader_is_at_end_of_buffers(ref_json_reader)))
+  {
+    *ref_json_reader = saved_json_reader;
+    return AZ_ERROR_JSON_READER_NEED_MORE_DATA;
+  }
+
+  return _az_json_reader_trace_result(ref_json_reader, result);
+}
+
+// Restores the state of an incremental reader when an operation which reads several tokens runs
+// out of data partway through, so that it can be started over after the next feed.
+AZ_NODISCARD static az_result _az_json_reader_restore_if_need_more_data(
+    az_json_reader* ref_json_reader,
+    az_json_reader const* saved_json_reader,
+    az_result result)
+{
+  if (result == AZ_ERROR_JSON_READER_NEED_MORE_DATA)
+  {
+    *ref_json_reader = *saved_json_reader;
+  }
+  return result;
+}
+
+AZ_NODISCARD static az_result _az_json_reader_skip_children(az_json_reader* ref_json_reader)
+{
   if (ref_json_reader->token.kind == AZ_JSON_TOKEN_PROPERTY_NAME)
   {
     _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
@@ -958,3 +1697,434 @@ AZ_NODISCARD az_result az_json_reader_skip_children(az_json_reader* ref_json_rea
   }
   return AZ_OK;
 }
+
+AZ_NODISCARD az_result az_json_reader_skip_children(az_json_reader* ref_json_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+
+  az_json_reader const saved_json_reader = *ref_json_reader;
+  return _az_json_reader_restore_if_need_more_data(
+      ref_json_reader, &saved_json_reader, _az_json_reader_skip_children(ref_json_reader));
+}
+
+// Scans the rest of the current segment for the end of the object or array which is depth levels
+// up, and sets out_end_index to its index within the remaining bytes, or to -1 if it isn't there.
+// The depth, and whether the segment ended within a string or right after a backslash, are carried
+// from one segment to the next.
+static void _az_json_reader_find_container_end(
+    az_span remaining,
+    int32_t* ref_depth,
+    uint64_t* ref_escaped_first_byte,
+    uint64_t* ref_within_string,
+    int32_t* out_end_index)
+{
+  uint8_t const* const remaining_ptr = az_span_ptr(remaining);
+  int32_t const remaining_size = az_span_size(remaining);
+
+  for (int32_t block_start = 0; block_start < remaining_size;
+       block_start += _az_JSON_INDEX_BLOCK_SIZE)
+  {
+    int32_t const block_size = _az_min(remaining_size - block_start, _az_JSON_INDEX_BLOCK_SIZE);
+    uint8_t padded_block[_az_JSON_INDEX_BLOCK_SIZE];
+    uint8_t const* block = remaining_ptr + block_start;
+    if (block_size < _az_JSON_INDEX_BLOCK_SIZE)
+    {
+      // Pad the last block with whitespace, which is neither a quote nor a container character.
+      memset(padded_block, ' ', sizeof(padded_block));
+      memcpy(padded_block, block, (size_t)block_size);
+      block = padded_block;
+    }
+
+    _az_json_index_block_masks masks;
+    _az_json_index_classify_block(block, &masks);
+
+    // Backslashes are rare, so find the characters they escape one at a time. A backslash which
+    // ends the segment escapes the first byte of the next one.
+    uint64_t escaped = *ref_escaped_first_byte;
+    uint64_t backslash = masks.backslash & ~*ref_escaped_first_byte;
+    *ref_escaped_first_byte = 0;
+    while (backslash != 0)
+    {
+      int32_t const bit = _az_json_index_lowest_bit(backslash);
+      backslash &= backslash - 1;
+      if (bit == block_size - 1)
+      {
+        *ref_escaped_first_byte = 1;
+      }
+      else
+      {
+        escaped |= (uint64_t)1 << (bit + 1);
+        backslash &= ~((uint64_t)1 << (bit + 1));
+      }
+    }
+
+    uint64_t const quote = masks.quote & ~escaped;
+    uint64_t const string = _az_json_index_prefix_xor(quote) ^ *ref_within_string;
+    *ref_within_string = 0 - (string >> 63);
+
+    // Only the container characters among the operators outside of strings change the depth.
+    uint64_t operators = masks.operator_char & ~string;
+    while (operators != 0)
+    {
+      int32_t const bit = _az_json_index_lowest_bit(operators);
+      operators &= operators - 1;
+
+      uint8_t const ch = block[bit];
+      if (ch == '{' || ch == '[')
+      {
+        (*ref_depth)++;
+      }
+      else if (ch == '}' || ch == ']')
+      {
+        (*ref_depth)--;
+        if (*ref_depth == 0)
+        {
+          *out_end_index = block_start + bit;
+          return;
+        }
+      }
+    }
+  }
+
+  *out_end_index = -1;
+}
+
+AZ_NODISCARD static az_result _az_json_reader_fast_skip_children(az_json_reader* ref_json_reader)
+{
+  if (ref_json_reader->token.kind == AZ_JSON_TOKEN_PROPERTY_NAME)
+  {
+    _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+  }
+
+  az_json_token_kind const token_kind = ref_json_reader->token.kind;
+  if (token_kind != AZ_JSON_TOKEN_BEGIN_OBJECT && token_kind != AZ_JSON_TOKEN_BEGIN_ARRAY)
+  {
+    return AZ_OK;
+  }
+
+  int32_t depth = 1;
+  uint64_t escaped_first_byte = 0;
+  uint64_t within_string = 0;
+  az_span remaining = _get_remaining_json(ref_json_reader);
+  while (true)
+  {
+    int32_t end_index = -1;
+    _az_json_reader_find_container_end(
+        remaining, &depth, &escaped_first_byte, &within_string, &end_index);
+
+    if (end_index != -1)
+    {
+      ref_json_reader->_internal.bytes_consumed += end_index;
+      ref_json_reader->_internal.total_bytes_consumed += end_index;
+      break;
+    }
+
+    ref_json_reader->_internal.bytes_consumed += az_span_size(remaining);
+    ref_json_reader->_internal.total_bytes_consumed += az_span_size(remaining);
+    _az_RETURN_IF_FAILED(_az_json_reader_get_next_buffer(ref_json_reader, &remaining, true));
+  }
+
+  // Clear the internal state of the previous token, as when reading the end token.
+  ref_json_reader->token._internal.start_buffer_index = -1;
+  ref_json_reader->token._internal.start_buffer_offset = -1;
+  ref_json_reader->token._internal.end_buffer_index = -1;
+  ref_json_reader->token._internal.end_buffer_offset = -1;
+
+  // This also rejects an end which doesn't match the start of the container being skipped.
+  return _az_json_reader_process_container_end(
+      ref_json_reader,
+      az_span_ptr(_get_remaining_json(ref_json_reader))[0] == '}' ? AZ_JSON_TOKEN_END_OBJECT
+                                                                  : AZ_JSON_TOKEN_END_ARRAY);
+}
+
+AZ_NODISCARD az_result az_json_reader_fast_skip_children(az_json_reader* ref_json_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+
+  az_json_reader const saved_json_reader = *ref_json_reader;
+  az_result result = _az_json_reader_fast_skip_children(ref_json_reader);
+
+  // As for a token, running out of data before the end of the container is only an error once all
+  // of it was fed to an incremental reader.
+  if (result == AZ_ERROR_UNEXPECTED_END && !ref_json_reader->_internal.is_end_of_data)
+  {
+    result = AZ_ERROR_JSON_READER_NEED_MORE_DATA;
+  }
+
+  return _az_json_reader_restore_if_need_more_data(ref_json_reader, &saved_json_reader, result);
+}
+
+// Splits the first segment off a path, setting out_rest to what follows it.
+AZ_NODISCARD static az_span _az_json_path_first_segment(
+    az_span path,
+    az_span* out_rest,
+    bool* out_is_last)
+{
+  int32_t const index = az_span_find(path, AZ_SPAN_FROM_STR("."));
+  if (index == -1)
+  {
+    *out_rest = AZ_SPAN_EMPTY;
+    *out_is_last = true;
+    return path;
+  }
+
+  *out_rest = az_span_slice_to_end(path, index + 1);
+  *out_is_last = false;
+  return az_span_slice(path, 0, index);
+}
+
+AZ_NODISCARD static az_span _az_json_path_get_segment(
+    az_span path,
+    int32_t segment_index,
+    bool* out_is_last)
+{
+  az_span segment = _az_json_path_first_segment(path, &path, out_is_last);
+  for (int32_t i = 0; i < segment_index && !*out_is_last; i++)
+  {
+    segment = _az_json_path_first_segment(path, &path, out_is_last);
+  }
+  return segment;
+}
+
+AZ_NODISCARD static bool _az_json_path_segment_is_index(az_span segment, int32_t index)
+{
+  int32_t const segment_size = az_span_size(segment);
+  uint8_t const* const segment_ptr = az_span_ptr(segment);
+  int32_t value = 0;
+  for (int32_t i = 0; i < segment_size; i++)
+  {
+    if (!isdigit(segment_ptr[i]))
+    {
+      return false;
+    }
+
+    value = (value * 10) + (segment_ptr[i] - '0');
+    if (value > index)
+    {
+      return false;
+    }
+  }
+
+  return segment_size > 0 && value == index;
+}
+
+// Moves the reader from the start of an object or array to the value of its child named by the
+// path segment.
+AZ_NODISCARD static az_result _az_json_reader_find_child(
+    az_json_reader* ref_json_reader,
+    az_span segment)
+{
+  az_json_token_kind const kind = ref_json_reader->token.kind;
+  if (kind == AZ_JSON_TOKEN_BEGIN_OBJECT)
+  {
+    while (true)
+    {
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+      if (ref_json_reader->token.kind == AZ_JSON_TOKEN_END_OBJECT)
+      {
+        return AZ_ERROR_ITEM_NOT_FOUND;
+      }
+
+      if (az_json_token_is_text_equal(&ref_json_reader->token, segment))
+      {
+        return az_json_reader_next_token(ref_json_reader);
+      }
+
+      // Skip the value of the property, along with any of its children.
+      _az_RETURN_IF_FAILED(_az_json_reader_skip_children(ref_json_reader));
+    }
+  }
+  else if (kind == AZ_JSON_TOKEN_BEGIN_ARRAY)
+  {
+    for (int32_t element_index = 0;; element_index++)
+    {
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+      if (ref_json_reader->token.kind == AZ_JSON_TOKEN_END_ARRAY)
+      {
+        return AZ_ERROR_ITEM_NOT_FOUND;
+      }
+
+      if (_az_json_path_segment_is_index(segment, element_index))
+      {
+        return AZ_OK;
+      }
+
+      _az_RETURN_IF_FAILED(_az_json_reader_skip_children(ref_json_reader));
+    }
+  }
+
+  // A primitive value has no children.
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
+
+// Moves the reader to the current value if it was just initialized or is on a property name.
+AZ_NODISCARD static az_result _az_json_reader_move_to_value(az_json_reader* ref_json_reader)
+{
+  if (ref_json_reader->token.kind == AZ_JSON_TOKEN_NONE
+      || ref_json_reader->token.kind == AZ_JSON_TOKEN_PROPERTY_NAME)
+  {
+    return az_json_reader_next_token(ref_json_reader);
+  }
+  return AZ_OK;
+}
+
+AZ_NODISCARD static az_result
+_az_json_reader_find_path(az_json_reader* ref_json_reader, az_span path)
+{
+  _az_RETURN_IF_FAILED(_az_json_reader_move_to_value(ref_json_reader));
+
+  bool is_last = az_span_size(path) == 0;
+  while (!is_last)
+  {
+    az_span const segment = _az_json_path_first_segment(path, &path, &is_last);
+    _az_RETURN_IF_FAILED(_az_json_reader_find_child(ref_json_reader, segment));
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_reader_find_path(az_json_reader* ref_json_reader, az_span path)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+
+  az_json_reader const saved_json_reader = *ref_json_reader;
+  return _az_json_reader_restore_if_need_more_data(
+      ref_json_reader, &saved_json_reader, _az_json_reader_find_path(ref_json_reader, path));
+}
+
+// Reads the children of the object or array the reader is on, at the given depth relative to where
+// the lookup started, and sets the value of the lookups which end at one of them.
+AZ_NODISCARD static az_result _az_json_reader_find_paths_in_container(
+    az_json_reader* ref_json_reader,
+    az_json_path_lookup lookups[],
+    int32_t lookups_count,
+    int32_t depth,
+    int32_t* ref_remaining_count)
+{
+  bool const is_object = ref_json_reader->token.kind == AZ_JSON_TOKEN_BEGIN_OBJECT;
+
+  for (int32_t element_index = 0;; element_index++)
+  {
+    _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+
+    az_json_token_kind kind = ref_json_reader->token.kind;
+    if (kind == AZ_JSON_TOKEN_END_OBJECT || kind == AZ_JSON_TOKEN_END_ARRAY)
+    {
+      return AZ_OK;
+    }
+
+    az_json_token const property_name = ref_json_reader->token;
+    if (is_object)
+    {
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+      kind = ref_json_reader->token.kind;
+    }
+
+    // Advance the lookups which match the location of the reader and continue with this child.
+    bool descend = false;
+    for (int32_t i = 0; i < lookups_count; i++)
+    {
+      az_json_path_lookup* const lookup = &lookups[i];
+      if (lookup->value.kind != AZ_JSON_TOKEN_NONE || lookup->_internal.matched_segments != depth)
+      {
+        continue;
+      }
+
+      bool is_last = false;
+      az_span const segment = _az_json_path_get_segment(lookup->path, depth, &is_last);
+      bool const matches = is_object ? az_json_token_is_text_equal(&property_name, segment)
+                                     : _az_json_path_segment_is_index(segment, element_index);
+      if (!matches)
+      {
+        continue;
+      }
+
+      if (is_last)
+      {
+        lookup->value = ref_json_reader->token;
+        (*ref_remaining_count)--;
+      }
+      else
+      {
+        lookup->_internal.matched_segments = depth + 1;
+        descend = true;
+      }
+    }
+
+    if (*ref_remaining_count == 0)
+    {
+      return AZ_OK;
+    }
+
+    if (descend && (kind == AZ_JSON_TOKEN_BEGIN_OBJECT || kind == AZ_JSON_TOKEN_BEGIN_ARRAY))
+    {
+      _az_RETURN_IF_FAILED(_az_json_reader_find_paths_in_container(
+          ref_json_reader, lookups, lookups_count, depth + 1, ref_remaining_count));
+      if (*ref_remaining_count == 0)
+      {
+        return AZ_OK;
+      }
+    }
+    else
+    {
+      _az_RETURN_IF_FAILED(_az_json_reader_skip_children(ref_json_reader));
+    }
+
+    // The lookups which continued with this child don't have a value within it.
+    for (int32_t i = 0; i < lookups_count; i++)
+    {
+      if (lookups[i]._internal.matched_segments > depth)
+      {
+        lookups[i]._internal.matched_segments = depth;
+      }
+    }
+  }
+}
+
+AZ_NODISCARD static az_result _az_json_reader_find_paths(
+    az_json_reader* ref_json_reader,
+    az_json_path_lookup lookups[],
+    int32_t lookups_count)
+{
+  _az_RETURN_IF_FAILED(_az_json_reader_move_to_value(ref_json_reader));
+
+  int32_t remaining_count = lookups_count;
+  for (int32_t i = 0; i < lookups_count; i++)
+  {
+    lookups[i].value = (az_json_token){ .kind = AZ_JSON_TOKEN_NONE };
+    lookups[i]._internal.matched_segments = 0;
+
+    // An empty path selects the current value.
+    if (az_span_size(lookups[i].path) == 0)
+    {
+      lookups[i].value = ref_json_reader->token;
+      remaining_count--;
+    }
+  }
+
+  az_json_token_kind const kind = ref_json_reader->token.kind;
+  if (remaining_count > 0
+      && (kind == AZ_JSON_TOKEN_BEGIN_OBJECT || kind == AZ_JSON_TOKEN_BEGIN_ARRAY))
+  {
+    _az_RETURN_IF_FAILED(_az_json_reader_find_paths_in_container(
+        ref_json_reader, lookups, lookups_count, 0, &remaining_count));
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_reader_find_paths(
+    az_json_reader* ref_json_reader,
+    az_json_path_lookup lookups[],
+    int32_t lookups_count)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_reader);
+  _az_PRECONDITION(lookups_count >= 0);
+  _az_PRECONDITION(lookups_count == 0 || lookups != NULL);
+
+  az_json_reader const saved_json_reader = *ref_json_reader;
+  return _az_json_reader_restore_if_need_more_data(
+      ref_json_reader,
+      &saved_json_reader,
+      _az_json_reader_find_paths(ref_json_reader, lookups, lookups_count));
+}
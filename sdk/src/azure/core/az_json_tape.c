@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_json.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+// While an object, an array or a property name is open, the next index of its entry is not known
+// yet, and holds the index of the enclosing open entry instead, encoded as a negative number. The
+// stack of open entries is threaded through the tape this way, so that it takes no more memory.
+AZ_INLINE int32_t _az_json_tape_encode_parent(int32_t parent_index)
+{
+  return -2 - parent_index;
+}
+
+AZ_INLINE int32_t _az_json_tape_decode_parent(int32_t next_index)
+{
+  return -2 - next_index;
+}
+
+// Closes the entry of a property name once its value is complete.
+static void _az_json_tape_close_value(az_json_tape_entry entries[], int32_t count, int32_t* open)
+{
+  if (*open >= 0 && entries[*open].kind == AZ_JSON_TOKEN_PROPERTY_NAME)
+  {
+    int32_t const name_index = *open;
+    *open = _az_json_tape_decode_parent(entries[name_index].next_index);
+    entries[name_index].next_index = count;
+  }
+}
+
+AZ_NODISCARD az_result az_json_tape_init(
+    az_json_tape* out_tape,
+    az_span json_buffer,
+    az_json_tape_entry entries[],
+    int32_t max_entries,
+    az_json_reader_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_tape);
+  _az_PRECONDITION_NOT_NULL(entries);
+  _az_PRECONDITION(max_entries > 0);
+
+  az_json_reader reader = { 0 };
+  _az_RETURN_IF_FAILED(az_json_reader_init(&reader, json_buffer, options));
+
+  uint8_t const* const json_start = az_span_ptr(json_buffer);
+  int32_t count = 0;
+  int32_t open = -1;
+
+  az_result result = AZ_OK;
+  while (az_result_succeeded(result = az_json_reader_next_token(&reader)))
+  {
+    az_json_token const* const token = &reader.token;
+    int32_t const offset = (int32_t)(az_span_ptr(token->slice) - json_start);
+
+    if (token->kind == AZ_JSON_TOKEN_END_OBJECT || token->kind == AZ_JSON_TOKEN_END_ARRAY)
+    {
+      // The reader has validated that the end matches the open container.
+      int32_t const container_index = open;
+      open = _az_json_tape_decode_parent(entries[container_index].next_index);
+      entries[container_index].next_index = count;
+      entries[container_index].size = offset + 1 - entries[container_index].offset;
+      _az_json_tape_close_value(entries, count, &open);
+      continue;
+    }
+
+    if (count == max_entries)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    entries[count] = (az_json_tape_entry){
+      .kind = token->kind,
+      .offset = offset,
+      .size = az_span_size(token->slice),
+      .next_index = count + 1,
+    };
+
+    if (token->kind == AZ_JSON_TOKEN_PROPERTY_NAME || token->kind == AZ_JSON_TOKEN_BEGIN_OBJECT
+        || token->kind == AZ_JSON_TOKEN_BEGIN_ARRAY)
+    {
+      entries[count].next_index = _az_json_tape_encode_parent(open);
+      open = count;
+      count++;
+    }
+    else
+    {
+      count++;
+      _az_json_tape_close_value(entries, count, &open);
+    }
+  }
+
+  if (result != AZ_ERROR_JSON_READER_DONE)
+  {
+    return result;
+  }
+
+  out_tape->_internal.json_buffer = json_buffer;
+  out_tape->_internal.entries = entries;
+  out_tape->_internal.count = count;
+  return AZ_OK;
+}
+
+void az_json_tape_get_token(az_json_tape const* tape, int32_t index, az_json_token* out_token)
+{
+  _az_PRECONDITION_NOT_NULL(tape);
+  _az_PRECONDITION_RANGE(0, index, tape->_internal.count - 1);
+  _az_PRECONDITION_NOT_NULL(out_token);
+
+  az_json_tape_entry const* const entry = &tape->_internal.entries[index];
+  az_span const slice
+      = az_span_slice(tape->_internal.json_buffer, entry->offset, entry->offset + entry->size);
+
+  // Only strings need to know about escapes, and a backslash within them is always one.
+  bool const is_string
+      = entry->kind == AZ_JSON_TOKEN_STRING || entry->kind == AZ_JSON_TOKEN_PROPERTY_NAME;
+  bool const has_escaped_chars = is_string && entry->size > 0
+      && memchr(az_span_ptr(slice), '\\', (size_t)entry->size) != NULL;
+
+  *out_token = (az_json_token){
+    .kind = entry->kind,
+    .slice = slice,
+    .size = entry->size,
+    ._internal = {
+      .is_multisegment = false,
+      .string_has_escaped_chars = has_escaped_chars,
+      .pointer_to_first_buffer = &AZ_SPAN_EMPTY,
+      .start_buffer_index = -1,
+      .start_buffer_offset = -1,
+      .end_buffer_index = -1,
+      .end_buffer_offset = -1,
+    },
+  };
+}
+
+AZ_NODISCARD az_result az_json_tape_find_property(
+    az_json_tape const* tape,
+    int32_t object_index,
+    az_span name,
+    int32_t* out_value_index)
+{
+  _az_PRECONDITION_NOT_NULL(tape);
+  _az_PRECONDITION_RANGE(0, object_index, tape->_internal.count - 1);
+  _az_PRECONDITION(tape->_internal.entries[object_index].kind == AZ_JSON_TOKEN_BEGIN_OBJECT);
+  _az_PRECONDITION_NOT_NULL(out_value_index);
+
+  az_json_tape_entry const* const entries = tape->_internal.entries;
+  int32_t const end = entries[object_index].next_index;
+  for (int32_t i = object_index + 1; i < end; i = entries[i].next_index)
+  {
+    az_json_token name_token = { 0 };
+    az_json_tape_get_token(tape, i, &name_token);
+    if (az_json_token_is_text_equal(&name_token, name))
+    {
+      *out_value_index = i + 1;
+      return AZ_OK;
+    }
+  }
+
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
+
+AZ_NODISCARD az_result az_json_tape_get_array_item(
+    az_json_tape const* tape,
+    int32_t array_index,
+    int32_t position,
+    int32_t* out_item_index)
+{
+  _az_PRECONDITION_NOT_NULL(tape);
+  _az_PRECONDITION_RANGE(0, array_index, tape->_internal.count - 1);
+  _az_PRECONDITION(tape->_internal.entries[array_index].kind == AZ_JSON_TOKEN_BEGIN_ARRAY);
+  _az_PRECONDITION(position >= 0);
+  _az_PRECONDITION_NOT_NULL(out_item_index);
+
+  az_json_tape_entry const* const entries = tape->_internal.entries;
+  int32_t const end = entries[array_index].next_index;
+  int32_t i = array_index + 1;
+  for (int32_t skipped = 0; skipped < position && i < end; skipped++)
+  {
+    i = entries[i].next_index;
+  }
+
+  if (i >= end)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  *out_item_index = i;
+  return AZ_OK;
+}
@@ -5,9 +5,14 @@
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 
+#include "az_hex_private.h"
 #include "az_json_private.h"
+#include "az_simd_private.h"
 
 #include "az_span_private.h"
+
+#include <string.h>
+
 #include <azure/core/_az_cfg.h>
 
 static az_span _az_json_token_copy_into_span_helper(
@@ -83,69 +88,324 @@ AZ_NODISCARD static uint8_t _az_json_unescape_single_byte(uint8_t ch)
   }
 }
 
-AZ_NODISCARD static bool _az_json_token_is_text_equal_helper(
-    az_span token_slice,
-    az_span* expected_text,
-    bool* next_char_escaped)
+// The largest number of bytes an escape sequence is unescaped into: the UTF-8 encoding of a code
+// point outside of the basic multilingual plane, escaped as a \uXXXX\uXXXX surrogate pair.
+#define _az_JSON_UNESCAPED_MAX_SIZE 4
+
+#ifdef _az_SIMD
+
+// The kernels of the unescaping return the number of bytes at the start of `ptr`, in whole blocks,
+// up to the first backslash.
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+AZ_NODISCARD int32_t _az_json_token_unescaped_prefix_sse2(uint8_t const* ptr, int32_t size)
 {
-  int32_t token_size = az_span_size(token_slice);
-  uint8_t* token_ptr = az_span_ptr(token_slice);
+  __m128i const backslash = _mm_set1_epi8('\\');
 
-  int32_t expected_size = az_span_size(*expected_text);
-  uint8_t* expected_ptr = az_span_ptr(*expected_text);
+  int32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i const bytes = _mm_loadu_si128((__m128i const*)(ptr + i));
+    uint64_t const mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash));
+    if (mask != 0)
+    {
+      return i + _az_simd_lowest_bit_index(mask);
+    }
+  }
 
-  int32_t token_idx = 0;
-  for (int32_t i = 0; i < expected_size; i++)
+  return i;
+}
+
+#endif // defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") AZ_NODISCARD int32_t
+    _az_json_token_unescaped_prefix_avx2(uint8_t const* ptr, int32_t size)
+{
+  __m256i const backslash = _mm256_set1_epi8('\\');
+
+  int32_t i = 0;
+  for (; i + 32 <= size; i += 32)
   {
-    if (token_idx >= token_size)
+    __m256i const bytes = _mm256_loadu_si256((__m256i const*)(ptr + i));
+    uint64_t const mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, backslash));
+    if (mask != 0)
     {
-      *expected_text = az_span_slice_to_end(*expected_text, i);
-      return false;
+      return i + _az_simd_lowest_bit_index(mask);
     }
-    uint8_t token_byte = token_ptr[token_idx];
+  }
 
-    if (token_byte == '\\' || *next_char_escaped)
+  return i;
+}
+
+#endif // _az_SIMD_KERNEL_AVX2
+
+#ifdef _az_SIMD_NEON
+
+AZ_NODISCARD int32_t _az_json_token_unescaped_prefix_neon(uint8_t const* ptr, int32_t size)
+{
+  uint8x16_t const backslash = vdupq_n_u8('\\');
+
+  int32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+  {
+    // NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves one nibble per position.
+    uint8x16_t const bytes = vld1q_u8(ptr + i);
+    uint64_t const mask = vget_lane_u64(
+        vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(bytes, backslash)), 4)),
+        0);
+    if (mask != 0)
     {
-      if (*next_char_escaped)
-      {
-        token_byte = _az_json_unescape_single_byte(token_byte);
-      }
-      else
-      {
-        token_idx++;
-        if (token_idx >= token_size)
-        {
-          *next_char_escaped = true;
-          *expected_text = az_span_slice_to_end(*expected_text, i);
-          return false;
-        }
-        token_byte = _az_json_unescape_single_byte(token_ptr[token_idx]);
-      }
-      *next_char_escaped = false;
+      return i + _az_simd_lowest_bit_index(mask) / 4;
+    }
+  }
 
-      // TODO: Characters escaped in the form of \uXXXX where XXXX is the UTF-16 code point, is
-      // not currently supported.
-      // To do this, we need to encode UTF-16 codepoints (including surrogate pairs) into UTF-8.
-      if (token_byte == 'u')
-      {
-        *expected_text = AZ_SPAN_EMPTY;
-        return false;
-      }
+  return i;
+}
+
+#endif // _az_SIMD_NEON
+
+#endif // _az_SIMD
+
+// Returns the number of bytes at the start of the buffer which are unescaped as is, i.e. the index
+// of the first backslash, or size if there is none.
+static AZ_NODISCARD int32_t
+_az_json_token_count_bytes_before_backslash(uint8_t const* source_ptr, int32_t source_size)
+{
+  int32_t i = 0;
+
+#ifdef _az_SIMD
+  i = _az_simd_get_kernels()->json_token_unescaped_prefix(source_ptr, source_size);
+#endif // _az_SIMD
+
+  for (; i < source_size; i++)
+  {
+    if (source_ptr[i] == '\\')
+    {
+      break;
     }
+  }
+
+  return i;
+}
+
+// Reads the bytes of a string token, moving from one segment to the next when the token straddles
+// more than one, so that escape sequences split across segments can be decoded.
+typedef struct
+{
+  az_json_token const* token;
+  az_span remaining;
+  int32_t buffer_index;
+} _az_json_token_string_cursor;
+
+static void _az_json_token_string_cursor_init(
+    _az_json_token_string_cursor* cursor,
+    az_json_token const* json_token)
+{
+  cursor->token = json_token;
+  cursor->remaining = json_token->slice;
+  cursor->buffer_index = json_token->_internal.end_buffer_index;
 
-    if (token_byte != expected_ptr[i])
+  if (json_token->_internal.is_multisegment)
+  {
+    cursor->remaining = AZ_SPAN_EMPTY;
+    if (json_token->size > 0)
+    {
+      cursor->buffer_index = json_token->_internal.start_buffer_index;
+      cursor->remaining = az_span_slice_to_end(
+          json_token->_internal.pointer_to_first_buffer[cursor->buffer_index],
+          json_token->_internal.start_buffer_offset);
+    }
+  }
+}
+
+// Moves on to the next segment with bytes left to read, if the current one has been read entirely.
+// Returns false once the whole token has been read.
+static AZ_NODISCARD bool _az_json_token_string_cursor_refill(_az_json_token_string_cursor* cursor)
+{
+  az_json_token const* const json_token = cursor->token;
+
+  while (az_span_size(cursor->remaining) == 0)
+  {
+    if (!json_token->_internal.is_multisegment
+        || cursor->buffer_index >= json_token->_internal.end_buffer_index)
     {
-      *expected_text = AZ_SPAN_EMPTY;
       return false;
     }
 
-    token_idx++;
+    cursor->buffer_index++;
+    cursor->remaining = json_token->_internal.pointer_to_first_buffer[cursor->buffer_index];
+    if (cursor->buffer_index == json_token->_internal.end_buffer_index)
+    {
+      cursor->remaining
+          = az_span_slice(cursor->remaining, 0, json_token->_internal.end_buffer_offset);
+    }
   }
 
-  *expected_text = AZ_SPAN_EMPTY;
+  return true;
+}
 
-  // Only return true if the size of the unescaped token matches the expected size exactly.
-  return token_idx == token_size;
+static AZ_NODISCARD az_result
+_az_json_token_string_cursor_read_byte(_az_json_token_string_cursor* cursor, uint8_t* out_byte)
+{
+  if (!_az_json_token_string_cursor_refill(cursor))
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  *out_byte = *az_span_ptr(cursor->remaining);
+  cursor->remaining = az_span_slice_to_end(cursor->remaining, 1);
+  return AZ_OK;
+}
+
+// Reads the 4 hex digits of a \uXXXX escape sequence, which follow the 'u'.
+static AZ_NODISCARD az_result _az_json_token_string_cursor_read_code_unit(
+    _az_json_token_string_cursor* cursor,
+    uint32_t* out_code_unit)
+{
+  uint32_t code_unit = 0;
+  for (int32_t i = 0; i < 4; i++)
+  {
+    uint8_t ch = 0;
+    _az_RETURN_IF_FAILED(_az_json_token_string_cursor_read_byte(cursor, &ch));
+
+    uint32_t digit = 0;
+    if (ch >= '0' && ch <= '9')
+    {
+      digit = (uint32_t)(ch - '0');
+    }
+    else if (ch >= 'a' && ch <= 'f')
+    {
+      digit = (uint32_t)(ch - _az_HEX_LOWER_OFFSET);
+    }
+    else if (ch >= 'A' && ch <= 'F')
+    {
+      digit = (uint32_t)(ch - _az_HEX_UPPER_OFFSET);
+    }
+    else
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
+    code_unit = (code_unit << 4) | digit;
+  }
+
+  *out_code_unit = code_unit;
+  return AZ_OK;
+}
+
+// Decodes the escape sequence which follows a backslash. A \uXXXX escape sequence of a high
+// surrogate must be followed by one of a low surrogate, and the pair is decoded into the UTF-8
+// encoding of the single code point they denote. Unpaired surrogates cannot be encoded in UTF-8.
+static AZ_NODISCARD az_result _az_json_token_string_cursor_unescape(
+    _az_json_token_string_cursor* cursor,
+    uint8_t out_bytes[_az_JSON_UNESCAPED_MAX_SIZE],
+    int32_t* out_size)
+{
+  uint8_t ch = 0;
+  _az_RETURN_IF_FAILED(_az_json_token_string_cursor_read_byte(cursor, &ch));
+
+  if (ch != 'u')
+  {
+    out_bytes[0] = _az_json_unescape_single_byte(ch);
+    *out_size = 1;
+    return AZ_OK;
+  }
+
+  uint32_t code_point = 0;
+  _az_RETURN_IF_FAILED(_az_json_token_string_cursor_read_code_unit(cursor, &code_point));
+
+  if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  if (code_point >= 0xD800 && code_point <= 0xDBFF)
+  {
+    // The high surrogate is unpaired if the string ends right after it.
+    uint8_t backslash = 0;
+    uint8_t u = 0;
+    if (az_result_failed(_az_json_token_string_cursor_read_byte(cursor, &backslash))
+        || az_result_failed(_az_json_token_string_cursor_read_byte(cursor, &u))
+        || backslash != '\\' || u != 'u')
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
+    uint32_t low_surrogate = 0;
+    _az_RETURN_IF_FAILED(_az_json_token_string_cursor_read_code_unit(cursor, &low_surrogate));
+    if (low_surrogate < 0xDC00 || low_surrogate > 0xDFFF)
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+
+    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_surrogate - 0xDC00);
+  }
+
+  if (code_point < 0x80)
+  {
+    out_bytes[0] = (uint8_t)code_point;
+    *out_size = 1;
+  }
+  else if (code_point < 0x800)
+  {
+    out_bytes[0] = (uint8_t)(0xC0 | (code_point >> 6));
+    out_bytes[1] = (uint8_t)(0x80 | (code_point & 0x3F));
+    *out_size = 2;
+  }
+  else if (code_point < 0x10000)
+  {
+    out_bytes[0] = (uint8_t)(0xE0 | (code_point >> 12));
+    out_bytes[1] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+    out_bytes[2] = (uint8_t)(0x80 | (code_point & 0x3F));
+    *out_size = 3;
+  }
+  else
+  {
+    out_bytes[0] = (uint8_t)(0xF0 | (code_point >> 18));
+    out_bytes[1] = (uint8_t)(0x80 | ((code_point >> 12) & 0x3F));
+    out_bytes[2] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+    out_bytes[3] = (uint8_t)(0x80 | (code_point & 0x3F));
+    *out_size = 4;
+  }
+
+  return AZ_OK;
+}
+
+// Gets the next piece of the unescaped string: either the run of bytes up to the next backslash
+// within the current segment, which points into the token, or the bytes which the escape sequence
+// there is decoded into, which are written to the scratch buffer. The piece is empty once the whole
+// token has been read.
+static AZ_NODISCARD az_result _az_json_token_string_cursor_next(
+    _az_json_token_string_cursor* cursor,
+    uint8_t scratch[_az_JSON_UNESCAPED_MAX_SIZE],
+    az_span* out_piece)
+{
+  if (!_az_json_token_string_cursor_refill(cursor))
+  {
+    *out_piece = AZ_SPAN_EMPTY;
+    return AZ_OK;
+  }
+
+  int32_t const run_size = _az_json_token_count_bytes_before_backslash(
+      az_span_ptr(cursor->remaining), az_span_size(cursor->remaining));
+  if (run_size > 0)
+  {
+    *out_piece = az_span_slice(cursor->remaining, 0, run_size);
+    cursor->remaining = az_span_slice_to_end(cursor->remaining, run_size);
+    return AZ_OK;
+  }
+
+  // Skip the backslash.
+  cursor->remaining = az_span_slice_to_end(cursor->remaining, 1);
+
+  int32_t unescaped_size = 0;
+  _az_RETURN_IF_FAILED(_az_json_token_string_cursor_unescape(cursor, scratch, &unescaped_size));
+  *out_piece = az_span_create(scratch, unescaped_size);
+  return AZ_OK;
 }
 
 AZ_NODISCARD bool az_json_token_is_text_equal(
@@ -209,31 +469,27 @@ AZ_NODISCARD bool az_json_token_is_text_equal(
     return false;
   }
 
-  bool next_char_escaped = false;
+  _az_json_token_string_cursor cursor = { 0 };
+  _az_json_token_string_cursor_init(&cursor, json_token);
+  uint8_t scratch[_az_JSON_UNESCAPED_MAX_SIZE] = { 0 };
 
-  // Contiguous token
-  if (!json_token->_internal.is_multisegment)
+  az_span piece = AZ_SPAN_EMPTY;
+  if (az_result_failed(_az_json_token_string_cursor_next(&cursor, scratch, &piece)))
   {
-    return _az_json_token_is_text_equal_helper(token_slice, &expected_text, &next_char_escaped);
+    return false;
   }
 
-  // Token straddles more than one segment
-  for (int32_t i = json_token->_internal.start_buffer_index;
-       i <= json_token->_internal.end_buffer_index;
-       i++)
+  while (az_span_size(piece) > 0)
   {
-    az_span source = json_token->_internal.pointer_to_first_buffer[i];
-    if (i == json_token->_internal.start_buffer_index)
-    {
-      source = az_span_slice_to_end(source, json_token->_internal.start_buffer_offset);
-    }
-    else if (i == json_token->_internal.end_buffer_index)
+    int32_t const piece_size = az_span_size(piece);
+    if (az_span_size(expected_text) < piece_size
+        || !az_span_is_content_equal(piece, az_span_slice(expected_text, 0, piece_size)))
     {
-      source = az_span_slice(source, 0, json_token->_internal.end_buffer_offset);
+      return false;
     }
+    expected_text = az_span_slice_to_end(expected_text, piece_size);
 
-    if (!_az_json_token_is_text_equal_helper(source, &expected_text, &next_char_escaped)
-        && az_span_size(expected_text) == 0)
+    if (az_result_failed(_az_json_token_string_cursor_next(&cursor, scratch, &piece)))
     {
       return false;
     }
@@ -274,57 +530,6 @@ AZ_NODISCARD az_result az_json_token_get_boolean(az_json_token const* json_token
   return AZ_OK;
 }
 
-AZ_NODISCARD static az_result _az_json_token_get_string_helper(
-    az_span source,
-    char* destination,
-    int32_t destination_max_size,
-    int32_t* dest_idx,
-    bool* next_char_escaped)
-{
-  int32_t source_size = az_span_size(source);
-  uint8_t* source_ptr = az_span_ptr(source);
-  for (int32_t i = 0; i < source_size; i++)
-  {
-    if (*dest_idx >= destination_max_size)
-    {
-      return AZ_ERROR_NOT_ENOUGH_SPACE;
-    }
-    uint8_t token_byte = source_ptr[i];
-
-    if (token_byte == '\\' || *next_char_escaped)
-    {
-      if (*next_char_escaped)
-      {
-        token_byte = _az_json_unescape_single_byte(token_byte);
-      }
-      else
-      {
-        i++;
-        if (i >= source_size)
-        {
-          *next_char_escaped = true;
-          break;
-        }
-        token_byte = _az_json_unescape_single_byte(source_ptr[i]);
-      }
-      *next_char_escaped = false;
-
-      // TODO: Characters escaped in the form of \uXXXX where XXXX is the UTF-16 code point, is
-      // not currently supported.
-      // To do this, we need to encode UTF-16 codepoints (including surrogate pairs) into UTF-8.
-      if (token_byte == 'u')
-      {
-        return AZ_ERROR_NOT_IMPLEMENTED;
-      }
-    }
-
-    destination[*dest_idx] = (char)token_byte;
-    *dest_idx = *dest_idx + 1;
-  }
-
-  return AZ_OK;
-}
-
 AZ_NODISCARD az_result az_json_token_get_string(
     az_json_token const* json_token,
     char* destination,
@@ -383,40 +588,27 @@ AZ_NODISCARD az_result az_json_token_get_string(
     return AZ_ERROR_NOT_ENOUGH_SPACE;
   }
 
-  int32_t dest_idx = 0;
-  bool next_char_escaped = false;
+  _az_json_token_string_cursor cursor = { 0 };
+  _az_json_token_string_cursor_init(&cursor, json_token);
+  uint8_t scratch[_az_JSON_UNESCAPED_MAX_SIZE] = { 0 };
 
-  // Contiguous token
-  if (!json_token->_internal.is_multisegment)
-  {
-    _az_RETURN_IF_FAILED(_az_json_token_get_string_helper(
-        token_slice, destination, destination_max_size, &dest_idx, &next_char_escaped));
-  }
-  else
+  // Runs of bytes between escape sequences are copied at once.
+  int32_t dest_idx = 0;
+  az_span piece = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_json_token_string_cursor_next(&cursor, scratch, &piece));
+  while (az_span_size(piece) > 0)
   {
-    // Token straddles more than one segment
-    for (int32_t i = json_token->_internal.start_buffer_index;
-         i <= json_token->_internal.end_buffer_index;
-         i++)
-    {
-      az_span source = json_token->_internal.pointer_to_first_buffer[i];
-      if (i == json_token->_internal.start_buffer_index)
-      {
-        source = az_span_slice_to_end(source, json_token->_internal.start_buffer_offset);
-      }
-      else if (i == json_token->_internal.end_buffer_index)
-      {
-        source = az_span_slice(source, 0, json_token->_internal.end_buffer_offset);
-      }
+    int32_t const piece_size = az_span_size(piece);
 
-      _az_RETURN_IF_FAILED(_az_json_token_get_string_helper(
-          source, destination, destination_max_size, &dest_idx, &next_char_escaped));
+    // We need enough space to add a null terminator.
+    if (piece_size >= destination_max_size - dest_idx)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
     }
-  }
+    memcpy(destination + dest_idx, az_span_ptr(piece), (size_t)piece_size);
+    dest_idx += piece_size;
 
-  if (dest_idx >= destination_max_size)
-  {
-    return AZ_ERROR_NOT_ENOUGH_SPACE;
+    _az_RETURN_IF_FAILED(_az_json_token_string_cursor_next(&cursor, scratch, &piece));
   }
   destination[dest_idx] = 0;
 
@@ -428,6 +620,33 @@ AZ_NODISCARD az_result az_json_token_get_string(
   return AZ_OK;
 }
 
+// Gets the value of an integer number token which was parsed by the reader, failing as parsing the
+// token would when it doesn't fit in [-max_negative_magnitude, max_magnitude]. Unsigned integers
+// don't accept a minus sign, not even for "-0".
+static AZ_NODISCARD az_result _az_json_token_get_parsed_integer(
+    az_json_token const* json_token,
+    bool is_signed,
+    uint64_t max_magnitude,
+    uint64_t max_negative_magnitude,
+    uint64_t* out_magnitude)
+{
+  uint64_t const magnitude = json_token->_internal.integer_magnitude;
+  if (json_token->_internal.is_negative)
+  {
+    if (!is_signed || magnitude > max_negative_magnitude)
+    {
+      return AZ_ERROR_UNEXPECTED_CHAR;
+    }
+  }
+  else if (magnitude > max_magnitude)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  *out_magnitude = magnitude;
+  return AZ_OK;
+}
+
 AZ_NODISCARD az_result
 az_json_token_get_uint64(az_json_token const* json_token, uint64_t* out_value)
 {
@@ -439,6 +658,12 @@ az_json_token_get_uint64(az_json_token const* json_token, uint64_t* out_value)
     return AZ_ERROR_JSON_INVALID_STATE;
   }
 
+  // The reader already computed the value while it validated the number.
+  if (json_token->_internal.has_integer_value)
+  {
+    return _az_json_token_get_parsed_integer(json_token, false, UINT64_MAX, 0, out_value);
+  }
+
   az_span token_slice = json_token->slice;
 
   // Contiguous token
@@ -453,8 +678,7 @@ az_json_token_get_uint64(az_json_token const* json_token, uint64_t* out_value)
     return AZ_ERROR_UNEXPECTED_CHAR;
   }
 
-  // Token straddles more than one segment.
-  // Used to copy discontiguous token values into a contiguous buffer, for number parsing.
+  // Otherwise, copy the discontiguous token value into a contiguous buffer, for number parsing.
   uint8_t scratch_buffer[_az_MAX_SIZE_FOR_UINT64] = { 0 };
   az_span scratch = AZ_SPAN_FROM_BUFFER(scratch_buffer);
 
@@ -474,6 +698,15 @@ az_json_token_get_uint32(az_json_token const* json_token, uint32_t* out_value)
     return AZ_ERROR_JSON_INVALID_STATE;
   }
 
+  if (json_token->_internal.has_integer_value)
+  {
+    uint64_t magnitude = 0;
+    _az_RETURN_IF_FAILED(
+        _az_json_token_get_parsed_integer(json_token, false, UINT32_MAX, 0, &magnitude));
+    *out_value = (uint32_t)magnitude;
+    return AZ_OK;
+  }
+
   az_span token_slice = json_token->slice;
 
   // Contiguous token
@@ -488,8 +721,7 @@ az_json_token_get_uint32(az_json_token const* json_token, uint32_t* out_value)
     return AZ_ERROR_UNEXPECTED_CHAR;
   }
 
-  // Token straddles more than one segment.
-  // Used to copy discontiguous token values into a contiguous buffer, for number parsing.
+  // Otherwise, copy the discontiguous token value into a contiguous buffer, for number parsing.
   uint8_t scratch_buffer[_az_MAX_SIZE_FOR_UINT32] = { 0 };
   az_span scratch = AZ_SPAN_FROM_BUFFER(scratch_buffer);
 
@@ -508,6 +740,17 @@ AZ_NODISCARD az_result az_json_token_get_int64(az_json_token const* json_token,
     return AZ_ERROR_JSON_INVALID_STATE;
   }
 
+  if (json_token->_internal.has_integer_value)
+  {
+    uint64_t magnitude = 0;
+    _az_RETURN_IF_FAILED(_az_json_token_get_parsed_integer(
+        json_token, true, INT64_MAX, (uint64_t)INT64_MAX + 1, &magnitude));
+
+    // Negating in unsigned arithmetic wraps INT64_MAX + 1 around to INT64_MIN.
+    *out_value = json_token->_internal.is_negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    return AZ_OK;
+  }
+
   az_span token_slice = json_token->slice;
 
   // Contiguous token
@@ -522,8 +765,7 @@ AZ_NODISCARD az_result az_json_token_get_int64(az_json_token const* json_token,
     return AZ_ERROR_UNEXPECTED_CHAR;
   }
 
-  // Token straddles more than one segment.
-  // Used to copy discontiguous token values into a contiguous buffer, for number parsing.
+  // Otherwise, copy the discontiguous token value into a contiguous buffer, for number parsing.
   uint8_t scratch_buffer[_az_MAX_SIZE_FOR_INT64] = { 0 };
   az_span scratch = AZ_SPAN_FROM_BUFFER(scratch_buffer);
 
@@ -542,6 +784,18 @@ AZ_NODISCARD az_result az_json_token_get_int32(az_json_token const* json_token,
     return AZ_ERROR_JSON_INVALID_STATE;
   }
 
+  if (json_token->_internal.has_integer_value)
+  {
+    uint64_t magnitude = 0;
+    _az_RETURN_IF_FAILED(_az_json_token_get_parsed_integer(
+        json_token, true, INT32_MAX, (uint64_t)INT32_MAX + 1, &magnitude));
+
+    int64_t const value
+        = json_token->_internal.is_negative ? -(int64_t)magnitude : (int64_t)magnitude;
+    *out_value = (int32_t)value;
+    return AZ_OK;
+  }
+
   az_span token_slice = json_token->slice;
 
   // Contiguous token
@@ -556,8 +810,7 @@ AZ_NODISCARD az_result az_json_token_get_int32(az_json_token const* json_token,
     return AZ_ERROR_UNEXPECTED_CHAR;
   }
 
-  // Token straddles more than one segment.
-  // Used to copy discontiguous token values into a contiguous buffer, for number parsing.
+  // Otherwise, copy the discontiguous token value into a contiguous buffer, for number parsing.
   uint8_t scratch_buffer[_az_MAX_SIZE_FOR_INT32] = { 0 };
   az_span scratch = AZ_SPAN_FROM_BUFFER(scratch_buffer);
 
@@ -576,6 +829,15 @@ AZ_NODISCARD az_result az_json_token_get_double(az_json_token const* json_token,
     return AZ_ERROR_JSON_INVALID_STATE;
   }
 
+  // Integers up to _az_MAX_SAFE_INTEGER convert to a double exactly.
+  if (json_token->_internal.has_integer_value
+      && json_token->_internal.integer_magnitude <= _az_MAX_SAFE_INTEGER)
+  {
+    double const value = (double)json_token->_internal.integer_magnitude;
+    *out_value = json_token->_internal.is_negative ? -value : value;
+    return AZ_OK;
+  }
+
   az_span token_slice = json_token->slice;
 
   // Contiguous token
@@ -590,8 +852,31 @@ AZ_NODISCARD az_result az_json_token_get_double(az_json_token const* json_token,
     return AZ_ERROR_UNEXPECTED_CHAR;
   }
 
-  // Token straddles more than one segment.
-  // Used to copy discontiguous token values into a contiguous buffer, for number parsing.
+  // Most numbers can be converted exactly by reading each segment in place.
+  _az_span_double_parser parser = { 0 };
+  _az_span_double_parser_init(&parser);
+  for (int32_t i = json_token->_internal.start_buffer_index;
+       i <= json_token->_internal.end_buffer_index;
+       i++)
+  {
+    az_span source = json_token->_internal.pointer_to_first_buffer[i];
+    if (i == json_token->_internal.start_buffer_index)
+    {
+      source = az_span_slice_to_end(source, json_token->_internal.start_buffer_offset);
+    }
+    else if (i == json_token->_internal.end_buffer_index)
+    {
+      source = az_span_slice(source, 0, json_token->_internal.end_buffer_offset);
+    }
+    _az_span_double_parser_append(&parser, source);
+  }
+
+  if (_az_span_double_parser_get_value(&parser, out_value))
+  {
+    return AZ_OK;
+  }
+
+  // Otherwise, copy the discontiguous token value into a contiguous buffer, for number parsing.
   uint8_t scratch_buffer[_az_MAX_SIZE_FOR_PARSING_DOUBLE] = { 0 };
   az_span scratch = AZ_SPAN_FROM_BUFFER(scratch_buffer);
 
@@ -599,3 +884,116 @@ AZ_NODISCARD az_result az_json_token_get_double(az_json_token const* json_token,
 
   return az_span_atod(az_span_slice(scratch, 0, _az_span_diff(remainder, scratch)), out_value);
 }
+
+enum
+{
+  // Names at least this long share the last bit of az_json_property_matcher's sizes.
+  _az_JSON_PROPERTY_MATCHER_MAX_SIZE_BIT = 63,
+};
+
+AZ_NODISCARD AZ_INLINE uint64_t _az_json_property_matcher_size_bit(int32_t size)
+{
+  int32_t const bit = size < _az_JSON_PROPERTY_MATCHER_MAX_SIZE_BIT
+      ? size
+      : _az_JSON_PROPERTY_MATCHER_MAX_SIZE_BIT;
+  return (uint64_t)1 << bit;
+}
+
+AZ_NODISCARD az_result az_json_property_matcher_init(
+    az_json_property_matcher* out_matcher,
+    az_span const names[],
+    int32_t names_count)
+{
+  _az_PRECONDITION_NOT_NULL(out_matcher);
+  _az_PRECONDITION(names_count >= 0);
+  _az_PRECONDITION(names_count == 0 || names != NULL);
+
+  *out_matcher = (az_json_property_matcher){
+    ._internal = {
+      .names = names,
+      .names_count = names_count,
+      .sizes = 0,
+      .first_bytes = { 0 },
+    },
+  };
+
+  for (int32_t i = 0; i < names_count; i++)
+  {
+    int32_t const size = az_span_size(names[i]);
+    out_matcher->_internal.sizes |= _az_json_property_matcher_size_bit(size);
+    if (size > 0)
+    {
+      uint8_t const first_byte = az_span_ptr(names[i])[0];
+      out_matcher->_internal.first_bytes[first_byte / 64] |= (uint64_t)1 << (first_byte % 64);
+    }
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD int32_t az_json_property_matcher_find(
+    az_json_property_matcher const* matcher,
+    az_json_token const* json_token)
+{
+  _az_PRECONDITION_NOT_NULL(matcher);
+  _az_PRECONDITION_NOT_NULL(json_token);
+
+  az_json_token_kind const kind = json_token->kind;
+  if (kind != AZ_JSON_TOKEN_STRING && kind != AZ_JSON_TOKEN_PROPERTY_NAME)
+  {
+    return -1;
+  }
+
+  az_span const* const names = matcher->_internal.names;
+  int32_t const names_count = matcher->_internal.names_count;
+
+  // The unescaped text of these tokens isn't contiguous in the JSON buffer.
+  if (json_token->_internal.string_has_escaped_chars || json_token->_internal.is_multisegment)
+  {
+    for (int32_t i = 0; i < names_count; i++)
+    {
+      if (az_json_token_is_text_equal(json_token, names[i]))
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  az_span const token_slice = json_token->slice;
+  int32_t const token_size = az_span_size(token_slice);
+  if ((matcher->_internal.sizes & _az_json_property_matcher_size_bit(token_size)) == 0)
+  {
+    return -1;
+  }
+
+  if (token_size == 0)
+  {
+    for (int32_t i = 0; i < names_count; i++)
+    {
+      if (az_span_size(names[i]) == 0)
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  uint8_t const* const token_ptr = az_span_ptr(token_slice);
+  uint8_t const first_byte = token_ptr[0];
+  if ((matcher->_internal.first_bytes[first_byte / 64] & ((uint64_t)1 << (first_byte % 64))) == 0)
+  {
+    return -1;
+  }
+
+  for (int32_t i = 0; i < names_count; i++)
+  {
+    if (az_span_size(names[i]) == token_size && az_span_ptr(names[i])[0] == first_byte
+        && memcmp(az_span_ptr(names[i]) + 1, token_ptr + 1, (size_t)(token_size - 1)) == 0)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
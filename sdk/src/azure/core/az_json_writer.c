@@ -3,8 +3,11 @@
 
 #include "az_hex_private.h"
 #include "az_json_private.h"
+#include "az_simd_private.h"
 #include "az_span_private.h"
 #include <azure/core/az_json.h>
+#include <azure/core/az_ndjson.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 
@@ -23,12 +26,15 @@ AZ_NODISCARD az_result az_json_writer_init(
     ._internal = {
       .destination_buffer = destination_buffer,
       .allocator_callback = NULL,
+      .flush_callback = NULL,
       .user_context = NULL,
+      .is_measuring = false,
       .bytes_written = 0,
       .total_bytes_written = 0,
       .need_comma = false,
       .token_kind = AZ_JSON_TOKEN_NONE,
-      .bit_stack = { 0 },
+      .bit_stack = _az_json_stack_create(
+          options == NULL ? AZ_SPAN_EMPTY : options->nesting_stack_buffer),
       .options = options == NULL ? az_json_writer_options_default() : *options,
     },
   };
@@ -49,27 +55,102 @@ AZ_NODISCARD az_result az_json_writer_chunked_init(
     ._internal = {
       .destination_buffer = first_destination_buffer,
       .allocator_callback = allocator_callback,
+      .flush_callback = NULL,
       .user_context = user_context,
+      .is_measuring = false,
       .bytes_written = 0,
       .total_bytes_written = 0,
       .need_comma = false,
       .token_kind = AZ_JSON_TOKEN_NONE,
-      .bit_stack = { 0 },
+      .bit_stack = _az_json_stack_create(
+          options == NULL ? AZ_SPAN_EMPTY : options->nesting_stack_buffer),
       .options = options == NULL ? az_json_writer_options_default() : *options,
     },
   };
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_json_writer_sink_init(
+    az_json_writer* out_json_writer,
+    az_span scratch_buffer,
+    az_json_writer_flush_fn flush_callback,
+    void* user_context,
+    az_json_writer_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_json_writer);
+  _az_PRECONDITION_VALID_SPAN(scratch_buffer, _az_MINIMUM_STRING_CHUNK_SIZE, false);
+  _az_PRECONDITION_NOT_NULL(flush_callback);
+
+  _az_RETURN_IF_FAILED(az_json_writer_init(out_json_writer, scratch_buffer, options));
+  out_json_writer->_internal.flush_callback = flush_callback;
+  out_json_writer->_internal.user_context = user_context;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_writer_flush(az_json_writer* ref_json_writer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  _az_PRECONDITION_NOT_NULL(ref_json_writer->_internal.flush_callback);
+
+  if (ref_json_writer->_internal.bytes_written > 0)
+  {
+    _az_RETURN_IF_FAILED(ref_json_writer->_internal.flush_callback(
+        ref_json_writer->_internal.user_context,
+        az_json_writer_get_bytes_used_in_destination(ref_json_writer)));
+    ref_json_writer->_internal.bytes_written = 0;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_json_writer_measure_init(az_json_writer* out_json_writer, az_json_writer_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_json_writer);
+
+  _az_RETURN_IF_FAILED(az_json_writer_init(out_json_writer, AZ_SPAN_EMPTY, options));
+  out_json_writer->_internal.is_measuring = true;
+  return AZ_OK;
+}
+
+void az_json_writer_reset(az_json_writer* ref_json_writer, az_span destination_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  _az_PRECONDITION(
+      ref_json_writer->_internal.flush_callback == NULL
+      || az_span_size(destination_buffer) >= _az_MINIMUM_STRING_CHUNK_SIZE);
+
+  // Only the state which writing changes is set again: the options, the callbacks and whether the
+  // writer is measuring are kept as they are.
+  ref_json_writer->_internal.destination_buffer = destination_buffer;
+  ref_json_writer->_internal.bytes_written = 0;
+  ref_json_writer->_internal.total_bytes_written = 0;
+  ref_json_writer->_internal.need_comma = false;
+  ref_json_writer->_internal.token_kind = AZ_JSON_TOKEN_NONE;
+  _az_json_stack_reset(&ref_json_writer->_internal.bit_stack);
+}
+
 static AZ_NODISCARD az_span
 _get_remaining_span(az_json_writer* ref_json_writer, int32_t required_size)
 {
   _az_PRECONDITION_NOT_NULL(ref_json_writer);
   _az_PRECONDITION(required_size > 0);
 
-  az_span remaining = az_span_slice_to_end(
+  az_span remaining = _az_span_slice_to_end_unchecked(
       ref_json_writer->_internal.destination_buffer, ref_json_writer->_internal.bytes_written);
 
+  // A sink is passed what the buffer holds, and the buffer is then written again from its start.
+  if (az_span_size(remaining) < required_size && ref_json_writer->_internal.flush_callback != NULL
+      && ref_json_writer->_internal.bytes_written > 0)
+  {
+    // As with the allocator, let the caller fail with AZ_ERROR_NOT_ENOUGH_SPACE.
+    if (az_result_failed(az_json_writer_flush(ref_json_writer)))
+    {
+      return AZ_SPAN_EMPTY;
+    }
+    remaining = ref_json_writer->_internal.destination_buffer;
+  }
+
   if (az_span_size(remaining) < required_size
       && ref_json_writer->_internal.allocator_callback != NULL)
   {
@@ -199,6 +280,124 @@ static AZ_NODISCARD bool _az_is_appending_container_end_valid(
 }
 #endif // AZ_NO_PRECONDITION_CHECKING
 
+#ifdef _az_SIMD
+
+/*
+ * The kernels of the JSON writer return the number of bytes at the start of `ptr`, in whole
+ * blocks, up to the first quote, backslash or control character. The SIMD instruction sets only
+ * compare signed bytes for less than, so control characters are found as the bytes which an
+ * unsigned minimum with 0x1F leaves unchanged.
+ */
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+AZ_NODISCARD int32_t _az_json_writer_unescaped_prefix_sse2(uint8_t const* ptr, int32_t size)
+{
+  __m128i const quote = _mm_set1_epi8('"');
+  __m128i const backslash = _mm_set1_epi8('\\');
+  __m128i const last_control = _mm_set1_epi8(0x1F);
+
+  int32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i const bytes = _mm_loadu_si128((__m128i const*)(ptr + i));
+    __m128i const to_escape = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+        _mm_cmpeq_epi8(_mm_min_epu8(bytes, last_control), bytes));
+    uint64_t const mask = (uint32_t)_mm_movemask_epi8(to_escape);
+    if (mask != 0)
+    {
+      return i + _az_simd_lowest_bit_index(mask);
+    }
+  }
+
+  return i;
+}
+
+#endif // defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") AZ_NODISCARD int32_t
+    _az_json_writer_unescaped_prefix_avx2(uint8_t const* ptr, int32_t size)
+{
+  __m256i const quote = _mm256_set1_epi8('"');
+  __m256i const backslash = _mm256_set1_epi8('\\');
+  __m256i const last_control = _mm256_set1_epi8(0x1F);
+
+  int32_t i = 0;
+  for (; i + 32 <= size; i += 32)
+  {
+    __m256i const bytes = _mm256_loadu_si256((__m256i const*)(ptr + i));
+    __m256i const to_escape = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote), _mm256_cmpeq_epi8(bytes, backslash)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, last_control), bytes));
+    uint64_t const mask = (uint32_t)_mm256_movemask_epi8(to_escape);
+    if (mask != 0)
+    {
+      return i + _az_simd_lowest_bit_index(mask);
+    }
+  }
+
+  return i;
+}
+
+#endif // _az_SIMD_KERNEL_AVX2
+
+#ifdef _az_SIMD_NEON
+
+AZ_NODISCARD int32_t _az_json_writer_unescaped_prefix_neon(uint8_t const* ptr, int32_t size)
+{
+  uint8x16_t const quote = vdupq_n_u8('"');
+  uint8x16_t const backslash = vdupq_n_u8('\\');
+  uint8x16_t const last_control = vdupq_n_u8(0x1F);
+
+  int32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+  {
+    // NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves one nibble per position.
+    uint8x16_t const bytes = vld1q_u8(ptr + i);
+    uint8x16_t const to_escape = vorrq_u8(
+        vorrq_u8(vceqq_u8(bytes, quote), vceqq_u8(bytes, backslash)),
+        vcleq_u8(bytes, last_control));
+    uint64_t const mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(to_escape), 4)), 0);
+    if (mask != 0)
+    {
+      return i + _az_simd_lowest_bit_index(mask) / 4;
+    }
+  }
+
+  return i;
+}
+
+#endif // _az_SIMD_NEON
+
+#endif // _az_SIMD
+
+// Returns the number of bytes at the start of the buffer which can be copied into a JSON string as
+// is, i.e. the index of the first quote, backslash or control character, or size if there is none.
+static AZ_NODISCARD int32_t
+_az_json_writer_count_bytes_to_copy_as_is(uint8_t const* value_ptr, int32_t value_size)
+{
+  int32_t i = 0;
+
+#ifdef _az_SIMD
+  i = _az_simd_get_kernels()->json_writer_unescaped_prefix(value_ptr, value_size);
+#endif // _az_SIMD
+
+  for (; i < value_size; i++)
+  {
+    uint8_t const ch = value_ptr[i];
+    if (ch == '"' || ch == '\\' || ch < 0x20)
+    {
+      break;
+    }
+  }
+
+  return i;
+}
+
 // Returns the length of the JSON string within the az_span after it has been escaped.
 // The out parameter contains the index where the first character to escape is found.
 // If no chars need to be escaped then return the size of value with the out parameter set to -1.
@@ -210,8 +409,8 @@ static int32_t _az_json_writer_escaped_length(
     bool break_on_first_escaped)
 {
   _az_PRECONDITION_NOT_NULL(out_index_of_first_escaped_char);
-  _az_PRECONDITION_VALID_SPAN(value, 0, true);
 
+  // The public functions appending the value validated it.
   int32_t value_size = az_span_size(value);
   _az_PRECONDITION(value_size <= _az_MAX_UNESCAPED_STRING_SIZE);
 
@@ -223,6 +422,17 @@ static int32_t _az_json_writer_escaped_length(
 
   while (i < value_size)
   {
+    // Skip over the run of bytes which don't need to be escaped, many at a time.
+    int32_t const copied_as_is
+        = _az_json_writer_count_bytes_to_copy_as_is(value_ptr + i, value_size - i);
+    escaped_length += copied_as_is;
+    i += copied_as_is;
+
+    if (i == value_size)
+    {
+      break;
+    }
+
     uint8_t const ch = value_ptr[i];
 
     switch (ch)
@@ -336,12 +546,13 @@ static int32_t _az_json_writer_escape_next_byte_and_copy(
           _az_number_to_upper_hex((uint8_t)(next_byte / 16)),
           _az_number_to_upper_hex((uint8_t)(next_byte % 16)),
         };
-        *remaining_destination = az_span_copy(*remaining_destination, AZ_SPAN_FROM_BUFFER(array));
+        *remaining_destination
+            = _az_span_copy_unchecked(*remaining_destination, AZ_SPAN_FROM_BUFFER(array));
         written += 6;
       }
       else
       {
-        *remaining_destination = az_span_copy_u8(*remaining_destination, next_byte);
+        *remaining_destination = _az_span_copy_u8_unchecked(*remaining_destination, next_byte);
         written++;
       }
       break;
@@ -353,8 +564,8 @@ static int32_t _az_json_writer_escape_next_byte_and_copy(
   // the character.
   if (escaped)
   {
-    *remaining_destination = az_span_copy_u8(*remaining_destination, '\\');
-    *remaining_destination = az_span_copy_u8(*remaining_destination, escaped);
+    *remaining_destination = _az_span_copy_u8_unchecked(*remaining_destination, '\\');
+    *remaining_destination = _az_span_copy_u8_unchecked(*remaining_destination, escaped);
     written += 2;
   }
   return written;
@@ -362,11 +573,10 @@ static int32_t _az_json_writer_escape_next_byte_and_copy(
 
 static AZ_NODISCARD az_span _az_json_writer_escape_and_copy(az_span destination, az_span source)
 {
-  _az_PRECONDITION_VALID_SPAN(source, 1, false);
-
+  // The public functions appending the value validated it, and reserved the escaped size of it in
+  // the destination.
   int32_t src_size = az_span_size(source);
-  _az_PRECONDITION(src_size <= _az_MAX_UNESCAPED_STRING_SIZE);
-  _az_PRECONDITION_VALID_SPAN(destination, src_size + 1, false);
+  _az_PRECONDITION(src_size > 0 && src_size <= _az_MAX_UNESCAPED_STRING_SIZE);
 
   int32_t i = 0;
   uint8_t* value_ptr = az_span_ptr(source);
@@ -375,6 +585,18 @@ static AZ_NODISCARD az_span _az_json_writer_escape_and_copy(az_span destination,
 
   while (i < src_size)
   {
+    // Bulk copy the run of bytes which don't need to be escaped, before escaping the next one.
+    int32_t const copied_as_is
+        = _az_json_writer_count_bytes_to_copy_as_is(value_ptr + i, src_size - i);
+    remaining_destination = _az_span_copy_unchecked(
+        remaining_destination, _az_span_slice_unchecked(source, i, i + copied_as_is));
+    i += copied_as_is;
+
+    if (i == src_size)
+    {
+      break;
+    }
+
     uint8_t const ch = value_ptr[i];
     _az_json_writer_escape_next_byte_and_copy(&remaining_destination, ch);
     i++;
@@ -390,8 +612,13 @@ AZ_INLINE void _az_update_json_writer_state(
     bool need_comma,
     az_json_token_kind token_kind)
 {
-  ref_json_writer->_internal.bytes_written += bytes_written_in_last;
   ref_json_writer->_internal.total_bytes_written += total_bytes_written;
+  if (!ref_json_writer->_internal.is_measuring)
+  {
+    ref_json_writer->_internal.bytes_written += bytes_written_in_last;
+    _az_BUFFER_STATS_RECORD(
+        _az_BUFFER_STATS_JSON_WRITER, ref_json_writer->_internal.total_bytes_written);
+  }
   ref_json_writer->_internal.need_comma = need_comma;
   ref_json_writer->_internal.token_kind = token_kind;
 }
@@ -403,7 +630,7 @@ static AZ_NODISCARD az_result az_json_writer_span_copy_chunked(
 {
   if (az_span_size(value) < az_span_size(*remaining_json))
   {
-    *remaining_json = az_span_copy(*remaining_json, value);
+    *remaining_json = _az_span_copy_unchecked(*remaining_json, value);
     ref_json_writer->_internal.bytes_written += az_span_size(value);
   }
   else
@@ -414,13 +641,13 @@ static AZ_NODISCARD az_result az_json_writer_span_copy_chunked(
       az_span value_slice_that_fits = value;
       if (destination_size < az_span_size(value))
       {
-        value_slice_that_fits = az_span_slice(value, 0, destination_size);
+        value_slice_that_fits = _az_span_slice_unchecked(value, 0, destination_size);
       }
 
-      az_span_copy(*remaining_json, value_slice_that_fits);
+      _az_span_copy_unchecked(*remaining_json, value_slice_that_fits);
       ref_json_writer->_internal.bytes_written += az_span_size(value_slice_that_fits);
 
-      value = az_span_slice_to_end(value, az_span_size(value_slice_that_fits));
+      value = _az_span_slice_to_end_unchecked(value, az_span_size(value_slice_that_fits));
       *remaining_json = _get_remaining_span(ref_json_writer, _az_MINIMUM_STRING_CHUNK_SIZE);
       _az_RETURN_IF_NOT_ENOUGH_SIZE(*remaining_json, _az_MINIMUM_STRING_CHUNK_SIZE);
     }
@@ -428,6 +655,28 @@ static AZ_NODISCARD az_result az_json_writer_span_copy_chunked(
   return AZ_OK;
 }
 
+// Counts the size of a string or property name for a measuring writer, with the same escaping as
+// when it is written, whatever its length.
+static AZ_NODISCARD az_result _az_json_writer_measure_string(
+    az_json_writer* ref_json_writer,
+    az_span value,
+    int32_t delimiters_size,
+    bool need_comma,
+    az_json_token_kind token_kind)
+{
+  int32_t required_size = delimiters_size;
+  if (ref_json_writer->_internal.need_comma)
+  {
+    required_size++; // For the leading comma separator.
+  }
+
+  int32_t index_of_first_escaped_char = -1;
+  required_size += _az_json_writer_escaped_length(value, &index_of_first_escaped_char, false);
+
+  _az_update_json_writer_state(ref_json_writer, 0, required_size, need_comma, token_kind);
+  return AZ_OK;
+}
+
 static AZ_NODISCARD az_result
 az_json_writer_append_string_small(az_json_writer* ref_json_writer, az_span value)
 {
@@ -450,27 +699,27 @@ az_json_writer_append_string_small(az_json_writer* ref_json_writer, az_span valu
 
   if (ref_json_writer->_internal.need_comma)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
   }
 
-  remaining_json = az_span_copy_u8(remaining_json, '"');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, '"');
 
   // No character needed to be escaped, copy the whole string as is.
   if (index_of_first_escaped_char == -1)
   {
-    remaining_json = az_span_copy(remaining_json, value);
+    remaining_json = _az_span_copy_unchecked(remaining_json, value);
   }
   else
   {
     // Bulk copy the characters that didn't need to be escaped before dropping to the byte-by-byte
     // encode and copy.
-    remaining_json
-        = az_span_copy(remaining_json, az_span_slice(value, 0, index_of_first_escaped_char));
+    remaining_json = _az_span_copy_unchecked(
+        remaining_json, _az_span_slice_unchecked(value, 0, index_of_first_escaped_char));
     remaining_json = _az_json_writer_escape_and_copy(
-        remaining_json, az_span_slice_to_end(value, index_of_first_escaped_char));
+        remaining_json, _az_span_slice_to_end_unchecked(value, index_of_first_escaped_char));
   }
 
-  az_span_copy_u8(remaining_json, '"');
+  _az_span_copy_u8_unchecked(remaining_json, '"');
 
   _az_update_json_writer_state(
       ref_json_writer, required_size, required_size, true, AZ_JSON_TOKEN_STRING);
@@ -488,18 +737,18 @@ az_json_writer_append_string_chunked(az_json_writer* ref_json_writer, az_span va
   int32_t required_size = 2; // For the surrounding quotes.
   if (ref_json_writer->_internal.need_comma)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
     required_size++;
     ref_json_writer->_internal.bytes_written++;
   }
 
-  remaining_json = az_span_copy_u8(remaining_json, '"');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, '"');
   ref_json_writer->_internal.bytes_written++;
 
   int32_t consumed = 0;
   do
   {
-    az_span value_slice = az_span_slice_to_end(value, consumed);
+    az_span value_slice = _az_span_slice_to_end_unchecked(value, consumed);
     int32_t index_of_first_escaped_char = -1;
     _az_json_writer_escaped_length(value_slice, &index_of_first_escaped_char, true);
 
@@ -517,7 +766,7 @@ az_json_writer_append_string_chunked(az_json_writer* ref_json_writer, az_span va
       _az_RETURN_IF_FAILED(az_json_writer_span_copy_chunked(
           ref_json_writer,
           &remaining_json,
-          az_span_slice(value_slice, 0, index_of_first_escaped_char)));
+          _az_span_slice_unchecked(value_slice, 0, index_of_first_escaped_char)));
 
       consumed += index_of_first_escaped_char;
 
@@ -541,7 +790,7 @@ az_json_writer_append_string_chunked(az_json_writer* ref_json_writer, az_span va
   remaining_json = _get_remaining_span(ref_json_writer, _az_MINIMUM_STRING_CHUNK_SIZE);
   _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, _az_MINIMUM_STRING_CHUNK_SIZE);
 
-  az_span_copy_u8(remaining_json, '"');
+  _az_span_copy_u8_unchecked(remaining_json, '"');
   ref_json_writer->_internal.bytes_written++;
 
   // Currently, required_size only counts the escaped bytes, so add back the length of the input
@@ -561,6 +810,12 @@ AZ_NODISCARD az_result az_json_writer_append_string(az_json_writer* ref_json_wri
   _az_PRECONDITION(az_span_size(value) <= _az_MAX_UNESCAPED_STRING_SIZE);
   _az_PRECONDITION(_az_is_appending_value_valid(ref_json_writer));
 
+  if (ref_json_writer->_internal.is_measuring)
+  {
+    // For the surrounding quotes.
+    return _az_json_writer_measure_string(ref_json_writer, value, 2, true, AZ_JSON_TOKEN_STRING);
+  }
+
   if (az_span_size(value) <= _az_MAX_UNESCAPED_STRING_SIZE_PER_CHUNK)
   {
     return az_json_writer_append_string_small(ref_json_writer, value);
@@ -593,28 +848,28 @@ az_json_writer_append_property_name_small(az_json_writer* ref_json_writer, az_sp
 
   if (ref_json_writer->_internal.need_comma)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
   }
 
-  remaining_json = az_span_copy_u8(remaining_json, '"');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, '"');
 
   // No character needed to be escaped, copy the whole string as is.
   if (index_of_first_escaped_char == -1)
   {
-    remaining_json = az_span_copy(remaining_json, value);
+    remaining_json = _az_span_copy_unchecked(remaining_json, value);
   }
   else
   {
     // Bulk copy the characters that didn't need to be escaped before dropping to the byte-by-byte
     // encode and copy.
-    remaining_json
-        = az_span_copy(remaining_json, az_span_slice(value, 0, index_of_first_escaped_char));
+    remaining_json = _az_span_copy_unchecked(
+        remaining_json, _az_span_slice_unchecked(value, 0, index_of_first_escaped_char));
     remaining_json = _az_json_writer_escape_and_copy(
-        remaining_json, az_span_slice_to_end(value, index_of_first_escaped_char));
+        remaining_json, _az_span_slice_to_end_unchecked(value, index_of_first_escaped_char));
   }
 
-  remaining_json = az_span_copy_u8(remaining_json, '"');
-  remaining_json = az_span_copy_u8(remaining_json, ':');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, '"');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, ':');
 
   _az_update_json_writer_state(
       ref_json_writer, required_size, required_size, false, AZ_JSON_TOKEN_PROPERTY_NAME);
@@ -632,18 +887,18 @@ az_json_writer_append_property_name_chunked(az_json_writer* ref_json_writer, az_
   int32_t required_size = 3; // For the surrounding quotes and the key:value separator colon.
   if (ref_json_writer->_internal.need_comma)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
     required_size++;
     ref_json_writer->_internal.bytes_written++;
   }
 
-  remaining_json = az_span_copy_u8(remaining_json, '"');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, '"');
   ref_json_writer->_internal.bytes_written++;
 
   int32_t consumed = 0;
   do
   {
-    az_span value_slice = az_span_slice_to_end(value, consumed);
+    az_span value_slice = _az_span_slice_to_end_unchecked(value, consumed);
     int32_t index_of_first_escaped_char = -1;
     _az_json_writer_escaped_length(value_slice, &index_of_first_escaped_char, true);
 
@@ -661,7 +916,7 @@ az_json_writer_append_property_name_chunked(az_json_writer* ref_json_writer, az_
       _az_RETURN_IF_FAILED(az_json_writer_span_copy_chunked(
           ref_json_writer,
           &remaining_json,
-          az_span_slice(value_slice, 0, index_of_first_escaped_char)));
+          _az_span_slice_unchecked(value_slice, 0, index_of_first_escaped_char)));
 
       consumed += index_of_first_escaped_char;
 
@@ -685,8 +940,8 @@ az_json_writer_append_property_name_chunked(az_json_writer* ref_json_writer, az_
   remaining_json = _get_remaining_span(ref_json_writer, _az_MINIMUM_STRING_CHUNK_SIZE);
   _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, _az_MINIMUM_STRING_CHUNK_SIZE);
 
-  remaining_json = az_span_copy_u8(remaining_json, '"');
-  remaining_json = az_span_copy_u8(remaining_json, ':');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, '"');
+  remaining_json = _az_span_copy_u8_unchecked(remaining_json, ':');
   ref_json_writer->_internal.bytes_written += 2;
 
   // Currently, required_size only counts the escaped bytes, so add back the length of the input
@@ -708,6 +963,13 @@ az_json_writer_append_property_name(az_json_writer* ref_json_writer, az_span nam
   _az_PRECONDITION(az_span_size(name) <= _az_MAX_UNESCAPED_STRING_SIZE);
   _az_PRECONDITION(_az_is_appending_property_name_valid(ref_json_writer));
 
+  if (ref_json_writer->_internal.is_measuring)
+  {
+    // For the surrounding quotes and the key:value separator colon.
+    return _az_json_writer_measure_string(
+        ref_json_writer, name, 3, false, AZ_JSON_TOKEN_PROPERTY_NAME);
+  }
+
   if (az_span_size(name) <= _az_MAX_UNESCAPED_STRING_SIZE_PER_CHUNK)
   {
     return az_json_writer_append_property_name_small(ref_json_writer, name);
@@ -753,24 +1015,13 @@ static AZ_NODISCARD az_result _az_validate_json(
   return AZ_OK;
 }
 
-AZ_NODISCARD az_result
-az_json_writer_append_json_text(az_json_writer* ref_json_writer, az_span json_text)
+// Appends a JSON text validated by _az_validate_json(), which returned its last_token_kind.
+static AZ_NODISCARD az_result _az_json_writer_append_validated_json_text(
+    az_json_writer* ref_json_writer,
+    az_span json_text,
+    az_json_token_kind last_token_kind)
 {
-  _az_PRECONDITION_NOT_NULL(ref_json_writer);
-  // A null or empty span is not allowed since that is invalid JSON.
-  _az_PRECONDITION_VALID_SPAN(json_text, 0, false);
-
-  az_json_token_kind first_token_kind = AZ_JSON_TOKEN_NONE;
-  az_json_token_kind last_token_kind = AZ_JSON_TOKEN_NONE;
-
-  // This runtime validation is necessary since the input could be user defined and malformed.
-  // This cannot be caught at dev time by a precondition, especially since they can be turned off.
-  _az_RETURN_IF_FAILED(_az_validate_json(json_text, &first_token_kind, &last_token_kind));
-
-  // It is guaranteed that first_token_kind is NOT:
-  // AZ_JSON_TOKEN_NONE, AZ_JSON_TOKEN_END_ARRAY, AZ_JSON_TOKEN_END_OBJECT,
-  // AZ_JSON_TOKEN_PROPERTY_NAME
-  // And that last_token_kind is NOT:
+  // It is guaranteed that last_token_kind is NOT:
   // AZ_JSON_TOKEN_NONE, AZ_JSON_TOKEN_START_ARRAY, AZ_JSON_TOKEN_START_OBJECT,
   // AZ_JSON_TOKEN_PROPERTY_NAME
 
@@ -779,15 +1030,45 @@ az_json_writer_append_json_text(az_json_writer* ref_json_writer, az_span json_te
   if (!_az_is_appending_value_valid(ref_json_writer))
   {
     // All other tokens, including start array and object are validated here.
-    // Also first_token_kind cannot be AZ_JSON_TOKEN_NONE at this point.
     return AZ_ERROR_JSON_INVALID_STATE;
   }
 
-  az_span remaining_json = _get_remaining_span(ref_json_writer, _az_MINIMUM_STRING_CHUNK_SIZE);
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, _az_MINIMUM_STRING_CHUNK_SIZE);
+  int32_t required_size = az_span_size(json_text);
+  if (ref_json_writer->_internal.need_comma)
+  {
+    required_size++; // For the leading comma separator.
+  }
+
+  if (!ref_json_writer->_internal.is_measuring)
+  {
+    // A single buffer must fit the whole text, so that nothing is written when it does not.
+    // Chunked destinations provide at least a minimum chunk at a time.
+    bool const is_chunked = ref_json_writer->_internal.allocator_callback != NULL
+        || ref_json_writer->_internal.flush_callback != NULL;
+    int32_t const minimum_size = is_chunked && required_size > _az_MINIMUM_STRING_CHUNK_SIZE
+        ? _az_MINIMUM_STRING_CHUNK_SIZE
+        : required_size;
+
+    az_span remaining_json = _get_remaining_span(ref_json_writer, minimum_size);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, minimum_size);
+
+    if (ref_json_writer->_internal.need_comma)
+    {
+      remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
+      ref_json_writer->_internal.bytes_written++;
+    }
 
-  _az_RETURN_IF_FAILED(
-      az_json_writer_span_copy_chunked(ref_json_writer, &remaining_json, json_text));
+    if (is_chunked)
+    {
+      _az_RETURN_IF_FAILED(
+          az_json_writer_span_copy_chunked(ref_json_writer, &remaining_json, json_text));
+    }
+    else
+    {
+      remaining_json = _az_span_copy_unchecked(remaining_json, json_text);
+      ref_json_writer->_internal.bytes_written += az_span_size(json_text);
+    }
+  }
 
   // We only need to add a comma if the last token we append is a value or end of object/array.
   // If the last token is a property name or the start of an object/array, we don't need to add a
@@ -797,10 +1078,62 @@ az_json_writer_append_json_text(az_json_writer* ref_json_writer, az_span json_te
   // Therefore, need_comma must be true after appending the json_text.
 
   // We already tracked and updated bytes_written while writing, so no need to update it here.
-  _az_update_json_writer_state(ref_json_writer, 0, az_span_size(json_text), true, last_token_kind);
+  _az_update_json_writer_state(ref_json_writer, 0, required_size, true, last_token_kind);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_json_writer_append_json_text(az_json_writer* ref_json_writer, az_span json_text)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  // A null or empty span is not allowed since that is invalid JSON.
+  _az_PRECONDITION_VALID_SPAN(json_text, 0, false);
+
+  az_json_token_kind first_token_kind = AZ_JSON_TOKEN_NONE;
+  az_json_token_kind last_token_kind = AZ_JSON_TOKEN_NONE;
+
+  // This runtime validation is necessary since the input could be user defined and malformed.
+  // This cannot be caught at dev time by a precondition, especially since they can be turned off.
+  _az_RETURN_IF_FAILED(_az_validate_json(json_text, &first_token_kind, &last_token_kind));
+
+  return _az_json_writer_append_validated_json_text(ref_json_writer, json_text, last_token_kind);
+}
+
+AZ_NODISCARD az_result
+az_json_validated_text_init(az_json_validated_text* out_validated_text, az_span json_text)
+{
+  _az_PRECONDITION_NOT_NULL(out_validated_text);
+  // A null or empty span is not allowed since that is invalid JSON.
+  _az_PRECONDITION_VALID_SPAN(json_text, 0, false);
+
+  az_json_token_kind first_token_kind = AZ_JSON_TOKEN_NONE;
+  az_json_token_kind last_token_kind = AZ_JSON_TOKEN_NONE;
+  _az_RETURN_IF_FAILED(_az_validate_json(json_text, &first_token_kind, &last_token_kind));
+
+  *out_validated_text = (az_json_validated_text){
+    ._internal = {
+      .json_text = json_text,
+      .last_token_kind = last_token_kind,
+    },
+  };
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_json_writer_append_validated_json_text(
+    az_json_writer* ref_json_writer,
+    az_json_validated_text const* validated_text)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  _az_PRECONDITION_NOT_NULL(validated_text);
+  // A zero-initialized validated text was not set by az_json_validated_text_init().
+  _az_PRECONDITION(validated_text->_internal.last_token_kind != AZ_JSON_TOKEN_NONE);
+
+  return _az_json_writer_append_validated_json_text(
+      ref_json_writer,
+      validated_text->_internal.json_text,
+      validated_text->_internal.last_token_kind);
+}
+
 static AZ_NODISCARD az_result _az_json_writer_append_literal(
     az_json_writer* ref_json_writer,
     az_span literal,
@@ -821,15 +1154,18 @@ static AZ_NODISCARD az_result _az_json_writer_append_literal(
     required_size++; // For the leading comma separator.
   }
 
-  az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
-
-  if (ref_json_writer->_internal.need_comma)
+  if (!ref_json_writer->_internal.is_measuring)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
-  }
+    az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
 
-  remaining_json = az_span_copy(remaining_json, literal);
+    if (ref_json_writer->_internal.need_comma)
+    {
+      remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
+    }
+
+    remaining_json = _az_span_copy_unchecked(remaining_json, literal);
+  }
 
   _az_update_json_writer_state(ref_json_writer, required_size, required_size, true, literal_kind);
   return AZ_OK;
@@ -869,12 +1205,16 @@ AZ_NODISCARD az_result az_json_writer_append_int32(az_json_writer* ref_json_writ
     required_size++; // For the leading comma separator.
   }
 
-  az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
+  // A measuring writer formats the number on the stack, only to count its characters.
+  uint8_t scratch[_az_MAX_SIZE_FOR_INT32 + 1];
+  az_span remaining_json = ref_json_writer->_internal.is_measuring
+      ? AZ_SPAN_FROM_BUFFER(scratch)
+      : _get_remaining_span(ref_json_writer, required_size);
   _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
 
   if (ref_json_writer->_internal.need_comma)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
   }
 
   // Since we asked for the maximum needed space above, this is guaranteed not to fail due to
@@ -911,12 +1251,16 @@ AZ_NODISCARD az_result az_json_writer_append_double(
     required_size++; // For the leading comma separator.
   }
 
-  az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
+  // A measuring writer formats the number on the stack, only to count its characters.
+  uint8_t scratch[_az_MAX_SIZE_FOR_WRITING_DOUBLE + 1];
+  az_span remaining_json = ref_json_writer->_internal.is_measuring
+      ? AZ_SPAN_FROM_BUFFER(scratch)
+      : _get_remaining_span(ref_json_writer, required_size);
   _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
 
   if (ref_json_writer->_internal.need_comma)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
   }
 
   // Since we asked for the maximum needed space above, this is guaranteed not to fail due to
@@ -933,6 +1277,151 @@ AZ_NODISCARD az_result az_json_writer_append_double(
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result
+az_json_writer_append_double_shortest(az_json_writer* ref_json_writer, double value)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  _az_PRECONDITION(_az_is_appending_value_valid(ref_json_writer));
+  // Non-finite numbers are not supported because they lead to invalid JSON.
+  // Unquoted strings such as nan and -inf are invalid as JSON numbers.
+  _az_PRECONDITION(_az_isfinite(value));
+
+  // Need enough space to write any double number.
+  int32_t required_size = _az_MAX_SIZE_FOR_WRITING_SHORTEST_DOUBLE;
+
+  if (ref_json_writer->_internal.need_comma)
+  {
+    required_size++; // For the leading comma separator.
+  }
+
+  // A measuring writer formats the number on the stack, only to count its characters.
+  uint8_t scratch[_az_MAX_SIZE_FOR_WRITING_SHORTEST_DOUBLE + 1];
+  az_span remaining_json = ref_json_writer->_internal.is_measuring
+      ? AZ_SPAN_FROM_BUFFER(scratch)
+      : _get_remaining_span(ref_json_writer, required_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
+
+  if (ref_json_writer->_internal.need_comma)
+  {
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
+  }
+
+  // Since we asked for the maximum needed space above, this is guaranteed not to fail due to
+  // AZ_ERROR_NOT_ENOUGH_SPACE. Still checking the returned az_result, for other potential failure
+  // cases.
+  az_span leftover;
+  _az_RETURN_IF_FAILED(az_span_dtoa_shortest(remaining_json, value, &leftover));
+
+  // We already accounted for the maximum size needed in required_size, so subtract that to get the
+  // actual bytes written.
+  int32_t written = required_size + _az_span_diff(leftover, remaining_json)
+      - _az_MAX_SIZE_FOR_WRITING_SHORTEST_DOUBLE;
+  _az_update_json_writer_state(ref_json_writer, written, written, true, AZ_JSON_TOKEN_NUMBER);
+  return AZ_OK;
+}
+
+// Divides the value by 10 and returns the remainder as a digit, with a 32-bit division once the
+// value fits, which is much cheaper than a 64-bit one on a 32-bit core.
+AZ_INLINE uint8_t _az_json_writer_next_scaled_digit(uint64_t* ref_value)
+{
+  uint64_t const value = *ref_value;
+  if (value <= UINT32_MAX)
+  {
+    uint32_t const value32 = (uint32_t)value;
+    *ref_value = value32 / 10;
+    return (uint8_t)('0' + value32 % 10);
+  }
+
+  *ref_value = value / 10;
+  return (uint8_t)('0' + value % 10);
+}
+
+AZ_NODISCARD az_result az_json_writer_append_scaled_int64(
+    az_json_writer* ref_json_writer,
+    int64_t value,
+    int32_t decimal_places)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  _az_PRECONDITION(_az_is_appending_value_valid(ref_json_writer));
+  _az_PRECONDITION_RANGE(0, decimal_places, _az_MAX_SCALED_INT64_DECIMAL_PLACES);
+
+  // The number is formatted backward, from its last digit, with integer arithmetic only.
+  uint8_t number[_az_MAX_SIZE_FOR_WRITING_SCALED_INT64];
+  uint8_t* const number_end = number + sizeof(number);
+  uint8_t* cursor = number_end;
+
+  // Negating in unsigned arithmetic also works for INT64_MIN.
+  uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+  // Non-significant trailing zeros after the decimal point are not written, as with
+  // az_json_writer_append_double().
+  bool has_fractional_digits = false;
+  for (int32_t i = 0; i < decimal_places; i++)
+  {
+    uint8_t const digit = _az_json_writer_next_scaled_digit(&magnitude);
+    if (has_fractional_digits || digit != '0')
+    {
+      has_fractional_digits = true;
+      *--cursor = digit;
+    }
+  }
+
+  if (has_fractional_digits)
+  {
+    *--cursor = '.';
+  }
+
+  do
+  {
+    *--cursor = _az_json_writer_next_scaled_digit(&magnitude);
+  } while (magnitude > 0);
+
+  if (value < 0)
+  {
+    *--cursor = '-';
+  }
+
+  int32_t const number_size = (int32_t)(number_end - cursor);
+  int32_t required_size = number_size;
+
+  if (ref_json_writer->_internal.need_comma)
+  {
+    required_size++; // For the leading comma separator.
+  }
+
+  if (!ref_json_writer->_internal.is_measuring)
+  {
+    az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
+
+    if (ref_json_writer->_internal.need_comma)
+    {
+      remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
+    }
+
+    remaining_json = _az_span_copy_unchecked(remaining_json, az_span_create(cursor, number_size));
+  }
+
+  _az_update_json_writer_state(
+      ref_json_writer, required_size, required_size, true, AZ_JSON_TOKEN_NUMBER);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_writer_append_timestamp(
+    az_json_writer* ref_json_writer,
+    int64_t epoch_msec,
+    az_span_timestamp_cache* ref_cache)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+
+  // The timestamp is formatted on the stack, and then appended as any other string.
+  uint8_t timestamp[AZ_SPAN_ISO8601_TIMESTAMP_SIZE];
+  az_span remainder = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_span_timestamp_to_iso8601(
+      AZ_SPAN_FROM_BUFFER(timestamp), epoch_msec, ref_cache, &remainder));
+  return az_json_writer_append_string(ref_json_writer, AZ_SPAN_FROM_BUFFER(timestamp));
+}
+
 static AZ_NODISCARD az_result _az_json_writer_append_container_start(
     az_json_writer* ref_json_writer,
     uint8_t byte,
@@ -943,9 +1432,10 @@ static AZ_NODISCARD az_result _az_json_writer_append_container_start(
       container_kind == AZ_JSON_TOKEN_BEGIN_OBJECT || container_kind == AZ_JSON_TOKEN_BEGIN_ARRAY);
   _az_PRECONDITION(_az_is_appending_value_valid(ref_json_writer));
 
-  // The current depth is equal to or larger than the maximum allowed depth of 64. Cannot write the
-  // next JSON object or array.
-  if (ref_json_writer->_internal.bit_stack._internal.current_depth >= _az_MAX_JSON_STACK_SIZE)
+  // The current depth is equal to or larger than the maximum allowed depth. Cannot write the next
+  // JSON object or array.
+  if (ref_json_writer->_internal.bit_stack._internal.current_depth
+      >= _az_json_stack_max_depth(&ref_json_writer->_internal.bit_stack))
   {
     return AZ_ERROR_JSON_NESTING_OVERFLOW;
   }
@@ -957,15 +1447,18 @@ static AZ_NODISCARD az_result _az_json_writer_append_container_start(
     required_size++; // For the leading comma separator.
   }
 
-  az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
-
-  if (ref_json_writer->_internal.need_comma)
+  if (!ref_json_writer->_internal.is_measuring)
   {
-    remaining_json = az_span_copy_u8(remaining_json, ',');
-  }
+    az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
+
+    if (ref_json_writer->_internal.need_comma)
+    {
+      remaining_json = _az_span_copy_u8_unchecked(remaining_json, ',');
+    }
 
-  remaining_json = az_span_copy_u8(remaining_json, byte);
+    remaining_json = _az_span_copy_u8_unchecked(remaining_json, byte);
+  }
 
   _az_update_json_writer_state(
       ref_json_writer, required_size, required_size, false, container_kind);
@@ -1003,10 +1496,13 @@ static AZ_NODISCARD az_result az_json_writer_append_container_end(
 
   int32_t required_size = 1; // For the end object or array byte.
 
-  az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
+  if (!ref_json_writer->_internal.is_measuring)
+  {
+    az_span remaining_json = _get_remaining_span(ref_json_writer, required_size);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, required_size);
 
-  remaining_json = az_span_copy_u8(remaining_json, byte);
+    _az_span_copy_u8_unchecked(remaining_json, byte);
+  }
 
   _az_update_json_writer_state(ref_json_writer, required_size, required_size, true, container_kind);
   _az_json_stack_pop(&ref_json_writer->_internal.bit_stack);
@@ -1023,3 +1519,142 @@ AZ_NODISCARD az_result az_json_writer_append_end_array(az_json_writer* ref_json_
 {
   return az_json_writer_append_container_end(ref_json_writer, ']', AZ_JSON_TOKEN_END_ARRAY);
 }
+
+AZ_NODISCARD az_result az_ndjson_writer_end_record(az_json_writer* ref_json_writer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_json_writer);
+  _az_PRECONDITION(
+      ref_json_writer->_internal.bit_stack._internal.current_depth == 0
+      && ref_json_writer->_internal.token_kind != AZ_JSON_TOKEN_NONE);
+
+  if (!ref_json_writer->_internal.is_measuring)
+  {
+    az_span remaining_json = _get_remaining_span(ref_json_writer, 1);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remaining_json, 1);
+    az_span_ptr(remaining_json)[0] = '\n';
+  }
+
+  // The next value starts a new record, as the first one did.
+  _az_update_json_writer_state(ref_json_writer, 1, 1, false, AZ_JSON_TOKEN_NONE);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_template_compile(
+    az_json_template* out_template,
+    az_json_template_field fields[],
+    int32_t fields_count,
+    az_span fragment_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(out_template);
+  _az_PRECONDITION(fields_count >= 0);
+  _az_PRECONDITION(fields_count == 0 || fields != NULL);
+  _az_PRECONDITION_VALID_SPAN(fragment_buffer, 1, false);
+
+  az_span remainder = fragment_buffer;
+
+  for (int32_t i = 0; i < fields_count; i++)
+  {
+    _az_PRECONDITION_VALID_SPAN(fields[i].name, 0, true);
+    _az_PRECONDITION_RANGE(
+        AZ_JSON_TEMPLATE_FIELD_INT32, fields[i].kind, AZ_JSON_TEMPLATE_FIELD_BOOLEAN);
+
+    az_span const name = fields[i].name;
+    int32_t index_of_first_escaped_char = -1;
+    int32_t const escaped_size
+        = _az_json_writer_escaped_length(name, &index_of_first_escaped_char, false);
+
+    // For the leading brace or comma, the surrounding quotes and the key:value separator colon.
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, escaped_size + 4);
+
+    remainder = az_span_copy_u8(remainder, i == 0 ? '{' : ',');
+    remainder = az_span_copy_u8(remainder, '"');
+
+    if (index_of_first_escaped_char == -1)
+    {
+      remainder = az_span_copy(remainder, name);
+    }
+    else
+    {
+      remainder = az_span_copy(remainder, az_span_slice(name, 0, index_of_first_escaped_char));
+      remainder = _az_json_writer_escape_and_copy(
+          remainder, az_span_slice_to_end(name, index_of_first_escaped_char));
+    }
+
+    remainder = az_span_copy_u8(remainder, '"');
+    remainder = az_span_copy_u8(remainder, ':');
+
+    fields[i]._internal.fragment_end = az_span_size(fragment_buffer) - az_span_size(remainder);
+  }
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, fields_count == 0 ? 2 : 1);
+  if (fields_count == 0)
+  {
+    remainder = az_span_copy_u8(remainder, '{');
+  }
+  remainder = az_span_copy_u8(remainder, '}');
+
+  out_template->_internal.fragments
+      = az_span_slice(fragment_buffer, 0, az_span_size(fragment_buffer) - az_span_size(remainder));
+  out_template->_internal.fields = fields;
+  out_template->_internal.fields_count = fields_count;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_json_template_write(
+    az_json_template const* json_template,
+    az_json_template_value const values[],
+    az_span destination,
+    az_span* out_json)
+{
+  _az_PRECONDITION_NOT_NULL(json_template);
+  _az_PRECONDITION(json_template->_internal.fields_count == 0 || values != NULL);
+  _az_PRECONDITION_VALID_SPAN(destination, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_json);
+
+  az_span const fragments = json_template->_internal.fragments;
+  az_span remainder = destination;
+  int32_t fragment_start = 0;
+
+  for (int32_t i = 0; i < json_template->_internal.fields_count; i++)
+  {
+    az_json_template_field const* field = &json_template->_internal.fields[i];
+
+    az_span const fragment
+        = _az_span_slice_unchecked(fragments, fragment_start, field->_internal.fragment_end);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(fragment));
+    remainder = _az_span_copy_unchecked(remainder, fragment);
+    fragment_start = field->_internal.fragment_end;
+
+    switch (field->kind)
+    {
+      case AZ_JSON_TEMPLATE_FIELD_INT32:
+        _az_RETURN_IF_FAILED(az_span_i32toa(remainder, values[i].int32_value, &remainder));
+        break;
+      case AZ_JSON_TEMPLATE_FIELD_INT64:
+        _az_RETURN_IF_FAILED(az_span_i64toa(remainder, values[i].int64_value, &remainder));
+        break;
+      case AZ_JSON_TEMPLATE_FIELD_DOUBLE:
+        _az_RETURN_IF_FAILED(
+            az_span_dtoa_shortest(remainder, values[i].double_value, &remainder));
+        break;
+      case AZ_JSON_TEMPLATE_FIELD_BOOLEAN:
+      default:
+      {
+        az_span const literal
+            = values[i].boolean_value ? AZ_SPAN_FROM_STR("true") : AZ_SPAN_FROM_STR("false");
+        _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(literal));
+        remainder = _az_span_copy_unchecked(remainder, literal);
+        break;
+      }
+    }
+  }
+
+  az_span const tail = _az_span_slice_to_end_unchecked(fragments, fragment_start);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(tail));
+  remainder = _az_span_copy_unchecked(remainder, tail);
+
+  *out_json = _az_span_slice_unchecked(
+      destination, 0, az_span_size(destination) - az_span_size(remainder));
+  return AZ_OK;
+}
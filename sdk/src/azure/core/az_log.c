@@ -1,23 +1,90 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include "az_http_policy_logging_private.h"
 #include "az_span_private.h"
 #include <azure/core/az_config.h>
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_log.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_atomic_internal.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_log_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <azure/core/_az_cfg.h>
 
 #ifndef AZ_NO_LOGGING
 
-static az_log_classification const* volatile _az_log_classifications = NULL;
+// Every classification is enabled until the customer provides a list.
+#define _az_LOG_ALL_CLASSIFICATIONS UINT64_MAX
+
+// The bits of the classifications in the customer-provided list, see AZ_LOG_CLASSIFICATION_BIT().
+static uint64_t volatile _az_log_classification_mask = _az_LOG_ALL_CLASSIFICATIONS;
 static az_log_message_fn volatile _az_log_message_callback = NULL;
+static az_http_log_message_fn volatile _az_http_log_message_callback = NULL;
+static az_log_ring* volatile _az_log_ring = NULL;
+
+// Producers publish a record by setting its state last, and the consumer frees its room by
+// clearing it and then moving the tail forward, so these are the accesses which need to be ordered.
+#if defined(__GNUC__) || defined(__clang__)
+#define _az_LOG_RING_LOAD_ACQUIRE(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define _az_LOG_RING_STORE_RELEASE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#else
+// MSVC gives volatile accesses acquire and release semantics on x86 and x64.
+#define _az_LOG_RING_LOAD_ACQUIRE(ptr) (*(ptr))
+#define _az_LOG_RING_STORE_RELEASE(ptr, value) (*(ptr) = (value))
+#endif
+
+// The classifications which can have a limit at the same time, one for each of them today.
+#define _az_LOG_MAX_LIMITS 8
+
+// The window the rate cap of a limit counts messages over.
+#define _az_LOG_LIMIT_WINDOW_MSEC 1000
+
+typedef struct
+{
+  bool is_set;
+  az_log_classification classification;
+  int32_t sample_rate;
+  int32_t max_messages_per_second;
+
+  // The messages seen by sampling, of which every sample_rate-th one is logged.
+  uint32_t sample_count;
+
+  // The messages logged since the window started, and those suppressed since the last summary.
+  int64_t window_start_msec;
+  int32_t window_count;
+  uint32_t suppressed_count;
+} _az_log_limit;
+
+static _az_log_limit _az_log_limits[_az_LOG_MAX_LIMITS];
+
+// Taken while a message is counted, since the pipelines of several threads log at the same time.
+static uint64_t volatile _az_log_limits_lock = 0;
+
+// The bits of the classifications which have a limit, so that the others don't look it up.
+static uint64_t volatile _az_log_limited_mask = 0;
+
+enum
+{
+  // Each message starts with its classification, its size in 3 bytes and its state, and is padded
+  // to a multiple of 8 bytes.
+  _az_LOG_RING_HEADER_SIZE = 8,
+  _az_LOG_RING_STATE_OFFSET = 7,
+  _az_LOG_RING_MAX_MESSAGE_SIZE = 0xFFFFFF,
+
+  // The states of a header. The room which isn't reserved is all zeros, so it reads as pending.
+  _az_LOG_RING_PENDING = 0,
+  _az_LOG_RING_COMMITTED = 1,
+  _az_LOG_RING_WRAP = 2, // sends the consumer back to the start of the buffer
+};
 
 // Verifies that the classification that the user provided is one of the valid possibilties and
 // guards against looping past the end of the classification array.
@@ -50,10 +117,85 @@ AZ_INLINE bool _az_log_classifications_are_valid(az_log_classification const* cl
 }
 #endif // AZ_NO_PRECONDITION_CHECKING
 
+// Returns the bit of the classification, or 0 if the classification doesn't have one.
+static AZ_NODISCARD uint64_t _az_log_classification_bit(az_log_classification classification)
+{
+  uint32_t const facility = (uint32_t)classification >> 16;
+  uint32_t const code = (uint32_t)classification & 0xFFFFu;
+  return facility < 8 && code < 8 ? AZ_LOG_CLASSIFICATION_BIT(classification) : 0;
+}
+
 void az_log_set_classifications(az_log_classification const classifications[])
 {
   _az_PRECONDITION(_az_log_classifications_are_valid(classifications));
-  _az_log_classifications = classifications;
+
+  // The list is turned into a mask once, so that each log call only tests a bit.
+  uint64_t mask = _az_LOG_ALL_CLASSIFICATIONS;
+  if (classifications != NULL)
+  {
+    mask = 0;
+    for (az_log_classification const* cls = classifications; *cls != AZ_LOG_END_OF_LIST; ++cls)
+    {
+      mask |= _az_log_classification_bit(*cls);
+    }
+  }
+
+  _az_log_classification_mask = mask;
+}
+
+AZ_NODISCARD az_result
+az_log_set_limit(az_log_classification classification, az_log_limit_options const* options)
+{
+  uint64_t const bit = _az_log_classification_bit(classification);
+  _az_PRECONDITION(bit != 0);
+  _az_PRECONDITION(options == NULL || options->sample_rate >= 0);
+  _az_PRECONDITION(options == NULL || options->max_messages_per_second >= 0);
+
+  _az_log_limit* limit = NULL;
+  for (int32_t i = 0; i < _az_LOG_MAX_LIMITS; i++)
+  {
+    if (_az_log_limits[i].is_set && _az_log_limits[i].classification == classification)
+    {
+      limit = &_az_log_limits[i];
+      break;
+    }
+
+    if (limit == NULL && !_az_log_limits[i].is_set)
+    {
+      limit = &_az_log_limits[i];
+    }
+  }
+
+  // The limit is taken out of the mask while it changes, so that no message reads it half-written.
+  _az_log_limited_mask &= ~bit;
+
+  if (options == NULL)
+  {
+    if (limit != NULL)
+    {
+      limit->is_set = false;
+    }
+    return AZ_OK;
+  }
+
+  if (limit == NULL)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  *limit = (_az_log_limit){
+    .is_set = true,
+    .classification = classification,
+    .sample_rate = options->sample_rate,
+    .max_messages_per_second = options->max_messages_per_second,
+    .sample_count = 0,
+    .window_start_msec = 0,
+    .window_count = 0,
+    .suppressed_count = 0,
+  };
+
+  _az_log_limited_mask |= bit;
+  return AZ_OK;
 }
 
 void az_log_set_callback(az_log_message_fn az_log_message_callback)
@@ -61,6 +203,294 @@ void az_log_set_callback(az_log_message_fn az_log_message_callback)
   _az_log_message_callback = az_log_message_callback;
 }
 
+void az_http_log_set_message_callback(az_http_log_message_fn http_log_message_callback)
+{
+  _az_http_log_message_callback = http_log_message_callback;
+}
+
+// Returns whether the classification is in the customer-provided list.
+static bool _az_log_classification_is_enabled(az_log_classification classification)
+{
+  // Copy the volatile field to a local variable so that it doesn't change within this function
+  uint64_t const mask = _az_log_classification_mask;
+  uint64_t const bit = _az_log_classification_bit(classification);
+
+  if (bit == 0)
+  {
+    // A classification without a bit can't be in a list, but if the user hasn't registered any
+    // classifications, then we log everything.
+    return mask == _az_LOG_ALL_CLASSIFICATIONS && classification != AZ_LOG_END_OF_LIST;
+  }
+
+  return (mask & bit) != 0;
+}
+
+static void _az_log_ring_put_int32(uint8_t* destination, int32_t value)
+{
+  uint32_t const bits = (uint32_t)value;
+  destination[0] = (uint8_t)bits;
+  destination[1] = (uint8_t)(bits >> 8);
+  destination[2] = (uint8_t)(bits >> 16);
+  destination[3] = (uint8_t)(bits >> 24);
+}
+
+static AZ_NODISCARD int32_t _az_log_ring_get_int32(uint8_t const* source)
+{
+  return (int32_t)((uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16)
+                   | ((uint32_t)source[3] << 24));
+}
+
+static AZ_NODISCARD uint64_t _az_log_ring_record_size(int32_t message_size)
+{
+  return _az_LOG_RING_HEADER_SIZE + (((uint64_t)message_size + 7u) & ~(uint64_t)7u);
+}
+
+// Publishes the header at \p header, once everything else the record holds has been written.
+static void _az_log_ring_commit(uint8_t* header, uint8_t state)
+{
+  _az_LOG_RING_STORE_RELEASE((uint8_t volatile*)(header + _az_LOG_RING_STATE_OFFSET), state);
+}
+
+void az_log_ring_init(az_log_ring* out_ring, az_span buffer)
+{
+  _az_PRECONDITION_NOT_NULL(out_ring);
+  _az_PRECONDITION(az_span_size(buffer) >= 16);
+  _az_PRECONDITION((az_span_size(buffer) & (az_span_size(buffer) - 1)) == 0);
+
+  az_span_fill(buffer, _az_LOG_RING_PENDING);
+  out_ring->_internal.buffer = az_span_ptr(buffer);
+  out_ring->_internal.capacity = (uint32_t)az_span_size(buffer);
+  out_ring->_internal.head = 0;
+  out_ring->_internal.tail = 0;
+  out_ring->_internal.dropped_count = 0;
+}
+
+void az_log_set_ring(az_log_ring* ring) { _az_log_ring = ring; }
+
+// Runs on the threads which log; it copies the message and never waits for the consumer, nor for
+// the other threads. Each thread reserves the room of its record by moving the head forward with a
+// compare-and-swap, then fills it in and commits it, so records can be committed in any order.
+static void _az_log_ring_write(
+    az_log_ring* ref_ring,
+    az_log_classification classification,
+    az_span message)
+{
+  uint64_t const capacity = ref_ring->_internal.capacity;
+  int32_t const message_size = az_span_size(message);
+  uint64_t const record_size = _az_log_ring_record_size(message_size);
+
+  if (message_size > _az_LOG_RING_MAX_MESSAGE_SIZE || record_size > capacity)
+  {
+    (void)_az_atomic_add(&ref_ring->_internal.dropped_count, 1);
+    return;
+  }
+
+  uint64_t head = _az_atomic_load(&ref_ring->_internal.head);
+  uint64_t offset = 0;
+  uint64_t skip = 0;
+  do
+  {
+    uint64_t const tail = _az_atomic_load(&ref_ring->_internal.tail);
+
+    // A message which doesn't fit before the end of the buffer starts over at the beginning.
+    offset = head & (capacity - 1);
+    skip = capacity - offset < record_size ? capacity - offset : 0;
+
+    if ((head - tail) + skip + record_size > capacity)
+    {
+      (void)_az_atomic_add(&ref_ring->_internal.dropped_count, 1);
+      return;
+    }
+  } while (
+      !_az_atomic_compare_exchange(&ref_ring->_internal.head, &head, head + skip + record_size));
+
+  uint8_t* const buffer = ref_ring->_internal.buffer;
+  if (skip > 0)
+  {
+    // Offsets are multiples of 8, so there is always room for the marker.
+    _az_log_ring_commit(buffer + offset, _az_LOG_RING_WRAP);
+  }
+
+  uint8_t* const record = buffer + ((head + skip) & (capacity - 1));
+  _az_log_ring_put_int32(record, (int32_t)classification);
+  record[4] = (uint8_t)message_size;
+  record[5] = (uint8_t)(message_size >> 8);
+  record[6] = (uint8_t)(message_size >> 16);
+  az_span_copy(az_span_create(record + _az_LOG_RING_HEADER_SIZE, message_size), message);
+
+  _az_log_ring_commit(record, _az_LOG_RING_COMMITTED);
+}
+
+int32_t az_log_ring_drain(az_log_ring* ref_ring, int32_t max_messages)
+{
+  _az_PRECONDITION_NOT_NULL(ref_ring);
+  _az_PRECONDITION(max_messages >= 0);
+
+  // Copy the volatile field to a local variable so that it doesn't change within this function
+  az_log_message_fn const callback = _az_log_message_callback;
+
+  uint64_t const capacity = ref_ring->_internal.capacity;
+  uint8_t* const buffer = ref_ring->_internal.buffer;
+  uint64_t tail = ref_ring->_internal.tail;
+
+  int32_t count = 0;
+  while (count < max_messages)
+  {
+    uint64_t const offset = tail & (capacity - 1);
+    uint8_t* const header = buffer + offset;
+
+    // Stops at the first record which isn't committed yet, even when later ones are, so that
+    // messages are delivered in the order their room was reserved.
+    uint8_t const state
+        = _az_LOG_RING_LOAD_ACQUIRE((uint8_t volatile*)(header + _az_LOG_RING_STATE_OFFSET));
+    if (state == _az_LOG_RING_PENDING)
+    {
+      break;
+    }
+
+    if (state == _az_LOG_RING_WRAP)
+    {
+      // The room after the marker was never written, so only the marker needs to be cleared.
+      az_span_fill(az_span_create(header, _az_LOG_RING_HEADER_SIZE), _az_LOG_RING_PENDING);
+      tail += capacity - offset;
+      _az_atomic_store(&ref_ring->_internal.tail, tail);
+      continue;
+    }
+
+    int32_t const message_size
+        = (int32_t)((uint32_t)header[4] | ((uint32_t)header[5] << 8) | ((uint32_t)header[6] << 16));
+    if (callback != NULL)
+    {
+      callback(
+          (az_log_classification)_az_log_ring_get_int32(header),
+          az_span_create(header + _az_LOG_RING_HEADER_SIZE, message_size));
+    }
+
+    // The room is only given back to the producers once the callback is done with it, and is
+    // cleared first, so that the headers of the records reserved in it next read as pending.
+    uint64_t const record_size = _az_log_ring_record_size(message_size);
+    az_span_fill(az_span_create(header, (int32_t)record_size), _az_LOG_RING_PENDING);
+    tail += record_size;
+    _az_atomic_store(&ref_ring->_internal.tail, tail);
+    count++;
+  }
+
+  return count;
+}
+
+// Returns the limit of the classification, or NULL if it has none.
+static AZ_NODISCARD _az_log_limit* _az_log_get_limit(az_log_classification classification)
+{
+  if ((_az_log_limited_mask & _az_log_classification_bit(classification)) == 0)
+  {
+    return NULL;
+  }
+
+  for (int32_t i = 0; i < _az_LOG_MAX_LIMITS; i++)
+  {
+    if (_az_log_limits[i].is_set && _az_log_limits[i].classification == classification)
+    {
+      return &_az_log_limits[i];
+    }
+  }
+
+  return NULL;
+}
+
+// Returns whether the next message would be logged, without counting it.
+static AZ_NODISCARD bool _az_log_limit_peek(_az_log_limit const* limit, int64_t now)
+{
+  if (limit->sample_rate > 1 && limit->sample_count % (uint32_t)limit->sample_rate != 0)
+  {
+    return false;
+  }
+
+  return limit->max_messages_per_second == 0
+      || limit->window_count < limit->max_messages_per_second
+      || now - limit->window_start_msec >= _az_LOG_LIMIT_WINDOW_MSEC;
+}
+
+// Counts a message, and returns whether it is logged. When a new window starts, the messages the
+// previous ones suppressed are given back in out_suppressed_count, for their summary to be logged.
+static AZ_NODISCARD bool
+_az_log_limit_admit(_az_log_limit* ref_limit, int64_t now, uint32_t* out_suppressed_count)
+{
+  *out_suppressed_count = 0;
+
+  uint32_t const sample_index = ref_limit->sample_count++;
+  if (ref_limit->sample_rate > 1 && sample_index % (uint32_t)ref_limit->sample_rate != 0)
+  {
+    return false;
+  }
+
+  if (ref_limit->max_messages_per_second == 0)
+  {
+    return true;
+  }
+
+  if (now - ref_limit->window_start_msec >= _az_LOG_LIMIT_WINDOW_MSEC)
+  {
+    ref_limit->window_start_msec = now;
+    ref_limit->window_count = 0;
+    *out_suppressed_count = ref_limit->suppressed_count;
+    ref_limit->suppressed_count = 0;
+  }
+
+  if (ref_limit->window_count >= ref_limit->max_messages_per_second)
+  {
+    ref_limit->suppressed_count++;
+    return false;
+  }
+
+  ref_limit->window_count++;
+  return true;
+}
+
+// Counts a message which _az_log_limit_peek() rejected, either sampled out or over the rate cap.
+static void _az_log_limit_drop(_az_log_limit* ref_limit)
+{
+  uint32_t const sample_index = ref_limit->sample_count++;
+  if (ref_limit->sample_rate <= 1 || sample_index % (uint32_t)ref_limit->sample_rate == 0)
+  {
+    ref_limit->suppressed_count++;
+  }
+}
+
+static void _az_log_deliver(
+    az_log_message_fn callback,
+    az_log_classification classification,
+    az_span message)
+{
+  az_log_ring* const ring = _az_log_ring;
+  if (ring != NULL)
+  {
+    _az_log_ring_write(ring, classification, message);
+  }
+  else
+  {
+    callback(classification, message);
+  }
+}
+
+// Logs the number of messages a rate cap suppressed, before the next message it lets through.
+static void _az_log_deliver_summary(
+    az_log_message_fn callback,
+    az_log_classification classification,
+    uint32_t suppressed_count)
+{
+  uint8_t summary_buffer[48];
+  az_span const summary = AZ_SPAN_FROM_BUFFER(summary_buffer);
+  az_span remainder = AZ_SPAN_EMPTY;
+  if (az_result_succeeded(az_span_u64toa(summary, suppressed_count, &remainder)))
+  {
+    remainder = az_span_copy(remainder, AZ_SPAN_FROM_STR(" log messages suppressed."));
+    _az_log_deliver(
+        callback,
+        classification,
+        az_span_slice(summary, 0, az_span_size(summary) - az_span_size(remainder)));
+  }
+}
+
 // _az_LOG_WRITE_engine is a function private to this .c file; it contains the code to handle
 // _az_LOG_SHOULD_WRITE & _az_LOG_WRITE.
 //
@@ -71,9 +501,8 @@ void az_log_set_callback(az_log_message_fn az_log_message_callback)
 // false indicating whether it was logged.
 static bool _az_log_write_engine(bool log_it, az_log_classification classification, az_span message)
 {
-  // Copy the volatile fields to local variables so that they don't change within this function
+  // Copy the volatile field to a local variable so that it doesn't change within this function
   az_log_message_fn const callback = _az_log_message_callback;
-  az_log_classification const* classifications = _az_log_classifications;
 
   if (callback == NULL)
   {
@@ -81,30 +510,54 @@ static bool _az_log_write_engine(bool log_it, az_log_classification classificati
     return false;
   }
 
-  if (classifications == NULL)
+  // If this message's classification is not in the customer-provided list, we should not log it.
+  if (!_az_log_classification_is_enabled(classification))
   {
-    // If the user hasn't registered any classifications, then we log everything.
-    classifications
-        = &classification; // We don't need AZ_LOG_END_OF_LIST to be there, as very first comparison
-                           // is going to succeed and return from the function.
+    return false;
   }
 
-  for (az_log_classification const* cls = classifications; *cls != AZ_LOG_END_OF_LIST; ++cls)
+  // The limit is checked before the caller formats the message: a message it drops is counted
+  // then, while one it lets through is counted once it is written.
+  _az_log_limit* const limit = _az_log_get_limit(classification);
+  int64_t const now
+      = limit != NULL && limit->max_messages_per_second > 0 ? az_platform_clock_msec() : 0;
+  if (!log_it)
   {
-    // If this message's classification is in the customer-provided list, we should log it.
-    if (*cls == classification)
+    if (limit == NULL)
     {
-      if (log_it)
-      {
-        callback(classification, message);
-      }
-
       return true;
     }
+
+    _az_atomic_spin_lock(&_az_log_limits_lock);
+    bool const is_dropped = !_az_log_limit_peek(limit, now);
+    if (is_dropped)
+    {
+      _az_log_limit_drop(limit);
+    }
+    _az_atomic_spin_unlock(&_az_log_limits_lock);
+
+    return !is_dropped;
   }
 
-  // This message's classification is not in the customer-provided list; we should not log it.
-  return false;
+  if (limit != NULL)
+  {
+    uint32_t suppressed_count = 0;
+    _az_atomic_spin_lock(&_az_log_limits_lock);
+    bool const is_admitted = _az_log_limit_admit(limit, now, &suppressed_count);
+    _az_atomic_spin_unlock(&_az_log_limits_lock);
+    if (suppressed_count > 0)
+    {
+      _az_log_deliver_summary(callback, classification, suppressed_count);
+    }
+
+    if (!is_admitted)
+    {
+      return false;
+    }
+  }
+
+  _az_log_deliver(callback, classification, message);
+  return true;
 }
 
 // This function returns whether or not the passed-in message should be logged.
@@ -119,4 +572,10 @@ void _az_log_write(az_log_classification classification, az_span message)
   (void)_az_log_write_engine(true, classification, message);
 }
 
+az_http_log_message_fn _az_http_log_get_message_callback(az_log_classification classification)
+{
+  az_http_log_message_fn const callback = _az_http_log_message_callback;
+  return callback != NULL && _az_log_classification_is_enabled(classification) ? callback : NULL;
+}
+
 #endif // AZ_NO_LOGGING
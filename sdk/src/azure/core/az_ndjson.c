@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_simd_private.h"
+#include <azure/core/az_json.h>
+#include <azure/core/az_ndjson.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_atomic_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+// The records a thread takes at a time, so that the threads don't contend for each of them.
+#define _az_NDJSON_RECORDS_PER_TAKE 8
+
+// Adds the line from start to end, unless it is empty once its carriage return is removed.
+static void _az_ndjson_add_record(
+    az_span source,
+    int32_t start,
+    int32_t end,
+    az_span out_records[],
+    int32_t* ref_record_count)
+{
+  if (end > start && az_span_ptr(source)[end - 1] == '\r')
+  {
+    end--;
+  }
+
+  if (end > start)
+  {
+    out_records[*ref_record_count] = az_span_slice(source, start, end);
+    (*ref_record_count)++;
+  }
+}
+
+#ifdef _az_SIMD
+
+#if defined(_az_SIMD_AVX2)
+#define _az_NDJSON_BLOCK_SIZE 32
+#define _az_NDJSON_MASK_BITS_PER_POSITION 1
+#elif defined(_az_SIMD_SSE2)
+#define _az_NDJSON_BLOCK_SIZE 16
+#define _az_NDJSON_MASK_BITS_PER_POSITION 1
+#else // _az_SIMD_NEON
+#define _az_NDJSON_BLOCK_SIZE 16
+#define _az_NDJSON_MASK_BITS_PER_POSITION 4
+#endif
+
+// Returns a mask with _az_NDJSON_MASK_BITS_PER_POSITION bits set for each newline of the block.
+static AZ_NODISCARD uint64_t _az_ndjson_newline_mask(uint8_t const* block)
+{
+#if defined(_az_SIMD_AVX2)
+  return (uint32_t)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)block), _mm256_set1_epi8('\n')));
+#elif defined(_az_SIMD_SSE2)
+  return (uint32_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)block), _mm_set1_epi8('\n')));
+#else
+  // NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves one nibble per position.
+  uint8x16_t const newlines = vceqq_u8(vld1q_u8(block), vdupq_n_u8('\n'));
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(newlines), 4)), 0);
+#endif
+}
+
+#endif // _az_SIMD
+
+AZ_NODISCARD az_result az_ndjson_split(
+    az_span source,
+    az_span out_records[],
+    int32_t max_records,
+    int32_t* out_record_count,
+    az_span* out_remaining)
+{
+  _az_PRECONDITION_NOT_NULL(out_records);
+  _az_PRECONDITION(max_records > 0);
+  _az_PRECONDITION_NOT_NULL(out_record_count);
+  _az_PRECONDITION_NOT_NULL(out_remaining);
+
+  uint8_t const* const ptr = az_span_ptr(source);
+  int32_t const size = az_span_size(source);
+  int32_t record_count = 0;
+  int32_t start = 0;
+  int32_t i = 0;
+
+#ifdef _az_SIMD
+  uint64_t const position_bits = ((uint64_t)1 << _az_NDJSON_MASK_BITS_PER_POSITION) - 1;
+  for (; record_count < max_records && i + _az_NDJSON_BLOCK_SIZE <= size;
+       i += _az_NDJSON_BLOCK_SIZE)
+  {
+    uint64_t mask = _az_ndjson_newline_mask(ptr + i);
+    while (mask != 0 && record_count < max_records)
+    {
+      int32_t const bit = _az_simd_lowest_bit_index(mask);
+      int32_t const end = i + (bit / _az_NDJSON_MASK_BITS_PER_POSITION);
+      _az_ndjson_add_record(source, start, end, out_records, &record_count);
+      start = end + 1;
+      mask &= ~(position_bits << bit);
+    }
+  }
+#endif // _az_SIMD
+
+  for (; record_count < max_records && i < size; i++)
+  {
+    if (ptr[i] == '\n')
+    {
+      _az_ndjson_add_record(source, start, i, out_records, &record_count);
+      start = i + 1;
+    }
+  }
+
+  if (record_count < max_records && start < size)
+  {
+    _az_ndjson_add_record(source, start, size, out_records, &record_count);
+    start = size;
+  }
+
+  *out_record_count = record_count;
+  *out_remaining = az_span_slice_to_end(source, start);
+  return AZ_OK;
+}
+
+typedef struct
+{
+  az_span const* records;
+  int32_t record_count;
+  az_ndjson_record_fn record_fn;
+  void* user_context;
+  az_json_reader_options const* options;
+  az_result* results;
+  uint64_t volatile next_index;
+} _az_ndjson_batch;
+
+// Runs on each thread, until every record of the batch was taken.
+static void _az_ndjson_parse(void* user_context)
+{
+  _az_ndjson_batch* const batch = (_az_ndjson_batch*)user_context;
+  uint64_t const record_count = (uint64_t)batch->record_count;
+
+  uint64_t first = _az_atomic_load(&batch->next_index);
+  while (first < record_count)
+  {
+    if (!_az_atomic_compare_exchange(
+            &batch->next_index, &first, first + _az_NDJSON_RECORDS_PER_TAKE))
+    {
+      // Another thread took these records, retry with the next ones.
+      continue;
+    }
+
+    uint64_t const end = first + _az_NDJSON_RECORDS_PER_TAKE < record_count
+        ? first + _az_NDJSON_RECORDS_PER_TAKE
+        : record_count;
+    for (uint64_t i = first; i < end; i++)
+    {
+      az_json_reader reader = { 0 };
+      az_result result = az_json_reader_init(&reader, batch->records[i], batch->options);
+      if (az_result_succeeded(result))
+      {
+        result = batch->record_fn(&reader, (int32_t)i, batch->user_context);
+      }
+      batch->results[i] = result;
+    }
+
+    first = _az_atomic_load(&batch->next_index);
+  }
+}
+
+AZ_NODISCARD az_result az_ndjson_parse_records(
+    az_span const records[],
+    int32_t record_count,
+    az_ndjson_record_fn record_fn,
+    void* user_context,
+    az_json_reader_options const* options,
+    az_ndjson_worker workers[],
+    int32_t worker_count,
+    az_result out_results[])
+{
+  _az_PRECONDITION(record_count >= 0);
+  _az_PRECONDITION(records != NULL || record_count == 0);
+  _az_PRECONDITION_NOT_NULL(record_fn);
+  _az_PRECONDITION(worker_count >= 0);
+  _az_PRECONDITION(workers != NULL || worker_count == 0);
+  _az_PRECONDITION(out_results != NULL || record_count == 0);
+
+  _az_ndjson_batch batch = {
+    .records = records,
+    .record_count = record_count,
+    .record_fn = record_fn,
+    .user_context = user_context,
+    .options = options,
+    .results = out_results,
+    .next_index = 0,
+  };
+
+  // The calling thread parses records too, so a thread is only submitted for each take of records
+  // after the first.
+  int32_t const take_count
+      = (record_count + _az_NDJSON_RECORDS_PER_TAKE - 1) / _az_NDJSON_RECORDS_PER_TAKE;
+  int32_t submitted_count = 0;
+  while (submitted_count < worker_count && submitted_count < take_count - 1)
+  {
+    az_platform_work* const work = &workers[submitted_count]._internal.work;
+    az_platform_work_init(work, _az_ndjson_parse, &batch);
+    if (az_result_failed(az_platform_executor_submit(work)))
+    {
+      // The records are parsed by the threads which are running.
+      break;
+    }
+    submitted_count++;
+  }
+
+  _az_ndjson_parse(&batch);
+  for (int32_t i = 0; i < submitted_count; i++)
+  {
+    az_platform_executor_wait(&workers[i]._internal.work);
+  }
+
+  for (int32_t i = 0; i < record_count; i++)
+  {
+    _az_RETURN_IF_FAILED(out_results[i]);
+  }
+
+  return AZ_OK;
+}
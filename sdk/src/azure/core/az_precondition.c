@@ -25,3 +25,11 @@ az_precondition_failed_fn az_precondition_failed_get_callback()
 {
   return _az_precondition_failed_callback;
 }
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((cold, noinline))
+#endif
+void _az_precondition_failed(void)
+{
+  _az_precondition_failed_callback();
+}
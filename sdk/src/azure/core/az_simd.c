@@ -0,0 +1,284 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_simd_private.h"
+#include <azure/core/internal/az_atomic_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(_az_SIMD_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#endif
+
+#if defined(_az_SIMD_DISPATCH_ARMV8)
+#include <sys/auxv.h>
+#endif
+
+#include <azure/core/_az_cfg.h>
+
+// Set in the cached values once they are computed, so that a host without any feature is cached.
+#define _az_SIMD_STATE_READY ((uint64_t)1 << 32)
+
+// The features the compiler targets, which every host the build runs on has.
+static AZ_NODISCARD uint32_t _az_simd_get_compile_time_features(void)
+{
+  uint32_t features = 0;
+#if defined(_az_SIMD_AVX2)
+  features |= _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_AVX2;
+#if defined(__AVX512BW__)
+  features |= _az_SIMD_FEATURE_AVX512BW;
+#endif
+#elif defined(_az_SIMD_SSE2)
+  features |= _az_SIMD_FEATURE_SSE2;
+#elif defined(_az_SIMD_NEON)
+  features |= _az_SIMD_FEATURE_NEON;
+#endif
+
+#if defined(_az_SIMD_SHA_X86)
+  features |= _az_SIMD_FEATURE_SHA_X86;
+#elif defined(_az_SIMD_SHA_ARMV8)
+  features |= _az_SIMD_FEATURE_SHA_ARMV8;
+#endif
+
+#if defined(_az_SIMD_CLMUL_X86)
+  features |= _az_SIMD_FEATURE_CLMUL_X86;
+#elif defined(_az_SIMD_CLMUL_ARMV8)
+  features |= _az_SIMD_FEATURE_CLMUL_ARMV8;
+#endif
+
+  return features;
+}
+
+#if defined(_az_SIMD_DISPATCH)
+
+static void _az_simd_cpuid(uint32_t leaf, uint32_t out_registers[4])
+{
+#if defined(__GNUC__) || defined(__clang__)
+  if (__get_cpuid_max(0, NULL) < leaf)
+  {
+    out_registers[0] = out_registers[1] = out_registers[2] = out_registers[3] = 0;
+    return;
+  }
+
+  __cpuid_count(leaf, 0, out_registers[0], out_registers[1], out_registers[2], out_registers[3]);
+#else
+  int registers[4] = { 0 };
+  __cpuid(registers, 0);
+  if ((uint32_t)registers[0] < leaf)
+  {
+    out_registers[0] = out_registers[1] = out_registers[2] = out_registers[3] = 0;
+    return;
+  }
+
+  __cpuidex(registers, (int)leaf, 0);
+  for (int32_t i = 0; i < 4; i++)
+  {
+    out_registers[i] = (uint32_t)registers[i];
+  }
+#endif
+}
+
+// The register state the operating system saves on context switches, from XCR0.
+static AZ_NODISCARD uint64_t _az_simd_get_saved_state(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#else
+  return _xgetbv(0);
+#endif
+}
+
+// The vector registers are only usable when the operating system saves them, which XCR0 tells.
+static AZ_NODISCARD uint32_t _az_simd_probe_features(void)
+{
+  // EAX, EBX, ECX and EDX.
+  uint32_t leaf1[4] = { 0 };
+  uint32_t leaf7[4] = { 0 };
+  _az_simd_cpuid(1, leaf1);
+  _az_simd_cpuid(7, leaf7);
+
+  uint32_t features = 0;
+  if ((leaf1[3] & (1U << 26)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_SSE2;
+  }
+
+  bool const has_sse41 = (leaf1[2] & (1U << 19)) != 0;
+  if (has_sse41 && (leaf1[2] & (1U << 1)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_CLMUL_X86;
+  }
+
+  if (has_sse41 && (leaf7[1] & (1U << 29)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_SHA_X86;
+  }
+
+  // OSXSAVE, which makes XCR0 readable.
+  if ((leaf1[2] & (1U << 27)) == 0)
+  {
+    return features;
+  }
+
+  uint64_t const saved_state = _az_simd_get_saved_state();
+
+  // The XMM and YMM registers.
+  if ((saved_state & 0x6) == 0x6 && (leaf7[1] & (1U << 5)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_AVX2;
+
+    // The opmask registers and the upper halves of the ZMM registers, then AVX512F and AVX512BW.
+    if ((saved_state & 0xE0) == 0xE0 && (leaf7[1] & (1U << 16)) != 0
+        && (leaf7[1] & (1U << 30)) != 0)
+    {
+      features |= _az_SIMD_FEATURE_AVX512BW;
+    }
+  }
+
+  return features;
+}
+
+#elif defined(_az_SIMD_DISPATCH_ARMV8)
+
+static AZ_NODISCARD uint32_t _az_simd_probe_features(void)
+{
+  // The HWCAP_ASIMD, HWCAP_PMULL and HWCAP_SHA2 bits of AArch64 Linux.
+  unsigned long const hwcap = getauxval(AT_HWCAP);
+
+  uint32_t features = 0;
+  if ((hwcap & (1UL << 1)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_NEON;
+  }
+
+  if ((hwcap & (1UL << 4)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_CLMUL_ARMV8;
+  }
+
+  if ((hwcap & (1UL << 6)) != 0)
+  {
+    features |= _az_SIMD_FEATURE_SHA_ARMV8;
+  }
+
+  return features;
+}
+
+#else
+
+static AZ_NODISCARD uint32_t _az_simd_probe_features(void) { return 0; }
+
+#endif // _az_SIMD_DISPATCH
+
+// Threads which race to compute either value compute the same one, so whichever is stored last
+// doesn't matter.
+static uint64_t volatile _az_simd_features;
+
+AZ_NODISCARD uint32_t _az_simd_get_features(void)
+{
+  uint64_t state = _az_atomic_load(&_az_simd_features);
+  if ((state & _az_SIMD_STATE_READY) == 0)
+  {
+    state = _az_SIMD_STATE_READY | _az_simd_probe_features()
+        | _az_simd_get_compile_time_features();
+    _az_atomic_store(&_az_simd_features, state);
+  }
+
+  return (uint32_t)state;
+}
+
+#ifdef _az_SIMD
+
+static uint64_t volatile _az_simd_kernels_features;
+static _az_simd_kernel_table _az_simd_kernels;
+
+void _az_simd_select_kernels(uint32_t features)
+{
+  features |= _az_simd_get_compile_time_features();
+
+  _az_simd_kernel_table kernels = { 0 };
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+  kernels.span_find = _az_span_find_sse2;
+  kernels.span_url_unreserved_prefix = _az_span_url_unreserved_prefix_sse2;
+  kernels.json_writer_unescaped_prefix = _az_json_writer_unescaped_prefix_sse2;
+  kernels.json_token_unescaped_prefix = _az_json_token_unescaped_prefix_sse2;
+  kernels.json_index_classify_block = _az_json_index_classify_block_sse2;
+#elif defined(_az_SIMD_NEON)
+  kernels.span_find = _az_span_find_neon;
+  kernels.span_url_unreserved_prefix = _az_span_url_unreserved_prefix_neon;
+  kernels.json_writer_unescaped_prefix = _az_json_writer_unescaped_prefix_neon;
+  kernels.json_token_unescaped_prefix = _az_json_token_unescaped_prefix_neon;
+  kernels.json_index_classify_block = _az_json_index_classify_block_neon;
+#if defined(__aarch64__) || defined(_M_ARM64)
+  kernels.base64_encode = _az_base64_encode_neon;
+  kernels.base64_decode = _az_base64_decode_neon;
+#endif
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX2
+  if ((features & _az_SIMD_FEATURE_AVX2) != 0)
+  {
+    kernels.span_find = _az_span_find_avx2;
+    kernels.span_url_unreserved_prefix = _az_span_url_unreserved_prefix_avx2;
+    kernels.json_writer_unescaped_prefix = _az_json_writer_unescaped_prefix_avx2;
+    kernels.json_token_unescaped_prefix = _az_json_token_unescaped_prefix_avx2;
+    kernels.json_index_classify_block = _az_json_index_classify_block_avx2;
+    kernels.base64_encode = _az_base64_encode_avx2;
+    kernels.base64_decode = _az_base64_decode_avx2;
+  }
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX512BW
+  if ((features & _az_SIMD_FEATURE_AVX512BW) != 0)
+  {
+    kernels.span_find = _az_span_find_avx512bw;
+  }
+#endif
+
+#ifdef _az_SIMD_KERNEL_CLMUL_X86
+  if ((features & _az_SIMD_FEATURE_CLMUL_X86) != 0)
+  {
+    kernels.crc64_update = _az_crc64_update_clmul_x86;
+  }
+#endif
+
+#ifdef _az_SIMD_KERNEL_CLMUL_ARMV8
+  if ((features & _az_SIMD_FEATURE_CLMUL_ARMV8) != 0)
+  {
+    kernels.crc64_update = _az_crc64_update_clmul_armv8;
+  }
+#endif
+
+#ifdef _az_SIMD_KERNEL_SHA_X86
+  if ((features & _az_SIMD_FEATURE_SHA_X86) != 0)
+  {
+    kernels.sha256_compress = _az_sha256_compress_sha_x86;
+  }
+#endif
+
+#ifdef _az_SIMD_KERNEL_SHA_ARMV8
+  if ((features & _az_SIMD_FEATURE_SHA_ARMV8) != 0)
+  {
+    kernels.sha256_compress = _az_sha256_compress_sha_armv8;
+  }
+#endif
+
+  _az_simd_kernels = kernels;
+  _az_atomic_store(&_az_simd_kernels_features, _az_SIMD_STATE_READY | features);
+}
+
+AZ_NODISCARD _az_simd_kernel_table const* _az_simd_get_kernels(void)
+{
+  if ((_az_atomic_load(&_az_simd_kernels_features) & _az_SIMD_STATE_READY) == 0)
+  {
+    _az_simd_select_kernels(_az_simd_get_features());
+  }
+
+  return &_az_simd_kernels;
+}
+
+#endif // _az_SIMD
@@ -0,0 +1,422 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief Compile-time selection of the vector instruction set used by the SIMD accelerated span,
+ * JSON and crypto routines.
+ *
+ * @details Exactly one of `_az_SIMD_AVX2`, `_az_SIMD_SSE2` or `_az_SIMD_NEON` is defined when the
+ * compiler targets an architecture which provides it, unless `AZ_NO_SIMD` is defined. Otherwise,
+ * callers use their scalar implementation. Likewise, `_az_SIMD_SHA_X86` or `_az_SIMD_SHA_ARMV8`
+ * is defined when the SHA-256 instructions are available, and `_az_SIMD_CLMUL_X86` or
+ * `_az_SIMD_CLMUL_ARMV8` when the carry-less multiplication instructions are.
+ *
+ * The routines with a kernel in the #_az_simd_kernel_table are also built for the instruction sets
+ * the compiler doesn't target, and the best one the host supports is picked once at runtime, so a
+ * single binary uses the widest vectors and the cryptography extensions of each host. On x86, those
+ * are AVX2, AVX-512BW, the SHA extensions and PCLMULQDQ, over an SSE2 baseline. On AArch64 Linux,
+ * they are the SHA2 and PMULL extensions, over a NEON baseline. `AZ_NO_SIMD_DISPATCH` turns this
+ * off, for builds which know their target, such as microcontrollers, and only keeps the kernels of
+ * the instruction sets selected at compile time.
+ */
+
+#ifndef _az_SIMD_PRIVATE_H
+#define _az_SIMD_PRIVATE_H
+
+#include <stdint.h>
+
+#ifndef AZ_NO_SIMD
+#if defined(__AVX2__)
+#define _az_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _az_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define _az_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif // AZ_NO_SIMD
+
+#if defined(_az_SIMD_AVX2) || defined(_az_SIMD_SSE2) || defined(_az_SIMD_NEON)
+#define _az_SIMD
+#endif
+
+// On x86, SSE2 is the baseline of the kernels, and the wider ones are compiled for their
+// instruction set with a target attribute, which MSVC doesn't need, when they are dispatched.
+#if (defined(_az_SIMD_AVX2) || defined(_az_SIMD_SSE2)) && !defined(AZ_NO_SIMD_DISPATCH) \
+    && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define _az_SIMD_DISPATCH
+#if defined(__GNUC__) || defined(__clang__)
+#define _az_SIMD_TARGET(instruction_set) __attribute__((target(instruction_set)))
+#else
+#define _az_SIMD_TARGET(instruction_set)
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined(_az_SIMD_AVX2) || defined(_az_SIMD_DISPATCH)
+#define _az_SIMD_KERNEL_AVX2
+#endif
+
+#if (defined(_az_SIMD_AVX2) && defined(__AVX512BW__)) || defined(_az_SIMD_DISPATCH)
+#define _az_SIMD_KERNEL_AVX512BW
+#endif
+
+#ifndef _az_SIMD_TARGET
+#define _az_SIMD_TARGET(instruction_set)
+#endif
+
+// On AArch64, NEON is the baseline, and the cryptography extensions are dispatched on Linux, which
+// tells whether the host has them. Each compiler spells their target attributes differently, and
+// only declares their intrinsics without the extensions enabled from GCC 10 and Clang 16.
+#if defined(_az_SIMD_NEON) && !defined(AZ_NO_SIMD_DISPATCH) && defined(__aarch64__) \
+    && defined(__linux__) \
+    && ((defined(__clang__) && __clang_major__ >= 16) \
+        || (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 10))
+#define _az_SIMD_DISPATCH_ARMV8
+#if defined(__clang__)
+#define _az_SIMD_TARGET_ARMV8(extension) __attribute__((target(extension)))
+#else
+#define _az_SIMD_TARGET_ARMV8(extension) __attribute__((target("+" extension)))
+#endif
+#else
+#define _az_SIMD_TARGET_ARMV8(extension)
+#endif
+
+// The SHA-256 instructions are a separate extension on both architectures, so they are selected
+// independently of the vector instruction set above.
+#ifndef AZ_NO_SIMD
+#if defined(__SHA__) && defined(__SSE4_1__)
+#define _az_SIMD_SHA_X86
+#include <immintrin.h>
+#elif defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+#define _az_SIMD_SHA_ARMV8
+#include <arm_neon.h>
+#endif
+#endif // AZ_NO_SIMD
+
+// The 64-bit carry-less multiplication, used to fold CRCs, is also a separate extension: PCLMULQDQ
+// on x86, and PMULL, which comes with the AES instructions, on ARMv8.
+#ifndef AZ_NO_SIMD
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+#define _az_SIMD_CLMUL_X86
+#include <immintrin.h>
+#elif defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO)
+#define _az_SIMD_CLMUL_ARMV8
+#include <arm_neon.h>
+#endif
+#endif // AZ_NO_SIMD
+
+#if defined(_az_SIMD_SHA_X86) || defined(_az_SIMD_DISPATCH)
+#define _az_SIMD_KERNEL_SHA_X86
+#endif
+
+#if defined(_az_SIMD_SHA_ARMV8) || defined(_az_SIMD_DISPATCH_ARMV8)
+#define _az_SIMD_KERNEL_SHA_ARMV8
+#endif
+
+#if defined(_az_SIMD_CLMUL_X86) || defined(_az_SIMD_DISPATCH)
+#define _az_SIMD_KERNEL_CLMUL_X86
+#endif
+
+#if defined(_az_SIMD_CLMUL_ARMV8) || defined(_az_SIMD_DISPATCH_ARMV8)
+#define _az_SIMD_KERNEL_CLMUL_ARMV8
+#endif
+
+#if defined(_az_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief The instruction sets a host supports, as bits of the value returned by
+ * #_az_simd_get_features().
+ */
+enum
+{
+  _az_SIMD_FEATURE_SSE2 = 1 << 0,
+  _az_SIMD_FEATURE_AVX2 = 1 << 1,
+  _az_SIMD_FEATURE_AVX512BW = 1 << 2,
+  _az_SIMD_FEATURE_NEON = 1 << 3,
+  _az_SIMD_FEATURE_SHA_X86 = 1 << 4,
+  _az_SIMD_FEATURE_CLMUL_X86 = 1 << 5,
+  _az_SIMD_FEATURE_SHA_ARMV8 = 1 << 6,
+  _az_SIMD_FEATURE_CLMUL_ARMV8 = 1 << 7,
+};
+
+/**
+ * @brief Gets the instruction sets of the host, which are probed on the first call: with `cpuid`
+ * on x86, and with `getauxval()` on Linux for ARMv8. Those the compiler targets are always
+ * included, and they are the only ones when the host isn't probed.
+ */
+AZ_NODISCARD uint32_t _az_simd_get_features(void);
+
+/**
+ * @brief The bits of the bytes of a 64-byte block of JSON which the structural index looks for, one
+ * bit per byte in each mask.
+ */
+typedef struct
+{
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t operator_char;
+  uint64_t whitespace;
+  uint64_t control;
+  uint64_t non_ascii;
+} _az_json_index_block_masks;
+
+#ifdef _az_SIMD
+
+/**
+ * @brief Returns the index of the lowest set bit of \p mask, which must not be zero.
+ */
+AZ_NODISCARD AZ_INLINE int32_t _az_simd_lowest_bit_index(uint64_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+  (void)_BitScanForward64(&index, mask);
+#else
+  if (!_BitScanForward(&index, (unsigned long)mask))
+  {
+    (void)_BitScanForward(&index, (unsigned long)(mask >> 32));
+    index += 32;
+  }
+#endif
+  return (int32_t)index;
+#else
+  return (int32_t)__builtin_ctzll(mask);
+#endif
+}
+
+/**
+ * @brief Searches \p source_ptr for \p target_ptr, a block of candidate positions at a time.
+ * Returns the index of the target or -1, in which case \p out_position is set to the first position
+ * which was not checked because it doesn't start a complete block.
+ */
+typedef AZ_NODISCARD int32_t (*_az_simd_span_find_fn)(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position);
+
+// The kernels of az_span_find(), in az_span.c.
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+AZ_NODISCARD int32_t _az_span_find_sse2(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position);
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX2
+AZ_NODISCARD int32_t _az_span_find_avx2(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position);
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX512BW
+AZ_NODISCARD int32_t _az_span_find_avx512bw(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position);
+#endif
+
+#ifdef _az_SIMD_NEON
+AZ_NODISCARD int32_t _az_span_find_neon(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position);
+#endif
+
+/**
+ * @brief Returns the number of bytes at the start of \p ptr which are known not to be any of those
+ * the routine looks for, checked one block at a time. The caller checks the bytes from there on,
+ * up to the first one it looks for, which may be the first it is given.
+ */
+typedef AZ_NODISCARD int32_t (*_az_simd_prefix_fn)(uint8_t const* ptr, int32_t size);
+
+// The kernels of the URL encoding, in az_span.c, which look for the bytes to percent-encode.
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+AZ_NODISCARD int32_t _az_span_url_unreserved_prefix_sse2(uint8_t const* ptr, int32_t size);
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX2
+AZ_NODISCARD int32_t _az_span_url_unreserved_prefix_avx2(uint8_t const* ptr, int32_t size);
+#endif
+
+#ifdef _az_SIMD_NEON
+AZ_NODISCARD int32_t _az_span_url_unreserved_prefix_neon(uint8_t const* ptr, int32_t size);
+#endif
+
+// The kernels of the JSON writer, in az_json_writer.c, which look for the bytes to escape.
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+AZ_NODISCARD int32_t _az_json_writer_unescaped_prefix_sse2(uint8_t const* ptr, int32_t size);
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX2
+AZ_NODISCARD int32_t _az_json_writer_unescaped_prefix_avx2(uint8_t const* ptr, int32_t size);
+#endif
+
+#ifdef _az_SIMD_NEON
+AZ_NODISCARD int32_t _az_json_writer_unescaped_prefix_neon(uint8_t const* ptr, int32_t size);
+#endif
+
+// The kernels of the JSON token unescaping, in az_json_token.c, which look for backslashes.
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+AZ_NODISCARD int32_t _az_json_token_unescaped_prefix_sse2(uint8_t const* ptr, int32_t size);
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX2
+AZ_NODISCARD int32_t _az_json_token_unescaped_prefix_avx2(uint8_t const* ptr, int32_t size);
+#endif
+
+#ifdef _az_SIMD_NEON
+AZ_NODISCARD int32_t _az_json_token_unescaped_prefix_neon(uint8_t const* ptr, int32_t size);
+#endif
+
+/**
+ * @brief Sets the masks of the 64 bytes of \p block.
+ */
+typedef void (*_az_simd_json_classify_fn)(uint8_t const* block, _az_json_index_block_masks* out);
+
+// The kernels of the JSON structural index, in az_json_reader.c.
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+void _az_json_index_classify_block_sse2(uint8_t const* block, _az_json_index_block_masks* out);
+#endif
+
+#ifdef _az_SIMD_KERNEL_AVX2
+void _az_json_index_classify_block_avx2(uint8_t const* block, _az_json_index_block_masks* out);
+#endif
+
+#ifdef _az_SIMD_NEON
+void _az_json_index_classify_block_neon(uint8_t const* block, _az_json_index_block_masks* out);
+#endif
+
+/**
+ * @brief Encodes or decodes as many whole groups of \p source as the kernel can, with \p alphabet,
+ * and returns the number of source bytes it consumed. Decoding stops at the first block holding a
+ * byte outside of the alphabet, which is left to the caller to report.
+ */
+typedef AZ_NODISCARD int32_t (*_az_simd_base64_fn)(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet);
+
+// The kernels of the base64 encoding and decoding, in az_crypto.c.
+
+#ifdef _az_SIMD_KERNEL_AVX2
+AZ_NODISCARD int32_t _az_base64_encode_avx2(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet);
+
+AZ_NODISCARD int32_t _az_base64_decode_avx2(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet);
+#endif
+
+#if defined(_az_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+AZ_NODISCARD int32_t _az_base64_encode_neon(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet);
+
+AZ_NODISCARD int32_t _az_base64_decode_neon(
+    uint8_t* destination,
+    uint8_t const* source,
+    int32_t size,
+    uint8_t const* alphabet);
+#endif
+
+/**
+ * @brief Updates the CRC-64, already inverted, with \p size bytes of \p data, which must be at
+ * least 16.
+ */
+typedef AZ_NODISCARD uint64_t (*_az_simd_crc64_fn)(uint64_t crc, uint8_t const* data, int32_t size);
+
+// The kernels of az_crypto_crc64(), in az_crypto.c.
+
+#ifdef _az_SIMD_KERNEL_CLMUL_X86
+AZ_NODISCARD uint64_t _az_crc64_update_clmul_x86(uint64_t crc, uint8_t const* data, int32_t size);
+#endif
+
+#ifdef _az_SIMD_KERNEL_CLMUL_ARMV8
+AZ_NODISCARD uint64_t
+_az_crc64_update_clmul_armv8(uint64_t crc, uint8_t const* data, int32_t size);
+#endif
+
+/**
+ * @brief Compresses \p block_count blocks of 64 bytes of \p data into the SHA-256 \p state.
+ */
+typedef void (*_az_simd_sha256_fn)(uint32_t state[8], uint8_t const* data, int32_t block_count);
+
+// The kernels of the SHA-256 compression, in az_crypto.c.
+
+#ifdef _az_SIMD_KERNEL_SHA_X86
+void _az_sha256_compress_sha_x86(uint32_t state[8], uint8_t const* data, int32_t block_count);
+#endif
+
+#ifdef _az_SIMD_KERNEL_SHA_ARMV8
+void _az_sha256_compress_sha_armv8(uint32_t state[8], uint8_t const* data, int32_t block_count);
+#endif
+
+/**
+ * @brief The kernels of the routines which use the best instruction set of the host, picked from
+ * the features returned by #_az_simd_get_features(). Those without a kernel for the host, which
+ * only the base64, CRC-64 and SHA-256 routines can lack, are `NULL`, and their routines use their
+ * scalar implementation.
+ */
+typedef struct
+{
+  _az_simd_span_find_fn span_find;
+  _az_simd_prefix_fn span_url_unreserved_prefix;
+  _az_simd_prefix_fn json_writer_unescaped_prefix;
+  _az_simd_prefix_fn json_token_unescaped_prefix;
+  _az_simd_json_classify_fn json_index_classify_block;
+  _az_simd_base64_fn base64_encode;
+  _az_simd_base64_fn base64_decode;
+  _az_simd_crc64_fn crc64_update;
+  _az_simd_sha256_fn sha256_compress;
+} _az_simd_kernel_table;
+
+/**
+ * @brief Gets the kernels for the host, which are picked on the first call.
+ */
+AZ_NODISCARD _az_simd_kernel_table const* _az_simd_get_kernels(void);
+
+/**
+ * @brief Picks the kernels again, for the instruction sets of \p features the build has kernels
+ * for, in addition to those the compiler targets. This lets tests run each kernel on a host which
+ * supports them.
+ */
+void _az_simd_select_kernels(uint32_t features);
+
+#endif // _az_SIMD
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_SIMD_PRIVATE_H
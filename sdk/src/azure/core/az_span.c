@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "az_hex_private.h"
+#include "az_simd_private.h"
 #include "az_span_private.h"
 #include <azure/core/az_precondition.h>
 #include <azure/core/az_span.h>
@@ -10,17 +11,15 @@
 #include <azure/core/internal/az_span_internal.h>
 
 #include <ctype.h>
+#include <float.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <azure/core/_az_cfg.h>
 
-// The maximum integer value that can be stored in a double without losing precision (2^53 - 1)
-// An IEEE 64-bit double has 52 bits of mantissa
-#define _az_MAX_SAFE_INTEGER 9007199254740991
-
 #ifndef AZ_NO_PRECONDITION_CHECKING
 // Note: If you are modifying this function, make sure to modify the inline version in the az_span.h
 // file as well.
@@ -83,6 +82,97 @@ AZ_NODISCARD AZ_INLINE uint8_t _az_tolower(uint8_t value)
   return value;
 }
 
+#ifdef _az_SIMD
+
+#if defined(_az_SIMD_AVX2)
+#define _az_SPAN_FOLD_BLOCK_SIZE 32
+#else
+#define _az_SPAN_FOLD_BLOCK_SIZE 16
+#endif
+
+/*
+ * Compares `size` bytes, which must be at least one block, ignoring ASCII case. Each block of both
+ * spans is folded to lower case, by setting the 0x20 bit of the bytes in 'A'..'Z', and compared.
+ * The last block overlaps the one before it, so no bytes are left for a scalar loop.
+ */
+static AZ_NODISCARD bool _az_span_is_content_equal_ignoring_case_vectorized(
+    uint8_t const* ptr1,
+    uint8_t const* ptr2,
+    int32_t size)
+{
+#if defined(_az_SIMD_AVX2)
+  // There is no unsigned byte comparison, so 'A'..'Z' is moved to the bottom of the signed range.
+  __m256i const offset = _mm256_set1_epi8((char)(0x80 - 'A'));
+  __m256i const upper_end = _mm256_set1_epi8((char)(-0x80 + ('Z' - 'A') + 1));
+  __m256i const case_bit = _mm256_set1_epi8((char)_az_ASCII_LOWER_DIF);
+#elif defined(_az_SIMD_SSE2)
+  __m128i const offset = _mm_set1_epi8((char)(0x80 - 'A'));
+  __m128i const upper_end = _mm_set1_epi8((char)(-0x80 + ('Z' - 'A') + 1));
+  __m128i const case_bit = _mm_set1_epi8((char)_az_ASCII_LOWER_DIF);
+#else
+  uint8x16_t const first_upper = vdupq_n_u8('A');
+  uint8x16_t const upper_range = vdupq_n_u8('Z' - 'A');
+  uint8x16_t const case_bit = vdupq_n_u8(_az_ASCII_LOWER_DIF);
+#endif
+
+  int32_t i = 0;
+  while (true)
+  {
+#if defined(_az_SIMD_AVX2)
+    __m256i const block1 = _mm256_loadu_si256((__m256i const*)(ptr1 + i));
+    __m256i const block2 = _mm256_loadu_si256((__m256i const*)(ptr2 + i));
+    __m256i const lower1 = _mm256_or_si256(
+        block1,
+        _mm256_and_si256(
+            _mm256_cmpgt_epi8(upper_end, _mm256_add_epi8(block1, offset)), case_bit));
+    __m256i const lower2 = _mm256_or_si256(
+        block2,
+        _mm256_and_si256(
+            _mm256_cmpgt_epi8(upper_end, _mm256_add_epi8(block2, offset)), case_bit));
+    bool const equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lower1, lower2)) == -1;
+#elif defined(_az_SIMD_SSE2)
+    __m128i const block1 = _mm_loadu_si128((__m128i const*)(ptr1 + i));
+    __m128i const block2 = _mm_loadu_si128((__m128i const*)(ptr2 + i));
+    __m128i const lower1 = _mm_or_si128(
+        block1, _mm_and_si128(_mm_cmpgt_epi8(upper_end, _mm_add_epi8(block1, offset)), case_bit));
+    __m128i const lower2 = _mm_or_si128(
+        block2, _mm_and_si128(_mm_cmpgt_epi8(upper_end, _mm_add_epi8(block2, offset)), case_bit));
+    bool const equal = _mm_movemask_epi8(_mm_cmpeq_epi8(lower1, lower2)) == 0xFFFF;
+#else
+    uint8x16_t const block1 = vld1q_u8(ptr1 + i);
+    uint8x16_t const block2 = vld1q_u8(ptr2 + i);
+    uint8x16_t const lower1 = vorrq_u8(
+        block1, vandq_u8(vcleq_u8(vsubq_u8(block1, first_upper), upper_range), case_bit));
+    uint8x16_t const lower2 = vorrq_u8(
+        block2, vandq_u8(vcleq_u8(vsubq_u8(block2, first_upper), upper_range), case_bit));
+    // As in _az_span_find_neon(), narrowing leaves one nibble per byte of the comparison.
+    bool const equal = vget_lane_u64(
+                           vreinterpret_u64_u8(vshrn_n_u16(
+                               vreinterpretq_u16_u8(vceqq_u8(lower1, lower2)), 4)),
+                           0)
+        == UINT64_MAX;
+#endif
+
+    if (!equal)
+    {
+      return false;
+    }
+
+    if (i == size - _az_SPAN_FOLD_BLOCK_SIZE)
+    {
+      return true;
+    }
+
+    i += _az_SPAN_FOLD_BLOCK_SIZE;
+    if (i > size - _az_SPAN_FOLD_BLOCK_SIZE)
+    {
+      i = size - _az_SPAN_FOLD_BLOCK_SIZE;
+    }
+  }
+}
+
+#endif // _az_SIMD
+
 AZ_NODISCARD bool az_span_is_content_equal_ignoring_case(az_span span1, az_span span2)
 {
   int32_t const size = az_span_size(span1);
@@ -90,6 +180,15 @@ AZ_NODISCARD bool az_span_is_content_equal_ignoring_case(az_span span1, az_span
   {
     return false;
   }
+
+#ifdef _az_SIMD
+  if (size >= _az_SPAN_FOLD_BLOCK_SIZE)
+  {
+    return _az_span_is_content_equal_ignoring_case_vectorized(
+        az_span_ptr(span1), az_span_ptr(span2), size);
+  }
+#endif // _az_SIMD
+
   for (int32_t i = 0; i < size; ++i)
   {
     if (_az_tolower(az_span_ptr(span1)[i]) != _az_tolower(az_span_ptr(span2)[i]))
@@ -354,6 +453,220 @@ static bool _is_valid_start_of_double(uint8_t first_byte)
   return result;
 }
 
+enum
+{
+  _az_DOUBLE_PARSER_STATE_START,
+  _az_DOUBLE_PARSER_STATE_SIGN,
+  _az_DOUBLE_PARSER_STATE_INTEGER,
+  _az_DOUBLE_PARSER_STATE_DECIMAL_POINT,
+  _az_DOUBLE_PARSER_STATE_FRACTION,
+  _az_DOUBLE_PARSER_STATE_EXPONENT_START,
+  _az_DOUBLE_PARSER_STATE_EXPONENT_SIGN,
+  _az_DOUBLE_PARSER_STATE_EXPONENT,
+  _az_DOUBLE_PARSER_STATE_UNSUPPORTED,
+
+  // 19 digits always fit in a uint64_t.
+  _az_DOUBLE_PARSER_MAX_SIGNIFICANT_DIGITS = 19,
+
+  // Larger exponents are never converted by the fast path, so stop accumulating them.
+  _az_DOUBLE_PARSER_MAX_EXPONENT = 100000,
+
+  // Powers of ten up to 10^22 are exactly representable as a double.
+  _az_DOUBLE_PARSER_MAX_EXACT_POWER_OF_10 = 22,
+
+  // Up to 15 more powers of ten can be moved into the significand, when it has few enough digits
+  // to remain below 2^53.
+  _az_DOUBLE_PARSER_MAX_EXACT_INTEGER_POWER_OF_10 = 15,
+};
+
+void _az_span_double_parser_init(_az_span_double_parser* out_parser)
+{
+  _az_PRECONDITION_NOT_NULL(out_parser);
+
+  *out_parser = (_az_span_double_parser){
+    ._internal = {
+      .significand = 0,
+      .significant_digits = 0,
+      .fractional_digits = 0,
+      .exponent = 0,
+      .state = _az_DOUBLE_PARSER_STATE_START,
+      .is_negative = false,
+      .is_exponent_negative = false,
+    },
+  };
+}
+
+void _az_span_double_parser_append(_az_span_double_parser* ref_parser, az_span source)
+{
+  _az_PRECONDITION_NOT_NULL(ref_parser);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+
+  int32_t state = ref_parser->_internal.state;
+  uint8_t const* source_ptr = az_span_ptr(source);
+  int32_t const source_size = az_span_size(source);
+
+  for (int32_t i = 0; i < source_size && state != _az_DOUBLE_PARSER_STATE_UNSUPPORTED; i++)
+  {
+    uint8_t const next_byte = source_ptr[i];
+    bool const is_digit = next_byte >= '0' && next_byte <= '9';
+
+    switch (state)
+    {
+      case _az_DOUBLE_PARSER_STATE_START:
+        if (next_byte == '-' || next_byte == '+')
+        {
+          ref_parser->_internal.is_negative = next_byte == '-';
+          state = _az_DOUBLE_PARSER_STATE_SIGN;
+          continue;
+        }
+        break;
+
+      case _az_DOUBLE_PARSER_STATE_INTEGER:
+      case _az_DOUBLE_PARSER_STATE_FRACTION:
+        if (state == _az_DOUBLE_PARSER_STATE_INTEGER && next_byte == '.')
+        {
+          state = _az_DOUBLE_PARSER_STATE_DECIMAL_POINT;
+          continue;
+        }
+        if (next_byte == 'e' || next_byte == 'E')
+        {
+          state = _az_DOUBLE_PARSER_STATE_EXPONENT_START;
+          continue;
+        }
+        break;
+
+      case _az_DOUBLE_PARSER_STATE_EXPONENT_START:
+        if (next_byte == '-' || next_byte == '+')
+        {
+          ref_parser->_internal.is_exponent_negative = next_byte == '-';
+          state = _az_DOUBLE_PARSER_STATE_EXPONENT_SIGN;
+          continue;
+        }
+        break;
+
+      default:
+        break;
+    }
+
+    if (!is_digit)
+    {
+      state = _az_DOUBLE_PARSER_STATE_UNSUPPORTED;
+      continue;
+    }
+
+    // The states after the mantissa are all parts of the exponent.
+    int32_t const digit = next_byte - '0';
+    if (state >= _az_DOUBLE_PARSER_STATE_EXPONENT_START)
+    {
+      state = _az_DOUBLE_PARSER_STATE_EXPONENT;
+      if (ref_parser->_internal.exponent < _az_DOUBLE_PARSER_MAX_EXPONENT)
+      {
+        ref_parser->_internal.exponent = ref_parser->_internal.exponent * 10 + digit;
+      }
+      continue;
+    }
+
+    if (state == _az_DOUBLE_PARSER_STATE_DECIMAL_POINT)
+    {
+      state = _az_DOUBLE_PARSER_STATE_FRACTION;
+    }
+    else if (state != _az_DOUBLE_PARSER_STATE_FRACTION)
+    {
+      state = _az_DOUBLE_PARSER_STATE_INTEGER;
+    }
+
+    if (state == _az_DOUBLE_PARSER_STATE_FRACTION)
+    {
+      ref_parser->_internal.fractional_digits++;
+    }
+
+    // Leading zeros are not significant.
+    if (ref_parser->_internal.significand == 0 && digit == 0)
+    {
+      continue;
+    }
+
+    if (ref_parser->_internal.significant_digits == _az_DOUBLE_PARSER_MAX_SIGNIFICANT_DIGITS)
+    {
+      state = _az_DOUBLE_PARSER_STATE_UNSUPPORTED;
+      continue;
+    }
+
+    ref_parser->_internal.significand
+        = ref_parser->_internal.significand * 10 + (uint64_t)digit;
+    ref_parser->_internal.significant_digits++;
+  }
+
+  ref_parser->_internal.state = state;
+}
+
+AZ_NODISCARD bool _az_span_double_parser_get_value(
+    _az_span_double_parser const* parser,
+    double* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(parser);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  // A decimal point must follow at least one digit, the exponent must have digits, and the value
+  // must be converted with double precision, rather than the extended precision of an x87 FPU.
+  int32_t const state = parser->_internal.state;
+  if ((state != _az_DOUBLE_PARSER_STATE_INTEGER && state != _az_DOUBLE_PARSER_STATE_DECIMAL_POINT
+       && state != _az_DOUBLE_PARSER_STATE_FRACTION && state != _az_DOUBLE_PARSER_STATE_EXPONENT)
+      || parser->_internal.exponent >= _az_DOUBLE_PARSER_MAX_EXPONENT)
+  {
+    return false;
+  }
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+  return false;
+#else
+  static double const powers_of_10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+
+  uint64_t significand = parser->_internal.significand;
+  int32_t exponent
+      = (parser->_internal.is_exponent_negative ? -parser->_internal.exponent
+                                                : parser->_internal.exponent)
+      - parser->_internal.fractional_digits;
+
+  if (significand == 0)
+  {
+    *out_value = parser->_internal.is_negative ? -0.0 : 0.0;
+    return true;
+  }
+
+  // Both the significand and the power of ten are exact doubles, so the single multiplication or
+  // division is correctly rounded (Clinger's fast path). A larger exponent can still be used when
+  // the significand has few enough digits to absorb the excess exactly.
+  int32_t const max_exponent
+      = _az_DOUBLE_PARSER_MAX_EXACT_POWER_OF_10 + _az_DOUBLE_PARSER_MAX_EXACT_INTEGER_POWER_OF_10;
+  if (exponent > _az_DOUBLE_PARSER_MAX_EXACT_POWER_OF_10 && exponent <= max_exponent)
+  {
+    for (; exponent > _az_DOUBLE_PARSER_MAX_EXACT_POWER_OF_10; exponent--)
+    {
+      significand *= 10;
+      if (significand > _az_MAX_SAFE_INTEGER)
+      {
+        return false;
+      }
+    }
+  }
+
+  if (significand > _az_MAX_SAFE_INTEGER || exponent < -_az_DOUBLE_PARSER_MAX_EXACT_POWER_OF_10
+      || exponent > _az_DOUBLE_PARSER_MAX_EXACT_POWER_OF_10)
+  {
+    return false;
+  }
+
+  double value = (double)significand;
+  value = exponent < 0 ? value / powers_of_10[-exponent] : value * powers_of_10[exponent];
+  *out_value = parser->_internal.is_negative ? -value : value;
+  return true;
+#endif // FLT_EVAL_METHOD
+}
+
 // Disable the following warning just for this particular use case.
 // C4996: 'sscanf': This function or variable may be unsafe. Consider using sscanf_s instead.
 // C4710: 'sscanf': function not inlined
@@ -380,6 +693,15 @@ AZ_NODISCARD az_result az_span_atod(az_span source, double* out_number)
     return AZ_ERROR_UNEXPECTED_CHAR;
   }
 
+  // Most numbers have few enough digits to be converted exactly without sscanf.
+  _az_span_double_parser parser = { 0 };
+  _az_span_double_parser_init(&parser);
+  _az_span_double_parser_append(&parser, source);
+  if (_az_span_double_parser_get_value(&parser, out_number))
+  {
+    return AZ_OK;
+  }
+
   // Stack based string to allow thread-safe mutation.
   // The length is 8 to allow space for the null-terminating character.
   char format[8] = "%00lf%n";
@@ -400,6 +722,180 @@ AZ_NODISCARD az_result az_span_atod(az_span source, double* out_number)
 #pragma warning(pop)
 #endif
 
+#ifdef _az_SIMD
+
+/*
+ * The kernels of az_span_find() look for `target` one block of candidate positions at a time: the
+ * first and last bytes of `target` are broadcast into vector registers and compared against
+ * `source` at each position and `target_size - 1` bytes further. Only the positions where both
+ * match, whose bits are set in the mask of the block, are compared in full by this function.
+ */
+AZ_NODISCARD AZ_INLINE int32_t _az_span_find_check_candidates(
+    uint8_t const* block_first,
+    uint8_t const* target_ptr,
+    int32_t last_offset,
+    uint64_t mask,
+    int32_t mask_bits_per_position)
+{
+  uint64_t const position_bits = ((uint64_t)1 << mask_bits_per_position) - 1;
+  while (mask != 0)
+  {
+    int32_t const bit = _az_simd_lowest_bit_index(mask);
+    int32_t const candidate = bit / mask_bits_per_position;
+    if (memcmp(block_first + candidate + 1, target_ptr + 1, (size_t)last_offset) == 0)
+    {
+      return candidate;
+    }
+
+    mask &= ~(position_bits << bit);
+  }
+
+  return -1;
+}
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+AZ_NODISCARD int32_t _az_span_find_sse2(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position)
+{
+  int32_t const last_offset = target_size - 1;
+  int32_t const positions = source_size - last_offset;
+  __m128i const first = _mm_set1_epi8((char)target_ptr[0]);
+  __m128i const last = _mm_set1_epi8((char)target_ptr[last_offset]);
+
+  int32_t i = 0;
+  for (; i + 16 <= positions; i += 16)
+  {
+    __m128i const matches = _mm_and_si128(
+        _mm_cmpeq_epi8(first, _mm_loadu_si128((__m128i const*)(source_ptr + i))),
+        _mm_cmpeq_epi8(last, _mm_loadu_si128((__m128i const*)(source_ptr + i + last_offset))));
+    int32_t const found = _az_span_find_check_candidates(
+        source_ptr + i, target_ptr, last_offset, (uint32_t)_mm_movemask_epi8(matches), 1);
+    if (found != -1)
+    {
+      return i + found;
+    }
+  }
+
+  *out_position = i;
+  return -1;
+}
+
+#endif // defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") AZ_NODISCARD int32_t _az_span_find_avx2(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position)
+{
+  int32_t const last_offset = target_size - 1;
+  int32_t const positions = source_size - last_offset;
+  __m256i const first = _mm256_set1_epi8((char)target_ptr[0]);
+  __m256i const last = _mm256_set1_epi8((char)target_ptr[last_offset]);
+
+  int32_t i = 0;
+  for (; i + 32 <= positions; i += 32)
+  {
+    __m256i const matches = _mm256_and_si256(
+        _mm256_cmpeq_epi8(first, _mm256_loadu_si256((__m256i const*)(source_ptr + i))),
+        _mm256_cmpeq_epi8(
+            last, _mm256_loadu_si256((__m256i const*)(source_ptr + i + last_offset))));
+    int32_t const found = _az_span_find_check_candidates(
+        source_ptr + i, target_ptr, last_offset, (uint32_t)_mm256_movemask_epi8(matches), 1);
+    if (found != -1)
+    {
+      return i + found;
+    }
+  }
+
+  *out_position = i;
+  return -1;
+}
+
+#endif // _az_SIMD_KERNEL_AVX2
+
+#ifdef _az_SIMD_KERNEL_AVX512BW
+
+_az_SIMD_TARGET("avx512f,avx512bw") AZ_NODISCARD int32_t _az_span_find_avx512bw(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position)
+{
+  int32_t const last_offset = target_size - 1;
+  int32_t const positions = source_size - last_offset;
+  __m512i const first = _mm512_set1_epi8((char)target_ptr[0]);
+  __m512i const last = _mm512_set1_epi8((char)target_ptr[last_offset]);
+
+  int32_t i = 0;
+  for (; i + 64 <= positions; i += 64)
+  {
+    // The comparisons of AVX-512 give a bit for each position, so they need no movemask.
+    uint64_t const matches
+        = _mm512_cmpeq_epi8_mask(first, _mm512_loadu_si512(source_ptr + i))
+        & _mm512_cmpeq_epi8_mask(last, _mm512_loadu_si512(source_ptr + i + last_offset));
+    int32_t const found
+        = _az_span_find_check_candidates(source_ptr + i, target_ptr, last_offset, matches, 1);
+    if (found != -1)
+    {
+      return i + found;
+    }
+  }
+
+  *out_position = i;
+  return -1;
+}
+
+#endif // _az_SIMD_KERNEL_AVX512BW
+
+#ifdef _az_SIMD_NEON
+
+AZ_NODISCARD int32_t _az_span_find_neon(
+    uint8_t const* source_ptr,
+    int32_t source_size,
+    uint8_t const* target_ptr,
+    int32_t target_size,
+    int32_t* out_position)
+{
+  int32_t const last_offset = target_size - 1;
+  int32_t const positions = source_size - last_offset;
+  uint8x16_t const first = vdupq_n_u8(target_ptr[0]);
+  uint8x16_t const last = vdupq_n_u8(target_ptr[last_offset]);
+
+  int32_t i = 0;
+  for (; i + 16 <= positions; i += 16)
+  {
+    // NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves one nibble per position.
+    uint8x16_t const matches = vandq_u8(
+        vceqq_u8(first, vld1q_u8(source_ptr + i)),
+        vceqq_u8(last, vld1q_u8(source_ptr + i + last_offset)));
+    uint64_t const mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    int32_t const found
+        = _az_span_find_check_candidates(source_ptr + i, target_ptr, last_offset, mask, 4);
+    if (found != -1)
+    {
+      return i + found;
+    }
+  }
+
+  *out_position = i;
+  return -1;
+}
+
+#endif // _az_SIMD_NEON
+
+#endif // _az_SIMD
+
 AZ_NODISCARD int32_t az_span_find(az_span source, az_span target)
 {
   /* This function implements the Naive string-search algorithm.
@@ -421,6 +917,10 @@ AZ_NODISCARD int32_t az_span_find(az_span source, az_span target)
    *     - the loop has reached the end of `source` (and there are still remaining bytes of `target`
    *         to be checked).
    */
+  /* When a SIMD instruction set is available, positions are first checked one block at a time by
+   * the kernel of the host, from _az_simd_get_kernels(), and this loop only checks the ones left
+   * over after the last block.
+   */
 
   int32_t source_size = az_span_size(source);
   int32_t target_size = az_span_size(target);
@@ -438,9 +938,19 @@ AZ_NODISCARD int32_t az_span_find(az_span source, az_span target)
   {
     uint8_t* source_ptr = az_span_ptr(source);
     uint8_t* target_ptr = az_span_ptr(target);
+    int32_t i = 0;
+
+#ifdef _az_SIMD
+    int32_t const found
+        = _az_simd_get_kernels()->span_find(source_ptr, source_size, target_ptr, target_size, &i);
+    if (found != -1)
+    {
+      return found;
+    }
+#endif // _az_SIMD
 
     // This loop traverses `source` position by position (step 1.)
-    for (int32_t i = 0; i < (source_size - target_size + 1); i++)
+    for (; i < (source_size - target_size + 1); i++)
     {
       // This is the check done in step 1. above.
       if (source_ptr[i] == target_ptr[0])
@@ -557,36 +1067,123 @@ void az_span_to_str(char* destination, int32_t destination_max_size, az_span sou
 
 AZ_INLINE uint8_t _az_decimal_to_ascii(uint8_t d) { return (uint8_t)(('0' + d) & 0xFF); }
 
-static AZ_NODISCARD az_result _az_span_builder_append_uint64(az_span* ref_span, uint64_t n)
+// The ASCII representation of every number from 00 to 99, so that two digits can be emitted per
+// division by 100.
+static uint8_t const _az_digit_pairs[200] = {
+  '0', '0', '0', '1', '0', '2', '0', '3', '0', '4', '0', '5', '0', '6', '0', '7', '0', '8', '0',
+  '9', '1', '0', '1', '1', '1', '2', '1', '3', '1', '4', '1', '5', '1', '6', '1', '7', '1', '8',
+  '1', '9', '2', '0', '2', '1', '2', '2', '2', '3', '2', '4', '2', '5', '2', '6', '2', '7', '2',
+  '8', '2', '9', '3', '0', '3', '1', '3', '2', '3', '3', '3', '4', '3', '5', '3', '6', '3', '7',
+  '3', '8', '3', '9', '4', '0', '4', '1', '4', '2', '4', '3', '4', '4', '4', '5', '4', '6', '4',
+  '7', '4', '8', '4', '9', '5', '0', '5', '1', '5', '2', '5', '3', '5', '4', '5', '5', '5', '6',
+  '5', '7', '5', '8', '5', '9', '6', '0', '6', '1', '6', '2', '6', '3', '6', '4', '6', '5', '6',
+  '6', '6', '7', '6', '8', '6', '9', '7', '0', '7', '1', '7', '2', '7', '3', '7', '4', '7', '5',
+  '7', '6', '7', '7', '7', '8', '7', '9', '8', '0', '8', '1', '8', '2', '8', '3', '8', '4', '8',
+  '5', '8', '6', '8', '7', '8', '8', '8', '9', '9', '0', '9', '1', '9', '2', '9', '3', '9', '4',
+  '9', '5', '9', '6', '9', '7', '9', '8', '9', '9',
+};
+
+AZ_NODISCARD int32_t _az_span_u32_digit_count(uint32_t value)
 {
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(*ref_span, 1);
+  // A balanced tree of comparisons against powers of ten: at most four comparisons.
+  if (value < 100000)
+  {
+    if (value < 100)
+    {
+      return value < 10 ? 1 : 2;
+    }
+    if (value < 1000)
+    {
+      return 3;
+    }
+    return value < 10000 ? 4 : 5;
+  }
+  if (value < 10000000)
+  {
+    return value < 1000000 ? 6 : 7;
+  }
+  if (value < 1000000000)
+  {
+    return value < 100000000 ? 8 : 9;
+  }
+  return 10;
+}
 
-  if (n == 0)
+AZ_NODISCARD int32_t _az_span_u64_digit_count(uint64_t value)
+{
+  if (value <= UINT32_MAX)
   {
-    *ref_span = az_span_copy_u8(*ref_span, '0');
-    return AZ_OK;
+    return _az_span_u32_digit_count((uint32_t)value);
+  }
+
+  // Any value which doesn't fit in 32 bits has at least 10 digits.
+  if (value < 100000000000000ull)
+  {
+    if (value < 100000000000ull)
+    {
+      return value < 10000000000ull ? 10 : 11;
+    }
+    return value < 1000000000000ull ? 12 : (value < 10000000000000ull ? 13 : 14);
+  }
+  if (value < 100000000000000000ull)
+  {
+    return value < 1000000000000000ull ? 15 : (value < 10000000000000000ull ? 16 : 17);
+  }
+  if (value < 10000000000000000000ull)
+  {
+    return value < 1000000000000000000ull ? 18 : 19;
   }
+  return 20;
+}
 
-  uint64_t div = 10000000000000000000ull;
-  uint64_t nn = n;
-  int32_t digit_count = 20;
-  while (nn / div == 0)
+// Writes the digits of value backwards, two at a time, so that the last one lands right before
+// end. The caller must make sure there is room for all of them.
+static void _az_span_write_digits_backwards(uint8_t* end, uint64_t value)
+{
+  // Peel off eight digits per 64-bit division, so that the rest of the work uses 32-bit
+  // arithmetic, which is much cheaper on the microcontrollers this SDK targets.
+  while (value > UINT32_MAX)
   {
-    div /= 10;
-    digit_count--;
+    uint64_t const quotient = value / 100000000;
+    uint32_t remainder = (uint32_t)(value - (quotient * 100000000));
+    value = quotient;
+
+    for (int32_t i = 0; i < 4; i++)
+    {
+      uint32_t const pair_index = (remainder % 100) * 2;
+      remainder /= 100;
+      *--end = _az_digit_pairs[pair_index + 1];
+      *--end = _az_digit_pairs[pair_index];
+    }
   }
 
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(*ref_span, digit_count);
+  uint32_t remaining = (uint32_t)value;
+  while (remaining >= 100)
+  {
+    uint32_t const pair_index = (remaining % 100) * 2;
+    remaining /= 100;
+    *--end = _az_digit_pairs[pair_index + 1];
+    *--end = _az_digit_pairs[pair_index];
+  }
 
-  while (div > 1)
+  if (remaining >= 10)
+  {
+    *--end = _az_digit_pairs[(remaining * 2) + 1];
+    *--end = _az_digit_pairs[remaining * 2];
+  }
+  else
   {
-    uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)(nn / div));
-    *ref_span = az_span_copy_u8(*ref_span, value_to_append);
-    nn %= div;
-    div /= 10;
+    *--end = _az_decimal_to_ascii((uint8_t)remaining);
   }
-  uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)nn);
-  *ref_span = az_span_copy_u8(*ref_span, value_to_append);
+}
+
+static AZ_NODISCARD az_result _az_span_builder_append_uint64(az_span* ref_span, uint64_t n)
+{
+  int32_t const digit_count = _az_span_u64_digit_count(n);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(*ref_span, digit_count);
+
+  _az_span_write_digits_backwards(az_span_ptr(*ref_span) + digit_count, n);
+  *ref_span = az_span_slice_to_end(*ref_span, digit_count);
   return AZ_OK;
 }
 
@@ -608,7 +1205,8 @@ AZ_NODISCARD az_result az_span_i64toa(az_span destination, int64_t source, az_sp
   {
     _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, 1);
     *out_span = az_span_copy_u8(destination, '-');
-    return _az_span_builder_append_uint64(out_span, (uint64_t)-source);
+    // Negate in unsigned arithmetic, which is well defined for INT64_MIN as well.
+    return _az_span_builder_append_uint64(out_span, 0 - (uint64_t)source);
   }
 
   // make out_span point to destination before trying to write on it (might be an empty az_span or
@@ -620,38 +1218,11 @@ AZ_NODISCARD az_result az_span_i64toa(az_span destination, int64_t source, az_sp
 static AZ_NODISCARD az_result
 _az_span_builder_append_u32toa(az_span destination, uint32_t n, az_span* out_span)
 {
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, 1);
-
-  if (n == 0)
-  {
-    *out_span = az_span_copy_u8(destination, '0');
-    return AZ_OK;
-  }
-
-  uint32_t div = 1000000000;
-  uint32_t nn = n;
-  int32_t digit_count = 10;
-  while (nn / div == 0)
-  {
-    div /= 10;
-    digit_count--;
-  }
-
+  int32_t const digit_count = _az_span_u32_digit_count(n);
   _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, digit_count);
 
-  *out_span = destination;
-
-  while (div > 1)
-  {
-    uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)(nn / div));
-    *out_span = az_span_copy_u8(*out_span, value_to_append);
-
-    nn %= div;
-    div /= 10;
-  }
-
-  uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)nn);
-  *out_span = az_span_copy_u8(*out_span, value_to_append);
+  _az_span_write_digits_backwards(az_span_ptr(destination) + digit_count, n);
+  *out_span = az_span_slice_to_end(destination, digit_count);
   return AZ_OK;
 }
 
@@ -669,14 +1240,16 @@ AZ_NODISCARD az_result az_span_i32toa(az_span destination, int32_t source, az_sp
 
   *out_span = destination;
 
+  uint32_t magnitude = (uint32_t)source;
   if (source < 0)
   {
     _az_RETURN_IF_NOT_ENOUGH_SIZE(*out_span, 1);
     *out_span = az_span_copy_u8(*out_span, '-');
-    source = -source;
+    // Negate in unsigned arithmetic, which is well defined for INT32_MIN as well.
+    magnitude = 0 - magnitude;
   }
 
-  return _az_span_builder_append_u32toa(*out_span, (uint32_t)source, out_span);
+  return _az_span_builder_append_u32toa(*out_span, magnitude, out_span);
 }
 
 AZ_NODISCARD az_result
@@ -781,6 +1354,460 @@ az_span_dtoa(az_span destination, double source, int32_t fractional_digits, az_s
   return _az_span_builder_append_uint64(out_span, fractional_part);
 }
 
+/*
+ * Shortest round-trip double formatting, based on the Grisu2 algorithm by Florian Loitsch
+ * ("Printing Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010). The value
+ * and the boundaries of the interval of real numbers which round to it are scaled by a cached
+ * power of ten, so that the digits can be generated with 64-bit integer arithmetic only. The digits
+ * always read back as the same double, and are the shortest such digits for almost all values.
+ */
+
+// A floating point number f * 2^e, with a 64-bit significand.
+typedef struct
+{
+  uint64_t f;
+  int32_t e;
+} _az_diy_fp;
+
+typedef struct
+{
+  uint64_t f;
+  int16_t e; // The binary exponent of f.
+  int16_t k; // The decimal exponent of the power of ten approximated by f * 2^e.
+} _az_cached_power;
+
+enum
+{
+  // The binary exponent range of the scaled boundaries, so that the integral part of the upper
+  // boundary fits in 32 bits and digits can be multiplied by 10 without overflowing.
+  _az_GRISU_ALPHA = -60,
+  _az_GRISU_GAMMA = -32,
+
+  _az_CACHED_POWERS_MIN_DECIMAL_EXPONENT = -300,
+  _az_CACHED_POWERS_DECIMAL_EXPONENT_STEP = 8,
+
+  // Digits needed to uniquely identify any double.
+  _az_MAX_SHORTEST_DOUBLE_DIGITS = 17,
+};
+
+// 10^k, for k from -300 to 324 in steps of 8, rounded to a normalized 64-bit significand.
+static const _az_cached_power _az_cached_powers[] = {
+  { 0xAB70FE17C79AC6CA, -1060, -300 },
+  { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+  { 0xBE5691EF416BD60C, -1007, -284 },
+  { 0x8DD01FAD907FFC3C, -980, -276 },
+  { 0xD3515C2831559A83, -954, -268 },
+  { 0x9D71AC8FADA6C9B5, -927, -260 },
+  { 0xEA9C227723EE8BCB, -901, -252 },
+  { 0xAECC49914078536D, -874, -244 },
+  { 0x823C12795DB6CE57, -847, -236 },
+  { 0xC21094364DFB5637, -821, -228 },
+  { 0x9096EA6F3848984F, -794, -220 },
+  { 0xD77485CB25823AC7, -768, -212 },
+  { 0xA086CFCD97BF97F4, -741, -204 },
+  { 0xEF340A98172AACE5, -715, -196 },
+  { 0xB23867FB2A35B28E, -688, -188 },
+  { 0x84C8D4DFD2C63F3B, -661, -180 },
+  { 0xC5DD44271AD3CDBA, -635, -172 },
+  { 0x936B9FCEBB25C996, -608, -164 },
+  { 0xDBAC6C247D62A584, -582, -156 },
+  { 0xA3AB66580D5FDAF6, -555, -148 },
+  { 0xF3E2F893DEC3F126, -529, -140 },
+  { 0xB5B5ADA8AAFF80B8, -502, -132 },
+  { 0x87625F056C7C4A8B, -475, -124 },
+  { 0xC9BCFF6034C13053, -449, -116 },
+  { 0x964E858C91BA2655, -422, -108 },
+  { 0xDFF9772470297EBD, -396, -100 },
+  { 0xA6DFBD9FB8E5B88F, -369, -92 },
+  { 0xF8A95FCF88747D94, -343, -84 },
+  { 0xB94470938FA89BCF, -316, -76 },
+  { 0x8A08F0F8BF0F156B, -289, -68 },
+  { 0xCDB02555653131B6, -263, -60 },
+  { 0x993FE2C6D07B7FAC, -236, -52 },
+  { 0xE45C10C42A2B3B06, -210, -44 },
+  { 0xAA242499697392D3, -183, -36 },
+  { 0xFD87B5F28300CA0E, -157, -28 },
+  { 0xBCE5086492111AEB, -130, -20 },
+  { 0x8CBCCC096F5088CC, -103, -12 },
+  { 0xD1B71758E219652C, -77, -4 },
+  { 0x9C40000000000000, -50, 4 },
+  { 0xE8D4A51000000000, -24, 12 },
+  { 0xAD78EBC5AC620000, 3, 20 },
+  { 0x813F3978F8940984, 30, 28 },
+  { 0xC097CE7BC90715B3, 56, 36 },
+  { 0x8F7E32CE7BEA5C70, 83, 44 },
+  { 0xD5D238A4ABE98068, 109, 52 },
+  { 0x9F4F2726179A2245, 136, 60 },
+  { 0xED63A231D4C4FB27, 162, 68 },
+  { 0xB0DE65388CC8ADA8, 189, 76 },
+  { 0x83C7088E1AAB65DB, 216, 84 },
+  { 0xC45D1DF942711D9A, 242, 92 },
+  { 0x924D692CA61BE758, 269, 100 },
+  { 0xDA01EE641A708DEA, 295, 108 },
+  { 0xA26DA3999AEF774A, 322, 116 },
+  { 0xF209787BB47D6B85, 348, 124 },
+  { 0xB454E4A179DD1877, 375, 132 },
+  { 0x865B86925B9BC5C2, 402, 140 },
+  { 0xC83553C5C8965D3D, 428, 148 },
+  { 0x952AB45CFA97A0B3, 455, 156 },
+  { 0xDE469FBD99A05FE3, 481, 164 },
+  { 0xA59BC234DB398C25, 508, 172 },
+  { 0xF6C69A72A3989F5C, 534, 180 },
+  { 0xB7DCBF5354E9BECE, 561, 188 },
+  { 0x88FCF317F22241E2, 588, 196 },
+  { 0xCC20CE9BD35C78A5, 614, 204 },
+  { 0x98165AF37B2153DF, 641, 212 },
+  { 0xE2A0B5DC971F303A, 667, 220 },
+  { 0xA8D9D1535CE3B396, 694, 228 },
+  { 0xFB9B7CD9A4A7443C, 720, 236 },
+  { 0xBB764C4CA7A44410, 747, 244 },
+  { 0x8BAB8EEFB6409C1A, 774, 252 },
+  { 0xD01FEF10A657842C, 800, 260 },
+  { 0x9B10A4E5E9913129, 827, 268 },
+  { 0xE7109BFBA19C0C9D, 853, 276 },
+  { 0xAC2820D9623BF429, 880, 284 },
+  { 0x80444B5E7AA7CF85, 907, 292 },
+  { 0xBF21E44003ACDD2D, 933, 300 },
+  { 0x8E679C2F5E44FF8F, 960, 308 },
+  { 0xD433179D9C8CB841, 986, 316 },
+  { 0x9E19DB92B4E31BA9, 1013, 324 },
+};
+
+AZ_NODISCARD static _az_diy_fp _az_diy_fp_multiply(_az_diy_fp x, _az_diy_fp y)
+{
+  // Compute the upper 64 bits of the 128-bit product, rounded, from 32-bit halves.
+  uint64_t const x_lo = x.f & 0xFFFFFFFF;
+  uint64_t const x_hi = x.f >> 32;
+  uint64_t const y_lo = y.f & 0xFFFFFFFF;
+  uint64_t const y_hi = y.f >> 32;
+
+  uint64_t const p0 = x_lo * y_lo;
+  uint64_t const p1 = x_lo * y_hi;
+  uint64_t const p2 = x_hi * y_lo;
+  uint64_t const p3 = x_hi * y_hi;
+
+  uint64_t middle = (p0 >> 32) + (p1 & 0xFFFFFFFF) + (p2 & 0xFFFFFFFF);
+  middle += (uint64_t)1 << 31;
+
+  return (_az_diy_fp){
+    .f = p3 + (p2 >> 32) + (p1 >> 32) + (middle >> 32),
+    .e = x.e + y.e + 64,
+  };
+}
+
+AZ_NODISCARD static _az_diy_fp _az_diy_fp_normalize(_az_diy_fp x)
+{
+  while ((x.f >> 63) == 0)
+  {
+    x.f <<= 1;
+    x.e--;
+  }
+
+  return x;
+}
+
+// Rounds the last digit towards the value as long as the digits stay within the boundaries.
+static void _az_grisu_round(
+    uint8_t* digits,
+    int32_t length,
+    uint64_t distance,
+    uint64_t delta,
+    uint64_t rest,
+    uint64_t ten_kappa)
+{
+  while (rest < distance && delta - rest >= ten_kappa
+         && (rest + ten_kappa < distance || distance - rest > rest + ten_kappa - distance))
+  {
+    digits[length - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+// Writes the shortest digits of a finite, positive double, given its IEEE 754 representation, and
+// returns how many were written. The value is the digits times 10^out_decimal_exponent.
+static int32_t _az_grisu2(uint64_t bits, uint8_t* digits, int32_t* out_decimal_exponent)
+{
+  // Split the representation into its significand and binary exponent.
+  uint64_t const hidden_bit = (uint64_t)1 << 52;
+  uint64_t const fraction = bits & (hidden_bit - 1);
+  int32_t const biased_exponent = (int32_t)(bits >> 52);
+  int32_t const exponent_bias = 1023 + 52;
+
+  _az_diy_fp const v = biased_exponent == 0
+      ? (_az_diy_fp){ .f = fraction, .e = 1 - exponent_bias }
+      : (_az_diy_fp){ .f = fraction + hidden_bit, .e = biased_exponent - exponent_bias };
+
+  // The boundaries are halfway to the neighboring doubles. The lower one is closer when the
+  // significand is a power of two, since the exponent then decreases below the value.
+  _az_diy_fp const upper = _az_diy_fp_normalize((_az_diy_fp){ .f = 2 * v.f + 1, .e = v.e - 1 });
+  _az_diy_fp lower = (fraction == 0 && biased_exponent > 1)
+      ? (_az_diy_fp){ .f = 4 * v.f - 1, .e = v.e - 2 }
+      : (_az_diy_fp){ .f = 2 * v.f - 1, .e = v.e - 1 };
+  lower.f <<= lower.e - upper.e;
+  lower.e = upper.e;
+
+  // Pick the cached power of ten which brings the exponent of the upper boundary within
+  // [_az_GRISU_ALPHA, _az_GRISU_GAMMA]. 78913 / 2^18 approximates log10(2).
+  int32_t const f = _az_GRISU_ALPHA - upper.e - 1;
+  int32_t const k = (f * 78913) / (1 << 18) + (f > 0);
+  int32_t const index = (-_az_CACHED_POWERS_MIN_DECIMAL_EXPONENT + k
+                         + (_az_CACHED_POWERS_DECIMAL_EXPONENT_STEP - 1))
+      / _az_CACHED_POWERS_DECIMAL_EXPONENT_STEP;
+  _az_cached_power const cached = _az_cached_powers[index];
+  _az_diy_fp const power = { .f = cached.f, .e = cached.e };
+
+  _az_diy_fp const w = _az_diy_fp_multiply(_az_diy_fp_normalize(v), power);
+  _az_diy_fp w_lower = _az_diy_fp_multiply(lower, power);
+  _az_diy_fp w_upper = _az_diy_fp_multiply(upper, power);
+
+  // Shrink the interval by one unit on each side, to account for the multiplication errors.
+  w_lower.f++;
+  w_upper.f--;
+
+  int32_t decimal_exponent = -cached.k;
+
+  uint64_t delta = w_upper.f - w_lower.f;
+  uint64_t distance = w_upper.f - w.f;
+
+  // Split the upper boundary into its integral and fractional parts.
+  int32_t const shift = -w_upper.e;
+  uint64_t const one = (uint64_t)1 << shift;
+  uint32_t integral = (uint32_t)(w_upper.f >> shift);
+  uint64_t fractional = w_upper.f & (one - 1);
+
+  uint32_t power_of_ten = 1000000000;
+  int32_t kappa = 10;
+  while (power_of_ten > integral && kappa > 1)
+  {
+    power_of_ten /= 10;
+    kappa--;
+  }
+
+  int32_t length = 0;
+
+  // Generate the digits of the integral part, stopping as soon as they identify the value.
+  while (kappa > 0)
+  {
+    digits[length++] = (uint8_t)('0' + integral / power_of_ten);
+    integral %= power_of_ten;
+    kappa--;
+
+    uint64_t const rest = ((uint64_t)integral << shift) + fractional;
+    if (rest <= delta)
+    {
+      *out_decimal_exponent = decimal_exponent + kappa;
+      _az_grisu_round(digits, length, distance, delta, rest, (uint64_t)power_of_ten << shift);
+      return length;
+    }
+
+    power_of_ten /= 10;
+  }
+
+  // Then the digits of the fractional part.
+  int32_t fractional_digits = 0;
+  do
+  {
+    fractional *= 10;
+    digits[length++] = (uint8_t)('0' + (fractional >> shift));
+    fractional &= one - 1;
+    fractional_digits++;
+
+    delta *= 10;
+    distance *= 10;
+  } while (fractional > delta);
+
+  *out_decimal_exponent = decimal_exponent - fractional_digits;
+  _az_grisu_round(digits, length, distance, delta, fractional, one);
+  return length;
+}
+
+AZ_NODISCARD az_result az_span_dtoa_shortest(az_span destination, double source, az_span* out_span)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, false);
+  // Inputs that are either positive or negative infinity, or not a number, are not supported.
+  _az_PRECONDITION(_az_isfinite(source));
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  *out_span = destination;
+
+  // The input is either positive or negative infinity, or not a number.
+  if (!_az_isfinite(source))
+  {
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  uint8_t buffer[_az_MAX_SIZE_FOR_WRITING_SHORTEST_DOUBLE] = { 0 };
+  az_span remaining = AZ_SPAN_FROM_BUFFER(buffer);
+
+  uint64_t bits = 0;
+  memcpy(&bits, &source, sizeof(bits));
+
+  // Negative zero is written as 0, like az_span_dtoa() does.
+  uint64_t const sign_bit = (uint64_t)1 << 63;
+  if ((bits & ~sign_bit) == 0)
+  {
+    remaining = az_span_copy_u8(remaining, '0');
+  }
+  else
+  {
+    if ((bits & sign_bit) != 0)
+    {
+      remaining = az_span_copy_u8(remaining, '-');
+    }
+
+    uint8_t digits[_az_MAX_SHORTEST_DOUBLE_DIGITS] = { 0 };
+    int32_t decimal_exponent = 0;
+    int32_t const length = _az_grisu2(bits & ~sign_bit, digits, &decimal_exponent);
+    az_span const digit_span = az_span_create(digits, length);
+
+    // Same layout as the JavaScript Number.prototype.toString(): plain decimal notation for values
+    // from 1e-7 up to 1e21, and scientific notation otherwise. The value is 0.digits * 10^point.
+    int32_t const point = length + decimal_exponent;
+    if (length <= point && point <= 21)
+    {
+      remaining = az_span_copy(remaining, digit_span);
+      for (int32_t i = length; i < point; i++)
+      {
+        remaining = az_span_copy_u8(remaining, '0');
+      }
+    }
+    else if (0 < point && point <= 21)
+    {
+      remaining = az_span_copy(remaining, az_span_slice(digit_span, 0, point));
+      remaining = az_span_copy_u8(remaining, '.');
+      remaining = az_span_copy(remaining, az_span_slice_to_end(digit_span, point));
+    }
+    else if (-6 < point && point <= 0)
+    {
+      remaining = az_span_copy(remaining, AZ_SPAN_FROM_STR("0."));
+      for (int32_t i = point; i < 0; i++)
+      {
+        remaining = az_span_copy_u8(remaining, '0');
+      }
+      remaining = az_span_copy(remaining, digit_span);
+    }
+    else
+    {
+      remaining = az_span_copy_u8(remaining, digits[0]);
+      if (length > 1)
+      {
+        remaining = az_span_copy_u8(remaining, '.');
+        remaining = az_span_copy(remaining, az_span_slice_to_end(digit_span, 1));
+      }
+
+      int32_t exponent = point - 1;
+      remaining = az_span_copy_u8(remaining, 'e');
+      remaining = az_span_copy_u8(remaining, exponent < 0 ? '-' : '+');
+      exponent = exponent < 0 ? -exponent : exponent;
+
+      // The three digits of the exponent are written from the most significant one, skipping
+      // leading zeros.
+      if (exponent >= 100)
+      {
+        remaining = az_span_copy_u8(remaining, (uint8_t)('0' + exponent / 100));
+      }
+      if (exponent >= 10)
+      {
+        remaining = az_span_copy_u8(remaining, (uint8_t)('0' + (exponent / 10) % 10));
+      }
+      remaining = az_span_copy_u8(remaining, (uint8_t)('0' + exponent % 10));
+    }
+  }
+
+  int32_t const formatted_size = (int32_t)sizeof(buffer) - az_span_size(remaining);
+  az_span const formatted = az_span_slice(AZ_SPAN_FROM_BUFFER(buffer), 0, formatted_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(*out_span, az_span_size(formatted));
+  *out_span = az_span_copy(*out_span, formatted);
+  return AZ_OK;
+}
+
+#define _az_MSEC_PER_HOUR 3600000
+#define _az_HOURS_PER_DAY 24
+
+// The first millisecond after the end of the year 9999, the last one with 4 digits.
+#define _az_TIMESTAMP_END_EPOCH_MSEC 253402300800000ll
+
+// Writes digit_count decimal digits of value, with leading zeros.
+static uint8_t* _az_timestamp_write_digits(uint8_t* destination, int32_t value, int32_t digit_count)
+{
+  for (int32_t i = digit_count - 1; i >= 0; i--)
+  {
+    destination[i] = (uint8_t)('0' + (value % 10));
+    value /= 10;
+  }
+
+  return destination + digit_count;
+}
+
+// Writes "YYYY-MM-DDTHH:" for the hour of the day since 1/1/1970, with the civil calendar algorithm
+// of Howard Hinnant, which counts years from March so that the leap day is the last of the year.
+static void _az_timestamp_write_hour_prefix(uint8_t* destination, int64_t hours)
+{
+  int32_t const days = (int32_t)(hours / _az_HOURS_PER_DAY) + 719468; // Days since 0000-03-01.
+  int32_t const era = days / 146097;
+  int32_t const day_of_era = days - (era * 146097);
+  int32_t const year_of_era
+      = (day_of_era - (day_of_era / 1460) + (day_of_era / 36524) - (day_of_era / 146096)) / 365;
+  int32_t const day_of_year
+      = day_of_era - ((365 * year_of_era) + (year_of_era / 4) - (year_of_era / 100));
+  int32_t const month_from_march = ((5 * day_of_year) + 2) / 153;
+  int32_t const day = day_of_year - (((153 * month_from_march) + 2) / 5) + 1;
+  int32_t const month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+  int32_t const year = year_of_era + (era * 400) + (month <= 2 ? 1 : 0);
+
+  destination = _az_timestamp_write_digits(destination, year, 4);
+  *destination++ = '-';
+  destination = _az_timestamp_write_digits(destination, month, 2);
+  *destination++ = '-';
+  destination = _az_timestamp_write_digits(destination, day, 2);
+  *destination++ = 'T';
+  destination = _az_timestamp_write_digits(destination, (int32_t)(hours % _az_HOURS_PER_DAY), 2);
+  *destination = ':';
+}
+
+AZ_NODISCARD az_result az_span_timestamp_to_iso8601(
+    az_span destination,
+    int64_t epoch_msec,
+    az_span_timestamp_cache* ref_cache,
+    az_span* out_span)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, false);
+  _az_PRECONDITION(epoch_msec >= 0 && epoch_msec < _az_TIMESTAMP_END_EPOCH_MSEC);
+  _az_PRECONDITION_NOT_NULL(out_span);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, AZ_SPAN_ISO8601_TIMESTAMP_SIZE);
+
+  az_span_timestamp_cache cache;
+  if (ref_cache == NULL)
+  {
+    az_span_timestamp_cache_init(&cache);
+    ref_cache = &cache;
+  }
+
+  // The end of the hour is kept rather than its start, so that a cache which is zero holds no hour.
+  int64_t const hour_start_msec = epoch_msec - (epoch_msec % _az_MSEC_PER_HOUR);
+  if (ref_cache->_internal.hour_end_msec != hour_start_msec + _az_MSEC_PER_HOUR)
+  {
+    _az_timestamp_write_hour_prefix(
+        ref_cache->_internal.hour_prefix, hour_start_msec / _az_MSEC_PER_HOUR);
+    ref_cache->_internal.hour_end_msec = hour_start_msec + _az_MSEC_PER_HOUR;
+  }
+
+  // "MM:SS.mmmZ" follows the prefix of the hour.
+  int32_t const msec_of_hour = (int32_t)(epoch_msec - hour_start_msec);
+  uint8_t* ptr = az_span_ptr(destination);
+  memcpy(ptr, ref_cache->_internal.hour_prefix, sizeof(ref_cache->_internal.hour_prefix));
+  ptr += sizeof(ref_cache->_internal.hour_prefix);
+  ptr = _az_timestamp_write_digits(ptr, msec_of_hour / 60000, 2);
+  *ptr++ = ':';
+  ptr = _az_timestamp_write_digits(ptr, (msec_of_hour / 1000) % 60, 2);
+  *ptr++ = '.';
+  ptr = _az_timestamp_write_digits(ptr, msec_of_hour % 1000, 3);
+  *ptr = 'Z';
+
+  *out_span = az_span_slice_to_end(destination, AZ_SPAN_ISO8601_TIMESTAMP_SIZE);
+  return AZ_OK;
+}
+
 // TODO: pass az_span by value
 AZ_NODISCARD az_result _az_is_expected_span(az_span* ref_span, az_span expected)
 {
@@ -877,29 +1904,157 @@ AZ_NODISCARD az_span _az_span_trim_whitespace_from_end(az_span source)
   return _az_span_trim_side(source, RIGHT);
 }
 
-// [0-9]
-AZ_NODISCARD AZ_INLINE bool _az_span_is_byte_digit(uint8_t c) { return '0' <= c && c <= '9'; }
+// The bytes which are not percent-encoded: [A-Za-z0-9], '-', '_', '.' and '~' (RFC 3986).
+static uint8_t const _az_span_url_unreserved[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x00
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x10
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, // 0x20
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, // 0x30
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x40
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1, // 0x50
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x60
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0, // 0x70
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x80
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x90
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xA0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xB0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xC0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xD0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xE0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xF0
+};
+
+#ifdef _az_SIMD
+
+/*
+ * The kernels of the URL encoding return the number of bytes at the start of `ptr`, in whole
+ * blocks, up to the first one which must be percent-encoded. The bytes which don't are the
+ * letters, found one case at a time by setting the 0x20 bit, the digits, and `-`, `_`, `.` and `~`.
+ * There is no unsigned byte comparison on x86, so each range is moved to the bottom of the signed
+ * range.
+ */
+
+#if defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+AZ_NODISCARD int32_t _az_span_url_unreserved_prefix_sse2(uint8_t const* ptr, int32_t size)
+{
+  int32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i const bytes = _mm_loadu_si128((__m128i const*)(ptr + i));
+    __m128i const lower = _mm_or_si128(bytes, _mm_set1_epi8((char)_az_ASCII_LOWER_DIF));
+    __m128i const letters = _mm_cmpgt_epi8(
+        _mm_set1_epi8((char)(-0x80 + ('z' - 'a') + 1)),
+        _mm_add_epi8(lower, _mm_set1_epi8((char)(0x80 - 'a'))));
+    __m128i const digits = _mm_cmpgt_epi8(
+        _mm_set1_epi8((char)(-0x80 + ('9' - '0') + 1)),
+        _mm_add_epi8(bytes, _mm_set1_epi8((char)(0x80 - '0'))));
+    __m128i const marks = _mm_or_si128(
+        _mm_or_si128(
+            _mm_cmpeq_epi8(bytes, _mm_set1_epi8('-')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'))),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('~'))));
+    __m128i const unreserved = _mm_or_si128(_mm_or_si128(letters, digits), marks);
+    uint64_t const reserved = ~(uint64_t)(uint32_t)_mm_movemask_epi8(unreserved) & 0xFFFF;
+    if (reserved != 0)
+    {
+      return i + _az_simd_lowest_bit_index(reserved);
+    }
+  }
 
-// [A-Za-z]
-AZ_NODISCARD AZ_INLINE bool _az_span_is_byte_letter(uint8_t c)
+  return i;
+}
+
+#endif // defined(_az_SIMD_SSE2) || defined(_az_SIMD_AVX2)
+
+#ifdef _az_SIMD_KERNEL_AVX2
+
+_az_SIMD_TARGET("avx2") AZ_NODISCARD int32_t
+    _az_span_url_unreserved_prefix_avx2(uint8_t const* ptr, int32_t size)
 {
-  // This is equivalent to ('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z')
-  // This works because upper case and lower case letters are 0x20 away from each other.
-  return ((uint32_t)(c - 'A') & ~0x20u) <= 'Z' - 'A';
+  int32_t i = 0;
+  for (; i + 32 <= size; i += 32)
+  {
+    __m256i const bytes = _mm256_loadu_si256((__m256i const*)(ptr + i));
+    __m256i const lower = _mm256_or_si256(bytes, _mm256_set1_epi8((char)_az_ASCII_LOWER_DIF));
+    __m256i const letters = _mm256_cmpgt_epi8(
+        _mm256_set1_epi8((char)(-0x80 + ('z' - 'a') + 1)),
+        _mm256_add_epi8(lower, _mm256_set1_epi8((char)(0x80 - 'a'))));
+    __m256i const digits = _mm256_cmpgt_epi8(
+        _mm256_set1_epi8((char)(-0x80 + ('9' - '0') + 1)),
+        _mm256_add_epi8(bytes, _mm256_set1_epi8((char)(0x80 - '0'))));
+    __m256i const marks = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('-')),
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_'))),
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('.')),
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('~'))));
+    __m256i const unreserved = _mm256_or_si256(_mm256_or_si256(letters, digits), marks);
+    uint64_t const reserved = ~(uint64_t)(uint32_t)_mm256_movemask_epi8(unreserved) & UINT32_MAX;
+    if (reserved != 0)
+    {
+      return i + _az_simd_lowest_bit_index(reserved);
+    }
+  }
+
+  return i;
 }
 
-AZ_NODISCARD AZ_INLINE bool _az_span_url_should_encode(uint8_t c)
+#endif // _az_SIMD_KERNEL_AVX2
+
+#ifdef _az_SIMD_NEON
+
+AZ_NODISCARD int32_t _az_span_url_unreserved_prefix_neon(uint8_t const* ptr, int32_t size)
 {
-  switch (c)
+  int32_t i = 0;
+  for (; i + 16 <= size; i += 16)
   {
-    case '-':
-    case '_':
-    case '.':
-    case '~':
-      return false;
-    default:
-      return !(_az_span_is_byte_digit(c) || _az_span_is_byte_letter(c));
+    uint8x16_t const bytes = vld1q_u8(ptr + i);
+    uint8x16_t const lower = vorrq_u8(bytes, vdupq_n_u8(_az_ASCII_LOWER_DIF));
+    uint8x16_t const letters
+        = vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8('z' - 'a'));
+    uint8x16_t const digits = vcleq_u8(vsubq_u8(bytes, vdupq_n_u8('0')), vdupq_n_u8('9' - '0'));
+    uint8x16_t const marks = vorrq_u8(
+        vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('-')), vceqq_u8(bytes, vdupq_n_u8('_'))),
+        vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('.')), vceqq_u8(bytes, vdupq_n_u8('~'))));
+    uint8x16_t const reserved = vmvnq_u8(vorrq_u8(vorrq_u8(letters, digits), marks));
+    // As in _az_span_find_neon(), narrowing leaves one nibble per position.
+    uint64_t const mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(reserved), 4)), 0);
+    if (mask != 0)
+    {
+      return i + _az_simd_lowest_bit_index(mask) / 4;
+    }
   }
+
+  return i;
+}
+
+#endif // _az_SIMD_NEON
+
+#endif // _az_SIMD
+
+/*
+ * Returns the number of bytes at the start of `source`, which has `size` bytes, that are not
+ * percent-encoded. When a SIMD instruction set is available, they are first counted one block at a
+ * time, by the kernel of the host.
+ */
+static AZ_NODISCARD int32_t
+_az_span_url_unreserved_prefix_size(uint8_t const* source, int32_t size)
+{
+  int32_t i = 0;
+
+#ifdef _az_SIMD
+  i = _az_simd_get_kernels()->span_url_unreserved_prefix(source, size);
+#endif // _az_SIMD
+
+  while (i < size && _az_span_url_unreserved[source[i]])
+  {
+    i++;
+  }
+
+  return i;
 }
 
 AZ_NODISCARD int32_t _az_span_url_encode_calc_length(az_span source)
@@ -913,14 +2068,13 @@ AZ_NODISCARD int32_t _az_span_url_encode_calc_length(az_span source)
   uint8_t const* const src_ptr = az_span_ptr(source);
 
   int32_t encoded_length = source_size;
-  for (int32_t i = 0; i < source_size; i++)
+  int32_t i = _az_span_url_unreserved_prefix_size(src_ptr, source_size);
+  while (i < source_size)
   {
-    uint8_t c = src_ptr[i];
-    if (_az_span_url_should_encode(c))
-    {
-      // Adding '%' plus 2 digits (minus 1 as original symbol is counted as 1)
-      encoded_length += 2;
-    }
+    // Adding '%' plus 2 digits (minus 1 as original symbol is counted as 1)
+    encoded_length += 2;
+    i++;
+    i += _az_span_url_unreserved_prefix_size(src_ptr + i, source_size - i);
   }
 
   // If source_size is 0, this will return 0.
@@ -943,19 +2097,29 @@ AZ_NODISCARD az_result _az_span_url_encode(az_span destination, az_span source,
   uint8_t* const src_ptr = az_span_ptr(source);
   uint8_t* dest_ptr = dest_begin;
 
-  for (int32_t i = 0; i < source_size; i++)
+  // Runs of bytes which are not encoded are copied at once. Without precondition checking, the
+  // spans may overlap, and then the source is read one byte at a time, after each write, as it
+  // always was.
+  bool const overlap = _az_span_overlap(destination, source);
+
+  int32_t i = 0;
+  while (i < source_size)
   {
-    uint8_t c = src_ptr[i];
-    if (!_az_span_url_should_encode(c))
+    int32_t run = overlap ? _az_span_url_unreserved[src_ptr[i]]
+                          : _az_span_url_unreserved_prefix_size(src_ptr + i, source_size - i);
+    if (run > 0)
     {
-      if (dest_ptr >= dest_end)
+      int32_t const available = (int32_t)(dest_end - dest_ptr);
+      if (run > available)
       {
+        memmove(dest_ptr, src_ptr + i, (size_t)available);
         *out_length = 0;
         return AZ_ERROR_NOT_ENOUGH_SPACE;
       }
 
-      *dest_ptr = c;
-      ++dest_ptr;
+      memmove(dest_ptr, src_ptr + i, (size_t)run);
+      dest_ptr += run;
+      i += run;
     }
     else
     {
@@ -965,10 +2129,12 @@ AZ_NODISCARD az_result _az_span_url_encode(az_span destination, az_span source,
         return AZ_ERROR_NOT_ENOUGH_SPACE;
       }
 
+      uint8_t const c = src_ptr[i];
       dest_ptr[0] = '%';
       dest_ptr[1] = _az_number_to_upper_hex(c >> 4);
       dest_ptr[2] = _az_number_to_upper_hex(c & 0x0F);
       dest_ptr += 3;
+      i++;
     }
   }
 
@@ -976,6 +2142,171 @@ AZ_NODISCARD az_result _az_span_url_encode(az_span destination, az_span source,
   return AZ_OK;
 }
 
+void _az_span_builder_init(_az_span_builder* builder, az_span buffer)
+{
+  _az_span_builder_init_segmented(builder, buffer, NULL, 0);
+}
+
+void _az_span_builder_init_segmented(
+    _az_span_builder* builder,
+    az_span buffer,
+    az_span* segments,
+    int32_t segments_capacity)
+{
+  _az_PRECONDITION_NOT_NULL(builder);
+  _az_PRECONDITION(segments_capacity >= 0);
+  _az_PRECONDITION(segments != NULL || segments_capacity == 0);
+
+  *builder = (_az_span_builder){
+    .buffer = buffer,
+    .segments = segments,
+    .segments_capacity = segments_capacity,
+    .segment_count = 0,
+    .buffer_length = 0,
+    .length = 0,
+    .overflowed = false,
+  };
+}
+
+// Adds `size` bytes at `ptr` to the segments, extending the last one when they follow it.
+static AZ_NODISCARD bool
+_az_span_builder_add_segment(_az_span_builder* builder, uint8_t* ptr, int32_t size)
+{
+  if (builder->segment_count > 0)
+  {
+    az_span* const last = &builder->segments[builder->segment_count - 1];
+    if (az_span_ptr(*last) + az_span_size(*last) == ptr)
+    {
+      *last = az_span_create(az_span_ptr(*last), az_span_size(*last) + size);
+      return true;
+    }
+  }
+
+  if (builder->segment_count == builder->segments_capacity)
+  {
+    return false;
+  }
+
+  builder->segments[builder->segment_count] = az_span_create(ptr, size);
+  builder->segment_count++;
+  return true;
+}
+
+// Returns where the next `size` bytes of the text are written in the buffer, or NULL once the text
+// no longer fits.
+static AZ_NODISCARD uint8_t* _az_span_builder_reserve(_az_span_builder* builder, int32_t size)
+{
+  builder->length += size;
+  if (builder->overflowed || size > az_span_size(builder->buffer) - builder->buffer_length)
+  {
+    builder->overflowed = true;
+    return NULL;
+  }
+
+  uint8_t* const ptr = az_span_ptr(builder->buffer) + builder->buffer_length;
+  builder->buffer_length += size;
+
+  if (builder->segments != NULL && !_az_span_builder_add_segment(builder, ptr, size))
+  {
+    builder->overflowed = true;
+    return NULL;
+  }
+
+  return ptr;
+}
+
+void _az_span_builder_append(_az_span_builder* builder, az_span source)
+{
+  _az_PRECONDITION_NOT_NULL(builder);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+
+  int32_t const size = az_span_size(source);
+  if (size == 0)
+  {
+    return;
+  }
+
+  if (builder->segments != NULL)
+  {
+    builder->length += size;
+    if (!builder->overflowed
+        && !_az_span_builder_add_segment(builder, az_span_ptr(source), size))
+    {
+      builder->overflowed = true;
+    }
+    return;
+  }
+
+  uint8_t* const ptr = _az_span_builder_reserve(builder, size);
+  if (ptr != NULL)
+  {
+    memcpy(ptr, az_span_ptr(source), (size_t)size);
+  }
+}
+
+void _az_span_builder_append_u8(_az_span_builder* builder, uint8_t byte)
+{
+  _az_PRECONDITION_NOT_NULL(builder);
+
+  uint8_t* const ptr = _az_span_builder_reserve(builder, 1);
+  if (ptr != NULL)
+  {
+    *ptr = byte;
+  }
+}
+
+void _az_span_builder_append_u32(_az_span_builder* builder, uint32_t value)
+{
+  _az_PRECONDITION_NOT_NULL(builder);
+
+  int32_t const digit_count = _az_span_u32_digit_count(value);
+  uint8_t* const ptr = _az_span_builder_reserve(builder, digit_count);
+  if (ptr != NULL)
+  {
+    az_span remainder;
+    az_result const result = az_span_u32toa(az_span_create(ptr, digit_count), value, &remainder);
+    _az_PRECONDITION(az_result_succeeded(result));
+    (void)result;
+  }
+}
+
+void _az_span_builder_append_u64(_az_span_builder* builder, uint64_t value)
+{
+  _az_PRECONDITION_NOT_NULL(builder);
+
+  int32_t const digit_count = _az_span_u64_digit_count(value);
+  uint8_t* const ptr = _az_span_builder_reserve(builder, digit_count);
+  if (ptr != NULL)
+  {
+    az_span remainder;
+    az_result const result = az_span_u64toa(az_span_create(ptr, digit_count), value, &remainder);
+    _az_PRECONDITION(az_result_succeeded(result));
+    (void)result;
+  }
+}
+
+void _az_span_builder_append_url_encoded(_az_span_builder* builder, az_span source)
+{
+  _az_PRECONDITION_NOT_NULL(builder);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+
+  if (az_span_size(source) == 0)
+  {
+    return;
+  }
+
+  int32_t const encoded_length = _az_span_url_encode_calc_length(source);
+  uint8_t* const ptr = _az_span_builder_reserve(builder, encoded_length);
+  if (ptr != NULL)
+  {
+    int32_t written = 0;
+    az_result const result
+        = _az_span_url_encode(az_span_create(ptr, encoded_length), source, &written);
+    _az_PRECONDITION(az_result_succeeded(result) && written == encoded_length);
+    (void)result;
+  }
+}
+
 az_span _az_span_token(
     az_span source,
     az_span delimiter,
@@ -999,3 +2330,30 @@ az_span _az_span_token(
   *out_remainder = AZ_SPAN_EMPTY;
   return source;
 }
+
+AZ_NODISCARD az_result
+az_span_arena_allocate(az_span_arena* ref_arena, int32_t size, az_span* out_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(ref_arena);
+  _az_PRECONDITION(size >= 0);
+  _az_PRECONDITION_NOT_NULL(out_buffer);
+
+  az_span const buffer = ref_arena->_internal.buffer;
+  int32_t const used = ref_arena->_internal.used;
+
+  // The padding is computed from the address, since the arena's buffer may not be aligned itself.
+  uintptr_t const address = (uintptr_t)(az_span_ptr(buffer) + used);
+  int32_t const padding
+      = (int32_t)((AZ_SPAN_ARENA_ALIGNMENT - (address % AZ_SPAN_ARENA_ALIGNMENT))
+                  % AZ_SPAN_ARENA_ALIGNMENT);
+
+  int32_t const available = az_span_size(buffer) - used;
+  if (padding > available || size > available - padding)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  *out_buffer = az_span_slice(buffer, used + padding, used + padding + size);
+  ref_arena->_internal.used = used + padding + size;
+  return AZ_OK;
+}
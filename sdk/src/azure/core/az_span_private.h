@@ -13,6 +13,10 @@
 
 #include <azure/core/_az_cfg_prefix.h>
 
+// The maximum integer value that can be stored in a double without losing precision (2^53 - 1)
+// An IEEE 64-bit double has 52 bits of mantissa
+#define _az_MAX_SAFE_INTEGER 9007199254740991
+
 enum
 {
   _az_ASCII_LOWER_DIF = 'a' - 'A',
@@ -37,6 +41,9 @@ enum
 
   // Two digit length to create the "format" passed to sscanf.
   _az_MAX_SIZE_FOR_PARSING_DOUBLE = 99,
+
+  // 17 significant digits + sign + "0." + 5 leading zeros (i.e. -0.000001234567890123456)
+  _az_MAX_SIZE_FOR_WRITING_SHORTEST_DOUBLE = 25,
 };
 
 /**
@@ -67,6 +74,47 @@ AZ_NODISCARD AZ_INLINE bool _az_isfinite(double value)
   return ((binary_value & 0x7FF0000000000000) != 0x7FF0000000000000);
 }
 
+/**
+ * @brief Incrementally parses decimal numbers, such as `-12.5e3`, whose significant digits and
+ * exponent are small enough for the value to be converted exactly with a single floating point
+ * multiplication or division. The number can be fed in several pieces, as they appear in the
+ * buffers of a multisegment JSON token.
+ */
+typedef struct
+{
+  struct
+  {
+    uint64_t significand;
+    int32_t significant_digits;
+    int32_t fractional_digits;
+    int32_t exponent;
+    int32_t state;
+    bool is_negative;
+    bool is_exponent_negative;
+  } _internal;
+} _az_span_double_parser;
+
+/**
+ * @brief Initializes a #_az_span_double_parser to parse a new number.
+ */
+void _az_span_double_parser_init(_az_span_double_parser* out_parser);
+
+/**
+ * @brief Feeds the next bytes of the number to the \p ref_parser.
+ */
+void _az_span_double_parser_append(_az_span_double_parser* ref_parser, az_span source);
+
+/**
+ * @brief Gets the value of the number fed to the \p ref_parser.
+ *
+ * @return `true` if the value was converted exactly. `false` if the number is not well-formed, or
+ * needs more digits or a larger exponent than the fast path supports, in which case the caller
+ * should fall back to the slower, general conversion.
+ */
+AZ_NODISCARD bool _az_span_double_parser_get_value(
+    _az_span_double_parser const* parser,
+    double* out_value);
+
 AZ_NODISCARD az_result _az_is_expected_span(az_span* ref_span, az_span expected);
 
 /**
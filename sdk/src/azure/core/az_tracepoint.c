@@ -0,0 +1,30 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_tracepoint.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
+
+#include <azure/core/_az_cfg.h>
+
+#if defined(AZ_TRACEPOINTS) && defined(_WIN32)
+
+// {12a9f918-6ff4-4e97-ba5b-c9ad05a574aa}
+TRACELOGGING_DEFINE_PROVIDER(
+    _az_tracepoint_provider,
+    "Azure.SDK.C",
+    (0x12a9f918, 0x6ff4, 0x4e97, 0xba, 0x5b, 0xc9, 0xad, 0x05, 0xa5, 0x74, 0xaa));
+
+AZ_NODISCARD az_result az_tracepoint_register(void)
+{
+  return SUCCEEDED(TraceLoggingRegister(_az_tracepoint_provider)) ? AZ_OK : AZ_ERROR_OUT_OF_MEMORY;
+}
+
+void az_tracepoint_unregister(void) { TraceLoggingUnregister(_az_tracepoint_provider); }
+
+#else
+
+AZ_NODISCARD az_result az_tracepoint_register(void) { return AZ_OK; }
+
+void az_tracepoint_unregister(void) {}
+
+#endif // AZ_TRACEPOINTS
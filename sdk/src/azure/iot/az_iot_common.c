@@ -3,11 +3,13 @@
 
 #include <stdint.h>
 
+#include <azure/core/az_crypto.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 #include <azure/iot/az_iot_common.h>
 #include <azure/iot/internal/az_iot_common_internal.h>
 
@@ -31,6 +33,9 @@ AZ_NODISCARD az_result az_iot_message_properties_init(
   properties->_internal.properties_buffer = buffer;
   properties->_internal.properties_written = written_length;
   properties->_internal.current_property_index = 0;
+  properties->_internal.index = NULL;
+  properties->_internal.index_capacity = 0;
+  properties->_internal.index_count = 0;
 
   return AZ_OK;
 }
@@ -66,9 +71,63 @@ az_iot_message_properties_append(az_iot_message_properties* properties, az_span
 
   properties->_internal.properties_written += required_length;
 
+  az_iot_message_property* const index = properties->_internal.index;
+  if (index != NULL)
+  {
+    // The name and value are the last bytes written, right before the end of the properties.
+    az_span const buffer = properties->_internal.properties_buffer;
+    int32_t const value_start = properties->_internal.properties_written - az_span_size(value);
+    int32_t const name_start = value_start - 1 - az_span_size(name);
+    int32_t const count = properties->_internal.index_count;
+
+    if (count < properties->_internal.index_capacity)
+    {
+      index[count].name = az_span_slice(buffer, name_start, value_start - 1);
+      index[count].value
+          = az_span_slice(buffer, value_start, properties->_internal.properties_written);
+      properties->_internal.index_count++;
+    }
+    else
+    {
+      // Fall back to scanning, which tracks the iteration as a byte offset instead.
+      uint32_t const entry = properties->_internal.current_property_index;
+      properties->_internal.current_property_index = entry < (uint32_t)count
+          ? (uint32_t)(az_span_ptr(index[entry].name) - az_span_ptr(buffer))
+          : (uint32_t)name_start;
+      properties->_internal.index = NULL;
+    }
+  }
+
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result
+az_iot_message_properties_append_cbor_content_type(az_iot_message_properties* properties)
+{
+  _az_PRECONDITION_NOT_NULL(properties);
+
+  az_iot_message_properties const original = *properties;
+
+  az_result result = az_iot_message_properties_append(
+      properties,
+      AZ_SPAN_FROM_STR(AZ_IOT_MESSAGE_PROPERTIES_CONTENT_TYPE),
+      AZ_SPAN_FROM_STR(AZ_IOT_MESSAGE_CONTENT_TYPE_CBOR));
+  if (az_result_succeeded(result))
+  {
+    result = az_iot_message_properties_append(
+        properties,
+        AZ_SPAN_FROM_STR(AZ_IOT_MESSAGE_PROPERTIES_CONTENT_ENCODING),
+        AZ_SPAN_FROM_STR("utf-8"));
+  }
+
+  if (az_result_failed(result))
+  {
+    *properties = original;
+  }
+
+  return result;
+}
+
 AZ_NODISCARD az_result az_iot_message_properties_find(
     az_iot_message_properties* properties,
     az_span name,
@@ -78,6 +137,20 @@ AZ_NODISCARD az_result az_iot_message_properties_find(
   _az_PRECONDITION_VALID_SPAN(name, 1, false);
   _az_PRECONDITION_NOT_NULL(out_value);
 
+  if (properties->_internal.index != NULL)
+  {
+    for (int32_t i = 0; i < properties->_internal.index_count; i++)
+    {
+      if (az_span_is_content_equal(properties->_internal.index[i].name, name))
+      {
+        *out_value = properties->_internal.index[i].value;
+        return AZ_OK;
+      }
+    }
+
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
   az_span remaining = az_span_slice(
       properties->_internal.properties_buffer, 0, properties->_internal.properties_written);
 
@@ -103,6 +176,61 @@ AZ_NODISCARD az_result az_iot_message_properties_find(
   return AZ_ERROR_ITEM_NOT_FOUND;
 }
 
+AZ_NODISCARD az_result az_iot_message_properties_build_index(
+    az_iot_message_properties* properties,
+    az_iot_message_property* index,
+    int32_t index_capacity)
+{
+  _az_PRECONDITION_NOT_NULL(properties);
+  _az_PRECONDITION_NOT_NULL(index);
+  _az_PRECONDITION(index_capacity > 0);
+
+  properties->_internal.index = NULL;
+
+  az_span remaining = az_span_slice(
+      properties->_internal.properties_buffer, 0, properties->_internal.properties_written);
+  int32_t const iteration_offset = (int32_t)properties->_internal.current_property_index;
+  int32_t iteration_entry = 0;
+  int32_t count = 0;
+
+  // Tokenize exactly like the scanning find does, so both paths agree on every buffer.
+  while (az_span_size(remaining) != 0)
+  {
+    int32_t token_index = 0;
+    az_span name
+        = _az_span_token(remaining, hub_client_param_equals_span, &remaining, &token_index);
+    if (token_index == -1)
+    {
+      break;
+    }
+
+    if (count == index_capacity)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    // Carry over the position of an iteration in progress, which is a byte offset without an
+    // index and an entry number with one.
+    if (az_span_ptr(name) - az_span_ptr(properties->_internal.properties_buffer)
+        < iteration_offset)
+    {
+      iteration_entry++;
+    }
+
+    index[count].name = name;
+    index[count].value
+        = _az_span_token(remaining, hub_client_param_separator_span, &remaining, &token_index);
+    count++;
+  }
+
+  properties->_internal.index = index;
+  properties->_internal.index_capacity = index_capacity;
+  properties->_internal.index_count = count;
+  properties->_internal.current_property_index = (uint32_t)iteration_entry;
+
+  return AZ_OK;
+}
+
 AZ_NODISCARD az_result az_iot_message_properties_next(
     az_iot_message_properties* properties,
     az_span* out_name,
@@ -112,6 +240,22 @@ AZ_NODISCARD az_result az_iot_message_properties_next(
   _az_PRECONDITION_NOT_NULL(out_name);
   _az_PRECONDITION_NOT_NULL(out_value);
 
+  if (properties->_internal.index != NULL)
+  {
+    uint32_t const entry = properties->_internal.current_property_index;
+    if (entry == (uint32_t)properties->_internal.index_count)
+    {
+      *out_name = AZ_SPAN_EMPTY;
+      *out_value = AZ_SPAN_EMPTY;
+      return AZ_ERROR_IOT_END_OF_PROPERTIES;
+    }
+
+    *out_name = properties->_internal.index[entry].name;
+    *out_value = properties->_internal.index[entry].value;
+    properties->_internal.current_property_index = entry + 1;
+    return AZ_OK;
+  }
+
   int32_t index = (int32_t)properties->_internal.current_property_index;
   int32_t prop_length = properties->_internal.properties_written;
 
@@ -134,8 +278,10 @@ AZ_NODISCARD az_result az_iot_message_properties_next(
   }
   else
   {
+    // The remainder ends at the written length rather than at the end of the buffer, so it isn't
+    // a suffix of the buffer and _az_span_diff() can't be used.
     properties->_internal.current_property_index
-        = (uint32_t)(_az_span_diff(remainder, properties->_internal.properties_buffer));
+        = (uint32_t)(az_span_ptr(remainder) - az_span_ptr(properties->_internal.properties_buffer));
   }
 
   return AZ_OK;
@@ -176,44 +322,131 @@ AZ_NODISCARD int32_t az_iot_calculate_retry_delay(
   return delay > 0 ? delay : 0;
 }
 
-AZ_NODISCARD int32_t _az_iot_u32toa_size(uint32_t number)
+// Any value but 0 can seed xorshift.
+#define _az_IOT_RETRY_DEFAULT_RANDOM_SEED 2463534242u
+
+AZ_NODISCARD az_iot_retry_options az_iot_retry_options_default()
+{
+  return (az_iot_retry_options){
+    .jitter = AZ_IOT_RETRY_JITTER_FULL,
+    .min_retry_delay_msec = 1000,
+    .max_retry_delay_msec = 100000,
+    .throttled_min_retry_delay_msec = 10000,
+    .random_seed = 0,
+    .random_callback = NULL,
+    .random_user_context = NULL,
+  };
+}
+
+void az_iot_retry_init(az_iot_retry* retry, az_iot_retry_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(retry);
+
+  retry->_internal.options = options == NULL ? az_iot_retry_options_default() : *options;
+
+  _az_PRECONDITION_RANGE(0, retry->_internal.options.min_retry_delay_msec, INT32_MAX - 1);
+  _az_PRECONDITION_RANGE(
+      retry->_internal.options.min_retry_delay_msec,
+      retry->_internal.options.max_retry_delay_msec,
+      INT32_MAX - 1);
+  _az_PRECONDITION_RANGE(0, retry->_internal.options.throttled_min_retry_delay_msec, INT32_MAX - 1);
+
+  uint32_t const seed = retry->_internal.options.random_seed;
+  retry->_internal.random_state = seed == 0 ? _az_IOT_RETRY_DEFAULT_RANDOM_SEED : seed;
+  az_iot_retry_reset(retry);
+}
+
+void az_iot_retry_reset(az_iot_retry* retry)
 {
-  if (number == 0)
+  _az_PRECONDITION_NOT_NULL(retry);
+
+  retry->_internal.previous_delay_msec = 0;
+  retry->_internal.attempt = 0;
+  retry->_internal.is_throttled = false;
+}
+
+AZ_NODISCARD bool az_iot_retry_next_delay(
+    az_iot_retry* retry,
+    az_iot_status status,
+    int32_t operation_msec,
+    int32_t* out_delay_msec)
+{
+  _az_PRECONDITION_NOT_NULL(retry);
+  _az_PRECONDITION_RANGE(0, operation_msec, INT32_MAX - 1);
+  _az_PRECONDITION_NOT_NULL(out_delay_msec);
+
+  if (status != AZ_IOT_STATUS_UNKNOWN && !az_iot_status_retriable(status))
   {
-    return 1;
+    return false;
   }
-  else
+
+  if (_az_LOG_SHOULD_WRITE(AZ_LOG_IOT_RETRY))
   {
-    uint32_t div = 1000000000;
-    int32_t digit_count = 10;
-    while (number / div == 0)
-    {
-      div /= 10;
-      digit_count--;
-    }
+    _az_LOG_WRITE(AZ_LOG_IOT_RETRY, AZ_SPAN_EMPTY);
+  }
+
+  az_iot_retry_options const* options = &retry->_internal.options;
 
-    return digit_count;
+  // Once throttled, stay away longer until the operation succeeds, since the hub is overloaded.
+  if (status == AZ_IOT_STATUS_THROTTLED)
+  {
+    retry->_internal.is_throttled = true;
   }
-}
 
-AZ_NODISCARD int32_t _az_iot_u64toa_size(uint64_t number)
-{
-  if (number == 0)
+  int32_t min_delay_msec = options->min_retry_delay_msec;
+  if (retry->_internal.is_throttled && options->throttled_min_retry_delay_msec > min_delay_msec)
+  {
+    min_delay_msec = options->throttled_min_retry_delay_msec < options->max_retry_delay_msec
+        ? options->throttled_min_retry_delay_msec
+        : options->max_retry_delay_msec;
+  }
+
+  uint32_t const random = options->random_callback != NULL
+      ? options->random_callback(options->random_user_context)
+      : _az_retry_next_random(&retry->_internal.random_state);
+
+  int32_t delay = 0;
+  if (options->jitter == AZ_IOT_RETRY_JITTER_DECORRELATED)
   {
-    return 1;
+    int32_t const previous_delay_msec = retry->_internal.previous_delay_msec > min_delay_msec
+        ? retry->_internal.previous_delay_msec
+        : min_delay_msec;
+    delay = _az_retry_calc_decorrelated_delay(
+        random, previous_delay_msec, min_delay_msec, options->max_retry_delay_msec);
   }
   else
   {
-    uint64_t div = 10000000000000000000ul;
-    int32_t digit_count = 20;
-    while (number / div == 0)
+    // Shifting a 31-bit delay by up to 32 bits can't overflow 64 bits.
+    int32_t const shift = retry->_internal.attempt < 32 ? retry->_internal.attempt : 32;
+    int64_t upper = (int64_t)min_delay_msec << shift;
+    if (upper > options->max_retry_delay_msec)
     {
-      div /= 10;
-      digit_count--;
+      upper = options->max_retry_delay_msec;
     }
 
-    return digit_count;
+    uint32_t const range = (uint32_t)(upper - min_delay_msec) + 1;
+    delay = min_delay_msec + (int32_t)(random % range);
   }
+
+  retry->_internal.previous_delay_msec = delay;
+  if (retry->_internal.attempt < INT16_MAX)
+  {
+    retry->_internal.attempt++;
+  }
+
+  delay -= operation_msec;
+  *out_delay_msec = delay > 0 ? delay : 0;
+  return true;
+}
+
+AZ_NODISCARD int32_t _az_iot_u32toa_size(uint32_t number)
+{
+  return _az_span_u32_digit_count(number);
+}
+
+AZ_NODISCARD int32_t _az_iot_u64toa_size(uint64_t number)
+{
+  return _az_span_u64_digit_count(number);
 }
 
 AZ_NODISCARD az_result
@@ -224,3 +457,228 @@ _az_span_copy_url_encode(az_span destination, az_span source, az_span* out_remai
   *out_remainder = az_span_slice(destination, length, az_span_size(destination));
   return AZ_OK;
 }
+
+static AZ_NODISCARD az_result _az_iot_sas_compute(
+    az_span base64_shared_access_key,
+    az_span signature,
+    az_span key_buffer,
+    az_span base64_hmac_sha256_signature,
+    az_span* out_base64_hmac_sha256_signature)
+{
+  int32_t key_size = 0;
+  _az_RETURN_IF_FAILED(az_base64_decode(key_buffer, base64_shared_access_key, &key_size));
+  az_span const key = az_span_slice(key_buffer, 0, key_size);
+
+  uint8_t hmac[AZ_CRYPTO_SHA256_SIZE];
+  az_result const result = az_crypto_hmac_sha256(key, signature, AZ_SPAN_FROM_BUFFER(hmac));
+  az_span_fill(key, 0);
+  _az_RETURN_IF_FAILED(result);
+
+  int32_t written = 0;
+  _az_RETURN_IF_FAILED(
+      az_base64_encode(base64_hmac_sha256_signature, AZ_SPAN_FROM_BUFFER(hmac), &written));
+  *out_base64_hmac_sha256_signature = az_span_slice(base64_hmac_sha256_signature, 0, written);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result _az_iot_sas_sign(
+    az_span base64_shared_access_key,
+    az_span signature,
+    az_span key_buffer,
+    az_span base64_hmac_sha256_signature,
+    az_span* out_base64_hmac_sha256_signature)
+{
+  _az_TRACEPOINT1(iot_sas_sign_entry, az_span_size(signature));
+  az_result const result = _az_iot_sas_compute(
+      base64_shared_access_key,
+      signature,
+      key_buffer,
+      base64_hmac_sha256_signature,
+      out_base64_hmac_sha256_signature);
+  _az_TRACEPOINT1(iot_sas_sign_exit, result);
+
+  return result;
+}
+
+// Request IDs are consecutive, so the low bits of the pending ones rarely collide.
+AZ_INLINE int32_t _az_iot_pending_request_home_slot(
+    az_iot_pending_request_table const* table,
+    uint32_t request_id)
+{
+  return (int32_t)(request_id & (uint32_t)(table->_internal.slot_count - 1));
+}
+
+// Returns the slot which holds the request, or the empty slot which ends its probe sequence.
+static AZ_NODISCARD int32_t
+_az_iot_pending_request_probe(az_iot_pending_request_table const* table, uint32_t request_id)
+{
+  int32_t const mask = table->_internal.slot_count - 1;
+  int32_t slot = _az_iot_pending_request_home_slot(table, request_id);
+
+  // One slot is always empty, so an empty slot always ends the probe sequence.
+  while (table->_internal.slots[slot]._internal.request_id != 0
+         && table->_internal.slots[slot]._internal.request_id != request_id)
+  {
+    slot = (slot + 1) & mask;
+  }
+
+  return slot;
+}
+
+// Empties a slot, and moves the requests which follow it back, so that no probe sequence goes
+// through an empty slot.
+static void _az_iot_pending_request_remove(az_iot_pending_request_table* table, int32_t slot)
+{
+  az_iot_pending_request* slots = table->_internal.slots;
+  int32_t const mask = table->_internal.slot_count - 1;
+
+  int32_t next = slot;
+  while (true)
+  {
+    next = (next + 1) & mask;
+    if (slots[next]._internal.request_id == 0)
+    {
+      break;
+    }
+
+    // The request can move to the empty slot unless its home slot is after it, cyclically.
+    int32_t const home = _az_iot_pending_request_home_slot(table, slots[next]._internal.request_id);
+    if (((next - home) & mask) >= ((next - slot) & mask))
+    {
+      slots[slot] = slots[next];
+      slot = next;
+    }
+  }
+
+  slots[slot]._internal.request_id = 0;
+  slots[slot]._internal.user_context = NULL;
+  table->_internal.request_count--;
+}
+
+AZ_NODISCARD az_result az_iot_pending_request_table_init(
+    az_iot_pending_request_table* table,
+    az_iot_pending_request* slots,
+    int32_t slot_count)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+  _az_PRECONDITION_NOT_NULL(slots);
+  _az_PRECONDITION(slot_count >= 2);
+  _az_PRECONDITION((slot_count & (slot_count - 1)) == 0);
+
+  table->_internal.slots = slots;
+  table->_internal.slot_count = slot_count;
+  table->_internal.request_count = 0;
+  table->_internal.last_request_id = 0;
+
+  for (int32_t i = 0; i < slot_count; i++)
+  {
+    slots[i]._internal.request_id = 0;
+    slots[i]._internal.expiration_msec = 0;
+    slots[i]._internal.user_context = NULL;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_pending_request_table_add(
+    az_iot_pending_request_table* table,
+    int64_t expiration_msec,
+    void* user_context,
+    az_span request_id_buffer,
+    az_span* out_request_id)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+  _az_PRECONDITION_VALID_SPAN(request_id_buffer, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_request_id);
+
+  if (table->_internal.request_count == table->_internal.slot_count - 1)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  // 0 marks the empty slots, and an ID still pending once the IDs wrap around is skipped.
+  uint32_t request_id = table->_internal.last_request_id;
+  int32_t slot;
+  do
+  {
+    request_id++;
+    if (request_id == 0)
+    {
+      request_id = 1;
+    }
+    slot = _az_iot_pending_request_probe(table, request_id);
+  } while (table->_internal.slots[slot]._internal.request_id != 0);
+
+  az_span remainder = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_span_u32toa(request_id_buffer, request_id, &remainder));
+
+  table->_internal.last_request_id = request_id;
+  table->_internal.slots[slot]._internal.request_id = request_id;
+  table->_internal.slots[slot]._internal.expiration_msec = expiration_msec;
+  table->_internal.slots[slot]._internal.user_context = user_context;
+  table->_internal.request_count++;
+
+  *out_request_id
+      = az_span_slice(request_id_buffer, 0, _az_span_diff(remainder, request_id_buffer));
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_pending_request_table_complete(
+    az_iot_pending_request_table* table,
+    az_span request_id,
+    void** out_user_context)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+  _az_PRECONDITION_VALID_SPAN(request_id, 0, true);
+
+  // The IDs this table generates are numbers without leading zeros.
+  uint32_t number = 0;
+  if (az_span_size(request_id) == 0 || az_span_ptr(request_id)[0] == '0'
+      || az_result_failed(az_span_atou32(request_id, &number)))
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  int32_t const slot = _az_iot_pending_request_probe(table, number);
+  if (table->_internal.slots[slot]._internal.request_id == 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  if (out_user_context != NULL)
+  {
+    *out_user_context = table->_internal.slots[slot]._internal.user_context;
+  }
+
+  _az_iot_pending_request_remove(table, slot);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_pending_request_table_expire(
+    az_iot_pending_request_table* table,
+    int64_t now_msec,
+    void** out_user_context)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+
+  if (table->_internal.request_count > 0)
+  {
+    for (int32_t slot = 0; slot < table->_internal.slot_count; slot++)
+    {
+      az_iot_pending_request const* request = &table->_internal.slots[slot];
+      if (request->_internal.request_id != 0 && request->_internal.expiration_msec <= now_msec)
+      {
+        if (out_user_context != NULL)
+        {
+          *out_user_context = request->_internal.user_context;
+        }
+
+        _az_iot_pending_request_remove(table, slot);
+        return AZ_OK;
+      }
+    }
+  }
+
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
@@ -6,11 +6,14 @@
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
 #include <azure/core/az_version.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 #include <azure/iot/az_iot_hub_client.h>
 #include <azure/iot/internal/az_iot_common_internal.h>
+#include <azure/iot/internal/az_iot_hub_client_internal.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -26,13 +29,29 @@ static const az_span hub_service_preview_api_version
 static const az_span client_sdk_version
     = AZ_SPAN_LITERAL_FROM_STR("DeviceClientType=c%2F" AZ_SDK_VERSION_STRING);
 
+static const az_span hub_c2d_topic_prefix = AZ_SPAN_LITERAL_FROM_STR("devices/");
+#ifndef AZ_NO_IOT_HUB_METHODS
+static const az_span hub_methods_topic_prefix = AZ_SPAN_LITERAL_FROM_STR("$iothub/methods/");
+#endif // AZ_NO_IOT_HUB_METHODS
+#ifndef AZ_NO_IOT_HUB_TWIN
+static const az_span hub_twin_topic_prefix = AZ_SPAN_LITERAL_FROM_STR("$iothub/twin/");
+#endif // AZ_NO_IOT_HUB_TWIN
+
 AZ_NODISCARD az_iot_hub_client_options az_iot_hub_client_options_default()
 {
-  return (az_iot_hub_client_options){ .module_id = AZ_SPAN_EMPTY,
-                                      .user_agent = client_sdk_version,
-                                      .model_id = AZ_SPAN_EMPTY };
+  return (az_iot_hub_client_options){
+#ifndef AZ_NO_IOT_HUB_MODULE_ID
+    .module_id = AZ_SPAN_EMPTY,
+#endif // AZ_NO_IOT_HUB_MODULE_ID
+    .user_agent = client_sdk_version,
+#ifndef AZ_NO_IOT_HUB_MODEL_ID
+    .model_id = AZ_SPAN_EMPTY,
+#endif // AZ_NO_IOT_HUB_MODEL_ID
+    .topic_prefix_buffer = AZ_SPAN_EMPTY,
+  };
 }
 
+#ifndef AZ_IOT_HUB_LEAN_CLIENT
 AZ_NODISCARD az_result az_iot_hub_client_init(
     az_iot_hub_client* client,
     az_span iot_hub_hostname,
@@ -46,9 +65,59 @@ AZ_NODISCARD az_result az_iot_hub_client_init(
   client->_internal.iot_hub_hostname = iot_hub_hostname;
   client->_internal.device_id = device_id;
   client->_internal.options = options == NULL ? az_iot_hub_client_options_default() : *options;
+  client->_internal.telemetry_topic_prefix = AZ_SPAN_EMPTY;
+
+  az_span const prefix_buffer = client->_internal.options.topic_prefix_buffer;
+  if (az_span_size(prefix_buffer) > 0)
+  {
+    // Without properties, the telemetry topic is exactly the per-device prefix, so build it once
+    // here and let every later call copy it in one go.
+    size_t prefix_length = 0;
+    _az_RETURN_IF_FAILED(az_iot_hub_client_telemetry_get_publish_topic(
+        client,
+        NULL,
+        (char*)az_span_ptr(prefix_buffer),
+        (size_t)az_span_size(prefix_buffer),
+        &prefix_length));
+    client->_internal.telemetry_topic_prefix
+        = az_span_slice(prefix_buffer, 0, (int32_t)prefix_length);
+  }
 
   return AZ_OK;
 }
+#endif // AZ_IOT_HUB_LEAN_CLIENT
+
+void az_iot_hub_client_shared_init(
+    az_iot_hub_client_shared* shared,
+    az_span iot_hub_hostname,
+    az_iot_hub_client_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(shared);
+  _az_PRECONDITION_VALID_SPAN(iot_hub_hostname, 1, false);
+  _az_PRECONDITION(options == NULL || az_span_size(options->topic_prefix_buffer) == 0);
+
+  shared->_internal.iot_hub_hostname = iot_hub_hostname;
+  shared->_internal.options = options == NULL ? az_iot_hub_client_options_default() : *options;
+}
+
+void az_iot_hub_client_init_shared(
+    az_iot_hub_client* client,
+    az_iot_hub_client_shared const* shared,
+    az_span device_id)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_NOT_NULL(shared);
+  _az_PRECONDITION_VALID_SPAN(device_id, 1, false);
+
+#ifdef AZ_IOT_HUB_LEAN_CLIENT
+  client->_internal.shared = shared;
+#else
+  client->_internal.iot_hub_hostname = shared->_internal.iot_hub_hostname;
+  client->_internal.options = shared->_internal.options;
+  client->_internal.telemetry_topic_prefix = AZ_SPAN_EMPTY;
+#endif // AZ_IOT_HUB_LEAN_CLIENT
+  client->_internal.device_id = device_id;
+}
 
 AZ_NODISCARD az_result az_iot_hub_client_get_user_name(
     az_iot_hub_client const* client,
@@ -57,85 +126,59 @@ AZ_NODISCARD az_result az_iot_hub_client_get_user_name(
     size_t* out_mqtt_user_name_length)
 {
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_user_name);
-  _az_PRECONDITION(mqtt_user_name_size > 0);
-
-  const az_span* const module_id = &(client->_internal.options.module_id);
-  const az_span* const user_agent = &(client->_internal.options.user_agent);
-  const az_span* const model_id = &(client->_internal.options.model_id);
+  _az_PRECONDITION_IOT_STRING_BUFFER(
+      mqtt_user_name, mqtt_user_name_size, out_mqtt_user_name_length);
 
-  az_span mqtt_user_name_span
-      = az_span_create((uint8_t*)mqtt_user_name, (int32_t)mqtt_user_name_size);
+  az_span const module_id = _az_iot_hub_client_get_module_id(client);
+  const az_span* const user_agent = &(_az_iot_hub_client_get_options(client)->user_agent);
+  az_span const model_id = _az_iot_hub_client_get_model_id(client);
 
-  int32_t required_length = az_span_size(client->_internal.iot_hub_hostname)
-      + az_span_size(client->_internal.device_id) + (int32_t)sizeof(hub_client_forward_slash);
-  required_length += az_span_size(*model_id) > 0 ? az_span_size(hub_service_preview_api_version)
-                                                 : az_span_size(hub_service_api_version);
-  if (az_span_size(*module_id) > 0)
-  {
-    required_length += az_span_size(*module_id) + (int32_t)sizeof(hub_client_forward_slash);
-  }
-  if (az_span_size(*user_agent) > 0)
-  {
-    required_length += az_span_size(*user_agent) + az_span_size(hub_client_param_separator_span);
-  }
-  // Note we skip the length of the model id since we have to url encode it. Bound checking is done
-  // later.
-  if (az_span_size(*model_id) > 0)
-  {
-    required_length += az_span_size(hub_client_param_separator_span)
-        + az_span_size(hub_client_param_equals_span);
-  }
-
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_user_name_span, required_length + (int32_t)sizeof(null_terminator));
-
-  az_span remainder = az_span_copy(mqtt_user_name_span, client->_internal.iot_hub_hostname);
-  remainder = az_span_copy_u8(remainder, hub_client_forward_slash);
-  remainder = az_span_copy(remainder, client->_internal.device_id);
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_user_name, (int32_t)mqtt_user_name_size));
+  _az_span_builder_append(&builder, _az_iot_hub_client_get_hostname(client));
+  _az_span_builder_append_u8(&builder, hub_client_forward_slash);
+  _az_span_builder_append(&builder, client->_internal.device_id);
 
-  if (az_span_size(*module_id) > 0)
+  if (az_span_size(module_id) > 0)
   {
-    remainder = az_span_copy_u8(remainder, hub_client_forward_slash);
-    remainder = az_span_copy(remainder, *module_id);
+    _az_span_builder_append_u8(&builder, hub_client_forward_slash);
+    _az_span_builder_append(&builder, module_id);
   }
 
-  if (az_span_size(*model_id) > 0)
-  {
-    remainder = az_span_copy(remainder, hub_service_preview_api_version);
-  }
-  else
-  {
-    remainder = az_span_copy(remainder, hub_service_api_version);
-  }
+  _az_span_builder_append(
+      &builder,
+      az_span_size(model_id) > 0 ? hub_service_preview_api_version : hub_service_api_version);
 
   if (az_span_size(*user_agent) > 0)
   {
-    remainder = az_span_copy_u8(remainder, *az_span_ptr(hub_client_param_separator_span));
-    remainder = az_span_copy(remainder, *user_agent);
+    _az_span_builder_append(&builder, hub_client_param_separator_span);
+    _az_span_builder_append(&builder, *user_agent);
   }
 
-  if (az_span_size(*model_id) > 0)
+  if (az_span_size(model_id) > 0)
   {
-    remainder = az_span_copy_u8(remainder, *az_span_ptr(hub_client_param_separator_span));
-    remainder = az_span_copy(remainder, hub_digital_twin_model_id);
-    remainder = az_span_copy_u8(remainder, *az_span_ptr(hub_client_param_equals_span));
-
-    _az_RETURN_IF_FAILED(_az_span_copy_url_encode(remainder, *model_id, &remainder));
-  }
-  if (az_span_size(remainder) > 0)
-  {
-    remainder = az_span_copy_u8(remainder, null_terminator);
+    _az_span_builder_append(&builder, hub_client_param_separator_span);
+    _az_span_builder_append(&builder, hub_digital_twin_model_id);
+    _az_span_builder_append(&builder, hub_client_param_equals_span);
+    _az_span_builder_append_url_encoded(&builder, model_id);
   }
-  else
+
+  _az_span_builder_append_u8(&builder, null_terminator);
+  if (mqtt_user_name == NULL)
   {
-    return AZ_ERROR_NOT_ENOUGH_SPACE;
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_user_name_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
+    return AZ_OK;
   }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_USER_NAME, _az_span_builder_length(&builder));
   if (out_mqtt_user_name_length)
   {
     *out_mqtt_user_name_length
-        = mqtt_user_name_size - (size_t)az_span_size(remainder) - sizeof(null_terminator);
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
   }
 
   return AZ_OK;
@@ -148,17 +191,24 @@ AZ_NODISCARD az_result az_iot_hub_client_get_client_id(
     size_t* out_mqtt_client_id_length)
 {
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_client_id);
-  _az_PRECONDITION(mqtt_client_id_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(
+      mqtt_client_id, mqtt_client_id_size, out_mqtt_client_id_length);
 
   az_span mqtt_client_id_span
       = az_span_create((uint8_t*)mqtt_client_id, (int32_t)mqtt_client_id_size);
-  const az_span* const module_id = &(client->_internal.options.module_id);
+  az_span const module_id = _az_iot_hub_client_get_module_id(client);
 
   int32_t required_length = az_span_size(client->_internal.device_id);
-  if (az_span_size(*module_id) > 0)
+  if (az_span_size(module_id) > 0)
   {
-    required_length += az_span_size(*module_id) + (int32_t)sizeof(hub_client_forward_slash);
+    required_length += az_span_size(module_id) + (int32_t)sizeof(hub_client_forward_slash);
+  }
+
+  if (mqtt_client_id == NULL)
+  {
+    // Only the length is asked for.
+    *out_mqtt_client_id_length = (size_t)required_length;
+    return AZ_OK;
   }
 
   _az_RETURN_IF_NOT_ENOUGH_SIZE(
@@ -166,14 +216,16 @@ AZ_NODISCARD az_result az_iot_hub_client_get_client_id(
 
   az_span remainder = az_span_copy(mqtt_client_id_span, client->_internal.device_id);
 
-  if (az_span_size(*module_id) > 0)
+  if (az_span_size(module_id) > 0)
   {
     remainder = az_span_copy_u8(remainder, hub_client_forward_slash);
-    remainder = az_span_copy(remainder, *module_id);
+    remainder = az_span_copy(remainder, module_id);
   }
 
   az_span_copy_u8(remainder, null_terminator);
 
+  _az_BUFFER_STATS_RECORD(
+      _az_BUFFER_STATS_IOT_MQTT_CLIENT_ID, required_length + (int32_t)sizeof(null_terminator));
   if (out_mqtt_client_id_length)
   {
     *out_mqtt_client_id_length = (size_t)required_length;
@@ -181,3 +233,102 @@ AZ_NODISCARD az_result az_iot_hub_client_get_client_id(
 
   return AZ_OK;
 }
+
+static AZ_NODISCARD az_result _az_iot_hub_client_match_received_topic(
+    az_iot_hub_client const* client,
+    az_span received_topic,
+    az_iot_hub_client_received_topic* out_topic)
+{
+  // IoT Hub publishes every feature under its own fixed prefix, so the leading bytes are enough to
+  // pick the single parser that can match, instead of searching the topic once per feature.
+#ifndef AZ_NO_IOT_HUB_TWIN
+  if (_az_span_starts_with(received_topic, hub_twin_topic_prefix))
+  {
+    _az_RETURN_IF_FAILED(az_iot_hub_client_twin_parse_received_topic(
+        client, received_topic, &out_topic->data.twin_response));
+    out_topic->type = out_topic->data.twin_response.response_type
+            == AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES
+        ? AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_DESIRED_PATCH
+        : AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_RESPONSE;
+    return AZ_OK;
+  }
+#endif // AZ_NO_IOT_HUB_TWIN
+
+#ifndef AZ_NO_IOT_HUB_METHODS
+  if (_az_span_starts_with(received_topic, hub_methods_topic_prefix))
+  {
+    _az_RETURN_IF_FAILED(az_iot_hub_client_methods_parse_received_topic(
+        client, received_topic, &out_topic->data.method_request));
+    out_topic->type = AZ_IOT_HUB_CLIENT_TOPIC_TYPE_METHOD_REQUEST;
+    return AZ_OK;
+  }
+#endif // AZ_NO_IOT_HUB_METHODS
+
+  if (_az_span_starts_with(received_topic, hub_c2d_topic_prefix))
+  {
+    _az_RETURN_IF_FAILED(az_iot_hub_client_c2d_parse_received_topic(
+        client, received_topic, &out_topic->data.c2d_request));
+    out_topic->type = AZ_IOT_HUB_CLIENT_TOPIC_TYPE_C2D_REQUEST;
+    return AZ_OK;
+  }
+
+  return AZ_ERROR_IOT_TOPIC_NO_MATCH;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_parse_received_topic(
+    az_iot_hub_client const* client,
+    az_span received_topic,
+    az_iot_hub_client_received_topic* out_topic)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(received_topic, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_topic);
+
+  az_result const result
+      = _az_iot_hub_client_match_received_topic(client, received_topic, out_topic);
+  _az_TRACEPOINT3(iot_hub_topic_parse, client, az_span_size(received_topic), result);
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_parse_received_message(
+    az_iot_hub_client const* client,
+    az_span received_topic,
+    az_span received_payload,
+    az_iot_hub_client_receive_buffer_release_fn release_callback,
+    void* release_user_context,
+    az_iot_hub_client_received_message* out_message)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(received_topic, 1, false);
+  _az_PRECONDITION_VALID_SPAN(received_payload, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_message);
+
+  _az_RETURN_IF_FAILED(
+      az_iot_hub_client_parse_received_topic(client, received_topic, &out_message->topic));
+
+  out_message->payload = received_payload;
+  out_message->_internal.received_topic = received_topic;
+  out_message->_internal.release_callback = release_callback;
+  out_message->_internal.release_user_context = release_user_context;
+  return AZ_OK;
+}
+
+void az_iot_hub_client_received_message_release(az_iot_hub_client_received_message* message)
+{
+  _az_PRECONDITION_NOT_NULL(message);
+
+  az_iot_hub_client_receive_buffer_release_fn const release_callback
+      = message->_internal.release_callback;
+  az_span const received_topic = message->_internal.received_topic;
+  az_span const received_payload = message->payload;
+
+  message->payload = AZ_SPAN_EMPTY;
+  message->_internal.received_topic = AZ_SPAN_EMPTY;
+  message->_internal.release_callback = NULL;
+
+  if (release_callback != NULL)
+  {
+    release_callback(received_topic, received_payload, message->_internal.release_user_context);
+  }
+}
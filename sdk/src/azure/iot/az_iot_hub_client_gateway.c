@@ -0,0 +1,237 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_result_internal.h>
+#include <azure/core/internal/az_span_internal.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+#include <azure/core/internal/az_precondition_internal.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define _az_GATEWAY_EMPTY_BUCKET -1
+
+static const az_span devices_prefix = AZ_SPAN_LITERAL_FROM_STR("devices/");
+static const az_span modules_segment = AZ_SPAN_LITERAL_FROM_STR("modules/");
+
+// FNV-1a over the device ID, a separator which cannot appear in an ID, and the module ID.
+static AZ_NODISCARD uint32_t _az_iot_hub_gateway_hash(az_span device_id, az_span module_id)
+{
+  uint32_t hash = 2166136261u;
+
+  uint8_t const* ptr = az_span_ptr(device_id);
+  for (int32_t i = 0; i < az_span_size(device_id); i++)
+  {
+    hash = (hash ^ ptr[i]) * 16777619u;
+  }
+
+  hash = (hash ^ (uint8_t)'/') * 16777619u;
+
+  ptr = az_span_ptr(module_id);
+  for (int32_t i = 0; i < az_span_size(module_id); i++)
+  {
+    hash = (hash ^ ptr[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+// Returns the bucket which holds the identity, or the empty bucket where it would be inserted.
+static AZ_NODISCARD int32_t _az_iot_hub_gateway_probe(
+    az_iot_hub_gateway const* gateway,
+    az_span device_id,
+    az_span module_id,
+    uint32_t hash)
+{
+  int32_t const mask = gateway->_internal.bucket_count - 1;
+  int32_t bucket = (int32_t)(hash & (uint32_t)mask);
+
+  // There are more buckets than identities, so an empty bucket always ends the probe sequence.
+  while (true)
+  {
+    int32_t const index = gateway->_internal.buckets[bucket];
+    if (index == _az_GATEWAY_EMPTY_BUCKET)
+    {
+      return bucket;
+    }
+
+    az_iot_hub_gateway_identity const* identity = &gateway->_internal.identities[index];
+    if (identity->_internal.hash == hash
+        && az_span_is_content_equal(identity->_internal.device_id, device_id)
+        && az_span_is_content_equal(identity->_internal.module_id, module_id))
+    {
+      return bucket;
+    }
+
+    bucket = (bucket + 1) & mask;
+  }
+}
+
+AZ_NODISCARD az_result az_iot_hub_gateway_init(
+    az_iot_hub_gateway* gateway,
+    az_span iot_hub_hostname,
+    az_iot_hub_client_options const* options,
+    az_iot_hub_gateway_identity* identities,
+    int32_t identity_capacity,
+    int32_t* buckets,
+    int32_t bucket_count)
+{
+  _az_PRECONDITION_NOT_NULL(gateway);
+  _az_PRECONDITION_VALID_SPAN(iot_hub_hostname, 1, false);
+#ifndef AZ_NO_IOT_HUB_MODULE_ID
+  _az_PRECONDITION(options == NULL || az_span_size(options->module_id) == 0);
+#endif // AZ_NO_IOT_HUB_MODULE_ID
+  _az_PRECONDITION_NOT_NULL(identities);
+  _az_PRECONDITION(identity_capacity > 0);
+  _az_PRECONDITION_NOT_NULL(buckets);
+  _az_PRECONDITION(bucket_count > identity_capacity);
+  _az_PRECONDITION((bucket_count & (bucket_count - 1)) == 0);
+
+  az_iot_hub_client_shared_init(&gateway->_internal.shared, iot_hub_hostname, options);
+  gateway->_internal.identities = identities;
+  gateway->_internal.identity_capacity = identity_capacity;
+  gateway->_internal.identity_count = 0;
+  gateway->_internal.buckets = buckets;
+  gateway->_internal.bucket_count = bucket_count;
+
+  for (int32_t i = 0; i < bucket_count; i++)
+  {
+    buckets[i] = _az_GATEWAY_EMPTY_BUCKET;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_gateway_add_identity(
+    az_iot_hub_gateway* gateway,
+    az_span device_id,
+    az_span module_id,
+    int32_t* out_identity_index)
+{
+  _az_PRECONDITION_NOT_NULL(gateway);
+  _az_PRECONDITION_VALID_SPAN(device_id, 1, false);
+  _az_PRECONDITION_VALID_SPAN(module_id, 0, true);
+#if defined(AZ_NO_IOT_HUB_MODULE_ID) || defined(AZ_IOT_HUB_LEAN_CLIENT)
+  // The clients of the identities couldn't carry the module ID.
+  _az_PRECONDITION(az_span_size(module_id) == 0);
+#endif // defined(AZ_NO_IOT_HUB_MODULE_ID) || defined(AZ_IOT_HUB_LEAN_CLIENT)
+
+  uint32_t const hash = _az_iot_hub_gateway_hash(device_id, module_id);
+  int32_t const bucket = _az_iot_hub_gateway_probe(gateway, device_id, module_id, hash);
+
+  if (gateway->_internal.buckets[bucket] != _az_GATEWAY_EMPTY_BUCKET)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  if (gateway->_internal.identity_count == gateway->_internal.identity_capacity)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t const index = gateway->_internal.identity_count++;
+  az_iot_hub_gateway_identity* identity = &gateway->_internal.identities[index];
+  identity->_internal.device_id = device_id;
+  identity->_internal.module_id = module_id;
+  identity->_internal.hash = hash;
+  gateway->_internal.buckets[bucket] = index;
+
+  if (out_identity_index != NULL)
+  {
+    *out_identity_index = index;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_gateway_find_identity(
+    az_iot_hub_gateway const* gateway,
+    az_span device_id,
+    az_span module_id,
+    int32_t* out_identity_index)
+{
+  _az_PRECONDITION_NOT_NULL(gateway);
+  _az_PRECONDITION_VALID_SPAN(device_id, 0, true);
+  _az_PRECONDITION_VALID_SPAN(module_id, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_identity_index);
+
+  uint32_t const hash = _az_iot_hub_gateway_hash(device_id, module_id);
+  int32_t const bucket = _az_iot_hub_gateway_probe(gateway, device_id, module_id, hash);
+  int32_t const index = gateway->_internal.buckets[bucket];
+
+  if (index == _az_GATEWAY_EMPTY_BUCKET)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  *out_identity_index = index;
+  return AZ_OK;
+}
+
+void az_iot_hub_gateway_get_client(
+    az_iot_hub_gateway const* gateway,
+    int32_t identity_index,
+    az_iot_hub_client* out_client)
+{
+  _az_PRECONDITION_NOT_NULL(gateway);
+  _az_PRECONDITION_RANGE(0, identity_index, gateway->_internal.identity_count - 1);
+  _az_PRECONDITION_NOT_NULL(out_client);
+
+  az_iot_hub_gateway_identity const* identity = &gateway->_internal.identities[identity_index];
+
+  az_iot_hub_client_init_shared(
+      out_client, &gateway->_internal.shared, identity->_internal.device_id);
+#if !defined(AZ_NO_IOT_HUB_MODULE_ID) && !defined(AZ_IOT_HUB_LEAN_CLIENT)
+  out_client->_internal.options.module_id = identity->_internal.module_id;
+#endif // !defined(AZ_NO_IOT_HUB_MODULE_ID) && !defined(AZ_IOT_HUB_LEAN_CLIENT)
+}
+
+AZ_NODISCARD az_result az_iot_hub_gateway_route_received_topic(
+    az_iot_hub_gateway const* gateway,
+    az_span received_topic,
+    int32_t* out_identity_index)
+{
+  _az_PRECONDITION_NOT_NULL(gateway);
+  _az_PRECONDITION_VALID_SPAN(received_topic, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_identity_index);
+
+  int32_t const prefix_size = az_span_size(devices_prefix);
+  if (az_span_size(received_topic) <= prefix_size
+      || !_az_span_starts_with(received_topic, devices_prefix))
+  {
+    return AZ_ERROR_IOT_TOPIC_NO_MATCH;
+  }
+
+  // devices/{device_id}/[modules/{module_id}/]...
+  az_span remainder = az_span_slice_to_end(received_topic, prefix_size);
+  int32_t separator = az_span_find(remainder, AZ_SPAN_FROM_STR("/"));
+  if (separator <= 0)
+  {
+    return AZ_ERROR_IOT_TOPIC_NO_MATCH;
+  }
+
+  az_span const device_id = az_span_slice(remainder, 0, separator);
+  az_span module_id = AZ_SPAN_EMPTY;
+  remainder = az_span_slice_to_end(remainder, separator + 1);
+
+  int32_t const segment_size = az_span_size(modules_segment);
+  if (az_span_size(remainder) > segment_size
+      && az_span_is_content_equal(az_span_slice(remainder, 0, segment_size), modules_segment))
+  {
+    remainder = az_span_slice_to_end(remainder, segment_size);
+    separator = az_span_find(remainder, AZ_SPAN_FROM_STR("/"));
+    if (separator <= 0)
+    {
+      return AZ_ERROR_IOT_TOPIC_NO_MATCH;
+    }
+
+    module_id = az_span_slice(remainder, 0, separator);
+  }
+
+  return az_iot_hub_gateway_find_identity(gateway, device_id, module_id, out_identity_index);
+}
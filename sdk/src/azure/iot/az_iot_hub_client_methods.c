@@ -5,6 +5,7 @@
 
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 #include <azure/iot/az_iot_hub_client.h>
@@ -32,7 +33,10 @@ AZ_NODISCARD az_result az_iot_hub_client_methods_parse_received_topic(
 
   (void)client;
 
-  int32_t index = az_span_find(received_topic, methods_topic_prefix);
+  // IoT Hub publishes method requests with the prefix at the start of the topic.
+  int32_t index = _az_span_starts_with(received_topic, methods_topic_prefix)
+      ? 0
+      : az_span_find(received_topic, methods_topic_prefix);
 
   if (index == -1)
   {
@@ -85,31 +89,214 @@ AZ_NODISCARD az_result az_iot_hub_client_methods_response_get_publish_topic(
 {
   _az_PRECONDITION_NOT_NULL(client);
   _az_PRECONDITION_VALID_SPAN(request_id, 1, false);
-  _az_PRECONDITION_NOT_NULL(mqtt_topic);
-  _az_PRECONDITION(mqtt_topic_size);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_topic, mqtt_topic_size, out_mqtt_topic_length);
 
   (void)client;
 
-  az_span mqtt_topic_span = az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size);
-  int32_t required_length = az_span_size(methods_topic_prefix)
-      + az_span_size(methods_response_topic_result) + _az_iot_u32toa_size(status)
-      + az_span_size(methods_response_topic_properties) + az_span_size(request_id);
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size));
+  _az_span_builder_append(&builder, methods_topic_prefix);
+  _az_span_builder_append(&builder, methods_response_topic_result);
+  _az_span_builder_append_u32(&builder, (uint32_t)status);
+  _az_span_builder_append(&builder, methods_response_topic_properties);
+  _az_span_builder_append(&builder, request_id);
+  _az_span_builder_append_u8(&builder, null_terminator);
+  if (mqtt_topic == NULL)
+  {
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
+    return AZ_OK;
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_topic_span, required_length + (int32_t)sizeof(null_terminator));
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_TOPIC, _az_span_builder_length(&builder));
+  if (out_mqtt_topic_length)
+  {
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
+  }
 
-  az_span remainder = az_span_copy(mqtt_topic_span, methods_topic_prefix);
-  remainder = az_span_copy(remainder, methods_response_topic_result);
+  return AZ_OK;
+}
 
-  _az_RETURN_IF_FAILED(az_span_u32toa(remainder, (uint32_t)status, &remainder));
+#define _az_COMMAND_TABLE_EMPTY_BUCKET -1
 
-  remainder = az_span_copy(remainder, methods_response_topic_properties);
-  remainder = az_span_copy(remainder, request_id);
-  az_span_copy_u8(remainder, null_terminator);
+// FNV-1a over the component name, the separator when there is a component, and the command name,
+// which is the hash of the method name.
+static AZ_NODISCARD uint32_t _az_iot_hub_client_command_table_hash(
+    az_iot_hub_client_command_table const* table,
+    az_span component_name,
+    az_span command_name)
+{
+  uint32_t hash = 2166136261u;
 
-  if (out_mqtt_topic_length)
+  uint8_t const* ptr = az_span_ptr(component_name);
+  for (int32_t i = 0; i < az_span_size(component_name); i++)
+  {
+    hash = (hash ^ ptr[i]) * 16777619u;
+  }
+
+  if (az_span_size(component_name) > 0)
+  {
+    hash = (hash ^ table->_internal.component_separator) * 16777619u;
+  }
+
+  ptr = az_span_ptr(command_name);
+  for (int32_t i = 0; i < az_span_size(command_name); i++)
+  {
+    hash = (hash ^ ptr[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+// Returns the bucket which holds the command, or the empty bucket where it would be inserted.
+static AZ_NODISCARD int32_t _az_iot_hub_client_command_table_probe(
+    az_iot_hub_client_command_table const* table,
+    az_span component_name,
+    az_span command_name,
+    uint32_t hash)
+{
+  int32_t const mask = table->_internal.bucket_count - 1;
+  int32_t bucket = (int32_t)(hash & (uint32_t)mask);
+
+  // There are more buckets than commands, so an empty bucket always ends the probe sequence.
+  while (true)
+  {
+    int32_t const index = table->_internal.buckets[bucket];
+    if (index == _az_COMMAND_TABLE_EMPTY_BUCKET)
+    {
+      return bucket;
+    }
+
+    az_iot_hub_client_command const* command = &table->_internal.commands[index];
+    if (command->_internal.hash == hash
+        && az_span_is_content_equal(command->_internal.command_name, command_name)
+        && az_span_is_content_equal(command->_internal.component_name, component_name))
+    {
+      return bucket;
+    }
+
+    bucket = (bucket + 1) & mask;
+  }
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_command_table_init(
+    az_iot_hub_client_command_table* table,
+    uint8_t component_separator,
+    az_iot_hub_client_command* commands,
+    int32_t command_capacity,
+    int32_t* buckets,
+    int32_t bucket_count)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+  _az_PRECONDITION_NOT_NULL(commands);
+  _az_PRECONDITION(command_capacity > 0);
+  _az_PRECONDITION_NOT_NULL(buckets);
+  _az_PRECONDITION(bucket_count > command_capacity);
+  _az_PRECONDITION((bucket_count & (bucket_count - 1)) == 0);
+
+  table->_internal.commands = commands;
+  table->_internal.command_capacity = command_capacity;
+  table->_internal.command_count = 0;
+  table->_internal.buckets = buckets;
+  table->_internal.bucket_count = bucket_count;
+  table->_internal.component_separator = component_separator;
+
+  for (int32_t i = 0; i < bucket_count; i++)
+  {
+    buckets[i] = _az_COMMAND_TABLE_EMPTY_BUCKET;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_command_table_add(
+    az_iot_hub_client_command_table* table,
+    az_span component_name,
+    az_span command_name,
+    int32_t* out_command_index)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+  _az_PRECONDITION_VALID_SPAN(component_name, 0, true);
+  _az_PRECONDITION_VALID_SPAN(command_name, 1, false);
+
+  uint32_t const hash
+      = _az_iot_hub_client_command_table_hash(table, component_name, command_name);
+  int32_t const bucket
+      = _az_iot_hub_client_command_table_probe(table, component_name, command_name, hash);
+
+  if (table->_internal.buckets[bucket] != _az_COMMAND_TABLE_EMPTY_BUCKET)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  if (table->_internal.command_count == table->_internal.command_capacity)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t const index = table->_internal.command_count++;
+  az_iot_hub_client_command* command = &table->_internal.commands[index];
+  command->_internal.component_name = component_name;
+  command->_internal.command_name = command_name;
+  command->_internal.hash = hash;
+  table->_internal.buckets[bucket] = index;
+
+  if (out_command_index != NULL)
+  {
+    *out_command_index = index;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_command_table_find(
+    az_iot_hub_client_command_table const* table,
+    az_span method_name,
+    int32_t* out_command_index,
+    az_span* out_component_name,
+    az_span* out_command_name)
+{
+  _az_PRECONDITION_NOT_NULL(table);
+  _az_PRECONDITION_VALID_SPAN(method_name, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_command_index);
+
+  az_span component_name = AZ_SPAN_EMPTY;
+  az_span command_name = method_name;
+
+  // A leading separator has no component name before it, so it is part of the command name.
+  uint8_t component_separator = table->_internal.component_separator;
+  int32_t const separator = az_span_find(method_name, az_span_create(&component_separator, 1));
+  if (separator > 0)
+  {
+    component_name = az_span_slice(method_name, 0, separator);
+    command_name = az_span_slice_to_end(method_name, separator + 1);
+  }
+
+  uint32_t const hash
+      = _az_iot_hub_client_command_table_hash(table, component_name, command_name);
+  int32_t const bucket
+      = _az_iot_hub_client_command_table_probe(table, component_name, command_name, hash);
+  int32_t const index = table->_internal.buckets[bucket];
+
+  if (index == _az_COMMAND_TABLE_EMPTY_BUCKET)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  *out_command_index = index;
+
+  if (out_component_name != NULL)
+  {
+    *out_component_name = component_name;
+  }
+
+  if (out_command_name != NULL)
   {
-    *out_mqtt_topic_length = (size_t)required_length;
+    *out_command_name = command_name;
   }
 
   return AZ_OK;
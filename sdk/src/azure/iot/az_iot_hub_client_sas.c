@@ -3,14 +3,17 @@
 
 #include <azure/core/az_precondition.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/iot/az_iot_hub_client.h>
 #include <azure/iot/internal/az_iot_common_internal.h>
+#include <azure/iot/internal/az_iot_hub_client_internal.h>
 
 #include <azure/core/internal/az_log_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <azure/core/_az_cfg.h>
@@ -48,7 +51,7 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_signature(
   int32_t signature_size = az_span_size(signature);
 
   _az_RETURN_IF_FAILED(
-      _az_span_copy_url_encode(remainder, client->_internal.iot_hub_hostname, &remainder));
+      _az_span_copy_url_encode(remainder, _az_iot_hub_client_get_hostname(client), &remainder));
 
   _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(devices_string));
   remainder = az_span_copy(remainder, devices_string);
@@ -56,13 +59,13 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_signature(
   _az_RETURN_IF_FAILED(
       _az_span_copy_url_encode(remainder, client->_internal.device_id, &remainder));
 
-  if (az_span_size(client->_internal.options.module_id) > 0)
+  if (az_span_size(_az_iot_hub_client_get_module_id(client)) > 0)
   {
     _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(modules_string));
     remainder = az_span_copy(remainder, modules_string);
 
     _az_RETURN_IF_FAILED(
-        _az_span_copy_url_encode(remainder, client->_internal.options.module_id, &remainder));
+        _az_span_copy_url_encode(remainder, _az_iot_hub_client_get_module_id(client), &remainder));
   }
 
   _az_RETURN_IF_NOT_ENOUGH_SIZE(
@@ -92,81 +95,257 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_password(
   _az_PRECONDITION_NOT_NULL(client);
   _az_PRECONDITION_VALID_SPAN(base64_hmac_sha256_signature, 1, false);
   _az_PRECONDITION(token_expiration_epoch_time > 0);
-  _az_PRECONDITION_NOT_NULL(mqtt_password);
-  _az_PRECONDITION(mqtt_password_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_password, mqtt_password_size, out_mqtt_password_length);
 
   // Concatenates: "SharedAccessSignature sr=" scope "&sig=" sig  "&se=" expiration_time_secs
   //               plus, if key_name size > 0, "&skn=" key_name
 
-  az_span mqtt_password_span = az_span_create((uint8_t*)mqtt_password, (int32_t)mqtt_password_size);
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_password, (int32_t)mqtt_password_size));
 
   // SharedAccessSignature
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, az_span_size(sr_string) + 1 /* EQUAL_SIGN */);
-  mqtt_password_span = az_span_copy(mqtt_password_span, sr_string);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-
-  _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-      mqtt_password_span, client->_internal.iot_hub_hostname, &mqtt_password_span));
+  _az_span_builder_append(&builder, sr_string);
+  _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+  _az_span_builder_append_url_encoded(&builder, _az_iot_hub_client_get_hostname(client));
 
   // Device ID
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, az_span_size(devices_string));
-  mqtt_password_span = az_span_copy(mqtt_password_span, devices_string);
-
-  _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-      mqtt_password_span, client->_internal.device_id, &mqtt_password_span));
+  _az_span_builder_append(&builder, devices_string);
+  _az_span_builder_append_url_encoded(&builder, client->_internal.device_id);
 
   // Module ID
-  if (az_span_size(client->_internal.options.module_id) > 0)
+  if (az_span_size(_az_iot_hub_client_get_module_id(client)) > 0)
   {
-    _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, az_span_size(modules_string));
-    mqtt_password_span = az_span_copy(mqtt_password_span, modules_string);
-
-    _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-        mqtt_password_span, client->_internal.options.module_id, &mqtt_password_span));
+    _az_span_builder_append(&builder, modules_string);
+    _az_span_builder_append_url_encoded(&builder, _az_iot_hub_client_get_module_id(client));
   }
 
   // Signature
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_password_span, 1 /* AMPERSAND */ + az_span_size(sig_string) + 1 /* EQUAL_SIGN */);
-
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, AMPERSAND);
-  mqtt_password_span = az_span_copy(mqtt_password_span, sig_string);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-
-  _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-      mqtt_password_span, base64_hmac_sha256_signature, &mqtt_password_span));
+  _az_span_builder_append_u8(&builder, AMPERSAND);
+  _az_span_builder_append(&builder, sig_string);
+  _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+  _az_span_builder_append_url_encoded(&builder, base64_hmac_sha256_signature);
 
   // Expiration
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_password_span, 1 /* AMPERSAND */ + az_span_size(se_string) + 1 /* EQUAL_SIGN */);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, AMPERSAND);
-  mqtt_password_span = az_span_copy(mqtt_password_span, se_string);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-
-  _az_RETURN_IF_FAILED(
-      az_span_u64toa(mqtt_password_span, token_expiration_epoch_time, &mqtt_password_span));
+  _az_span_builder_append_u8(&builder, AMPERSAND);
+  _az_span_builder_append(&builder, se_string);
+  _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+  _az_span_builder_append_u64(&builder, token_expiration_epoch_time);
 
   if (az_span_size(key_name) > 0)
   {
     // Key Name
-    _az_RETURN_IF_NOT_ENOUGH_SIZE(
-        mqtt_password_span,
-        1 /* AMPERSAND */ + az_span_size(skn_string) + 1 /* EQUAL_SIGN */ + az_span_size(key_name));
-    mqtt_password_span = az_span_copy_u8(mqtt_password_span, AMPERSAND);
-    mqtt_password_span = az_span_copy(mqtt_password_span, skn_string);
-    mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-    mqtt_password_span = az_span_copy(mqtt_password_span, key_name);
+    _az_span_builder_append_u8(&builder, AMPERSAND);
+    _az_span_builder_append(&builder, skn_string);
+    _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+    _az_span_builder_append(&builder, key_name);
   }
 
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, 1 /* NULL TERMINATOR */);
-
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, STRING_NULL_TERMINATOR);
+  _az_span_builder_append_u8(&builder, STRING_NULL_TERMINATOR);
+  if (mqtt_password == NULL)
+  {
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_password_length = (size_t)(_az_span_builder_length(&builder) - 1);
+    return AZ_OK;
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_PASSWORD, _az_span_builder_length(&builder));
   if (out_mqtt_password_length != NULL)
   {
     *out_mqtt_password_length
-        = mqtt_password_size - (size_t)az_span_size(mqtt_password_span) - 1 /* NULL TERMINATOR */;
+        = (size_t)(_az_span_builder_length(&builder) - 1 /* NULL TERMINATOR */);
   }
 
   return AZ_OK;
 }
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_get_password_from_key(
+    az_iot_hub_client const* client,
+    uint64_t token_expiration_epoch_time,
+    az_span base64_shared_access_key,
+    az_span key_name,
+    char* mqtt_password,
+    size_t mqtt_password_size,
+    size_t* out_mqtt_password_length)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION(token_expiration_epoch_time > 0);
+  _az_PRECONDITION_VALID_SPAN(base64_shared_access_key, 1, false);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_password, mqtt_password_size, out_mqtt_password_length);
+
+  if (mqtt_password == NULL)
+  {
+    // The signature can't be known without signing, so the length is that of the password with
+    // the longest signature.
+    return az_iot_hub_client_sas_get_password(
+        client,
+        token_expiration_epoch_time,
+        AZ_SPAN_FROM_STR(_az_IOT_SAS_LONGEST_BASE64_HMAC_SHA256),
+        key_name,
+        NULL,
+        0,
+        out_mqtt_password_length);
+  }
+
+  // The password contains the signature's scope plus more than a decoded key's worth of other
+  // text, so the signature and the decoded key are staged in mqtt_password before it is written.
+  az_span const mqtt_password_span
+      = az_span_create((uint8_t*)mqtt_password, (int32_t)mqtt_password_size);
+
+  az_span signature;
+  _az_RETURN_IF_FAILED(az_iot_hub_client_sas_get_signature(
+      client, token_expiration_epoch_time, mqtt_password_span, &signature));
+
+  uint8_t base64_hmac_sha256_buffer[_az_IOT_SAS_BASE64_HMAC_SHA256_SIZE];
+  az_span base64_hmac_sha256_signature;
+  _az_RETURN_IF_FAILED(_az_iot_sas_sign(
+      base64_shared_access_key,
+      signature,
+      az_span_slice_to_end(mqtt_password_span, az_span_size(signature)),
+      AZ_SPAN_FROM_BUFFER(base64_hmac_sha256_buffer),
+      &base64_hmac_sha256_signature));
+
+  return az_iot_hub_client_sas_get_password(
+      client,
+      token_expiration_epoch_time,
+      base64_hmac_sha256_signature,
+      key_name,
+      mqtt_password,
+      mqtt_password_size,
+      out_mqtt_password_length);
+}
+
+AZ_NODISCARD az_iot_hub_client_sas_token_cache_options
+az_iot_hub_client_sas_token_cache_options_default()
+{
+  return (az_iot_hub_client_sas_token_cache_options){
+    .token_lifetime_seconds = AZ_IOT_HUB_CLIENT_SAS_TOKEN_CACHE_DEFAULT_LIFETIME_SECONDS,
+    .refresh_margin_seconds = AZ_IOT_HUB_CLIENT_SAS_TOKEN_CACHE_DEFAULT_REFRESH_MARGIN_SECONDS,
+  };
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_token_cache_init(
+    az_iot_hub_client_sas_token_cache* cache,
+    az_iot_hub_client const* client,
+    az_span base64_shared_access_key,
+    az_span key_name,
+    az_span buffer,
+    az_iot_hub_client_sas_token_cache_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(cache);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(base64_shared_access_key, 1, false);
+  _az_PRECONDITION_VALID_SPAN(buffer, 2, false);
+  _az_PRECONDITION(
+      options == NULL || options->refresh_margin_seconds < options->token_lifetime_seconds);
+
+  int32_t const half_size = az_span_size(buffer) / 2;
+
+  cache->_internal.client = client;
+  cache->_internal.base64_shared_access_key = base64_shared_access_key;
+  cache->_internal.key_name = key_name;
+  cache->_internal.options
+      = options == NULL ? az_iot_hub_client_sas_token_cache_options_default() : *options;
+  cache->_internal.passwords[0] = az_span_slice(buffer, 0, half_size);
+  cache->_internal.passwords[1] = az_span_slice(buffer, half_size, half_size * 2);
+  cache->_internal.password_lengths[0] = 0;
+  cache->_internal.password_lengths[1] = 0;
+  cache->_internal.expirations[0] = 0;
+  cache->_internal.expirations[1] = 0;
+  cache->_internal.current = -1;
+  cache->_internal.next_ready = false;
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_iot_hub_client_sas_token_cache_sign(
+    az_iot_hub_client_sas_token_cache* cache,
+    int32_t index,
+    uint64_t token_expiration_epoch_time)
+{
+  az_span const password = cache->_internal.passwords[index];
+  size_t length = 0;
+
+  _az_RETURN_IF_FAILED(az_iot_hub_client_sas_get_password_from_key(
+      cache->_internal.client,
+      token_expiration_epoch_time,
+      cache->_internal.base64_shared_access_key,
+      cache->_internal.key_name,
+      (char*)az_span_ptr(password),
+      (size_t)az_span_size(password),
+      &length));
+
+  cache->_internal.password_lengths[index] = (int32_t)length;
+  cache->_internal.expirations[index] = token_expiration_epoch_time;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD AZ_INLINE bool _az_iot_hub_client_sas_token_cache_is_fresh(
+    az_iot_hub_client_sas_token_cache const* cache,
+    int32_t index,
+    uint64_t current_epoch_time)
+{
+  return current_epoch_time + cache->_internal.options.refresh_margin_seconds
+      < cache->_internal.expirations[index];
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_token_cache_get_password(
+    az_iot_hub_client_sas_token_cache* cache,
+    uint64_t current_epoch_time,
+    az_span* out_mqtt_password)
+{
+  _az_PRECONDITION_NOT_NULL(cache);
+  _az_PRECONDITION(current_epoch_time > 0);
+  _az_PRECONDITION_NOT_NULL(out_mqtt_password);
+
+  int32_t current = cache->_internal.current;
+
+  if (current < 0
+      || !_az_iot_hub_client_sas_token_cache_is_fresh(cache, current, current_epoch_time))
+  {
+    int32_t const next = current < 0 ? 0 : 1 - current;
+
+    if (!(cache->_internal.next_ready
+          && _az_iot_hub_client_sas_token_cache_is_fresh(cache, next, current_epoch_time)))
+    {
+      // Nothing usable was prepared ahead of time, so the token is signed on this call.
+      _az_RETURN_IF_FAILED(_az_iot_hub_client_sas_token_cache_sign(
+          cache, next, current_epoch_time + cache->_internal.options.token_lifetime_seconds));
+    }
+
+    current = next;
+    cache->_internal.current = current;
+    cache->_internal.next_ready = false;
+  }
+
+  *out_mqtt_password = az_span_slice(
+      cache->_internal.passwords[current], 0, cache->_internal.password_lengths[current]);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_iot_hub_client_sas_token_cache_renew(az_iot_hub_client_sas_token_cache* cache)
+{
+  _az_PRECONDITION_NOT_NULL(cache);
+
+  int32_t const current = cache->_internal.current;
+
+  if (current < 0 || cache->_internal.next_ready)
+  {
+    return AZ_OK;
+  }
+
+  // The next token takes over a refresh margin before the current one expires, and is valid for
+  // a whole lifetime from then on.
+  uint64_t const replaced_at
+      = cache->_internal.expirations[current] - cache->_internal.options.refresh_margin_seconds;
+
+  _az_RETURN_IF_FAILED(_az_iot_hub_client_sas_token_cache_sign(
+      cache, 1 - current, replaced_at + cache->_internal.options.token_lifetime_seconds));
+  cache->_internal.next_ready = true;
+
+  return AZ_OK;
+}
@@ -1,14 +1,20 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include <azure/core/az_json.h>
 #include <azure/core/az_precondition.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/iot/az_iot_hub_client.h>
+#include <azure/iot/internal/az_iot_common_internal.h>
+#include <azure/iot/internal/az_iot_hub_client_internal.h>
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -17,6 +23,30 @@ static const az_span telemetry_topic_prefix = AZ_SPAN_LITERAL_FROM_STR("devices/
 static const az_span telemetry_topic_modules_mid = AZ_SPAN_LITERAL_FROM_STR("/modules/");
 static const az_span telemetry_topic_suffix = AZ_SPAN_LITERAL_FROM_STR("/messages/events/");
 
+static AZ_NODISCARD int32_t _az_iot_hub_client_telemetry_get_topic_length(
+    az_iot_hub_client const* client,
+    az_iot_message_properties const* properties)
+{
+  int32_t length = az_span_size(_az_iot_hub_client_get_telemetry_topic_prefix(client));
+  if (length == 0)
+  {
+    length = az_span_size(telemetry_topic_prefix) + az_span_size(client->_internal.device_id)
+        + az_span_size(telemetry_topic_suffix);
+    int32_t const module_id_length = az_span_size(_az_iot_hub_client_get_module_id(client));
+    if (module_id_length > 0)
+    {
+      length += az_span_size(telemetry_topic_modules_mid) + module_id_length;
+    }
+  }
+
+  if (properties != NULL)
+  {
+    length += properties->_internal.properties_written;
+  }
+
+  return length;
+}
+
 AZ_NODISCARD az_result az_iot_hub_client_telemetry_get_publish_topic(
     az_iot_hub_client const* client,
     az_iot_message_properties const* properties,
@@ -25,37 +55,43 @@ AZ_NODISCARD az_result az_iot_hub_client_telemetry_get_publish_topic(
     size_t* out_mqtt_topic_length)
 {
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_topic);
-  _az_PRECONDITION(mqtt_topic_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_topic, mqtt_topic_size, out_mqtt_topic_length);
 
-  const az_span* const module_id = &(client->_internal.options.module_id);
+  az_span const module_id = _az_iot_hub_client_get_module_id(client);
+  az_span const cached_prefix = _az_iot_hub_client_get_telemetry_topic_prefix(client);
 
   az_span mqtt_topic_span = az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size);
-  int32_t required_length = az_span_size(telemetry_topic_prefix)
-      + az_span_size(client->_internal.device_id) + az_span_size(telemetry_topic_suffix);
-  int32_t module_id_length = az_span_size(*module_id);
-  if (module_id_length > 0)
-  {
-    required_length += az_span_size(telemetry_topic_modules_mid) + module_id_length;
-  }
-  if (properties != NULL)
+  int32_t const required_length = _az_iot_hub_client_telemetry_get_topic_length(client, properties);
+  int32_t module_id_length = az_span_size(module_id);
+
+  if (mqtt_topic == NULL)
   {
-    required_length += properties->_internal.properties_written;
+    // Only the length is asked for.
+    *out_mqtt_topic_length = (size_t)required_length;
+    return AZ_OK;
   }
 
   _az_RETURN_IF_NOT_ENOUGH_SIZE(
       mqtt_topic_span, required_length + (int32_t)sizeof(null_terminator));
 
-  az_span remainder = az_span_copy(mqtt_topic_span, telemetry_topic_prefix);
-  remainder = az_span_copy(remainder, client->_internal.device_id);
-
-  if (module_id_length > 0)
+  az_span remainder;
+  if (az_span_size(cached_prefix) > 0)
   {
-    remainder = az_span_copy(remainder, telemetry_topic_modules_mid);
-    remainder = az_span_copy(remainder, *module_id);
+    remainder = az_span_copy(mqtt_topic_span, cached_prefix);
   }
+  else
+  {
+    remainder = az_span_copy(mqtt_topic_span, telemetry_topic_prefix);
+    remainder = az_span_copy(remainder, client->_internal.device_id);
+
+    if (module_id_length > 0)
+    {
+      remainder = az_span_copy(remainder, telemetry_topic_modules_mid);
+      remainder = az_span_copy(remainder, module_id);
+    }
 
-  remainder = az_span_copy(remainder, telemetry_topic_suffix);
+    remainder = az_span_copy(remainder, telemetry_topic_suffix);
+  }
 
   if (properties != NULL)
   {
@@ -67,6 +103,8 @@ AZ_NODISCARD az_result az_iot_hub_client_telemetry_get_publish_topic(
 
   az_span_copy_u8(remainder, null_terminator);
 
+  _az_BUFFER_STATS_RECORD(
+      _az_BUFFER_STATS_IOT_MQTT_TOPIC, required_length + (int32_t)sizeof(null_terminator));
   if (out_mqtt_topic_length)
   {
     *out_mqtt_topic_length = (size_t)required_length;
@@ -74,3 +112,660 @@ AZ_NODISCARD az_result az_iot_hub_client_telemetry_get_publish_topic(
 
   return AZ_OK;
 }
+
+AZ_NODISCARD az_iot_hub_client_telemetry_batch_options
+az_iot_hub_client_telemetry_batch_options_default()
+{
+  return (az_iot_hub_client_telemetry_batch_options){
+    .max_payload_size = 0,
+    .max_age_seconds = 0,
+  };
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_batch_init(
+    az_iot_hub_client_telemetry_batch* batch,
+    az_span payload_buffer,
+    az_iot_hub_client_telemetry_batch_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION_VALID_SPAN(payload_buffer, 2, false);
+  _az_PRECONDITION(options == NULL || options->max_payload_size >= 0);
+
+  batch->_internal.payload_buffer = payload_buffer;
+  batch->_internal.options
+      = options == NULL ? az_iot_hub_client_telemetry_batch_options_default() : *options;
+
+  return az_iot_hub_client_telemetry_batch_reset(batch);
+}
+
+AZ_NODISCARD az_result
+az_iot_hub_client_telemetry_batch_reset(az_iot_hub_client_telemetry_batch* batch)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+
+  // The last byte is kept for the ']' which closes the array, so that a reading which fits can
+  // always be completed into a payload.
+  az_span const payload_buffer = batch->_internal.payload_buffer;
+  _az_RETURN_IF_FAILED(az_json_writer_init(
+      &batch->_internal.writer,
+      az_span_slice(payload_buffer, 0, az_span_size(payload_buffer) - 1),
+      NULL));
+  _az_RETURN_IF_FAILED(az_json_writer_append_begin_array(&batch->_internal.writer));
+
+  batch->_internal.reading_count = 0;
+  batch->_internal.first_reading_time = 0;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_batch_append_reading(
+    az_iot_hub_client_telemetry_batch* batch,
+    az_span json_reading,
+    uint64_t current_epoch_time)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION_VALID_SPAN(json_reading, 1, false);
+
+  // Appending can fail part way through, so the writer is restored to leave the batch unchanged.
+  az_json_writer const saved_writer = batch->_internal.writer;
+  az_result const result = az_json_writer_append_json_text(&batch->_internal.writer, json_reading);
+  if (az_result_failed(result))
+  {
+    batch->_internal.writer = saved_writer;
+    return result;
+  }
+
+  if (batch->_internal.reading_count == 0)
+  {
+    batch->_internal.first_reading_time = current_epoch_time;
+  }
+
+  batch->_internal.reading_count++;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD bool az_iot_hub_client_telemetry_batch_should_flush(
+    az_iot_hub_client_telemetry_batch const* batch,
+    uint64_t current_epoch_time)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+
+  if (batch->_internal.reading_count == 0)
+  {
+    return false;
+  }
+
+  int32_t const max_payload_size = batch->_internal.options.max_payload_size;
+  int32_t const payload_size
+      = az_span_size(az_json_writer_get_bytes_used_in_destination(&batch->_internal.writer))
+      + 1 /* ']' */;
+  if (max_payload_size > 0 && payload_size >= max_payload_size)
+  {
+    return true;
+  }
+
+  uint32_t const max_age_seconds = batch->_internal.options.max_age_seconds;
+  return max_age_seconds > 0
+      && current_epoch_time >= batch->_internal.first_reading_time + max_age_seconds;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_batch_get_payload(
+    az_iot_hub_client_telemetry_batch* batch,
+    az_span* out_payload,
+    int32_t* out_reading_count)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION_NOT_NULL(out_payload);
+
+  // The writer never uses the last byte of the buffer, which is kept for the closing ']'.
+  int32_t const size
+      = az_span_size(az_json_writer_get_bytes_used_in_destination(&batch->_internal.writer));
+  az_span_ptr(batch->_internal.payload_buffer)[size] = ']';
+
+  *out_payload = az_span_slice(batch->_internal.payload_buffer, 0, size + 1);
+
+  if (out_reading_count != NULL)
+  {
+    *out_reading_count = batch->_internal.reading_count;
+  }
+
+  return AZ_OK;
+}
+
+// The queue buffer starts with a header, followed by the ring of records. The records are between
+// begin and end, or, once the ring wrapped around, between begin and wrap and then between the
+// start of the ring and end. Each record is its header, the null-terminated topic and the payload,
+// padded to a multiple of 4 bytes.
+enum
+{
+  _az_TELEMETRY_QUEUE_MAGIC = 0x51544941, // "AITQ"
+  _az_TELEMETRY_QUEUE_RECORD_MAGIC = 0xA5,
+  _az_TELEMETRY_QUEUE_QUEUED = 1,
+  _az_TELEMETRY_QUEUE_IN_FLIGHT = 2,
+  _az_TELEMETRY_QUEUE_ACKNOWLEDGED = 3,
+};
+
+typedef struct
+{
+  uint32_t magic;
+  int32_t begin;
+  int32_t end;
+  int32_t wrap;
+  int32_t count;
+  uint32_t check;
+} _az_telemetry_queue_header;
+
+typedef struct
+{
+  uint8_t magic;
+  uint8_t state;
+  uint16_t packet_id;
+  uint16_t topic_size;
+  uint16_t reserved;
+  uint32_t payload_size;
+} _az_telemetry_queue_record;
+
+#define _az_TELEMETRY_QUEUE_START ((int32_t)sizeof(_az_telemetry_queue_header))
+#define _az_TELEMETRY_QUEUE_RECORD_HEADER_SIZE ((int32_t)sizeof(_az_telemetry_queue_record))
+
+static AZ_NODISCARD uint32_t _az_telemetry_queue_get_check(_az_telemetry_queue_header const* header)
+{
+  return ~(header->magic ^ (uint32_t)header->begin ^ ((uint32_t)header->end << 8)
+           ^ ((uint32_t)header->wrap << 16) ^ ((uint32_t)header->count << 24));
+}
+
+static AZ_NODISCARD int32_t
+_az_telemetry_queue_get_record_size(int32_t topic_size, uint32_t payload_size)
+{
+  int32_t const size
+      = _az_TELEMETRY_QUEUE_RECORD_HEADER_SIZE + topic_size + 1 + (int32_t)payload_size;
+  return (size + 3) & ~3;
+}
+
+static _az_telemetry_queue_record
+_az_telemetry_queue_read_record(az_iot_hub_client_telemetry_queue const* queue, int32_t offset)
+{
+  _az_telemetry_queue_record record;
+  memcpy(&record, az_span_ptr(queue->_internal.buffer) + offset, sizeof(record));
+  return record;
+}
+
+static void _az_telemetry_queue_write_record(
+    az_iot_hub_client_telemetry_queue* queue,
+    int32_t offset,
+    _az_telemetry_queue_record const* record)
+{
+  memcpy(az_span_ptr(queue->_internal.buffer) + offset, record, sizeof(*record));
+}
+
+static AZ_NODISCARD az_result
+_az_telemetry_queue_persist(az_iot_hub_client_telemetry_queue* queue, int32_t offset, int32_t size)
+{
+  az_iot_hub_client_telemetry_queue_options const* const options = &queue->_internal.options;
+  if (options->persist == NULL)
+  {
+    return AZ_OK;
+  }
+
+  return options->persist(
+      options->persist_context,
+      offset,
+      az_span_slice(queue->_internal.buffer, offset, offset + size));
+}
+
+// The records are persisted before the header which makes them part of the queue, so a copy which
+// was interrupted while being written still holds the previous queue.
+static AZ_NODISCARD az_result
+_az_telemetry_queue_save_header(az_iot_hub_client_telemetry_queue* queue)
+{
+  _az_telemetry_queue_header header = {
+    .magic = _az_TELEMETRY_QUEUE_MAGIC,
+    .begin = queue->_internal.begin,
+    .end = queue->_internal.end,
+    .wrap = queue->_internal.wrap,
+    .count = queue->_internal.count,
+    .check = 0,
+  };
+  header.check = _az_telemetry_queue_get_check(&header);
+  memcpy(az_span_ptr(queue->_internal.buffer), &header, sizeof(header));
+
+  return _az_telemetry_queue_persist(queue, 0, _az_TELEMETRY_QUEUE_START);
+}
+
+static AZ_NODISCARD int32_t _az_telemetry_queue_get_next_offset(
+    az_iot_hub_client_telemetry_queue const* queue,
+    int32_t offset,
+    _az_telemetry_queue_record const* record)
+{
+  int32_t const next
+      = offset + _az_telemetry_queue_get_record_size(record->topic_size, record->payload_size);
+  return queue->_internal.wrap != 0 && next == queue->_internal.wrap ? _az_TELEMETRY_QUEUE_START
+                                                                   : next;
+}
+
+static void _az_telemetry_queue_remove_oldest(az_iot_hub_client_telemetry_queue* queue)
+{
+  _az_telemetry_queue_record const record
+      = _az_telemetry_queue_read_record(queue, queue->_internal.begin);
+  if (record.state == _az_TELEMETRY_QUEUE_ACKNOWLEDGED)
+  {
+    queue->_internal.acknowledged_count--;
+  }
+
+  queue->_internal.begin
+      = _az_telemetry_queue_get_next_offset(queue, queue->_internal.begin, &record);
+  if (queue->_internal.begin == _az_TELEMETRY_QUEUE_START)
+  {
+    queue->_internal.wrap = 0;
+  }
+
+  if (--queue->_internal.count == 0)
+  {
+    queue->_internal.begin = _az_TELEMETRY_QUEUE_START;
+    queue->_internal.end = _az_TELEMETRY_QUEUE_START;
+    queue->_internal.wrap = 0;
+  }
+}
+
+// Removes the acknowledged records at the start of the ring, as their space can only be reused
+// once every record before them is removed.
+static bool _az_telemetry_queue_remove_acknowledged(az_iot_hub_client_telemetry_queue* queue)
+{
+  bool removed = false;
+  while (queue->_internal.count > 0
+         && _az_telemetry_queue_read_record(queue, queue->_internal.begin).state
+             == _az_TELEMETRY_QUEUE_ACKNOWLEDGED)
+  {
+    _az_telemetry_queue_remove_oldest(queue);
+    removed = true;
+  }
+
+  return removed;
+}
+
+static AZ_NODISCARD bool _az_telemetry_queue_reserve(
+    az_iot_hub_client_telemetry_queue* queue,
+    int32_t size,
+    int32_t* out_offset)
+{
+  int32_t const capacity = az_span_size(queue->_internal.buffer);
+  int32_t const begin = queue->_internal.begin;
+  int32_t const end = queue->_internal.end;
+
+  if (queue->_internal.wrap != 0)
+  {
+    if (end + size > begin)
+    {
+      return false;
+    }
+
+    *out_offset = end;
+  }
+  else if (end + size <= capacity)
+  {
+    *out_offset = end;
+  }
+  else if (_az_TELEMETRY_QUEUE_START + size <= begin)
+  {
+    queue->_internal.wrap = end;
+    *out_offset = _az_TELEMETRY_QUEUE_START;
+  }
+  else
+  {
+    return false;
+  }
+
+  queue->_internal.end = *out_offset + size;
+  queue->_internal.count++;
+  return true;
+}
+
+AZ_NODISCARD az_iot_hub_client_telemetry_queue_options
+az_iot_hub_client_telemetry_queue_options_default()
+{
+  return (az_iot_hub_client_telemetry_queue_options){
+    .max_in_flight = 10,
+    .max_messages_per_second = 0,
+    .discard_oldest = false,
+    .persist = NULL,
+    .persist_context = NULL,
+  };
+}
+
+static void _az_telemetry_queue_set(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_span buffer,
+    az_iot_hub_client_telemetry_queue_options const* options)
+{
+  queue->_internal.buffer = buffer;
+  queue->_internal.options
+      = options == NULL ? az_iot_hub_client_telemetry_queue_options_default() : *options;
+  queue->_internal.begin = _az_TELEMETRY_QUEUE_START;
+  queue->_internal.end = _az_TELEMETRY_QUEUE_START;
+  queue->_internal.wrap = 0;
+  queue->_internal.count = 0;
+  queue->_internal.acknowledged_count = 0;
+  queue->_internal.in_flight_count = 0;
+  queue->_internal.window_start_time = 0;
+  queue->_internal.window_count = 0;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_init(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_span buffer,
+    az_iot_hub_client_telemetry_queue_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+  _az_PRECONDITION_VALID_SPAN(buffer, _az_TELEMETRY_QUEUE_START + 1, false);
+  _az_PRECONDITION(options == NULL || options->max_in_flight >= 0);
+
+  _az_telemetry_queue_set(queue, buffer, options);
+
+  return _az_telemetry_queue_save_header(queue);
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_restore(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_span buffer,
+    az_iot_hub_client_telemetry_queue_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+  _az_PRECONDITION_VALID_SPAN(buffer, _az_TELEMETRY_QUEUE_START + 1, false);
+  _az_PRECONDITION(options == NULL || options->max_in_flight >= 0);
+
+  _az_telemetry_queue_set(queue, buffer, options);
+
+  _az_telemetry_queue_header header;
+  memcpy(&header, az_span_ptr(buffer), sizeof(header));
+
+  int32_t const capacity = az_span_size(buffer);
+  bool const valid_offsets = _az_TELEMETRY_QUEUE_START <= header.begin && header.begin <= capacity
+      && _az_TELEMETRY_QUEUE_START <= header.end && header.end <= capacity
+      && (header.wrap == 0 || (header.end <= header.begin && header.begin < header.wrap
+                               && header.wrap <= capacity));
+  if (header.magic != _az_TELEMETRY_QUEUE_MAGIC
+      || header.check != _az_telemetry_queue_get_check(&header) || !valid_offsets
+      || header.count < 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  queue->_internal.begin = header.begin;
+  queue->_internal.end = header.end;
+  queue->_internal.wrap = header.wrap;
+  queue->_internal.count = header.count;
+
+  // Every record must be complete and end where the next one starts.
+  int32_t offset = header.begin;
+  bool before_wrap = header.wrap != 0;
+  for (int32_t i = 0; i < header.count; i++)
+  {
+    int32_t const limit = before_wrap ? header.wrap : header.end;
+    if (offset + _az_TELEMETRY_QUEUE_RECORD_HEADER_SIZE > limit)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+
+    _az_telemetry_queue_record record = _az_telemetry_queue_read_record(queue, offset);
+    if (record.magic != _az_TELEMETRY_QUEUE_RECORD_MAGIC
+        || record.state < _az_TELEMETRY_QUEUE_QUEUED
+        || record.state > _az_TELEMETRY_QUEUE_ACKNOWLEDGED
+        || record.payload_size > (uint32_t)(limit - offset)
+        || offset + _az_telemetry_queue_get_record_size(record.topic_size, record.payload_size)
+            > limit)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+
+    if (record.state == _az_TELEMETRY_QUEUE_IN_FLIGHT)
+    {
+      record.state = _az_TELEMETRY_QUEUE_QUEUED;
+      record.packet_id = 0;
+      _az_telemetry_queue_write_record(queue, offset, &record);
+    }
+    else if (record.state == _az_TELEMETRY_QUEUE_ACKNOWLEDGED)
+    {
+      queue->_internal.acknowledged_count++;
+    }
+
+    offset += _az_telemetry_queue_get_record_size(record.topic_size, record.payload_size);
+    if (before_wrap && offset == header.wrap)
+    {
+      offset = _az_TELEMETRY_QUEUE_START;
+      before_wrap = false;
+    }
+  }
+
+  if (before_wrap || (header.count > 0 && offset != header.end)
+      || (header.count == 0 && (header.begin != header.end || header.wrap != 0)))
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  if (_az_telemetry_queue_remove_acknowledged(queue))
+  {
+    return _az_telemetry_queue_save_header(queue);
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_enqueue(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_iot_hub_client const* client,
+    az_iot_message_properties const* properties,
+    az_span payload)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(payload, 0, true);
+
+  int32_t const topic_size = _az_iot_hub_client_telemetry_get_topic_length(client, properties);
+  int32_t const payload_size = az_span_size(payload);
+  int32_t const ring_size = az_span_size(queue->_internal.buffer) - _az_TELEMETRY_QUEUE_START;
+  if (topic_size > UINT16_MAX || payload_size > ring_size)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t const size = _az_telemetry_queue_get_record_size(topic_size, (uint32_t)payload_size);
+  if (size > ring_size)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t offset = 0;
+  bool discarded = false;
+  while (!_az_telemetry_queue_reserve(queue, size, &offset))
+  {
+    // The oldest record is discarded only if it isn't in flight, because its PUBACK would then
+    // remove a later one.
+    if (!queue->_internal.options.discard_oldest || queue->_internal.count == 0
+        || _az_telemetry_queue_read_record(queue, queue->_internal.begin).state
+            == _az_TELEMETRY_QUEUE_IN_FLIGHT)
+    {
+      if (discarded)
+      {
+        _az_RETURN_IF_FAILED(_az_telemetry_queue_save_header(queue));
+      }
+
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    _az_telemetry_queue_remove_oldest(queue);
+    (void)_az_telemetry_queue_remove_acknowledged(queue);
+    discarded = true;
+  }
+
+  int32_t const topic_offset = offset + _az_TELEMETRY_QUEUE_RECORD_HEADER_SIZE;
+  _az_RETURN_IF_FAILED(az_iot_hub_client_telemetry_get_publish_topic(
+      client,
+      properties,
+      (char*)az_span_ptr(queue->_internal.buffer) + topic_offset,
+      (size_t)topic_size + 1,
+      NULL));
+  az_span_copy(
+      az_span_slice_to_end(queue->_internal.buffer, topic_offset + topic_size + 1), payload);
+
+  _az_telemetry_queue_record const record = {
+    .magic = _az_TELEMETRY_QUEUE_RECORD_MAGIC,
+    .state = _az_TELEMETRY_QUEUE_QUEUED,
+    .packet_id = 0,
+    .topic_size = (uint16_t)topic_size,
+    .reserved = 0,
+    .payload_size = (uint32_t)payload_size,
+  };
+  _az_telemetry_queue_write_record(queue, offset, &record);
+
+  _az_RETURN_IF_FAILED(_az_telemetry_queue_persist(queue, offset, size));
+  return _az_telemetry_queue_save_header(queue);
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_enqueue_batch(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_iot_hub_client const* client,
+    az_iot_message_properties const* properties,
+    az_iot_hub_client_telemetry_batch* batch)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+
+  az_span payload;
+  _az_RETURN_IF_FAILED(az_iot_hub_client_telemetry_batch_get_payload(batch, &payload, NULL));
+  _az_RETURN_IF_FAILED(
+      az_iot_hub_client_telemetry_queue_enqueue(queue, client, properties, payload));
+
+  return az_iot_hub_client_telemetry_batch_reset(batch);
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_get_next(
+    az_iot_hub_client_telemetry_queue* queue,
+    uint64_t current_epoch_time,
+    az_iot_hub_client_telemetry_queue_message* out_message)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+  _az_PRECONDITION_NOT_NULL(out_message);
+
+  int32_t offset = queue->_internal.begin;
+  _az_telemetry_queue_record record;
+  int32_t i = 0;
+  for (; i < queue->_internal.count; i++)
+  {
+    record = _az_telemetry_queue_read_record(queue, offset);
+    if (record.state == _az_TELEMETRY_QUEUE_QUEUED)
+    {
+      break;
+    }
+
+    offset = _az_telemetry_queue_get_next_offset(queue, offset, &record);
+  }
+
+  if (i == queue->_internal.count)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  az_iot_hub_client_telemetry_queue_options const* const options = &queue->_internal.options;
+  if (options->max_in_flight > 0 && queue->_internal.in_flight_count >= options->max_in_flight)
+  {
+    return AZ_ERROR_IOT_QUEUE_THROTTLED;
+  }
+
+  if (current_epoch_time != queue->_internal.window_start_time)
+  {
+    queue->_internal.window_start_time = current_epoch_time;
+    queue->_internal.window_count = 0;
+  }
+
+  if (options->max_messages_per_second > 0
+      && queue->_internal.window_count >= options->max_messages_per_second)
+  {
+    return AZ_ERROR_IOT_QUEUE_THROTTLED;
+  }
+
+  int32_t const topic_offset = offset + _az_TELEMETRY_QUEUE_RECORD_HEADER_SIZE;
+  int32_t const payload_offset = topic_offset + record.topic_size + 1;
+  out_message->topic
+      = az_span_slice(queue->_internal.buffer, topic_offset, topic_offset + record.topic_size);
+  out_message->payload = az_span_slice(
+      queue->_internal.buffer, payload_offset, payload_offset + (int32_t)record.payload_size);
+  out_message->_internal.offset = offset;
+
+  return AZ_OK;
+}
+
+void az_iot_hub_client_telemetry_queue_mark_published(
+    az_iot_hub_client_telemetry_queue* queue,
+    az_iot_hub_client_telemetry_queue_message const* message,
+    uint16_t packet_id)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+  _az_PRECONDITION_NOT_NULL(message);
+  _az_PRECONDITION(packet_id != 0);
+
+  // Whether a message is in flight is not persisted, as it is published again once restored.
+  _az_telemetry_queue_record record
+      = _az_telemetry_queue_read_record(queue, message->_internal.offset);
+  _az_PRECONDITION(record.state == _az_TELEMETRY_QUEUE_QUEUED);
+
+  record.state = _az_TELEMETRY_QUEUE_IN_FLIGHT;
+  record.packet_id = packet_id;
+  _az_telemetry_queue_write_record(queue, message->_internal.offset, &record);
+
+  queue->_internal.in_flight_count++;
+  queue->_internal.window_count++;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_telemetry_queue_acknowledge(
+    az_iot_hub_client_telemetry_queue* queue,
+    uint16_t packet_id)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+
+  int32_t offset = queue->_internal.begin;
+  for (int32_t i = 0; i < queue->_internal.count; i++)
+  {
+    _az_telemetry_queue_record record = _az_telemetry_queue_read_record(queue, offset);
+    if (record.state == _az_TELEMETRY_QUEUE_IN_FLIGHT && record.packet_id == packet_id)
+    {
+      record.state = _az_TELEMETRY_QUEUE_ACKNOWLEDGED;
+      _az_telemetry_queue_write_record(queue, offset, &record);
+      queue->_internal.in_flight_count--;
+      queue->_internal.acknowledged_count++;
+
+      // A message acknowledged before older ones stays in the ring until they are, so its state
+      // is persisted for it not to be published again after a restart.
+      if (_az_telemetry_queue_remove_acknowledged(queue))
+      {
+        return _az_telemetry_queue_save_header(queue);
+      }
+
+      return _az_telemetry_queue_persist(queue, offset, _az_TELEMETRY_QUEUE_RECORD_HEADER_SIZE);
+    }
+
+    offset = _az_telemetry_queue_get_next_offset(queue, offset, &record);
+  }
+
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
+
+void az_iot_hub_client_telemetry_queue_requeue_in_flight(az_iot_hub_client_telemetry_queue* queue)
+{
+  _az_PRECONDITION_NOT_NULL(queue);
+
+  int32_t offset = queue->_internal.begin;
+  for (int32_t i = 0; i < queue->_internal.count; i++)
+  {
+    _az_telemetry_queue_record record = _az_telemetry_queue_read_record(queue, offset);
+    if (record.state == _az_TELEMETRY_QUEUE_IN_FLIGHT)
+    {
+      record.state = _az_TELEMETRY_QUEUE_QUEUED;
+      record.packet_id = 0;
+      _az_telemetry_queue_write_record(queue, offset, &record);
+    }
+
+    offset = _az_telemetry_queue_get_next_offset(queue, offset, &record);
+  }
+
+  queue->_internal.in_flight_count = 0;
+}
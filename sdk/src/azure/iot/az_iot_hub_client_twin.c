@@ -1,16 +1,21 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <azure/core/az_json.h>
 #include <azure/core/az_precondition.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_log_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 #include <azure/iot/az_iot_hub_client.h>
+#include <azure/iot/internal/az_iot_common_internal.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -24,6 +29,7 @@ static const az_span az_iot_hub_twin_get_pub_topic = AZ_SPAN_LITERAL_FROM_STR("G
 static const az_span az_iot_hub_twin_version_prop = AZ_SPAN_LITERAL_FROM_STR("$version");
 static const az_span az_iot_hub_twin_patch_pub_topic
     = AZ_SPAN_LITERAL_FROM_STR("PATCH/properties/reported/");
+static const az_span az_iot_hub_twin_desired_prop = AZ_SPAN_LITERAL_FROM_STR("desired");
 static const az_span az_iot_hub_twin_patch_sub_topic
     = AZ_SPAN_LITERAL_FROM_STR("PATCH/properties/desired/");
 
@@ -36,31 +42,33 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_document_get_publish_topic(
 {
   _az_PRECONDITION_NOT_NULL(client);
   _az_PRECONDITION_VALID_SPAN(request_id, 1, false);
-  _az_PRECONDITION_NOT_NULL(mqtt_topic);
-  _az_PRECONDITION(mqtt_topic_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_topic, mqtt_topic_size, out_mqtt_topic_length);
   (void)client;
 
-  az_span mqtt_topic_span = az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size);
-  int32_t required_length = az_span_size(az_iot_hub_twin_topic_prefix)
-      + az_span_size(az_iot_hub_twin_get_pub_topic)
-      + (int32_t)sizeof(az_iot_hub_client_twin_question)
-      + az_span_size(az_iot_hub_client_request_id_span)
-      + (int32_t)sizeof(az_iot_hub_client_twin_equals) + az_span_size(request_id);
-
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_topic_span, required_length + (int32_t)sizeof(null_terminator));
-
-  az_span remainder = az_span_copy(mqtt_topic_span, az_iot_hub_twin_topic_prefix);
-  remainder = az_span_copy(remainder, az_iot_hub_twin_get_pub_topic);
-  remainder = az_span_copy_u8(remainder, az_iot_hub_client_twin_question);
-  remainder = az_span_copy(remainder, az_iot_hub_client_request_id_span);
-  remainder = az_span_copy_u8(remainder, az_iot_hub_client_twin_equals);
-  remainder = az_span_copy(remainder, request_id);
-  az_span_copy_u8(remainder, null_terminator);
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size));
+  _az_span_builder_append(&builder, az_iot_hub_twin_topic_prefix);
+  _az_span_builder_append(&builder, az_iot_hub_twin_get_pub_topic);
+  _az_span_builder_append_u8(&builder, az_iot_hub_client_twin_question);
+  _az_span_builder_append(&builder, az_iot_hub_client_request_id_span);
+  _az_span_builder_append_u8(&builder, az_iot_hub_client_twin_equals);
+  _az_span_builder_append(&builder, request_id);
+  _az_span_builder_append_u8(&builder, null_terminator);
+  if (mqtt_topic == NULL)
+  {
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
+    return AZ_OK;
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_TOPIC, _az_span_builder_length(&builder));
   if (out_mqtt_topic_length)
   {
-    *out_mqtt_topic_length = (size_t)required_length;
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
   }
 
   return AZ_OK;
@@ -75,31 +83,33 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_patch_get_publish_topic(
 {
   _az_PRECONDITION_NOT_NULL(client);
   _az_PRECONDITION_VALID_SPAN(request_id, 1, false);
-  _az_PRECONDITION_NOT_NULL(mqtt_topic);
-  _az_PRECONDITION(mqtt_topic_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_topic, mqtt_topic_size, out_mqtt_topic_length);
   (void)client;
 
-  az_span mqtt_topic_span = az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size);
-  int32_t required_length = az_span_size(az_iot_hub_twin_topic_prefix)
-      + az_span_size(az_iot_hub_twin_patch_pub_topic)
-      + (int32_t)sizeof(az_iot_hub_client_twin_question)
-      + az_span_size(az_iot_hub_client_request_id_span)
-      + (int32_t)sizeof(az_iot_hub_client_twin_equals) + az_span_size(request_id);
-
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_topic_span, required_length + (int32_t)sizeof(null_terminator));
-
-  az_span remainder = az_span_copy(mqtt_topic_span, az_iot_hub_twin_topic_prefix);
-  remainder = az_span_copy(remainder, az_iot_hub_twin_patch_pub_topic);
-  remainder = az_span_copy_u8(remainder, az_iot_hub_client_twin_question);
-  remainder = az_span_copy(remainder, az_iot_hub_client_request_id_span);
-  remainder = az_span_copy_u8(remainder, az_iot_hub_client_twin_equals);
-  remainder = az_span_copy(remainder, request_id);
-  az_span_copy_u8(remainder, null_terminator);
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size));
+  _az_span_builder_append(&builder, az_iot_hub_twin_topic_prefix);
+  _az_span_builder_append(&builder, az_iot_hub_twin_patch_pub_topic);
+  _az_span_builder_append_u8(&builder, az_iot_hub_client_twin_question);
+  _az_span_builder_append(&builder, az_iot_hub_client_request_id_span);
+  _az_span_builder_append_u8(&builder, az_iot_hub_client_twin_equals);
+  _az_span_builder_append(&builder, request_id);
+  _az_span_builder_append_u8(&builder, null_terminator);
+  if (mqtt_topic == NULL)
+  {
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
+    return AZ_OK;
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_TOPIC, _az_span_builder_length(&builder));
   if (out_mqtt_topic_length)
   {
-    *out_mqtt_topic_length = (size_t)required_length;
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof(null_terminator));
   }
 
   return AZ_OK;
@@ -117,9 +127,11 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_parse_received_topic(
 
   az_result result;
 
-  int32_t twin_index;
-  // Check if is related to twin or not
-  if ((twin_index = az_span_find(received_topic, az_iot_hub_twin_topic_prefix)) >= 0)
+  // Check if is related to twin or not, which IoT Hub publishes with the prefix at the start.
+  int32_t const twin_index = _az_span_starts_with(received_topic, az_iot_hub_twin_topic_prefix)
+      ? 0
+      : az_span_find(received_topic, az_iot_hub_twin_topic_prefix);
+  if (twin_index >= 0)
   {
     _az_LOG_WRITE(AZ_LOG_MQTT_RECEIVED_TOPIC, received_topic);
 
@@ -210,3 +222,811 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_parse_received_topic(
 
   return result;
 }
+
+// The value hash recorded for an object, whose properties have their own records.
+#define _az_TWIN_DESIRED_OBJECT_HASH 0
+#define _az_TWIN_DESIRED_EMPTY_RECORD 0
+
+#define _az_FNV1A_64_OFFSET_BASIS 14695981039346656037ull
+#define _az_FNV1A_64_PRIME 1099511628211ull
+
+static AZ_NODISCARD uint64_t _az_twin_desired_hash(uint64_t hash, az_span span)
+{
+  uint8_t const* ptr = az_span_ptr(span);
+  for (int32_t i = 0; i < az_span_size(span); i++)
+  {
+    hash = (hash ^ ptr[i]) * _az_FNV1A_64_PRIME;
+  }
+  return hash;
+}
+
+static AZ_NODISCARD uint64_t _az_twin_desired_hash_token(uint64_t hash, az_json_token const* token)
+{
+  hash = (hash ^ (uint64_t)token->kind) * _az_FNV1A_64_PRIME;
+  return _az_twin_desired_hash(hash, token->slice);
+}
+
+static void _az_twin_desired_tracker_clear(az_iot_hub_client_twin_desired_tracker* tracker)
+{
+  for (int32_t i = 0; i < tracker->_internal.record_capacity; i++)
+  {
+    tracker->_internal.records[i]._internal.path_hash = _az_TWIN_DESIRED_EMPTY_RECORD;
+  }
+  tracker->_internal.record_count = 0;
+}
+
+// Returns the record of the path, or the empty record where it would be inserted.
+static AZ_NODISCARD az_iot_hub_client_twin_desired_record* _az_twin_desired_tracker_probe(
+    az_iot_hub_client_twin_desired_tracker const* tracker,
+    uint64_t path_hash)
+{
+  uint64_t const mask = (uint64_t)tracker->_internal.record_capacity - 1;
+  uint64_t index = path_hash & mask;
+
+  // At most three quarters of the records are used, so an empty one always ends the probing.
+  while (tracker->_internal.records[index]._internal.path_hash != _az_TWIN_DESIRED_EMPTY_RECORD
+         && tracker->_internal.records[index]._internal.path_hash != path_hash)
+  {
+    index = (index + 1) & mask;
+  }
+
+  return &tracker->_internal.records[index];
+}
+
+// Records the value of a path, and returns whether it differs from the recorded one.
+static bool _az_twin_desired_tracker_update(
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    uint64_t path_hash,
+    uint64_t value_hash)
+{
+  az_iot_hub_client_twin_desired_record* record
+      = _az_twin_desired_tracker_probe(tracker, path_hash);
+
+  if (record->_internal.path_hash == path_hash)
+  {
+    if (record->_internal.value_hash == value_hash)
+    {
+      return false;
+    }
+
+    if (record->_internal.value_hash != _az_TWIN_DESIRED_OBJECT_HASH)
+    {
+      record->_internal.value_hash = value_hash;
+      return true;
+    }
+
+    // An object was replaced, and only the hashes of the paths of its properties are known, so
+    // every record is dropped rather than leaving stale ones behind.
+    _az_twin_desired_tracker_clear(tracker);
+    record = _az_twin_desired_tracker_probe(tracker, path_hash);
+  }
+
+  int32_t const capacity = tracker->_internal.record_capacity;
+  if (tracker->_internal.record_count < capacity - capacity / 4)
+  {
+    record->_internal.path_hash = path_hash;
+    record->_internal.value_hash = value_hash;
+    tracker->_internal.record_count++;
+  }
+
+  return true;
+}
+
+void az_iot_hub_client_twin_desired_tracker_init(
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_desired_record* records,
+    int32_t record_capacity)
+{
+  _az_PRECONDITION_NOT_NULL(tracker);
+  _az_PRECONDITION_NOT_NULL(records);
+  _az_PRECONDITION(record_capacity >= 4);
+  _az_PRECONDITION((record_capacity & (record_capacity - 1)) == 0);
+
+  tracker->_internal.records = records;
+  tracker->_internal.record_capacity = record_capacity;
+  tracker->_internal.version = -1;
+  _az_twin_desired_tracker_clear(tracker);
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_twin_desired_changes_init(
+    az_iot_hub_client_twin_desired_changes* changes,
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_response_type response_type,
+    az_span json,
+    az_span path_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(changes);
+  _az_PRECONDITION_NOT_NULL(tracker);
+  _az_PRECONDITION(
+      response_type == AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET
+      || response_type == AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES);
+  _az_PRECONDITION_VALID_SPAN(json, 1, false);
+  _az_PRECONDITION_VALID_SPAN(path_buffer, 1, false);
+
+  changes->_internal.tracker = tracker;
+  changes->_internal.json = json;
+  changes->_internal.path_buffer = path_buffer;
+  changes->_internal.depth = 0;
+  changes->_internal.version = -1;
+  changes->_internal.done = false;
+
+  az_json_reader* reader = &changes->_internal.reader;
+  _az_RETURN_IF_FAILED(az_json_reader_init(reader, json, NULL));
+
+  if (response_type == AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET)
+  {
+    _az_RETURN_IF_FAILED(az_json_reader_find_path(reader, az_iot_hub_twin_desired_prop));
+  }
+  else
+  {
+    _az_RETURN_IF_FAILED(az_json_reader_next_token(reader));
+  }
+
+  if (reader->token.kind != AZ_JSON_TOKEN_BEGIN_OBJECT)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  // The version usually comes last, so it is looked up with a copy of the reader which skips over
+  // the properties.
+  az_json_reader version_reader = *reader;
+  az_result const result = az_json_reader_find_path(&version_reader, az_iot_hub_twin_version_prop);
+  if (az_result_succeeded(result) && version_reader.token.kind == AZ_JSON_TOKEN_NUMBER)
+  {
+    _az_RETURN_IF_FAILED(
+        az_json_token_get_int64(&version_reader.token, &changes->_internal.version));
+  }
+  else if (result != AZ_ERROR_ITEM_NOT_FOUND)
+  {
+    _az_RETURN_IF_FAILED(result);
+  }
+
+  if (changes->_internal.version >= 0 && changes->_internal.version <= tracker->_internal.version)
+  {
+    changes->_internal.done = true;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_twin_desired_changes_next(
+    az_iot_hub_client_twin_desired_changes* changes,
+    az_span* out_path,
+    az_json_token* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(changes);
+  _az_PRECONDITION_NOT_NULL(out_path);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  az_json_reader* reader = &changes->_internal.reader;
+  az_span const path_buffer = changes->_internal.path_buffer;
+
+  while (!changes->_internal.done)
+  {
+    _az_RETURN_IF_FAILED(az_json_reader_next_token(reader));
+
+    if (reader->token.kind == AZ_JSON_TOKEN_END_OBJECT)
+    {
+      if (changes->_internal.depth > 0)
+      {
+        changes->_internal.depth--;
+        continue;
+      }
+
+      if (changes->_internal.version >= 0)
+      {
+        changes->_internal.tracker->_internal.version = changes->_internal.version;
+      }
+      changes->_internal.done = true;
+      break;
+    }
+
+    int32_t const depth = changes->_internal.depth;
+    if (depth == 0 && az_span_size(reader->token.slice) > 0
+        && az_span_ptr(reader->token.slice)[0] == '$')
+    {
+      // Metadata such as $metadata can be larger than the properties, and isn't validated.
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(reader));
+      _az_RETURN_IF_FAILED(az_json_reader_fast_skip_children(reader));
+      continue;
+    }
+
+    // The path of the property is its name appended to the path of the enclosing object.
+    az_span remainder = az_span_slice_to_end(
+        path_buffer, depth == 0 ? 0 : changes->_internal.path_lengths[depth - 1]);
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, reader->token.size + (depth == 0 ? 0 : 1));
+    if (depth > 0)
+    {
+      remainder = az_span_copy_u8(remainder, '.');
+    }
+    remainder = az_json_token_copy_into_span(&reader->token, remainder);
+
+    int32_t const path_length = az_span_size(path_buffer) - az_span_size(remainder);
+    az_span const path = az_span_slice(path_buffer, 0, path_length);
+    uint64_t path_hash = _az_twin_desired_hash(_az_FNV1A_64_OFFSET_BASIS, path);
+    if (path_hash == _az_TWIN_DESIRED_EMPTY_RECORD)
+    {
+      path_hash++;
+    }
+
+    _az_RETURN_IF_FAILED(az_json_reader_next_token(reader));
+
+    if (reader->token.kind == AZ_JSON_TOKEN_BEGIN_OBJECT)
+    {
+      if (depth == AZ_IOT_HUB_CLIENT_TWIN_DESIRED_MAX_DEPTH)
+      {
+        return AZ_ERROR_NOT_SUPPORTED;
+      }
+
+      _az_twin_desired_tracker_update(
+          changes->_internal.tracker, path_hash, _az_TWIN_DESIRED_OBJECT_HASH);
+      changes->_internal.path_lengths[depth] = path_length;
+      changes->_internal.depth++;
+      continue;
+    }
+
+    az_json_token value = reader->token;
+    uint64_t value_hash = _az_twin_desired_hash_token(_az_FNV1A_64_OFFSET_BASIS, &value);
+
+    if (value.kind == AZ_JSON_TOKEN_BEGIN_ARRAY)
+    {
+      // An array is a single value, hashed along with every token within it.
+      int32_t nesting = 1;
+      while (nesting > 0)
+      {
+        _az_RETURN_IF_FAILED(az_json_reader_next_token(reader));
+        value_hash = _az_twin_desired_hash_token(value_hash, &reader->token);
+
+        if (reader->token.kind == AZ_JSON_TOKEN_BEGIN_ARRAY
+            || reader->token.kind == AZ_JSON_TOKEN_BEGIN_OBJECT)
+        {
+          nesting++;
+        }
+        else if (
+            reader->token.kind == AZ_JSON_TOKEN_END_ARRAY
+            || reader->token.kind == AZ_JSON_TOKEN_END_OBJECT)
+        {
+          nesting--;
+        }
+      }
+
+      uint8_t* const start = az_span_ptr(value.slice);
+      value.size = (int32_t)(az_span_ptr(reader->token.slice) + 1 - start);
+      value.slice = az_span_create(start, value.size);
+    }
+
+    if (value_hash == _az_TWIN_DESIRED_OBJECT_HASH)
+    {
+      value_hash++;
+    }
+
+    if (_az_twin_desired_tracker_update(changes->_internal.tracker, path_hash, value_hash))
+    {
+      *out_path = path;
+      *out_value = value;
+      return AZ_OK;
+    }
+  }
+
+  return AZ_ERROR_IOT_END_OF_PROPERTIES;
+}
+
+// For the quotes around the name, the key:value separator colon and the comma which follows.
+#define _az_TWIN_REPORTED_PROPERTY_OVERHEAD 4
+
+static AZ_NODISCARD az_result _az_twin_reported_validate_value(az_span json_value)
+{
+  az_json_reader reader;
+  _az_RETURN_IF_FAILED(az_json_reader_init(&reader, json_value, NULL));
+  _az_RETURN_IF_FAILED(az_json_reader_next_token(&reader));
+  _az_RETURN_IF_FAILED(az_json_reader_skip_children(&reader));
+
+  az_result const result = az_json_reader_next_token(&reader);
+  if (result == AZ_ERROR_JSON_READER_DONE)
+  {
+    return AZ_OK;
+  }
+
+  return az_result_failed(result) ? result : AZ_ERROR_UNEXPECTED_CHAR;
+}
+
+static void _az_twin_reported_batch_remove_pending(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_iot_hub_client_twin_reported_property* property)
+{
+  property->_internal.is_pending = false;
+  batch->_internal.pending_count--;
+  batch->_internal.pending_size -= az_span_size(property->_internal.name)
+      + az_span_size(property->_internal.pending_value) + _az_TWIN_REPORTED_PROPERTY_OVERHEAD;
+  property->_internal.pending_value = AZ_SPAN_EMPTY;
+}
+
+AZ_NODISCARD az_iot_hub_client_twin_reported_batch_options
+az_iot_hub_client_twin_reported_batch_options_default()
+{
+  return (az_iot_hub_client_twin_reported_batch_options){
+    .max_patch_size = 0,
+    .max_delay_seconds = 0,
+  };
+}
+
+void az_iot_hub_client_twin_reported_batch_init(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_iot_hub_client_twin_reported_property* properties,
+    int32_t property_capacity,
+    az_span value_buffer,
+    az_iot_hub_client_twin_reported_batch_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION_NOT_NULL(properties);
+  _az_PRECONDITION(property_capacity > 0);
+  _az_PRECONDITION_VALID_SPAN(value_buffer, 1, false);
+  _az_PRECONDITION(options == NULL || options->max_patch_size >= 0);
+
+  batch->_internal.properties = properties;
+  batch->_internal.property_capacity = property_capacity;
+  batch->_internal.property_count = 0;
+  batch->_internal.value_buffer = value_buffer;
+  batch->_internal.value_buffer_used = 0;
+  batch->_internal.options
+      = options == NULL ? az_iot_hub_client_twin_reported_batch_options_default() : *options;
+  batch->_internal.pending_count = 0;
+  batch->_internal.pending_size = 0;
+  batch->_internal.first_pending_time = 0;
+  batch->_internal.is_patch_in_flight = false;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_twin_reported_batch_set(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_span name,
+    az_span json_value,
+    uint64_t current_epoch_time)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION_VALID_SPAN(name, 1, false);
+  _az_PRECONDITION_VALID_SPAN(json_value, 1, false);
+
+  _az_RETURN_IF_FAILED(_az_twin_reported_validate_value(json_value));
+
+  az_iot_hub_client_twin_reported_property* property = NULL;
+  for (int32_t i = 0; i < batch->_internal.property_count; i++)
+  {
+    if (az_span_is_content_equal(batch->_internal.properties[i]._internal.name, name))
+    {
+      property = &batch->_internal.properties[i];
+      break;
+    }
+  }
+
+  bool const is_new = property == NULL;
+  if (is_new)
+  {
+    if (batch->_internal.property_count == batch->_internal.property_capacity)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    property = &batch->_internal.properties[batch->_internal.property_count];
+    property->_internal.name = name;
+    property->_internal.pending_value = AZ_SPAN_EMPTY;
+    property->_internal.is_pending = false;
+    property->_internal.is_sent = false;
+    property->_internal.is_acknowledged = false;
+  }
+
+  uint64_t const hash = _az_twin_desired_hash(_az_FNV1A_64_OFFSET_BASIS, json_value);
+
+  // This is the value IoT Hub holds once the patch in flight, if any, is acknowledged.
+  if ((property->_internal.is_sent && property->_internal.sent_hash == hash)
+      || (!property->_internal.is_sent && property->_internal.is_acknowledged
+          && property->_internal.acknowledged_hash == hash))
+  {
+    if (property->_internal.is_pending)
+    {
+      _az_twin_reported_batch_remove_pending(batch, property);
+    }
+    return AZ_OK;
+  }
+
+  if (property->_internal.is_pending && property->_internal.pending_hash == hash)
+  {
+    return AZ_OK;
+  }
+
+  // A replaced value is left in the buffer until the next patch is built.
+  az_span const value
+      = az_span_slice_to_end(batch->_internal.value_buffer, batch->_internal.value_buffer_used);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(value, az_span_size(json_value));
+  az_span_copy(value, json_value);
+  batch->_internal.value_buffer_used += az_span_size(json_value);
+
+  if (is_new)
+  {
+    batch->_internal.property_count++;
+  }
+
+  if (property->_internal.is_pending)
+  {
+    batch->_internal.pending_size -= az_span_size(property->_internal.pending_value);
+  }
+  else
+  {
+    if (batch->_internal.pending_count == 0)
+    {
+      batch->_internal.first_pending_time = current_epoch_time;
+    }
+    batch->_internal.pending_count++;
+    batch->_internal.pending_size
+        += az_span_size(property->_internal.name) + _az_TWIN_REPORTED_PROPERTY_OVERHEAD;
+  }
+
+  property->_internal.pending_value = az_span_slice(value, 0, az_span_size(json_value));
+  property->_internal.pending_hash = hash;
+  property->_internal.is_pending = true;
+  batch->_internal.pending_size += az_span_size(json_value);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD bool az_iot_hub_client_twin_reported_batch_should_flush(
+    az_iot_hub_client_twin_reported_batch const* batch,
+    uint64_t current_epoch_time)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+
+  if (batch->_internal.pending_count == 0 || batch->_internal.is_patch_in_flight)
+  {
+    return false;
+  }
+
+  int32_t const max_patch_size = batch->_internal.options.max_patch_size;
+  if (max_patch_size > 0 && batch->_internal.pending_size >= max_patch_size)
+  {
+    return true;
+  }
+
+  uint32_t const max_delay_seconds = batch->_internal.options.max_delay_seconds;
+  return max_delay_seconds > 0
+      && current_epoch_time >= batch->_internal.first_pending_time + max_delay_seconds;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_twin_reported_batch_get_patch(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_span destination,
+    az_span* out_patch)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION(!batch->_internal.is_patch_in_flight);
+  _az_PRECONDITION_VALID_SPAN(destination, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_patch);
+
+  az_iot_hub_client_twin_reported_property* properties = batch->_internal.properties;
+  int32_t const property_count = batch->_internal.property_count;
+
+  az_json_writer writer;
+  _az_RETURN_IF_FAILED(az_json_writer_init(&writer, destination, NULL));
+  _az_RETURN_IF_FAILED(az_json_writer_append_begin_object(&writer));
+
+  for (int32_t i = 0; i < property_count; i++)
+  {
+    if (properties[i]._internal.is_pending)
+    {
+      _az_RETURN_IF_FAILED(
+          az_json_writer_append_property_name(&writer, properties[i]._internal.name));
+      _az_RETURN_IF_FAILED(
+          az_json_writer_append_json_text(&writer, properties[i]._internal.pending_value));
+    }
+  }
+
+  _az_RETURN_IF_FAILED(az_json_writer_append_end_object(&writer));
+
+  for (int32_t i = 0; i < property_count; i++)
+  {
+    if (properties[i]._internal.is_pending)
+    {
+      properties[i]._internal.sent_hash = properties[i]._internal.pending_hash;
+      properties[i]._internal.is_sent = true;
+      properties[i]._internal.is_pending = false;
+      properties[i]._internal.pending_value = AZ_SPAN_EMPTY;
+    }
+  }
+
+  batch->_internal.value_buffer_used = 0;
+  batch->_internal.pending_count = 0;
+  batch->_internal.pending_size = 0;
+  batch->_internal.is_patch_in_flight = true;
+
+  *out_patch = az_json_writer_get_bytes_used_in_destination(&writer);
+  return AZ_OK;
+}
+
+void az_iot_hub_client_twin_reported_batch_acknowledge(
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_iot_status status)
+{
+  _az_PRECONDITION_NOT_NULL(batch);
+  _az_PRECONDITION(batch->_internal.is_patch_in_flight);
+
+  bool const is_accepted = az_iot_status_succeeded(status);
+
+  for (int32_t i = 0; i < batch->_internal.property_count; i++)
+  {
+    az_iot_hub_client_twin_reported_property* property = &batch->_internal.properties[i];
+    if (property->_internal.is_sent)
+    {
+      if (is_accepted)
+      {
+        property->_internal.acknowledged_hash = property->_internal.sent_hash;
+        property->_internal.is_acknowledged = true;
+      }
+      property->_internal.is_sent = false;
+    }
+  }
+
+  batch->_internal.is_patch_in_flight = false;
+}
+
+// The image of a twin cache is its header, followed by the used records of the desired tracker and
+// then by each acknowledged reported property, as its header followed by its name. The check is a
+// hash of the whole image, taken while the check itself is zero, so that an image whose write was
+// interrupted is not restored.
+enum
+{
+  _az_TWIN_CACHE_MAGIC = 0x43544941, // "AITC"
+};
+
+typedef struct
+{
+  uint32_t magic;
+  int32_t size;
+  int32_t record_count;
+  int32_t property_count;
+  int64_t version;
+  uint64_t check;
+} _az_twin_cache_header;
+
+typedef struct
+{
+  uint64_t acknowledged_hash;
+  int32_t name_size;
+  int32_t reserved;
+} _az_twin_cache_property;
+
+#define _az_TWIN_CACHE_HEADER_SIZE ((int32_t)sizeof(_az_twin_cache_header))
+#define _az_TWIN_CACHE_RECORD_SIZE ((int32_t)sizeof(az_iot_hub_client_twin_desired_record))
+#define _az_TWIN_CACHE_PROPERTY_SIZE ((int32_t)sizeof(_az_twin_cache_property))
+
+static AZ_NODISCARD uint64_t _az_twin_cache_get_check(az_span image)
+{
+  _az_twin_cache_header header;
+  memcpy(&header, az_span_ptr(image), sizeof(header));
+  header.check = 0;
+
+  uint64_t const check = _az_twin_desired_hash(
+      _az_FNV1A_64_OFFSET_BASIS,
+      az_span_create((uint8_t*)&header, _az_TWIN_CACHE_HEADER_SIZE));
+  return _az_twin_desired_hash(check, az_span_slice_to_end(image, _az_TWIN_CACHE_HEADER_SIZE));
+}
+
+void az_iot_hub_client_twin_cache_init(
+    az_iot_hub_client_twin_cache* cache,
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_reported_batch* batch,
+    az_span buffer,
+    az_iot_hub_client_twin_cache_store_fn store,
+    void* store_context)
+{
+  _az_PRECONDITION_NOT_NULL(cache);
+  _az_PRECONDITION_NOT_NULL(tracker);
+  _az_PRECONDITION_VALID_SPAN(buffer, _az_TWIN_CACHE_HEADER_SIZE, false);
+  _az_PRECONDITION_NOT_NULL(store);
+
+  cache->_internal.tracker = tracker;
+  cache->_internal.batch = batch;
+  cache->_internal.buffer = buffer;
+  cache->_internal.store = store;
+  cache->_internal.store_context = store_context;
+  cache->_internal.stored_check = 0;
+  cache->_internal.is_stored = false;
+}
+
+static AZ_NODISCARD az_result
+_az_twin_cache_restore(az_iot_hub_client_twin_cache* cache, az_span image)
+{
+  if (az_span_size(image) < _az_TWIN_CACHE_HEADER_SIZE)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  _az_twin_cache_header header;
+  memcpy(&header, az_span_ptr(image), sizeof(header));
+  if (header.magic != _az_TWIN_CACHE_MAGIC || header.size < _az_TWIN_CACHE_HEADER_SIZE
+      || header.size > az_span_size(image) || header.record_count < 0
+      || header.property_count < 0
+      || header.record_count
+          > (header.size - _az_TWIN_CACHE_HEADER_SIZE) / _az_TWIN_CACHE_RECORD_SIZE)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  image = az_span_slice(image, 0, header.size);
+  if (header.check != _az_twin_cache_get_check(image))
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  az_iot_hub_client_twin_desired_tracker* const tracker = cache->_internal.tracker;
+  int32_t const capacity = tracker->_internal.record_capacity;
+  if (header.record_count > capacity - capacity / 4)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t offset = _az_TWIN_CACHE_HEADER_SIZE;
+  for (int32_t i = 0; i < header.record_count; i++)
+  {
+    az_iot_hub_client_twin_desired_record record;
+    memcpy(&record, az_span_ptr(image) + offset, sizeof(record));
+    offset += _az_TWIN_CACHE_RECORD_SIZE;
+
+    az_iot_hub_client_twin_desired_record* const slot
+        = _az_twin_desired_tracker_probe(tracker, record._internal.path_hash);
+    if (record._internal.path_hash == _az_TWIN_DESIRED_EMPTY_RECORD
+        || slot->_internal.path_hash == record._internal.path_hash)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+
+    *slot = record;
+    tracker->_internal.record_count++;
+  }
+  tracker->_internal.version = header.version;
+
+  az_iot_hub_client_twin_reported_batch* const batch = cache->_internal.batch;
+  for (int32_t i = 0; i < header.property_count; i++)
+  {
+    _az_twin_cache_property property;
+    if (offset + _az_TWIN_CACHE_PROPERTY_SIZE > header.size)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+    memcpy(&property, az_span_ptr(image) + offset, sizeof(property));
+    offset += _az_TWIN_CACHE_PROPERTY_SIZE;
+
+    if (property.name_size <= 0 || property.name_size > header.size - offset)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+    az_span const name = az_span_slice(image, offset, offset + property.name_size);
+    offset += property.name_size;
+
+    if (batch == NULL)
+    {
+      continue;
+    }
+
+    if (batch->_internal.property_count == batch->_internal.property_capacity)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    az_iot_hub_client_twin_reported_property* const restored
+        = &batch->_internal.properties[batch->_internal.property_count];
+    restored->_internal.name = name;
+    restored->_internal.pending_value = AZ_SPAN_EMPTY;
+    restored->_internal.acknowledged_hash = property.acknowledged_hash;
+    restored->_internal.is_pending = false;
+    restored->_internal.is_sent = false;
+    restored->_internal.is_acknowledged = true;
+    batch->_internal.property_count++;
+  }
+
+  if (offset != header.size)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  // Unless a record or a property is added, the state is the one the store holds.
+  cache->_internal.stored_check = header.check;
+  cache->_internal.is_stored = true;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_iot_hub_client_twin_cache_restore(az_iot_hub_client_twin_cache* cache, az_span image)
+{
+  _az_PRECONDITION_NOT_NULL(cache);
+  _az_PRECONDITION(
+      cache->_internal.tracker->_internal.record_count == 0
+      && cache->_internal.tracker->_internal.version == -1);
+  _az_PRECONDITION(
+      cache->_internal.batch == NULL || cache->_internal.batch->_internal.property_count == 0);
+  _az_PRECONDITION(
+      az_span_ptr(image) + az_span_size(image) <= az_span_ptr(cache->_internal.buffer)
+      || az_span_ptr(cache->_internal.buffer) + az_span_size(cache->_internal.buffer)
+          <= az_span_ptr(image));
+
+  az_result const result = _az_twin_cache_restore(cache, image);
+  if (az_result_failed(result))
+  {
+    _az_twin_desired_tracker_clear(cache->_internal.tracker);
+    cache->_internal.tracker->_internal.version = -1;
+    if (cache->_internal.batch != NULL)
+    {
+      cache->_internal.batch->_internal.property_count = 0;
+    }
+  }
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_twin_cache_save(az_iot_hub_client_twin_cache* cache)
+{
+  _az_PRECONDITION_NOT_NULL(cache);
+
+  az_iot_hub_client_twin_desired_tracker const* const tracker = cache->_internal.tracker;
+  az_iot_hub_client_twin_reported_batch const* const batch = cache->_internal.batch;
+  az_span const buffer = cache->_internal.buffer;
+
+  _az_twin_cache_header header = {
+    .magic = _az_TWIN_CACHE_MAGIC,
+    .size = 0,
+    .record_count = 0,
+    .property_count = 0,
+    .version = tracker->_internal.version,
+    .check = 0,
+  };
+
+  int32_t offset = _az_TWIN_CACHE_HEADER_SIZE;
+  for (int32_t i = 0; i < tracker->_internal.record_capacity; i++)
+  {
+    az_iot_hub_client_twin_desired_record const* const record = &tracker->_internal.records[i];
+    if (record->_internal.path_hash != _az_TWIN_DESIRED_EMPTY_RECORD)
+    {
+      _az_RETURN_IF_NOT_ENOUGH_SIZE(
+          az_span_slice_to_end(buffer, offset), _az_TWIN_CACHE_RECORD_SIZE);
+      memcpy(az_span_ptr(buffer) + offset, record, sizeof(*record));
+      offset += _az_TWIN_CACHE_RECORD_SIZE;
+      header.record_count++;
+    }
+  }
+
+  // Only the values IoT Hub acknowledged are cached: the ones which are pending or in flight are
+  // set again after a restart.
+  for (int32_t i = 0; batch != NULL && i < batch->_internal.property_count; i++)
+  {
+    az_iot_hub_client_twin_reported_property const* const property
+        = &batch->_internal.properties[i];
+    if (property->_internal.is_acknowledged)
+    {
+      _az_twin_cache_property const cached = {
+        .acknowledged_hash = property->_internal.acknowledged_hash,
+        .name_size = az_span_size(property->_internal.name),
+        .reserved = 0,
+      };
+      _az_RETURN_IF_NOT_ENOUGH_SIZE(
+          az_span_slice_to_end(buffer, offset), _az_TWIN_CACHE_PROPERTY_SIZE + cached.name_size);
+      memcpy(az_span_ptr(buffer) + offset, &cached, sizeof(cached));
+      offset += _az_TWIN_CACHE_PROPERTY_SIZE;
+      az_span_copy(az_span_slice_to_end(buffer, offset), property->_internal.name);
+      offset += cached.name_size;
+      header.property_count++;
+    }
+  }
+
+  header.size = offset;
+  az_span const image = az_span_slice(buffer, 0, offset);
+  memcpy(az_span_ptr(image), &header, sizeof(header));
+  header.check = _az_twin_cache_get_check(image);
+  memcpy(az_span_ptr(image), &header, sizeof(header));
+
+  if (cache->_internal.is_stored && cache->_internal.stored_check == header.check)
+  {
+    return AZ_OK;
+  }
+
+  _az_RETURN_IF_FAILED(cache->_internal.store(cache->_internal.store_context, image));
+  cache->_internal.stored_check = header.check;
+  cache->_internal.is_stored = true;
+  return AZ_OK;
+}
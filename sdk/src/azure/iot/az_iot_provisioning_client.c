@@ -4,12 +4,15 @@
 #include <azure/core/az_json.h>
 #include <azure/core/az_result.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_log_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
+#include <azure/core/internal/az_tracepoint_internal.h>
 #include <azure/iot/az_iot_common.h>
 #include <azure/iot/az_iot_provisioning_client.h>
+#include <azure/iot/internal/az_iot_common_internal.h>
 
 #include <azure/core/_az_cfg.h>
 
@@ -72,8 +75,8 @@ AZ_NODISCARD az_result az_iot_provisioning_client_get_user_name(
     size_t* out_mqtt_user_name_length)
 {
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_user_name);
-  _az_PRECONDITION(mqtt_user_name_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(
+      mqtt_user_name, mqtt_user_name_size, out_mqtt_user_name_length);
 
   az_span provisioning_service_api_version
       = AZ_SPAN_LITERAL_FROM_STR("/api-version=" AZ_IOT_PROVISIONING_SERVICE_VERSION);
@@ -93,6 +96,13 @@ AZ_NODISCARD az_result az_iot_provisioning_client_get_user_name(
     required_length += az_span_size(user_agent_version_prefix) + az_span_size(*user_agent);
   }
 
+  if (mqtt_user_name == NULL)
+  {
+    // Only the length is asked for.
+    *out_mqtt_user_name_length = (size_t)required_length;
+    return AZ_OK;
+  }
+
   _az_RETURN_IF_NOT_ENOUGH_SIZE(
       mqtt_user_name_span, required_length + (int32_t)sizeof((uint8_t)'\0'));
 
@@ -109,6 +119,8 @@ AZ_NODISCARD az_result az_iot_provisioning_client_get_user_name(
 
   remainder = az_span_copy_u8(remainder, '\0');
 
+  _az_BUFFER_STATS_RECORD(
+      _az_BUFFER_STATS_IOT_MQTT_USER_NAME, required_length + (int32_t)sizeof((uint8_t)'\0'));
   if (out_mqtt_user_name_length)
   {
     *out_mqtt_user_name_length = (size_t)required_length;
@@ -125,20 +137,29 @@ AZ_NODISCARD az_result az_iot_provisioning_client_get_client_id(
     size_t* out_mqtt_client_id_length)
 {
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_client_id);
-  _az_PRECONDITION(mqtt_client_id_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(
+      mqtt_client_id, mqtt_client_id_size, out_mqtt_client_id_length);
 
   az_span mqtt_client_id_span
       = az_span_create((uint8_t*)mqtt_client_id, (int32_t)mqtt_client_id_size);
 
   int32_t required_length = az_span_size(client->_internal.registration_id);
 
+  if (mqtt_client_id == NULL)
+  {
+    // Only the length is asked for.
+    *out_mqtt_client_id_length = (size_t)required_length;
+    return AZ_OK;
+  }
+
   _az_RETURN_IF_NOT_ENOUGH_SIZE(
       mqtt_client_id_span, required_length + (int32_t)sizeof((uint8_t)'\0'));
 
   az_span remainder = az_span_copy(mqtt_client_id_span, client->_internal.registration_id);
   remainder = az_span_copy_u8(remainder, '\0');
 
+  _az_BUFFER_STATS_RECORD(
+      _az_BUFFER_STATS_IOT_MQTT_CLIENT_ID, required_length + (int32_t)sizeof((uint8_t)'\0'));
   if (out_mqtt_client_id_length)
   {
     *out_mqtt_client_id_length = (size_t)required_length;
@@ -157,8 +178,7 @@ AZ_NODISCARD az_result az_iot_provisioning_client_register_get_publish_topic(
   (void)client;
 
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_topic);
-  _az_PRECONDITION(mqtt_topic_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_topic, mqtt_topic_size, out_mqtt_topic_length);
 
   az_span mqtt_topic_span = az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size);
   az_span str_dps_registrations = _az_iot_provisioning_get_str_dps_registrations();
@@ -166,12 +186,21 @@ AZ_NODISCARD az_result az_iot_provisioning_client_register_get_publish_topic(
   int32_t required_length
       = az_span_size(str_dps_registrations) + az_span_size(str_put_iotdps_register);
 
+  if (mqtt_topic == NULL)
+  {
+    // Only the length is asked for.
+    *out_mqtt_topic_length = (size_t)required_length;
+    return AZ_OK;
+  }
+
   _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_topic_span, required_length + (int32_t)sizeof((uint8_t)'\0'));
 
   az_span remainder = az_span_copy(mqtt_topic_span, str_dps_registrations);
   remainder = az_span_copy(remainder, str_put_iotdps_register);
   remainder = az_span_copy_u8(remainder, '\0');
 
+  _az_BUFFER_STATS_RECORD(
+      _az_BUFFER_STATS_IOT_MQTT_TOPIC, required_length + (int32_t)sizeof((uint8_t)'\0'));
   if (out_mqtt_topic_length)
   {
     *out_mqtt_topic_length = (size_t)required_length;
@@ -191,28 +220,31 @@ AZ_NODISCARD az_result az_iot_provisioning_client_query_status_get_publish_topic
   (void)client;
 
   _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_NOT_NULL(mqtt_topic);
-  _az_PRECONDITION(mqtt_topic_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_topic, mqtt_topic_size, out_mqtt_topic_length);
 
   _az_PRECONDITION_VALID_SPAN(operation_id, 1, false);
 
-  az_span mqtt_topic_span = az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size);
-  az_span str_dps_registrations = _az_iot_provisioning_get_str_dps_registrations();
-
-  int32_t required_length = az_span_size(str_dps_registrations)
-      + az_span_size(str_get_iotdps_get_operationstatus)
-      + az_span_size(operation_id);
-
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_topic_span, required_length + (int32_t)sizeof((uint8_t)'\0'));
-
-  az_span remainder = az_span_copy(mqtt_topic_span, str_dps_registrations);
-  remainder = az_span_copy(remainder, str_get_iotdps_get_operationstatus);
-  remainder = az_span_copy(remainder, operation_id);
-  remainder = az_span_copy_u8(remainder, '\0');
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_topic, (int32_t)mqtt_topic_size));
+  _az_span_builder_append(&builder, _az_iot_provisioning_get_str_dps_registrations());
+  _az_span_builder_append(&builder, str_get_iotdps_get_operationstatus);
+  _az_span_builder_append(&builder, operation_id);
+  _az_span_builder_append_u8(&builder, '\0');
+  if (mqtt_topic == NULL)
+  {
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof((uint8_t)'\0'));
+    return AZ_OK;
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_TOPIC, _az_span_builder_length(&builder));
   if (out_mqtt_topic_length)
   {
-    *out_mqtt_topic_length = (size_t)required_length;
+    *out_mqtt_topic_length
+        = (size_t)(_az_span_builder_length(&builder) - (int32_t)sizeof((uint8_t)'\0'));
   }
 
   return AZ_OK;
@@ -277,8 +309,8 @@ AZ_INLINE az_result _az_iot_provisioning_client_payload_registration_state_parse
   bool found_assigned_hub = false;
   bool found_device_id = false;
 
-  while ((!(found_device_id && found_assigned_hub))
-         && az_result_succeeded(az_json_reader_next_token(jr))
+  // The whole object is read, so that the reader ends on its closing brace.
+  while (az_result_succeeded(az_json_reader_next_token(jr))
          && jr->token.kind != AZ_JSON_TOKEN_END_OBJECT)
   {
     if (az_json_token_is_text_equal(&jr->token, AZ_SPAN_FROM_STR("assignedHub")))
@@ -327,7 +359,7 @@ AZ_INLINE az_result _az_iot_provisioning_client_payload_registration_state_parse
     else
     {
       // ignore other tokens
-      _az_RETURN_IF_FAILED(az_json_reader_skip_children(jr));
+      _az_RETURN_IF_FAILED(az_json_reader_fast_skip_children(jr));
     }
   }
 
@@ -423,7 +455,7 @@ AZ_INLINE az_result az_iot_provisioning_client_parse_payload(
     else
     {
       // ignore other tokens
-      _az_RETURN_IF_FAILED(az_json_reader_skip_children(&jr));
+      _az_RETURN_IF_FAILED(az_json_reader_fast_skip_children(&jr));
     }
   }
 
@@ -465,22 +497,16 @@ Stage 3:
  {"errorCode":401002,"trackingId":"8ad0463c-6427-4479-9dfa-3e8bb7003e9b","message":"Invalid
   certificate.","timestampUtc":"2020-04-10T05:24:22.4718526Z"}
 */
-AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_payload(
-    az_iot_provisioning_client const* client,
+static AZ_NODISCARD az_result _az_iot_provisioning_client_match_received_topic(
     az_span received_topic,
     az_span received_payload,
     az_iot_provisioning_client_register_response* out_response)
 {
-  (void)client;
-
-  _az_PRECONDITION_NOT_NULL(client);
-  _az_PRECONDITION_VALID_SPAN(received_topic, 0, false);
-  _az_PRECONDITION_VALID_SPAN(received_payload, 0, false);
-  _az_PRECONDITION_NOT_NULL(out_response);
+  // Only logged, so unused when logging is compiled out.
+  (void)received_payload;
 
   az_span str_dps_registrations_res = _az_iot_provisioning_get_dps_registrations_res();
-  int32_t idx = az_span_find(received_topic, str_dps_registrations_res);
-  if (idx != 0)
+  if (!_az_span_starts_with(received_topic, str_dps_registrations_res))
   {
     return AZ_ERROR_IOT_TOPIC_NO_MATCH;
   }
@@ -497,7 +523,7 @@ AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_paylo
 
   // Parse the optional retry-after= field.
   az_span retry_after = AZ_SPAN_FROM_STR("retry-after=");
-  idx = az_span_find(remainder, retry_after);
+  int32_t const idx = az_span_find(remainder, retry_after);
   if (idx != -1)
   {
     remainder = az_span_slice_to_end(remainder, idx + az_span_size(retry_after));
@@ -510,11 +536,138 @@ AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_paylo
     out_response->retry_after_seconds = 0;
   }
 
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_iot_provisioning_client_parse_received_topic(
+    az_iot_provisioning_client const* client,
+    az_span received_topic,
+    az_span received_payload,
+    az_iot_provisioning_client_register_response* out_response)
+{
+  (void)client;
+
+  az_result const result = _az_iot_provisioning_client_match_received_topic(
+      received_topic, received_payload, out_response);
+  _az_TRACEPOINT3(iot_provisioning_topic_parse, client, az_span_size(received_topic), result);
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_payload(
+    az_iot_provisioning_client const* client,
+    az_span received_topic,
+    az_span received_payload,
+    az_iot_provisioning_client_register_response* out_response)
+{
+  (void)client;
+
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(received_topic, 0, false);
+  _az_PRECONDITION_VALID_SPAN(received_payload, 0, false);
+  _az_PRECONDITION_NOT_NULL(out_response);
+
+  _az_RETURN_IF_FAILED(_az_iot_provisioning_client_parse_received_topic(
+      client, received_topic, received_payload, out_response));
+
   _az_RETURN_IF_FAILED(az_iot_provisioning_client_parse_payload(received_payload, out_response));
 
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_iot_provisioning_client_parse_received_topic_and_payload_lazy(
+    az_iot_provisioning_client const* client,
+    az_span received_topic,
+    az_span received_payload,
+    az_iot_provisioning_client_register_response* out_response)
+{
+  (void)client;
+
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(received_topic, 0, false);
+  _az_PRECONDITION_VALID_SPAN(received_payload, 0, false);
+  _az_PRECONDITION_NOT_NULL(out_response);
+
+  _az_RETURN_IF_FAILED(_az_iot_provisioning_client_parse_received_topic(
+      client, received_topic, received_payload, out_response));
+
+  out_response->registration_state = _az_iot_provisioning_registration_state_default();
+
+  az_json_reader jr;
+  _az_RETURN_IF_FAILED(az_json_reader_init(&jr, received_payload, NULL));
+
+  _az_RETURN_IF_FAILED(az_json_reader_next_token(&jr));
+  if (jr.token.kind != AZ_JSON_TOKEN_BEGIN_OBJECT)
+  {
+    return AZ_ERROR_UNEXPECTED_CHAR;
+  }
+
+  bool found_operation_id = false;
+  bool found_operation_status = false;
+  bool found_error = false;
+
+  // Reading stops as soon as the operation ID and status are found, which usually come first.
+  while (!(found_operation_id && found_operation_status)
+         && az_result_succeeded(az_json_reader_next_token(&jr))
+         && jr.token.kind != AZ_JSON_TOKEN_END_OBJECT)
+  {
+    if (az_json_token_is_text_equal(&jr.token, AZ_SPAN_FROM_STR("operationId")))
+    {
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(&jr));
+      if (jr.token.kind != AZ_JSON_TOKEN_STRING)
+      {
+        return AZ_ERROR_ITEM_NOT_FOUND;
+      }
+      out_response->operation_id = jr.token.slice;
+      found_operation_id = true;
+    }
+    else if (az_json_token_is_text_equal(&jr.token, AZ_SPAN_FROM_STR("status")))
+    {
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(&jr));
+      if (jr.token.kind != AZ_JSON_TOKEN_STRING)
+      {
+        return AZ_ERROR_ITEM_NOT_FOUND;
+      }
+      out_response->operation_status = jr.token.slice;
+      found_operation_status = true;
+    }
+    else
+    {
+      found_error = found_error
+          || az_json_token_is_text_equal(&jr.token, AZ_SPAN_FROM_STR("errorCode"));
+      _az_RETURN_IF_FAILED(az_json_reader_next_token(&jr));
+      _az_RETURN_IF_FAILED(az_json_reader_skip_children(&jr));
+    }
+  }
+
+  if (!(found_operation_status && found_operation_id))
+  {
+    out_response->operation_id = AZ_SPAN_EMPTY;
+    out_response->operation_status = AZ_SPAN_FROM_STR("failed");
+
+    if (!found_error)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_provisioning_client_parse_registration_state(
+    az_span received_payload,
+    az_iot_provisioning_client_registration_state* out_state)
+{
+  _az_PRECONDITION_VALID_SPAN(received_payload, 0, false);
+  _az_PRECONDITION_NOT_NULL(out_state);
+
+  az_iot_provisioning_client_register_response response;
+  _az_RETURN_IF_FAILED(az_iot_provisioning_client_parse_payload(received_payload, &response));
+
+  *out_state = response.registration_state;
+  return AZ_OK;
+}
+
 AZ_NODISCARD az_result az_iot_provisioning_client_parse_operation_status(
     az_iot_provisioning_client_register_response* response,
     az_iot_provisioning_client_operation_status* out_operation_status)
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+#include <azure/iot/az_iot_provisioning_client.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+// The image of a registration is its header, followed by the assigned hub hostname and then by the
+// device ID. The check is a hash of the whole image, taken while the check itself is zero, so that
+// an image whose write was interrupted is not read.
+enum
+{
+  _az_PROVISIONING_CACHE_MAGIC = 0x43504941, // "AIPC"
+};
+
+typedef struct
+{
+  uint32_t magic;
+  int32_t size;
+  int32_t hostname_size;
+  int32_t device_id_size;
+  uint64_t registration_hash;
+  uint64_t assigned_epoch_time;
+  uint64_t check;
+} _az_provisioning_cache_header;
+
+#define _az_PROVISIONING_CACHE_HEADER_SIZE ((int32_t)sizeof(_az_provisioning_cache_header))
+
+#define _az_FNV1A_64_OFFSET_BASIS 14695981039346656037ull
+#define _az_FNV1A_64_PRIME 1099511628211ull
+
+static AZ_NODISCARD uint64_t _az_provisioning_cache_hash(uint64_t hash, az_span span)
+{
+  uint8_t const* const ptr = az_span_ptr(span);
+  for (int32_t i = 0; i < az_span_size(span); i++)
+  {
+    hash = (hash ^ ptr[i]) * _az_FNV1A_64_PRIME;
+  }
+
+  return hash;
+}
+
+// FNV-1a over the global endpoint, ID scope and registration ID, each followed by a separator
+// which cannot appear in them.
+static AZ_NODISCARD uint64_t
+_az_provisioning_cache_get_registration_hash(az_iot_provisioning_client const* client)
+{
+  az_span const separator = AZ_SPAN_FROM_STR("\n");
+
+  uint64_t hash = _az_FNV1A_64_OFFSET_BASIS;
+  hash = _az_provisioning_cache_hash(hash, client->_internal.global_device_endpoint);
+  hash = _az_provisioning_cache_hash(hash, separator);
+  hash = _az_provisioning_cache_hash(hash, client->_internal.id_scope);
+  hash = _az_provisioning_cache_hash(hash, separator);
+  hash = _az_provisioning_cache_hash(hash, client->_internal.registration_id);
+  return _az_provisioning_cache_hash(hash, separator);
+}
+
+static AZ_NODISCARD uint64_t _az_provisioning_cache_get_check(az_span image)
+{
+  _az_provisioning_cache_header header;
+  memcpy(&header, az_span_ptr(image), sizeof(header));
+  header.check = 0;
+
+  uint64_t const check = _az_provisioning_cache_hash(
+      _az_FNV1A_64_OFFSET_BASIS,
+      az_span_create((uint8_t*)&header, _az_PROVISIONING_CACHE_HEADER_SIZE));
+  return _az_provisioning_cache_hash(
+      check, az_span_slice_to_end(image, _az_PROVISIONING_CACHE_HEADER_SIZE));
+}
+
+AZ_NODISCARD az_result az_iot_provisioning_client_cache_write(
+    az_iot_provisioning_client const* client,
+    az_iot_provisioning_client_registration_state const* registration_state,
+    uint64_t current_epoch_time,
+    az_span destination,
+    az_span* out_image)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_NOT_NULL(registration_state);
+  _az_PRECONDITION_VALID_SPAN(registration_state->assigned_hub_hostname, 1, false);
+  _az_PRECONDITION_VALID_SPAN(registration_state->device_id, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_image);
+
+  az_span const hostname = registration_state->assigned_hub_hostname;
+  az_span const device_id = registration_state->device_id;
+
+  _az_provisioning_cache_header header = {
+    .magic = _az_PROVISIONING_CACHE_MAGIC,
+    .size = _az_PROVISIONING_CACHE_HEADER_SIZE + az_span_size(hostname) + az_span_size(device_id),
+    .hostname_size = az_span_size(hostname),
+    .device_id_size = az_span_size(device_id),
+    .registration_hash = _az_provisioning_cache_get_registration_hash(client),
+    .assigned_epoch_time = current_epoch_time,
+    .check = 0,
+  };
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, header.size);
+
+  az_span const image = az_span_slice(destination, 0, header.size);
+  memcpy(az_span_ptr(image), &header, sizeof(header));
+  az_span remainder = az_span_slice_to_end(image, _az_PROVISIONING_CACHE_HEADER_SIZE);
+  remainder = az_span_copy(remainder, hostname);
+  remainder = az_span_copy(remainder, device_id);
+
+  header.check = _az_provisioning_cache_get_check(image);
+  memcpy(az_span_ptr(image), &header, sizeof(header));
+
+  *out_image = image;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_provisioning_client_cache_read(
+    az_iot_provisioning_client const* client,
+    az_span image,
+    uint64_t current_epoch_time,
+    uint32_t max_age_seconds,
+    az_iot_provisioning_client_cache_entry* out_entry)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_NOT_NULL(out_entry);
+
+  if (az_span_size(image) < _az_PROVISIONING_CACHE_HEADER_SIZE)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  _az_provisioning_cache_header header;
+  memcpy(&header, az_span_ptr(image), sizeof(header));
+  if (header.magic != _az_PROVISIONING_CACHE_MAGIC || header.size > az_span_size(image)
+      || header.hostname_size <= 0 || header.device_id_size <= 0
+      || header.hostname_size > header.size - _az_PROVISIONING_CACHE_HEADER_SIZE
+      || header.device_id_size
+          != header.size - _az_PROVISIONING_CACHE_HEADER_SIZE - header.hostname_size)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  image = az_span_slice(image, 0, header.size);
+  if (header.check != _az_provisioning_cache_get_check(image)
+      || header.registration_hash != _az_provisioning_cache_get_registration_hash(client))
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  if (max_age_seconds > 0 && current_epoch_time > header.assigned_epoch_time
+      && current_epoch_time - header.assigned_epoch_time > max_age_seconds)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  int32_t const hostname_end = _az_PROVISIONING_CACHE_HEADER_SIZE + header.hostname_size;
+  out_entry->assigned_hub_hostname
+      = az_span_slice(image, _az_PROVISIONING_CACHE_HEADER_SIZE, hostname_end);
+  out_entry->device_id = az_span_slice_to_end(image, hostname_end);
+  out_entry->assigned_epoch_time = header.assigned_epoch_time;
+  return AZ_OK;
+}
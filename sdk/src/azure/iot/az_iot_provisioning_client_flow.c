@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+#include <azure/core/internal/az_retry_internal.h>
+#include <azure/iot/az_iot_common.h>
+#include <azure/iot/az_iot_provisioning_client.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+AZ_NODISCARD az_iot_provisioning_client_flow_options
+az_iot_provisioning_client_flow_options_default()
+{
+  return (az_iot_provisioning_client_flow_options){
+    .retry_options = az_iot_retry_options_default(),
+    .jitter_msec = 1000,
+    .default_poll_interval_msec = 3000,
+    .response_timeout_msec = 30000,
+  };
+}
+
+// The jitter shares the random numbers of the retries, so that a random callback or seed set in the
+// retry options applies to both.
+static AZ_NODISCARD int32_t _az_iot_provisioning_client_flow_jitter(
+    az_iot_provisioning_client_flow* flow)
+{
+  az_iot_retry_options const* retry_options = &flow->_internal.retry._internal.options;
+  uint32_t const random = retry_options->random_callback != NULL
+      ? retry_options->random_callback(retry_options->random_user_context)
+      : _az_retry_next_random(&flow->_internal.retry._internal.random_state);
+
+  return (int32_t)(random % ((uint32_t)flow->_internal.options.jitter_msec + 1));
+}
+
+static void _az_iot_provisioning_client_flow_schedule(
+    az_iot_provisioning_client_flow* flow,
+    az_iot_provisioning_client_flow_action action,
+    int64_t publish_msec)
+{
+  flow->_internal.next_action = action;
+  flow->_internal.next_publish_msec = publish_msec;
+  flow->_internal.is_request_pending = false;
+}
+
+// Schedules the request again after a failure, and returns false if it must not be retried.
+static AZ_NODISCARD bool _az_iot_provisioning_client_flow_retry(
+    az_iot_provisioning_client_flow* flow,
+    az_iot_status status,
+    int64_t min_delay_msec,
+    int64_t now_msec)
+{
+  // The time spent waiting for the response isn't deducted from the delay, so that the retries
+  // of devices whose requests failed together stay spread out.
+  int32_t retry_delay_msec = 0;
+  if (!az_iot_retry_next_delay(&flow->_internal.retry, status, 0, &retry_delay_msec))
+  {
+    return false;
+  }
+
+  int64_t const delay_msec = retry_delay_msec > min_delay_msec ? retry_delay_msec : min_delay_msec;
+  _az_iot_provisioning_client_flow_schedule(
+      flow, flow->_internal.next_action, now_msec + delay_msec);
+  return true;
+}
+
+void az_iot_provisioning_client_flow_init(
+    az_iot_provisioning_client_flow* flow,
+    int64_t now_msec,
+    az_span operation_id_buffer,
+    az_iot_provisioning_client_flow_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(flow);
+  _az_PRECONDITION_VALID_SPAN(operation_id_buffer, 1, false);
+
+  flow->_internal.options
+      = options == NULL ? az_iot_provisioning_client_flow_options_default() : *options;
+
+  _az_PRECONDITION_RANGE(0, flow->_internal.options.jitter_msec, INT32_MAX - 1);
+  _az_PRECONDITION_RANGE(0, flow->_internal.options.default_poll_interval_msec, INT32_MAX - 1);
+  _az_PRECONDITION_RANGE(1, flow->_internal.options.response_timeout_msec, INT32_MAX - 1);
+
+  az_iot_retry_init(&flow->_internal.retry, &flow->_internal.options.retry_options);
+  flow->_internal.operation_id_buffer = operation_id_buffer;
+  flow->_internal.operation_id = AZ_SPAN_EMPTY;
+  flow->_internal.response_deadline_msec = 0;
+
+  // Devices which power up together, such as after an outage, don't all register at once.
+  _az_iot_provisioning_client_flow_schedule(
+      flow,
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER,
+      now_msec + _az_iot_provisioning_client_flow_jitter(flow));
+}
+
+AZ_NODISCARD az_iot_provisioning_client_flow_action az_iot_provisioning_client_flow_get_next_action(
+    az_iot_provisioning_client_flow* flow,
+    int64_t now_msec,
+    int64_t* out_next_msec)
+{
+  _az_PRECONDITION_NOT_NULL(flow);
+  _az_PRECONDITION_NOT_NULL(out_next_msec);
+
+  az_iot_provisioning_client_flow_action const action = flow->_internal.next_action;
+  if (action == AZ_IOT_PROVISIONING_FLOW_ACTION_ASSIGNED
+      || action == AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED)
+  {
+    *out_next_msec = now_msec;
+    return action;
+  }
+
+  if (flow->_internal.is_request_pending)
+  {
+    if (now_msec < flow->_internal.response_deadline_msec)
+    {
+      *out_next_msec = flow->_internal.response_deadline_msec;
+      return AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT;
+    }
+
+    // A request without a response is retried, like one which failed with an unknown status.
+    if (!_az_iot_provisioning_client_flow_retry(flow, AZ_IOT_STATUS_UNKNOWN, 0, now_msec))
+    {
+      _az_iot_provisioning_client_flow_schedule(flow, AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED, 0);
+      *out_next_msec = now_msec;
+      return AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED;
+    }
+  }
+
+  if (now_msec < flow->_internal.next_publish_msec)
+  {
+    *out_next_msec = flow->_internal.next_publish_msec;
+    return AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT;
+  }
+
+  flow->_internal.is_request_pending = true;
+  flow->_internal.response_deadline_msec = now_msec + flow->_internal.options.response_timeout_msec;
+  *out_next_msec = now_msec;
+  return action;
+}
+
+AZ_NODISCARD az_result az_iot_provisioning_client_flow_on_response(
+    az_iot_provisioning_client_flow* flow,
+    az_iot_provisioning_client_register_response const* response,
+    int64_t now_msec)
+{
+  _az_PRECONDITION_NOT_NULL(flow);
+  _az_PRECONDITION_NOT_NULL(response);
+
+  az_iot_provisioning_client_flow_action const action = flow->_internal.next_action;
+  if (action == AZ_IOT_PROVISIONING_FLOW_ACTION_ASSIGNED
+      || action == AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED)
+  {
+    return AZ_OK;
+  }
+
+  int64_t const retry_after_msec = (int64_t)response->retry_after_seconds * 1000;
+
+  if (!az_iot_status_succeeded(response->status))
+  {
+    if (!_az_iot_provisioning_client_flow_retry(flow, response->status, retry_after_msec, now_msec))
+    {
+      _az_iot_provisioning_client_flow_schedule(flow, AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED, 0);
+    }
+
+    return AZ_OK;
+  }
+
+  az_iot_provisioning_client_register_response parsed_response = *response;
+  az_iot_provisioning_client_operation_status operation_status;
+  _az_RETURN_IF_FAILED(
+      az_iot_provisioning_client_parse_operation_status(&parsed_response, &operation_status));
+
+  if (az_iot_provisioning_client_operation_complete(operation_status))
+  {
+    _az_iot_provisioning_client_flow_schedule(
+        flow,
+        operation_status == AZ_IOT_PROVISIONING_STATUS_ASSIGNED
+            ? AZ_IOT_PROVISIONING_FLOW_ACTION_ASSIGNED
+            : AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED,
+        0);
+    return AZ_OK;
+  }
+
+  int32_t const operation_id_size = az_span_size(response->operation_id);
+  if (operation_id_size > az_span_size(flow->_internal.operation_id_buffer))
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  if (!az_span_is_content_equal(flow->_internal.operation_id, response->operation_id))
+  {
+    az_span_copy(flow->_internal.operation_id_buffer, response->operation_id);
+    flow->_internal.operation_id
+        = az_span_slice(flow->_internal.operation_id_buffer, 0, operation_id_size);
+  }
+
+  az_iot_retry_reset(&flow->_internal.retry);
+
+  int64_t const poll_interval_msec = retry_after_msec > 0
+      ? retry_after_msec
+      : flow->_internal.options.default_poll_interval_msec;
+  _az_iot_provisioning_client_flow_schedule(
+      flow,
+      AZ_IOT_PROVISIONING_FLOW_ACTION_QUERY,
+      now_msec + poll_interval_msec + _az_iot_provisioning_client_flow_jitter(flow));
+  return AZ_OK;
+}
@@ -3,6 +3,7 @@
 
 #include <azure/core/az_precondition.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_buffer_stats_internal.h>
 #include <azure/core/internal/az_log_internal.h>
 #include <azure/core/internal/az_precondition_internal.h>
 #include <azure/core/internal/az_result_internal.h>
@@ -80,8 +81,7 @@ AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_password(
   _az_PRECONDITION_NOT_NULL(client);
   _az_PRECONDITION_VALID_SPAN(base64_hmac_sha256_signature, 1, false);
   _az_PRECONDITION(token_expiration_epoch_time > 0);
-  _az_PRECONDITION_NOT_NULL(mqtt_password);
-  _az_PRECONDITION(mqtt_password_size > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_password, mqtt_password_size, out_mqtt_password_length);
 
   // Concatenates:
   // "SharedAccessSignature sr=<url-encoded(resource-string)>&sig=<signature>&se=<expiration-time>"
@@ -90,69 +90,111 @@ AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_password(
   // Where:
   // resource-string: <scope-id>/registrations/<registration-id>
 
-  az_span mqtt_password_span = az_span_create((uint8_t*)mqtt_password, (int32_t)mqtt_password_size);
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_create((uint8_t*)mqtt_password, (int32_t)mqtt_password_size));
 
   // SharedAccessSignature
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, az_span_size(sr_string) + 1 /* EQUAL SIGN */);
-  mqtt_password_span = az_span_copy(mqtt_password_span, sr_string);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
+  _az_span_builder_append(&builder, sr_string);
+  _az_span_builder_append_u8(&builder, EQUAL_SIGN);
 
   // Resource string
-  _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-      mqtt_password_span, client->_internal.id_scope, &mqtt_password_span));
-
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, az_span_size(resources_string));
-  mqtt_password_span = az_span_copy(mqtt_password_span, resources_string);
-
-  _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-      mqtt_password_span, client->_internal.registration_id, &mqtt_password_span));
+  _az_span_builder_append_url_encoded(&builder, client->_internal.id_scope);
+  _az_span_builder_append(&builder, resources_string);
+  _az_span_builder_append_url_encoded(&builder, client->_internal.registration_id);
 
   // Signature
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_password_span, 1 /* AMPERSAND */ + az_span_size(sig_string) + 1 /* EQUAL_SIGN */);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, AMPERSAND);
-  mqtt_password_span = az_span_copy(mqtt_password_span, sig_string);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-
-  _az_RETURN_IF_FAILED(_az_span_copy_url_encode(
-      mqtt_password_span, base64_hmac_sha256_signature, &mqtt_password_span));
+  _az_span_builder_append_u8(&builder, AMPERSAND);
+  _az_span_builder_append(&builder, sig_string);
+  _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+  _az_span_builder_append_url_encoded(&builder, base64_hmac_sha256_signature);
 
   // Expiration
-
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(
-      mqtt_password_span,
-      1 /* AMPERSAND */ + az_span_size(se_string)
-          + 1 /* EQUAL_SIGN */ + _az_iot_u64toa_size(token_expiration_epoch_time));
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, AMPERSAND);
-  mqtt_password_span = az_span_copy(mqtt_password_span, se_string);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-  _az_RETURN_IF_FAILED(
-      az_span_u64toa(mqtt_password_span, token_expiration_epoch_time, &mqtt_password_span));
+  _az_span_builder_append_u8(&builder, AMPERSAND);
+  _az_span_builder_append(&builder, se_string);
+  _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+  _az_span_builder_append_u64(&builder, token_expiration_epoch_time);
 
   if (az_span_size(key_name) > 0)
   {
     // Key Name
-    _az_RETURN_IF_NOT_ENOUGH_SIZE(
-        mqtt_password_span,
-        1 // AMPERSAND
-            + az_span_size(skn_string) + 1 // EQUAL_SIGN
-            + az_span_size(key_name));
-
-    mqtt_password_span = az_span_copy_u8(mqtt_password_span, AMPERSAND);
-    mqtt_password_span = az_span_copy(mqtt_password_span, skn_string);
-    mqtt_password_span = az_span_copy_u8(mqtt_password_span, EQUAL_SIGN);
-    mqtt_password_span = az_span_copy(mqtt_password_span, key_name);
+    _az_span_builder_append_u8(&builder, AMPERSAND);
+    _az_span_builder_append(&builder, skn_string);
+    _az_span_builder_append_u8(&builder, EQUAL_SIGN);
+    _az_span_builder_append(&builder, key_name);
   }
 
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(mqtt_password_span, 1 /* NULL TERMINATOR */);
-  mqtt_password_span = az_span_copy_u8(mqtt_password_span, STRING_NULL_TERMINATOR);
+  _az_span_builder_append_u8(&builder, STRING_NULL_TERMINATOR);
+  if (mqtt_password == NULL)
+  {
+    // Only the length is asked for: the builder counted it without writing anything.
+    *out_mqtt_password_length = (size_t)(_az_span_builder_length(&builder) - 1);
+    return AZ_OK;
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
 
+  _az_BUFFER_STATS_RECORD(_az_BUFFER_STATS_IOT_MQTT_PASSWORD, _az_span_builder_length(&builder));
   if (out_mqtt_password_length != NULL)
   {
     *out_mqtt_password_length
-        = ((size_t)mqtt_password_size - (size_t)az_span_size(mqtt_password_span)
-           - 1 /* NULL TERMINATOR */);
+        = (size_t)(_az_span_builder_length(&builder) - 1 /* NULL TERMINATOR */);
   }
 
   return AZ_OK;
 }
+
+AZ_NODISCARD az_result az_iot_provisioning_client_sas_get_password_from_key(
+    az_iot_provisioning_client const* client,
+    az_span base64_shared_access_key,
+    uint64_t token_expiration_epoch_time,
+    az_span key_name,
+    char* mqtt_password,
+    size_t mqtt_password_size,
+    size_t* out_mqtt_password_length)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(base64_shared_access_key, 1, false);
+  _az_PRECONDITION(token_expiration_epoch_time > 0);
+  _az_PRECONDITION_IOT_STRING_BUFFER(mqtt_password, mqtt_password_size, out_mqtt_password_length);
+
+  if (mqtt_password == NULL)
+  {
+    // The signature can't be known without signing, so the length is that of the password with
+    // the longest signature.
+    return az_iot_provisioning_client_sas_get_password(
+        client,
+        AZ_SPAN_FROM_STR(_az_IOT_SAS_LONGEST_BASE64_HMAC_SHA256),
+        token_expiration_epoch_time,
+        key_name,
+        NULL,
+        0,
+        out_mqtt_password_length);
+  }
+
+  // The signature and the decoded key are staged in mqtt_password, which the password needs more
+  // space from than both of them, before it is written.
+  az_span const mqtt_password_span
+      = az_span_create((uint8_t*)mqtt_password, (int32_t)mqtt_password_size);
+
+  az_span signature;
+  _az_RETURN_IF_FAILED(az_iot_provisioning_client_sas_get_signature(
+      client, token_expiration_epoch_time, mqtt_password_span, &signature));
+
+  uint8_t base64_hmac_sha256_buffer[_az_IOT_SAS_BASE64_HMAC_SHA256_SIZE];
+  az_span base64_hmac_sha256_signature;
+  _az_RETURN_IF_FAILED(_az_iot_sas_sign(
+      base64_shared_access_key,
+      signature,
+      az_span_slice_to_end(mqtt_password_span, az_span_size(signature)),
+      AZ_SPAN_FROM_BUFFER(base64_hmac_sha256_buffer),
+      &base64_hmac_sha256_signature));
+
+  return az_iot_provisioning_client_sas_get_password(
+      client,
+      base64_hmac_sha256_signature,
+      token_expiration_epoch_time,
+      key_name,
+      mqtt_password,
+      mqtt_password_size,
+      out_mqtt_password_length);
+}
@@ -1,13 +1,17 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include "az_curl_private.h"
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_atomic_internal.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <curl/curl.h>
 
@@ -62,22 +66,407 @@ static AZ_NODISCARD az_result _az_http_client_curl_code_to_result(CURLcode code)
 #define _az_RETURN_IF_CURL_FAILED(exp) \
   _az_RETURN_IF_FAILED(_az_http_client_curl_code_to_result(exp))
 
-AZ_NODISCARD AZ_INLINE az_result _az_http_client_curl_init(CURL** out)
+/**
+ * @brief The number of easy handles kept around when connection reuse is enabled, which is the
+ * number of requests which can pick up their keep-alive connections at the same time.
+ */
+#define _az_HTTP_CLIENT_CURL_HANDLE_COUNT 8
+
+/**
+ * @brief Connection cache used when connection reuse is enabled. The share handle keeps DNS
+ * lookups, TLS sessions and open connections alive across requests, and the easy handles are kept
+ * around (and reset before each request) so their keep-alive connections can be picked up again.
+ *
+ * @details Each easy handle is claimed by the request which uses it, so that requests can be sent
+ * from several threads at once. A request which finds all of them claimed uses an easy handle of
+ * its own, which still shares the DNS lookups, TLS sessions and, since curl 7.57.0, the open
+ * connections of the share handle. The share handle is locked with one spin lock for each kind of
+ * data it shares.
+ */
+static CURLSH* _az_http_client_curl_share = NULL;
+static CURL* _az_http_client_curl_handles[_az_HTTP_CLIENT_CURL_HANDLE_COUNT];
+static uint64_t volatile _az_http_client_curl_handles_in_use[_az_HTTP_CLIENT_CURL_HANDLE_COUNT];
+static uint64_t volatile _az_http_client_curl_share_locks[CURL_LOCK_DATA_LAST];
+
+static void _az_http_client_curl_share_lock(
+    CURL* handle,
+    curl_lock_data data,
+    curl_lock_access access,
+    void* user_pointer)
+{
+  (void)handle;
+  (void)access;
+  (void)user_pointer;
+  _az_atomic_spin_lock(&_az_http_client_curl_share_locks[data]);
+}
+
+static void _az_http_client_curl_share_unlock(CURL* handle, curl_lock_data data, void* user_pointer)
+{
+  (void)handle;
+  (void)user_pointer;
+  _az_atomic_spin_unlock(&_az_http_client_curl_share_locks[data]);
+}
+
+// Returns the easy handle the request claimed, reset and attached to the share handle.
+static AZ_NODISCARD az_result _az_http_client_curl_claim(int32_t index, CURL** out)
+{
+  CURL* curl = _az_http_client_curl_handles[index];
+  if (curl == NULL)
+  {
+    curl = curl_easy_init();
+    if (curl == NULL)
+    {
+      _az_atomic_spin_unlock(&_az_http_client_curl_handles_in_use[index]);
+      return AZ_ERROR_HTTP_ADAPTER;
+    }
+
+    _az_http_client_curl_handles[index] = curl;
+  }
+  else
+  {
+    // Reset clears any option set by a previous request but keeps the live connections, DNS cache
+    // and TLS session cache of the handle.
+    curl_easy_reset(curl);
+  }
+
+  if (curl_easy_setopt(curl, CURLOPT_SHARE, _az_http_client_curl_share) != CURLE_OK)
+  {
+    _az_atomic_spin_unlock(&_az_http_client_curl_handles_in_use[index]);
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  *out = curl;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result _az_http_client_curl_init(CURL** out)
 {
+  if (_az_http_client_curl_share != NULL)
+  {
+    for (int32_t i = 0; i < _az_HTTP_CLIENT_CURL_HANDLE_COUNT; i++)
+    {
+      uint64_t expected = 0;
+      if (_az_atomic_compare_exchange(&_az_http_client_curl_handles_in_use[i], &expected, 1))
+      {
+        return _az_http_client_curl_claim(i, out);
+      }
+    }
+  }
+
   *out = curl_easy_init();
+  if (*out == NULL)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  if (_az_http_client_curl_share != NULL
+      && curl_easy_setopt(*out, CURLOPT_SHARE, _az_http_client_curl_share) != CURLE_OK)
+  {
+    curl_easy_cleanup(*out);
+    *out = NULL;
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
   return AZ_OK;
 }
 
-AZ_NODISCARD AZ_INLINE az_result _az_http_client_curl_done(CURL** pp)
+AZ_NODISCARD az_result _az_http_client_curl_done(CURL** pp)
 {
   _az_PRECONDITION_NOT_NULL(pp);
   _az_PRECONDITION_NOT_NULL(*pp);
 
+  // The kept handles are only released by az_http_client_connection_reuse_cleanup().
+  for (int32_t i = 0; i < _az_HTTP_CLIENT_CURL_HANDLE_COUNT; i++)
+  {
+    if (*pp == _az_http_client_curl_handles[i])
+    {
+      _az_atomic_spin_unlock(&_az_http_client_curl_handles_in_use[i]);
+      *pp = NULL;
+      return AZ_OK;
+    }
+  }
+
   curl_easy_cleanup(*pp);
   *pp = NULL;
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_http_client_connection_reuse_init()
+{
+  if (_az_http_client_curl_share != NULL)
+  {
+    // Already initialized.
+    return AZ_OK;
+  }
+
+  CURLSH* const share = curl_share_init();
+  if (share == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  az_result result = AZ_OK;
+  if (curl_share_setopt(share, CURLSHOPT_LOCKFUNC, _az_http_client_curl_share_lock) != CURLSHE_OK
+      || curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, _az_http_client_curl_share_unlock)
+          != CURLSHE_OK
+      || curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) != CURLSHE_OK
+      || curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) != CURLSHE_OK)
+  {
+    result = AZ_ERROR_HTTP_ADAPTER;
+  }
+#if LIBCURL_VERSION_NUM >= 0x073900 // CURL_LOCK_DATA_CONNECT is available since curl 7.57.0
+  else if (curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) != CURLSHE_OK)
+  {
+    result = AZ_ERROR_HTTP_ADAPTER;
+  }
+#endif
+
+  CURL* const curl = az_result_succeeded(result) ? curl_easy_init() : NULL;
+  if (curl == NULL)
+  {
+    (void)curl_share_cleanup(share);
+    return az_result_failed(result) ? result : AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  // The share is set right away on the first handle, so that TLS sessions can be imported before
+  // the first request.
+  if (curl_easy_setopt(curl, CURLOPT_SHARE, share) != CURLE_OK)
+  {
+    curl_easy_cleanup(curl);
+    (void)curl_share_cleanup(share);
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  _az_http_client_curl_handles[0] = curl;
+  _az_http_client_curl_share = share;
+  return AZ_OK;
+}
+
+void az_http_client_connection_reuse_cleanup()
+{
+  // The easy handles must be released before the share handle they are attached to.
+  for (int32_t i = 0; i < _az_HTTP_CLIENT_CURL_HANDLE_COUNT; i++)
+  {
+    if (_az_http_client_curl_handles[i] != NULL)
+    {
+      curl_easy_cleanup(_az_http_client_curl_handles[i]);
+      _az_http_client_curl_handles[i] = NULL;
+    }
+  }
+
+  if (_az_http_client_curl_share != NULL)
+  {
+    (void)curl_share_cleanup(_az_http_client_curl_share);
+    _az_http_client_curl_share = NULL;
+  }
+}
+
+#if LIBCURL_VERSION_NUM >= 0x080C00 // curl_easy_ssls_export() is available since curl 8.12.0
+
+/*
+ * The exported sessions are a sequence of records. Each record is the session key, including its
+ * 0-terminator, or nothing if curl doesn't export it, then the salted hash of the key and the
+ * session data. Each of them is preceded by its size, as 4 little-endian bytes.
+ */
+enum
+{
+  _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES = 4,
+};
+
+typedef struct
+{
+  az_span remainder;
+  az_result result;
+} _az_http_client_curl_sessions_writer;
+
+static AZ_NODISCARD az_result _az_http_client_curl_sessions_write_field(
+    az_span* ref_remainder,
+    uint8_t const* data,
+    size_t size)
+{
+  if (size > (size_t)(INT32_MAX - _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES))
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t const field_size = (int32_t)size;
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(
+      *ref_remainder, _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES + field_size);
+
+  uint8_t* const ptr = az_span_ptr(*ref_remainder);
+  for (int32_t i = 0; i < _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES; i++)
+  {
+    ptr[i] = (uint8_t)((uint32_t)field_size >> (8 * i));
+  }
+  if (field_size > 0)
+  {
+    memcpy(ptr + _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES, data, size);
+  }
+
+  *ref_remainder = az_span_slice_to_end(
+      *ref_remainder, _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES + field_size);
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_http_client_curl_sessions_read_field(az_span* ref_remainder, az_span* out_field)
+{
+  int32_t const remainder_size = az_span_size(*ref_remainder);
+  if (remainder_size < _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  uint8_t const* const ptr = az_span_ptr(*ref_remainder);
+  uint32_t field_size = 0;
+  for (int32_t i = 0; i < _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES; i++)
+  {
+    field_size |= (uint32_t)ptr[i] << (8 * i);
+  }
+  if (field_size > (uint32_t)(remainder_size - _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES))
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  int32_t const end = _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES + (int32_t)field_size;
+  *out_field = az_span_slice(*ref_remainder, _az_HTTP_CLIENT_CURL_SESSION_FIELD_SIZE_BYTES, end);
+  *ref_remainder = az_span_slice_to_end(*ref_remainder, end);
+  return AZ_OK;
+}
+
+static CURLcode _az_http_client_curl_export_session(
+    CURL* handle,
+    void* user_pointer,
+    char const* session_key,
+    unsigned char const* shmac,
+    size_t shmac_len,
+    unsigned char const* sdata,
+    size_t sdata_len,
+    curl_off_t valid_until,
+    int ietf_tls_id,
+    char const* alpn,
+    size_t earlydata_max)
+{
+  (void)handle;
+  (void)valid_until;
+  (void)ietf_tls_id;
+  (void)alpn;
+  (void)earlydata_max;
+
+  _az_http_client_curl_sessions_writer* const writer
+      = (_az_http_client_curl_sessions_writer*)user_pointer;
+  size_t const key_size = session_key == NULL ? 0 : strlen(session_key) + 1;
+
+  az_span remainder = writer->remainder;
+  writer->result = _az_http_client_curl_sessions_write_field(
+      &remainder, (uint8_t const*)session_key, key_size);
+  if (az_result_succeeded(writer->result))
+  {
+    writer->result = _az_http_client_curl_sessions_write_field(&remainder, shmac, shmac_len);
+  }
+  if (az_result_succeeded(writer->result))
+  {
+    writer->result = _az_http_client_curl_sessions_write_field(&remainder, sdata, sdata_len);
+  }
+
+  if (az_result_failed(writer->result))
+  {
+    // Stops the export.
+    return CURLE_WRITE_ERROR;
+  }
+
+  writer->remainder = remainder;
+  return CURLE_OK;
+}
+
+AZ_NODISCARD az_result
+az_http_client_tls_sessions_export(az_span destination, az_span* out_sessions)
+{
+  _az_PRECONDITION_NOT_NULL(out_sessions);
+
+  *out_sessions = az_span_slice(destination, 0, 0);
+  if (_az_http_client_curl_share == NULL)
+  {
+    // Without connection reuse, the sessions are gone with the handle of each request.
+    return AZ_OK;
+  }
+
+  // The sessions are in the share handle, and are reached through the first easy handle, which is
+  // waited for if a request is using it.
+  _az_atomic_spin_lock(&_az_http_client_curl_handles_in_use[0]);
+  _az_http_client_curl_sessions_writer writer = { .remainder = destination, .result = AZ_OK };
+  CURLcode const code = curl_easy_ssls_export(
+      _az_http_client_curl_handles[0], _az_http_client_curl_export_session, &writer);
+  _az_atomic_spin_unlock(&_az_http_client_curl_handles_in_use[0]);
+  _az_RETURN_IF_FAILED(writer.result);
+  if (code == CURLE_NOT_BUILT_IN)
+  {
+    return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+  }
+  _az_RETURN_IF_CURL_FAILED(code);
+
+  *out_sessions = az_span_slice(destination, 0, _az_span_diff(writer.remainder, destination));
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_client_tls_sessions_import(az_span sessions)
+{
+  _az_RETURN_IF_FAILED(az_http_client_connection_reuse_init());
+
+  az_span remainder = sessions;
+  while (az_span_size(remainder) > 0)
+  {
+    az_span key = AZ_SPAN_EMPTY;
+    az_span shmac = AZ_SPAN_EMPTY;
+    az_span sdata = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(_az_http_client_curl_sessions_read_field(&remainder, &key));
+    _az_RETURN_IF_FAILED(_az_http_client_curl_sessions_read_field(&remainder, &shmac));
+    _az_RETURN_IF_FAILED(_az_http_client_curl_sessions_read_field(&remainder, &sdata));
+
+    int32_t const key_size = az_span_size(key);
+    if (key_size > 0 && az_span_ptr(key)[key_size - 1] != '\0')
+    {
+      return AZ_ERROR_UNEXPECTED_END;
+    }
+
+    _az_atomic_spin_lock(&_az_http_client_curl_handles_in_use[0]);
+    CURLcode const code = curl_easy_ssls_import(
+        _az_http_client_curl_handles[0],
+        key_size > 0 ? (char const*)az_span_ptr(key) : NULL,
+        az_span_size(shmac) > 0 ? az_span_ptr(shmac) : NULL,
+        (size_t)az_span_size(shmac),
+        az_span_ptr(sdata),
+        (size_t)az_span_size(sdata));
+    _az_atomic_spin_unlock(&_az_http_client_curl_handles_in_use[0]);
+    if (code == CURLE_NOT_BUILT_IN)
+    {
+      return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+    }
+
+    // A session which is rejected, such as an expired one, only means a full handshake.
+  }
+
+  return AZ_OK;
+}
+
+#else // LIBCURL_VERSION_NUM
+
+AZ_NODISCARD az_result
+az_http_client_tls_sessions_export(az_span destination, az_span* out_sessions)
+{
+  (void)destination;
+  (void)out_sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_tls_sessions_import(az_span sessions)
+{
+  (void)sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+#endif // LIBCURL_VERSION_NUM
+
 /**
  * @brief writes a header key and value to a buffer as a 0-terminated string and using a separator
  * span in between. Returns error as soon as any of the write operations fails
@@ -118,6 +507,7 @@ _az_http_client_curl_slist_append(struct curl_slist** ref_list, char const* str)
   {
     // free any previous allocates custom headers
     curl_slist_free_all(*ref_list);
+    *ref_list = NULL;
     return AZ_ERROR_HTTP_ADAPTER;
   }
 
@@ -125,6 +515,66 @@ _az_http_client_curl_slist_append(struct curl_slist** ref_list, char const* str)
   return AZ_OK;
 }
 
+enum
+{
+  // The number of headers, including "Expect:", and the size of the header strings and URL of a
+  // request which can be sent synchronously without allocating memory.
+  _az_HTTP_CLIENT_CURL_SCRATCH_HEADER_COUNT = 24,
+  _az_HTTP_CLIENT_CURL_SCRATCH_SIZE = 4096,
+};
+
+/**
+ * @brief Holds the header list and the URL of a request while it is sent synchronously, so that
+ * they don't need to be allocated. The headers of a request which don't fit are allocated instead.
+ */
+typedef struct
+{
+  struct curl_slist nodes[_az_HTTP_CLIENT_CURL_SCRATCH_HEADER_COUNT];
+  int32_t node_count;
+  az_span remaining;
+  uint8_t buffer[_az_HTTP_CLIENT_CURL_SCRATCH_SIZE];
+} _az_http_client_curl_scratch;
+
+static void _az_http_client_curl_scratch_reset(_az_http_client_curl_scratch* ref_scratch)
+{
+  ref_scratch->node_count = 0;
+  ref_scratch->remaining = AZ_SPAN_FROM_BUFFER(ref_scratch->buffer);
+}
+
+/**
+ * @brief writes a header into the scratch buffer and links it at the end of the scratch header
+ * list, which curl reads but never frees.
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_scratch_append_header(
+    _az_http_client_curl_scratch* ref_scratch,
+    az_span header_name,
+    az_span header_value,
+    az_span separator)
+{
+  int32_t const index = ref_scratch->node_count;
+  if (index == _az_HTTP_CLIENT_CURL_SCRATCH_HEADER_COUNT)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  az_span const text = ref_scratch->remaining;
+  _az_RETURN_IF_FAILED(
+      _az_span_append_header_to_buffer(text, header_name, header_value, separator));
+  ref_scratch->remaining = az_span_slice_to_end(
+      text,
+      az_span_size(header_name) + az_span_size(separator) + az_span_size(header_value) + 1);
+
+  ref_scratch->nodes[index].data = (char*)az_span_ptr(text);
+  ref_scratch->nodes[index].next = NULL;
+  if (index > 0)
+  {
+    ref_scratch->nodes[index - 1].next = &ref_scratch->nodes[index];
+  }
+
+  ref_scratch->node_count = index + 1;
+  return AZ_OK;
+}
+
 /**
  * @brief allocate a buffer for a header. Then reads the header name and value and writes a buffer.
  * Then uses that buffer to set curl header. Header is set only if write operations were OK. Buffer
@@ -169,45 +619,6 @@ static AZ_NODISCARD az_result _az_http_client_curl_add_header_to_curl_list(
   return result;
 }
 
-/**
- * @brief Adds special header "Expect:" for libcurl to avoid sending only headers to server and wait
- * for a 100 Continue response before sending a PUT method
- *
- * see: https://github.com/curl/curl/blob/master/docs/FAQ#L1033
- * libcurl makes all POST and PUT requests (except for POST requests with a
- * very tiny request body) use the "Expect: 100-continue" header. This header
- * allows the server to deny the operation early so that libcurl can bail out
- * before having to send any data. This is useful in authentication
- * cases and others.
- *
- * However, many servers don't implement the Expect: stuff properly and if the
- * server doesn't respond (positively) within 1 second libcurl will continue
- * and send off the data anyway.
- *
- * You can disable libcurl's use of the Expect: header the same way you disable
- * any header, using -H / CURLOPT_HTTPHEADER, or by forcing it to use HTTP 1.0.
- *
- * This function is meant to be called after all headers from original request was called. It will
- * append another header and set headers for a ref_curl session
- *
- * @param ref_curl reference to an easy curl session
- * @param ref_list list of headers as curl list
- *
- * @return az_result
- */
-static AZ_NODISCARD az_result
-_az_http_client_curl_add_expect_header(CURL* ref_curl, struct curl_slist** ref_list)
-{
-  _az_PRECONDITION_NOT_NULL(ref_curl);
-  _az_PRECONDITION_NOT_NULL(ref_list);
-
-  // Append header to current custom headers list
-  _az_RETURN_IF_FAILED(_az_http_client_curl_slist_append(ref_list, "Expect:"));
-  // Update the reference to curl custom list (in case it gets moved in memory due to appending)
-  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_HTTPHEADER, *ref_list));
-  return AZ_OK;
-}
-
 /**
  * @brief loop all the headers from a HTTP request and set each header into easy curl
  *
@@ -232,6 +643,33 @@ _az_http_client_curl_build_headers(az_http_request const* request, struct curl_s
   return AZ_OK;
 }
 
+/**
+ * @brief writes all the headers from a HTTP request, and the "Expect:" header when \p
+ * add_expect_header is `true`, into \p ref_scratch.
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_build_headers_in_scratch(
+    az_http_request const* request,
+    bool add_expect_header,
+    _az_http_client_curl_scratch* ref_scratch)
+{
+  az_span header_name = { 0 };
+  az_span header_value = { 0 };
+  for (int32_t offset = 0; offset < az_http_request_headers_count(request); ++offset)
+  {
+    _az_RETURN_IF_FAILED(az_http_request_get_header(request, offset, &header_name, &header_value));
+    _az_RETURN_IF_FAILED(_az_http_client_curl_scratch_append_header(
+        ref_scratch, header_name, header_value, AZ_SPAN_FROM_STR(":")));
+  }
+
+  if (add_expect_header)
+  {
+    _az_RETURN_IF_FAILED(_az_http_client_curl_scratch_append_header(
+        ref_scratch, AZ_SPAN_FROM_STR("Expect"), AZ_SPAN_EMPTY, AZ_SPAN_FROM_STR(":")));
+  }
+
+  return AZ_OK;
+}
+
 /**
  * @brief writes a url request adds a zero to make it a c-string. Return error if any of the write
  * operations fails.
@@ -284,176 +722,230 @@ static size_t _az_http_client_curl_write_to_span(
   return expected_size;
 }
 
-/**
- * handles GET request
- */
-static AZ_NODISCARD az_result _az_http_client_curl_send_get_request(CURL* ref_curl)
-{
-  _az_PRECONDITION_NOT_NULL(ref_curl);
-
-  // send
-  _az_RETURN_IF_CURL_FAILED(curl_easy_perform(ref_curl));
-
-  return AZ_OK;
-}
-
 /**
  * handles DELETE request
  */
-static AZ_NODISCARD az_result _az_http_client_curl_send_delete_request(CURL* ref_curl)
+static AZ_NODISCARD az_result _az_http_client_curl_setup_delete_request(CURL* ref_curl)
 {
   _az_PRECONDITION_NOT_NULL(ref_curl);
 
-  _az_RETURN_IF_FAILED(_az_http_client_curl_code_to_result(
-      curl_easy_setopt(ref_curl, CURLOPT_CUSTOMREQUEST, "DELETE")));
-
-  _az_RETURN_IF_FAILED(_az_http_client_curl_code_to_result(curl_easy_perform(ref_curl)));
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_CUSTOMREQUEST, "DELETE"));
 
   return AZ_OK;
 }
 
 /**
- * handles POST request. It handles seting up a body for request
+ * handles HEAD request
  */
-static AZ_NODISCARD az_result
-_az_http_client_curl_send_post_request(CURL* ref_curl, az_http_request const* request)
+static AZ_NODISCARD az_result _az_http_client_curl_setup_head_request(CURL* ref_curl)
 {
   _az_PRECONDITION_NOT_NULL(ref_curl);
-  _az_PRECONDITION_NOT_NULL(request);
-
-  // Method
-  az_span request_body = { 0 };
-  _az_RETURN_IF_FAILED(az_http_request_get_body(request, &request_body));
-  az_span body = { 0 };
-  int32_t const required_length = az_span_size(request_body) + az_span_size(AZ_SPAN_FROM_STR("\0"));
 
-  _az_RETURN_IF_FAILED(_az_span_malloc(required_length, &body));
-
-  char* b = (char*)az_span_ptr(body);
-  az_span_to_str(b, required_length, request_body);
-
-  az_result res_code
-      = _az_http_client_curl_code_to_result(curl_easy_setopt(ref_curl, CURLOPT_POSTFIELDS, b));
-  if (az_result_succeeded(res_code))
-  {
-    res_code = _az_http_client_curl_code_to_result(curl_easy_perform(ref_curl));
-  }
-
-  _az_span_free(&body);
-  _az_RETURN_IF_FAILED(res_code);
+  // The response has no body, even if its Content-Length says otherwise.
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_NOBODY, 1L));
 
   return AZ_OK;
 }
 
 /**
  * @brief UPLOAD requests are done via callbacks.  The callback is passed in a buffer address which
- * is filled with the userdata content. The callback will occur until the callback returns 0 (no
- * more data). The callback will return CURL_READFUNC_ABORT should an error occur.  This in turn
- * terminates the POST request.
+ * is filled with the next chunk of the request body. The callback will occur until the callback
+ * returns 0 (no more data). The callback will return CURL_READFUNC_ABORT should an error occur.
+ * This in turn terminates the request.
  *
  * @param dst Destination address buffer
  * @param size Size of an item
  * @param nmemb Number of items to copy
  * @param userdata Source data to upload
- *                 Passed as the pointer to an az_span
- * @return int
+ *                 Passed as the pointer to an _az_http_request_body_reader
+ * @return size_t
  */
-static int32_t _az_http_client_curl_upload_read_callback(
-    void* dst,
+static size_t _az_http_client_curl_upload_read_callback(
+    char* dst,
     size_t size,
     size_t nmemb,
     void* userdata)
 {
-
-  az_span* upload_content = (az_span*)userdata;
+  _az_http_request_body_reader* const body_reader = (_az_http_request_body_reader*)userdata;
 
   // Calculate the size of the *dst buffer
-  int32_t dst_buffer_size = (int32_t)(nmemb * size);
+  size_t const dst_buffer_size = nmemb * size;
 
   // Terminate the upload if the destination buffer is too small
   if (dst_buffer_size < 1)
+  {
     return CURL_READFUNC_ABORT;
+  }
 
-  int32_t userdata_length = az_span_size(*upload_content);
-
-  // Return if nothing to copy
-  if (userdata_length < 1)
-    return CURLE_OK; // Success, all bytes copied
-
-  // Calculate how many bytes can we copy from customer data (upload_content)
-  // Curl provides dst buffer with a max size of dest_buffer_size, if customer data size is less
-  // than the max, we can copy all customer data directly and have it uploaded at once.
-  // If not, we can only copy the max dst size from customer data and wait for another upload to
-  // copy a next chunk of data
-  int32_t size_of_copy = (userdata_length < dst_buffer_size) ? userdata_length : dst_buffer_size;
-
-  memcpy(dst, az_span_ptr(*upload_content), (size_t)size_of_copy);
+  // Curl provides dst buffer with a max size of dst_buffer_size. The body (either a buffer or a
+  // body provider) fills as much of it as it can, and the next chunk is read on the next callback.
+  int32_t size_of_copy = 0;
+  az_result const result = az_http_request_read_body(
+      body_reader->_internal.request,
+      body_reader->_internal.offset,
+      az_span_create(
+          (uint8_t*)dst, dst_buffer_size > INT32_MAX ? INT32_MAX : (int32_t)dst_buffer_size),
+      &size_of_copy);
+
+  if (az_result_failed(result))
+  {
+    return CURL_READFUNC_ABORT;
+  }
 
-  // Update the userdata span. If we already copied all content, slice will set upload_content with
-  // 0 length
-  *upload_content = az_span_slice_to_end(*upload_content, size_of_copy);
+  // Once all content is copied, size_of_copy is 0, which tells curl the upload is done.
+  body_reader->_internal.offset += size_of_copy;
 
-  return size_of_copy;
+  return (size_t)size_of_copy;
 }
 
 /**
- * Perform an UPLOAD or PUT request.
- * As of CURL 7.12.1 CURLOPT_PUT is deprecated.  PUT requests should be made using CURLOPT_UPLOAD
+ * @brief sets the read callback used to stream the request body, reading it through \p
+ * ref_body_reader, which must stay alive until the request is performed.
  */
-static AZ_NODISCARD az_result
-_az_http_client_curl_send_upload_request(CURL* ref_curl, az_http_request const* request)
+static AZ_NODISCARD az_result _az_http_client_curl_setup_body_reader(
+    CURL* ref_curl,
+    az_http_request const* request,
+    _az_http_request_body_reader* ref_body_reader)
 {
-  _az_PRECONDITION_NOT_NULL(ref_curl);
-  _az_PRECONDITION_NOT_NULL(request);
+  *ref_body_reader = (_az_http_request_body_reader){
+    ._internal = {
+      .request = request,
+      .offset = 0,
+    },
+  };
 
-  az_span body = { 0 };
-  _az_RETURN_IF_FAILED(az_http_request_get_body(request, &body));
-
-  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_UPLOAD, 1L));
   _az_RETURN_IF_CURL_FAILED(
       curl_easy_setopt(ref_curl, CURLOPT_READFUNCTION, _az_http_client_curl_upload_read_callback));
 
   // Setup the request to pass body into the read callback
-  // The read callback receives the address of body
-  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_READDATA, &body));
-
-  // Set the size of the upload
-  _az_RETURN_IF_CURL_FAILED(
-      curl_easy_setopt(ref_curl, CURLOPT_INFILESIZE, (curl_off_t)az_span_size(body)));
-
-  // Do the curl work
-  // curl_easy_perform does not return until the CURLOPT_READFUNCTION callbacks complete.
-  _az_RETURN_IF_CURL_FAILED(curl_easy_perform(ref_curl));
+  // The read callback receives the address of body reader
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_READDATA, ref_body_reader));
 
   return AZ_OK;
 }
 
 /**
- * @brief finds out if there are headers in the request and add them to curl header list
- *
- * @param ref_curl curl specific structure to send a request
- * @param ref_list curl headers list
- * @param request an http request
- * @return az_result
+ * handles POST request. It handles seting up a body for request. The body is copied into \p
+ * out_body, which must stay alive until the request is performed. When the request body comes from
+ * a body provider, it is streamed through \p ref_body_reader instead.
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_setup_post_request(
+    CURL* ref_curl,
+    az_http_request const* request,
+    az_span* out_body,
+    _az_http_request_body_reader* ref_body_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_curl);
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(out_body);
+
+  if (request->_internal.body_provider != NULL)
+  {
+    // When the size is AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN, curl takes the -1 as an unknown size, and
+    // sends the body with chunked transfer coding.
+    _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_POST, 1L));
+    _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(
+        ref_curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)az_http_request_get_body_size(request)));
+    return _az_http_client_curl_setup_body_reader(ref_curl, request, ref_body_reader);
+  }
+
+  // Method
+  az_span request_body = { 0 };
+  _az_RETURN_IF_FAILED(az_http_request_get_body(request, &request_body));
+  int32_t const required_length = az_span_size(request_body) + az_span_size(AZ_SPAN_FROM_STR("\0"));
+
+  _az_RETURN_IF_FAILED(_az_span_malloc(required_length, out_body));
+
+  char* b = (char*)az_span_ptr(*out_body);
+  az_span_to_str(b, required_length, request_body);
+
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_POSTFIELDS, b));
+
+  return AZ_OK;
+}
+
+/**
+ * Set up an UPLOAD or PUT request.
+ * As of CURL 7.12.1 CURLOPT_PUT is deprecated.  PUT requests should be made using CURLOPT_UPLOAD
+ *
+ * The read callback consumes the body through \p ref_body_reader, which must stay alive until the
+ * request is performed.
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_setup_upload_request(
+    CURL* ref_curl,
+    az_http_request const* request,
+    _az_http_request_body_reader* ref_body_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_curl);
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(ref_body_reader);
+
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_UPLOAD, 1L));
+  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_body_reader(ref_curl, request, ref_body_reader));
+
+  // Set the size of the upload, which is -1, for chunked transfer coding, when it is unknown
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(
+      ref_curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)az_http_request_get_body_size(request)));
+
+  return AZ_OK;
+}
+
+/**
+ * @brief finds out if there are headers in the request and add them to curl header list
+ *
+ * @param ref_curl curl specific structure to send a request
+ * @param ref_list curl headers list, when the headers are allocated instead of being written to
+ * \p ref_scratch
+ * @param ref_scratch __[nullable]__ buffer to write the headers into when they fit
+ * @param request an http request
+ * @param add_expect_header whether to append the "Expect:" header
+ * @return az_result
  */
 static AZ_NODISCARD az_result _az_http_client_curl_setup_headers(
     CURL* ref_curl,
     struct curl_slist** ref_list,
-    az_http_request const* request)
+    _az_http_client_curl_scratch* ref_scratch,
+    az_http_request const* request,
+    bool add_expect_header)
 {
   _az_PRECONDITION_NOT_NULL(ref_curl);
   _az_PRECONDITION_NOT_NULL(request);
 
-  if (az_http_request_headers_count(request) == 0)
+  if (az_http_request_headers_count(request) == 0 && !add_expect_header)
   {
     // no headers, no need to set it up
     return AZ_OK;
   }
 
-  // build headers into a slist as curl is expecting
-  _az_RETURN_IF_FAILED(_az_http_client_curl_build_headers(request, ref_list));
+  struct curl_slist* list = NULL;
+  if (ref_scratch != NULL)
+  {
+    if (az_result_succeeded(
+            _az_http_client_curl_build_headers_in_scratch(request, add_expect_header, ref_scratch)))
+    {
+      list = &ref_scratch->nodes[0];
+    }
+    else
+    {
+      // The headers don't fit, so they are allocated.
+      _az_http_client_curl_scratch_reset(ref_scratch);
+    }
+  }
+
+  if (list == NULL)
+  {
+    // build headers into a slist as curl is expecting
+    _az_RETURN_IF_FAILED(_az_http_client_curl_build_headers(request, ref_list));
+    if (add_expect_header)
+    {
+      _az_RETURN_IF_FAILED(_az_http_client_curl_slist_append(ref_list, "Expect:"));
+    }
+
+    list = *ref_list;
+  }
+
   // set all headers from slist
-  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_HTTPHEADER, *ref_list));
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_HTTPHEADER, list));
 
   return AZ_OK;
 }
@@ -462,11 +954,14 @@ static AZ_NODISCARD az_result _az_http_client_curl_setup_headers(
  * @brief set url for the request
  *
  * @param ref_curl specific curl struct to send a request
+ * @param ref_scratch __[nullable]__ buffer to write the url into when it fits
  * @param request an az http request builder holding all data to send request
  * @return az_result
  */
-static AZ_NODISCARD az_result
-_az_http_client_curl_setup_url(CURL* ref_curl, az_http_request const* request)
+static AZ_NODISCARD az_result _az_http_client_curl_setup_url(
+    CURL* ref_curl,
+    _az_http_client_curl_scratch* ref_scratch,
+    az_http_request const* request)
 {
   _az_PRECONDITION_NOT_NULL(ref_curl);
   _az_PRECONDITION_NOT_NULL(request);
@@ -477,6 +972,14 @@ _az_http_client_curl_setup_url(CURL* ref_curl, az_http_request const* request)
   // Note: the url from request is already url-encoded.
   int32_t request_url_size = az_span_size(request_url);
 
+  if (ref_scratch != NULL
+      && az_result_succeeded(_az_http_client_curl_append_url(ref_scratch->remaining, request_url)))
+  {
+    // curl keeps its own copy of the url, so the rest of the scratch buffer stays free.
+    char* buffer = (char*)az_span_ptr(ref_scratch->remaining);
+    return _az_http_client_curl_code_to_result(curl_easy_setopt(ref_curl, CURLOPT_URL, buffer));
+  }
+
   az_span writable_buffer;
   {
     // Add 1 for 0-terminated str
@@ -530,62 +1033,141 @@ _az_http_client_curl_setup_response_redirect(CURL* ref_curl, az_http_response* r
 }
 
 /**
- * @brief use this function to group all the actions that we do with CURL so we can clean it after
- * it no matter is there is an error at any step.
+ * @brief sets up everything curl needs to send \p request and write the response into \p
+ * ref_response, without performing the request.
  *
  * @param ref_curl curl specific structure used to send an http request
  * @param request http builder with specific data to build an http request
  * @param ref_response pre-allocated buffer where to write http response
-
- * @return AZ_OK if request was sent and a response was received
+ * @param ref_headers curl headers list, to be released once the request is performed
+ * @param ref_scratch __[nullable]__ buffer holding the headers and url when they fit, which must
+ * stay alive until the request is performed
+ * @param ref_post_body copy of the body of a POST request, to be released once the request is
+ * performed
+ * @param ref_body_reader reader streaming the body of a PUT request (or of a POST request with a
+ * body provider), which must stay alive until the request is performed
+ *
+ * @return AZ_OK if the request is ready to be performed
  */
-static AZ_NODISCARD az_result _az_http_client_curl_send_request_impl_process(
+static AZ_NODISCARD az_result _az_http_client_curl_setup_request(
     CURL* ref_curl,
     az_http_request const* request,
-    az_http_response* ref_response)
+    az_http_response* ref_response,
+    struct curl_slist** ref_headers,
+    _az_http_client_curl_scratch* ref_scratch,
+    az_span* ref_post_body,
+    _az_http_request_body_reader* ref_body_reader)
 {
   _az_PRECONDITION_NOT_NULL(ref_curl);
   _az_PRECONDITION_NOT_NULL(request);
 
-  az_result result = AZ_ERROR_ARG;
+  az_http_method method;
+  _az_RETURN_IF_FAILED(az_http_request_get_method(request, &method));
 
-  struct curl_slist* list = NULL;
-  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_headers(ref_curl, &list, request));
+  bool const is_post = az_span_is_content_equal(method, az_http_method_post());
+  bool const is_put = az_span_is_content_equal(method, az_http_method_put());
 
-  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_url(ref_curl, request));
+  // Adds special header "Expect:" to POST and PUT requests, for libcurl to avoid sending only
+  // headers to server and wait for a 100 Continue response before sending the body.
+  //
+  // see: https://github.com/curl/curl/blob/master/docs/FAQ#L1033
+  // libcurl makes all POST and PUT requests (except for POST requests with a very tiny request
+  // body) use the "Expect: 100-continue" header. This header allows the server to deny the
+  // operation early so that libcurl can bail out before having to send any data.
+  //
+  // However, many servers don't implement the Expect: stuff properly and if the server doesn't
+  // respond (positively) within 1 second libcurl will continue and send off the data anyway.
+  // libcurl's use of the Expect: header is disabled the same way as any header, using
+  // CURLOPT_HTTPHEADER.
 
-  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_response_redirect(ref_curl, ref_response));
+  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_headers(
+      ref_curl, ref_headers, ref_scratch, request, is_post || is_put));
 
-  az_http_method method;
-  _az_RETURN_IF_FAILED(az_http_request_get_method(request, &method));
+  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_url(ref_curl, ref_scratch, request));
+
+  _az_RETURN_IF_FAILED(_az_http_client_curl_setup_response_redirect(ref_curl, ref_response));
 
   if (az_span_is_content_equal(method, az_http_method_get()))
   {
-    result = _az_http_client_curl_send_get_request(ref_curl);
+    // GET is the default method for curl, nothing else to set up.
+    return AZ_OK;
   }
-  else if (az_span_is_content_equal(method, az_http_method_delete()))
+
+  if (az_span_is_content_equal(method, az_http_method_delete()))
   {
-    result = _az_http_client_curl_send_delete_request(ref_curl);
+    return _az_http_client_curl_setup_delete_request(ref_curl);
   }
-  else if (az_span_is_content_equal(method, az_http_method_post()))
+
+  if (az_span_is_content_equal(method, az_http_method_head()))
+  {
+    return _az_http_client_curl_setup_head_request(ref_curl);
+  }
+
+  if (is_post)
   {
-    _az_RETURN_IF_FAILED(_az_http_client_curl_add_expect_header(ref_curl, &list));
-    result = _az_http_client_curl_send_post_request(ref_curl, request);
+    return _az_http_client_curl_setup_post_request(
+        ref_curl, request, ref_post_body, ref_body_reader);
   }
-  else if (az_span_is_content_equal(method, az_http_method_put()))
+
+  if (is_put)
   {
     // As of CURL 7.12.1 CURLOPT_PUT is deprecated.  PUT requests should be made using
     // CURLOPT_UPLOAD
-    _az_RETURN_IF_FAILED(_az_http_client_curl_add_expect_header(ref_curl, &list));
-    result = _az_http_client_curl_send_upload_request(ref_curl, request);
+    return _az_http_client_curl_setup_upload_request(ref_curl, request, ref_body_reader);
   }
-  else
+
+  return AZ_ERROR_HTTP_INVALID_METHOD_VERB;
+}
+
+/**
+ * @brief releases the resources allocated by _az_http_client_curl_setup_request().
+ */
+static void _az_http_client_curl_release_request(
+    struct curl_slist** ref_headers,
+    az_span* ref_post_body)
+{
+  // Clean custom headers previously appended
+  curl_slist_free_all(*ref_headers);
+  *ref_headers = NULL;
+
+  _az_span_free(ref_post_body);
+}
+
+/**
+ * @brief use this function to group all the actions that we do with CURL so we can clean it after
+ * it no matter is there is an error at any step.
+ *
+ * @param ref_curl curl specific structure used to send an http request
+ * @param request http builder with specific data to build an http request
+ * @param ref_response pre-allocated buffer where to write http response
+
+ * @return AZ_OK if request was sent and a response was received
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_send_request_impl_process(
+    CURL* ref_curl,
+    az_http_request const* request,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_curl);
+  _az_PRECONDITION_NOT_NULL(request);
+
+  struct curl_slist* headers = NULL;
+  az_span post_body = AZ_SPAN_EMPTY;
+  _az_http_request_body_reader upload_body = { 0 };
+
+  _az_http_client_curl_scratch scratch;
+  _az_http_client_curl_scratch_reset(&scratch);
+
+  az_result result = _az_http_client_curl_setup_request(
+      ref_curl, request, ref_response, &headers, &scratch, &post_body, &upload_body);
+
+  if (az_result_succeeded(result))
   {
-    return AZ_ERROR_HTTP_INVALID_METHOD_VERB;
+    // curl_easy_perform does not return until the CURLOPT_READFUNCTION callbacks complete.
+    result = _az_http_client_curl_code_to_result(curl_easy_perform(ref_curl));
   }
 
-  // Clean custom headers previously appended
-  curl_slist_free_all(list);
+  _az_http_client_curl_release_request(&headers, &post_body);
 
   return result;
 }
@@ -617,3 +1199,430 @@ az_http_client_send_request(az_http_request const* request, az_http_response* re
 
   return process_result;
 }
+
+/**
+ * @brief Whether libcurl was built with HTTP/2 support, and is recent enough to multiplex streams.
+ */
+static AZ_NODISCARD bool _az_http_client_curl_supports_http2()
+{
+#if LIBCURL_VERSION_NUM >= 0x072F00 // CURL_HTTP_VERSION_2TLS is available since curl 7.47.0
+  curl_version_info_data const* const info = curl_version_info(CURLVERSION_NOW);
+  return info != NULL && (info->features & CURL_VERSION_HTTP2) != 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief tells the event loop of an #az_http_client_async the activity to watch a socket for, as
+ * the CURLMOPT_SOCKETFUNCTION of its multi handle.
+ */
+static int _az_http_client_async_socket_callback(
+    CURL* easy,
+    curl_socket_t socket,
+    int what,
+    void* user_pointer,
+    void* socket_pointer)
+{
+  (void)easy;
+  (void)socket_pointer;
+  az_http_client_async const* const client = (az_http_client_async const*)user_pointer;
+
+  az_http_client_async_socket_events events = AZ_HTTP_CLIENT_ASYNC_SOCKET_NONE;
+  switch (what)
+  {
+    case CURL_POLL_IN:
+      events = AZ_HTTP_CLIENT_ASYNC_SOCKET_IN;
+      break;
+    case CURL_POLL_OUT:
+      events = AZ_HTTP_CLIENT_ASYNC_SOCKET_OUT;
+      break;
+    case CURL_POLL_INOUT:
+      events = AZ_HTTP_CLIENT_ASYNC_SOCKET_INOUT;
+      break;
+    default: // CURL_POLL_REMOVE
+      break;
+  }
+
+  client->_internal.socket_callback(client->_internal.callback_context, (intptr_t)socket, events);
+  return 0;
+}
+
+/**
+ * @brief tells the event loop of an #az_http_client_async when to call
+ * #az_http_client_async_timer_expired(), as the CURLMOPT_TIMERFUNCTION of its multi handle.
+ */
+static int _az_http_client_async_timer_callback(CURLM* multi, long timeout_ms, void* user_pointer)
+{
+  (void)multi;
+  az_http_client_async const* const client = (az_http_client_async const*)user_pointer;
+
+  int32_t const timeout_msec = timeout_ms > INT32_MAX ? INT32_MAX : (int32_t)timeout_ms;
+  client->_internal.timer_callback(client->_internal.callback_context, timeout_msec);
+  return 0;
+}
+
+AZ_NODISCARD az_result az_http_client_async_init(
+    az_http_client_async* out_client,
+    az_http_client_async_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_client);
+  _az_PRECONDITION(options == NULL || options->max_host_connections >= 0);
+  _az_PRECONDITION(
+      options == NULL || (options->socket_callback == NULL) == (options->timer_callback == NULL));
+
+  az_http_client_async_options const client_options
+      = options == NULL ? az_http_client_async_options_default() : *options;
+
+  CURLM* const multi = curl_multi_init();
+  if (multi == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  // Without HTTP/2 support in libcurl, the requests fall back to HTTP/1.1 as documented.
+  bool const use_http2 = client_options.use_http2 && _az_http_client_curl_supports_http2();
+
+  CURLMcode code = CURLM_OK;
+#if LIBCURL_VERSION_NUM >= 0x072F00
+  if (use_http2)
+  {
+    code = curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  }
+#endif
+
+  if (code == CURLM_OK && client_options.max_host_connections > 0)
+  {
+    code = curl_multi_setopt(
+        multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)client_options.max_host_connections);
+  }
+
+  // The callbacks are given the client, which the caller must not move once it is initialized.
+  if (code == CURLM_OK && client_options.socket_callback != NULL)
+  {
+    code = curl_multi_setopt(
+        multi, CURLMOPT_SOCKETFUNCTION, _az_http_client_async_socket_callback);
+    if (code == CURLM_OK)
+    {
+      code = curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, (void*)out_client);
+    }
+    if (code == CURLM_OK)
+    {
+      code = curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, _az_http_client_async_timer_callback);
+    }
+    if (code == CURLM_OK)
+    {
+      code = curl_multi_setopt(multi, CURLMOPT_TIMERDATA, (void*)out_client);
+    }
+  }
+
+  if (code != CURLM_OK)
+  {
+    (void)curl_multi_cleanup(multi);
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  *out_client = (az_http_client_async){
+    ._internal = {
+      .multi_handle = multi,
+      .operations = NULL,
+      .pending_count = 0,
+      .use_http2 = use_http2,
+      .socket_callback = client_options.socket_callback,
+      .timer_callback = client_options.timer_callback,
+      .callback_context = client_options.callback_context,
+    },
+  };
+
+  return AZ_OK;
+}
+
+/**
+ * @brief asks for HTTP/2 over TLS on a request of an #az_http_client_async which uses HTTP/2.
+ *
+ * @remarks The request waits for a connection which is being established to the same host to
+ * tell whether it can be multiplexed, rather than opening a connection of its own. Without this,
+ * requests submitted together would each open one before the first finds out.
+ */
+static AZ_NODISCARD az_result
+_az_http_client_async_setup_http2(az_http_client_async const* client, CURL* ref_curl)
+{
+  if (!client->_internal.use_http2)
+  {
+    return AZ_OK;
+  }
+
+#if LIBCURL_VERSION_NUM >= 0x072F00
+  _az_RETURN_IF_CURL_FAILED(
+      curl_easy_setopt(ref_curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS));
+  _az_RETURN_IF_CURL_FAILED(curl_easy_setopt(ref_curl, CURLOPT_PIPEWAIT, 1L));
+#else
+  (void)ref_curl;
+#endif
+
+  return AZ_OK;
+}
+
+/**
+ * @brief detaches a finished (or abandoned) operation from the multi handle, releases everything
+ * curl allocated for it and records its final result.
+ */
+static void _az_http_client_async_complete(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* ref_operation,
+    az_result result)
+{
+  CURL* const curl = (CURL*)ref_operation->_internal.easy_handle;
+  (void)curl_multi_remove_handle((CURLM*)ref_client->_internal.multi_handle, curl);
+  curl_easy_cleanup(curl);
+
+  struct curl_slist* headers = (struct curl_slist*)ref_operation->_internal.headers;
+  _az_http_client_curl_release_request(&headers, &ref_operation->_internal.post_body);
+
+  // Unlink the operation from the list of operations in flight.
+  az_http_client_async_operation** ref_link = &ref_client->_internal.operations;
+  while (*ref_link != NULL && *ref_link != ref_operation)
+  {
+    ref_link = &(*ref_link)->_internal.next;
+  }
+
+  if (*ref_link != NULL)
+  {
+    *ref_link = ref_operation->_internal.next;
+  }
+
+  ref_operation->_internal.easy_handle = NULL;
+  ref_operation->_internal.headers = NULL;
+  ref_operation->_internal.next = NULL;
+  ref_operation->_internal.result = result;
+  ref_operation->_internal.completed = true;
+  ref_client->_internal.pending_count--;
+}
+
+AZ_NODISCARD az_result az_http_client_async_submit(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* out_operation,
+    az_http_request const* request,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.multi_handle);
+  _az_PRECONDITION_NOT_NULL(out_operation);
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  // Easy handles added to the same multi handle already share their connection, DNS and TLS
+  // session caches, so there is no need to attach the connection reuse share handle here.
+  CURL* const curl = curl_easy_init();
+  if (curl == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  *out_operation = (az_http_client_async_operation){
+    ._internal = {
+      .easy_handle = curl,
+      .headers = NULL,
+      .post_body = AZ_SPAN_EMPTY,
+      .upload_body = { 0 },
+      .result = AZ_OK,
+      .completed = false,
+      .next = NULL,
+    },
+  };
+
+  struct curl_slist* headers = NULL;
+
+  az_result result = _az_http_client_curl_code_to_result(
+      curl_easy_setopt(curl, CURLOPT_PRIVATE, (void*)out_operation));
+
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_client_async_setup_http2(ref_client, curl);
+  }
+
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_client_curl_setup_request(
+        curl,
+        request,
+        ref_response,
+        &headers,
+        NULL,
+        &out_operation->_internal.post_body,
+        &out_operation->_internal.upload_body);
+  }
+
+  if (az_result_succeeded(result)
+      && curl_multi_add_handle((CURLM*)ref_client->_internal.multi_handle, curl) != CURLM_OK)
+  {
+    result = AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  if (az_result_failed(result))
+  {
+    _az_http_client_curl_release_request(&headers, &out_operation->_internal.post_body);
+    curl_easy_cleanup(curl);
+    out_operation->_internal.easy_handle = NULL;
+    return result;
+  }
+
+  out_operation->_internal.headers = headers;
+  out_operation->_internal.next = ref_client->_internal.operations;
+  ref_client->_internal.operations = out_operation;
+  ref_client->_internal.pending_count++;
+
+  return AZ_OK;
+}
+
+/**
+ * @brief completes the operations whose transfers curl has finished.
+ */
+static void _az_http_client_async_complete_finished(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count)
+{
+  CURLM* const multi = (CURLM*)ref_client->_internal.multi_handle;
+
+  CURLMsg* message = NULL;
+  int messages_left = 0;
+  while ((message = curl_multi_info_read(multi, &messages_left)) != NULL)
+  {
+    if (message->msg == CURLMSG_DONE)
+    {
+      char* operation = NULL;
+      CURLcode const code = message->data.result;
+      if (curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &operation) == CURLE_OK
+          && operation != NULL)
+      {
+        _az_http_client_async_complete(
+            ref_client,
+            (az_http_client_async_operation*)(void*)operation,
+            _az_http_client_curl_code_to_result(code));
+      }
+    }
+  }
+
+  if (out_pending_count != NULL)
+  {
+    *out_pending_count = ref_client->_internal.pending_count;
+  }
+}
+
+AZ_NODISCARD az_result az_http_client_async_poll(
+    az_http_client_async* ref_client,
+    int32_t timeout_msec,
+    int32_t* out_pending_count)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.multi_handle);
+  _az_PRECONDITION(ref_client->_internal.socket_callback == NULL);
+  _az_PRECONDITION(timeout_msec >= 0);
+
+  CURLM* const multi = (CURLM*)ref_client->_internal.multi_handle;
+
+  int running = 0;
+  if (curl_multi_perform(multi, &running) != CURLM_OK)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  if (running > 0 && timeout_msec > 0)
+  {
+    // Wait for activity on any of the connections (or the timeout), then move transfers forward.
+    if (curl_multi_wait(multi, NULL, 0, timeout_msec, NULL) != CURLM_OK
+        || curl_multi_perform(multi, &running) != CURLM_OK)
+    {
+      return AZ_ERROR_HTTP_ADAPTER;
+    }
+  }
+
+  _az_http_client_async_complete_finished(ref_client, out_pending_count);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_client_async_socket_action(
+    az_http_client_async* ref_client,
+    intptr_t socket,
+    az_http_client_async_socket_events events,
+    int32_t* out_pending_count)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.multi_handle);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.socket_callback);
+
+  int mask = 0;
+  if ((events & AZ_HTTP_CLIENT_ASYNC_SOCKET_IN) != 0)
+  {
+    mask |= CURL_CSELECT_IN;
+  }
+  if ((events & AZ_HTTP_CLIENT_ASYNC_SOCKET_OUT) != 0)
+  {
+    mask |= CURL_CSELECT_OUT;
+  }
+
+  int running = 0;
+  if (curl_multi_socket_action(
+          (CURLM*)ref_client->_internal.multi_handle, (curl_socket_t)socket, mask, &running)
+      != CURLM_OK)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  _az_http_client_async_complete_finished(ref_client, out_pending_count);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_client_async_timer_expired(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.multi_handle);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.timer_callback);
+
+  int running = 0;
+  if (curl_multi_socket_action(
+          (CURLM*)ref_client->_internal.multi_handle, CURL_SOCKET_TIMEOUT, 0, &running)
+      != CURLM_OK)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  _az_http_client_async_complete_finished(ref_client, out_pending_count);
+  return AZ_OK;
+}
+
+void az_http_client_async_cancel(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* ref_operation)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_operation);
+
+  // An operation which failed to submit has no easy handle and was never in flight.
+  if (!ref_operation->_internal.completed && ref_operation->_internal.easy_handle != NULL)
+  {
+    _az_http_client_async_complete(ref_client, ref_operation, AZ_ERROR_CANCELED);
+  }
+}
+
+void az_http_client_async_cleanup(az_http_client_async* ref_client)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+
+  if (ref_client->_internal.multi_handle == NULL)
+  {
+    return;
+  }
+
+  // Anything still in flight is abandoned.
+  while (ref_client->_internal.operations != NULL)
+  {
+    _az_http_client_async_complete(
+        ref_client, ref_client->_internal.operations, AZ_ERROR_CANCELED);
+  }
+
+  (void)curl_multi_cleanup((CURLM*)ref_client->_internal.multi_handle);
+  ref_client->_internal.multi_handle = NULL;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief The easy handles the libcurl transport adapter sends each request with, from the
+ * connection cache when connection reuse is enabled.
+ */
+
+#ifndef _az_CURL_PRIVATE_H
+#define _az_CURL_PRIVATE_H
+
+#include <azure/core/az_result.h>
+
+#include <curl/curl.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+/**
+ * @brief Gets an easy handle for a request: one of the handles kept by the connection cache which
+ * no other request claimed, or else a transient handle of its own, attached to the same share
+ * handle.
+ *
+ * @param[out] out The easy handle, which #_az_http_client_curl_done() gives back.
+ */
+AZ_NODISCARD az_result _az_http_client_curl_init(CURL** out);
+
+/**
+ * @brief Gives back the easy handle of a request. A kept handle is released for the next request,
+ * and a transient one is cleaned up.
+ *
+ * @param[in,out] pp The easy handle, which is set to `NULL`.
+ */
+AZ_NODISCARD az_result _az_http_client_curl_done(CURL** pp);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_CURL_PRIVATE_H
@@ -0,0 +1,463 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_lwip_http_private.h"
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <azure/core/_az_cfg.h>
+
+static az_span const _az_http_lwip_header_names[] = {
+  AZ_SPAN_LITERAL_FROM_STR("content-length"),
+  AZ_SPAN_LITERAL_FROM_STR("transfer-encoding"),
+  AZ_SPAN_LITERAL_FROM_STR("connection"),
+};
+
+static AZ_NODISCARD uint8_t _az_http_lwip_tolower(uint8_t value)
+{
+  return (value >= 'A' && value <= 'Z') ? (uint8_t)(value + ('a' - 'A')) : value;
+}
+
+static AZ_NODISCARD int32_t _az_http_lwip_hex_value(uint8_t value)
+{
+  if (value >= '0' && value <= '9')
+  {
+    return value - '0';
+  }
+
+  uint8_t const lower = _az_http_lwip_tolower(value);
+  return (lower >= 'a' && lower <= 'f') ? lower - 'a' + 10 : -1;
+}
+
+void _az_http_lwip_parser_init(_az_http_lwip_parser* out_parser, bool is_head)
+{
+  *out_parser = (_az_http_lwip_parser){
+    .state = _az_HTTP_LWIP_PARSE_STATUS_LINE,
+    .is_head = is_head,
+    .status_code = 0,
+    .status_digit_count = -1,
+    .name_candidates = 0,
+    .name_length = 0,
+    .header = _az_HTTP_LWIP_HEADER_OTHER,
+    .value_match_length = 0,
+    .has_content_length = false,
+    .is_chunked = false,
+    .is_close = false,
+    .remaining = 0,
+    .digit_count = 0,
+  };
+}
+
+static void _az_http_lwip_parser_start_header_line(_az_http_lwip_parser* ref_parser)
+{
+  ref_parser->state = _az_HTTP_LWIP_PARSE_HEADER_NAME;
+  ref_parser->name_candidates = (1 << _az_HTTP_LWIP_HEADER_CONTENT_LENGTH)
+      | (1 << _az_HTTP_LWIP_HEADER_TRANSFER_ENCODING) | (1 << _az_HTTP_LWIP_HEADER_CONNECTION);
+  ref_parser->name_length = 0;
+}
+
+static void _az_http_lwip_parser_start_chunk(_az_http_lwip_parser* ref_parser)
+{
+  ref_parser->state = _az_HTTP_LWIP_PARSE_CHUNK_SIZE;
+  ref_parser->remaining = 0;
+  ref_parser->digit_count = 0;
+}
+
+// Picks where the body ends once the headers are parsed, the way RFC 7230 section 3.3.3 does.
+static void _az_http_lwip_parser_end_headers(_az_http_lwip_parser* ref_parser)
+{
+  int32_t const status_code = ref_parser->status_code;
+  if (ref_parser->is_head || (status_code >= 100 && status_code < 200) || status_code == 204
+      || status_code == 304)
+  {
+    ref_parser->state = _az_HTTP_LWIP_PARSE_DONE;
+  }
+  else if (ref_parser->is_chunked)
+  {
+    _az_http_lwip_parser_start_chunk(ref_parser);
+  }
+  else if (ref_parser->has_content_length)
+  {
+    ref_parser->state = ref_parser->remaining > 0 ? _az_HTTP_LWIP_PARSE_BODY_LENGTH
+                                                  : _az_HTTP_LWIP_PARSE_DONE;
+  }
+  else
+  {
+    // The body ends when the server closes the connection, which can't be used again.
+    ref_parser->state = _az_HTTP_LWIP_PARSE_BODY_UNTIL_CLOSE;
+    ref_parser->is_close = true;
+  }
+}
+
+// Matches the value of Transfer-Encoding or Connection against the token which matters, wherever
+// it is in the list of the value.
+static void _az_http_lwip_parser_match_value(
+    _az_http_lwip_parser* ref_parser,
+    az_span token,
+    uint8_t value,
+    bool* ref_is_found)
+{
+  uint8_t const lower = _az_http_lwip_tolower(value);
+  if (lower == az_span_ptr(token)[ref_parser->value_match_length])
+  {
+    ref_parser->value_match_length++;
+    if (ref_parser->value_match_length == az_span_size(token))
+    {
+      *ref_is_found = true;
+      ref_parser->value_match_length = 0;
+    }
+  }
+  else
+  {
+    ref_parser->value_match_length = lower == az_span_ptr(token)[0] ? 1 : 0;
+  }
+}
+
+static AZ_NODISCARD az_result
+_az_http_lwip_parser_parse_header_byte(_az_http_lwip_parser* ref_parser, uint8_t value)
+{
+  switch (ref_parser->state)
+  {
+    case _az_HTTP_LWIP_PARSE_STATUS_LINE:
+      if (value == '\n')
+      {
+        _az_http_lwip_parser_start_header_line(ref_parser);
+      }
+      else if (ref_parser->status_digit_count < 0)
+      {
+        if (value == ' ')
+        {
+          ref_parser->status_digit_count = 0;
+        }
+      }
+      else if (ref_parser->status_digit_count < 3 && value >= '0' && value <= '9')
+      {
+        ref_parser->status_code = (ref_parser->status_code * 10) + (value - '0');
+        ref_parser->status_digit_count++;
+      }
+      break;
+
+    case _az_HTTP_LWIP_PARSE_HEADER_NAME:
+      if (ref_parser->name_length == 0 && value == '\r')
+      {
+        ref_parser->state = _az_HTTP_LWIP_PARSE_HEADERS_END;
+      }
+      else if (value == '\n')
+      {
+        if (ref_parser->name_length == 0)
+        {
+          _az_http_lwip_parser_end_headers(ref_parser);
+        }
+        else
+        {
+          // A line without a colon is left for az_http_response to reject.
+          _az_http_lwip_parser_start_header_line(ref_parser);
+        }
+      }
+      else if (value == ':')
+      {
+        ref_parser->header = _az_HTTP_LWIP_HEADER_OTHER;
+        for (int32_t i = 0; i < _az_HTTP_LWIP_HEADER_OTHER; i++)
+        {
+          if ((ref_parser->name_candidates & (1 << i)) != 0
+              && ref_parser->name_length == az_span_size(_az_http_lwip_header_names[i]))
+          {
+            ref_parser->header = (_az_http_lwip_header)i;
+          }
+        }
+
+        ref_parser->value_match_length = 0;
+        ref_parser->state = _az_HTTP_LWIP_PARSE_HEADER_VALUE;
+      }
+      else
+      {
+        uint8_t const lower = _az_http_lwip_tolower(value);
+        for (int32_t i = 0; i < _az_HTTP_LWIP_HEADER_OTHER; i++)
+        {
+          az_span const name = _az_http_lwip_header_names[i];
+          if (ref_parser->name_length >= az_span_size(name)
+              || az_span_ptr(name)[ref_parser->name_length] != lower)
+          {
+            ref_parser->name_candidates &= (uint8_t) ~(1 << i);
+          }
+        }
+
+        ref_parser->name_length++;
+      }
+      break;
+
+    case _az_HTTP_LWIP_PARSE_HEADER_VALUE:
+      if (value == '\n')
+      {
+        _az_http_lwip_parser_start_header_line(ref_parser);
+      }
+      else if (ref_parser->header == _az_HTTP_LWIP_HEADER_CONTENT_LENGTH)
+      {
+        if (value >= '0' && value <= '9')
+        {
+          if (ref_parser->remaining > (INT64_MAX - 9) / 10)
+          {
+            return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
+          }
+
+          ref_parser->remaining = (ref_parser->remaining * 10) + (value - '0');
+          ref_parser->has_content_length = true;
+        }
+      }
+      else if (ref_parser->header == _az_HTTP_LWIP_HEADER_TRANSFER_ENCODING)
+      {
+        _az_http_lwip_parser_match_value(
+            ref_parser, AZ_SPAN_FROM_STR("chunked"), value, &ref_parser->is_chunked);
+      }
+      else if (ref_parser->header == _az_HTTP_LWIP_HEADER_CONNECTION)
+      {
+        _az_http_lwip_parser_match_value(
+            ref_parser, AZ_SPAN_FROM_STR("close"), value, &ref_parser->is_close);
+      }
+      break;
+
+    default: // _az_HTTP_LWIP_PARSE_HEADERS_END
+      if (value == '\n')
+      {
+        _az_http_lwip_parser_end_headers(ref_parser);
+      }
+      break;
+  }
+
+  return AZ_OK;
+}
+
+// Parses the size line of a chunk, which is the end of the body when it is 0.
+static AZ_NODISCARD az_result
+_az_http_lwip_parser_parse_chunk_size_byte(_az_http_lwip_parser* ref_parser, uint8_t value)
+{
+  if (value == '\n')
+  {
+    if (ref_parser->digit_count == 0)
+    {
+      return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
+    }
+
+    if (ref_parser->remaining == 0)
+    {
+      ref_parser->state = _az_HTTP_LWIP_PARSE_TRAILER;
+      ref_parser->digit_count = 0;
+    }
+    else
+    {
+      ref_parser->state = _az_HTTP_LWIP_PARSE_CHUNK_DATA;
+    }
+  }
+  else if (ref_parser->state == _az_HTTP_LWIP_PARSE_CHUNK_SIZE && value != '\r')
+  {
+    int32_t const digit = _az_http_lwip_hex_value(value);
+    if (digit >= 0)
+    {
+      if (ref_parser->remaining > (INT64_MAX >> 4))
+      {
+        return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
+      }
+
+      ref_parser->remaining = (ref_parser->remaining << 4) + digit;
+      ref_parser->digit_count++;
+    }
+    else if (value == ';' || value == ' ' || value == '\t')
+    {
+      ref_parser->state = _az_HTTP_LWIP_PARSE_CHUNK_EXTENSION;
+    }
+    else
+    {
+      return AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER;
+    }
+  }
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_http_lwip_append(az_http_response* ref_response, az_span source)
+{
+  if (az_result_failed(az_http_response_append(ref_response, source)))
+  {
+    return AZ_ERROR_HTTP_RESPONSE_OVERFLOW;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result _az_http_lwip_parser_parse(
+    _az_http_lwip_parser* ref_parser,
+    az_span data,
+    az_http_response* ref_response,
+    int32_t* out_consumed)
+{
+  uint8_t const* const ptr = az_span_ptr(data);
+  int32_t const size = az_span_size(data);
+  int32_t i = 0;
+
+  while (i < size && ref_parser->state != _az_HTTP_LWIP_PARSE_DONE)
+  {
+    switch (ref_parser->state)
+    {
+      case _az_HTTP_LWIP_PARSE_STATUS_LINE:
+      case _az_HTTP_LWIP_PARSE_HEADER_NAME:
+      case _az_HTTP_LWIP_PARSE_HEADER_VALUE:
+      case _az_HTTP_LWIP_PARSE_HEADERS_END:
+        _az_RETURN_IF_FAILED(_az_http_lwip_parser_parse_header_byte(ref_parser, ptr[i]));
+        i++;
+        if (ref_parser->state > _az_HTTP_LWIP_PARSE_HEADERS_END)
+        {
+          // The status line and the headers come first, and are passed on as they were received.
+          _az_RETURN_IF_FAILED(_az_http_lwip_append(ref_response, az_span_slice(data, 0, i)));
+        }
+        break;
+
+      case _az_HTTP_LWIP_PARSE_BODY_LENGTH:
+      case _az_HTTP_LWIP_PARSE_CHUNK_DATA:
+      {
+        int32_t const length
+            = ref_parser->remaining < size - i ? (int32_t)ref_parser->remaining : size - i;
+        _az_RETURN_IF_FAILED(
+            _az_http_lwip_append(ref_response, az_span_slice(data, i, i + length)));
+        i += length;
+        ref_parser->remaining -= length;
+        if (ref_parser->remaining == 0)
+        {
+          ref_parser->state = ref_parser->state == _az_HTTP_LWIP_PARSE_BODY_LENGTH
+              ? _az_HTTP_LWIP_PARSE_DONE
+              : _az_HTTP_LWIP_PARSE_CHUNK_DATA_END;
+        }
+        break;
+      }
+
+      case _az_HTTP_LWIP_PARSE_BODY_UNTIL_CLOSE:
+        _az_RETURN_IF_FAILED(_az_http_lwip_append(ref_response, az_span_slice_to_end(data, i)));
+        i = size;
+        break;
+
+      case _az_HTTP_LWIP_PARSE_CHUNK_SIZE:
+      case _az_HTTP_LWIP_PARSE_CHUNK_EXTENSION:
+        _az_RETURN_IF_FAILED(_az_http_lwip_parser_parse_chunk_size_byte(ref_parser, ptr[i]));
+        i++;
+        break;
+
+      case _az_HTTP_LWIP_PARSE_CHUNK_DATA_END:
+        if (ptr[i] == '\n')
+        {
+          _az_http_lwip_parser_start_chunk(ref_parser);
+        }
+        i++;
+        break;
+
+      default: // _az_HTTP_LWIP_PARSE_TRAILER
+        // Trailer fields are skipped, until the empty line which ends the body.
+        if (ptr[i] == '\n')
+        {
+          if (ref_parser->digit_count == 0)
+          {
+            ref_parser->state = _az_HTTP_LWIP_PARSE_DONE;
+          }
+          ref_parser->digit_count = 0;
+        }
+        else if (ptr[i] != '\r')
+        {
+          ref_parser->digit_count++;
+        }
+        i++;
+        break;
+    }
+  }
+
+  if (ref_parser->state <= _az_HTTP_LWIP_PARSE_HEADERS_END)
+  {
+    _az_RETURN_IF_FAILED(_az_http_lwip_append(ref_response, az_span_slice(data, 0, i)));
+  }
+
+  *out_consumed = i;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result _az_http_lwip_writer_flush(_az_http_lwip_writer* ref_writer)
+{
+  if (ref_writer->length > 0)
+  {
+    _az_RETURN_IF_FAILED(ref_writer->write(
+        ref_writer->request, az_span_create(ref_writer->buffer, ref_writer->length)));
+    ref_writer->length = 0;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result _az_http_lwip_writer_append(_az_http_lwip_writer* ref_writer, az_span data)
+{
+  while (az_span_size(data) > 0)
+  {
+    if (ref_writer->length == _az_HTTP_LWIP_SEND_BUFFER_SIZE)
+    {
+      _az_RETURN_IF_FAILED(_az_http_lwip_writer_flush(ref_writer));
+    }
+
+    int32_t const available = _az_HTTP_LWIP_SEND_BUFFER_SIZE - ref_writer->length;
+    int32_t const length = az_span_size(data) < available ? az_span_size(data) : available;
+    memcpy(ref_writer->buffer + ref_writer->length, az_span_ptr(data), (size_t)length);
+    ref_writer->length += length;
+    data = az_span_slice_to_end(data, length);
+  }
+
+  return AZ_OK;
+}
+
+// The size line before the data of a chunk, "XXX\r\n", and the line end after it. Three
+// hexadecimal digits cover the whole writer buffer.
+#define _az_HTTP_LWIP_CHUNK_SIZE_LINE_SIZE 5
+#define _az_HTTP_LWIP_CHUNK_FRAMING_SIZE (_az_HTTP_LWIP_CHUNK_SIZE_LINE_SIZE + 2)
+
+AZ_NODISCARD az_result _az_http_lwip_write_chunked_body(_az_http_lwip_writer* ref_writer)
+{
+  static uint8_t const hex_digits[] = "0123456789ABCDEF";
+
+  int64_t offset = 0;
+  while (true)
+  {
+    if (ref_writer->length > _az_HTTP_LWIP_SEND_BUFFER_SIZE - _az_HTTP_LWIP_CHUNK_FRAMING_SIZE - 1)
+    {
+      _az_RETURN_IF_FAILED(_az_http_lwip_writer_flush(ref_writer));
+    }
+
+    // The data is read after the room left for the size line, which is written once it is known.
+    uint8_t* const chunk = ref_writer->buffer + ref_writer->length;
+    int32_t read = 0;
+    _az_RETURN_IF_FAILED(az_http_request_read_body(
+        ref_writer->request,
+        offset,
+        az_span_create(
+            chunk + _az_HTTP_LWIP_CHUNK_SIZE_LINE_SIZE,
+            _az_HTTP_LWIP_SEND_BUFFER_SIZE - ref_writer->length
+                - _az_HTTP_LWIP_CHUNK_FRAMING_SIZE),
+        &read));
+    if (read == 0)
+    {
+      // The last chunk is empty, and no trailer follows it.
+      _az_RETURN_IF_FAILED(
+          _az_http_lwip_writer_append(ref_writer, AZ_SPAN_FROM_STR("0\r\n\r\n")));
+      return _az_http_lwip_writer_flush(ref_writer);
+    }
+
+    chunk[0] = hex_digits[(read >> 8) & 0xF];
+    chunk[1] = hex_digits[(read >> 4) & 0xF];
+    chunk[2] = hex_digits[read & 0xF];
+    chunk[3] = '\r';
+    chunk[4] = '\n';
+    chunk[_az_HTTP_LWIP_CHUNK_SIZE_LINE_SIZE + read] = '\r';
+    chunk[_az_HTTP_LWIP_CHUNK_SIZE_LINE_SIZE + read + 1] = '\n';
+
+    ref_writer->length += _az_HTTP_LWIP_CHUNK_FRAMING_SIZE + read;
+    offset += read;
+  }
+}
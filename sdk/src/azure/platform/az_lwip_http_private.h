@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file
+ *
+ * @brief The HTTP/1.1 framing of the lwIP and mbedTLS transport adapter: the parser of the
+ * responses it receives and the writer of the requests it sends, which don't depend on lwIP or
+ * mbedTLS.
+ */
+
+#ifndef _az_LWIP_HTTP_PRIVATE_H
+#define _az_LWIP_HTTP_PRIVATE_H
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <azure/core/_az_cfg_prefix.h>
+
+// The request is written to TCP, or to TLS, in pieces of this size, so that its line and headers
+// take as few segments and records as they can.
+#define _az_HTTP_LWIP_SEND_BUFFER_SIZE 512
+
+/*
+ * The response is parsed as it is received, without being buffered: its status line and headers
+ * are passed to the az_http_response unchanged, while the few headers which tell where the body
+ * ends are recognized byte by byte, and its body is decoded from its transfer coding.
+ */
+typedef enum
+{
+  _az_HTTP_LWIP_PARSE_STATUS_LINE,
+  _az_HTTP_LWIP_PARSE_HEADER_NAME,
+  _az_HTTP_LWIP_PARSE_HEADER_VALUE,
+  _az_HTTP_LWIP_PARSE_HEADERS_END,
+  _az_HTTP_LWIP_PARSE_BODY_LENGTH,
+  _az_HTTP_LWIP_PARSE_BODY_UNTIL_CLOSE,
+  _az_HTTP_LWIP_PARSE_CHUNK_SIZE,
+  _az_HTTP_LWIP_PARSE_CHUNK_EXTENSION,
+  _az_HTTP_LWIP_PARSE_CHUNK_DATA,
+  _az_HTTP_LWIP_PARSE_CHUNK_DATA_END,
+  _az_HTTP_LWIP_PARSE_TRAILER,
+  _az_HTTP_LWIP_PARSE_DONE,
+} _az_http_lwip_parse_state;
+
+// The headers the parser recognizes, which are also the bits of its name candidates.
+typedef enum
+{
+  _az_HTTP_LWIP_HEADER_CONTENT_LENGTH = 0,
+  _az_HTTP_LWIP_HEADER_TRANSFER_ENCODING = 1,
+  _az_HTTP_LWIP_HEADER_CONNECTION = 2,
+  _az_HTTP_LWIP_HEADER_OTHER = 3,
+} _az_http_lwip_header;
+
+typedef struct
+{
+  _az_http_lwip_parse_state state;
+  bool is_head;
+
+  int32_t status_code;
+  int32_t status_digit_count; // -1 until the space after the HTTP version.
+
+  uint8_t name_candidates;
+  int32_t name_length;
+  _az_http_lwip_header header;
+  int32_t value_match_length;
+
+  bool has_content_length;
+  bool is_chunked;
+  bool is_close;
+  int64_t remaining;
+  int32_t digit_count;
+} _az_http_lwip_parser;
+
+/**
+ * @brief Starts parsing a response.
+ *
+ * @param is_head Whether the response is to a HEAD request, which it has no body for.
+ */
+void _az_http_lwip_parser_init(_az_http_lwip_parser* out_parser, bool is_head);
+
+/**
+ * @brief Parses the next bytes of the response, and writes them into \p ref_response.
+ *
+ * @param data The bytes received, straight from a pbuf or decrypted by mbedTLS.
+ * @param out_consumed The bytes of \p data which are part of the response. They are fewer than the
+ * size of \p data only once the whole response was parsed.
+ *
+ * @retval #AZ_ERROR_HTTP_RESPONSE_OVERFLOW The response doesn't fit in \p ref_response.
+ * @retval #AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER A length or chunk size line is malformed.
+ */
+AZ_NODISCARD az_result _az_http_lwip_parser_parse(
+    _az_http_lwip_parser* ref_parser,
+    az_span data,
+    az_http_response* ref_response,
+    int32_t* out_consumed);
+
+/**
+ * @brief Writes bytes of \p request to its connection, all of them or none.
+ */
+typedef AZ_NODISCARD az_result (*_az_http_lwip_write_fn)(
+    az_http_request const* request,
+    az_span data);
+
+// Coalesces the small pieces of the request line and headers into few writes.
+typedef struct
+{
+  az_http_request const* request;
+  _az_http_lwip_write_fn write;
+  int32_t length;
+  uint8_t buffer[_az_HTTP_LWIP_SEND_BUFFER_SIZE];
+} _az_http_lwip_writer;
+
+/**
+ * @brief Writes what the writer buffer holds, if anything.
+ */
+AZ_NODISCARD az_result _az_http_lwip_writer_flush(_az_http_lwip_writer* ref_writer);
+
+/**
+ * @brief Copies \p data into the writer buffer, writing the buffer each time it is full.
+ */
+AZ_NODISCARD az_result _az_http_lwip_writer_append(_az_http_lwip_writer* ref_writer, az_span data);
+
+/**
+ * @brief Writes a body of unknown size with chunked transfer coding, a chunk for each piece the
+ * body provider fills the writer buffer with, until it provides no more bytes.
+ */
+AZ_NODISCARD az_result _az_http_lwip_write_chunked_body(_az_http_lwip_writer* ref_writer);
+
+#include <azure/core/_az_cfg_suffix.h>
+
+#endif // _az_LWIP_HTTP_PRIVATE_H
@@ -0,0 +1,957 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_lwip_http_private.h"
+#include <azure/core/az_context.h>
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_config_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+#include <azure/platform/az_lwip_mbedtls.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <lwip/dns.h>
+#include <lwip/ip_addr.h>
+#include <lwip/pbuf.h>
+#include <lwip/tcp.h>
+
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+
+#include <azure/core/_az_cfg.h>
+
+// The longest host name a connection can be made to, with its 0-terminator.
+#define _az_HTTP_LWIP_MAX_HOST_SIZE 128
+
+// The bytes of a TLS response decrypted at a time, before they are passed to the response.
+#define _az_HTTP_LWIP_RECEIVE_CHUNK_SIZE 512
+
+/*
+ * The adapter has a single connection, which is kept alive between requests once connection reuse
+ * is enabled. Its lwIP callbacks run from the poll callback, or from the lwIP calls of the adapter,
+ * so they only record what happened for the request to act on.
+ */
+typedef struct
+{
+  struct tcp_pcb* pcb;
+
+  // The pbufs received and not consumed yet, and the bytes of the first one which were.
+  struct pbuf* received;
+  uint16_t received_offset;
+
+  bool is_connected;
+  bool is_closed;
+  err_t error;
+
+  bool is_tls;
+  bool is_reusable;
+  uint16_t port;
+  char host[_az_HTTP_LWIP_MAX_HOST_SIZE];
+} _az_http_lwip_connection;
+
+// The lookup of the host name of the connection, which lwIP completes from its DNS callback.
+typedef struct
+{
+  bool is_done;
+  bool is_found;
+  ip_addr_t address;
+} _az_http_lwip_resolution;
+
+static az_http_client_lwip_options _az_http_lwip_options;
+static bool _az_http_lwip_is_initialized = false;
+static bool _az_http_lwip_is_reuse_enabled = false;
+static mbedtls_ssl_context _az_http_lwip_tls;
+static _az_http_lwip_connection _az_http_lwip_connection_state;
+static _az_http_lwip_resolution _az_http_lwip_resolution_state;
+
+/*
+ * lwIP callbacks.
+ */
+
+static void _az_http_lwip_on_resolved(char const* name, ip_addr_t const* address, void* arg)
+{
+  _az_http_lwip_resolution* const resolution = (_az_http_lwip_resolution*)arg;
+
+  // A lookup which timed out may still complete, for another host than the current one.
+  if (strcmp(name, _az_http_lwip_connection_state.host) != 0)
+  {
+    return;
+  }
+
+  resolution->is_found = address != NULL;
+  if (address != NULL)
+  {
+    ip_addr_copy(resolution->address, *address);
+  }
+  resolution->is_done = true;
+}
+
+static err_t _az_http_lwip_on_connected(void* arg, struct tcp_pcb* pcb, err_t err)
+{
+  (void)pcb;
+  ((_az_http_lwip_connection*)arg)->is_connected = err == ERR_OK;
+  return ERR_OK;
+}
+
+static err_t _az_http_lwip_on_received(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err)
+{
+  (void)pcb;
+  _az_http_lwip_connection* const connection = (_az_http_lwip_connection*)arg;
+
+  if (p == NULL)
+  {
+    connection->is_closed = true;
+  }
+  else if (err != ERR_OK)
+  {
+    (void)pbuf_free(p);
+  }
+  else if (connection->received == NULL)
+  {
+    connection->received = p;
+  }
+  else
+  {
+    // The pbufs are kept as lwIP filled them, and only opened in the TCP window once consumed.
+    pbuf_cat(connection->received, p);
+  }
+
+  return ERR_OK;
+}
+
+static void _az_http_lwip_on_error(void* arg, err_t err)
+{
+  _az_http_lwip_connection* const connection = (_az_http_lwip_connection*)arg;
+
+  // lwIP has already freed the pcb.
+  connection->pcb = NULL;
+  connection->is_closed = true;
+  connection->error = err;
+}
+
+// Releases the first bytes of the received pbufs, and opens the TCP window by as much.
+static void _az_http_lwip_consume(_az_http_lwip_connection* ref_connection, uint16_t size)
+{
+  struct pbuf* const head = ref_connection->received;
+  ref_connection->received_offset = (uint16_t)(ref_connection->received_offset + size);
+
+  if (ref_connection->received_offset >= head->len)
+  {
+    // The rest of the chain is kept, while the pbuf which was consumed is freed.
+    struct pbuf* const rest = head->next;
+    if (rest != NULL)
+    {
+      pbuf_ref(rest);
+    }
+    (void)pbuf_free(head);
+
+    ref_connection->received = rest;
+    ref_connection->received_offset = 0;
+  }
+
+  if (ref_connection->pcb != NULL && size > 0)
+  {
+    tcp_recved(ref_connection->pcb, size);
+  }
+}
+
+/**
+ * @brief Runs lwIP once, unless the request has waited for too long.
+ *
+ * @param deadline_msec The time, in #az_platform_clock_msec() time, by which whatever the request
+ * waits for must have happened.
+ */
+static AZ_NODISCARD az_result
+_az_http_lwip_wait(az_http_request const* request, int64_t deadline_msec)
+{
+  int64_t const now = az_platform_clock_msec();
+  if (request->_internal.context != NULL && az_context_has_expired(request->_internal.context, now))
+  {
+    return AZ_ERROR_CANCELED;
+  }
+
+  if (now >= deadline_msec)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  _az_http_lwip_options.poll(_az_http_lwip_options.poll_context);
+  return AZ_OK;
+}
+
+static AZ_NODISCARD int64_t _az_http_lwip_deadline()
+{
+  return az_platform_clock_msec() + _az_http_lwip_options.timeout_msec;
+}
+
+/*
+ * mbedTLS callbacks, through which TLS records go over the TCP connection.
+ */
+
+static int _az_http_lwip_tls_send(void* context, unsigned char const* buffer, size_t length)
+{
+  _az_http_lwip_connection* const connection = (_az_http_lwip_connection*)context;
+  if (connection->pcb == NULL || connection->error != ERR_OK)
+  {
+    return MBEDTLS_ERR_NET_CONN_RESET;
+  }
+
+  u16_t const available = tcp_sndbuf(connection->pcb);
+  u16_t const size = length < available ? (u16_t)length : available;
+  if (size == 0 || tcp_write(connection->pcb, buffer, size, TCP_WRITE_FLAG_COPY) != ERR_OK)
+  {
+    // The send buffer or queue is full, until the server acknowledges what was sent.
+    (void)tcp_output(connection->pcb);
+    return MBEDTLS_ERR_SSL_WANT_WRITE;
+  }
+
+  (void)tcp_output(connection->pcb);
+  return (int)size;
+}
+
+static int _az_http_lwip_tls_receive(void* context, unsigned char* buffer, size_t length)
+{
+  _az_http_lwip_connection* const connection = (_az_http_lwip_connection*)context;
+  while (connection->received != NULL
+         && connection->received_offset >= connection->received->len)
+  {
+    _az_http_lwip_consume(connection, 0);
+  }
+
+  struct pbuf* const head = connection->received;
+  if (head == NULL)
+  {
+    if (connection->error != ERR_OK)
+    {
+      return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    return connection->is_closed ? 0 : MBEDTLS_ERR_SSL_WANT_READ;
+  }
+
+  u16_t const available = (u16_t)(head->len - connection->received_offset);
+  u16_t const size = length < available ? (u16_t)length : available;
+  memcpy(buffer, (uint8_t const*)head->payload + connection->received_offset, size);
+  _az_http_lwip_consume(connection, size);
+  return (int)size;
+}
+
+// Closes the connection, whether the request is done with it or it failed.
+static void _az_http_lwip_close()
+{
+  _az_http_lwip_connection* const connection = &_az_http_lwip_connection_state;
+
+  if (connection->pcb != NULL)
+  {
+    if (connection->is_tls && connection->is_connected && connection->error == ERR_OK)
+    {
+      // Best effort: the alert is sent if it fits in the send buffer.
+      (void)mbedtls_ssl_close_notify(&_az_http_lwip_tls);
+    }
+
+    tcp_arg(connection->pcb, NULL);
+    tcp_recv(connection->pcb, NULL);
+    tcp_err(connection->pcb, NULL);
+    if (tcp_close(connection->pcb) != ERR_OK)
+    {
+      tcp_abort(connection->pcb);
+    }
+    connection->pcb = NULL;
+  }
+
+  if (connection->received != NULL)
+  {
+    (void)pbuf_free(connection->received);
+    connection->received = NULL;
+  }
+
+  connection->received_offset = 0;
+  connection->is_connected = false;
+  connection->is_reusable = false;
+  connection->host[0] = '\0';
+}
+
+static AZ_NODISCARD az_result
+_az_http_lwip_resolve(az_http_request const* request, ip_addr_t* out_address)
+{
+  _az_http_lwip_resolution* const resolution = &_az_http_lwip_resolution_state;
+  resolution->is_done = false;
+  resolution->is_found = false;
+
+  err_t const err = dns_gethostbyname(
+      _az_http_lwip_connection_state.host, out_address, _az_http_lwip_on_resolved, resolution);
+  if (err == ERR_OK)
+  {
+    // The host name is an address, or it was in the DNS cache.
+    return AZ_OK;
+  }
+
+  if (err != ERR_INPROGRESS)
+  {
+    return AZ_ERROR_HTTP_RESPONSE_COULDNT_RESOLVE_HOST;
+  }
+
+  int64_t const deadline = _az_http_lwip_deadline();
+  while (!resolution->is_done)
+  {
+    _az_RETURN_IF_FAILED(_az_http_lwip_wait(request, deadline));
+  }
+
+  if (!resolution->is_found)
+  {
+    return AZ_ERROR_HTTP_RESPONSE_COULDNT_RESOLVE_HOST;
+  }
+
+  ip_addr_copy(*out_address, resolution->address);
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_http_lwip_tls_handshake(az_http_request const* request)
+{
+  _az_http_lwip_connection* const connection = &_az_http_lwip_connection_state;
+
+  // The context keeps its buffers from one connection to the next.
+  if (mbedtls_ssl_session_reset(&_az_http_lwip_tls) != 0
+      || mbedtls_ssl_set_hostname(&_az_http_lwip_tls, connection->host) != 0)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  int64_t deadline = _az_http_lwip_deadline();
+  int ret = 0;
+  while ((ret = mbedtls_ssl_handshake(&_az_http_lwip_tls)) != 0)
+  {
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+    {
+      return AZ_ERROR_HTTP_ADAPTER;
+    }
+
+    _az_RETURN_IF_FAILED(_az_http_lwip_wait(request, deadline));
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Gets a connection to \p host, either the one kept alive by the previous request, or a new
+ * one.
+ */
+static AZ_NODISCARD az_result
+_az_http_lwip_connect(az_http_request const* request, bool is_tls, az_span host, uint16_t port)
+{
+  _az_http_lwip_connection* const connection = &_az_http_lwip_connection_state;
+
+  if (connection->is_reusable && connection->pcb != NULL && !connection->is_closed
+      && connection->received == NULL && connection->is_tls == is_tls && connection->port == port
+      && az_span_is_content_equal(host, az_span_create_from_str(connection->host)))
+  {
+    connection->is_reusable = false;
+    return AZ_OK;
+  }
+
+  _az_http_lwip_close();
+
+  if (is_tls && _az_http_lwip_options.tls_config == NULL)
+  {
+    return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+  }
+
+  if (az_span_size(host) >= _az_HTTP_LWIP_MAX_HOST_SIZE)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  az_span_to_str(connection->host, _az_HTTP_LWIP_MAX_HOST_SIZE, host);
+  connection->is_tls = is_tls;
+  connection->port = port;
+  connection->is_closed = false;
+  connection->error = ERR_OK;
+
+  ip_addr_t address;
+  _az_RETURN_IF_FAILED(_az_http_lwip_resolve(request, &address));
+
+  connection->pcb = tcp_new_ip_type(IP_GET_TYPE(&address));
+  if (connection->pcb == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  tcp_arg(connection->pcb, connection);
+  tcp_recv(connection->pcb, _az_http_lwip_on_received);
+  tcp_err(connection->pcb, _az_http_lwip_on_error);
+
+  if (tcp_connect(connection->pcb, &address, port, _az_http_lwip_on_connected) != ERR_OK)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  int64_t const deadline = _az_http_lwip_deadline();
+  while (!connection->is_connected)
+  {
+    if (connection->is_closed)
+    {
+      return AZ_ERROR_HTTP_ADAPTER;
+    }
+
+    _az_RETURN_IF_FAILED(_az_http_lwip_wait(request, deadline));
+  }
+
+  return is_tls ? _az_http_lwip_tls_handshake(request) : AZ_OK;
+}
+
+// Writes bytes of the request to the connection, waiting for room in its send buffer as needed.
+static AZ_NODISCARD az_result _az_http_lwip_write(az_http_request const* request, az_span data)
+{
+  _az_http_lwip_connection* const connection = &_az_http_lwip_connection_state;
+  uint8_t const* ptr = az_span_ptr(data);
+  int32_t size = az_span_size(data);
+  int64_t deadline = _az_http_lwip_deadline();
+
+  while (size > 0)
+  {
+    int32_t written = 0;
+    if (connection->is_tls)
+    {
+      int const ret = mbedtls_ssl_write(&_az_http_lwip_tls, ptr, (size_t)size);
+      if (ret > 0)
+      {
+        written = ret;
+      }
+      else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+      {
+        return AZ_ERROR_HTTP_ADAPTER;
+      }
+    }
+    else
+    {
+      if (connection->pcb == NULL || connection->is_closed)
+      {
+        return AZ_ERROR_HTTP_ADAPTER;
+      }
+
+      u16_t const available = tcp_sndbuf(connection->pcb);
+      u16_t const length = size < available ? (u16_t)size : available;
+      if (length > 0 && tcp_write(connection->pcb, ptr, length, TCP_WRITE_FLAG_COPY) == ERR_OK)
+      {
+        written = length;
+      }
+      (void)tcp_output(connection->pcb);
+    }
+
+    if (written > 0)
+    {
+      ptr += written;
+      size -= written;
+      deadline = _az_http_lwip_deadline();
+    }
+    else
+    {
+      _az_RETURN_IF_FAILED(_az_http_lwip_wait(request, deadline));
+    }
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Splits the URL of a request into what the connection and the request line need.
+ *
+ * @param out_authority The host and port, as they are written in the Host header.
+ * @param out_path The path and query, which can be empty or start with `?`.
+ */
+static AZ_NODISCARD az_result _az_http_lwip_parse_url(
+    az_span url,
+    bool* out_is_tls,
+    az_span* out_authority,
+    az_span* out_host,
+    uint16_t* out_port,
+    az_span* out_path)
+{
+  int32_t const scheme_end = az_span_find(url, AZ_SPAN_FROM_STR("://"));
+  if (scheme_end < 0)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  az_span const scheme = az_span_slice(url, 0, scheme_end);
+  if (az_span_is_content_equal_ignoring_case(scheme, AZ_SPAN_FROM_STR("https")))
+  {
+    *out_is_tls = true;
+  }
+  else if (az_span_is_content_equal_ignoring_case(scheme, AZ_SPAN_FROM_STR("http")))
+  {
+    *out_is_tls = false;
+  }
+  else
+  {
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  az_span const rest = az_span_slice_to_end(url, scheme_end + 3);
+  int32_t authority_end = 0;
+  while (authority_end < az_span_size(rest) && az_span_ptr(rest)[authority_end] != '/'
+         && az_span_ptr(rest)[authority_end] != '?' && az_span_ptr(rest)[authority_end] != '#')
+  {
+    authority_end++;
+  }
+
+  az_span const authority = az_span_slice(rest, 0, authority_end);
+  az_span path = az_span_slice_to_end(rest, authority_end);
+  int32_t const fragment_start = az_span_find(path, AZ_SPAN_FROM_STR("#"));
+  if (fragment_start >= 0)
+  {
+    path = az_span_slice(path, 0, fragment_start);
+  }
+
+  // The port follows the last colon, unless it is within the brackets of an IPv6 address.
+  az_span host = authority;
+  az_span port = AZ_SPAN_EMPTY;
+  for (int32_t i = az_span_size(authority) - 1; i >= 0; i--)
+  {
+    uint8_t const value = az_span_ptr(authority)[i];
+    if (value == ']')
+    {
+      break;
+    }
+
+    if (value == ':')
+    {
+      host = az_span_slice(authority, 0, i);
+      port = az_span_slice_to_end(authority, i + 1);
+      break;
+    }
+  }
+
+  if (az_span_size(host) >= 2 && az_span_ptr(host)[0] == '[')
+  {
+    host = az_span_slice(host, 1, az_span_size(host) - 1);
+  }
+
+  if (az_span_size(host) == 0)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  uint32_t port_number = *out_is_tls ? 443 : 80;
+  if (az_span_size(port) > 0
+      && (az_result_failed(az_span_atou32(port, &port_number)) || port_number == 0
+          || port_number > UINT16_MAX))
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  *out_authority = authority;
+  *out_host = host;
+  *out_port = (uint16_t)port_number;
+  *out_path = path;
+  return AZ_OK;
+}
+
+// Writes the request line, the headers and the body of the request.
+static AZ_NODISCARD az_result _az_http_lwip_send(
+    az_http_request const* request,
+    az_http_method method,
+    az_span authority,
+    az_span path)
+{
+  _az_http_lwip_writer writer = { .request = request, .write = _az_http_lwip_write, .length = 0 };
+
+  _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, method));
+  _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR(" ")));
+  if (az_span_size(path) == 0 || az_span_ptr(path)[0] == '?')
+  {
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("/")));
+  }
+  _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, path));
+  _az_RETURN_IF_FAILED(
+      _az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR(" HTTP/1.1\r\nHost: ")));
+  _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, authority));
+  _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("\r\n")));
+
+  int32_t const header_count = az_http_request_headers_count(request);
+  for (int32_t i = 0; i < header_count; i++)
+  {
+    az_span name = AZ_SPAN_EMPTY;
+    az_span value = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(az_http_request_get_header(request, i, &name, &value));
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, name));
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR(": ")));
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, value));
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("\r\n")));
+  }
+
+  int64_t const body_size = az_http_request_get_body_size(request);
+  az_span content_length = AZ_SPAN_EMPTY;
+  if (body_size == AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN)
+  {
+    _az_RETURN_IF_FAILED(
+        _az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("Transfer-Encoding: chunked\r\n")));
+  }
+  else if (az_result_failed(az_http_request_get_header_by_id(
+          request, AZ_HTTP_HEADER_ID_CONTENT_LENGTH, &content_length))
+      && (body_size > 0 || az_span_is_content_equal(method, az_http_method_post())
+          || az_span_is_content_equal(method, az_http_method_put())
+          || az_span_is_content_equal(method, az_http_method_patch())))
+  {
+    uint8_t digits_buffer[_az_INT64_AS_STR_BUFFER_SIZE];
+    az_span const digits = AZ_SPAN_FROM_BUFFER(digits_buffer);
+    az_span remainder = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(az_span_i64toa(digits, body_size, &remainder));
+    _az_RETURN_IF_FAILED(
+        _az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("Content-Length: ")));
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(
+        &writer, az_span_slice(digits, 0, az_span_size(digits) - az_span_size(remainder))));
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("\r\n")));
+  }
+
+  if (!_az_http_lwip_is_reuse_enabled)
+  {
+    _az_RETURN_IF_FAILED(
+        _az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("Connection: close\r\n")));
+  }
+
+  _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, AZ_SPAN_FROM_STR("\r\n")));
+
+  if (request->_internal.body_provider == NULL)
+  {
+    // A body in a buffer is written as it is, when it doesn't fit with the headers.
+    az_span const body = request->_internal.body;
+    if (az_span_size(body) <= _az_HTTP_LWIP_SEND_BUFFER_SIZE - writer.length)
+    {
+      _az_RETURN_IF_FAILED(_az_http_lwip_writer_append(&writer, body));
+      return _az_http_lwip_writer_flush(&writer);
+    }
+
+    _az_RETURN_IF_FAILED(_az_http_lwip_writer_flush(&writer));
+    return _az_http_lwip_write(request, body);
+  }
+
+  if (body_size == AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN)
+  {
+    return _az_http_lwip_write_chunked_body(&writer);
+  }
+
+  // A body provider fills the writer buffer after the headers, and then one buffer at a time.
+  int64_t offset = 0;
+  while (offset < body_size)
+  {
+    if (writer.length == _az_HTTP_LWIP_SEND_BUFFER_SIZE)
+    {
+      _az_RETURN_IF_FAILED(_az_http_lwip_writer_flush(&writer));
+    }
+
+    int32_t read = 0;
+    _az_RETURN_IF_FAILED(az_http_request_read_body(
+        request,
+        offset,
+        az_span_create(
+            writer.buffer + writer.length, _az_HTTP_LWIP_SEND_BUFFER_SIZE - writer.length),
+        &read));
+    if (read == 0)
+    {
+      return AZ_ERROR_UNEXPECTED_END;
+    }
+
+    writer.length += read;
+    offset += read;
+  }
+
+  return _az_http_lwip_writer_flush(&writer);
+}
+
+/**
+ * @brief Receives the response, passing each pbuf, or each piece mbedTLS decrypts, to the parser
+ * as it arrives.
+ */
+static AZ_NODISCARD az_result _az_http_lwip_receive(
+    az_http_request const* request,
+    _az_http_lwip_parser* ref_parser,
+    az_http_response* ref_response)
+{
+  _az_http_lwip_connection* const connection = &_az_http_lwip_connection_state;
+  uint8_t chunk[_az_HTTP_LWIP_RECEIVE_CHUNK_SIZE];
+  int64_t deadline = _az_http_lwip_deadline();
+  bool is_end_of_stream = false;
+
+  while (ref_parser->state != _az_HTTP_LWIP_PARSE_DONE && !is_end_of_stream)
+  {
+    az_span data = AZ_SPAN_EMPTY;
+    if (connection->is_tls)
+    {
+      int const ret = mbedtls_ssl_read(&_az_http_lwip_tls, chunk, sizeof(chunk));
+      if (ret > 0)
+      {
+        data = az_span_create(chunk, ret);
+      }
+      else if (
+          ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == MBEDTLS_ERR_SSL_CONN_EOF)
+      {
+        is_end_of_stream = true;
+      }
+      else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+      {
+        return AZ_ERROR_HTTP_ADAPTER;
+      }
+    }
+    else if (connection->received != NULL)
+    {
+      // The payload of the pbuf is parsed where lwIP received it.
+      struct pbuf* const head = connection->received;
+      data = az_span_create(
+          (uint8_t*)head->payload + connection->received_offset,
+          head->len - connection->received_offset);
+      if (az_span_size(data) == 0)
+      {
+        _az_http_lwip_consume(connection, 0);
+        continue;
+      }
+    }
+    else if (connection->is_closed)
+    {
+      if (connection->error != ERR_OK)
+      {
+        return AZ_ERROR_HTTP_ADAPTER;
+      }
+
+      is_end_of_stream = true;
+    }
+
+    if (az_span_size(data) > 0)
+    {
+      int32_t consumed = 0;
+      _az_RETURN_IF_FAILED(_az_http_lwip_parser_parse(ref_parser, data, ref_response, &consumed));
+      if (consumed < az_span_size(data))
+      {
+        // Bytes past the end of the response leave the connection in an unknown state.
+        ref_parser->is_close = true;
+      }
+
+      if (!connection->is_tls)
+      {
+        _az_http_lwip_consume(connection, (uint16_t)az_span_size(data));
+      }
+      deadline = _az_http_lwip_deadline();
+    }
+    else if (!is_end_of_stream)
+    {
+      _az_RETURN_IF_FAILED(_az_http_lwip_wait(request, deadline));
+    }
+  }
+
+  if (ref_parser->state == _az_HTTP_LWIP_PARSE_BODY_UNTIL_CLOSE)
+  {
+    return AZ_OK;
+  }
+
+  // The server closed the connection before the end of the response.
+  return ref_parser->state == _az_HTTP_LWIP_PARSE_DONE ? AZ_OK : AZ_ERROR_HTTP_ADAPTER;
+}
+
+AZ_NODISCARD az_result az_http_client_lwip_init(az_http_client_lwip_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(options);
+  _az_PRECONDITION_NOT_NULL(options->poll);
+  _az_PRECONDITION(options->timeout_msec > 0);
+
+  az_http_client_lwip_cleanup();
+
+  _az_http_lwip_options = *options;
+  _az_http_lwip_connection_state = (_az_http_lwip_connection){ 0 };
+
+  if (options->tls_config != NULL)
+  {
+    mbedtls_ssl_init(&_az_http_lwip_tls);
+    int const ret = mbedtls_ssl_setup(&_az_http_lwip_tls, options->tls_config);
+    if (ret != 0)
+    {
+      mbedtls_ssl_free(&_az_http_lwip_tls);
+      return ret == MBEDTLS_ERR_SSL_ALLOC_FAILED ? AZ_ERROR_OUT_OF_MEMORY : AZ_ERROR_HTTP_ADAPTER;
+    }
+
+    mbedtls_ssl_set_bio(
+        &_az_http_lwip_tls,
+        &_az_http_lwip_connection_state,
+        _az_http_lwip_tls_send,
+        _az_http_lwip_tls_receive,
+        NULL);
+  }
+
+  _az_http_lwip_is_initialized = true;
+  return AZ_OK;
+}
+
+void az_http_client_lwip_cleanup()
+{
+  if (!_az_http_lwip_is_initialized)
+  {
+    return;
+  }
+
+  _az_http_lwip_close();
+  if (_az_http_lwip_options.tls_config != NULL)
+  {
+    mbedtls_ssl_free(&_az_http_lwip_tls);
+  }
+
+  _az_http_lwip_is_initialized = false;
+}
+
+/**
+ * @brief sends \p request over lwIP, with mbedTLS for `https`, and writes the response into \p
+ * ref_response.
+ *
+ * @param request an internal http builder with data to build and send http request
+ * @param ref_response pre-allocated buffer where http response will be written
+ * @return az_result
+ */
+AZ_NODISCARD az_result
+az_http_client_send_request(az_http_request const* request, az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  if (!_az_http_lwip_is_initialized)
+  {
+    return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+  }
+
+  az_span url = AZ_SPAN_EMPTY;
+  az_http_method method = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_http_request_get_url(request, &url));
+  _az_RETURN_IF_FAILED(az_http_request_get_method(request, &method));
+
+  bool is_tls = false;
+  az_span authority = AZ_SPAN_EMPTY;
+  az_span host = AZ_SPAN_EMPTY;
+  uint16_t port = 0;
+  az_span path = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_http_lwip_parse_url(url, &is_tls, &authority, &host, &port, &path));
+
+  _az_http_lwip_parser parser;
+  _az_http_lwip_parser_init(&parser, az_span_is_content_equal(method, az_http_method_head()));
+
+  az_result result = _az_http_lwip_connect(request, is_tls, host, port);
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_lwip_send(request, method, authority, path);
+  }
+
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_lwip_receive(request, &parser, ref_response);
+  }
+
+  if (az_result_succeeded(result) && _az_http_lwip_is_reuse_enabled && !parser.is_close
+      && !_az_http_lwip_connection_state.is_closed)
+  {
+    // The connection is kept alive for the next request to the same host.
+    _az_http_lwip_connection_state.is_reusable = true;
+  }
+  else
+  {
+    _az_http_lwip_close();
+  }
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_http_client_connection_reuse_init()
+{
+  _az_http_lwip_is_reuse_enabled = true;
+  return AZ_OK;
+}
+
+void az_http_client_connection_reuse_cleanup()
+{
+  _az_http_lwip_is_reuse_enabled = false;
+  _az_http_lwip_close();
+}
+
+// A TLS session is only resumed by the connection kept alive, which needs no ticket.
+AZ_NODISCARD az_result
+az_http_client_tls_sessions_export(az_span destination, az_span* out_sessions)
+{
+  (void)destination;
+  (void)out_sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_tls_sessions_import(az_span sessions)
+{
+  (void)sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+// The adapter has a single connection, which requests take turns on, so it can't send requests
+// asynchronously.
+AZ_NODISCARD az_result az_http_client_async_init(
+    az_http_client_async* out_client,
+    az_http_client_async_options const* options)
+{
+  (void)out_client;
+  (void)options;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_submit(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* out_operation,
+    az_http_request const* request,
+    az_http_response* ref_response)
+{
+  (void)ref_client;
+  (void)out_operation;
+  (void)request;
+  (void)ref_response;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_poll(
+    az_http_client_async* ref_client,
+    int32_t timeout_msec,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)timeout_msec;
+  (void)out_pending_count;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_socket_action(
+    az_http_client_async* ref_client,
+    intptr_t socket,
+    az_http_client_async_socket_events events,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)socket;
+  (void)events;
+  (void)out_pending_count;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_timer_expired(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)out_pending_count;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+void az_http_client_async_cancel(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* ref_operation)
+{
+  (void)ref_client;
+  (void)ref_operation;
+}
+
+void az_http_client_async_cleanup(az_http_client_async* ref_client) { (void)ref_client; }
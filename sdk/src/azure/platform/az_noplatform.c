@@ -7,4 +7,59 @@
 
 AZ_NODISCARD int64_t az_platform_clock_msec() { return 0; }
 
+AZ_NODISCARD int64_t az_platform_clock_nsec() { return 0; }
+
 void az_platform_sleep_msec(int32_t milliseconds) { (void)milliseconds; }
+
+AZ_NODISCARD az_result az_platform_wait_msec(az_context const* context, int32_t milliseconds)
+{
+  (void)milliseconds;
+
+  // There is no clock to wait on. A canceled context is set to expire at 0, the time it always is.
+  return context != NULL && az_context_get_expiration(context) <= 0 ? AZ_ERROR_CANCELED : AZ_OK;
+}
+
+void az_platform_wake_waiters() {}
+
+AZ_NODISCARD az_result az_platform_executor_submit(az_platform_work* ref_work)
+{
+  // Without threads, the work is run by the thread which submits it.
+  ref_work->_internal.work_fn(ref_work->_internal.user_context);
+  return AZ_OK;
+}
+
+void az_platform_executor_wait(az_platform_work* ref_work) { (void)ref_work; }
+
+void az_platform_executor_shutdown() {}
+
+AZ_NODISCARD az_result az_platform_file_map(az_platform_file_mapping* out_mapping, char const* path)
+{
+  (void)out_mapping;
+  (void)path;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result
+az_platform_file_map_handle(az_platform_file_mapping* out_mapping, intptr_t file)
+{
+  (void)out_mapping;
+  (void)file;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+void az_platform_file_unmap(az_platform_file_mapping* ref_mapping) { (void)ref_mapping; }
+
+AZ_NODISCARD az_result az_platform_file_write_at(intptr_t file, int64_t offset, az_span content)
+{
+  (void)file;
+  (void)offset;
+  (void)content;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_platform_file_allocate(intptr_t file, int64_t size)
+{
+  (void)file;
+  (void)size;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
@@ -1,21 +1,502 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
-#include <azure/core/internal/az_config_internal.h>
 #include <azure/core/az_platform.h>
+#include <azure/core/internal/az_config_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <time.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <azure/core/_az_cfg.h>
 
+// The waits in az_platform_wait_msec() sleep on one condition variable, which
+// az_platform_wake_waiters() broadcasts to. It measures time with CLOCK_MONOTONIC, so that the
+// waits aren't affected by changes to the system time.
+static pthread_mutex_t _az_posix_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _az_posix_wait_condition;
+static pthread_once_t _az_posix_wait_once = PTHREAD_ONCE_INIT;
+
+static void _az_posix_wait_init(void)
+{
+  pthread_condattr_t attributes;
+  (void)pthread_condattr_init(&attributes);
+  (void)pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+  (void)pthread_cond_init(&_az_posix_wait_condition, &attributes);
+  (void)pthread_condattr_destroy(&attributes);
+}
+
 AZ_NODISCARD int64_t az_platform_clock_msec()
 {
-  return (int64_t)((clock() / CLOCKS_PER_SEC) * _az_TIME_MILLISECONDS_PER_SECOND);
+  return az_platform_clock_nsec() / _az_TIME_NANOSECONDS_PER_MILLISECOND;
+}
+
+AZ_NODISCARD int64_t az_platform_clock_nsec()
+{
+  struct timespec now = { 0 };
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * _az_TIME_NANOSECONDS_PER_SECOND + (int64_t)now.tv_nsec;
 }
 
 void az_platform_sleep_msec(int32_t milliseconds)
 {
   (void)usleep((useconds_t)milliseconds * _az_TIME_MICROSECONDS_PER_MILLISECOND);
 }
+
+AZ_NODISCARD az_result az_platform_wait_msec(az_context const* context, int32_t milliseconds)
+{
+  if (context == NULL)
+  {
+    if (milliseconds > 0)
+    {
+      az_platform_sleep_msec(milliseconds);
+    }
+    return AZ_OK;
+  }
+
+  (void)pthread_once(&_az_posix_wait_once, _az_posix_wait_init);
+
+  int64_t const deadline
+      = az_platform_clock_nsec() + (int64_t)milliseconds * _az_TIME_NANOSECONDS_PER_MILLISECOND;
+
+  az_result result = AZ_OK;
+  (void)pthread_mutex_lock(&_az_posix_wait_mutex);
+  while (true)
+  {
+    // The context is checked with the mutex held, so a cancellation which happens after the check
+    // can't be missed: az_platform_wake_waiters() only broadcasts once this thread is waiting.
+    int64_t const now_msec = az_platform_clock_msec();
+    int64_t const expiration = az_context_get_expiration(context);
+    if (expiration < now_msec)
+    {
+      result = AZ_ERROR_CANCELED;
+      break;
+    }
+
+    int64_t const now = az_platform_clock_nsec();
+    if (now >= deadline)
+    {
+      break;
+    }
+
+    // Wake up when the context expires, if that is sooner than the end of the wait.
+    int64_t wake_time = deadline;
+    if (expiration - now_msec < (deadline - now) / _az_TIME_NANOSECONDS_PER_MILLISECOND)
+    {
+      wake_time = now + (expiration - now_msec + 1) * _az_TIME_NANOSECONDS_PER_MILLISECOND;
+    }
+
+    struct timespec const wake_timespec = {
+      .tv_sec = (time_t)(wake_time / _az_TIME_NANOSECONDS_PER_SECOND),
+      .tv_nsec = (long)(wake_time % _az_TIME_NANOSECONDS_PER_SECOND),
+    };
+    (void)pthread_cond_timedwait(&_az_posix_wait_condition, &_az_posix_wait_mutex, &wake_timespec);
+  }
+  (void)pthread_mutex_unlock(&_az_posix_wait_mutex);
+
+  return result;
+}
+
+void az_platform_wake_waiters()
+{
+  (void)pthread_once(&_az_posix_wait_once, _az_posix_wait_init);
+
+  (void)pthread_mutex_lock(&_az_posix_wait_mutex);
+  (void)pthread_cond_broadcast(&_az_posix_wait_condition);
+  (void)pthread_mutex_unlock(&_az_posix_wait_mutex);
+}
+
+enum
+{
+  _az_POSIX_EXECUTOR_MAX_THREADS = 16,
+};
+
+// The states of an az_platform_work. It is idle once it has run, as before it was submitted.
+enum
+{
+  _az_POSIX_WORK_IDLE = 0,
+  _az_POSIX_WORK_QUEUED = 1,
+  _az_POSIX_WORK_RUNNING = 2,
+};
+
+typedef struct
+{
+  az_platform_work* head;
+  az_platform_work* tail;
+} _az_posix_work_queue;
+
+// Each thread has its own queue, but one mutex protects all of them: the work is expected to be
+// coarse, such as a block upload, so the lock isn't contended and stealing needs no other locking.
+static struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t work_available;
+  pthread_cond_t work_done;
+  pthread_t threads[_az_POSIX_EXECUTOR_MAX_THREADS];
+  _az_posix_work_queue queues[_az_POSIX_EXECUTOR_MAX_THREADS];
+  int32_t thread_count;
+  int32_t next_queue;
+  bool stopping;
+} _az_posix_executor = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .work_available = PTHREAD_COND_INITIALIZER,
+  .work_done = PTHREAD_COND_INITIALIZER,
+};
+
+static void _az_posix_work_queue_push(_az_posix_work_queue* queue, az_platform_work* work)
+{
+  work->_internal.next = NULL;
+  if (queue->tail == NULL)
+  {
+    queue->head = work;
+  }
+  else
+  {
+    queue->tail->_internal.next = work;
+  }
+  queue->tail = work;
+}
+
+static AZ_NODISCARD bool
+_az_posix_work_queue_remove(_az_posix_work_queue* queue, az_platform_work const* work)
+{
+  az_platform_work* previous = NULL;
+  for (az_platform_work* current = queue->head; current != NULL;
+       previous = current, current = current->_internal.next)
+  {
+    if (current == work)
+    {
+      if (previous == NULL)
+      {
+        queue->head = current->_internal.next;
+      }
+      else
+      {
+        previous->_internal.next = current->_internal.next;
+      }
+
+      if (queue->tail == current)
+      {
+        queue->tail = previous;
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Takes the oldest work of the queue of thread `index`, or else of the next queue which has some.
+static AZ_NODISCARD az_platform_work* _az_posix_executor_take(int32_t index)
+{
+  int32_t const count = _az_posix_executor.thread_count;
+  for (int32_t i = 0; i < count; i++)
+  {
+    _az_posix_work_queue* const queue = &_az_posix_executor.queues[(index + i) % count];
+    az_platform_work* const work = queue->head;
+    if (work != NULL)
+    {
+      queue->head = work->_internal.next;
+      if (queue->head == NULL)
+      {
+        queue->tail = NULL;
+      }
+
+      return work;
+    }
+  }
+
+  return NULL;
+}
+
+// Runs `work` with the mutex released. The mutex must be held when it is called.
+static void _az_posix_executor_run(az_platform_work* work)
+{
+  work->_internal.state = _az_POSIX_WORK_RUNNING;
+  (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+
+  work->_internal.work_fn(work->_internal.user_context);
+
+  (void)pthread_mutex_lock(&_az_posix_executor.mutex);
+  work->_internal.state = _az_POSIX_WORK_IDLE;
+  (void)pthread_cond_broadcast(&_az_posix_executor.work_done);
+}
+
+static void* _az_posix_executor_thread(void* argument)
+{
+  int32_t const index = (int32_t)(intptr_t)argument;
+
+  (void)pthread_mutex_lock(&_az_posix_executor.mutex);
+  while (true)
+  {
+    az_platform_work* const work = _az_posix_executor_take(index);
+    if (work != NULL)
+    {
+      _az_posix_executor_run(work);
+    }
+    else if (_az_posix_executor.stopping)
+    {
+      break;
+    }
+    else
+    {
+      (void)pthread_cond_wait(&_az_posix_executor.work_available, &_az_posix_executor.mutex);
+    }
+  }
+  (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+
+  return NULL;
+}
+
+// Returns the index of the executor thread which is calling, or -1.
+static AZ_NODISCARD int32_t _az_posix_executor_current_thread()
+{
+  pthread_t const self = pthread_self();
+  for (int32_t i = 0; i < _az_posix_executor.thread_count; i++)
+  {
+    if (pthread_equal(self, _az_posix_executor.threads[i]))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static void _az_posix_executor_start()
+{
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  if (processors < 1)
+  {
+    processors = 1;
+  }
+  else if (processors > _az_POSIX_EXECUTOR_MAX_THREADS)
+  {
+    processors = _az_POSIX_EXECUTOR_MAX_THREADS;
+  }
+
+  int32_t count = 0;
+  while (count < (int32_t)processors
+         && pthread_create(
+                &_az_posix_executor.threads[count],
+                NULL,
+                _az_posix_executor_thread,
+                (void*)(intptr_t)count)
+             == 0)
+  {
+    count++;
+  }
+
+  _az_posix_executor.thread_count = count;
+  _az_posix_executor.next_queue = 0;
+}
+
+AZ_NODISCARD az_result az_platform_executor_submit(az_platform_work* ref_work)
+{
+  _az_PRECONDITION_NOT_NULL(ref_work);
+  _az_PRECONDITION_NOT_NULL(ref_work->_internal.work_fn);
+  _az_PRECONDITION(ref_work->_internal.state == _az_POSIX_WORK_IDLE);
+
+  (void)pthread_mutex_lock(&_az_posix_executor.mutex);
+
+  if (_az_posix_executor.thread_count == 0 && !_az_posix_executor.stopping)
+  {
+    _az_posix_executor_start();
+  }
+
+  if (_az_posix_executor.thread_count == 0 || _az_posix_executor.stopping)
+  {
+    // No thread could be started, or they are stopping: run the work now, as without threads.
+    _az_posix_executor_run(ref_work);
+  }
+  else
+  {
+    // Work submitted from an executor thread goes to its own queue, the rest is spread out.
+    int32_t index = _az_posix_executor_current_thread();
+    if (index < 0)
+    {
+      index = _az_posix_executor.next_queue;
+      _az_posix_executor.next_queue = (index + 1) % _az_posix_executor.thread_count;
+    }
+
+    ref_work->_internal.state = _az_POSIX_WORK_QUEUED;
+    _az_posix_work_queue_push(&_az_posix_executor.queues[index], ref_work);
+    (void)pthread_cond_signal(&_az_posix_executor.work_available);
+  }
+
+  (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+  return AZ_OK;
+}
+
+void az_platform_executor_wait(az_platform_work* ref_work)
+{
+  _az_PRECONDITION_NOT_NULL(ref_work);
+
+  (void)pthread_mutex_lock(&_az_posix_executor.mutex);
+
+  if (ref_work->_internal.state == _az_POSIX_WORK_QUEUED)
+  {
+    // Nothing has started it yet, so this thread runs it rather than waiting for one that will.
+    for (int32_t i = 0; i < _az_posix_executor.thread_count; i++)
+    {
+      if (_az_posix_work_queue_remove(&_az_posix_executor.queues[i], ref_work))
+      {
+        break;
+      }
+    }
+    _az_posix_executor_run(ref_work);
+  }
+
+  while (ref_work->_internal.state == _az_POSIX_WORK_RUNNING)
+  {
+    (void)pthread_cond_wait(&_az_posix_executor.work_done, &_az_posix_executor.mutex);
+  }
+
+  (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+}
+
+void az_platform_executor_shutdown()
+{
+  (void)pthread_mutex_lock(&_az_posix_executor.mutex);
+  int32_t const count = _az_posix_executor.thread_count;
+  if (count == 0 || _az_posix_executor.stopping)
+  {
+    (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+    return;
+  }
+
+  // The threads run what is left in the queues before they stop.
+  _az_posix_executor.stopping = true;
+  (void)pthread_cond_broadcast(&_az_posix_executor.work_available);
+  (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+
+  for (int32_t i = 0; i < count; i++)
+  {
+    (void)pthread_join(_az_posix_executor.threads[i], NULL);
+  }
+
+  (void)pthread_mutex_lock(&_az_posix_executor.mutex);
+  _az_posix_executor.thread_count = 0;
+  _az_posix_executor.stopping = false;
+  (void)pthread_mutex_unlock(&_az_posix_executor.mutex);
+}
+
+AZ_NODISCARD az_result az_platform_file_map(az_platform_file_mapping* out_mapping, char const* path)
+{
+  _az_PRECONDITION_NOT_NULL(out_mapping);
+  _az_PRECONDITION_NOT_NULL(path);
+
+  int const file = open(path, O_RDONLY);
+  if (file < 0)
+  {
+    return errno == ENOENT ? AZ_ERROR_ITEM_NOT_FOUND : AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  // The mapping keeps the file referenced, so it can be closed right away.
+  az_result const result = az_platform_file_map_handle(out_mapping, file);
+  (void)close(file);
+  return result;
+}
+
+AZ_NODISCARD az_result
+az_platform_file_map_handle(az_platform_file_mapping* out_mapping, intptr_t file)
+{
+  _az_PRECONDITION_NOT_NULL(out_mapping);
+
+  *out_mapping = (az_platform_file_mapping){ ._internal = { .content = NULL, .size = 0 } };
+
+  struct stat status;
+  if (fstat((int)file, &status) != 0 || !S_ISREG(status.st_mode)
+      || (uint64_t)status.st_size > SIZE_MAX)
+  {
+    return AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  if (status.st_size == 0)
+  {
+    // An empty file has nothing to map.
+    return AZ_OK;
+  }
+
+  void* const content = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, (int)file, 0);
+  if (content == MAP_FAILED)
+  {
+    return AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  // Uploads read the file once, in order, so have the kernel read ahead of them.
+  (void)posix_madvise(content, (size_t)status.st_size, POSIX_MADV_SEQUENTIAL);
+
+  out_mapping->_internal.content = (uint8_t*)content;
+  out_mapping->_internal.size = (int64_t)status.st_size;
+  return AZ_OK;
+}
+
+void az_platform_file_unmap(az_platform_file_mapping* ref_mapping)
+{
+  _az_PRECONDITION_NOT_NULL(ref_mapping);
+
+  if (ref_mapping->_internal.content != NULL)
+  {
+    (void)munmap(ref_mapping->_internal.content, (size_t)ref_mapping->_internal.size);
+  }
+
+  *ref_mapping = (az_platform_file_mapping){ ._internal = { .content = NULL, .size = 0 } };
+}
+
+AZ_NODISCARD az_result az_platform_file_write_at(intptr_t file, int64_t offset, az_span content)
+{
+  _az_PRECONDITION(offset >= 0);
+
+  uint8_t const* remaining = az_span_ptr(content);
+  size_t remaining_size = (size_t)az_span_size(content);
+  while (remaining_size > 0)
+  {
+    ssize_t const written = pwrite((int)file, remaining, remaining_size, (off_t)offset);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      return AZ_ERROR_PLATFORM_FILE_IO;
+    }
+
+    remaining += written;
+    remaining_size -= (size_t)written;
+    offset += written;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_platform_file_allocate(intptr_t file, int64_t size)
+{
+  _az_PRECONDITION(size >= 0);
+
+#if defined(__APPLE__)
+  // There is no posix_fallocate(), so the file is only extended, as a sparse file.
+  struct stat status;
+  if (fstat((int)file, &status) != 0)
+  {
+    return AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  return status.st_size >= size || ftruncate((int)file, (off_t)size) == 0
+      ? AZ_OK
+      : AZ_ERROR_PLATFORM_FILE_IO;
+#else
+  // Returns the error rather than setting errno.
+  return size == 0 || posix_fallocate((int)file, 0, (off_t)size) == 0 ? AZ_OK
+                                                                      : AZ_ERROR_PLATFORM_FILE_IO;
+#endif
+}
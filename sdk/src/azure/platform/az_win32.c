@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: MIT
 
 #include <azure/core/az_platform.h>
+#include <azure/core/internal/az_config_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
 
 // Two macros below are not used in the code below, it is windows.h that consumes them.
 #define WIN32_LEAN_AND_MEAN
@@ -10,6 +12,482 @@
 
 #include <azure/core/_az_cfg.h>
 
+// The waits in az_platform_wait_msec() sleep on one condition variable, which
+// az_platform_wake_waiters() wakes. Both are statically initialized, so there is no setup.
+static SRWLOCK _az_win32_wait_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE _az_win32_wait_condition = CONDITION_VARIABLE_INIT;
+
 AZ_NODISCARD int64_t az_platform_clock_msec() { return GetTickCount64(); }
 
+AZ_NODISCARD int64_t az_platform_clock_nsec()
+{
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  (void)QueryPerformanceFrequency(&frequency);
+  (void)QueryPerformanceCounter(&counter);
+
+  // Split the conversion so that it doesn't overflow for large counter values.
+  int64_t const seconds = counter.QuadPart / frequency.QuadPart;
+  int64_t const remainder = counter.QuadPart % frequency.QuadPart;
+  return seconds * _az_TIME_NANOSECONDS_PER_SECOND
+      + remainder * _az_TIME_NANOSECONDS_PER_SECOND / frequency.QuadPart;
+}
+
 void az_platform_sleep_msec(int32_t milliseconds) { Sleep(milliseconds); }
+
+AZ_NODISCARD az_result az_platform_wait_msec(az_context const* context, int32_t milliseconds)
+{
+  if (context == NULL)
+  {
+    if (milliseconds > 0)
+    {
+      Sleep(milliseconds);
+    }
+    return AZ_OK;
+  }
+
+  int64_t const deadline = az_platform_clock_msec() + milliseconds;
+
+  az_result result = AZ_OK;
+  AcquireSRWLockExclusive(&_az_win32_wait_lock);
+  while (true)
+  {
+    // The context is checked with the lock held, so a cancellation which happens after the check
+    // can't be missed: az_platform_wake_waiters() only wakes once this thread is waiting.
+    int64_t const now = az_platform_clock_msec();
+    int64_t const expiration = az_context_get_expiration(context);
+    if (expiration < now)
+    {
+      result = AZ_ERROR_CANCELED;
+      break;
+    }
+
+    if (now >= deadline)
+    {
+      break;
+    }
+
+    // Wake up when the context expires, if that is sooner than the end of the wait.
+    int64_t const wake_time = expiration < deadline ? expiration + 1 : deadline;
+    (void)SleepConditionVariableSRW(
+        &_az_win32_wait_condition, &_az_win32_wait_lock, (DWORD)(wake_time - now), 0);
+  }
+  ReleaseSRWLockExclusive(&_az_win32_wait_lock);
+
+  return result;
+}
+
+void az_platform_wake_waiters()
+{
+  AcquireSRWLockExclusive(&_az_win32_wait_lock);
+  WakeAllConditionVariable(&_az_win32_wait_condition);
+  ReleaseSRWLockExclusive(&_az_win32_wait_lock);
+}
+
+enum
+{
+  _az_WIN32_EXECUTOR_MAX_THREADS = 16,
+};
+
+// The states of an az_platform_work. It is idle once it has run, as before it was submitted.
+enum
+{
+  _az_WIN32_WORK_IDLE = 0,
+  _az_WIN32_WORK_QUEUED = 1,
+  _az_WIN32_WORK_RUNNING = 2,
+};
+
+typedef struct
+{
+  az_platform_work* head;
+  az_platform_work* tail;
+} _az_win32_work_queue;
+
+// Each thread has its own queue, but one lock protects all of them: the work is expected to be
+// coarse, such as a block upload, so the lock isn't contended and stealing needs no other locking.
+static struct
+{
+  SRWLOCK lock;
+  CONDITION_VARIABLE work_available;
+  CONDITION_VARIABLE work_done;
+  HANDLE threads[_az_WIN32_EXECUTOR_MAX_THREADS];
+  DWORD thread_ids[_az_WIN32_EXECUTOR_MAX_THREADS];
+  _az_win32_work_queue queues[_az_WIN32_EXECUTOR_MAX_THREADS];
+  int32_t thread_count;
+  int32_t next_queue;
+  bool stopping;
+} _az_win32_executor = {
+  .lock = SRWLOCK_INIT,
+  .work_available = CONDITION_VARIABLE_INIT,
+  .work_done = CONDITION_VARIABLE_INIT,
+};
+
+static void _az_win32_work_queue_push(_az_win32_work_queue* queue, az_platform_work* work)
+{
+  work->_internal.next = NULL;
+  if (queue->tail == NULL)
+  {
+    queue->head = work;
+  }
+  else
+  {
+    queue->tail->_internal.next = work;
+  }
+  queue->tail = work;
+}
+
+static AZ_NODISCARD bool
+_az_win32_work_queue_remove(_az_win32_work_queue* queue, az_platform_work const* work)
+{
+  az_platform_work* previous = NULL;
+  for (az_platform_work* current = queue->head; current != NULL;
+       previous = current, current = current->_internal.next)
+  {
+    if (current == work)
+    {
+      if (previous == NULL)
+      {
+        queue->head = current->_internal.next;
+      }
+      else
+      {
+        previous->_internal.next = current->_internal.next;
+      }
+
+      if (queue->tail == current)
+      {
+        queue->tail = previous;
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Takes the oldest work of the queue of thread `index`, or else of the next queue which has some.
+static AZ_NODISCARD az_platform_work* _az_win32_executor_take(int32_t index)
+{
+  int32_t const count = _az_win32_executor.thread_count;
+  for (int32_t i = 0; i < count; i++)
+  {
+    _az_win32_work_queue* const queue = &_az_win32_executor.queues[(index + i) % count];
+    az_platform_work* const work = queue->head;
+    if (work != NULL)
+    {
+      queue->head = work->_internal.next;
+      if (queue->head == NULL)
+      {
+        queue->tail = NULL;
+      }
+
+      return work;
+    }
+  }
+
+  return NULL;
+}
+
+// Runs `work` with the lock released. The lock must be held when it is called.
+static void _az_win32_executor_run(az_platform_work* work)
+{
+  work->_internal.state = _az_WIN32_WORK_RUNNING;
+  ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+
+  work->_internal.work_fn(work->_internal.user_context);
+
+  AcquireSRWLockExclusive(&_az_win32_executor.lock);
+  work->_internal.state = _az_WIN32_WORK_IDLE;
+  WakeAllConditionVariable(&_az_win32_executor.work_done);
+}
+
+static DWORD WINAPI _az_win32_executor_thread(LPVOID argument)
+{
+  int32_t const index = (int32_t)(intptr_t)argument;
+
+  AcquireSRWLockExclusive(&_az_win32_executor.lock);
+  while (true)
+  {
+    az_platform_work* const work = _az_win32_executor_take(index);
+    if (work != NULL)
+    {
+      _az_win32_executor_run(work);
+    }
+    else if (_az_win32_executor.stopping)
+    {
+      break;
+    }
+    else
+    {
+      (void)SleepConditionVariableSRW(
+          &_az_win32_executor.work_available, &_az_win32_executor.lock, INFINITE, 0);
+    }
+  }
+  ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+
+  return 0;
+}
+
+// Returns the index of the executor thread which is calling, or -1.
+static AZ_NODISCARD int32_t _az_win32_executor_current_thread()
+{
+  DWORD const self = GetCurrentThreadId();
+  for (int32_t i = 0; i < _az_win32_executor.thread_count; i++)
+  {
+    if (_az_win32_executor.thread_ids[i] == self)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static void _az_win32_executor_start()
+{
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+
+  int32_t processors = (int32_t)system_info.dwNumberOfProcessors;
+  if (processors < 1)
+  {
+    processors = 1;
+  }
+  else if (processors > _az_WIN32_EXECUTOR_MAX_THREADS)
+  {
+    processors = _az_WIN32_EXECUTOR_MAX_THREADS;
+  }
+
+  int32_t count = 0;
+  while (count < processors)
+  {
+    HANDLE const thread = CreateThread(
+        NULL,
+        0,
+        _az_win32_executor_thread,
+        (LPVOID)(intptr_t)count,
+        0,
+        &_az_win32_executor.thread_ids[count]);
+    if (thread == NULL)
+    {
+      break;
+    }
+
+    _az_win32_executor.threads[count] = thread;
+    count++;
+  }
+
+  _az_win32_executor.thread_count = count;
+  _az_win32_executor.next_queue = 0;
+}
+
+AZ_NODISCARD az_result az_platform_executor_submit(az_platform_work* ref_work)
+{
+  _az_PRECONDITION_NOT_NULL(ref_work);
+  _az_PRECONDITION_NOT_NULL(ref_work->_internal.work_fn);
+  _az_PRECONDITION(ref_work->_internal.state == _az_WIN32_WORK_IDLE);
+
+  AcquireSRWLockExclusive(&_az_win32_executor.lock);
+
+  if (_az_win32_executor.thread_count == 0 && !_az_win32_executor.stopping)
+  {
+    _az_win32_executor_start();
+  }
+
+  if (_az_win32_executor.thread_count == 0 || _az_win32_executor.stopping)
+  {
+    // No thread could be started, or they are stopping: run the work now, as without threads.
+    _az_win32_executor_run(ref_work);
+  }
+  else
+  {
+    // Work submitted from an executor thread goes to its own queue, the rest is spread out.
+    int32_t index = _az_win32_executor_current_thread();
+    if (index < 0)
+    {
+      index = _az_win32_executor.next_queue;
+      _az_win32_executor.next_queue = (index + 1) % _az_win32_executor.thread_count;
+    }
+
+    ref_work->_internal.state = _az_WIN32_WORK_QUEUED;
+    _az_win32_work_queue_push(&_az_win32_executor.queues[index], ref_work);
+    WakeConditionVariable(&_az_win32_executor.work_available);
+  }
+
+  ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+  return AZ_OK;
+}
+
+void az_platform_executor_wait(az_platform_work* ref_work)
+{
+  _az_PRECONDITION_NOT_NULL(ref_work);
+
+  AcquireSRWLockExclusive(&_az_win32_executor.lock);
+
+  if (ref_work->_internal.state == _az_WIN32_WORK_QUEUED)
+  {
+    // Nothing has started it yet, so this thread runs it rather than waiting for one that will.
+    for (int32_t i = 0; i < _az_win32_executor.thread_count; i++)
+    {
+      if (_az_win32_work_queue_remove(&_az_win32_executor.queues[i], ref_work))
+      {
+        break;
+      }
+    }
+    _az_win32_executor_run(ref_work);
+  }
+
+  while (ref_work->_internal.state == _az_WIN32_WORK_RUNNING)
+  {
+    (void)SleepConditionVariableSRW(
+        &_az_win32_executor.work_done, &_az_win32_executor.lock, INFINITE, 0);
+  }
+
+  ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+}
+
+void az_platform_executor_shutdown()
+{
+  AcquireSRWLockExclusive(&_az_win32_executor.lock);
+  int32_t const count = _az_win32_executor.thread_count;
+  if (count == 0 || _az_win32_executor.stopping)
+  {
+    ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+    return;
+  }
+
+  // The threads run what is left in the queues before they stop.
+  _az_win32_executor.stopping = true;
+  WakeAllConditionVariable(&_az_win32_executor.work_available);
+  ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+
+  for (int32_t i = 0; i < count; i++)
+  {
+    (void)WaitForSingleObject(_az_win32_executor.threads[i], INFINITE);
+    (void)CloseHandle(_az_win32_executor.threads[i]);
+  }
+
+  AcquireSRWLockExclusive(&_az_win32_executor.lock);
+  _az_win32_executor.thread_count = 0;
+  _az_win32_executor.stopping = false;
+  ReleaseSRWLockExclusive(&_az_win32_executor.lock);
+}
+
+AZ_NODISCARD az_result az_platform_file_map(az_platform_file_mapping* out_mapping, char const* path)
+{
+  _az_PRECONDITION_NOT_NULL(out_mapping);
+  _az_PRECONDITION_NOT_NULL(path);
+
+  HANDLE const file = CreateFileA(
+      path,
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      NULL,
+      OPEN_EXISTING,
+      FILE_FLAG_SEQUENTIAL_SCAN,
+      NULL);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    DWORD const error = GetLastError();
+    return error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND
+        ? AZ_ERROR_ITEM_NOT_FOUND
+        : AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  // The view keeps the file referenced, so it can be closed right away.
+  az_result const result = az_platform_file_map_handle(out_mapping, (intptr_t)file);
+  (void)CloseHandle(file);
+  return result;
+}
+
+AZ_NODISCARD az_result
+az_platform_file_map_handle(az_platform_file_mapping* out_mapping, intptr_t file)
+{
+  _az_PRECONDITION_NOT_NULL(out_mapping);
+
+  *out_mapping = (az_platform_file_mapping){ ._internal = { .content = NULL, .size = 0 } };
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx((HANDLE)file, &size) || (uint64_t)size.QuadPart > SIZE_MAX)
+  {
+    return AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  if (size.QuadPart == 0)
+  {
+    // Empty files can't be mapped, and have nothing to map.
+    return AZ_OK;
+  }
+
+  HANDLE const mapping = CreateFileMappingA((HANDLE)file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL)
+  {
+    return AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  // The view keeps the mapping object referenced too.
+  void* const content = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  (void)CloseHandle(mapping);
+  if (content == NULL)
+  {
+    return AZ_ERROR_PLATFORM_FILE_IO;
+  }
+
+  out_mapping->_internal.content = (uint8_t*)content;
+  out_mapping->_internal.size = size.QuadPart;
+  return AZ_OK;
+}
+
+void az_platform_file_unmap(az_platform_file_mapping* ref_mapping)
+{
+  _az_PRECONDITION_NOT_NULL(ref_mapping);
+
+  if (ref_mapping->_internal.content != NULL)
+  {
+    (void)UnmapViewOfFile(ref_mapping->_internal.content);
+  }
+
+  *ref_mapping = (az_platform_file_mapping){ ._internal = { .content = NULL, .size = 0 } };
+}
+
+AZ_NODISCARD az_result az_platform_file_write_at(intptr_t file, int64_t offset, az_span content)
+{
+  _az_PRECONDITION(offset >= 0);
+
+  uint8_t const* remaining = az_span_ptr(content);
+  int32_t remaining_size = az_span_size(content);
+  while (remaining_size > 0)
+  {
+    // On a handle opened for synchronous I/O, the offset of the OVERLAPPED is where the write
+    // starts, and the write completes before WriteFile() returns.
+    OVERLAPPED overlapped = { 0 };
+    overlapped.Offset = (DWORD)((uint64_t)offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+
+    DWORD written = 0;
+    if (!WriteFile((HANDLE)file, remaining, (DWORD)remaining_size, &written, &overlapped)
+        || written == 0)
+    {
+      return AZ_ERROR_PLATFORM_FILE_IO;
+    }
+
+    remaining += written;
+    remaining_size -= (int32_t)written;
+    offset += written;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_platform_file_allocate(intptr_t file, int64_t size)
+{
+  _az_PRECONDITION(size >= 0);
+
+  FILE_ALLOCATION_INFO allocation = { 0 };
+  allocation.AllocationSize.QuadPart = size;
+  return SetFileInformationByHandle(
+             (HANDLE)file, FileAllocationInfo, &allocation, (DWORD)sizeof(allocation))
+      ? AZ_OK
+      : AZ_ERROR_PLATFORM_FILE_IO;
+}
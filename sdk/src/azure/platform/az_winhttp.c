@@ -0,0 +1,1246 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Two macros below are not used in the code below, it is windows.h that consumes them.
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include <winhttp.h>
+
+#include <azure/core/_az_cfg.h>
+
+// The bytes of the body uploaded, or of the response read, at a time.
+#define _az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE 8192
+
+/**
+ * Converts the error of a WinHTTP function to az_result.
+ */
+static AZ_NODISCARD az_result _az_http_client_winhttp_error_to_result(DWORD error)
+{
+  switch (error)
+  {
+    case ERROR_NOT_ENOUGH_MEMORY:
+      return AZ_ERROR_OUT_OF_MEMORY;
+
+    case ERROR_WINHTTP_NAME_NOT_RESOLVED:
+      return AZ_ERROR_HTTP_RESPONSE_COULDNT_RESOLVE_HOST;
+
+    case ERROR_WINHTTP_OPERATION_CANCELLED:
+      return AZ_ERROR_CANCELED;
+
+    default:
+      // let any other error code be an HTTP PAL ERROR
+      return AZ_ERROR_HTTP_ADAPTER;
+  }
+}
+
+// returning AZ error on WinHTTP Error
+#define _az_RETURN_IF_WINHTTP_FAILED(exp)                              \
+  do                                                                   \
+  {                                                                    \
+    if (!(exp))                                                        \
+    {                                                                  \
+      return _az_http_client_winhttp_error_to_result(GetLastError()); \
+    }                                                                  \
+  } while (0)
+
+/**
+ * @brief Session used when connection reuse is enabled. WinHTTP keeps the connections of a session
+ * alive across its requests, and Schannel resumes the TLS sessions of the whole process.
+ */
+static HINTERNET _az_http_client_winhttp_session = NULL;
+
+/**
+ * @brief opens a WinHTTP session, which is asynchronous when \p flags has WINHTTP_FLAG_ASYNC.
+ *
+ * @remarks No user agent is given, so that the one written by the telemetry policy is the only one.
+ */
+static AZ_NODISCARD az_result _az_http_client_winhttp_open_session(DWORD flags, HINTERNET* out)
+{
+  *out = WinHttpOpen(
+      NULL,
+      WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+      WINHTTP_NO_PROXY_NAME,
+      WINHTTP_NO_PROXY_BYPASS,
+      flags);
+  _az_RETURN_IF_WINHTTP_FAILED(*out != NULL);
+
+  return AZ_OK;
+}
+
+/**
+ * @brief writes \p source to \p destination as UTF-16, which never takes more code units than
+ * \p source has bytes.
+ *
+ * @return the number of code units written.
+ */
+static int32_t _az_http_client_winhttp_widen(az_span source, WCHAR* destination)
+{
+  int32_t const size = az_span_size(source);
+  if (size == 0)
+  {
+    return 0;
+  }
+
+  return (int32_t)MultiByteToWideChar(
+      CP_UTF8, 0, (char const*)az_span_ptr(source), size, destination, size);
+}
+
+/**
+ * @brief adds the headers of \p request to \p ref_handle, in a single call since WinHTTP copies
+ * them.
+ */
+static AZ_NODISCARD az_result
+_az_http_client_winhttp_add_headers(HINTERNET ref_handle, az_http_request const* request)
+{
+  int32_t const headers_count = az_http_request_headers_count(request);
+  if (headers_count == 0)
+  {
+    return AZ_OK;
+  }
+
+  az_span const separator = AZ_SPAN_FROM_STR(": ");
+  az_span const end_of_line = AZ_SPAN_FROM_STR("\r\n");
+
+  size_t capacity = 0;
+  for (int32_t i = 0; i < headers_count; i++)
+  {
+    az_span name = { 0 };
+    az_span value = { 0 };
+    _az_RETURN_IF_FAILED(az_http_request_get_header(request, i, &name, &value));
+    capacity += (size_t)az_span_size(name) + (size_t)az_span_size(separator)
+        + (size_t)az_span_size(value) + (size_t)az_span_size(end_of_line);
+  }
+
+  WCHAR* const headers = (WCHAR*)malloc(capacity * sizeof(WCHAR));
+  if (headers == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  int32_t length = 0;
+  for (int32_t i = 0; i < headers_count; i++)
+  {
+    az_span name = { 0 };
+    az_span value = { 0 };
+    (void)az_http_request_get_header(request, i, &name, &value);
+    length += _az_http_client_winhttp_widen(name, headers + length);
+    length += _az_http_client_winhttp_widen(separator, headers + length);
+    length += _az_http_client_winhttp_widen(value, headers + length);
+    length += _az_http_client_winhttp_widen(end_of_line, headers + length);
+  }
+
+  BOOL const added
+      = WinHttpAddRequestHeaders(ref_handle, headers, (DWORD)length, WINHTTP_ADDREQ_FLAG_ADD);
+  DWORD const error = GetLastError();
+  free(headers);
+
+  return added ? AZ_OK : _az_http_client_winhttp_error_to_result(error);
+}
+
+/**
+ * @brief opens the connect and request handles of \p request on \p session, with its headers
+ * added.
+ *
+ * @remarks WinHTTP reuses a connection of the session to the same host and port, so a connect
+ * handle is opened for every request. On failure, the handles which were opened are released.
+ */
+static AZ_NODISCARD az_result _az_http_client_winhttp_open_request(
+    HINTERNET session,
+    az_http_request const* request,
+    HINTERNET* out_connect,
+    HINTERNET* out_request)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+
+  *out_connect = NULL;
+  *out_request = NULL;
+
+  az_http_method method = { 0 };
+  _az_RETURN_IF_FAILED(az_http_request_get_method(request, &method));
+
+  // Note: the url from request is already url-encoded.
+  az_span url = { 0 };
+  _az_RETURN_IF_FAILED(az_http_request_get_url(request, &url));
+
+  // The url, the host name and the method, each 0-terminated, share one allocation.
+  int32_t const url_size = az_span_size(url);
+  size_t const buffer_length = (size_t)url_size + 1 + (size_t)url_size + 1
+      + (size_t)az_span_size(method) + 1;
+  WCHAR* const buffer = (WCHAR*)malloc(buffer_length * sizeof(WCHAR));
+  if (buffer == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  WCHAR* const wide_url = buffer;
+  wide_url[_az_http_client_winhttp_widen(url, wide_url)] = L'\0';
+
+  WCHAR* const host = wide_url + url_size + 1;
+  WCHAR* const wide_method = host + url_size + 1;
+  wide_method[_az_http_client_winhttp_widen(method, wide_method)] = L'\0';
+
+  URL_COMPONENTS components = { 0 };
+  components.dwStructSize = sizeof(components);
+  components.dwHostNameLength = (DWORD)-1;
+  components.dwUrlPathLength = (DWORD)-1;
+  components.dwExtraInfoLength = (DWORD)-1;
+
+  az_result result = AZ_OK;
+  if (!WinHttpCrackUrl(wide_url, 0, 0, &components))
+  {
+    result = AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  if (az_result_succeeded(result))
+  {
+    for (DWORD i = 0; i < components.dwHostNameLength; i++)
+    {
+      host[i] = components.lpszHostName[i];
+    }
+    host[components.dwHostNameLength] = L'\0';
+
+    *out_connect = WinHttpConnect(session, host, components.nPort, 0);
+    if (*out_connect == NULL)
+    {
+      result = _az_http_client_winhttp_error_to_result(GetLastError());
+    }
+  }
+
+  if (az_result_succeeded(result))
+  {
+    // The path runs with the query to the end of the url. Both are already encoded.
+    WCHAR const* const path = components.dwUrlPathLength > 0 ? components.lpszUrlPath
+        : components.dwExtraInfoLength > 0                   ? components.lpszExtraInfo
+                                                             : NULL;
+    DWORD const flags = WINHTTP_FLAG_ESCAPE_DISABLE | WINHTTP_FLAG_ESCAPE_DISABLE_QUERY
+        | (components.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0);
+
+    *out_request = WinHttpOpenRequest(
+        *out_connect,
+        wide_method,
+        path,
+        NULL,
+        WINHTTP_NO_REFERER,
+        WINHTTP_DEFAULT_ACCEPT_TYPES,
+        flags);
+    if (*out_request == NULL)
+    {
+      result = _az_http_client_winhttp_error_to_result(GetLastError());
+    }
+  }
+
+  free(buffer);
+
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_client_winhttp_add_headers(*out_request, request);
+  }
+
+  if (az_result_succeeded(result)
+      && az_http_request_get_body_size(request) == AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN
+      && !WinHttpAddRequestHeaders(
+          *out_request, L"Transfer-Encoding: chunked", (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD))
+  {
+    result = _az_http_client_winhttp_error_to_result(GetLastError());
+  }
+
+  if (az_result_failed(result))
+  {
+    if (*out_request != NULL)
+    {
+      (void)WinHttpCloseHandle(*out_request);
+      *out_request = NULL;
+    }
+
+    if (*out_connect != NULL)
+    {
+      (void)WinHttpCloseHandle(*out_connect);
+      *out_connect = NULL;
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @brief the length of the body of \p request, for WinHttpSendRequest().
+ */
+static AZ_NODISCARD az_result
+_az_http_client_winhttp_get_body_length(az_http_request const* request, DWORD* out_length)
+{
+  int64_t const size = az_http_request_get_body_size(request);
+
+  // A body of unknown size is sent with chunked transfer coding, which WinHTTP leaves to
+  // _az_http_client_winhttp_read_chunk() to write. A larger body would have to be sent that way
+  // too.
+  if (size == AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN)
+  {
+    *out_length = WINHTTP_IGNORE_REQUEST_TOTAL_LENGTH;
+    return AZ_OK;
+  }
+
+  if (size > (int64_t)MAXDWORD)
+  {
+    return AZ_ERROR_NOT_SUPPORTED;
+  }
+
+  *out_length = (DWORD)size;
+  return AZ_OK;
+}
+
+// The size line before the data of a chunk, "XXXX\r\n", and the line end after it. Four
+// hexadecimal digits cover _az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE.
+#define _az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE_LINE_SIZE 6
+#define _az_HTTP_CLIENT_WINHTTP_CHUNK_FRAMING_SIZE \
+  (_az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE_LINE_SIZE + 2)
+
+/**
+ * @brief reads the next piece of the body of \p request into \p chunk. A body of unknown size is
+ * framed with chunked transfer coding, so its last piece is the empty chunk which ends it.
+ *
+ * @param out_read the number of bytes of the body read, which is `0` at its end.
+ * @param out_write_size the number of bytes of \p chunk to write.
+ */
+static AZ_NODISCARD az_result _az_http_client_winhttp_read_chunk(
+    az_http_request const* request,
+    int64_t offset,
+    uint8_t chunk[_az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE],
+    int32_t* out_read,
+    DWORD* out_write_size)
+{
+  if (az_http_request_get_body_size(request) != AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN)
+  {
+    _az_RETURN_IF_FAILED(az_http_request_read_body(
+        request, offset, az_span_create(chunk, _az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE), out_read));
+    *out_write_size = (DWORD)*out_read;
+    return AZ_OK;
+  }
+
+  // The data is read after the room left for the size line, which is written once it is known.
+  int32_t read = 0;
+  _az_RETURN_IF_FAILED(az_http_request_read_body(
+      request,
+      offset,
+      az_span_create(
+          chunk + _az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE_LINE_SIZE,
+          _az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE - _az_HTTP_CLIENT_WINHTTP_CHUNK_FRAMING_SIZE),
+      &read));
+
+  static uint8_t const hex_digits[] = "0123456789ABCDEF";
+  chunk[0] = hex_digits[(read >> 12) & 0xF];
+  chunk[1] = hex_digits[(read >> 8) & 0xF];
+  chunk[2] = hex_digits[(read >> 4) & 0xF];
+  chunk[3] = hex_digits[read & 0xF];
+  chunk[4] = '\r';
+  chunk[5] = '\n';
+  chunk[_az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE_LINE_SIZE + read] = '\r';
+  chunk[_az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE_LINE_SIZE + read + 1] = '\n';
+
+  *out_read = read;
+  *out_write_size = (DWORD)(_az_HTTP_CLIENT_WINHTTP_CHUNK_FRAMING_SIZE + read);
+  return AZ_OK;
+}
+
+/**
+ * @brief writes the status line and the headers of the response received on \p handle to
+ * \p ref_response, as they came on the wire.
+ *
+ * @remarks The version of an HTTP/2 response has no minor digit, which is added so that the
+ * status line parses as an HTTP/1.x one.
+ */
+static AZ_NODISCARD az_result
+_az_http_client_winhttp_append_headers(HINTERNET handle, az_http_response* ref_response)
+{
+  DWORD wide_size = 0;
+  (void)WinHttpQueryHeaders(
+      handle,
+      WINHTTP_QUERY_RAW_HEADERS_CRLF,
+      WINHTTP_HEADER_NAME_BY_INDEX,
+      WINHTTP_NO_OUTPUT_BUFFER,
+      &wide_size,
+      WINHTTP_NO_HEADER_INDEX);
+  if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+  {
+    return AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  WCHAR* const wide_headers = (WCHAR*)malloc(wide_size);
+  if (wide_headers == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  az_result result = AZ_OK;
+  char* headers = NULL;
+  int size = 0;
+  if (!WinHttpQueryHeaders(
+          handle,
+          WINHTTP_QUERY_RAW_HEADERS_CRLF,
+          WINHTTP_HEADER_NAME_BY_INDEX,
+          wide_headers,
+          &wide_size,
+          WINHTTP_NO_HEADER_INDEX))
+  {
+    result = _az_http_client_winhttp_error_to_result(GetLastError());
+  }
+  else
+  {
+    // On success, wide_size no longer counts the 0-terminator.
+    int const wide_length = (int)(wide_size / sizeof(WCHAR));
+    size = WideCharToMultiByte(CP_UTF8, 0, wide_headers, wide_length, NULL, 0, NULL, NULL);
+    headers = size > 0 ? (char*)malloc((size_t)size) : NULL;
+    if (headers == NULL)
+    {
+      result = size > 0 ? AZ_ERROR_OUT_OF_MEMORY : AZ_ERROR_HTTP_ADAPTER;
+    }
+    else
+    {
+      (void)WideCharToMultiByte(CP_UTF8, 0, wide_headers, wide_length, headers, size, NULL, NULL);
+    }
+  }
+
+  free(wide_headers);
+
+  if (az_result_succeeded(result))
+  {
+    az_span const raw = az_span_create((uint8_t*)headers, (int32_t)size);
+    int32_t const version_end = az_span_find(raw, AZ_SPAN_FROM_STR(" "));
+    az_span const version = az_span_slice(raw, 0, version_end < 0 ? 0 : version_end);
+
+    // The header block ends with an empty line, whether or not WinHTTP wrote it.
+    az_span terminator = AZ_SPAN_FROM_STR("\r\n\r\n");
+    if (az_span_size(raw) >= 4
+        && az_span_is_content_equal(
+            az_span_slice_to_end(raw, az_span_size(raw) - 4), AZ_SPAN_FROM_STR("\r\n\r\n")))
+    {
+      terminator = AZ_SPAN_EMPTY;
+    }
+    else if (
+        az_span_size(raw) >= 2
+        && az_span_is_content_equal(
+            az_span_slice_to_end(raw, az_span_size(raw) - 2), AZ_SPAN_FROM_STR("\r\n")))
+    {
+      terminator = AZ_SPAN_FROM_STR("\r\n");
+    }
+
+    bool const has_minor_version
+        = az_span_size(version) == 0 || az_span_find(version, AZ_SPAN_FROM_STR(".")) >= 0;
+    if (az_result_failed(az_http_response_append(ref_response, version))
+        || (!has_minor_version
+            && az_result_failed(az_http_response_append(ref_response, AZ_SPAN_FROM_STR(".0"))))
+        || az_result_failed(
+            az_http_response_append(ref_response, az_span_slice_to_end(raw, az_span_size(version))))
+        || az_result_failed(az_http_response_append(ref_response, terminator)))
+    {
+      result = AZ_ERROR_HTTP_RESPONSE_OVERFLOW;
+    }
+  }
+
+  free(headers);
+  return result;
+}
+
+/**
+ * @brief sends the request opened on \p handle, streaming its body from a body provider when it
+ * has one, and writes the response into \p ref_response.
+ */
+static AZ_NODISCARD az_result _az_http_client_winhttp_send_request_impl_process(
+    HINTERNET handle,
+    az_http_request const* request,
+    az_http_response* ref_response)
+{
+  DWORD body_length = 0;
+  _az_RETURN_IF_FAILED(_az_http_client_winhttp_get_body_length(request, &body_length));
+
+  // A body in a buffer is sent with the request, and one from a body provider is written after it.
+  LPVOID optional = WINHTTP_NO_REQUEST_DATA;
+  DWORD optional_length = 0;
+  if (request->_internal.body_provider == NULL && body_length > 0)
+  {
+    optional = az_span_ptr(request->_internal.body);
+    optional_length = body_length;
+  }
+
+  _az_RETURN_IF_WINHTTP_FAILED(WinHttpSendRequest(
+      handle, WINHTTP_NO_ADDITIONAL_HEADERS, 0, optional, optional_length, body_length, 0));
+
+  uint8_t chunk[_az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE];
+  if (request->_internal.body_provider != NULL)
+  {
+    int64_t offset = 0;
+    int32_t chunk_size = 0;
+    do
+    {
+      DWORD write_size = 0;
+      _az_RETURN_IF_FAILED(
+          _az_http_client_winhttp_read_chunk(request, offset, chunk, &chunk_size, &write_size));
+
+      DWORD written = 0;
+      _az_RETURN_IF_WINHTTP_FAILED(
+          write_size == 0 || WinHttpWriteData(handle, chunk, write_size, &written));
+      offset += chunk_size;
+    } while (chunk_size > 0);
+  }
+
+  _az_RETURN_IF_WINHTTP_FAILED(WinHttpReceiveResponse(handle, NULL));
+  _az_RETURN_IF_FAILED(_az_http_client_winhttp_append_headers(handle, ref_response));
+
+  DWORD read = 0;
+  do
+  {
+    _az_RETURN_IF_WINHTTP_FAILED(WinHttpReadData(handle, chunk, sizeof(chunk), &read));
+    if (az_result_failed(
+            az_http_response_append(ref_response, az_span_create(chunk, (int32_t)read))))
+    {
+      return AZ_ERROR_HTTP_RESPONSE_OVERFLOW;
+    }
+  } while (read > 0);
+
+  return AZ_OK;
+}
+
+/**
+ * @brief sends \p request with WinHTTP and writes the response into \p ref_response.
+ *
+ * @param request an internal http builder with data to build and send http request
+ * @param ref_response pre-allocated buffer where http response will be written
+ * @return az_result
+ */
+AZ_NODISCARD az_result
+az_http_client_send_request(az_http_request const* request, az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  HINTERNET session = _az_http_client_winhttp_session;
+  if (session == NULL)
+  {
+    _az_RETURN_IF_FAILED(_az_http_client_winhttp_open_session(0, &session));
+  }
+
+  HINTERNET connect = NULL;
+  HINTERNET handle = NULL;
+  az_result result = _az_http_client_winhttp_open_request(session, request, &connect, &handle);
+
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_client_winhttp_send_request_impl_process(handle, request, ref_response);
+    (void)WinHttpCloseHandle(handle);
+    (void)WinHttpCloseHandle(connect);
+  }
+
+  // The persistent session is only released by az_http_client_connection_reuse_cleanup().
+  if (session != _az_http_client_winhttp_session)
+  {
+    (void)WinHttpCloseHandle(session);
+  }
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_http_client_connection_reuse_init()
+{
+  if (_az_http_client_winhttp_session != NULL)
+  {
+    // Already initialized.
+    return AZ_OK;
+  }
+
+  return _az_http_client_winhttp_open_session(0, &_az_http_client_winhttp_session);
+}
+
+void az_http_client_connection_reuse_cleanup()
+{
+  if (_az_http_client_winhttp_session != NULL)
+  {
+    (void)WinHttpCloseHandle(_az_http_client_winhttp_session);
+    _az_http_client_winhttp_session = NULL;
+  }
+}
+
+// Schannel caches the TLS sessions of the process itself, and has no way to export them.
+AZ_NODISCARD az_result
+az_http_client_tls_sessions_export(az_span destination, az_span* out_sessions)
+{
+  (void)destination;
+  (void)out_sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_tls_sessions_import(az_span sessions)
+{
+  (void)sessions;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+/*
+ * An #az_http_client_async sends its requests on an asynchronous WinHTTP session, whose
+ * callbacks run on the threads of the WinHTTP thread pool as the I/O completion port of its
+ * sockets reports progress, and move each request forward from one step to the next. Once a
+ * request is done, its handle is closed, and the last callback of the handle gives it to the
+ * thread which polls the client, which completes its operation.
+ *
+ * The multi_handle of the client points to its _az_http_client_winhttp_client, and the easy_handle
+ * of each operation in flight to its _az_http_client_winhttp_operation.
+ */
+
+typedef struct _az_http_client_winhttp_operation _az_http_client_winhttp_operation;
+
+typedef struct
+{
+  HINTERNET session;
+  SRWLOCK lock;
+  // Signaled when an operation is added to closed.
+  HANDLE closed_event;
+  // The operations whose handles WinHTTP has closed, which are to be completed.
+  _az_http_client_winhttp_operation* closed;
+} _az_http_client_winhttp_client;
+
+struct _az_http_client_winhttp_operation
+{
+  _az_http_client_winhttp_client* client;
+  az_http_client_async_operation* operation;
+  // The copy of the request submitted, whose method, url, headers and body buffer are kept after
+  // the state in its allocation, so that the request of the caller may go away once submitted.
+  az_http_request request;
+  az_http_response* response;
+  HINTERNET connect;
+  HINTERNET handle;
+  int64_t upload_offset;
+  // Whether the end of the body was read, so that the response is awaited once it is written.
+  bool is_upload_done;
+  // Both are set, with the lock held, by the first of the callbacks and the polling thread to
+  // finish the request.
+  az_result result;
+  bool is_closing;
+  _az_http_client_winhttp_operation* next_closed;
+  uint8_t chunk[_az_HTTP_CLIENT_WINHTTP_CHUNK_SIZE];
+};
+
+/**
+ * @brief the number of bytes _az_http_client_winhttp_copy_request() copies \p request into.
+ */
+static AZ_NODISCARD size_t _az_http_client_winhttp_copy_size(az_http_request const* request)
+{
+  int32_t const headers_count = az_http_request_headers_count(request);
+  size_t size = (size_t)headers_count * sizeof(_az_http_request_header)
+      + (size_t)az_span_size(request->_internal.method) + (size_t)request->_internal.url_length;
+  for (int32_t i = 0; i < headers_count; i++)
+  {
+    _az_http_request_header const* const header
+        = &((_az_http_request_header const*)az_span_ptr(request->_internal.headers))[i];
+    size += (size_t)az_span_size(header->name) + (size_t)az_span_size(header->value);
+  }
+
+  if (request->_internal.body_provider == NULL)
+  {
+    size += (size_t)az_span_size(request->_internal.body);
+  }
+
+  return size;
+}
+
+/**
+ * @brief copies \p span to \p ref_storage and moves \p ref_storage past it.
+ */
+static AZ_NODISCARD az_span _az_http_client_winhttp_copy_span(az_span span, uint8_t** ref_storage)
+{
+  az_span const copy = az_span_create(*ref_storage, az_span_size(span));
+  (void)az_span_copy(copy, span);
+  *ref_storage += az_span_size(span);
+  return copy;
+}
+
+/**
+ * @brief copies \p request to \p out_copy, with its method, url, headers and body buffer in
+ * \p storage, which holds _az_http_client_winhttp_copy_size() bytes. The headers come first, so
+ * \p storage must be aligned for them.
+ *
+ * @remarks Like the headers which curl_slist_append() copies for the curl transport adapter, the
+ * copy lets the caller reuse its request once it is submitted. A body provider is still called
+ * with the context of the caller.
+ */
+static void _az_http_client_winhttp_copy_request(
+    az_http_request const* request,
+    az_http_request* out_copy,
+    uint8_t* storage)
+{
+  int32_t const headers_count = az_http_request_headers_count(request);
+  _az_http_request_header* const headers = (_az_http_request_header*)storage;
+  storage += (size_t)headers_count * sizeof(_az_http_request_header);
+
+  *out_copy = *request;
+  out_copy->_internal.headers = az_span_create(
+      (uint8_t*)headers, headers_count * (int32_t)sizeof(_az_http_request_header));
+  out_copy->_internal.max_headers = headers_count;
+  for (int32_t i = 0; i < headers_count; i++)
+  {
+    _az_http_request_header const* const header
+        = &((_az_http_request_header const*)az_span_ptr(request->_internal.headers))[i];
+    headers[i] = (_az_http_request_header){
+      .name = _az_http_client_winhttp_copy_span(header->name, &storage),
+      .value = _az_http_client_winhttp_copy_span(header->value, &storage),
+      .name_hash = header->name_hash,
+    };
+  }
+
+  out_copy->_internal.method
+      = _az_http_client_winhttp_copy_span(request->_internal.method, &storage);
+  out_copy->_internal.url = _az_http_client_winhttp_copy_span(
+      az_span_slice(request->_internal.url, 0, request->_internal.url_length), &storage);
+
+  if (request->_internal.body_provider == NULL)
+  {
+    out_copy->_internal.body
+        = _az_http_client_winhttp_copy_span(request->_internal.body, &storage);
+  }
+  else if (request->_internal.body_provider_user_context == (void*)request)
+  {
+    // Body segments are read through the request they are set on.
+    out_copy->_internal.body_provider_user_context = out_copy;
+  }
+}
+
+/**
+ * @brief closes the handle of a request which is done, unless it is already closing. WinHTTP
+ * cancels what is still pending on it.
+ */
+static void _az_http_client_winhttp_async_finish(
+    _az_http_client_winhttp_operation* ref_state,
+    az_result result)
+{
+  _az_http_client_winhttp_client* const client = ref_state->client;
+
+  AcquireSRWLockExclusive(&client->lock);
+  bool const should_close = !ref_state->is_closing;
+  if (should_close)
+  {
+    ref_state->is_closing = true;
+    ref_state->result = result;
+  }
+  ReleaseSRWLockExclusive(&client->lock);
+
+  if (should_close)
+  {
+    (void)WinHttpCloseHandle(ref_state->handle);
+  }
+}
+
+/**
+ * @brief finishes the request with the error of the WinHTTP function which just failed.
+ */
+static void _az_http_client_winhttp_async_fail(_az_http_client_winhttp_operation* ref_state)
+{
+  _az_http_client_winhttp_async_finish(
+      ref_state, _az_http_client_winhttp_error_to_result(GetLastError()));
+}
+
+/**
+ * @brief writes the next chunk of the body, or waits for the response once it was all written.
+ */
+static void _az_http_client_winhttp_async_write_next(_az_http_client_winhttp_operation* ref_state)
+{
+  if (ref_state->is_upload_done)
+  {
+    // The empty chunk which ends a body of unknown size was written.
+    if (!WinHttpReceiveResponse(ref_state->handle, NULL))
+    {
+      _az_http_client_winhttp_async_fail(ref_state);
+    }
+    return;
+  }
+
+  int32_t chunk_size = 0;
+  DWORD write_size = 0;
+  az_result const result = _az_http_client_winhttp_read_chunk(
+      &ref_state->request, ref_state->upload_offset, ref_state->chunk, &chunk_size, &write_size);
+  if (az_result_failed(result))
+  {
+    _az_http_client_winhttp_async_finish(ref_state, result);
+    return;
+  }
+
+  ref_state->upload_offset += chunk_size;
+  ref_state->is_upload_done = chunk_size == 0;
+  BOOL const started = write_size > 0
+      ? WinHttpWriteData(ref_state->handle, ref_state->chunk, write_size, NULL)
+      : WinHttpReceiveResponse(ref_state->handle, NULL);
+  if (!started)
+  {
+    _az_http_client_winhttp_async_fail(ref_state);
+  }
+}
+
+/**
+ * @brief reads the next chunk of the response body.
+ */
+static void _az_http_client_winhttp_async_read_next(_az_http_client_winhttp_operation* ref_state)
+{
+  if (!WinHttpReadData(ref_state->handle, ref_state->chunk, sizeof(ref_state->chunk), NULL))
+  {
+    _az_http_client_winhttp_async_fail(ref_state);
+  }
+}
+
+/**
+ * @brief the status callback of the session of an #az_http_client_async, called on the threads of
+ * the WinHTTP thread pool.
+ */
+static void CALLBACK _az_http_client_winhttp_async_callback(
+    HINTERNET handle,
+    DWORD_PTR context,
+    DWORD status,
+    LPVOID status_information,
+    DWORD status_information_length)
+{
+  _az_http_client_winhttp_operation* const state = (_az_http_client_winhttp_operation*)context;
+
+  // Only the request handles have a context: those of the session and connections are ignored.
+  if (state == NULL || handle != state->handle)
+  {
+    return;
+  }
+
+  switch (status)
+  {
+    case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+    case WINHTTP_CALLBACK_STATUS_WRITE_COMPLETE:
+      _az_http_client_winhttp_async_write_next(state);
+      break;
+
+    case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE:
+    {
+      az_result const result = _az_http_client_winhttp_append_headers(handle, state->response);
+      if (az_result_failed(result))
+      {
+        _az_http_client_winhttp_async_finish(state, result);
+      }
+      else
+      {
+        _az_http_client_winhttp_async_read_next(state);
+      }
+      break;
+    }
+
+    case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+      if (status_information_length == 0)
+      {
+        _az_http_client_winhttp_async_finish(state, AZ_OK);
+      }
+      else if (az_result_failed(az_http_response_append(
+                   state->response,
+                   az_span_create(state->chunk, (int32_t)status_information_length))))
+      {
+        _az_http_client_winhttp_async_finish(state, AZ_ERROR_HTTP_RESPONSE_OVERFLOW);
+      }
+      else
+      {
+        _az_http_client_winhttp_async_read_next(state);
+      }
+      break;
+
+    case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+      _az_http_client_winhttp_async_finish(
+          state,
+          _az_http_client_winhttp_error_to_result(
+              ((WINHTTP_ASYNC_RESULT const*)status_information)->dwError));
+      break;
+
+    case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+    {
+      // This is the last callback of the handle, so the polling thread can release the state.
+      _az_http_client_winhttp_client* const client = state->client;
+      AcquireSRWLockExclusive(&client->lock);
+      state->is_closing = true;
+      state->next_closed = client->closed;
+      client->closed = state;
+      ReleaseSRWLockExclusive(&client->lock);
+      (void)SetEvent(client->closed_event);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+AZ_NODISCARD az_result az_http_client_async_init(
+    az_http_client_async* out_client,
+    az_http_client_async_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_client);
+  _az_PRECONDITION(options == NULL || options->max_host_connections >= 0);
+  _az_PRECONDITION(
+      options == NULL || (options->socket_callback == NULL) == (options->timer_callback == NULL));
+
+  az_http_client_async_options const client_options
+      = options == NULL ? az_http_client_async_options_default() : *options;
+
+  // WinHTTP waits on the sockets itself, through an I/O completion port, so it can't be driven by
+  // an event loop.
+  if (client_options.socket_callback != NULL)
+  {
+    return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+  }
+
+  _az_http_client_winhttp_client* const client
+      = (_az_http_client_winhttp_client*)malloc(sizeof(_az_http_client_winhttp_client));
+  if (client == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  InitializeSRWLock(&client->lock);
+  client->closed = NULL;
+  client->closed_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+  client->session = NULL;
+
+  az_result result = client->closed_event != NULL ? AZ_OK : AZ_ERROR_OUT_OF_MEMORY;
+  if (az_result_succeeded(result))
+  {
+    result = _az_http_client_winhttp_open_session(WINHTTP_FLAG_ASYNC, &client->session);
+  }
+
+  if (az_result_succeeded(result)
+      && WinHttpSetStatusCallback(
+             client->session,
+             _az_http_client_winhttp_async_callback,
+             WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS | WINHTTP_CALLBACK_FLAG_HANDLES,
+             0)
+          == WINHTTP_INVALID_STATUS_CALLBACK)
+  {
+    result = AZ_ERROR_HTTP_ADAPTER;
+  }
+
+  if (az_result_succeeded(result) && client_options.max_host_connections > 0)
+  {
+    DWORD max_connections = (DWORD)client_options.max_host_connections;
+    if (!WinHttpSetOption(
+            client->session,
+            WINHTTP_OPTION_MAX_CONNS_PER_SERVER,
+            &max_connections,
+            sizeof(max_connections))
+        || !WinHttpSetOption(
+            client->session,
+            WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER,
+            &max_connections,
+            sizeof(max_connections)))
+    {
+      result = AZ_ERROR_HTTP_ADAPTER;
+    }
+  }
+
+  // Windows versions without HTTP/2 support in WinHTTP reject the option, and the requests fall
+  // back to HTTP/1.1 as documented.
+  bool use_http2 = false;
+#ifdef WINHTTP_PROTOCOL_FLAG_HTTP2
+  if (az_result_succeeded(result) && client_options.use_http2)
+  {
+    DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+    use_http2 = WinHttpSetOption(
+                    client->session,
+                    WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL,
+                    &protocols,
+                    sizeof(protocols))
+        != FALSE;
+  }
+#endif
+
+  if (az_result_failed(result))
+  {
+    if (client->session != NULL)
+    {
+      (void)WinHttpCloseHandle(client->session);
+    }
+    if (client->closed_event != NULL)
+    {
+      (void)CloseHandle(client->closed_event);
+    }
+    free(client);
+    return result;
+  }
+
+  *out_client = (az_http_client_async){
+    ._internal = {
+      .multi_handle = client,
+      .operations = NULL,
+      .pending_count = 0,
+      .use_http2 = use_http2,
+      .socket_callback = NULL,
+      .timer_callback = NULL,
+      .callback_context = client_options.callback_context,
+    },
+  };
+
+  return AZ_OK;
+}
+
+/**
+ * @brief unlinks the operation of a request whose handle WinHTTP has closed, records its final
+ * result and releases its state.
+ */
+static void _az_http_client_async_complete(
+    az_http_client_async* ref_client,
+    _az_http_client_winhttp_operation* state)
+{
+  az_http_client_async_operation* const operation = state->operation;
+  (void)WinHttpCloseHandle(state->connect);
+
+  // Unlink the operation from the list of operations in flight.
+  az_http_client_async_operation** ref_link = &ref_client->_internal.operations;
+  while (*ref_link != NULL && *ref_link != operation)
+  {
+    ref_link = &(*ref_link)->_internal.next;
+  }
+
+  if (*ref_link != NULL)
+  {
+    *ref_link = operation->_internal.next;
+  }
+
+  operation->_internal.easy_handle = NULL;
+  operation->_internal.next = NULL;
+  operation->_internal.result = state->result;
+  operation->_internal.completed = true;
+  ref_client->_internal.pending_count--;
+
+  free(state);
+}
+
+/**
+ * @brief completes the operations whose handles WinHTTP has closed.
+ */
+static void _az_http_client_async_complete_closed(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count)
+{
+  _az_http_client_winhttp_client* const client
+      = (_az_http_client_winhttp_client*)ref_client->_internal.multi_handle;
+
+  AcquireSRWLockExclusive(&client->lock);
+  _az_http_client_winhttp_operation* closed = client->closed;
+  client->closed = NULL;
+  ReleaseSRWLockExclusive(&client->lock);
+
+  while (closed != NULL)
+  {
+    _az_http_client_winhttp_operation* const next = closed->next_closed;
+    _az_http_client_async_complete(ref_client, closed);
+    closed = next;
+  }
+
+  if (out_pending_count != NULL)
+  {
+    *out_pending_count = ref_client->_internal.pending_count;
+  }
+}
+
+AZ_NODISCARD az_result az_http_client_async_submit(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* out_operation,
+    az_http_request const* request,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.multi_handle);
+  _az_PRECONDITION_NOT_NULL(out_operation);
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  _az_http_client_winhttp_client* const client
+      = (_az_http_client_winhttp_client*)ref_client->_internal.multi_handle;
+
+  DWORD body_length = 0;
+  _az_RETURN_IF_FAILED(_az_http_client_winhttp_get_body_length(request, &body_length));
+
+  _az_http_client_winhttp_operation* const state = (_az_http_client_winhttp_operation*)malloc(
+      sizeof(_az_http_client_winhttp_operation) + _az_http_client_winhttp_copy_size(request));
+  if (state == NULL)
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  state->client = client;
+  state->operation = out_operation;
+  _az_http_client_winhttp_copy_request(request, &state->request, (uint8_t*)(state + 1));
+  state->response = ref_response;
+  // A body in a buffer is sent with the request, so there is nothing left to write after it.
+  state->upload_offset = request->_internal.body_provider == NULL ? (int64_t)body_length : 0;
+  state->is_upload_done = false;
+  state->result = AZ_OK;
+  state->is_closing = false;
+  state->next_closed = NULL;
+
+  *out_operation = (az_http_client_async_operation){
+    ._internal = {
+      .easy_handle = NULL,
+      .headers = NULL,
+      .post_body = AZ_SPAN_EMPTY,
+      .upload_body = { 0 },
+      .result = AZ_OK,
+      .completed = false,
+      .next = NULL,
+    },
+  };
+
+  az_result result = _az_http_client_winhttp_open_request(
+      client->session, &state->request, &state->connect, &state->handle);
+
+  // The context is only set once the request is ready, so that the callbacks of handles which are
+  // closed on failure are ignored.
+  DWORD_PTR context = (DWORD_PTR)state;
+  if (az_result_succeeded(result)
+      && !WinHttpSetOption(state->handle, WINHTTP_OPTION_CONTEXT_VALUE, &context, sizeof(context)))
+  {
+    result = _az_http_client_winhttp_error_to_result(GetLastError());
+    (void)WinHttpCloseHandle(state->handle);
+    (void)WinHttpCloseHandle(state->connect);
+  }
+
+  if (az_result_failed(result))
+  {
+    free(state);
+    return result;
+  }
+
+  // The operation is in flight before the request is sent, since its callbacks may run right away.
+  out_operation->_internal.easy_handle = state;
+  out_operation->_internal.next = ref_client->_internal.operations;
+  ref_client->_internal.operations = out_operation;
+  ref_client->_internal.pending_count++;
+
+  // WinHTTP sends a body buffer from where it is, so it is sent from the copy.
+  LPVOID const optional = state->request._internal.body_provider == NULL && body_length > 0
+      ? (LPVOID)az_span_ptr(state->request._internal.body)
+      : WINHTTP_NO_REQUEST_DATA;
+  DWORD const optional_length = optional == WINHTTP_NO_REQUEST_DATA ? 0 : body_length;
+  if (!WinHttpSendRequest(
+          state->handle,
+          WINHTTP_NO_ADDITIONAL_HEADERS,
+          0,
+          optional,
+          optional_length,
+          body_length,
+          context))
+  {
+    // The operation completes with the error once its handle is closed.
+    _az_http_client_winhttp_async_fail(state);
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_client_async_poll(
+    az_http_client_async* ref_client,
+    int32_t timeout_msec,
+    int32_t* out_pending_count)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_client->_internal.multi_handle);
+  _az_PRECONDITION(timeout_msec >= 0);
+
+  _az_http_client_winhttp_client* const client
+      = (_az_http_client_winhttp_client*)ref_client->_internal.multi_handle;
+
+  if (ref_client->_internal.pending_count > 0 && timeout_msec > 0)
+  {
+    // Wait for a request to be done (or the timeout). The requests move forward on the WinHTTP
+    // thread pool meanwhile.
+    DWORD const wait_result = WaitForSingleObject(client->closed_event, (DWORD)timeout_msec);
+    if (wait_result != WAIT_OBJECT_0 && wait_result != WAIT_TIMEOUT)
+    {
+      return AZ_ERROR_HTTP_ADAPTER;
+    }
+  }
+
+  _az_http_client_async_complete_closed(ref_client, out_pending_count);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_client_async_socket_action(
+    az_http_client_async* ref_client,
+    intptr_t socket,
+    az_http_client_async_socket_events events,
+    int32_t* out_pending_count)
+{
+  // A client can't be driven by an event loop, see az_http_client_async_init().
+  (void)ref_client;
+  (void)socket;
+  (void)events;
+  (void)out_pending_count;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+AZ_NODISCARD az_result az_http_client_async_timer_expired(
+    az_http_client_async* ref_client,
+    int32_t* out_pending_count)
+{
+  (void)ref_client;
+  (void)out_pending_count;
+  return AZ_ERROR_DEPENDENCY_NOT_PROVIDED;
+}
+
+void az_http_client_async_cancel(
+    az_http_client_async* ref_client,
+    az_http_client_async_operation* ref_operation)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_operation);
+
+  // An operation which failed to submit has no state and was never in flight.
+  if (ref_operation->_internal.completed || ref_operation->_internal.easy_handle == NULL)
+  {
+    return;
+  }
+
+  _az_http_client_winhttp_client* const client
+      = (_az_http_client_winhttp_client*)ref_client->_internal.multi_handle;
+
+  _az_http_client_winhttp_async_finish(
+      (_az_http_client_winhttp_operation*)ref_operation->_internal.easy_handle, AZ_ERROR_CANCELED);
+
+  // The request and response may still be used by a callback until the handle is closed, so the
+  // operation is only completed then.
+  _az_http_client_async_complete_closed(ref_client, NULL);
+  while (!ref_operation->_internal.completed)
+  {
+    (void)WaitForSingleObject(client->closed_event, INFINITE);
+    _az_http_client_async_complete_closed(ref_client, NULL);
+  }
+}
+
+void az_http_client_async_cleanup(az_http_client_async* ref_client)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+
+  _az_http_client_winhttp_client* const client
+      = (_az_http_client_winhttp_client*)ref_client->_internal.multi_handle;
+  if (client == NULL)
+  {
+    return;
+  }
+
+  // Anything still in flight is abandoned.
+  while (ref_client->_internal.operations != NULL)
+  {
+    az_http_client_async_cancel(ref_client, ref_client->_internal.operations);
+  }
+
+  (void)WinHttpCloseHandle(client->session);
+  (void)CloseHandle(client->closed_event);
+  free(client);
+  ref_client->_internal.multi_handle = NULL;
+}
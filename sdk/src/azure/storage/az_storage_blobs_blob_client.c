@@ -1,9 +1,11 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include <azure/core/az_crypto.h>
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_json.h>
+#include <azure/core/az_platform.h>
 #include <azure/core/az_precondition.h>
 #include <azure/core/internal/az_config_internal.h>
 #include <azure/core/internal/az_credentials_internal.h>
@@ -17,18 +19,89 @@
 
 #include <azure/core/_az_cfg.h>
 
-enum
-{
-  _az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE = 10 * sizeof(_az_http_request_header),
-};
-
 static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_TYPE
     = AZ_SPAN_LITERAL_FROM_STR("x-ms-blob-type");
 
 static az_span const AZ_STORAGE_BLOBS_BLOB_TYPE_BLOCKBLOB = AZ_SPAN_LITERAL_FROM_STR("BlockBlob");
+static az_span const AZ_STORAGE_BLOBS_BLOB_TYPE_APPENDBLOB = AZ_SPAN_LITERAL_FROM_STR("AppendBlob");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_CONTENT_TYPE
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-blob-content-type");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_RANGE
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-range");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_CONTENT_CRC64
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-content-crc64");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_CONDITION_APPENDPOS
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-blob-condition-appendpos");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_ACCESS_TIER
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-access-tier");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_DELETE_SNAPSHOTS
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-delete-snapshots");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_COPY_SOURCE
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-copy-source");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_REQUIRES_SYNC
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-requires-sync");
+
+static az_span const AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_SOURCE_RANGE
+    = AZ_SPAN_LITERAL_FROM_STR("x-ms-source-range");
 
 static az_span const AZ_HTTP_HEADER_CONTENT_LENGTH = AZ_SPAN_LITERAL_FROM_STR("Content-Length");
 static az_span const AZ_HTTP_HEADER_CONTENT_TYPE = AZ_SPAN_LITERAL_FROM_STR("Content-Type");
+static az_span const AZ_HTTP_HEADER_CONTENT_RANGE = AZ_SPAN_LITERAL_FROM_STR("Content-Range");
+static az_span const AZ_HTTP_HEADER_CONTENT_MD5 = AZ_SPAN_LITERAL_FROM_STR("Content-MD5");
+static az_span const AZ_HTTP_HEADER_ETAG = AZ_SPAN_LITERAL_FROM_STR("ETag");
+static az_span const AZ_HTTP_HEADER_LAST_MODIFIED = AZ_SPAN_LITERAL_FROM_STR("Last-Modified");
+static az_span const AZ_HTTP_HEADER_IF_MATCH = AZ_SPAN_LITERAL_FROM_STR("If-Match");
+static az_span const AZ_HTTP_HEADER_IF_NONE_MATCH = AZ_SPAN_LITERAL_FROM_STR("If-None-Match");
+static az_span const AZ_HTTP_HEADER_IF_MODIFIED_SINCE
+    = AZ_SPAN_LITERAL_FROM_STR("If-Modified-Since");
+static az_span const AZ_HTTP_HEADER_IF_UNMODIFIED_SINCE
+    = AZ_SPAN_LITERAL_FROM_STR("If-Unmodified-Since");
+
+static az_span const AZ_STORAGE_BLOBS_BLOCK_LIST_START = AZ_SPAN_LITERAL_FROM_STR(
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?><BlockList>");
+static az_span const AZ_STORAGE_BLOBS_BLOCK_LIST_END = AZ_SPAN_LITERAL_FROM_STR("</BlockList>");
+static az_span const AZ_STORAGE_BLOBS_BLOCK_LATEST_START = AZ_SPAN_LITERAL_FROM_STR("<Latest>");
+static az_span const AZ_STORAGE_BLOBS_BLOCK_LATEST_END = AZ_SPAN_LITERAL_FROM_STR("</Latest>");
+
+static az_span const AZ_STORAGE_BLOBS_BATCH_CONTENT_TYPE
+    = AZ_SPAN_LITERAL_FROM_STR("multipart/mixed; boundary=" AZ_STORAGE_BLOBS_BATCH_BOUNDARY);
+static az_span const AZ_STORAGE_BLOBS_BATCH_PART_START
+    = AZ_SPAN_LITERAL_FROM_STR("--" AZ_STORAGE_BLOBS_BATCH_BOUNDARY "\r\n"
+                               "Content-Type: application/http\r\n"
+                               "Content-Transfer-Encoding: binary\r\n"
+                               "Content-ID: ");
+static az_span const AZ_STORAGE_BLOBS_BATCH_END
+    = AZ_SPAN_LITERAL_FROM_STR("--" AZ_STORAGE_BLOBS_BATCH_BOUNDARY "--\r\n");
+static az_span const AZ_HTTP_HEADER_CONTENT_ID = AZ_SPAN_LITERAL_FROM_STR("Content-ID");
+
+static az_span const AZ_STORAGE_BLOBS_LIST_BLOB_START = AZ_SPAN_LITERAL_FROM_STR("<Blob>");
+static az_span const AZ_STORAGE_BLOBS_LIST_BLOB_END = AZ_SPAN_LITERAL_FROM_STR("</Blob>");
+static az_span const AZ_STORAGE_BLOBS_LIST_PROPERTIES_START
+    = AZ_SPAN_LITERAL_FROM_STR("<Properties>");
+static az_span const AZ_STORAGE_BLOBS_LIST_PROPERTIES_END
+    = AZ_SPAN_LITERAL_FROM_STR("</Properties>");
+static az_span const AZ_STORAGE_BLOBS_LIST_NEXT_MARKER = AZ_SPAN_LITERAL_FROM_STR("<NextMarker");
+
+enum
+{
+  // Block IDs are the base64 encoding of the block index as a fixed-width decimal number.
+  _az_STORAGE_BLOBS_BLOCK_INDEX_DIGITS = 6,
+
+  // Holds the status line and headers of the response to a prewarm, which has no body.
+  _az_STORAGE_BLOBS_PREWARM_RESPONSE_SIZE = 2048,
+
+  // Holds the status line and headers of the response to a block staged from a URL, which has no
+  // body when it succeeds.
+  _az_STORAGE_BLOBS_COPY_BLOCK_RESPONSE_SIZE = 1024,
+};
 
 AZ_NODISCARD az_storage_blobs_blob_client_options az_storage_blobs_blob_client_options_default()
 {
@@ -43,8 +116,14 @@ AZ_NODISCARD az_storage_blobs_blob_client_options az_storage_blobs_blob_client_o
         },
       },
       .telemetry_options = _az_http_policy_telemetry_options_default(),
+      .coalescing_options = { .coalescer = NULL, .credential = NULL },
     },
     .retry_options = _az_http_policy_retry_options_default(),
+    .coalescer = NULL,
+    .response_cache = NULL,
+    .tracer = NULL,
+    .rate_limiter = NULL,
+    .circuit_breaker = NULL,
   };
 
   options.retry_options.max_retries = 5;
@@ -72,7 +151,14 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
       .credential = cred,
       .pipeline = (_az_http_pipeline){
         ._internal = {
+          // Composed in the order of _az_HTTP_PIPELINE_FIRST_POLICY and the policies after it.
           .policies = {
+            {
+              ._internal = {
+                .process = az_http_pipeline_policy_metrics,
+                .options = &out_client->_internal.options.metrics_options,
+              },
+            },
             {
               ._internal = {
                 .process = az_http_pipeline_policy_apiversion,
@@ -85,12 +171,42 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
                 .options = &out_client->_internal.options._internal.telemetry_options,
               },
             },
+            {
+              ._internal = {
+                .process = az_http_pipeline_policy_coalescing,
+                .options = &out_client->_internal.options._internal.coalescing_options,
+              },
+            },
+            {
+              ._internal = {
+                .process = az_http_pipeline_policy_response_cache,
+                .options = out_client->_internal.options.response_cache,
+              },
+            },
+            {
+              ._internal = {
+                .process = az_http_pipeline_policy_tracing,
+                .options = out_client->_internal.options.tracer,
+              },
+            },
             {
               ._internal = {
                 .process = az_http_pipeline_policy_retry,
                 .options = &out_client->_internal.options.retry_options,
               },
             },
+            {
+              ._internal = {
+                .process = az_http_pipeline_policy_circuit_breaker,
+                .options = out_client->_internal.options.circuit_breaker,
+              },
+            },
+            {
+              ._internal = {
+                .process = az_http_pipeline_policy_rate_limit,
+                .options = out_client->_internal.options.rate_limiter,
+              },
+            },
             {
               ._internal = {
                 .process = az_http_pipeline_policy_credential,
@@ -117,11 +233,17 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
     }
   };
 
+  // Requests only share a response with the ones authorized by the same credential.
+  out_client->_internal.options._internal.coalescing_options
+      = (_az_http_policy_coalescing_options){ .coalescer = options->coalescer, .credential = cred };
+
   // Copy url to client buffer so customer can re-use buffer on his/her side
   int32_t const uri_size = az_span_size(endpoint);
   _az_RETURN_IF_NOT_ENOUGH_SIZE(out_client->_internal.endpoint, uri_size);
   az_span_copy(out_client->_internal.endpoint, endpoint);
   out_client->_internal.endpoint = az_span_slice(out_client->_internal.endpoint, 0, uri_size);
+  out_client->_internal.endpoint_query_start
+      = _az_http_url_get_query_start(out_client->_internal.endpoint);
 
   _az_RETURN_IF_FAILED(
       _az_credential_set_scopes(cred, AZ_SPAN_FROM_STR("https://storage.azure.com/.default")));
@@ -129,65 +251,3680 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
   return AZ_OK;
 }
 
-AZ_NODISCARD az_result az_storage_blobs_blob_upload(
-    az_storage_blobs_blob_client* ref_client,
-    az_span content, /* Buffer of content*/
-    az_storage_blobs_blob_upload_options const* options,
-    az_http_response* ref_response)
+static AZ_NODISCARD az_result _az_storage_blobs_append_content_length(
+    az_http_request* ref_request,
+    az_span content_length_buffer,
+    int64_t content_length)
+{
+  az_span remainder;
+  _az_RETURN_IF_FAILED(az_span_i64toa(content_length_buffer, content_length, &remainder));
+  az_span const content_length_span
+      = az_span_slice(content_length_buffer, 0, _az_span_diff(remainder, content_length_buffer));
+
+  return az_http_request_append_header(
+      ref_request, AZ_HTTP_HEADER_CONTENT_LENGTH, content_length_span);
+}
+
+/**
+ * @brief Writes the range of \p size bytes from \p offset to \p range_buffer, as
+ * "bytes=<first>-<last>", where the last byte is omitted when \p size is 0, to read up to the end
+ * of the blob.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_write_range(
+    az_span range_buffer,
+    int64_t offset,
+    int64_t size,
+    az_span* out_range)
+{
+  az_span remainder = range_buffer;
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(AZ_SPAN_FROM_STR("bytes=")));
+  remainder = az_span_copy(remainder, AZ_SPAN_FROM_STR("bytes="));
+  _az_RETURN_IF_FAILED(az_span_i64toa(remainder, offset, &remainder));
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, 1);
+  remainder = az_span_copy_u8(remainder, '-');
+
+  if (size > 0)
+  {
+    _az_RETURN_IF_FAILED(az_span_i64toa(remainder, offset + size - 1, &remainder));
+  }
+
+  *out_range = az_span_slice(range_buffer, 0, _az_span_diff(remainder, range_buffer));
+  return AZ_OK;
+}
+
+/**
+ * @brief Appends a header for each of the \p conditions which isn't empty.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_append_conditions(
+    az_http_request* ref_request,
+    az_storage_blobs_blob_request_conditions const* conditions)
+{
+  az_span const names[] = {
+    AZ_HTTP_HEADER_IF_MATCH,
+    AZ_HTTP_HEADER_IF_NONE_MATCH,
+    AZ_HTTP_HEADER_IF_MODIFIED_SINCE,
+    AZ_HTTP_HEADER_IF_UNMODIFIED_SINCE,
+  };
+  az_span const values[] = {
+    conditions->if_match,
+    conditions->if_none_match,
+    conditions->if_modified_since,
+    conditions->if_unmodified_since,
+  };
+
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+  {
+    if (az_span_size(values[i]) > 0)
+    {
+      _az_RETURN_IF_FAILED(az_http_request_append_header(ref_request, names[i], values[i]));
+    }
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Writes \p crc64 as the service does in the `x-ms-content-crc64` header: the Base64 of its
+ * bytes, least significant first. \p destination is #_az_STORAGE_BLOBS_CRC64_BASE64_SIZE bytes.
+ */
+static AZ_NODISCARD az_result
+_az_storage_blobs_crc64_to_base64(uint64_t crc64, az_span destination, az_span* out_base64)
+{
+  uint8_t crc64_bytes[8];
+  for (int32_t i = 0; i < 8; i++)
+  {
+    crc64_bytes[i] = (uint8_t)(crc64 >> (i * 8));
+  }
+
+  int32_t written = 0;
+  _az_RETURN_IF_FAILED(
+      az_base64_encode(destination, AZ_SPAN_FROM_BUFFER(crc64_bytes), &written));
+  *out_base64 = az_span_slice(destination, 0, written);
+  return AZ_OK;
+}
+
+/**
+ * @brief Adds the `x-ms-content-crc64` header of \p content, written to \p crc64_buffer, which
+ * must stay alive until the request is sent.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_append_content_crc64(
+    az_http_request* ref_request,
+    az_span crc64_buffer,
+    az_span content)
+{
+  az_span crc64_base64 = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_crc64_to_base64(
+      az_crypto_crc64(content, 0), crc64_buffer, &crc64_base64));
+
+  return az_http_request_append_header(
+      ref_request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_CONTENT_CRC64, crc64_base64);
+}
+
+/**
+ * @brief Wraps a content provider to compute the CRC-64 of the content as the transport reads it.
+ */
+typedef struct
 {
+  az_http_request_body_provider_fn content_provider;
+  void* user_context;
+  int64_t next_offset;
+  uint64_t crc64;
+  bool read_in_order;
+} _az_storage_blobs_crc64_provider;
 
-  az_storage_blobs_blob_upload_options opt;
-  if (options == NULL)
+static AZ_NODISCARD az_result _az_storage_blobs_crc64_provide(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  _az_storage_blobs_crc64_provider* const provider
+      = (_az_storage_blobs_crc64_provider*)user_context;
+
+  _az_RETURN_IF_FAILED(
+      provider->content_provider(provider->user_context, offset, destination, out_size));
+
+  // The content is read again from the start when the request is retried.
+  if (offset == 0)
   {
-    opt = az_storage_blobs_blob_upload_options_default();
+    provider->next_offset = 0;
+    provider->crc64 = 0;
+    provider->read_in_order = true;
+  }
+
+  if (offset == provider->next_offset)
+  {
+    provider->crc64
+        = az_crypto_crc64(az_span_slice(destination, 0, *out_size), provider->crc64);
+    provider->next_offset += *out_size;
   }
   else
   {
-    opt = *options;
+    provider->read_in_order = false;
   }
 
-  // Request buffer
-  // create request buffer TODO: define size for a blob upload
+  return AZ_OK;
+}
+
+/**
+ * @brief Compares the CRC-64 the content was sent with to the one the service returns in a
+ * successful response. A response without one isn't checked.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_check_content_crc64(
+    az_http_response* ref_response,
+    _az_storage_blobs_crc64_provider const* provider)
+{
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+  if (status_line.status_code < AZ_HTTP_STATUS_CODE_OK
+      || status_line.status_code >= AZ_HTTP_STATUS_CODE_MULTIPLE_CHOICES
+      || !provider->read_in_order)
+  {
+    return AZ_OK;
+  }
+
+  uint8_t crc64_buffer[_az_STORAGE_BLOBS_CRC64_BASE64_SIZE];
+  az_span expected = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_crc64_to_base64(
+      provider->crc64, AZ_SPAN_FROM_BUFFER(crc64_buffer), &expected));
+
+  az_span header_name = AZ_SPAN_EMPTY;
+  az_span header_value = AZ_SPAN_EMPTY;
+  az_result result = AZ_OK;
+  while (az_result_succeeded(
+      result = az_http_response_get_next_header(ref_response, &header_name, &header_value)))
+  {
+    if (az_span_is_content_equal_ignoring_case(
+            header_name, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_CONTENT_CRC64))
+    {
+      return az_span_is_content_equal(header_value, expected)
+          ? AZ_OK
+          : AZ_ERROR_STORAGE_CONTENT_CRC64_MISMATCH;
+    }
+  }
+
+  return result == AZ_ERROR_HTTP_END_OF_HEADERS ? AZ_OK : result;
+}
+
+/**
+ * @brief Initializes a request to the endpoint of \p client, which is copied to \p url_buffer
+ * without looking for its query again.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_request_init(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request* out_request,
+    az_context* context,
+    az_http_method method,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span body)
+{
+  if (ref_client->_internal.is_prewarming)
+  {
+    // The connection the prewarm opens can't be used by two requests at once.
+    ref_client->_internal.is_prewarming = false;
+    az_platform_executor_wait(&ref_client->_internal.prewarm_work);
+  }
+
+  return _az_http_request_init_from_url_prefix(
+      out_request,
+      context,
+      method,
+      url_buffer,
+      ref_client->_internal.endpoint,
+      ref_client->_internal.endpoint_query_start,
+      headers_buffer,
+      body);
+}
+
+AZ_NODISCARD az_result
+az_storage_blobs_blob_client_prewarm(az_storage_blobs_blob_client* ref_client)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+
+  _az_RETURN_IF_FAILED(az_http_client_connection_reuse_init());
+
   uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
-  az_span request_url_span = AZ_SPAN_FROM_BUFFER(url_buffer);
-  // copy url from client
-  int32_t uri_size = az_span_size(ref_client->_internal.endpoint);
-  _az_RETURN_IF_NOT_ENOUGH_SIZE(request_url_span, uri_size);
-  az_span_copy(request_url_span, ref_client->_internal.endpoint);
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_http_request_init_from_url_prefix(
+      &request,
+      &az_context_application,
+      az_http_method_head(),
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      ref_client->_internal.endpoint,
+      ref_client->_internal.endpoint_query_start,
+      AZ_SPAN_EMPTY,
+      AZ_SPAN_EMPTY));
 
-  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
-  az_span request_headers_span = AZ_SPAN_FROM_BUFFER(headers_buffer);
+  uint8_t response_buffer[_az_STORAGE_BLOBS_PREWARM_RESPONSE_SIZE];
+  az_http_response response;
+  _az_RETURN_IF_FAILED(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)));
+
+  // Any response means the connection is open, whether the service accepted the request or not.
+  return az_http_client_send_request(&request, &response);
+}
+
+static void _az_storage_blobs_blob_client_prewarm_work(void* user_context)
+{
+  // A failed prewarm only means the first request connects by itself.
+  az_result result
+      = az_storage_blobs_blob_client_prewarm((az_storage_blobs_blob_client*)user_context);
+  (void)result;
+}
 
+AZ_NODISCARD az_result
+az_storage_blobs_blob_client_prewarm_submit(az_storage_blobs_blob_client* ref_client)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION(!ref_client->_internal.is_prewarming);
+
+  az_platform_work_init(
+      &ref_client->_internal.prewarm_work, _az_storage_blobs_blob_client_prewarm_work, ref_client);
+  _az_RETURN_IF_FAILED(az_platform_executor_submit(&ref_client->_internal.prewarm_work));
+
+  ref_client->_internal.is_prewarming = true;
+  return AZ_OK;
+}
+
+/**
+ * @brief Allocates the buffers of a request from \p ref_arena: the URL, sized for the endpoint and
+ * \p query_size bytes of query parameters, and the headers.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_allocate_request_buffers(
+    az_storage_blobs_blob_client const* client,
+    az_span_arena* ref_arena,
+    int32_t query_size,
+    az_span* out_url_buffer,
+    az_span* out_headers_buffer)
+{
+  _az_RETURN_IF_FAILED(az_span_arena_allocate(
+      ref_arena, az_span_size(client->_internal.endpoint) + query_size, out_url_buffer));
+  return az_span_arena_allocate(
+      ref_arena, _az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE, out_headers_buffer);
+}
+
+/**
+ * @brief Builds and sends a Put Blob request, whose body is either \p content or, when \p
+ * content_provider is not `NULL`, the bytes it provides.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_upload_send(
+    az_storage_blobs_blob_client* ref_client,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span content,
+    int64_t content_size,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_context* context,
+    bool validate_content_crc64,
+    az_storage_blobs_blob_request_conditions const* conditions,
+    az_http_response* ref_response)
+{
   // create request
   az_http_request request;
-  _az_RETURN_IF_FAILED(az_http_request_init(
-      &request,
-      opt.context,
-      az_http_method_put(),
-      request_url_span,
-      uri_size,
-      request_headers_span,
-      content));
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client, &request, context, az_http_method_put(), url_buffer, headers_buffer, content));
+
+  _az_storage_blobs_crc64_provider crc64_provider = {
+    .content_provider = content_provider,
+    .user_context = user_context,
+    .next_offset = 0,
+    .crc64 = 0,
+    .read_in_order = true,
+  };
+
+  if (content_provider != NULL && validate_content_crc64)
+  {
+    _az_RETURN_IF_FAILED(az_http_request_set_body_provider(
+        &request, content_size, _az_storage_blobs_crc64_provide, &crc64_provider));
+  }
+  else if (content_provider != NULL)
+  {
+    _az_RETURN_IF_FAILED(
+        az_http_request_set_body_provider(&request, content_size, content_provider, user_context));
+  }
 
   // add blob type to request
   _az_RETURN_IF_FAILED(az_http_request_append_header(
       &request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_TYPE, AZ_STORAGE_BLOBS_BLOB_TYPE_BLOCKBLOB));
 
   uint8_t content_length[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
-  az_span content_length_span = AZ_SPAN_FROM_BUFFER(content_length);
-  az_span remainder;
-  _az_RETURN_IF_FAILED(az_span_i64toa(content_length_span, az_span_size(content), &remainder));
-  content_length_span
-      = az_span_slice(content_length_span, 0, _az_span_diff(remainder, content_length_span));
 
   // add Content-Length to request
-  _az_RETURN_IF_FAILED(
-      az_http_request_append_header(&request, AZ_HTTP_HEADER_CONTENT_LENGTH, content_length_span));
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_content_length(
+      &request, AZ_SPAN_FROM_BUFFER(content_length), content_size));
 
   // add blob type to request
   _az_RETURN_IF_FAILED(az_http_request_append_header(
       &request, AZ_HTTP_HEADER_CONTENT_TYPE, AZ_SPAN_FROM_STR("text/plain")));
 
+  // Content in a buffer is checked by the service, and content from a provider once it is sent.
+  uint8_t content_crc64[_az_STORAGE_BLOBS_CRC64_BASE64_SIZE];
+  if (validate_content_crc64 && content_provider == NULL)
+  {
+    _az_RETURN_IF_FAILED(_az_storage_blobs_append_content_crc64(
+        &request, AZ_SPAN_FROM_BUFFER(content_crc64), content));
+  }
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_conditions(&request, conditions));
+
+  // start pipeline
+  _az_RETURN_IF_FAILED(
+      az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response));
+
+  return validate_content_crc64 && content_provider != NULL
+      ? _az_storage_blobs_check_content_crc64(ref_response, &crc64_provider)
+      : AZ_OK;
+}
+
+/**
+ * @brief Sends a Put Blob request with its URL and headers in worst-case sized buffers on the
+ * stack.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_upload_send_from_stack(
+    az_storage_blobs_blob_client* ref_client,
+    az_span content,
+    int64_t content_size,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_context* context,
+    bool validate_content_crc64,
+    az_storage_blobs_blob_request_conditions const* conditions,
+    az_http_response* ref_response)
+{
+  // create request buffer TODO: define size for a blob upload
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  return _az_storage_blobs_blob_upload_send(
+      ref_client,
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      content,
+      content_size,
+      content_provider,
+      user_context,
+      context,
+      validate_content_crc64,
+      conditions,
+      ref_response);
+}
+
+static AZ_NODISCARD az_result _az_storage_blobs_blob_upload(
+    az_storage_blobs_blob_client* ref_client,
+    az_span content,
+    int64_t content_size,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  if (opt.arena == NULL)
+  {
+    return _az_storage_blobs_blob_upload_send_from_stack(
+        ref_client,
+        content,
+        content_size,
+        content_provider,
+        user_context,
+        opt.context,
+        opt.validate_content_crc64,
+        &opt.conditions,
+        ref_response);
+  }
+
+  az_span url_buffer = AZ_SPAN_EMPTY;
+  az_span headers_buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+      ref_client, opt.arena, 0, &url_buffer, &headers_buffer));
+
+  return _az_storage_blobs_blob_upload_send(
+      ref_client,
+      url_buffer,
+      headers_buffer,
+      content,
+      content_size,
+      content_provider,
+      user_context,
+      opt.context,
+      opt.validate_content_crc64,
+      &opt.conditions,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload(
+    az_storage_blobs_blob_client* ref_client,
+    az_span content, /* Buffer of content*/
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  return _az_storage_blobs_blob_upload(
+      ref_client, content, az_span_size(content), NULL, NULL, options, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_from_provider(
+    az_storage_blobs_blob_client* ref_client,
+    int64_t content_size,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION(content_size >= 0);
+  _az_PRECONDITION_NOT_NULL(content_provider);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  return _az_storage_blobs_blob_upload(
+      ref_client,
+      AZ_SPAN_EMPTY,
+      content_size,
+      content_provider,
+      user_context,
+      options,
+      ref_response);
+}
+
+/**
+ * @brief Provides the content of an upload from the #az_platform_file_mapping in \p user_context.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_file_provide(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  az_span const content = az_platform_file_mapping_get_span(
+      (az_platform_file_mapping const*)user_context, offset, az_span_size(destination));
+
+  az_span_copy(destination, content);
+  *out_size = az_span_size(content);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_from_file(
+    az_storage_blobs_blob_client* ref_client,
+    az_platform_file_mapping const* mapping,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(mapping);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  int64_t const content_size = az_platform_file_mapping_get_size(mapping);
+  if (content_size <= INT32_MAX)
+  {
+    return az_storage_blobs_blob_upload(
+        ref_client,
+        az_platform_file_mapping_get_span(mapping, 0, (int32_t)content_size),
+        options,
+        ref_response);
+  }
+
+  // The provider only reads the mapping.
+  return az_storage_blobs_blob_upload_from_provider(
+      ref_client,
+      content_size,
+      _az_storage_blobs_file_provide,
+      (void*)(uintptr_t)mapping,
+      options,
+      ref_response);
+}
+
+AZ_NODISCARD az_result
+az_storage_blobs_blob_get_block_id(int32_t block_index, az_span destination, az_span* out_block_id)
+{
+  _az_PRECONDITION_RANGE(0, block_index, AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT - 1);
+  _az_PRECONDITION_NOT_NULL(out_block_id);
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(destination, AZ_STORAGE_BLOBS_BLOCK_ID_SIZE);
+
+  // Zero-padded so that every block ID of a blob has the same length.
+  uint8_t digits[_az_STORAGE_BLOBS_BLOCK_INDEX_DIGITS];
+  for (int32_t i = _az_STORAGE_BLOBS_BLOCK_INDEX_DIGITS - 1; i >= 0; i--)
+  {
+    digits[i] = (uint8_t)('0' + (block_index % 10));
+    block_index /= 10;
+  }
+
+  // Base64-encode the digits. Six input bytes map to eight output characters, with no padding.
+  static char const base64_chars[]
+      = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  uint8_t* const block_id = az_span_ptr(destination);
+  for (int32_t i = 0; i < _az_STORAGE_BLOBS_BLOCK_INDEX_DIGITS / 3; i++)
+  {
+    uint32_t const triplet = ((uint32_t)digits[i * 3] << 16) | ((uint32_t)digits[i * 3 + 1] << 8)
+        | (uint32_t)digits[i * 3 + 2];
+
+    block_id[i * 4] = (uint8_t)base64_chars[(triplet >> 18) & 0x3F];
+    block_id[i * 4 + 1] = (uint8_t)base64_chars[(triplet >> 12) & 0x3F];
+    block_id[i * 4 + 2] = (uint8_t)base64_chars[(triplet >> 6) & 0x3F];
+    block_id[i * 4 + 3] = (uint8_t)base64_chars[triplet & 0x3F];
+  }
+
+  *out_block_id = az_span_slice(destination, 0, AZ_STORAGE_BLOBS_BLOCK_ID_SIZE);
+  return AZ_OK;
+}
+
+/**
+ * @brief Builds a Put Block request into caller-provided buffers.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_stage_block_request_init(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request* out_request,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span content_length_buffer,
+    az_span content_crc64_buffer,
+    az_span block_id,
+    az_span content,
+    az_context* context,
+    bool validate_content_crc64)
+{
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client, out_request, context, az_http_method_put(), url_buffer, headers_buffer, content));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      out_request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("block"), true));
+
+  // Block IDs are base64, which can contain characters that need to be url-encoded.
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      out_request, AZ_SPAN_FROM_STR("blockid"), block_id, false));
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_content_length(
+      out_request, content_length_buffer, az_span_size(content)));
+
+  return validate_content_crc64
+      ? _az_storage_blobs_append_content_crc64(out_request, content_crc64_buffer, content)
+      : AZ_OK;
+}
+
+/**
+ * @brief Builds a Put Block request into the buffers provided and sends it.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_stage_block_send(
+    az_storage_blobs_blob_client* ref_client,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span block_id,
+    az_span content,
+    az_context* context,
+    bool validate_content_crc64,
+    az_http_response* ref_response)
+{
+  uint8_t content_length[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
+  uint8_t content_crc64[_az_STORAGE_BLOBS_CRC64_BASE64_SIZE];
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_blob_stage_block_request_init(
+      ref_client,
+      &request,
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_FROM_BUFFER(content_length),
+      AZ_SPAN_FROM_BUFFER(content_crc64),
+      block_id,
+      content,
+      context,
+      validate_content_crc64));
+
   // start pipeline
   return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
 }
+
+/**
+ * @brief Sends a Put Block request with its URL and headers in worst-case sized buffers on the
+ * stack.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_stage_block_send_from_stack(
+    az_storage_blobs_blob_client* ref_client,
+    az_span block_id,
+    az_span content,
+    az_context* context,
+    bool validate_content_crc64,
+    az_http_response* ref_response)
+{
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  return _az_storage_blobs_blob_stage_block_send(
+      ref_client,
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      block_id,
+      content,
+      context,
+      validate_content_crc64,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block(
+    az_storage_blobs_blob_client* ref_client,
+    az_span block_id,
+    az_span content,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_VALID_SPAN(block_id, 1, false);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  if (opt.arena == NULL)
+  {
+    return _az_storage_blobs_blob_stage_block_send_from_stack(
+        ref_client, block_id, content, opt.context, opt.validate_content_crc64, ref_response);
+  }
+
+  // "?comp=block&blockid=", and the block ID, of which each byte may be url-encoded.
+  int32_t const query_size = 20 + az_span_size(block_id) * 3;
+
+  az_span url_buffer = AZ_SPAN_EMPTY;
+  az_span headers_buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+      ref_client, opt.arena, query_size, &url_buffer, &headers_buffer));
+
+  return _az_storage_blobs_blob_stage_block_send(
+      ref_client,
+      url_buffer,
+      headers_buffer,
+      block_id,
+      content,
+      opt.context,
+      opt.validate_content_crc64,
+      ref_response);
+}
+
+typedef struct
+{
+  az_http_client_async* async_client;
+  az_http_client_async_operation* operation;
+} _az_storage_blobs_submit_options;
+
+/**
+ * @brief Last policy of the pipeline used to stage blocks asynchronously. Instead of sending the
+ * request and waiting for the response, it submits it to an #az_http_client_async.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_policy_submit(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  _az_storage_blobs_submit_options const* const submit_options
+      = (_az_storage_blobs_submit_options const*)ref_options;
+
+  return az_http_client_async_submit(
+      submit_options->async_client, submit_options->operation, ref_request, ref_response);
+}
+
+/**
+ * @brief Applies the request-shaping policies of the client to \p ref_request, then submits it to
+ * \p ref_async_client.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_http_client_async_operation* out_operation,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  _az_storage_blobs_submit_options submit_options = {
+    .async_client = ref_async_client,
+    .operation = out_operation,
+  };
+
+  // Same policies as the client pipeline, except for retry and logging which need to wait for the
+  // response.
+  _az_http_policy policies[] = {
+    {
+      ._internal = {
+        .process = az_http_pipeline_policy_apiversion,
+        .options = &ref_client->_internal.options._internal.api_version,
+      },
+    },
+    {
+      ._internal = {
+        .process = az_http_pipeline_policy_telemetry,
+        .options = &ref_client->_internal.options._internal.telemetry_options,
+      },
+    },
+    {
+      ._internal = {
+        .process = az_http_pipeline_policy_credential,
+        .options = ref_client->_internal.credential,
+      },
+    },
+    {
+      ._internal = {
+        .process = _az_storage_blobs_policy_submit,
+        .options = &submit_options,
+      },
+    },
+  };
+
+  return policies[0]._internal.process(
+      &policies[1], policies[0]._internal.options, ref_request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_storage_blobs_blob_stage_block_operation* out_operation,
+    az_span block_id,
+    az_span content,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_async_client);
+  _az_PRECONDITION_NOT_NULL(out_operation);
+  _az_PRECONDITION_VALID_SPAN(block_id, 1, false);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_blob_stage_block_request_init(
+      ref_client,
+      &out_operation->_internal.request,
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.url_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.headers_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.content_length_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.content_crc64_buffer),
+      block_id,
+      content,
+      opt.context,
+      opt.validate_content_crc64));
+
+  return _az_storage_blobs_submit(
+      ref_client,
+      ref_async_client,
+      &out_operation->operation,
+      &out_operation->_internal.request,
+      ref_response);
+}
+
+/**
+ * @brief Builds a Put Block List request with \p body into the buffers provided and sends it.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_commit_block_list_send(
+    az_storage_blobs_blob_client* ref_client,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span body,
+    az_context* context,
+    az_storage_blobs_blob_request_conditions const* conditions,
+    az_http_response* ref_response)
+{
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client, &request, context, az_http_method_put(), url_buffer, headers_buffer, body));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("blocklist"), true));
+
+  uint8_t content_length[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_content_length(
+      &request, AZ_SPAN_FROM_BUFFER(content_length), az_span_size(body)));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_HTTP_HEADER_CONTENT_TYPE, AZ_SPAN_FROM_STR("application/xml")));
+
+  // Same content type as a blob uploaded in one request with az_storage_blobs_blob_upload()
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request,
+      AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_CONTENT_TYPE,
+      AZ_SPAN_FROM_STR("text/plain")));
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_conditions(&request, conditions));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+/**
+ * @brief Sends a Put Block List request with its URL and headers in worst-case sized buffers on
+ * the stack.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_commit_block_list_send_from_stack(
+    az_storage_blobs_blob_client* ref_client,
+    az_span body,
+    az_context* context,
+    az_storage_blobs_blob_request_conditions const* conditions,
+    az_http_response* ref_response)
+{
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  return _az_storage_blobs_blob_commit_block_list_send(
+      ref_client,
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      body,
+      context,
+      conditions,
+      ref_response);
+}
+
+/**
+ * @brief Sends a Put Block List request with \p body, with its URL and headers allocated as \p
+ * options asks.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_commit_block_list_body(
+    az_storage_blobs_blob_client* ref_client,
+    az_span body,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  if (options->arena == NULL)
+  {
+    return _az_storage_blobs_blob_commit_block_list_send_from_stack(
+        ref_client, body, options->context, &options->conditions, ref_response);
+  }
+
+  az_span url_buffer = AZ_SPAN_EMPTY;
+  az_span headers_buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+      ref_client,
+      options->arena,
+      az_span_size(AZ_SPAN_FROM_STR("?comp=blocklist")),
+      &url_buffer,
+      &headers_buffer));
+
+  return _az_storage_blobs_blob_commit_block_list_send(
+      ref_client,
+      url_buffer,
+      headers_buffer,
+      body,
+      options->context,
+      &options->conditions,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_commit_block_list(
+    az_storage_blobs_blob_client* ref_client,
+    az_span const* block_ids,
+    int32_t block_ids_count,
+    az_span body_buffer,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(block_ids);
+  _az_PRECONDITION_RANGE(1, block_ids_count, AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  // Build the block list body
+  int32_t body_size = az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_START)
+      + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+  for (int32_t i = 0; i < block_ids_count; i++)
+  {
+    body_size += az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_START) + az_span_size(block_ids[i])
+        + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_END);
+  }
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(body_buffer, body_size);
+
+  az_span remainder = az_span_copy(body_buffer, AZ_STORAGE_BLOBS_BLOCK_LIST_START);
+  for (int32_t i = 0; i < block_ids_count; i++)
+  {
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_START);
+    remainder = az_span_copy(remainder, block_ids[i]);
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_END);
+  }
+  az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+
+  return _az_storage_blobs_blob_commit_block_list_body(
+      ref_client, az_span_slice(body_buffer, 0, body_size), &opt, ref_response);
+}
+
+/**
+ * @brief Builds a Copy Blob From URL request into the buffers provided and sends it.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_copy_from_url_send(
+    az_storage_blobs_blob_client* ref_client,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span source_url,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client,
+      &request,
+      options->context,
+      az_http_method_put(),
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_COPY_SOURCE, source_url));
+
+  // Without it, the copy is asynchronous, and only has the service start it.
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_REQUIRES_SYNC, AZ_SPAN_FROM_STR("true")));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_HTTP_HEADER_CONTENT_LENGTH, AZ_SPAN_FROM_STR("0")));
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_conditions(&request, &options->conditions));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_copy_from_url(
+    az_storage_blobs_blob_client* ref_client,
+    az_span source_url,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_VALID_SPAN(source_url, 1, false);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  if (opt.arena == NULL)
+  {
+    uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+    uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+    return _az_storage_blobs_blob_copy_from_url_send(
+        ref_client,
+        AZ_SPAN_FROM_BUFFER(url_buffer),
+        AZ_SPAN_FROM_BUFFER(headers_buffer),
+        source_url,
+        &opt,
+        ref_response);
+  }
+
+  az_span url_buffer = AZ_SPAN_EMPTY;
+  az_span headers_buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+      ref_client, opt.arena, 0, &url_buffer, &headers_buffer));
+
+  return _az_storage_blobs_blob_copy_from_url_send(
+      ref_client, url_buffer, headers_buffer, source_url, &opt, ref_response);
+}
+
+/**
+ * @brief Builds a Put Block From URL request into caller-provided buffers.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_stage_block_from_url_request_init(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request* out_request,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span source_range_buffer,
+    az_span block_id,
+    az_span source_url,
+    int64_t source_offset,
+    int64_t size,
+    az_context* context)
+{
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client,
+      out_request,
+      context,
+      az_http_method_put(),
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      out_request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("block"), true));
+
+  // Block IDs are base64, which can contain characters that need to be url-encoded.
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      out_request, AZ_SPAN_FROM_STR("blockid"), block_id, false));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      out_request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_COPY_SOURCE, source_url));
+
+  az_span source_range = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(
+      _az_storage_blobs_write_range(source_range_buffer, source_offset, size, &source_range));
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      out_request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_SOURCE_RANGE, source_range));
+
+  // The content is read by the service, so the request has none.
+  return az_http_request_append_header(
+      out_request, AZ_HTTP_HEADER_CONTENT_LENGTH, AZ_SPAN_FROM_STR("0"));
+}
+
+/**
+ * @brief Builds a Put Block From URL request into the buffers provided and sends it.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_stage_block_from_url_send(
+    az_storage_blobs_blob_client* ref_client,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span block_id,
+    az_span source_url,
+    int64_t source_offset,
+    int64_t size,
+    az_context* context,
+    az_http_response* ref_response)
+{
+  uint8_t source_range[6 + _az_INT64_AS_STR_BUFFER_SIZE * 2];
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_blob_stage_block_from_url_request_init(
+      ref_client,
+      &request,
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_FROM_BUFFER(source_range),
+      block_id,
+      source_url,
+      source_offset,
+      size,
+      context));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block_from_url(
+    az_storage_blobs_blob_client* ref_client,
+    az_span block_id,
+    az_span source_url,
+    int64_t source_offset,
+    int64_t size,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_VALID_SPAN(block_id, 1, false);
+  _az_PRECONDITION_VALID_SPAN(source_url, 1, false);
+  _az_PRECONDITION(source_offset >= 0);
+  _az_PRECONDITION(size > 0 && size <= AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  if (opt.arena == NULL)
+  {
+    uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+    uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+    return _az_storage_blobs_blob_stage_block_from_url_send(
+        ref_client,
+        AZ_SPAN_FROM_BUFFER(url_buffer),
+        AZ_SPAN_FROM_BUFFER(headers_buffer),
+        block_id,
+        source_url,
+        source_offset,
+        size,
+        opt.context,
+        ref_response);
+  }
+
+  // "?comp=block&blockid=", and the block ID, of which each byte may be url-encoded.
+  int32_t const query_size = 20 + az_span_size(block_id) * 3;
+
+  az_span url_buffer = AZ_SPAN_EMPTY;
+  az_span headers_buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+      ref_client, opt.arena, query_size, &url_buffer, &headers_buffer));
+
+  return _az_storage_blobs_blob_stage_block_from_url_send(
+      ref_client,
+      url_buffer,
+      headers_buffer,
+      block_id,
+      source_url,
+      source_offset,
+      size,
+      opt.context,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_stage_block_from_url_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_storage_blobs_blob_stage_block_operation* out_operation,
+    az_span block_id,
+    az_span source_url,
+    int64_t source_offset,
+    int64_t size,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_async_client);
+  _az_PRECONDITION_NOT_NULL(out_operation);
+  _az_PRECONDITION_VALID_SPAN(block_id, 1, false);
+  _az_PRECONDITION_VALID_SPAN(source_url, 1, false);
+  _az_PRECONDITION(source_offset >= 0);
+  _az_PRECONDITION(size > 0 && size <= AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_blob_stage_block_from_url_request_init(
+      ref_client,
+      &out_operation->_internal.request,
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.url_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.headers_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.source_range_buffer),
+      block_id,
+      source_url,
+      source_offset,
+      size,
+      opt.context));
+
+  return _az_storage_blobs_submit(
+      ref_client,
+      ref_async_client,
+      &out_operation->operation,
+      &out_operation->_internal.request,
+      ref_response);
+}
+
+/**
+ * @brief A block of a copy in blocks, being staged from the source URL.
+ */
+typedef struct
+{
+  az_storage_blobs_blob_stage_block_operation stage;
+  az_http_response response;
+  uint8_t response_buffer[_az_STORAGE_BLOBS_COPY_BLOCK_RESPONSE_SIZE];
+  int32_t block_index;
+  bool in_flight;
+} _az_storage_blobs_copy_block;
+
+/**
+ * @brief Gets the ID of the block at \p block_index, and the range of the source it is copied
+ * from.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_copy_block_get_range(
+    int32_t block_index,
+    int64_t source_size,
+    int32_t block_size,
+    az_span block_id_buffer,
+    az_span* out_block_id,
+    int64_t* out_offset,
+    int64_t* out_size)
+{
+  _az_RETURN_IF_FAILED(
+      az_storage_blobs_blob_get_block_id(block_index, block_id_buffer, out_block_id));
+
+  *out_offset = (int64_t)block_index * block_size;
+  *out_size = source_size - *out_offset < block_size ? source_size - *out_offset : block_size;
+  return AZ_OK;
+}
+
+/**
+ * @brief Stages every block of the copy, with up to \p concurrency of them in flight. A block
+ * whose request fails is staged again through the pipeline, into \p ref_response.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_copy_blocks(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    _az_storage_blobs_copy_block* ref_blocks,
+    int32_t concurrency,
+    az_span source_url,
+    int64_t source_size,
+    int32_t block_size,
+    int32_t block_count,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response,
+    bool* out_staged)
+{
+  uint8_t block_id_buffer[AZ_STORAGE_BLOBS_BLOCK_ID_SIZE];
+  az_span block_id = AZ_SPAN_EMPTY;
+  int64_t offset = 0;
+  int64_t size = 0;
+
+  *out_staged = false;
+  int32_t next_block = 0;
+  int32_t staged_count = 0;
+  while (staged_count < block_count)
+  {
+    for (int32_t i = 0; i < concurrency && next_block < block_count; ++i)
+    {
+      if (!ref_blocks[i].in_flight)
+      {
+        _az_RETURN_IF_FAILED(_az_storage_blobs_copy_block_get_range(
+            next_block,
+            source_size,
+            block_size,
+            AZ_SPAN_FROM_BUFFER(block_id_buffer),
+            &block_id,
+            &offset,
+            &size));
+
+        _az_RETURN_IF_FAILED(az_http_response_init(
+            &ref_blocks[i].response, AZ_SPAN_FROM_BUFFER(ref_blocks[i].response_buffer)));
+        _az_RETURN_IF_FAILED(az_storage_blobs_blob_stage_block_from_url_submit(
+            ref_client,
+            ref_async_client,
+            &ref_blocks[i].stage,
+            block_id,
+            source_url,
+            offset,
+            size,
+            options,
+            &ref_blocks[i].response));
+
+        ref_blocks[i].block_index = next_block;
+        ref_blocks[i].in_flight = true;
+        next_block++;
+      }
+    }
+
+    bool completed = false;
+    for (int32_t i = 0; i < concurrency; ++i)
+    {
+      az_http_client_async_operation const* const operation = &ref_blocks[i].stage.operation;
+      if (!ref_blocks[i].in_flight || !az_http_client_async_operation_is_completed(operation))
+      {
+        continue;
+      }
+
+      ref_blocks[i].in_flight = false;
+      completed = true;
+
+      az_http_response_status_line status_line = { 0 };
+      if (az_result_failed(az_http_client_async_operation_get_result(operation))
+          || az_result_failed(
+              az_http_response_get_status_line(&ref_blocks[i].response, &status_line))
+          || status_line.status_code != AZ_HTTP_STATUS_CODE_CREATED)
+      {
+        // Submitted requests aren't retried, so the block is staged again through the pipeline.
+        _az_RETURN_IF_FAILED(_az_storage_blobs_copy_block_get_range(
+            ref_blocks[i].block_index,
+            source_size,
+            block_size,
+            AZ_SPAN_FROM_BUFFER(block_id_buffer),
+            &block_id,
+            &offset,
+            &size));
+
+        _az_RETURN_IF_FAILED(az_storage_blobs_blob_stage_block_from_url(
+            ref_client, block_id, source_url, offset, size, options, ref_response));
+
+        _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+        if (status_line.status_code != AZ_HTTP_STATUS_CODE_CREATED)
+        {
+          // Leave the error in the response.
+          return AZ_OK;
+        }
+      }
+
+      staged_count++;
+    }
+
+    if (!completed)
+    {
+      _az_RETURN_IF_FAILED(az_http_client_async_poll(ref_async_client, 1000, NULL));
+    }
+  }
+
+  *out_staged = true;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_copy_from_url_in_blocks(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_span source_url,
+    int64_t source_size,
+    az_span block_list_buffer,
+    az_storage_blobs_blob_copy_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_async_client);
+  _az_PRECONDITION_VALID_SPAN(source_url, 1, false);
+  _az_PRECONDITION(source_size >= 0);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_copy_options const opt
+      = options == NULL ? az_storage_blobs_blob_copy_options_default() : *options;
+
+  _az_PRECONDITION_RANGE(1, opt.block_size, AZ_STORAGE_BLOBS_STAGE_BLOCK_FROM_URL_MAX_SIZE);
+  _az_PRECONDITION_RANGE(1, opt.concurrency, AZ_STORAGE_BLOBS_COPY_MAX_CONCURRENCY);
+
+  int64_t const block_count_64 = (source_size + opt.block_size - 1) / opt.block_size;
+  if (block_count_64 > AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  int32_t const block_count = (int32_t)block_count_64;
+  int32_t const block_list_size = az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_START)
+      + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_END)
+      + block_count
+          * (az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_START) + AZ_STORAGE_BLOBS_BLOCK_ID_SIZE
+             + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_END));
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(block_list_buffer, block_list_size);
+
+  az_storage_blobs_blob_upload_options upload_options
+      = az_storage_blobs_blob_upload_options_default();
+  upload_options.context = opt.context;
+
+  // The conditions are on the destination blob, so they only apply to the commit.
+  upload_options.conditions = opt.conditions;
+
+  _az_storage_blobs_copy_block blocks[AZ_STORAGE_BLOBS_COPY_MAX_CONCURRENCY];
+  for (int32_t i = 0; i < opt.concurrency; ++i)
+  {
+    blocks[i].in_flight = false;
+  }
+
+  bool staged = false;
+  az_result const result = _az_storage_blobs_copy_blocks(
+      ref_client,
+      ref_async_client,
+      blocks,
+      opt.concurrency,
+      source_url,
+      source_size,
+      opt.block_size,
+      block_count,
+      &upload_options,
+      ref_response,
+      &staged);
+
+  for (int32_t i = 0; i < opt.concurrency; ++i)
+  {
+    if (blocks[i].in_flight)
+    {
+      az_http_client_async_cancel(ref_async_client, &blocks[i].stage.operation);
+    }
+  }
+
+  if (az_result_failed(result) || !staged)
+  {
+    return result;
+  }
+
+  uint8_t block_id_buffer[AZ_STORAGE_BLOBS_BLOCK_ID_SIZE];
+  az_span block_id = AZ_SPAN_EMPTY;
+  az_span remainder = az_span_copy(block_list_buffer, AZ_STORAGE_BLOBS_BLOCK_LIST_START);
+  for (int32_t i = 0; i < block_count; i++)
+  {
+    _az_RETURN_IF_FAILED(
+        az_storage_blobs_blob_get_block_id(i, AZ_SPAN_FROM_BUFFER(block_id_buffer), &block_id));
+
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_START);
+    remainder = az_span_copy(remainder, block_id);
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_END);
+  }
+  az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+
+  return _az_storage_blobs_blob_commit_block_list_body(
+      ref_client,
+      az_span_slice(block_list_buffer, 0, block_list_size),
+      &upload_options,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_journal_init(
+    az_storage_blobs_blob_upload_journal* out_journal,
+    az_span buffer,
+    int64_t content_size,
+    int32_t block_size)
+{
+  _az_PRECONDITION_NOT_NULL(out_journal);
+  _az_PRECONDITION(content_size > 0);
+  _az_PRECONDITION(block_size > 0);
+
+  int64_t const block_count = (content_size + block_size - 1) / block_size;
+  _az_PRECONDITION(block_count <= AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT);
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(
+      buffer, AZ_STORAGE_BLOBS_UPLOAD_JOURNAL_SIZE((int32_t)block_count));
+
+  // The header is the content size (8 bytes) and the block size (4 bytes), least significant byte
+  // first, followed by one bit for each block.
+  uint8_t* const header = az_span_ptr(buffer);
+  uint64_t saved_content_size = 0;
+  uint32_t saved_block_size = 0;
+  for (int32_t i = 7; i >= 0; i--)
+  {
+    saved_content_size = (saved_content_size << 8) | header[i];
+  }
+  for (int32_t i = 11; i >= 8; i--)
+  {
+    saved_block_size = (saved_block_size << 8) | header[i];
+  }
+
+  *out_journal = (az_storage_blobs_blob_upload_journal){
+    ._internal = {
+      .staged_blocks = header + 12,
+      .content_size = content_size,
+      .block_size = block_size,
+      .block_count = (int32_t)block_count,
+    },
+  };
+
+  if (saved_content_size != (uint64_t)content_size || saved_block_size != (uint32_t)block_size)
+  {
+    // Not the journal of this upload, so start over.
+    for (int32_t i = 0; i < 8; i++)
+    {
+      header[i] = (uint8_t)((uint64_t)content_size >> (i * 8));
+    }
+    for (int32_t i = 0; i < 4; i++)
+    {
+      header[8 + i] = (uint8_t)((uint32_t)block_size >> (i * 8));
+    }
+
+    az_span_fill(
+        az_span_slice(buffer, 12, AZ_STORAGE_BLOBS_UPLOAD_JOURNAL_SIZE((int32_t)block_count)), 0);
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD bool az_storage_blobs_blob_upload_journal_is_block_staged(
+    az_storage_blobs_blob_upload_journal const* journal,
+    int32_t block_index)
+{
+  _az_PRECONDITION_NOT_NULL(journal);
+  _az_PRECONDITION_RANGE(0, block_index, journal->_internal.block_count - 1);
+
+  return (journal->_internal.staged_blocks[block_index / 8] & (1U << (block_index % 8))) != 0;
+}
+
+void az_storage_blobs_blob_upload_journal_set_block_staged(
+    az_storage_blobs_blob_upload_journal* ref_journal,
+    int32_t block_index)
+{
+  _az_PRECONDITION_NOT_NULL(ref_journal);
+  _az_PRECONDITION_RANGE(0, block_index, ref_journal->_internal.block_count - 1);
+
+  ref_journal->_internal.staged_blocks[block_index / 8] |= (uint8_t)(1U << (block_index % 8));
+}
+
+AZ_NODISCARD int32_t az_storage_blobs_blob_upload_journal_get_staged_count(
+    az_storage_blobs_blob_upload_journal const* journal)
+{
+  _az_PRECONDITION_NOT_NULL(journal);
+
+  int32_t staged_count = 0;
+  for (int32_t i = 0; i < journal->_internal.block_count; i++)
+  {
+    if (az_storage_blobs_blob_upload_journal_is_block_staged(journal, i))
+    {
+      staged_count++;
+    }
+  }
+
+  return staged_count;
+}
+
+/**
+ * @brief Returns the size of the block at \p block_index, which is the block size of the journal
+ * except for the last block.
+ */
+static AZ_NODISCARD int32_t _az_storage_blobs_blob_upload_journal_get_block_size(
+    az_storage_blobs_blob_upload_journal const* journal,
+    int32_t block_index)
+{
+  int64_t const remaining
+      = journal->_internal.content_size - (int64_t)block_index * journal->_internal.block_size;
+  return remaining < journal->_internal.block_size ? (int32_t)remaining
+                                                   : journal->_internal.block_size;
+}
+
+/**
+ * @brief Gets the position of the block whose ID is \p block_id, if it is one
+ * #az_storage_blobs_blob_get_block_id() generates.
+ */
+static AZ_NODISCARD bool _az_storage_blobs_block_id_to_index(az_span block_id, int32_t* out_index)
+{
+  if (az_span_size(block_id) != AZ_STORAGE_BLOBS_BLOCK_ID_SIZE)
+  {
+    return false;
+  }
+
+  // Decode the Base64 of the zero-padded digits, four characters making three digits.
+  uint8_t const* const chars = az_span_ptr(block_id);
+  int32_t index = 0;
+  for (int32_t i = 0; i < AZ_STORAGE_BLOBS_BLOCK_ID_SIZE; i += 4)
+  {
+    uint32_t triplet = 0;
+    for (int32_t j = 0; j < 4; j++)
+    {
+      uint8_t const c = chars[i + j];
+      uint32_t value = 0;
+      if (c >= 'A' && c <= 'Z')
+      {
+        value = (uint32_t)(c - 'A');
+      }
+      else if (c >= 'a' && c <= 'z')
+      {
+        value = (uint32_t)(c - 'a') + 26;
+      }
+      else if (c >= '0' && c <= '9')
+      {
+        value = (uint32_t)(c - '0') + 52;
+      }
+      else
+      {
+        // '+' and '/' never encode digits.
+        return false;
+      }
+      triplet = (triplet << 6) | value;
+    }
+
+    for (int32_t shift = 16; shift >= 0; shift -= 8)
+    {
+      uint32_t const digit = (triplet >> shift) & 0xFF;
+      if (digit < '0' || digit > '9')
+      {
+        return false;
+      }
+      index = index * 10 + (int32_t)(digit - '0');
+    }
+  }
+
+  *out_index = index;
+  return true;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_get_block_list(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  uint8_t url_stack_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_stack_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+  az_span url_buffer = AZ_SPAN_FROM_BUFFER(url_stack_buffer);
+  az_span headers_buffer = AZ_SPAN_FROM_BUFFER(headers_stack_buffer);
+  if (opt.arena != NULL)
+  {
+    _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+        ref_client,
+        opt.arena,
+        az_span_size(AZ_SPAN_FROM_STR("?comp=blocklist&blocklisttype=all")),
+        &url_buffer,
+        &headers_buffer));
+  }
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client,
+      &request,
+      opt.context,
+      az_http_method_get(),
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("blocklist"), true));
+
+  // Uncommitted blocks are the ones staged by an upload which didn't complete.
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("blocklisttype"), AZ_SPAN_FROM_STR("all"), true));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+/**
+ * @brief Gets the text of the next \p element of \p xml, and moves \p xml past it.
+ */
+static AZ_NODISCARD az_result
+_az_storage_blobs_xml_next_element(az_span* ref_xml, az_span element, az_span* out_text)
+{
+  // "<" element ">" text "</" element ">", with element names of less than 16 characters.
+  uint8_t tag_buffer[20];
+  az_span tag = AZ_SPAN_FROM_BUFFER(tag_buffer);
+
+  az_span remainder = az_span_copy_u8(tag, '<');
+  remainder = az_span_copy(remainder, element);
+  remainder = az_span_copy_u8(remainder, '>');
+  az_span const start_tag = az_span_slice(tag, 0, _az_span_diff(remainder, tag));
+
+  int32_t const start = az_span_find(*ref_xml, start_tag);
+  if (start < 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  az_span const text_and_rest = az_span_slice_to_end(*ref_xml, start + az_span_size(start_tag));
+  int32_t const end = az_span_find(text_and_rest, AZ_SPAN_FROM_STR("</"));
+  if (end < 0)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  *out_text = az_span_slice(text_and_rest, 0, end);
+  *ref_xml = az_span_slice_to_end(text_and_rest, end);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_journal_update(
+    az_storage_blobs_blob_upload_journal* ref_journal,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_journal);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+  if (status_line.status_code != AZ_HTTP_STATUS_CODE_OK
+      && status_line.status_code != AZ_HTTP_STATUS_CODE_NOT_FOUND)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  az_span xml = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_http_response_get_body(ref_response, &xml));
+
+  if (status_line.status_code == AZ_HTTP_STATUS_CODE_OK)
+  {
+    // The body runs to the end of the response buffer, so the list ends at its closing tag.
+    // Without it, the response didn't fit in the buffer.
+    int32_t const list_end = az_span_find(xml, AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+    if (list_end < 0)
+    {
+      return AZ_ERROR_UNEXPECTED_END;
+    }
+    xml = az_span_slice(xml, 0, list_end);
+  }
+
+  // The service has the final say, since it discards the blocks which are never committed.
+  az_span_fill(
+      az_span_create(
+          ref_journal->_internal.staged_blocks, (ref_journal->_internal.block_count + 7) / 8),
+      0);
+
+  if (status_line.status_code == AZ_HTTP_STATUS_CODE_NOT_FOUND)
+  {
+    return AZ_OK;
+  }
+
+  az_span name = AZ_SPAN_EMPTY;
+  az_result result = AZ_OK;
+  while (az_result_succeeded(
+      result = _az_storage_blobs_xml_next_element(&xml, AZ_SPAN_FROM_STR("Name"), &name)))
+  {
+    az_span size_text = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(
+        _az_storage_blobs_xml_next_element(&xml, AZ_SPAN_FROM_STR("Size"), &size_text));
+
+    int64_t size = 0;
+    _az_RETURN_IF_FAILED(az_span_atoi64(size_text, &size));
+
+    // Blocks staged with other IDs, or of another size, are not part of this upload.
+    int32_t block_index = 0;
+    if (_az_storage_blobs_block_id_to_index(name, &block_index)
+        && block_index < ref_journal->_internal.block_count
+        && size == _az_storage_blobs_blob_upload_journal_get_block_size(ref_journal, block_index))
+    {
+      az_storage_blobs_blob_upload_journal_set_block_staged(ref_journal, block_index);
+    }
+  }
+
+  return result == AZ_ERROR_ITEM_NOT_FOUND ? AZ_OK : result;
+}
+
+/**
+ * @brief Fills \p destination with the content from \p offset, calling \p content_provider as many
+ * times as it takes.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_read_content(
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    int64_t offset,
+    az_span destination)
+{
+  int32_t filled = 0;
+  while (filled < az_span_size(destination))
+  {
+    int32_t size = 0;
+    _az_RETURN_IF_FAILED(content_provider(
+        user_context, offset + filled, az_span_slice_to_end(destination, filled), &size));
+
+    if (size <= 0 || size > az_span_size(destination) - filled)
+    {
+      return AZ_ERROR_UNEXPECTED_END;
+    }
+    filled += size;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_resumable(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_span block_buffer,
+    az_storage_blobs_blob_upload_journal* ref_journal,
+    az_span block_list_buffer,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(content_provider);
+  _az_PRECONDITION_NOT_NULL(ref_journal);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  int32_t const block_count = ref_journal->_internal.block_count;
+  int32_t const block_list_size = az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_START)
+      + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_END)
+      + block_count
+          * (az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_START) + AZ_STORAGE_BLOBS_BLOCK_ID_SIZE
+             + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_END));
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(block_buffer, ref_journal->_internal.block_size);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(block_list_buffer, block_list_size);
+
+  uint8_t block_id_buffer[AZ_STORAGE_BLOBS_BLOCK_ID_SIZE];
+  az_span block_id = AZ_SPAN_EMPTY;
+
+  for (int32_t i = 0; i < block_count; i++)
+  {
+    if (az_storage_blobs_blob_upload_journal_is_block_staged(ref_journal, i))
+    {
+      continue;
+    }
+
+    az_span const block = az_span_slice(
+        block_buffer, 0, _az_storage_blobs_blob_upload_journal_get_block_size(ref_journal, i));
+    _az_RETURN_IF_FAILED(_az_storage_blobs_read_content(
+        content_provider, user_context, (int64_t)i * ref_journal->_internal.block_size, block));
+
+    _az_RETURN_IF_FAILED(
+        az_storage_blobs_blob_get_block_id(i, AZ_SPAN_FROM_BUFFER(block_id_buffer), &block_id));
+
+    // Each request only needs the arena while it is sent.
+    if (opt.arena != NULL)
+    {
+      az_span_arena_reset(opt.arena);
+    }
+
+    _az_RETURN_IF_FAILED(
+        az_storage_blobs_blob_stage_block(ref_client, block_id, block, &opt, ref_response));
+
+    az_http_response_status_line status_line = { 0 };
+    _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+    if (status_line.status_code != AZ_HTTP_STATUS_CODE_CREATED)
+    {
+      // Leave the error in the response, and the progress so far in the journal.
+      return AZ_OK;
+    }
+
+    az_storage_blobs_blob_upload_journal_set_block_staged(ref_journal, i);
+  }
+
+  az_span remainder = az_span_copy(block_list_buffer, AZ_STORAGE_BLOBS_BLOCK_LIST_START);
+  for (int32_t i = 0; i < block_count; i++)
+  {
+    _az_RETURN_IF_FAILED(
+        az_storage_blobs_blob_get_block_id(i, AZ_SPAN_FROM_BUFFER(block_id_buffer), &block_id));
+
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_START);
+    remainder = az_span_copy(remainder, block_id);
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_END);
+  }
+  az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+
+  if (opt.arena != NULL)
+  {
+    az_span_arena_reset(opt.arena);
+  }
+
+  return _az_storage_blobs_blob_commit_block_list_body(
+      ref_client, az_span_slice(block_list_buffer, 0, block_list_size), &opt, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_upload_from_stream(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request_body_provider_fn content_provider,
+    void* user_context,
+    az_span block_buffer,
+    az_span block_list_buffer,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(content_provider);
+  _az_PRECONDITION_VALID_SPAN(block_buffer, 1, false);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  int32_t const block_entry_size = az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_START)
+      + AZ_STORAGE_BLOBS_BLOCK_ID_SIZE + az_span_size(AZ_STORAGE_BLOBS_BLOCK_LATEST_END);
+  int32_t const block_list_end_size = az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(
+      block_list_buffer, az_span_size(AZ_STORAGE_BLOBS_BLOCK_LIST_START) + block_list_end_size);
+
+  // The block list is built as the blocks are staged, since their count is only known at the end.
+  az_span remainder = az_span_copy(block_list_buffer, AZ_STORAGE_BLOBS_BLOCK_LIST_START);
+
+  uint8_t block_id_buffer[AZ_STORAGE_BLOBS_BLOCK_ID_SIZE];
+  az_span block_id = AZ_SPAN_EMPTY;
+
+  int64_t offset = 0;
+  int32_t block_count = 0;
+  bool is_content_end = false;
+  while (!is_content_end)
+  {
+    int32_t block_size = 0;
+    while (block_size < az_span_size(block_buffer))
+    {
+      int32_t size = 0;
+      _az_RETURN_IF_FAILED(content_provider(
+          user_context, offset, az_span_slice_to_end(block_buffer, block_size), &size));
+
+      if (size < 0 || size > az_span_size(block_buffer) - block_size)
+      {
+        return AZ_ERROR_UNEXPECTED_END;
+      }
+
+      if (size == 0)
+      {
+        is_content_end = true;
+        break;
+      }
+
+      block_size += size;
+      offset += size;
+    }
+
+    if (block_size == 0)
+    {
+      // The content ended with the previous block.
+      break;
+    }
+
+    if (block_count == AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT)
+    {
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, block_entry_size + block_list_end_size);
+    _az_RETURN_IF_FAILED(az_storage_blobs_blob_get_block_id(
+        block_count, AZ_SPAN_FROM_BUFFER(block_id_buffer), &block_id));
+
+    // Each request only needs the arena while it is sent.
+    if (opt.arena != NULL)
+    {
+      az_span_arena_reset(opt.arena);
+    }
+
+    _az_RETURN_IF_FAILED(az_storage_blobs_blob_stage_block(
+        ref_client, block_id, az_span_slice(block_buffer, 0, block_size), &opt, ref_response));
+
+    az_http_response_status_line status_line = { 0 };
+    _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+    if (status_line.status_code != AZ_HTTP_STATUS_CODE_CREATED)
+    {
+      // Leave the error in the response.
+      return AZ_OK;
+    }
+
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_START);
+    remainder = az_span_copy(remainder, block_id);
+    remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LATEST_END);
+    block_count++;
+  }
+
+  remainder = az_span_copy(remainder, AZ_STORAGE_BLOBS_BLOCK_LIST_END);
+  int32_t const block_list_size = az_span_size(block_list_buffer) - az_span_size(remainder);
+
+  if (opt.arena != NULL)
+  {
+    az_span_arena_reset(opt.arena);
+  }
+
+  return _az_storage_blobs_blob_commit_block_list_body(
+      ref_client, az_span_slice(block_list_buffer, 0, block_list_size), &opt, ref_response);
+}
+
+/**
+ * @brief Builds a Get Blob request into caller-provided buffers, with an `x-ms-range` header when
+ * only part of the blob is to be downloaded.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_download_request_init(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_request* out_request,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span range_buffer,
+    az_storage_blobs_blob_download_options const* options)
+{
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client,
+      out_request,
+      options->context,
+      az_http_method_get(),
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_conditions(out_request, &options->conditions));
+
+  if (options->range_offset == 0 && options->range_size == 0)
+  {
+    // The whole blob.
+    return AZ_OK;
+  }
+
+  az_span range = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_write_range(
+      range_buffer, options->range_offset, options->range_size, &range));
+
+  return az_http_request_append_header(out_request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_RANGE, range);
+}
+
+/**
+ * @brief Builds a Get Blob request into the buffers provided and sends it.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_download_send(
+    az_storage_blobs_blob_client* ref_client,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response)
+{
+  uint8_t range_buffer[6 + _az_INT64_AS_STR_BUFFER_SIZE * 2];
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_blob_download_request_init(
+      ref_client,
+      &request,
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_FROM_BUFFER(range_buffer),
+      options));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+/**
+ * @brief Sends a Get Blob request with its URL and headers in worst-case sized buffers on the
+ * stack.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_download_send_from_stack(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response)
+{
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  return _az_storage_blobs_blob_download_send(
+      ref_client,
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      options,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_download(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_download_options const opt
+      = options == NULL ? az_storage_blobs_blob_download_options_default() : *options;
+
+  _az_PRECONDITION(opt.range_offset >= 0);
+  _az_PRECONDITION(opt.range_size >= 0);
+
+  if (opt.arena == NULL)
+  {
+    return _az_storage_blobs_blob_download_send_from_stack(ref_client, &opt, ref_response);
+  }
+
+  az_span url_buffer = AZ_SPAN_EMPTY;
+  az_span headers_buffer = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+      ref_client, opt.arena, 0, &url_buffer, &headers_buffer));
+
+  return _az_storage_blobs_blob_download_send(
+      ref_client, url_buffer, headers_buffer, &opt, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_download_submit(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    az_storage_blobs_blob_download_operation* out_operation,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_async_client);
+  _az_PRECONDITION_NOT_NULL(out_operation);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_download_options const opt
+      = options == NULL ? az_storage_blobs_blob_download_options_default() : *options;
+
+  _az_PRECONDITION(opt.range_offset >= 0);
+  _az_PRECONDITION(opt.range_size >= 0);
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_blob_download_request_init(
+      ref_client,
+      &out_operation->_internal.request,
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.url_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.headers_buffer),
+      AZ_SPAN_FROM_BUFFER(out_operation->_internal.range_buffer),
+      &opt));
+
+  return _az_storage_blobs_submit(
+      ref_client,
+      ref_async_client,
+      &out_operation->operation,
+      &out_operation->_internal.request,
+      ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_download_get_blob_size(
+    az_http_response* ref_response,
+    int64_t* out_blob_size)
+{
+  _az_PRECONDITION_NOT_NULL(ref_response);
+  _az_PRECONDITION_NOT_NULL(out_blob_size);
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+
+  az_span header_name = AZ_SPAN_EMPTY;
+  az_span header_value = AZ_SPAN_EMPTY;
+  az_result result = AZ_OK;
+  while (az_result_succeeded(
+      result = az_http_response_get_next_header(ref_response, &header_name, &header_value)))
+  {
+    if (az_span_is_content_equal_ignoring_case(header_name, AZ_HTTP_HEADER_CONTENT_RANGE))
+    {
+      // Content-Range: bytes <first>-<last>/<size>
+      int32_t const size_start = az_span_find(header_value, AZ_SPAN_FROM_STR("/"));
+      if (size_start < 0)
+      {
+        return AZ_ERROR_UNEXPECTED_CHAR;
+      }
+
+      return az_span_atoi64(az_span_slice_to_end(header_value, size_start + 1), out_blob_size);
+    }
+  }
+
+  return result == AZ_ERROR_HTTP_END_OF_HEADERS ? AZ_ERROR_ITEM_NOT_FOUND : result;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_get_properties(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_download_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_download_options const opt
+      = options == NULL ? az_storage_blobs_blob_download_options_default() : *options;
+
+  uint8_t url_stack_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_stack_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+  az_span url_buffer = AZ_SPAN_FROM_BUFFER(url_stack_buffer);
+  az_span headers_buffer = AZ_SPAN_FROM_BUFFER(headers_stack_buffer);
+  if (opt.arena != NULL)
+  {
+    _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+        ref_client, opt.arena, 0, &url_buffer, &headers_buffer));
+  }
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client,
+      &request,
+      opt.context,
+      az_http_method_head(),
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_conditions(&request, &opt.conditions));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_parse_properties(
+    az_http_response* ref_response,
+    az_storage_blobs_blob_properties* out_properties)
+{
+  _az_PRECONDITION_NOT_NULL(ref_response);
+  _az_PRECONDITION_NOT_NULL(out_properties);
+
+  *out_properties = (az_storage_blobs_blob_properties){
+    .etag = AZ_SPAN_EMPTY,
+    .last_modified = AZ_SPAN_EMPTY,
+    .content_md5 = AZ_SPAN_EMPTY,
+    .blob_type = AZ_SPAN_EMPTY,
+    .content_length = -1,
+  };
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+
+  az_span header_name = AZ_SPAN_EMPTY;
+  az_span header_value = AZ_SPAN_EMPTY;
+  az_result result = AZ_OK;
+  while (az_result_succeeded(
+      result = az_http_response_get_next_header(ref_response, &header_name, &header_value)))
+  {
+    if (az_span_is_content_equal_ignoring_case(header_name, AZ_HTTP_HEADER_ETAG))
+    {
+      out_properties->etag = header_value;
+    }
+    else if (az_span_is_content_equal_ignoring_case(header_name, AZ_HTTP_HEADER_LAST_MODIFIED))
+    {
+      out_properties->last_modified = header_value;
+    }
+    else if (az_span_is_content_equal_ignoring_case(header_name, AZ_HTTP_HEADER_CONTENT_MD5))
+    {
+      out_properties->content_md5 = header_value;
+    }
+    else if (az_span_is_content_equal_ignoring_case(
+                 header_name, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_TYPE))
+    {
+      out_properties->blob_type = header_value;
+    }
+    else if (az_span_is_content_equal_ignoring_case(header_name, AZ_HTTP_HEADER_CONTENT_LENGTH))
+    {
+      _az_RETURN_IF_FAILED(az_span_atoi64(header_value, &out_properties->content_length));
+    }
+  }
+
+  return result == AZ_ERROR_HTTP_END_OF_HEADERS ? AZ_OK : result;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_download_reader_init(
+    az_storage_blobs_download_reader* out_reader,
+    az_storage_blobs_blob_client* client,
+    az_http_client_async* async_client,
+    az_span buffer,
+    az_storage_blobs_download_reader_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_reader);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_NOT_NULL(async_client);
+  _az_PRECONDITION_VALID_SPAN(buffer, 1, false);
+
+  az_storage_blobs_download_reader_options const opt
+      = options == NULL ? az_storage_blobs_download_reader_options_default() : *options;
+
+  _az_PRECONDITION_RANGE(1, opt.window_count, AZ_STORAGE_BLOBS_DOWNLOAD_READER_MAX_WINDOWS);
+  _az_PRECONDITION(opt.range_offset >= 0);
+
+  int32_t const range_size = az_span_size(buffer) / opt.window_count
+      - AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE;
+  if (range_size <= 0)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  out_reader->_internal.client = client;
+  out_reader->_internal.async_client = async_client;
+  out_reader->_internal.buffer = buffer;
+  out_reader->_internal.window_count = opt.window_count;
+  out_reader->_internal.range_size = range_size;
+  out_reader->_internal.head = 0;
+  out_reader->_internal.head_read = false;
+  out_reader->_internal.done = false;
+  out_reader->_internal.next_offset = opt.range_offset;
+  out_reader->_internal.blob_size = -1;
+  out_reader->_internal.etag_size = 0;
+  out_reader->_internal.options = opt;
+
+  for (int32_t i = 0; i < opt.window_count; ++i)
+  {
+    out_reader->_internal.windows[i].offset = 0;
+    out_reader->_internal.windows[i].submit_msec = 0;
+    out_reader->_internal.windows[i].size = 0;
+    out_reader->_internal.windows[i].assigned = false;
+    out_reader->_internal.windows[i].measured = false;
+    out_reader->_internal.windows[i].in_flight = false;
+    _az_RETURN_IF_FAILED(az_http_response_init(
+        &out_reader->_internal.windows[i].response,
+        az_span_slice(
+            buffer,
+            i * (range_size + AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE),
+            (i + 1) * (range_size + AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE))));
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Gets the size of the range at \p offset: the one the tuner asks for, if any, within the
+ * window, and smaller at the end of the blob.
+ */
+static AZ_NODISCARD int32_t _az_storage_blobs_download_reader_get_range_size(
+    az_storage_blobs_download_reader const* reader,
+    int64_t offset)
+{
+  az_storage_blobs_transfer_tuner const* const tuner = reader->_internal.options.tuner;
+  int32_t range_size = reader->_internal.range_size;
+  if (tuner != NULL && az_storage_blobs_transfer_tuner_get_block_size(tuner) < range_size)
+  {
+    range_size = az_storage_blobs_transfer_tuner_get_block_size(tuner);
+  }
+
+  int64_t const blob_size = reader->_internal.blob_size;
+  return blob_size >= 0 && blob_size - offset < range_size ? (int32_t)(blob_size - offset)
+                                                           : range_size;
+}
+
+/**
+ * @brief Records the ranges which completed, in the order the transport completed them, with the
+ * tuner of the reader.
+ */
+static void _az_storage_blobs_download_reader_measure(az_storage_blobs_download_reader* ref_reader)
+{
+  az_storage_blobs_transfer_tuner* const tuner = ref_reader->_internal.options.tuner;
+  if (tuner == NULL)
+  {
+    return;
+  }
+
+  int64_t const now_msec = az_platform_clock_msec();
+  for (int32_t i = 0; i < ref_reader->_internal.window_count; ++i)
+  {
+    if (ref_reader->_internal.windows[i].in_flight && !ref_reader->_internal.windows[i].measured
+        && az_http_client_async_operation_is_completed(
+            &ref_reader->_internal.windows[i].download.operation))
+    {
+      // A transport failure is recorded as a status of 0.
+      az_http_response_status_line status_line = { 0 };
+      if (az_result_succeeded(az_http_client_async_operation_get_result(
+              &ref_reader->_internal.windows[i].download.operation)))
+      {
+        az_result const result = az_http_response_get_status_line(
+            &ref_reader->_internal.windows[i].response, &status_line);
+        (void)result;
+      }
+
+      az_storage_blobs_transfer_tuner_record(
+          tuner,
+          ref_reader->_internal.windows[i].size,
+          ref_reader->_internal.windows[i].submit_msec,
+          now_msec,
+          status_line.status_code);
+      ref_reader->_internal.windows[i].measured = true;
+    }
+  }
+}
+
+/**
+ * @brief Submits the Get Blob request of the range assigned to the window at \p index.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_download_reader_submit(
+    az_storage_blobs_download_reader* ref_reader,
+    int32_t index)
+{
+  az_storage_blobs_download_reader_options const* const reader_options
+      = &ref_reader->_internal.options;
+
+  az_storage_blobs_blob_download_options options = az_storage_blobs_blob_download_options_default();
+  options.context = reader_options->context;
+  options.range_offset = ref_reader->_internal.windows[index].offset;
+  options.range_size = ref_reader->_internal.windows[index].size;
+  options.conditions = reader_options->conditions;
+  if (az_span_size(options.conditions.if_match) == 0 && ref_reader->_internal.etag_size > 0)
+  {
+    options.conditions.if_match
+        = az_span_create(ref_reader->_internal.etag, ref_reader->_internal.etag_size);
+  }
+
+  // The window only ever receives this range, so it is reused without clearing it.
+  az_http_response* const response = &ref_reader->_internal.windows[index].response;
+  _az_RETURN_IF_FAILED(az_http_response_init(response, response->_internal.http_response));
+
+  _az_RETURN_IF_FAILED(az_storage_blobs_blob_download_submit(
+      ref_reader->_internal.client,
+      ref_reader->_internal.async_client,
+      &ref_reader->_internal.windows[index].download,
+      &options,
+      response));
+
+  ref_reader->_internal.windows[index].submit_msec = az_platform_clock_msec();
+  ref_reader->_internal.windows[index].in_flight = true;
+  ref_reader->_internal.windows[index].measured = false;
+  return AZ_OK;
+}
+
+/**
+ * @brief Submits the windows which are free, in order from the one being read, for the next ranges
+ * of the blob, as well as the ones whose download failed.
+ */
+static AZ_NODISCARD az_result
+_az_storage_blobs_download_reader_fill(az_storage_blobs_download_reader* ref_reader)
+{
+  int32_t in_flight_limit = ref_reader->_internal.window_count;
+  az_storage_blobs_transfer_tuner const* const tuner = ref_reader->_internal.options.tuner;
+  if (tuner != NULL && az_storage_blobs_transfer_tuner_get_concurrency(tuner) < in_flight_limit)
+  {
+    in_flight_limit = az_storage_blobs_transfer_tuner_get_concurrency(tuner);
+  }
+
+  // The window being read is only free once the next read starts.
+  int32_t const first = ref_reader->_internal.head_read ? 1 : 0;
+  for (int32_t i = first; i < ref_reader->_internal.window_count; ++i)
+  {
+    int32_t const index = (ref_reader->_internal.head + i) % ref_reader->_internal.window_count;
+    if (!ref_reader->_internal.windows[index].assigned)
+    {
+      // Until the first range tells the size of the blob, it is the only one downloaded.
+      bool const has_next_range = ref_reader->_internal.blob_size < 0
+          ? i == 0
+          : ref_reader->_internal.next_offset < ref_reader->_internal.blob_size;
+      if (!has_next_range || i - first >= in_flight_limit)
+      {
+        return AZ_OK;
+      }
+
+      int32_t const size = _az_storage_blobs_download_reader_get_range_size(
+          ref_reader, ref_reader->_internal.next_offset);
+      ref_reader->_internal.windows[index].offset = ref_reader->_internal.next_offset;
+      ref_reader->_internal.windows[index].size = size;
+      ref_reader->_internal.windows[index].assigned = true;
+      ref_reader->_internal.next_offset += size;
+    }
+
+    if (!ref_reader->_internal.windows[index].in_flight)
+    {
+      _az_RETURN_IF_FAILED(_az_storage_blobs_download_reader_submit(ref_reader, index));
+    }
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Checks the response to the range of the window at \p index, whose operation completed,
+ * and gets its content. The first range also tells the size and the ETag of the blob.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_download_reader_complete(
+    az_storage_blobs_download_reader* ref_reader,
+    int32_t index,
+    az_span* out_content)
+{
+  ref_reader->_internal.windows[index].in_flight = false;
+  _az_RETURN_IF_FAILED(az_http_client_async_operation_get_result(
+      &ref_reader->_internal.windows[index].download.operation));
+
+  az_http_response* const response = &ref_reader->_internal.windows[index].response;
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(response, &status_line));
+
+  int64_t const offset = ref_reader->_internal.windows[index].offset;
+  if (status_line.status_code == AZ_HTTP_STATUS_CODE_RANGE_NOT_SATISFIABLE
+      && ref_reader->_internal.blob_size < 0)
+  {
+    // The first range starts at the end of the blob, or the blob is empty.
+    ref_reader->_internal.blob_size = offset;
+    ref_reader->_internal.next_offset = offset;
+    *out_content = AZ_SPAN_EMPTY;
+    return AZ_OK;
+  }
+
+  if (status_line.status_code != AZ_HTTP_STATUS_CODE_PARTIAL_CONTENT)
+  {
+    return AZ_ERROR_STORAGE_DOWNLOAD_FAILED;
+  }
+
+  az_storage_blobs_blob_properties properties = { 0 };
+  _az_RETURN_IF_FAILED(az_storage_blobs_blob_parse_properties(response, &properties));
+  if (ref_reader->_internal.blob_size < 0)
+  {
+    _az_RETURN_IF_FAILED(
+        az_storage_blobs_blob_download_get_blob_size(response, &ref_reader->_internal.blob_size));
+
+    // An ETag which doesn't fit isn't used as a condition for the next ranges.
+    if (az_span_size(properties.etag) <= (int32_t)sizeof(ref_reader->_internal.etag))
+    {
+      az_span_copy(AZ_SPAN_FROM_BUFFER(ref_reader->_internal.etag), properties.etag);
+      ref_reader->_internal.etag_size = az_span_size(properties.etag);
+    }
+  }
+
+  // The first range was requested before the size of the blob was known.
+  if (ref_reader->_internal.blob_size - offset < ref_reader->_internal.windows[index].size)
+  {
+    ref_reader->_internal.windows[index].size = (int32_t)(ref_reader->_internal.blob_size - offset);
+    ref_reader->_internal.next_offset = ref_reader->_internal.blob_size;
+  }
+
+  // The body runs to the end of the window, so the Content-Length tells where the range ends.
+  int32_t const range_size = ref_reader->_internal.windows[index].size;
+  az_span body = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_http_response_get_body(response, &body));
+  if (properties.content_length != range_size || az_span_size(body) < range_size)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  *out_content = az_span_slice(body, 0, range_size);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_download_reader_read(
+    az_storage_blobs_download_reader* ref_reader,
+    az_span* out_content)
+{
+  _az_PRECONDITION_NOT_NULL(ref_reader);
+  _az_PRECONDITION_NOT_NULL(out_content);
+  _az_PRECONDITION(!ref_reader->_internal.done);
+
+  // The content of the window given out by the previous read isn't used anymore.
+  if (ref_reader->_internal.head_read)
+  {
+    ref_reader->_internal.windows[ref_reader->_internal.head].assigned = false;
+    ref_reader->_internal.head
+        = (ref_reader->_internal.head + 1) % ref_reader->_internal.window_count;
+    ref_reader->_internal.head_read = false;
+  }
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_download_reader_fill(ref_reader));
+
+  int32_t const head = ref_reader->_internal.head;
+  az_http_client_async_operation const* const operation
+      = &ref_reader->_internal.windows[head].download.operation;
+  while (!az_http_client_async_operation_is_completed(operation))
+  {
+    _az_RETURN_IF_FAILED(
+        az_http_client_async_poll(ref_reader->_internal.async_client, 1000, NULL));
+    _az_storage_blobs_download_reader_measure(ref_reader);
+  }
+
+  _az_storage_blobs_download_reader_measure(ref_reader);
+
+  az_span content = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_download_reader_complete(ref_reader, head, &content));
+
+  ref_reader->_internal.head_read = true;
+  ref_reader->_internal.done = ref_reader->_internal.windows[head].offset + az_span_size(content)
+      >= ref_reader->_internal.blob_size;
+  *out_content = content;
+
+  // The next ranges are downloaded while this one is being processed.
+  return _az_storage_blobs_download_reader_fill(ref_reader);
+}
+
+void az_storage_blobs_download_reader_cancel(az_storage_blobs_download_reader* ref_reader)
+{
+  _az_PRECONDITION_NOT_NULL(ref_reader);
+
+  for (int32_t i = 0; i < ref_reader->_internal.window_count; ++i)
+  {
+    if (ref_reader->_internal.windows[i].in_flight)
+    {
+      az_http_client_async_cancel(
+          ref_reader->_internal.async_client,
+          &ref_reader->_internal.windows[i].download.operation);
+      ref_reader->_internal.windows[i].in_flight = false;
+    }
+
+    ref_reader->_internal.windows[i].assigned = false;
+  }
+
+  ref_reader->_internal.done = true;
+}
+
+/**
+ * @brief Assigns the next ranges of the blob to the windows which are free, in any order, and
+ * submits them, as well as the ones whose download failed.
+ */
+static AZ_NODISCARD az_result
+_az_storage_blobs_download_to_file_fill(az_storage_blobs_download_reader* ref_reader)
+{
+  int32_t in_flight_limit = ref_reader->_internal.window_count;
+  az_storage_blobs_transfer_tuner const* const tuner = ref_reader->_internal.options.tuner;
+  if (tuner != NULL && az_storage_blobs_transfer_tuner_get_concurrency(tuner) < in_flight_limit)
+  {
+    in_flight_limit = az_storage_blobs_transfer_tuner_get_concurrency(tuner);
+  }
+
+  int32_t assigned_count = 0;
+  for (int32_t i = 0; i < ref_reader->_internal.window_count; ++i)
+  {
+    assigned_count += ref_reader->_internal.windows[i].assigned ? 1 : 0;
+  }
+
+  for (int32_t i = 0; i < ref_reader->_internal.window_count; ++i)
+  {
+    if (!ref_reader->_internal.windows[i].assigned)
+    {
+      // Until the first range tells the size of the blob, it is the only one downloaded.
+      bool const has_next_range = ref_reader->_internal.blob_size < 0
+          ? assigned_count == 0
+          : ref_reader->_internal.next_offset < ref_reader->_internal.blob_size;
+      if (!has_next_range || assigned_count >= in_flight_limit)
+      {
+        return AZ_OK;
+      }
+
+      int32_t const size = _az_storage_blobs_download_reader_get_range_size(
+          ref_reader, ref_reader->_internal.next_offset);
+      ref_reader->_internal.windows[i].offset = ref_reader->_internal.next_offset;
+      ref_reader->_internal.windows[i].size = size;
+      ref_reader->_internal.windows[i].assigned = true;
+      ref_reader->_internal.next_offset += size;
+      assigned_count++;
+    }
+
+    if (!ref_reader->_internal.windows[i].in_flight)
+    {
+      _az_RETURN_IF_FAILED(_az_storage_blobs_download_reader_submit(ref_reader, i));
+    }
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Writes the ranges which completed to the file, and submits the next ones, until the
+ * whole blob was written.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_download_to_file_write(
+    az_storage_blobs_download_reader* ref_reader,
+    intptr_t file,
+    bool preallocate)
+{
+  _az_RETURN_IF_FAILED(_az_storage_blobs_download_to_file_fill(ref_reader));
+
+  bool assigned = true;
+  while (assigned)
+  {
+    _az_storage_blobs_download_reader_measure(ref_reader);
+
+    bool completed = false;
+    assigned = false;
+    for (int32_t i = 0; i < ref_reader->_internal.window_count; ++i)
+    {
+      if (ref_reader->_internal.windows[i].in_flight
+          && az_http_client_async_operation_is_completed(
+              &ref_reader->_internal.windows[i].download.operation))
+      {
+        completed = true;
+        bool const first = ref_reader->_internal.blob_size < 0;
+        az_span content = AZ_SPAN_EMPTY;
+        _az_RETURN_IF_FAILED(_az_storage_blobs_download_reader_complete(ref_reader, i, &content));
+        if (first && preallocate)
+        {
+          _az_RETURN_IF_FAILED(az_platform_file_allocate(file, ref_reader->_internal.blob_size));
+        }
+
+        _az_RETURN_IF_FAILED(az_platform_file_write_at(
+            file, ref_reader->_internal.windows[i].offset, content));
+
+        // The window is free for the next range as soon as it was written.
+        ref_reader->_internal.windows[i].assigned = false;
+        _az_RETURN_IF_FAILED(_az_storage_blobs_download_to_file_fill(ref_reader));
+      }
+    }
+
+    // Filling can assign a window which was already checked.
+    for (int32_t i = 0; i < ref_reader->_internal.window_count; ++i)
+    {
+      assigned = assigned || ref_reader->_internal.windows[i].assigned;
+    }
+
+    if (assigned && !completed)
+    {
+      _az_RETURN_IF_FAILED(
+          az_http_client_async_poll(ref_reader->_internal.async_client, 1000, NULL));
+    }
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_download_to_file(
+    az_storage_blobs_blob_client* ref_client,
+    az_http_client_async* ref_async_client,
+    intptr_t file,
+    az_span buffer,
+    az_storage_blobs_blob_download_to_file_options const* options,
+    int64_t* out_blob_size)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_async_client);
+
+  az_storage_blobs_blob_download_to_file_options const opt
+      = options == NULL ? az_storage_blobs_blob_download_to_file_options_default() : *options;
+
+  // The windows of a reader download the ranges, but they are written as they complete.
+  az_storage_blobs_download_reader_options reader_options
+      = az_storage_blobs_download_reader_options_default();
+  reader_options.context = opt.context;
+  reader_options.window_count = opt.window_count;
+  reader_options.conditions = opt.conditions;
+  reader_options.tuner = opt.tuner;
+
+  az_storage_blobs_download_reader reader;
+  _az_RETURN_IF_FAILED(az_storage_blobs_download_reader_init(
+      &reader, ref_client, ref_async_client, buffer, &reader_options));
+
+  az_result const result = _az_storage_blobs_download_to_file_write(&reader, file, opt.preallocate);
+  if (az_result_failed(result))
+  {
+    az_storage_blobs_download_reader_cancel(&reader);
+    return result;
+  }
+
+  if (out_blob_size != NULL)
+  {
+    *out_blob_size = reader._internal.blob_size;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_create_append_blob(
+    az_storage_blobs_blob_client* ref_client,
+    az_storage_blobs_blob_upload_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_client);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  az_storage_blobs_blob_upload_options const opt
+      = options == NULL ? az_storage_blobs_blob_upload_options_default() : *options;
+
+  uint8_t url_stack_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_stack_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+  az_span url_buffer = AZ_SPAN_FROM_BUFFER(url_stack_buffer);
+  az_span headers_buffer = AZ_SPAN_FROM_BUFFER(headers_stack_buffer);
+  if (opt.arena != NULL)
+  {
+    _az_RETURN_IF_FAILED(_az_storage_blobs_allocate_request_buffers(
+        ref_client, opt.arena, 0, &url_buffer, &headers_buffer));
+  }
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      ref_client,
+      &request,
+      opt.context,
+      az_http_method_put(),
+      url_buffer,
+      headers_buffer,
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request,
+      AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_TYPE,
+      AZ_STORAGE_BLOBS_BLOB_TYPE_APPENDBLOB));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_HTTP_HEADER_CONTENT_LENGTH, AZ_SPAN_FROM_STR("0")));
+
+  // Same content type as a blob uploaded with az_storage_blobs_blob_upload()
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request,
+      AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_CONTENT_TYPE,
+      AZ_SPAN_FROM_STR("text/plain")));
+
+  // start pipeline
+  return az_http_pipeline_process(&ref_client->_internal.pipeline, &request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_append_writer_init(
+    az_storage_blobs_append_writer* out_writer,
+    az_storage_blobs_blob_client* client,
+    az_span buffer,
+    int64_t append_position,
+    az_storage_blobs_append_writer_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_writer);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(buffer, 1, false);
+  _az_PRECONDITION(az_span_size(buffer) <= AZ_STORAGE_BLOBS_APPEND_BLOCK_MAX_SIZE);
+  _az_PRECONDITION(append_position >= 0);
+
+  az_storage_blobs_append_writer_options opt
+      = options == NULL ? az_storage_blobs_append_writer_options_default() : *options;
+
+  _az_PRECONDITION(opt.flush_size >= 0);
+  _az_PRECONDITION(opt.flush_interval_msec >= 0);
+
+  if (opt.flush_size == 0 || opt.flush_size > az_span_size(buffer))
+  {
+    opt.flush_size = az_span_size(buffer);
+  }
+
+  *out_writer = (az_storage_blobs_append_writer){
+    ._internal = {
+      .client = client,
+      .buffer = buffer,
+      .buffered_size = 0,
+      .append_position = append_position,
+      .first_buffered_msec = 0,
+      .options = opt,
+    },
+  };
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Sends an Append Block request with \p block, conditioned on the blob ending at the append
+ * position of \p ref_writer, and moves the position past it once appended.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_append_writer_append_block(
+    az_storage_blobs_append_writer* ref_writer,
+    az_span block,
+    az_http_response* ref_response)
+{
+  az_storage_blobs_blob_client* const client = ref_writer->_internal.client;
+
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      client,
+      &request,
+      ref_writer->_internal.options.context,
+      az_http_method_put(),
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      block));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("appendblock"), true));
+
+  uint8_t content_length[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_content_length(
+      &request, AZ_SPAN_FROM_BUFFER(content_length), az_span_size(block)));
+
+  // A block is only appended where the writer expects the blob to end, so that records of two
+  // writers are never interleaved, and a retried request which did go through isn't appended
+  // twice.
+  uint8_t append_position[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
+  az_span remainder = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_span_i64toa(
+      AZ_SPAN_FROM_BUFFER(append_position), ref_writer->_internal.append_position, &remainder));
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request,
+      AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_BLOB_CONDITION_APPENDPOS,
+      az_span_slice(
+          AZ_SPAN_FROM_BUFFER(append_position),
+          0,
+          _az_span_diff(remainder, AZ_SPAN_FROM_BUFFER(append_position)))));
+
+  // start pipeline
+  _az_RETURN_IF_FAILED(
+      az_http_pipeline_process(&client->_internal.pipeline, &request, ref_response));
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+  if (status_line.status_code != AZ_HTTP_STATUS_CODE_CREATED)
+  {
+    return AZ_ERROR_STORAGE_APPEND_FAILED;
+  }
+
+  ref_writer->_internal.append_position += az_span_size(block);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_append_writer_flush(
+    az_storage_blobs_append_writer* ref_writer,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_writer);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  if (ref_writer->_internal.buffered_size == 0)
+  {
+    return AZ_OK;
+  }
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_writer_append_block(
+      ref_writer,
+      az_span_slice(ref_writer->_internal.buffer, 0, ref_writer->_internal.buffered_size),
+      ref_response));
+
+  ref_writer->_internal.buffered_size = 0;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_append_writer_poll(
+    az_storage_blobs_append_writer* ref_writer,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_writer);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  int32_t const interval = ref_writer->_internal.options.flush_interval_msec;
+  if (ref_writer->_internal.buffered_size == 0 || interval == 0
+      || az_platform_clock_msec() - ref_writer->_internal.first_buffered_msec < interval)
+  {
+    return AZ_OK;
+  }
+
+  return az_storage_blobs_append_writer_flush(ref_writer, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_append_writer_write(
+    az_storage_blobs_append_writer* ref_writer,
+    az_span record,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_writer);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  int32_t const record_size = az_span_size(record);
+  int32_t const buffer_size = az_span_size(ref_writer->_internal.buffer);
+
+  if (record_size > buffer_size - ref_writer->_internal.buffered_size)
+  {
+    // Keep the record whole, in the next block.
+    _az_RETURN_IF_FAILED(az_storage_blobs_append_writer_flush(ref_writer, ref_response));
+  }
+
+  if (record_size > buffer_size)
+  {
+    return _az_storage_blobs_append_writer_append_block(ref_writer, record, ref_response);
+  }
+
+  if (ref_writer->_internal.buffered_size == 0)
+  {
+    ref_writer->_internal.first_buffered_msec = az_platform_clock_msec();
+  }
+
+  az_span_copy(
+      az_span_slice_to_end(ref_writer->_internal.buffer, ref_writer->_internal.buffered_size),
+      record);
+  ref_writer->_internal.buffered_size += record_size;
+
+  az_result const result
+      = ref_writer->_internal.buffered_size >= ref_writer->_internal.options.flush_size
+      ? az_storage_blobs_append_writer_flush(ref_writer, ref_response)
+      : az_storage_blobs_append_writer_poll(ref_writer, ref_response);
+
+  if (az_result_failed(result))
+  {
+    // The record isn't written unless it is appended, so that it can be written again.
+    ref_writer->_internal.buffered_size -= record_size;
+  }
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_batch_init(
+    az_storage_blobs_batch* out_batch,
+    az_storage_blobs_blob_client* client,
+    az_span buffer)
+{
+  _az_PRECONDITION_NOT_NULL(out_batch);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(buffer, 1, false);
+
+  *out_batch = (az_storage_blobs_batch){
+    ._internal = {
+      .client = client,
+      .buffer = buffer,
+      .length = 0,
+      .count = 0,
+    },
+  };
+
+  return AZ_OK;
+}
+
+/**
+ * @brief The last policy of the pipeline an operation of a batch goes through to be authorized by
+ * the credential of the client. Instead of sending the request, it writes it as the next part of
+ * the body of the batch request.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_batch_write_operation(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_response;
+
+  az_storage_blobs_batch* const batch = (az_storage_blobs_batch*)ref_options;
+
+  az_http_method method = AZ_SPAN_EMPTY;
+  az_span url = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_http_request_get_method(ref_request, &method));
+  _az_RETURN_IF_FAILED(az_http_request_get_url(ref_request, &url));
+
+  // The request line only has the path and query of the URL.
+  int32_t const scheme_end = az_span_find(url, AZ_SPAN_FROM_STR("://"));
+  az_span const address = az_span_slice_to_end(url, scheme_end == -1 ? 0 : scheme_end + 3);
+  int32_t const path_start = az_span_find(address, AZ_SPAN_FROM_STR("/"));
+  if (path_start == -1)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  _az_span_builder builder;
+  _az_span_builder_init(
+      &builder, az_span_slice_to_end(batch->_internal.buffer, batch->_internal.length));
+
+  _az_span_builder_append(&builder, AZ_STORAGE_BLOBS_BATCH_PART_START);
+  _az_span_builder_append_u32(&builder, (uint32_t)batch->_internal.count);
+  _az_span_builder_append(&builder, AZ_SPAN_FROM_STR("\r\n\r\n"));
+  _az_span_builder_append(&builder, method);
+  _az_span_builder_append_u8(&builder, ' ');
+  _az_span_builder_append(&builder, az_span_slice_to_end(address, path_start));
+  _az_span_builder_append(&builder, AZ_SPAN_FROM_STR(" HTTP/1.1\r\n"));
+
+  int32_t const header_count = az_http_request_headers_count(ref_request);
+  for (int32_t i = 0; i < header_count; i++)
+  {
+    az_span name = AZ_SPAN_EMPTY;
+    az_span value = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(az_http_request_get_header(ref_request, i, &name, &value));
+    _az_span_builder_append(&builder, name);
+    _az_span_builder_append(&builder, AZ_SPAN_FROM_STR(": "));
+    _az_span_builder_append(&builder, value);
+    _az_span_builder_append(&builder, AZ_SPAN_FROM_STR("\r\n"));
+  }
+
+  _az_span_builder_append(&builder, AZ_SPAN_FROM_STR("\r\n"));
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
+
+  batch->_internal.length += _az_span_builder_length(&builder);
+  batch->_internal.count++;
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Adds an operation on the blob \p blob_name, which changes its tier to \p tier, or deletes
+ * it when \p tier is empty.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_batch_add(
+    az_storage_blobs_batch* ref_batch,
+    az_span blob_name,
+    az_span tier)
+{
+  if (ref_batch->_internal.count >= AZ_STORAGE_BLOBS_BATCH_MAX_COUNT)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  // The URL of the blob is the URL of the container, followed by its name, then by the query of
+  // the endpoint, such as a SAS token.
+  az_span const endpoint = ref_batch->_internal.client->_internal.endpoint;
+  int32_t const query_separator = az_span_find(endpoint, AZ_SPAN_FROM_STR("?"));
+  az_span container_url
+      = query_separator == -1 ? endpoint : az_span_slice(endpoint, 0, query_separator);
+  if (az_span_size(container_url) > 0
+      && az_span_ptr(container_url)[az_span_size(container_url) - 1] == '/')
+  {
+    container_url = az_span_slice(container_url, 0, az_span_size(container_url) - 1);
+  }
+
+  uint8_t url_stack_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_stack_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+  _az_span_builder url;
+  _az_span_builder_init(&url, AZ_SPAN_FROM_BUFFER(url_stack_buffer));
+  _az_span_builder_append(&url, container_url);
+  _az_span_builder_append_u8(&url, '/');
+  _az_span_builder_append(&url, blob_name);
+  if (query_separator != -1)
+  {
+    _az_span_builder_append(&url, az_span_slice_to_end(endpoint, query_separator));
+  }
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&url));
+
+  bool const is_delete = az_span_size(tier) == 0;
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(az_http_request_init(
+      &request,
+      &az_context_application,
+      is_delete ? az_http_method_delete() : az_http_method_put(),
+      AZ_SPAN_FROM_BUFFER(url_stack_buffer),
+      _az_span_builder_length(&url),
+      AZ_SPAN_FROM_BUFFER(headers_stack_buffer),
+      AZ_SPAN_EMPTY));
+
+  if (is_delete)
+  {
+    _az_RETURN_IF_FAILED(az_http_request_append_header(
+        &request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_DELETE_SNAPSHOTS, AZ_SPAN_FROM_STR("include")));
+  }
+  else
+  {
+    _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+        &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("tier"), true));
+    _az_RETURN_IF_FAILED(az_http_request_append_header(
+        &request, AZ_STORAGE_BLOBS_BLOB_HEADER_X_MS_ACCESS_TIER, tier));
+  }
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_HTTP_HEADER_CONTENT_LENGTH, AZ_SPAN_FROM_STR("0")));
+
+  // The credential of the client authorizes the operation, as it would a request it sends, then
+  // hands it to the policy which writes it to the batch.
+  _az_http_policy policies[] = {
+    {
+      ._internal = {
+        .process = _az_storage_blobs_batch_write_operation,
+        .options = ref_batch,
+      },
+    },
+    {
+      ._internal = {
+        .process = NULL,
+        .options = NULL,
+      },
+    },
+  };
+
+  az_http_response unused_response = { 0 };
+  return az_http_pipeline_policy_credential(
+      policies, ref_batch->_internal.client->_internal.credential, &request, &unused_response);
+}
+
+AZ_NODISCARD az_result
+az_storage_blobs_batch_add_delete(az_storage_blobs_batch* ref_batch, az_span blob_name)
+{
+  _az_PRECONDITION_NOT_NULL(ref_batch);
+  _az_PRECONDITION_VALID_SPAN(blob_name, 1, false);
+
+  return _az_storage_blobs_batch_add(ref_batch, blob_name, AZ_SPAN_EMPTY);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_batch_add_set_tier(
+    az_storage_blobs_batch* ref_batch,
+    az_span blob_name,
+    az_span tier)
+{
+  _az_PRECONDITION_NOT_NULL(ref_batch);
+  _az_PRECONDITION_VALID_SPAN(blob_name, 1, false);
+  _az_PRECONDITION_VALID_SPAN(tier, 1, false);
+
+  return _az_storage_blobs_batch_add(ref_batch, blob_name, tier);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_batch_submit(
+    az_storage_blobs_batch* ref_batch,
+    az_storage_blobs_batch_options const* options,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_batch);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+
+  if (ref_batch->_internal.count == 0)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  az_storage_blobs_batch_options const opt
+      = options == NULL ? az_storage_blobs_batch_options_default() : *options;
+
+  // The closing boundary isn't counted in the length of the batch, so that more operations can
+  // still be added after it, and the batch sent again.
+  az_span const remainder
+      = az_span_slice_to_end(ref_batch->_internal.buffer, ref_batch->_internal.length);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(AZ_STORAGE_BLOBS_BATCH_END));
+  az_span_copy(remainder, AZ_STORAGE_BLOBS_BATCH_END);
+  az_span const body = az_span_slice(
+      ref_batch->_internal.buffer,
+      0,
+      ref_batch->_internal.length + az_span_size(AZ_STORAGE_BLOBS_BATCH_END));
+
+  az_storage_blobs_blob_client* const client = ref_batch->_internal.client;
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      client,
+      &request,
+      opt.context,
+      az_http_method_post(),
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      body));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("restype"), AZ_SPAN_FROM_STR("container"), true));
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("batch"), true));
+
+  uint8_t content_length[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_content_length(
+      &request, AZ_SPAN_FROM_BUFFER(content_length), az_span_size(body)));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      &request, AZ_HTTP_HEADER_CONTENT_TYPE, AZ_STORAGE_BLOBS_BATCH_CONTENT_TYPE));
+
+  // start pipeline
+  return az_http_pipeline_process(&client->_internal.pipeline, &request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_batch_reader_init(
+    az_storage_blobs_batch_reader* out_reader,
+    az_http_response* response)
+{
+  _az_PRECONDITION_NOT_NULL(out_reader);
+  _az_PRECONDITION_NOT_NULL(response);
+
+  *out_reader = (az_storage_blobs_batch_reader){
+    ._internal = {
+      .boundary = AZ_SPAN_EMPTY,
+      .remaining = AZ_SPAN_EMPTY,
+    },
+  };
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(response, &status_line));
+
+  az_span header_name = AZ_SPAN_EMPTY;
+  az_span header_value = AZ_SPAN_EMPTY;
+  az_result result = AZ_OK;
+  while (az_result_succeeded(
+      result = az_http_response_get_next_header(response, &header_name, &header_value)))
+  {
+    if (az_span_is_content_equal_ignoring_case(header_name, AZ_HTTP_HEADER_CONTENT_TYPE))
+    {
+      // multipart/mixed; boundary=batchresponse_<GUID>
+      az_span const parameter = AZ_SPAN_FROM_STR("boundary=");
+      int32_t const index = az_span_find(header_value, parameter);
+      if (index != -1)
+      {
+        az_span boundary = az_span_slice_to_end(header_value, index + az_span_size(parameter));
+        int32_t const end = az_span_find(boundary, AZ_SPAN_FROM_STR(";"));
+        out_reader->_internal.boundary
+            = end == -1 ? boundary : az_span_slice(boundary, 0, end);
+      }
+    }
+  }
+
+  if (result != AZ_ERROR_HTTP_END_OF_HEADERS)
+  {
+    return result;
+  }
+
+  if (az_span_size(out_reader->_internal.boundary) == 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  return az_http_response_get_body(response, &out_reader->_internal.remaining);
+}
+
+/**
+ * @brief Finds the next delimiter, "--" followed by \p boundary, in \p source.
+ *
+ * @return The position of the boundary, after the "--", or -1 if there is none.
+ */
+static AZ_NODISCARD int32_t _az_storage_blobs_batch_find_boundary(az_span source, az_span boundary)
+{
+  uint8_t const* const ptr = az_span_ptr(source);
+  int32_t offset = 0;
+
+  while (true)
+  {
+    int32_t const index = az_span_find(az_span_slice_to_end(source, offset), boundary);
+    if (index == -1)
+    {
+      return -1;
+    }
+
+    int32_t const position = offset + index;
+    if (position >= 2 && ptr[position - 2] == '-' && ptr[position - 1] == '-')
+    {
+      return position;
+    }
+
+    offset = position + 1;
+  }
+}
+
+AZ_NODISCARD az_result az_storage_blobs_batch_reader_next(
+    az_storage_blobs_batch_reader* ref_reader,
+    az_storage_blobs_batch_result* out_result)
+{
+  _az_PRECONDITION_NOT_NULL(ref_reader);
+  _az_PRECONDITION_NOT_NULL(out_result);
+
+  az_span const boundary = ref_reader->_internal.boundary;
+  az_span const remaining = ref_reader->_internal.remaining;
+
+  // Each part starts with a delimiter line, and the last one is followed by "--boundary--".
+  int32_t const start = _az_storage_blobs_batch_find_boundary(remaining, boundary);
+  if (start == -1)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  az_span const after_boundary = az_span_slice_to_end(remaining, start + az_span_size(boundary));
+  if (az_span_size(after_boundary) >= 2 && az_span_ptr(after_boundary)[0] == '-'
+      && az_span_ptr(after_boundary)[1] == '-')
+  {
+    // The reader stays on the closing delimiter, so that reading again also ends.
+    return AZ_ERROR_STORAGE_END_OF_BATCH;
+  }
+
+  int32_t const line_end = az_span_find(after_boundary, AZ_SPAN_FROM_STR("\r\n"));
+  if (line_end == -1)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  az_span part = az_span_slice_to_end(after_boundary, line_end + 2);
+  int32_t const end = _az_storage_blobs_batch_find_boundary(part, boundary);
+  if (end == -1)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  // The next delimiter, and its "--", is left for the next call.
+  part = az_span_slice(part, 0, end - 2);
+
+  // The headers of the part, such as its Content-ID, then the HTTP response of the operation.
+  int32_t const part_headers_end = az_span_find(part, AZ_SPAN_FROM_STR("\r\n\r\n"));
+  if (part_headers_end == -1)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  out_result->content_id = -1;
+  az_span part_headers = az_span_slice(part, 0, part_headers_end + 2);
+  while (az_span_size(part_headers) > 0)
+  {
+    int32_t const header_end = az_span_find(part_headers, AZ_SPAN_FROM_STR("\r\n"));
+    az_span const header = az_span_slice(part_headers, 0, header_end);
+    part_headers = az_span_slice_to_end(part_headers, header_end + 2);
+
+    int32_t const colon = az_span_find(header, AZ_SPAN_FROM_STR(":"));
+    if (colon != -1
+        && az_span_is_content_equal_ignoring_case(
+            az_span_slice(header, 0, colon), AZ_HTTP_HEADER_CONTENT_ID))
+    {
+      az_span value = az_span_slice_to_end(header, colon + 1);
+      while (az_span_size(value) > 0 && az_span_ptr(value)[0] == ' ')
+      {
+        value = az_span_slice_to_end(value, 1);
+      }
+      _az_RETURN_IF_FAILED(az_span_atoi32(value, &out_result->content_id));
+    }
+  }
+
+  // The line break before the next delimiter belongs to it, rather than to the body.
+  az_span message = az_span_slice_to_end(part, part_headers_end + 4);
+  int32_t const message_headers_end = az_span_find(message, AZ_SPAN_FROM_STR("\r\n\r\n"));
+  int32_t const message_size = az_span_size(message);
+  if (message_headers_end != -1 && message_size > message_headers_end + 4 && message_size >= 2
+      && az_span_ptr(message)[message_size - 2] == '\r'
+      && az_span_ptr(message)[message_size - 1] == '\n')
+  {
+    message = az_span_slice(message, 0, message_size - 2);
+  }
+
+  ref_reader->_internal.remaining = az_span_slice_to_end(after_boundary, line_end + 2 + end - 2);
+
+  _az_RETURN_IF_FAILED(az_http_response_init(&out_result->response, message));
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(&out_result->response, &status_line));
+  out_result->status_code = status_line.status_code;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_enumerator_init(
+    az_storage_blobs_blob_enumerator* out_enumerator,
+    az_storage_blobs_blob_client* client,
+    az_span buffer,
+    az_storage_blobs_list_blobs_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_enumerator);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(buffer, 1, false);
+  _az_PRECONDITION(options == NULL || options->max_results >= 0);
+
+  *out_enumerator = (az_storage_blobs_blob_enumerator){
+    ._internal = {
+      .client = client,
+      .buffer = buffer,
+      .buffered_size = 0,
+      .marker = { 0 },
+      .marker_size = 0,
+      .page_complete = false,
+      .done = false,
+      .callback = NULL,
+      .user_context = NULL,
+      .options = options == NULL ? az_storage_blobs_list_blobs_options_default() : *options,
+    },
+  };
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Gets the text of \p element of \p properties, or an empty span if it isn't there.
+ */
+static AZ_NODISCARD az_span _az_storage_blobs_blob_item_get_property(
+    az_span properties,
+    az_span element)
+{
+  az_span text = AZ_SPAN_EMPTY;
+  az_result const result = _az_storage_blobs_xml_next_element(&properties, element, &text);
+  return az_result_succeeded(result) ? text : AZ_SPAN_EMPTY;
+}
+
+/**
+ * @brief Parses the content of a `<Blob>` element.
+ */
+static AZ_NODISCARD az_result
+_az_storage_blobs_blob_item_parse(az_span element, az_storage_blobs_blob_item* out_item)
+{
+  *out_item = (az_storage_blobs_blob_item){
+    .name = AZ_SPAN_EMPTY,
+    .etag = AZ_SPAN_EMPTY,
+    .last_modified = AZ_SPAN_EMPTY,
+    .blob_type = AZ_SPAN_EMPTY,
+    .access_tier = AZ_SPAN_EMPTY,
+    .content_length = -1,
+  };
+
+  az_span xml = element;
+  _az_RETURN_IF_FAILED(
+      _az_storage_blobs_xml_next_element(&xml, AZ_SPAN_FROM_STR("Name"), &out_item->name));
+
+  int32_t const properties_start = az_span_find(xml, AZ_STORAGE_BLOBS_LIST_PROPERTIES_START);
+  if (properties_start == -1)
+  {
+    return AZ_OK;
+  }
+
+  // The properties can come in any order, so each one is searched for from the start of them.
+  az_span properties = az_span_slice_to_end(xml, properties_start);
+  int32_t const properties_end = az_span_find(properties, AZ_STORAGE_BLOBS_LIST_PROPERTIES_END);
+  if (properties_end != -1)
+  {
+    properties = az_span_slice(properties, 0, properties_end);
+  }
+
+  out_item->etag = _az_storage_blobs_blob_item_get_property(properties, AZ_SPAN_FROM_STR("Etag"));
+  out_item->last_modified
+      = _az_storage_blobs_blob_item_get_property(properties, AZ_SPAN_FROM_STR("Last-Modified"));
+  out_item->blob_type
+      = _az_storage_blobs_blob_item_get_property(properties, AZ_SPAN_FROM_STR("BlobType"));
+  out_item->access_tier
+      = _az_storage_blobs_blob_item_get_property(properties, AZ_SPAN_FROM_STR("AccessTier"));
+
+  az_span const content_length
+      = _az_storage_blobs_blob_item_get_property(properties, AZ_SPAN_FROM_STR("Content-Length"));
+  if (az_span_size(content_length) > 0)
+  {
+    _az_RETURN_IF_FAILED(az_span_atoi64(content_length, &out_item->content_length));
+  }
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Reads the continuation marker at the start of \p xml, which is past `<NextMarker`.
+ *
+ * @return #AZ_ERROR_ITEM_NOT_FOUND if the element isn't complete yet.
+ */
+static AZ_NODISCARD az_result _az_storage_blobs_blob_enumerator_read_marker(
+    az_storage_blobs_blob_enumerator* ref_enumerator,
+    az_span xml)
+{
+  int32_t const tag_end = az_span_find(xml, AZ_SPAN_FROM_STR(">"));
+  if (tag_end == -1)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  // The last page has an empty marker, which the service writes as <NextMarker />.
+  az_span marker = AZ_SPAN_EMPTY;
+  if (tag_end == 0 || az_span_ptr(xml)[tag_end - 1] != '/')
+  {
+    az_span const text = az_span_slice_to_end(xml, tag_end + 1);
+    int32_t const text_end = az_span_find(text, AZ_SPAN_FROM_STR("</"));
+    if (text_end == -1)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+
+    marker = az_span_slice(text, 0, text_end);
+  }
+
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(
+      AZ_SPAN_FROM_BUFFER(ref_enumerator->_internal.marker), az_span_size(marker));
+  az_span_copy(AZ_SPAN_FROM_BUFFER(ref_enumerator->_internal.marker), marker);
+  ref_enumerator->_internal.marker_size = az_span_size(marker);
+  ref_enumerator->_internal.page_complete = true;
+  ref_enumerator->_internal.done = az_span_size(marker) == 0;
+  return AZ_OK;
+}
+
+/**
+ * @brief Gives the complete `<Blob>` elements of the receive buffer to the callback, then keeps
+ * only the bytes which may still be needed.
+ */
+static AZ_NODISCARD az_result
+_az_storage_blobs_blob_enumerator_parse(az_storage_blobs_blob_enumerator* ref_enumerator)
+{
+  az_span const data
+      = az_span_slice(ref_enumerator->_internal.buffer, 0, ref_enumerator->_internal.buffered_size);
+  int32_t consumed = 0;
+
+  while (true)
+  {
+    az_span const remaining = az_span_slice_to_end(data, consumed);
+    int32_t const end = az_span_find(remaining, AZ_STORAGE_BLOBS_LIST_BLOB_END);
+    if (end == -1)
+    {
+      break;
+    }
+
+    az_span element = az_span_slice(remaining, 0, end);
+    int32_t const start = az_span_find(element, AZ_STORAGE_BLOBS_LIST_BLOB_START);
+    if (start != -1)
+    {
+      element
+          = az_span_slice_to_end(element, start + az_span_size(AZ_STORAGE_BLOBS_LIST_BLOB_START));
+    }
+
+    az_storage_blobs_blob_item item = { 0 };
+    _az_RETURN_IF_FAILED(_az_storage_blobs_blob_item_parse(element, &item));
+    _az_RETURN_IF_FAILED(
+        ref_enumerator->_internal.callback(ref_enumerator->_internal.user_context, &item));
+
+    consumed += end + az_span_size(AZ_STORAGE_BLOBS_LIST_BLOB_END);
+  }
+
+  az_span const remaining = az_span_slice_to_end(data, consumed);
+  int32_t const marker_start = az_span_find(remaining, AZ_STORAGE_BLOBS_LIST_NEXT_MARKER);
+  int32_t const blob_start = az_span_find(remaining, AZ_STORAGE_BLOBS_LIST_BLOB_START);
+  if (marker_start != -1)
+  {
+    az_result const result = _az_storage_blobs_blob_enumerator_read_marker(
+        ref_enumerator,
+        az_span_slice_to_end(
+            remaining, marker_start + az_span_size(AZ_STORAGE_BLOBS_LIST_NEXT_MARKER)));
+    if (result != AZ_ERROR_ITEM_NOT_FOUND)
+    {
+      _az_RETURN_IF_FAILED(result);
+    }
+
+    // The rest of the page only closes the elements, so it isn't kept once the marker is read.
+    consumed = ref_enumerator->_internal.page_complete ? az_span_size(data)
+                                                       : consumed + marker_start;
+  }
+  else if (blob_start != -1)
+  {
+    consumed += blob_start;
+  }
+  else
+  {
+    // Only a tag which the chunk cut in two may still be needed.
+    int32_t tag_start = az_span_size(remaining);
+    while (tag_start > 0 && az_span_ptr(remaining)[tag_start - 1] != '<')
+    {
+      --tag_start;
+    }
+
+    consumed += tag_start > 0 ? tag_start - 1 : az_span_size(remaining);
+  }
+
+  az_span_copy(ref_enumerator->_internal.buffer, az_span_slice_to_end(data, consumed));
+  ref_enumerator->_internal.buffered_size -= consumed;
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_storage_blobs_blob_enumerator_sink(void* user_context, az_span body_chunk)
+{
+  az_storage_blobs_blob_enumerator* const enumerator
+      = (az_storage_blobs_blob_enumerator*)user_context;
+
+  while (az_span_size(body_chunk) > 0 && !enumerator->_internal.page_complete)
+  {
+    az_span const free_space
+        = az_span_slice_to_end(enumerator->_internal.buffer, enumerator->_internal.buffered_size);
+    if (az_span_size(free_space) == 0)
+    {
+      // An element doesn't fit in the receive buffer.
+      return AZ_ERROR_NOT_ENOUGH_SPACE;
+    }
+
+    int32_t const size = az_span_size(free_space) < az_span_size(body_chunk)
+        ? az_span_size(free_space)
+        : az_span_size(body_chunk);
+    az_span_copy(free_space, az_span_slice(body_chunk, 0, size));
+    enumerator->_internal.buffered_size += size;
+    body_chunk = az_span_slice_to_end(body_chunk, size);
+
+    _az_RETURN_IF_FAILED(_az_storage_blobs_blob_enumerator_parse(enumerator));
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_blob_enumerator_next_page(
+    az_storage_blobs_blob_enumerator* ref_enumerator,
+    az_storage_blobs_blob_item_fn callback,
+    void* user_context,
+    az_http_response* ref_response)
+{
+  _az_PRECONDITION_NOT_NULL(ref_enumerator);
+  _az_PRECONDITION_NOT_NULL(callback);
+  _az_PRECONDITION_NOT_NULL(ref_response);
+  _az_PRECONDITION(!ref_enumerator->_internal.done);
+
+  az_storage_blobs_list_blobs_options const* const opt = &ref_enumerator->_internal.options;
+  az_storage_blobs_blob_client* const client = ref_enumerator->_internal.client;
+  uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUFFER_SIZE];
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+
+  az_http_request request;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_request_init(
+      client,
+      &request,
+      opt->context,
+      az_http_method_get(),
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      AZ_SPAN_EMPTY));
+
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("restype"), AZ_SPAN_FROM_STR("container"), true));
+  _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("list"), true));
+
+  if (az_span_size(opt->prefix) > 0)
+  {
+    _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+        &request, AZ_SPAN_FROM_STR("prefix"), opt->prefix, false));
+  }
+
+  uint8_t max_results_buffer[_az_INT64_AS_STR_BUFFER_SIZE] = { 0 };
+  if (opt->max_results > 0)
+  {
+    az_span max_results = AZ_SPAN_FROM_BUFFER(max_results_buffer);
+    az_span remainder = AZ_SPAN_EMPTY;
+    _az_RETURN_IF_FAILED(az_span_i32toa(max_results, opt->max_results, &remainder));
+    max_results = az_span_slice(max_results, 0, _az_span_diff(remainder, max_results));
+    _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+        &request, AZ_SPAN_FROM_STR("maxresults"), max_results, true));
+  }
+
+  if (ref_enumerator->_internal.marker_size > 0)
+  {
+    _az_RETURN_IF_FAILED(az_http_request_set_query_parameter(
+        &request,
+        AZ_SPAN_FROM_STR("marker"),
+        az_span_create(ref_enumerator->_internal.marker, ref_enumerator->_internal.marker_size),
+        false));
+  }
+
+  ref_enumerator->_internal.buffered_size = 0;
+  ref_enumerator->_internal.page_complete = false;
+  ref_enumerator->_internal.callback = callback;
+  ref_enumerator->_internal.user_context = user_context;
+
+  // The sink is only set for this page, so the response can be used for other requests after it.
+  az_http_response_body_sink_fn const sink = ref_response->_internal.body_sink.callback;
+  void* const sink_user_context = ref_response->_internal.body_sink.user_context;
+  _az_RETURN_IF_FAILED(az_http_response_set_body_sink(
+      ref_response, _az_storage_blobs_blob_enumerator_sink, ref_enumerator));
+
+  // start pipeline
+  az_result const result
+      = az_http_pipeline_process(&client->_internal.pipeline, &request, ref_response);
+
+  ref_response->_internal.body_sink.callback = sink;
+  ref_response->_internal.body_sink.user_context = sink_user_context;
+  _az_RETURN_IF_FAILED(result);
+
+  az_http_response_status_line status_line = { 0 };
+  _az_RETURN_IF_FAILED(az_http_response_get_status_line(ref_response, &status_line));
+  if (status_line.status_code == AZ_HTTP_STATUS_CODE_OK
+      && !ref_enumerator->_internal.page_complete)
+  {
+    return AZ_ERROR_UNEXPECTED_END;
+  }
+
+  return AZ_OK;
+}
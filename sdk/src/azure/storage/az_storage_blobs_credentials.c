@@ -0,0 +1,719 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_credentials.h>
+#include <azure/core/az_crypto.h>
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_http_internal.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/core/internal/az_result_internal.h>
+#include <azure/core/internal/az_span_internal.h>
+#include <azure/storage/az_storage_blobs.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+static az_span const AZ_STORAGE_BLOBS_SHARED_KEY_SCHEME = AZ_SPAN_LITERAL_FROM_STR("SharedKey ");
+static az_span const AZ_STORAGE_BLOBS_HEADER_PREFIX_X_MS = AZ_SPAN_LITERAL_FROM_STR("x-ms-");
+static az_span const AZ_STORAGE_BLOBS_HEADER_X_MS_DATE = AZ_SPAN_LITERAL_FROM_STR("x-ms-date");
+static az_span const AZ_HTTP_HEADER_AUTHORIZATION = AZ_SPAN_LITERAL_FROM_STR("Authorization");
+static az_span const AZ_HTTP_HEADER_CONTENT_LENGTH = AZ_SPAN_LITERAL_FROM_STR("Content-Length");
+
+// The standard headers of the string-to-sign of the SharedKey scheme, in their order, after the
+// method. Content-Length is signed as it is sent, which is empty for an empty body.
+static az_span const _az_storage_blobs_signed_headers[] = {
+  AZ_SPAN_LITERAL_FROM_STR("Content-Encoding"),
+  AZ_SPAN_LITERAL_FROM_STR("Content-Language"),
+  AZ_SPAN_LITERAL_FROM_STR("Content-Length"),
+  AZ_SPAN_LITERAL_FROM_STR("Content-MD5"),
+  AZ_SPAN_LITERAL_FROM_STR("Content-Type"),
+  AZ_SPAN_LITERAL_FROM_STR("Date"),
+  AZ_SPAN_LITERAL_FROM_STR("If-Modified-Since"),
+  AZ_SPAN_LITERAL_FROM_STR("If-Match"),
+  AZ_SPAN_LITERAL_FROM_STR("If-None-Match"),
+  AZ_SPAN_LITERAL_FROM_STR("If-Unmodified-Since"),
+  AZ_SPAN_LITERAL_FROM_STR("Range"),
+};
+
+static AZ_NODISCARD uint8_t _az_storage_blobs_to_lower(uint8_t c)
+{
+  return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+// Compares ignoring case, so that names are sorted as their lowercase forms.
+static AZ_NODISCARD int32_t _az_storage_blobs_compare_ignoring_case(az_span span1, az_span span2)
+{
+  int32_t const size1 = az_span_size(span1);
+  int32_t const size2 = az_span_size(span2);
+  uint8_t const* const ptr1 = az_span_ptr(span1);
+  uint8_t const* const ptr2 = az_span_ptr(span2);
+
+  for (int32_t i = 0; i < size1 && i < size2; i++)
+  {
+    int32_t const difference = (int32_t)_az_storage_blobs_to_lower(ptr1[i])
+        - (int32_t)_az_storage_blobs_to_lower(ptr2[i]);
+    if (difference != 0)
+    {
+      return difference;
+    }
+  }
+
+  return size1 - size2;
+}
+
+// Items are sorted by name, then by index, so that items of the same name keep their order.
+static AZ_NODISCARD bool _az_storage_blobs_is_sorted_after(
+    az_span name,
+    int32_t index,
+    az_span other_name,
+    int32_t other_index)
+{
+  int32_t const comparison = _az_storage_blobs_compare_ignoring_case(name, other_name);
+  return comparison > 0 || (comparison == 0 && index > other_index);
+}
+
+static void _az_storage_blobs_append_lowercase(_az_span_builder* builder, az_span source)
+{
+  uint8_t const* const ptr = az_span_ptr(source);
+  for (int32_t i = 0; i < az_span_size(source); i++)
+  {
+    _az_span_builder_append_u8(builder, _az_storage_blobs_to_lower(ptr[i]));
+  }
+}
+
+static AZ_NODISCARD int32_t _az_storage_blobs_hex_value(uint8_t c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+
+  c = _az_storage_blobs_to_lower(c);
+  return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+static void _az_storage_blobs_append_url_decoded(_az_span_builder* builder, az_span source)
+{
+  uint8_t const* const ptr = az_span_ptr(source);
+  int32_t const size = az_span_size(source);
+
+  for (int32_t i = 0; i < size; i++)
+  {
+    int32_t const high = (ptr[i] == '%' && i + 2 < size) ? _az_storage_blobs_hex_value(ptr[i + 1])
+                                                          : -1;
+    int32_t const low = high >= 0 ? _az_storage_blobs_hex_value(ptr[i + 2]) : -1;
+    if (low >= 0)
+    {
+      _az_span_builder_append_u8(builder, (uint8_t)((high << 4) | low));
+      i += 2;
+    }
+    else
+    {
+      _az_span_builder_append_u8(builder, ptr[i]);
+    }
+  }
+}
+
+static AZ_NODISCARD az_span _az_storage_blobs_trim_spaces(az_span source)
+{
+  uint8_t const* const ptr = az_span_ptr(source);
+  int32_t start = 0;
+  int32_t end = az_span_size(source);
+
+  while (start < end && (ptr[start] == ' ' || ptr[start] == '\t'))
+  {
+    start++;
+  }
+
+  while (end > start && (ptr[end - 1] == ' ' || ptr[end - 1] == '\t'))
+  {
+    end--;
+  }
+
+  return az_span_slice(source, start, end);
+}
+
+static void _az_storage_blobs_format_two_digits(uint8_t* destination, int64_t value)
+{
+  destination[0] = (uint8_t)('0' + (value / 10) % 10);
+  destination[1] = (uint8_t)('0' + value % 10);
+}
+
+// Writes the time as the IMF-fixdate of RFC 7231, such as "Wed, 21 Oct 2015 07:28:00 GMT".
+static void _az_storage_blobs_format_date(int64_t unix_time, uint8_t* destination)
+{
+  static uint8_t const day_names[] = "ThuFriSatSunMonTueWed"; // 1970-01-01 was a Thursday.
+  static uint8_t const month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+  int64_t const seconds = unix_time < 0 ? 0 : unix_time;
+  int64_t const days = seconds / 86400;
+  int64_t const second_of_day = seconds % 86400;
+
+  // The civil date of a day count, from the algorithm of Howard Hinnant, in years starting on
+  // March 1st so that the leap day is the last day of the year.
+  int64_t const day_of_era_count = days + 719468;
+  int64_t const era = day_of_era_count / 146097;
+  int64_t const day_of_era = day_of_era_count - era * 146097;
+  int64_t const year_of_era
+      = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  int64_t const day_of_year
+      = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  int64_t const shifted_month = (5 * day_of_year + 2) / 153;
+  int64_t const day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  int64_t const month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  int64_t const year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+  for (int32_t i = 0; i < 3; i++)
+  {
+    destination[i] = day_names[(days % 7) * 3 + i];
+    destination[8 + i] = month_names[(month - 1) * 3 + i];
+  }
+
+  destination[3] = ',';
+  destination[4] = ' ';
+  _az_storage_blobs_format_two_digits(destination + 5, day);
+  destination[7] = ' ';
+  destination[11] = ' ';
+  _az_storage_blobs_format_two_digits(destination + 12, year / 100);
+  _az_storage_blobs_format_two_digits(destination + 14, year);
+  destination[16] = ' ';
+  _az_storage_blobs_format_two_digits(destination + 17, second_of_day / 3600);
+  destination[19] = ':';
+  _az_storage_blobs_format_two_digits(destination + 20, (second_of_day / 60) % 60);
+  destination[22] = ':';
+  _az_storage_blobs_format_two_digits(destination + 23, second_of_day % 60);
+  destination[25] = ' ';
+  destination[26] = 'G';
+  destination[27] = 'M';
+  destination[28] = 'T';
+}
+
+// Appends the x-ms-* headers, lowercase and sorted by name, each as "name:value\n".
+static AZ_NODISCARD az_result
+_az_storage_blobs_append_canonicalized_headers(_az_span_builder* builder, az_http_request* request)
+{
+  int32_t const header_count = az_http_request_headers_count(request);
+  az_span previous_name = AZ_SPAN_EMPTY;
+  int32_t previous_index = -1;
+
+  while (true)
+  {
+    int32_t next_index = -1;
+    az_span next_name = AZ_SPAN_EMPTY;
+    az_span next_value = AZ_SPAN_EMPTY;
+
+    for (int32_t i = 0; i < header_count; i++)
+    {
+      az_span name = AZ_SPAN_EMPTY;
+      az_span value = AZ_SPAN_EMPTY;
+      _az_RETURN_IF_FAILED(az_http_request_get_header(request, i, &name, &value));
+
+      if (az_span_size(name) < az_span_size(AZ_STORAGE_BLOBS_HEADER_PREFIX_X_MS)
+          || !az_span_is_content_equal_ignoring_case(
+              az_span_slice(name, 0, az_span_size(AZ_STORAGE_BLOBS_HEADER_PREFIX_X_MS)),
+              AZ_STORAGE_BLOBS_HEADER_PREFIX_X_MS))
+      {
+        continue;
+      }
+
+      if (_az_storage_blobs_is_sorted_after(name, i, previous_name, previous_index)
+          && (next_index == -1
+              || _az_storage_blobs_is_sorted_after(next_name, next_index, name, i)))
+      {
+        next_index = i;
+        next_name = name;
+        next_value = value;
+      }
+    }
+
+    if (next_index == -1)
+    {
+      return AZ_OK;
+    }
+
+    _az_storage_blobs_append_lowercase(builder, next_name);
+    _az_span_builder_append_u8(builder, ':');
+    _az_span_builder_append(builder, _az_storage_blobs_trim_spaces(next_value));
+    _az_span_builder_append_u8(builder, '\n');
+
+    previous_name = next_name;
+    previous_index = next_index;
+  }
+}
+
+// Appends "/account/path", then each query parameter, sorted by name, as "\nname:value", with
+// the values of a repeated name separated by commas.
+static void _az_storage_blobs_append_canonicalized_resource(
+    _az_span_builder* builder,
+    az_span account_name,
+    az_span url)
+{
+  int32_t const scheme_end = az_span_find(url, AZ_SPAN_FROM_STR("://"));
+  int32_t const host_start = scheme_end == -1 ? 0 : scheme_end + 3;
+  int32_t const query_separator = az_span_find(url, AZ_SPAN_FROM_STR("?"));
+  az_span const address
+      = az_span_slice(url, host_start, query_separator == -1 ? az_span_size(url) : query_separator);
+  int32_t const path_start = az_span_find(address, AZ_SPAN_FROM_STR("/"));
+
+  _az_span_builder_append_u8(builder, '/');
+  _az_span_builder_append(builder, account_name);
+  if (path_start == -1)
+  {
+    _az_span_builder_append_u8(builder, '/');
+  }
+  else
+  {
+    _az_span_builder_append(builder, az_span_slice_to_end(address, path_start));
+  }
+
+  if (query_separator == -1)
+  {
+    return;
+  }
+
+  az_span const query = az_span_slice_to_end(url, query_separator + 1);
+  int32_t const query_size = az_span_size(query);
+  az_span previous_name = AZ_SPAN_EMPTY;
+  int32_t previous_offset = -1;
+
+  while (true)
+  {
+    int32_t next_offset = -1;
+    az_span next_name = AZ_SPAN_EMPTY;
+    az_span next_value = AZ_SPAN_EMPTY;
+
+    int32_t offset = 0;
+    while (offset < query_size)
+    {
+      az_span const remainder = az_span_slice_to_end(query, offset);
+      int32_t parameter_size = az_span_find(remainder, AZ_SPAN_FROM_STR("&"));
+      if (parameter_size == -1)
+      {
+        parameter_size = az_span_size(remainder);
+      }
+
+      az_span const parameter = az_span_slice(remainder, 0, parameter_size);
+      int32_t const equal_sign = az_span_find(parameter, AZ_SPAN_FROM_STR("="));
+      az_span const name
+          = equal_sign == -1 ? parameter : az_span_slice(parameter, 0, equal_sign);
+
+      if (az_span_size(name) > 0
+          && _az_storage_blobs_is_sorted_after(name, offset, previous_name, previous_offset)
+          && (next_offset == -1
+              || _az_storage_blobs_is_sorted_after(next_name, next_offset, name, offset)))
+      {
+        next_offset = offset;
+        next_name = name;
+        next_value
+            = equal_sign == -1 ? AZ_SPAN_EMPTY : az_span_slice_to_end(parameter, equal_sign + 1);
+      }
+
+      offset += parameter_size + 1;
+    }
+
+    if (next_offset == -1)
+    {
+      return;
+    }
+
+    if (previous_offset != -1
+        && _az_storage_blobs_compare_ignoring_case(next_name, previous_name) == 0)
+    {
+      _az_span_builder_append_u8(builder, ',');
+    }
+    else
+    {
+      _az_span_builder_append_u8(builder, '\n');
+      _az_storage_blobs_append_lowercase(builder, next_name);
+      _az_span_builder_append_u8(builder, ':');
+    }
+
+    _az_storage_blobs_append_url_decoded(builder, next_value);
+
+    previous_name = next_name;
+    previous_offset = next_offset;
+  }
+}
+
+// Writes the Base64 of the HMAC-SHA256 of the string-to-sign, with the account key.
+static AZ_NODISCARD az_result _az_storage_blobs_sign(
+    az_storage_blobs_shared_key_credential* credential,
+    az_span string_to_sign,
+    az_span destination,
+    az_span* out_signature)
+{
+  uint8_t hmac[AZ_CRYPTO_SHA256_SIZE];
+  _az_RETURN_IF_FAILED(az_crypto_hmac_sha256(
+      az_span_create(credential->_internal.key, credential->_internal.key_size),
+      string_to_sign,
+      AZ_SPAN_FROM_BUFFER(hmac)));
+
+  int32_t written = 0;
+  _az_RETURN_IF_FAILED(az_base64_encode(destination, AZ_SPAN_FROM_BUFFER(hmac), &written));
+  *out_signature = az_span_slice(destination, 0, written);
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result _az_storage_blobs_shared_key_credential_apply(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_storage_blobs_shared_key_credential* const credential
+      = (az_storage_blobs_shared_key_credential*)ref_options;
+
+  // The credential is only read, so that requests sent at the same time from several threads can
+  // share it. The values of each request are built on the stack instead, and stay valid while the
+  // following policies send it.
+  uint8_t date_buffer[_az_STORAGE_BLOBS_RFC1123_DATE_SIZE];
+  _az_storage_blobs_format_date(credential->_internal.get_time(), date_buffer);
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      ref_request, AZ_STORAGE_BLOBS_HEADER_X_MS_DATE, AZ_SPAN_FROM_BUFFER(date_buffer)));
+
+  uint8_t string_to_sign_buffer[_az_STORAGE_BLOBS_STRING_TO_SIGN_MAX_SIZE];
+  _az_span_builder builder;
+  _az_span_builder_init(&builder, AZ_SPAN_FROM_BUFFER(string_to_sign_buffer));
+
+  az_http_method method = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_http_request_get_method(ref_request, &method));
+  _az_span_builder_append(&builder, method);
+  _az_span_builder_append_u8(&builder, '\n');
+
+  for (size_t i = 0; i < sizeof(_az_storage_blobs_signed_headers) / sizeof(az_span); i++)
+  {
+    az_span value = AZ_SPAN_EMPTY;
+    az_result const found = az_http_request_get_header_by_name(
+        ref_request, _az_storage_blobs_signed_headers[i], &value);
+
+    if (az_span_is_content_equal(
+            _az_storage_blobs_signed_headers[i], AZ_HTTP_HEADER_CONTENT_LENGTH))
+    {
+      if (az_result_failed(found))
+      {
+        int64_t const body_size = az_http_request_get_body_size(ref_request);
+        if (body_size > 0)
+        {
+          _az_span_builder_append_u64(&builder, (uint64_t)body_size);
+        }
+      }
+      else if (!az_span_is_content_equal(value, AZ_SPAN_FROM_STR("0")))
+      {
+        _az_span_builder_append(&builder, value);
+      }
+    }
+    else if (az_result_succeeded(found))
+    {
+      _az_span_builder_append(&builder, value);
+    }
+
+    _az_span_builder_append_u8(&builder, '\n');
+  }
+
+  _az_RETURN_IF_FAILED(_az_storage_blobs_append_canonicalized_headers(&builder, ref_request));
+
+  az_span url = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(az_http_request_get_url(ref_request, &url));
+  _az_storage_blobs_append_canonicalized_resource(
+      &builder, credential->_internal.account_name, url);
+
+  _az_RETURN_IF_FAILED(_az_span_builder_result(&builder));
+
+  uint8_t authorization_buffer[_az_STORAGE_BLOBS_SHARED_KEY_AUTHORIZATION_SIZE];
+  az_span const authorization = AZ_SPAN_FROM_BUFFER(authorization_buffer);
+  int32_t const prefix_size = credential->_internal.authorization_prefix_size;
+  az_span_copy(
+      authorization,
+      az_span_create(credential->_internal.authorization_buffer, prefix_size));
+  az_span signature = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_sign(
+      credential,
+      _az_span_builder_get_span(&builder),
+      az_span_slice_to_end(authorization, prefix_size),
+      &signature));
+
+  _az_RETURN_IF_FAILED(az_http_request_append_header(
+      ref_request,
+      AZ_HTTP_HEADER_AUTHORIZATION,
+      az_span_slice(authorization, 0, prefix_size + az_span_size(signature))));
+
+  return _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CREDENTIAL, ref_request, ref_response);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_shared_key_credential_init(
+    az_storage_blobs_shared_key_credential* out_credential,
+    az_span account_name,
+    az_span account_key,
+    az_span signing_buffer,
+    az_storage_blobs_get_time_fn get_time)
+{
+  _az_PRECONDITION_NOT_NULL(out_credential);
+  _az_PRECONDITION_VALID_SPAN(account_name, 1, false);
+  _az_PRECONDITION_VALID_SPAN(account_key, 1, false);
+  _az_PRECONDITION_VALID_SPAN(signing_buffer, 1, false);
+  _az_PRECONDITION_NOT_NULL(get_time);
+
+  if (az_span_size(account_name) > _az_STORAGE_BLOBS_ACCOUNT_NAME_MAX_SIZE)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  *out_credential = (az_storage_blobs_shared_key_credential){
+    .credential = {
+      ._internal = {
+        .apply_credential_policy = _az_storage_blobs_shared_key_credential_apply,
+        .set_scopes = NULL,
+      },
+    },
+    ._internal = {
+      .key_size = 0,
+      .authorization_prefix_size = 0,
+      .account_name = AZ_SPAN_EMPTY,
+      .signing_buffer = signing_buffer,
+      .get_time = get_time,
+    },
+  };
+
+  // The key is decoded into the authorization buffer first, since the largest key can decode to
+  // more bytes than it has, before its padding is taken off.
+  az_span const authorization = AZ_SPAN_FROM_BUFFER(out_credential->_internal.authorization_buffer);
+  int32_t key_size = 0;
+  _az_RETURN_IF_FAILED(az_base64_decode(authorization, account_key, &key_size));
+  if (key_size > AZ_STORAGE_BLOBS_ACCOUNT_KEY_MAX_SIZE)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  az_span_copy(
+      AZ_SPAN_FROM_BUFFER(out_credential->_internal.key),
+      az_span_slice(authorization, 0, key_size));
+  out_credential->_internal.key_size = key_size;
+
+  int32_t const scheme_size = az_span_size(AZ_STORAGE_BLOBS_SHARED_KEY_SCHEME);
+  az_span remainder = az_span_copy(authorization, AZ_STORAGE_BLOBS_SHARED_KEY_SCHEME);
+  remainder = az_span_copy(remainder, account_name);
+  remainder = az_span_copy_u8(remainder, ':');
+  out_credential->_internal.account_name
+      = az_span_slice(authorization, scheme_size, scheme_size + az_span_size(account_name));
+  out_credential->_internal.authorization_prefix_size = _az_span_diff(remainder, authorization);
+
+  return AZ_OK;
+}
+
+// Appends "&name=value", with the value URL-encoded, unless the value is empty.
+static void _az_storage_blobs_append_sas_parameter(
+    _az_span_builder* builder,
+    az_span name,
+    az_span value)
+{
+  if (az_span_size(value) > 0)
+  {
+    if (_az_span_builder_length(builder) > 0)
+    {
+      _az_span_builder_append_u8(builder, '&');
+    }
+
+    _az_span_builder_append(builder, name);
+    _az_span_builder_append_u8(builder, '=');
+    _az_span_builder_append_url_encoded(builder, value);
+  }
+}
+
+static void _az_storage_blobs_append_line(_az_span_builder* builder, az_span value)
+{
+  _az_span_builder_append(builder, value);
+  _az_span_builder_append_u8(builder, '\n');
+}
+
+// Signs the string-to-sign which is in the signing buffer, and appends the signature to the token.
+static AZ_NODISCARD az_result _az_storage_blobs_finish_sas(
+    az_storage_blobs_shared_key_credential* credential,
+    _az_span_builder* string_to_sign,
+    _az_span_builder* token,
+    az_span* out_token)
+{
+  _az_RETURN_IF_FAILED(_az_span_builder_result(string_to_sign));
+
+  uint8_t signature_buffer[_az_STORAGE_BLOBS_SIGNATURE_BASE64_SIZE];
+  az_span signature = AZ_SPAN_EMPTY;
+  _az_RETURN_IF_FAILED(_az_storage_blobs_sign(
+      credential,
+      _az_span_builder_get_span(string_to_sign),
+      AZ_SPAN_FROM_BUFFER(signature_buffer),
+      &signature));
+
+  _az_storage_blobs_append_sas_parameter(token, AZ_SPAN_FROM_STR("sig"), signature);
+  _az_RETURN_IF_FAILED(_az_span_builder_result(token));
+
+  *out_token = _az_span_builder_get_span(token);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_storage_blobs_get_account_sas(
+    az_storage_blobs_shared_key_credential* credential,
+    az_storage_blobs_sas_options const* options,
+    az_span resource_types,
+    az_span destination,
+    az_span* out_token)
+{
+  _az_PRECONDITION_NOT_NULL(credential);
+  _az_PRECONDITION_NOT_NULL(options);
+  _az_PRECONDITION_VALID_SPAN(options->permissions, 1, false);
+  _az_PRECONDITION_VALID_SPAN(options->expiry, 1, false);
+  _az_PRECONDITION_VALID_SPAN(resource_types, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_token);
+
+  az_span const services = AZ_SPAN_FROM_STR("b");
+
+  _az_span_builder string_to_sign;
+  _az_span_builder_init(&string_to_sign, credential->_internal.signing_buffer);
+  _az_storage_blobs_append_line(&string_to_sign, credential->_internal.account_name);
+  _az_storage_blobs_append_line(&string_to_sign, options->permissions);
+  _az_storage_blobs_append_line(&string_to_sign, services);
+  _az_storage_blobs_append_line(&string_to_sign, resource_types);
+  _az_storage_blobs_append_line(&string_to_sign, options->start);
+  _az_storage_blobs_append_line(&string_to_sign, options->expiry);
+  _az_storage_blobs_append_line(&string_to_sign, options->ip_range);
+  _az_storage_blobs_append_line(&string_to_sign, options->protocol);
+  _az_storage_blobs_append_line(&string_to_sign, AZ_STORAGE_API_VERSION);
+
+  _az_span_builder token;
+  _az_span_builder_init(&token, destination);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sv"), AZ_STORAGE_API_VERSION);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("ss"), services);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("srt"), resource_types);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sp"), options->permissions);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("st"), options->start);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("se"), options->expiry);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sip"), options->ip_range);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("spr"), options->protocol);
+
+  return _az_storage_blobs_finish_sas(credential, &string_to_sign, &token, out_token);
+}
+
+AZ_NODISCARD az_result az_storage_blobs_get_blob_sas(
+    az_storage_blobs_shared_key_credential* credential,
+    az_storage_blobs_sas_options const* options,
+    az_span container_name,
+    az_span blob_name,
+    az_span destination,
+    az_span* out_token)
+{
+  _az_PRECONDITION_NOT_NULL(credential);
+  _az_PRECONDITION_NOT_NULL(options);
+  _az_PRECONDITION_VALID_SPAN(options->permissions, 1, false);
+  _az_PRECONDITION_VALID_SPAN(options->expiry, 1, false);
+  _az_PRECONDITION_VALID_SPAN(container_name, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_token);
+
+  bool const is_blob = az_span_size(blob_name) > 0;
+  az_span const resource = is_blob ? AZ_SPAN_FROM_STR("b") : AZ_SPAN_FROM_STR("c");
+
+  // The string-to-sign of version 2018-11-09 and later, without a stored access policy, snapshot
+  // or response header overrides.
+  _az_span_builder string_to_sign;
+  _az_span_builder_init(&string_to_sign, credential->_internal.signing_buffer);
+  _az_storage_blobs_append_line(&string_to_sign, options->permissions);
+  _az_storage_blobs_append_line(&string_to_sign, options->start);
+  _az_storage_blobs_append_line(&string_to_sign, options->expiry);
+  _az_span_builder_append(&string_to_sign, AZ_SPAN_FROM_STR("/blob/"));
+  _az_span_builder_append(&string_to_sign, credential->_internal.account_name);
+  _az_span_builder_append_u8(&string_to_sign, '/');
+  _az_span_builder_append(&string_to_sign, container_name);
+  if (is_blob)
+  {
+    _az_span_builder_append_u8(&string_to_sign, '/');
+    _az_span_builder_append(&string_to_sign, blob_name);
+  }
+  _az_span_builder_append_u8(&string_to_sign, '\n');
+  _az_storage_blobs_append_line(&string_to_sign, AZ_SPAN_EMPTY); // signed identifier
+  _az_storage_blobs_append_line(&string_to_sign, options->ip_range);
+  _az_storage_blobs_append_line(&string_to_sign, options->protocol);
+  _az_storage_blobs_append_line(&string_to_sign, AZ_STORAGE_API_VERSION);
+  _az_storage_blobs_append_line(&string_to_sign, resource);
+  // The snapshot time and the five response headers are empty, with no line break after the last.
+  _az_span_builder_append(&string_to_sign, AZ_SPAN_FROM_STR("\n\n\n\n\n"));
+
+  _az_span_builder token;
+  _az_span_builder_init(&token, destination);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sv"), AZ_STORAGE_API_VERSION);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sr"), resource);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sp"), options->permissions);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("st"), options->start);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("se"), options->expiry);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("sip"), options->ip_range);
+  _az_storage_blobs_append_sas_parameter(&token, AZ_SPAN_FROM_STR("spr"), options->protocol);
+
+  return _az_storage_blobs_finish_sas(credential, &string_to_sign, &token, out_token);
+}
+
+static AZ_NODISCARD az_result _az_storage_blobs_sas_credential_apply(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  az_storage_blobs_sas_credential const* const credential
+      = (az_storage_blobs_sas_credential const*)ref_options;
+  az_span const token = credential->_internal.token;
+
+  if (az_span_size(token) == 0)
+  {
+    return _az_http_pipeline_nextpolicy_expecting(
+        ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CREDENTIAL, ref_request, ref_response);
+  }
+
+  // The token is appended as it is, already URL-encoded, and removed again once the request is
+  // sent, so that it isn't appended twice when the request is retried.
+  int32_t const url_length = ref_request->_internal.url_length;
+  int32_t const query_start = ref_request->_internal.query_start;
+  az_span remainder = az_span_slice_to_end(ref_request->_internal.url, url_length);
+  _az_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(token) + 1);
+
+  remainder = az_span_copy_u8(remainder, query_start == 0 ? '?' : '&');
+  az_span_copy(remainder, token);
+  ref_request->_internal.url_length += az_span_size(token) + 1;
+  if (query_start == 0)
+  {
+    ref_request->_internal.query_start = url_length + 1;
+  }
+
+  az_result const result = _az_http_pipeline_nextpolicy_expecting(
+      ref_policies, _az_HTTP_PIPELINE_POLICY_AFTER_CREDENTIAL, ref_request, ref_response);
+
+  ref_request->_internal.url_length = url_length;
+  ref_request->_internal.query_start = query_start;
+
+  return result;
+}
+
+AZ_NODISCARD az_result
+az_storage_blobs_sas_credential_init(az_storage_blobs_sas_credential* out_credential, az_span token)
+{
+  _az_PRECONDITION_NOT_NULL(out_credential);
+  _az_PRECONDITION_VALID_SPAN(token, 0, true);
+
+  if (az_span_size(token) > 0 && az_span_ptr(token)[0] == '?')
+  {
+    token = az_span_slice_to_end(token, 1);
+  }
+
+  *out_credential = (az_storage_blobs_sas_credential){
+    .credential = {
+      ._internal = {
+        .apply_credential_policy = _az_storage_blobs_sas_credential_apply,
+        .set_scopes = NULL,
+      },
+    },
+    ._internal = {
+      .token = token,
+    },
+  };
+
+  return AZ_OK;
+}
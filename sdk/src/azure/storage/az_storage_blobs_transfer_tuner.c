@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <azure/core/az_http.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/storage/az_storage_blobs.h>
+
+#include <stdint.h>
+
+#include <azure/core/_az_cfg.h>
+
+static void _az_storage_blobs_transfer_tuner_start_round(az_storage_blobs_transfer_tuner* ref_tuner)
+{
+  ref_tuner->_internal.round_count = 0;
+  ref_tuner->_internal.round_size = 0;
+  ref_tuner->_internal.round_start_msec = 0;
+  ref_tuner->_internal.round_end_msec = 0;
+}
+
+void az_storage_blobs_transfer_tuner_init(
+    az_storage_blobs_transfer_tuner* out_tuner,
+    az_storage_blobs_transfer_tuner_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(out_tuner);
+
+  az_storage_blobs_transfer_tuner_options const opt
+      = options == NULL ? az_storage_blobs_transfer_tuner_options_default() : *options;
+
+  _az_PRECONDITION(0 < opt.min_block_size && opt.min_block_size <= opt.max_block_size);
+  _az_PRECONDITION(0 < opt.min_concurrency && opt.min_concurrency <= opt.max_concurrency);
+  _az_PRECONDITION(opt.target_block_msec > 0);
+
+  out_tuner->_internal.options = opt;
+  out_tuner->_internal.block_size = opt.min_block_size;
+  out_tuner->_internal.concurrency = opt.min_concurrency;
+  out_tuner->_internal.previous_round_rate = 0;
+  _az_storage_blobs_transfer_tuner_start_round(out_tuner);
+}
+
+void az_storage_blobs_transfer_tuner_record(
+    az_storage_blobs_transfer_tuner* ref_tuner,
+    int64_t block_size,
+    int64_t start_msec,
+    int64_t end_msec,
+    az_http_status_code status_code)
+{
+  _az_PRECONDITION_NOT_NULL(ref_tuner);
+  _az_PRECONDITION(block_size >= 0);
+
+  az_storage_blobs_transfer_tuner_options const* const options = &ref_tuner->_internal.options;
+
+  // The service throttles with 503 Server Busy or 500 Operation Timed Out. The rate of the round is
+  // forgotten, as it was measured while the service was overloaded.
+  if (status_code == AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE
+      || status_code == AZ_HTTP_STATUS_CODE_INTERNAL_SERVER_ERROR)
+  {
+    int32_t const halved = ref_tuner->_internal.concurrency / 2;
+    ref_tuner->_internal.concurrency
+        = halved < options->min_concurrency ? options->min_concurrency : halved;
+    ref_tuner->_internal.previous_round_rate = 0;
+    _az_storage_blobs_transfer_tuner_start_round(ref_tuner);
+    return;
+  }
+
+  if (status_code < 200 || status_code >= 300)
+  {
+    return;
+  }
+
+  int64_t const elapsed_msec = end_msec > start_msec ? end_msec - start_msec : 1;
+
+  // Blocks which take much less than the target are mostly the round trip of their request.
+  if (elapsed_msec * 2 < options->target_block_msec)
+  {
+    int64_t const grown = (int64_t)ref_tuner->_internal.block_size * 2;
+    ref_tuner->_internal.block_size
+        = grown > options->max_block_size ? options->max_block_size : (int32_t)grown;
+  }
+  else if (elapsed_msec > (int64_t)options->target_block_msec * 2)
+  {
+    int32_t const shrunk = ref_tuner->_internal.block_size / 2;
+    ref_tuner->_internal.block_size
+        = shrunk < options->min_block_size ? options->min_block_size : shrunk;
+  }
+
+  if (ref_tuner->_internal.round_count == 0 || start_msec < ref_tuner->_internal.round_start_msec)
+  {
+    ref_tuner->_internal.round_start_msec = start_msec;
+  }
+
+  if (ref_tuner->_internal.round_count == 0 || end_msec > ref_tuner->_internal.round_end_msec)
+  {
+    ref_tuner->_internal.round_end_msec = end_msec;
+  }
+
+  ref_tuner->_internal.round_size += block_size;
+  ++ref_tuner->_internal.round_count;
+  if (ref_tuner->_internal.round_count < ref_tuner->_internal.concurrency)
+  {
+    return;
+  }
+
+  // A round is as many blocks as are in flight, so its rate is the throughput of the transfer.
+  int64_t const round_msec
+      = ref_tuner->_internal.round_end_msec - ref_tuner->_internal.round_start_msec;
+  int64_t const rate = ref_tuner->_internal.round_size * 1000 / (round_msec > 0 ? round_msec : 1);
+  int64_t const previous_rate = ref_tuner->_internal.previous_round_rate;
+  if (rate >= previous_rate + previous_rate / 10)
+  {
+    if (ref_tuner->_internal.concurrency < options->max_concurrency)
+    {
+      ++ref_tuner->_internal.concurrency;
+    }
+  }
+  else if (rate < previous_rate - previous_rate / 10)
+  {
+    if (ref_tuner->_internal.concurrency > options->min_concurrency)
+    {
+      --ref_tuner->_internal.concurrency;
+    }
+  }
+
+  ref_tuner->_internal.previous_round_rate = rate;
+  _az_storage_blobs_transfer_tuner_start_round(ref_tuner);
+}
@@ -0,0 +1,258 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "test_az_json_codegen.h"
+
+#include <azure/core/az_json.h>
+#include <azure/core/az_result.h>
+#include <azure/core/az_span.h>
+
+#include <device_report.h>
+#include <thermostat.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_DEVICE_REPORT_JSON \
+  "{\"deviceId\":\"dev-1\",\"uptime\":9007199254740993,\"online\":true," \
+  "\"firmware\":{\"version\":\"1.2.3\",\"build\":42}," \
+  "\"readings\":[1.5,-2,3e2],\"sensors\":[{\"name\":\"a\",\"rate\":10},{\"rate\":20}]," \
+  "\"tags\":[\"x\",\"yy\"],\"rack\":7,\"rank\":8}"
+
+// The doubles compared are exactly representable.
+static bool _is_double_equal(double actual, double expected)
+{
+  return !(actual < expected) && !(actual > expected);
+}
+
+static void test_json_codegen_dtdl_parse(void** state)
+{
+  (void)state;
+
+  // Unknown properties of any kind are skipped, and escaped names are matched by their value.
+  az_span const json = AZ_SPAN_FROM_STR(
+      " {\"unknown\":{\"temperature\":[1,{\"a\":2}]},\"temperature\":21.5,"
+      "\"targ\\u0065tTemperature\":23,\"serialNumber\":\"SN\\t1\",\"mode\":2,\"getMaxMinReport\":1}"
+      " ");
+
+  thermostat value;
+  assert_int_equal(thermostat_parse(json, &value), AZ_OK);
+  assert_true(value.has_temperature);
+  assert_true(_is_double_equal(value.temperature, 21.5));
+  assert_true(value.has_target_temperature);
+  assert_true(_is_double_equal(value.target_temperature, 23));
+  assert_false(value.has_max_temp_since_last_reboot);
+  assert_true(value.has_serial_number);
+  assert_string_equal(value.serial_number, "SN\t1");
+  assert_true(value.has_mode);
+  assert_int_equal(value.mode, 2);
+
+  // The fields which aren't in the JSON are cleared.
+  assert_int_equal(thermostat_parse(AZ_SPAN_FROM_STR("{}"), &value), AZ_OK);
+  assert_false(value.has_temperature);
+  assert_false(value.has_serial_number);
+
+  // The types of the values are checked, and nothing but whitespace may follow the object.
+  assert_int_equal(
+      thermostat_parse(AZ_SPAN_FROM_STR("{\"mode\":\"heat\"}"), &value),
+      AZ_ERROR_JSON_INVALID_STATE);
+  assert_int_equal(
+      thermostat_parse(AZ_SPAN_FROM_STR("{\"mode\":1.5}"), &value), AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      thermostat_parse(AZ_SPAN_FROM_STR("[\"mode\"]"), &value), AZ_ERROR_JSON_INVALID_STATE);
+  assert_int_equal(
+      thermostat_parse(AZ_SPAN_FROM_STR("{\"mode\":1}}"), &value), AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      thermostat_parse(AZ_SPAN_FROM_STR("{\"mode\":1"), &value), AZ_ERROR_UNEXPECTED_END);
+}
+
+static void test_json_codegen_dtdl_serialize(void** state)
+{
+  (void)state;
+
+  thermostat value = { 0 };
+  value.temperature = 21.5;
+  value.has_temperature = true;
+  value.max_temp_since_last_reboot = 30;
+  value.has_max_temp_since_last_reboot = true;
+  strcpy(value.serial_number, "S\"N");
+  value.has_serial_number = true;
+
+  uint8_t buffer[128];
+  az_span json = AZ_SPAN_EMPTY;
+  assert_int_equal(thermostat_serialize(&value, AZ_SPAN_FROM_BUFFER(buffer), &json), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      json,
+      AZ_SPAN_FROM_STR(
+          "{\"temperature\":21.5,\"maxTempSinceLastReboot\":30,\"serialNumber\":\"S\\\"N\"}")));
+
+  thermostat parsed;
+  assert_int_equal(thermostat_parse(json, &parsed), AZ_OK);
+  assert_true(_is_double_equal(parsed.temperature, 21.5));
+  assert_true(_is_double_equal(parsed.max_temp_since_last_reboot, 30));
+  assert_string_equal(parsed.serial_number, "S\"N");
+  assert_false(parsed.has_target_temperature);
+  assert_false(parsed.has_mode);
+
+  assert_int_equal(
+      thermostat_serialize(&value, az_span_create(buffer, 16), &json),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void _test_json_codegen_check_device_report(device_report const* value)
+{
+  assert_true(value->has_device_id);
+  assert_string_equal(value->device_id, "dev-1");
+  assert_true(value->has_uptime);
+  assert_true(value->uptime == 9007199254740993LL);
+  assert_true(value->has_online);
+  assert_true(value->online);
+
+  assert_true(value->has_firmware);
+  assert_string_equal(value->firmware.version, "1.2.3");
+  assert_true(value->firmware.has_build);
+  assert_int_equal(value->firmware.build, 42);
+
+  assert_true(value->has_readings);
+  assert_int_equal(value->readings_count, 3);
+  assert_true(_is_double_equal(value->readings[0], 1.5));
+  assert_true(_is_double_equal(value->readings[1], -2));
+  assert_true(_is_double_equal(value->readings[2], 300));
+
+  assert_true(value->has_sensors);
+  assert_int_equal(value->sensors_count, 2);
+  assert_string_equal(value->sensors[0].name, "a");
+  assert_int_equal(value->sensors[0].rate, 10);
+  assert_false(value->sensors[1].has_name);
+  assert_int_equal(value->sensors[1].rate, 20);
+
+  assert_true(value->has_tags);
+  assert_int_equal(value->tags_count, 2);
+  assert_string_equal(value->tags[0], "x");
+  assert_string_equal(value->tags[1], "yy");
+
+  // Both names have the same length and first byte.
+  assert_int_equal(value->rack, 7);
+  assert_int_equal(value->rank, 8);
+}
+
+static void test_json_codegen_json_schema_parse(void** state)
+{
+  (void)state;
+
+  device_report value;
+  assert_int_equal(device_report_parse(AZ_SPAN_FROM_STR(TEST_DEVICE_REPORT_JSON), &value), AZ_OK);
+  _test_json_codegen_check_device_report(&value);
+
+  // Required properties, within nested objects too.
+  assert_int_equal(
+      device_report_parse(AZ_SPAN_FROM_STR("{\"deviceId\":\"d\",\"uptime\":1}"), &value), AZ_OK);
+  assert_false(value.has_firmware);
+  assert_int_equal(
+      device_report_parse(AZ_SPAN_FROM_STR("{\"deviceId\":\"d\"}"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      device_report_parse(
+          AZ_SPAN_FROM_STR("{\"deviceId\":\"d\",\"uptime\":1,\"firmware\":{\"build\":1}}"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // Strings and arrays longer than their fields.
+  assert_int_equal(
+      device_report_parse(
+          AZ_SPAN_FROM_STR("{\"deviceId\":\"0123456789abcdef\",\"uptime\":1}"), &value),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      device_report_parse(
+          AZ_SPAN_FROM_STR("{\"deviceId\":\"d\",\"uptime\":1,\"sensors\":[{},{},{}]}"), &value),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      device_report_parse(
+          AZ_SPAN_FROM_STR("{\"deviceId\":\"d\",\"uptime\":1,\"tags\":[\"12345678\"]}"), &value),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      device_report_parse(
+          AZ_SPAN_FROM_STR("{\"deviceId\":\"d\",\"uptime\":1,\"readings\":{}}"), &value),
+      AZ_ERROR_JSON_INVALID_STATE);
+}
+
+static void test_json_codegen_json_schema_read(void** state)
+{
+  (void)state;
+
+  // The generated object is the value of a property, read from one byte buffers.
+  char const json[] = "{\"before\":[],\"report\":" TEST_DEVICE_REPORT_JSON ",\"after\":0}";
+  az_span buffers[sizeof(json) - 1];
+  for (int32_t i = 0; i < (int32_t)(sizeof(json) - 1); i++)
+  {
+    buffers[i] = az_span_create((uint8_t*)(uintptr_t)(json + i), 1);
+  }
+
+  az_json_reader reader;
+  assert_int_equal(
+      az_json_reader_chunked_init(&reader, buffers, (int32_t)(sizeof(json) - 1), NULL),
+      AZ_OK);
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  assert_int_equal(az_json_reader_skip_children(&reader), AZ_OK);
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  assert_true(az_json_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("report")));
+
+  device_report value;
+  assert_int_equal(device_report_read(&reader, &value), AZ_OK);
+  _test_json_codegen_check_device_report(&value);
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_END_OBJECT);
+
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  assert_true(az_json_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("after")));
+}
+
+static void test_json_codegen_json_schema_write(void** state)
+{
+  (void)state;
+
+  device_report value;
+  assert_int_equal(device_report_parse(AZ_SPAN_FROM_STR(TEST_DEVICE_REPORT_JSON), &value), AZ_OK);
+
+  uint8_t buffer[512];
+  az_span json = AZ_SPAN_EMPTY;
+  assert_int_equal(device_report_serialize(&value, AZ_SPAN_FROM_BUFFER(buffer), &json), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      json,
+      AZ_SPAN_FROM_STR(
+          "{\"deviceId\":\"dev-1\",\"uptime\":9007199254740993,\"online\":true,"
+          "\"firmware\":{\"version\":\"1.2.3\",\"build\":42},"
+          "\"readings\":[1.5,-2,300],\"sensors\":[{\"name\":\"a\",\"rate\":10},{\"rate\":20}],"
+          "\"tags\":[\"x\",\"yy\"],\"rack\":7,\"rank\":8}")));
+
+  // The generated object is written as the value of a property.
+  az_json_writer writer;
+  assert_int_equal(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(buffer), NULL), AZ_OK);
+  assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+  value = (device_report){ 0 };
+  value.has_rank = true;
+  value.has_tags = true;
+  assert_int_equal(device_report_write(&writer, &value), AZ_OK);
+  assert_int_equal(az_json_writer_append_end_array(&writer), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      az_json_writer_get_bytes_used_in_destination(&writer),
+      AZ_SPAN_FROM_STR("[{\"tags\":[],\"rank\":0}]")));
+}
+
+int test_az_json_codegen()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_json_codegen_dtdl_parse),
+    cmocka_unit_test(test_json_codegen_dtdl_serialize),
+    cmocka_unit_test(test_json_codegen_json_schema_parse),
+    cmocka_unit_test(test_json_codegen_json_schema_read),
+    cmocka_unit_test(test_json_codegen_json_schema_write),
+  };
+  return cmocka_run_group_tests_name("az_json_codegen", tests, NULL, NULL);
+}
@@ -1,11 +1,14 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+int test_az_cbor();
 int test_az_context();
+int test_az_crypto();
 int test_az_http();
 int test_az_json();
 int test_az_logging();
 int test_az_pipeline();
+int test_az_platform();
 int test_az_policy();
 int test_az_span();
 int test_az_url_encode();
@@ -0,0 +1,398 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_test_definitions.h"
+#include <azure/core/az_cbor.h>
+#include <azure/core/internal/az_result_internal.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_EXPECT_SUCCESS(exp) assert_true(az_result_succeeded(exp))
+
+// Writes a single value with a fresh writer, and checks its encoding.
+#define TEST_CBOR_WRITER_HELPER(append, expected)                                         \
+  do                                                                                      \
+  {                                                                                       \
+    uint8_t buffer[16] = { 0 };                                                           \
+    uint8_t const expected_bytes[] = expected;                                            \
+    az_cbor_writer writer = { 0 };                                                        \
+    TEST_EXPECT_SUCCESS(az_cbor_writer_init(&writer, AZ_SPAN_FROM_BUFFER(buffer), NULL)); \
+    TEST_EXPECT_SUCCESS(append);                                                          \
+    az_span const written = az_cbor_writer_get_bytes_used_in_destination(&writer);        \
+    assert_int_equal(az_span_size(written), sizeof(expected_bytes));                      \
+    assert_memory_equal(az_span_ptr(written), expected_bytes, sizeof(expected_bytes));    \
+  } while (0)
+
+#define TEST_BYTES(...) \
+  {                     \
+    __VA_ARGS__         \
+  }
+
+static void test_cbor_writer_integers(void** state)
+{
+  (void)state;
+
+  // The examples of RFC 8949, appendix A.
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_int32(&writer, 0), TEST_BYTES(0x00));
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_int32(&writer, 23), TEST_BYTES(0x17));
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_int32(&writer, 24), TEST_BYTES(0x18, 0x18));
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_int32(&writer, 1000), TEST_BYTES(0x19, 0x03, 0xE8));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_int32(&writer, 100000), TEST_BYTES(0x1A, 0x00, 0x01, 0x86, 0xA0));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_uint64(&writer, UINT64_MAX),
+      TEST_BYTES(0x1B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF));
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_int32(&writer, -1), TEST_BYTES(0x20));
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_int32(&writer, -100), TEST_BYTES(0x38, 0x63));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_int32(&writer, -1000), TEST_BYTES(0x39, 0x03, 0xE7));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_int64(&writer, INT64_MIN),
+      TEST_BYTES(0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF));
+}
+
+static void test_cbor_writer_floats(void** state)
+{
+  (void)state;
+
+  // Each value uses the shortest of the half, single and double precision encodings that is exact.
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_double(&writer, 0.0), TEST_BYTES(0xF9, 0x00, 0x00));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, -0.0), TEST_BYTES(0xF9, 0x80, 0x00));
+  TEST_CBOR_WRITER_HELPER(az_cbor_writer_append_double(&writer, 1.5), TEST_BYTES(0xF9, 0x3E, 0x00));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, 21.5), TEST_BYTES(0xF9, 0x4D, 0x60));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, 65504.0), TEST_BYTES(0xF9, 0x7B, 0xFF));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, 5.960464477539063e-8), TEST_BYTES(0xF9, 0x00, 0x01));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, 100000.0), TEST_BYTES(0xFA, 0x47, 0xC3, 0x50, 0x00));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, 3.4028234663852886e+38),
+      TEST_BYTES(0xFA, 0x7F, 0x7F, 0xFF, 0xFF));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, 1.1),
+      TEST_BYTES(0xFB, 0x3F, 0xF1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9A));
+  TEST_CBOR_WRITER_HELPER(
+      az_cbor_writer_append_double(&writer, -4.1),
+      TEST_BYTES(0xFB, 0xC0, 0x10, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66));
+}
+
+static void test_cbor_writer_map(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[64] = { 0 };
+  az_cbor_writer writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_writer_init(&writer, AZ_SPAN_FROM_BUFFER(buffer), NULL));
+
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_begin_map(&writer));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("a")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_begin_array(&writer));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_bool(&writer, true));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_bool(&writer, false));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_null(&writer));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_end_array(&writer));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("b")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_string(&writer, AZ_SPAN_FROM_STR("IETF")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("c")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_bytes(&writer, AZ_SPAN_FROM_STR("\x01\x02")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_end_map(&writer));
+
+  uint8_t const expected[] = { 0xBF, 0x61, 'a',  0x9F, 0xF5, 0xF4, 0xF6, 0xFF, 0x61, 'b', 0x64,
+                               'I',  'E',  'T',  'F',  0x61, 'c',  0x42, 0x01, 0x02, 0xFF };
+  az_span const written = az_cbor_writer_get_bytes_used_in_destination(&writer);
+  assert_int_equal(az_span_size(written), sizeof(expected));
+  assert_memory_equal(az_span_ptr(written), expected, sizeof(expected));
+}
+
+static void test_cbor_writer_not_enough_space(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[4] = { 0 };
+  az_cbor_writer writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_writer_init(&writer, AZ_SPAN_FROM_BUFFER(buffer), NULL));
+
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_begin_map(&writer));
+  assert_int_equal(
+      az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("name")),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(az_cbor_writer_append_int32(&writer, 100000), AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // Nothing is written by a failed append.
+  assert_int_equal(az_span_size(az_cbor_writer_get_bytes_used_in_destination(&writer)), 1);
+}
+
+typedef struct
+{
+  uint8_t chunks[4][10];
+  int32_t chunk_count;
+  uint8_t cbor[32];
+  int32_t cbor_size;
+} test_cbor_chunks;
+
+static az_result test_cbor_allocator(
+    az_span_allocator_context* allocator_context,
+    az_span* out_next_destination)
+{
+  test_cbor_chunks* const chunks = (test_cbor_chunks*)allocator_context->user_context;
+  assert_true(allocator_context->minimum_required_size <= (int32_t)sizeof(chunks->chunks[0]));
+
+  memcpy(
+      chunks->cbor + chunks->cbor_size,
+      chunks->chunks[chunks->chunk_count - 1],
+      (size_t)allocator_context->bytes_used);
+  chunks->cbor_size += allocator_context->bytes_used;
+
+  if (chunks->chunk_count == 4)
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+
+  *out_next_destination = AZ_SPAN_FROM_BUFFER(chunks->chunks[chunks->chunk_count]);
+  chunks->chunk_count++;
+  return AZ_OK;
+}
+
+static void test_cbor_writer_chunked(void** state)
+{
+  (void)state;
+
+  test_cbor_chunks chunks = { 0 };
+  chunks.chunk_count = 1;
+
+  az_cbor_writer writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_writer_chunked_init(
+      &writer, AZ_SPAN_FROM_BUFFER(chunks.chunks[0]), test_cbor_allocator, &chunks, NULL));
+
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_begin_array(&writer));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_string(&writer, AZ_SPAN_FROM_STR("0123456789")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_int32(&writer, 100000));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_double(&writer, 1.1));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_end_array(&writer));
+
+  az_span const last = az_cbor_writer_get_bytes_used_in_destination(&writer);
+  memcpy(chunks.cbor + chunks.cbor_size, az_span_ptr(last), (size_t)az_span_size(last));
+  chunks.cbor_size += az_span_size(last);
+
+  uint8_t const expected[] = { 0x9F, 0x6A, '0',  '1',  '2',  '3',  '4',  '5',  '6',  '7',
+                               '8',  '9',  0x1A, 0x00, 0x01, 0x86, 0xA0, 0xFB, 0x3F, 0xF1,
+                               0x99, 0x99, 0x99, 0x99, 0x99, 0x9A, 0xFF };
+  assert_int_equal(chunks.cbor_size, sizeof(expected));
+  assert_memory_equal(chunks.cbor, expected, sizeof(expected));
+  assert_int_equal(writer._internal.total_bytes_written, sizeof(expected));
+}
+
+static void test_cbor_reader_definite_map(void** state)
+{
+  (void)state;
+
+  // {"a": 1, "b": [2, -3], "c": h'0102'}
+  uint8_t cbor[] = { 0xA3, 0x61, 'a', 0x01, 0x61, 'b', 0x82, 0x02,
+                     0x22, 0x61, 'c', 0x42, 0x01, 0x02 };
+  az_cbor_reader reader = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(cbor), NULL));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_NONE);
+
+  int32_t value = 0;
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_BEGIN_MAP);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_PROPERTY_NAME);
+  assert_true(az_cbor_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("a")));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_int32(&reader.token, &value));
+  assert_int_equal(value, 1);
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_true(az_cbor_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("b")));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_BEGIN_ARRAY);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_int32(&reader.token, &value));
+  assert_int_equal(value, 2);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_int32(&reader.token, &value));
+  assert_int_equal(value, -3);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_END_ARRAY);
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_true(az_cbor_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("c")));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_BYTES);
+  assert_int_equal(az_span_size(reader.token.slice), 2);
+  assert_int_equal(az_span_ptr(reader.token.slice)[1], 0x02);
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_END_MAP);
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_CBOR_READER_DONE);
+}
+
+static void test_cbor_reader_round_trip(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[64] = { 0 };
+  az_cbor_writer writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_writer_init(&writer, AZ_SPAN_FROM_BUFFER(buffer), NULL));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_begin_map(&writer));
+  TEST_EXPECT_SUCCESS(
+      az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("temperature")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_double(&writer, 21.5));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("humidity")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_double(&writer, 1.1));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("count")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_int64(&writer, INT64_MIN));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("valid")));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_bool(&writer, true));
+  TEST_EXPECT_SUCCESS(az_cbor_writer_append_end_map(&writer));
+
+  az_cbor_reader reader = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(
+      &reader, az_cbor_writer_get_bytes_used_in_destination(&writer), NULL));
+
+  double number = 0;
+  int64_t count = 0;
+  bool valid = false;
+  char name[16] = { 0 };
+  int32_t name_length = 0;
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_BEGIN_MAP);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_string(&reader.token, name, sizeof(name), &name_length));
+  assert_string_equal(name, "temperature");
+  assert_int_equal(name_length, 11);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_FLOAT);
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_double(&reader.token, &number));
+  assert_true(number > 21.4999 && number < 21.5001);
+  assert_int_equal(
+      az_cbor_token_get_int32(&reader.token, &name_length), AZ_ERROR_CBOR_INVALID_STATE);
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_double(&reader.token, &number));
+  assert_memory_equal(&number, &(double){ 1.1 }, sizeof(number));
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_int64(&reader.token, &count));
+  assert_true(count == INT64_MIN);
+  assert_int_equal(az_cbor_token_get_int32(&reader.token, &name_length), AZ_ERROR_UNEXPECTED_CHAR);
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_boolean(&reader.token, &valid));
+  assert_true(valid);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_END_MAP);
+}
+
+static void test_cbor_reader_skip_children(void** state)
+{
+  (void)state;
+
+  // [{"a": [1, 2]}, _ [3], tag 1 4]
+  uint8_t cbor[] = { 0x83, 0xA1, 0x61, 'a', 0x82, 0x01, 0x02, 0x9F, 0x03, 0xFF, 0xC1, 0x04 };
+  az_cbor_reader reader = { 0 };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(cbor), NULL));
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_BEGIN_MAP);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_skip_children(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_END_MAP);
+
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_BEGIN_ARRAY);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_skip_children(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_END_ARRAY);
+
+  // The tag is skipped.
+  uint32_t value = 0;
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_token_get_uint32(&reader.token, &value));
+  assert_int_equal(value, 4);
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_CBOR_TOKEN_END_ARRAY);
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_CBOR_READER_DONE);
+}
+
+static void test_cbor_reader_invalid(void** state)
+{
+  (void)state;
+
+  az_cbor_reader reader = { 0 };
+
+  // A truncated argument, and a string longer than the buffer.
+  uint8_t truncated[] = { 0x19, 0x03 };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(truncated), NULL));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_UNEXPECTED_END);
+
+  uint8_t short_string[] = { 0x63, 'a', 'b' };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(short_string), NULL));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_UNEXPECTED_END);
+
+  // A map missing its last item.
+  uint8_t short_map[] = { 0xA1, 0x61, 'a' };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(short_map), NULL));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_UNEXPECTED_END);
+
+  // Keys which aren't text, strings of indefinite length, and a break outside of a container.
+  uint8_t integer_key[] = { 0xA1, 0x01, 0x02 };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(integer_key), NULL));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_NOT_SUPPORTED);
+
+  uint8_t indefinite_string[] = { 0x7F, 0x61, 'a', 0xFF };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(indefinite_string), NULL));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_NOT_SUPPORTED);
+
+  uint8_t lone_break[] = { 0xFF };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(lone_break), NULL));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_UNEXPECTED_CHAR);
+
+  // A break between a key and its value.
+  uint8_t half_pair[] = { 0xBF, 0x61, 'a', 0xFF };
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(half_pair), NULL));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_UNEXPECTED_CHAR);
+
+  uint8_t nested[_az_CBOR_MAX_NESTING_DEPTH + 1];
+  memset(nested, 0x9F, sizeof(nested));
+  TEST_EXPECT_SUCCESS(az_cbor_reader_init(&reader, AZ_SPAN_FROM_BUFFER(nested), NULL));
+  for (int32_t i = 0; i < _az_CBOR_MAX_NESTING_DEPTH; i++)
+  {
+    TEST_EXPECT_SUCCESS(az_cbor_reader_next_token(&reader));
+  }
+  assert_int_equal(az_cbor_reader_next_token(&reader), AZ_ERROR_CBOR_NESTING_OVERFLOW);
+}
+
+int test_az_cbor()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_cbor_writer_integers),
+    cmocka_unit_test(test_cbor_writer_floats),
+    cmocka_unit_test(test_cbor_writer_map),
+    cmocka_unit_test(test_cbor_writer_not_enough_space),
+    cmocka_unit_test(test_cbor_writer_chunked),
+    cmocka_unit_test(test_cbor_reader_definite_map),
+    cmocka_unit_test(test_cbor_reader_round_trip),
+    cmocka_unit_test(test_cbor_reader_skip_children),
+    cmocka_unit_test(test_cbor_reader_invalid),
+  };
+  return cmocka_run_group_tests_name("az_core_cbor", tests, NULL, NULL);
+}
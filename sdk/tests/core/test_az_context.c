@@ -3,6 +3,7 @@
 
 #include "az_test_definitions.h"
 #include <azure/core/az_context.h>
+#include <azure/core/az_platform.h>
 #include <azure/core/az_result.h>
 
 #include <setjmp.h>
@@ -41,10 +42,61 @@ static void az_context_test(void** state)
   assert_true(expiration == 0);
 }
 
+static void az_context_nested_expiration_test(void** state)
+{
+  (void)state;
+
+  void const* const key = "k";
+  az_context root = az_context_create_with_expiration(&az_context_application, 500);
+  az_context values[8];
+  az_context const* parent = &root;
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+  {
+    values[i] = az_context_create_with_value(parent, key, NULL);
+    parent = &values[i];
+  }
+
+  az_context leaf = az_context_create_with_expiration(parent, 700);
+  assert_true(az_context_get_expiration(&leaf) == 500);
+  assert_false(az_context_has_expired(&leaf, 500));
+  assert_true(az_context_has_expired(&leaf, 501));
+
+  // Canceling a node in the middle of the chain is seen by the nodes created before it.
+  az_context_cancel(&values[3]);
+  assert_true(az_context_get_expiration(&leaf) == 0);
+  assert_true(az_context_get_expiration(&values[2]) == 500);
+
+  // And by the nodes created after it.
+  az_context child = az_context_create_with_expiration(&leaf, 900);
+  assert_true(az_context_get_expiration(&child) == 0);
+  az_context sibling = az_context_create_with_value(&values[2], key, NULL);
+  assert_true(az_context_get_expiration(&sibling) == 500);
+}
+
+static void az_context_platform_wait_test(void** state)
+{
+  (void)state;
+
+  int64_t const start = az_platform_clock_nsec();
+
+  az_context parent = az_context_create_with_expiration(&az_context_application, 0x7FFFFFFF);
+  az_context child = az_context_create_with_value(&parent, "k", "v");
+  assert_int_equal(az_platform_wait_msec(&child, 1), AZ_OK);
+  assert_int_equal(az_platform_wait_msec(NULL, 1), AZ_OK);
+
+  // A canceled parent ends the wait before it starts, however long it would be.
+  az_context_cancel(&parent);
+  assert_int_equal(az_platform_wait_msec(&child, 0x7FFFFFFF), AZ_ERROR_CANCELED);
+
+  assert_true(az_platform_clock_nsec() >= start);
+}
+
 int test_az_context()
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(az_context_test),
+    cmocka_unit_test(az_context_nested_expiration_test),
+    cmocka_unit_test(az_context_platform_wait_test),
   };
   return cmocka_run_group_tests_name("az_core_context", tests, NULL, NULL);
 }
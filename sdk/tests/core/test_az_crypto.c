@@ -0,0 +1,605 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_simd_private.h"
+#include "az_test_definitions.h"
+#include <azure/core/az_crypto.h>
+#include <azure/core/az_span.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_ASSERT_SHA256(source, ...)                                               \
+  do                                                                                  \
+  {                                                                                   \
+    uint8_t digest[AZ_CRYPTO_SHA256_SIZE];                                            \
+    uint8_t const expected[AZ_CRYPTO_SHA256_SIZE] = { __VA_ARGS__ };                  \
+    assert_int_equal(az_crypto_sha256((source), AZ_SPAN_FROM_BUFFER(digest)), AZ_OK); \
+    assert_memory_equal(digest, expected, AZ_CRYPTO_SHA256_SIZE);                     \
+  } while (0)
+
+static void test_az_crypto_sha256(void** state)
+{
+  (void)state;
+
+  TEST_ASSERT_SHA256(
+      AZ_SPAN_EMPTY,
+      0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9,
+      0x24, 0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52,
+      0xb8, 0x55);
+
+  TEST_ASSERT_SHA256(
+      AZ_SPAN_FROM_STR("abc"),
+      0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22,
+      0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00,
+      0x15, 0xad);
+
+  // 56 bytes, so that the padding needs a second block.
+  TEST_ASSERT_SHA256(
+      AZ_SPAN_FROM_STR("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+      0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60,
+      0x39, 0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb,
+      0x06, 0xc1);
+
+  // 112 bytes, which spans two whole blocks.
+  TEST_ASSERT_SHA256(
+      AZ_SPAN_FROM_STR("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnop"
+                       "jklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"),
+      0xcf, 0x5b, 0x16, 0xa7, 0x78, 0xaf, 0x83, 0x80, 0x03, 0x6c, 0xe5, 0x9e, 0x7b, 0x04, 0x92,
+      0x37, 0x0b, 0x24, 0x9b, 0x11, 0xe8, 0xf0, 0x7a, 0x51, 0xaf, 0xac, 0x45, 0x03, 0x7a, 0xfe,
+      0xe9, 0xd1);
+
+  uint8_t digest[AZ_CRYPTO_SHA256_SIZE - 1];
+  assert_int_equal(
+      az_crypto_sha256(AZ_SPAN_FROM_STR("abc"), AZ_SPAN_FROM_BUFFER(digest)),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_crypto_hmac_sha256(void** state)
+{
+  (void)state;
+
+  uint8_t hmac[AZ_CRYPTO_SHA256_SIZE];
+
+  // RFC 4231 test case 1.
+  {
+    uint8_t key[20];
+    memset(key, 0x0b, sizeof(key));
+    uint8_t const expected[AZ_CRYPTO_SHA256_SIZE]
+        = { 0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c, 0xa8, 0xaf,
+            0xce, 0xaf, 0x0b, 0xf1, 0x2b, 0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83,
+            0x3d, 0xa7, 0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7 };
+    assert_int_equal(
+        az_crypto_hmac_sha256(
+            AZ_SPAN_FROM_BUFFER(key), AZ_SPAN_FROM_STR("Hi There"), AZ_SPAN_FROM_BUFFER(hmac)),
+        AZ_OK);
+    assert_memory_equal(hmac, expected, AZ_CRYPTO_SHA256_SIZE);
+  }
+
+  // RFC 4231 test case 2.
+  {
+    uint8_t const expected[AZ_CRYPTO_SHA256_SIZE]
+        = { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24,
+            0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27,
+            0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+    assert_int_equal(
+        az_crypto_hmac_sha256(
+            AZ_SPAN_FROM_STR("Jefe"),
+            AZ_SPAN_FROM_STR("what do ya want for nothing?"),
+            AZ_SPAN_FROM_BUFFER(hmac)),
+        AZ_OK);
+    assert_memory_equal(hmac, expected, AZ_CRYPTO_SHA256_SIZE);
+  }
+
+  // RFC 4231 test case 6, with a key longer than a block.
+  {
+    uint8_t key[131];
+    memset(key, 0xaa, sizeof(key));
+    uint8_t const expected[AZ_CRYPTO_SHA256_SIZE]
+        = { 0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26,
+            0xaa, 0xcb, 0xf5, 0xb7, 0x7f, 0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28,
+            0xc5, 0x14, 0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54 };
+    assert_int_equal(
+        az_crypto_hmac_sha256(
+            AZ_SPAN_FROM_BUFFER(key),
+            AZ_SPAN_FROM_STR("Test Using Larger Than Block-Size Key - Hash Key First"),
+            AZ_SPAN_FROM_BUFFER(hmac)),
+        AZ_OK);
+    assert_memory_equal(hmac, expected, AZ_CRYPTO_SHA256_SIZE);
+  }
+}
+
+static int32_t _test_hmac_callback_calls = 0;
+
+static az_result _test_hmac_callback(az_span key, az_span message, az_span destination)
+{
+  (void)key;
+  (void)message;
+  _test_hmac_callback_calls++;
+  az_span_fill(az_span_slice(destination, 0, AZ_CRYPTO_SHA256_SIZE), 0x42);
+  return AZ_OK;
+}
+
+static void test_az_crypto_hmac_sha256_callback(void** state)
+{
+  (void)state;
+
+  uint8_t hmac[AZ_CRYPTO_SHA256_SIZE] = { 0 };
+  uint8_t expected[AZ_CRYPTO_SHA256_SIZE];
+  memset(expected, 0x42, sizeof(expected));
+
+  az_crypto_set_hmac_sha256_callback(_test_hmac_callback);
+  assert_int_equal(
+      az_crypto_hmac_sha256(
+          AZ_SPAN_FROM_STR("key"), AZ_SPAN_FROM_STR("message"), AZ_SPAN_FROM_BUFFER(hmac)),
+      AZ_OK);
+  assert_int_equal(_test_hmac_callback_calls, 1);
+  assert_memory_equal(hmac, expected, AZ_CRYPTO_SHA256_SIZE);
+
+  az_crypto_set_hmac_sha256_callback(NULL);
+  assert_int_equal(
+      az_crypto_hmac_sha256(
+          AZ_SPAN_FROM_STR("key"), AZ_SPAN_FROM_STR("message"), AZ_SPAN_FROM_BUFFER(hmac)),
+      AZ_OK);
+  assert_int_equal(_test_hmac_callback_calls, 1);
+  assert_true(memcmp(hmac, expected, AZ_CRYPTO_SHA256_SIZE) != 0);
+}
+
+static void test_az_crypto_crc64(void** state)
+{
+  (void)state;
+
+  // The check value of the CRC-64/NVME.
+  assert_true(az_crypto_crc64(AZ_SPAN_FROM_STR("123456789"), 0) == 0xae8b14860a799888ULL);
+  assert_true(az_crypto_crc64(AZ_SPAN_EMPTY, 0) == 0);
+  assert_true(az_crypto_crc64(AZ_SPAN_EMPTY, 0x1234) == 0x1234);
+  assert_true(
+      az_crypto_crc64(
+          AZ_SPAN_FROM_STR("6789"), az_crypto_crc64(AZ_SPAN_FROM_STR("12345"), 0))
+      == 0xae8b14860a799888ULL);
+}
+
+static void test_az_crypto_crc64_long(void** state)
+{
+  (void)state;
+
+  // Long enough for the folding of one and four blocks at a time, with every tail size.
+  uint8_t source[1000];
+  for (size_t i = 0; i < sizeof(source); i++)
+  {
+    source[i] = (uint8_t)((i * 7) + 3);
+  }
+
+  assert_true(az_crypto_crc64(AZ_SPAN_FROM_BUFFER(source), 0) == 0x387e868bd14debedULL);
+
+  // Updated one byte at a time, the CRC is the same as from all of the bytes at once.
+  uint64_t crc = 0;
+  for (int32_t size = 0; size <= 300; size++)
+  {
+    assert_true(az_crypto_crc64(az_span_create(source, size), 0) == crc);
+    crc = az_crypto_crc64(az_span_create(source + size, 1), crc);
+  }
+
+  // And the same when the pieces are long.
+  uint64_t const first = az_crypto_crc64(az_span_create(source, 333), 0);
+  assert_true(
+      az_crypto_crc64(az_span_create(source + 333, 667), first) == 0x387e868bd14debedULL);
+}
+
+static void test_az_base64_encode(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[16];
+  int32_t written = 0;
+
+  // RFC 4648 section 10.
+  az_span const sources[] = {
+    AZ_SPAN_FROM_STR(""),     AZ_SPAN_FROM_STR("f"),     AZ_SPAN_FROM_STR("fo"),
+    AZ_SPAN_FROM_STR("foo"),  AZ_SPAN_FROM_STR("foob"),  AZ_SPAN_FROM_STR("fooba"),
+    AZ_SPAN_FROM_STR("foobar"),
+  };
+  az_span const encoded[] = {
+    AZ_SPAN_FROM_STR(""),         AZ_SPAN_FROM_STR("Zg=="),     AZ_SPAN_FROM_STR("Zm8="),
+    AZ_SPAN_FROM_STR("Zm9v"),     AZ_SPAN_FROM_STR("Zm9vYg=="), AZ_SPAN_FROM_STR("Zm9vYmE="),
+    AZ_SPAN_FROM_STR("Zm9vYmFy"),
+  };
+
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+  {
+    assert_int_equal(az_base64_encode(AZ_SPAN_FROM_BUFFER(buffer), sources[i], &written), AZ_OK);
+    assert_int_equal(written, az_span_size(encoded[i]));
+    assert_int_equal(az_base64_get_encoded_size(az_span_size(sources[i])), written);
+    assert_true(az_span_is_content_equal(az_span_create(buffer, written), encoded[i]));
+
+    assert_int_equal(az_base64_decode(AZ_SPAN_FROM_BUFFER(buffer), encoded[i], &written), AZ_OK);
+    assert_int_equal(written, az_span_size(sources[i]));
+    assert_true(az_span_is_content_equal(az_span_create(buffer, written), sources[i]));
+  }
+
+  assert_int_equal(
+      az_base64_encode(az_span_create(buffer, 7), AZ_SPAN_FROM_STR("foobar"), &written),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_base64_round_trip_long(void** state)
+{
+  (void)state;
+
+  // Long enough for the vector encoders, with every byte value and every tail size.
+  uint8_t source[259];
+  for (size_t i = 0; i < sizeof(source); i++)
+  {
+    source[i] = (uint8_t)((i * 7) + 3);
+  }
+
+  uint8_t encoded[348];
+  uint8_t decoded[259];
+
+  for (int32_t size = 0; size <= (int32_t)sizeof(source); size++)
+  {
+    int32_t encoded_size = 0;
+    assert_int_equal(
+        az_base64_encode(
+            AZ_SPAN_FROM_BUFFER(encoded), az_span_create(source, size), &encoded_size),
+        AZ_OK);
+    assert_int_equal(encoded_size, az_base64_get_encoded_size(size));
+
+    int32_t decoded_size = 0;
+    assert_int_equal(
+        az_base64_decode(
+            AZ_SPAN_FROM_BUFFER(decoded), az_span_create(encoded, encoded_size), &decoded_size),
+        AZ_OK);
+    assert_int_equal(decoded_size, size);
+    assert_memory_equal(decoded, source, (size_t)size);
+  }
+
+  // The bytes 0x00, 0x10, 0x83, ... 0xff cover the whole alphabet.
+  uint8_t all_values[] = { 0x00, 0x10, 0x83, 0x10, 0x51, 0x87, 0x20, 0x92, 0x8b, 0x30, 0xd3,
+                           0x8f, 0x41, 0x14, 0x93, 0x51, 0x55, 0x97, 0x61, 0x96, 0x9b, 0x71,
+                           0xd7, 0x9f, 0x82, 0x18, 0xa3, 0x92, 0x59, 0xa7, 0xa2, 0x9a, 0xab,
+                           0xb2, 0xdb, 0xaf, 0xc3, 0x1c, 0xb3, 0xd3, 0x5d, 0xb7, 0xe3, 0x9e,
+                           0xbb, 0xf3, 0xdf, 0xbf };
+  int32_t encoded_size = 0;
+  assert_int_equal(
+      az_base64_encode(
+          AZ_SPAN_FROM_BUFFER(encoded), AZ_SPAN_FROM_BUFFER(all_values), &encoded_size),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(
+      az_span_create(encoded, encoded_size),
+      AZ_SPAN_FROM_STR("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/")));
+}
+
+static void test_az_base64_decode_fails(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[16];
+  int32_t written = 0;
+
+  assert_int_equal(
+      az_base64_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Zm9"), &written),
+      AZ_ERROR_UNEXPECTED_END);
+  assert_int_equal(
+      az_base64_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Zm9*"), &written),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_base64_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Zg==Zm9v"), &written),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_base64_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Z==="), &written),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_base64_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Zm=v"), &written),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_base64_decode(az_span_create(buffer, 5), AZ_SPAN_FROM_STR("Zm9vYmFy"), &written),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_base64_decode_fails_long(void** state)
+{
+  (void)state;
+
+  // Long enough for the vector decoders, with a character outside of the alphabet at each place.
+  uint8_t source[96];
+  uint8_t url_source[96];
+  uint8_t decoded[72];
+  for (size_t i = 0; i < sizeof(source); i++)
+  {
+    source[i] = (uint8_t)"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i % 64];
+    url_source[i] = source[i] == '+' ? '-' : (source[i] == '/' ? '_' : source[i]);
+  }
+
+  int32_t written = 0;
+  assert_int_equal(
+      az_base64_decode(AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_BUFFER(source), &written),
+      AZ_OK);
+  assert_int_equal(
+      az_base64_url_decode(
+          AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_BUFFER(url_source), &written),
+      AZ_OK);
+
+  uint8_t const invalid_chars[] = { '=', '*', 0x80, 0xff };
+  for (size_t i = 0; i < sizeof(source); i++)
+  {
+    for (size_t j = 0; j < sizeof(invalid_chars); j++)
+    {
+      uint8_t const saved = source[i];
+      source[i] = invalid_chars[j];
+      url_source[i] = invalid_chars[j];
+      assert_int_equal(
+          az_base64_decode(AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_BUFFER(source), &written),
+          i == sizeof(source) - 1 && invalid_chars[j] == '=' ? AZ_OK : AZ_ERROR_UNEXPECTED_CHAR);
+      assert_int_equal(
+          az_base64_url_decode(
+              AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_BUFFER(url_source), &written),
+          AZ_ERROR_UNEXPECTED_CHAR);
+      source[i] = saved;
+      url_source[i] = saved == '+' ? '-' : (saved == '/' ? '_' : saved);
+    }
+
+    // The characters of each alphabet which aren't part of the other one.
+    if (source[i] == '+' || source[i] == '/')
+    {
+      url_source[i] = source[i];
+      assert_int_equal(
+          az_base64_url_decode(
+              AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_BUFFER(url_source), &written),
+          AZ_ERROR_UNEXPECTED_CHAR);
+      url_source[i] = source[i] == '+' ? '-' : '_';
+      source[i] = url_source[i];
+      assert_int_equal(
+          az_base64_decode(AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_BUFFER(source), &written),
+          AZ_ERROR_UNEXPECTED_CHAR);
+      source[i] = url_source[i] == '-' ? '+' : '/';
+    }
+  }
+}
+
+static void test_az_base64_get_decoded_size(void** state)
+{
+  (void)state;
+
+  assert_int_equal(az_base64_get_decoded_size(AZ_SPAN_FROM_STR("")), 0);
+  assert_int_equal(az_base64_get_decoded_size(AZ_SPAN_FROM_STR("Zg==")), 1);
+  assert_int_equal(az_base64_get_decoded_size(AZ_SPAN_FROM_STR("Zm8=")), 2);
+  assert_int_equal(az_base64_get_decoded_size(AZ_SPAN_FROM_STR("Zm9vYmFy")), 6);
+}
+
+static void test_az_base64_url(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[16];
+  int32_t written = 0;
+
+  // RFC 4648 section 10, without the padding.
+  az_span const sources[] = {
+    AZ_SPAN_FROM_STR(""),     AZ_SPAN_FROM_STR("f"),     AZ_SPAN_FROM_STR("fo"),
+    AZ_SPAN_FROM_STR("foo"),  AZ_SPAN_FROM_STR("foob"),  AZ_SPAN_FROM_STR("fooba"),
+    AZ_SPAN_FROM_STR("foobar"),
+  };
+  az_span const encoded[] = {
+    AZ_SPAN_FROM_STR(""),       AZ_SPAN_FROM_STR("Zg"),     AZ_SPAN_FROM_STR("Zm8"),
+    AZ_SPAN_FROM_STR("Zm9v"),   AZ_SPAN_FROM_STR("Zm9vYg"), AZ_SPAN_FROM_STR("Zm9vYmE"),
+    AZ_SPAN_FROM_STR("Zm9vYmFy"),
+  };
+
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+  {
+    assert_int_equal(
+        az_base64_url_encode(AZ_SPAN_FROM_BUFFER(buffer), sources[i], &written), AZ_OK);
+    assert_int_equal(written, az_span_size(encoded[i]));
+    assert_int_equal(az_base64_url_get_encoded_size(az_span_size(sources[i])), written);
+    assert_true(az_span_is_content_equal(az_span_create(buffer, written), encoded[i]));
+
+    assert_int_equal(
+        az_base64_url_decode(AZ_SPAN_FROM_BUFFER(buffer), encoded[i], &written), AZ_OK);
+    assert_int_equal(written, az_span_size(sources[i]));
+    assert_int_equal(az_base64_url_get_decoded_size(az_span_size(encoded[i])), written);
+    assert_true(az_span_is_content_equal(az_span_create(buffer, written), sources[i]));
+  }
+
+  uint8_t url_bytes[] = { 0xfb, 0xff, 0xbf };
+  assert_int_equal(
+      az_base64_url_encode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_BUFFER(url_bytes), &written),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(az_span_create(buffer, written), AZ_SPAN_FROM_STR("-_-_")));
+
+  assert_int_equal(
+      az_base64_url_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Zm9vY"), &written),
+      AZ_ERROR_UNEXPECTED_END);
+  assert_int_equal(
+      az_base64_url_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("Zg=="), &written),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_base64_url_decode(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("+/8"), &written),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_base64_url_decode(az_span_create(buffer, 5), AZ_SPAN_FROM_STR("Zm9vYmFy"), &written),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_base64_url_encode(az_span_create(buffer, 6), AZ_SPAN_FROM_STR("fooba"), &written),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_base64_url_round_trip_long(void** state)
+{
+  (void)state;
+
+  uint8_t source[259];
+  for (size_t i = 0; i < sizeof(source); i++)
+  {
+    source[i] = (uint8_t)((i * 7) + 3);
+  }
+
+  uint8_t encoded[346];
+  uint8_t decoded[259];
+
+  for (int32_t size = 0; size <= (int32_t)sizeof(source); size++)
+  {
+    int32_t encoded_size = 0;
+    assert_int_equal(
+        az_base64_url_encode(
+            AZ_SPAN_FROM_BUFFER(encoded), az_span_create(source, size), &encoded_size),
+        AZ_OK);
+    assert_int_equal(encoded_size, az_base64_url_get_encoded_size(size));
+
+    int32_t decoded_size = 0;
+    assert_int_equal(
+        az_base64_url_decode(
+            az_span_create(decoded, size), az_span_create(encoded, encoded_size), &decoded_size),
+        AZ_OK);
+    assert_int_equal(decoded_size, size);
+    assert_memory_equal(decoded, source, (size_t)size);
+  }
+}
+
+static void test_az_hex(void** state)
+{
+  (void)state;
+
+  // Long enough for the vector code, with every byte value and every tail size.
+  uint8_t source[256];
+  for (size_t i = 0; i < sizeof(source); i++)
+  {
+    source[i] = (uint8_t)i;
+  }
+
+  uint8_t encoded[512];
+  uint8_t decoded[256];
+
+  for (int32_t size = 0; size <= (int32_t)sizeof(source); size++)
+  {
+    int32_t encoded_size = 0;
+    assert_int_equal(
+        az_hex_encode(AZ_SPAN_FROM_BUFFER(encoded), az_span_create(source, size), &encoded_size),
+        AZ_OK);
+    assert_int_equal(encoded_size, az_hex_get_encoded_size(size));
+    for (int32_t i = 0; i < size; i++)
+    {
+      assert_int_equal(encoded[i * 2], "0123456789abcdef"[source[i] >> 4]);
+      assert_int_equal(encoded[(i * 2) + 1], "0123456789abcdef"[source[i] & 0x0F]);
+    }
+
+    int32_t decoded_size = 0;
+    assert_int_equal(
+        az_hex_decode(
+            az_span_create(decoded, size), az_span_create(encoded, encoded_size), &decoded_size),
+        AZ_OK);
+    assert_int_equal(decoded_size, size);
+    assert_int_equal(az_hex_get_decoded_size(encoded_size), size);
+    assert_memory_equal(decoded, source, (size_t)size);
+  }
+
+  // Uppercase digits decode too, but no other character does, wherever it is.
+  int32_t written = 0;
+  for (size_t i = 0; i < 64; i++)
+  {
+    encoded[i] = (uint8_t)"0123456789ABCDEFabcdef"[i % 22];
+  }
+  assert_int_equal(
+      az_hex_decode(AZ_SPAN_FROM_BUFFER(decoded), az_span_create(encoded, 64), &written), AZ_OK);
+  assert_int_equal(written, 32);
+  assert_int_equal(decoded[5], 0xAB);
+
+  uint8_t const invalid_chars[] = { '/', ':', '@', 'G', '`', 'g', 0x80, 0xff };
+  for (size_t i = 0; i < 64; i++)
+  {
+    for (size_t j = 0; j < sizeof(invalid_chars); j++)
+    {
+      uint8_t const saved = encoded[i];
+      encoded[i] = invalid_chars[j];
+      assert_int_equal(
+          az_hex_decode(AZ_SPAN_FROM_BUFFER(decoded), az_span_create(encoded, 64), &written),
+          AZ_ERROR_UNEXPECTED_CHAR);
+      encoded[i] = saved;
+    }
+  }
+
+  assert_int_equal(
+      az_hex_decode(AZ_SPAN_FROM_BUFFER(decoded), AZ_SPAN_FROM_STR("abc"), &written),
+      AZ_ERROR_UNEXPECTED_END);
+  assert_int_equal(
+      az_hex_decode(az_span_create(decoded, 1), AZ_SPAN_FROM_STR("abcd"), &written),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_hex_encode(az_span_create(encoded, 3), AZ_SPAN_FROM_STR("ab"), &written),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_crypto_kernels(void** state)
+{
+#ifdef _az_SIMD
+  // Each kernel the host can run, from none beyond those the compiler targets, gives the results
+  // of the scalar code.
+  uint32_t const feature_sets[] = {
+    0,
+    _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_AVX2,
+    _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_SHA_X86 | _az_SIMD_FEATURE_CLMUL_X86,
+    _az_SIMD_FEATURE_NEON | _az_SIMD_FEATURE_SHA_ARMV8 | _az_SIMD_FEATURE_CLMUL_ARMV8,
+  };
+
+  for (size_t f = 0; f < sizeof(feature_sets) / sizeof(feature_sets[0]); f++)
+  {
+    _az_simd_select_kernels(feature_sets[f] & _az_simd_get_features());
+    test_az_crypto_sha256(state);
+    test_az_crypto_hmac_sha256(state);
+    test_az_crypto_crc64(state);
+    test_az_crypto_crc64_long(state);
+    test_az_base64_round_trip_long(state);
+    test_az_base64_decode_fails_long(state);
+    test_az_base64_url_round_trip_long(state);
+  }
+
+  // The extensions the host has are used, and not only those the compiler targets.
+  uint32_t const features = _az_simd_get_features();
+  _az_simd_select_kernels(features);
+  _az_simd_kernel_table const* const kernels = _az_simd_get_kernels();
+  if ((features & (_az_SIMD_FEATURE_SHA_X86 | _az_SIMD_FEATURE_SHA_ARMV8)) != 0)
+  {
+    assert_non_null(kernels->sha256_compress);
+  }
+  if ((features & (_az_SIMD_FEATURE_CLMUL_X86 | _az_SIMD_FEATURE_CLMUL_ARMV8)) != 0)
+  {
+    assert_non_null(kernels->crc64_update);
+  }
+  if ((features & _az_SIMD_FEATURE_AVX2) != 0)
+  {
+    assert_non_null(kernels->base64_encode);
+    assert_non_null(kernels->base64_decode);
+  }
+#else
+  (void)state;
+#endif // _az_SIMD
+}
+
+int test_az_crypto()
+{
+  struct CMUnitTest const tests[] = {
+    cmocka_unit_test(test_az_crypto_sha256),
+    cmocka_unit_test(test_az_crypto_hmac_sha256),
+    cmocka_unit_test(test_az_crypto_hmac_sha256_callback),
+    cmocka_unit_test(test_az_crypto_crc64),
+    cmocka_unit_test(test_az_crypto_crc64_long),
+    cmocka_unit_test(test_az_base64_encode),
+    cmocka_unit_test(test_az_base64_round_trip_long),
+    cmocka_unit_test(test_az_base64_decode_fails),
+    cmocka_unit_test(test_az_base64_decode_fails_long),
+    cmocka_unit_test(test_az_base64_get_decoded_size),
+    cmocka_unit_test(test_az_base64_url),
+    cmocka_unit_test(test_az_base64_url_round_trip_long),
+    cmocka_unit_test(test_az_hex),
+    cmocka_unit_test(test_az_crypto_kernels),
+  };
+
+  return cmocka_run_group_tests_name("az_core_crypto", tests, NULL, NULL);
+}
@@ -4,6 +4,7 @@
 #include "az_http_header_validation_private.h"
 #include "az_test_definitions.h"
 #include <az_http_private.h>
+#include <azure/core/az_buffer_stats.h>
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_json.h>
@@ -15,6 +16,7 @@
 
 #include <setjmp.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include <az_test_precondition.h>
 #include <cmocka.h>
@@ -459,6 +461,256 @@ static void test_http_request(void** state)
   "  \"somejson\":45\r" \
   "}\n"
 
+static void test_http_request_get_header_by_name_and_id(void** state)
+{
+  (void)state;
+
+  uint8_t url_buf[100];
+  uint8_t header_buf[(8 * sizeof(_az_http_request_header))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(url_buf);
+  az_span_copy(url_span, request_url);
+
+  az_http_request request;
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &request,
+      &az_context_application,
+      az_http_method_get(),
+      url_span,
+      az_span_size(request_url),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_EMPTY));
+
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("AUTHORIZATION"), request_header_authorization_token1));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("content-length"), AZ_SPAN_FROM_STR("4")));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("Content-Type"), request_header_content_type_token));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("x-ms-client-request-id"), AZ_SPAN_FROM_STR("1")));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("X-MS-Date"), AZ_SPAN_FROM_STR("2")));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("x-ms-version"), AZ_SPAN_FROM_STR("3")));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("x-ms-version"), AZ_SPAN_FROM_STR("4")));
+
+  az_span value = AZ_SPAN_EMPTY;
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_name(&request, AZ_SPAN_FROM_STR("content-type"), &value));
+  assert_true(az_span_is_content_equal(value, request_header_content_type_token));
+  assert_int_equal(
+      az_http_request_get_header_by_name(&request, AZ_SPAN_FROM_STR("Content-Range"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // The value of each ID is the hash of its name.
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_id(&request, AZ_HTTP_HEADER_ID_AUTHORIZATION, &value));
+  assert_true(az_span_is_content_equal(value, request_header_authorization_token1));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_id(&request, AZ_HTTP_HEADER_ID_CONTENT_LENGTH, &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("4")));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_id(&request, AZ_HTTP_HEADER_ID_CONTENT_TYPE, &value));
+  assert_true(az_span_is_content_equal(value, request_header_content_type_token));
+  TEST_EXPECT_SUCCESS(az_http_request_get_header_by_id(
+      &request, AZ_HTTP_HEADER_ID_X_MS_CLIENT_REQUEST_ID, &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("1")));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_id(&request, AZ_HTTP_HEADER_ID_X_MS_DATE, &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("2")));
+
+  // The first header with the name is returned.
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_id(&request, AZ_HTTP_HEADER_ID_X_MS_VERSION, &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("3")));
+
+  assert_int_equal(
+      az_http_request_get_header_by_id(&request, (az_http_header_id)12345, &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static void test_http_request_init_from_url_prefix(void** state)
+{
+  (void)state;
+
+  az_span const urls[] = {
+    AZ_SPAN_FROM_STR("https://account.blob.core.windows.net/container/blob"),
+    AZ_SPAN_FROM_STR("https://account.blob.core.windows.net/container/blob?sv=2019&sig=abc"),
+  };
+  az_span const expected[] = {
+    AZ_SPAN_FROM_STR("https://account.blob.core.windows.net/container/blob?comp=block"),
+    AZ_SPAN_FROM_STR("https://account.blob.core.windows.net/container/blob?sv=2019&sig=abc"
+                     "&comp=block"),
+  };
+  assert_int_equal(_az_http_url_get_query_start(urls[0]), 0);
+  assert_int_equal(_az_http_url_get_query_start(urls[1]), az_span_size(urls[0]) + 1);
+
+  for (size_t i = 0; i < sizeof(urls) / sizeof(urls[0]); i++)
+  {
+    uint8_t url_buffer[100] = { 0 };
+    uint8_t headers_buffer[4 * sizeof(_az_http_request_header)] = { 0 };
+    az_http_request request = { 0 };
+    TEST_EXPECT_SUCCESS(_az_http_request_init_from_url_prefix(
+        &request,
+        &az_context_application,
+        az_http_method_put(),
+        AZ_SPAN_FROM_BUFFER(url_buffer),
+        urls[i],
+        _az_http_url_get_query_start(urls[i]),
+        AZ_SPAN_FROM_BUFFER(headers_buffer),
+        AZ_SPAN_EMPTY));
+
+    // The request is the same as the one initialized from a copy of the URL.
+    az_http_request copied_url_request = { 0 };
+    TEST_EXPECT_SUCCESS(az_http_request_init(
+        &copied_url_request,
+        &az_context_application,
+        az_http_method_put(),
+        AZ_SPAN_FROM_BUFFER(url_buffer),
+        az_span_size(urls[i]),
+        AZ_SPAN_FROM_BUFFER(headers_buffer),
+        AZ_SPAN_EMPTY));
+    assert_int_equal(request._internal.url_length, copied_url_request._internal.url_length);
+    assert_int_equal(request._internal.query_start, copied_url_request._internal.query_start);
+
+    TEST_EXPECT_SUCCESS(az_http_request_set_query_parameter(
+        &request, AZ_SPAN_FROM_STR("comp"), AZ_SPAN_FROM_STR("block"), true));
+    az_span url = AZ_SPAN_EMPTY;
+    TEST_EXPECT_SUCCESS(az_http_request_get_url(&request, &url));
+    assert_true(az_span_is_content_equal(url, expected[i]));
+
+    az_http_request too_small_request = { 0 };
+    assert_int_equal(
+        _az_http_request_init_from_url_prefix(
+            &too_small_request,
+            &az_context_application,
+            az_http_method_put(),
+            az_span_create(url_buffer, az_span_size(urls[i]) - 1),
+            urls[i],
+            _az_http_url_get_query_start(urls[i]),
+            AZ_SPAN_FROM_BUFFER(headers_buffer),
+            AZ_SPAN_EMPTY),
+        AZ_ERROR_NOT_ENOUGH_SPACE);
+  }
+}
+
+static void test_http_response_parse_headers(void** state)
+{
+  (void)state;
+
+  az_http_response response = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_init(
+      &response,
+      AZ_SPAN_FROM_STR("HTTP/1.1 503 Service Unavailable\r\n"
+                       "Retry-After: 10\r\n"
+                       "ETag: \"0x8D\"\r\n"
+                       "etag: second\r\n"
+                       "\r\n"
+                       "body")));
+
+  // The headers can be parsed at any point, even after the status line.
+  az_http_response_status_line status_line = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+
+  az_http_response_header header_array[3];
+  az_http_response_headers headers;
+  TEST_EXPECT_SUCCESS(az_http_response_parse_headers(&response, header_array, 3, &headers));
+  assert_int_equal(az_http_response_headers_count(&headers), 3);
+
+  az_span value = AZ_SPAN_EMPTY;
+  TEST_EXPECT_SUCCESS(
+      az_http_response_headers_find(&headers, AZ_SPAN_FROM_STR("retry-after"), &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("10")));
+  TEST_EXPECT_SUCCESS(az_http_response_headers_find(&headers, AZ_SPAN_FROM_STR("ETAG"), &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("\"0x8D\"")));
+  assert_int_equal(
+      az_http_response_headers_find(&headers, AZ_SPAN_FROM_STR("Content-Type"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // The parsing state of the response is left as it was.
+  az_span name = AZ_SPAN_EMPTY;
+  TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &name, &value));
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("Retry-After")));
+
+  assert_int_equal(
+      az_http_response_parse_headers(&response, header_array, 2, &headers),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_http_response_long_headers(void** state)
+{
+  (void)state;
+
+  // The lines are longer than the blocks the headers are scanned in, and the ':' and tabs of the
+  // values are past the first block.
+  {
+    az_http_response response = { 0 };
+    TEST_EXPECT_SUCCESS(az_http_response_init(
+        &response,
+        AZ_SPAN_FROM_STR("HTTP/1.1 200 OK: the reason phrase goes on for more than one block\r\n"
+                         "x-ms-request-server-encrypted-content-header: true\r\n"
+                         "Location: https://account.blob.core.windows.net:443/c/b\t\t \r\n"
+                         "Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT\tand\tmore\r\n"
+                         "\r\n")));
+
+    az_http_response_status_line status_line = { 0 };
+    TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+    assert_true(az_span_is_content_equal(
+        status_line.reason_phrase,
+        AZ_SPAN_FROM_STR("OK: the reason phrase goes on for more than one block")));
+
+    az_span name = AZ_SPAN_EMPTY;
+    az_span value = AZ_SPAN_EMPTY;
+    TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &name, &value));
+    assert_true(az_span_is_content_equal(
+        name, AZ_SPAN_FROM_STR("x-ms-request-server-encrypted-content-header")));
+    assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("true")));
+
+    TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &name, &value));
+    assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("Location")));
+    assert_true(az_span_is_content_equal(
+        value, AZ_SPAN_FROM_STR("https://account.blob.core.windows.net:443/c/b")));
+
+    TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &name, &value));
+    assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("Last-Modified")));
+    assert_true(az_span_is_content_equal(
+        value, AZ_SPAN_FROM_STR("Wed, 21 Oct 2015 07:28:00 GMT\tand\tmore")));
+
+    assert_int_equal(
+        az_http_response_get_next_header(&response, &name, &value), AZ_ERROR_HTTP_END_OF_HEADERS);
+  }
+
+  // A control character far into a value, and a value which doesn't end, are both corrupt.
+  {
+    az_span const responses[] = {
+      AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: application/json; charset=utf-8; and\vmore\r\n"
+                       "\r\n"),
+      AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: application/json; charset=utf-8; and more"),
+      AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"
+                       "Content-Type-Which-Is-Longer-Than-A-Block\v: text\r\n"
+                       "\r\n"),
+    };
+
+    for (size_t i = 0; i < sizeof(responses) / sizeof(responses[0]); i++)
+    {
+      az_http_response response = { 0 };
+      TEST_EXPECT_SUCCESS(az_http_response_init(&response, responses[i]));
+
+      az_http_response_status_line status_line = { 0 };
+      TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+
+      az_span name = AZ_SPAN_EMPTY;
+      az_span value = AZ_SPAN_EMPTY;
+      assert_int_equal(
+          az_http_response_get_next_header(&response, &name, &value),
+          AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER);
+    }
+  }
+}
+
 static void test_http_response(void** state)
 {
   (void)state;
@@ -892,6 +1144,473 @@ static void test_http_response_append_overflow_on_second_call(void** state)
   }
 }
 
+static az_result _test_http_request_body_provider(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  // Provides the body three bytes at a time, from the span given as user context.
+  az_span const body = *(az_span*)user_context;
+  int32_t const size = az_span_size(destination) < 3 ? az_span_size(destination) : 3;
+  az_span_copy(destination, az_span_slice(body, (int32_t)offset, (int32_t)offset + size));
+  *out_size = size;
+  return AZ_OK;
+}
+
+static az_result _test_http_request_body_provider_ends_early(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  (void)user_context;
+  (void)offset;
+  (void)destination;
+  *out_size = 0;
+  return AZ_OK;
+}
+
+static void test_http_request_body_provider(void** state)
+{
+  (void)state;
+  uint8_t url_buf[100] = { 0 };
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(url_buf);
+  az_span_copy(url_span, request_url);
+
+  az_http_request request = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &request,
+      &az_context_application,
+      az_http_method_put(),
+      url_span,
+      az_span_size(request_url),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_FROM_STR("body")));
+
+  // A body buffer is read as is.
+  uint8_t read_buf[8] = { 0 };
+  int32_t read_size = 0;
+  assert_int_equal(az_http_request_get_body_size(&request), 4);
+  TEST_EXPECT_SUCCESS(
+      az_http_request_read_body(&request, 1, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+  assert_int_equal(read_size, 3);
+  assert_memory_equal(read_buf, "ody", 3);
+
+  // A body provider replaces the body buffer.
+  az_span body = AZ_SPAN_FROM_STR("streamed body");
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_provider(
+      &request, az_span_size(body), _test_http_request_body_provider, &body));
+  assert_int_equal(az_http_request_get_body_size(&request), az_span_size(body));
+
+  az_span get_body = AZ_SPAN_FROM_STR("not empty");
+  TEST_EXPECT_SUCCESS(az_http_request_get_body(&request, &get_body));
+  assert_int_equal(az_span_size(get_body), 0);
+
+  uint8_t streamed[20] = { 0 };
+  int64_t offset = 0;
+  do
+  {
+    TEST_EXPECT_SUCCESS(az_http_request_read_body(
+        &request, offset, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+    memcpy(streamed + offset, read_buf, (size_t)read_size);
+    offset += read_size;
+  } while (read_size > 0);
+
+  assert_int_equal(offset, az_span_size(body));
+  assert_memory_equal(streamed, az_span_ptr(body), (size_t)az_span_size(body));
+
+  // The body can't end before its size.
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_provider(
+      &request, 10, _test_http_request_body_provider_ends_early, NULL));
+  assert_true(
+      az_http_request_read_body(&request, 0, AZ_SPAN_FROM_BUFFER(read_buf), &read_size)
+      == AZ_ERROR_UNEXPECTED_END);
+
+  // A body of unknown size is read until its provider provides nothing.
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_provider(
+      &request, AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN, _test_http_request_body_provider, &body));
+  assert_int_equal(az_http_request_get_body_size(&request), AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN);
+  TEST_EXPECT_SUCCESS(
+      az_http_request_read_body(&request, 3, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+  assert_int_equal(read_size, 3);
+  assert_memory_equal(read_buf, "eam", 3);
+
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_provider(
+      &request,
+      AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN,
+      _test_http_request_body_provider_ends_early,
+      NULL));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_read_body(&request, 13, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+  assert_int_equal(read_size, 0);
+}
+
+static void test_http_request_body_segments(void** state)
+{
+  (void)state;
+  uint8_t url_buf[100] = { 0 };
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(url_buf);
+  az_span_copy(url_span, request_url);
+
+  az_http_request request = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &request,
+      &az_context_application,
+      az_http_method_post(),
+      url_span,
+      az_span_size(request_url),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_FROM_STR("body")));
+
+  // The segments replace the body buffer, and their sizes add up to the size of the body.
+  az_span const segments[] = {
+    AZ_SPAN_LITERAL_FROM_STR("header;"),
+    AZ_SPAN_LITERAL_FROM_STR(""),
+    AZ_SPAN_LITERAL_FROM_STR("1,2,3"),
+    AZ_SPAN_LITERAL_FROM_STR(";trailer"),
+  };
+  az_span const expected = AZ_SPAN_FROM_STR("header;1,2,3;trailer");
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_segments(&request, segments, 4));
+  assert_int_equal(az_http_request_get_body_size(&request), az_span_size(expected));
+
+  az_span get_body = AZ_SPAN_FROM_STR("not empty");
+  TEST_EXPECT_SUCCESS(az_http_request_get_body(&request, &get_body));
+  assert_int_equal(az_span_size(get_body), 0);
+
+  // Each read fills the destination across as many segments as it spans.
+  uint8_t read_buf[6] = { 0 };
+  int32_t read_size = 0;
+  TEST_EXPECT_SUCCESS(
+      az_http_request_read_body(&request, 5, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+  assert_int_equal(read_size, 6);
+  assert_memory_equal(read_buf, "r;1,2,", 6);
+
+  uint8_t streamed[32] = { 0 };
+  int64_t offset = 0;
+  do
+  {
+    TEST_EXPECT_SUCCESS(az_http_request_read_body(
+        &request, offset, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+    memcpy(streamed + offset, read_buf, (size_t)read_size);
+    offset += read_size;
+  } while (read_size > 0);
+
+  assert_int_equal(offset, az_span_size(expected));
+  assert_memory_equal(streamed, az_span_ptr(expected), (size_t)az_span_size(expected));
+
+  // No segments make an empty body.
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_segments(&request, NULL, 0));
+  assert_int_equal(az_http_request_get_body_size(&request), 0);
+  TEST_EXPECT_SUCCESS(
+      az_http_request_read_body(&request, 0, AZ_SPAN_FROM_BUFFER(read_buf), &read_size));
+  assert_int_equal(read_size, 0);
+}
+
+static az_result _test_http_response_body_sink(void* user_context, az_span body_chunk)
+{
+  az_span* remaining = (az_span*)user_context;
+  if (az_span_size(*remaining) < az_span_size(body_chunk))
+  {
+    return AZ_ERROR_NOT_ENOUGH_SPACE;
+  }
+  *remaining = az_span_copy(*remaining, body_chunk);
+  return AZ_OK;
+}
+
+static void test_http_response_body_sink(void** state)
+{
+  (void)state;
+  az_span const headers = AZ_SPAN_FROM_STR("HTTP/1.1 100 Continue\r\n"
+                                           "\r\n"
+                                           "HTTP/1.1 200 Ok\r\n"
+                                           "Content-Length: 9\r\n"
+                                           "\r\n");
+
+  // The body of a successful response goes to the sink, byte by byte or all at once, and the
+  // informational response is dropped.
+  for (int32_t chunk_size = 1; chunk_size <= 64; chunk_size += 63)
+  {
+    uint8_t response_buf[40] = { 0 };
+    uint8_t sink_buf[20] = { 0 };
+    az_span sink_remaining = AZ_SPAN_FROM_BUFFER(sink_buf);
+
+    az_http_response response = { 0 };
+    TEST_EXPECT_SUCCESS(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)));
+    TEST_EXPECT_SUCCESS(
+        az_http_response_set_body_sink(&response, _test_http_response_body_sink, &sink_remaining));
+
+    uint8_t wire[80] = { 0 };
+    az_span wire_span = AZ_SPAN_FROM_BUFFER(wire);
+    az_span wire_remaining = az_span_copy(wire_span, headers);
+    wire_remaining = az_span_copy(wire_remaining, AZ_SPAN_FROM_STR("body data"));
+    wire_span = az_span_slice(wire_span, 0, az_span_size(wire_span) - az_span_size(wire_remaining));
+
+    while (az_span_size(wire_span) > 0)
+    {
+      int32_t const size
+          = az_span_size(wire_span) < chunk_size ? az_span_size(wire_span) : chunk_size;
+      TEST_EXPECT_SUCCESS(az_http_response_append(&response, az_span_slice(wire_span, 0, size)));
+      wire_span = az_span_slice_to_end(wire_span, size);
+    }
+
+    assert_int_equal(az_span_size(AZ_SPAN_FROM_BUFFER(sink_buf)) - az_span_size(sink_remaining), 9);
+    assert_memory_equal(sink_buf, "body data", 9);
+
+    az_http_response_status_line status_line = { 0 };
+    TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+    assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_OK);
+
+    az_span body = AZ_SPAN_FROM_STR("not empty");
+    TEST_EXPECT_SUCCESS(az_http_response_get_body(&response, &body));
+    assert_int_equal(az_span_size(body), 0);
+  }
+
+  // The body of an error response is buffered.
+  {
+    uint8_t response_buf[60] = { 0 };
+    uint8_t sink_buf[20] = { 0 };
+    az_span sink_remaining = AZ_SPAN_FROM_BUFFER(sink_buf);
+
+    az_http_response response = { 0 };
+    TEST_EXPECT_SUCCESS(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)));
+    TEST_EXPECT_SUCCESS(
+        az_http_response_set_body_sink(&response, _test_http_response_body_sink, &sink_remaining));
+    TEST_EXPECT_SUCCESS(az_http_response_append(
+        &response, AZ_SPAN_FROM_STR("HTTP/1.1 404 Not Found\r\n\r\nno blob")));
+
+    assert_int_equal(az_span_size(sink_remaining), (int32_t)sizeof(sink_buf));
+
+    az_span body = AZ_SPAN_EMPTY;
+    TEST_EXPECT_SUCCESS(az_http_response_get_body(&response, &body));
+    assert_true(az_span_is_content_equal(az_span_slice(body, 0, 7), AZ_SPAN_FROM_STR("no blob")));
+  }
+}
+
+typedef struct
+{
+  uint8_t buffers[2][128];
+  az_span current;
+  int32_t allocation_count;
+} _test_http_response_allocator_state;
+
+// Doubles the buffer, moving it between two static buffers as realloc() may, up to 128 bytes.
+static az_result _test_http_response_allocator(
+    az_span_allocator_context* allocator_context,
+    az_span* out_next_destination)
+{
+  _test_http_response_allocator_state* const allocator
+      = (_test_http_response_allocator_state*)allocator_context->user_context;
+
+  int32_t size = az_span_size(allocator->current) * 2;
+  if (size < allocator_context->minimum_required_size)
+  {
+    size = allocator_context->minimum_required_size;
+  }
+  if (size > (int32_t)sizeof(allocator->buffers[0]))
+  {
+    return AZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  uint8_t* const next = allocator->buffers[allocator->allocation_count % 2];
+  memcpy(next, az_span_ptr(allocator->current), (size_t)allocator_context->bytes_used);
+  memset(az_span_ptr(allocator->current), 0, (size_t)az_span_size(allocator->current));
+
+  allocator->current = az_span_create(next, size);
+  allocator->allocation_count++;
+  *out_next_destination = allocator->current;
+  return AZ_OK;
+}
+
+static void test_http_response_allocator(void** state)
+{
+  (void)state;
+
+  uint8_t first_buffer[8] = { 0 };
+  _test_http_response_allocator_state allocator = { 0 };
+  allocator.current = AZ_SPAN_FROM_BUFFER(first_buffer);
+
+  az_http_response response = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_init(&response, allocator.current));
+  TEST_EXPECT_SUCCESS(
+      az_http_response_set_allocator(&response, _test_http_response_allocator, &allocator));
+
+  // A small response fits the first buffer.
+  TEST_EXPECT_SUCCESS(az_http_response_append(&response, AZ_SPAN_FROM_STR("HTTP/1.")));
+  assert_int_equal(allocator.allocation_count, 0);
+
+  // The buffer grows as the rest arrives, and the parser follows it.
+  TEST_EXPECT_SUCCESS(
+      az_http_response_append(&response, AZ_SPAN_FROM_STR("1 200 OK\r\nETag: \"0x8D\"\r\n")));
+  az_http_response_status_line status_line = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+  assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_OK);
+
+  TEST_EXPECT_SUCCESS(az_http_response_append(
+      &response, AZ_SPAN_FROM_STR("Content-Type: text/plain\r\n\r\nthe body of the blob")));
+  assert_int_equal(allocator.allocation_count, 2);
+
+  TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+  assert_true(az_span_is_content_equal(status_line.reason_phrase, AZ_SPAN_FROM_STR("OK")));
+  az_span name = AZ_SPAN_EMPTY;
+  az_span value = AZ_SPAN_EMPTY;
+  TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &name, &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("\"0x8D\"")));
+  TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &name, &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("text/plain")));
+  az_span body = AZ_SPAN_EMPTY;
+  TEST_EXPECT_SUCCESS(az_http_response_get_body(&response, &body));
+  assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("the body of the blob")));
+
+  // A retried request is received in the grown buffer, which is grown again if needed.
+  _az_http_response_reset(&response);
+  TEST_EXPECT_SUCCESS(
+      az_http_response_append(&response, AZ_SPAN_FROM_STR("HTTP/1.1 204 No Content\r\n")));
+  assert_int_equal(allocator.allocation_count, 2);
+
+  uint8_t too_large[128] = { 0 };
+  assert_int_equal(
+      az_http_response_append(&response, AZ_SPAN_FROM_BUFFER(too_large)),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+  assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_NO_CONTENT);
+}
+
+static void test_http_response_pool(void** state)
+{
+  (void)state;
+
+  uint8_t memory[2 * 32 + 128] = { 0 };
+  az_http_response_pool_size_class const size_classes[] = { { 32, 2 }, { 128, 1 } };
+  az_http_response_pool pool = { 0 };
+  az_span const too_small = az_span_create(memory, (int32_t)sizeof(memory) - 1);
+  assert_int_equal(
+      az_http_response_pool_init(&pool, too_small, size_classes, 2), AZ_ERROR_NOT_ENOUGH_SPACE);
+  TEST_EXPECT_SUCCESS(
+      az_http_response_pool_init(&pool, AZ_SPAN_FROM_BUFFER(memory), size_classes, 2));
+
+  // The small buffers are checked out first, then the large one.
+  az_http_response responses[4];
+  TEST_EXPECT_SUCCESS(az_http_response_pool_checkout(&pool, 0, &responses[0]));
+  TEST_EXPECT_SUCCESS(az_http_response_pool_checkout(&pool, 0, &responses[1]));
+  TEST_EXPECT_SUCCESS(az_http_response_pool_checkout(&pool, 0, &responses[2]));
+  assert_ptr_equal(az_span_ptr(responses[0]._internal.http_response), memory);
+  assert_ptr_equal(az_span_ptr(responses[1]._internal.http_response), memory + 32);
+  assert_ptr_equal(az_span_ptr(responses[2]._internal.http_response), memory + 64);
+  assert_int_equal(
+      az_http_response_pool_checkout(&pool, 0, &responses[3]), AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  az_http_response_pool_return(&pool, &responses[1]);
+  az_http_response_pool_return(&pool, &responses[2]);
+  assert_int_equal(az_span_size(responses[2]._internal.http_response), 0);
+
+  // A response which expects more than the small buffers gets the large one.
+  TEST_EXPECT_SUCCESS(az_http_response_pool_checkout(&pool, 100, &responses[2]));
+  assert_ptr_equal(az_span_ptr(responses[2]._internal.http_response), memory + 64);
+  assert_int_equal(
+      az_http_response_pool_checkout(&pool, 100, &responses[3]), AZ_ERROR_NOT_ENOUGH_SPACE);
+  az_http_response_pool_return(&pool, &responses[2]);
+
+  // A response which outgrows its buffer moves to the large one, and gives the small one back.
+  az_http_response* const response = &responses[1];
+  TEST_EXPECT_SUCCESS(az_http_response_pool_checkout(&pool, 0, response));
+  assert_ptr_equal(az_span_ptr(response->_internal.http_response), memory + 32);
+  TEST_EXPECT_SUCCESS(az_http_response_append(
+      response, AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\n")));
+  assert_ptr_equal(az_span_ptr(response->_internal.http_response), memory + 64);
+
+  TEST_EXPECT_SUCCESS(az_http_response_pool_checkout(&pool, 0, &responses[3]));
+  assert_ptr_equal(az_span_ptr(responses[3]._internal.http_response), memory + 32);
+
+  az_span body = AZ_SPAN_EMPTY;
+  TEST_EXPECT_SUCCESS(az_http_response_append(response, AZ_SPAN_FROM_STR("the body")));
+  TEST_EXPECT_SUCCESS(az_http_response_get_body(response, &body));
+  assert_true(az_span_is_content_equal(az_span_slice(body, 0, 8), AZ_SPAN_FROM_STR("the body")));
+
+  // Without a larger buffer available, the response is too large.
+  uint8_t too_large[100] = { 0 };
+  assert_int_equal(
+      az_http_response_append(&responses[3], AZ_SPAN_FROM_BUFFER(too_large)),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  az_http_response_pool_return(&pool, &responses[0]);
+  az_http_response_pool_return(&pool, &responses[3]);
+  az_http_response_pool_return(&pool, response);
+  assert_int_equal(pool._internal.size_classes[0].in_use, 0);
+  assert_int_equal(pool._internal.size_classes[1].in_use, 0);
+}
+
+static void test_http_buffer_stats(void** state)
+{
+  (void)state;
+
+  az_buffer_stats_reset();
+
+  az_span const url = AZ_SPAN_FROM_STR("https://example.com/path");
+  uint8_t url_buffer[64] = { 0 };
+  az_span_copy(AZ_SPAN_FROM_BUFFER(url_buffer), url);
+  uint8_t headers_buffer[4 * sizeof(_az_http_request_header)] = { 0 };
+  az_http_request request = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &request,
+      &az_context_application,
+      az_http_method_get(),
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      az_span_size(url),
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      AZ_SPAN_EMPTY));
+  TEST_EXPECT_SUCCESS(az_http_request_set_query_parameter(
+      &request, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("b"), true));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_append_header(&request, AZ_SPAN_FROM_STR("x"), AZ_SPAN_FROM_STR("1")));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_append_header(&request, AZ_SPAN_FROM_STR("y"), AZ_SPAN_FROM_STR("2")));
+
+  az_span const status_line = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n\r\n");
+  uint8_t response_buffer[64] = { 0 };
+  az_http_response response = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)));
+  TEST_EXPECT_SUCCESS(az_http_response_append(&response, status_line));
+
+  uint8_t json_buffer[64] = { 0 };
+  az_json_writer writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL));
+  TEST_EXPECT_SUCCESS(az_json_writer_append_begin_object(&writer));
+  TEST_EXPECT_SUCCESS(az_json_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("a")));
+  TEST_EXPECT_SUCCESS(az_json_writer_append_int32(&writer, 1));
+  TEST_EXPECT_SUCCESS(az_json_writer_append_end_object(&writer));
+
+  az_buffer_stats stats = { 0 };
+  az_buffer_stats_get(&stats);
+#ifdef AZ_BUFFER_STATS
+  assert_int_equal(stats.http_request_url, az_span_size(url) + 4);
+  assert_int_equal(stats.http_request_headers, 2 * (int32_t)sizeof(_az_http_request_header));
+  assert_int_equal(stats.http_response, az_span_size(status_line));
+  assert_int_equal(stats.json_writer, (int32_t)sizeof("{\"a\":1}") - 1);
+
+  // A shorter URL leaves the peak as it was.
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &request,
+      &az_context_application,
+      az_http_method_get(),
+      AZ_SPAN_FROM_BUFFER(url_buffer),
+      1,
+      AZ_SPAN_FROM_BUFFER(headers_buffer),
+      AZ_SPAN_EMPTY));
+  az_buffer_stats_get(&stats);
+  assert_int_equal(stats.http_request_url, az_span_size(url) + 4);
+
+  az_buffer_stats_reset();
+  az_buffer_stats_get(&stats);
+#endif // AZ_BUFFER_STATS
+  assert_int_equal(stats.http_request_url, 0);
+  assert_int_equal(stats.http_request_headers, 0);
+  assert_int_equal(stats.http_response, 0);
+  assert_int_equal(stats.json_writer, 0);
+}
+
 int test_az_http()
 {
 #ifndef AZ_NO_PRECONDITION_CHECKING
@@ -906,7 +1625,11 @@ int test_az_http()
     cmocka_unit_test(test_http_response_append_null_response),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_http_request),
+    cmocka_unit_test(test_http_request_get_header_by_name_and_id),
     cmocka_unit_test(test_http_response),
+    cmocka_unit_test(test_http_request_init_from_url_prefix),
+    cmocka_unit_test(test_http_response_parse_headers),
+    cmocka_unit_test(test_http_response_long_headers),
     cmocka_unit_test(test_http_request_header_validation_range),
     cmocka_unit_test(test_http_response_header_validation),
     cmocka_unit_test(test_http_response_header_validation_fail),
@@ -914,6 +1637,12 @@ int test_az_http()
     cmocka_unit_test(test_http_response_append_overflow),
     cmocka_unit_test(test_http_response_append),
     cmocka_unit_test(test_http_response_append_overflow_on_second_call),
+    cmocka_unit_test(test_http_request_body_provider),
+    cmocka_unit_test(test_http_request_body_segments),
+    cmocka_unit_test(test_http_response_body_sink),
+    cmocka_unit_test(test_http_response_allocator),
+    cmocka_unit_test(test_http_response_pool),
+    cmocka_unit_test(test_http_buffer_stats),
   };
   return cmocka_run_group_tests_name("az_core_http", tests, NULL, NULL);
 }
@@ -1,14 +1,18 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include "az_simd_private.h"
 #include "az_test_definitions.h"
 #include <azure/core/az_json.h>
+#include <azure/core/az_ndjson.h>
 #include <azure/core/internal/az_result_internal.h>
 #include <azure/core/internal/az_span_internal.h>
 
 #include <math.h>
 #include <setjmp.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <cmocka.h>
 
@@ -276,6 +280,34 @@ static void test_json_writer_append_nested(void** state)
           "\"foo\":[\"bar\",null,0,-12,12,9007199254740991]"
           "}");
     }
+
+    {
+      TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(array), NULL));
+      TEST_EXPECT_SUCCESS(az_json_writer_append_begin_array(&writer));
+      TEST_EXPECT_SUCCESS(az_json_writer_append_json_text(&writer, AZ_SPAN_FROM_STR("1")));
+      TEST_EXPECT_SUCCESS(az_json_writer_append_json_text(&writer, AZ_SPAN_FROM_STR("{\"a\":2}")));
+      TEST_EXPECT_SUCCESS(az_json_writer_append_int32(&writer, 3));
+      TEST_EXPECT_SUCCESS(az_json_writer_append_end_array(&writer));
+
+      az_span_to_str((char*)array, 200, az_json_writer_get_bytes_used_in_destination(&writer));
+      assert_string_equal(array, "[1,{\"a\":2},3]");
+    }
+  }
+
+  {
+    // A single buffer only needs to fit the text and its comma.
+    uint8_t array[9] = { 0 };
+    az_json_writer writer = { 0 };
+
+    TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(array), NULL));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_begin_array(&writer));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_json_text(&writer, AZ_SPAN_FROM_STR("true")));
+    assert_int_equal(
+        az_json_writer_append_json_text(&writer, AZ_SPAN_FROM_STR("false")),
+        AZ_ERROR_NOT_ENOUGH_SPACE);
+    TEST_EXPECT_SUCCESS(az_json_writer_append_json_text(&writer, AZ_SPAN_FROM_STR("123")));
+    assert_true(az_span_is_content_equal(
+        az_json_writer_get_bytes_used_in_destination(&writer), AZ_SPAN_FROM_STR("[true,123")));
   }
 }
 
@@ -374,6 +406,53 @@ static void test_json_writer_append_nested_invalid(void** state)
   }
 }
 
+static void test_json_writer_append_validated_json_text(void** state)
+{
+  (void)state;
+  {
+    az_json_validated_text validated_text = { 0 };
+    TEST_EXPECT_SUCCESS(
+        az_json_validated_text_init(&validated_text, AZ_SPAN_FROM_STR("{\"a\":  [1,{}]}")));
+
+    uint8_t array[200] = { 0 };
+    az_json_writer writer = { 0 };
+
+    // The same validated text can be appended several times, as is.
+    TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(array), NULL));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_begin_array(&writer));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_validated_json_text(&writer, &validated_text));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_validated_json_text(&writer, &validated_text));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_int32(&writer, 3));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_end_array(&writer));
+    assert_true(az_span_is_content_equal(
+        az_json_writer_get_bytes_used_in_destination(&writer),
+        AZ_SPAN_FROM_STR("[{\"a\":  [1,{}]},{\"a\":  [1,{}]},3]")));
+
+    TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(array), NULL));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_begin_object(&writer));
+    assert_int_equal(
+        az_json_writer_append_validated_json_text(&writer, &validated_text),
+        AZ_ERROR_JSON_INVALID_STATE);
+
+    // A single buffer must fit the whole text.
+    TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, az_span_create(array, 13), NULL));
+    assert_int_equal(
+        az_json_writer_append_validated_json_text(&writer, &validated_text),
+        AZ_ERROR_NOT_ENOUGH_SPACE);
+    assert_int_equal(az_span_size(az_json_writer_get_bytes_used_in_destination(&writer)), 0);
+  }
+
+  {
+    az_json_validated_text validated_text = { 0 };
+    assert_int_equal(
+        az_json_validated_text_init(&validated_text, AZ_SPAN_FROM_STR("{\"name")),
+        AZ_ERROR_UNEXPECTED_END);
+    assert_int_equal(
+        az_json_validated_text_init(&validated_text, AZ_SPAN_FROM_STR("1,2")),
+        AZ_ERROR_UNEXPECTED_CHAR);
+  }
+}
+
 static uint8_t json_array[200] = { 0 };
 
 typedef struct
@@ -2083,6 +2162,366 @@ static void test_az_json_token_get_string_and_text_equal_discontiguous(void** st
   _az_JSON_TOKEN_IS_TEXT_EQUAL_NAME_HELPER(json_string);
 }
 
+static void test_az_json_token_get_string_unicode_escapes(void** state)
+{
+  (void)state;
+
+  char dest[128] = { 0 };
+  int32_t str_length = 0;
+
+  az_span json = AZ_SPAN_FROM_STR(
+      "\"caf\\u00e9 \\u20AC \\uD83D\\uDE00 \\u0041 and a run of more than thirty-two bytes\\n\"");
+  az_span expected = AZ_SPAN_FROM_STR(
+      "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 A and a run of more than thirty-two bytes\n");
+
+  az_json_reader reader = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_reader_init(&reader, json, NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+
+  az_json_token json_string = reader.token;
+  assert_int_equal(az_json_token_get_string(&json_string, dest, 128, &str_length), AZ_OK);
+  assert_int_equal(str_length, az_span_size(expected));
+  assert_memory_equal(dest, az_span_ptr(expected), (size_t)str_length);
+  assert_true(az_json_token_is_text_equal(&json_string, expected));
+  assert_false(az_json_token_is_text_equal(&json_string, az_span_slice(expected, 0, 10)));
+
+  // There must be room left for the null terminator.
+  assert_int_equal(
+      az_json_token_get_string(&json_string, dest, az_span_size(expected), NULL),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_json_token_get_string(&json_string, dest, az_span_size(expected) + 1, NULL), AZ_OK);
+
+  // The escape sequences straddle the segments.
+  az_span buffers_half[2] = { 0 };
+  _az_split_buffers(json, buffers_half);
+  TEST_EXPECT_SUCCESS(az_json_reader_chunked_init(&reader, buffers_half, 2, NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+
+  json_string = reader.token;
+  assert_int_equal(az_json_token_get_string(&json_string, dest, 128, &str_length), AZ_OK);
+  assert_int_equal(str_length, az_span_size(expected));
+  assert_memory_equal(dest, az_span_ptr(expected), (size_t)str_length);
+  assert_true(az_json_token_is_text_equal(&json_string, expected));
+
+  az_span buffers_one[128] = { 0 };
+  _az_split_buffers_single_byte(json, buffers_one);
+  TEST_EXPECT_SUCCESS(
+      az_json_reader_chunked_init(&reader, buffers_one, az_span_size(json), NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+
+  json_string = reader.token;
+  assert_int_equal(az_json_token_get_string(&json_string, dest, 128, &str_length), AZ_OK);
+  assert_int_equal(str_length, az_span_size(expected));
+  assert_memory_equal(dest, az_span_ptr(expected), (size_t)str_length);
+  assert_true(az_json_token_is_text_equal(&json_string, expected));
+
+  // Unpaired surrogates cannot be encoded in UTF-8.
+  az_span const unpaired[] = {
+    AZ_SPAN_FROM_STR("\\uD83D"),
+    AZ_SPAN_FROM_STR("\\uDE00"),
+    AZ_SPAN_FROM_STR("\\uD83D\\u0041"),
+    AZ_SPAN_FROM_STR("\\uD83Dx"),
+  };
+  for (size_t i = 0; i < sizeof(unpaired) / sizeof(unpaired[0]); i++)
+  {
+    json_string = (az_json_token){
+      .kind = AZ_JSON_TOKEN_STRING,
+      .slice = unpaired[i],
+      .size = az_span_size(unpaired[i]),
+      ._internal = {
+        .string_has_escaped_chars = true,
+      },
+    };
+    assert_int_equal(
+        az_json_token_get_string(&json_string, dest, 128, NULL), AZ_ERROR_UNEXPECTED_CHAR);
+    assert_false(az_json_token_is_text_equal(&json_string, AZ_SPAN_FROM_STR("A")));
+  }
+}
+
+// Skips the value of the first property of the JSON object within the buffers both ways, and
+// checks that the reader ends up in the same state.
+static void _az_json_fast_skip_children_compare(az_span buffers[], int32_t number_of_buffers)
+{
+  az_json_reader reader = { 0 };
+  az_json_reader fast_reader = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_reader_chunked_init(&reader, buffers, number_of_buffers, NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  fast_reader = reader;
+
+  TEST_EXPECT_SUCCESS(az_json_reader_skip_children(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_fast_skip_children(&fast_reader));
+  assert_int_equal(fast_reader.token.kind, reader.token.kind);
+  assert_ptr_equal(az_span_ptr(fast_reader.token.slice), az_span_ptr(reader.token.slice));
+  assert_int_equal(fast_reader._internal.buffer_index, reader._internal.buffer_index);
+  assert_int_equal(fast_reader._internal.bytes_consumed, reader._internal.bytes_consumed);
+  assert_int_equal(
+      fast_reader._internal.bit_stack._internal.current_depth,
+      reader._internal.bit_stack._internal.current_depth);
+
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&fast_reader));
+  assert_int_equal(fast_reader.token.kind, AZ_JSON_TOKEN_PROPERTY_NAME);
+  assert_true(az_json_token_is_text_equal(&fast_reader.token, AZ_SPAN_FROM_STR("value")));
+}
+
+static void test_json_fast_skip_children(void** state)
+{
+  (void)state;
+
+  // Strings containing delimiters, quotes and backslashes, and more than a block of bytes.
+  az_span json = AZ_SPAN_FROM_STR(
+      "{\"$metadata\":{\"a\":[1,{\"b\":\"}]\\\"{[\"},[[]],\"\\\\\"],\"long\":\"0123456789"
+      "0123456789012345678901234567890123456789012345678901234567890123456789\\\\\","
+      "\"c\":{\"d\":[true,false,null,-1.5e3]}},\"value\":[]}");
+
+  _az_json_fast_skip_children_compare(&json, 1);
+
+  az_span buffers_half[2] = { 0 };
+  _az_split_buffers(json, buffers_half);
+  _az_json_fast_skip_children_compare(buffers_half, 2);
+
+  // A backslash or a quote ends many of the segments.
+  az_span buffers_one[256] = { 0 };
+  assert_true(az_span_size(json) <= 256);
+  _az_split_buffers_single_byte(json, buffers_one);
+  _az_json_fast_skip_children_compare(buffers_one, az_span_size(json));
+
+  // Values other than objects and arrays have no children.
+  az_json_reader reader = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_reader_init(&reader, AZ_SPAN_FROM_STR("{\"foo\":1}"), NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_fast_skip_children(&reader));
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_NUMBER);
+
+  // The skipped content isn't validated, but its end must match its start.
+  TEST_EXPECT_SUCCESS(
+      az_json_reader_init(&reader, AZ_SPAN_FROM_STR("{\"foo\":{\"a\" 1 x},\"b\":2}"), NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_fast_skip_children(&reader));
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_END_OBJECT);
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  assert_true(az_json_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("b")));
+
+  TEST_EXPECT_SUCCESS(az_json_reader_init(&reader, AZ_SPAN_FROM_STR("{\"foo\":[1}}"), NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  assert_int_equal(az_json_reader_fast_skip_children(&reader), AZ_ERROR_UNEXPECTED_CHAR);
+
+  TEST_EXPECT_SUCCESS(az_json_reader_init(&reader, AZ_SPAN_FROM_STR("{\"foo\":[1,\"]\""), NULL));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  assert_int_equal(az_json_reader_fast_skip_children(&reader), AZ_ERROR_UNEXPECTED_END);
+
+  // An incremental reader waits for the end of the container, then starts over.
+  az_span buffers[4];
+  TEST_EXPECT_SUCCESS(az_json_reader_incremental_init(&reader, buffers, 4, NULL));
+  TEST_EXPECT_SUCCESS(
+      az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR("{\"skip\":{\"a\":\"[\\")));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  assert_int_equal(
+      az_json_reader_fast_skip_children(&reader), AZ_ERROR_JSON_READER_NEED_MORE_DATA);
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_PROPERTY_NAME);
+  TEST_EXPECT_SUCCESS(
+      az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR("\"}\"},\"value\":42}")));
+  TEST_EXPECT_SUCCESS(az_json_reader_fast_skip_children(&reader));
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_END_OBJECT);
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  assert_true(az_json_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("value")));
+}
+
+// Reads the whole JSON payload, one token at a time, the same way with every kind of reader.
+static az_result _az_json_reader_read_all_utf8(az_span json, az_json_reader_options const* options)
+{
+  uint32_t index_buffer[64];
+  az_span buffers_one[64] = { 0 };
+  assert_true(az_span_size(json) <= 64);
+  _az_split_buffers_single_byte(json, buffers_one);
+
+  az_json_reader readers[3] = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_reader_init(&readers[0], json, options));
+  TEST_EXPECT_SUCCESS(az_json_reader_indexed_init(
+      &readers[1],
+      json,
+      az_span_create((uint8_t*)index_buffer, (int32_t)sizeof(index_buffer)),
+      options));
+  TEST_EXPECT_SUCCESS(
+      az_json_reader_chunked_init(&readers[2], buffers_one, az_span_size(json), options));
+
+  az_result results[3] = { AZ_OK, AZ_OK, AZ_OK };
+  for (int32_t i = 0; i < 3; i++)
+  {
+    while (az_result_succeeded(results[i] = az_json_reader_next_token(&readers[i])))
+    {
+    }
+  }
+
+  assert_int_equal(results[1], results[0]);
+  assert_int_equal(results[2], results[0]);
+  return results[0];
+}
+
+static void test_json_reader_validate_utf8(void** state)
+{
+  (void)state;
+
+  az_json_reader_options options = az_json_reader_options_default();
+  assert_false(options.validate_utf8);
+  options.validate_utf8 = true;
+
+  az_span const valid[] = {
+    AZ_SPAN_FROM_STR("\"\xC2\x80 \xDF\xBF \xE0\xA0\x80 \xED\x9F\xBF \xEF\xBF\xBF\""),
+    AZ_SPAN_FROM_STR("{\"caf\xC3\xA9\":[\"\xF0\x90\x80\x80\",\"\\u00e9\xF4\x8F\xBF\xBF\"]}"),
+    AZ_SPAN_FROM_STR("[\"ascii only, escaped \\\" and \\\\\"]"),
+  };
+  for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++)
+  {
+    assert_int_equal(_az_json_reader_read_all_utf8(valid[i], &options), AZ_ERROR_JSON_READER_DONE);
+  }
+
+  az_span const invalid[] = {
+    AZ_SPAN_FROM_STR("\"\x80\""), // continuation byte without a leading byte
+    AZ_SPAN_FROM_STR("\"\xC0\x80\""), // overlong encoding
+    AZ_SPAN_FROM_STR("\"\xE0\x9F\xBF\""), // overlong encoding
+    AZ_SPAN_FROM_STR("\"\xED\xA0\x80\""), // surrogate
+    AZ_SPAN_FROM_STR("\"\xF4\x90\x80\x80\""), // beyond U+10FFFF
+    AZ_SPAN_FROM_STR("\"\xF5\x80\x80\x80\""), // beyond U+10FFFF
+    AZ_SPAN_FROM_STR("\"\xC3\""), // truncated by the closing quote
+    AZ_SPAN_FROM_STR("\"\xE2\x82\\n\""), // truncated by an escape sequence
+    AZ_SPAN_FROM_STR("{\"\xFF\":1}"), // property name
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+  {
+    assert_int_equal(_az_json_reader_read_all_utf8(invalid[i], &options), AZ_ERROR_UNEXPECTED_CHAR);
+
+    // By default, the bytes within strings aren't validated.
+    assert_int_equal(_az_json_reader_read_all_utf8(invalid[i], NULL), AZ_ERROR_JSON_READER_DONE);
+  }
+}
+
+// Reads the single number of a JSON payload, split in two buffers at split_index when it isn't 0.
+static az_json_token _az_json_reader_read_number(
+    az_span json,
+    int32_t split_index,
+    az_json_reader_options const* options,
+    az_span buffers[2])
+{
+  az_json_reader reader = { 0 };
+  if (split_index == 0)
+  {
+    TEST_EXPECT_SUCCESS(az_json_reader_init(&reader, json, options));
+  }
+  else
+  {
+    buffers[0] = az_span_slice(json, 0, split_index);
+    buffers[1] = az_span_slice_to_end(json, split_index);
+    TEST_EXPECT_SUCCESS(az_json_reader_chunked_init(&reader, buffers, 2, options));
+  }
+
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_NUMBER);
+  return reader.token;
+}
+
+static void test_json_reader_parse_integers(void** state)
+{
+  (void)state;
+
+  az_json_reader_options options = az_json_reader_options_default();
+  assert_false(options.parse_integers);
+  options.parse_integers = true;
+
+  // Only integers whose magnitude fits in 64 bits carry their value.
+  struct
+  {
+    char const* number;
+    bool has_integer_value;
+  } const numbers[] = {
+    { "0", true },
+    { "-0", true },
+    { "7", true },
+    { "-42", true },
+    { "2147483647", true },
+    { "2147483648", true },
+    { "-2147483648", true },
+    { "-2147483649", true },
+    { "4294967295", true },
+    { "4294967296", true },
+    { "9007199254740991", true },
+    { "9007199254740993", true },
+    { "-9007199254740993", true },
+    { "9223372036854775807", true },
+    { "9223372036854775808", true },
+    { "-9223372036854775808", true },
+    { "-9223372036854775809", true },
+    { "18446744073709551615", true },
+    { "18446744073709551616", false },
+    { "123456789012345678901234567890", false },
+    { "1.5", false },
+    { "-0.0", false },
+    { "12e3", false },
+  };
+
+
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++)
+  {
+    char json_buffer[64] = { 0 };
+    int const json_size = snprintf(json_buffer, sizeof(json_buffer), "[%s]", numbers[i].number);
+    az_span const json = az_span_create((uint8_t*)json_buffer, json_size);
+
+    // Split within the number, as well as right before its last digit.
+    int32_t const splits[] = { 0, 2, json_size - 2 };
+    for (size_t j = 0; j < sizeof(splits) / sizeof(splits[0]); j++)
+    {
+      az_span parsed_buffers[2] = { 0 };
+      az_span scanned_buffers[2] = { 0 };
+      az_json_token const parsed
+          = _az_json_reader_read_number(json, splits[j], &options, parsed_buffers);
+      az_json_token const scanned
+          = _az_json_reader_read_number(json, splits[j], NULL, scanned_buffers);
+
+      assert_int_equal(parsed._internal.has_integer_value, numbers[i].has_integer_value);
+      assert_false(scanned._internal.has_integer_value);
+
+      // The values, and failures, are the same as when the token is parsed.
+      uint64_t parsed_u64 = 0, scanned_u64 = 0;
+      assert_int_equal(
+          az_json_token_get_uint64(&parsed, &parsed_u64),
+          az_json_token_get_uint64(&scanned, &scanned_u64));
+      assert_true(parsed_u64 == scanned_u64);
+
+      uint32_t parsed_u32 = 0, scanned_u32 = 0;
+      assert_int_equal(
+          az_json_token_get_uint32(&parsed, &parsed_u32),
+          az_json_token_get_uint32(&scanned, &scanned_u32));
+      assert_int_equal(parsed_u32, scanned_u32);
+
+      int64_t parsed_i64 = 0, scanned_i64 = 0;
+      assert_int_equal(
+          az_json_token_get_int64(&parsed, &parsed_i64),
+          az_json_token_get_int64(&scanned, &scanned_i64));
+      assert_true(parsed_i64 == scanned_i64);
+
+      int32_t parsed_i32 = 0, scanned_i32 = 0;
+      assert_int_equal(
+          az_json_token_get_int32(&parsed, &parsed_i32),
+          az_json_token_get_int32(&scanned, &scanned_i32));
+      assert_int_equal(parsed_i32, scanned_i32);
+
+      double parsed_double = 0, scanned_double = 0;
+      assert_int_equal(
+          az_json_token_get_double(&parsed, &parsed_double),
+          az_json_token_get_double(&scanned, &scanned_double));
+      assert_memory_equal(&parsed_double, &scanned_double, sizeof(double));
+    }
+  }
+}
+
 static az_span _az_buffers64_one[64] = { 0 };
 static uint8_t _az_buffer_for_complex_json[64] = { 0 };
 
@@ -2754,6 +3193,1233 @@ static void test_az_json_reader_chunked(void** state)
   assert_true(az_span_is_content_equal(expected, az_span_create_from_str(m.name_string)));
 }
 
+static void _az_json_reader_indexed_compare(az_span json)
+{
+  uint32_t index_buffer[512];
+  assert_true(
+      (size_t)AZ_JSON_READER_STRUCTURAL_INDEX_SIZE(az_span_size(json)) <= sizeof(index_buffer));
+
+  az_json_reader reader = { 0 };
+  az_json_reader indexed_reader = { 0 };
+  assert_int_equal(az_json_reader_init(&reader, json, NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_indexed_init(
+          &indexed_reader,
+          json,
+          az_span_create((uint8_t*)index_buffer, (int32_t)sizeof(index_buffer)),
+          NULL),
+      AZ_OK);
+
+  while (true)
+  {
+    az_result const result = az_json_reader_next_token(&reader);
+    assert_int_equal(az_json_reader_next_token(&indexed_reader), result);
+    if (az_result_failed(result))
+    {
+      break;
+    }
+
+    assert_int_equal(indexed_reader.token.kind, reader.token.kind);
+    assert_int_equal(indexed_reader.token.size, reader.token.size);
+    assert_true(az_span_is_content_equal(indexed_reader.token.slice, reader.token.slice));
+    assert_true(az_span_ptr(indexed_reader.token.slice) == az_span_ptr(reader.token.slice));
+    assert_int_equal(
+        indexed_reader.token._internal.string_has_escaped_chars,
+        reader.token._internal.string_has_escaped_chars);
+    assert_int_equal(
+        indexed_reader._internal.total_bytes_consumed, reader._internal.total_bytes_consumed);
+  }
+}
+
+static void test_az_json_reader_indexed(void** state)
+{
+  (void)state;
+
+  // Tokens and errors are the same as those of the byte by byte reader.
+  az_span const payloads[] = {
+    AZ_SPAN_FROM_STR(" { \"name\": \"some value string\" , \"code\" : 123456 } "),
+    AZ_SPAN_FROM_STR("{\"desired\":{\"targetTemperature\":21.5,\"$version\":12},\"reported\":{"
+                     "\"manufacturer\":\"Contoso Industries\",\"serialNumber\":\"A1B2C3D4E5F6\","
+                     "\"enabled\":true,\"fault\":false,\"lastError\":null,\"readings\":[1,-2,3."
+                     "5e10,0,[],{}],\"$version\":3}}"),
+    AZ_SPAN_FROM_STR("[\"escaped \\\" quote\", \"backslash \\\\\", \"unicode \\u00e9\", \"\"]"),
+    // A backslash at the end of the first 64-byte block escapes the first byte of the next one.
+    AZ_SPAN_FROM_STR("[\"0123456789012345678901234567890123456789012345678901234567890\\\"\",1]"),
+    AZ_SPAN_FROM_STR("[\"0123456789012345678901234567890123456789012345678901234567890\\\\\",1]"),
+    AZ_SPAN_FROM_STR("[\"012345678901234567890123456789012345678901234567890123456789\\\\\",1]"),
+    AZ_SPAN_FROM_STR("\"single string\""),
+    AZ_SPAN_FROM_STR("  -12.5e+3  "),
+    AZ_SPAN_FROM_STR("true"),
+    AZ_SPAN_FROM_STR("[truex]"),
+    AZ_SPAN_FROM_STR("[true x]"),
+    AZ_SPAN_FROM_STR("[1,2"),
+    AZ_SPAN_FROM_STR("{\"a\":\"unterminated}"),
+    AZ_SPAN_FROM_STR("{\"a\" \"b\"}"),
+    AZ_SPAN_FROM_STR("[\"tab\tinside\"]"),
+    AZ_SPAN_FROM_STR("[\"bad \\x escape\"]"),
+    AZ_SPAN_FROM_STR("[\"a\"\"b\"]"),
+    AZ_SPAN_FROM_STR("{}]"),
+    AZ_SPAN_FROM_STR("[1,]"),
+  };
+
+  for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++)
+  {
+    _az_json_reader_indexed_compare(payloads[i]);
+  }
+
+  // The structural index must have room for every structural position.
+  {
+    uint32_t index_buffer[4];
+    az_json_reader reader = { 0 };
+    assert_int_equal(
+        az_json_reader_indexed_init(
+            &reader,
+            AZ_SPAN_FROM_STR("[1,2,3]"),
+            az_span_create((uint8_t*)index_buffer, (int32_t)sizeof(index_buffer)),
+            NULL),
+        AZ_ERROR_NOT_ENOUGH_SPACE);
+  }
+}
+
+static az_span const _az_json_path_twin = AZ_SPAN_LITERAL_FROM_STR(
+    "{\"properties\":{\"desired\":{\"thermostat1\":{\"__t\":\"c\",\"targetTemperature\":21.5},"
+    "\"$version\":4,\"skipped\":[{\"targetTemperature\":1},[2,3]]},\"reported\":{\"readings\":["
+    "10,[20,21],{\"value\":30}],\"a\\/b\":\"escaped\"}}}");
+
+static void test_az_json_reader_find_path(void** state)
+{
+  (void)state;
+
+  az_json_reader reader = { 0 };
+  int32_t version = 0;
+  double temperature = 0;
+
+  assert_int_equal(az_json_reader_init(&reader, _az_json_path_twin, NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_find_path(
+          &reader, AZ_SPAN_FROM_STR("properties.desired.thermostat1.targetTemperature")),
+      AZ_OK);
+  assert_int_equal(az_json_token_get_double(&reader.token, &temperature), AZ_OK);
+  assert_true(_is_double_equal(temperature, 21.5, 1e-9));
+
+  // The reader can keep looking up paths relative to where it is.
+  assert_int_equal(az_json_reader_init(&reader, _az_json_path_twin, NULL), AZ_OK);
+  assert_int_equal(az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("properties")), AZ_OK);
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_BEGIN_OBJECT);
+  assert_int_equal(
+      az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("desired.$version")), AZ_OK);
+  assert_int_equal(az_json_token_get_int32(&reader.token, &version), AZ_OK);
+  assert_int_equal(version, 4);
+
+  // Array indexes and escaped property names.
+  assert_int_equal(az_json_reader_init(&reader, _az_json_path_twin, NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("properties.reported.readings.1.0")),
+      AZ_OK);
+  assert_int_equal(az_json_token_get_int32(&reader.token, &version), AZ_OK);
+  assert_int_equal(version, 20);
+
+  assert_int_equal(az_json_reader_init(&reader, _az_json_path_twin, NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("properties.reported.a/b")), AZ_OK);
+  assert_true(az_json_token_is_text_equal(&reader.token, AZ_SPAN_FROM_STR("escaped")));
+
+  // Missing paths.
+  az_span const missing[] = {
+    AZ_SPAN_FROM_STR("properties.desired.thermostat2"),
+    AZ_SPAN_FROM_STR("properties.reported.readings.3"),
+    AZ_SPAN_FROM_STR("properties.reported.readings.x"),
+    AZ_SPAN_FROM_STR("properties.desired.$version.value"),
+  };
+  for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++)
+  {
+    assert_int_equal(az_json_reader_init(&reader, _az_json_path_twin, NULL), AZ_OK);
+    assert_int_equal(az_json_reader_find_path(&reader, missing[i]), AZ_ERROR_ITEM_NOT_FOUND);
+  }
+
+  // Invalid JSON is reported as such.
+  assert_int_equal(az_json_reader_init(&reader, AZ_SPAN_FROM_STR("{\"a\":[1,}"), NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("b")), AZ_ERROR_UNEXPECTED_CHAR);
+}
+
+static void test_az_json_reader_find_paths(void** state)
+{
+  (void)state;
+
+  az_json_path_lookup lookups[] = {
+    { .path = AZ_SPAN_LITERAL_FROM_STR("properties.reported.readings.2.value") },
+    { .path = AZ_SPAN_LITERAL_FROM_STR("properties.desired.thermostat1.targetTemperature") },
+    { .path = AZ_SPAN_LITERAL_FROM_STR("properties.desired.$version") },
+    { .path = AZ_SPAN_LITERAL_FROM_STR("properties.desired.thermostat2") },
+    { .path = AZ_SPAN_LITERAL_FROM_STR("properties.reported") },
+    { .path = AZ_SPAN_LITERAL_FROM_STR("") },
+  };
+
+  az_json_reader reader = { 0 };
+  assert_int_equal(az_json_reader_init(&reader, _az_json_path_twin, NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_find_paths(&reader, lookups, sizeof(lookups) / sizeof(lookups[0])), AZ_OK);
+
+  int32_t value = 0;
+  double temperature = 0;
+  assert_int_equal(az_json_token_get_int32(&lookups[0].value, &value), AZ_OK);
+  assert_int_equal(value, 30);
+  assert_int_equal(az_json_token_get_double(&lookups[1].value, &temperature), AZ_OK);
+  assert_true(_is_double_equal(temperature, 21.5, 1e-9));
+  assert_int_equal(az_json_token_get_int32(&lookups[2].value, &value), AZ_OK);
+  assert_int_equal(value, 4);
+  assert_int_equal(lookups[3].value.kind, AZ_JSON_TOKEN_NONE);
+  assert_int_equal(lookups[4].value.kind, AZ_JSON_TOKEN_BEGIN_OBJECT);
+  assert_int_equal(lookups[5].value.kind, AZ_JSON_TOKEN_BEGIN_OBJECT);
+
+  // Reading stops as soon as every path is found.
+  az_json_path_lookup first[] = { { .path = AZ_SPAN_LITERAL_FROM_STR("a") } };
+  assert_int_equal(
+      az_json_reader_init(&reader, AZ_SPAN_FROM_STR("{\"a\":1,\"b\":[1,}"), NULL), AZ_OK);
+  assert_int_equal(az_json_reader_find_paths(&reader, first, 1), AZ_OK);
+  assert_int_equal(first[0].value.kind, AZ_JSON_TOKEN_NUMBER);
+}
+
+static void test_az_json_property_matcher(void** state)
+{
+  (void)state;
+
+  static az_span const names[] = {
+    AZ_SPAN_LITERAL_FROM_STR("targetTemperature"),
+    AZ_SPAN_LITERAL_FROM_STR("maxTempSinceLastReboot"),
+    AZ_SPAN_LITERAL_FROM_STR("$version"),
+    AZ_SPAN_LITERAL_FROM_STR("a/b"),
+    AZ_SPAN_LITERAL_FROM_STR("tarGetTemperature"),
+    AZ_SPAN_LITERAL_FROM_STR(""),
+  };
+
+  az_json_property_matcher matcher = { 0 };
+  assert_int_equal(
+      az_json_property_matcher_init(&matcher, names, sizeof(names) / sizeof(names[0])), AZ_OK);
+
+  az_json_reader reader = { 0 };
+  assert_int_equal(
+      az_json_reader_init(
+          &reader,
+          AZ_SPAN_FROM_STR("{\"$version\":1,\"targetTemperature\":2,\"tarGetTemperature\":3,"
+                           "\"targetTemperaturf\":4,\"a\\/b\":5,\"\":6,\"other\":\"a/b\"}"),
+          NULL),
+      AZ_OK);
+
+  int32_t const expected[] = { 2, 0, 4, -1, 3, 5, -1 };
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  assert_int_equal(az_json_property_matcher_find(&matcher, &reader.token), -1);
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+  {
+    assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+    assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_PROPERTY_NAME);
+    assert_int_equal(az_json_property_matcher_find(&matcher, &reader.token), expected[i]);
+    assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  }
+
+  // String values are matched too.
+  assert_int_equal(az_json_property_matcher_find(&matcher, &reader.token), 3);
+}
+
+static void _az_json_reader_incremental_compare(az_span json, int32_t chunk_size)
+{
+  az_json_reader reader = { 0 };
+  assert_int_equal(az_json_reader_init(&reader, json, NULL), AZ_OK);
+
+  az_span buffers[128];
+  az_json_reader incremental_reader = { 0 };
+  assert_int_equal(
+      az_json_reader_incremental_init(
+          &incremental_reader, buffers, sizeof(buffers) / sizeof(buffers[0]), NULL),
+      AZ_OK);
+
+  az_span remaining = json;
+  while (true)
+  {
+    az_result const expected = az_json_reader_next_token(&reader);
+    az_result result = AZ_OK;
+
+    // Only feed more data when the reader asks for it.
+    while ((result = az_json_reader_next_token(&incremental_reader))
+           == AZ_ERROR_JSON_READER_NEED_MORE_DATA)
+    {
+      if (az_span_size(remaining) == 0)
+      {
+        az_json_reader_incremental_end(&incremental_reader);
+        continue;
+      }
+
+      int32_t const size
+          = az_span_size(remaining) < chunk_size ? az_span_size(remaining) : chunk_size;
+      assert_int_equal(
+          az_json_reader_incremental_feed(&incremental_reader, az_span_slice(remaining, 0, size)),
+          AZ_OK);
+      remaining = az_span_slice_to_end(remaining, size);
+    }
+
+    assert_int_equal(result, expected);
+    if (az_result_failed(result))
+    {
+      break;
+    }
+
+    uint8_t expected_text[64] = { 0 };
+    uint8_t text[64] = { 0 };
+    assert_int_equal(incremental_reader.token.kind, reader.token.kind);
+    assert_int_equal(incremental_reader.token.size, reader.token.size);
+    az_json_token_copy_into_span(&reader.token, AZ_SPAN_FROM_BUFFER(expected_text));
+    az_json_token_copy_into_span(&incremental_reader.token, AZ_SPAN_FROM_BUFFER(text));
+    assert_memory_equal(text, expected_text, sizeof(text));
+  }
+}
+
+static void test_az_json_reader_incremental(void** state)
+{
+  (void)state;
+
+  az_span const payloads[] = {
+    AZ_SPAN_FROM_STR(" { \"name\": \"some \\\" value\" , \"code\" : -123.5e+6, \"list\" : [ true,"
+                     "false , null,{}, [] ] } "),
+    AZ_SPAN_FROM_STR("12345"),
+    AZ_SPAN_FROM_STR("\"single string\""),
+    AZ_SPAN_FROM_STR("[1,2"),
+    AZ_SPAN_FROM_STR("{\"a\":tru"),
+    AZ_SPAN_FROM_STR("[1,2]x"),
+  };
+
+  for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++)
+  {
+    for (int32_t chunk_size = 1; chunk_size <= 7; chunk_size += 3)
+    {
+      _az_json_reader_incremental_compare(payloads[i], chunk_size);
+    }
+  }
+
+  // An empty stream is only incomplete once the caller says no more data is coming.
+  az_span buffers[4];
+  az_json_reader reader = { 0 };
+  assert_int_equal(az_json_reader_incremental_init(&reader, buffers, 4, NULL), AZ_OK);
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_ERROR_JSON_READER_NEED_MORE_DATA);
+  az_json_reader_incremental_end(&reader);
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_ERROR_UNEXPECTED_END);
+
+  // Skipping children and looking up paths also wait for more data, then start over.
+  assert_int_equal(az_json_reader_incremental_init(&reader, buffers, 4, NULL), AZ_OK);
+  assert_int_equal(
+      az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR("{\"skip\":{\"a\":[1,")), AZ_OK);
+  assert_int_equal(
+      az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("value")),
+      AZ_ERROR_JSON_READER_NEED_MORE_DATA);
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_NONE);
+  assert_int_equal(
+      az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR("2]},\"value\":42}")), AZ_OK);
+  assert_int_equal(az_json_reader_find_path(&reader, AZ_SPAN_FROM_STR("value")), AZ_OK);
+
+  int32_t value = 0;
+  assert_int_equal(az_json_token_get_int32(&reader.token, &value), AZ_OK);
+  assert_int_equal(value, 42);
+
+  // The array of buffers is bounded.
+  assert_int_equal(az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR(" ")), AZ_OK);
+  assert_int_equal(az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR(" ")), AZ_OK);
+  assert_int_equal(
+      az_json_reader_incremental_feed(&reader, AZ_SPAN_FROM_STR(" ")), AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_json_deep_nesting(void** state)
+{
+  (void)state;
+
+  // Alternate objects and arrays, so that every depth has to be restored correctly on the way out.
+  enum
+  {
+    max_depth = 200
+  };
+  uint8_t stack_buffer[AZ_JSON_NESTING_STACK_BUFFER_SIZE(max_depth)] = { 0 };
+  assert_int_equal(sizeof(stack_buffer), 17);
+  assert_int_equal(AZ_JSON_NESTING_STACK_BUFFER_SIZE(64), 0);
+
+  uint8_t json_buffer[max_depth * 5] = { 0 };
+  az_json_writer_options writer_options = az_json_writer_options_default();
+  writer_options.nesting_stack_buffer = AZ_SPAN_FROM_BUFFER(stack_buffer);
+  az_json_writer writer = { 0 };
+  assert_int_equal(
+      az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), &writer_options), AZ_OK);
+
+  for (int32_t depth = 0; depth < max_depth; depth++)
+  {
+    if (depth % 3 == 0)
+    {
+      assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+    }
+    else
+    {
+      assert_int_equal(az_json_writer_append_begin_object(&writer), AZ_OK);
+      assert_int_equal(az_json_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("a")), AZ_OK);
+    }
+  }
+  assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_ERROR_JSON_NESTING_OVERFLOW);
+  assert_int_equal(az_json_writer_append_int32(&writer, 1), AZ_OK);
+
+  for (int32_t depth = max_depth - 1; depth >= 0; depth--)
+  {
+    assert_int_equal(
+        depth % 3 == 0 ? az_json_writer_append_end_array(&writer)
+                       : az_json_writer_append_end_object(&writer),
+        AZ_OK);
+  }
+
+  az_span const json = az_json_writer_get_bytes_used_in_destination(&writer);
+
+  // Without a nesting stack buffer, the reader stops at a depth of 64.
+  az_json_reader reader = { 0 };
+  assert_int_equal(az_json_reader_init(&reader, json, NULL), AZ_OK);
+  az_result result = AZ_OK;
+  while ((result = az_json_reader_next_token(&reader)) == AZ_OK)
+  {
+  }
+  assert_int_equal(result, AZ_ERROR_JSON_NESTING_OVERFLOW);
+
+  az_json_reader_options reader_options = az_json_reader_options_default();
+  reader_options.nesting_stack_buffer = AZ_SPAN_FROM_BUFFER(stack_buffer);
+  assert_int_equal(az_json_reader_init(&reader, json, &reader_options), AZ_OK);
+
+  for (int32_t depth = 0; depth < max_depth; depth++)
+  {
+    assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+    if (depth % 3 == 0)
+    {
+      assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_BEGIN_ARRAY);
+    }
+    else
+    {
+      assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_BEGIN_OBJECT);
+      assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+      assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_PROPERTY_NAME);
+    }
+  }
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+  assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_NUMBER);
+
+  for (int32_t depth = max_depth - 1; depth >= 0; depth--)
+  {
+    assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+    assert_int_equal(
+        reader.token.kind, depth % 3 == 0 ? AZ_JSON_TOKEN_END_ARRAY : AZ_JSON_TOKEN_END_OBJECT);
+  }
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_ERROR_JSON_READER_DONE);
+
+  // Mismatched closing characters are still detected beyond a depth of 64.
+  json_buffer[az_span_size(json) - 1 - 100] = ']';
+  assert_int_equal(az_json_reader_init(&reader, json, &reader_options), AZ_OK);
+  while ((result = az_json_reader_next_token(&reader)) == AZ_OK)
+  {
+  }
+  assert_int_equal(result, AZ_ERROR_UNEXPECTED_CHAR);
+}
+
+static void test_json_writer_escape_long_string(void** state)
+{
+  (void)state;
+
+  // Move a single byte to escape through a long string, so that it is found in every position of
+  // the blocks scanned at once, as well as in the bytes left over after the last block.
+  az_span const escapes[] = {
+    AZ_SPAN_FROM_STR("\\\""), AZ_SPAN_FROM_STR("\\\\"), AZ_SPAN_FROM_STR("\\n"),
+    AZ_SPAN_FROM_STR("\\u0001"), AZ_SPAN_FROM_STR("\\u001F"),
+  };
+  uint8_t const escaped_bytes[] = { '"', '\\', '\n', 0x01, 0x1F };
+
+  for (size_t e = 0; e < sizeof(escaped_bytes); e++)
+  {
+    for (int32_t position = 0; position < 100; position++)
+    {
+      // Space, tilde, DEL and bytes above 0x7F are written as is.
+      uint8_t value[100] = { 0 };
+      uint8_t expected[110] = { 0 };
+      az_span remaining = AZ_SPAN_FROM_BUFFER(expected);
+      remaining = az_span_copy_u8(remaining, '"');
+      for (int32_t i = 0; i < (int32_t)sizeof(value); i++)
+      {
+        uint8_t const background[] = { ' ', '~', 0x7F, 0xA9 };
+        value[i] = i == position ? escaped_bytes[e] : background[i % 4];
+        remaining = i == position ? az_span_copy(remaining, escapes[e])
+                                  : az_span_copy_u8(remaining, value[i]);
+      }
+      remaining = az_span_copy_u8(remaining, '"');
+      az_span const expected_json
+          = az_span_slice(AZ_SPAN_FROM_BUFFER(expected), 0, 110 - az_span_size(remaining));
+
+      // Long strings need room for a full chunk after each byte written.
+      uint8_t json_buffer[256] = { 0 };
+      az_json_writer writer = { 0 };
+      assert_int_equal(
+          az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL), AZ_OK);
+      assert_int_equal(az_json_writer_append_string(&writer, AZ_SPAN_FROM_BUFFER(value)), AZ_OK);
+      az_span const json = az_json_writer_get_bytes_used_in_destination(&writer);
+      assert_true(az_span_is_content_equal(json, expected_json));
+    }
+  }
+}
+
+static void test_json_writer_append_double_shortest(void** state)
+{
+  (void)state;
+
+  uint8_t json_buffer[100] = { 0 };
+  az_json_writer writer = { 0 };
+  assert_int_equal(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL), AZ_OK);
+
+  assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_append_double_shortest(&writer, 21.5), AZ_OK);
+  assert_int_equal(az_json_writer_append_double_shortest(&writer, 0.1 + 0.2), AZ_OK);
+  assert_int_equal(az_json_writer_append_double_shortest(&writer, -1e100), AZ_OK);
+  assert_int_equal(az_json_writer_append_double_shortest(&writer, 3), AZ_OK);
+  assert_int_equal(az_json_writer_append_end_array(&writer), AZ_OK);
+
+  az_span const expected = AZ_SPAN_FROM_STR("[21.5,0.30000000000000004,-1e+100,3]");
+  assert_true(
+      az_span_is_content_equal(az_json_writer_get_bytes_used_in_destination(&writer), expected));
+
+  // The writer asks for enough room to write any double.
+  assert_int_equal(
+      az_json_writer_init(&writer, az_span_slice(AZ_SPAN_FROM_BUFFER(json_buffer), 0, 24), NULL),
+      AZ_OK);
+  assert_int_equal(az_json_writer_append_double_shortest(&writer, 1), AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_json_writer_append_scaled_int64(void** state)
+{
+  (void)state;
+
+  uint8_t json_buffer[200] = { 0 };
+  az_json_writer writer = { 0 };
+  assert_int_equal(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL), AZ_OK);
+
+  assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, 2150, 2), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, 2155, 2), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, -5, 2), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, 0, 3), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, 7, 0), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, -1000, 3), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, INT64_MIN, 18), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, INT64_MAX, 0), AZ_OK);
+  assert_int_equal(az_json_writer_append_end_array(&writer), AZ_OK);
+
+  az_span const expected = AZ_SPAN_FROM_STR(
+      "[21.5,21.55,-0.05,0,7,-1,-9.223372036854775808,9223372036854775807]");
+  assert_true(
+      az_span_is_content_equal(az_json_writer_get_bytes_used_in_destination(&writer), expected));
+
+  // Only the room the number and its comma need is asked for, and nothing is written without it.
+  assert_int_equal(
+      az_json_writer_init(&writer, az_span_slice(AZ_SPAN_FROM_BUFFER(json_buffer), 0, 7), NULL),
+      AZ_OK);
+  assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, -2155, 2), AZ_OK);
+  assert_int_equal(az_json_writer_append_scaled_int64(&writer, 1, 0), AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_true(az_span_is_content_equal(
+      az_json_writer_get_bytes_used_in_destination(&writer), AZ_SPAN_FROM_STR("[-21.55")));
+}
+
+static void test_json_writer_append_timestamp(void** state)
+{
+  (void)state;
+
+  uint8_t json_buffer[200] = { 0 };
+  az_json_writer writer = { 0 };
+  assert_int_equal(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL), AZ_OK);
+
+  az_span_timestamp_cache cache;
+  az_span_timestamp_cache_init(&cache);
+  assert_int_equal(az_json_writer_append_begin_object(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("start")), AZ_OK);
+  assert_int_equal(az_json_writer_append_timestamp(&writer, 1602633600123, &cache), AZ_OK);
+  assert_int_equal(az_json_writer_append_property_name(&writer, AZ_SPAN_FROM_STR("end")), AZ_OK);
+  assert_int_equal(az_json_writer_append_timestamp(&writer, 1602634205007, &cache), AZ_OK);
+  assert_int_equal(az_json_writer_append_end_object(&writer), AZ_OK);
+
+  az_span const expected = AZ_SPAN_FROM_STR(
+      "{\"start\":\"2020-10-14T00:00:00.123Z\",\"end\":\"2020-10-14T00:10:05.007Z\"}");
+  assert_true(
+      az_span_is_content_equal(az_json_writer_get_bytes_used_in_destination(&writer), expected));
+
+  assert_int_equal(
+      az_json_writer_init(&writer, az_span_slice(AZ_SPAN_FROM_BUFFER(json_buffer), 0, 25), NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_json_writer_append_timestamp(&writer, 1602633600123, NULL), AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_json_token_get_double_multisegment(void** state)
+{
+  (void)state;
+
+  az_span buffers[] = {
+    AZ_SPAN_FROM_STR("[12."),
+    AZ_SPAN_FROM_STR("5e"),
+    AZ_SPAN_FROM_STR("-3, -0.0000123456789"),
+    AZ_SPAN_FROM_STR("01, 1234567890"),
+    AZ_SPAN_FROM_STR("123456789012, 1"),
+    AZ_SPAN_FROM_STR("e23]"),
+  };
+  double const expected[] = { 12.5e-3, -0.000012345678901, 1234567890123456789012.0, 1e23 };
+
+  az_json_reader reader = { 0 };
+  assert_int_equal(
+      az_json_reader_chunked_init(&reader, buffers, sizeof(buffers) / sizeof(buffers[0]), NULL),
+      AZ_OK);
+  assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+  {
+    assert_int_equal(az_json_reader_next_token(&reader), AZ_OK);
+    assert_int_equal(reader.token.kind, AZ_JSON_TOKEN_NUMBER);
+    assert_true(reader.token._internal.is_multisegment);
+
+    double value = 0;
+    assert_int_equal(az_json_token_get_double(&reader.token, &value), AZ_OK);
+    assert_memory_equal(&value, &expected[i], sizeof(double));
+  }
+}
+
+static void test_az_json_template(void** state)
+{
+  (void)state;
+
+  az_json_template_field fields[] = {
+    { .name = AZ_SPAN_LITERAL_FROM_STR("temp"), .kind = AZ_JSON_TEMPLATE_FIELD_DOUBLE },
+    { .name = AZ_SPAN_LITERAL_FROM_STR("hu\"mi"), .kind = AZ_JSON_TEMPLATE_FIELD_INT32 },
+    { .name = AZ_SPAN_LITERAL_FROM_STR("ts"), .kind = AZ_JSON_TEMPLATE_FIELD_INT64 },
+    { .name = AZ_SPAN_LITERAL_FROM_STR("on"), .kind = AZ_JSON_TEMPLATE_FIELD_BOOLEAN },
+  };
+
+  uint8_t fragment_buffer[64] = { 0 };
+  az_json_template json_template = { 0 };
+  assert_int_equal(
+      az_json_template_compile(&json_template, fields, 4, AZ_SPAN_FROM_BUFFER(fragment_buffer)),
+      AZ_OK);
+
+  az_json_template_value values[4];
+  values[0].double_value = 21.5;
+  values[1].int32_value = -40;
+  values[2].int64_value = 5000000000;
+  values[3].boolean_value = true;
+
+  az_span const expected
+      = AZ_SPAN_FROM_STR("{\"temp\":21.5,\"hu\\\"mi\":-40,\"ts\":5000000000,\"on\":true}");
+
+  uint8_t json_buffer[100] = { 0 };
+  az_span json = AZ_SPAN_EMPTY;
+  assert_int_equal(
+      az_json_template_write(&json_template, values, AZ_SPAN_FROM_BUFFER(json_buffer), &json),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(json, expected));
+
+  // The template can be written again with other values.
+  values[0].double_value = 0.1 + 0.2;
+  values[3].boolean_value = false;
+  assert_int_equal(
+      az_json_template_write(&json_template, values, AZ_SPAN_FROM_BUFFER(json_buffer), &json),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(
+      json,
+      AZ_SPAN_FROM_STR(
+          "{\"temp\":0.30000000000000004,\"hu\\\"mi\":-40,\"ts\":5000000000,\"on\":false}")));
+
+  // It's an error when the destination is one byte too small.
+  values[0].double_value = 21.5;
+  values[3].boolean_value = true;
+  az_span const destination = AZ_SPAN_FROM_BUFFER(json_buffer);
+  assert_int_equal(
+      az_json_template_write(
+          &json_template,
+          values,
+          az_span_slice(destination, 0, az_span_size(expected) - 1),
+          &json),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_json_template_write(
+          &json_template, values, az_span_slice(destination, 0, az_span_size(expected)), &json),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(json, expected));
+
+  // The fragments of this template are 31 bytes long.
+  assert_int_equal(
+      az_json_template_compile(
+          &json_template, fields, 4, az_span_slice(AZ_SPAN_FROM_BUFFER(fragment_buffer), 0, 30)),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_json_template_compile(
+          &json_template, fields, 4, az_span_slice(AZ_SPAN_FROM_BUFFER(fragment_buffer), 0, 31)),
+      AZ_OK);
+
+  // A template without fields writes an empty object.
+  assert_int_equal(
+      az_json_template_compile(&json_template, NULL, 0, AZ_SPAN_FROM_BUFFER(fragment_buffer)),
+      AZ_OK);
+  assert_int_equal(az_json_template_write(&json_template, NULL, destination, &json), AZ_OK);
+  assert_true(az_span_is_content_equal(json, AZ_SPAN_FROM_STR("{}")));
+}
+
+static az_result _test_json_writer_build_document(az_json_writer* ref_json_writer)
+{
+  uint8_t long_value[300] = { 0 };
+  for (int32_t i = 0; i < (int32_t)sizeof(long_value); i++)
+  {
+    long_value[i] = i % 50 == 0 ? '"' : (i % 70 == 0 ? 0x01 : 'a');
+  }
+
+  _az_RETURN_IF_FAILED(az_json_writer_append_begin_object(ref_json_writer));
+  _az_RETURN_IF_FAILED(
+      az_json_writer_append_property_name(ref_json_writer, AZ_SPAN_FROM_STR("short\\\n")));
+  _az_RETURN_IF_FAILED(az_json_writer_append_string(ref_json_writer, AZ_SPAN_FROM_STR("a\"b")));
+  _az_RETURN_IF_FAILED(az_json_writer_append_property_name(
+      ref_json_writer, az_span_slice(AZ_SPAN_FROM_BUFFER(long_value), 1, 200)));
+  _az_RETURN_IF_FAILED(
+      az_json_writer_append_string(ref_json_writer, AZ_SPAN_FROM_BUFFER(long_value)));
+  _az_RETURN_IF_FAILED(
+      az_json_writer_append_property_name(ref_json_writer, AZ_SPAN_FROM_STR("numbers")));
+  _az_RETURN_IF_FAILED(az_json_writer_append_begin_array(ref_json_writer));
+  _az_RETURN_IF_FAILED(az_json_writer_append_int32(ref_json_writer, INT32_MIN));
+  _az_RETURN_IF_FAILED(az_json_writer_append_int32(ref_json_writer, 7));
+  _az_RETURN_IF_FAILED(az_json_writer_append_double(ref_json_writer, -1.25, 3));
+  _az_RETURN_IF_FAILED(az_json_writer_append_double_shortest(ref_json_writer, 0.1));
+  _az_RETURN_IF_FAILED(az_json_writer_append_bool(ref_json_writer, false));
+  _az_RETURN_IF_FAILED(az_json_writer_append_null(ref_json_writer));
+  _az_RETURN_IF_FAILED(
+      az_json_writer_append_json_text(ref_json_writer, AZ_SPAN_FROM_STR("{\"x\":[1, 2]}")));
+  _az_RETURN_IF_FAILED(az_json_writer_append_end_array(ref_json_writer));
+  return az_json_writer_append_end_object(ref_json_writer);
+}
+
+static void test_json_writer_measure(void** state)
+{
+  (void)state;
+
+  az_json_writer measuring_writer = { 0 };
+  assert_int_equal(az_json_writer_measure_init(&measuring_writer, NULL), AZ_OK);
+  assert_int_equal(_test_json_writer_build_document(&measuring_writer), AZ_OK);
+
+  // Nothing is written, and the count is the exact size of the JSON written to a buffer.
+  assert_int_equal(
+      az_span_size(az_json_writer_get_bytes_used_in_destination(&measuring_writer)), 0);
+
+  uint8_t json_buffer[1024] = { 0 };
+  az_json_writer writer = { 0 };
+  assert_int_equal(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL), AZ_OK);
+  assert_int_equal(_test_json_writer_build_document(&writer), AZ_OK);
+  assert_int_equal(
+      az_json_writer_get_total_bytes_written(&measuring_writer),
+      az_span_size(az_json_writer_get_bytes_used_in_destination(&writer)));
+  assert_int_equal(
+      az_json_writer_get_total_bytes_written(&measuring_writer),
+      az_json_writer_get_total_bytes_written(&writer));
+
+  // Invalid input is rejected as when writing.
+  assert_int_equal(
+      az_json_writer_append_json_text(&measuring_writer, AZ_SPAN_FROM_STR("{")),
+      AZ_ERROR_UNEXPECTED_END);
+}
+
+typedef struct
+{
+  uint8_t json[1024];
+  int32_t json_size;
+  int32_t chunk_count;
+  int32_t succeeding_chunks;
+} _test_json_sink;
+
+static az_result _test_json_writer_flush(void* user_context, az_span chunk)
+{
+  _test_json_sink* const sink = (_test_json_sink*)user_context;
+  if (sink->chunk_count == sink->succeeding_chunks)
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  assert_true(az_span_size(chunk) > 0);
+  az_span_copy(az_span_slice_to_end(AZ_SPAN_FROM_BUFFER(sink->json), sink->json_size), chunk);
+  sink->json_size += az_span_size(chunk);
+  sink->chunk_count++;
+  return AZ_OK;
+}
+
+static void test_json_writer_sink(void** state)
+{
+  (void)state;
+
+  _test_json_sink sink
+      = { .json = { 0 }, .json_size = 0, .chunk_count = 0, .succeeding_chunks = 100 };
+  uint8_t scratch[64] = { 0 };
+  az_json_writer writer = { 0 };
+  assert_int_equal(
+      az_json_writer_sink_init(
+          &writer, AZ_SPAN_FROM_BUFFER(scratch), _test_json_writer_flush, &sink, NULL),
+      AZ_OK);
+  assert_int_equal(_test_json_writer_build_document(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_flush(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_flush(&writer), AZ_OK);
+
+  // The scratch buffer was reused for each chunk, and the chunks make up the whole JSON.
+  uint8_t json_buffer[1024] = { 0 };
+  az_json_writer expected_writer = { 0 };
+  assert_int_equal(
+      az_json_writer_init(&expected_writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL), AZ_OK);
+  assert_int_equal(_test_json_writer_build_document(&expected_writer), AZ_OK);
+  assert_true(sink.chunk_count > 1);
+  assert_true(az_span_is_content_equal(
+      az_span_slice(AZ_SPAN_FROM_BUFFER(sink.json), 0, sink.json_size),
+      az_json_writer_get_bytes_used_in_destination(&expected_writer)));
+  assert_int_equal(az_json_writer_get_total_bytes_written(&writer), sink.json_size);
+
+  // A failing callback fails the append which needed room.
+  _test_json_sink failing_sink
+      = { .json = { 0 }, .json_size = 0, .chunk_count = 0, .succeeding_chunks = 1 };
+  assert_int_equal(
+      az_json_writer_sink_init(
+          &writer, AZ_SPAN_FROM_BUFFER(scratch), _test_json_writer_flush, &failing_sink, NULL),
+      AZ_OK);
+  assert_int_equal(_test_json_writer_build_document(&writer), AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(failing_sink.chunk_count, 1);
+}
+
+static void test_json_writer_reset(void** state)
+{
+  (void)state;
+
+  uint8_t expected_buffer[1024] = { 0 };
+  az_json_writer expected_writer = { 0 };
+  assert_int_equal(
+      az_json_writer_init(&expected_writer, AZ_SPAN_FROM_BUFFER(expected_buffer), NULL), AZ_OK);
+  assert_int_equal(_test_json_writer_build_document(&expected_writer), AZ_OK);
+  az_span const expected = az_json_writer_get_bytes_used_in_destination(&expected_writer);
+
+  // A reset writer writes the same JSON as a new one, wherever the previous JSON text stopped.
+  uint8_t nesting_stack[AZ_JSON_NESTING_STACK_BUFFER_SIZE(80)] = { 0 };
+  az_json_writer_options options = az_json_writer_options_default();
+  options.nesting_stack_buffer = AZ_SPAN_FROM_BUFFER(nesting_stack);
+
+  uint8_t first_buffer[16] = { 0 };
+  az_json_writer writer = { 0 };
+  assert_int_equal(
+      az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(first_buffer), &options), AZ_OK);
+  for (int32_t i = 0; i < 16; i++)
+  {
+    assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+  }
+
+  uint8_t json_buffer[1024] = { 0 };
+  az_json_writer_reset(&writer, AZ_SPAN_FROM_BUFFER(json_buffer));
+  assert_int_equal(az_json_writer_get_total_bytes_written(&writer), 0);
+  assert_int_equal(_test_json_writer_build_document(&writer), AZ_OK);
+  assert_true(
+      az_span_is_content_equal(az_json_writer_get_bytes_used_in_destination(&writer), expected));
+
+  // The options are kept, including the nesting stack buffer.
+  az_json_writer_reset(&writer, AZ_SPAN_FROM_BUFFER(json_buffer));
+  for (int32_t i = 0; i < 80; i++)
+  {
+    assert_int_equal(az_json_writer_append_begin_array(&writer), AZ_OK);
+  }
+
+  // So are the callbacks of a sink.
+  _test_json_sink sink
+      = { .json = { 0 }, .json_size = 0, .chunk_count = 0, .succeeding_chunks = 100 };
+  uint8_t scratch[64] = { 0 };
+  assert_int_equal(
+      az_json_writer_sink_init(
+          &writer, AZ_SPAN_FROM_BUFFER(scratch), _test_json_writer_flush, &sink, NULL),
+      AZ_OK);
+  assert_int_equal(az_json_writer_append_begin_object(&writer), AZ_OK);
+  az_json_writer_reset(&writer, AZ_SPAN_FROM_BUFFER(scratch));
+  assert_int_equal(_test_json_writer_build_document(&writer), AZ_OK);
+  assert_int_equal(az_json_writer_flush(&writer), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      az_span_slice(AZ_SPAN_FROM_BUFFER(sink.json), 0, sink.json_size), expected));
+}
+
+static void test_json_reader_reset(void** state)
+{
+  (void)state;
+
+  az_span const json = AZ_SPAN_FROM_STR("{\"a\":[1,{\"b\":\"c\"}],\"d\":true}");
+
+  uint8_t nesting_stack[AZ_JSON_NESTING_STACK_BUFFER_SIZE(80)] = { 0 };
+  az_json_reader_options options = az_json_reader_options_default();
+  options.nesting_stack_buffer = AZ_SPAN_FROM_BUFFER(nesting_stack);
+
+  // Whatever it was initialized for, and wherever it stopped, a reset reader reads the new buffer
+  // as a new one would.
+  uint8_t deep_json[161] = { 0 };
+  memset(deep_json, '[', 80);
+  memset(deep_json + 80, ']', 80);
+  az_span buffers[2] = { AZ_SPAN_FROM_STR("[[1,"), AZ_SPAN_FROM_STR("2]") };
+  uint32_t index_buffer[64] = { 0 };
+  az_json_reader reader = { 0 };
+  for (int32_t i = 0; i < 3; i++)
+  {
+    if (i == 0)
+    {
+      TEST_EXPECT_SUCCESS(az_json_reader_init(&reader, AZ_SPAN_FROM_STR("[[[["), &options));
+    }
+    else if (i == 1)
+    {
+      TEST_EXPECT_SUCCESS(az_json_reader_chunked_init(&reader, buffers, 2, &options));
+    }
+    else
+    {
+      TEST_EXPECT_SUCCESS(az_json_reader_indexed_init(
+          &reader,
+          AZ_SPAN_FROM_STR("[[1,2]]"),
+          az_span_create((uint8_t*)index_buffer, (int32_t)sizeof(index_buffer)),
+          &options));
+    }
+    TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+    TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+    TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+
+    az_json_reader_reset(&reader, json);
+    az_json_reader expected_reader = { 0 };
+    TEST_EXPECT_SUCCESS(az_json_reader_init(&expected_reader, json, &options));
+
+    az_result result = AZ_OK;
+    while (az_result_succeeded(result = az_json_reader_next_token(&expected_reader)))
+    {
+      TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+      assert_int_equal(reader.token.kind, expected_reader.token.kind);
+      assert_ptr_equal(az_span_ptr(reader.token.slice), az_span_ptr(expected_reader.token.slice));
+      assert_int_equal(reader.token.size, expected_reader.token.size);
+    }
+    assert_int_equal(result, AZ_ERROR_JSON_READER_DONE);
+    assert_int_equal(az_json_reader_next_token(&reader), AZ_ERROR_JSON_READER_DONE);
+
+    // The options are kept, including the nesting stack buffer.
+    az_json_reader_reset(&reader, az_span_create(deep_json, 160));
+    while (az_result_succeeded(result = az_json_reader_next_token(&reader)))
+    {
+    }
+    assert_int_equal(result, AZ_ERROR_JSON_READER_DONE);
+  }
+}
+
+static void test_az_json_tape(void** state)
+{
+  (void)state;
+
+  az_span const json = AZ_SPAN_FROM_STR(
+      "{\"desired\":{\"fan\":{\"speed\":3,\"on\":true},\"list\":[1,[2,3],{},\"x\"]},"
+      "\"na\\/me\":\"a\\nb\",\"$version\":12}");
+
+  az_json_tape_entry entries[21];
+  az_json_tape tape = { 0 };
+  assert_int_equal(az_json_tape_init(&tape, json, entries, 21, NULL), AZ_OK);
+  assert_int_equal(az_json_tape_get_count(&tape), 21);
+
+  // The root object skips over the whole tape, and its JSON text is the whole payload.
+  assert_int_equal(entries[0].kind, AZ_JSON_TOKEN_BEGIN_OBJECT);
+  assert_int_equal(entries[0].next_index, 21);
+  assert_int_equal(entries[0].size, az_span_size(json));
+
+  int32_t desired = 0;
+  int32_t fan = 0;
+  int32_t value_index = 0;
+  int32_t value = 0;
+  assert_int_equal(
+      az_json_tape_find_property(&tape, 0, AZ_SPAN_FROM_STR("desired"), &desired), AZ_OK);
+  assert_int_equal(
+      az_json_tape_find_property(&tape, desired, AZ_SPAN_FROM_STR("fan"), &fan), AZ_OK);
+  assert_int_equal(
+      az_json_tape_find_property(&tape, fan, AZ_SPAN_FROM_STR("speed"), &value_index), AZ_OK);
+  az_json_token token = { 0 };
+  az_json_tape_get_token(&tape, value_index, &token);
+  assert_int_equal(az_json_token_get_int32(&token, &value), AZ_OK);
+  assert_int_equal(value, 3);
+  az_json_tape_get_token(&tape, fan, &token);
+  assert_true(az_span_is_content_equal(token.slice, AZ_SPAN_FROM_STR("{\"speed\":3,\"on\":true}")));
+
+  // The version comes after the whole desired object, whose entries are skipped.
+  assert_int_equal(
+      az_json_tape_find_property(&tape, 0, AZ_SPAN_FROM_STR("$version"), &value_index), AZ_OK);
+  az_json_tape_get_token(&tape, value_index, &token);
+  assert_int_equal(az_json_token_get_int32(&token, &value), AZ_OK);
+  assert_int_equal(value, 12);
+  assert_int_equal(
+      az_json_tape_find_property(&tape, fan, AZ_SPAN_FROM_STR("$version"), &value_index),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // Escaped names and strings are unescaped as for tokens of a reader.
+  assert_int_equal(
+      az_json_tape_find_property(&tape, 0, AZ_SPAN_FROM_STR("na/me"), &value_index), AZ_OK);
+  az_json_tape_get_token(&tape, value_index, &token);
+  assert_true(az_json_token_is_text_equal(&token, AZ_SPAN_FROM_STR("a\nb")));
+
+  int32_t list = 0;
+  assert_int_equal(
+      az_json_tape_find_property(&tape, desired, AZ_SPAN_FROM_STR("list"), &list), AZ_OK);
+  assert_int_equal(az_json_tape_get_array_item(&tape, list, 2, &value_index), AZ_OK);
+  assert_int_equal(entries[value_index].kind, AZ_JSON_TOKEN_BEGIN_OBJECT);
+  assert_int_equal(entries[value_index].next_index, value_index + 1);
+  assert_int_equal(az_json_tape_get_array_item(&tape, list, 3, &value_index), AZ_OK);
+  az_json_tape_get_token(&tape, value_index, &token);
+  assert_true(az_json_token_is_text_equal(&token, AZ_SPAN_FROM_STR("x")));
+  assert_int_equal(
+      az_json_tape_get_array_item(&tape, list, 4, &value_index), AZ_ERROR_ITEM_NOT_FOUND);
+
+  // A tape which is too small, and invalid JSON.
+  assert_int_equal(az_json_tape_init(&tape, json, entries, 20, NULL), AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_json_tape_init(&tape, AZ_SPAN_FROM_STR("{\"a\":[1}"), entries, 21, NULL),
+      AZ_ERROR_UNEXPECTED_CHAR);
+
+  // A single value is a tape of one entry.
+  assert_int_equal(az_json_tape_init(&tape, AZ_SPAN_FROM_STR(" 42 "), entries, 1, NULL), AZ_OK);
+  assert_int_equal(az_json_tape_get_count(&tape), 1);
+  assert_int_equal(entries[0].next_index, 1);
+}
+
+static void test_az_ndjson_split(void** state)
+{
+  (void)state;
+
+  az_span records[8];
+  int32_t record_count = 0;
+  az_span remaining = AZ_SPAN_EMPTY;
+
+  az_span const source = AZ_SPAN_FROM_STR(
+      "{\"a\":1}\n\n[true,false]\r\n\"a string which is longer than a vector block\"\n\r\n42");
+  assert_int_equal(az_ndjson_split(source, records, 8, &record_count, &remaining), AZ_OK);
+  assert_int_equal(record_count, 4);
+  assert_true(az_span_is_content_equal(records[0], AZ_SPAN_FROM_STR("{\"a\":1}")));
+  assert_true(az_span_is_content_equal(records[1], AZ_SPAN_FROM_STR("[true,false]")));
+  assert_true(az_span_is_content_equal(
+      records[2], AZ_SPAN_FROM_STR("\"a string which is longer than a vector block\"")));
+  assert_true(az_span_is_content_equal(records[3], AZ_SPAN_FROM_STR("42")));
+  assert_int_equal(az_span_size(remaining), 0);
+
+  // A batch with more records than the array holds is split by several calls.
+  assert_int_equal(az_ndjson_split(source, records, 3, &record_count, &remaining), AZ_OK);
+  assert_int_equal(record_count, 3);
+  assert_true(az_span_is_content_equal(remaining, AZ_SPAN_FROM_STR("\r\n42")));
+  assert_int_equal(az_ndjson_split(remaining, records, 3, &record_count, &remaining), AZ_OK);
+  assert_int_equal(record_count, 1);
+  assert_true(az_span_is_content_equal(records[0], AZ_SPAN_FROM_STR("42")));
+  assert_int_equal(az_span_size(remaining), 0);
+
+  // Lines of every length up to several blocks, split one record at a time.
+  uint8_t buffer[2000];
+  int32_t size = 0;
+  for (int32_t length = 0; length < 60; length++)
+  {
+    for (int32_t i = 0; i < length; i++)
+    {
+      buffer[size++] = (uint8_t)('a' + (length % 26));
+    }
+    buffer[size++] = '\n';
+  }
+
+  remaining = az_span_create(buffer, size);
+  for (int32_t length = 1; length < 60; length++)
+  {
+    assert_int_equal(az_ndjson_split(remaining, records, 1, &record_count, &remaining), AZ_OK);
+    assert_int_equal(record_count, 1);
+    assert_int_equal(az_span_size(records[0]), length);
+    assert_int_equal(az_span_ptr(records[0])[0], 'a' + (length % 26));
+  }
+  assert_int_equal(az_ndjson_split(remaining, records, 1, &record_count, &remaining), AZ_OK);
+  assert_int_equal(record_count, 0);
+  assert_int_equal(az_span_size(remaining), 0);
+}
+
+static az_result test_az_ndjson_read_number(
+    az_json_reader* ref_json_reader,
+    int32_t record_index,
+    void* user_context)
+{
+  int32_t* const numbers = (int32_t*)user_context;
+  _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+  _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+  _az_RETURN_IF_FAILED(az_json_reader_next_token(ref_json_reader));
+  return az_json_token_get_int32(&ref_json_reader->token, &numbers[record_index]);
+}
+
+static void test_az_ndjson_parse_records(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[2000];
+  az_span remaining = AZ_SPAN_FROM_BUFFER(buffer);
+  for (int32_t i = 0; i < 100; i++)
+  {
+    if (i == 57 || i == 80)
+    {
+      remaining = az_span_copy(remaining, AZ_SPAN_FROM_STR("{\"n\":}\n"));
+    }
+    else
+    {
+      remaining = az_span_copy(remaining, AZ_SPAN_FROM_STR("{\"n\":"));
+      TEST_EXPECT_SUCCESS(az_span_i32toa(remaining, i, &remaining));
+      remaining = az_span_copy(remaining, AZ_SPAN_FROM_STR("}\n"));
+    }
+  }
+  az_span const source
+      = az_span_create(buffer, (int32_t)sizeof(buffer) - az_span_size(remaining));
+
+  az_span records[100];
+  int32_t record_count = 0;
+  assert_int_equal(az_ndjson_split(source, records, 100, &record_count, &remaining), AZ_OK);
+  assert_int_equal(record_count, 100);
+
+  for (int32_t worker_count = 0; worker_count <= 4; worker_count += 4)
+  {
+    az_ndjson_worker workers[4];
+    az_result results[100];
+    int32_t numbers[100] = { 0 };
+    assert_int_equal(
+        az_ndjson_parse_records(
+            records,
+            record_count,
+            test_az_ndjson_read_number,
+            numbers,
+            NULL,
+            workers,
+            worker_count,
+            results),
+        AZ_ERROR_UNEXPECTED_CHAR);
+
+    for (int32_t i = 0; i < 100; i++)
+    {
+      if (i == 57 || i == 80)
+      {
+        assert_int_equal(results[i], AZ_ERROR_UNEXPECTED_CHAR);
+      }
+      else
+      {
+        assert_int_equal(results[i], AZ_OK);
+        assert_int_equal(numbers[i], i);
+      }
+    }
+  }
+
+  // A batch without records.
+  assert_int_equal(
+      az_ndjson_parse_records(NULL, 0, test_az_ndjson_read_number, NULL, NULL, NULL, 0, NULL),
+      AZ_OK);
+}
+
+static void test_az_ndjson_writer(void** state)
+{
+  (void)state;
+
+  az_json_writer writer = { 0 };
+  int32_t previous = 0;
+  _az_user_context user_context = { .current_index = &previous };
+  TEST_EXPECT_SUCCESS(az_json_writer_chunked_init(
+      &writer, AZ_SPAN_EMPTY, &test_allocator, (void*)&user_context, NULL));
+
+  az_json_writer measuring_writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_writer_measure_init(&measuring_writer, NULL));
+
+  az_json_writer* const writers[] = { &writer, &measuring_writer };
+  for (size_t i = 0; i < sizeof(writers) / sizeof(writers[0]); i++)
+  {
+    TEST_EXPECT_SUCCESS(az_json_writer_append_begin_object(writers[i]));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_property_name(writers[i], AZ_SPAN_FROM_STR("a")));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_int32(writers[i], 1));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_end_object(writers[i]));
+    TEST_EXPECT_SUCCESS(az_ndjson_writer_end_record(writers[i]));
+
+    TEST_EXPECT_SUCCESS(az_json_writer_append_begin_array(writers[i]));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_bool(writers[i], true));
+    TEST_EXPECT_SUCCESS(az_json_writer_append_end_array(writers[i]));
+    TEST_EXPECT_SUCCESS(az_ndjson_writer_end_record(writers[i]));
+
+    TEST_EXPECT_SUCCESS(az_json_writer_append_string(writers[i], AZ_SPAN_FROM_STR("x")));
+    TEST_EXPECT_SUCCESS(az_ndjson_writer_end_record(writers[i]));
+  }
+
+  // The chunks of the test allocator follow each other in json_array.
+  az_span const expected = AZ_SPAN_FROM_STR("{\"a\":1}\n[true]\n\"x\"\n");
+  assert_int_equal(
+      az_json_writer_get_total_bytes_written(&measuring_writer), az_span_size(expected));
+  assert_int_equal(az_json_writer_get_total_bytes_written(&writer), az_span_size(expected));
+  assert_true(az_span_is_content_equal(
+      az_span_create(json_array, az_span_size(expected)), expected));
+
+  // The records can be read back.
+  az_span records[3];
+  int32_t record_count = 0;
+  az_span remaining = AZ_SPAN_EMPTY;
+  az_span const written = az_span_create(json_array, az_span_size(expected));
+  assert_int_equal(az_ndjson_split(written, records, 3, &record_count, &remaining), AZ_OK);
+  assert_int_equal(record_count, 3);
+  assert_true(az_span_is_content_equal(records[2], AZ_SPAN_FROM_STR("\"x\"")));
+
+  // Without room for the newline, and no allocator to get more.
+  uint8_t buffer[7];
+  az_json_writer small_writer = { 0 };
+  TEST_EXPECT_SUCCESS(az_json_writer_init(&small_writer, AZ_SPAN_FROM_BUFFER(buffer), NULL));
+  TEST_EXPECT_SUCCESS(az_json_writer_append_string(&small_writer, AZ_SPAN_FROM_STR("abcde")));
+  assert_int_equal(az_ndjson_writer_end_record(&small_writer), AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_json_kernels(void** state)
+{
+#ifdef _az_SIMD
+  // Each kernel the host can run, from the narrowest, classifies, escapes and unescapes the bytes
+  // the scalar code does.
+  uint32_t const feature_sets[] = {
+    0,
+    _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_AVX2,
+    _az_SIMD_FEATURE_NEON,
+  };
+
+  for (size_t f = 0; f < sizeof(feature_sets) / sizeof(feature_sets[0]); f++)
+  {
+    _az_simd_select_kernels(feature_sets[f] & _az_simd_get_features());
+    test_json_fast_skip_children(state);
+    test_json_reader_validate_utf8(state);
+    test_az_json_reader_indexed(state);
+    test_json_writer_escape_long_string(state);
+
+    // A string with an escaped quote in every position of the blocks unescaped at once, and in the
+    // bytes left over after the last block, reads back as it was written.
+    for (int32_t position = 0; position < 100; position++)
+    {
+      uint8_t value[100];
+      for (int32_t i = 0; i < (int32_t)sizeof(value); i++)
+      {
+        value[i] = i == position ? '"' : (uint8_t)('a' + (i % 26));
+      }
+
+      uint8_t json_buffer[256] = { 0 };
+      az_json_writer writer = { 0 };
+      TEST_EXPECT_SUCCESS(az_json_writer_init(&writer, AZ_SPAN_FROM_BUFFER(json_buffer), NULL));
+      TEST_EXPECT_SUCCESS(az_json_writer_append_string(&writer, AZ_SPAN_FROM_BUFFER(value)));
+
+      az_json_reader reader = { 0 };
+      TEST_EXPECT_SUCCESS(az_json_reader_init(
+          &reader, az_json_writer_get_bytes_used_in_destination(&writer), NULL));
+      TEST_EXPECT_SUCCESS(az_json_reader_next_token(&reader));
+
+      // The string is written with a null terminator.
+      char unescaped[sizeof(value) + 1] = { 0 };
+      int32_t unescaped_length = 0;
+      TEST_EXPECT_SUCCESS(az_json_token_get_string(
+          &reader.token, unescaped, (int32_t)sizeof(unescaped), &unescaped_length));
+      assert_int_equal(unescaped_length, (int32_t)sizeof(value));
+      assert_memory_equal(unescaped, value, sizeof(value));
+    }
+  }
+
+  _az_simd_select_kernels(_az_simd_get_features());
+#else
+  (void)state;
+#endif // _az_SIMD
+}
+
 int test_az_json()
 {
   const struct CMUnitTest tests[]
@@ -2761,6 +4427,7 @@ int test_az_json()
           cmocka_unit_test(test_json_writer),
           cmocka_unit_test(test_json_writer_append_nested),
           cmocka_unit_test(test_json_writer_append_nested_invalid),
+          cmocka_unit_test(test_json_writer_append_validated_json_text),
           cmocka_unit_test(test_json_writer_chunked),
           cmocka_unit_test(test_json_writer_chunked_no_callback),
           cmocka_unit_test(test_json_writer_large_string_chunked),
@@ -2768,13 +4435,38 @@ int test_az_json()
           cmocka_unit_test(test_json_reader_invalid),
           cmocka_unit_test(test_json_reader_incomplete),
           cmocka_unit_test(test_json_skip_children),
+          cmocka_unit_test(test_json_fast_skip_children),
+          cmocka_unit_test(test_json_reader_validate_utf8),
+          cmocka_unit_test(test_json_reader_parse_integers),
           cmocka_unit_test(test_json_value),
           cmocka_unit_test(test_az_json_token_get_string_and_text_equal),
           cmocka_unit_test(test_az_json_token_get_string_and_text_equal_discontiguous),
+          cmocka_unit_test(test_az_json_token_get_string_unicode_escapes),
           cmocka_unit_test(test_az_json_reader_double),
           cmocka_unit_test(test_az_json_token_number_too_large),
           cmocka_unit_test(test_az_json_token_literal),
           cmocka_unit_test(test_az_json_token_copy),
-          cmocka_unit_test(test_az_json_reader_chunked) };
+          cmocka_unit_test(test_az_json_reader_chunked),
+          cmocka_unit_test(test_az_json_reader_indexed),
+          cmocka_unit_test(test_az_json_reader_find_path),
+          cmocka_unit_test(test_az_json_reader_find_paths),
+          cmocka_unit_test(test_az_json_property_matcher),
+          cmocka_unit_test(test_az_json_reader_incremental),
+          cmocka_unit_test(test_az_json_deep_nesting),
+          cmocka_unit_test(test_json_writer_escape_long_string),
+          cmocka_unit_test(test_json_writer_append_double_shortest),
+          cmocka_unit_test(test_json_writer_append_scaled_int64),
+          cmocka_unit_test(test_json_writer_append_timestamp),
+          cmocka_unit_test(test_json_writer_measure),
+          cmocka_unit_test(test_json_writer_sink),
+          cmocka_unit_test(test_json_writer_reset),
+          cmocka_unit_test(test_json_reader_reset),
+          cmocka_unit_test(test_az_json_tape),
+          cmocka_unit_test(test_az_ndjson_split),
+          cmocka_unit_test(test_az_ndjson_parse_records),
+          cmocka_unit_test(test_az_ndjson_writer),
+          cmocka_unit_test(test_az_json_token_get_double_multisegment),
+          cmocka_unit_test(test_az_json_template),
+          cmocka_unit_test(test_az_json_kernels) };
   return cmocka_run_group_tests_name("az_core_json", tests, NULL, NULL);
 }
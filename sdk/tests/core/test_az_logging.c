@@ -9,11 +9,14 @@
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
 #include <azure/core/az_log.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/internal/az_atomic_internal.h>
 #include <azure/core/internal/az_http_internal.h>
 #include <azure/core/internal/az_log_internal.h>
 
 #include <setjmp.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include <cmocka.h>
 
@@ -340,6 +343,24 @@ static void test_az_log_everything_valid(void** state)
   }
 }
 
+static void test_az_log_classification_bits_are_distinct(void** state)
+{
+  (void)state;
+  az_log_classification const classifications[]
+      = { AZ_LOG_HTTP_REQUEST,        AZ_LOG_HTTP_RESPONSE,         AZ_LOG_HTTP_RETRY,
+          AZ_LOG_MQTT_RECEIVED_TOPIC, AZ_LOG_MQTT_RECEIVED_PAYLOAD, AZ_LOG_IOT_RETRY,
+          AZ_LOG_IOT_SAS_TOKEN,       AZ_LOG_IOT_AZURERTOS };
+
+  uint64_t mask = 0;
+  for (size_t i = 0; i < sizeof(classifications) / sizeof(classifications[0]); i++)
+  {
+    uint64_t const bit = AZ_LOG_CLASSIFICATION_BIT(classifications[i]);
+    assert_true(bit != 0);
+    assert_true((mask & bit) == 0);
+    mask |= bit;
+  }
+}
+
 static void test_az_log_everything_on_null(void** state)
 {
   (void)state;
@@ -373,6 +394,465 @@ static void test_az_log_everything_on_null(void** state)
   }
 }
 
+#ifndef AZ_NO_LOGGING
+
+#ifdef _az_MOCK_ENABLED
+int64_t __wrap_az_platform_clock_msec();
+#endif // _az_MOCK_ENABLED
+
+static int _number_of_http_log_messages = 0;
+
+static void _http_log_message_listener(
+    az_log_classification classification,
+    az_http_log_message* message)
+{
+  _number_of_http_log_messages++;
+
+  az_span method = { 0 };
+  az_span url = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_log_message_get_request(message, &method, &url));
+  assert_true(az_span_is_content_equal(method, AZ_SPAN_FROM_STR("GET")));
+  assert_true(az_span_is_content_equal(url, AZ_SPAN_FROM_STR("https://www.example.com")));
+
+  az_span name = { 0 };
+  az_span value = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_log_message_get_request_header(message, 0, &name, &value));
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("Header1")));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("Value1")));
+
+  // The credential is never passed to the callback.
+  TEST_EXPECT_SUCCESS(az_http_log_message_get_request_header(message, 1, &name, &value));
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("authorization")));
+  assert_int_equal(az_span_size(value), 0);
+
+  assert_int_equal(
+      az_http_log_message_get_request_header(message, 2, &name, &value), AZ_ERROR_ARG);
+
+  az_http_response_status_line status_line = { 0 };
+  if (classification == AZ_LOG_HTTP_REQUEST)
+  {
+    assert_int_equal(
+        az_http_log_message_get_status_line(message, &status_line), AZ_ERROR_ITEM_NOT_FOUND);
+    assert_int_equal(az_http_log_message_get_duration_msec(message), 0);
+    return;
+  }
+
+  assert_int_equal(classification, AZ_LOG_HTTP_RESPONSE);
+  assert_true(az_http_log_message_get_duration_msec(message) >= 0);
+
+  // Headers can be read without reading the status line first, and reading it starts over.
+  TEST_EXPECT_SUCCESS(az_http_log_message_get_next_response_header(message, &name, &value));
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("Header11")));
+
+  TEST_EXPECT_SUCCESS(az_http_log_message_get_status_line(message, &status_line));
+  assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_NOT_FOUND);
+
+  TEST_EXPECT_SUCCESS(az_http_log_message_get_next_response_header(message, &name, &value));
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("Header11")));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("Value11")));
+  assert_int_equal(
+      az_http_log_message_get_next_response_header(message, &name, &value),
+      AZ_ERROR_HTTP_END_OF_HEADERS);
+}
+
+static az_result _test_logging_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_request;
+  return az_http_response_append(
+      ref_response,
+      AZ_SPAN_FROM_STR("HTTP/1.1 404 Not Found\r\n"
+                       "Header11: Value11\r\n"
+                       "\r\n"
+                       "body"));
+}
+
+static void test_az_log_http_message_callback(void** state)
+{
+  (void)state;
+  uint8_t headers[1024] = { 0 };
+  az_http_request request = { 0 };
+  az_span url = AZ_SPAN_FROM_STR("https://www.example.com");
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &request,
+      &az_context_application,
+      az_http_method_get(),
+      url,
+      az_span_size(url),
+      AZ_SPAN_FROM_BUFFER(headers),
+      AZ_SPAN_EMPTY));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("Header1"), AZ_SPAN_FROM_STR("Value1")));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &request, AZ_SPAN_FROM_STR("authorization"), AZ_SPAN_FROM_STR("BigSecret!")));
+
+  uint8_t response_buf[256] = { 0 };
+  az_http_response response = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)));
+
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = _test_logging_transport,
+        .options = NULL,
+      },
+    },
+  };
+
+  // The formatted messages are no longer produced once a message callback is set.
+  az_log_set_callback(_log_listener_no_op);
+  az_http_log_set_message_callback(_http_log_message_listener);
+  _number_of_http_log_messages = 0;
+
+#ifdef _az_MOCK_ENABLED
+  will_return_count(__wrap_az_platform_clock_msec, 0, 2);
+#endif // _az_MOCK_ENABLED
+  TEST_EXPECT_SUCCESS(az_http_pipeline_policy_logging(policies, NULL, &request, &response));
+  assert_int_equal(_number_of_http_log_messages, 2);
+
+  // Classifications apply to the message callback too.
+  az_log_classification const classifications[] = { AZ_LOG_HTTP_REQUEST, AZ_LOG_END_OF_LIST };
+  az_log_set_classifications(classifications);
+  _number_of_http_log_messages = 0;
+
+  TEST_EXPECT_SUCCESS(az_http_pipeline_policy_logging(policies, NULL, &request, &response));
+  assert_int_equal(_number_of_http_log_messages, 1);
+
+  az_log_set_classifications(NULL);
+  az_http_log_set_message_callback(NULL);
+  az_log_set_callback(NULL);
+}
+
+static int _number_of_ring_messages = 0;
+static uint8_t _ring_message_sizes[64];
+
+static void _log_listener_ring(az_log_classification classification, az_span message)
+{
+  assert_int_equal(classification, AZ_LOG_IOT_RETRY);
+
+  // Each message is filled with the index of the message.
+  for (int32_t i = 0; i < az_span_size(message); i++)
+  {
+    assert_int_equal(az_span_ptr(message)[i], (uint8_t)_number_of_ring_messages);
+  }
+
+  _ring_message_sizes[_number_of_ring_messages++] = (uint8_t)az_span_size(message);
+}
+
+static void _test_log_ring_write(int32_t index, int32_t size)
+{
+  uint8_t message[64];
+  for (int32_t i = 0; i < size; i++)
+  {
+    message[i] = (uint8_t)index;
+  }
+
+  _az_LOG_WRITE(AZ_LOG_IOT_RETRY, az_span_create(message, size));
+}
+
+static void test_az_log_ring(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[64];
+  az_log_ring ring;
+  az_log_ring_init(&ring, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_log_set_callback(_log_listener_ring);
+  az_log_set_ring(&ring);
+  _number_of_ring_messages = 0;
+
+  // Messages are only delivered when the ring is drained.
+  _test_log_ring_write(0, 5);
+  _test_log_ring_write(1, 0);
+  _test_log_ring_write(2, 16);
+  assert_int_equal(_number_of_ring_messages, 0);
+
+  assert_int_equal(az_log_ring_drain(&ring, 2), 2);
+  assert_int_equal(_number_of_ring_messages, 2);
+  assert_int_equal(az_log_ring_drain(&ring, 10), 1);
+  assert_int_equal(_number_of_ring_messages, 3);
+  assert_int_equal(_ring_message_sizes[0], 5);
+  assert_int_equal(_ring_message_sizes[1], 0);
+  assert_int_equal(_ring_message_sizes[2], 16);
+  assert_int_equal(az_log_ring_drain(&ring, 10), 0);
+
+  // This one does not fit before the end of the buffer, so it starts over at the beginning.
+  _test_log_ring_write(3, 24);
+  assert_int_equal(az_log_ring_drain(&ring, 10), 1);
+  assert_int_equal(_ring_message_sizes[3], 24);
+
+  // When the ring is full, messages are dropped instead of waiting for the drain.
+  _test_log_ring_write(4, 24);
+  _test_log_ring_write(5, 24);
+  _test_log_ring_write(6, 24);
+  assert_int_equal(az_log_ring_get_dropped_count(&ring), 1);
+
+  // A message larger than the ring never fits, even once it is drained.
+  assert_int_equal(az_log_ring_drain(&ring, 1), 1);
+  _test_log_ring_write(6, 60);
+  assert_int_equal(az_log_ring_get_dropped_count(&ring), 2);
+
+  assert_int_equal(az_log_ring_drain(&ring, 10), 1);
+  assert_int_equal(_ring_message_sizes[4], 24);
+  assert_int_equal(_ring_message_sizes[5], 24);
+
+  // Without a ring, the callback is called right away again.
+  az_log_set_ring(NULL);
+  _test_log_ring_write(6, 1);
+  assert_int_equal(_number_of_ring_messages, 7);
+
+  az_log_set_callback(NULL);
+}
+
+enum
+{
+  _TEST_LOG_RING_PRODUCERS = 4,
+  _TEST_LOG_RING_MESSAGES_PER_PRODUCER = 500,
+};
+
+static int32_t _ring_next_sequences[_TEST_LOG_RING_PRODUCERS];
+static int32_t _number_of_shared_ring_messages = 0;
+static uint64_t volatile _ring_finished_producers = 0;
+
+// Each message is its producer, then its sequence number, padded with the producer.
+static void _log_listener_shared_ring(az_log_classification classification, az_span message)
+{
+  assert_int_equal(classification, AZ_LOG_IOT_RETRY);
+  uint8_t const* const bytes = az_span_ptr(message);
+  assert_true(az_span_size(message) >= 3);
+  assert_true(bytes[0] < _TEST_LOG_RING_PRODUCERS);
+  for (int32_t i = 3; i < az_span_size(message); i++)
+  {
+    assert_int_equal(bytes[i], bytes[0]);
+  }
+
+  // Messages may be dropped, but those of a producer are delivered in order.
+  int32_t const sequence = bytes[1] | (bytes[2] << 8);
+  assert_true(sequence >= _ring_next_sequences[bytes[0]]);
+  assert_int_equal(az_span_size(message), 3 + sequence % 29);
+  _ring_next_sequences[bytes[0]] = sequence + 1;
+  _number_of_shared_ring_messages++;
+}
+
+static void _test_log_ring_produce(void* user_context)
+{
+  uint8_t const producer = (uint8_t)(intptr_t)user_context;
+  uint8_t message[32];
+  for (int32_t sequence = 0; sequence < _TEST_LOG_RING_MESSAGES_PER_PRODUCER; sequence++)
+  {
+    int32_t const size = 3 + sequence % 29;
+    message[0] = producer;
+    message[1] = (uint8_t)sequence;
+    message[2] = (uint8_t)(sequence >> 8);
+    for (int32_t i = 3; i < size; i++)
+    {
+      message[i] = producer;
+    }
+
+    _az_LOG_WRITE(AZ_LOG_IOT_RETRY, az_span_create(message, size));
+  }
+
+  (void)_az_atomic_add(&_ring_finished_producers, 1);
+}
+
+static void test_az_log_ring_several_producers(void** state)
+{
+  (void)state;
+
+  // Small enough for the producers to wrap around and fill it while it is drained.
+  uint8_t buffer[512];
+  az_log_ring ring;
+  az_log_ring_init(&ring, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_log_set_callback(_log_listener_shared_ring);
+  az_log_set_ring(&ring);
+  _number_of_shared_ring_messages = 0;
+  _ring_finished_producers = 0;
+
+  az_platform_work works[_TEST_LOG_RING_PRODUCERS];
+  for (int32_t i = 0; i < _TEST_LOG_RING_PRODUCERS; i++)
+  {
+    _ring_next_sequences[i] = 0;
+    az_platform_work_init(&works[i], _test_log_ring_produce, (void*)(intptr_t)i);
+    assert_int_equal(az_platform_executor_submit(&works[i]), AZ_OK);
+  }
+
+  while (_az_atomic_load(&_ring_finished_producers) < _TEST_LOG_RING_PRODUCERS)
+  {
+    (void)az_log_ring_drain(&ring, 16);
+  }
+
+  for (int32_t i = 0; i < _TEST_LOG_RING_PRODUCERS; i++)
+  {
+    az_platform_executor_wait(&works[i]);
+  }
+  (void)az_log_ring_drain(&ring, INT32_MAX);
+
+  // Every message was either delivered whole or dropped, and the ring is empty again.
+  assert_int_equal(
+      _number_of_shared_ring_messages + (int32_t)az_log_ring_get_dropped_count(&ring),
+      _TEST_LOG_RING_PRODUCERS * _TEST_LOG_RING_MESSAGES_PER_PRODUCER);
+  assert_int_equal(az_log_ring_drain(&ring, INT32_MAX), 0);
+
+  az_log_set_ring(NULL);
+  az_log_set_callback(NULL);
+}
+
+static int _number_of_limited_messages = 0;
+static int _number_of_limit_summaries = 0;
+
+static void _log_listener_limit(az_log_classification classification, az_span message)
+{
+  assert_int_equal(classification, AZ_LOG_IOT_RETRY);
+  if (az_span_is_content_equal(message, AZ_SPAN_FROM_STR("3 log messages suppressed.")))
+  {
+    _number_of_limit_summaries++;
+  }
+  else
+  {
+    assert_true(az_span_is_content_equal(message, AZ_SPAN_FROM_STR("retry")));
+    _number_of_limited_messages++;
+  }
+}
+
+static void _test_log_limit_write(bool check_first)
+{
+  if (!check_first || _az_LOG_SHOULD_WRITE(AZ_LOG_IOT_RETRY))
+  {
+    _az_LOG_WRITE(AZ_LOG_IOT_RETRY, AZ_SPAN_FROM_STR("retry"));
+  }
+}
+
+static void test_az_log_limit_sampling(void** state)
+{
+  (void)state;
+
+  az_log_set_callback(_log_listener_limit);
+  _number_of_limited_messages = 0;
+
+  az_log_limit_options options = az_log_limit_options_default();
+  options.sample_rate = 3;
+  TEST_EXPECT_SUCCESS(az_log_set_limit(AZ_LOG_IOT_RETRY, &options));
+
+  // The first message of every three is logged, whether it is checked before it is formatted or
+  // written right away.
+  for (int32_t i = 0; i < 9; i++)
+  {
+    _test_log_limit_write(i % 2 == 0);
+  }
+  assert_int_equal(_number_of_limited_messages, 3);
+
+  // Once the limit is removed, every message is logged again.
+  TEST_EXPECT_SUCCESS(az_log_set_limit(AZ_LOG_IOT_RETRY, NULL));
+  _test_log_limit_write(true);
+  _test_log_limit_write(false);
+  assert_int_equal(_number_of_limited_messages, 5);
+
+  az_log_set_callback(NULL);
+}
+
+enum
+{
+  _TEST_LOG_LIMIT_WRITERS = 4,
+  _TEST_LOG_LIMIT_MESSAGES_PER_WRITER = 3000,
+  _TEST_LOG_LIMIT_SAMPLE_RATE = 3,
+};
+
+static uint64_t volatile _number_of_shared_limited_messages = 0;
+
+// Called from several threads at once, so the messages are counted atomically.
+static void _log_listener_shared_limit(az_log_classification classification, az_span message)
+{
+  (void)classification;
+  (void)message;
+  (void)_az_atomic_add(&_number_of_shared_limited_messages, 1);
+}
+
+static void _test_log_limit_write_many(void* user_context)
+{
+  (void)user_context;
+  for (int32_t i = 0; i < _TEST_LOG_LIMIT_MESSAGES_PER_WRITER; i++)
+  {
+    _az_LOG_WRITE(AZ_LOG_IOT_RETRY, AZ_SPAN_FROM_STR("retry"));
+  }
+}
+
+static void test_az_log_limit_sampling_several_threads(void** state)
+{
+  (void)state;
+
+  az_log_set_callback(_log_listener_shared_limit);
+  _number_of_shared_limited_messages = 0;
+
+  az_log_limit_options options = az_log_limit_options_default();
+  options.sample_rate = _TEST_LOG_LIMIT_SAMPLE_RATE;
+  TEST_EXPECT_SUCCESS(az_log_set_limit(AZ_LOG_IOT_RETRY, &options));
+
+  // Each message is counted once by the sampling it shares with the other threads, so exactly one
+  // of every three is logged.
+  az_platform_work works[_TEST_LOG_LIMIT_WRITERS];
+  for (int32_t i = 0; i < _TEST_LOG_LIMIT_WRITERS; i++)
+  {
+    az_platform_work_init(&works[i], _test_log_limit_write_many, NULL);
+    assert_int_equal(az_platform_executor_submit(&works[i]), AZ_OK);
+  }
+
+  for (int32_t i = 0; i < _TEST_LOG_LIMIT_WRITERS; i++)
+  {
+    az_platform_executor_wait(&works[i]);
+  }
+
+  assert_int_equal(
+      _az_atomic_load(&_number_of_shared_limited_messages),
+      _TEST_LOG_LIMIT_WRITERS * _TEST_LOG_LIMIT_MESSAGES_PER_WRITER / _TEST_LOG_LIMIT_SAMPLE_RATE);
+
+  TEST_EXPECT_SUCCESS(az_log_set_limit(AZ_LOG_IOT_RETRY, NULL));
+  az_log_set_callback(NULL);
+}
+
+#ifdef _az_MOCK_ENABLED
+static void test_az_log_limit_rate(void** state)
+{
+  (void)state;
+
+  az_log_set_callback(_log_listener_limit);
+  _number_of_limited_messages = 0;
+  _number_of_limit_summaries = 0;
+
+  az_log_limit_options options = az_log_limit_options_default();
+  options.max_messages_per_second = 2;
+  TEST_EXPECT_SUCCESS(az_log_set_limit(AZ_LOG_IOT_RETRY, &options));
+
+  // Within a second, the messages beyond the cap are suppressed, before they are formatted too.
+  will_return_count(__wrap_az_platform_clock_msec, 5000, 4);
+  for (int32_t i = 0; i < 4; i++)
+  {
+    _test_log_limit_write(false);
+  }
+  will_return(__wrap_az_platform_clock_msec, 5500);
+  assert_false(_az_LOG_SHOULD_WRITE(AZ_LOG_IOT_RETRY));
+  assert_int_equal(_number_of_limited_messages, 2);
+  assert_int_equal(_number_of_limit_summaries, 0);
+
+  // The first message of the next second is preceded by the number of those suppressed.
+  will_return(__wrap_az_platform_clock_msec, 6000);
+  _test_log_limit_write(false);
+  assert_int_equal(_number_of_limited_messages, 3);
+  assert_int_equal(_number_of_limit_summaries, 1);
+
+  TEST_EXPECT_SUCCESS(az_log_set_limit(AZ_LOG_IOT_RETRY, NULL));
+  az_log_set_callback(NULL);
+}
+#endif // _az_MOCK_ENABLED
+
+#endif // AZ_NO_LOGGING
+
 int test_az_logging()
 {
   const struct CMUnitTest tests[] = {
@@ -381,6 +861,17 @@ int test_az_logging()
     cmocka_unit_test(test_az_log_incorrect_list_fails_gracefully),
     cmocka_unit_test(test_az_log_everything_valid),
     cmocka_unit_test(test_az_log_everything_on_null),
+    cmocka_unit_test(test_az_log_classification_bits_are_distinct),
+#ifndef AZ_NO_LOGGING
+    cmocka_unit_test(test_az_log_http_message_callback),
+    cmocka_unit_test(test_az_log_ring),
+    cmocka_unit_test(test_az_log_ring_several_producers),
+    cmocka_unit_test(test_az_log_limit_sampling),
+    cmocka_unit_test(test_az_log_limit_sampling_several_threads),
+#ifdef _az_MOCK_ENABLED
+    cmocka_unit_test(test_az_log_limit_rate),
+#endif // _az_MOCK_ENABLED
+#endif // AZ_NO_LOGGING
   };
   return cmocka_run_group_tests_name("az_core_logging", tests, NULL, NULL);
 }
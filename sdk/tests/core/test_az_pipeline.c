@@ -113,10 +113,101 @@ az_result test_policy_2(
   return AZ_OK;
 }
 
+static void _test_az_pipeline_process_policies(
+    _az_http_policy_process_fn first,
+    _az_http_policy_process_fn second,
+    az_result expected_result,
+    az_span expected_first_header)
+{
+  uint8_t url_buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(url_buf);
+  az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+  az_http_request request;
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_get(),
+          url_span,
+          3,
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+
+  _az_http_policy_apiversion_options api_version = _az_http_policy_apiversion_options_default();
+  api_version._internal.name = AZ_SPAN_FROM_STR("x-ms-version");
+  api_version._internal.version = AZ_SPAN_FROM_STR("2019-02-02");
+  _az_http_policy_telemetry_options telemetry = _az_http_policy_telemetry_options_default();
+
+  _az_http_pipeline pipeline = {
+    ._internal = {
+      .policies = {
+        {
+          ._internal = {
+            .process = first,
+            .options = first == az_http_pipeline_policy_apiversion ? (void*)&api_version
+                                                                   : (void*)&telemetry,
+          },
+        },
+        {
+          ._internal = {
+            .process = second,
+            .options = second == az_http_pipeline_policy_apiversion ? (void*)&api_version
+                                                                    : (void*)&telemetry,
+          },
+        },
+        {
+          ._internal = {
+            .process = expected_result == AZ_OK ? test_policy_2 : NULL,
+            .options = NULL,
+          },
+        },
+      },
+    },
+  };
+
+  uint8_t response_buf[10];
+  az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+
+  assert_int_equal(az_http_pipeline_process(&pipeline, &request, &response), expected_result);
+  assert_int_equal(az_http_request_headers_count(&request), 2);
+
+  az_span name = AZ_SPAN_EMPTY;
+  az_span value = AZ_SPAN_EMPTY;
+  assert_return_code(az_http_request_get_header(&request, 0, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, expected_first_header));
+}
+
+// The policies call the one which follows them in the pipeline of the SDK clients directly, and
+// others through their function pointer.
+static void test_az_pipeline_process_expected_order(void** state)
+{
+  (void)state;
+
+  _test_az_pipeline_process_policies(
+      az_http_pipeline_policy_apiversion,
+      az_http_pipeline_policy_telemetry,
+      AZ_OK,
+      AZ_SPAN_FROM_STR("x-ms-version"));
+  _test_az_pipeline_process_policies(
+      az_http_pipeline_policy_telemetry,
+      az_http_pipeline_policy_apiversion,
+      AZ_OK,
+      AZ_SPAN_FROM_STR("User-Agent"));
+  _test_az_pipeline_process_policies(
+      az_http_pipeline_policy_apiversion,
+      az_http_pipeline_policy_telemetry,
+      AZ_ERROR_HTTP_PIPELINE_INVALID_POLICY,
+      AZ_SPAN_FROM_STR("x-ms-version"));
+}
+
 int test_az_pipeline()
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(az_pipeline_test),
+    cmocka_unit_test(test_az_pipeline_process_expected_order),
   };
   return cmocka_run_group_tests_name("az_core_pipeline", tests, NULL, NULL);
 }
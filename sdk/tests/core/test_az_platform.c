@@ -0,0 +1,245 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_test_definitions.h"
+#include <azure/core/az_platform.h>
+#include <azure/core/az_result.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_WORK_COUNT 64
+
+typedef struct
+{
+  int32_t input;
+  int32_t output;
+} square_work_context;
+
+static void square_work(void* user_context)
+{
+  square_work_context* const context = (square_work_context*)user_context;
+  context->output = context->input * context->input;
+}
+
+typedef struct
+{
+  az_platform_work work;
+  square_work_context children[2];
+  az_result submit_result;
+  int32_t sum;
+} sum_work_context;
+
+static void sum_work(void* user_context)
+{
+  sum_work_context* const context = (sum_work_context*)user_context;
+
+  // Work running on the executor submits more work and waits for it. The results are checked by
+  // the test thread, as cmocka can only fail a test from it.
+  az_platform_work children[2];
+  context->submit_result = AZ_OK;
+  for (int32_t i = 0; i < 2; i++)
+  {
+    az_platform_work_init(&children[i], square_work, &context->children[i]);
+    az_result const result = az_platform_executor_submit(&children[i]);
+    if (az_result_failed(result))
+    {
+      context->submit_result = result;
+    }
+  }
+
+  for (int32_t i = 0; i < 2; i++)
+  {
+    az_platform_executor_wait(&children[i]);
+  }
+
+  context->sum = context->children[0].output + context->children[1].output;
+}
+
+static void az_platform_executor_submit_wait_test(void** state)
+{
+  (void)state;
+
+  az_platform_work works[TEST_WORK_COUNT];
+  square_work_context contexts[TEST_WORK_COUNT];
+  for (int32_t i = 0; i < TEST_WORK_COUNT; i++)
+  {
+    contexts[i] = (square_work_context){ .input = i, .output = -1 };
+    az_platform_work_init(&works[i], square_work, &contexts[i]);
+    assert_int_equal(az_platform_executor_submit(&works[i]), AZ_OK);
+  }
+
+  for (int32_t i = 0; i < TEST_WORK_COUNT; i++)
+  {
+    az_platform_executor_wait(&works[i]);
+    assert_int_equal(contexts[i].output, i * i);
+  }
+
+  // A work which has run can be submitted again.
+  contexts[0].input = 7;
+  assert_int_equal(az_platform_executor_submit(&works[0]), AZ_OK);
+  az_platform_executor_wait(&works[0]);
+  assert_int_equal(contexts[0].output, 49);
+}
+
+static void az_platform_executor_nested_test(void** state)
+{
+  (void)state;
+
+  sum_work_context contexts[TEST_WORK_COUNT / 4];
+  int32_t const count = (int32_t)(sizeof(contexts) / sizeof(contexts[0]));
+  for (int32_t i = 0; i < count; i++)
+  {
+    contexts[i] = (sum_work_context){ .children = { { .input = i }, { .input = i + 1 } } };
+    az_platform_work_init(&contexts[i].work, sum_work, &contexts[i]);
+    assert_int_equal(az_platform_executor_submit(&contexts[i].work), AZ_OK);
+  }
+
+  for (int32_t i = 0; i < count; i++)
+  {
+    az_platform_executor_wait(&contexts[i].work);
+    assert_int_equal(contexts[i].submit_result, AZ_OK);
+    assert_int_equal(contexts[i].sum, i * i + (i + 1) * (i + 1));
+  }
+}
+
+static void az_platform_executor_shutdown_test(void** state)
+{
+  (void)state;
+
+  square_work_context contexts[TEST_WORK_COUNT];
+  az_platform_work works[TEST_WORK_COUNT];
+  for (int32_t i = 0; i < TEST_WORK_COUNT; i++)
+  {
+    contexts[i] = (square_work_context){ .input = i, .output = -1 };
+    az_platform_work_init(&works[i], square_work, &contexts[i]);
+    assert_int_equal(az_platform_executor_submit(&works[i]), AZ_OK);
+  }
+
+  // The work already submitted is run before the threads stop.
+  az_platform_executor_shutdown();
+  for (int32_t i = 0; i < TEST_WORK_COUNT; i++)
+  {
+    assert_int_equal(contexts[i].output, i * i);
+    az_platform_executor_wait(&works[i]);
+  }
+
+  // Shutting down twice does nothing, and the next submission starts the executor again.
+  az_platform_executor_shutdown();
+  contexts[1].input = 9;
+  assert_int_equal(az_platform_executor_submit(&works[1]), AZ_OK);
+  az_platform_executor_wait(&works[1]);
+  assert_int_equal(contexts[1].output, 81);
+
+  az_platform_executor_shutdown();
+}
+
+static void az_platform_file_map_test(void** state)
+{
+  (void)state;
+
+  az_platform_file_mapping mapping;
+  az_result const missing_result
+      = az_platform_file_map(&mapping, "az_platform_file_map_test_missing.bin");
+  if (missing_result == AZ_ERROR_DEPENDENCY_NOT_PROVIDED)
+  {
+    // Built without a platform, which has no files.
+    return;
+  }
+  assert_int_equal(missing_result, AZ_ERROR_ITEM_NOT_FOUND);
+
+  char const path[] = "az_platform_file_map_test.bin";
+  FILE* const file = fopen(path, "wb");
+  assert_non_null(file);
+  assert_int_equal(fwrite("0123456789", 1, 10, file), 10);
+  assert_int_equal(fclose(file), 0);
+
+  assert_int_equal(az_platform_file_map(&mapping, path), AZ_OK);
+  assert_int_equal(az_platform_file_mapping_get_size(&mapping), 10);
+  assert_true(az_span_is_content_equal(
+      az_platform_file_mapping_get_span(&mapping, 0, 10), AZ_SPAN_FROM_STR("0123456789")));
+
+  // Spans past the end of the file are cut to it.
+  assert_true(az_span_is_content_equal(
+      az_platform_file_mapping_get_span(&mapping, 8, 4), AZ_SPAN_FROM_STR("89")));
+
+  az_platform_file_unmap(&mapping);
+  assert_int_equal(az_platform_file_mapping_get_size(&mapping), 0);
+
+  // An empty file maps to no content.
+  FILE* const empty_file = fopen(path, "wb");
+  assert_non_null(empty_file);
+  assert_int_equal(fclose(empty_file), 0);
+  assert_int_equal(az_platform_file_map(&mapping, path), AZ_OK);
+  assert_int_equal(az_platform_file_mapping_get_size(&mapping), 0);
+  az_platform_file_unmap(&mapping);
+
+  assert_int_equal(remove(path), 0);
+}
+
+static intptr_t _get_file_handle(FILE* file)
+{
+#ifdef _WIN32
+  return _get_osfhandle(_fileno(file));
+#else
+  return (intptr_t)fileno(file);
+#endif
+}
+
+static void az_platform_file_write_at_test(void** state)
+{
+  (void)state;
+
+  char const path[] = "az_platform_file_write_at_test.bin";
+  FILE* const file = fopen(path, "wb");
+  assert_non_null(file);
+
+  intptr_t const handle = _get_file_handle(file);
+  az_result const allocate_result = az_platform_file_allocate(handle, 10);
+  if (allocate_result == AZ_ERROR_DEPENDENCY_NOT_PROVIDED)
+  {
+    // Built without a platform, which has no files.
+    assert_int_equal(fclose(file), 0);
+    assert_int_equal(remove(path), 0);
+    return;
+  }
+  assert_int_equal(allocate_result, AZ_OK);
+
+  // The ranges are written in any order, past the end of the file.
+  assert_int_equal(az_platform_file_write_at(handle, 6, AZ_SPAN_FROM_STR("6789")), AZ_OK);
+  assert_int_equal(az_platform_file_write_at(handle, 0, AZ_SPAN_FROM_STR("012345")), AZ_OK);
+  assert_int_equal(az_platform_file_write_at(handle, 10, AZ_SPAN_EMPTY), AZ_OK);
+  assert_int_equal(fclose(file), 0);
+
+  az_platform_file_mapping mapping;
+  assert_int_equal(az_platform_file_map(&mapping, path), AZ_OK);
+  assert_int_equal(az_platform_file_mapping_get_size(&mapping), 10);
+  assert_true(az_span_is_content_equal(
+      az_platform_file_mapping_get_span(&mapping, 0, 10), AZ_SPAN_FROM_STR("0123456789")));
+  az_platform_file_unmap(&mapping);
+
+  assert_int_equal(remove(path), 0);
+}
+
+int test_az_platform()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(az_platform_executor_submit_wait_test),
+    cmocka_unit_test(az_platform_executor_nested_test),
+    cmocka_unit_test(az_platform_executor_shutdown_test),
+    cmocka_unit_test(az_platform_file_map_test),
+    cmocka_unit_test(az_platform_file_write_at_test),
+  };
+  return cmocka_run_group_tests_name("az_core_platform", tests, NULL, NULL);
+}
@@ -2,14 +2,19 @@
 // SPDX-License-Identifier: MIT
 
 #include "az_test_definitions.h"
+#include <az_http_private.h>
 #include <azure/core/az_credentials.h>
 #include <azure/core/az_http.h>
 #include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
 #include <azure/core/az_span.h>
+#include <azure/core/internal/az_config_internal.h>
 #include <azure/core/internal/az_http_internal.h>
 
 #include <setjmp.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <cmocka.h>
 
@@ -37,6 +42,7 @@ void test_az_http_pipeline_policy_credential(void** state);
 void test_az_http_pipeline_policy_retry(void** state);
 void test_az_http_pipeline_policy_retry_with_header(void** state);
 void test_az_http_pipeline_policy_retry_with_header_2(void** state);
+int64_t __wrap_az_platform_clock_msec();
 #endif // _az_MOCK_ENABLED
 
 static az_result test_policy_transport(
@@ -47,6 +53,26 @@ static az_result test_policy_transport(
 
 void test_az_http_pipeline_policy_apiversion(void** state);
 void test_az_http_pipeline_policy_telemetry(void** state);
+void test_az_http_pipeline_policy_retry_wait_callback(void** state);
+void test_az_http_pipeline_policy_retry_jitter(void** state);
+void test_az_http_pipeline_policy_retry_deadline(void** state);
+void test_az_http_pipeline_policy_hedge_passes_through(void** state);
+void test_az_http_pipeline_policy_hedge_submit_fails(void** state);
+void test_az_http_pipeline_policy_metrics(void** state);
+void test_az_http_pipeline_policy_metrics_disabled(void** state);
+void test_az_http_pipeline_policy_metrics_shared(void** state);
+void test_az_credential_token_cache(void** state);
+void test_az_http_pipeline_policy_coalescing(void** state);
+void test_az_http_pipeline_policy_coalescing_shares_response(void** state);
+void test_az_http_pipeline_policy_response_cache(void** state);
+void test_az_http_pipeline_policy_rate_limit(void** state);
+void test_az_http_pipeline_policy_circuit_breaker(void** state);
+void test_az_http_trace_context_get_traceparent(void** state);
+void test_az_http_pipeline_policy_tracing(void** state);
+void test_az_http_pipeline_policy_compression_round_trip(void** state);
+void test_az_http_pipeline_policy_compression_binary(void** state);
+void test_az_http_pipeline_policy_compression_dynamic_codes(void** state);
+void test_az_http_pipeline_policy_compression_passes_through(void** state);
 
 az_result test_policy_transport(
     _az_http_policy* ref_policies,
@@ -153,34 +179,10 @@ void test_az_http_pipeline_policy_apiversion(void** state)
       az_http_pipeline_policy_apiversion(policies, &api_version, &request, NULL), AZ_OK);
 }
 
-#ifdef _az_MOCK_ENABLED
-
-const az_span retry_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
-                                                        "Content-Type: text/html; charset=UTF-8\r\n"
-                                                        "\r\n"
-                                                        "{\r\n"
-                                                        "  \"body\":0,\r"
-                                                        "}\n");
-
-const az_span retry_response_with_header
-    = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
-                               "Content-Type: text/html; charset=UTF-8\r\n"
-                               "retry-after-ms: 1600\r\n"
-                               "\r\n"
-                               "{\r\n"
-                               "  \"body\":0,\r"
-                               "}\n");
-
-const az_span retry_response_with_header_2
-    = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
-                               "Content-Type: text/html; charset=UTF-8\r\n"
-                               "Retry-After: 1600\r\n"
-                               "\r\n"
-                               "{\r\n"
-                               "  \"body\":0,\r"
-                               "}\n");
+static const az_span timeout_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
+                                                                   "\r\n");
 
-az_result test_policy_transport_retry_response(
+static az_result test_policy_transport_timeout_response(
     _az_http_policy* ref_policies,
     void* ref_options,
     az_http_request* ref_request,
@@ -189,180 +191,2084 @@ az_result test_policy_transport_retry_response(
   (void)ref_policies;
   (void)ref_options;
   (void)ref_request;
-  assert_return_code(az_http_response_init(ref_response, retry_response), AZ_OK);
+  assert_return_code(az_http_response_init(ref_response, timeout_response), AZ_OK);
   return AZ_OK;
 }
 
-az_result test_policy_transport_retry_response_with_header(
-    _az_http_policy* ref_policies,
-    void* ref_options,
-    az_http_request* ref_request,
-    az_http_response* ref_response)
+typedef struct
 {
-  (void)ref_policies;
-  (void)ref_options;
-  (void)ref_request;
-  assert_return_code(az_http_response_init(ref_response, retry_response_with_header), AZ_OK);
-  return AZ_OK;
-}
+  int32_t delays_msec[8];
+  int32_t count;
+  int32_t fail_after;
+} test_retry_waits;
 
-az_result test_policy_transport_retry_response_with_header_2(
-    _az_http_policy* ref_policies,
-    void* ref_options,
-    az_http_request* ref_request,
-    az_http_response* ref_response)
+static az_result test_retry_wait_callback(void* user_context, int32_t delay_msec)
 {
-  (void)ref_policies;
-  (void)ref_options;
-  (void)ref_request;
-  assert_return_code(az_http_response_init(ref_response, retry_response_with_header_2), AZ_OK);
+  test_retry_waits* waits = (test_retry_waits*)user_context;
+  if (waits->count == waits->fail_after)
+  {
+    return AZ_ERROR_CANCELED;
+  }
+
+  waits->delays_msec[waits->count++] = delay_msec;
   return AZ_OK;
 }
 
-void test_az_http_pipeline_policy_retry(void** state)
+static az_result test_retry_run(az_context* context, az_http_policy_retry_options* retry_options)
 {
-  (void)state;
-
-  uint8_t buf[100];
+  uint8_t url_buf[100];
   uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
-  memset(buf, 0, sizeof(buf));
   memset(header_buf, 0, sizeof(header_buf));
 
-  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
-  az_span remainder = az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
-  assert_int_equal(az_span_size(remainder), 97);
-  az_span header_span = AZ_SPAN_FROM_BUFFER(header_buf);
   az_http_request request;
-
   assert_return_code(
       az_http_request_init(
           &request,
-          &az_context_application,
+          context,
           az_http_method_get(),
-          url_span,
-          3,
-          header_span,
+          AZ_SPAN_FROM_BUFFER(url_buf),
+          0,
+          AZ_SPAN_FROM_BUFFER(header_buf),
           AZ_SPAN_EMPTY),
       AZ_OK);
 
-  // Create policy options
-  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport_timeout_response,
+        .options = NULL,
+      },
+    },
+  };
 
-  _az_http_policy policies[1] = {            
-            {
-              ._internal = {
-                .process = test_policy_transport_retry_response,
-                .options = NULL,
-              },
-            },
-        };
+  az_http_response response;
+  return az_http_pipeline_policy_retry(policies, retry_options, &request, &response);
+}
 
-  // set clock sec required when retrying (will retry 4 times)
+void test_az_http_pipeline_policy_retry_wait_callback(void** state)
+{
+  (void)state;
+
+  test_retry_waits waits = { .count = 0, .fail_after = -1 };
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  retry_options.retry_delay_msec = 10;
+  retry_options.max_retry_delay_msec = 100;
+  retry_options.wait_callback = test_retry_wait_callback;
+  retry_options.wait_user_context = &waits;
+
+#ifdef _az_MOCK_ENABLED
+  // The clock is read after each wait, to check the context.
   will_return_count(__wrap_az_platform_clock_msec, 0, 4);
+#endif // _az_MOCK_ENABLED
+  assert_return_code(test_retry_run(&az_context_application, &retry_options), AZ_OK);
+  assert_int_equal(waits.count, 4);
+  assert_int_equal(waits.delays_msec[0], 40);
+  assert_int_equal(waits.delays_msec[1], 80);
+  assert_int_equal(waits.delays_msec[2], 100);
+  assert_int_equal(waits.delays_msec[3], 100);
+
+  // A failed wait stops retrying and is returned to the caller.
+  waits = (test_retry_waits){ .count = 0, .fail_after = 1 };
+#ifdef _az_MOCK_ENABLED
+  will_return(__wrap_az_platform_clock_msec, 0);
+#endif // _az_MOCK_ENABLED
+  assert_int_equal(test_retry_run(&az_context_application, &retry_options), AZ_ERROR_CANCELED);
+  assert_int_equal(waits.count, 1);
+}
+
+void test_az_http_pipeline_policy_retry_jitter(void** state)
+{
+  (void)state;
+
+  test_retry_waits waits = { .count = 0, .fail_after = -1 };
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  retry_options.retry_delay_msec = 10;
+  retry_options.max_retry_delay_msec = 100;
+  retry_options.jitter = AZ_HTTP_POLICY_RETRY_JITTER_DECORRELATED;
+  retry_options.wait_callback = test_retry_wait_callback;
+  retry_options.wait_user_context = &waits;
+
+#ifdef _az_MOCK_ENABLED
+  // The clock seeds the jitter, and is read after each wait, to check the context.
+  will_return_count(__wrap_az_platform_clock_msec, 0, 5);
+#endif // _az_MOCK_ENABLED
+  assert_return_code(test_retry_run(&az_context_application, &retry_options), AZ_OK);
+  assert_int_equal(waits.count, 4);
+
+  int32_t previous = retry_options.retry_delay_msec;
+  for (int32_t i = 0; i < waits.count; i++)
+  {
+    int32_t const upper = previous * 3 < 100 ? previous * 3 : 100;
+    assert_true(waits.delays_msec[i] >= 10 && waits.delays_msec[i] <= upper);
+    previous = waits.delays_msec[i];
+  }
+}
+
+void test_az_http_pipeline_policy_retry_deadline(void** state)
+{
+  (void)state;
+
+  test_retry_waits waits = { .count = 0, .fail_after = -1 };
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  retry_options.wait_callback = test_retry_wait_callback;
+  retry_options.wait_user_context = &waits;
+
+  // The first retry would start after the deadline, so the policy gives up without waiting.
+  az_context context = az_context_create_with_expiration(&az_context_application, 1);
+
+#ifdef _az_MOCK_ENABLED
+  will_return(__wrap_az_platform_clock_msec, 0);
+#endif // _az_MOCK_ENABLED
+  assert_int_equal(test_retry_run(&context, &retry_options), AZ_ERROR_CANCELED);
+  assert_int_equal(waits.count, 0);
+}
+
+static void test_hedge_request_init(
+    az_http_request* out_request,
+    az_http_method method,
+    az_span url_buffer,
+    az_span header_buffer)
+{
+  assert_return_code(
+      az_http_request_init(
+          out_request,
+          &az_context_application,
+          method,
+          url_buffer,
+          0,
+          header_buffer,
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+}
+
+void test_az_http_pipeline_policy_hedge_passes_through(void** state)
+{
+  (void)state;
+
+  uint8_t url_buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  uint8_t response_buf[64];
+  uint8_t hedge_response_buf[64];
+
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport,
+        .options = NULL,
+      },
+    },
+  };
+
   az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+
+  // Without an async client, nothing is hedged.
+  _az_http_policy_hedge_options hedge_options = _az_http_policy_hedge_options_default();
+  assert_null(hedge_options.async_client);
+
+  az_http_request request;
+  test_hedge_request_init(
+      &request,
+      az_http_method_get(),
+      AZ_SPAN_FROM_BUFFER(url_buf),
+      AZ_SPAN_FROM_BUFFER(header_buf));
   assert_return_code(
-      az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+      az_http_pipeline_policy_hedge(policies, &hedge_options, &request, &response), AZ_OK);
+
+  // Requests which are not idempotent go to the next policy, and are never sent twice.
+  az_http_client_async client = { 0 };
+  hedge_options.async_client = &client;
+  hedge_options.hedge_response_buffer = AZ_SPAN_FROM_BUFFER(hedge_response_buf);
+
+  test_hedge_request_init(
+      &request,
+      az_http_method_post(),
+      AZ_SPAN_FROM_BUFFER(url_buf),
+      AZ_SPAN_FROM_BUFFER(header_buf));
+  assert_return_code(
+      az_http_pipeline_policy_hedge(policies, &hedge_options, &request, &response), AZ_OK);
 }
 
-void test_az_http_pipeline_policy_retry_with_header(void** state)
+void test_az_http_pipeline_policy_hedge_submit_fails(void** state)
 {
   (void)state;
 
-  uint8_t buf[100];
+  uint8_t url_buf[100];
   uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
-  memset(buf, 0, sizeof(buf));
-  memset(header_buf, 0, sizeof(header_buf));
+  uint8_t response_buf[64];
+  uint8_t hedge_response_buf[64];
+
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport,
+        .options = NULL,
+      },
+    },
+  };
+
+  az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+
+  // The tests link the transport which provides no HTTP support, so sending the request fails.
+  az_http_client_async client = { 0 };
+  _az_http_policy_hedge_options hedge_options = _az_http_policy_hedge_options_default();
+  hedge_options.async_client = &client;
+  hedge_options.hedge_response_buffer = AZ_SPAN_FROM_BUFFER(hedge_response_buf);
 
-  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
-  az_span remainder = az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
-  assert_int_equal(az_span_size(remainder), 97);
-  az_span header_span = AZ_SPAN_FROM_BUFFER(header_buf);
   az_http_request request;
+  test_hedge_request_init(
+      &request,
+      az_http_method_head(),
+      AZ_SPAN_FROM_BUFFER(url_buf),
+      AZ_SPAN_FROM_BUFFER(header_buf));
+
+#ifdef _az_MOCK_ENABLED
+  will_return(__wrap_az_platform_clock_msec, 0);
+#endif // _az_MOCK_ENABLED
+  assert_int_equal(
+      az_http_pipeline_policy_hedge(policies, &hedge_options, &request, &response),
+      AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+}
+
+static az_result test_policy_transport_append_timeout_response(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_request;
+  return az_http_response_append(ref_response, timeout_response);
+}
+
+static void test_metrics_callback(void* user_context, az_http_request_metrics const* metrics)
+{
+  *(az_http_request_metrics*)user_context = *metrics;
+}
 
+void test_az_http_pipeline_policy_metrics(void** state)
+{
+  (void)state;
+
+  uint8_t url_buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  uint8_t response_buf[64];
+  memset(header_buf, 0, sizeof(header_buf));
+
+  az_http_request request;
   assert_return_code(
       az_http_request_init(
           &request,
           &az_context_application,
-          az_http_method_get(),
-          url_span,
-          3,
-          header_span,
-          AZ_SPAN_EMPTY),
+          az_http_method_put(),
+          AZ_SPAN_FROM_BUFFER(url_buf),
+          0,
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_FROM_STR("body")),
       AZ_OK);
 
-  // Create policy options
+  test_retry_waits waits = { .count = 0, .fail_after = -1 };
   az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
-  // make just one retry
-  retry_options.max_retries = 1;
+  retry_options.max_retries = 2;
+  retry_options.wait_callback = test_retry_wait_callback;
+  retry_options.wait_user_context = &waits;
 
-  _az_http_policy policies[1] = {            
-            {
-              ._internal = {
-                .process = test_policy_transport_retry_response_with_header,
-                .options = NULL,
-              },
-            },
-        };
+  az_http_pipeline_metrics counters = { 0 };
+  az_http_request_metrics metrics = { 0 };
+  az_http_policy_metrics_options metrics_options = {
+    .counters = &counters,
+    .callback = test_metrics_callback,
+    .callback_user_context = &metrics,
+  };
 
-  will_return(__wrap_az_platform_clock_msec, 0);
+  _az_http_pipeline pipeline = {
+    ._internal = {
+      .policies = {
+        {
+          ._internal = {
+            .process = az_http_pipeline_policy_metrics,
+            .options = &metrics_options,
+          },
+        },
+        {
+          ._internal = {
+            .process = az_http_pipeline_policy_retry,
+            .options = &retry_options,
+          },
+        },
+        {
+          ._internal = {
+            .process = test_policy_transport_append_timeout_response,
+            .options = NULL,
+          },
+        },
+      },
+    },
+  };
+
+#ifdef _az_MOCK_ENABLED
+  will_return_always(__wrap_az_platform_clock_msec, 0);
+#endif // _az_MOCK_ENABLED
 
   az_http_response response;
-  assert_return_code(
-      az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+  assert_return_code(az_http_pipeline_process(&pipeline, &request, &response), AZ_OK);
+
+  assert_int_equal(metrics.result, AZ_OK);
+  assert_int_equal(metrics.policy_count, 2);
+  assert_true(metrics.policy_time_msec[0] >= 0);
+  assert_true(metrics.policy_time_msec[1] >= 0);
+  assert_int_equal(metrics.retry_count, 2);
+  assert_int_equal(metrics.bytes_sent, 3 * 4);
+  assert_int_equal(metrics.bytes_received, 3 * az_span_size(timeout_response));
+  assert_int_equal(metrics.status_code, AZ_HTTP_STATUS_CODE_REQUEST_TIMEOUT);
+
+  assert_return_code(az_http_pipeline_process(&pipeline, &request, &response), AZ_OK);
+
+  assert_int_equal(counters.request_count, 2);
+  assert_int_equal(counters.failed_request_count, 0);
+  assert_int_equal(counters.retry_count, 4);
+  assert_int_equal(counters.bytes_sent, 6 * 4);
+  assert_int_equal(counters.bytes_received, 6 * az_span_size(timeout_response));
+  assert_int_equal(counters.status_class_count[4], 2);
+  assert_int_equal(counters.status_class_count[0], 0);
 }
 
-void test_az_http_pipeline_policy_retry_with_header_2(void** state)
+void test_az_http_pipeline_policy_metrics_disabled(void** state)
 {
   (void)state;
 
-  uint8_t buf[100];
+  uint8_t url_buf[100];
   uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
-  memset(buf, 0, sizeof(buf));
-  memset(header_buf, 0, sizeof(header_buf));
 
-  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
-  az_span remainder = az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
-  assert_int_equal(az_span_size(remainder), 97);
-  az_span header_span = AZ_SPAN_FROM_BUFFER(header_buf);
   az_http_request request;
-
   assert_return_code(
       az_http_request_init(
           &request,
           &az_context_application,
           az_http_method_get(),
-          url_span,
-          3,
-          header_span,
+          AZ_SPAN_FROM_BUFFER(url_buf),
+          0,
+          AZ_SPAN_FROM_BUFFER(header_buf),
           AZ_SPAN_EMPTY),
       AZ_OK);
 
-  // Create policy options
-  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
-  // make just one retry
-  retry_options.max_retries = 1;
-
-  _az_http_policy policies[1] = {            
-            {
-              ._internal = {
-                .process = test_policy_transport_retry_response_with_header_2,
-                .options = NULL,
-              },
-            },
-        };
-
-  will_return(__wrap_az_platform_clock_msec, 0);
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport,
+        .options = NULL,
+      },
+    },
+  };
 
-  az_http_response response;
+  // Without counters or a callback, the policy measures nothing.
+  az_http_policy_metrics_options metrics_options = { 0 };
   assert_return_code(
-      az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+      az_http_pipeline_policy_metrics(policies, &metrics_options, &request, NULL), AZ_OK);
+  assert_return_code(az_http_pipeline_policy_metrics(policies, NULL, &request, NULL), AZ_OK);
 }
 
-int64_t __wrap_az_platform_clock_msec();
-int64_t __wrap_az_platform_clock_msec() { return (int64_t)mock(); }
+// gzip of the readings of test_compression_readings(), compressed with dynamic Huffman codes.
+#ifndef _az_MOCK_ENABLED
+enum
+{
+  TEST_METRICS_SENDERS = 4,
+  TEST_METRICS_REQUESTS_PER_SENDER = 1000,
+};
+
+static az_span const test_metrics_ok_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 200 OK\r\n\r\n");
+
+static az_result test_policy_transport_append_ok_response(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_request;
+  return az_http_response_append(ref_response, test_metrics_ok_response);
+}
 
+// Sends requests through a pipeline shared with the other senders. The results are checked by the
+// test, once every sender is done.
+static void test_metrics_sender(void* user_context)
+{
+  _az_http_pipeline* const pipeline = (_az_http_pipeline*)user_context;
+  for (int32_t i = 0; i < TEST_METRICS_REQUESTS_PER_SENDER; i++)
+  {
+    uint8_t url_buf[16];
+    uint8_t header_buf[sizeof(_az_http_request_header)];
+    uint8_t response_buf[32];
+    az_http_request request;
+    az_http_response response;
+    if (az_result_failed(az_http_request_init(
+            &request,
+            &az_context_application,
+            az_http_method_put(),
+            AZ_SPAN_FROM_BUFFER(url_buf),
+            0,
+            AZ_SPAN_FROM_BUFFER(header_buf),
+            AZ_SPAN_FROM_STR("body")))
+        || az_result_failed(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)))
+        || az_result_failed(az_http_pipeline_process(pipeline, &request, &response)))
+    {
+      return;
+    }
+  }
+}
 #endif // _az_MOCK_ENABLED
 
+void test_az_http_pipeline_policy_metrics_shared(void** state)
+{
+  (void)state;
+
+#ifndef _az_MOCK_ENABLED
+  az_http_pipeline_metrics counters = { 0 };
+  az_http_policy_metrics_options metrics_options = {
+    .counters = &counters,
+    .callback = NULL,
+    .callback_user_context = NULL,
+  };
+
+  _az_http_pipeline pipeline = {
+    ._internal = {
+      .policies = {
+        {
+          ._internal = {
+            .process = az_http_pipeline_policy_metrics,
+            .options = &metrics_options,
+          },
+        },
+        {
+          ._internal = {
+            .process = test_policy_transport_append_ok_response,
+            .options = NULL,
+          },
+        },
+      },
+    },
+  };
+
+  // The requests of every sender are added to the same counters, and none of them is lost.
+  az_platform_work works[TEST_METRICS_SENDERS];
+  for (int32_t i = 0; i < TEST_METRICS_SENDERS; i++)
+  {
+    az_platform_work_init(&works[i], test_metrics_sender, &pipeline);
+    assert_return_code(az_platform_executor_submit(&works[i]), AZ_OK);
+  }
+
+  for (int32_t i = 0; i < TEST_METRICS_SENDERS; i++)
+  {
+    az_platform_executor_wait(&works[i]);
+  }
+
+  int64_t const request_count = TEST_METRICS_SENDERS * TEST_METRICS_REQUESTS_PER_SENDER;
+  assert_int_equal(counters.request_count, request_count);
+  assert_int_equal(counters.failed_request_count, 0);
+  assert_int_equal(counters.retry_count, 0);
+  assert_int_equal(counters.bytes_sent, request_count * 4);
+  assert_int_equal(
+      counters.bytes_received, request_count * az_span_size(test_metrics_ok_response));
+  assert_int_equal(counters.status_class_count[2], request_count);
+  assert_int_equal(counters.status_class_count[0], 0);
+#endif // _az_MOCK_ENABLED
+}
+
+static uint8_t const test_compression_dynamic_gzip[] = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0xD1, 0xBB, 0x0A, 0x84, 0x30,
+  0x10, 0x46, 0xE1, 0x7E, 0x1F, 0x63, 0x6A, 0x91, 0xDC, 0x26, 0x6A, 0xDE, 0x66, 0xC1, 0x80, 0x29,
+  0x02, 0x12, 0x62, 0x21, 0xE2, 0xBB, 0xEF, 0xB2, 0x30, 0x2E, 0xFC, 0xCD, 0xF4, 0x5F, 0x75, 0xCE,
+  0x45, 0x65, 0xA5, 0x64, 0x06, 0xEA, 0xB9, 0xEE, 0xB9, 0xBD, 0xFB, 0xD1, 0x32, 0x25, 0x67, 0x46,
+  0x1E, 0x68, 0x3B, 0x6A, 0x59, 0x4B, 0x3F, 0x29, 0x05, 0x73, 0xBF, 0xAE, 0x9F, 0xB4, 0x28, 0x2D,
+  0x48, 0x2B, 0xD2, 0xA1, 0x74, 0x20, 0x9D, 0x48, 0x8F, 0xD2, 0x83, 0xF4, 0x22, 0x03, 0xCA, 0x00,
+  0x32, 0x88, 0x64, 0x94, 0x0C, 0x92, 0x45, 0x46, 0x94, 0x11, 0x64, 0x14, 0x39, 0x69, 0x95, 0x26,
+  0x91, 0xB3, 0x56, 0x69, 0x16, 0xB9, 0x68, 0x95, 0x96, 0xA7, 0xBC, 0x51, 0x32, 0xF1, 0x7F, 0x92,
+  0x55, 0x3A, 0xF1, 0xF7, 0xD2, 0x07, 0x79, 0x07, 0x36, 0x6B, 0xFA, 0x01, 0x00, 0x00,
+};
+
+static uint8_t test_compression_arena_buffer[48 * 1024];
+
+typedef struct
+{
+  uint8_t data[1024];
+  int32_t size;
+} test_compression_buffer;
+
+typedef struct
+{
+  az_span response_headers;
+  az_span response_body;
+  int32_t chunk_size;
+  test_compression_buffer sent_body;
+  az_span content_encoding;
+  az_span content_length;
+  az_span accept_encoding;
+} test_compression_transport_options;
+
+static az_span test_compression_readings(test_compression_buffer* out_buffer)
+{
+  out_buffer->size = 0;
+  for (int i = 0; i < 12; i++)
+  {
+    out_buffer->size += snprintf(
+        (char*)out_buffer->data + out_buffer->size,
+        sizeof(out_buffer->data) - (size_t)out_buffer->size,
+        "{\"id\":%d,\"temperature\":%d.5,\"humidity\":%d}\n",
+        i,
+        20 + i % 7,
+        40 + i % 13);
+  }
+
+  return az_span_create(out_buffer->data, out_buffer->size);
+}
+
+static az_result test_compression_sink(void* user_context, az_span body_chunk)
+{
+  test_compression_buffer* const buffer = (test_compression_buffer*)user_context;
+  assert_true(buffer->size + az_span_size(body_chunk) <= (int32_t)sizeof(buffer->data));
+  memcpy(buffer->data + buffer->size, az_span_ptr(body_chunk), (size_t)az_span_size(body_chunk));
+  buffer->size += az_span_size(body_chunk);
+  return AZ_OK;
+}
+
+static az_result test_compression_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  test_compression_transport_options* const options
+      = (test_compression_transport_options*)ref_options;
+
+  az_span body = { 0 };
+  assert_return_code(az_http_request_get_body(ref_request, &body), AZ_OK);
+  assert_true(az_span_size(body) <= (int32_t)sizeof(options->sent_body.data));
+  if (az_span_size(body) > 0)
+  {
+    memcpy(options->sent_body.data, az_span_ptr(body), (size_t)az_span_size(body));
+  }
+  options->sent_body.size = az_span_size(body);
+
+  options->content_encoding = AZ_SPAN_EMPTY;
+  options->content_length = AZ_SPAN_EMPTY;
+  options->accept_encoding = AZ_SPAN_EMPTY;
+  // Headers which were not sent are left empty.
+  az_result ignore = az_http_request_get_header_by_name(
+      ref_request, AZ_SPAN_FROM_STR("Content-Encoding"), &options->content_encoding);
+  ignore = az_http_request_get_header_by_name(
+      ref_request, AZ_SPAN_FROM_STR("Content-Length"), &options->content_length);
+  ignore = az_http_request_get_header_by_name(
+      ref_request, AZ_SPAN_FROM_STR("Accept-Encoding"), &options->accept_encoding);
+  (void)ignore;
+
+  az_result result = az_http_response_append(ref_response, options->response_headers);
+
+  // The body arrives in small chunks, so that decompression stops and continues in every state.
+  az_span remaining = options->response_body;
+  while (az_result_succeeded(result) && az_span_size(remaining) > 0)
+  {
+    int32_t const size = az_span_size(remaining) < options->chunk_size ? az_span_size(remaining)
+                                                                        : options->chunk_size;
+    result = az_http_response_append(ref_response, az_span_slice(remaining, 0, size));
+    remaining = az_span_slice_to_end(remaining, size);
+  }
+
+  return result;
+}
+
+static az_result test_compression_run(
+    az_span_arena* arena,
+    az_span body,
+    test_compression_transport_options* ref_transport_options,
+    test_compression_buffer* out_received)
+{
+  uint8_t url_buf[100];
+  uint8_t header_buf[(4 * sizeof(_az_http_request_header))];
+  uint8_t response_buf[128];
+  memset(header_buf, 0, sizeof(header_buf));
+
+  az_http_request request;
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_put(),
+          AZ_SPAN_FROM_BUFFER(url_buf),
+          0,
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          body),
+      AZ_OK);
+
+  uint8_t content_length_buf[8];
+  az_span content_length = AZ_SPAN_FROM_BUFFER(content_length_buf);
+  az_span remainder = { 0 };
+  assert_return_code(az_span_i32toa(content_length, az_span_size(body), &remainder), AZ_OK);
+  content_length = az_span_slice(
+      content_length, 0, az_span_size(content_length) - az_span_size(remainder));
+  assert_return_code(
+      az_http_request_append_header(&request, AZ_SPAN_FROM_STR("Content-Length"), content_length),
+      AZ_OK);
+
+  _az_http_policy_compression_options options = _az_http_policy_compression_options_default();
+  options.arena = arena;
+
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_compression_transport,
+        .options = ref_transport_options,
+      },
+    },
+  };
+
+  out_received->size = 0;
+  az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+  assert_return_code(
+      az_http_response_set_body_sink(&response, test_compression_sink, out_received), AZ_OK);
+
+  az_result const result
+      = az_http_pipeline_policy_compression(policies, &options, &request, &response);
+
+  // The request is left as it was.
+  az_span request_body = { 0 };
+  assert_return_code(az_http_request_get_body(&request, &request_body), AZ_OK);
+  assert_true(az_span_is_content_equal(request_body, body));
+  assert_int_equal(az_http_request_headers_count(&request), 1);
+  az_span value = { 0 };
+  assert_return_code(
+      az_http_request_get_header_by_name(&request, AZ_SPAN_FROM_STR("Content-Length"), &value),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(value, content_length));
+  assert_int_equal(az_span_arena_get_used_size(arena), 0);
+
+  return result;
+}
+
+void test_az_http_pipeline_policy_compression_round_trip(void** state)
+{
+  (void)state;
+
+  az_span_arena arena;
+  az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(test_compression_arena_buffer));
+
+  test_compression_buffer readings;
+  az_span const body = test_compression_readings(&readings);
+
+  test_compression_transport_options transport_options = {
+    .response_headers = AZ_SPAN_FROM_STR("HTTP/1.1 201 Created\r\n\r\n"),
+    .response_body = AZ_SPAN_EMPTY,
+    .chunk_size = 1,
+  };
+
+  test_compression_buffer received;
+  assert_return_code(test_compression_run(&arena, body, &transport_options, &received), AZ_OK);
+
+  assert_true(
+      az_span_is_content_equal(transport_options.content_encoding, AZ_SPAN_FROM_STR("gzip")));
+  assert_true(
+      az_span_is_content_equal(transport_options.accept_encoding, AZ_SPAN_FROM_STR("gzip")));
+  assert_true(transport_options.sent_body.size < az_span_size(body) / 2);
+
+  int32_t content_length = 0;
+  assert_return_code(az_span_atoi32(transport_options.content_length, &content_length), AZ_OK);
+  assert_int_equal(content_length, transport_options.sent_body.size);
+
+  // The body which was sent decompresses back to the readings, in chunks of any size.
+  test_compression_buffer sent_body = transport_options.sent_body;
+  transport_options.response_headers
+      = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nContent-Encoding: GZIP\r\n\r\n");
+  transport_options.response_body = az_span_create(sent_body.data, sent_body.size);
+  for (int32_t chunk_size = 1; chunk_size <= sent_body.size; chunk_size += 7)
+  {
+    transport_options.chunk_size = chunk_size;
+    assert_return_code(
+        test_compression_run(&arena, AZ_SPAN_EMPTY, &transport_options, &received), AZ_OK);
+    assert_true(az_span_is_content_equal(az_span_create(received.data, received.size), body));
+  }
+}
+
+void test_az_http_pipeline_policy_compression_binary(void** state)
+{
+  (void)state;
+
+  az_span_arena arena;
+  az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(test_compression_arena_buffer));
+
+  // Every byte value, so that the literals with 9 bit fixed codes, from 0x90 to 0xFF, are sent.
+  test_compression_buffer bytes;
+  bytes.size = 3 * 256;
+  for (int32_t i = 0; i < bytes.size; i++)
+  {
+    bytes.data[i] = (uint8_t)(i * 7);
+  }
+  az_span const body = az_span_create(bytes.data, bytes.size);
+
+  test_compression_transport_options transport_options = {
+    .response_headers = AZ_SPAN_FROM_STR("HTTP/1.1 201 Created\r\n\r\n"),
+    .response_body = AZ_SPAN_EMPTY,
+    .chunk_size = 1,
+  };
+
+  test_compression_buffer received;
+  assert_return_code(test_compression_run(&arena, body, &transport_options, &received), AZ_OK);
+  assert_true(
+      az_span_is_content_equal(transport_options.content_encoding, AZ_SPAN_FROM_STR("gzip")));
+
+  test_compression_buffer sent_body = transport_options.sent_body;
+  transport_options.response_headers
+      = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\n\r\n");
+  transport_options.response_body = az_span_create(sent_body.data, sent_body.size);
+  transport_options.chunk_size = 5;
+  assert_return_code(
+      test_compression_run(&arena, AZ_SPAN_EMPTY, &transport_options, &received), AZ_OK);
+  assert_true(az_span_is_content_equal(az_span_create(received.data, received.size), body));
+}
+
+void test_az_http_pipeline_policy_compression_dynamic_codes(void** state)
+{
+  (void)state;
+
+  az_span_arena arena;
+  az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(test_compression_arena_buffer));
+
+  test_compression_buffer readings;
+  az_span const expected = test_compression_readings(&readings);
+
+  uint8_t gzip[sizeof(test_compression_dynamic_gzip)];
+  memcpy(gzip, test_compression_dynamic_gzip, sizeof(gzip));
+
+  test_compression_transport_options transport_options = {
+    .response_headers = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\n\r\n"),
+    .response_body = AZ_SPAN_FROM_BUFFER(gzip),
+    .chunk_size = 1,
+  };
+
+  test_compression_buffer received;
+  assert_return_code(
+      test_compression_run(&arena, AZ_SPAN_EMPTY, &transport_options, &received), AZ_OK);
+  assert_true(az_span_is_content_equal(az_span_create(received.data, received.size), expected));
+
+  // A body which ends early is an error.
+  transport_options.response_body = az_span_slice(AZ_SPAN_FROM_BUFFER(gzip), 0, 100);
+  assert_int_equal(
+      test_compression_run(&arena, AZ_SPAN_EMPTY, &transport_options, &received),
+      AZ_ERROR_UNEXPECTED_END);
+
+  // So is a body which doesn't match its CRC-32.
+  gzip[sizeof(gzip) - 8] ^= 1;
+  transport_options.response_body = AZ_SPAN_FROM_BUFFER(gzip);
+  assert_int_equal(
+      test_compression_run(&arena, AZ_SPAN_EMPTY, &transport_options, &received),
+      AZ_ERROR_UNEXPECTED_CHAR);
+}
+
+void test_az_http_pipeline_policy_compression_passes_through(void** state)
+{
+  (void)state;
+
+  az_span_arena arena;
+  az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(test_compression_arena_buffer));
+
+  // Small bodies are sent as they are, and bodies without a Content-Encoding reach the sink as
+  // they are.
+  az_span const body = AZ_SPAN_FROM_STR("{\"id\":1}");
+  test_compression_transport_options transport_options = {
+    .response_headers = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n\r\n"),
+    .response_body = body,
+    .chunk_size = 3,
+  };
+
+  test_compression_buffer received;
+  assert_return_code(test_compression_run(&arena, body, &transport_options, &received), AZ_OK);
+  assert_int_equal(az_span_size(transport_options.content_encoding), 0);
+  assert_true(az_span_is_content_equal(
+      az_span_create(transport_options.sent_body.data, transport_options.sent_body.size), body));
+  assert_true(az_span_is_content_equal(az_span_create(received.data, received.size), body));
+
+  // Without an arena, the policy does nothing.
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport,
+        .options = NULL,
+      },
+    },
+  };
+
+  _az_http_policy_compression_options options = _az_http_policy_compression_options_default();
+  assert_return_code(az_http_pipeline_policy_compression(policies, &options, NULL, NULL), AZ_OK);
+}
+
+#ifdef _az_MOCK_ENABLED
+
+const az_span retry_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
+                                                        "Content-Type: text/html; charset=UTF-8\r\n"
+                                                        "\r\n"
+                                                        "{\r\n"
+                                                        "  \"body\":0,\r"
+                                                        "}\n");
+
+const az_span retry_response_with_header
+    = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
+                               "Content-Type: text/html; charset=UTF-8\r\n"
+                               "retry-after-ms: 1600\r\n"
+                               "\r\n"
+                               "{\r\n"
+                               "  \"body\":0,\r"
+                               "}\n");
+
+const az_span retry_response_with_header_2
+    = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
+                               "Content-Type: text/html; charset=UTF-8\r\n"
+                               "Retry-After: 1600\r\n"
+                               "\r\n"
+                               "{\r\n"
+                               "  \"body\":0,\r"
+                               "}\n");
+
+az_result test_policy_transport_retry_response(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_request;
+  assert_return_code(az_http_response_init(ref_response, retry_response), AZ_OK);
+  return AZ_OK;
+}
+
+az_result test_policy_transport_retry_response_with_header(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_request;
+  assert_return_code(az_http_response_init(ref_response, retry_response_with_header), AZ_OK);
+  return AZ_OK;
+}
+
+az_result test_policy_transport_retry_response_with_header_2(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_request;
+  assert_return_code(az_http_response_init(ref_response, retry_response_with_header_2), AZ_OK);
+  return AZ_OK;
+}
+
+void test_az_http_pipeline_policy_retry(void** state)
+{
+  (void)state;
+
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  memset(buf, 0, sizeof(buf));
+  memset(header_buf, 0, sizeof(header_buf));
+
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span remainder = az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+  assert_int_equal(az_span_size(remainder), 97);
+  az_span header_span = AZ_SPAN_FROM_BUFFER(header_buf);
+  az_http_request request;
+
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_get(),
+          url_span,
+          3,
+          header_span,
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+
+  // Create policy options
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+
+  _az_http_policy policies[1] = {            
+            {
+              ._internal = {
+                .process = test_policy_transport_retry_response,
+                .options = NULL,
+              },
+            },
+        };
+
+  // set clock sec required when retrying (will retry 4 times)
+  will_return_count(__wrap_az_platform_clock_msec, 0, 4);
+  az_http_response response;
+  assert_return_code(
+      az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+}
+
+void test_az_http_pipeline_policy_retry_with_header(void** state)
+{
+  (void)state;
+
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  memset(buf, 0, sizeof(buf));
+  memset(header_buf, 0, sizeof(header_buf));
+
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span remainder = az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+  assert_int_equal(az_span_size(remainder), 97);
+  az_span header_span = AZ_SPAN_FROM_BUFFER(header_buf);
+  az_http_request request;
+
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_get(),
+          url_span,
+          3,
+          header_span,
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+
+  // Create policy options
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  // make just one retry
+  retry_options.max_retries = 1;
+
+  _az_http_policy policies[1] = {            
+            {
+              ._internal = {
+                .process = test_policy_transport_retry_response_with_header,
+                .options = NULL,
+              },
+            },
+        };
+
+  will_return(__wrap_az_platform_clock_msec, 0);
+
+  az_http_response response;
+  assert_return_code(
+      az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+}
+
+void test_az_http_pipeline_policy_retry_with_header_2(void** state)
+{
+  (void)state;
+
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  memset(buf, 0, sizeof(buf));
+  memset(header_buf, 0, sizeof(header_buf));
+
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span remainder = az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+  assert_int_equal(az_span_size(remainder), 97);
+  az_span header_span = AZ_SPAN_FROM_BUFFER(header_buf);
+  az_http_request request;
+
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_get(),
+          url_span,
+          3,
+          header_span,
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+
+  // Create policy options
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  // make just one retry
+  retry_options.max_retries = 1;
+
+  _az_http_policy policies[1] = {            
+            {
+              ._internal = {
+                .process = test_policy_transport_retry_response_with_header_2,
+                .options = NULL,
+              },
+            },
+        };
+
+  will_return(__wrap_az_platform_clock_msec, 0);
+
+  az_http_response response;
+  assert_return_code(
+      az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+}
+
+int64_t __wrap_az_platform_clock_msec() { return (int64_t)mock(); }
+
+#endif // _az_MOCK_ENABLED
+
+typedef struct
+{
+  int32_t count;
+  int64_t expires_in_msec;
+  az_result result;
+  az_credential_token_cache* nested_cache;
+  az_result nested_result;
+} test_token_source;
+
+static int64_t test_token_cache_now()
+{
+#ifdef _az_MOCK_ENABLED
+  return 0;
+#else
+  return az_platform_clock_msec();
+#endif // _az_MOCK_ENABLED
+}
+
+static az_result test_token_cache_acquire(
+    void* user_context,
+    az_context* context,
+    az_span scopes,
+    az_span token_buffer,
+    az_span* out_token,
+    int64_t* out_expires_at_msec);
+
+static az_result test_token_cache_get(
+    az_credential_token_cache* cache,
+    az_span scopes,
+    test_token_source* source,
+    az_span token_buffer,
+    az_span* out_token)
+{
+#ifdef _az_MOCK_ENABLED
+  will_return(__wrap_az_platform_clock_msec, 0);
+#endif // _az_MOCK_ENABLED
+  return az_credential_token_cache_get(
+      cache,
+      source,
+      scopes,
+      &az_context_application,
+      test_token_cache_acquire,
+      source,
+      token_buffer,
+      out_token);
+}
+
+static az_result test_token_cache_acquire(
+    void* user_context,
+    az_context* context,
+    az_span scopes,
+    az_span token_buffer,
+    az_span* out_token,
+    int64_t* out_expires_at_msec)
+{
+  (void)context;
+  (void)scopes;
+
+  test_token_source* const source = (test_token_source*)user_context;
+  source->count++;
+
+  // While this refresh is in flight, the other callers get the current token without waiting.
+  if (source->nested_cache != NULL)
+  {
+    uint8_t nested_buffer[16];
+    az_span nested_token = AZ_SPAN_EMPTY;
+    source->nested_result = test_token_cache_get(
+        source->nested_cache,
+        AZ_SPAN_FROM_STR("scope"),
+        source,
+        AZ_SPAN_FROM_BUFFER(nested_buffer),
+        &nested_token);
+    assert_true(az_span_is_content_equal(nested_token, AZ_SPAN_FROM_STR("token-1")));
+  }
+
+  if (az_result_failed(source->result))
+  {
+    return source->result;
+  }
+
+  az_span remainder = az_span_copy(token_buffer, AZ_SPAN_FROM_STR("token-"));
+  remainder = az_span_copy_u8(remainder, (uint8_t)('0' + source->count));
+  *out_token = az_span_slice(token_buffer, 0, az_span_size(token_buffer) - az_span_size(remainder));
+  *out_expires_at_msec = test_token_cache_now() + source->expires_in_msec;
+  return AZ_OK;
+}
+
+void test_az_credential_token_cache(void** state)
+{
+  (void)state;
+
+  az_credential_token_cache_options options = az_credential_token_cache_options_default();
+  options.refresh_before_expiry_msec = 60000;
+  az_credential_token_cache cache;
+  az_credential_token_cache_init(&cache, &options);
+
+  az_span const scope = AZ_SPAN_FROM_STR("scope");
+  uint8_t buffer[16];
+  az_span const token_buffer = AZ_SPAN_FROM_BUFFER(buffer);
+  az_span token = AZ_SPAN_EMPTY;
+  test_token_source source = {
+    .count = 0,
+    .expires_in_msec = 2 * 60000,
+    .result = AZ_OK,
+    .nested_cache = NULL,
+    .nested_result = AZ_OK,
+  };
+
+  // The first caller acquires the token, the next one gets it from the cache.
+  assert_return_code(test_token_cache_get(&cache, scope, &source, token_buffer, &token), AZ_OK);
+  assert_true(az_span_is_content_equal(token, AZ_SPAN_FROM_STR("token-1")));
+  assert_return_code(test_token_cache_get(&cache, scope, &source, token_buffer, &token), AZ_OK);
+  assert_true(az_span_is_content_equal(token, AZ_SPAN_FROM_STR("token-1")));
+  assert_int_equal(source.count, 1);
+
+  // Other scopes have their own token.
+  assert_return_code(
+      test_token_cache_get(&cache, AZ_SPAN_FROM_STR("other"), &source, token_buffer, &token),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(token, AZ_SPAN_FROM_STR("token-2")));
+
+  // A token is refreshed before it expires, and returned to the other callers meanwhile.
+  az_credential_token_cache_init(&cache, &options);
+  source.count = 0;
+  source.expires_in_msec = 30000;
+  assert_return_code(test_token_cache_get(&cache, scope, &source, token_buffer, &token), AZ_OK);
+  source.nested_cache = &cache;
+  assert_return_code(test_token_cache_get(&cache, scope, &source, token_buffer, &token), AZ_OK);
+  assert_return_code(source.nested_result, AZ_OK);
+  assert_true(az_span_is_content_equal(token, AZ_SPAN_FROM_STR("token-2")));
+  source.nested_cache = NULL;
+
+  // A failed refresh keeps the current token while it is valid.
+  source.result = AZ_ERROR_HTTP_AUTHENTICATION_FAILED;
+  assert_return_code(test_token_cache_get(&cache, scope, &source, token_buffer, &token), AZ_OK);
+  assert_true(az_span_is_content_equal(token, AZ_SPAN_FROM_STR("token-2")));
+  assert_int_equal(source.count, 3);
+
+  // Without a valid token, the failure is returned.
+  az_credential_token_cache_init(&cache, &options);
+  assert_int_equal(
+      test_token_cache_get(&cache, scope, &source, token_buffer, &token),
+      AZ_ERROR_HTTP_AUTHENTICATION_FAILED);
+
+  // The cache holds a token for a limited number of scopes.
+  source.result = AZ_OK;
+  static az_span const scopes[] = {
+    AZ_SPAN_LITERAL_FROM_STR("1"),
+    AZ_SPAN_LITERAL_FROM_STR("2"),
+    AZ_SPAN_LITERAL_FROM_STR("3"),
+  };
+  for (size_t i = 0; i < sizeof(scopes) / sizeof(scopes[0]); i++)
+  {
+    source.count = 0;
+    assert_return_code(
+        test_token_cache_get(&cache, scopes[i], &source, token_buffer, &token), AZ_OK);
+  }
+  assert_int_equal(
+      test_token_cache_get(&cache, AZ_SPAN_FROM_STR("4"), &source, token_buffer, &token),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+// The response buffers are the size of the response, whose body is the rest of the buffer.
+#define TEST_COALESCING_RESPONSE "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n\r\nshared"
+static az_span const test_coalescing_response = AZ_SPAN_LITERAL_FROM_STR(TEST_COALESCING_RESPONSE);
+
+typedef struct test_coalescing_state test_coalescing_state;
+
+typedef struct
+{
+  test_coalescing_state* state;
+  az_platform_work work;
+  uint8_t response_buf[sizeof(TEST_COALESCING_RESPONSE) - 1];
+  az_http_response response;
+  az_result result;
+} test_coalescing_caller;
+
+struct test_coalescing_state
+{
+  az_http_request_coalescer* coalescer;
+  void const* credential;
+  int32_t send_count;
+  az_context* joined_context;
+  void const* joined_credential;
+  az_result joined_result;
+  test_coalescing_caller* waiter;
+};
+
+static az_result test_coalescing_send(
+    test_coalescing_state* state,
+    az_context* context,
+    az_http_method method,
+    az_http_response* response);
+
+static az_result test_coalescing_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_request;
+
+  test_coalescing_state* const state = (test_coalescing_state*)ref_options;
+  state->send_count++;
+
+  // While this request is in flight, another one is sent from the same thread.
+  az_context* const joined_context = state->joined_context;
+  state->joined_context = NULL;
+  if (joined_context != NULL)
+  {
+    uint8_t joined_response_buf[sizeof(TEST_COALESCING_RESPONSE) - 1];
+    az_http_response joined_response;
+    assert_return_code(
+        az_http_response_init(&joined_response, AZ_SPAN_FROM_BUFFER(joined_response_buf)), AZ_OK);
+    void const* const credential = state->credential;
+    state->credential = state->joined_credential;
+    state->joined_result = test_coalescing_send(
+        state, joined_context, az_http_method_get(), &joined_response);
+    state->credential = credential;
+  }
+
+  // Keep the request in flight until the request sent from the executor has joined it.
+  test_coalescing_caller* const waiter = state->waiter;
+  state->waiter = NULL;
+  if (waiter != NULL)
+  {
+    assert_return_code(az_platform_executor_submit(&waiter->work), AZ_OK);
+
+    int32_t const* const joined = &state->coalescer->_internal.flights[0]._internal.waiter_count;
+    for (int32_t i = 0; i < 5000 && *(int32_t const volatile*)joined == 0; i++)
+    {
+      az_platform_sleep_msec(1);
+    }
+  }
+
+  return az_http_response_append(ref_response, test_coalescing_response);
+}
+
+static az_result test_coalescing_send(
+    test_coalescing_state* state,
+    az_context* context,
+    az_http_method method,
+    az_http_response* response)
+{
+  uint8_t url_buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  az_span url = AZ_SPAN_FROM_BUFFER(url_buf);
+  az_span_copy(url, AZ_SPAN_FROM_STR("https://example.blob.core.windows.net/c/b"));
+
+  az_http_request request;
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          context,
+          method,
+          url,
+          (int32_t)sizeof("https://example.blob.core.windows.net/c/b") - 1,
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+  assert_return_code(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("x-ms-version"), AZ_SPAN_FROM_STR("1")),
+      AZ_OK);
+
+  _az_http_policy policies[] = {
+    {
+      ._internal = {
+        .process = test_coalescing_transport,
+        .options = state,
+      },
+    },
+    {
+      ._internal = {
+        .process = NULL,
+        .options = NULL,
+      },
+    },
+  };
+
+  _az_http_policy_coalescing_options options
+      = { .coalescer = state->coalescer, .credential = state->credential };
+  return az_http_pipeline_policy_coalescing(policies, &options, &request, response);
+}
+
+static void test_coalescing_assert_response(az_http_response* response)
+{
+  az_http_response_status_line status_line;
+  assert_return_code(az_http_response_get_status_line(response, &status_line), AZ_OK);
+  assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_OK);
+
+  az_span body = AZ_SPAN_EMPTY;
+  assert_return_code(az_http_response_get_body(response, &body), AZ_OK);
+  assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("shared")));
+}
+
+void test_az_http_pipeline_policy_coalescing(void** state)
+{
+  (void)state;
+
+  az_http_request_coalescer coalescer;
+  az_http_request_coalescer_init(&coalescer);
+  int32_t credential = 0;
+  test_coalescing_state coalescing
+      = { .coalescer = &coalescer, .credential = &credential, .joined_credential = &credential };
+
+  uint8_t response_buf[sizeof(TEST_COALESCING_RESPONSE) - 1];
+  az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+
+  // Requests which aren't in flight at the same time are each sent.
+  for (int32_t i = 0; i < 2; i++)
+  {
+    _az_http_response_reset(&response);
+    assert_return_code(
+        test_coalescing_send(
+            &coalescing, &az_context_application, az_http_method_get(), &response),
+        AZ_OK);
+    test_coalescing_assert_response(&response);
+  }
+  assert_int_equal(coalescing.send_count, 2);
+
+  // A request which changes something is sent even when an identical one is in flight.
+  az_context canceled = az_context_create_with_expiration(&az_context_application, 0);
+  az_context_cancel(&canceled);
+  coalescing.joined_context = &canceled;
+  _az_http_response_reset(&response);
+  assert_return_code(
+      test_coalescing_send(&coalescing, &az_context_application, az_http_method_put(), &response),
+      AZ_OK);
+  assert_int_equal(coalescing.send_count, 4);
+  assert_return_code(coalescing.joined_result, AZ_OK);
+
+  // An identical GET joins the one in flight, and gives up waiting once its context is canceled.
+  coalescing.joined_context = &canceled;
+  _az_http_response_reset(&response);
+  assert_return_code(
+      test_coalescing_send(&coalescing, &az_context_application, az_http_method_get(), &response),
+      AZ_OK);
+  assert_int_equal(coalescing.send_count, 5);
+  assert_int_equal(coalescing.joined_result, AZ_ERROR_CANCELED);
+  test_coalescing_assert_response(&response);
+
+  // A GET from a client with another credential isn't authorized to get the response, so it is
+  // sent, as is one from an anonymous client.
+  int32_t other_credential = 0;
+  void const* const other_credentials[] = { &other_credential, NULL };
+  for (int32_t i = 0; i < 2; i++)
+  {
+    coalescing.joined_context = &canceled;
+    coalescing.joined_credential = other_credentials[i];
+    _az_http_response_reset(&response);
+    assert_return_code(
+        test_coalescing_send(
+            &coalescing, &az_context_application, az_http_method_get(), &response),
+        AZ_OK);
+    assert_int_equal(coalescing.send_count, 7 + 2 * i);
+    assert_return_code(coalescing.joined_result, AZ_OK);
+  }
+
+  for (int32_t i = 0; i < AZ_HTTP_REQUEST_COALESCER_MAX_IN_FLIGHT; i++)
+  {
+    assert_false(coalescer._internal.flights[i]._internal.is_in_use);
+    assert_int_equal(coalescer._internal.flights[i]._internal.waiter_count, 0);
+  }
+
+  // Without a coalescer, the policy only calls the next one.
+  coalescing.coalescer = NULL;
+  _az_http_response_reset(&response);
+  assert_return_code(
+      test_coalescing_send(&coalescing, &az_context_application, az_http_method_get(), &response),
+      AZ_OK);
+  assert_int_equal(coalescing.send_count, 10);
+}
+
+#ifndef _az_MOCK_ENABLED
+static void test_coalescing_waiter(void* user_context)
+{
+  test_coalescing_caller* const caller = (test_coalescing_caller*)user_context;
+  caller->result = test_coalescing_send(
+      caller->state, &az_context_application, az_http_method_get(), &caller->response);
+}
+#endif // _az_MOCK_ENABLED
+
+void test_az_http_pipeline_policy_coalescing_shares_response(void** state)
+{
+  (void)state;
+
+#ifndef _az_MOCK_ENABLED
+  // Without a platform, the clock stays at 0 and the executor runs work before submit returns, so
+  // requests can't be in flight at the same time.
+  if (az_platform_clock_msec() == 0)
+  {
+    return;
+  }
+
+  az_http_request_coalescer coalescer;
+  az_http_request_coalescer_init(&coalescer);
+
+  test_coalescing_caller waiter = { .result = AZ_ERROR_NOT_IMPLEMENTED };
+  test_coalescing_state coalescing = { .coalescer = &coalescer, .waiter = &waiter };
+  waiter.state = &coalescing;
+  assert_return_code(
+      az_http_response_init(&waiter.response, AZ_SPAN_FROM_BUFFER(waiter.response_buf)), AZ_OK);
+  az_platform_work_init(&waiter.work, test_coalescing_waiter, &waiter);
+
+  uint8_t response_buf[sizeof(TEST_COALESCING_RESPONSE) - 1];
+  az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+  assert_return_code(
+      test_coalescing_send(&coalescing, &az_context_application, az_http_method_get(), &response),
+      AZ_OK);
+
+  // The waiter copied the response before the request it joined returned.
+  az_platform_executor_wait(&waiter.work);
+  assert_int_equal(waiter.result, AZ_OK);
+  assert_int_equal(coalescing.send_count, 1);
+  test_coalescing_assert_response(&waiter.response);
+  test_coalescing_assert_response(&response);
+#endif // _az_MOCK_ENABLED
+}
+
+typedef struct
+{
+  az_span etag;
+  az_span response;
+  int32_t send_count;
+  bool was_conditional;
+} test_response_cache_service;
+
+static az_result test_response_cache_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+
+  test_response_cache_service* const service = (test_response_cache_service*)ref_options;
+  service->send_count++;
+
+  az_span if_none_match = AZ_SPAN_EMPTY;
+  service->was_conditional = az_result_succeeded(az_http_request_get_header_by_name(
+      ref_request, AZ_SPAN_FROM_STR("If-None-Match"), &if_none_match));
+  if (service->was_conditional && az_span_is_content_equal(if_none_match, service->etag))
+  {
+    return az_http_response_append(
+        ref_response, AZ_SPAN_FROM_STR("HTTP/1.1 304 Not Modified\r\n\r\n"));
+  }
+
+  return az_http_response_append(ref_response, service->response);
+}
+
+static void test_response_cache_send(
+    az_http_response_cache* cache,
+    test_response_cache_service* service,
+    az_http_method method,
+    az_span url,
+    az_span expected_response)
+{
+  uint8_t url_buf[100];
+  uint8_t header_buf[(2 * sizeof(_az_http_request_header))];
+  az_span_copy(AZ_SPAN_FROM_BUFFER(url_buf), url);
+
+  az_http_request request;
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          method,
+          AZ_SPAN_FROM_BUFFER(url_buf),
+          az_span_size(url),
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+
+  _az_http_policy policies[] = {
+    {
+      ._internal = {
+        .process = test_response_cache_transport,
+        .options = service,
+      },
+    },
+    {
+      ._internal = {
+        .process = NULL,
+        .options = NULL,
+      },
+    },
+  };
+
+  uint8_t response_buf[128];
+  az_http_response response;
+  assert_return_code(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)), AZ_OK);
+  assert_return_code(
+      az_http_pipeline_policy_response_cache(policies, cache, &request, &response), AZ_OK);
+
+  // The If-None-Match header only lasts for the call.
+  assert_int_equal(az_http_request_headers_count(&request), 0);
+  assert_true(az_span_is_content_equal(
+      az_span_slice(response._internal.http_response, 0, response._internal.written),
+      expected_response));
+}
+
+void test_az_http_pipeline_policy_response_cache(void** state)
+{
+  (void)state;
+
+  az_span const first = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nETag: \"1\"\r\n\r\nfirst");
+  az_span const second = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nETag: \"2\"\r\n\r\nsecond");
+  az_span const url = AZ_SPAN_FROM_STR("https://example.blob.core.windows.net/c/b");
+  az_span const other_url = AZ_SPAN_FROM_STR("https://example.blob.core.windows.net/c/other");
+
+  uint8_t memory[256];
+  az_http_response_cache cache;
+  assert_return_code(
+      az_http_response_cache_init(&cache, AZ_SPAN_FROM_BUFFER(memory), 2), AZ_OK);
+
+  test_response_cache_service service = {
+    .etag = AZ_SPAN_FROM_STR("\"1\""),
+    .response = first,
+  };
+
+  // The first response is cached, then revalidated, and served from the cache on 304.
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, first);
+  assert_false(service.was_conditional);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, first);
+  assert_true(service.was_conditional);
+  assert_int_equal(service.send_count, 2);
+
+  // Once the resource changes, its new response replaces the cached one.
+  service.etag = AZ_SPAN_FROM_STR("\"2\"");
+  service.response = second;
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  assert_true(service.was_conditional);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  assert_true(service.was_conditional);
+
+  // Other methods are neither cached nor revalidated.
+  test_response_cache_send(&cache, &service, az_http_method_put(), url, second);
+  assert_false(service.was_conditional);
+
+  // A response which doesn't fit a slot isn't cached.
+  assert_return_code(az_http_response_cache_init(&cache, AZ_SPAN_FROM_BUFFER(memory), 4), AZ_OK);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  assert_false(service.was_conditional);
+
+  // With a single slot, caching the response of another request evicts the first one.
+  assert_return_code(az_http_response_cache_init(&cache, AZ_SPAN_FROM_BUFFER(memory), 1), AZ_OK);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  test_response_cache_send(&cache, &service, az_http_method_get(), other_url, second);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  assert_false(service.was_conditional);
+  test_response_cache_send(&cache, &service, az_http_method_get(), url, second);
+  assert_true(service.was_conditional);
+
+  // Without a cache, the policy only calls the next one.
+  test_response_cache_send(NULL, &service, az_http_method_get(), url, second);
+  assert_false(service.was_conditional);
+}
+
+#ifndef _az_MOCK_ENABLED
+static az_span const test_policy_url
+    = AZ_SPAN_LITERAL_FROM_STR("https://example.blob.core.windows.net/c/b");
+
+// The service behind a policy under test, which answers every request with the same response.
+typedef struct
+{
+  az_span response;
+  int32_t send_count;
+} test_policy_service;
+
+static az_result test_policy_service_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_request;
+
+  test_policy_service* const service = (test_policy_service*)ref_options;
+  service->send_count++;
+  return az_http_response_append(ref_response, service->response);
+}
+
+// A GET request sent through a policy under test, and the response it got.
+typedef struct
+{
+  uint8_t url_buf[100];
+  uint8_t header_buf[sizeof(_az_http_request_header)];
+  az_http_request request;
+  uint8_t response_buf[128];
+  az_http_response response;
+} test_policy_exchange;
+
+// Sends a GET request for \p url through \p policy, with \p transport as the next and last policy.
+static az_result test_policy_send(
+    test_policy_exchange* out_exchange,
+    az_context* context,
+    az_span url,
+    _az_http_policy_process_fn policy,
+    void* policy_options,
+    _az_http_policy_process_fn transport,
+    void* transport_options)
+{
+  az_span_copy(AZ_SPAN_FROM_BUFFER(out_exchange->url_buf), url);
+  assert_return_code(
+      az_http_request_init(
+          &out_exchange->request,
+          context,
+          az_http_method_get(),
+          AZ_SPAN_FROM_BUFFER(out_exchange->url_buf),
+          az_span_size(url),
+          AZ_SPAN_FROM_BUFFER(out_exchange->header_buf),
+          AZ_SPAN_EMPTY),
+      AZ_OK);
+
+  _az_http_policy policies[] = {
+    {
+      ._internal = {
+        .process = transport,
+        .options = transport_options,
+      },
+    },
+    {
+      ._internal = {
+        .process = NULL,
+        .options = NULL,
+      },
+    },
+  };
+
+  assert_return_code(
+      az_http_response_init(
+          &out_exchange->response, AZ_SPAN_FROM_BUFFER(out_exchange->response_buf)),
+      AZ_OK);
+  return policy(policies, policy_options, &out_exchange->request, &out_exchange->response);
+}
+
+static az_result test_rate_limit_send(
+    az_http_rate_limiter* limiter,
+    test_policy_service* service,
+    az_context* context,
+    az_span response)
+{
+  service->response = response;
+  test_policy_exchange exchange;
+  az_result const result = test_policy_send(
+      &exchange,
+      context,
+      test_policy_url,
+      az_http_pipeline_policy_rate_limit,
+      limiter,
+      test_policy_service_transport,
+      service);
+
+  // The headers of the response are still there for the caller to read.
+  if (az_result_succeeded(result))
+  {
+    az_http_response_status_line status_line = { 0 };
+    az_span header_name = AZ_SPAN_EMPTY;
+    az_span header_value = AZ_SPAN_EMPTY;
+    assert_return_code(az_http_response_get_status_line(&exchange.response, &status_line), AZ_OK);
+    if (status_line.status_code != AZ_HTTP_STATUS_CODE_OK)
+    {
+      assert_return_code(
+          az_http_response_get_next_header(&exchange.response, &header_name, &header_value),
+          AZ_OK);
+    }
+  }
+
+  return result;
+}
+#endif // _az_MOCK_ENABLED
+
+void test_az_http_pipeline_policy_rate_limit(void** state)
+{
+  (void)state;
+
+#ifndef _az_MOCK_ENABLED
+  az_span const ok = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n\r\n");
+  az_span const throttled
+      = AZ_SPAN_FROM_STR("HTTP/1.1 429 Too Many Requests\r\nretry-after-ms: 5\r\n\r\n");
+  az_span const unavailable
+      = AZ_SPAN_FROM_STR("HTTP/1.1 503 Service Unavailable\r\nServer: test\r\n\r\n");
+  az_span const throttled_longer
+      = AZ_SPAN_FROM_STR("HTTP/1.1 429 Too Many Requests\r\nRetry-After: 10\r\n\r\n");
+
+  test_policy_service service = { 0 };
+
+  // Without a limiter, the policy only calls the next one.
+  assert_return_code(test_rate_limit_send(NULL, &service, &az_context_application, ok), AZ_OK);
+  assert_int_equal(service.send_count, 1);
+
+  az_http_rate_limiter_options options = az_http_rate_limiter_options_default();
+  options.requests_per_second = 1000;
+  options.burst = 2;
+  az_http_rate_limiter limiter;
+  az_http_rate_limiter_init(&limiter, &options);
+
+  // Each request takes a token, which is refilled 1 ms later.
+  uint64_t now_usec = (uint64_t)az_platform_clock_msec() * _az_TIME_MICROSECONDS_PER_MILLISECOND;
+  assert_return_code(test_rate_limit_send(&limiter, &service, &az_context_application, ok), AZ_OK);
+  assert_return_code(test_rate_limit_send(&limiter, &service, &az_context_application, ok), AZ_OK);
+  assert_int_equal(service.send_count, 3);
+  assert_true(limiter._internal.full_at_usec >= now_usec + 2000);
+  assert_int_equal(limiter._internal.requests_per_second, 1000);
+
+  // A throttling response halves the rate, and empties the bucket until its Retry-After passed.
+  now_usec = (uint64_t)az_platform_clock_msec() * _az_TIME_MICROSECONDS_PER_MILLISECOND;
+  assert_return_code(
+      test_rate_limit_send(&limiter, &service, &az_context_application, throttled), AZ_OK);
+  assert_int_equal(limiter._internal.requests_per_second, 500);
+  assert_true(limiter._internal.full_at_usec >= now_usec + 5000 + 2000);
+
+  // Each successful response raises it back.
+  assert_return_code(test_rate_limit_send(&limiter, &service, &az_context_application, ok), AZ_OK);
+  assert_int_equal(limiter._internal.requests_per_second, 500 + (500 / 16));
+
+  // A throttling response without Retry-After only lowers the rate.
+  assert_return_code(
+      test_rate_limit_send(&limiter, &service, &az_context_application, unavailable), AZ_OK);
+  assert_int_equal(limiter._internal.requests_per_second, (500 + (500 / 16)) / 2);
+
+  // A request which would wait for longer than its context lasts isn't sent.
+  assert_return_code(
+      test_rate_limit_send(&limiter, &service, &az_context_application, throttled_longer), AZ_OK);
+  int32_t const send_count = service.send_count;
+  az_context canceled = az_context_create_with_expiration(&az_context_application, 0);
+  az_context_cancel(&canceled);
+  assert_int_equal(
+      test_rate_limit_send(&limiter, &service, &canceled, ok), AZ_ERROR_CANCELED);
+  assert_int_equal(service.send_count, send_count);
+
+  // Unless the limiter is adaptive, the responses don't change the rate.
+  options.is_adaptive = false;
+  az_http_rate_limiter_init(&limiter, &options);
+  assert_return_code(
+      test_rate_limit_send(&limiter, &service, &az_context_application, throttled), AZ_OK);
+  assert_int_equal(limiter._internal.requests_per_second, 1000);
+#endif // _az_MOCK_ENABLED
+}
+
+#ifndef _az_MOCK_ENABLED
+typedef struct test_circuit_breaker_service test_circuit_breaker_service;
+
+struct test_circuit_breaker_service
+{
+  az_http_circuit_breaker* breaker;
+  az_result result;
+  az_span response;
+  int32_t send_count;
+  bool send_while_in_flight;
+  az_result in_flight_result;
+};
+
+static az_result test_circuit_breaker_send(test_circuit_breaker_service* service, az_span url);
+
+static az_result test_circuit_breaker_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+
+  test_circuit_breaker_service* const service = (test_circuit_breaker_service*)ref_options;
+  service->send_count++;
+  if (service->send_while_in_flight)
+  {
+    service->send_while_in_flight = false;
+    az_span url = AZ_SPAN_EMPTY;
+    assert_return_code(az_http_request_get_url(ref_request, &url), AZ_OK);
+    service->in_flight_result = test_circuit_breaker_send(service, url);
+  }
+
+  return az_result_failed(service->result)
+      ? service->result
+      : az_http_response_append(ref_response, service->response);
+}
+
+static az_result test_circuit_breaker_send(test_circuit_breaker_service* service, az_span url)
+{
+  test_policy_exchange exchange;
+  return test_policy_send(
+      &exchange,
+      &az_context_application,
+      url,
+      az_http_pipeline_policy_circuit_breaker,
+      service->breaker,
+      test_circuit_breaker_transport,
+      service);
+}
+#endif // _az_MOCK_ENABLED
+
+void test_az_http_pipeline_policy_circuit_breaker(void** state)
+{
+  (void)state;
+
+#ifndef _az_MOCK_ENABLED
+  az_span const ok = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n\r\n");
+  az_span const unavailable = AZ_SPAN_FROM_STR("HTTP/1.1 503 Service Unavailable\r\n\r\n");
+  az_span const throttled = AZ_SPAN_FROM_STR("HTTP/1.1 429 Too Many Requests\r\n\r\n");
+  az_span const url = AZ_SPAN_FROM_STR("https://example.blob.core.windows.net/c/b");
+  az_span const same_host_url = AZ_SPAN_FROM_STR("https://example.blob.core.windows.net/c/other");
+  az_span const other_url = AZ_SPAN_FROM_STR("https://other.blob.core.windows.net/c/b?comp=list");
+
+  test_circuit_breaker_service service = { .result = AZ_OK, .response = ok };
+
+  // Without a breaker, the policy only calls the next one.
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  assert_int_equal(service.send_count, 1);
+
+  az_http_circuit_breaker_options options = az_http_circuit_breaker_options_default();
+  options.minimum_request_count = 4;
+  options.break_msec = 60 * 60 * 1000;
+  az_http_circuit_breaker breaker;
+  az_http_circuit_breaker_init(&breaker, &options);
+  service.breaker = &breaker;
+
+  // Throttling responses aren't failures, and the circuit stays closed below the minimum count.
+  service.response = throttled;
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  service.response = unavailable;
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  assert_return_code(test_circuit_breaker_send(&service, same_host_url), AZ_OK);
+  assert_false(breaker._internal.hosts[0]._internal.is_open);
+
+  // Once enough of the requests to the host failed, the others fail without being sent.
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  assert_true(breaker._internal.hosts[0]._internal.is_open);
+  assert_int_equal(service.send_count, 5);
+  assert_int_equal(test_circuit_breaker_send(&service, same_host_url), AZ_ERROR_HTTP_CIRCUIT_OPEN);
+  assert_int_equal(service.send_count, 5);
+
+  // The requests to other hosts are still sent, and those which couldn't be sent are failures.
+  service.result = AZ_ERROR_HTTP_ADAPTER;
+  for (int32_t i = 0; i < 4; i++)
+  {
+    assert_int_equal(test_circuit_breaker_send(&service, other_url), AZ_ERROR_HTTP_ADAPTER);
+  }
+  assert_int_equal(service.send_count, 9);
+  assert_int_equal(breaker._internal.host_count, 2);
+  assert_true(breaker._internal.hosts[1]._internal.is_open);
+
+  // Those the caller canceled aren't.
+  az_http_circuit_breaker_init(&breaker, &options);
+  service.result = AZ_ERROR_CANCELED;
+  for (int32_t i = 0; i < 4; i++)
+  {
+    assert_int_equal(test_circuit_breaker_send(&service, url), AZ_ERROR_CANCELED);
+  }
+  assert_false(breaker._internal.hosts[0]._internal.is_open);
+
+  // Once the break has passed, a single trial request is sent, which keeps the circuit open when
+  // it fails and closes it when it succeeds.
+  options.break_msec = 0;
+  az_http_circuit_breaker_init(&breaker, &options);
+  service.result = AZ_OK;
+  service.response = unavailable;
+  for (int32_t i = 0; i < 4; i++)
+  {
+    assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  }
+  assert_true(breaker._internal.hosts[0]._internal.is_open);
+
+  service.send_count = 0;
+  service.send_while_in_flight = true;
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  assert_int_equal(service.in_flight_result, AZ_ERROR_HTTP_CIRCUIT_OPEN);
+  assert_int_equal(service.send_count, 1);
+  assert_true(breaker._internal.hosts[0]._internal.is_open);
+
+  service.response = ok;
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  assert_false(breaker._internal.hosts[0]._internal.is_open);
+
+  // The failures which opened the circuit are forgotten once it closed.
+  service.response = unavailable;
+  assert_return_code(test_circuit_breaker_send(&service, url), AZ_OK);
+  assert_false(breaker._internal.hosts[0]._internal.is_open);
+#endif // _az_MOCK_ENABLED
+}
+
+void test_az_http_trace_context_get_traceparent(void** state)
+{
+  (void)state;
+
+  az_http_trace_context const trace_context = {
+    .trace_id = { 0x0a, 0xf7, 0x65, 0x19, 0x16, 0xcd, 0x43, 0xdd,
+                  0x84, 0x48, 0xeb, 0x21, 0x1c, 0x80, 0x31, 0x9c },
+    .span_id = { 0xb7, 0xad, 0x6b, 0x71, 0x69, 0x20, 0x33, 0x31 },
+    .is_sampled = true,
+  };
+
+  uint8_t buffer[AZ_HTTP_TRACEPARENT_SIZE + 1];
+  az_span traceparent = AZ_SPAN_EMPTY;
+  assert_return_code(
+      az_http_trace_context_get_traceparent(
+          &trace_context, AZ_SPAN_FROM_BUFFER(buffer), &traceparent),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(
+      traceparent, AZ_SPAN_FROM_STR("00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01")));
+
+  assert_int_equal(
+      az_http_trace_context_get_traceparent(
+          &trace_context, az_span_create(buffer, AZ_HTTP_TRACEPARENT_SIZE - 1), &traceparent),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+#ifndef _az_MOCK_ENABLED
+typedef struct
+{
+  uint8_t traceparent[AZ_HTTP_TRACEPARENT_SIZE];
+  int32_t traceparent_size;
+} test_tracing_service;
+
+static az_result test_tracing_transport(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+
+  test_tracing_service* const service = (test_tracing_service*)ref_options;
+  az_span traceparent = AZ_SPAN_EMPTY;
+  service->traceparent_size = 0;
+  if (az_result_succeeded(az_http_request_get_header_by_name(
+          ref_request, AZ_SPAN_FROM_STR("traceparent"), &traceparent)))
+  {
+    assert_int_equal(az_span_size(traceparent), AZ_HTTP_TRACEPARENT_SIZE);
+    az_span_copy(AZ_SPAN_FROM_BUFFER(service->traceparent), traceparent);
+    service->traceparent_size = az_span_size(traceparent);
+  }
+
+  return az_http_response_append(ref_response, AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n\r\n"));
+}
+
+static void test_tracing_send(
+    az_http_tracer* tracer,
+    test_tracing_service* service,
+    az_context* context)
+{
+  test_policy_exchange exchange;
+  assert_return_code(
+      test_policy_send(
+          &exchange,
+          context,
+          test_policy_url,
+          az_http_pipeline_policy_tracing,
+          tracer,
+          test_tracing_transport,
+          service),
+      AZ_OK);
+
+  // The traceparent header only lasts for the call.
+  assert_int_equal(az_http_request_headers_count(&exchange.request), 0);
+}
+
+static void test_tracing_assert_traceparent(
+    test_tracing_service* service,
+    az_http_trace_context const* trace_context)
+{
+  uint8_t buffer[AZ_HTTP_TRACEPARENT_SIZE];
+  az_span traceparent = AZ_SPAN_EMPTY;
+  assert_return_code(
+      az_http_trace_context_get_traceparent(
+          trace_context, AZ_SPAN_FROM_BUFFER(buffer), &traceparent),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(
+      az_span_create(service->traceparent, service->traceparent_size), traceparent));
+}
+#endif // _az_MOCK_ENABLED
+
+void test_az_http_pipeline_policy_tracing(void** state)
+{
+  (void)state;
+
+#ifndef _az_MOCK_ENABLED
+  uint8_t const no_parent[AZ_HTTP_TRACE_SPAN_ID_SIZE] = { 0 };
+  test_tracing_service service = { 0 };
+
+  // Without a tracer, the policy only calls the next one.
+  test_tracing_send(NULL, &service, &az_context_application);
+  assert_int_equal(service.traceparent_size, 0);
+
+  az_http_tracer_options options = az_http_tracer_options_default();
+  options.seed = 42;
+  az_http_trace_span spans[2];
+  az_http_tracer tracer;
+  az_http_tracer_init(&tracer, spans, 2, &options);
+
+  // A request sent for no operation starts a trace.
+  test_tracing_send(&tracer, &service, &az_context_application);
+  assert_int_equal(az_http_tracer_get_span_count(&tracer), 1);
+  test_tracing_assert_traceparent(&service, &spans[0].context);
+  assert_memory_equal(spans[0].parent_span_id, no_parent, AZ_HTTP_TRACE_SPAN_ID_SIZE);
+  assert_int_equal(spans[0].status_code, AZ_HTTP_STATUS_CODE_OK);
+  assert_int_equal(spans[0].result, AZ_OK);
+  assert_true(spans[0].start_msec <= spans[0].end_msec);
+
+  // A request sent for an operation is traced as its child.
+  az_http_trace_context operation;
+  az_http_tracer_start_trace(&tracer, &operation);
+  assert_true(operation.is_sampled);
+  az_context context = az_http_trace_context_create(&az_context_application, &operation);
+  test_tracing_send(&tracer, &service, &context);
+  assert_int_equal(az_http_tracer_get_span_count(&tracer), 2);
+  test_tracing_assert_traceparent(&service, &spans[1].context);
+  assert_memory_equal(spans[1].context.trace_id, operation.trace_id, AZ_HTTP_TRACE_ID_SIZE);
+  assert_memory_equal(spans[1].parent_span_id, operation.span_id, AZ_HTTP_TRACE_SPAN_ID_SIZE);
+  assert_true(
+      memcmp(spans[1].context.span_id, operation.span_id, AZ_HTTP_TRACE_SPAN_ID_SIZE) != 0);
+
+  // Once the buffer is full, requests are still traced, and their spans dropped.
+  test_tracing_send(&tracer, &service, &context);
+  assert_int_equal(service.traceparent_size, AZ_HTTP_TRACEPARENT_SIZE);
+  assert_int_equal(az_http_tracer_get_span_count(&tracer), 2);
+  assert_int_equal(tracer._internal.span_count, 3);
+
+  // The requests of an operation which isn't sampled aren't, whatever the tracer samples.
+  operation.is_sampled = false;
+  test_tracing_send(&tracer, &service, &context);
+  assert_int_equal(service.traceparent_size, 0);
+  assert_int_equal(tracer._internal.span_count, 3);
+
+  // Nor are the traces the requests start when the tracer samples none.
+  options.sample_one_in = 0;
+  az_http_tracer_init(&tracer, NULL, 0, &options);
+  test_tracing_send(&tracer, &service, &az_context_application);
+  assert_int_equal(service.traceparent_size, 0);
+  az_http_tracer_start_trace(&tracer, &operation);
+  assert_false(operation.is_sampled);
+
+  // When one in two traces is sampled, some are and some aren't.
+  options.sample_one_in = 2;
+  az_http_tracer_init(&tracer, NULL, 0, &options);
+  int32_t sampled_count = 0;
+  for (int32_t i = 0; i < 64; i++)
+  {
+    test_tracing_send(&tracer, &service, &az_context_application);
+    sampled_count += service.traceparent_size > 0 ? 1 : 0;
+  }
+  assert_true(sampled_count > 0 && sampled_count < 64);
+  assert_int_equal(tracer._internal.span_count, sampled_count);
+#endif // _az_MOCK_ENABLED
+}
+
 int test_az_policy()
 {
   const struct CMUnitTest tests[] = {
@@ -373,6 +2279,26 @@ int test_az_policy()
 #endif // _az_MOCK_ENABLED
     cmocka_unit_test(test_az_http_pipeline_policy_apiversion),
     cmocka_unit_test(test_az_http_pipeline_policy_telemetry),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_wait_callback),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_jitter),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_deadline),
+    cmocka_unit_test(test_az_http_pipeline_policy_hedge_passes_through),
+    cmocka_unit_test(test_az_http_pipeline_policy_hedge_submit_fails),
+    cmocka_unit_test(test_az_http_pipeline_policy_metrics),
+    cmocka_unit_test(test_az_http_pipeline_policy_metrics_disabled),
+    cmocka_unit_test(test_az_http_pipeline_policy_metrics_shared),
+    cmocka_unit_test(test_az_http_pipeline_policy_compression_round_trip),
+    cmocka_unit_test(test_az_http_pipeline_policy_compression_binary),
+    cmocka_unit_test(test_az_http_pipeline_policy_compression_dynamic_codes),
+    cmocka_unit_test(test_az_http_pipeline_policy_compression_passes_through),
+    cmocka_unit_test(test_az_credential_token_cache),
+    cmocka_unit_test(test_az_http_pipeline_policy_coalescing),
+    cmocka_unit_test(test_az_http_pipeline_policy_coalescing_shares_response),
+    cmocka_unit_test(test_az_http_pipeline_policy_response_cache),
+    cmocka_unit_test(test_az_http_pipeline_policy_rate_limit),
+    cmocka_unit_test(test_az_http_pipeline_policy_circuit_breaker),
+    cmocka_unit_test(test_az_http_trace_context_get_traceparent),
+    cmocka_unit_test(test_az_http_pipeline_policy_tracing),
   };
   return cmocka_run_group_tests_name("az_core_policy", tests, NULL, NULL);
 }
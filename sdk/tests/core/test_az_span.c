@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include "az_simd_private.h"
 #include "az_span_private.h"
 #include "az_test_definitions.h"
 #include <azure/core/az_span.h>
@@ -14,6 +15,7 @@
 #include <math.h>
 #include <setjmp.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <cmocka.h>
 
@@ -92,6 +94,50 @@ static void az_span_to_lower_test(void** state)
   assert_false(az_span_is_content_equal_ignoring_case(a, d));
 }
 
+static void az_span_is_content_equal_ignoring_case_long_test(void** state)
+{
+  (void)state;
+
+  // Lengths around and beyond a vector block, so that whole and overlapping blocks are compared.
+  uint8_t lower[70];
+  uint8_t mixed[70];
+  for (int32_t i = 0; i < (int32_t)sizeof(lower); i++)
+  {
+    lower[i] = (uint8_t)('a' + (i % 26));
+    mixed[i] = (uint8_t)(i % 3 == 0 ? lower[i] - 'a' + 'A' : lower[i]);
+  }
+
+  // Pairs of bytes which differ only by the case bit but aren't letters.
+  uint8_t const not_letters[][2] = { { '@', '`' }, { '[', '{' }, { '^', '~' }, { 0xC1, 0xE1 } };
+
+  for (int32_t size = 0; size <= (int32_t)sizeof(lower); size++)
+  {
+    az_span const lower_span = az_span_create(lower, size);
+    az_span const mixed_span = az_span_create(mixed, size);
+    assert_true(az_span_is_content_equal_ignoring_case(lower_span, mixed_span));
+    assert_true(az_span_is_content_equal_ignoring_case(mixed_span, lower_span));
+
+    for (int32_t i = 0; i < size; i++)
+    {
+      uint8_t const original = mixed[i];
+      mixed[i] = (uint8_t)(original + 1);
+      assert_false(az_span_is_content_equal_ignoring_case(lower_span, mixed_span));
+      mixed[i] = original;
+
+      uint8_t const original_lower = lower[i];
+      for (size_t pair = 0; pair < sizeof(not_letters) / sizeof(not_letters[0]); pair++)
+      {
+        lower[i] = not_letters[pair][0];
+        mixed[i] = not_letters[pair][1];
+        assert_false(az_span_is_content_equal_ignoring_case(lower_span, mixed_span));
+        assert_false(az_span_is_content_equal_ignoring_case(mixed_span, lower_span));
+      }
+      lower[i] = original_lower;
+      mixed[i] = original;
+    }
+  }
+}
+
 static void test_az_span_is_content_equal(void** state)
 {
   (void)state;
@@ -638,6 +684,41 @@ static void az_span_atod_test(void** state)
   assert_true(value == 0);
 }
 
+#define AZ_SPAN_ATOD_EXACT_HELPER(source, expected)                              \
+  do                                                                             \
+  {                                                                              \
+    double value = 0;                                                            \
+    assert_int_equal(az_span_atod(AZ_SPAN_FROM_STR(source), &value), AZ_OK);     \
+    assert_memory_equal(&value, &(double){ expected }, sizeof(double));          \
+  } while (0)
+
+static void az_span_atod_exact_test(void** state)
+{
+  (void)state;
+
+  // Converted with a single exact multiplication or division.
+  AZ_SPAN_ATOD_EXACT_HELPER("0.1", 0.1);
+  AZ_SPAN_ATOD_EXACT_HELPER("-0", -0.0);
+  AZ_SPAN_ATOD_EXACT_HELPER("21.53", 21.53);
+  AZ_SPAN_ATOD_EXACT_HELPER("-0.000123456789", -0.000123456789);
+  AZ_SPAN_ATOD_EXACT_HELPER("9007199254740991", 9007199254740991.0);
+  AZ_SPAN_ATOD_EXACT_HELPER("1e22", 1e22);
+  AZ_SPAN_ATOD_EXACT_HELPER("1e-22", 1e-22);
+  AZ_SPAN_ATOD_EXACT_HELPER("12e30", 12e30);
+  AZ_SPAN_ATOD_EXACT_HELPER("0.000e400", 0.0);
+  AZ_SPAN_ATOD_EXACT_HELPER("1234567890123456789e-5", 1234567890123456789e-5);
+
+  // Too many digits, or too large an exponent, for the fast path.
+  AZ_SPAN_ATOD_EXACT_HELPER("9007199254740993", 9007199254740993.0);
+  AZ_SPAN_ATOD_EXACT_HELPER("12345678901234567890", 12345678901234567890.0);
+  AZ_SPAN_ATOD_EXACT_HELPER("1e23", 1e23);
+  AZ_SPAN_ATOD_EXACT_HELPER("123456e30", 123456e30);
+  AZ_SPAN_ATOD_EXACT_HELPER("1e-23", 1e-23);
+  AZ_SPAN_ATOD_EXACT_HELPER("1.7976931348623157e308", 1.7976931348623157e308);
+  AZ_SPAN_ATOD_EXACT_HELPER("4.9e-324", 4.9e-324);
+  AZ_SPAN_ATOD_EXACT_HELPER("0.1e-99999", 0.0);
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif // __GNUC__
@@ -934,6 +1015,164 @@ static void az_span_find_overlapping_checks_success(void** state)
   assert_int_equal(az_span_find(source, az_span_slice(span, 2, 4)), 1);
 }
 
+static int32_t _naive_find(az_span source, az_span target)
+{
+  for (int32_t i = 0; i + az_span_size(target) <= az_span_size(source); i++)
+  {
+    if (az_span_is_content_equal(az_span_slice(source, i, i + az_span_size(target)), target))
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void test_az_span_builder(void** state)
+{
+  (void)state;
+
+  {
+    // All of the pieces fit.
+    uint8_t buffer[32] = { 0 };
+    _az_span_builder builder;
+    _az_span_builder_init(&builder, AZ_SPAN_FROM_BUFFER(buffer));
+    _az_span_builder_append(&builder, AZ_SPAN_FROM_STR("res/"));
+    _az_span_builder_append_u32(&builder, 200);
+    _az_span_builder_append_u8(&builder, '?');
+    _az_span_builder_append(&builder, AZ_SPAN_EMPTY);
+    _az_span_builder_append_u64(&builder, 12345678901234ull);
+    _az_span_builder_append_url_encoded(&builder, AZ_SPAN_FROM_STR("a b"));
+    assert_int_equal(_az_span_builder_result(&builder), AZ_OK);
+    assert_int_equal(_az_span_builder_length(&builder), sizeof("res/200?12345678901234a%20b") - 1);
+    assert_true(az_span_is_content_equal(
+        _az_span_builder_get_span(&builder), AZ_SPAN_FROM_STR("res/200?12345678901234a%20b")));
+  }
+  {
+    // The pieces after one that doesn't fit are counted but not written.
+    uint8_t buffer[7] = { '*', '*', '*', '*', '*', '*', '*' };
+    _az_span_builder builder;
+    _az_span_builder_init(&builder, AZ_SPAN_FROM_BUFFER(buffer));
+    _az_span_builder_append(&builder, AZ_SPAN_FROM_STR("abcde"));
+    _az_span_builder_append_url_encoded(&builder, AZ_SPAN_FROM_STR("/"));
+    _az_span_builder_append_u8(&builder, 'f');
+    assert_int_equal(_az_span_builder_result(&builder), AZ_ERROR_NOT_ENOUGH_SPACE);
+    assert_int_equal(_az_span_builder_length(&builder), 9);
+    assert_true(
+        az_span_is_content_equal(AZ_SPAN_FROM_BUFFER(buffer), AZ_SPAN_FROM_STR("abcde**")));
+  }
+  {
+    // Segments reference the appended spans and share the generated text where it is contiguous.
+    az_span const prefix = AZ_SPAN_FROM_STR("$iothub/methods/res/");
+    az_span const request_id = AZ_SPAN_FROM_STR("abc");
+    uint8_t buffer[16] = { 0 };
+    az_span segments[4];
+    _az_span_builder builder;
+    _az_span_builder_init_segmented(&builder, AZ_SPAN_FROM_BUFFER(buffer), segments, 4);
+    _az_span_builder_append(&builder, prefix);
+    _az_span_builder_append_u32(&builder, 404);
+    _az_span_builder_append_u8(&builder, '/');
+    _az_span_builder_append(&builder, request_id);
+    assert_int_equal(_az_span_builder_result(&builder), AZ_OK);
+    assert_int_equal(builder.segment_count, 3);
+    assert_ptr_equal(az_span_ptr(segments[0]), az_span_ptr(prefix));
+    assert_int_equal(az_span_size(segments[0]), az_span_size(prefix));
+    assert_true(az_span_is_content_equal(segments[1], AZ_SPAN_FROM_STR("404/")));
+    assert_ptr_equal(az_span_ptr(segments[2]), az_span_ptr(request_id));
+    assert_int_equal(_az_span_builder_length(&builder), az_span_size(prefix) + 4 + 3);
+  }
+  {
+    // Running out of segments fails like running out of buffer.
+    uint8_t buffer[4] = { 0 };
+    az_span segments[1];
+    _az_span_builder builder;
+    _az_span_builder_init_segmented(&builder, AZ_SPAN_FROM_BUFFER(buffer), segments, 1);
+    _az_span_builder_append(&builder, AZ_SPAN_FROM_STR("one"));
+    _az_span_builder_append_u8(&builder, '/');
+    assert_int_equal(_az_span_builder_result(&builder), AZ_ERROR_NOT_ENOUGH_SPACE);
+    assert_int_equal(_az_span_builder_length(&builder), 4);
+    assert_int_equal(builder.segment_count, 1);
+  }
+}
+
+static void az_span_find_long_source_success(void** state)
+{
+  (void)state;
+
+  // Sources longer than a vector block, made of a small alphabet so that the first and last bytes
+  // of the target match at many positions which are not a full match.
+  uint8_t buffer[200];
+  uint32_t seed = 12345;
+  for (size_t i = 0; i < sizeof(buffer); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    buffer[i] = (uint8_t)('a' + ((seed >> 16) % 2));
+  }
+
+  az_span const targets[] = {
+    AZ_SPAN_FROM_STR("b"),        AZ_SPAN_FROM_STR("ab"),        AZ_SPAN_FROM_STR("abba"),
+    AZ_SPAN_FROM_STR("aabbaabb"), AZ_SPAN_FROM_STR("abababbbaa"), AZ_SPAN_FROM_STR("bbbbbbbbbb"),
+  };
+
+  for (int32_t size = 0; size <= (int32_t)sizeof(buffer); size += 7)
+  {
+    az_span const source = az_span_create(buffer, size);
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++)
+    {
+      assert_int_equal(az_span_find(source, targets[t]), _naive_find(source, targets[t]));
+    }
+  }
+
+  // A target at the very end of a long source.
+  az_span const topic
+      = AZ_SPAN_FROM_STR("devices/my_device/messages/devicebound/%24.to=%2Fdevices%2Fmy_device");
+  assert_int_equal(az_span_find(topic, AZ_SPAN_FROM_STR("my_device")), 8);
+  assert_int_equal(az_span_find(topic, AZ_SPAN_FROM_STR("%2Fmy_device")), 56);
+  assert_int_equal(az_span_find(topic, AZ_SPAN_FROM_STR("%2Fmy_devicf")), -1);
+}
+
+static void az_span_find_kernels_success(void** state)
+{
+  (void)state;
+#ifdef _az_SIMD
+  // Each kernel the host can run, from the narrowest, finds what the naive search finds, with
+  // targets which straddle the 16, 32 and 64-byte blocks of the kernels.
+  uint32_t const feature_sets[] = {
+    0,
+    _az_SIMD_FEATURE_SSE2,
+    _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_AVX2,
+    _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_AVX2 | _az_SIMD_FEATURE_AVX512BW,
+    _az_SIMD_FEATURE_NEON,
+  };
+
+  uint8_t buffer[300];
+  for (size_t i = 0; i < sizeof(buffer); i++)
+  {
+    buffer[i] = (uint8_t)('a' + (i % 3));
+  }
+
+  az_span const target = AZ_SPAN_FROM_STR("xyz");
+  for (size_t f = 0; f < sizeof(feature_sets) / sizeof(feature_sets[0]); f++)
+  {
+    _az_simd_select_kernels(feature_sets[f] & _az_simd_get_features());
+    for (int32_t offset = 0; offset + az_span_size(target) <= (int32_t)sizeof(buffer); offset += 5)
+    {
+      uint8_t source[sizeof(buffer)];
+      memcpy(source, buffer, sizeof(source));
+      memcpy(source + offset, az_span_ptr(target), (size_t)az_span_size(target));
+
+      az_span const source_span = AZ_SPAN_FROM_BUFFER(source);
+      assert_int_equal(az_span_find(source_span, target), offset);
+      assert_int_equal(az_span_find(source_span, target), _naive_find(source_span, target));
+      assert_int_equal(
+          az_span_find(az_span_slice(source_span, 0, offset + 2), target),
+          _naive_find(az_span_slice(source_span, 0, offset + 2), target));
+    }
+  }
+
+  _az_simd_select_kernels(_az_simd_get_features());
+#endif // _az_SIMD
+}
+
 static void az_span_i64toa_test(void** state)
 {
   (void)state;
@@ -1187,6 +1426,61 @@ static void az_span_u32toa_overflow_fails(void** state)
   assert_true(az_span_u32toa(buffer, v, &out_span) == AZ_ERROR_NOT_ENOUGH_SPACE);
 }
 
+static void az_span_toa_digit_boundaries_succeeds(void** state)
+{
+  (void)state;
+  uint8_t raw_buffer[25];
+  uint8_t expected_buffer[25];
+  az_span out_span;
+
+  // 10^k - 1 is written as k nines and 10^k as a one followed by k zeros.
+  uint64_t power = 1;
+  for (int32_t k = 1; k <= 19; k++)
+  {
+    power *= 10;
+    int32_t const expected_size = k + 1;
+
+    memset(expected_buffer, '9', (size_t)k);
+    assert_int_equal(_az_span_u64_digit_count(power - 1), k);
+    assert_int_equal(az_span_u64toa(AZ_SPAN_FROM_BUFFER(raw_buffer), power - 1, &out_span), AZ_OK);
+    assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - k);
+    assert_memory_equal(raw_buffer, expected_buffer, (size_t)k);
+
+    expected_buffer[0] = '1';
+    memset(expected_buffer + 1, '0', (size_t)k);
+    assert_int_equal(_az_span_u64_digit_count(power), expected_size);
+    assert_int_equal(az_span_u64toa(AZ_SPAN_FROM_BUFFER(raw_buffer), power, &out_span), AZ_OK);
+    assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - expected_size);
+    assert_memory_equal(raw_buffer, expected_buffer, (size_t)expected_size);
+
+    if (power <= UINT32_MAX)
+    {
+      assert_int_equal(_az_span_u32_digit_count((uint32_t)power), expected_size);
+      assert_int_equal(
+          az_span_u32toa(AZ_SPAN_FROM_BUFFER(raw_buffer), (uint32_t)power, &out_span), AZ_OK);
+      assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - expected_size);
+      assert_memory_equal(raw_buffer, expected_buffer, (size_t)expected_size);
+    }
+
+    // A destination one byte short of the digit count must be rejected.
+    assert_int_equal(
+        az_span_u64toa(az_span_create(raw_buffer, k), power, &out_span),
+        AZ_ERROR_NOT_ENOUGH_SPACE);
+  }
+
+  assert_int_equal(_az_span_u64_digit_count(UINT64_MAX), 20);
+  assert_int_equal(az_span_u64toa(AZ_SPAN_FROM_BUFFER(raw_buffer), UINT64_MAX, &out_span), AZ_OK);
+  assert_memory_equal(raw_buffer, "18446744073709551615", 20);
+
+  assert_int_equal(az_span_i64toa(AZ_SPAN_FROM_BUFFER(raw_buffer), INT64_MIN, &out_span), AZ_OK);
+  assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - 20);
+  assert_memory_equal(raw_buffer, "-9223372036854775808", 20);
+
+  assert_int_equal(az_span_i32toa(AZ_SPAN_FROM_BUFFER(raw_buffer), INT32_MIN, &out_span), AZ_OK);
+  assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - 11);
+  assert_memory_equal(raw_buffer, "-2147483648", 11);
+}
+
 #define AZ_SPAN_DTOA_SUCCEEDS_HELPER(v, fractional_digits, expected)                         \
   do                                                                                         \
   {                                                                                          \
@@ -1493,6 +1787,63 @@ static void az_span_dtoa_too_large(void** state)
   assert_int_equal(az_span_dtoa(buff, 1.7e308, 15, &o), AZ_ERROR_NOT_SUPPORTED);
 }
 
+#define AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(v, expected)                          \
+  do                                                                                \
+  {                                                                                 \
+    az_span buffer = AZ_SPAN_FROM_BUFFER(raw_buffer);                               \
+    az_span out_span = AZ_SPAN_EMPTY;                                               \
+    assert_int_equal(az_span_dtoa_shortest(buffer, v, &out_span), AZ_OK);           \
+    az_span output = az_span_slice(buffer, 0, _az_span_diff(out_span, buffer));     \
+    assert_true(az_span_is_content_equal(output, expected));                        \
+    double round_trip = 0;                                                          \
+    assert_int_equal(az_span_atod(output, &round_trip), AZ_OK);                     \
+    assert_memory_equal(&round_trip, &(double){ v }, sizeof(double));               \
+  } while (0)
+
+static void az_span_dtoa_shortest_succeeds(void** state)
+{
+  (void)state;
+
+  // The longest output is [-]0.00000[0-9]{17}, i.e. 1+7+17
+  uint8_t raw_buffer[25] = { 0 };
+
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(0, AZ_SPAN_FROM_STR("0"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(1., AZ_SPAN_FROM_STR("1"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(-1., AZ_SPAN_FROM_STR("-1"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(0.1, AZ_SPAN_FROM_STR("0.1"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(0.3, AZ_SPAN_FROM_STR("0.3"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(0.1 + 0.2, AZ_SPAN_FROM_STR("0.30000000000000004"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(100, AZ_SPAN_FROM_STR("100"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(123.456, AZ_SPAN_FROM_STR("123.456"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(-23.09, AZ_SPAN_FROM_STR("-23.09"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(25.5, AZ_SPAN_FROM_STR("25.5"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(1e20, AZ_SPAN_FROM_STR("100000000000000000000"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(1e21, AZ_SPAN_FROM_STR("1e+21"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(1.5e300, AZ_SPAN_FROM_STR("1.5e+300"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(0.000001, AZ_SPAN_FROM_STR("0.000001"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(1e-7, AZ_SPAN_FROM_STR("1e-7"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(-1.25e-10, AZ_SPAN_FROM_STR("-1.25e-10"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(
+      -0.0000012345678901234567, AZ_SPAN_FROM_STR("-0.0000012345678901234567"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(9007199254740993., AZ_SPAN_FROM_STR("9007199254740992"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(
+      1.7976931348623157e308, AZ_SPAN_FROM_STR("1.7976931348623157e+308"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(
+      2.2250738585072014e-308, AZ_SPAN_FROM_STR("2.2250738585072014e-308"));
+  AZ_SPAN_DTOA_SHORTEST_SUCCEEDS_HELPER(5e-324, AZ_SPAN_FROM_STR("5e-324"));
+
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(raw_buffer);
+  az_span out_span = AZ_SPAN_EMPTY;
+  assert_int_equal(
+      az_span_dtoa_shortest(az_span_slice(buffer, 0, 6), 123.456, &out_span),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // Negative zero is written the same as zero.
+  assert_int_equal(az_span_dtoa_shortest(buffer, -0.0, &out_span), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      az_span_slice(buffer, 0, _az_span_diff(out_span, buffer)), AZ_SPAN_FROM_STR("0")));
+}
+
 static void az_span_copy_empty(void** state)
 {
   (void)state;
@@ -1749,6 +2100,167 @@ static void test_az_span_token_success(void** state)
   assert_true(az_span_size(out_span) == 0);
 }
 
+static void az_span_timestamp_to_iso8601_succeeds(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[AZ_SPAN_ISO8601_TIMESTAMP_SIZE + 1];
+  az_span const destination = AZ_SPAN_FROM_BUFFER(buffer);
+  az_span const timestamp = az_span_slice(destination, 0, AZ_SPAN_ISO8601_TIMESTAMP_SIZE);
+  az_span remainder = AZ_SPAN_EMPTY;
+
+  assert_int_equal(az_span_timestamp_to_iso8601(destination, 0, NULL, &remainder), AZ_OK);
+  assert_true(az_span_is_content_equal(timestamp, AZ_SPAN_FROM_STR("1970-01-01T00:00:00.000Z")));
+  assert_int_equal(az_span_size(remainder), 1);
+
+  // Leap days, the end of a century which isn't a leap year, and the last millisecond supported.
+  assert_int_equal(
+      az_span_timestamp_to_iso8601(destination, 951782400000, NULL, &remainder), AZ_OK);
+  assert_true(az_span_is_content_equal(timestamp, AZ_SPAN_FROM_STR("2000-02-29T00:00:00.000Z")));
+  assert_int_equal(
+      az_span_timestamp_to_iso8601(destination, 4107542399999, NULL, &remainder), AZ_OK);
+  assert_true(az_span_is_content_equal(timestamp, AZ_SPAN_FROM_STR("2100-02-28T23:59:59.999Z")));
+  assert_int_equal(
+      az_span_timestamp_to_iso8601(destination, 4107542400000, NULL, &remainder), AZ_OK);
+  assert_true(az_span_is_content_equal(timestamp, AZ_SPAN_FROM_STR("2100-03-01T00:00:00.000Z")));
+  assert_int_equal(
+      az_span_timestamp_to_iso8601(destination, 253402300799999, NULL, &remainder), AZ_OK);
+  assert_true(az_span_is_content_equal(timestamp, AZ_SPAN_FROM_STR("9999-12-31T23:59:59.999Z")));
+
+  assert_int_equal(
+      az_span_timestamp_to_iso8601(
+          az_span_slice(destination, 0, AZ_SPAN_ISO8601_TIMESTAMP_SIZE - 1), 0, NULL, &remainder),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void az_span_timestamp_to_iso8601_cache_succeeds(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[AZ_SPAN_ISO8601_TIMESTAMP_SIZE];
+  az_span const destination = AZ_SPAN_FROM_BUFFER(buffer);
+  az_span remainder = AZ_SPAN_EMPTY;
+  az_span_timestamp_cache cache;
+  az_span_timestamp_cache_init(&cache);
+
+  // Each time of a day, a second apart and each with its own milliseconds, is written the same
+  // with the cache as without it, across each change of hour and into the next day.
+  uint8_t expected_buffer[AZ_SPAN_ISO8601_TIMESTAMP_SIZE];
+  az_span const expected = AZ_SPAN_FROM_BUFFER(expected_buffer);
+  for (int64_t epoch_msec = 1602633600000; epoch_msec < 1602720000000 + 7200000;
+       epoch_msec += 1007)
+  {
+    assert_int_equal(
+        az_span_timestamp_to_iso8601(destination, epoch_msec, &cache, &remainder), AZ_OK);
+    assert_int_equal(az_span_timestamp_to_iso8601(expected, epoch_msec, NULL, &remainder), AZ_OK);
+    assert_true(az_span_is_content_equal(destination, expected));
+  }
+  assert_true(
+      az_span_is_content_equal(destination, AZ_SPAN_FROM_STR("2020-10-15T01:59:59.643Z")));
+
+  // Going back in time formats the hour again.
+  assert_int_equal(
+      az_span_timestamp_to_iso8601(destination, 1602633600123, &cache, &remainder), AZ_OK);
+  assert_true(
+      az_span_is_content_equal(destination, AZ_SPAN_FROM_STR("2020-10-14T00:00:00.123Z")));
+
+  // A cache which is zero-initialized holds no hour, even the first one.
+  az_span_timestamp_cache zero_cache = { 0 };
+  assert_int_equal(az_span_timestamp_to_iso8601(destination, 5, &zero_cache, &remainder), AZ_OK);
+  assert_true(
+      az_span_is_content_equal(destination, AZ_SPAN_FROM_STR("1970-01-01T00:00:00.005Z")));
+}
+
+static void az_span_arena_allocate_succeeds(void** state)
+{
+  (void)state;
+
+  // The arena starts one byte past an aligned address so that every allocation needs padding.
+  static uint64_t storage[8];
+  az_span_arena arena;
+  az_span_arena_init(&arena, az_span_create((uint8_t*)storage + 1, 63));
+
+  az_span first = AZ_SPAN_EMPTY;
+  assert_int_equal(az_span_arena_allocate(&arena, 10, &first), AZ_OK);
+  assert_int_equal(az_span_size(first), 10);
+  assert_true(az_span_ptr(first) == (uint8_t*)storage + 8);
+  assert_int_equal(az_span_arena_get_used_size(&arena), 17);
+
+  az_span second = AZ_SPAN_EMPTY;
+  assert_int_equal(az_span_arena_allocate(&arena, 33, &second), AZ_OK);
+  assert_true(az_span_ptr(second) == (uint8_t*)storage + 24);
+  assert_int_equal(az_span_arena_get_used_size(&arena), 56);
+
+  // 7 bytes are left, but the padding takes them.
+  az_span third = AZ_SPAN_EMPTY;
+  assert_int_equal(az_span_arena_allocate(&arena, 1, &third), AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(az_span_arena_get_used_size(&arena), 56);
+  assert_int_equal(az_span_arena_allocate(&arena, 0, &third), AZ_OK);
+  assert_int_equal(az_span_size(third), 0);
+
+  az_span_arena_reset(&arena);
+  assert_int_equal(az_span_arena_get_used_size(&arena), 0);
+  assert_int_equal(az_span_arena_allocate(&arena, 56, &first), AZ_OK);
+  assert_true(az_span_ptr(first) == (uint8_t*)storage + 8);
+}
+
+static void az_span_unchecked_copy_and_slice_match_checked(void** state)
+{
+  (void)state;
+
+  uint8_t buffer[8] = { 0 };
+  az_span const destination = AZ_SPAN_FROM_BUFFER(buffer);
+  az_span const source = AZ_SPAN_FROM_STR("abcde");
+
+  az_span remainder = _az_span_copy_unchecked(destination, AZ_SPAN_EMPTY);
+  assert_true(az_span_ptr(remainder) == buffer);
+  assert_int_equal(az_span_size(remainder), 8);
+
+  remainder = _az_span_copy_unchecked(remainder, _az_span_slice_unchecked(source, 1, 4));
+  assert_true(az_span_ptr(remainder) == buffer + 3);
+  assert_int_equal(az_span_size(remainder), 5);
+
+  remainder = _az_span_copy_u8_unchecked(remainder, ':');
+  remainder = _az_span_copy_unchecked(remainder, _az_span_slice_to_end_unchecked(source, 3));
+  assert_int_equal(az_span_size(remainder), 2);
+
+  az_span const written
+      = _az_span_slice_unchecked(destination, 0, _az_span_diff(remainder, destination));
+  assert_true(az_span_is_content_equal(written, AZ_SPAN_FROM_STR("bcd:de")));
+  assert_true(az_span_is_content_equal(written, az_span_slice(destination, 0, 6)));
+}
+
+static void az_span_starts_with_every_size_and_mismatch(void** state)
+{
+  (void)state;
+
+  uint8_t text[] = "$iothub/methods/POST/name/?$rid=1";
+  az_span const span = AZ_SPAN_FROM_BUFFER(text);
+
+  assert_true(_az_span_starts_with(span, AZ_SPAN_EMPTY));
+  assert_true(_az_span_starts_with(AZ_SPAN_EMPTY, AZ_SPAN_EMPTY));
+  assert_false(_az_span_starts_with(AZ_SPAN_FROM_STR("$iothub/"), AZ_SPAN_FROM_STR("$iothub/m")));
+  assert_true(_az_span_starts_with(span, AZ_SPAN_FROM_STR("$iothub/methods/")));
+  assert_false(_az_span_starts_with(span, AZ_SPAN_FROM_STR("$iothub/twin/")));
+
+  // Every prefix size, with a mismatch in each of its bytes, covers the first, overlapping and last
+  // words.
+  uint8_t prefix_buffer[sizeof(text)];
+  for (int32_t size = 1; size <= az_span_size(span); size++)
+  {
+    az_span const prefix = az_span_create(prefix_buffer, size);
+    az_span_copy(prefix, az_span_slice(span, 0, size));
+    assert_true(_az_span_starts_with(span, prefix));
+
+    for (int32_t i = 0; i < size; i++)
+    {
+      prefix_buffer[i] ^= 0x20;
+      assert_false(_az_span_starts_with(span, prefix));
+      prefix_buffer[i] ^= 0x20;
+    }
+  }
+}
+
 int test_az_span()
 {
   const struct CMUnitTest tests[] = {
@@ -1757,6 +2269,7 @@ int test_az_span()
     cmocka_unit_test(az_single_char_ascii_lower_test),
     cmocka_unit_test(az_span_to_lower_test),
     cmocka_unit_test(az_span_to_str_test),
+    cmocka_unit_test(az_span_is_content_equal_ignoring_case_long_test),
     cmocka_unit_test(test_az_span_is_content_equal),
     cmocka_unit_test(az_span_find_beginning_success),
     cmocka_unit_test(az_span_find_middle_success),
@@ -1771,6 +2284,9 @@ int test_az_span()
     cmocka_unit_test(az_span_find_embedded_NULLs_success),
     cmocka_unit_test(az_span_find_capacity_checks_success),
     cmocka_unit_test(az_span_find_overlapping_checks_success),
+    cmocka_unit_test(az_span_find_long_source_success),
+    cmocka_unit_test(az_span_find_kernels_success),
+    cmocka_unit_test(test_az_span_builder),
     cmocka_unit_test(az_span_atox_return_errors),
     cmocka_unit_test(az_span_atou32_test),
     cmocka_unit_test(az_span_atoi32_test),
@@ -1778,6 +2294,7 @@ int test_az_span()
     cmocka_unit_test(az_span_atoi64_test),
     cmocka_unit_test(test_az_isfinite),
     cmocka_unit_test(az_span_atod_test),
+    cmocka_unit_test(az_span_atod_exact_test),
     cmocka_unit_test(az_span_atod_non_finite_not_allowed),
     cmocka_unit_test(az_span_ato_number_whitespace_or_invalid_not_allowed),
     cmocka_unit_test(az_span_ato_number_no_out_of_bounds_reads),
@@ -1795,9 +2312,13 @@ int test_az_span()
     cmocka_unit_test(az_span_u32toa_zero_succeeds),
     cmocka_unit_test(az_span_u32toa_max_uint_succeeds),
     cmocka_unit_test(az_span_u32toa_overflow_fails),
+    cmocka_unit_test(az_span_toa_digit_boundaries_succeeds),
     cmocka_unit_test(az_span_dtoa_succeeds),
     cmocka_unit_test(az_span_dtoa_overflow_fails),
     cmocka_unit_test(az_span_dtoa_too_large),
+    cmocka_unit_test(az_span_dtoa_shortest_succeeds),
+    cmocka_unit_test(az_span_timestamp_to_iso8601_succeeds),
+    cmocka_unit_test(az_span_timestamp_to_iso8601_cache_succeeds),
     cmocka_unit_test(az_span_copy_empty),
     cmocka_unit_test(test_az_span_is_valid),
     cmocka_unit_test(test_az_span_overlap),
@@ -1816,6 +2337,9 @@ int test_az_span()
     cmocka_unit_test(az_span_trim_two_calls),
     cmocka_unit_test(az_span_trim_two_calls_inverse),
     cmocka_unit_test(az_span_trim_repeat_calls),
+    cmocka_unit_test(az_span_arena_allocate_succeeds),
+    cmocka_unit_test(az_span_unchecked_copy_and_slice_match_checked),
+    cmocka_unit_test(az_span_starts_with_every_size_and_mismatch),
   };
   return cmocka_run_group_tests_name("az_core_span", tests, NULL, NULL);
 }
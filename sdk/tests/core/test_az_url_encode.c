@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include "az_simd_private.h"
 #include "az_test_definitions.h"
 #include <azure/core/internal/az_span_internal.h>
 
@@ -475,6 +476,83 @@ static void test_url_encode_full(void** state)
                        "****")));
 }
 
+static void test_url_encode_long_runs(void** state)
+{
+  (void)state;
+
+  // Runs of unreserved bytes longer than a vector block, with each byte value at each position, so
+  // that the bulk copies stop at the right byte.
+  uint8_t source[70];
+  for (int32_t value = 0; value < 256; value++)
+  {
+    for (int32_t position = 0; position < (int32_t)sizeof(source); position++)
+    {
+      for (int32_t i = 0; i < (int32_t)sizeof(source); i++)
+      {
+        source[i] = (uint8_t)"abcXYZ019-_.~"[i % 13];
+      }
+      source[position] = (uint8_t)value;
+
+      bool const encoded = !(('a' <= value && value <= 'z') || ('A' <= value && value <= 'Z')
+                             || ('0' <= value && value <= '9') || value == '-' || value == '_'
+                             || value == '.' || value == '~');
+      int32_t const expected_length = (int32_t)sizeof(source) + (encoded ? 2 : 0);
+      assert_int_equal(
+          _az_span_url_encode_calc_length(AZ_SPAN_FROM_BUFFER(source)), expected_length);
+
+      uint8_t buf[sizeof(source) + 2] = { 0 };
+      int32_t url_length = 0xFF;
+      assert_true(az_result_succeeded(_az_span_url_encode(
+          az_span_create(buf, expected_length), AZ_SPAN_FROM_BUFFER(source), &url_length)));
+      assert_int_equal(url_length, expected_length);
+      assert_memory_equal(buf, source, (size_t)position);
+      if (encoded)
+      {
+        assert_int_equal(buf[position], '%');
+        assert_int_equal(buf[position + 1], "0123456789ABCDEF"[value >> 4]);
+        assert_int_equal(buf[position + 2], "0123456789ABCDEF"[value & 0x0F]);
+        assert_memory_equal(
+            buf + position + 3, source + position + 1, sizeof(source) - (size_t)position - 1);
+
+        // One byte short, the bytes that fit are still written.
+        url_length = 0xFF;
+        assert_true(
+            _az_span_url_encode(
+                az_span_create(buf, expected_length - 1), AZ_SPAN_FROM_BUFFER(source), &url_length)
+            == AZ_ERROR_NOT_ENOUGH_SPACE);
+        assert_int_equal(url_length, 0);
+      }
+      else
+      {
+        assert_memory_equal(buf, source, sizeof(source));
+      }
+    }
+  }
+}
+
+static void test_url_encode_kernels(void** state)
+{
+#ifdef _az_SIMD
+  // Each kernel the host can run, from the narrowest, stops at the bytes the scalar code does.
+  uint32_t const feature_sets[] = {
+    0,
+    _az_SIMD_FEATURE_SSE2 | _az_SIMD_FEATURE_AVX2,
+    _az_SIMD_FEATURE_NEON,
+  };
+
+  for (size_t f = 0; f < sizeof(feature_sets) / sizeof(feature_sets[0]); f++)
+  {
+    _az_simd_select_kernels(feature_sets[f] & _az_simd_get_features());
+    test_url_encode_full(state);
+    test_url_encode_long_runs(state);
+  }
+
+  _az_simd_select_kernels(_az_simd_get_features());
+#else
+  (void)state;
+#endif // _az_SIMD
+}
+
 int test_az_url_encode()
 {
   struct CMUnitTest const tests[] = {
@@ -482,6 +560,8 @@ int test_az_url_encode()
     cmocka_unit_test(test_url_encode_preconditions),
     cmocka_unit_test(test_url_encode_usage),
     cmocka_unit_test(test_url_encode_full),
+    cmocka_unit_test(test_url_encode_long_runs),
+    cmocka_unit_test(test_url_encode_kernels),
   };
 
   return cmocka_run_group_tests_name("az_core_encode", tests, NULL, NULL);
@@ -145,6 +145,26 @@ static void test_az_iot_message_properties_next_NULL_out_value_fail(void** state
   ASSERT_PRECONDITION_CHECKED(az_iot_message_properties_next(&props, &name, NULL));
 }
 
+static void test_az_iot_message_properties_build_index_NULL_index_fail(void** state)
+{
+  (void)state;
+
+  az_iot_message_properties props;
+  assert_int_equal(az_iot_message_properties_init(&props, AZ_SPAN_EMPTY, 0), AZ_OK);
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_message_properties_build_index(&props, NULL, 1));
+}
+
+static void test_az_iot_pending_request_table_init_slot_count_not_power_of_two_fails(void** state)
+{
+  (void)state;
+
+  az_iot_pending_request slots[6];
+  az_iot_pending_request_table table;
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_pending_request_table_init(&table, slots, 6));
+}
+
 #endif // AZ_NO_PRECONDITION_CHECKING
 
 static void test_az_iot_u32toa_size_success()
@@ -272,6 +292,175 @@ static void test_az_iot_calculate_retry_delay_no_logging_succeed()
   az_log_set_classifications(NULL);
 }
 
+static uint32_t _retry_random_callback(void* user_context)
+{
+  return *(uint32_t*)user_context;
+}
+
+static void test_az_iot_retry_full_jitter_succeed()
+{
+  uint32_t random = 0;
+  az_iot_retry_options options = az_iot_retry_options_default();
+  options.min_retry_delay_msec = 1000;
+  options.max_retry_delay_msec = 10000;
+  options.random_callback = _retry_random_callback;
+  options.random_user_context = &random;
+
+  az_iot_retry retry;
+  az_iot_retry_init(&retry, &options);
+
+  // The delay is between the minimum delay and the delay doubled with each attempt.
+  int32_t delay = -1;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+  assert_int_equal(delay, 1000);
+  random = 1000;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_SERVER_ERROR, 0, &delay));
+  assert_int_equal(delay, 2000);
+  random = 3000;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_SERVER_ERROR, 0, &delay));
+  assert_int_equal(delay, 4000);
+  random = 7001;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_SERVER_ERROR, 0, &delay));
+  assert_int_equal(delay, 1000);
+
+  // Up to the maximum delay.
+  random = UINT32_MAX;
+  for (int i = 0; i < 40; i++)
+  {
+    assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+    assert_true(delay >= 1000 && delay <= 10000);
+  }
+  random = 9000;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+  assert_int_equal(delay, 10000);
+
+  // The time the operation took is subtracted.
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 2500, &delay));
+  assert_int_equal(delay, 7500);
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 20000, &delay));
+  assert_int_equal(delay, 0);
+
+  az_iot_retry_reset(&retry);
+  random = 1000;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+  assert_int_equal(delay, 1000);
+}
+
+static void test_az_iot_retry_not_retriable_fail()
+{
+  az_iot_retry retry;
+  az_iot_retry_init(&retry, NULL);
+
+  int32_t delay = -1;
+  assert_false(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNAUTHORIZED, 0, &delay));
+  assert_false(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_NOT_FOUND, 0, &delay));
+  assert_false(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_OK, 0, &delay));
+  assert_int_equal(delay, -1);
+
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_THROTTLED, 0, &delay));
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_SERVER_ERROR, 0, &delay));
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+}
+
+static void test_az_iot_retry_throttled_succeed()
+{
+  az_iot_retry retry;
+  az_iot_retry_init(&retry, NULL);
+
+  // Once throttled, the delays stay above the throttled minimum until the retry is reset.
+  int32_t delay = -1;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+  assert_int_equal(delay, 1000);
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_THROTTLED, 0, &delay));
+  assert_true(delay >= 10000 && delay <= 20000);
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_SERVER_ERROR, 0, &delay));
+  assert_true(delay >= 10000 && delay <= 40000);
+  for (int i = 0; i < 20; i++)
+  {
+    assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+    assert_true(delay >= 10000 && delay <= 100000);
+  }
+
+  az_iot_retry_reset(&retry);
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+  assert_int_equal(delay, 1000);
+
+  // The throttled minimum is capped at the maximum delay.
+  az_iot_retry_options options = az_iot_retry_options_default();
+  options.max_retry_delay_msec = 5000;
+  az_iot_retry_init(&retry, &options);
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_THROTTLED, 0, &delay));
+  assert_int_equal(delay, 5000);
+}
+
+static void test_az_iot_retry_decorrelated_jitter_succeed()
+{
+  az_iot_retry_options options = az_iot_retry_options_default();
+  options.jitter = AZ_IOT_RETRY_JITTER_DECORRELATED;
+  options.random_seed = 42;
+
+  az_iot_retry retry;
+  az_iot_retry_init(&retry, &options);
+
+  // Each delay is between the minimum delay and three times the previous one.
+  int32_t previous = options.min_retry_delay_msec;
+  for (int i = 0; i < 50; i++)
+  {
+    int32_t delay = -1;
+    assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+    int32_t const upper = previous * 3 < options.max_retry_delay_msec
+        ? previous * 3
+        : options.max_retry_delay_msec;
+    assert_true(delay >= options.min_retry_delay_msec && delay <= upper);
+    previous = delay;
+  }
+}
+
+static void test_az_iot_retry_seeds_spread_delays_succeed()
+{
+  // Devices seeded differently don't pick the same delays, while the same seed repeats them.
+  az_iot_retry_options options = az_iot_retry_options_default();
+  az_iot_retry retries[3];
+  options.random_seed = 1;
+  az_iot_retry_init(&retries[0], &options);
+  options.random_seed = 2;
+  az_iot_retry_init(&retries[1], &options);
+  options.random_seed = 1;
+  az_iot_retry_init(&retries[2], &options);
+
+  int32_t differences = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    int32_t delays[3];
+    for (int j = 0; j < 3; j++)
+    {
+      assert_true(az_iot_retry_next_delay(&retries[j], AZ_IOT_STATUS_UNKNOWN, 0, &delays[j]));
+    }
+    assert_int_equal(delays[0], delays[2]);
+    differences += delays[0] != delays[1] ? 1 : 0;
+  }
+  assert_true(differences >= 6);
+}
+
+static void test_az_iot_retry_logging_succeed()
+{
+  az_log_classification const classifications[] = { AZ_LOG_IOT_RETRY, AZ_LOG_END_OF_LIST };
+  az_log_set_classifications(classifications);
+  az_log_set_callback(_log_listener);
+
+  az_iot_retry retry;
+  az_iot_retry_init(&retry, NULL);
+
+  _log_retry = 0;
+  int32_t delay = -1;
+  assert_true(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_UNKNOWN, 0, &delay));
+  assert_false(az_iot_retry_next_delay(&retry, AZ_IOT_STATUS_BAD_REQUEST, 0, &delay));
+  assert_int_equal(_az_BUILT_WITH_LOGGING(1, 0), _log_retry);
+
+  az_log_set_callback(NULL);
+  az_log_set_classifications(NULL);
+}
+
 static void test_az_span_copy_url_encode_succeed()
 {
   az_span url_decoded_span = AZ_SPAN_FROM_STR("abc/=%012");
@@ -378,6 +567,46 @@ static void test_az_iot_message_properties_append_small_buffer_fail(void** state
       az_span_size(props._internal.properties_buffer), sizeof(test_correct_one_key_value) - 2);
 }
 
+static void test_az_iot_message_properties_append_cbor_content_type_succeed(void** state)
+{
+  (void)state;
+
+  uint8_t test_span_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_span = az_span_create(test_span_buf, sizeof(test_span_buf));
+
+  az_iot_message_properties props;
+  assert_int_equal(az_iot_message_properties_init(&props, test_span, 0), AZ_OK);
+  assert_int_equal(az_iot_message_properties_append(&props, test_key_one, test_value_one), AZ_OK);
+  assert_int_equal(az_iot_message_properties_append_cbor_content_type(&props), AZ_OK);
+
+  az_span value;
+  assert_int_equal(
+      az_iot_message_properties_find(
+          &props, AZ_SPAN_FROM_STR(AZ_IOT_MESSAGE_PROPERTIES_CONTENT_TYPE), &value),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("application%2Fcbor")));
+  assert_int_equal(
+      az_iot_message_properties_find(
+          &props, AZ_SPAN_FROM_STR(AZ_IOT_MESSAGE_PROPERTIES_CONTENT_ENCODING), &value),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("utf-8")));
+}
+
+static void test_az_iot_message_properties_append_cbor_content_type_small_buffer_fail(void** state)
+{
+  (void)state;
+
+  // Room for the content type, but not for the content encoding.
+  uint8_t test_span_buf[sizeof("%24.ct=application%2Fcbor&%24.ce=utf") - 1];
+  az_span test_span = az_span_create(test_span_buf, sizeof(test_span_buf));
+
+  az_iot_message_properties props;
+  assert_int_equal(az_iot_message_properties_init(&props, test_span, 0), AZ_OK);
+  assert_int_equal(
+      az_iot_message_properties_append_cbor_content_type(&props), AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(props._internal.properties_written, 0);
+}
+
 static void test_az_iot_message_properties_append_twice_succeed(void** state)
 {
   (void)state;
@@ -687,6 +916,359 @@ static void test_az_iot_message_properties_next_empty_succeed(void** state)
       az_iot_message_properties_next(&props, &name, &value), AZ_ERROR_IOT_END_OF_PROPERTIES);
 }
 
+static void test_az_iot_message_properties_build_index_find_succeed(void** state)
+{
+  (void)state;
+
+  az_span test_span = az_span_create_from_str(TEST_KEY_VALUE_SUBSTRING);
+  az_iot_message_properties props;
+  assert_int_equal(
+      az_iot_message_properties_init(&props, test_span, az_span_size(test_span)), AZ_OK);
+
+  az_iot_message_property index[2];
+  assert_int_equal(az_iot_message_properties_build_index(&props, index, 2), AZ_OK);
+  assert_true(az_span_is_content_equal(index[0].name, test_key_one));
+  assert_true(az_span_is_content_equal(index[1].value, test_value_two));
+
+  az_span out_value;
+  assert_int_equal(az_iot_message_properties_find(&props, test_key, &out_value), AZ_OK);
+  assert_true(az_span_is_content_equal(out_value, test_value_two));
+  assert_int_equal(az_iot_message_properties_find(&props, test_key_one, &out_value), AZ_OK);
+  assert_true(az_span_is_content_equal(out_value, test_value_one));
+  assert_int_equal(
+      az_iot_message_properties_find(&props, test_key_two, &out_value), AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_message_properties_find(&props, test_value_one, &out_value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static void test_az_iot_message_properties_build_index_small_index_fail(void** state)
+{
+  (void)state;
+
+  az_span test_span = az_span_create_from_str(TEST_KEY_VALUE_THREE);
+  az_iot_message_properties props;
+  assert_int_equal(
+      az_iot_message_properties_init(&props, test_span, az_span_size(test_span)), AZ_OK);
+
+  az_iot_message_property index[2];
+  assert_int_equal(
+      az_iot_message_properties_build_index(&props, index, 2), AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // The properties keep working without an index.
+  az_span out_value;
+  assert_int_equal(az_iot_message_properties_find(&props, test_key_three, &out_value), AZ_OK);
+  assert_true(az_span_is_content_equal(out_value, test_value_three));
+}
+
+static void test_az_iot_message_properties_build_index_next_succeed(void** state)
+{
+  (void)state;
+
+  az_span test_span = az_span_create_from_str(TEST_KEY_VALUE_THREE);
+  az_iot_message_properties props;
+  assert_int_equal(
+      az_iot_message_properties_init(&props, test_span, az_span_size(test_span)), AZ_OK);
+
+  az_span name;
+  az_span value;
+  assert_int_equal(az_iot_message_properties_next(&props, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, test_key_one));
+
+  // An iteration in progress carries on from where it was.
+  az_iot_message_property index[4];
+  assert_int_equal(az_iot_message_properties_build_index(&props, index, 4), AZ_OK);
+
+  assert_int_equal(az_iot_message_properties_next(&props, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, test_key_two));
+  assert_true(az_span_is_content_equal(value, test_value_two));
+  assert_int_equal(az_iot_message_properties_next(&props, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, test_key_three));
+  assert_true(az_span_is_content_equal(value, test_value_three));
+  assert_int_equal(
+      az_iot_message_properties_next(&props, &name, &value), AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_EMPTY));
+}
+
+static void test_az_iot_message_properties_build_index_append_succeed(void** state)
+{
+  (void)state;
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_iot_message_properties props;
+  assert_int_equal(
+      az_iot_message_properties_init(&props, AZ_SPAN_FROM_BUFFER(test_buf), 0), AZ_OK);
+
+  az_iot_message_property index[2];
+  assert_int_equal(az_iot_message_properties_build_index(&props, index, 2), AZ_OK);
+
+  assert_int_equal(
+      az_iot_message_properties_append(&props, test_key_one, test_value_one), AZ_OK);
+  assert_int_equal(
+      az_iot_message_properties_append(&props, test_key_two, test_value_two), AZ_OK);
+
+  az_span name;
+  az_span value;
+  assert_int_equal(az_iot_message_properties_next(&props, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, test_key_one));
+  assert_true(az_span_is_content_equal(value, test_value_one));
+
+  // The index is full, so this append drops it and the iteration continues by scanning.
+  assert_int_equal(
+      az_iot_message_properties_append(&props, test_key_three, test_value_three), AZ_OK);
+
+  assert_int_equal(az_iot_message_properties_next(&props, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, test_key_two));
+  assert_true(az_span_is_content_equal(value, test_value_two));
+  assert_int_equal(az_iot_message_properties_next(&props, &name, &value), AZ_OK);
+  assert_true(az_span_is_content_equal(name, test_key_three));
+  assert_true(az_span_is_content_equal(value, test_value_three));
+  assert_int_equal(
+      az_iot_message_properties_next(&props, &name, &value), AZ_ERROR_IOT_END_OF_PROPERTIES);
+
+  az_span out_value;
+  assert_int_equal(az_iot_message_properties_find(&props, test_key_two, &out_value), AZ_OK);
+  assert_true(az_span_is_content_equal(out_value, test_value_two));
+  assert_memory_equal(test_buf, TEST_KEY_VALUE_THREE, sizeof(TEST_KEY_VALUE_THREE) - 1);
+}
+
+static void test_az_iot_pending_request_table_complete_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_pending_request slots[8];
+  az_iot_pending_request_table table;
+  assert_int_equal(az_iot_pending_request_table_init(&table, slots, 8), AZ_OK);
+
+  int contexts[3];
+  uint8_t request_id_buffers[3][AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE];
+  az_span request_ids[3];
+  for (int i = 0; i < 3; i++)
+  {
+    assert_int_equal(
+        az_iot_pending_request_table_add(
+            &table,
+            1000,
+            &contexts[i],
+            AZ_SPAN_FROM_BUFFER(request_id_buffers[i]),
+            &request_ids[i]),
+        AZ_OK);
+  }
+  assert_true(az_span_is_content_equal(request_ids[0], AZ_SPAN_FROM_STR("1")));
+  assert_true(az_span_is_content_equal(request_ids[1], AZ_SPAN_FROM_STR("2")));
+  assert_true(az_span_is_content_equal(request_ids[2], AZ_SPAN_FROM_STR("3")));
+  assert_int_equal(az_iot_pending_request_table_get_count(&table), 3);
+
+  void* context = NULL;
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("2"), &context), AZ_OK);
+  assert_ptr_equal(context, &contexts[1]);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("2"), &context),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // Only the request IDs the table generated are found.
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("01"), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("1a"), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("0"), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_EMPTY, NULL), AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("99999999999"), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  assert_int_equal(az_iot_pending_request_table_complete(&table, request_ids[2], &context), AZ_OK);
+  assert_ptr_equal(context, &contexts[2]);
+  assert_int_equal(az_iot_pending_request_table_complete(&table, request_ids[0], NULL), AZ_OK);
+  assert_int_equal(az_iot_pending_request_table_get_count(&table), 0);
+}
+
+static void test_az_iot_pending_request_table_add_fail(void** state)
+{
+  (void)state;
+
+  az_iot_pending_request slots[4];
+  az_iot_pending_request_table table;
+  assert_int_equal(az_iot_pending_request_table_init(&table, slots, 4), AZ_OK);
+
+  uint8_t request_id_buffer[AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE];
+  az_span request_id = AZ_SPAN_EMPTY;
+  for (int i = 0; i < 3; i++)
+  {
+    assert_int_equal(
+        az_iot_pending_request_table_add(
+            &table, 1000, NULL, AZ_SPAN_FROM_BUFFER(request_id_buffer), &request_id),
+        AZ_OK);
+  }
+
+  // One slot is left empty.
+  assert_int_equal(
+      az_iot_pending_request_table_add(
+          &table, 1000, NULL, AZ_SPAN_FROM_BUFFER(request_id_buffer), &request_id),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(az_iot_pending_request_table_complete(&table, request_id, NULL), AZ_OK);
+
+  // The request isn't added when its ID doesn't fit.
+  uint8_t small_buffer[1];
+  table._internal.last_request_id = 9;
+  assert_int_equal(
+      az_iot_pending_request_table_add(
+          &table, 1000, NULL, AZ_SPAN_FROM_BUFFER(small_buffer), &request_id),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(az_iot_pending_request_table_get_count(&table), 2);
+}
+
+static void test_az_iot_pending_request_table_wrap_around_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_pending_request slots[4];
+  az_iot_pending_request_table table;
+  assert_int_equal(az_iot_pending_request_table_init(&table, slots, 4), AZ_OK);
+
+  uint8_t request_id_buffer[AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE];
+  az_span request_id = AZ_SPAN_EMPTY;
+  assert_int_equal(
+      az_iot_pending_request_table_add(
+          &table, 1000, NULL, AZ_SPAN_FROM_BUFFER(request_id_buffer), &request_id),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(request_id, AZ_SPAN_FROM_STR("1")));
+
+  // 0 is skipped, and so is 1 while it is pending.
+  table._internal.last_request_id = UINT32_MAX - 1;
+  assert_int_equal(
+      az_iot_pending_request_table_add(
+          &table, 1000, NULL, AZ_SPAN_FROM_BUFFER(request_id_buffer), &request_id),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(request_id, AZ_SPAN_FROM_STR("4294967295")));
+  assert_int_equal(
+      az_iot_pending_request_table_add(
+          &table, 1000, NULL, AZ_SPAN_FROM_BUFFER(request_id_buffer), &request_id),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(request_id, AZ_SPAN_FROM_STR("2")));
+
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("4294967295"), NULL), AZ_OK);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("1"), NULL), AZ_OK);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("2"), NULL), AZ_OK);
+}
+
+static void test_az_iot_pending_request_table_expire_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_pending_request slots[8];
+  az_iot_pending_request_table table;
+  assert_int_equal(az_iot_pending_request_table_init(&table, slots, 8), AZ_OK);
+
+  int64_t const expirations[] = { 300, 100, 200, 100 };
+  int contexts[4];
+  uint8_t request_id_buffer[AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE];
+  az_span request_id = AZ_SPAN_EMPTY;
+  for (int i = 0; i < 4; i++)
+  {
+    assert_int_equal(
+        az_iot_pending_request_table_add(
+            &table,
+            expirations[i],
+            &contexts[i],
+            AZ_SPAN_FROM_BUFFER(request_id_buffer),
+            &request_id),
+        AZ_OK);
+  }
+
+  void* context = NULL;
+  assert_int_equal(
+      az_iot_pending_request_table_expire(&table, 99, &context), AZ_ERROR_ITEM_NOT_FOUND);
+
+  void* first = NULL;
+  void* second = NULL;
+  assert_int_equal(az_iot_pending_request_table_expire(&table, 150, &first), AZ_OK);
+  assert_int_equal(az_iot_pending_request_table_expire(&table, 150, &second), AZ_OK);
+  assert_true(
+      (first == &contexts[1] && second == &contexts[3])
+      || (first == &contexts[3] && second == &contexts[1]));
+  assert_int_equal(
+      az_iot_pending_request_table_expire(&table, 150, &context), AZ_ERROR_ITEM_NOT_FOUND);
+
+  // An expired request can't be completed anymore, the others still can.
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("2"), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_pending_request_table_complete(&table, AZ_SPAN_FROM_STR("3"), &context), AZ_OK);
+  assert_ptr_equal(context, &contexts[2]);
+  assert_int_equal(az_iot_pending_request_table_expire(&table, 300, &context), AZ_OK);
+  assert_ptr_equal(context, &contexts[0]);
+  assert_int_equal(az_iot_pending_request_table_get_count(&table), 0);
+}
+
+static void test_az_iot_pending_request_table_collisions_succeed(void** state)
+{
+  (void)state;
+
+  // Requests stay pending for various lengths of time, so that the consecutive IDs collide and
+  // requests are moved back when others are removed.
+  az_iot_pending_request slots[8];
+  az_iot_pending_request_table table;
+  assert_int_equal(az_iot_pending_request_table_init(&table, slots, 8), AZ_OK);
+
+  uint32_t pending[7] = { 0 };
+  int32_t pending_count = 0;
+  uint32_t random = 12345;
+  for (int round = 0; round < 500; round++)
+  {
+    random = random * 1103515245u + 12345u;
+    if (pending_count < 7 && (pending_count == 0 || (random >> 16) % 3 != 0))
+    {
+      uint8_t request_id_buffer[AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE];
+      az_span request_id = AZ_SPAN_EMPTY;
+      assert_int_equal(
+          az_iot_pending_request_table_add(
+              &table, 0, NULL, AZ_SPAN_FROM_BUFFER(request_id_buffer), &request_id),
+          AZ_OK);
+      assert_int_equal(az_span_atou32(request_id, &pending[pending_count]), AZ_OK);
+      pending_count++;
+    }
+    else
+    {
+      int32_t const index = (int32_t)((random >> 8) % (uint32_t)pending_count);
+      uint8_t request_id_buffer[AZ_IOT_PENDING_REQUEST_ID_MAX_SIZE];
+      az_span remainder = AZ_SPAN_EMPTY;
+      assert_int_equal(
+          az_span_u32toa(AZ_SPAN_FROM_BUFFER(request_id_buffer), pending[index], &remainder),
+          AZ_OK);
+      az_span const request_id = az_span_slice(
+          AZ_SPAN_FROM_BUFFER(request_id_buffer),
+          0,
+          (int32_t)sizeof(request_id_buffer) - az_span_size(remainder));
+      assert_int_equal(az_iot_pending_request_table_complete(&table, request_id, NULL), AZ_OK);
+      assert_int_equal(
+          az_iot_pending_request_table_complete(&table, request_id, NULL),
+          AZ_ERROR_ITEM_NOT_FOUND);
+      pending[index] = pending[--pending_count];
+    }
+
+    assert_int_equal(az_iot_pending_request_table_get_count(&table), pending_count);
+  }
+
+  // Every request left is still found.
+  void* context = NULL;
+  while (az_result_succeeded(az_iot_pending_request_table_expire(&table, 0, &context)))
+  {
+    pending_count--;
+  }
+  assert_int_equal(pending_count, 0);
+}
+
 #ifdef _MSC_VER
 // warning C4113: 'void (__cdecl *)()' differs in parameter lists from 'CMUnitTestFunction'
 #pragma warning(disable : 4113)
@@ -710,6 +1292,8 @@ int test_az_iot_common()
     cmocka_unit_test(test_az_iot_message_properties_next_NULL_props_fail),
     cmocka_unit_test(test_az_iot_message_properties_next_NULL_out_name_fail),
     cmocka_unit_test(test_az_iot_message_properties_next_NULL_out_value_fail),
+    cmocka_unit_test(test_az_iot_message_properties_build_index_NULL_index_fail),
+    cmocka_unit_test(test_az_iot_pending_request_table_init_slot_count_not_power_of_two_fails),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_az_iot_u32toa_size_success),
     cmocka_unit_test(test_az_iot_u64toa_size_success),
@@ -719,6 +1303,12 @@ int test_az_iot_common()
     cmocka_unit_test(test_az_iot_calculate_retry_delay_overflow_time_success),
     cmocka_unit_test(test_az_iot_calculate_retry_delay_logging_succeed),
     cmocka_unit_test(test_az_iot_calculate_retry_delay_no_logging_succeed),
+    cmocka_unit_test(test_az_iot_retry_full_jitter_succeed),
+    cmocka_unit_test(test_az_iot_retry_not_retriable_fail),
+    cmocka_unit_test(test_az_iot_retry_throttled_succeed),
+    cmocka_unit_test(test_az_iot_retry_decorrelated_jitter_succeed),
+    cmocka_unit_test(test_az_iot_retry_seeds_spread_delays_succeed),
+    cmocka_unit_test(test_az_iot_retry_logging_succeed),
     cmocka_unit_test(test_az_span_copy_url_encode_succeed),
     cmocka_unit_test(test_az_span_copy_url_encode_insufficient_size_fail),
     cmocka_unit_test(test_az_iot_message_properties_init_succeed),
@@ -726,6 +1316,8 @@ int test_az_iot_common()
     cmocka_unit_test(test_az_iot_message_properties_append_succeed),
     cmocka_unit_test(test_az_iot_message_properties_append_empty_buffer_fail),
     cmocka_unit_test(test_az_iot_message_properties_append_small_buffer_fail),
+    cmocka_unit_test(test_az_iot_message_properties_append_cbor_content_type_succeed),
+    cmocka_unit_test(test_az_iot_message_properties_append_cbor_content_type_small_buffer_fail),
     cmocka_unit_test(test_az_iot_message_properties_append_twice_succeed),
     cmocka_unit_test(test_az_iot_message_properties_append_twice_small_buffer_fail),
     cmocka_unit_test(test_az_iot_message_properties_find_succeed),
@@ -742,6 +1334,15 @@ int test_az_iot_common()
     cmocka_unit_test(test_az_iot_message_properties_next_succeed),
     cmocka_unit_test(test_az_iot_message_properties_next_twice_succeed),
     cmocka_unit_test(test_az_iot_message_properties_next_empty_succeed),
+    cmocka_unit_test(test_az_iot_message_properties_build_index_find_succeed),
+    cmocka_unit_test(test_az_iot_message_properties_build_index_small_index_fail),
+    cmocka_unit_test(test_az_iot_message_properties_build_index_next_succeed),
+    cmocka_unit_test(test_az_iot_message_properties_build_index_append_succeed),
+    cmocka_unit_test(test_az_iot_pending_request_table_complete_succeed),
+    cmocka_unit_test(test_az_iot_pending_request_table_add_fail),
+    cmocka_unit_test(test_az_iot_pending_request_table_wrap_around_succeed),
+    cmocka_unit_test(test_az_iot_pending_request_table_expire_succeed),
+    cmocka_unit_test(test_az_iot_pending_request_table_collisions_succeed),
   };
   return cmocka_run_group_tests_name("az_iot_common", tests, NULL, NULL);
 }
@@ -17,6 +17,7 @@ int main()
 
   result += test_az_iot_hub_client();
   result += test_az_iot_hub_client_c2d();
+  result += test_az_iot_hub_client_gateway();
   result += test_az_iot_hub_client_methods();
   result += test_az_iot_hub_client_sas_token();
   result += test_az_iot_hub_client_telemetry();
@@ -145,6 +145,33 @@ static void test_az_iot_hub_client_get_client_id_NULL_output_span_fails(void** s
   ASSERT_PRECONDITION_CHECKED(az_iot_hub_client_get_client_id(&client, test_buf, 0, &test_length));
 }
 
+static void test_az_iot_hub_client_parse_received_topic_NULL_out_topic_fails(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_client_parse_received_topic(
+      &client, AZ_SPAN_FROM_STR("$iothub/methods/POST/TestMethod/?$rid=1"), NULL));
+}
+
+static void test_az_iot_hub_client_parse_received_message_NULL_out_message_fails(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_client_parse_received_message(
+      &client,
+      AZ_SPAN_FROM_STR("$iothub/methods/POST/TestMethod/?$rid=1"),
+      AZ_SPAN_EMPTY,
+      NULL,
+      NULL,
+      NULL));
+}
+
 #endif // AZ_NO_PRECONDITION_CHECKING
 
 static void test_az_iot_hub_client_get_default_options_succeed(void** state)
@@ -203,6 +230,44 @@ static void test_az_iot_hub_client_init_custom_options_succeed(void** state)
       _az_COUNTOF(TEST_USER_AGENT) - 1);
 }
 
+static void test_az_iot_hub_client_init_shared_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.module_id = AZ_SPAN_FROM_STR(TEST_MODULE_ID);
+  options.user_agent = AZ_SPAN_FROM_STR(TEST_USER_AGENT);
+  az_iot_hub_client_shared shared;
+  az_iot_hub_client_shared_init(&shared, test_hub_hostname, &options);
+
+  az_iot_hub_client clients[2];
+  az_iot_hub_client_init_shared(&clients[0], &shared, test_device_id);
+  az_iot_hub_client_init_shared(&clients[1], &shared, AZ_SPAN_FROM_STR("my_other_device"));
+
+  char mqtt_user_name_buf[TEST_SPAN_BUFFER_SIZE];
+  size_t test_length;
+  assert_int_equal(
+      az_iot_hub_client_get_user_name(
+          &clients[0], mqtt_user_name_buf, sizeof(mqtt_user_name_buf), &test_length),
+      AZ_OK);
+  assert_string_equal(test_correct_user_name_with_module_id, mqtt_user_name_buf);
+
+  assert_int_equal(
+      az_iot_hub_client_get_user_name(
+          &clients[1], mqtt_user_name_buf, sizeof(mqtt_user_name_buf), &test_length),
+      AZ_OK);
+  assert_string_equal(
+      "myiothub.azure-devices.net/my_other_device/my_module_id/?api-version=2018-06-30&os=azrtos",
+      mqtt_user_name_buf);
+
+  char mqtt_client_id_buf[TEST_SPAN_BUFFER_SIZE];
+  assert_int_equal(
+      az_iot_hub_client_get_client_id(
+          &clients[0], mqtt_client_id_buf, sizeof(mqtt_client_id_buf), &test_length),
+      AZ_OK);
+  assert_string_equal(test_correct_client_id_with_module_id, mqtt_client_id_buf);
+}
+
 static void test_az_iot_hub_client_get_user_name_succeed(void** state)
 {
   (void)state;
@@ -222,6 +287,33 @@ static void test_az_iot_hub_client_get_user_name_succeed(void** state)
   assert_int_equal(sizeof(test_correct_user_name) - 1, test_length);
 }
 
+static void test_az_iot_hub_client_get_user_name_measure_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  size_t test_length = 0;
+  assert_int_equal(az_iot_hub_client_get_user_name(&client, NULL, 0, &test_length), AZ_OK);
+  assert_int_equal(sizeof(test_correct_user_name) - 1, test_length);
+
+  assert_int_equal(az_iot_hub_client_get_client_id(&client, NULL, 0, &test_length), AZ_OK);
+  assert_int_equal(sizeof(test_correct_client_id) - 1, test_length);
+
+  // The measured length, plus the null terminator, is exactly what is needed.
+  char mqtt_user_name_buf[sizeof(test_correct_user_name)];
+  assert_int_equal(
+      az_iot_hub_client_get_user_name(
+          &client, mqtt_user_name_buf, sizeof(test_correct_user_name) - 1, &test_length),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_iot_hub_client_get_user_name(
+          &client, mqtt_user_name_buf, sizeof(mqtt_user_name_buf), &test_length),
+      AZ_OK);
+  assert_string_equal(test_correct_user_name, mqtt_user_name_buf);
+}
+
 static void test_az_iot_hub_client_get_user_name_small_buffer_fail(void** state)
 {
   (void)state;
@@ -349,7 +441,7 @@ static void test_az_iot_hub_client_get_user_name_with_model_id_user_options_succ
   (void)state;
 
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.model_id = AZ_SPAN_FROM_STR(TEST_MODEL_ID);
   options.module_id = AZ_SPAN_FROM_STR(TEST_MODULE_ID);
   options.user_agent = AZ_SPAN_FROM_STR(TEST_USER_AGENT);
@@ -463,6 +555,190 @@ static void test_az_iot_hub_client_get_client_id_module_small_buffer_fail(void**
       AZ_ERROR_NOT_ENOUGH_SPACE);
 }
 
+static void test_az_iot_hub_client_parse_received_topic_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  az_iot_hub_client_received_topic topic;
+  az_span value;
+
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client,
+          AZ_SPAN_FROM_STR("devices/my_device/messages/devicebound/abc=123&def=456"),
+          &topic),
+      AZ_OK);
+  assert_int_equal(topic.type, AZ_IOT_HUB_CLIENT_TOPIC_TYPE_C2D_REQUEST);
+  assert_int_equal(
+      az_iot_message_properties_find(
+          &topic.data.c2d_request.properties, AZ_SPAN_FROM_STR("def"), &value),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("456")));
+
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client, AZ_SPAN_FROM_STR("$iothub/methods/POST/TestMethod/?$rid=1"), &topic),
+      AZ_OK);
+  assert_int_equal(topic.type, AZ_IOT_HUB_CLIENT_TOPIC_TYPE_METHOD_REQUEST);
+  assert_true(
+      az_span_is_content_equal(topic.data.method_request.name, AZ_SPAN_FROM_STR("TestMethod")));
+  assert_true(
+      az_span_is_content_equal(topic.data.method_request.request_id, AZ_SPAN_FROM_STR("1")));
+
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client, AZ_SPAN_FROM_STR("$iothub/twin/res/204/?$rid=id_one&$version=16"), &topic),
+      AZ_OK);
+  assert_int_equal(topic.type, AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_RESPONSE);
+  assert_int_equal(
+      topic.data.twin_response.response_type, AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_REPORTED_PROPERTIES);
+  assert_int_equal(topic.data.twin_response.status, AZ_IOT_STATUS_NO_CONTENT);
+  assert_true(
+      az_span_is_content_equal(topic.data.twin_response.request_id, AZ_SPAN_FROM_STR("id_one")));
+  assert_true(az_span_is_content_equal(topic.data.twin_response.version, AZ_SPAN_FROM_STR("16")));
+
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client,
+          AZ_SPAN_FROM_STR("$iothub/twin/PATCH/properties/desired/?$version=id_one"),
+          &topic),
+      AZ_OK);
+  assert_int_equal(topic.type, AZ_IOT_HUB_CLIENT_TOPIC_TYPE_TWIN_DESIRED_PATCH);
+  assert_int_equal(
+      topic.data.twin_response.response_type, AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES);
+  assert_true(
+      az_span_is_content_equal(topic.data.twin_response.version, AZ_SPAN_FROM_STR("id_one")));
+}
+
+static void test_az_iot_hub_client_parse_received_topic_no_match_fail(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  az_iot_hub_client_received_topic topic;
+
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client, AZ_SPAN_FROM_STR("devices/my_device/messages/events/"), &topic),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client, AZ_SPAN_FROM_STR("$iothub/contoso/res/200"), &topic),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(
+          &client, AZ_SPAN_FROM_STR("$iothub/twin/rez/200"), &topic),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+  assert_int_equal(
+      az_iot_hub_client_parse_received_topic(&client, AZ_SPAN_FROM_STR("$iothub/"), &topic),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+}
+
+typedef struct
+{
+  int32_t calls;
+  az_span topic;
+  az_span payload;
+} test_receive_buffer;
+
+static void test_receive_buffer_release(az_span topic, az_span payload, void* user_context)
+{
+  test_receive_buffer* buffer = (test_receive_buffer*)user_context;
+  buffer->calls++;
+  buffer->topic = topic;
+  buffer->payload = payload;
+}
+
+static void test_az_iot_hub_client_parse_received_message_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  // The topic and payload of an MQTT publish, as they sit in the receive buffer.
+  uint8_t receive_buffer[]
+      = "devices/my_device/messages/devicebound/abc=123&def=456{\"command\":\"reboot\"}";
+  az_span const received = az_span_create(receive_buffer, (int32_t)sizeof(receive_buffer) - 1);
+  az_span const received_topic = az_span_slice(received, 0, 54);
+  az_span const received_payload = az_span_slice_to_end(received, 54);
+
+  test_receive_buffer buffer = { 0 };
+  az_iot_hub_client_received_message message;
+  assert_int_equal(
+      az_iot_hub_client_parse_received_message(
+          &client,
+          received_topic,
+          received_payload,
+          test_receive_buffer_release,
+          &buffer,
+          &message),
+      AZ_OK);
+  assert_int_equal(message.topic.type, AZ_IOT_HUB_CLIENT_TOPIC_TYPE_C2D_REQUEST);
+  assert_true(az_span_ptr(message.payload) == az_span_ptr(received_payload));
+  assert_int_equal(az_span_size(message.payload), az_span_size(received_payload));
+
+  // The property value is a view into the receive buffer.
+  az_span value;
+  assert_int_equal(
+      az_iot_message_properties_find(
+          &message.topic.data.c2d_request.properties, AZ_SPAN_FROM_STR("def"), &value),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("456")));
+  assert_true(az_span_ptr(value) == receive_buffer + 51);
+  assert_int_equal(buffer.calls, 0);
+
+  az_iot_hub_client_received_message_release(&message);
+  assert_int_equal(buffer.calls, 1);
+  assert_true(az_span_ptr(buffer.topic) == az_span_ptr(received_topic));
+  assert_int_equal(az_span_size(buffer.topic), az_span_size(received_topic));
+  assert_true(az_span_ptr(buffer.payload) == az_span_ptr(received_payload));
+  assert_int_equal(az_span_size(message.payload), 0);
+
+  az_iot_hub_client_received_message_release(&message);
+  assert_int_equal(buffer.calls, 1);
+}
+
+static void test_az_iot_hub_client_parse_received_message_no_match_fail(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(az_iot_hub_client_init(&client, test_hub_hostname, test_device_id, NULL), AZ_OK);
+
+  test_receive_buffer buffer = { 0 };
+  az_iot_hub_client_received_message message;
+  assert_int_equal(
+      az_iot_hub_client_parse_received_message(
+          &client,
+          AZ_SPAN_FROM_STR("$iothub/contoso/res/200"),
+          AZ_SPAN_FROM_STR("{}"),
+          test_receive_buffer_release,
+          &buffer,
+          &message),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+  assert_int_equal(buffer.calls, 0);
+
+  // A method request without a release callback leaves the buffer to the caller.
+  assert_int_equal(
+      az_iot_hub_client_parse_received_message(
+          &client,
+          AZ_SPAN_FROM_STR("$iothub/methods/POST/TestMethod/?$rid=1"),
+          AZ_SPAN_EMPTY,
+          NULL,
+          NULL,
+          &message),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(
+      message.topic.data.method_request.name, AZ_SPAN_FROM_STR("TestMethod")));
+  az_iot_hub_client_received_message_release(&message);
+}
+
 int test_az_iot_hub_client()
 {
 #ifndef AZ_NO_PRECONDITION_CHECKING
@@ -480,11 +756,15 @@ int test_az_iot_hub_client()
     cmocka_unit_test(test_az_iot_hub_client_get_client_id_NULL_client_fails),
     cmocka_unit_test(test_az_iot_hub_client_get_client_id_NULL_input_span_fails),
     cmocka_unit_test(test_az_iot_hub_client_get_client_id_NULL_output_span_fails),
+    cmocka_unit_test(test_az_iot_hub_client_parse_received_topic_NULL_out_topic_fails),
+    cmocka_unit_test(test_az_iot_hub_client_parse_received_message_NULL_out_message_fails),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_az_iot_hub_client_get_default_options_succeed),
     cmocka_unit_test(test_az_iot_hub_client_init_succeed),
     cmocka_unit_test(test_az_iot_hub_client_init_custom_options_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_init_shared_succeed),
     cmocka_unit_test(test_az_iot_hub_client_get_user_name_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_get_user_name_measure_succeed),
     cmocka_unit_test(test_az_iot_hub_client_get_user_name_small_buffer_fail),
     cmocka_unit_test(test_az_iot_hub_client_get_user_name_user_options_succeed),
     cmocka_unit_test(test_az_iot_hub_client_get_user_name_user_options_small_buffer_fail),
@@ -499,6 +779,10 @@ int test_az_iot_hub_client()
     cmocka_unit_test(test_az_iot_hub_client_get_client_id_small_buffer_fail),
     cmocka_unit_test(test_az_iot_hub_client_get_client_id_module_succeed),
     cmocka_unit_test(test_az_iot_hub_client_get_client_id_module_small_buffer_fail),
+    cmocka_unit_test(test_az_iot_hub_client_parse_received_topic_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_parse_received_topic_no_match_fail),
+    cmocka_unit_test(test_az_iot_hub_client_parse_received_message_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_parse_received_message_no_match_fail),
   };
   return cmocka_run_group_tests_name("az_iot_hub_client", tests, NULL, NULL);
 }
@@ -3,6 +3,7 @@
 
 int test_az_iot_hub_client();
 int test_az_iot_hub_client_c2d();
+int test_az_iot_hub_client_gateway();
 int test_az_iot_hub_client_methods();
 int test_az_iot_hub_client_sas_token();
 int test_az_iot_hub_client_telemetry();
@@ -0,0 +1,279 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "test_az_iot_hub_client.h"
+#include <az_test_precondition.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/iot/az_iot_hub_client.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#define TEST_DEVICE_HOSTNAME_STR "myiothub.azure-devices.net"
+#define TEST_IDENTITY_CAPACITY 8
+#define TEST_BUCKET_COUNT 16
+
+static const az_span test_device_hostname = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_HOSTNAME_STR);
+
+#ifndef AZ_NO_PRECONDITION_CHECKING
+ENABLE_PRECONDITION_CHECK_TESTS()
+
+static void test_az_iot_hub_gateway_init_bucket_count_not_power_of_two_fails()
+{
+  az_iot_hub_gateway gateway;
+  az_iot_hub_gateway_identity identities[TEST_IDENTITY_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_gateway_init(
+      &gateway, test_device_hostname, NULL, identities, TEST_IDENTITY_CAPACITY, buckets, 12));
+}
+
+static void test_az_iot_hub_gateway_init_module_id_option_fails()
+{
+  az_iot_hub_gateway gateway;
+  az_iot_hub_gateway_identity identities[TEST_IDENTITY_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.module_id = AZ_SPAN_FROM_STR("my_module");
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_gateway_init(
+      &gateway,
+      test_device_hostname,
+      &options,
+      identities,
+      TEST_IDENTITY_CAPACITY,
+      buckets,
+      TEST_BUCKET_COUNT));
+}
+
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+static void _test_gateway_init(
+    az_iot_hub_gateway* gateway,
+    az_iot_hub_gateway_identity* identities,
+    int32_t* buckets)
+{
+  assert_int_equal(
+      az_iot_hub_gateway_init(
+          gateway,
+          test_device_hostname,
+          NULL,
+          identities,
+          TEST_IDENTITY_CAPACITY,
+          buckets,
+          TEST_BUCKET_COUNT),
+      AZ_OK);
+}
+
+static void test_az_iot_hub_gateway_add_identity_succeeds()
+{
+  az_iot_hub_gateway gateway;
+  az_iot_hub_gateway_identity identities[TEST_IDENTITY_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+  _test_gateway_init(&gateway, identities, buckets);
+
+  int32_t index = -1;
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_EMPTY, &index),
+      AZ_OK);
+  assert_int_equal(index, 0);
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_FROM_STR("module_a"), &index),
+      AZ_OK);
+  assert_int_equal(index, 1);
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(&gateway, AZ_SPAN_FROM_STR("device_b"), AZ_SPAN_EMPTY, NULL),
+      AZ_OK);
+
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(&gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_EMPTY, NULL),
+      AZ_ERROR_ARG);
+
+  assert_int_equal(
+      az_iot_hub_gateway_find_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_FROM_STR("module_a"), &index),
+      AZ_OK);
+  assert_int_equal(index, 1);
+  assert_int_equal(
+      az_iot_hub_gateway_find_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_b"), AZ_SPAN_EMPTY, &index),
+      AZ_OK);
+  assert_int_equal(index, 2);
+  assert_int_equal(
+      az_iot_hub_gateway_find_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_b"), AZ_SPAN_FROM_STR("module_a"), &index),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static void test_az_iot_hub_gateway_add_identity_full_fails()
+{
+  az_iot_hub_gateway gateway;
+  az_iot_hub_gateway_identity identities[TEST_IDENTITY_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+  _test_gateway_init(&gateway, identities, buckets);
+
+  uint8_t names[] = "abcdefgh";
+  for (int32_t i = 0; i < TEST_IDENTITY_CAPACITY; i++)
+  {
+    assert_int_equal(
+        az_iot_hub_gateway_add_identity(
+            &gateway, az_span_create(&names[i], 1), AZ_SPAN_EMPTY, NULL),
+        AZ_OK);
+  }
+
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(&gateway, AZ_SPAN_FROM_STR("z"), AZ_SPAN_EMPTY, NULL),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_iot_hub_gateway_route_received_topic_succeeds()
+{
+  az_iot_hub_gateway gateway;
+  az_iot_hub_gateway_identity identities[TEST_IDENTITY_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+  _test_gateway_init(&gateway, identities, buckets);
+
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(&gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_EMPTY, NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_FROM_STR("module_a"), NULL),
+      AZ_OK);
+
+  int32_t index = -1;
+  assert_int_equal(
+      az_iot_hub_gateway_route_received_topic(
+          &gateway, AZ_SPAN_FROM_STR("devices/device_a/messages/devicebound/abc=123"), &index),
+      AZ_OK);
+  assert_int_equal(index, 0);
+
+  assert_int_equal(
+      az_iot_hub_gateway_route_received_topic(
+          &gateway,
+          AZ_SPAN_FROM_STR("devices/device_a/modules/module_a/messages/devicebound/"),
+          &index),
+      AZ_OK);
+  assert_int_equal(index, 1);
+
+  assert_int_equal(
+      az_iot_hub_gateway_route_received_topic(
+          &gateway, AZ_SPAN_FROM_STR("devices/device_c/messages/devicebound/"), &index),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_hub_gateway_route_received_topic(
+          &gateway, AZ_SPAN_FROM_STR("$iothub/twin/res/200/?$rid=1"), &index),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+  assert_int_equal(
+      az_iot_hub_gateway_route_received_topic(&gateway, AZ_SPAN_FROM_STR("devices/"), &index),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+  assert_int_equal(
+      az_iot_hub_gateway_route_received_topic(
+          &gateway, AZ_SPAN_FROM_STR("devices/device_a"), &index),
+      AZ_ERROR_IOT_TOPIC_NO_MATCH);
+}
+
+static void test_az_iot_hub_gateway_route_received_topic_many_identities_succeeds()
+{
+  enum
+  {
+    identity_count = 1000,
+    bucket_count = 2048
+  };
+
+  static az_iot_hub_gateway_identity identities[identity_count];
+  static int32_t buckets[bucket_count];
+  static char device_ids[identity_count][16];
+
+  az_iot_hub_gateway gateway;
+  assert_int_equal(
+      az_iot_hub_gateway_init(
+          &gateway, test_device_hostname, NULL, identities, identity_count, buckets, bucket_count),
+      AZ_OK);
+
+  for (int32_t i = 0; i < identity_count; i++)
+  {
+    int const length = snprintf(device_ids[i], sizeof(device_ids[i]), "device_%d", (int)i);
+    assert_int_equal(
+        az_iot_hub_gateway_add_identity(
+            &gateway, az_span_create((uint8_t*)device_ids[i], length), AZ_SPAN_EMPTY, NULL),
+        AZ_OK);
+  }
+
+  for (int32_t i = 0; i < identity_count; i++)
+  {
+    char topic[64];
+    int const length
+        = snprintf(topic, sizeof(topic), "devices/%s/messages/devicebound/", device_ids[i]);
+
+    int32_t index = -1;
+    assert_int_equal(
+        az_iot_hub_gateway_route_received_topic(
+            &gateway, az_span_create((uint8_t*)topic, length), &index),
+        AZ_OK);
+    assert_int_equal(index, i);
+  }
+}
+
+static void test_az_iot_hub_gateway_get_client_succeeds()
+{
+  az_iot_hub_gateway gateway;
+  az_iot_hub_gateway_identity identities[TEST_IDENTITY_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+  _test_gateway_init(&gateway, identities, buckets);
+
+  int32_t index = -1;
+  assert_int_equal(
+      az_iot_hub_gateway_add_identity(
+          &gateway, AZ_SPAN_FROM_STR("device_a"), AZ_SPAN_FROM_STR("module_a"), &index),
+      AZ_OK);
+
+  az_iot_hub_client client;
+  az_iot_hub_gateway_get_client(&gateway, index, &client);
+
+  const char expected_topic[] = "devices/device_a/modules/module_a/messages/events/";
+  char topic[64];
+  size_t length = 0;
+
+  assert_int_equal(
+      az_iot_hub_client_telemetry_get_publish_topic(
+          &client, NULL, topic, sizeof(topic), &length),
+      AZ_OK);
+  assert_int_equal(length, sizeof(expected_topic) - 1);
+  assert_memory_equal(topic, expected_topic, sizeof(expected_topic));
+}
+
+#ifdef _MSC_VER
+// warning C4113: 'void (__cdecl *)()' differs in parameter lists from 'CMUnitTestFunction'
+#pragma warning(disable : 4113)
+#endif
+
+int test_az_iot_hub_client_gateway()
+{
+#ifndef AZ_NO_PRECONDITION_CHECKING
+  SETUP_PRECONDITION_CHECK_TESTS();
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+  const struct CMUnitTest tests[] = {
+#ifndef AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_hub_gateway_init_bucket_count_not_power_of_two_fails),
+    cmocka_unit_test(test_az_iot_hub_gateway_init_module_id_option_fails),
+#endif // AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_hub_gateway_add_identity_succeeds),
+    cmocka_unit_test(test_az_iot_hub_gateway_add_identity_full_fails),
+    cmocka_unit_test(test_az_iot_hub_gateway_route_received_topic_succeeds),
+    cmocka_unit_test(test_az_iot_hub_gateway_route_received_topic_many_identities_succeeds),
+    cmocka_unit_test(test_az_iot_hub_gateway_get_client_succeeds),
+  };
+  return cmocka_run_group_tests_name("az_iot_hub_gateway", tests, NULL, NULL);
+}
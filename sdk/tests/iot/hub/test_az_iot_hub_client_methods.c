@@ -23,6 +23,8 @@
 
 #define TEST_DEVICE_ID_STR "my_device"
 #define TEST_DEVICE_HOSTNAME_STR "myiothub.azure-devices.net"
+#define TEST_COMMAND_CAPACITY 4
+#define TEST_BUCKET_COUNT 8
 
 static const az_span test_device_hostname = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_HOSTNAME_STR);
 static const az_span test_device_id = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_ID_STR);
@@ -151,6 +153,21 @@ static void test_az_iot_hub_client_methods_parse_received_topic_NULL_out_request
       az_iot_hub_client_methods_parse_received_topic(&client, received_topic, NULL));
 }
 
+static void test_az_iot_hub_client_command_table_init_bucket_count_not_power_of_two_fails()
+{
+  az_iot_hub_client_command_table table;
+  az_iot_hub_client_command commands[TEST_COMMAND_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_client_command_table_init(
+      &table,
+      AZ_IOT_HUB_CLIENT_COMMAND_COMPONENT_SEPARATOR,
+      commands,
+      TEST_COMMAND_CAPACITY,
+      buckets,
+      6));
+}
+
 #endif // AZ_NO_PRECONDITION_CHECKING
 
 static void test_az_iot_hub_client_methods_response_get_publish_topic_succeed()
@@ -174,6 +191,29 @@ static void test_az_iot_hub_client_methods_response_get_publish_topic_succeed()
   assert_int_equal(sizeof(expected_topic) - 1, test_length);
 }
 
+static void test_az_iot_hub_client_methods_response_get_publish_topic_measure_succeed()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  az_span request_id = AZ_SPAN_LITERAL_FROM_STR("2");
+  const char expected_topic[] = "$iothub/methods/res/200/?$rid=2";
+
+  size_t test_length = 0;
+  assert_int_equal(
+      az_iot_hub_client_methods_response_get_publish_topic(
+          &client, request_id, 200, NULL, 0, &test_length),
+      AZ_OK);
+  assert_int_equal(sizeof(expected_topic) - 1, test_length);
+
+  char test_buf[sizeof(expected_topic)];
+  assert_int_equal(
+      az_iot_hub_client_methods_response_get_publish_topic(
+          &client, request_id, 200, test_buf, test_length + 1, &test_length),
+      AZ_OK);
+  assert_string_equal(expected_topic, test_buf);
+}
+
 static void test_az_iot_hub_client_methods_response_get_publish_topic_user_status_succeed()
 {
   char test_buf[TEST_SPAN_BUFFER_SIZE];
@@ -364,6 +404,161 @@ static void test_az_iot_hub_client_methods_parse_received_topic_response_topic_f
       == AZ_ERROR_IOT_TOPIC_NO_MATCH);
 }
 
+static void test_az_iot_hub_client_command_table_find_succeed()
+{
+  az_iot_hub_client_command_table table;
+  az_iot_hub_client_command commands[TEST_COMMAND_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+  assert_int_equal(
+      az_iot_hub_client_command_table_init(
+          &table,
+          AZ_IOT_HUB_CLIENT_COMMAND_COMPONENT_SEPARATOR,
+          commands,
+          TEST_COMMAND_CAPACITY,
+          buckets,
+          TEST_BUCKET_COUNT),
+      AZ_OK);
+
+  int32_t reboot_index = -1;
+  int32_t thermostat1_index = -1;
+  int32_t thermostat2_index = -1;
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table, AZ_SPAN_EMPTY, AZ_SPAN_FROM_STR("reboot"), &reboot_index),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table,
+          AZ_SPAN_FROM_STR("thermostat1"),
+          AZ_SPAN_FROM_STR("getMaxMinReport"),
+          &thermostat1_index),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table,
+          AZ_SPAN_FROM_STR("thermostat2"),
+          AZ_SPAN_FROM_STR("getMaxMinReport"),
+          &thermostat2_index),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table, AZ_SPAN_FROM_STR("thermostat1"), AZ_SPAN_FROM_STR("reboot"), NULL),
+      AZ_OK);
+  assert_int_equal(reboot_index, 0);
+  assert_int_equal(thermostat1_index, 1);
+  assert_int_equal(thermostat2_index, 2);
+
+  int32_t index = -1;
+  az_span component_name = AZ_SPAN_EMPTY;
+  az_span command_name = AZ_SPAN_EMPTY;
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table,
+          AZ_SPAN_FROM_STR("thermostat2*getMaxMinReport"),
+          &index,
+          &component_name,
+          &command_name),
+      AZ_OK);
+  assert_int_equal(index, thermostat2_index);
+  assert_true(az_span_is_content_equal(component_name, AZ_SPAN_FROM_STR("thermostat2")));
+  assert_true(az_span_is_content_equal(command_name, AZ_SPAN_FROM_STR("getMaxMinReport")));
+
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("reboot"), &index, &component_name, &command_name),
+      AZ_OK);
+  assert_int_equal(index, reboot_index);
+  assert_int_equal(az_span_size(component_name), 0);
+  assert_true(az_span_is_content_equal(command_name, AZ_SPAN_FROM_STR("reboot")));
+
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("thermostat1*reboot"), &index, NULL, NULL),
+      AZ_OK);
+  assert_int_equal(index, 3);
+}
+
+static void test_az_iot_hub_client_command_table_find_fail()
+{
+  az_iot_hub_client_command_table table;
+  az_iot_hub_client_command commands[TEST_COMMAND_CAPACITY];
+  int32_t buckets[TEST_BUCKET_COUNT];
+  assert_int_equal(
+      az_iot_hub_client_command_table_init(
+          &table,
+          AZ_IOT_HUB_CLIENT_COMMAND_COMPONENT_SEPARATOR,
+          commands,
+          TEST_COMMAND_CAPACITY,
+          buckets,
+          TEST_BUCKET_COUNT),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(&table, AZ_SPAN_EMPTY, AZ_SPAN_FROM_STR("reboot"), NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table, AZ_SPAN_FROM_STR("thermostat1"), AZ_SPAN_FROM_STR("reboot"), NULL),
+      AZ_OK);
+
+  int32_t index = -1;
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("thermostat2*reboot"), &index, NULL, NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("thermostat1*"), &index, NULL, NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("thermostat1"), &index, NULL, NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(&table, AZ_SPAN_FROM_STR("*reboot"), &index, NULL, NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(&table, AZ_SPAN_EMPTY, &index, NULL, NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(index, -1);
+}
+
+static void test_az_iot_hub_client_command_table_add_fail()
+{
+  az_iot_hub_client_command_table table;
+  az_iot_hub_client_command commands[2];
+  int32_t buckets[4];
+  assert_int_equal(
+      az_iot_hub_client_command_table_init(&table, '/', commands, 2, buckets, 4), AZ_OK);
+
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table, AZ_SPAN_FROM_STR("thermostat1"), AZ_SPAN_FROM_STR("getMaxMinReport"), NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table, AZ_SPAN_FROM_STR("thermostat1"), AZ_SPAN_FROM_STR("getMaxMinReport"), NULL),
+      AZ_ERROR_ARG);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(
+          &table, AZ_SPAN_EMPTY, AZ_SPAN_FROM_STR("getMaxMinReport"), NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_command_table_add(&table, AZ_SPAN_EMPTY, AZ_SPAN_FROM_STR("reboot"), NULL),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // The separator is the one the table was initialized with.
+  int32_t index = -1;
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("thermostat1/getMaxMinReport"), &index, NULL, NULL),
+      AZ_OK);
+  assert_int_equal(index, 0);
+  assert_int_equal(
+      az_iot_hub_client_command_table_find(
+          &table, AZ_SPAN_FROM_STR("thermostat1*getMaxMinReport"), &index, NULL, NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
 const az_span _log_expected_topic
     = AZ_SPAN_LITERAL_FROM_STR("$iothub/methods/POST/TestMethod/?$rid=1");
 static int _log_invoked_topic = 0;
@@ -453,8 +648,10 @@ int test_az_iot_hub_client_methods()
     cmocka_unit_test(
         test_az_iot_hub_client_methods_parse_received_topic_AZ_SPAN_EMPTY_received_topic_fail),
     cmocka_unit_test(test_az_iot_hub_client_methods_parse_received_topic_NULL_out_request_fail),
+    cmocka_unit_test(test_az_iot_hub_client_command_table_init_bucket_count_not_power_of_two_fails),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_az_iot_hub_client_methods_response_get_publish_topic_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_methods_response_get_publish_topic_measure_succeed),
     cmocka_unit_test(test_az_iot_hub_client_methods_response_get_publish_topic_user_status_succeed),
     cmocka_unit_test(
         test_az_iot_hub_client_methods_response_get_publish_topic_user_status_small_buf_fail),
@@ -470,6 +667,9 @@ int test_az_iot_hub_client_methods()
     cmocka_unit_test(test_az_iot_hub_client_methods_parse_received_topic_twin_patch_topic_fail),
     cmocka_unit_test(test_az_iot_hub_client_methods_parse_received_topic_topic_filter_fail),
     cmocka_unit_test(test_az_iot_hub_client_methods_parse_received_topic_response_topic_fail),
+    cmocka_unit_test(test_az_iot_hub_client_command_table_find_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_command_table_find_fail),
+    cmocka_unit_test(test_az_iot_hub_client_command_table_add_fail),
     cmocka_unit_test(test_az_iot_hub_client_methods_logging_succeed),
     cmocka_unit_test(test_az_iot_hub_client_methods_no_logging_succeed),
   };
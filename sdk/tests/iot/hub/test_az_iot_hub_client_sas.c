@@ -5,6 +5,7 @@
 #include <az_test_log.h>
 #include <az_test_precondition.h>
 #include <az_test_span.h>
+#include <azure/core/az_crypto.h>
 #include <azure/core/az_log.h>
 #include <azure/core/az_precondition.h>
 #include <azure/core/az_span.h>
@@ -27,12 +28,16 @@
 #define TEST_URL_ENC_SIG "cS1eHM%2FlDjsRsrZV9508wOFrgmZk4g8FNg8NwHVSiSQ"
 #define TEST_EXPIRATION_STR "1578941692"
 #define TEST_KEY_NAME "iothubowner"
+#define TEST_KEY "AQIDBAUGBwgJCgsMDQ4PEBESExQVFhcYGRobHB0eHyA="
+#define TEST_DEVICE_URL_ENC_KEY_SIG "RmqTpZvLpmH8fbhSotiYBBseHuUQ%2FF%2B2HUo6DoZ%2FdDM%3D"
+#define TEST_MODULE_URL_ENC_KEY_SIG "iknF15JHPtujnqXhcMlRofY4BebAfWXk72grA%2F3laGg%3D"
 
 static const az_span test_device_hostname = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_HOSTNAME_STR);
 static const az_span test_device_id = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_ID_STR);
 static const az_span test_module_id = AZ_SPAN_LITERAL_FROM_STR(TEST_MODULE_ID_STR);
 static const uint32_t test_sas_expiry_time_secs = 1578941692;
 static const az_span test_signature = AZ_SPAN_LITERAL_FROM_STR(TEST_SIG);
+static const az_span test_key = AZ_SPAN_LITERAL_FROM_STR(TEST_KEY);
 
 #ifndef AZ_NO_PRECONDITION_CHECKING
 ENABLE_PRECONDITION_CHECK_TESTS()
@@ -121,6 +126,22 @@ static void az_iot_hub_client_sas_get_password_empty_password_buffer_span_fails(
       &client, test_sas_expiry_time_secs, test_signature, key_name, password, 0, &length));
 }
 
+static void az_iot_hub_client_sas_token_cache_init_margin_not_less_than_lifetime_fails()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  az_iot_hub_client_sas_token_cache_options options
+      = az_iot_hub_client_sas_token_cache_options_default();
+  options.refresh_margin_seconds = options.token_lifetime_seconds;
+
+  uint8_t buffer[TEST_SPAN_BUFFER_SIZE * 2];
+  az_iot_hub_client_sas_token_cache cache;
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_client_sas_token_cache_init(
+      &cache, &client, test_key, AZ_SPAN_EMPTY, AZ_SPAN_FROM_BUFFER(buffer), &options));
+}
+
 #endif // AZ_NO_PRECONDITION_CHECKING
 
 static void az_iot_hub_client_sas_get_signature_device_succeeds()
@@ -149,7 +170,7 @@ static void az_iot_hub_client_sas_get_signature_device_succeeds()
 static void az_iot_hub_client_sas_get_signature_module_succeeds()
 {
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.module_id = test_module_id;
   assert_true(
       az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
@@ -200,6 +221,76 @@ static void az_iot_hub_client_sas_get_password_device_succeeds()
   assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
 }
 
+static void az_iot_hub_client_sas_get_password_measure_succeeds()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  const char expected_password[]
+      = "SharedAccessSignature sr=" TEST_DEVICE_HOSTNAME_STR "%2Fdevices%2F" TEST_DEVICE_ID_STR
+        "&sig=" TEST_URL_ENC_SIG "&se=" TEST_EXPIRATION_STR "&skn=" TEST_KEY_NAME;
+
+  size_t length = 0;
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password(
+          &client,
+          test_sas_expiry_time_secs,
+          test_signature,
+          AZ_SPAN_FROM_STR(TEST_KEY_NAME),
+          NULL,
+          0,
+          &length),
+      AZ_OK);
+  assert_int_equal(length, _az_COUNTOF(expected_password) - 1);
+
+  char password[_az_COUNTOF(expected_password)];
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password(
+          &client,
+          test_sas_expiry_time_secs,
+          test_signature,
+          AZ_SPAN_FROM_STR(TEST_KEY_NAME),
+          password,
+          length + 1,
+          &length),
+      AZ_OK);
+  assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
+}
+
+static void az_iot_hub_client_sas_get_password_from_key_measure_succeeds()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  const char expected_password[]
+      = "SharedAccessSignature sr=" TEST_DEVICE_HOSTNAME_STR "%2Fdevices%2F" TEST_DEVICE_ID_STR
+        "&sig=" TEST_DEVICE_URL_ENC_KEY_SIG "&se=" TEST_EXPIRATION_STR;
+
+  // The signature isn't computed, so the length is that of the longest one.
+  size_t length = 0;
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password_from_key(
+          &client, test_sas_expiry_time_secs, test_key, AZ_SPAN_EMPTY, NULL, 0, &length),
+      AZ_OK);
+  assert_true(length >= _az_COUNTOF(expected_password) - 1);
+  assert_true(length <= _az_COUNTOF(expected_password) - 1 + 86);
+
+  char password[TEST_SPAN_BUFFER_SIZE];
+  assert_true(length + 1 <= sizeof(password));
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password_from_key(
+          &client,
+          test_sas_expiry_time_secs,
+          test_key,
+          AZ_SPAN_EMPTY,
+          password,
+          length + 1,
+          &length),
+      AZ_OK);
+  assert_int_equal(length, _az_COUNTOF(expected_password) - 1);
+  assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
+}
+
 static void az_iot_hub_client_sas_get_password_device_no_out_length_succeeds()
 {
   az_iot_hub_client client;
@@ -229,7 +320,7 @@ static void az_iot_hub_client_sas_get_password_device_no_out_length_succeeds()
 static void az_iot_hub_client_sas_get_password_module_succeeds()
 {
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.module_id = test_module_id;
   assert_true(
       az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
@@ -259,7 +350,7 @@ static void az_iot_hub_client_sas_get_password_module_succeeds()
 static void az_iot_hub_client_sas_get_password_module_no_length_succeeds()
 {
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.module_id = test_module_id;
   assert_true(
       az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
@@ -315,7 +406,7 @@ static void az_iot_hub_client_sas_get_password_device_with_keyname_succeeds()
 static void az_iot_hub_client_sas_get_password_module_with_keyname_succeeds()
 {
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.module_id = test_module_id;
   assert_true(
       az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
@@ -368,7 +459,7 @@ static void az_iot_hub_client_sas_get_password_device_overflow_fails()
 static void az_iot_hub_client_sas_get_password_module_overflow_fails()
 {
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.module_id = test_module_id;
   assert_true(
       az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
@@ -407,7 +498,7 @@ static void az_iot_hub_client_sas_get_signature_device_signature_overflow_fails(
 static void az_iot_hub_client_sas_get_signature_module_signature_overflow_fails()
 {
   az_iot_hub_client client;
-  az_iot_hub_client_options options;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
   options.module_id = test_module_id;
   assert_true(
       az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
@@ -421,6 +512,214 @@ static void az_iot_hub_client_sas_get_signature_module_signature_overflow_fails(
       AZ_ERROR_NOT_ENOUGH_SPACE);
 }
 
+static void az_iot_hub_client_sas_get_password_from_key_device_succeeds()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  const char expected_password[]
+      = "SharedAccessSignature sr=" TEST_DEVICE_HOSTNAME_STR "%2Fdevices%2F" TEST_DEVICE_ID_STR
+        "&sig=" TEST_DEVICE_URL_ENC_KEY_SIG "&se=" TEST_EXPIRATION_STR;
+
+  // Exactly large enough for the password, which also stages the signature and the key.
+  char password[_az_COUNTOF(expected_password)];
+  size_t length = 0;
+
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password_from_key(
+          &client,
+          test_sas_expiry_time_secs,
+          test_key,
+          AZ_SPAN_EMPTY,
+          password,
+          _az_COUNTOF(password),
+          &length),
+      AZ_OK);
+
+  assert_int_equal(length, _az_COUNTOF(expected_password) - 1);
+  assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
+}
+
+static void az_iot_hub_client_sas_get_password_from_key_module_with_keyname_succeeds()
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.module_id = test_module_id;
+  assert_true(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options) == AZ_OK);
+
+  const char expected_password[]
+      = "SharedAccessSignature sr=" TEST_DEVICE_HOSTNAME_STR "%2Fdevices%2F" TEST_DEVICE_ID_STR
+        "%2Fmodules%2F" TEST_MODULE_ID_STR "&sig=" TEST_MODULE_URL_ENC_KEY_SIG
+        "&se=" TEST_EXPIRATION_STR "&skn=" TEST_KEY_NAME;
+
+  char password[TEST_SPAN_BUFFER_SIZE];
+  size_t length = 0;
+
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password_from_key(
+          &client,
+          test_sas_expiry_time_secs,
+          test_key,
+          AZ_SPAN_FROM_STR(TEST_KEY_NAME),
+          password,
+          _az_COUNTOF(password),
+          &length),
+      AZ_OK);
+
+  assert_int_equal(length, _az_COUNTOF(expected_password) - 1);
+  assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
+}
+
+static void az_iot_hub_client_sas_get_password_from_key_invalid_key_fails()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  char password[TEST_SPAN_BUFFER_SIZE];
+
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password_from_key(
+          &client,
+          test_sas_expiry_time_secs,
+          AZ_SPAN_FROM_STR("AQIDBAUGBwgJ*gsMDQ4P"),
+          AZ_SPAN_EMPTY,
+          password,
+          _az_COUNTOF(password),
+          NULL),
+      AZ_ERROR_UNEXPECTED_CHAR);
+}
+
+static void az_iot_hub_client_sas_get_password_from_key_device_overflow_fails()
+{
+  az_iot_hub_client client;
+  assert_true(az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  char password[138];
+
+  assert_int_equal(
+      az_iot_hub_client_sas_get_password_from_key(
+          &client,
+          test_sas_expiry_time_secs,
+          test_key,
+          AZ_SPAN_EMPTY,
+          password,
+          _az_COUNTOF(password),
+          NULL),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static int32_t _sign_count = 0;
+
+static az_result _counting_hmac_sha256(az_span key, az_span message, az_span destination)
+{
+  (void)key;
+  (void)message;
+  _sign_count++;
+  az_span_fill(az_span_slice(destination, 0, AZ_CRYPTO_SHA256_SIZE), 0x5a);
+  return AZ_OK;
+}
+
+static void _sas_token_cache_init(
+    az_iot_hub_client* client,
+    az_iot_hub_client_sas_token_cache* cache,
+    az_span buffer)
+{
+  assert_true(az_iot_hub_client_init(client, test_device_hostname, test_device_id, NULL) == AZ_OK);
+
+  az_iot_hub_client_sas_token_cache_options options
+      = az_iot_hub_client_sas_token_cache_options_default();
+  options.token_lifetime_seconds = 3600;
+  options.refresh_margin_seconds = 300;
+
+  assert_int_equal(
+      az_iot_hub_client_sas_token_cache_init(
+          cache, client, test_key, AZ_SPAN_EMPTY, buffer, &options),
+      AZ_OK);
+
+  _sign_count = 0;
+  az_crypto_set_hmac_sha256_callback(_counting_hmac_sha256);
+}
+
+static void az_iot_hub_client_sas_token_cache_get_password_caches_until_margin_succeeds()
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_sas_token_cache cache;
+  uint8_t buffer[TEST_SPAN_BUFFER_SIZE * 2];
+  _sas_token_cache_init(&client, &cache, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_span password;
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 1000, &password), AZ_OK);
+  assert_int_equal(_sign_count, 1);
+  assert_true(az_span_find(password, AZ_SPAN_FROM_STR("&se=4600")) > 0);
+  assert_int_equal(az_span_ptr(password)[az_span_size(password)], '\0');
+
+  az_span cached;
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 4299, &cached), AZ_OK);
+  assert_int_equal(_sign_count, 1);
+  assert_ptr_equal(az_span_ptr(cached), az_span_ptr(password));
+  assert_int_equal(az_span_size(cached), az_span_size(password));
+
+  // Within the refresh margin, and nothing was renewed, so a new token is signed.
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 4300, &password), AZ_OK);
+  assert_int_equal(_sign_count, 2);
+  assert_true(az_span_find(password, AZ_SPAN_FROM_STR("&se=7900")) > 0);
+
+  az_crypto_set_hmac_sha256_callback(NULL);
+}
+
+static void az_iot_hub_client_sas_token_cache_renew_succeeds()
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_sas_token_cache cache;
+  uint8_t buffer[TEST_SPAN_BUFFER_SIZE * 2];
+  _sas_token_cache_init(&client, &cache, AZ_SPAN_FROM_BUFFER(buffer));
+
+  // There is no current token to renew yet.
+  assert_int_equal(az_iot_hub_client_sas_token_cache_renew(&cache), AZ_OK);
+  assert_int_equal(_sign_count, 0);
+
+  az_span password;
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 1000, &password), AZ_OK);
+  assert_int_equal(_sign_count, 1);
+
+  assert_int_equal(az_iot_hub_client_sas_token_cache_renew(&cache), AZ_OK);
+  assert_int_equal(az_iot_hub_client_sas_token_cache_renew(&cache), AZ_OK);
+  assert_int_equal(_sign_count, 2);
+
+  // The renewed token does not replace the current one before the refresh margin.
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 2000, &password), AZ_OK);
+  assert_true(az_span_find(password, AZ_SPAN_FROM_STR("&se=4600")) > 0);
+
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 4300, &password), AZ_OK);
+  assert_int_equal(_sign_count, 2);
+  assert_true(az_span_find(password, AZ_SPAN_FROM_STR("&se=7900")) > 0);
+
+  // A renewed token which went stale is signed again instead.
+  assert_int_equal(az_iot_hub_client_sas_token_cache_renew(&cache), AZ_OK);
+  assert_int_equal(_sign_count, 3);
+  assert_int_equal(az_iot_hub_client_sas_token_cache_get_password(&cache, 20000, &password), AZ_OK);
+  assert_int_equal(_sign_count, 4);
+  assert_true(az_span_find(password, AZ_SPAN_FROM_STR("&se=23600")) > 0);
+
+  az_crypto_set_hmac_sha256_callback(NULL);
+}
+
+static void az_iot_hub_client_sas_token_cache_get_password_small_buffer_fails()
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_sas_token_cache cache;
+  uint8_t buffer[260];
+  _sas_token_cache_init(&client, &cache, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_span password;
+  assert_int_equal(
+      az_iot_hub_client_sas_token_cache_get_password(&cache, 1000, &password),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  az_crypto_set_hmac_sha256_callback(NULL);
+}
+
 static int _log_invoked_sas = 0;
 static void _log_listener(az_log_classification classification, az_span message)
 {
@@ -505,12 +804,16 @@ int test_az_iot_hub_client_sas_token()
     cmocka_unit_test(az_iot_hub_client_sas_get_password_EMPTY_signature_fails),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_NULL_password_span_fails),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_empty_password_buffer_span_fails),
+    cmocka_unit_test(
+        az_iot_hub_client_sas_token_cache_init_margin_not_less_than_lifetime_fails),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(az_iot_hub_client_sas_get_signature_device_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_device_no_out_length_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_signature_module_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_module_no_length_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_device_succeeds),
+    cmocka_unit_test(az_iot_hub_client_sas_get_password_measure_succeeds),
+    cmocka_unit_test(az_iot_hub_client_sas_get_password_from_key_measure_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_module_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_device_with_keyname_succeeds),
     cmocka_unit_test(az_iot_hub_client_sas_get_password_module_with_keyname_succeeds),
@@ -518,6 +821,13 @@ int test_az_iot_hub_client_sas_token()
     cmocka_unit_test(az_iot_hub_client_sas_get_password_module_overflow_fails),
     cmocka_unit_test(az_iot_hub_client_sas_get_signature_device_signature_overflow_fails),
     cmocka_unit_test(az_iot_hub_client_sas_get_signature_module_signature_overflow_fails),
+    cmocka_unit_test(az_iot_hub_client_sas_get_password_from_key_device_succeeds),
+    cmocka_unit_test(az_iot_hub_client_sas_get_password_from_key_module_with_keyname_succeeds),
+    cmocka_unit_test(az_iot_hub_client_sas_get_password_from_key_invalid_key_fails),
+    cmocka_unit_test(az_iot_hub_client_sas_get_password_from_key_device_overflow_fails),
+    cmocka_unit_test(az_iot_hub_client_sas_token_cache_get_password_caches_until_margin_succeeds),
+    cmocka_unit_test(az_iot_hub_client_sas_token_cache_renew_succeeds),
+    cmocka_unit_test(az_iot_hub_client_sas_token_cache_get_password_small_buffer_fails),
     cmocka_unit_test(test_az_iot_hub_client_sas_logging_succeed),
     cmocka_unit_test(test_az_iot_hub_client_sas_no_logging_succeed),
   };
@@ -12,6 +12,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <az_test_precondition.h>
 #include <cmocka.h>
@@ -101,6 +102,27 @@ static void test_az_iot_hub_client_telemetry_get_publish_topic_no_options_no_pro
   assert_int_equal(sizeof(g_test_correct_topic_no_options_no_props) - 1, test_length);
 }
 
+static void test_az_iot_hub_client_telemetry_get_publish_topic_measure_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  size_t test_length = 0;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_get_publish_topic(&client, NULL, NULL, 0, &test_length), AZ_OK);
+  assert_int_equal(sizeof(g_test_correct_topic_no_options_no_props) - 1, test_length);
+
+  char test_buf[sizeof(g_test_correct_topic_no_options_no_props)];
+  assert_int_equal(
+      az_iot_hub_client_telemetry_get_publish_topic(
+          &client, NULL, test_buf, test_length + 1, &test_length),
+      AZ_OK);
+  assert_string_equal(g_test_correct_topic_no_options_no_props, test_buf);
+}
+
 static void test_az_iot_hub_client_telemetry_get_publish_topic_with_options_no_props_succeed(
     void** state)
 {
@@ -318,6 +340,413 @@ test_az_iot_hub_client_telemetry_get_publish_topic_with_options_module_id_with_p
       == AZ_ERROR_NOT_ENOUGH_SPACE);
 }
 
+static void
+test_az_iot_hub_client_telemetry_get_publish_topic_with_cached_prefix_with_props_succeed(
+    void** state)
+{
+  (void)state;
+
+  uint8_t prefix_buffer[AZ_IOT_HUB_CLIENT_TOPIC_PREFIX_BUFFER_SIZE(
+      sizeof("my_device") - 1, sizeof("my_module_id") - 1)];
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.module_id = test_module_id;
+  options.topic_prefix_buffer = AZ_SPAN_FROM_BUFFER(prefix_buffer);
+
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options), AZ_OK);
+
+  az_iot_message_properties props;
+  assert_int_equal(
+      az_iot_message_properties_init(&props, test_props, az_span_size(test_props)), AZ_OK);
+
+  char test_buf[TEST_SPAN_BUFFER_SIZE];
+  size_t test_length;
+
+  assert_int_equal(
+      az_iot_hub_client_telemetry_get_publish_topic(
+          &client, &props, test_buf, sizeof(test_buf), &test_length),
+      AZ_OK);
+  assert_string_equal(g_test_correct_topic_with_options_module_id_with_props, test_buf);
+  assert_int_equal(sizeof(g_test_correct_topic_with_options_module_id_with_props) - 1, test_length);
+
+  assert_int_equal(
+      az_iot_hub_client_telemetry_get_publish_topic(
+          &client, NULL, test_buf, sizeof(test_buf), &test_length),
+      AZ_OK);
+  assert_string_equal(g_test_correct_topic_with_options_no_props, test_buf);
+  assert_int_equal(sizeof(g_test_correct_topic_with_options_no_props) - 1, test_length);
+
+  // The destination must still fit the cached prefix, the properties and the null terminator.
+  assert_int_equal(
+      az_iot_hub_client_telemetry_get_publish_topic(
+          &client,
+          &props,
+          test_buf,
+          sizeof(g_test_correct_topic_with_options_module_id_with_props) - 1,
+          &test_length),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_iot_hub_client_telemetry_init_small_prefix_buffer_fails(void** state)
+{
+  (void)state;
+
+  uint8_t prefix_buffer[sizeof(g_test_correct_topic_no_options_no_props) - 1];
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.topic_prefix_buffer = AZ_SPAN_FROM_BUFFER(prefix_buffer);
+
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_iot_hub_client_telemetry_batch_append_reading_succeed(void** state)
+{
+  (void)state;
+
+  uint8_t payload_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_iot_hub_client_telemetry_batch batch;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_init(&batch, AZ_SPAN_FROM_BUFFER(payload_buffer), NULL),
+      AZ_OK);
+
+  az_span payload;
+  int32_t reading_count = -1;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_get_payload(&batch, &payload, &reading_count), AZ_OK);
+  assert_true(az_span_is_content_equal(payload, AZ_SPAN_FROM_STR("[]")));
+  assert_int_equal(reading_count, 0);
+
+  assert_int_equal(az_iot_hub_client_telemetry_batch_reset(&batch), AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_append_reading(
+          &batch, AZ_SPAN_FROM_STR("{\"temperature\":21.5}"), 1000),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_append_reading(
+          &batch, AZ_SPAN_FROM_STR("{\"temperature\":22}"), 1001),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_append_reading(&batch, AZ_SPAN_FROM_STR("{\"t\":"), 1002),
+      AZ_ERROR_UNEXPECTED_END);
+
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_get_payload(&batch, &payload, &reading_count), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      payload, AZ_SPAN_FROM_STR("[{\"temperature\":21.5},{\"temperature\":22}]")));
+  assert_int_equal(reading_count, 2);
+}
+
+static void test_az_iot_hub_client_telemetry_batch_append_reading_full_buffer_fails(void** state)
+{
+  (void)state;
+
+  // Room for "[" and two readings of 8 bytes with their comma, plus the closing ']'.
+  uint8_t payload_buffer[1 + 8 + 1 + 8 + 1];
+  az_iot_hub_client_telemetry_batch batch;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_init(&batch, AZ_SPAN_FROM_BUFFER(payload_buffer), NULL),
+      AZ_OK);
+
+  az_span const reading = AZ_SPAN_FROM_STR("{\"t\":10}");
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 1), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 1), AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 1),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  az_span payload;
+  assert_int_equal(az_iot_hub_client_telemetry_batch_get_payload(&batch, &payload, NULL), AZ_OK);
+  assert_true(az_span_is_content_equal(payload, AZ_SPAN_FROM_STR("[{\"t\":10},{\"t\":10}]")));
+
+  // After a reset, the reading which did not fit goes into the next batch.
+  assert_int_equal(az_iot_hub_client_telemetry_batch_reset(&batch), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 2), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_batch_get_payload(&batch, &payload, NULL), AZ_OK);
+  assert_true(az_span_is_content_equal(payload, AZ_SPAN_FROM_STR("[{\"t\":10}]")));
+}
+
+static void test_az_iot_hub_client_telemetry_batch_should_flush_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client_telemetry_batch_options options
+      = az_iot_hub_client_telemetry_batch_options_default();
+  options.max_payload_size = 30;
+  options.max_age_seconds = 10;
+
+  uint8_t payload_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_iot_hub_client_telemetry_batch batch;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_init(
+          &batch, AZ_SPAN_FROM_BUFFER(payload_buffer), &options),
+      AZ_OK);
+
+  az_span const reading = AZ_SPAN_FROM_STR("{\"t\":10}");
+  assert_false(az_iot_hub_client_telemetry_batch_should_flush(&batch, 5000));
+
+  // By age.
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 100), AZ_OK);
+  assert_false(az_iot_hub_client_telemetry_batch_should_flush(&batch, 109));
+  assert_true(az_iot_hub_client_telemetry_batch_should_flush(&batch, 110));
+
+  // By size: 3 readings make a payload of 28 bytes, and 4 of 37 bytes.
+  assert_int_equal(az_iot_hub_client_telemetry_batch_reset(&batch), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 200), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 200), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 200), AZ_OK);
+  assert_false(az_iot_hub_client_telemetry_batch_should_flush(&batch, 200));
+  assert_int_equal(az_iot_hub_client_telemetry_batch_append_reading(&batch, reading, 200), AZ_OK);
+  assert_true(az_iot_hub_client_telemetry_batch_should_flush(&batch, 200));
+}
+
+static void test_az_iot_hub_client_telemetry_queue_publish_and_acknowledge_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  az_iot_hub_client_telemetry_queue_options options
+      = az_iot_hub_client_telemetry_queue_options_default();
+  options.max_in_flight = 2;
+  options.max_messages_per_second = 3;
+
+  uint8_t queue_buffer[256];
+  az_iot_hub_client_telemetry_queue queue;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_init(&queue, AZ_SPAN_FROM_BUFFER(queue_buffer), &options),
+      AZ_OK);
+
+  az_iot_hub_client_telemetry_queue_message message;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_get_next(&queue, 100, &message), AZ_ERROR_ITEM_NOT_FOUND);
+
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(
+          &queue, &client, NULL, AZ_SPAN_FROM_STR("{\"t\":1}")),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(
+          &queue, &client, NULL, AZ_SPAN_FROM_STR("{\"t\":2}")),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(
+          &queue, &client, NULL, AZ_SPAN_FROM_STR("{\"t\":3}")),
+      AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_message_count(&queue), 3);
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 100, &message), AZ_OK);
+  assert_string_equal(
+      (char const*)az_span_ptr(message.topic), g_test_correct_topic_no_options_no_props);
+  assert_int_equal(
+      az_span_size(message.topic), (int32_t)sizeof(g_test_correct_topic_no_options_no_props) - 1);
+  assert_true(az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("{\"t\":1}")));
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 7);
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 100, &message), AZ_OK);
+  assert_true(az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("{\"t\":2}")));
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 8);
+
+  // Two messages are in flight, which is the limit.
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_get_next(&queue, 100, &message),
+      AZ_ERROR_IOT_QUEUE_THROTTLED);
+
+  // The second message is acknowledged first, so it waits in the ring for the first one.
+  assert_int_equal(az_iot_hub_client_telemetry_queue_acknowledge(&queue, 8), AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_acknowledge(&queue, 8), AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_message_count(&queue), 2);
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 100, &message), AZ_OK);
+  assert_true(az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("{\"t\":3}")));
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 9);
+
+  // The connection is lost before any other PUBACK.
+  az_iot_hub_client_telemetry_queue_requeue_in_flight(&queue);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_acknowledge(&queue, 7), AZ_ERROR_ITEM_NOT_FOUND);
+
+  // Three messages were published in this second, which is the limit.
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_get_next(&queue, 100, &message),
+      AZ_ERROR_IOT_QUEUE_THROTTLED);
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 101, &message), AZ_OK);
+  assert_true(az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("{\"t\":1}")));
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 10);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 101, &message), AZ_OK);
+  assert_true(az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("{\"t\":3}")));
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 11);
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_acknowledge(&queue, 11), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_acknowledge(&queue, 10), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_message_count(&queue), 0);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_get_next(&queue, 101, &message), AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static void test_az_iot_hub_client_telemetry_queue_full_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  // The 24 bytes of the queue header and 3 records of 56 bytes, each with a 12 byte header, the
+  // 34 byte topic and its null terminator, and an 8 byte payload padded by 1 byte.
+  uint8_t queue_buffer[24 + 3 * 56];
+  az_iot_hub_client_telemetry_queue queue;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_init(&queue, AZ_SPAN_FROM_BUFFER(queue_buffer), NULL),
+      AZ_OK);
+
+  az_span const a = AZ_SPAN_FROM_STR("{\"a\":10}");
+  az_span const b = AZ_SPAN_FROM_STR("{\"b\":10}");
+  az_span const c = AZ_SPAN_FROM_STR("{\"c\":10}");
+  az_span const d = AZ_SPAN_FROM_STR("{\"d\":10}");
+  assert_int_equal(az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, a), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, b), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, c), AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, d),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // Once the first message is acknowledged, the next one wraps around to the start of the ring.
+  az_iot_hub_client_telemetry_queue_message message;
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 1, &message), AZ_OK);
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 1);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_acknowledge(&queue, 1), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, d), AZ_OK);
+
+  // The oldest message is in flight, so it can't be discarded.
+  queue._internal.options.discard_oldest = true;
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 1, &message), AZ_OK);
+  assert_true(az_span_is_content_equal(message.payload, b));
+  az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, 2);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, a),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  az_iot_hub_client_telemetry_queue_requeue_in_flight(&queue);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_enqueue(&queue, &client, NULL, a), AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_message_count(&queue), 3);
+
+  az_span const expected[] = { c, d, a };
+  for (int32_t i = 0; i < 3; i++)
+  {
+    assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 2, &message), AZ_OK);
+    assert_true(az_span_is_content_equal(message.payload, expected[i]));
+    az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, (uint16_t)(i + 3));
+    assert_int_equal(
+        az_iot_hub_client_telemetry_queue_acknowledge(&queue, (uint16_t)(i + 3)), AZ_OK);
+  }
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_message_count(&queue), 0);
+}
+
+typedef struct
+{
+  uint8_t flash[256];
+  int32_t write_count;
+} test_telemetry_queue_storage;
+
+static az_result test_telemetry_queue_persist(void* user_context, int32_t offset, az_span data)
+{
+  test_telemetry_queue_storage* storage = (test_telemetry_queue_storage*)user_context;
+  az_span_copy(az_span_slice_to_end(AZ_SPAN_FROM_BUFFER(storage->flash), offset), data);
+  storage->write_count++;
+  return AZ_OK;
+}
+
+static void test_az_iot_hub_client_telemetry_queue_restore_succeed(void** state)
+{
+  (void)state;
+
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  test_telemetry_queue_storage storage = { 0 };
+  az_iot_hub_client_telemetry_queue_options options
+      = az_iot_hub_client_telemetry_queue_options_default();
+  options.persist = test_telemetry_queue_persist;
+  options.persist_context = &storage;
+
+  uint8_t queue_buffer[sizeof(storage.flash)];
+  az_iot_hub_client_telemetry_queue queue;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_init(&queue, AZ_SPAN_FROM_BUFFER(queue_buffer), &options),
+      AZ_OK);
+
+  uint8_t batch_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_iot_hub_client_telemetry_batch batch;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_init(&batch, AZ_SPAN_FROM_BUFFER(batch_buffer), NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_append_reading(&batch, AZ_SPAN_FROM_STR("{\"t\":1}"), 1),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_batch_append_reading(&batch, AZ_SPAN_FROM_STR("{\"t\":2}"), 1),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue_batch(&queue, &client, NULL, &batch), AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(
+          &queue, &client, NULL, AZ_SPAN_FROM_STR("{\"t\":3}")),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_enqueue(
+          &queue, &client, NULL, AZ_SPAN_FROM_STR("{\"t\":4}")),
+      AZ_OK);
+
+  // The first message is in flight and the second one acknowledged when the device restarts.
+  az_iot_hub_client_telemetry_queue_message message;
+  for (uint16_t packet_id = 1; packet_id <= 2; packet_id++)
+  {
+    assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&queue, 1, &message), AZ_OK);
+    az_iot_hub_client_telemetry_queue_mark_published(&queue, &message, packet_id);
+  }
+  assert_int_equal(az_iot_hub_client_telemetry_queue_acknowledge(&queue, 2), AZ_OK);
+  assert_true(storage.write_count > 0);
+
+  uint8_t restored_buffer[sizeof(storage.flash)];
+  memcpy(restored_buffer, storage.flash, sizeof(restored_buffer));
+  az_iot_hub_client_telemetry_queue restored;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_restore(
+          &restored, AZ_SPAN_FROM_BUFFER(restored_buffer), &options),
+      AZ_OK);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_message_count(&restored), 2);
+
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&restored, 2, &message), AZ_OK);
+  assert_true(
+      az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("[{\"t\":1},{\"t\":2}]")));
+  az_iot_hub_client_telemetry_queue_mark_published(&restored, &message, 1);
+  assert_int_equal(az_iot_hub_client_telemetry_queue_get_next(&restored, 2, &message), AZ_OK);
+  assert_true(az_span_is_content_equal(message.payload, AZ_SPAN_FROM_STR("{\"t\":4}")));
+
+  // A buffer which was never a queue, or whose header is damaged, is not restored.
+  memset(restored_buffer, 0, sizeof(restored_buffer));
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_restore(
+          &restored, AZ_SPAN_FROM_BUFFER(restored_buffer), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  memcpy(restored_buffer, storage.flash, sizeof(restored_buffer));
+  restored_buffer[8] ^= 0x10;
+  assert_int_equal(
+      az_iot_hub_client_telemetry_queue_restore(
+          &restored, AZ_SPAN_FROM_BUFFER(restored_buffer), NULL),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
 int test_az_iot_hub_client_telemetry()
 {
 #ifndef AZ_NO_PRECONDITION_CHECKING
@@ -332,6 +761,7 @@ int test_az_iot_hub_client_telemetry()
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(
         test_az_iot_hub_client_telemetry_get_publish_topic_no_options_no_props_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_get_publish_topic_measure_succeed),
     cmocka_unit_test(
         test_az_iot_hub_client_telemetry_get_publish_topic_with_options_no_props_succeed),
     cmocka_unit_test(
@@ -348,6 +778,15 @@ int test_az_iot_hub_client_telemetry()
         test_az_iot_hub_client_telemetry_get_publish_topic_with_options_module_id_with_props_succeed),
     cmocka_unit_test(
         test_az_iot_hub_client_telemetry_get_publish_topic_with_options_module_id_with_props_small_buffer_fails),
+    cmocka_unit_test(
+        test_az_iot_hub_client_telemetry_get_publish_topic_with_cached_prefix_with_props_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_init_small_prefix_buffer_fails),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_batch_append_reading_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_batch_append_reading_full_buffer_fails),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_batch_should_flush_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_queue_publish_and_acknowledge_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_queue_full_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_telemetry_queue_restore_succeed),
   };
 
   return cmocka_run_group_tests_name("az_iot_hub_client_telemetry", tests, NULL, NULL);
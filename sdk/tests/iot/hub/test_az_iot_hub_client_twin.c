@@ -15,6 +15,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <cmocka.h>
 
@@ -181,6 +182,25 @@ static void test_az_iot_hub_client_twin_parse_received_topic_NULL_response_fails
       &client, test_twin_received_topic_desired_success, NULL));
 }
 
+static void test_az_iot_hub_client_twin_reported_batch_get_patch_in_flight_fails()
+{
+  az_iot_hub_client_twin_reported_property properties[2];
+  uint8_t value_buffer[8];
+  az_iot_hub_client_twin_reported_batch batch;
+  az_iot_hub_client_twin_reported_batch_init(
+      &batch, properties, 2, AZ_SPAN_FROM_BUFFER(value_buffer), NULL);
+
+  uint8_t patch_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span patch;
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_hub_client_twin_reported_batch_get_patch(
+      &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch));
+}
+
 #endif // AZ_NO_PRECONDITION_CHECKING
 
 static void test_az_iot_hub_client_twin_document_get_publish_topic_succeed()
@@ -232,6 +252,33 @@ static void test_az_iot_hub_client_twin_patch_get_publish_topic_succeed()
   assert_int_equal(sizeof(test_correct_twin_patch_pub_topic) - 1, test_length);
 }
 
+static void test_az_iot_hub_client_twin_get_publish_topic_measure_succeed()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  size_t test_length = 0;
+  assert_int_equal(
+      az_iot_hub_client_twin_document_get_publish_topic(
+          &client, test_device_request_id, NULL, 0, &test_length),
+      AZ_OK);
+  assert_int_equal(sizeof(test_correct_twin_get_request_topic) - 1, test_length);
+
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_publish_topic(
+          &client, test_device_request_id, NULL, 0, &test_length),
+      AZ_OK);
+  assert_int_equal(sizeof(test_correct_twin_patch_pub_topic) - 1, test_length);
+
+  char test_buf[sizeof(test_correct_twin_patch_pub_topic)];
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_publish_topic(
+          &client, test_device_request_id, test_buf, test_length + 1, &test_length),
+      AZ_OK);
+  assert_string_equal(test_correct_twin_patch_pub_topic, test_buf);
+}
+
 static void test_az_iot_hub_client_twin_patch_get_publish_topic_small_buffer_fails()
 {
   az_iot_hub_client client;
@@ -402,6 +449,596 @@ static void test_az_iot_hub_client_twin_no_logging_succeed()
   az_log_set_classifications(NULL);
 }
 
+// Writes "path=value;" for every changed desired property into the buffer.
+static az_result _test_twin_desired_changes(
+    az_iot_hub_client_twin_desired_tracker* tracker,
+    az_iot_hub_client_twin_response_type response_type,
+    az_span json,
+    az_span path_buffer,
+    az_span changes_buffer,
+    az_span* out_changes)
+{
+  az_iot_hub_client_twin_desired_changes changes;
+  az_result result = az_iot_hub_client_twin_desired_changes_init(
+      &changes, tracker, response_type, json, path_buffer);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  az_span remainder = changes_buffer;
+  az_span path;
+  az_json_token value;
+  while (az_result_succeeded(
+      result = az_iot_hub_client_twin_desired_changes_next(&changes, &path, &value)))
+  {
+    remainder = az_span_copy(remainder, path);
+    remainder = az_span_copy_u8(remainder, '=');
+    remainder = az_span_copy(remainder, value.slice);
+    remainder = az_span_copy_u8(remainder, ';');
+  }
+
+  *out_changes
+      = az_span_slice(changes_buffer, 0, az_span_size(changes_buffer) - az_span_size(remainder));
+  return result;
+}
+
+static void test_az_iot_hub_client_twin_desired_changes_succeed()
+{
+  az_iot_hub_client_twin_desired_record records[16];
+  az_iot_hub_client_twin_desired_tracker tracker;
+  az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 16);
+
+  uint8_t path_buffer[32];
+  uint8_t changes_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span changes;
+
+  az_span const document = AZ_SPAN_FROM_STR(
+      "{\"desired\":{\"a\":1,\"t\":{\"x\":true,\"y\":\"s\"},\"arr\":[1,{\"b\":2}],"
+      "\"$metadata\":{\"$lastUpdated\":\"2020-01-01\"},\"$version\":5},"
+      "\"reported\":{\"z\":1,\"$version\":2}}");
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET,
+          document,
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(
+      az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("a=1;t.x=true;t.y=s;arr=[1,{\"b\":2}];")));
+
+  // The same document, received again on reconnect, has no change.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET,
+          document,
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_int_equal(az_span_size(changes), 0);
+
+  // Only the properties of a patch which changed are returned.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          AZ_SPAN_FROM_STR("{\"a\":1,\"t\":{\"x\":false,\"y\":\"s\"},\"$version\":6}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("t.x=false;")));
+
+  // A stale patch is ignored.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          AZ_SPAN_FROM_STR("{\"a\":2,\"$version\":6}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_int_equal(az_span_size(changes), 0);
+
+  // Once an object is removed, its properties are returned again when it is set.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          AZ_SPAN_FROM_STR("{\"t\":null,\"$version\":7}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("t=null;")));
+
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          AZ_SPAN_FROM_STR("{\"t\":{\"x\":false},\"$version\":8}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("t.x=false;")));
+}
+
+static void test_az_iot_hub_client_twin_desired_changes_tracker_full_succeed()
+{
+  // Three of the four records can be used.
+  az_iot_hub_client_twin_desired_record records[4];
+  az_iot_hub_client_twin_desired_tracker tracker;
+  az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 4);
+
+  uint8_t path_buffer[32];
+  uint8_t changes_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span changes;
+
+  az_span const patch = AZ_SPAN_FROM_STR("{\"a\":1,\"b\":2,\"c\":3,\"d\":4}");
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          patch,
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("a=1;b=2;c=3;d=4;")));
+
+  // The property which could not be recorded is returned again.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          patch,
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("d=4;")));
+}
+
+static void test_az_iot_hub_client_twin_desired_changes_small_path_buffer_fails()
+{
+  az_iot_hub_client_twin_desired_record records[16];
+  az_iot_hub_client_twin_desired_tracker tracker;
+  az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 16);
+
+  uint8_t path_buffer[8];
+  uint8_t changes_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span changes;
+
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          AZ_SPAN_FROM_STR("{\"a\":1,\"thermostat\":{\"target\":20},\"$version\":2}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("a=1;")));
+
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET,
+          AZ_SPAN_FROM_STR("{\"reported\":{}}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static void test_az_iot_hub_client_twin_reported_batch_succeed()
+{
+  az_iot_hub_client_twin_reported_property properties[4];
+  uint8_t value_buffer[64];
+  az_iot_hub_client_twin_reported_batch batch;
+  az_iot_hub_client_twin_reported_batch_init(
+      &batch, properties, 4, AZ_SPAN_FROM_BUFFER(value_buffer), NULL);
+
+  uint8_t patch_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span patch;
+
+  // Updates in a burst are merged, and the last value of a property wins.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("1"), 100),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("{\"x\":\"y\"}"), 100),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("2"), 101),
+      AZ_OK);
+
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(patch, AZ_SPAN_FROM_STR("{\"a\":2,\"b\":{\"x\":\"y\"}}")));
+
+  // While the patch is in flight, its values are not set again.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("2"), 102),
+      AZ_OK);
+  assert_false(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 1000));
+  az_iot_hub_client_twin_reported_batch_acknowledge(&batch, AZ_IOT_STATUS_NO_CONTENT);
+
+  // Writes equal to the acknowledged value are dropped, even after another value was set.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("{\"x\":\"y\"}"), 103),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("3"), 103),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("2"), 103),
+      AZ_OK);
+  assert_false(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 1000));
+
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(patch, AZ_SPAN_FROM_STR("{}")));
+  az_iot_hub_client_twin_reported_batch_acknowledge(&batch, AZ_IOT_STATUS_NO_CONTENT);
+
+  // Once a patch is rejected, its values are sent again.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("4"), 104),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(patch, AZ_SPAN_FROM_STR("{\"a\":4}")));
+  az_iot_hub_client_twin_reported_batch_acknowledge(&batch, AZ_IOT_STATUS_TIMEOUT);
+
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("4"), 105),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(patch, AZ_SPAN_FROM_STR("{\"a\":4}")));
+}
+
+static void test_az_iot_hub_client_twin_reported_batch_should_flush_succeed()
+{
+  az_iot_hub_client_twin_reported_property properties[4];
+  uint8_t value_buffer[64];
+  az_iot_hub_client_twin_reported_batch batch;
+
+  az_iot_hub_client_twin_reported_batch_options options
+      = az_iot_hub_client_twin_reported_batch_options_default();
+  options.max_patch_size = 16;
+  options.max_delay_seconds = 5;
+  az_iot_hub_client_twin_reported_batch_init(
+      &batch, properties, 4, AZ_SPAN_FROM_BUFFER(value_buffer), &options);
+
+  assert_false(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 1000));
+
+  // "a":1, is 6 bytes long.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("1"), 100),
+      AZ_OK);
+  assert_false(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 104));
+  assert_true(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 105));
+
+  // "b":12345, is 10 bytes long, which reaches the patch size.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("1234"), 101),
+      AZ_OK);
+  assert_false(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 101));
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("12345"), 101),
+      AZ_OK);
+  assert_true(az_iot_hub_client_twin_reported_batch_should_flush(&batch, 101));
+}
+
+static void test_az_iot_hub_client_twin_reported_batch_fails()
+{
+  az_iot_hub_client_twin_reported_property properties[2];
+  uint8_t value_buffer[8];
+  az_iot_hub_client_twin_reported_batch batch;
+  az_iot_hub_client_twin_reported_batch_init(
+      &batch, properties, 2, AZ_SPAN_FROM_BUFFER(value_buffer), NULL);
+
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("{\"x\":"), 100),
+      AZ_ERROR_UNEXPECTED_END);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("1 2"), 100),
+      AZ_ERROR_UNEXPECTED_CHAR);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("\"abcdefghij\""), 100),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("true"), 100),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("null"), 100),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("c"), AZ_SPAN_FROM_STR("1"), 100),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // The batch is unchanged when the patch does not fit.
+  uint8_t patch_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span patch;
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, az_span_create(patch_buffer, 18), &patch),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(patch, AZ_SPAN_FROM_STR("{\"a\":true,\"b\":null}")));
+}
+
+typedef struct
+{
+  uint8_t image[256];
+  int32_t image_size;
+  int32_t store_count;
+} _test_twin_cache_store;
+
+static az_result _test_twin_cache_store_image(void* user_context, az_span image)
+{
+  _test_twin_cache_store* const store = (_test_twin_cache_store*)user_context;
+  assert_true(az_span_size(image) <= (int32_t)sizeof(store->image));
+  memcpy(store->image, az_span_ptr(image), (size_t)az_span_size(image));
+  store->image_size = az_span_size(image);
+  store->store_count++;
+  return AZ_OK;
+}
+
+static void test_az_iot_hub_client_twin_cache_succeed()
+{
+  _test_twin_cache_store store = { 0 };
+  uint8_t path_buffer[32];
+  uint8_t changes_buffer[TEST_SPAN_BUFFER_SIZE];
+  uint8_t patch_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span changes;
+  az_span patch;
+
+  az_span const document = AZ_SPAN_FROM_STR(
+      "{\"desired\":{\"a\":1,\"t\":{\"x\":true},\"$version\":5},\"reported\":{\"$version\":2}}");
+
+  {
+    az_iot_hub_client_twin_desired_record records[16];
+    az_iot_hub_client_twin_desired_tracker tracker;
+    az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 16);
+    az_iot_hub_client_twin_reported_property properties[4];
+    uint8_t value_buffer[64];
+    az_iot_hub_client_twin_reported_batch batch;
+    az_iot_hub_client_twin_reported_batch_init(
+        &batch, properties, 4, AZ_SPAN_FROM_BUFFER(value_buffer), NULL);
+
+    uint8_t cache_buffer[256];
+    az_iot_hub_client_twin_cache cache;
+    az_iot_hub_client_twin_cache_init(
+        &cache,
+        &tracker,
+        &batch,
+        AZ_SPAN_FROM_BUFFER(cache_buffer),
+        _test_twin_cache_store_image,
+        &store);
+    assert_int_equal(az_iot_hub_client_twin_cache_get_desired_version(&cache), -1);
+
+    assert_int_equal(
+        _test_twin_desired_changes(
+            &tracker,
+            AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET,
+            document,
+            AZ_SPAN_FROM_BUFFER(path_buffer),
+            AZ_SPAN_FROM_BUFFER(changes_buffer),
+            &changes),
+        AZ_ERROR_IOT_END_OF_PROPERTIES);
+    assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("a=1;t.x=true;")));
+
+    assert_int_equal(
+        az_iot_hub_client_twin_reported_batch_set(
+            &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("1"), 100),
+        AZ_OK);
+    assert_int_equal(
+        az_iot_hub_client_twin_reported_batch_set(
+            &batch, AZ_SPAN_FROM_STR("sn"), AZ_SPAN_FROM_STR("\"1234\""), 100),
+        AZ_OK);
+    assert_int_equal(
+        az_iot_hub_client_twin_reported_batch_get_patch(
+            &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+        AZ_OK);
+    az_iot_hub_client_twin_reported_batch_acknowledge(&batch, AZ_IOT_STATUS_NO_CONTENT);
+
+    // A value which is pending is not cached.
+    assert_int_equal(
+        az_iot_hub_client_twin_reported_batch_set(
+            &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("true"), 101),
+        AZ_OK);
+
+    assert_int_equal(az_iot_hub_client_twin_cache_save(&cache), AZ_OK);
+    assert_int_equal(store.store_count, 1);
+    assert_int_equal(az_iot_hub_client_twin_cache_get_desired_version(&cache), 5);
+
+    // The store is only written when the state changed.
+    assert_int_equal(az_iot_hub_client_twin_cache_save(&cache), AZ_OK);
+    assert_int_equal(store.store_count, 1);
+  }
+
+  // After a restart, the state is restored from the store.
+  uint8_t image[256];
+  memcpy(image, store.image, (size_t)store.image_size);
+
+  az_iot_hub_client_twin_desired_record records[16];
+  az_iot_hub_client_twin_desired_tracker tracker;
+  az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 16);
+  az_iot_hub_client_twin_reported_property properties[4];
+  uint8_t value_buffer[64];
+  az_iot_hub_client_twin_reported_batch batch;
+  az_iot_hub_client_twin_reported_batch_init(
+      &batch, properties, 4, AZ_SPAN_FROM_BUFFER(value_buffer), NULL);
+
+  uint8_t cache_buffer[256];
+  az_iot_hub_client_twin_cache cache;
+  az_iot_hub_client_twin_cache_init(
+      &cache,
+      &tracker,
+      &batch,
+      AZ_SPAN_FROM_BUFFER(cache_buffer),
+      _test_twin_cache_store_image,
+      &store);
+  assert_int_equal(
+      az_iot_hub_client_twin_cache_restore(&cache, az_span_create(image, store.image_size)),
+      AZ_OK);
+  assert_int_equal(az_iot_hub_client_twin_cache_get_desired_version(&cache), 5);
+
+  // The twin document received on reconnecting has no change, and neither does the state.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET,
+          document,
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_int_equal(az_span_size(changes), 0);
+  assert_int_equal(az_iot_hub_client_twin_cache_save(&cache), AZ_OK);
+  assert_int_equal(store.store_count, 1);
+
+  // A newer document only reports the properties which changed.
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_GET,
+          AZ_SPAN_FROM_STR("{\"desired\":{\"a\":1,\"t\":{\"x\":false},\"$version\":6}}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_true(az_span_is_content_equal(changes, AZ_SPAN_FROM_STR("t.x=false;")));
+
+  // The acknowledged reported values are not sent again, but the pending one is.
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("a"), AZ_SPAN_FROM_STR("1"), 200),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("sn"), AZ_SPAN_FROM_STR("\"1234\""), 200),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_set(
+          &batch, AZ_SPAN_FROM_STR("b"), AZ_SPAN_FROM_STR("true"), 200),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_twin_reported_batch_get_patch(
+          &batch, AZ_SPAN_FROM_BUFFER(patch_buffer), &patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(patch, AZ_SPAN_FROM_STR("{\"b\":true}")));
+
+  assert_int_equal(az_iot_hub_client_twin_cache_save(&cache), AZ_OK);
+  assert_int_equal(store.store_count, 2);
+  assert_int_equal(az_iot_hub_client_twin_cache_get_desired_version(&cache), 6);
+}
+
+static void test_az_iot_hub_client_twin_cache_restore_fails()
+{
+  _test_twin_cache_store store = { 0 };
+  az_iot_hub_client_twin_desired_record records[4];
+  az_iot_hub_client_twin_desired_tracker tracker;
+  az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 4);
+  uint8_t cache_buffer[256];
+  az_iot_hub_client_twin_cache cache;
+  az_iot_hub_client_twin_cache_init(
+      &cache,
+      &tracker,
+      NULL,
+      AZ_SPAN_FROM_BUFFER(cache_buffer),
+      _test_twin_cache_store_image,
+      &store);
+
+  uint8_t path_buffer[32];
+  uint8_t changes_buffer[TEST_SPAN_BUFFER_SIZE];
+  az_span changes;
+  assert_int_equal(
+      _test_twin_desired_changes(
+          &tracker,
+          AZ_IOT_CLIENT_TWIN_RESPONSE_TYPE_DESIRED_PROPERTIES,
+          AZ_SPAN_FROM_STR("{\"a\":1,\"b\":2,\"$version\":3}"),
+          AZ_SPAN_FROM_BUFFER(path_buffer),
+          AZ_SPAN_FROM_BUFFER(changes_buffer),
+          &changes),
+      AZ_ERROR_IOT_END_OF_PROPERTIES);
+  assert_int_equal(az_iot_hub_client_twin_cache_save(&cache), AZ_OK);
+
+  uint8_t image[256];
+  memcpy(image, store.image, (size_t)store.image_size);
+  az_iot_hub_client_twin_desired_tracker_init(&tracker, records, 4);
+
+  // Nothing was stored yet, the write of the image was interrupted, or a byte of it changed.
+  assert_int_equal(
+      az_iot_hub_client_twin_cache_restore(&cache, az_span_create(image, 0)),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_iot_hub_client_twin_cache_restore(&cache, az_span_create(image, store.image_size - 1)),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  image[store.image_size - 1] ^= 1;
+  assert_int_equal(
+      az_iot_hub_client_twin_cache_restore(&cache, az_span_create(image, store.image_size)),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  image[store.image_size - 1] ^= 1;
+
+  // The tracker is left empty, and the image can then be restored.
+  assert_int_equal(az_iot_hub_client_twin_cache_get_desired_version(&cache), -1);
+  assert_int_equal(
+      az_iot_hub_client_twin_cache_restore(&cache, az_span_create(image, store.image_size)),
+      AZ_OK);
+  assert_int_equal(az_iot_hub_client_twin_cache_get_desired_version(&cache), 3);
+
+  // A buffer too small for the image.
+  uint8_t small_buffer[sizeof(cache_buffer)];
+  az_iot_hub_client_twin_cache small_cache;
+  az_iot_hub_client_twin_cache_init(
+      &small_cache,
+      &tracker,
+      NULL,
+      az_span_create(small_buffer, store.image_size - 1),
+      _test_twin_cache_store_image,
+      &store);
+  assert_int_equal(az_iot_hub_client_twin_cache_save(&small_cache), AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
 #ifdef _MSC_VER
 // warning C4113: 'void (__cdecl *)()' differs in parameter lists from 'CMUnitTestFunction'
 #pragma warning(disable : 4113)
@@ -426,10 +1063,12 @@ int test_az_iot_hub_client_twin()
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_NULL_client_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_NULL_rec_topic_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_NULL_response_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_reported_batch_get_patch_in_flight_fails),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_az_iot_hub_client_twin_document_get_publish_topic_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_document_get_publish_topic_small_buffer_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_publish_topic_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_get_publish_topic_measure_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_publish_topic_small_buffer_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_desired_found_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_get_response_found_succeed),
@@ -439,6 +1078,14 @@ int test_az_iot_hub_client_twin()
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_not_found_prefix_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_logging_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_no_logging_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_desired_changes_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_desired_changes_tracker_full_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_desired_changes_small_path_buffer_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_reported_batch_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_reported_batch_should_flush_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_reported_batch_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_cache_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_cache_restore_fails),
   };
 
   return cmocka_run_group_tests_name("az_iot_hub_client_twin", tests, NULL, NULL);
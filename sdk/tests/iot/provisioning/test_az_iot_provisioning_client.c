@@ -174,6 +174,46 @@ static void test_az_iot_provisioning_client_get_register_publish_topic_succeed()
   assert_int_equal(strlen(expected_topic), topic_len);
 }
 
+static void test_az_iot_provisioning_client_get_publish_topic_measure_succeed()
+{
+  az_iot_provisioning_client client;
+  assert_int_equal(
+      az_iot_provisioning_client_init(
+          &client,
+          test_global_device_hostname,
+          AZ_SPAN_FROM_STR(TEST_ID_SCOPE),
+          AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID),
+          NULL),
+      AZ_OK);
+
+  size_t client_id_len = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_get_client_id(&client, NULL, 0, &client_id_len), AZ_OK);
+  assert_int_equal(strlen(TEST_REGISTRATION_ID), client_id_len);
+
+  char expected_register_topic[] = "$dps/registrations/PUT/iotdps-register/?$rid=1";
+  char expected_query_topic[]
+      = "$dps/registrations/GET/iotdps-get-operationstatus/?$rid=1&operationId=" TEST_OPERATION_ID;
+
+  size_t topic_len = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_register_get_publish_topic(&client, NULL, 0, &topic_len), AZ_OK);
+  assert_int_equal(strlen(expected_register_topic), topic_len);
+
+  assert_int_equal(
+      az_iot_provisioning_client_query_status_get_publish_topic(
+          &client, AZ_SPAN_FROM_STR(TEST_OPERATION_ID), NULL, 0, &topic_len),
+      AZ_OK);
+  assert_int_equal(strlen(expected_query_topic), topic_len);
+
+  char topic[sizeof(expected_query_topic)];
+  assert_int_equal(
+      az_iot_provisioning_client_query_status_get_publish_topic(
+          &client, AZ_SPAN_FROM_STR(TEST_OPERATION_ID), topic, topic_len + 1, &topic_len),
+      AZ_OK);
+  assert_string_equal(expected_query_topic, topic);
+}
+
 static void test_az_iot_provisioning_client_get_register_publish_topic_insufficient_space_fails()
 {
   az_iot_provisioning_client client;
@@ -265,6 +305,7 @@ int test_az_iot_provisioning_client()
     cmocka_unit_test(test_az_iot_provisioning_client_custom_options_get_username_succeed),
     cmocka_unit_test(test_az_iot_provisioning_client_get_connect_info_insufficient_space_fails),
     cmocka_unit_test(test_az_iot_provisioning_client_get_register_publish_topic_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_get_publish_topic_measure_succeed),
     cmocka_unit_test(
         test_az_iot_provisioning_client_get_register_publish_topic_insufficient_space_fails),
     cmocka_unit_test(test_az_iot_provisioning_client_get_operation_status_publish_topic_succeed),
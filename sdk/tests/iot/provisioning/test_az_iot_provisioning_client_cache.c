@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "test_az_iot_provisioning_client.h"
+#include <az_test_precondition.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/iot/az_iot_provisioning_client.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_GLOBAL_DEVICE_HOSTNAME "global.azure-devices-provisioning.net"
+#define TEST_ID_SCOPE "0neFEEDC0DE"
+#define TEST_REGISTRATION_ID "myRegistrationId"
+#define TEST_HUB_HOSTNAME "contoso.azure-devices.net"
+#define TEST_DEVICE_ID "my-device-id1"
+#define TEST_EPOCH_TIME 1600000000
+
+static az_iot_provisioning_client _cache_test_client(az_span registration_id)
+{
+  az_iot_provisioning_client client;
+  assert_int_equal(
+      az_iot_provisioning_client_init(
+          &client,
+          AZ_SPAN_FROM_STR(TEST_GLOBAL_DEVICE_HOSTNAME),
+          AZ_SPAN_FROM_STR(TEST_ID_SCOPE),
+          registration_id,
+          NULL),
+      AZ_OK);
+  return client;
+}
+
+static az_span _cache_test_write(az_iot_provisioning_client const* client, az_span destination)
+{
+  az_iot_provisioning_client_registration_state registration_state = { 0 };
+  registration_state.assigned_hub_hostname = AZ_SPAN_FROM_STR(TEST_HUB_HOSTNAME);
+  registration_state.device_id = AZ_SPAN_FROM_STR(TEST_DEVICE_ID);
+
+  az_span image = AZ_SPAN_EMPTY;
+  assert_int_equal(
+      az_iot_provisioning_client_cache_write(
+          client, &registration_state, TEST_EPOCH_TIME, destination, &image),
+      AZ_OK);
+  return image;
+}
+
+#ifndef AZ_NO_PRECONDITION_CHECKING
+ENABLE_PRECONDITION_CHECK_TESTS()
+
+static void test_az_iot_provisioning_client_cache_write_empty_hostname_fails()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  az_iot_provisioning_client_registration_state registration_state = { 0 };
+  registration_state.device_id = AZ_SPAN_FROM_STR(TEST_DEVICE_ID);
+
+  uint8_t buffer[128];
+  az_span image;
+  ASSERT_PRECONDITION_CHECKED(az_iot_provisioning_client_cache_write(
+      &client, &registration_state, TEST_EPOCH_TIME, AZ_SPAN_FROM_BUFFER(buffer), &image));
+}
+
+static void test_az_iot_provisioning_client_cache_read_NULL_out_entry_fails()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  ASSERT_PRECONDITION_CHECKED(
+      az_iot_provisioning_client_cache_read(&client, AZ_SPAN_EMPTY, TEST_EPOCH_TIME, 0, NULL));
+}
+
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+static void test_az_iot_provisioning_client_cache_read_succeed()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  uint8_t buffer[128];
+  az_span const image = _cache_test_write(&client, AZ_SPAN_FROM_BUFFER(buffer));
+
+  // The image is read back whatever follows it in the buffer it is persisted in.
+  az_iot_provisioning_client_cache_entry entry;
+  assert_int_equal(
+      az_iot_provisioning_client_cache_read(
+          &client, AZ_SPAN_FROM_BUFFER(buffer), TEST_EPOCH_TIME + 60, 0, &entry),
+      AZ_OK);
+  assert_true(
+      az_span_is_content_equal(entry.assigned_hub_hostname, AZ_SPAN_FROM_STR(TEST_HUB_HOSTNAME)));
+  assert_true(az_span_is_content_equal(entry.device_id, AZ_SPAN_FROM_STR(TEST_DEVICE_ID)));
+  assert_true(entry.assigned_epoch_time == TEST_EPOCH_TIME);
+  assert_ptr_equal(
+      az_span_ptr(entry.device_id) + az_span_size(entry.device_id),
+      az_span_ptr(image) + az_span_size(image));
+}
+
+static void test_az_iot_provisioning_client_cache_read_max_age_succeed()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  uint8_t buffer[128];
+  az_span const image = _cache_test_write(&client, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_iot_provisioning_client_cache_entry entry;
+  assert_int_equal(
+      az_iot_provisioning_client_cache_read(&client, image, TEST_EPOCH_TIME + 3600, 3600, &entry),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_provisioning_client_cache_read(&client, image, TEST_EPOCH_TIME + 3601, 3600, &entry),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // A clock which isn't set yet doesn't expire the image.
+  assert_int_equal(az_iot_provisioning_client_cache_read(&client, image, 0, 3600, &entry), AZ_OK);
+}
+
+static void test_az_iot_provisioning_client_cache_read_other_registration_fails()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  uint8_t buffer[128];
+  az_span const image = _cache_test_write(&client, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_iot_provisioning_client other_client = _cache_test_client(AZ_SPAN_FROM_STR("otherId"));
+  az_iot_provisioning_client_cache_entry entry;
+  assert_int_equal(
+      az_iot_provisioning_client_cache_read(&other_client, image, TEST_EPOCH_TIME, 0, &entry),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static void test_az_iot_provisioning_client_cache_read_corrupted_fails()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  uint8_t buffer[128];
+  az_span const image = _cache_test_write(&client, AZ_SPAN_FROM_BUFFER(buffer));
+  az_iot_provisioning_client_cache_entry entry;
+
+  // An image whose write was interrupted.
+  for (int32_t size = 0; size < az_span_size(image); size++)
+  {
+    assert_int_equal(
+        az_iot_provisioning_client_cache_read(
+            &client, az_span_slice(image, 0, size), TEST_EPOCH_TIME, 0, &entry),
+        AZ_ERROR_ITEM_NOT_FOUND);
+  }
+
+  // An image with any of its bytes changed.
+  for (int32_t i = 0; i < az_span_size(image); i++)
+  {
+    az_span_ptr(image)[i] ^= 0x01;
+    assert_int_equal(
+        az_iot_provisioning_client_cache_read(&client, image, TEST_EPOCH_TIME, 0, &entry),
+        AZ_ERROR_ITEM_NOT_FOUND);
+    az_span_ptr(image)[i] ^= 0x01;
+  }
+
+  assert_int_equal(
+      az_iot_provisioning_client_cache_read(&client, image, TEST_EPOCH_TIME, 0, &entry), AZ_OK);
+}
+
+static void test_az_iot_provisioning_client_cache_write_small_buffer_fails()
+{
+  az_iot_provisioning_client client = _cache_test_client(AZ_SPAN_FROM_STR(TEST_REGISTRATION_ID));
+  uint8_t buffer[128];
+  az_span const image = _cache_test_write(&client, AZ_SPAN_FROM_BUFFER(buffer));
+
+  az_iot_provisioning_client_registration_state registration_state = { 0 };
+  registration_state.assigned_hub_hostname = AZ_SPAN_FROM_STR(TEST_HUB_HOSTNAME);
+  registration_state.device_id = AZ_SPAN_FROM_STR(TEST_DEVICE_ID);
+  uint8_t small_buffer[128];
+  az_span small_image;
+  assert_int_equal(
+      az_iot_provisioning_client_cache_write(
+          &client,
+          &registration_state,
+          TEST_EPOCH_TIME,
+          az_span_create(small_buffer, az_span_size(image) - 1),
+          &small_image),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static void test_az_iot_provisioning_client_cache_should_reprovision_succeed()
+{
+  assert_true(az_iot_provisioning_client_cache_should_reprovision(AZ_IOT_STATUS_UNAUTHORIZED));
+  assert_true(az_iot_provisioning_client_cache_should_reprovision(AZ_IOT_STATUS_FORBIDDEN));
+  assert_true(az_iot_provisioning_client_cache_should_reprovision(AZ_IOT_STATUS_NOT_FOUND));
+  assert_false(az_iot_provisioning_client_cache_should_reprovision(AZ_IOT_STATUS_THROTTLED));
+  assert_false(az_iot_provisioning_client_cache_should_reprovision(AZ_IOT_STATUS_SERVER_ERROR));
+}
+
+#ifdef _MSC_VER
+// warning C4113: 'void (__cdecl *)()' differs in parameter lists from 'CMUnitTestFunction'
+#pragma warning(disable : 4113)
+#endif
+
+int test_az_iot_provisioning_client_cache()
+{
+#ifndef AZ_NO_PRECONDITION_CHECKING
+  SETUP_PRECONDITION_CHECK_TESTS();
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+  const struct CMUnitTest tests[] = {
+#ifndef AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_write_empty_hostname_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_read_NULL_out_entry_fails),
+#endif // AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_read_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_read_max_age_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_read_other_registration_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_read_corrupted_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_write_small_buffer_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_cache_should_reprovision_succeed),
+  };
+  return cmocka_run_group_tests_name("az_iot_provisioning_client_cache", tests, NULL, NULL);
+}
@@ -0,0 +1,334 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "test_az_iot_provisioning_client.h"
+#include <az_test_precondition.h>
+#include <azure/core/az_precondition.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_precondition_internal.h>
+#include <azure/iot/az_iot_provisioning_client.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_OPERATION_ID "4.d0a671905ea5b2c8.42d78160-4c78-479e-8be7-61d5e55dac0d"
+#define TEST_ASSIGNING_PAYLOAD \
+  "{\"operationId\":\"" TEST_OPERATION_ID "\",\"status\":\"assigning\"}"
+#define TEST_ASSIGNED_PAYLOAD \
+  "{\"operationId\":\"" TEST_OPERATION_ID "\",\"status\":\"assigned\"," \
+  "\"registrationState\":{\"assignedHub\":\"contoso.azure-devices.net\"," \
+  "\"deviceId\":\"my-device-id1\",\"status\":\"assigned\"}}"
+#define TEST_ERROR_PAYLOAD \
+  "{\"errorCode\":401002,\"trackingId\":\"8ad0463c-6427-4479-9dfa-3e8bb7003e9b\"," \
+  "\"message\":\"Invalid certificate.\",\"timestampUtc\":\"2020-04-10T05:24:22.4718526Z\"}"
+
+// Every random number is 250, so the jitter is 250 msec, and a retry delay is 250 msec above its
+// minimum, unless its range is smaller.
+#define TEST_JITTER_MSEC 250
+
+static uint32_t _flow_random_callback(void* user_context)
+{
+  (void)user_context;
+  return TEST_JITTER_MSEC;
+}
+
+static az_iot_provisioning_client_flow_options _flow_test_options()
+{
+  az_iot_provisioning_client_flow_options options
+      = az_iot_provisioning_client_flow_options_default();
+  options.retry_options.random_callback = _flow_random_callback;
+  return options;
+}
+
+static az_iot_provisioning_client_register_response _flow_test_response(
+    az_span received_topic,
+    az_span received_payload)
+{
+  az_iot_provisioning_client client = { 0 };
+  az_iot_provisioning_client_register_response response;
+  assert_int_equal(
+      az_iot_provisioning_client_parse_received_topic_and_payload(
+          &client, received_topic, received_payload, &response),
+      AZ_OK);
+  return response;
+}
+
+#ifndef AZ_NO_PRECONDITION_CHECKING
+ENABLE_PRECONDITION_CHECK_TESTS()
+
+static void test_az_iot_provisioning_client_flow_get_next_action_NULL_out_next_fails()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), NULL);
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_provisioning_client_flow_get_next_action(&flow, 0, NULL));
+}
+
+static void test_az_iot_provisioning_client_flow_on_response_NULL_response_fails()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), NULL);
+
+  ASSERT_PRECONDITION_CHECKED(az_iot_provisioning_client_flow_on_response(&flow, NULL, 0));
+}
+
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+static void test_az_iot_provisioning_client_flow_options_default_succeed()
+{
+  az_iot_provisioning_client_flow_options options
+      = az_iot_provisioning_client_flow_options_default();
+
+  assert_int_equal(options.jitter_msec, 1000);
+  assert_int_equal(options.default_poll_interval_msec, 3000);
+  assert_int_equal(options.response_timeout_msec, 30000);
+  assert_int_equal(options.retry_options.min_retry_delay_msec, 1000);
+}
+
+static void test_az_iot_provisioning_client_flow_assigned_succeed()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow_options options = _flow_test_options();
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 1000, AZ_SPAN_FROM_BUFFER(buffer), &options);
+  assert_int_equal(az_span_size(az_iot_provisioning_client_flow_get_operation_id(&flow)), 0);
+
+  // The register request is delayed by the jitter.
+  int64_t next_msec = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 1000 + TEST_JITTER_MSEC);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, next_msec, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+  assert_true(next_msec == 1000 + TEST_JITTER_MSEC);
+
+  // Once published, the flow waits for the response.
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1500, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 1000 + TEST_JITTER_MSEC + 30000);
+
+  az_iot_provisioning_client_register_response response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/202/?$rid=1&retry-after=3"),
+      AZ_SPAN_FROM_STR(TEST_ASSIGNING_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 2000), AZ_OK);
+
+  // The operation ID was copied, so it outlives the received message.
+  az_span operation_id = az_iot_provisioning_client_flow_get_operation_id(&flow);
+  assert_true(az_span_is_content_equal(operation_id, AZ_SPAN_FROM_STR(TEST_OPERATION_ID)));
+  assert_ptr_equal(az_span_ptr(operation_id), buffer);
+
+  // The query follows retry-after, plus the jitter.
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 2000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 2000 + 3000 + TEST_JITTER_MSEC);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, next_msec, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_QUERY);
+
+  response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/200/?$rid=2"),
+      AZ_SPAN_FROM_STR(TEST_ASSIGNED_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 6000), AZ_OK);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 6000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_ASSIGNED);
+}
+
+static void test_az_iot_provisioning_client_flow_default_poll_interval_succeed()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow_options options = _flow_test_options();
+  options.default_poll_interval_msec = 5000;
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), &options);
+
+  int64_t next_msec = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+
+  az_iot_provisioning_client_register_response response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/202/?$rid=1"),
+      AZ_SPAN_FROM_STR(TEST_ASSIGNING_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 2000), AZ_OK);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 2000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 2000 + 5000 + TEST_JITTER_MSEC);
+}
+
+static void test_az_iot_provisioning_client_flow_throttled_honors_retry_after_succeed()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow_options options = _flow_test_options();
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), &options);
+
+  int64_t next_msec = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+
+  // retry-after is longer than the throttled retry delay of 10 seconds.
+  az_iot_provisioning_client_register_response response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/429/?$rid=1&retry-after=20"),
+      AZ_SPAN_FROM_STR(TEST_ERROR_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 2000), AZ_OK);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 2000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 2000 + 20000);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, next_msec, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+
+  // Without retry-after, the throttled retry delay applies, doubled for the second attempt.
+  response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/429/?$rid=2"), AZ_SPAN_FROM_STR(TEST_ERROR_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 23000), AZ_OK);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 23000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 23000 + 10000 + TEST_JITTER_MSEC);
+}
+
+static void test_az_iot_provisioning_client_flow_error_fails()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow_options options = _flow_test_options();
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), &options);
+
+  int64_t next_msec = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+
+  az_iot_provisioning_client_register_response response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/401/?$rid=1"), AZ_SPAN_FROM_STR(TEST_ERROR_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 2000), AZ_OK);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 2000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED);
+
+  // Responses received once the flow ended are ignored.
+  response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/202/?$rid=1&retry-after=3"),
+      AZ_SPAN_FROM_STR(TEST_ASSIGNING_PAYLOAD));
+  assert_int_equal(az_iot_provisioning_client_flow_on_response(&flow, &response, 3000), AZ_OK);
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 3000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_FAILED);
+}
+
+static void test_az_iot_provisioning_client_flow_response_timeout_retries_succeed()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow_options options = _flow_test_options();
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), &options);
+
+  int64_t next_msec = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+
+  // Past the response timeout, the request is retried after the minimum retry delay.
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 31000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 31000 + 1000);
+
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, next_msec, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+}
+
+static void test_az_iot_provisioning_client_flow_on_response_small_buffer_fails()
+{
+  uint8_t buffer[8];
+  az_iot_provisioning_client_flow_options options = _flow_test_options();
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), &options);
+
+  int64_t next_msec = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 1000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_REGISTER);
+
+  az_iot_provisioning_client_register_response response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/202/?$rid=1&retry-after=3"),
+      AZ_SPAN_FROM_STR(TEST_ASSIGNING_PAYLOAD));
+  assert_int_equal(
+      az_iot_provisioning_client_flow_on_response(&flow, &response, 2000),
+      AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // The flow still waits for a response.
+  assert_int_equal(az_span_size(az_iot_provisioning_client_flow_get_operation_id(&flow)), 0);
+  assert_int_equal(
+      az_iot_provisioning_client_flow_get_next_action(&flow, 2000, &next_msec),
+      AZ_IOT_PROVISIONING_FLOW_ACTION_WAIT);
+  assert_true(next_msec == 1000 + 30000);
+}
+
+static void test_az_iot_provisioning_client_flow_on_response_unknown_status_fails()
+{
+  uint8_t buffer[64];
+  az_iot_provisioning_client_flow flow;
+  az_iot_provisioning_client_flow_init(&flow, 0, AZ_SPAN_FROM_BUFFER(buffer), NULL);
+
+  az_iot_provisioning_client_register_response response = _flow_test_response(
+      AZ_SPAN_FROM_STR("$dps/registrations/res/202/?$rid=1&retry-after=3"),
+      AZ_SPAN_FROM_STR("{\"operationId\":\"" TEST_OPERATION_ID "\",\"status\":\"unknown\"}"));
+  assert_int_equal(
+      az_iot_provisioning_client_flow_on_response(&flow, &response, 2000),
+      AZ_ERROR_UNEXPECTED_CHAR);
+}
+
+#ifdef _MSC_VER
+// warning C4113: 'void (__cdecl *)()' differs in parameter lists from 'CMUnitTestFunction'
+#pragma warning(disable : 4113)
+#endif
+
+int test_az_iot_provisioning_client_flow()
+{
+#ifndef AZ_NO_PRECONDITION_CHECKING
+  SETUP_PRECONDITION_CHECK_TESTS();
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+  const struct CMUnitTest tests[] = {
+#ifndef AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_get_next_action_NULL_out_next_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_on_response_NULL_response_fails),
+#endif // AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_options_default_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_assigned_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_default_poll_interval_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_throttled_honors_retry_after_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_error_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_response_timeout_retries_succeed),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_on_response_small_buffer_fails),
+    cmocka_unit_test(test_az_iot_provisioning_client_flow_on_response_unknown_status_fails),
+  };
+  return cmocka_run_group_tests_name("az_iot_provisioning_client_flow", tests, NULL, NULL);
+}
@@ -419,6 +419,104 @@ test_az_iot_provisioning_client_received_topic_and_payload_parse_device_not_foun
   assert_int_equal(AZ_ERROR_ITEM_NOT_FOUND, ret);
 }
 
+static void
+test_az_iot_provisioning_client_parse_received_topic_and_payload_lazy_assigning_state_succeed()
+{
+  az_iot_provisioning_client client;
+  az_span received_topic = AZ_SPAN_FROM_STR("$dps/registrations/res/202/?$rid=1&retry-after=3");
+
+  // The rest of the payload isn't read once the operation ID and status are found.
+  az_span received_payload = AZ_SPAN_FROM_STR(
+      "{\"operationId\":\"" TEST_OPERATION_ID "\",\"status\":\"" TEST_STATUS_ASSIGNING
+      "\",\"registrationState\":{\"registrationId\":");
+
+  az_iot_provisioning_client_register_response response;
+  az_result ret = az_iot_provisioning_client_parse_received_topic_and_payload_lazy(
+      &client, received_topic, received_payload, &response);
+  assert_int_equal(AZ_OK, ret);
+
+  // From topic
+  assert_int_equal(AZ_IOT_STATUS_ACCEPTED, response.status); // 202
+  assert_int_equal(3, response.retry_after_seconds);
+
+  // From payload
+  assert_true(az_span_is_content_equal(response.operation_id, AZ_SPAN_FROM_STR(TEST_OPERATION_ID)));
+  assert_true(
+      az_span_is_content_equal(response.operation_status, AZ_SPAN_FROM_STR(TEST_STATUS_ASSIGNING)));
+  assert_int_equal(0, az_span_size(response.registration_state.assigned_hub_hostname));
+  assert_int_equal(AZ_IOT_STATUS_UNKNOWN, response.registration_state.error_code);
+}
+
+static void
+test_az_iot_provisioning_client_parse_received_topic_and_payload_lazy_assigned_state_succeed()
+{
+  az_iot_provisioning_client client;
+  az_span received_topic = AZ_SPAN_FROM_STR("$dps/registrations/res/200/?$rid=1");
+  az_span received_payload
+      = AZ_SPAN_FROM_STR("{\"registrationState\":{"
+                         "\"registrationId\":\"" TEST_REGISTRATION_ID "\","
+                         "\"assignedHub\":\"" TEST_HUB_HOSTNAME "\","
+                         "\"deviceId\":\"" TEST_DEVICE_ID "\","
+                         "\"status\":\"" TEST_STATUS_ASSIGNED "\"},"
+                         "\"operationId\":\"" TEST_OPERATION_ID
+                         "\",\"status\":\"" TEST_STATUS_ASSIGNED "\"}");
+
+  az_iot_provisioning_client_register_response response;
+  az_result ret = az_iot_provisioning_client_parse_received_topic_and_payload_lazy(
+      &client, received_topic, received_payload, &response);
+  assert_int_equal(AZ_OK, ret);
+
+  assert_int_equal(AZ_IOT_STATUS_OK, response.status); // 200
+  assert_true(az_span_is_content_equal(response.operation_id, AZ_SPAN_FROM_STR(TEST_OPERATION_ID)));
+  assert_true(
+      az_span_is_content_equal(response.operation_status, AZ_SPAN_FROM_STR(TEST_STATUS_ASSIGNED)));
+  assert_int_equal(0, az_span_size(response.registration_state.assigned_hub_hostname));
+
+  az_iot_provisioning_client_registration_state state;
+  ret = az_iot_provisioning_client_parse_registration_state(received_payload, &state);
+  assert_int_equal(AZ_OK, ret);
+  assert_true(
+      az_span_is_content_equal(state.assigned_hub_hostname, AZ_SPAN_FROM_STR(TEST_HUB_HOSTNAME)));
+  assert_true(az_span_is_content_equal(state.device_id, AZ_SPAN_FROM_STR(TEST_DEVICE_ID)));
+}
+
+static void
+test_az_iot_provisioning_client_parse_received_topic_and_payload_lazy_error_succeed()
+{
+  az_iot_provisioning_client client;
+  az_span received_topic = AZ_SPAN_FROM_STR("$dps/registrations/res/401/?$rid=1");
+  az_span received_payload
+      = AZ_SPAN_FROM_STR("{\"errorCode\":401002,\"trackingId\":\"" TEST_ERROR_TRACKING_ID "\","
+                         "\"message\":\"" TEST_ERROR_MESSAGE_INVALID_CERT
+                         "\",\"timestampUtc\":\"" TEST_ERROR_TIMESTAMP "\"}");
+
+  az_iot_provisioning_client_register_response response;
+  az_result ret = az_iot_provisioning_client_parse_received_topic_and_payload_lazy(
+      &client, received_topic, received_payload, &response);
+  assert_int_equal(AZ_OK, ret);
+
+  assert_int_equal(AZ_IOT_STATUS_UNAUTHORIZED, response.status); // 401
+  assert_int_equal(0, az_span_size(response.operation_id));
+  assert_true(
+      az_span_is_content_equal(response.operation_status, AZ_SPAN_FROM_STR(TEST_STATUS_FAILED)));
+
+  az_iot_provisioning_client_registration_state state;
+  ret = az_iot_provisioning_client_parse_registration_state(received_payload, &state);
+  assert_int_equal(AZ_OK, ret);
+  assert_int_equal(AZ_IOT_STATUS_UNAUTHORIZED, state.error_code);
+  assert_int_equal(401002, state.extended_error_code);
+  assert_true(az_span_is_content_equal(
+      state.error_message, AZ_SPAN_FROM_STR(TEST_ERROR_MESSAGE_INVALID_CERT)));
+
+  // Without an error code, a payload with no operation ID is rejected.
+  ret = az_iot_provisioning_client_parse_received_topic_and_payload_lazy(
+      &client,
+      received_topic,
+      AZ_SPAN_FROM_STR("{\"status\":\"" TEST_STATUS_ASSIGNING "\"}"),
+      &response);
+  assert_int_equal(AZ_ERROR_ITEM_NOT_FOUND, ret);
+}
+
 static void test_az_iot_provisioning_client_parse_operation_status_translate_succeed()
 {
   az_iot_provisioning_client_register_response response = { .status = AZ_IOT_STATUS_FORBIDDEN,
@@ -574,6 +672,12 @@ int test_az_iot_provisioning_client_parser()
         test_az_iot_provisioning_client_received_topic_and_payload_parse_hub_not_found_fails),
     cmocka_unit_test(
         test_az_iot_provisioning_client_received_topic_and_payload_parse_device_not_found_fails),
+    cmocka_unit_test(
+        test_az_iot_provisioning_client_parse_received_topic_and_payload_lazy_assigning_state_succeed),
+    cmocka_unit_test(
+        test_az_iot_provisioning_client_parse_received_topic_and_payload_lazy_assigned_state_succeed),
+    cmocka_unit_test(
+        test_az_iot_provisioning_client_parse_received_topic_and_payload_lazy_error_succeed),
     cmocka_unit_test(test_az_iot_provisioning_client_parse_operation_status_translate_succeed),
     cmocka_unit_test(test_az_iot_provisioning_client_operation_complete_translate_succeed),
     cmocka_unit_test(test_az_iot_provisioning_client_logging_succeed),
@@ -28,6 +28,8 @@
 #define TEST_URL_ENC_SIG "cS1eHM%2FlDjsRsrZV9508wOFrgmZk4g8FNg8NwHVSiSQ"
 #define TEST_EXPIRATION_STR "1578941692"
 #define TEST_KEY_NAME "iothubowner"
+#define TEST_KEY "AQIDBAUGBwgJCgsMDQ4PEBESExQVFhcYGRobHB0eHyA="
+#define TEST_URL_ENC_KEY_SIG "2xWvnlGtFYGndpkuYb132C%2BzUgXgVFZLGpMYQOZ%2FzvQ%3D"
 
 static const az_span test_global_device_hostname
     = AZ_SPAN_LITERAL_FROM_STR("global.azure-devices-provisioning.net");
@@ -35,6 +37,7 @@ static const az_span test_id_scope = AZ_SPAN_LITERAL_FROM_STR(TEST_ID_SCOPE);
 static const az_span test_registration_id = AZ_SPAN_LITERAL_FROM_STR(TEST_REGISTRATION_ID_STR);
 static const uint32_t test_sas_expiry_time_secs = 1578941692;
 static const az_span test_signature = AZ_SPAN_LITERAL_FROM_STR(TEST_SIG);
+static const az_span test_key = AZ_SPAN_LITERAL_FROM_STR(TEST_KEY);
 
 #ifndef AZ_NO_PRECONDITION_CHECKING
 ENABLE_PRECONDITION_CHECK_TESTS()
@@ -195,6 +198,38 @@ static void az_iot_provisioning_client_sas_get_password_device_succeeds()
   assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
 }
 
+static void az_iot_provisioning_client_sas_get_password_measure_succeeds()
+{
+  az_iot_provisioning_client client;
+  assert_int_equal(
+      az_iot_provisioning_client_init(
+          &client, test_global_device_hostname, test_id_scope, test_registration_id, NULL),
+      AZ_OK);
+
+  const char expected_password[] = "SharedAccessSignature sr=" TEST_URL_ENCODED_RESOURCE_URI
+                                   "&sig=" TEST_URL_ENC_SIG "&se=" TEST_EXPIRATION_STR;
+
+  size_t length = 0;
+  assert_int_equal(
+      az_iot_provisioning_client_sas_get_password(
+          &client, test_signature, test_sas_expiry_time_secs, AZ_SPAN_EMPTY, NULL, 0, &length),
+      AZ_OK);
+  assert_int_equal(length, _az_COUNTOF(expected_password) - 1);
+
+  char password[_az_COUNTOF(expected_password)];
+  assert_int_equal(
+      az_iot_provisioning_client_sas_get_password(
+          &client,
+          test_signature,
+          test_sas_expiry_time_secs,
+          AZ_SPAN_EMPTY,
+          password,
+          length + 1,
+          &length),
+      AZ_OK);
+  assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
+}
+
 static void az_iot_provisioning_client_sas_get_password_device_with_keyname_succeeds()
 {
   az_iot_provisioning_client client;
@@ -267,6 +302,59 @@ static void az_iot_provisioning_client_sas_get_signature_device_signature_overfl
       AZ_ERROR_NOT_ENOUGH_SPACE);
 }
 
+static void az_iot_provisioning_client_sas_get_password_from_key_device_succeeds()
+{
+  az_iot_provisioning_client client;
+  assert_int_equal(
+      az_iot_provisioning_client_init(
+          &client, test_global_device_hostname, test_id_scope, test_registration_id, NULL),
+      AZ_OK);
+
+  const char expected_password[]
+      = "SharedAccessSignature sr=" TEST_URL_ENCODED_RESOURCE_URI "&sig=" TEST_URL_ENC_KEY_SIG
+        "&se=" TEST_EXPIRATION_STR "&skn=" TEST_KEY_NAME;
+
+  // Exactly large enough for the password, which also stages the signature and the key.
+  char password[_az_COUNTOF(expected_password)];
+  size_t length = 0;
+
+  assert_int_equal(
+      az_iot_provisioning_client_sas_get_password_from_key(
+          &client,
+          test_key,
+          test_sas_expiry_time_secs,
+          AZ_SPAN_FROM_STR(TEST_KEY_NAME),
+          password,
+          _az_COUNTOF(password),
+          &length),
+      AZ_OK);
+
+  assert_int_equal(length, _az_COUNTOF(expected_password) - 1);
+  assert_memory_equal(password, expected_password, length + 1); // +1 to account for '\0'.
+}
+
+static void az_iot_provisioning_client_sas_get_password_from_key_invalid_key_fails()
+{
+  az_iot_provisioning_client client;
+  assert_int_equal(
+      az_iot_provisioning_client_init(
+          &client, test_global_device_hostname, test_id_scope, test_registration_id, NULL),
+      AZ_OK);
+
+  char password[TEST_SPAN_BUFFER_SIZE];
+
+  assert_int_equal(
+      az_iot_provisioning_client_sas_get_password_from_key(
+          &client,
+          AZ_SPAN_FROM_STR("AQIDBAUGBwgJCgsMDQ4"),
+          test_sas_expiry_time_secs,
+          AZ_SPAN_EMPTY,
+          password,
+          _az_COUNTOF(password),
+          NULL),
+      AZ_ERROR_UNEXPECTED_END);
+}
+
 static int _log_invoked_sas = 0;
 static void _log_listener(az_log_classification classification, az_span message)
 {
@@ -358,9 +446,12 @@ int test_az_iot_provisioning_client_sas_token()
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(az_iot_provisioning_client_sas_get_signature_device_succeeds),
     cmocka_unit_test(az_iot_provisioning_client_sas_get_password_device_succeeds),
+    cmocka_unit_test(az_iot_provisioning_client_sas_get_password_measure_succeeds),
     cmocka_unit_test(az_iot_provisioning_client_sas_get_password_device_with_keyname_succeeds),
     cmocka_unit_test(az_iot_provisioning_client_sas_get_password_device_overflow_fails),
     cmocka_unit_test(az_iot_provisioning_client_sas_get_signature_device_signature_overflow_fails),
+    cmocka_unit_test(az_iot_provisioning_client_sas_get_password_from_key_device_succeeds),
+    cmocka_unit_test(az_iot_provisioning_client_sas_get_password_from_key_invalid_key_fails),
     cmocka_unit_test(test_az_iot_provisioning_client_sas_logging_succeed),
     cmocka_unit_test(test_az_iot_provisioning_client_sas_no_logging_succeed),
   };
@@ -5,6 +5,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <cmocka.h>
 
@@ -24,3 +25,1376 @@ void test_storage_blobs_init(void** state)
           &client, AZ_SPAN_FROM_STR("url"), AZ_CREDENTIAL_ANONYMOUS, &opts)
       == AZ_OK);
 }
+
+void test_storage_blobs_prewarm(void** state);
+void test_storage_blobs_prewarm(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client = { 0 };
+  az_storage_blobs_blob_client_options opts = az_storage_blobs_blob_client_options_default();
+  opts.retry_options.max_retries = 0;
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client, AZ_SPAN_FROM_STR("https://account.blob.core.windows.net/c/b"), NULL, &opts)
+      == AZ_OK);
+
+  // The tests have no HTTP transport, so there is no connection to open.
+  assert_true(
+      az_storage_blobs_blob_client_prewarm(&client) == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+
+  // The first request waits for the prewarm, whose failure doesn't fail it.
+  assert_true(az_storage_blobs_blob_client_prewarm_submit(&client) == AZ_OK);
+  assert_true(client._internal.is_prewarming);
+
+  uint8_t response_buffer[64];
+  az_http_response response;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+  assert_true(
+      az_storage_blobs_blob_get_properties(&client, NULL, &response)
+      == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+  assert_false(client._internal.is_prewarming);
+}
+
+void test_storage_blobs_get_block_id(void** state);
+void test_storage_blobs_get_block_id(void** state)
+{
+  (void)state;
+  uint8_t buffer[AZ_STORAGE_BLOBS_BLOCK_ID_SIZE] = { 0 };
+  az_span block_id = AZ_SPAN_EMPTY;
+
+  assert_true(
+      az_storage_blobs_blob_get_block_id(0, AZ_SPAN_FROM_BUFFER(buffer), &block_id) == AZ_OK);
+  assert_true(az_span_is_content_equal(block_id, AZ_SPAN_FROM_STR("MDAwMDAw")));
+
+  assert_true(
+      az_storage_blobs_blob_get_block_id(1, AZ_SPAN_FROM_BUFFER(buffer), &block_id) == AZ_OK);
+  assert_true(az_span_is_content_equal(block_id, AZ_SPAN_FROM_STR("MDAwMDAx")));
+
+  assert_true(
+      az_storage_blobs_blob_get_block_id(12345, AZ_SPAN_FROM_BUFFER(buffer), &block_id) == AZ_OK);
+  assert_true(az_span_is_content_equal(block_id, AZ_SPAN_FROM_STR("MDEyMzQ1")));
+
+  assert_true(
+      az_storage_blobs_blob_get_block_id(
+          AZ_STORAGE_BLOBS_BLOCK_MAX_COUNT - 1, AZ_SPAN_FROM_BUFFER(buffer), &block_id)
+      == AZ_OK);
+  assert_true(az_span_is_content_equal(block_id, AZ_SPAN_FROM_STR("MDQ5OTk5")));
+
+  assert_true(
+      az_storage_blobs_blob_get_block_id(
+          1, az_span_slice(AZ_SPAN_FROM_BUFFER(buffer), 0, 7), &block_id)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+void test_storage_blobs_commit_block_list_not_enough_space(void** state);
+void test_storage_blobs_commit_block_list_not_enough_space(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client = { 0 };
+  az_storage_blobs_blob_client_options opts = az_storage_blobs_blob_client_options_default();
+
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client, AZ_SPAN_FROM_STR("url"), AZ_CREDENTIAL_ANONYMOUS, &opts)
+      == AZ_OK);
+
+  az_span const block_ids[] = { AZ_SPAN_FROM_STR("MDAwMDAw"), AZ_SPAN_FROM_STR("MDAwMDAx") };
+
+  uint8_t response_buffer[64] = { 0 };
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+
+  // 61 bytes for the list, plus (17 + 8) for each block ID.
+  uint8_t body_buffer[61 + 2 * 25 - 1] = { 0 };
+  assert_true(
+      az_storage_blobs_blob_commit_block_list(
+          &client, block_ids, 2, AZ_SPAN_FROM_BUFFER(body_buffer), NULL, &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+void test_storage_blobs_download_get_blob_size(void** state);
+void test_storage_blobs_download_get_blob_size(void** state)
+{
+  (void)state;
+  int64_t blob_size = 0;
+
+  az_span const ranged_response = AZ_SPAN_FROM_STR("HTTP/1.1 206 Partial Content\r\n"
+                                                   "Content-Length: 4\r\n"
+                                                   "Content-Range: bytes 0-3/5000000000\r\n"
+                                                   "\r\n"
+                                                   "data");
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, ranged_response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_download_get_blob_size(&response, &blob_size) == AZ_OK);
+  assert_true(blob_size == 5000000000);
+
+  az_span const whole_response = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"
+                                                  "Content-Length: 4\r\n"
+                                                  "\r\n"
+                                                  "data");
+  assert_true(az_http_response_init(&response, whole_response) == AZ_OK);
+  assert_true(
+      az_storage_blobs_blob_download_get_blob_size(&response, &blob_size)
+      == AZ_ERROR_ITEM_NOT_FOUND);
+
+  az_span const malformed_response = AZ_SPAN_FROM_STR("HTTP/1.1 206 Partial Content\r\n"
+                                                      "Content-Range: bytes 0-3\r\n"
+                                                      "\r\n"
+                                                      "data");
+  assert_true(az_http_response_init(&response, malformed_response) == AZ_OK);
+  assert_true(
+      az_storage_blobs_blob_download_get_blob_size(&response, &blob_size)
+      == AZ_ERROR_UNEXPECTED_CHAR);
+}
+
+void test_storage_blobs_arena_not_enough_space(void** state);
+void test_storage_blobs_arena_not_enough_space(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client = { 0 };
+  az_storage_blobs_blob_client_options opts = az_storage_blobs_blob_client_options_default();
+
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client, AZ_SPAN_FROM_STR("url"), AZ_CREDENTIAL_ANONYMOUS, &opts)
+      == AZ_OK);
+
+  uint8_t response_buffer[64] = { 0 };
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+
+  // Room for the URL, but not for the headers, so nothing is sent.
+  uint8_t arena_buffer[64] = { 0 };
+  az_span_arena arena;
+  az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(arena_buffer));
+
+  az_storage_blobs_blob_upload_options upload_options
+      = az_storage_blobs_blob_upload_options_default();
+  upload_options.arena = &arena;
+  assert_true(
+      az_storage_blobs_blob_upload(&client, AZ_SPAN_FROM_STR("data"), &upload_options, &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  az_span_arena_reset(&arena);
+  az_storage_blobs_blob_download_options download_options
+      = az_storage_blobs_blob_download_options_default();
+  download_options.arena = &arena;
+  assert_true(
+      az_storage_blobs_blob_download(&client, &download_options, &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+void test_storage_blobs_upload_journal(void** state);
+void test_storage_blobs_upload_journal(void** state)
+{
+  (void)state;
+  // 10 blocks, the last one of 5 bytes.
+  uint8_t buffer[AZ_STORAGE_BLOBS_UPLOAD_JOURNAL_SIZE(10)];
+  memset(buffer, 0xFF, sizeof(buffer));
+
+  az_storage_blobs_blob_upload_journal journal;
+  assert_true(
+      az_storage_blobs_blob_upload_journal_init(
+          &journal, az_span_slice(AZ_SPAN_FROM_BUFFER(buffer), 0, sizeof(buffer) - 1), 95, 10)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  assert_true(
+      az_storage_blobs_blob_upload_journal_init(&journal, AZ_SPAN_FROM_BUFFER(buffer), 95, 10)
+      == AZ_OK);
+  assert_int_equal(az_storage_blobs_blob_upload_journal_get_block_count(&journal), 10);
+  assert_int_equal(az_storage_blobs_blob_upload_journal_get_staged_count(&journal), 0);
+
+  az_storage_blobs_blob_upload_journal_set_block_staged(&journal, 0);
+  az_storage_blobs_blob_upload_journal_set_block_staged(&journal, 9);
+  assert_true(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 9));
+  assert_false(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 8));
+
+  // Resumed from the saved buffer, the progress is kept.
+  uint8_t saved[sizeof(buffer)];
+  memcpy(saved, buffer, sizeof(buffer));
+  assert_true(
+      az_storage_blobs_blob_upload_journal_init(&journal, AZ_SPAN_FROM_BUFFER(saved), 95, 10)
+      == AZ_OK);
+  assert_int_equal(az_storage_blobs_blob_upload_journal_get_staged_count(&journal), 2);
+  assert_true(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 0));
+
+  // The journal of another upload is not.
+  assert_true(
+      az_storage_blobs_blob_upload_journal_init(&journal, AZ_SPAN_FROM_BUFFER(saved), 96, 10)
+      == AZ_OK);
+  assert_int_equal(az_storage_blobs_blob_upload_journal_get_staged_count(&journal), 0);
+}
+
+void test_storage_blobs_upload_journal_update(void** state);
+void test_storage_blobs_upload_journal_update(void** state)
+{
+  (void)state;
+  uint8_t buffer[AZ_STORAGE_BLOBS_UPLOAD_JOURNAL_SIZE(3)] = { 0 };
+  az_storage_blobs_blob_upload_journal journal;
+  assert_true(
+      az_storage_blobs_blob_upload_journal_init(&journal, AZ_SPAN_FROM_BUFFER(buffer), 25, 10)
+      == AZ_OK);
+  az_storage_blobs_blob_upload_journal_set_block_staged(&journal, 1);
+
+  // Block 0 is staged, block 1 was discarded and block 2 has the wrong size. The other blocks are
+  // not from this upload.
+  az_span const block_list_response = AZ_SPAN_FROM_STR(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/xml\r\n"
+      "\r\n"
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?><BlockList><CommittedBlocks>"
+      "<Block><Name>YWJjZA==</Name><Size>10</Size></Block></CommittedBlocks><UncommittedBlocks>"
+      "<Block><Name>MDAwMDAw</Name><Size>10</Size></Block>"
+      "<Block><Name>MDAwMDAy</Name><Size>10</Size></Block>"
+      "<Block><Name>MDAwMDA5</Name><Size>5</Size></Block>"
+      "</UncommittedBlocks></BlockList>");
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, block_list_response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_upload_journal_update(&journal, &response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 0));
+  assert_false(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 1));
+  assert_false(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 2));
+
+  // Cut short, as when the list doesn't fit in the buffer of the response.
+  az_span const truncated_response = AZ_SPAN_FROM_STR(
+      "HTTP/1.1 200 OK\r\n"
+      "\r\n"
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?><BlockList><CommittedBlocks></CommittedBlocks>"
+      "<UncommittedBlocks><Block><Name>MDAwMDAx</Name><Size>10</Size></Block>");
+  assert_true(az_http_response_init(&response, truncated_response) == AZ_OK);
+  assert_true(
+      az_storage_blobs_blob_upload_journal_update(&journal, &response) == AZ_ERROR_UNEXPECTED_END);
+  assert_true(az_storage_blobs_blob_upload_journal_is_block_staged(&journal, 0));
+
+  az_span const not_found_response = AZ_SPAN_FROM_STR("HTTP/1.1 404 The specified blob does not "
+                                                      "exist.\r\n"
+                                                      "Content-Length: 0\r\n"
+                                                      "\r\n");
+  assert_true(az_http_response_init(&response, not_found_response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_upload_journal_update(&journal, &response) == AZ_OK);
+  assert_int_equal(az_storage_blobs_blob_upload_journal_get_staged_count(&journal), 0);
+
+  az_span const error_response = AZ_SPAN_FROM_STR("HTTP/1.1 403 Forbidden\r\n"
+                                                  "Content-Length: 0\r\n"
+                                                  "\r\n");
+  assert_true(az_http_response_init(&response, error_response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_upload_journal_update(&journal, &response) == AZ_ERROR_ARG);
+}
+
+void test_storage_blobs_append_writer(void** state);
+void test_storage_blobs_append_writer(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client = { 0 };
+  az_storage_blobs_blob_client_options opts = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client, AZ_SPAN_FROM_STR("url"), AZ_CREDENTIAL_ANONYMOUS, &opts)
+      == AZ_OK);
+
+  uint8_t response_buffer[64] = { 0 };
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+
+  az_storage_blobs_append_writer_options writer_options
+      = az_storage_blobs_append_writer_options_default();
+  writer_options.flush_size = 8;
+
+  uint8_t buffer[16] = { 0 };
+  az_storage_blobs_append_writer writer;
+  assert_true(
+      az_storage_blobs_append_writer_init(
+          &writer, &client, AZ_SPAN_FROM_BUFFER(buffer), 100, &writer_options)
+      == AZ_OK);
+
+  // Below the flush size, records are only buffered, and flushing with none sends nothing.
+  assert_true(az_storage_blobs_append_writer_flush(&writer, &response) == AZ_OK);
+  assert_true(
+      az_storage_blobs_append_writer_write(&writer, AZ_SPAN_FROM_STR("abc"), &response) == AZ_OK);
+  assert_true(
+      az_storage_blobs_append_writer_write(&writer, AZ_SPAN_FROM_STR("def"), &response) == AZ_OK);
+  assert_true(az_storage_blobs_append_writer_poll(&writer, &response) == AZ_OK);
+  assert_int_equal(az_storage_blobs_append_writer_get_buffered_size(&writer), 6);
+
+  // Reaching it sends the records, which without a transport fails and leaves the record out.
+  assert_true(
+      az_storage_blobs_append_writer_write(&writer, AZ_SPAN_FROM_STR("ghi"), &response)
+      == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+  assert_int_equal(az_storage_blobs_append_writer_get_buffered_size(&writer), 6);
+  assert_true(az_storage_blobs_append_writer_get_append_position(&writer) == 100);
+  assert_true(
+      az_storage_blobs_append_writer_flush(&writer, &response) == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+  assert_int_equal(az_storage_blobs_append_writer_get_buffered_size(&writer), 6);
+}
+
+void test_storage_blobs_parse_properties(void** state);
+void test_storage_blobs_parse_properties(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_properties properties;
+
+  az_span const properties_response
+      = AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"
+                         "Content-Length: 11\r\n"
+                         "Content-MD5: XrY7u+Ae7tCTyyK7j1rNww==\r\n"
+                         "Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT\r\n"
+                         "etag: \"0x8D2D96B4A8F9A2F\"\r\n"
+                         "x-ms-blob-type: BlockBlob\r\n"
+                         "\r\n");
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, properties_response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_parse_properties(&response, &properties) == AZ_OK);
+  assert_true(az_span_is_content_equal(properties.etag, AZ_SPAN_FROM_STR("\"0x8D2D96B4A8F9A2F\"")));
+  assert_true(az_span_is_content_equal(
+      properties.last_modified, AZ_SPAN_FROM_STR("Wed, 21 Oct 2015 07:28:00 GMT")));
+  assert_true(az_span_is_content_equal(
+      properties.content_md5, AZ_SPAN_FROM_STR("XrY7u+Ae7tCTyyK7j1rNww==")));
+  assert_true(az_span_is_content_equal(properties.blob_type, AZ_SPAN_FROM_STR("BlockBlob")));
+  assert_true(properties.content_length == 11);
+
+  // A response without the properties, such as 304 Not Modified, leaves them empty.
+  az_span const not_modified_response = AZ_SPAN_FROM_STR("HTTP/1.1 304 Not Modified\r\n"
+                                                         "\r\n");
+  assert_true(az_http_response_init(&response, not_modified_response) == AZ_OK);
+  assert_true(az_storage_blobs_blob_parse_properties(&response, &properties) == AZ_OK);
+  assert_int_equal(az_span_size(properties.etag), 0);
+  assert_true(properties.content_length == -1);
+}
+
+static az_span _test_storage_blobs_sent_url;
+static az_span _test_storage_blobs_sent_date;
+static az_span _test_storage_blobs_sent_authorization;
+static uint8_t _test_storage_blobs_sent_date_buffer[64];
+static uint8_t _test_storage_blobs_sent_authorization_buffer[128];
+
+// The shared key credential builds the headers on its stack, so they are copied to be checked.
+static az_span _test_storage_blobs_copy_header(
+    az_http_request* request,
+    az_span name,
+    az_span destination)
+{
+  az_span value = AZ_SPAN_EMPTY;
+  if (az_result_failed(az_http_request_get_header_by_name(request, name, &value))
+      || az_span_size(value) > az_span_size(destination))
+  {
+    return AZ_SPAN_EMPTY;
+  }
+
+  az_span_copy(destination, value);
+  return az_span_slice(destination, 0, az_span_size(value));
+}
+
+static az_result _test_storage_blobs_capture_request(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+  (void)ref_response;
+
+  _test_storage_blobs_sent_date = _test_storage_blobs_copy_header(
+      ref_request,
+      AZ_SPAN_FROM_STR("x-ms-date"),
+      AZ_SPAN_FROM_BUFFER(_test_storage_blobs_sent_date_buffer));
+  _test_storage_blobs_sent_authorization = _test_storage_blobs_copy_header(
+      ref_request,
+      AZ_SPAN_FROM_STR("Authorization"),
+      AZ_SPAN_FROM_BUFFER(_test_storage_blobs_sent_authorization_buffer));
+
+  return az_http_request_get_url(ref_request, &_test_storage_blobs_sent_url);
+}
+
+static int64_t _test_storage_blobs_get_time(void) { return 1445412480; }
+
+// The 64 bytes from 0 to 63, as a storage account key.
+#define TEST_STORAGE_BLOBS_ACCOUNT_KEY \
+  "AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGxwdHh8gISIjJCUmJygpKissLS4vMDEyMzQ1Njc4OTo7PD0+Pw=="
+
+void test_storage_blobs_shared_key_credential(void** state);
+void test_storage_blobs_shared_key_credential(void** state)
+{
+  (void)state;
+  uint8_t signing_buffer[512];
+  az_storage_blobs_shared_key_credential credential;
+  assert_true(
+      az_storage_blobs_shared_key_credential_init(
+          &credential,
+          AZ_SPAN_FROM_STR("myaccount"),
+          AZ_SPAN_FROM_STR(TEST_STORAGE_BLOBS_ACCOUNT_KEY),
+          AZ_SPAN_FROM_BUFFER(signing_buffer),
+          _test_storage_blobs_get_time)
+      == AZ_OK);
+
+  uint8_t url_buffer[128];
+  az_span const url
+      = AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob?comp=block");
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+  az_span_copy(AZ_SPAN_FROM_BUFFER(url_buffer), url);
+  az_http_request request;
+  assert_true(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_put(),
+          AZ_SPAN_FROM_BUFFER(url_buffer),
+          az_span_size(url),
+          AZ_SPAN_FROM_BUFFER(headers_buffer),
+          AZ_SPAN_FROM_STR("hello"))
+      == AZ_OK);
+  assert_true(
+      az_http_request_set_query_parameter(
+          &request, AZ_SPAN_FROM_STR("blockid"), AZ_SPAN_FROM_STR("MDAwMDAx="), false)
+      == AZ_OK);
+  assert_true(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("x-ms-version"), AZ_SPAN_FROM_STR("2019-02-02"))
+      == AZ_OK);
+  assert_true(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("Content-Type"), AZ_SPAN_FROM_STR("text/plain"))
+      == AZ_OK);
+  assert_true(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("x-ms-blob-type"), AZ_SPAN_FROM_STR("BlockBlob"))
+      == AZ_OK);
+  assert_true(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("Content-Length"), AZ_SPAN_FROM_STR("5"))
+      == AZ_OK);
+
+  // The headers the credential adds are taken off before it signs the request again, as the
+  // retry policy does, since they point to its stack.
+  int32_t const headers_length = request._internal.headers_length;
+
+  // The x-ms-* headers are signed sorted by name, and the query parameters URL-decoded.
+  _az_http_policy policies[] = {
+    { ._internal = { .process = _test_storage_blobs_capture_request, .options = NULL } },
+    { ._internal = { .process = NULL, .options = NULL } },
+  };
+  az_http_response response = { 0 };
+  assert_true(
+      credential.credential._internal.apply_credential_policy(
+          policies, &credential, &request, &response)
+      == AZ_OK);
+  assert_true(az_span_is_content_equal(
+      _test_storage_blobs_sent_date, AZ_SPAN_FROM_STR("Wed, 21 Oct 2015 07:28:00 GMT")));
+  assert_true(az_span_is_content_equal(
+      _test_storage_blobs_sent_authorization,
+      AZ_SPAN_FROM_STR("SharedKey myaccount:UR60fLa+ul2BwlExWcjFsEi0d02DfhIP1jzAg6F2JEk=")));
+
+  // Requests are signed on the stack, so a signing buffer too small for a SAS token doesn't
+  // change how they are signed.
+  assert_true(
+      az_storage_blobs_shared_key_credential_init(
+          &credential,
+          AZ_SPAN_FROM_STR("myaccount"),
+          AZ_SPAN_FROM_STR(TEST_STORAGE_BLOBS_ACCOUNT_KEY),
+          az_span_slice(AZ_SPAN_FROM_BUFFER(signing_buffer), 0, 16),
+          _test_storage_blobs_get_time)
+      == AZ_OK);
+  request._internal.headers_length = headers_length;
+  assert_true(
+      credential.credential._internal.apply_credential_policy(
+          policies, &credential, &request, &response)
+      == AZ_OK);
+  assert_true(az_span_is_content_equal(
+      _test_storage_blobs_sent_authorization,
+      AZ_SPAN_FROM_STR("SharedKey myaccount:UR60fLa+ul2BwlExWcjFsEi0d02DfhIP1jzAg6F2JEk=")));
+
+  az_storage_blobs_sas_options sas_options = az_storage_blobs_sas_options_default();
+  sas_options.expiry = AZ_SPAN_FROM_STR("2030-01-01T00:00:00Z");
+  uint8_t token_buffer[256];
+  az_span token = AZ_SPAN_EMPTY;
+  assert_true(
+      az_storage_blobs_get_blob_sas(
+          &credential,
+          &sas_options,
+          AZ_SPAN_FROM_STR("container"),
+          AZ_SPAN_FROM_STR("blob"),
+          AZ_SPAN_FROM_BUFFER(token_buffer),
+          &token)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // A request whose signed text is larger than 1 KiB fails before it is sent.
+  uint8_t long_value[1024];
+  memset(long_value, 'a', sizeof(long_value));
+  request._internal.headers_length = headers_length;
+  assert_true(
+      az_http_request_append_header(
+          &request, AZ_SPAN_FROM_STR("x-ms-meta-long"), AZ_SPAN_FROM_BUFFER(long_value))
+      == AZ_OK);
+  _test_storage_blobs_sent_authorization = AZ_SPAN_EMPTY;
+  assert_true(
+      credential.credential._internal.apply_credential_policy(
+          policies, &credential, &request, &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(az_span_size(_test_storage_blobs_sent_authorization), 0);
+
+  assert_true(
+      az_storage_blobs_shared_key_credential_init(
+          &credential,
+          AZ_SPAN_FROM_STR("anaccountnamelongerthan24"),
+          AZ_SPAN_FROM_STR(TEST_STORAGE_BLOBS_ACCOUNT_KEY),
+          AZ_SPAN_FROM_BUFFER(signing_buffer),
+          _test_storage_blobs_get_time)
+      == AZ_ERROR_ARG);
+}
+
+void test_storage_blobs_sas(void** state);
+void test_storage_blobs_sas(void** state)
+{
+  (void)state;
+  uint8_t signing_buffer[512];
+  az_storage_blobs_shared_key_credential shared_key_credential;
+  assert_true(
+      az_storage_blobs_shared_key_credential_init(
+          &shared_key_credential,
+          AZ_SPAN_FROM_STR("myaccount"),
+          AZ_SPAN_FROM_STR(TEST_STORAGE_BLOBS_ACCOUNT_KEY),
+          AZ_SPAN_FROM_BUFFER(signing_buffer),
+          _test_storage_blobs_get_time)
+      == AZ_OK);
+
+  az_storage_blobs_sas_options options = az_storage_blobs_sas_options_default();
+  options.expiry = AZ_SPAN_FROM_STR("2030-01-01T00:00:00Z");
+
+  uint8_t token_buffer[256];
+  az_span token = AZ_SPAN_EMPTY;
+  assert_true(
+      az_storage_blobs_get_blob_sas(
+          &shared_key_credential,
+          &options,
+          AZ_SPAN_FROM_STR("container"),
+          AZ_SPAN_FROM_STR("blob"),
+          AZ_SPAN_FROM_BUFFER(token_buffer),
+          &token)
+      == AZ_OK);
+  assert_true(az_span_is_content_equal(
+      token,
+      AZ_SPAN_FROM_STR("sv=2019-02-02&sr=b&sp=r&se=2030-01-01T00%3A00%3A00Z"
+                       "&sig=AUJUOdPi%2FpaXHm82kGpL2lgKl3YsacCHLjxaHlLIMPo%3D")));
+
+  options.permissions = AZ_SPAN_FROM_STR("rw");
+  options.protocol = AZ_SPAN_FROM_STR("https");
+  assert_true(
+      az_storage_blobs_get_account_sas(
+          &shared_key_credential,
+          &options,
+          AZ_SPAN_FROM_STR("co"),
+          AZ_SPAN_FROM_BUFFER(token_buffer),
+          &token)
+      == AZ_OK);
+  assert_true(az_span_is_content_equal(
+      token,
+      AZ_SPAN_FROM_STR("sv=2019-02-02&ss=b&srt=co&sp=rw&se=2030-01-01T00%3A00%3A00Z&spr=https"
+                       "&sig=rVRKiFCilvTGROiQsABEtnvQeYPFwRoZeFb%2BJj%2BQZTo%3D")));
+
+  assert_true(
+      az_storage_blobs_get_account_sas(
+          &shared_key_credential,
+          &options,
+          AZ_SPAN_FROM_STR("co"),
+          az_span_slice(AZ_SPAN_FROM_BUFFER(token_buffer), 0, 32),
+          &token)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  // The SAS credential adds the token for each attempt, and takes it off the URL afterwards.
+  az_storage_blobs_sas_credential sas_credential;
+  assert_true(
+      az_storage_blobs_sas_credential_init(&sas_credential, AZ_SPAN_FROM_STR("?sv=1&sig=a"))
+      == AZ_OK);
+
+  uint8_t url_buffer[128];
+  az_span const url = AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob");
+  uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUFFER_SIZE];
+  az_span_copy(AZ_SPAN_FROM_BUFFER(url_buffer), url);
+  az_http_request request;
+  assert_true(
+      az_http_request_init(
+          &request,
+          &az_context_application,
+          az_http_method_get(),
+          AZ_SPAN_FROM_BUFFER(url_buffer),
+          az_span_size(url),
+          AZ_SPAN_FROM_BUFFER(headers_buffer),
+          AZ_SPAN_EMPTY)
+      == AZ_OK);
+
+  _az_http_policy policies[] = {
+    { ._internal = { .process = _test_storage_blobs_capture_request, .options = NULL } },
+    { ._internal = { .process = NULL, .options = NULL } },
+  };
+  az_http_response response = { 0 };
+  for (int32_t attempt = 0; attempt < 2; attempt++)
+  {
+    assert_true(
+        sas_credential.credential._internal.apply_credential_policy(
+            policies, &sas_credential, &request, &response)
+        == AZ_OK);
+    assert_true(az_span_is_content_equal(
+        _test_storage_blobs_sent_url,
+        AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob?sv=1&sig=a")));
+  }
+
+  az_span request_url = AZ_SPAN_EMPTY;
+  assert_true(az_http_request_get_url(&request, &request_url) == AZ_OK);
+  assert_true(az_span_is_content_equal(request_url, url));
+}
+
+void test_storage_blobs_batch(void** state);
+void test_storage_blobs_batch(void** state)
+{
+  (void)state;
+  az_storage_blobs_sas_credential credential;
+  assert_true(
+      az_storage_blobs_sas_credential_init(&credential, AZ_SPAN_FROM_STR("sig=a")) == AZ_OK);
+
+  az_storage_blobs_blob_client client;
+  az_storage_blobs_blob_client_options client_options
+      = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client,
+          AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container"),
+          &credential,
+          &client_options)
+      == AZ_OK);
+
+  uint8_t buffer[512];
+  az_storage_blobs_batch batch;
+  assert_true(az_storage_blobs_batch_init(&batch, &client, AZ_SPAN_FROM_BUFFER(buffer)) == AZ_OK);
+  assert_true(az_storage_blobs_batch_add_delete(&batch, AZ_SPAN_FROM_STR("blob0")) == AZ_OK);
+  assert_true(
+      az_storage_blobs_batch_add_set_tier(
+          &batch, AZ_SPAN_FROM_STR("blob1"), AZ_SPAN_FROM_STR("Cool"))
+      == AZ_OK);
+  assert_int_equal(az_storage_blobs_batch_get_count(&batch), 2);
+
+  // Each operation is a part of the body, authorized by the credential of the client.
+  az_span const operations
+      = AZ_SPAN_FROM_STR("--" AZ_STORAGE_BLOBS_BATCH_BOUNDARY "\r\n"
+                         "Content-Type: application/http\r\n"
+                         "Content-Transfer-Encoding: binary\r\n"
+                         "Content-ID: 0\r\n"
+                         "\r\n"
+                         "DELETE /container/blob0?sig=a HTTP/1.1\r\n"
+                         "x-ms-delete-snapshots: include\r\n"
+                         "Content-Length: 0\r\n"
+                         "\r\n"
+                         "--" AZ_STORAGE_BLOBS_BATCH_BOUNDARY "\r\n"
+                         "Content-Type: application/http\r\n"
+                         "Content-Transfer-Encoding: binary\r\n"
+                         "Content-ID: 1\r\n"
+                         "\r\n"
+                         "PUT /container/blob1?comp=tier&sig=a HTTP/1.1\r\n"
+                         "x-ms-access-tier: Cool\r\n"
+                         "Content-Length: 0\r\n"
+                         "\r\n");
+  assert_int_equal(batch._internal.length, az_span_size(operations));
+  assert_true(az_span_is_content_equal(
+      az_span_slice(AZ_SPAN_FROM_BUFFER(buffer), 0, batch._internal.length), operations));
+
+  // An operation which doesn't fit leaves the batch as it was.
+  uint8_t small_buffer[300];
+  az_storage_blobs_batch small_batch;
+  assert_true(
+      az_storage_blobs_batch_init(&small_batch, &client, AZ_SPAN_FROM_BUFFER(small_buffer))
+      == AZ_OK);
+  assert_true(az_storage_blobs_batch_add_delete(&small_batch, AZ_SPAN_FROM_STR("blob0")) == AZ_OK);
+  assert_true(
+      az_storage_blobs_batch_add_delete(&small_batch, AZ_SPAN_FROM_STR("blob1"))
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+  assert_int_equal(az_storage_blobs_batch_get_count(&small_batch), 1);
+
+  az_storage_blobs_batch_clear(&small_batch);
+  assert_int_equal(az_storage_blobs_batch_get_count(&small_batch), 0);
+  az_http_response response = { 0 };
+  assert_true(az_storage_blobs_batch_submit(&small_batch, NULL, &response) == AZ_ERROR_ARG);
+}
+
+void test_storage_blobs_batch_reader(void** state);
+void test_storage_blobs_batch_reader(void** state)
+{
+  (void)state;
+  az_span const batch_response = AZ_SPAN_FROM_STR(
+      "HTTP/1.1 202 Accepted\r\n"
+      "Content-Type: multipart/mixed; boundary=batchresponse_66925647-d0cb-4109-b6d3\r\n"
+      "\r\n"
+      "--batchresponse_66925647-d0cb-4109-b6d3\r\n"
+      "Content-Type: application/http\r\n"
+      "Content-ID: 0\r\n"
+      "\r\n"
+      "HTTP/1.1 202 Accepted\r\n"
+      "x-ms-delete-type-permanent: true\r\n"
+      "\r\n"
+      "--batchresponse_66925647-d0cb-4109-b6d3\r\n"
+      "Content-Type: application/http\r\n"
+      "Content-ID: 1\r\n"
+      "\r\n"
+      "HTTP/1.1 404 The specified blob does not exist.\r\n"
+      "x-ms-error-code: BlobNotFound\r\n"
+      "Content-Length: 7\r\n"
+      "\r\n"
+      "<Error>\r\n"
+      "--batchresponse_66925647-d0cb-4109-b6d3--\r\n"
+      "stale bytes past the end of the response");
+
+  az_http_response response = { 0 };
+  assert_true(az_http_response_init(&response, batch_response) == AZ_OK);
+  az_storage_blobs_batch_reader reader;
+  assert_true(az_storage_blobs_batch_reader_init(&reader, &response) == AZ_OK);
+
+  az_storage_blobs_batch_result result;
+  assert_true(az_storage_blobs_batch_reader_next(&reader, &result) == AZ_OK);
+  assert_int_equal(result.content_id, 0);
+  assert_int_equal(result.status_code, AZ_HTTP_STATUS_CODE_ACCEPTED);
+  az_span name = AZ_SPAN_EMPTY;
+  az_span value = AZ_SPAN_EMPTY;
+  assert_true(az_http_response_get_next_header(&result.response, &name, &value) == AZ_OK);
+  assert_true(az_span_is_content_equal(name, AZ_SPAN_FROM_STR("x-ms-delete-type-permanent")));
+  assert_true(
+      az_http_response_get_next_header(&result.response, &name, &value)
+      == AZ_ERROR_HTTP_END_OF_HEADERS);
+
+  // The body of a failed operation is read in place, without the line break of the delimiter.
+  assert_true(az_storage_blobs_batch_reader_next(&reader, &result) == AZ_OK);
+  assert_int_equal(result.content_id, 1);
+  assert_int_equal(result.status_code, AZ_HTTP_STATUS_CODE_NOT_FOUND);
+  az_span body = AZ_SPAN_EMPTY;
+  assert_true(az_http_response_get_body(&result.response, &body) == AZ_OK);
+  assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("<Error>")));
+
+  assert_true(
+      az_storage_blobs_batch_reader_next(&reader, &result) == AZ_ERROR_STORAGE_END_OF_BATCH);
+  assert_true(
+      az_storage_blobs_batch_reader_next(&reader, &result) == AZ_ERROR_STORAGE_END_OF_BATCH);
+
+  // A response cut before its closing delimiter, and one which isn't multipart.
+  assert_true(
+      az_http_response_init(&response, az_span_slice(batch_response, 0, 200)) == AZ_OK);
+  assert_true(az_storage_blobs_batch_reader_init(&reader, &response) == AZ_OK);
+  assert_true(az_storage_blobs_batch_reader_next(&reader, &result) == AZ_ERROR_UNEXPECTED_END);
+
+  assert_true(
+      az_http_response_init(
+          &response, AZ_SPAN_FROM_STR("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n"))
+      == AZ_OK);
+  assert_true(az_storage_blobs_batch_reader_init(&reader, &response) == AZ_ERROR_ITEM_NOT_FOUND);
+}
+
+static az_span const _test_storage_blobs_list_first_page = AZ_SPAN_LITERAL_FROM_STR(
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/xml\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<EnumerationResults ServiceEndpoint=\"https://myaccount.blob.core.windows.net/\" "
+    "ContainerName=\"container\"><Prefix>logs/</Prefix><MaxResults>2</MaxResults><Blobs>"
+    "<Blob><Name>logs/a.txt</Name><Properties>"
+    "<Last-Modified>Wed, 21 Oct 2015 07:28:00 GMT</Last-Modified><Etag>0x8D4BCC2E4835CD0</Etag>"
+    "<Content-Length>1024</Content-Length><Content-Type>text/plain</Content-Type>"
+    "<BlobType>BlockBlob</BlobType><AccessTier>Hot</AccessTier></Properties></Blob>"
+    "<Blob><Name>logs/b&amp;c.txt</Name><Properties><Etag>0x8D4BCC2E4835CD1</Etag>"
+    "<BlobType>AppendBlob</BlobType><Content-Length>0</Content-Length></Properties>"
+    "<Metadata><Name>ignored</Name></Metadata></Blob>"
+    "</Blobs><NextMarker>2!64!bG9ncy9jLnR4dA--</NextMarker></EnumerationResults>");
+
+static az_span const _test_storage_blobs_list_last_page = AZ_SPAN_LITERAL_FROM_STR(
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/xml\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<EnumerationResults ContainerName=\"container\"><Marker>2!64!bG9ncy9jLnR4dA--</Marker>"
+    "<Blobs><Blob><Name>logs/c.txt</Name><Properties><Content-Length>7</Content-Length>"
+    "<BlobType>PageBlob</BlobType></Properties></Blob></Blobs><NextMarker />"
+    "</EnumerationResults>");
+
+static az_span _test_storage_blobs_list_response;
+static int32_t _test_storage_blobs_list_chunk_size;
+static uint8_t _test_storage_blobs_list_url[256];
+static int32_t _test_storage_blobs_list_url_size;
+
+// Stands in for the whole pipeline, and writes the response in small chunks, as a transport does.
+static az_result _test_storage_blobs_list_send(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+
+  az_span url = AZ_SPAN_EMPTY;
+  assert_true(az_http_request_get_url(ref_request, &url) == AZ_OK);
+  assert_true(az_span_size(url) <= (int32_t)sizeof(_test_storage_blobs_list_url));
+  az_span_copy(AZ_SPAN_FROM_BUFFER(_test_storage_blobs_list_url), url);
+  _test_storage_blobs_list_url_size = az_span_size(url);
+
+  az_span remaining = _test_storage_blobs_list_response;
+  while (az_span_size(remaining) > 0)
+  {
+    int32_t const size = az_span_size(remaining) < _test_storage_blobs_list_chunk_size
+        ? az_span_size(remaining)
+        : _test_storage_blobs_list_chunk_size;
+    az_result const result
+        = az_http_response_append(ref_response, az_span_slice(remaining, 0, size));
+    if (az_result_failed(result))
+    {
+      return result;
+    }
+
+    remaining = az_span_slice_to_end(remaining, size);
+  }
+
+  return AZ_OK;
+}
+
+static uint8_t _test_storage_blobs_list_items[512];
+static int32_t _test_storage_blobs_list_items_size;
+
+// Writes each blob as "name type length etag tier;".
+static az_result
+_test_storage_blobs_list_item(void* user_context, az_storage_blobs_blob_item const* item)
+{
+  assert_true(user_context == &_test_storage_blobs_list_items_size);
+
+  az_span remainder = az_span_slice_to_end(
+      AZ_SPAN_FROM_BUFFER(_test_storage_blobs_list_items), _test_storage_blobs_list_items_size);
+  remainder = az_span_copy(remainder, item->name);
+  remainder = az_span_copy_u8(remainder, ' ');
+  remainder = az_span_copy(remainder, item->blob_type);
+  remainder = az_span_copy_u8(remainder, ' ');
+  az_span length_end = AZ_SPAN_EMPTY;
+  assert_true(az_span_i64toa(remainder, item->content_length, &length_end) == AZ_OK);
+  remainder = az_span_copy_u8(length_end, ' ');
+  remainder = az_span_copy(remainder, item->etag);
+  remainder = az_span_copy_u8(remainder, ' ');
+  remainder = az_span_copy(remainder, item->access_tier);
+  remainder = az_span_copy_u8(remainder, ';');
+  _test_storage_blobs_list_items_size
+      = (int32_t)(az_span_ptr(remainder) - _test_storage_blobs_list_items);
+
+  return AZ_OK;
+}
+
+void test_storage_blobs_blob_enumerator(void** state);
+void test_storage_blobs_blob_enumerator(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client;
+  az_storage_blobs_blob_client_options client_options
+      = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client,
+          AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container"),
+          AZ_CREDENTIAL_ANONYMOUS,
+          &client_options)
+      == AZ_OK);
+  client._internal.pipeline._internal.policies[0]._internal.process
+      = _test_storage_blobs_list_send;
+
+  az_storage_blobs_list_blobs_options options = az_storage_blobs_list_blobs_options_default();
+  options.prefix = AZ_SPAN_FROM_STR("logs/");
+  options.max_results = 2;
+
+  // The receive buffer holds one element, rather than a page.
+  uint8_t buffer[400];
+  az_storage_blobs_blob_enumerator enumerator;
+  assert_true(
+      az_storage_blobs_blob_enumerator_init(
+          &enumerator, &client, AZ_SPAN_FROM_BUFFER(buffer), &options)
+      == AZ_OK);
+
+  void* const items_context = &_test_storage_blobs_list_items_size;
+  uint8_t response_buffer[128];
+  az_http_response response;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+
+  _test_storage_blobs_list_items_size = 0;
+  _test_storage_blobs_list_response = _test_storage_blobs_list_first_page;
+  _test_storage_blobs_list_chunk_size = 7;
+  assert_true(
+      az_storage_blobs_blob_enumerator_next_page(
+          &enumerator, _test_storage_blobs_list_item, items_context, &response)
+      == AZ_OK);
+  assert_false(az_storage_blobs_blob_enumerator_is_done(&enumerator));
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_list_url, _test_storage_blobs_list_url_size),
+      AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container"
+                       "?restype=container&comp=list&prefix=logs%2F&maxresults=2")));
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_list_items, _test_storage_blobs_list_items_size),
+      AZ_SPAN_FROM_STR("logs/a.txt BlockBlob 1024 0x8D4BCC2E4835CD0 Hot;"
+                       "logs/b&amp;c.txt AppendBlob 0 0x8D4BCC2E4835CD1 ;")));
+
+  // The next page continues from the marker, and the last one has an empty marker. Nothing resets
+  // the response between pages, as the retry policy does, since the pipeline is replaced.
+  _test_storage_blobs_list_items_size = 0;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+  _test_storage_blobs_list_response = _test_storage_blobs_list_last_page;
+  _test_storage_blobs_list_chunk_size = 1;
+  assert_true(
+      az_storage_blobs_blob_enumerator_next_page(
+          &enumerator, _test_storage_blobs_list_item, items_context, &response)
+      == AZ_OK);
+  assert_true(az_storage_blobs_blob_enumerator_is_done(&enumerator));
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_list_url, _test_storage_blobs_list_url_size),
+      AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container"
+                       "?restype=container&comp=list&prefix=logs%2F&maxresults=2"
+                       "&marker=2%2164%21bG9ncy9jLnR4dA--")));
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_list_items, _test_storage_blobs_list_items_size),
+      AZ_SPAN_FROM_STR("logs/c.txt PageBlob 7  ;")));
+
+  // An element which doesn't fit in the receive buffer, and a page cut before its marker.
+  assert_true(
+      az_storage_blobs_blob_enumerator_init(&enumerator, &client, az_span_create(buffer, 100), NULL)
+      == AZ_OK);
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+  _test_storage_blobs_list_response = _test_storage_blobs_list_first_page;
+  _test_storage_blobs_list_chunk_size = 64;
+  assert_true(
+      az_storage_blobs_blob_enumerator_next_page(
+          &enumerator, _test_storage_blobs_list_item, items_context, &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+
+  assert_true(
+      az_storage_blobs_blob_enumerator_init(&enumerator, &client, AZ_SPAN_FROM_BUFFER(buffer), NULL)
+      == AZ_OK);
+  _test_storage_blobs_list_items_size = 0;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+  _test_storage_blobs_list_response = az_span_slice(
+      _test_storage_blobs_list_last_page, 0, az_span_size(_test_storage_blobs_list_last_page) - 40);
+  assert_true(
+      az_storage_blobs_blob_enumerator_next_page(
+          &enumerator, _test_storage_blobs_list_item, items_context, &response)
+      == AZ_ERROR_UNEXPECTED_END);
+
+  // A service error is buffered in the response, and the page can be requested again.
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+  _test_storage_blobs_list_response = AZ_SPAN_FROM_STR(
+      "HTTP/1.1 503 Server Busy\r\nContent-Length: 7\r\n\r\n<Error>");
+  assert_true(
+      az_storage_blobs_blob_enumerator_next_page(
+          &enumerator, _test_storage_blobs_list_item, items_context, &response)
+      == AZ_OK);
+  assert_false(az_storage_blobs_blob_enumerator_is_done(&enumerator));
+  az_span body = AZ_SPAN_EMPTY;
+  assert_true(az_http_response_get_body(&response, &body) == AZ_OK);
+  assert_true(az_span_is_content_equal(az_span_slice(body, 0, 7), AZ_SPAN_FROM_STR("<Error>")));
+}
+
+void test_storage_blobs_download_reader(void** state);
+void test_storage_blobs_download_reader(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client;
+  az_storage_blobs_blob_client_options client_options
+      = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client,
+          AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob"),
+          AZ_CREDENTIAL_ANONYMOUS,
+          &client_options)
+      == AZ_OK);
+  az_http_client_async async_client = { 0 };
+
+  // Each window is an equal part of the buffer, with room for the headers of its response.
+  static uint8_t buffer[4 * (AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE + 16)];
+  az_storage_blobs_download_reader_options options
+      = az_storage_blobs_download_reader_options_default();
+  options.range_offset = 5;
+  az_storage_blobs_download_reader reader;
+  assert_true(
+      az_storage_blobs_download_reader_init(
+          &reader, &client, &async_client, AZ_SPAN_FROM_BUFFER(buffer), &options)
+      == AZ_OK);
+  assert_int_equal(reader._internal.range_size, 16);
+  assert_false(az_storage_blobs_download_reader_is_done(&reader));
+
+  // Until the first range tells the size of the blob, it is the only one requested, and a range
+  // which couldn't be requested is requested again by the next read.
+  az_span content = AZ_SPAN_EMPTY;
+  assert_true(
+      az_storage_blobs_download_reader_read(&reader, &content) == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+  assert_true(reader._internal.windows[0].assigned);
+  assert_true(reader._internal.windows[0].offset == 5);
+  assert_false(reader._internal.windows[1].assigned);
+  assert_true(
+      az_storage_blobs_download_reader_read(&reader, &content) == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+  assert_true(reader._internal.windows[0].offset == 5);
+  assert_true(reader._internal.next_offset == 5 + 16);
+
+  az_storage_blobs_download_reader_cancel(&reader);
+  assert_true(az_storage_blobs_download_reader_is_done(&reader));
+
+  assert_true(
+      az_storage_blobs_download_reader_init(
+          &reader,
+          &client,
+          &async_client,
+          az_span_create(buffer, 4 * AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE),
+          NULL)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+void test_storage_blobs_blob_download_to_file(void** state);
+void test_storage_blobs_blob_download_to_file(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client;
+  az_storage_blobs_blob_client_options client_options
+      = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client,
+          AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob"),
+          AZ_CREDENTIAL_ANONYMOUS,
+          &client_options)
+      == AZ_OK);
+  az_http_client_async async_client = { 0 };
+
+  // Without an HTTP transport, the first range can't be requested, and nothing is written.
+  static uint8_t buffer[4 * (AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE + 16)];
+  az_storage_blobs_blob_download_to_file_options options
+      = az_storage_blobs_blob_download_to_file_options_default();
+  options.preallocate = true;
+  int64_t blob_size = -1;
+  assert_true(
+      az_storage_blobs_blob_download_to_file(
+          &client, &async_client, -1, AZ_SPAN_FROM_BUFFER(buffer), &options, &blob_size)
+      == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+  assert_true(blob_size == -1);
+
+  assert_true(
+      az_storage_blobs_blob_download_to_file(
+          &client,
+          &async_client,
+          -1,
+          az_span_create(buffer, 4 * AZ_STORAGE_BLOBS_DOWNLOAD_READER_HEADERS_SIZE),
+          NULL,
+          NULL)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+void test_storage_blobs_transfer_tuner(void** state);
+void test_storage_blobs_transfer_tuner(void** state)
+{
+  (void)state;
+  az_storage_blobs_transfer_tuner tuner;
+  az_storage_blobs_transfer_tuner_init(&tuner, NULL);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 64 * 1024);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 1);
+
+  // Blocks which are quick for the target grow, and a faster round adds a block in flight.
+  az_storage_blobs_transfer_tuner_record(&tuner, 64 * 1024, 0, 100, AZ_HTTP_STATUS_CODE_CREATED);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 128 * 1024);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 2);
+
+  az_storage_blobs_transfer_tuner_record(&tuner, 128 * 1024, 100, 200, AZ_HTTP_STATUS_CODE_CREATED);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 2);
+  az_storage_blobs_transfer_tuner_record(&tuner, 128 * 1024, 100, 200, AZ_HTTP_STATUS_CODE_CREATED);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 512 * 1024);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 3);
+
+  // Blocks taking about the target keep their size, and a slower round removes a block in flight.
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    az_storage_blobs_transfer_tuner_record(
+        &tuner, 512 * 1024, 200, 1200, AZ_HTTP_STATUS_CODE_PARTIAL_CONTENT);
+  }
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 512 * 1024);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 2);
+
+  // Throttling halves the blocks in flight, other failures aren't measured, and slow blocks shrink.
+  az_storage_blobs_transfer_tuner_record(
+      &tuner, 512 * 1024, 1200, 1300, AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 1);
+  az_storage_blobs_transfer_tuner_record(&tuner, 512 * 1024, 1300, 1400, 0);
+  az_storage_blobs_transfer_tuner_record(
+      &tuner, 512 * 1024, 1300, 1400, AZ_HTTP_STATUS_CODE_PRECONDITION_FAILED);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 512 * 1024);
+  az_storage_blobs_transfer_tuner_record(&tuner, 512 * 1024, 1400, 6400, AZ_HTTP_STATUS_CODE_OK);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 256 * 1024);
+
+  // The tuning stays within the bounds of the options.
+  az_storage_blobs_transfer_tuner_options options
+      = az_storage_blobs_transfer_tuner_options_default();
+  options.max_block_size = 100 * 1024;
+  options.max_concurrency = 1;
+  az_storage_blobs_transfer_tuner_init(&tuner, &options);
+  az_storage_blobs_transfer_tuner_record(&tuner, 64 * 1024, 0, 10, AZ_HTTP_STATUS_CODE_CREATED);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 100 * 1024);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_concurrency(&tuner), 1);
+  az_storage_blobs_transfer_tuner_record(&tuner, 64 * 1024, 10, 9000, AZ_HTTP_STATUS_CODE_CREATED);
+  az_storage_blobs_transfer_tuner_record(&tuner, 64 * 1024, 10, 9000, AZ_HTTP_STATUS_CODE_CREATED);
+  assert_int_equal(az_storage_blobs_transfer_tuner_get_block_size(&tuner), 64 * 1024);
+}
+
+static uint8_t _test_storage_blobs_stream_bodies[256];
+static int32_t _test_storage_blobs_stream_bodies_size;
+
+// Stands in for the whole pipeline, recording the body of each request, separated by '|'.
+static az_result _test_storage_blobs_stream_send(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+
+  az_span body = AZ_SPAN_EMPTY;
+  assert_true(az_http_request_get_body(ref_request, &body) == AZ_OK);
+  az_span remainder = az_span_slice_to_end(
+      AZ_SPAN_FROM_BUFFER(_test_storage_blobs_stream_bodies),
+      _test_storage_blobs_stream_bodies_size);
+  remainder = az_span_copy(remainder, body);
+  remainder = az_span_copy_u8(remainder, '|');
+  _test_storage_blobs_stream_bodies_size
+      = (int32_t)(az_span_ptr(remainder) - _test_storage_blobs_stream_bodies);
+
+  // As the transport policy does, each request starts the response over.
+  az_result const result
+      = az_http_response_init(ref_response, ref_response->_internal.http_response);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  return az_http_response_append(ref_response, AZ_SPAN_FROM_STR("HTTP/1.1 201 Created\r\n\r\n"));
+}
+
+// Produces the content "abcdefghij" three bytes at a time, as if it was being generated.
+static az_result _test_storage_blobs_stream_provide(
+    void* user_context,
+    int64_t offset,
+    az_span destination,
+    int32_t* out_size)
+{
+  az_span const content = AZ_SPAN_FROM_STR("abcdefghij");
+  assert_true(offset == *(int64_t*)user_context);
+
+  int32_t size = az_span_size(content) - (int32_t)offset;
+  size = size < 3 ? size : 3;
+  size = size < az_span_size(destination) ? size : az_span_size(destination);
+  az_span_copy(destination, az_span_slice(content, (int32_t)offset, (int32_t)offset + size));
+
+  *(int64_t*)user_context += size;
+  *out_size = size;
+  return AZ_OK;
+}
+
+void test_storage_blobs_upload_from_stream(void** state);
+void test_storage_blobs_upload_from_stream(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client;
+  az_storage_blobs_blob_client_options client_options
+      = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client,
+          AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob"),
+          AZ_CREDENTIAL_ANONYMOUS,
+          &client_options)
+      == AZ_OK);
+  client._internal.pipeline._internal.policies[0]._internal.process
+      = _test_storage_blobs_stream_send;
+
+  uint8_t response_buffer[64];
+  az_http_response response;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+
+  // The content is read once, in order, and staged in blocks as they are filled.
+  int64_t next_offset = 0;
+  uint8_t block_buffer[4];
+  uint8_t block_list_buffer[61 + 3 * 25];
+  _test_storage_blobs_stream_bodies_size = 0;
+  assert_true(
+      az_storage_blobs_blob_upload_from_stream(
+          &client,
+          _test_storage_blobs_stream_provide,
+          &next_offset,
+          AZ_SPAN_FROM_BUFFER(block_buffer),
+          AZ_SPAN_FROM_BUFFER(block_list_buffer),
+          NULL,
+          &response)
+      == AZ_OK);
+  assert_true(next_offset == 10);
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_stream_bodies, _test_storage_blobs_stream_bodies_size),
+      AZ_SPAN_FROM_STR("abcd|efgh|ij|<?xml version=\"1.0\" encoding=\"utf-8\"?><BlockList>"
+                       "<Latest>MDAwMDAw</Latest><Latest>MDAwMDAx</Latest>"
+                       "<Latest>MDAwMDAy</Latest></BlockList>|")));
+
+  // The block list buffer must hold every block of the content.
+  next_offset = 0;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+  assert_true(
+      az_storage_blobs_blob_upload_from_stream(
+          &client,
+          _test_storage_blobs_stream_provide,
+          &next_offset,
+          AZ_SPAN_FROM_BUFFER(block_buffer),
+          az_span_slice(AZ_SPAN_FROM_BUFFER(block_list_buffer), 0, 61 + 2 * 25),
+          NULL,
+          &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
+
+static uint8_t _test_storage_blobs_copy_requests[512];
+static int32_t _test_storage_blobs_copy_requests_size;
+
+// Stands in for the whole pipeline, recording the query and the copy headers of each request,
+// separated by ' ', then its body, and a '|'.
+static az_result _test_storage_blobs_copy_send(
+    _az_http_policy* ref_policies,
+    void* ref_options,
+    az_http_request* ref_request,
+    az_http_response* ref_response)
+{
+  (void)ref_policies;
+  (void)ref_options;
+
+  az_span const names[] = {
+    AZ_SPAN_FROM_STR("x-ms-copy-source"),
+    AZ_SPAN_FROM_STR("x-ms-source-range"),
+    AZ_SPAN_FROM_STR("x-ms-requires-sync"),
+    AZ_SPAN_FROM_STR("Content-Length"),
+    AZ_SPAN_FROM_STR("If-None-Match"),
+  };
+
+  az_span url = AZ_SPAN_EMPTY;
+  assert_true(az_http_request_get_url(ref_request, &url) == AZ_OK);
+  int32_t const query_start = az_span_find(url, AZ_SPAN_FROM_STR("?"));
+
+  az_span remainder = az_span_slice_to_end(
+      AZ_SPAN_FROM_BUFFER(_test_storage_blobs_copy_requests),
+      _test_storage_blobs_copy_requests_size);
+  remainder = az_span_copy(
+      remainder, query_start < 0 ? AZ_SPAN_FROM_STR("-") : az_span_slice_to_end(url, query_start));
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+  {
+    az_span value = AZ_SPAN_FROM_STR("-");
+    az_result const result = az_http_request_get_header_by_name(ref_request, names[i], &value);
+    assert_true(result == AZ_OK || result == AZ_ERROR_ITEM_NOT_FOUND);
+    remainder = az_span_copy_u8(remainder, ' ');
+    remainder = az_span_copy(remainder, value);
+  }
+
+  az_span body = AZ_SPAN_EMPTY;
+  assert_true(az_http_request_get_body(ref_request, &body) == AZ_OK);
+  remainder = az_span_copy_u8(remainder, ' ');
+  remainder = az_span_copy(remainder, body);
+  remainder = az_span_copy_u8(remainder, '|');
+  _test_storage_blobs_copy_requests_size
+      = (int32_t)(az_span_ptr(remainder) - _test_storage_blobs_copy_requests);
+
+  // As the transport policy does, each request starts the response over.
+  az_result const result
+      = az_http_response_init(ref_response, ref_response->_internal.http_response);
+  if (az_result_failed(result))
+  {
+    return result;
+  }
+
+  return az_http_response_append(ref_response, AZ_SPAN_FROM_STR("HTTP/1.1 201 Created\r\n\r\n"));
+}
+
+void test_storage_blobs_copy_from_url(void** state);
+void test_storage_blobs_copy_from_url(void** state)
+{
+  (void)state;
+  az_storage_blobs_blob_client client;
+  az_storage_blobs_blob_client_options client_options
+      = az_storage_blobs_blob_client_options_default();
+  assert_true(
+      az_storage_blobs_blob_client_init(
+          &client,
+          AZ_SPAN_FROM_STR("https://myaccount.blob.core.windows.net/container/blob"),
+          AZ_CREDENTIAL_ANONYMOUS,
+          &client_options)
+      == AZ_OK);
+  client._internal.pipeline._internal.policies[0]._internal.process
+      = _test_storage_blobs_copy_send;
+
+  uint8_t response_buffer[64];
+  az_http_response response;
+  assert_true(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buffer)) == AZ_OK);
+
+  // The service reads the source, so the requests have no content, and a copy in one request
+  // waits for the copy to complete.
+  az_span const source_url = AZ_SPAN_FROM_STR("https://other.blob.core.windows.net/c/b?sig=s");
+  az_storage_blobs_blob_upload_options options = az_storage_blobs_blob_upload_options_default();
+  options.conditions.if_none_match = AZ_SPAN_FROM_STR("*");
+  _test_storage_blobs_copy_requests_size = 0;
+  assert_true(
+      az_storage_blobs_blob_copy_from_url(&client, source_url, &options, &response) == AZ_OK);
+
+  uint8_t block_id_buffer[AZ_STORAGE_BLOBS_BLOCK_ID_SIZE];
+  az_span block_id = AZ_SPAN_EMPTY;
+  assert_true(
+      az_storage_blobs_blob_get_block_id(1, AZ_SPAN_FROM_BUFFER(block_id_buffer), &block_id)
+      == AZ_OK);
+  assert_true(
+      az_storage_blobs_blob_stage_block_from_url(
+          &client, block_id, source_url, 8, 4, NULL, &response)
+      == AZ_OK);
+
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_copy_requests, _test_storage_blobs_copy_requests_size),
+      AZ_SPAN_FROM_STR("- https://other.blob.core.windows.net/c/b?sig=s - true 0 * |"
+                       "?comp=block&blockid=MDAwMDAx https://other.blob.core.windows.net/c/b?sig=s"
+                       " bytes=8-11 - 0 - |")));
+
+  // An empty source has no blocks to stage, so only its empty block list is committed.
+  az_http_client_async async_client = { 0 };
+  az_storage_blobs_blob_copy_options copy_options = az_storage_blobs_blob_copy_options_default();
+  copy_options.conditions.if_none_match = AZ_SPAN_FROM_STR("*");
+  uint8_t block_list_buffer[61 + 2 * 25];
+  _test_storage_blobs_copy_requests_size = 0;
+  assert_true(
+      az_storage_blobs_blob_copy_from_url_in_blocks(
+          &client,
+          &async_client,
+          source_url,
+          0,
+          AZ_SPAN_FROM_BUFFER(block_list_buffer),
+          &copy_options,
+          &response)
+      == AZ_OK);
+  assert_true(az_span_is_content_equal(
+      az_span_create(_test_storage_blobs_copy_requests, _test_storage_blobs_copy_requests_size),
+      AZ_SPAN_FROM_STR("?comp=blocklist - - - 61 * <?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                       "<BlockList></BlockList>|")));
+
+  // Without an HTTP transport, the first block can't be submitted.
+  copy_options.block_size = 4;
+  assert_true(
+      az_storage_blobs_blob_copy_from_url_in_blocks(
+          &client,
+          &async_client,
+          source_url,
+          8,
+          AZ_SPAN_FROM_BUFFER(block_list_buffer),
+          &copy_options,
+          &response)
+      == AZ_ERROR_DEPENDENCY_NOT_PROVIDED);
+
+  // The block list buffer must hold every block of the source.
+  assert_true(
+      az_storage_blobs_blob_copy_from_url_in_blocks(
+          &client,
+          &async_client,
+          source_url,
+          9,
+          AZ_SPAN_FROM_BUFFER(block_list_buffer),
+          &copy_options,
+          &response)
+      == AZ_ERROR_NOT_ENOUGH_SPACE);
+}
@@ -11,11 +11,49 @@
 #include <azure/core/_az_cfg.h>
 
 void test_storage_blobs_init(void** state);
+void test_storage_blobs_prewarm(void** state);
+void test_storage_blobs_get_block_id(void** state);
+void test_storage_blobs_commit_block_list_not_enough_space(void** state);
+void test_storage_blobs_download_get_blob_size(void** state);
+void test_storage_blobs_arena_not_enough_space(void** state);
+void test_storage_blobs_upload_journal(void** state);
+void test_storage_blobs_upload_journal_update(void** state);
+void test_storage_blobs_append_writer(void** state);
+void test_storage_blobs_parse_properties(void** state);
+void test_storage_blobs_shared_key_credential(void** state);
+void test_storage_blobs_sas(void** state);
+void test_storage_blobs_batch(void** state);
+void test_storage_blobs_batch_reader(void** state);
+void test_storage_blobs_blob_enumerator(void** state);
+void test_storage_blobs_download_reader(void** state);
+void test_storage_blobs_blob_download_to_file(void** state);
+void test_storage_blobs_transfer_tuner(void** state);
+void test_storage_blobs_upload_from_stream(void** state);
+void test_storage_blobs_copy_from_url(void** state);
 
 int main(void)
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(test_storage_blobs_init),
+    cmocka_unit_test(test_storage_blobs_prewarm),
+    cmocka_unit_test(test_storage_blobs_get_block_id),
+    cmocka_unit_test(test_storage_blobs_commit_block_list_not_enough_space),
+    cmocka_unit_test(test_storage_blobs_download_get_blob_size),
+    cmocka_unit_test(test_storage_blobs_arena_not_enough_space),
+    cmocka_unit_test(test_storage_blobs_upload_journal),
+    cmocka_unit_test(test_storage_blobs_upload_journal_update),
+    cmocka_unit_test(test_storage_blobs_append_writer),
+    cmocka_unit_test(test_storage_blobs_parse_properties),
+    cmocka_unit_test(test_storage_blobs_shared_key_credential),
+    cmocka_unit_test(test_storage_blobs_sas),
+    cmocka_unit_test(test_storage_blobs_batch),
+    cmocka_unit_test(test_storage_blobs_batch_reader),
+    cmocka_unit_test(test_storage_blobs_blob_enumerator),
+    cmocka_unit_test(test_storage_blobs_download_reader),
+    cmocka_unit_test(test_storage_blobs_blob_download_to_file),
+    cmocka_unit_test(test_storage_blobs_transfer_tuner),
+    cmocka_unit_test(test_storage_blobs_upload_from_stream),
+    cmocka_unit_test(test_storage_blobs_copy_from_url),
   };
 
   return cmocka_run_group_tests_name("az_storage_blobs", tests, NULL, NULL);
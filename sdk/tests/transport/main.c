@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include "test_az_transport.h"
+
+int main()
+{
+  int result = 0;
+
+#ifdef _az_TEST_TRANSPORT_CURL
+  result += test_az_curl();
+#endif // _az_TEST_TRANSPORT_CURL
+  result += test_az_lwip_http();
+
+  return result;
+}
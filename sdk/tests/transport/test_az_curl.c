@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_curl_private.h"
+#include "test_az_transport.h"
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_platform.h>
+#include <azure/core/internal/az_atomic_internal.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+enum
+{
+  // The number of easy handles kept by the connection cache.
+  _TEST_CURL_POOLED_HANDLES = 8,
+  _TEST_CURL_CLAIMING_THREADS = 12,
+  _TEST_CURL_CLAIMS_PER_THREAD = 200,
+};
+
+static bool _test_curl_is_one_of(CURL* curl, CURL* const* handles, int32_t count)
+{
+  for (int32_t i = 0; i < count; i++)
+  {
+    if (handles[i] == curl)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void test_az_curl_handle_pool(void** state)
+{
+  (void)state;
+
+  assert_int_equal(az_http_client_connection_reuse_init(), AZ_OK);
+
+  CURL* pooled[_TEST_CURL_POOLED_HANDLES] = { 0 };
+  for (int32_t i = 0; i < _TEST_CURL_POOLED_HANDLES; i++)
+  {
+    assert_int_equal(_az_http_client_curl_init(&pooled[i]), AZ_OK);
+    assert_non_null(pooled[i]);
+    assert_false(_test_curl_is_one_of(pooled[i], pooled, i));
+  }
+
+  // With every kept handle claimed, the next request gets a transient handle of its own.
+  CURL* transient = NULL;
+  assert_int_equal(_az_http_client_curl_init(&transient), AZ_OK);
+  assert_non_null(transient);
+  assert_false(_test_curl_is_one_of(transient, pooled, _TEST_CURL_POOLED_HANDLES));
+
+  assert_int_equal(_az_http_client_curl_done(&transient), AZ_OK);
+  assert_null(transient);
+
+  // Giving back a kept handle lets the next request pick it up again.
+  CURL* const released = pooled[3];
+  assert_int_equal(_az_http_client_curl_done(&pooled[3]), AZ_OK);
+  assert_null(pooled[3]);
+
+  CURL* reclaimed = NULL;
+  assert_int_equal(_az_http_client_curl_init(&reclaimed), AZ_OK);
+  assert_ptr_equal(reclaimed, released);
+  pooled[3] = reclaimed;
+
+  for (int32_t i = 0; i < _TEST_CURL_POOLED_HANDLES; i++)
+  {
+    assert_int_equal(_az_http_client_curl_done(&pooled[i]), AZ_OK);
+  }
+
+  az_http_client_connection_reuse_cleanup();
+}
+
+// The handles claimed right now, which no two threads may hold at once.
+static CURL* _test_curl_held[_TEST_CURL_CLAIMING_THREADS];
+static uint64_t volatile _test_curl_held_lock;
+static uint64_t volatile _test_curl_double_claims;
+static uint64_t volatile _test_curl_failed_claims;
+
+static void _test_curl_claim_many(void* user_context)
+{
+  int32_t const slot = (int32_t)(intptr_t)user_context;
+  for (int32_t i = 0; i < _TEST_CURL_CLAIMS_PER_THREAD; i++)
+  {
+    CURL* curl = NULL;
+    if (az_result_failed(_az_http_client_curl_init(&curl)))
+    {
+      (void)_az_atomic_add(&_test_curl_failed_claims, 1);
+      continue;
+    }
+
+    _az_atomic_spin_lock(&_test_curl_held_lock);
+    if (_test_curl_is_one_of(curl, _test_curl_held, _TEST_CURL_CLAIMING_THREADS))
+    {
+      (void)_az_atomic_add(&_test_curl_double_claims, 1);
+    }
+    _test_curl_held[slot] = curl;
+    _az_atomic_spin_unlock(&_test_curl_held_lock);
+
+    _az_atomic_spin_lock(&_test_curl_held_lock);
+    _test_curl_held[slot] = NULL;
+    _az_atomic_spin_unlock(&_test_curl_held_lock);
+
+    if (az_result_failed(_az_http_client_curl_done(&curl)))
+    {
+      (void)_az_atomic_add(&_test_curl_failed_claims, 1);
+    }
+  }
+}
+
+static void test_az_curl_handle_pool_several_threads(void** state)
+{
+  (void)state;
+
+  assert_int_equal(az_http_client_connection_reuse_init(), AZ_OK);
+  _test_curl_double_claims = 0;
+  _test_curl_failed_claims = 0;
+
+  // More threads than kept handles, so that some of the claims fall back to transient handles.
+  az_platform_work works[_TEST_CURL_CLAIMING_THREADS];
+  for (int32_t i = 0; i < _TEST_CURL_CLAIMING_THREADS; i++)
+  {
+    az_platform_work_init(&works[i], _test_curl_claim_many, (void*)(intptr_t)i);
+    assert_int_equal(az_platform_executor_submit(&works[i]), AZ_OK);
+  }
+
+  for (int32_t i = 0; i < _TEST_CURL_CLAIMING_THREADS; i++)
+  {
+    az_platform_executor_wait(&works[i]);
+  }
+
+  assert_int_equal(_az_atomic_load(&_test_curl_failed_claims), 0);
+  assert_int_equal(_az_atomic_load(&_test_curl_double_claims), 0);
+
+  // Every kept handle was given back.
+  CURL* pooled[_TEST_CURL_POOLED_HANDLES] = { 0 };
+  for (int32_t i = 0; i < _TEST_CURL_POOLED_HANDLES; i++)
+  {
+    assert_int_equal(_az_http_client_curl_init(&pooled[i]), AZ_OK);
+  }
+
+  CURL* transient = NULL;
+  assert_int_equal(_az_http_client_curl_init(&transient), AZ_OK);
+  assert_false(_test_curl_is_one_of(transient, pooled, _TEST_CURL_POOLED_HANDLES));
+  assert_int_equal(_az_http_client_curl_done(&transient), AZ_OK);
+
+  for (int32_t i = 0; i < _TEST_CURL_POOLED_HANDLES; i++)
+  {
+    assert_int_equal(_az_http_client_curl_done(&pooled[i]), AZ_OK);
+  }
+
+  az_http_client_connection_reuse_cleanup();
+}
+
+int test_az_curl()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_az_curl_handle_pool),
+    cmocka_unit_test(test_az_curl_handle_pool_several_threads),
+  };
+
+  return cmocka_run_group_tests_name("az_curl", tests, NULL, NULL);
+}
@@ -0,0 +1,352 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_lwip_http_private.h"
+#include "test_az_transport.h"
+#include <azure/core/az_http.h>
+#include <azure/core/az_http_transport.h>
+#include <azure/core/az_span.h>
+#include <azure/core/internal/az_http_internal.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include <azure/core/_az_cfg.h>
+
+#define TEST_LWIP_CHUNKED_RESPONSE                             \
+  "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, Chunked\r\n\r\n" \
+  "5;name=value\r\nhello\r\nD\r\n, split world\r\n0\r\n"
+
+// Parses a response received in reads of at most read_size bytes, into response_buffer.
+static az_result _test_lwip_parse(
+    az_span raw,
+    int32_t read_size,
+    az_span response_buffer,
+    az_http_response* out_response,
+    _az_http_lwip_parser* out_parser,
+    int32_t* out_consumed)
+{
+  _az_http_lwip_parser_init(out_parser, false);
+  az_result result = az_http_response_init(out_response, response_buffer);
+  *out_consumed = 0;
+  while (az_result_succeeded(result) && *out_consumed < az_span_size(raw)
+         && out_parser->state != _az_HTTP_LWIP_PARSE_DONE)
+  {
+    int32_t const remaining = az_span_size(raw) - *out_consumed;
+    int32_t const size = remaining < read_size ? remaining : read_size;
+    az_span const data = az_span_slice(raw, *out_consumed, *out_consumed + size);
+    int32_t consumed = 0;
+    result = _az_http_lwip_parser_parse(out_parser, data, out_response, &consumed);
+    *out_consumed += consumed;
+  }
+
+  return result;
+}
+
+// The status code and body of a parsed response, after walking its headers. The body is what was
+// written after the headers, without the rest of the response buffer.
+static void _test_lwip_get_response(
+    az_http_response* ref_response,
+    int32_t* out_status_code,
+    az_span* out_body)
+{
+  az_http_response_status_line status_line = { 0 };
+  assert_int_equal(az_http_response_get_status_line(ref_response, &status_line), AZ_OK);
+  *out_status_code = (int32_t)status_line.status_code;
+
+  az_span name = AZ_SPAN_EMPTY;
+  az_span value = AZ_SPAN_EMPTY;
+  while (az_result_succeeded(az_http_response_get_next_header(ref_response, &name, &value)))
+  {
+  }
+
+  az_span body = AZ_SPAN_EMPTY;
+  assert_int_equal(az_http_response_get_body(ref_response, &body), AZ_OK);
+  int32_t const headers_size
+      = (int32_t)(az_span_ptr(body) - az_span_ptr(ref_response->_internal.http_response));
+  *out_body = az_span_slice(body, 0, ref_response->_internal.written - headers_size);
+}
+
+static void test_az_lwip_http_parse_split_response(void** state)
+{
+  (void)state;
+
+  az_span const raw = AZ_SPAN_FROM_STR("HTTP/1.1 201 Created\r\ncontent-length: 11\r\n"
+                                       "X-Ms-Request-Id: 1\r\nConnection: keep-alive, Close\r\n\r\n"
+                                       "hello world");
+
+  // Every read size splits the status line, a header or the body somewhere else.
+  for (int32_t read_size = 1; read_size <= az_span_size(raw); read_size++)
+  {
+    uint8_t response_buffer[256];
+    az_http_response response;
+    _az_http_lwip_parser parser;
+    int32_t consumed = 0;
+    assert_int_equal(
+        _test_lwip_parse(
+            raw, read_size, AZ_SPAN_FROM_BUFFER(response_buffer), &response, &parser, &consumed),
+        AZ_OK);
+    assert_int_equal(parser.state, _az_HTTP_LWIP_PARSE_DONE);
+    assert_int_equal(consumed, az_span_size(raw));
+    assert_true(parser.is_close);
+    assert_false(parser.is_chunked);
+
+    int32_t status_code = 0;
+    az_span body = AZ_SPAN_EMPTY;
+    _test_lwip_get_response(&response, &status_code, &body);
+    assert_int_equal(status_code, 201);
+    assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("hello world")));
+  }
+}
+
+static void test_az_lwip_http_parse_split_chunk_size(void** state)
+{
+  (void)state;
+
+  az_span const raw = AZ_SPAN_FROM_STR(TEST_LWIP_CHUNKED_RESPONSE "\r\n");
+
+  // Small reads split each chunk size line, its extension and its line end across reads.
+  for (int32_t read_size = 1; read_size <= az_span_size(raw); read_size++)
+  {
+    uint8_t response_buffer[256];
+    az_http_response response;
+    _az_http_lwip_parser parser;
+    int32_t consumed = 0;
+    assert_int_equal(
+        _test_lwip_parse(
+            raw, read_size, AZ_SPAN_FROM_BUFFER(response_buffer), &response, &parser, &consumed),
+        AZ_OK);
+    assert_int_equal(parser.state, _az_HTTP_LWIP_PARSE_DONE);
+    assert_int_equal(consumed, az_span_size(raw));
+    assert_true(parser.is_chunked);
+    assert_false(parser.is_close);
+
+    int32_t status_code = 0;
+    az_span body = AZ_SPAN_EMPTY;
+    _test_lwip_get_response(&response, &status_code, &body);
+    assert_int_equal(status_code, 200);
+    assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("hello, split world")));
+  }
+}
+
+static void test_az_lwip_http_parse_trailers(void** state)
+{
+  (void)state;
+
+  az_span const response_bytes
+      = AZ_SPAN_FROM_STR(TEST_LWIP_CHUNKED_RESPONSE "X-Trailer: a\r\nX-Checksum: b;c\r\n\r\n");
+  uint8_t raw_buffer[256];
+  az_span raw = AZ_SPAN_FROM_BUFFER(raw_buffer);
+  az_span remainder = az_span_copy(raw, response_bytes);
+  remainder = az_span_copy(remainder, AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"));
+  raw = az_span_slice(raw, 0, az_span_size(raw) - az_span_size(remainder));
+
+  for (int32_t read_size = 1; read_size <= az_span_size(raw); read_size++)
+  {
+    uint8_t response_buffer[256];
+    az_http_response response;
+    _az_http_lwip_parser parser;
+    int32_t consumed = 0;
+    assert_int_equal(
+        _test_lwip_parse(
+            raw, read_size, AZ_SPAN_FROM_BUFFER(response_buffer), &response, &parser, &consumed),
+        AZ_OK);
+
+    // The trailer fields are skipped, and the bytes after the empty line are left unconsumed.
+    assert_int_equal(parser.state, _az_HTTP_LWIP_PARSE_DONE);
+    assert_int_equal(consumed, az_span_size(response_bytes));
+
+    int32_t status_code = 0;
+    az_span body = AZ_SPAN_EMPTY;
+    _test_lwip_get_response(&response, &status_code, &body);
+    assert_int_equal(status_code, 200);
+    assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("hello, split world")));
+  }
+}
+
+static void test_az_lwip_http_parse_oversized_headers(void** state)
+{
+  (void)state;
+
+  uint8_t raw_buffer[512];
+  az_span raw = AZ_SPAN_FROM_BUFFER(raw_buffer);
+  az_span remainder = az_span_copy(raw, AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nX-Long: "));
+  int32_t const value_size = 300;
+  memset(az_span_ptr(remainder), 'v', (size_t)value_size);
+  remainder = az_span_slice_to_end(remainder, value_size);
+  remainder = az_span_copy(remainder, AZ_SPAN_FROM_STR("\r\nContent-Length: 2\r\n\r\nok"));
+  raw = az_span_slice(raw, 0, az_span_size(raw) - az_span_size(remainder));
+
+  // Headers which don't fit in the response buffer fail the response, however they are read.
+  int32_t const read_sizes[] = { 1, 7, 64, az_span_size(raw) };
+  for (size_t i = 0; i < sizeof(read_sizes) / sizeof(read_sizes[0]); i++)
+  {
+    uint8_t response_buffer[256];
+    az_http_response response;
+    _az_http_lwip_parser parser;
+    int32_t consumed = 0;
+    assert_int_equal(
+        _test_lwip_parse(
+            raw,
+            read_sizes[i],
+            AZ_SPAN_FROM_BUFFER(response_buffer),
+            &response,
+            &parser,
+            &consumed),
+        AZ_ERROR_HTTP_RESPONSE_OVERFLOW);
+  }
+
+  // A Content-Length too large for the body counter is a corrupt header.
+  az_span const too_long = AZ_SPAN_FROM_STR(
+      "HTTP/1.1 200 OK\r\nContent-Length: 99999999999999999999\r\n\r\n");
+  uint8_t response_buffer[256];
+  az_http_response response;
+  _az_http_lwip_parser parser;
+  int32_t consumed = 0;
+  assert_int_equal(
+      _test_lwip_parse(
+          too_long, 5, AZ_SPAN_FROM_BUFFER(response_buffer), &response, &parser, &consumed),
+      AZ_ERROR_HTTP_CORRUPT_RESPONSE_HEADER);
+}
+
+// The bytes the writer sent, and the largest of its writes.
+static uint8_t _test_lwip_sent[4 * _az_HTTP_LWIP_SEND_BUFFER_SIZE];
+static int32_t _test_lwip_sent_length;
+static int32_t _test_lwip_write_count;
+static int32_t _test_lwip_largest_write;
+
+static AZ_NODISCARD az_result _test_lwip_write(az_http_request const* request, az_span data)
+{
+  (void)request;
+  assert_true(_test_lwip_sent_length + az_span_size(data) <= (int32_t)sizeof(_test_lwip_sent));
+  memcpy(_test_lwip_sent + _test_lwip_sent_length, az_span_ptr(data), (size_t)az_span_size(data));
+  _test_lwip_sent_length += az_span_size(data);
+  _test_lwip_write_count++;
+  if (az_span_size(data) > _test_lwip_largest_write)
+  {
+    _test_lwip_largest_write = az_span_size(data);
+  }
+
+  return AZ_OK;
+}
+
+static void _test_lwip_reset_sent(void)
+{
+  _test_lwip_sent_length = 0;
+  _test_lwip_write_count = 0;
+  _test_lwip_largest_write = 0;
+}
+
+// Provides the body bytes of the test, in whatever buffer the writer gives.
+static AZ_NODISCARD az_result
+_test_lwip_provide_body(void* user_context, int64_t offset, az_span destination, int32_t* out_size)
+{
+  az_span const body = *(az_span*)user_context;
+  az_span const rest = az_span_slice_to_end(body, (int32_t)offset);
+  int32_t const size = az_span_size(rest) < az_span_size(destination) ? az_span_size(rest)
+                                                                      : az_span_size(destination);
+  memcpy(az_span_ptr(destination), az_span_ptr(rest), (size_t)size);
+  *out_size = size;
+  return AZ_OK;
+}
+
+static void test_az_lwip_http_write_send_buffer_sized_body(void** state)
+{
+  (void)state;
+
+  uint8_t body_buffer[_az_HTTP_LWIP_SEND_BUFFER_SIZE];
+  for (int32_t i = 0; i < _az_HTTP_LWIP_SEND_BUFFER_SIZE; i++)
+  {
+    body_buffer[i] = (uint8_t)('a' + (i % 26));
+  }
+  az_span body = AZ_SPAN_FROM_BUFFER(body_buffer);
+
+  // Appending a buffer-sized piece fills the buffer without writing it.
+  _az_http_lwip_writer writer = { .request = NULL, .write = _test_lwip_write, .length = 0 };
+  _test_lwip_reset_sent();
+  assert_int_equal(_az_http_lwip_writer_append(&writer, body), AZ_OK);
+  assert_int_equal(_test_lwip_write_count, 0);
+  assert_int_equal(writer.length, _az_HTTP_LWIP_SEND_BUFFER_SIZE);
+  assert_int_equal(_az_http_lwip_writer_flush(&writer), AZ_OK);
+  assert_int_equal(_test_lwip_write_count, 1);
+  assert_memory_equal(_test_lwip_sent, body_buffer, sizeof(body_buffer));
+
+  // The same body, of unknown size, is written as chunks which each fit in the buffer, with or
+  // without headers before it.
+  int32_t const header_lengths[] = { 0, 100, _az_HTTP_LWIP_SEND_BUFFER_SIZE - 8 };
+  for (size_t i = 0; i < sizeof(header_lengths) / sizeof(header_lengths[0]); i++)
+  {
+    az_http_request request;
+    uint8_t headers_buffer[64];
+    uint8_t url_buffer[32];
+    az_span url = AZ_SPAN_FROM_BUFFER(url_buffer);
+    (void)az_span_copy(url, AZ_SPAN_FROM_STR("http://example.com"));
+    assert_int_equal(
+        az_http_request_init(
+            &request,
+            &az_context_application,
+            az_http_method_post(),
+            url,
+            (int32_t)sizeof("http://example.com") - 1,
+            AZ_SPAN_FROM_BUFFER(headers_buffer),
+            AZ_SPAN_EMPTY),
+        AZ_OK);
+    assert_int_equal(
+        az_http_request_set_body_provider(
+            &request, AZ_HTTP_REQUEST_BODY_SIZE_UNKNOWN, _test_lwip_provide_body, &body),
+        AZ_OK);
+
+    writer = (_az_http_lwip_writer){ .request = &request, .write = _test_lwip_write, .length = 0 };
+    memset(writer.buffer, 'h', (size_t)header_lengths[i]);
+    writer.length = header_lengths[i];
+    _test_lwip_reset_sent();
+    assert_int_equal(_az_http_lwip_write_chunked_body(&writer), AZ_OK);
+    assert_int_equal(writer.length, 0);
+    assert_true(_test_lwip_largest_write <= _az_HTTP_LWIP_SEND_BUFFER_SIZE);
+
+    // The chunks decode back to the body with the parser of the responses.
+    uint8_t raw_buffer[sizeof(_test_lwip_sent) + 64];
+    az_span raw = AZ_SPAN_FROM_BUFFER(raw_buffer);
+    az_span remainder = az_span_copy(
+        raw, AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"));
+    remainder = az_span_copy(
+        remainder,
+        az_span_create(
+            _test_lwip_sent + header_lengths[i], _test_lwip_sent_length - header_lengths[i]));
+    raw = az_span_slice(raw, 0, az_span_size(raw) - az_span_size(remainder));
+
+    uint8_t response_buffer[_az_HTTP_LWIP_SEND_BUFFER_SIZE + 64];
+    az_http_response response;
+    _az_http_lwip_parser parser;
+    int32_t consumed = 0;
+    assert_int_equal(
+        _test_lwip_parse(
+            raw, 37, AZ_SPAN_FROM_BUFFER(response_buffer), &response, &parser, &consumed),
+        AZ_OK);
+    assert_int_equal(parser.state, _az_HTTP_LWIP_PARSE_DONE);
+    assert_int_equal(consumed, az_span_size(raw));
+
+    int32_t status_code = 0;
+    az_span decoded = AZ_SPAN_EMPTY;
+    _test_lwip_get_response(&response, &status_code, &decoded);
+    assert_true(az_span_is_content_equal(decoded, body));
+  }
+}
+
+int test_az_lwip_http()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_az_lwip_http_parse_split_response),
+    cmocka_unit_test(test_az_lwip_http_parse_split_chunk_size),
+    cmocka_unit_test(test_az_lwip_http_parse_trailers),
+    cmocka_unit_test(test_az_lwip_http_parse_oversized_headers),
+    cmocka_unit_test(test_az_lwip_http_write_send_buffer_sized_body),
+  };
+
+  return cmocka_run_group_tests_name("az_lwip_http", tests, NULL, NULL);
+}